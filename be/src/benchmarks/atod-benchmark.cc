@@ -20,6 +20,7 @@
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include "exec/text-converter.inline.h"
 #include "runtime/string-value.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
@@ -90,6 +91,23 @@ void TestImpala(int batch_size, void* d) {
   }
 }
 
+// Same as TestImpala(), but with the batched text scanner kernel.
+template <typename Decimal, typename Storage>
+void TestBatched(int batch_size, void* d) {
+  TestData<Decimal>* data = reinterpret_cast<TestData<Decimal>*>(d);
+  ColumnType column_type = ColumnType::CreateDecimalType(data->precision, data->scale);
+  Decimal val;
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      const StringValue& str = data->data[j];
+      StringParser::ParseResult dummy;
+      val = TextConverter::ParseDecimal<Storage>(str.ptr, str.len, column_type, &dummy);
+      data->result[j] = val;
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << Benchmark::GetMachineInfo() << endl;
@@ -103,6 +121,7 @@ int main(int argc, char **argv) {
   AddTestData(&data4, 1000);
   data4.result.resize(data4.data.size());
   suite.AddBenchmark("Impala Decimal4", TestImpala<Decimal4Value, int32_t>, &data4);
+  suite.AddBenchmark("Batched Decimal4", TestBatched<Decimal4Value, int32_t>, &data4);
 
   TestData<Decimal8Value> data8;
   data8.precision = ColumnType::MAX_DECIMAL8_PRECISION;
@@ -111,6 +130,7 @@ int main(int argc, char **argv) {
   AddTestData(&data8, 1000);
   data8.result.resize(data8.data.size());
   suite.AddBenchmark("Impala Decimal8", TestImpala<Decimal8Value, int64_t>, &data8);
+  suite.AddBenchmark("Batched Decimal8", TestBatched<Decimal8Value, int64_t>, &data8);
 
   TestData<Decimal16Value> data16;
   data16.precision = ColumnType::MAX_PRECISION;
@@ -119,6 +139,8 @@ int main(int argc, char **argv) {
   AddTestData(&data16, 1000);
   data16.result.resize(data16.data.size());
   suite.AddBenchmark("Impala Decimal16", TestImpala<Decimal16Value, int128_t>, &data16);
+  suite.AddBenchmark(
+      "Batched Decimal16", TestBatched<Decimal16Value, int128_t>, &data16);
 
   cout << suite.Measure();
   return 0;
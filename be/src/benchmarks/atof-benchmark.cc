@@ -68,12 +68,14 @@ void AddTestData(TestData* data, const string& input) {
   data->data.push_back(StringValue(const_cast<char*>(str.c_str()), str.length()));
 }
 
-void AddTestData(TestData* data, int n, double min = -10, double max = 10) {
+void AddTestData(TestData* data, int n, double min = -10, double max = 10,
+    int precision = 6) {
   for (int i = 0; i < n; ++i) {
     double val = rand();
     val /= RAND_MAX;
     val = (val * (max - min)) + min;
     stringstream ss;
+    ss.precision(precision);
     ss << val;
     AddTestData(data, ss.str());
   }
@@ -131,5 +133,15 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("Impala", TestImpala, &data);
   cout << suite.Measure();
 
+  // Values with 15 significant digits, e.g. prices or measurements written in full.
+  TestData data_long;
+  AddTestData(&data_long, 1000, -5, 1000000, 15);
+  data_long.result.resize(data_long.data.size());
+
+  Benchmark suite_long("atof long");
+  suite_long.AddBenchmark("Strtod", TestStrtod, &data_long);
+  suite_long.AddBenchmark("Impala", TestImpala, &data_long);
+  cout << suite_long.Measure();
+
   return 0;
 }
@@ -20,6 +20,7 @@
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include "exec/text-converter.inline.h"
 #include "runtime/string-value.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
@@ -31,7 +32,8 @@ using namespace impala;
 
 // Benchmark for doing atoi.  This benchmark compares various implementations
 // to convert string to int32s.  The data is mostly positive, relatively small
-// numbers.
+// numbers. The batched text scanner kernel, TextConverter::ParseInt(), is also measured
+// on wide numbers, where it converts 8 digits at a time.
 //
 // Machine Info: Intel(R) Core(TM) i7-2600 CPU @ 3.40GHz
 // atoi:                 Function     Rate (iters/ms)          Comparison
@@ -62,6 +64,7 @@ struct TestData {
   vector<StringValue> data;
   vector<string> memory;
   vector<int32_t> result;
+  vector<int64_t> result64;
 };
 
 void AddTestData(TestData* data, const string& input) {
@@ -84,6 +87,16 @@ void AddTestData(TestData* data, int n, int32_t min = -10, int32_t max = 10,
   }
 }
 
+// Adds 'n' random numbers with 'num_digits' digits, as seen in BIGINT columns of ids.
+void AddLongTestData(TestData* data, int n, int num_digits) {
+  for (int i = 0; i < n; ++i) {
+    string str(1, '1' + rand() % 9);
+    while (static_cast<int>(str.size()) < num_digits) str += '0' + rand() % 10;
+    AddTestData(data, str);
+  }
+  data->result64.resize(data->data.size());
+}
+
 #define DIGIT(c) (c -'0')
 
 inline int32_t AtoiUnsafe(char* s, int len) {
@@ -202,6 +215,42 @@ void TestImpala(int batch_size, void* d) {
   }
 }
 
+void TestStrtoll(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      data->result64[j] = strtoll(data->data[j].ptr, NULL, 10);
+    }
+  }
+}
+
+void TestImpala64(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      const StringValue& str = data->data[j];
+      StringParser::ParseResult dummy;
+      data->result64[j] = StringParser::StringToInt<int64_t>(str.ptr, str.len, &dummy);
+    }
+  }
+}
+
+void TestImpalaBatched(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int n = data->data.size();
+    for (int j = 0; j < n; ++j) {
+      const StringValue& str = data->data[j];
+      StringParser::ParseResult dummy;
+      int32_t val = TextConverter::ParseInt<int32_t>(str.ptr, str.len, &dummy);
+      VALIDATE_RESULT(val, data->result[j], str.ptr);
+      data->result[j] = val;
+    }
+  }
+}
+
 void TestImpalaUnsafe(int batch_size, void* d) {
   TestData* data = reinterpret_cast<TestData*>(d);
   for (int i = 0; i < batch_size; ++i) {
@@ -251,6 +300,10 @@ int main(int argc, char **argv) {
   AddTestData(&data, 1000, -5, 1000);
   data.result.resize(data.data.size());
 
+  TestData data_wide;
+  AddTestData(&data_wide, 1000, 100000000, 999999999);
+  data_wide.result.resize(data_wide.data.size());
+
   TestData data_leading_space;
   AddTestData(&data_leading_space, 1000, -5, 1000, true, false);
   data_leading_space.result.resize(data_leading_space.data.size());
@@ -289,7 +342,23 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("impala_garbage", TestImpala, &data_garbage);
   suite.AddBenchmark("impala_trailing_garbage", TestImpala, &data_trailing_garbage);
 
+  suite.AddBenchmark("impala_batched", TestImpalaBatched, &data);
+  suite.AddBenchmark("impala_wide", TestImpala, &data_wide);
+  suite.AddBenchmark("impala_batched_wide", TestImpalaBatched, &data_wide);
+
   cout << suite.Measure();
 
+  TestData data_16_digits;
+  AddLongTestData(&data_16_digits, 1000, 16);
+  TestData data_19_digits;
+  AddLongTestData(&data_19_digits, 1000, 19);
+
+  Benchmark suite_long("atoi long");
+  suite_long.AddBenchmark("strtoll_16", TestStrtoll, &data_16_digits);
+  suite_long.AddBenchmark("impala_16", TestImpala64, &data_16_digits);
+  suite_long.AddBenchmark("strtoll_19", TestStrtoll, &data_19_digits);
+  suite_long.AddBenchmark("impala_19", TestImpala64, &data_19_digits);
+  cout << suite_long.Measure();
+
   return 0;
 }
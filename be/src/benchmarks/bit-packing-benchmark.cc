@@ -22,6 +22,8 @@
 //    of 32 values.
 // * UnpackScalar - an implementation that can unpack a variable number of values, using
 //   Unpack32Scalar internally.
+// * UnpackAVX2, UnpackAVX512 - UnpackValues() using the SimdBitPacking kernels, if
+//   supported by the machine.
 //
 //
 // Machine Info: Intel(R) Core(TM) i7-7700 CPU @ 3.60GHz
@@ -283,6 +285,9 @@ struct BenchmarkParams {
   int bit_width;
   const uint8_t* data;
   int64_t data_len;
+  /// CpuInfo feature to disable while running the benchmark, e.g. to force the scalar
+  /// implementation. 0 if none.
+  int64_t disabled_feature;
 };
 
 /// Legacy value-at-a-time implementation of bit unpacking. Retained here for
@@ -437,6 +442,7 @@ void Unpack32Benchmark(int batch_size, void* data) {
 /// Benchmark calling UnpackValues() to unpack 32 * 'batch_size' values.
 void UnpackBenchmark(int batch_size, void* data) {
   const BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  CpuInfo::TempDisable disabler(p->disabled_feature);
   const int64_t total_values_to_unpack = 32L * batch_size;
   for (int64_t unpacked = 0; unpacked < total_values_to_unpack;
        unpacked += NUM_OUT_VALUES) {
@@ -456,11 +462,25 @@ int main(int argc, char **argv) {
     const int64_t data_len = NUM_OUT_VALUES * bit_width / 8;
     vector<uint8_t> data(data_len);
     std::iota(data.begin(), data.end(), 0);
-    BenchmarkParams params{bit_width, data.data(), data_len};
+    BenchmarkParams params{bit_width, data.data(), data_len, 0};
+    // The SIMD kernels all require AVX2.
+    BenchmarkParams scalar_params{bit_width, data.data(), data_len, CpuInfo::AVX2};
+    BenchmarkParams avx2_params{bit_width, data.data(), data_len, CpuInfo::AVX512F};
     suite.AddBenchmark(Substitute("BitReader", bit_width), BitReaderBenchmark, &params);
     suite.AddBenchmark(
         Substitute("Unpack32Scalar", bit_width), Unpack32Benchmark, &params);
-    suite.AddBenchmark(Substitute("UnpackScalar", bit_width), UnpackBenchmark, &params);
+    suite.AddBenchmark(
+        Substitute("UnpackScalar", bit_width), UnpackBenchmark, &scalar_params);
+    if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+      suite.AddBenchmark(Substitute("UnpackAVX2", bit_width), UnpackBenchmark,
+          &avx2_params);
+    }
+    if (CpuInfo::IsSupported(CpuInfo::AVX512F)
+        && CpuInfo::IsSupported(CpuInfo::AVX512BW)
+        && CpuInfo::IsSupported(CpuInfo::AVX512VBMI)) {
+      suite.AddBenchmark(Substitute("UnpackAVX512", bit_width), UnpackBenchmark,
+          &params);
+    }
     cout << suite.Measure() << endl;
   }
   return 0;
@@ -0,0 +1,81 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gutil/strings/substitute.h"
+#include "util/benchmark.h"
+#include "util/blocking-queue.h"
+#include "util/cpu-info.h"
+#include "util/lock-free-blocking-queue.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+// Benchmark for BlockingQueue and LockFreeBlockingQueue with many producers that feed a
+// single consumer through a short queue, like the scanner threads of a scan node feed
+// its row batch queue. Every iteration moves ELEMS_PER_ITER elements through the queue.
+
+static const int ELEMS_PER_ITER = 10000;
+
+// Capacity of the queue, the default number of row batches in a scan node's queue.
+static const int QUEUE_CAPACITY = 10;
+
+struct TestData {
+  int num_producers;
+};
+
+template <typename Queue>
+void TestQueue(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  Queue queue(QUEUE_CAPACITY);
+  const int64_t num_elems = static_cast<int64_t>(batch_size) * ELEMS_PER_ITER;
+  const int64_t num_per_producer = num_elems / data->num_producers;
+  vector<std::thread> producers;
+  for (int i = 0; i < data->num_producers; ++i) {
+    producers.emplace_back([&queue, num_per_producer]() {
+      for (int64_t j = 0; j < num_per_producer; ++j) queue.BlockingPut(j);
+    });
+  }
+  int64_t value;
+  for (int64_t i = 0; i < num_per_producer * data->num_producers; ++i) {
+    queue.BlockingGet(&value);
+  }
+  for (std::thread& t : producers) t.join();
+}
+
+int main(int argc, char** argv) {
+  CpuInfo::Init();
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  Benchmark suite("blocking queue with one consumer", /* micro = */ false);
+  vector<unique_ptr<TestData>> data;
+  for (int num_producers : {1, 4, 16, 32}) {
+    data.emplace_back(new TestData{num_producers});
+    int baseline = suite.AddBenchmark(
+        Substitute("BlockingQueue $0 producers", num_producers),
+        TestQueue<BlockingQueue<int64_t>>, data.back().get(), -1);
+    suite.AddBenchmark(Substitute("LockFreeBlockingQueue $0 producers", num_producers),
+        TestQueue<LockFreeBlockingQueue<int64_t>>, data.back().get(), baseline);
+  }
+  cout << suite.Measure() << endl;
+  return 0;
+}
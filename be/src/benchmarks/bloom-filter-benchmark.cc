@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <iostream>
 #include <vector>
+#include <boost/thread/thread.hpp>
 
 #include "gen-cpp/data_stream_service.pb.h"
 #include "kudu/rpc/rpc_controller.h"
@@ -54,6 +55,11 @@ using kudu::rpc::RpcController;
 // 4. Lookups when the item is absent (this is theoretically faster than when the item is
 //    present in some Bloom filter variants)
 // 5. Unions
+// 6. Inserts of the same items by several threads into thread-local filters that are
+//    merged into one filter afterwards, as the local merge of partitioned join filters
+//    in RuntimeFilterBank does
+// 7. Lookups of present and absent items in batches with FindBatch(), which prefetches
+//    the buckets and uses AVX-512 if the CPU supports it and AVX2 is enabled
 //
 // As in bloom-filter.h, ndv refers to the number of unique items inserted into a filter
 // and fpp is the probability of false positives.
@@ -284,6 +290,28 @@ void Absent(int batch_size, void* data) {
   }
 }
 
+// Number of items of a FindBatch() call. Divides vec_mask + 1 for all ndvs below.
+static const int FIND_BATCH_SIZE = 256;
+
+void FindBatch(const vector<uint32_t>& items, int batch_size, TestData* d) {
+  bool found[FIND_BATCH_SIZE];
+  for (int i = 0; i < batch_size; i += FIND_BATCH_SIZE) {
+    const int num_items = min(FIND_BATCH_SIZE, batch_size - i);
+    d->bf.FindBatch(&items[i & d->vec_mask], num_items, found);
+    for (int j = 0; j < num_items; ++j) d->result += found[j];
+  }
+}
+
+void PresentBatch(int batch_size, void* data) {
+  TestData* d = reinterpret_cast<TestData*>(data);
+  FindBatch(d->present, batch_size, d);
+}
+
+void AbsentBatch(int batch_size, void* data) {
+  TestData* d = reinterpret_cast<TestData*>(data);
+  FindBatch(d->absent, batch_size, d);
+}
+
 }  // namespace find
 
 // Benchmark or
@@ -338,6 +366,56 @@ void Benchmark(int batch_size, void* data) {
 
 } // namespace either
 
+// Benchmark inserting a batch of items with several threads, each into its own filter,
+// followed by merging the filters into the first one. With one thread this is the same
+// as 'insert'.
+namespace parallel_insert {
+
+struct TestData {
+  TestData(int log_bufferpool_size, BufferPool::ClientHandle* client, int num_threads)
+    : data(1ull << 20) {
+    for (int i = 0; i < num_threads; ++i) {
+      filters.emplace_back(new BloomFilter(client));
+      CHECK(filters.back()->Init(log_bufferpool_size, 0).ok());
+    }
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = MakeRand();
+    }
+  }
+
+  ~TestData() {
+    for (unique_ptr<BloomFilter>& bf : filters) bf->Close();
+  }
+
+  vector<unique_ptr<BloomFilter>> filters;
+  vector<uint32_t> data;
+};
+
+// Inserts the items [begin, end) of the batch into the filter of thread 'thread_idx'.
+void InsertRange(TestData* d, int thread_idx, int begin, int end) {
+  BloomFilter* bf = d->filters[thread_idx].get();
+  for (int i = begin; i < end; ++i) {
+    bf->Insert(d->data[i & (d->data.size() - 1)]);
+  }
+}
+
+void Benchmark(int batch_size, void* data) {
+  TestData* d = reinterpret_cast<TestData*>(data);
+  int num_threads = d->filters.size();
+  int items_per_thread = (batch_size + num_threads - 1) / num_threads;
+  thread_group threads;
+  for (int t = 1; t < num_threads; ++t) {
+    int begin = min(batch_size, t * items_per_thread);
+    int end = min(batch_size, begin + items_per_thread);
+    threads.create_thread([d, t, begin, end]() { InsertRange(d, t, begin, end); });
+  }
+  InsertRange(d, 0, 0, min(batch_size, items_per_thread));
+  threads.join_all();
+  for (int t = 1; t < num_threads; ++t) d->filters[0]->Or(*d->filters[t]);
+}
+
+} // namespace parallel_insert
+
 void RunBenchmarks() {
   ObjectPool pool;
   RuntimeProfile* profile = RuntimeProfile::Create(&pool, "");
@@ -383,6 +461,14 @@ void RunBenchmarks() {
 
         snprintf(name, sizeof(name), "absent  ndv %7dk fpp %6.1f%%", ndv/1000, fpp*100);
         suite.AddBenchmark(name, find::Absent, testdata.back().get());
+
+        snprintf(name, sizeof(name), "present batch ndv %7dk fpp %6.1f%%", ndv/1000,
+            fpp*100);
+        suite.AddBenchmark(name, find::PresentBatch, testdata.back().get());
+
+        snprintf(name, sizeof(name), "absent  batch ndv %7dk fpp %6.1f%%", ndv/1000,
+            fpp*100);
+        suite.AddBenchmark(name, find::AbsentBatch, testdata.back().get());
       }
     }
     cout << suite.Measure() << endl;
@@ -406,6 +492,26 @@ void RunBenchmarks() {
     }
     cout << suite.Measure() << endl;
   }
+  CHECK(client.DecreaseReservationTo(numeric_limits<int64_t>::max(), 0).ok());
+
+  {
+    Benchmark suite("parallel insert", false /* micro_heuristics */);
+    vector<unique_ptr<parallel_insert::TestData> > testdata;
+    for (int ndv = 1000 * 1000; ndv <= 100 * 1000 * 1000; ndv *= 100) {
+      const double fpp = 0.01;
+      int log_required_size = BloomFilter::MinLogSpace(ndv, fpp);
+      for (int num_threads = 1; num_threads <= 8; num_threads *= 2) {
+        CHECK(client.IncreaseReservation(
+            num_threads * BloomFilter::GetExpectedMemoryUsed(log_required_size)));
+        testdata.emplace_back(
+            new parallel_insert::TestData(log_required_size, &client, num_threads));
+        snprintf(name, sizeof(name), "ndv %7dk fpp %6.1f%% threads %d", ndv / 1000,
+            fpp * 100, num_threads);
+        suite.AddBenchmark(name, parallel_insert::Benchmark, testdata.back().get());
+      }
+    }
+    cout << suite.Measure() << endl;
+  }
 
   CHECK(client.DecreaseReservationTo(numeric_limits<int64_t>::max(), 0).ok());
   env->buffer_pool()->DeregisterClient(&client);
@@ -438,7 +544,7 @@ int main(int argc, char **argv) {
     cout << suite.Measure() << endl;
   }
 
-  cout << "With AVX2:" << endl << endl;
+  cout << "With AVX2 (and AVX-512 for batched lookups if supported):" << endl << endl;
   FLAGS_disable_blockbloomfilter_avx2 = false;
   RunBenchmarks();
   cout << endl << "Without AVX or AVX2:" << endl << endl;
@@ -39,6 +39,7 @@
 #include "runtime/datetime-simple-date-format-parser.h"
 #include "runtime/timestamp-value.h"
 #include "runtime/timestamp-value.inline.h"
+#include "runtime/timezone-offset-cache.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/pretty-printer.h"
@@ -187,6 +188,22 @@ vector<TimestampValue> AddTestDataDateTimes(int n, const string& startstr) {
   return data;
 }
 
+// Timestamps a few seconds to 15 minutes apart, so that 1000 of them are within a week,
+// as in tables that are partitioned by day.
+vector<TimestampValue> AddNarrowTestDataDateTimes(int n, const string& startstr) {
+  random_device rd;
+  mt19937 gen(rd());
+  uniform_int_distribution<int64_t> dis_nanosec(0, 900000000000L);
+
+  TimestampValue ts = TimestampValue::ParseSimpleDateFormat(startstr);
+  vector<TimestampValue> data;
+  for (int i = 0; i < n; ++i) {
+    ts = ts.Add(boost::posix_time::nanoseconds(dis_nanosec(gen)));
+    data.push_back(ts);
+  }
+  return data;
+}
+
 template <class FROM, class TO, TO (*converter)(const FROM &)>
 class TestData {
 public:
@@ -693,6 +710,60 @@ TimestampVal cctz_to_utc(const TimestampVal& ts_val) {
   return ts_val_ret;
 }
 
+//
+// Test UtcToLocal and LocalToUtc of timestamps in a narrow range (TimezoneOffsetCache is
+// expected to be faster than CCTZ, and the batched conversion the fastest)
+//
+
+// Shared by the single-threaded benchmarks of the conversions with a cache.
+TimezoneOffsetCache LOCAL_TZ_CACHE;
+
+TimestampValue cached_utc_to_local(const TimestampValue& ts_value) {
+  TimestampValue result = ts_value;
+  result.UtcToLocal(&LOCAL_TZ_CACHE);
+  return result;
+}
+
+TimestampValue cached_local_to_utc(const TimestampValue& ts_value) {
+  TimestampValue result = ts_value;
+  result.LocalToUtc(&LOCAL_TZ_CACHE);
+  return result;
+}
+
+int64_t cctz_unix_time_to_local_seconds(const time_t& unix_time) {
+  static const cctz::civil_second epoch(1970, 1, 1, 0, 0, 0);
+  return cctz::convert(cctz_unix_time_to_time_point(unix_time), *PTR_CCTZ_LOCAL_TZ)
+      - epoch;
+}
+
+int64_t cached_unix_time_to_local_seconds(const time_t& unix_time) {
+  return LOCAL_TZ_CACHE.UtcToLocal(unix_time);
+}
+
+// Converts all Unix times with one call of the batched TimezoneOffsetCache::UtcToLocal().
+class BatchedUtcToLocalData {
+public:
+  BatchedUtcToLocalData(const vector<time_t>& data)
+    : data_(data.begin(), data.end()), result_(data.size()) {}
+
+  const vector<int64_t>& result() const { return result_; }
+
+  void add_to_benchmark(Benchmark& bm, const char* name) {
+    bm.AddBenchmark(name, run_test, this);
+  }
+
+  static void run_test(int batch_size, void *d) {
+    BatchedUtcToLocalData* data = reinterpret_cast<BatchedUtcToLocalData*>(d);
+    for (int i = 0; i < batch_size; ++i) {
+      LOCAL_TZ_CACHE.UtcToLocal(
+          data->data_.data(), data->data_.size(), data->result_.data());
+    }
+  }
+
+private:
+  const vector<int64_t> data_;
+  vector<int64_t> result_;
+};
 
 int main(int argc, char* argv[]) {
   CpuInfo::Init();
@@ -788,6 +859,69 @@ int main(int argc, char* argv[]) {
   bail_if_results_dont_match(vector<const vector<TimestampValue>*>{
       &glibc_utc_to_local_data.result(), &cctz_utc_to_local_data.result()});
 
+  // Benchmark UtcToLocal and LocalToUtc of timestamps within a week with cctz and with
+  // TimezoneOffsetCache
+  LOCAL_TZ_CACHE.Reset(PTR_CCTZ_LOCAL_TZ);
+  const vector<TimestampValue> narrow_tsvalue_data =
+      AddNarrowTestDataDateTimes(1000, "2017-05-01 00:00:00");
+
+  Benchmark bm_narrow_utc_to_local("UtcToLocal (one week)");
+  TestData<TimestampValue, TimestampValue, cctz_utc_to_local>
+      cctz_narrow_utc_to_local_data = narrow_tsvalue_data;
+  TestData<TimestampValue, TimestampValue, cached_utc_to_local>
+      cached_narrow_utc_to_local_data = narrow_tsvalue_data;
+
+  cctz_narrow_utc_to_local_data.add_to_benchmark(bm_narrow_utc_to_local,
+      "(Google/CCTZ)");
+  cached_narrow_utc_to_local_data.add_to_benchmark(bm_narrow_utc_to_local, "(cache)");
+  cout << bm_narrow_utc_to_local.Measure() << endl;
+
+  bail_if_results_dont_match(vector<const vector<TimestampValue>*>{
+      &cctz_narrow_utc_to_local_data.result(),
+      &cached_narrow_utc_to_local_data.result()});
+
+  Benchmark bm_narrow_local_to_utc("LocalToUtc (one week)");
+  TestData<TimestampValue, TimestampValue, cctz_local_to_utc>
+      cctz_narrow_local_to_utc_data = narrow_tsvalue_data;
+  TestData<TimestampValue, TimestampValue, cached_local_to_utc>
+      cached_narrow_local_to_utc_data = narrow_tsvalue_data;
+
+  cctz_narrow_local_to_utc_data.add_to_benchmark(bm_narrow_local_to_utc,
+      "(Google/CCTZ)");
+  cached_narrow_local_to_utc_data.add_to_benchmark(bm_narrow_local_to_utc, "(cache)");
+  cout << bm_narrow_local_to_utc.Measure() << endl;
+
+  bail_if_results_dont_match(vector<const vector<TimestampValue>*>{
+      &cctz_narrow_local_to_utc_data.result(),
+      &cached_narrow_local_to_utc_data.result()});
+
+  vector<time_t> narrow_time_data;
+  for (const TimestampValue& tsvalue: narrow_tsvalue_data) {
+    time_t unix_time;
+    tsvalue.ToUnixTime(&TimezoneDatabase::GetUtcTimezone(), &unix_time);
+    narrow_time_data.push_back(unix_time);
+  }
+
+  Benchmark bm_narrow_unix_time_to_local("UnixTimeToLocal (one week)");
+  TestData<time_t, int64_t, cctz_unix_time_to_local_seconds>
+      cctz_narrow_unix_time_to_local_data = narrow_time_data;
+  TestData<time_t, int64_t, cached_unix_time_to_local_seconds>
+      cached_narrow_unix_time_to_local_data = narrow_time_data;
+  BatchedUtcToLocalData batched_narrow_unix_time_to_local_data = narrow_time_data;
+
+  cctz_narrow_unix_time_to_local_data.add_to_benchmark(bm_narrow_unix_time_to_local,
+      "(Google/CCTZ)");
+  cached_narrow_unix_time_to_local_data.add_to_benchmark(bm_narrow_unix_time_to_local,
+      "(cache)");
+  batched_narrow_unix_time_to_local_data.add_to_benchmark(bm_narrow_unix_time_to_local,
+      "(cache, batched)");
+  cout << bm_narrow_unix_time_to_local.Measure() << endl;
+
+  bail_if_results_dont_match(vector<const vector<int64_t>*>{
+      &cctz_narrow_unix_time_to_local_data.result(),
+      &cached_narrow_unix_time_to_local_data.result(),
+      &batched_narrow_unix_time_to_local_data.result()});
+
   // Benchmark UnixTimeToLocalPtime with glibc/cctz
   vector<time_t> time_data;
   for (const TimestampValue& tsvalue: tsvalue_data) {
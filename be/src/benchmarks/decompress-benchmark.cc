@@ -0,0 +1,150 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "gutil/strings/substitute.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "util/benchmark.h"
+#include "util/codec.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using boost::scoped_ptr;
+using std::mt19937;
+using std::uniform_int_distribution;
+
+using namespace impala;
+
+// Measures the decompression of 1MB of delimited text with the zlib based codecs:
+//  * Preallocated: ProcessBlock() into a buffer of the decompressed size, like the
+//    scanners of formats that record the decompressed size of their blocks.
+//  * Unknown size: ProcessBlock() without an output buffer, like the sequence file and
+//    Avro scanners, which leaves the decompressor to size the output.
+//  * Streaming: ProcessBlockStreaming(), like the text scanner.
+// Every iteration decompresses the whole input, so the throughput in MB/s is the rate
+// times 1000.
+
+// Size of the uncompressed input.
+static const int64_t INPUT_LEN = 1024 * 1024;
+
+struct TestData {
+  string compressed;
+  scoped_ptr<Codec> decompressor;
+  // Buffer for the output of the preallocated benchmark.
+  vector<uint8_t> output;
+};
+
+void TestPreallocated(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    uint8_t* output = data->output.data();
+    int64_t output_len = data->output.size();
+    Status status = data->decompressor->ProcessBlock(true, data->compressed.size(),
+        reinterpret_cast<const uint8_t*>(data->compressed.data()), &output_len, &output);
+    DCHECK(status.ok()) << status.GetDetail();
+  }
+}
+
+void TestUnknownSize(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    uint8_t* output;
+    int64_t output_len;
+    Status status = data->decompressor->ProcessBlock(false, data->compressed.size(),
+        reinterpret_cast<const uint8_t*>(data->compressed.data()), &output_len, &output);
+    DCHECK(status.ok()) << status.GetDetail();
+  }
+}
+
+void TestStreaming(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    const uint8_t* input = reinterpret_cast<const uint8_t*>(data->compressed.data());
+    int64_t input_len = data->compressed.size();
+    bool stream_end = false;
+    while (!stream_end && input_len > 0) {
+      int64_t bytes_read;
+      int64_t output_len;
+      uint8_t* output;
+      Status status = data->decompressor->ProcessBlockStreaming(input_len, input,
+          &bytes_read, &output_len, &output, &stream_end);
+      DCHECK(status.ok()) << status.GetDetail();
+      input += bytes_read;
+      input_len -= bytes_read;
+    }
+  }
+}
+
+// Returns INPUT_LEN bytes of rows of delimited text.
+string GenerateInput() {
+  mt19937 rng(1234);
+  uniform_int_distribution<int> id_dist(0, 1000000);
+  uniform_int_distribution<int> word_dist(0, 9);
+  const char* words[] = {"alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf",
+      "hotel", "india", "juliett"};
+  string input;
+  while (input.size() < INPUT_LEN) {
+    input += Substitute("$0|$1|$2|2020-01-$3 12:00:00|$4.$5\n", id_dist(rng),
+        words[word_dist(rng)], words[word_dist(rng)], 10 + word_dist(rng), id_dist(rng),
+        word_dist(rng));
+  }
+  input.resize(INPUT_LEN);
+  return input;
+}
+
+int main(int argc, char** argv) {
+  CpuInfo::Init();
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  MemTracker tracker;
+  MemPool pool(&tracker);
+  string input = GenerateInput();
+  for (THdfsCompression::type format : {THdfsCompression::GZIP,
+      THdfsCompression::DEFAULT, THdfsCompression::DEFLATE}) {
+    TestData data;
+    scoped_ptr<Codec> compressor;
+    Status status = Codec::CreateCompressor(
+        &pool, true, Codec::CodecInfo(format), &compressor);
+    DCHECK(status.ok()) << status.GetDetail();
+    uint8_t* compressed;
+    int64_t compressed_len;
+    status = compressor->ProcessBlock(false, input.size(),
+        reinterpret_cast<const uint8_t*>(input.data()), &compressed_len, &compressed);
+    DCHECK(status.ok()) << status.GetDetail();
+    data.compressed.assign(reinterpret_cast<char*>(compressed), compressed_len);
+    compressor->Close();
+    status = Codec::CreateDecompressor(&pool, true, format, &data.decompressor);
+    DCHECK(status.ok()) << status.GetDetail();
+    data.output.resize(input.size());
+
+    Benchmark suite(Substitute("Decompress $0", Codec::GetCodecName(format)));
+    suite.AddBenchmark("Preallocated", TestPreallocated, &data);
+    suite.AddBenchmark("Unknown size", TestUnknownSize, &data);
+    suite.AddBenchmark("Streaming", TestStreaming, &data);
+    cout << suite.Measure() << endl;
+    data.decompressor->Close();
+  }
+  pool.FreeAll();
+  return 0;
+}
@@ -0,0 +1,131 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Test the performance of finding the fields and tuples of delimited text with
+// DelimitedTextParser::ParseFieldLocations(). This compares:
+// * SSE - SSE4.2 PCMPESTRM over 16 characters at a time.
+// * AVX2 - byte compares over 64 characters at a time.
+// * AVX512 - AVX-512BW byte compares over 64 characters at a time.
+// Each implementation is measured with short and long fields, and with a table that
+// has an escape character.
+//
+// Implementations not supported by the machine are skipped.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "exec/delimited-text-parser.inline.h"
+#include "gutil/strings/substitute.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+constexpr int NUM_COLS = 8;
+constexpr int NUM_ROWS = 8 * 1024;
+
+enum class ParseImpl { SSE, AVX2, AVX512 };
+
+struct BenchmarkParams {
+  ParseImpl impl;
+  TupleDelimitedTextParser* parser;
+  const string* data;
+  vector<char*>* row_end_locations;
+  vector<FieldLocation>* field_locations;
+};
+
+/// Benchmark parsing all the rows of 'data' 'batch_size' times.
+void ParseBenchmark(int batch_size, void* data) {
+  const BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  CpuInfo::TempDisable disable_avx512(
+      p->impl == ParseImpl::AVX512 ? 0 : CpuInfo::AVX512BW);
+  CpuInfo::TempDisable disable_avx2(p->impl == ParseImpl::SSE ? CpuInfo::AVX2 : 0);
+  for (int i = 0; i < batch_size; ++i) {
+    p->parser->ParserReset();
+    char* buffer = const_cast<char*>(p->data->data());
+    int num_tuples = 0;
+    int num_fields = 0;
+    char* next_column_start;
+    Status status = p->parser->ParseFieldLocations(NUM_ROWS, p->data->size(), &buffer,
+        p->row_end_locations->data(), p->field_locations->data(), &num_tuples,
+        &num_fields, &next_column_start);
+    DCHECK(status.ok());
+    DCHECK_EQ(num_tuples, NUM_ROWS);
+  }
+}
+
+/// Returns NUM_ROWS rows of NUM_COLS fields of up to 'max_field_len' characters. If
+/// 'escape_char' is not '\0', some of the field delimiters are escaped.
+string MakeData(int max_field_len, char escape_char) {
+  std::mt19937 rng(1234);
+  string data;
+  for (int r = 0; r < NUM_ROWS; ++r) {
+    for (int c = 0; c < NUM_COLS; ++c) {
+      const int len = rng() % (max_field_len + 1);
+      for (int i = 0; i < len; ++i) data += static_cast<char>('a' + rng() % 26);
+      if (escape_char != '\0' && rng() % 16 == 0) data += string(1, escape_char) + ',';
+      data += c == NUM_COLS - 1 ? '\n' : ',';
+    }
+  }
+  return data;
+}
+
+void RunBenchmarks(int max_field_len, char escape_char) {
+  Benchmark suite(Substitute("DelimitedTextParser field length <= $0$1", max_field_len,
+      escape_char == '\0' ? "" : " with escapes"));
+  bool is_materialized_col[NUM_COLS];
+  for (int i = 0; i < NUM_COLS; ++i) is_materialized_col[i] = true;
+  TupleDelimitedTextParser parser(
+      NUM_COLS, 0, is_materialized_col, '\n', ',', '\0', escape_char);
+  const string data = MakeData(max_field_len, escape_char);
+  vector<char*> row_end_locations(NUM_ROWS);
+  vector<FieldLocation> field_locations(NUM_ROWS * NUM_COLS);
+
+  vector<BenchmarkParams> params;
+  vector<string> names;
+  params.push_back(
+      {ParseImpl::SSE, &parser, &data, &row_end_locations, &field_locations});
+  names.push_back("SSE");
+  if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    params.push_back(
+        {ParseImpl::AVX2, &parser, &data, &row_end_locations, &field_locations});
+    names.push_back("AVX2");
+  }
+  if (CpuInfo::IsSupported(CpuInfo::AVX512BW)) {
+    params.push_back(
+        {ParseImpl::AVX512, &parser, &data, &row_end_locations, &field_locations});
+    names.push_back("AVX512");
+  }
+  for (int i = 0; i < params.size(); ++i) {
+    suite.AddBenchmark(names[i], ParseBenchmark, &params[i]);
+  }
+  cout << suite.Measure() << endl;
+}
+
+int main(int argc, char **argv) {
+  CpuInfo::Init();
+  cout << endl << Benchmark::GetMachineInfo() << endl;
+  for (int max_field_len : {4, 16, 64}) RunBenchmarks(max_field_len, '\0');
+  RunBenchmarks(16, '\\');
+  return 0;
+}
@@ -0,0 +1,127 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Test dictionary decoding performance of bit-packed literal runs for 4 and 8 byte
+// values and dictionary index bit widths from 1 to 20. This compares:
+// * Scalar - the value-at-a-time dictionary lookup.
+// * AVX2 - DictGather with AVX2 gathers.
+// * AVX512 - DictGather with AVX-512 gathers (and scatters for strided output).
+// Each implementation is measured with a contiguous output ('stride' == value size)
+// and with a strided output, as used when decoding directly into tuples.
+//
+// Implementations not supported by the machine are skipped.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "gutil/strings/substitute.h"
+#include "util/benchmark.h"
+#include "util/bit-packing.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+constexpr int NUM_VALUES = 64 * 1024;
+static_assert(NUM_VALUES % 32 == 0, "NUM_VALUES must be divisible by 32");
+
+/// Stride used for the strided output benchmarks, e.g. a tuple with a few slots.
+constexpr int TUPLE_STRIDE = 40;
+
+enum class DecodeImpl { SCALAR, AVX2, AVX512 };
+
+template <typename T>
+struct BenchmarkParams {
+  int bit_width;
+  DecodeImpl impl;
+  int64_t stride;
+  const uint8_t* data;
+  int64_t data_len;
+  T* dict;
+  int64_t dict_len;
+  uint8_t* out;
+};
+
+/// Benchmark decoding 'NUM_VALUES' dictionary-encoded values 'batch_size' times.
+template <typename T>
+void DecodeBenchmark(int batch_size, void* data) {
+  const BenchmarkParams<T>* p = reinterpret_cast<BenchmarkParams<T>*>(data);
+  CpuInfo::TempDisable disable_avx512(
+      p->impl == DecodeImpl::AVX512 ? 0 : CpuInfo::AVX512F);
+  CpuInfo::TempDisable disable_avx2(p->impl == DecodeImpl::SCALAR ? CpuInfo::AVX2 : 0);
+  bool decode_error = false;
+  for (int i = 0; i < batch_size; ++i) {
+    BitPacking::UnpackAndDecodeValues<T>(p->bit_width, p->data, p->data_len, p->dict,
+        p->dict_len, NUM_VALUES, reinterpret_cast<T*>(p->out), p->stride,
+        &decode_error);
+  }
+  DCHECK(!decode_error);
+}
+
+template <typename T>
+void RunBenchmarks() {
+  std::mt19937 rng(1234);
+  vector<uint8_t> out(NUM_VALUES * TUPLE_STRIDE);
+  for (int bit_width = 1; bit_width <= 20; ++bit_width) {
+    Benchmark suite(Substitute("DictDecode $0 bytes bit_width $1", sizeof(T), bit_width));
+    const int64_t dict_len = 1L << bit_width;
+    vector<T> dict(dict_len);
+    for (int64_t i = 0; i < dict_len; ++i) dict[i] = static_cast<T>(rng());
+    // Random bytes are valid indices because the dictionary has 2^bit_width entries.
+    const int64_t data_len = NUM_VALUES * bit_width / 8;
+    vector<uint8_t> data(data_len);
+    for (uint8_t& b : data) b = static_cast<uint8_t>(rng());
+
+    vector<BenchmarkParams<T>> params;
+    params.reserve(6);
+    vector<string> names;
+    for (int64_t stride : {static_cast<int64_t>(sizeof(T)),
+             static_cast<int64_t>(TUPLE_STRIDE)}) {
+      const string stride_name = stride == sizeof(T) ? "" : " strided";
+      params.push_back({bit_width, DecodeImpl::SCALAR, stride, data.data(), data_len,
+          dict.data(), dict_len, out.data()});
+      names.push_back("Scalar" + stride_name);
+      if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+        params.push_back({bit_width, DecodeImpl::AVX2, stride, data.data(), data_len,
+            dict.data(), dict_len, out.data()});
+        names.push_back("AVX2" + stride_name);
+      }
+      if (CpuInfo::IsSupported(CpuInfo::AVX512F)) {
+        params.push_back({bit_width, DecodeImpl::AVX512, stride, data.data(), data_len,
+            dict.data(), dict_len, out.data()});
+        names.push_back("AVX512" + stride_name);
+      }
+    }
+    for (int i = 0; i < params.size(); ++i) {
+      suite.AddBenchmark(names[i], DecodeBenchmark<T>, &params[i]);
+    }
+    cout << suite.Measure() << endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  CpuInfo::Init();
+  cout << endl << Benchmark::GetMachineInfo() << endl;
+  RunBenchmarks<int32_t>();
+  RunBenchmarks<int64_t>();
+  return 0;
+}
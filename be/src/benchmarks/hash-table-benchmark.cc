@@ -0,0 +1,167 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "exec/hash-table.inline.h"
+#include "exprs/scalar-expr-evaluator.h"
+#include "exprs/slot-ref.h"
+#include "runtime/bufferpool/buffer-pool.h"
+#include "runtime/bufferpool/suballocator.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/runtime-state.h"
+#include "runtime/test-env.h"
+#include "runtime/tuple-row.h"
+#include "runtime/tuple.h"
+#include "service/fe-support.h"
+#include "util/benchmark.h"
+
+#include "common/names.h"
+
+DECLARE_bool(enable_quadratic_probing);
+
+using namespace impala;
+
+// Benchmark for probing hash tables of int keys at different fill factors, with and
+// without group probing (--hash_table_group_probing). Each table has 1M buckets, so
+// the buckets do not fit in the CPU caches, as in large joins and aggregations. Half
+// of the probe rows match an entry of the table. The benchmark reports the number of
+// thousands of probes per ms.
+
+// Number of buckets of each hash table.
+static const int64_t NUM_BUCKETS = 1L << 20;
+
+// Number of rows probed per iteration.
+static const int NUM_PROBE_ROWS = 4096;
+
+struct ProbeData {
+  HashTable* table;
+  HashTableCtx* ht_ctx;
+  vector<TupleRow*> probe_rows;
+  int64_t num_matches = 0;
+};
+
+static TupleRow* CreateTupleRow(MemPool* pool, int32_t val) {
+  TupleRow* row = reinterpret_cast<TupleRow*>(pool->Allocate(sizeof(Tuple*)));
+  Tuple* tuple = Tuple::Create(sizeof(char) + sizeof(int32_t), pool);
+  *reinterpret_cast<int32_t*>(tuple->GetSlot(1)) = val;
+  tuple->SetNotNull(NullIndicatorOffset(0, 1));
+  row->SetTuple(0, tuple);
+  return row;
+}
+
+static void TestProbe(int batch_size, void* d) {
+  ProbeData* data = reinterpret_cast<ProbeData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    for (TupleRow* row : data->probe_rows) {
+      if (!data->ht_ctx->EvalAndHashProbe(row)) continue;
+      data->num_matches += !data->table->FindProbeRow(data->ht_ctx).AtEnd();
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  impala::InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
+  impala::InitFeSupport();
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  TestEnv test_env;
+  ABORT_IF_ERROR(test_env.Init());
+  RuntimeState* state;
+  ABORT_IF_ERROR(test_env.CreateQueryState(0, nullptr, &state));
+
+  ObjectPool pool;
+  MemTracker tracker;
+  MemPool mem_pool(&tracker);
+  RowDescriptor desc;
+  vector<ScalarExpr*> build_exprs{pool.Add(new SlotRef(ColumnType(TYPE_INT), 1, true))};
+  vector<ScalarExpr*> probe_exprs{pool.Add(new SlotRef(ColumnType(TYPE_INT), 1, true))};
+  ABORT_IF_ERROR(build_exprs[0]->Init(desc, true, nullptr));
+  ABORT_IF_ERROR(probe_exprs[0]->Init(desc, true, nullptr));
+  boost::scoped_ptr<HashTableCtx> ht_ctx;
+  ABORT_IF_ERROR(HashTableCtx::Create(&pool, state, build_exprs, probe_exprs, false,
+      vector<bool>(1, false), 1, 0, 1, &mem_pool, &mem_pool, &mem_pool, &ht_ctx));
+  ABORT_IF_ERROR(ht_ctx->Open(state));
+
+  BufferPool* buffer_pool = test_env.exec_env()->buffer_pool();
+  RuntimeProfile* profile = RuntimeProfile::Create(&pool, "ht");
+  BufferPool::ClientHandle client;
+  ABORT_IF_ERROR(buffer_pool->RegisterClient("", nullptr,
+      state->instance_buffer_reservation(), nullptr, std::numeric_limits<int64_t>::max(),
+      profile, &client));
+  Suballocator allocator(buffer_pool, &client, 64 * 1024);
+
+  vector<HashTable*> tables;
+  for (double fill_factor : {0.5, 0.75, 0.9}) {
+    int num_rows = NUM_BUCKETS * fill_factor;
+    vector<unique_ptr<ProbeData>> probe_data;
+    Benchmark suite(Substitute("Probe (fill factor $0)", fill_factor));
+    for (bool quadratic : {false, true}) {
+      for (bool group_probing : {false, true}) {
+        FLAGS_enable_quadratic_probing = quadratic;
+        CHECK(client.IncreaseReservation(
+            NUM_BUCKETS * (HashTable::BucketSize() + 1) + 64 * 1024));
+        HashTable* table = HashTable::Create(
+            group_probing, &allocator, false, 1, nullptr, -1, NUM_BUCKETS);
+        tables.push_back(table);
+        bool got_memory;
+        ABORT_IF_ERROR(table->Init(&got_memory));
+        CHECK(got_memory);
+        for (int i = 0; i < num_rows; ++i) {
+          TupleRow* row = CreateTupleRow(&mem_pool, 2 * i);
+          CHECK(ht_ctx->EvalAndHashBuild(row));
+          Status status;
+          CHECK(table->Insert(ht_ctx.get(), nullptr, row, &status));
+          ABORT_IF_ERROR(status);
+        }
+        probe_data.emplace_back(new ProbeData);
+        ProbeData* data = probe_data.back().get();
+        data->table = table;
+        data->ht_ctx = ht_ctx.get();
+        // Even values are in the table, odd values are not.
+        for (int i = 0; i < NUM_PROBE_ROWS; ++i) {
+          data->probe_rows.push_back(
+              CreateTupleRow(&mem_pool, (rand() % num_rows) * 2 + i % 2));
+        }
+        suite.AddBenchmark(Substitute("$0$1", quadratic ? "Quadratic" : "Linear",
+            group_probing ? "Group" : "Bucket"), TestProbe, data);
+      }
+    }
+    cout << suite.Measure() << endl;
+  }
+
+  for (HashTable* table : tables) {
+    table->Close();
+    delete table;
+  }
+  ht_ctx->Close(state);
+  buffer_pool->DeregisterClient(&client);
+  ScalarExpr::Close(build_exprs);
+  ScalarExpr::Close(probe_exprs);
+  mem_pool.FreeAll();
+  return 0;
+}
@@ -0,0 +1,111 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Test the performance of merging and estimating the HyperLogLog intermediates of NDV()
+// for each precision from 9 to 18. This compares:
+// * Scalar - the register-at-a-time loops.
+// * AVX2 - the HllSimd kernels.
+// Merge measures AggregateFunctions::HllMerge() and Estimate measures
+// AggregateFunctions::HllFinalEstimate(), each on a batch of intermediates.
+//
+// Implementations not supported by the machine are skipped.
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "exprs/aggregate-functions.h"
+#include "gutil/strings/substitute.h"
+#include "udf/udf.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using namespace impala;
+using impala_udf::StringVal;
+
+/// Number of intermediates that each iteration merges or estimates.
+constexpr int NUM_INTERMEDIATES = 64;
+
+struct BenchmarkParams {
+  bool use_simd;
+  int hll_len;
+  vector<vector<uint8_t>>* intermediates;
+  vector<uint8_t>* merged;
+  /// Sum of the estimates, so that they are not optimized away.
+  uint64_t total_estimate;
+};
+
+void MergeBenchmark(int batch_size, void* data) {
+  BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  CpuInfo::TempDisable disable_avx2(p->use_simd ? 0 : CpuInfo::AVX2);
+  StringVal dst(p->merged->data(), p->hll_len);
+  for (int i = 0; i < batch_size; ++i) {
+    for (vector<uint8_t>& intermediate : *p->intermediates) {
+      AggregateFunctions::HllMerge(
+          nullptr, StringVal(intermediate.data(), p->hll_len), &dst);
+    }
+  }
+}
+
+void EstimateBenchmark(int batch_size, void* data) {
+  BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  CpuInfo::TempDisable disable_avx2(p->use_simd ? 0 : CpuInfo::AVX2);
+  for (int i = 0; i < batch_size; ++i) {
+    for (const vector<uint8_t>& intermediate : *p->intermediates) {
+      p->total_estimate +=
+          AggregateFunctions::HllFinalEstimate(intermediate.data(), p->hll_len);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  CpuInfo::Init();
+  cout << endl << Benchmark::GetMachineInfo() << endl;
+  std::mt19937 rng(1234);
+  // Registers of an HLL that has seen many more values than it has registers.
+  std::geometric_distribution<int> register_dist(0.5);
+  for (int precision = AggregateFunctions::MIN_HLL_PRECISION;
+       precision <= AggregateFunctions::MAX_HLL_PRECISION; ++precision) {
+    const int hll_len = 1 << precision;
+    vector<vector<uint8_t>> intermediates(NUM_INTERMEDIATES, vector<uint8_t>(hll_len));
+    for (vector<uint8_t>& intermediate : intermediates) {
+      for (uint8_t& r : intermediate) r = 1 + register_dist(rng);
+    }
+    vector<uint8_t> merged(hll_len);
+
+    vector<BenchmarkParams> params;
+    vector<string> names;
+    params.push_back({false, hll_len, &intermediates, &merged, 0});
+    names.push_back("Scalar");
+    if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+      params.push_back({true, hll_len, &intermediates, &merged, 0});
+      names.push_back("AVX2");
+    }
+
+    Benchmark merge_suite(Substitute("HllMerge precision $0", precision));
+    Benchmark estimate_suite(Substitute("HllFinalEstimate precision $0", precision));
+    for (int i = 0; i < params.size(); ++i) {
+      merge_suite.AddBenchmark(names[i], MergeBenchmark, &params[i]);
+      estimate_suite.AddBenchmark(names[i], EstimateBenchmark, &params[i]);
+    }
+    cout << merge_suite.Measure() << endl;
+    cout << estimate_suite.Measure() << endl;
+  }
+  return 0;
+}
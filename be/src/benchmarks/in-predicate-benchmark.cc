@@ -664,18 +664,19 @@ class InPredicateBenchmark {
 
   template<typename T, typename SetType>
   static TestData<T, SetType> CreateTestData(int num_values,
-      const FunctionContext::TypeDesc& type, int num_search_vals = 100) {
+      const FunctionContext::TypeDesc& type, int num_search_vals = 100,
+      int value_range = 0) {
     srand(time(NULL));
     TestData<T, SetType> data;
     data.anyvals.resize(num_values);
     data.anyval_ptrs.resize(num_values);
     for (int i = 0; i < num_values; ++i) {
-      data.anyvals[i] = MakeAnyVal<T>(rand());
+      data.anyvals[i] = MakeAnyVal<T>(RandomValue(value_range));
       data.anyval_ptrs[i] = &data.anyvals[i];
     }
 
     for (int i = 0; i < num_search_vals; ++i) {
-      data.search_vals.push_back(MakeAnyVal<T>(rand()));
+      data.search_vals.push_back(MakeAnyVal<T>(RandomValue(value_range)));
     }
 
     FunctionContext* ctx = CreateContext(num_values, type);
@@ -718,13 +719,18 @@ class InPredicateBenchmark {
     }
   }
 
+  /// If 'value_range' is not 0, the values of the IN list and the values searched for
+  /// are in [0, value_range), so some of the values are found.
   template <typename AnyValType, typename SetType, FunctionContext::Type TypeDesc>
-  static void RunBenchmark(int n) {
-    Benchmark suite(Substitute("$0 n=$1", GetTypeName(TypeDesc), n));
+  static void RunBenchmark(int n, int value_range = 0) {
+    Benchmark suite(value_range == 0 ?
+        Substitute("$0 n=$1", GetTypeName(TypeDesc), n) :
+        Substitute("$0 n=$1 range=$2", GetTypeName(TypeDesc), n, value_range));
     FunctionContext::TypeDesc type;
     type.type = TypeDesc;
     InPredicateBenchmark::TestData<AnyValType, SetType> data =
-        InPredicateBenchmark::CreateTestData<AnyValType, SetType>(n, type);
+        InPredicateBenchmark::CreateTestData<AnyValType, SetType>(
+            n, type, 100, value_range);
     suite.AddBenchmark(Substitute("SetLookup n=$0", n),
         InPredicateBenchmark::TestSetLookup<AnyValType, SetType>, &data);
     suite.AddBenchmark(Substitute("Iterate n=$0", n),
@@ -733,6 +739,10 @@ class InPredicateBenchmark {
   }
 
  private:
+  static int RandomValue(int value_range) {
+    return value_range == 0 ? rand() : rand() % value_range;
+  }
+
   static FunctionContext* CreateContext(
       int num_args, const FunctionContext::TypeDesc& type) {
     // Types don't matter (but number of args do)
@@ -768,7 +778,8 @@ class InPredicateBenchmark {
 
 template <>
 void InPredicateBenchmark::RunBenchmark<DecimalVal, Decimal16Value,
-    FunctionContext::TYPE_DECIMAL>(int n) {
+    FunctionContext::TYPE_DECIMAL>(int n, int value_range) {
+  DCHECK_EQ(value_range, 0);
   Benchmark suite(Substitute("decimal(4,0) n=$0", n));
   FunctionContext::TypeDesc type;
   type.type = FunctionContext::TYPE_DECIMAL;
@@ -788,7 +799,8 @@ void InPredicateBenchmark::RunBenchmark<DecimalVal, Decimal16Value,
   for (int i = 1; i <= 10; ++i) { \
     InPredicateBenchmark::RunBenchmark<AnyValType, SetType, type_desc>(i); \
   } \
-  InPredicateBenchmark::RunBenchmark<AnyValType, SetType, type_desc>(400);
+  InPredicateBenchmark::RunBenchmark<AnyValType, SetType, type_desc>(400); \
+  InPredicateBenchmark::RunBenchmark<AnyValType, SetType, type_desc>(4000);
 
 int main(int argc, char **argv) {
   CpuInfo::Init();
@@ -804,5 +816,11 @@ int main(int argc, char **argv) {
   RUN_BENCHMARK(TimestampVal, TimestampValue, FunctionContext::TYPE_TIMESTAMP)
   RUN_BENCHMARK(DecimalVal, Decimal16Value, FunctionContext::TYPE_DECIMAL)
 
+  // IN lists of integers from a small range, e.g. ids generated by BI tools.
+  InPredicateBenchmark::RunBenchmark<IntVal, int32_t, FunctionContext::TYPE_INT>(
+      4000, 16000);
+  InPredicateBenchmark::RunBenchmark<BigIntVal, int64_t, FunctionContext::TYPE_BIGINT>(
+      4000, 16000);
+
   return 0;
 }
@@ -16,6 +16,9 @@
 // under the License.
 
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <sys/resource.h>
 
 #include <thrift/protocol/TBinaryProtocol.h>
 #include <thrift/protocol/TDebugProtocol.h>
@@ -24,21 +27,65 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/uuid/uuid_generators.hpp>
 #include "gen-cpp/NetworkTest_types.h"
 #include "gen-cpp/NetworkTestService.h"
+#include "gen-cpp/data_stream_service.pb.h"
+#include "gen-cpp/data_stream_service.proxy.h"
+#include "gen-cpp/data_stream_service.service.h"
 
+#include "common/atomic.h"
 #include "common/init.h"
 #include "common/logging.h"
-#include "util/cpu-info.h"
-#include "util/stopwatch.h"
+#include "kudu/rpc/rpc_context.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "rpc/rpc-mgr.inline.h"
 #include "rpc/thrift-client.h"
 #include "rpc/thrift-server.h"
 #include "rpc/thrift-thread.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/row-batch.h"
+#include "runtime/string-value.h"
+#include "runtime/tuple.h"
+#include "runtime/tuple-row.h"
+#include "service/data-stream-service.h"
+#include "service/fe-support.h"
+#include "service/frontend.h"
+#include "testutil/desc-tbl-builder.h"
+#include "util/cpu-info.h"
+#include "util/debug-util.h"
+#include "util/hdr-histogram.h"
+#include "util/kudu-status-util.h"
+#include "util/network-util.h"
+#include "util/parse-util.h"
+#include "util/pretty-printer.h"
+#include "util/runtime-profile.h"
+#include "util/stopwatch.h"
+#include "util/time.h"
+#include "util/uid-util.h"
 
 #include "common/names.h"
 
 DEFINE_int32(port, 22222, "Port for NetworkTestService");
 DEFINE_int64(send_batch_size, 0, "Batch size (in bytes).  Data is split up into batches");
+DEFINE_bool(krpc, false, "If true, the server hosts a DataStreamService on --krpc_port "
+    "instead of the Thrift NetworkTestService, and 'send' and 'broadcast' transmit "
+    "serialized row batches to it the way exchange senders do.");
+DEFINE_int32(krpc_port, 22223, "Port for the DataStreamService in KRPC mode");
+DEFINE_int32(krpc_batch_rows, 1024, "Number of rows of each row batch in KRPC mode");
+DEFINE_string(krpc_compression, "lz4",
+    "Codec of the row batches in KRPC mode: 'none', 'lz4' or 'zstd'");
+DEFINE_int32(krpc_channels, 1, "Number of channels to each target in KRPC mode. Each "
+    "channel has at most one TransmitData() RPC in flight, like the channels of an "
+    "exchange sender.");
+
+DECLARE_int32(datastream_service_num_svc_threads);
+DECLARE_string(datastream_service_queue_mem_limit);
+DECLARE_int32(rpc_retry_interval_ms);
+DECLARE_string(hostname);
 
 // Simple client server network speed benchmark utility.  This compiles to
 // a binary that runs as both the client and server.  The server can be started
@@ -55,6 +102,17 @@ DEFINE_int64(send_batch_size, 0, "Batch size (in bytes).  Data is split up into
 // and issue the send from another.
 // For 'broadcast', the server should be started on all the machines and then the
 // broadcast is issued from one of them.
+//
+// With --krpc, the benchmark models the exchange instead: the server hosts a
+// DataStreamService with --datastream_service_num_svc_threads service threads and a
+// service queue limited by --datastream_service_queue_mem_limit, which deserializes the
+// row batches it receives with RowBatch::FromProtobuf(). 'send' and 'broadcast' open
+// --krpc_channels channels to each target, which serialize row batches of
+// --krpc_batch_rows (BIGINT, STRING) rows with --krpc_compression and send them as
+// TransmitData() sidecars, retrying when the service queue is full. The size is the
+// serialized size of the row batches. The client reports the throughput, the latency
+// of the RPCs, the retries and its CPU time per GB, and the server reports its CPU time
+// per GB once all channels sent EOS.
 
 using boost::algorithm::is_any_of;
 using boost::algorithm::token_compress_on;
@@ -68,6 +126,10 @@ using namespace apache::thrift::concurrency;
 using namespace impala;
 using namespace impalatest;
 
+using kudu::rpc::RpcContext;
+using kudu::rpc::RpcController;
+using kudu::rpc::RpcSidecar;
+
 
 class TestServer : public NetworkTestServiceIf {
  public:
@@ -116,6 +178,345 @@ double Send(ThriftClient<NetworkTestServiceClient>* client, int64_t bytes) {
   return mb/sec;
 }
 
+/// The highest RPC latency in microseconds that the KRPC mode's histogram tracks.
+static const int64_t MAX_RPC_LATENCY_US = 60LL * MICROS_PER_SEC;
+
+/// The plan node id that the KRPC mode's row batches are sent to. Not checked.
+static const int DEST_NODE_ID = 1;
+
+/// Set up by InitKrpc() in KRPC mode. 'exec_env' is not destroyed, as its threads may
+/// still run at exit.
+static scoped_ptr<Frontend> fe;
+static ExecEnv* exec_env = nullptr;
+
+/// The (BIGINT, STRING) schema of the row batches of the KRPC mode. Created in main().
+static ObjectPool obj_pool;
+static RowDescriptor* row_desc;
+
+// Returns the user and system CPU time of this process in nanoseconds.
+static int64_t ProcessCpuTimeNs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * NANOS_PER_SEC
+      + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * NANOS_PER_MICRO;
+}
+
+// Returns 'cpu_ns' per GB of 'bytes' for printing.
+static string CpuPerGb(int64_t cpu_ns, int64_t bytes) {
+  if (bytes == 0) return "n/a";
+  return PrettyPrinter::Print(
+      static_cast<int64_t>(cpu_ns * (1024. * 1024. * 1024.) / bytes), TUnit::TIME_NS);
+}
+
+// Creates the schema of the row batches in 'row_desc'.
+static void CreateRowDescriptor() {
+  DescriptorTblBuilder builder(fe.get(), &obj_pool);
+  builder.DeclareTuple() << TYPE_BIGINT << TYPE_STRING;
+  DescriptorTbl* desc_tbl = builder.Build();
+  row_desc = obj_pool.Add(
+      new RowDescriptor(*desc_tbl, vector<TTupleId>(1, 0), vector<bool>(1, false)));
+}
+
+// Fills 'batch' to its capacity with rows of increasing ids and strings of 8 to 40
+// characters, of which the ids and the repeated characters compress well.
+static void FillRowBatch(RowBatch* batch) {
+  const TupleDescriptor* tuple_desc = row_desc->tuple_descriptors()[0];
+  const SlotDescriptor* id_slot = tuple_desc->slots()[0];
+  const SlotDescriptor* str_slot = tuple_desc->slots()[1];
+  const int tuple_size = tuple_desc->byte_size();
+  const int capacity = batch->capacity();
+  uint8_t* tuple_mem = batch->tuple_data_pool()->Allocate(tuple_size * capacity);
+  memset(tuple_mem, 0, tuple_size * capacity);
+  for (int i = 0; i < capacity; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size);
+    *reinterpret_cast<int64_t*>(tuple->GetSlot(id_slot->tuple_offset())) = i;
+    const int len = 8 + (i * 7) % 33;
+    char* str = reinterpret_cast<char*>(batch->tuple_data_pool()->Allocate(len));
+    for (int j = 0; j < len; ++j) str[j] = 'a' + (i + j / 4) % 26;
+    StringValue* str_value =
+        reinterpret_cast<StringValue*>(tuple->GetSlot(str_slot->tuple_offset()));
+    str_value->ptr = str;
+    str_value->len = len;
+    int idx = batch->AddRow();
+    batch->GetRow(idx)->SetTuple(0, tuple);
+    batch->CommitLastRow();
+  }
+}
+
+// A DataStreamService that deserializes the row batches it receives and then drops
+// them. It keeps the totals of the streams that are open, i.e. have sent row batches but
+// not EOS, and prints them when the last open stream is closed.
+class NetworkTestDataStreamService : public DataStreamServiceIf {
+ public:
+  NetworkTestDataStreamService(RpcMgr* rpc_mgr)
+    : DataStreamServiceIf(rpc_mgr->metric_entity(), rpc_mgr->result_tracker()),
+      rpc_mgr_(rpc_mgr),
+      profile_(RuntimeProfile::Create(&obj_pool, "Network Test Recvr")) {
+    MemTracker* process_mem_tracker = exec_env->process_mem_tracker();
+    bool is_percent;
+    int64_t bytes_limit = ParseUtil::ParseMemSpec(
+        FLAGS_datastream_service_queue_mem_limit, &is_percent,
+        process_mem_tracker->limit());
+    if (bytes_limit <= 0) bytes_limit = -1;
+    mem_tracker_.reset(
+        new MemTracker(bytes_limit, "Network Test Service Queue", process_mem_tracker));
+    batch_mem_tracker_.reset(
+        new MemTracker(-1, "Network Test Row Batches", process_mem_tracker));
+  }
+
+  Status Init() {
+    RETURN_IF_ERROR(exec_env->buffer_pool()->RegisterClient("Network Test Recvr",
+        nullptr, exec_env->buffer_reservation(), batch_mem_tracker_.get(),
+        numeric_limits<int64_t>::max(), profile_, &client_));
+    // Like DataStreamService::Init(), the queue is only bounded by 'mem_tracker_'.
+    int num_svc_threads = FLAGS_datastream_service_num_svc_threads > 0 ?
+        FLAGS_datastream_service_num_svc_threads : CpuInfo::num_cores();
+    return rpc_mgr_->RegisterService(num_svc_threads, numeric_limits<int32_t>::max(),
+        this, mem_tracker_.get(), exec_env->rpc_metrics());
+  }
+
+  virtual bool Authorize(const google::protobuf::Message* req,
+      google::protobuf::Message* resp, RpcContext* context) override {
+    return rpc_mgr_->Authorize("DataStreamService", context, mem_tracker_.get());
+  }
+
+  virtual void TransmitData(const TransmitDataRequestPB* request,
+      TransmitDataResponsePB* response, RpcContext* context) override {
+    const int64_t start_time_ns = MonotonicNanos();
+    StreamStarted(request->dest_fragment_instance_id());
+    kudu::Slice tuple_offsets;
+    kudu::Slice tuple_data;
+    Status status = FromKuduStatus(context->GetInboundSidecar(
+        request->tuple_offsets_sidecar_idx(), &tuple_offsets), "No tuple offsets");
+    if (status.ok()) {
+      status = FromKuduStatus(context->GetInboundSidecar(
+          request->tuple_data_sidecar_idx(), &tuple_data), "No tuple data");
+    }
+    if (status.ok()) {
+      unique_ptr<RowBatch> batch;
+      status = RowBatch::FromProtobuf(row_desc, request->row_batch_header(),
+          tuple_offsets, tuple_data, batch_mem_tracker_.get(), &client_, &batch);
+      bytes_received_.Add(tuple_offsets.size() + tuple_data.size());
+    }
+    response->set_receiver_latency_ns(MonotonicNanos() - start_time_ns);
+    DataStreamService::RespondAndReleaseRpc(
+        status, response, context, mem_tracker_.get());
+  }
+
+  virtual void EndDataStream(const EndDataStreamRequestPB* request,
+      EndDataStreamResponsePB* response, RpcContext* context) override {
+    StreamEnded(request->dest_fragment_instance_id());
+    DataStreamService::RespondAndReleaseRpc(
+        Status::OK(), response, context, mem_tracker_.get());
+  }
+
+  virtual void UpdateFilter(const UpdateFilterParamsPB* req, UpdateFilterResultPB* resp,
+      RpcContext* context) override {
+    DataStreamService::RespondAndReleaseRpc(
+        Status("Not supported"), resp, context, mem_tracker_.get());
+  }
+
+  virtual void PublishFilter(const PublishFilterParamsPB* req,
+      PublishFilterResultPB* resp, RpcContext* context) override {
+    DataStreamService::RespondAndReleaseRpc(
+        Status("Not supported"), resp, context, mem_tracker_.get());
+  }
+
+  void Close() { exec_env->buffer_pool()->DeregisterClient(&client_); }
+
+ private:
+  // Adds the stream of 'finst_id' to 'open_streams_' and starts the totals if it is the
+  // first open stream.
+  void StreamStarted(const UniqueIdPB& finst_id) {
+    lock_guard<mutex> l(lock_);
+    if (!open_streams_.insert(PrintId(finst_id)).second) return;
+    if (open_streams_.size() == 1) {
+      bytes_received_.Store(0);
+      start_cpu_ns_ = ProcessCpuTimeNs();
+      timer_.Reset();
+      timer_.Start();
+    }
+  }
+
+  // Removes the stream of 'finst_id' and prints the totals if it was the last one.
+  void StreamEnded(const UniqueIdPB& finst_id) {
+    lock_guard<mutex> l(lock_);
+    if (open_streams_.erase(PrintId(finst_id)) == 0 || !open_streams_.empty()) return;
+    const int64_t bytes = bytes_received_.Load();
+    const double sec = timer_.ElapsedTime() / static_cast<double>(NANOS_PER_SEC);
+    cout << endl << "Received " << PrettyPrinter::Print(bytes, TUnit::BYTES) << " at "
+         << (bytes / (1024. * 1024.) / sec) << " MB/s, CPU per GB: "
+         << CpuPerGb(ProcessCpuTimeNs() - start_cpu_ns_, bytes) << endl;
+  }
+
+  RpcMgr* rpc_mgr_;
+
+  // Tracks the payloads in the service queue and the deserialized row batches.
+  unique_ptr<MemTracker> mem_tracker_;
+  unique_ptr<MemTracker> batch_mem_tracker_;
+
+  // The buffer pool client that the row batches are deserialized into.
+  RuntimeProfile* profile_;
+  BufferPool::ClientHandle client_;
+
+  // Protects the fields below.
+  mutex lock_;
+  set<string> open_streams_;
+  int64_t start_cpu_ns_ = 0;
+  MonotonicStopWatch timer_;
+
+  // Serialized bytes received since the first of the open streams started.
+  AtomicInt64 bytes_received_{0};
+};
+
+// The totals of all channels of a KRPC send.
+struct KrpcSendStats {
+  KrpcSendStats() : rpc_latency_us(MAX_RPC_LATENCY_US, 2) {}
+
+  HdrHistogram rpc_latency_us;
+  AtomicInt64 serialized_bytes{0};
+  AtomicInt64 uncompressed_bytes{0};
+  AtomicInt64 retries{0};
+};
+
+// Sets up the frontend, the row schema and the ExecEnv with its buffer pool and RpcMgr
+// for the KRPC mode.
+static Status InitKrpc() {
+  InitFeSupport();
+  fe.reset(new Frontend());
+  CreateRowDescriptor();
+  exec_env = new ExecEnv();
+  RETURN_IF_ERROR(exec_env->InitForFeSupport());
+  exec_env->InitBufferPool(64 * 1024, 4L * 1024 * 1024 * 1024, 64 * 1024);
+  IpAddr ip;
+  RETURN_IF_ERROR(HostnameToIpAddr(FLAGS_hostname, &ip));
+  return exec_env->rpc_mgr()->Init(MakeNetworkAddress(ip, FLAGS_krpc_port));
+}
+
+// Sends at least 'bytes' of serialized row batches to 'address' as the sender
+// 'sender_id' of a new stream, and then EOS. Each row batch is serialized before it is
+// sent, and the next only once the previous RPC completed.
+static Status KrpcSendChannel(const TNetworkAddress& address, int64_t bytes,
+    int sender_id, CompressionTypePB::type codec, KrpcSendStats* stats) {
+  unique_ptr<DataStreamServiceProxy> proxy;
+  RETURN_IF_ERROR(DataStreamService::GetProxy(address, address.hostname, &proxy));
+  UniqueIdPB finst_id;
+  UUIDToUniqueIdPB(boost::uuids::random_generator()(), &finst_id);
+
+  MemTracker tracker(-1, "Network Test Sender", exec_env->process_mem_tracker());
+  RowBatch batch(row_desc, FLAGS_krpc_batch_rows, &tracker);
+  FillRowBatch(&batch);
+  OutboundRowBatch outbound_batch;
+  int64_t total_sent = 0;
+  while (total_sent < bytes) {
+    RETURN_IF_ERROR(batch.Serialize(&outbound_batch, codec));
+    TransmitDataRequestPB req;
+    *req.mutable_dest_fragment_instance_id() = finst_id;
+    req.set_sender_id(sender_id);
+    req.set_dest_node_id(DEST_NODE_ID);
+    req.set_allocated_row_batch_header(
+        const_cast<RowBatchHeaderPB*>(outbound_batch.header()));
+    RpcController controller;
+    int idx;
+    KUDU_RETURN_IF_ERROR(controller.AddOutboundSidecar(
+        RpcSidecar::FromSlice(outbound_batch.TupleOffsetsAsSlice()), &idx),
+        "Unable to add tuple offsets to sidecar");
+    req.set_tuple_offsets_sidecar_idx(idx);
+    KUDU_RETURN_IF_ERROR(controller.AddOutboundSidecar(
+        RpcSidecar::FromSlice(outbound_batch.TupleDataAsSlice()), &idx),
+        "Unable to add tuple data to sidecar");
+    req.set_tuple_data_sidecar_idx(idx);
+
+    TransmitDataResponsePB resp;
+    const int64_t start_time_ns = MonotonicNanos();
+    kudu::Status rpc_status = proxy->TransmitData(req, &resp, &controller);
+    const int64_t latency_us = (MonotonicNanos() - start_time_ns) / NANOS_PER_MICRO;
+    // 'req' doesn't own the header.
+    req.release_row_batch_header();
+    if (!rpc_status.ok()) {
+      if (RpcMgr::IsServerTooBusy(controller)) {
+        stats->retries.Add(1);
+        SleepForMs(FLAGS_rpc_retry_interval_ms);
+        continue;
+      }
+      return FromKuduStatus(rpc_status, "TransmitData() failed");
+    }
+    RETURN_IF_ERROR(Status(resp.status()));
+    stats->rpc_latency_us.Increment(min<int64_t>(latency_us, MAX_RPC_LATENCY_US));
+    const int64_t serialized_bytes = RowBatch::GetSerializedSize(outbound_batch);
+    total_sent += serialized_bytes;
+    stats->serialized_bytes.Add(serialized_bytes);
+    stats->uncompressed_bytes.Add(RowBatch::GetDeserializedSize(outbound_batch));
+  }
+
+  EndDataStreamRequestPB eos_req;
+  *eos_req.mutable_dest_fragment_instance_id() = finst_id;
+  eos_req.set_sender_id(sender_id);
+  eos_req.set_dest_node_id(DEST_NODE_ID);
+  EndDataStreamResponsePB eos_resp;
+  RpcController controller;
+  KUDU_RETURN_IF_ERROR(proxy->EndDataStream(eos_req, &eos_resp, &controller),
+      "EndDataStream() failed");
+  return Status(eos_resp.status());
+}
+
+// Sends 'bytes' of serialized row batches to each of 'targets' in parallel over
+// --krpc_channels channels each, and prints the stats of the sends.
+static void KrpcSend(const vector<string>& targets, int64_t bytes) {
+  CompressionTypePB::type codec;
+  if (FLAGS_krpc_compression == "none") {
+    codec = CompressionTypePB::NONE;
+  } else if (FLAGS_krpc_compression == "lz4") {
+    codec = CompressionTypePB::LZ4;
+  } else if (FLAGS_krpc_compression == "zstd") {
+    codec = CompressionTypePB::ZSTD;
+  } else {
+    cerr << "Invalid --krpc_compression: " << FLAGS_krpc_compression << endl;
+    return;
+  }
+  const int num_channels = max(1, FLAGS_krpc_channels);
+  KrpcSendStats stats;
+  vector<Status> statuses(targets.size() * num_channels);
+
+  const int64_t start_cpu_ns = ProcessCpuTimeNs();
+  MonotonicStopWatch timer;
+  timer.Start();
+  thread_group threads;
+  for (int i = 0; i < targets.size(); ++i) {
+    TNetworkAddress address = MakeNetworkAddress(targets[i], FLAGS_krpc_port);
+    for (int j = 0; j < num_channels; ++j) {
+      Status* status = &statuses[i * num_channels + j];
+      threads.add_thread(new thread([=, &stats]() {
+        *status = KrpcSendChannel(address, bytes / num_channels, j, codec, &stats);
+      }));
+    }
+  }
+  threads.join_all();
+  timer.Stop();
+  const int64_t cpu_ns = ProcessCpuTimeNs() - start_cpu_ns;
+
+  for (const Status& status : statuses) {
+    if (!status.ok()) {
+      cerr << "Send failed: " << status.GetDetail() << endl;
+      return;
+    }
+  }
+  const int64_t total_bytes = stats.serialized_bytes.Load();
+  const double mb = total_bytes / (1024. * 1024.);
+  const double sec = timer.ElapsedTime() / static_cast<double>(NANOS_PER_SEC);
+  cout << "Send rate per node: (MB/s) " << (mb / targets.size() / sec) << endl;
+  cout << "Send rate cluster: (MB/s) " << (mb / sec) << endl;
+  cout << "Uncompressed rate cluster: (MB/s) "
+       << (stats.uncompressed_bytes.Load() / (1024. * 1024.) / sec) << endl;
+  const HdrHistogram& latency = stats.rpc_latency_us;
+  cout << "RPCs: " << latency.TotalCount() << ", latency p50: "
+       << PrettyPrinter::Print(latency.ValueAtPercentile(50), TUnit::TIME_US)
+       << ", p99: " << PrettyPrinter::Print(latency.ValueAtPercentile(99), TUnit::TIME_US)
+       << ", max: " << PrettyPrinter::Print(latency.MaxValue(), TUnit::TIME_US) << endl;
+  cout << "Retries (service queue full): " << stats.retries.Load() << endl;
+  cout << "CPU per GB sent: " << CpuPerGb(cpu_ns, total_bytes) << endl;
+}
+
 // Send tokens[1] megabytes to tokens[2]
 void HandleSend(const vector<string>& tokens) {
   if (tokens.size() != 3) {
@@ -126,6 +527,10 @@ void HandleSend(const vector<string>& tokens) {
   int64_t bytes = mbs * (1024L * 1024L);
   cout << "Sending " << mbs << " megabytes..." << endl;
   const string& ip = tokens[2];
+  if (FLAGS_krpc) {
+    KrpcSend({ip}, bytes);
+    return;
+  }
 
   ThriftClient<NetworkTestServiceClient> client(ip, FLAGS_port);
   Status status = client.Open();
@@ -150,6 +555,10 @@ void HandleBroadcast(const vector<string>& tokens) {
   int64_t mbs = atoi(tokens[1].c_str());
   int64_t bytes = mbs * (1024L * 1024L);
   cout << "Broadcasting " << mbs << " megabytes..." << endl;
+  if (FLAGS_krpc) {
+    KrpcSend(vector<string>(tokens.begin() + 2, tokens.end()), bytes);
+    return;
+  }
 
   vector<ThriftClient<NetworkTestServiceClient>* > clients;
   for (int i = 2; i < tokens.size(); ++i) {
@@ -204,7 +613,8 @@ bool ProcessCommand(const vector<string>& tokens) {
 
 int main(int argc, char** argv) {
   google::ParseCommandLineFlags(&argc, &argv, true);
-  impala::InitCommonRuntime(argc, argv, false, impala::TestInfo::BE_TEST);
+  impala::InitCommonRuntime(argc, argv, FLAGS_krpc, impala::TestInfo::BE_TEST);
+  if (FLAGS_krpc) ABORT_IF_ERROR(InitKrpc());
 
   if (argc != 1) {
     // Just run client from command line args
@@ -214,19 +624,28 @@ int main(int argc, char** argv) {
     }
     ConvertToLowerCase(&tokens);
     ProcessCommand(tokens);
+    if (FLAGS_krpc) exec_env->rpc_mgr()->Shutdown();
     return 0;
   }
 
   // Start up server and client shell
+  ThriftServer* server = nullptr;
+  thread* server_thread = nullptr;
   std::shared_ptr<TestServer> handler(new TestServer);
-  std::shared_ptr<ThreadFactory> thread_factory(
-      new ThriftThreadFactory("test", "test"));
-  std::shared_ptr<TProcessor> processor(new NetworkTestServiceProcessor(handler));
-  ThriftServer* server;
-  ABORT_IF_ERROR(ThriftServerBuilder("Network Test Server", processor, FLAGS_port)
-                     .max_concurrent_connections(100)
-                     .Build(&server));
-  thread* server_thread = new thread(&TestServer::Server, handler.get(), server);
+  unique_ptr<NetworkTestDataStreamService> krpc_service;
+  if (FLAGS_krpc) {
+    krpc_service.reset(new NetworkTestDataStreamService(exec_env->rpc_mgr()));
+    ABORT_IF_ERROR(krpc_service->Init());
+    ABORT_IF_ERROR(exec_env->rpc_mgr()->StartServices());
+  } else {
+    std::shared_ptr<ThreadFactory> thread_factory(
+        new ThriftThreadFactory("test", "test"));
+    std::shared_ptr<TProcessor> processor(new NetworkTestServiceProcessor(handler));
+    ABORT_IF_ERROR(ThriftServerBuilder("Network Test Server", processor, FLAGS_port)
+                       .max_concurrent_connections(100)
+                       .Build(&server));
+    server_thread = new thread(&TestServer::Server, handler.get(), server);
+  }
 
   string input;
   while (1) {
@@ -243,8 +662,14 @@ int main(int argc, char** argv) {
     if (ProcessCommand(tokens)) break;
   }
 
-  server->StopForTesting();
-  server_thread->join();
+  if (FLAGS_krpc) {
+    // Shutdown() shuts down 'krpc_service' before it is destroyed.
+    exec_env->rpc_mgr()->Shutdown();
+    krpc_service->Close();
+  } else {
+    server->StopForTesting();
+    server_thread->join();
+  }
 
   return 0;
 }
@@ -0,0 +1,470 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+#include <gutil/strings/substitute.h>
+
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "exec/hash-table.inline.h"
+#include "exprs/scalar-expr-evaluator.h"
+#include "exprs/slot-ref.h"
+#include "runtime/bufferpool/buffer-pool.h"
+#include "runtime/bufferpool/suballocator.h"
+#include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/row-batch.h"
+#include "runtime/runtime-state.h"
+#include "runtime/sorter.h"
+#include "runtime/string-value.h"
+#include "runtime/test-env.h"
+#include "runtime/tmp-file-mgr.h"
+#include "runtime/tuple-row.h"
+#include "runtime/tuple.h"
+#include "service/fe-support.h"
+#include "service/frontend.h"
+#include "testutil/desc-tbl-builder.h"
+#include "util/benchmark.h"
+#include "util/bit-util.h"
+#include "util/pretty-printer.h"
+#include "util/runtime-profile-counters.h"
+#include "util/stopwatch.h"
+#include "util/tuple-row-compare.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+// Benchmark for the operators that dominate the CPU time of large queries: the Sorter,
+// which is used by sort, top-n with spilling and aggregation spilling, and the hash
+// table work of the build and probe phases of hash joins and of grouping aggregations.
+// The operators consume synthetic row batches of (BIGINT key, STRING payload, BIGINT)
+// rows with a controlled number of distinct keys, key skew and payload width.
+//
+// For every configuration, the benchmark first runs the operator once and reports the
+// rows processed per second, the peak memory of the operator and the bytes it spilled.
+// Then it measures the configurations of each operator relative to each other with the
+// regular benchmark harness, in invocations per ms. The operators are interpreted, like
+// with DISABLE_CODEGEN=true.
+//
+// The exchange is covered by row-batch-serialize-benchmark (serialization) and
+// network-perf-benchmark (KRPC transfers).
+
+// Page length for the Sorter and the buffer pool.
+static const int64_t PAGE_LEN = 64 * 1024;
+
+// Reservation of configurations that are not meant to spill.
+static const int64_t UNLIMITED_RESERVATION = 4L * 1024L * 1024L * 1024L;
+
+// Number of input rows of every configuration.
+static const int64_t NUM_ROWS = 1L << 20;
+
+static boost::scoped_ptr<Frontend> fe;
+
+// Shape of the synthetic input of an operator.
+struct TableConfig {
+  // Number of distinct keys.
+  int64_t cardinality;
+
+  // If true, the key of a row is drawn from a power law distribution in which the
+  // smallest keys are the most frequent. Otherwise the keys are uniformly distributed.
+  bool skewed;
+
+  // Length of the string payload of every row.
+  int payload_len;
+
+  string Name() const {
+    return Substitute("keys=$0 $1 payload=$2B", cardinality,
+        skewed ? "skewed" : "uniform", payload_len);
+  }
+};
+
+// Descriptors and query-level state shared by all runs.
+struct OperatorEnv {
+  TestEnv test_env;
+  RuntimeState* state = nullptr;
+  ObjectPool obj_pool;
+  RowDescriptor* row_desc = nullptr;
+  TupleDescriptor* tuple_desc = nullptr;
+  int key_offset = -1;
+  int payload_offset = -1;
+  int count_offset = -1;
+
+  void Init() {
+    test_env.SetBufferPoolArgs(PAGE_LEN, 2 * UNLIMITED_RESERVATION);
+    ABORT_IF_ERROR(test_env.Init());
+    ABORT_IF_ERROR(test_env.CreateQueryState(0, nullptr, &state));
+    DescriptorTblBuilder builder(fe.get(), &obj_pool);
+    builder.DeclareTuple() << TYPE_BIGINT << TYPE_STRING << TYPE_BIGINT;
+    DescriptorTbl* desc_tbl = builder.Build();
+    row_desc = obj_pool.Add(new RowDescriptor(
+        *desc_tbl, vector<TTupleId>(1, 0), vector<bool>(1, false)));
+    tuple_desc = row_desc->tuple_descriptors()[0];
+    const vector<SlotDescriptor*>& slots = tuple_desc->slots();
+    key_offset = slots[0]->tuple_offset();
+    payload_offset = slots[1]->tuple_offset();
+    count_offset = slots[2]->tuple_offset();
+  }
+
+  // Returns a SlotRef for the key of the rows.
+  ScalarExpr* KeyExpr(ObjectPool* pool) const {
+    ScalarExpr* expr = pool->Add(new SlotRef(ColumnType(TYPE_BIGINT), key_offset));
+    ABORT_IF_ERROR(expr->Init(*row_desc, true, nullptr));
+    return expr;
+  }
+};
+
+static OperatorEnv* env;
+
+// Synthetic input rows, in batches of the default batch size.
+struct Table {
+  MemTracker tracker;
+  vector<unique_ptr<RowBatch>> batches;
+  int64_t num_rows = 0;
+
+  // Generates 'num_rows' rows of the shape 'config'. If 'unique_keys' is true, the
+  // keys are 0 to 'num_rows' - 1 instead.
+  Table(const TableConfig& config, int64_t num_rows, bool unique_keys) {
+    const int batch_size = env->state->batch_size();
+    mt19937 rng(num_rows + config.cardinality);
+    uniform_real_distribution<double> dist(0, 1);
+    while (this->num_rows < num_rows) {
+      batches.emplace_back(new RowBatch(env->row_desc, batch_size, &tracker));
+      RowBatch* batch = batches.back().get();
+      while (!batch->AtCapacity() && this->num_rows < num_rows) {
+        int64_t key = this->num_rows;
+        if (!unique_keys) {
+          const double u = dist(rng);
+          key = config.cardinality * (config.skewed ? pow(u, 4) : u);
+          key = min(key, config.cardinality - 1);
+        }
+        Tuple* tuple = Tuple::Create(env->tuple_desc->byte_size(),
+            batch->tuple_data_pool());
+        *reinterpret_cast<int64_t*>(tuple->GetSlot(env->key_offset)) = key;
+        char* payload = reinterpret_cast<char*>(
+            batch->tuple_data_pool()->Allocate(config.payload_len));
+        for (int i = 0; i < config.payload_len; ++i) payload[i] = 'a' + (key + i) % 26;
+        *reinterpret_cast<StringValue*>(tuple->GetSlot(env->payload_offset)) =
+            StringValue(payload, config.payload_len);
+        TupleRow* row = batch->GetRow(batch->AddRow());
+        row->SetTuple(0, tuple);
+        batch->CommitLastRow();
+        ++this->num_rows;
+      }
+    }
+  }
+
+  ~Table() {
+    batches.clear();
+    tracker.Close();
+  }
+};
+
+// Statistics of one run of an operator.
+struct RunStats {
+  int64_t rows_out = 0;
+  int64_t peak_mem = 0;
+  int64_t spilled_bytes = 0;
+};
+
+// A buffer pool client with its own MemTracker and spill files, like the ones that
+// ExecNodes register.
+class OperatorClient {
+ public:
+  OperatorClient(const string& name, int64_t reservation_limit)
+    : profile_(RuntimeProfile::Create(&obj_pool_, name)),
+      file_group_(env->test_env.tmp_file_mgr(),
+          env->test_env.exec_env()->disk_io_mgr(), profile_, TUniqueId()) {
+    ABORT_IF_ERROR(buffer_pool()->RegisterClient(name, &file_group_,
+        env->state->instance_buffer_reservation(), &tracker_, reservation_limit,
+        profile_, &client_));
+  }
+
+  ~OperatorClient() {
+    buffer_pool()->DeregisterClient(&client_);
+    file_group_.Close();
+    tracker_.Close();
+  }
+
+  void Finish(RunStats* stats) {
+    stats->peak_mem = tracker_.peak_consumption();
+    vector<RuntimeProfile::Counter*> counters;
+    profile_->GetCounters("WriteIoBytes", &counters);
+    for (RuntimeProfile::Counter* counter : counters) {
+      stats->spilled_bytes += counter->value();
+    }
+  }
+
+  static BufferPool* buffer_pool() { return env->test_env.exec_env()->buffer_pool(); }
+  BufferPool::ClientHandle* client() { return &client_; }
+  MemTracker* tracker() { return &tracker_; }
+  RuntimeProfile* profile() { return profile_; }
+  ObjectPool* obj_pool() { return &obj_pool_; }
+
+ private:
+  ObjectPool obj_pool_;
+  MemTracker tracker_;
+  RuntimeProfile* profile_;
+  TmpFileGroup file_group_;
+  BufferPool::ClientHandle client_;
+};
+
+// Arguments of the benchmark functions.
+struct OperatorArgs {
+  string name;
+  TableConfig config;
+  // Maximum reservation of the operator. The Sorter spills if the input does not fit.
+  int64_t reservation_limit;
+  unique_ptr<Table> input;
+  // Build input of hash joins, with one row for every key.
+  unique_ptr<Table> build;
+  RunStats stats;
+};
+
+// Sorts the input by the key with a Sorter and reads the sorted rows.
+static void RunSort(OperatorArgs* args) {
+  OperatorClient op("Sort", args->reservation_limit);
+  ObjectPool* pool = op.obj_pool();
+  vector<ScalarExpr*> ordering_exprs{env->KeyExpr(pool)};
+  vector<ScalarExpr*> sort_tuple_exprs;
+  for (const SlotDescriptor* slot : env->tuple_desc->slots()) {
+    ScalarExpr* expr = pool->Add(new SlotRef(slot->type(), slot->tuple_offset()));
+    ABORT_IF_ERROR(expr->Init(*env->row_desc, true, nullptr));
+    sort_tuple_exprs.push_back(expr);
+  }
+  TSortInfo sort_info;
+  sort_info.__set_is_asc_order(vector<bool>(1, true));
+  sort_info.__set_nulls_first(vector<bool>(1, false));
+  sort_info.__set_sorting_order(TSortingOrder::LEXICAL);
+  TupleRowComparatorConfig comparator_config(sort_info, ordering_exprs);
+
+  Sorter sorter(comparator_config, sort_tuple_exprs, env->row_desc, op.tracker(),
+      op.client(), PAGE_LEN, op.profile(), env->state, "Sort", true,
+      CodegenFnPtr<SortHelperFn>());
+  ABORT_IF_ERROR(sorter.Prepare(pool));
+  CHECK(op.client()->IncreaseReservation(sorter.ComputeMinReservation()));
+  ABORT_IF_ERROR(sorter.Open());
+  for (const unique_ptr<RowBatch>& batch : args->input->batches) {
+    ABORT_IF_ERROR(sorter.AddBatch(batch.get()));
+  }
+  ABORT_IF_ERROR(sorter.InputDone());
+  RowBatch output(env->row_desc, env->state->batch_size(), op.tracker());
+  bool eos = false;
+  while (!eos) {
+    ABORT_IF_ERROR(sorter.GetNext(&output, &eos));
+    args->stats.rows_out += output.num_rows();
+    output.Reset();
+  }
+  sorter.Close(env->state);
+  ScalarExpr::Close(ordering_exprs);
+  ScalarExpr::Close(sort_tuple_exprs);
+  op.Finish(&args->stats);
+}
+
+// Creates and opens a HashTableCtx and a HashTable of the keys of the rows that can
+// hold 'num_keys' keys without resizing.
+static void CreateHashTable(OperatorClient* op, int64_t num_keys, MemPool* mem_pool,
+    vector<ScalarExpr*>* exprs, boost::scoped_ptr<HashTableCtx>* ht_ctx,
+    Suballocator* allocator, HashTable** table) {
+  exprs->push_back(env->KeyExpr(op->obj_pool()));
+  ABORT_IF_ERROR(HashTableCtx::Create(op->obj_pool(), env->state, *exprs, *exprs, false,
+      vector<bool>(1, false), 1, 0, 1, mem_pool, mem_pool, mem_pool, ht_ctx));
+  ABORT_IF_ERROR((*ht_ctx)->Open(env->state));
+  CHECK(op->client()->IncreaseReservationToFit(op->client()->GetUnusedReservation()
+      + UNLIMITED_RESERVATION / 2));
+  const int64_t num_buckets = BitUtil::RoundUpToPowerOfTwo(2 * num_keys);
+  *table = HashTable::Create(false, allocator, false, 1, nullptr, -1, num_buckets);
+  bool got_memory;
+  ABORT_IF_ERROR((*table)->Init(&got_memory));
+  CHECK(got_memory);
+}
+
+// Builds a hash table of the build rows and probes it with every input row, like the
+// build and probe phases of an inner hash join.
+static void RunHashJoin(OperatorArgs* args) {
+  OperatorClient op("HashJoin", args->reservation_limit);
+  MemPool mem_pool(op.tracker());
+  vector<ScalarExpr*> exprs;
+  boost::scoped_ptr<HashTableCtx> ht_ctx;
+  Suballocator allocator(OperatorClient::buffer_pool(), op.client(), PAGE_LEN);
+  HashTable* table;
+  CreateHashTable(&op, args->build->num_rows, &mem_pool, &exprs, &ht_ctx, &allocator,
+      &table);
+  for (const unique_ptr<RowBatch>& batch : args->build->batches) {
+    for (int i = 0; i < batch->num_rows(); ++i) {
+      TupleRow* row = batch->GetRow(i);
+      if (!ht_ctx->EvalAndHashBuild(row)) continue;
+      Status status;
+      CHECK(table->Insert(ht_ctx.get(), nullptr, row, &status));
+      ABORT_IF_ERROR(status);
+    }
+  }
+  for (const unique_ptr<RowBatch>& batch : args->input->batches) {
+    for (int i = 0; i < batch->num_rows(); ++i) {
+      if (!ht_ctx->EvalAndHashProbe(batch->GetRow(i))) continue;
+      for (HashTable::Iterator it = table->FindProbeRow(ht_ctx.get()); !it.AtEnd();
+           it.NextDuplicate()) {
+        ++args->stats.rows_out;
+      }
+    }
+  }
+  op.Finish(&args->stats);
+  table->Close();
+  delete table;
+  ht_ctx->Close(env->state);
+  ScalarExpr::Close(exprs);
+  mem_pool.FreeAll();
+}
+
+// Counts the input rows of every key in a hash table of aggregate tuples, like a
+// grouping aggregation with COUNT(*).
+static void RunAggregation(OperatorArgs* args) {
+  OperatorClient op("Aggregation", args->reservation_limit);
+  MemPool mem_pool(op.tracker());
+  vector<ScalarExpr*> exprs;
+  boost::scoped_ptr<HashTableCtx> ht_ctx;
+  Suballocator allocator(OperatorClient::buffer_pool(), op.client(), PAGE_LEN);
+  HashTable* table;
+  CreateHashTable(&op, args->config.cardinality, &mem_pool, &exprs, &ht_ctx,
+      &allocator, &table);
+  const int count_offset = env->count_offset;
+  for (const unique_ptr<RowBatch>& batch : args->input->batches) {
+    for (int i = 0; i < batch->num_rows(); ++i) {
+      TupleRow* row = batch->GetRow(i);
+      if (!ht_ctx->EvalAndHashBuild(row)) continue;
+      bool found;
+      HashTable::Iterator it = table->FindBuildRowBucket(ht_ctx.get(), &found);
+      DCHECK(!it.AtEnd());
+      if (found) {
+        ++*reinterpret_cast<int64_t*>(it.GetTuple()->GetSlot(count_offset));
+        continue;
+      }
+      Tuple* agg_tuple = Tuple::Create(env->tuple_desc->byte_size(), &mem_pool);
+      *reinterpret_cast<int64_t*>(agg_tuple->GetSlot(env->key_offset)) =
+          *reinterpret_cast<int64_t*>(row->GetTuple(0)->GetSlot(env->key_offset));
+      *reinterpret_cast<int64_t*>(agg_tuple->GetSlot(count_offset)) = 1;
+      it.SetTuple(agg_tuple, ht_ctx->expr_values_cache()->CurExprValuesHash());
+    }
+  }
+  args->stats.rows_out = table->size();
+  op.Finish(&args->stats);
+  table->Close();
+  delete table;
+  ht_ctx->Close(env->state);
+  ScalarExpr::Close(exprs);
+  mem_pool.FreeAll();
+}
+
+template <void (*RUN)(OperatorArgs*)>
+static void BenchmarkOperator(int batch_size, void* data) {
+  OperatorArgs* args = reinterpret_cast<OperatorArgs*>(data);
+  for (int i = 0; i < batch_size; ++i) {
+    args->stats = RunStats();
+    RUN(args);
+  }
+}
+
+// Runs every configuration once to report its statistics, then benchmarks them.
+template <void (*RUN)(OperatorArgs*)>
+static void RunSuite(const string& name, vector<unique_ptr<OperatorArgs>>* configs) {
+  cout << name << endl;
+  cout << setw(48) << left << "Configuration" << setw(14) << right << "Rows/s"
+       << setw(14) << "Rows out" << setw(14) << "Peak mem" << setw(14) << "Spilled"
+       << endl;
+  Benchmark suite(name, false);
+  for (const unique_ptr<OperatorArgs>& args : *configs) {
+    args->stats = RunStats();
+    MonotonicStopWatch sw;
+    sw.Start();
+    RUN(args.get());
+    const double secs = max<double>(sw.ElapsedTime() / 1e9, 1e-9);
+    cout << setw(48) << left << args->name << setw(14) << right
+         << PrettyPrinter::Print(args->input->num_rows / secs, TUnit::UNIT)
+         << setw(14) << args->stats.rows_out
+         << setw(14) << PrettyPrinter::Print(args->stats.peak_mem, TUnit::BYTES)
+         << setw(14) << PrettyPrinter::Print(args->stats.spilled_bytes, TUnit::BYTES)
+         << endl;
+    suite.AddBenchmark(args->name, BenchmarkOperator<RUN>, args.get());
+  }
+  cout << endl << suite.Measure(2000, 1) << endl;
+}
+
+static unique_ptr<OperatorArgs> MakeArgs(const TableConfig& config,
+    int64_t reservation_limit, bool build_side) {
+  unique_ptr<OperatorArgs> args(new OperatorArgs());
+  args->config = config;
+  args->reservation_limit = reservation_limit;
+  args->name = config.Name();
+  if (reservation_limit != UNLIMITED_RESERVATION) {
+    args->name += " limit=" + PrettyPrinter::Print(reservation_limit, TUnit::BYTES);
+  }
+  args->input.reset(new Table(config, NUM_ROWS, false));
+  if (build_side) args->build.reset(new Table(config, config.cardinality, true));
+  return args;
+}
+
+int main(int argc, char** argv) {
+  impala::InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
+  impala::InitFeSupport();
+  fe.reset(new Frontend());
+  cout << Benchmark::GetMachineInfo() << endl;
+  env = new OperatorEnv();
+  env->Init();
+
+  {
+    vector<unique_ptr<OperatorArgs>> configs;
+    configs.push_back(MakeArgs({NUM_ROWS, false, 8}, UNLIMITED_RESERVATION, false));
+    configs.push_back(MakeArgs({1024, false, 8}, UNLIMITED_RESERVATION, false));
+    configs.push_back(MakeArgs({NUM_ROWS, true, 8}, UNLIMITED_RESERVATION, false));
+    configs.push_back(MakeArgs({NUM_ROWS, false, 100}, UNLIMITED_RESERVATION, false));
+    configs.push_back(MakeArgs({NUM_ROWS, false, 100}, 16 * 1024 * 1024, false));
+    RunSuite<RunSort>("Sort", &configs);
+  }
+  {
+    vector<unique_ptr<OperatorArgs>> configs;
+    for (int64_t cardinality : {1024L, NUM_ROWS}) {
+      for (bool skewed : {false, true}) {
+        configs.push_back(
+            MakeArgs({cardinality, skewed, 8}, UNLIMITED_RESERVATION, true));
+      }
+    }
+    RunSuite<RunHashJoin>("Hash join build and probe", &configs);
+  }
+  {
+    vector<unique_ptr<OperatorArgs>> configs;
+    for (int64_t cardinality : {1024L, NUM_ROWS}) {
+      for (bool skewed : {false, true}) {
+        configs.push_back(
+            MakeArgs({cardinality, skewed, 8}, UNLIMITED_RESERVATION, false));
+      }
+    }
+    RunSuite<RunAggregation>("Grouping aggregation", &configs);
+  }
+  return 0;
+}
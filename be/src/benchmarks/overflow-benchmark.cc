@@ -375,6 +375,67 @@ TEST_MUL(TestBuiltinMulOverflow, BuiltinMultiply, false);
 TEST_MUL(TestMulOverflowCheckMSB, MultiplyCheckMSB, false);
 TEST_MUL(TestMulOverflow, Multiply, false);
 
+// Scale of the results of the multiplications and divisions below, as in sums of money.
+const int DECIMAL_OPS_RESULT_SCALE = 6;
+
+// Multiplication that always computes the product in int256_t, as
+// DecimalValue::Multiply() did for products that may not fit into 128 bits.
+Decimal16Value Int256Multiply(const Decimal16Value& val, int this_scale,
+    const Decimal16Value& other, int other_scale, int result_scale, bool* overflow) {
+  int256_t product = ConvertToInt256(val.value()) * ConvertToInt256(other.value());
+  int delta_scale = this_scale + other_scale - result_scale;
+  if (delta_scale > 0) {
+    product = DecimalUtil::ScaleDownAndRound<int256_t>(product, delta_scale, true);
+  }
+  return Decimal16Value(ConvertToInt128(product, MAX_UNSCALED_DECIMAL16, overflow));
+}
+
+// Division that always computes the quotient in int256_t, as DecimalValue::Divide() did
+// for Decimal16Value.
+Decimal16Value Int256Divide(const Decimal16Value& val, int this_scale,
+    const Decimal16Value& other, int other_scale, int result_scale, bool* overflow) {
+  if (other.value() == 0) return Decimal16Value();
+  int scale_by = result_scale + other_scale - this_scale;
+  int256_t x = ConvertToInt256(val.value())
+      * DecimalUtil::GetScaleMultiplier<int256_t>(scale_by);
+  int256_t y = ConvertToInt256(other.value());
+  int128_t r = ConvertToInt128(x / y, MAX_UNSCALED_DECIMAL16, overflow);
+  if (abs(2 * (x % y)) >= abs(y)) r += (Sign(val.value()) ^ Sign(other.value())) + 1;
+  return Decimal16Value(r);
+}
+
+Decimal16Value Int128Multiply(const Decimal16Value& val, int this_scale,
+    const Decimal16Value& other, int other_scale, int result_scale, bool* overflow) {
+  return val.Multiply<int128_t>(this_scale, other, other_scale,
+      ColumnType::MAX_PRECISION, result_scale, true, overflow);
+}
+
+Decimal16Value Int128Divide(const Decimal16Value& val, int this_scale,
+    const Decimal16Value& other, int other_scale, int result_scale, bool* overflow) {
+  bool is_nan = false;
+  return val.Divide<int128_t>(this_scale, other, other_scale, ColumnType::MAX_PRECISION,
+      result_scale, true, &is_nan, overflow);
+}
+
+// Multiplies or divides DECIMAL(38, scale) values to a DECIMAL(38, 6) result.
+#define TEST_DECIMAL_OP(NAME, FN) \
+  void NAME(int batch_size, void* d) { \
+    TestData* data = reinterpret_cast<TestData*>(d); \
+    for (int i = 0; i < batch_size; ++i) { \
+      for (int j = 0; j < data->values.size() - 1; ++j) { \
+        bool overflow = false; \
+        data->results[j] = FN(data->values[j], data->scale, data->values[j + 1], \
+            data->scale, DECIMAL_OPS_RESULT_SCALE, &overflow); \
+        data->overflows[j] = overflow; \
+      } \
+    } \
+  }
+
+TEST_DECIMAL_OP(TestInt256Multiply, Int256Multiply);
+TEST_DECIMAL_OP(TestInt128Multiply, Int128Multiply);
+TEST_DECIMAL_OP(TestInt256Divide, Int256Divide);
+TEST_DECIMAL_OP(TestInt128Divide, Int128Divide);
+
 void TestClzBranchy(int batch_size, void* d) {
   TestData* data = reinterpret_cast<TestData*>(d);
   for (int i = 0; i < batch_size; ++i) {
@@ -455,6 +516,24 @@ int main(int argc, char** argv) {
   mul_overflow_suite.AddBenchmark("mul_overflow", TestMulOverflow, &data);
   cout << mul_overflow_suite.Measure() << endl;
 
+  // DECIMAL(38, 10) values with 14 digits before the decimal point, whose products need
+  // more than 128 bits before they are scaled down to the result.
+  TestData decimal_ops_data;
+  decimal_ops_data.precision = 24;
+  decimal_ops_data.scale = 10;
+  decimal_ops_data.probability_negative = 0.25;
+  AddTestData(&decimal_ops_data, size);
+  decimal_ops_data.results.resize(size - 1);
+  decimal_ops_data.overflows.resize(size - 1);
+
+  Benchmark decimal_ops_suite("Decimal16 Mul and Div");
+  decimal_ops_suite.AddBenchmark("multiply_int256", TestInt256Multiply,
+      &decimal_ops_data);
+  decimal_ops_suite.AddBenchmark("multiply", TestInt128Multiply, &decimal_ops_data);
+  decimal_ops_suite.AddBenchmark("divide_int256", TestInt256Divide, &decimal_ops_data);
+  decimal_ops_suite.AddBenchmark("divide", TestInt128Divide, &decimal_ops_data);
+  cout << decimal_ops_suite.Measure() << endl;
+
   // Counting the number of leading zeros in a 128-bit integer.
   Benchmark clz_suite("Clz of int128_t");
   clz_suite.AddBenchmark("clz_branchy", TestClzBranchy, &data);
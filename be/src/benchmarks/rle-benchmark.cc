@@ -28,7 +28,8 @@
 
 // Benchmark to measure the speed of Parquet RLE decoding for various bit widths and
 // run lengths. Currently compares RleBatchDecoder used by Impala with an older version
-// that used memset.
+// that used memset, and with RleBatchDecoder with the SIMD kernels for unpacking literal
+// runs and filling repeated runs disabled.
 
 // Machine Info: Intel(R) Core(TM) i5-6600 CPU @ 3.30GHz
 // RLE decoding bit_width 1:  Function  iters/ms   10%ile   50%ile   90%ile     10%ile     50%ile     90%ile
@@ -144,6 +145,13 @@ void RleBenchmark(int batch_size, void* data) {
   }
 }
 
+/// Benchmark calling RleBatchDecoder<uint8_t>::GetValues() with the SIMD bit unpacking
+/// and run filling disabled.
+void RleBenchmarkNoSimd(int batch_size, void* data) {
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RleBenchmark(batch_size, data);
+}
+
 /// Benchmark calling the old version of RleBatchDecoder<uint8_t>::GetValues() that used
 /// memset() for setting repeated values.
 void RleBenchmarkMemset(int batch_size, void* data) {
@@ -172,6 +180,9 @@ struct RleBenchmarks {
     suite->AddBenchmark(
         Substitute("memset / max run length: $0", run_length),
         RleBenchmarkMemset, &params);
+    suite->AddBenchmark(
+        Substitute("no SIMD / max run length: $0", run_length),
+        RleBenchmarkNoSimd, &params);
   }
 };
 
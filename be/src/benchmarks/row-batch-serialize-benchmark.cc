@@ -16,10 +16,14 @@
 // under the License.
 
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <time.h>
 #include <boost/scoped_ptr.hpp>
 
 #include "common/init.h"
+#include "gutil/stringprintf.h"
+#include "runtime/collection-value.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
@@ -32,7 +36,10 @@
 #include "util/compress.h"
 #include "util/cpu-info.h"
 #include "util/decompress.h"
+#include "util/pretty-printer.h"
 #include "util/scope-exit-trigger.h"
+#include "util/stopwatch.h"
+#include "util/table-printer.h"
 
 #include "common/names.h"
 
@@ -71,6 +78,17 @@
 //           deser_dups_baseline               114.8                  1X
 //                    deser_dups               208.5              1.817X
 //
+// The outbound benchmarks compare the row-major and the columnar layout (see
+// RowBatch::SerializeColumnar()) of the KRPC OutboundRowBatch, both compressed with
+// LZ4, on the batch without duplicates. The serialized sizes of both layouts are
+// printed after the suites.
+//
+// The codec matrix serializes KRPC OutboundRowBatches of several schemas (narrow ints,
+// wide strings and nested collections) and batch sizes in both layouts, uncompressed
+// and compressed with LZ4 and with ZSTD at several levels, and deserializes them again.
+// It prints a table with the bytes on the wire, the compression ratio and the CPU time
+// per MB of row-major tuple data of every combination. The columnar layout does not
+// support collections, so the nested schema is only serialized row-major.
 // Earlier results with LossyHashTable
 // serialize:            Function     Rate (iters/ms)          Comparison
 // ----------------------------------------------------------------------
@@ -89,10 +107,25 @@
 //
 
 using namespace impala;
+using std::mt19937;
+using std::uniform_int_distribution;
 
 const int NUM_ROWS = 1024;
 const int MAX_STRING_LEN = 10;
 
+// The batch sizes, ZSTD levels and minimum measurement time per combination of the codec
+// matrix.
+const vector<int> MATRIX_BATCH_SIZES = {1024, 8192};
+const vector<int> MATRIX_ZSTD_LEVELS = {1, 3, 9};
+const int64_t MATRIX_MIN_MEASURE_NS = 100L * 1000L * 1000L;
+
+// Words that the strings of the codec matrix are made of, so that they compress like
+// text.
+const vector<string> WORDS = {"the", "quick", "brown", "fox", "jumps", "over", "lazy",
+    "dog", "impala", "query", "fragment", "exchange", "row", "batch", "tuple", "slot",
+    "column", "table", "partition", "block", "scan", "join", "aggregate", "sort",
+    "network", "memory", "disk", "buffer", "codec", "stream", "value", "null"};
+
 namespace impala {
 
 // For computing tuple mem layouts.
@@ -327,6 +360,274 @@ class RowBatchSerializeBenchmark {
     }
   }
 
+  struct OutboundSerializeArgs {
+    RowBatch* batch;
+    bool columnar;
+  };
+
+  static void TestSerializeOutbound(int batch_size, void* data) {
+    OutboundSerializeArgs* args = reinterpret_cast<OutboundSerializeArgs*>(data);
+    OutboundRowBatch outbound_batch;
+    for (int iter = 0; iter < batch_size; ++iter) {
+      ABORT_IF_ERROR(args->batch->Serialize(
+          &outbound_batch, CompressionTypePB::LZ4, args->columnar));
+    }
+  }
+
+  struct OutboundDeserializeArgs {
+    OutboundRowBatch* outbound_batch;
+    RowDescriptor* row_desc;
+    MemTracker* tracker;
+  };
+
+  // Deserializes like RowBatch::FromProtobuf() but with the tuple data allocated from
+  // the batch's MemPool, so that no buffer pool is needed.
+  static void TestDeserializeOutbound(int batch_size, void* data) {
+    OutboundDeserializeArgs* args = reinterpret_cast<OutboundDeserializeArgs*>(data);
+    const RowBatchHeaderPB& header = *args->outbound_batch->header();
+    for (int iter = 0; iter < batch_size; ++iter) {
+      RowBatch batch(args->row_desc, header.num_rows(), args->tracker);
+      batch.num_rows_ = header.num_rows();
+      uint8_t* tuple_data = batch.tuple_data_pool()->Allocate(header.uncompressed_size());
+      if (header.columnar()) {
+        uint8_t* columnar_data =
+            batch.tuple_data_pool()->Allocate(header.columnar_size());
+        RowBatch::DecompressTupleData(args->outbound_batch->TupleDataAsSlice(),
+            header.columnar_size(), header.compression_type(), columnar_data);
+        batch.DeserializeColumnar(
+            args->outbound_batch->TupleOffsetsAsSlice(), columnar_data, tuple_data);
+      } else {
+        batch.Deserialize(args->outbound_batch->TupleOffsetsAsSlice(),
+            args->outbound_batch->TupleDataAsSlice(), header.uncompressed_size(),
+            header.compression_type(), tuple_data);
+      }
+    }
+  }
+
+  // A codec of the matrix. 'level' is only used for ZSTD.
+  struct MatrixCodec {
+    string name;
+    CompressionTypePB::type codec;
+    int level;
+  };
+
+  // A combination of the codec matrix. The serialization benchmark writes the batch to
+  // 'outbound_batch' and its compressed tuple data to 'compressed_data', which the
+  // deserialization benchmark reads.
+  struct MatrixArgs {
+    RowBatch* batch;
+    RowDescriptor* row_desc;
+    MemTracker* tracker;
+    bool columnar;
+    MatrixCodec codec;
+    OutboundRowBatch outbound_batch;
+    string compressed_data;
+    CompressionTypePB::type compression_type;
+
+    // The tuple data as sent over the wire.
+    kudu::Slice WireTupleData() const {
+      if (compression_type == CompressionTypePB::NONE) {
+        return outbound_batch.TupleDataAsSlice();
+      }
+      return kudu::Slice(compressed_data);
+    }
+  };
+
+  // Writes random values into the slots of 'tuple', allocating var-len data from
+  // 'mem_pool'. Strings are made of WORDS and arrays have up to 8 items.
+  static void FillTuple(const TupleDescriptor& desc, int row_idx, mt19937* rng,
+      Tuple* tuple, MemPool* mem_pool) {
+    tuple->Init(desc.byte_size());
+    uniform_int_distribution<int> word_dist(0, WORDS.size() - 1);
+    for (const SlotDescriptor* slot : desc.slots()) {
+      switch (slot->type().type) {
+        case TYPE_INT: {
+          int32_t val = uniform_int_distribution<int32_t>(0, 1000)(*rng);
+          RawValue::Write(&val, tuple, slot, mem_pool);
+          break;
+        }
+        case TYPE_BIGINT: {
+          // Ids that increase with the row, like surrogate keys.
+          int64_t val = 1000000L + row_idx;
+          RawValue::Write(&val, tuple, slot, mem_pool);
+          break;
+        }
+        case TYPE_STRING: {
+          const int target_len = uniform_int_distribution<int>(16, 128)(*rng);
+          string str;
+          while (str.size() < target_len) str += WORDS[word_dist(*rng)] + " ";
+          StringValue val(const_cast<char*>(str.data()), str.size());
+          RawValue::Write(&val, tuple, slot, mem_pool);
+          break;
+        }
+        case TYPE_ARRAY: {
+          const TupleDescriptor* item_desc = slot->collection_item_descriptor();
+          const int num_items = uniform_int_distribution<int>(0, 8)(*rng);
+          CollectionValue* coll = tuple->GetCollectionSlot(slot->tuple_offset());
+          coll->ptr = mem_pool->Allocate(item_desc->byte_size() * num_items);
+          coll->num_tuples = num_items;
+          for (int i = 0; i < num_items; ++i) {
+            Tuple* item =
+                reinterpret_cast<Tuple*>(coll->ptr + i * item_desc->byte_size());
+            FillTuple(*item_desc, row_idx, rng, item, mem_pool);
+          }
+          break;
+        }
+        default:
+          DCHECK(false) << "Unsupported type: " << slot->type();
+      }
+    }
+  }
+
+  // Fills 'batch' with 'num_rows' rows of random tuples.
+  static void FillMatrixBatch(RowBatch* batch, int num_rows) {
+    mt19937 rng(12345);
+    MemPool* mem_pool = batch->tuple_data_pool();
+    const TupleDescriptor& desc = *batch->row_desc()->tuple_descriptors()[0];
+    uint8_t* tuple_mem = mem_pool->Allocate(desc.byte_size() * num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * desc.byte_size());
+      FillTuple(desc, i, &rng, tuple, mem_pool);
+      batch->GetRow(batch->AddRow())->SetTuple(0, tuple);
+      batch->CommitLastRow();
+    }
+  }
+
+  // Serializes the batch of 'args' without compression and compresses its tuple data
+  // with the codec of 'args', like RowBatch::Serialize() does with a fixed ZSTD level.
+  static void SerializeMatrix(MatrixArgs* args) {
+    ABORT_IF_ERROR(args->batch->Serialize(
+        &args->outbound_batch, CompressionTypePB::NONE, args->columnar));
+    args->compression_type = CompressionTypePB::NONE;
+    if (args->codec.codec == CompressionTypePB::NONE) return;
+    const kudu::Slice input = args->outbound_batch.TupleDataAsSlice();
+    unique_ptr<Codec> compressor;
+    if (args->codec.codec == CompressionTypePB::ZSTD) {
+      compressor.reset(new ZstandardCompressor(nullptr, false, args->codec.level));
+    } else {
+      DCHECK_EQ(args->codec.codec, CompressionTypePB::LZ4);
+      compressor.reset(new Lz4Compressor(nullptr, false));
+    }
+    ABORT_IF_ERROR(compressor->Init());
+    int64_t compressed_size = compressor->MaxOutputLen(input.size());
+    args->compressed_data.resize(compressed_size);
+    uint8_t* output = reinterpret_cast<uint8_t*>(&args->compressed_data[0]);
+    ABORT_IF_ERROR(compressor->ProcessBlock(
+        true, input.size(), input.data(), &compressed_size, &output));
+    compressor->Close();
+    if (compressed_size < input.size()) {
+      args->compressed_data.resize(compressed_size);
+      args->compression_type = args->codec.codec;
+    }
+  }
+
+  // Deserializes the output of SerializeMatrix() like TestDeserializeOutbound().
+  static void DeserializeMatrix(MatrixArgs* args) {
+    const RowBatchHeaderPB& header = *args->outbound_batch.header();
+    RowBatch batch(args->row_desc, header.num_rows(), args->tracker);
+    batch.num_rows_ = header.num_rows();
+    uint8_t* tuple_data = batch.tuple_data_pool()->Allocate(header.uncompressed_size());
+    const kudu::Slice tuple_offsets = args->outbound_batch.TupleOffsetsAsSlice();
+    if (header.columnar()) {
+      uint8_t* columnar_data = batch.tuple_data_pool()->Allocate(header.columnar_size());
+      RowBatch::DecompressTupleData(args->WireTupleData(), header.columnar_size(),
+          args->compression_type, columnar_data);
+      batch.DeserializeColumnar(tuple_offsets, columnar_data, tuple_data);
+    } else {
+      batch.Deserialize(tuple_offsets, args->WireTupleData(), header.uncompressed_size(),
+          args->compression_type, tuple_data);
+    }
+  }
+
+  static int64_t ThreadCpuNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000L * 1000L * 1000L + ts.tv_nsec;
+  }
+
+  // Runs 'fn' on 'args' for at least MATRIX_MIN_MEASURE_NS and returns the CPU time per
+  // call in nanoseconds.
+  static double MeasureCpuNanos(void (*fn)(MatrixArgs*), MatrixArgs* args) {
+    MonotonicStopWatch sw;
+    sw.Start();
+    const int64_t start_cpu_ns = ThreadCpuNanos();
+    int64_t iters = 0;
+    do {
+      fn(args);
+      ++iters;
+    } while (sw.ElapsedTime() < MATRIX_MIN_MEASURE_NS);
+    return static_cast<double>(ThreadCpuNanos() - start_cpu_ns) / iters;
+  }
+
+  static void RunCodecMatrix() {
+    struct MatrixSchema {
+      string name;
+      vector<ColumnType> types;
+    };
+    const ColumnType int_type(TYPE_INT);
+    const ColumnType bigint_type(TYPE_BIGINT);
+    const ColumnType string_type(TYPE_STRING);
+    ColumnType string_array_type(TYPE_ARRAY);
+    string_array_type.children.push_back(string_type);
+    const vector<MatrixSchema> schemas = {
+        {"narrow_ints", {int_type, int_type, int_type, bigint_type}},
+        {"wide_strings", {bigint_type, string_type, string_type, string_type}},
+        {"nested", {bigint_type, string_type, string_array_type}}};
+    vector<MatrixCodec> codecs = {{"NONE", CompressionTypePB::NONE, 0},
+        {"LZ4", CompressionTypePB::LZ4, 0}};
+    for (int level : MATRIX_ZSTD_LEVELS) {
+      codecs.push_back(
+          {Substitute("ZSTD-$0", level), CompressionTypePB::ZSTD, level});
+    }
+
+    MemTracker tracker;
+    ObjectPool obj_pool;
+    TablePrinter printer;
+    printer.AddColumn("Schema", true);
+    printer.AddColumn("Rows", false);
+    printer.AddColumn("Layout", true);
+    printer.AddColumn("Codec", true);
+    printer.AddColumn("Tuple Data", false);
+    printer.AddColumn("Wire Bytes", false);
+    printer.AddColumn("Ratio", false);
+    printer.AddColumn("Ser CPU/MB", false);
+    printer.AddColumn("Deser CPU/MB", false);
+    for (const MatrixSchema& schema : schemas) {
+      DescriptorTblBuilder builder(fe.get(), &obj_pool);
+      TupleDescBuilder& tuple_builder = builder.DeclareTuple();
+      for (const ColumnType& type : schema.types) tuple_builder << type;
+      DescriptorTbl* desc_tbl = builder.Build();
+      RowDescriptor* row_desc = obj_pool.Add(new RowDescriptor(
+          *desc_tbl, vector<TTupleId>(1, 0), vector<bool>(1, false)));
+      for (int num_rows : MATRIX_BATCH_SIZES) {
+        RowBatch* batch = obj_pool.Add(new RowBatch(row_desc, num_rows, &tracker));
+        FillMatrixBatch(batch, num_rows);
+        for (bool columnar : {false, true}) {
+          if (columnar && !batch->CanSerializeColumnar()) continue;
+          for (const MatrixCodec& codec : codecs) {
+            MatrixArgs args{batch, row_desc, &tracker, columnar, codec};
+            const double ser_ns = MeasureCpuNanos(SerializeMatrix, &args);
+            const double deser_ns = MeasureCpuNanos(DeserializeMatrix, &args);
+            const RowBatchHeaderPB& header = *args.outbound_batch.header();
+            const int64_t offsets_bytes =
+                args.outbound_batch.TupleOffsetsAsSlice().size();
+            const int64_t data_bytes = header.uncompressed_size() + offsets_bytes;
+            const int64_t wire_bytes = args.WireTupleData().size() + offsets_bytes;
+            const double mb = static_cast<double>(header.uncompressed_size()) / (1 << 20);
+            printer.AddRow({schema.name, Substitute("$0", num_rows),
+                columnar ? "columnar" : "row-major", codec.name,
+                PrettyPrinter::PrintBytes(data_bytes),
+                PrettyPrinter::PrintBytes(wire_bytes),
+                StringPrintf("%.2f", static_cast<double>(data_bytes) / wire_bytes),
+                PrettyPrinter::Print(ser_ns / mb, TUnit::TIME_NS),
+                PrettyPrinter::Print(deser_ns / mb, TUnit::TIME_NS)});
+          }
+        }
+      }
+    }
+    cout << "codec matrix:" << endl << printer.ToString() << endl;
+  }
+
   static void Run() {
     MemTracker tracker;
     MemPool mem_pool(&tracker);
@@ -404,6 +705,38 @@ class RowBatchSerializeBenchmark {
     deser_suite.AddBenchmark("deser_dups", TestDeserialize, &dup_deser_args, baseline);
 
     cout << deser_suite.Measure() << endl;
+
+    OutboundRowBatch row_major_batch;
+    ABORT_IF_ERROR(no_dup_batch->Serialize(&row_major_batch, CompressionTypePB::LZ4));
+    OutboundRowBatch columnar_batch;
+    ABORT_IF_ERROR(no_dup_batch->Serialize(
+        &columnar_batch, CompressionTypePB::LZ4, /* columnar */ true));
+
+    Benchmark outbound_ser_suite("serialize outbound");
+    OutboundSerializeArgs row_major_ser_args = { no_dup_batch, false };
+    OutboundSerializeArgs columnar_ser_args = { no_dup_batch, true };
+    baseline = outbound_ser_suite.AddBenchmark("ser_outbound_row_major",
+        TestSerializeOutbound, &row_major_ser_args, -1);
+    outbound_ser_suite.AddBenchmark("ser_outbound_columnar",
+        TestSerializeOutbound, &columnar_ser_args, baseline);
+    cout << outbound_ser_suite.Measure() << endl;
+
+    Benchmark outbound_deser_suite("deserialize outbound");
+    OutboundDeserializeArgs row_major_deser_args = { &row_major_batch, &row_desc,
+        &tracker };
+    OutboundDeserializeArgs columnar_deser_args = { &columnar_batch, &row_desc,
+        &tracker };
+    baseline = outbound_deser_suite.AddBenchmark("deser_outbound_row_major",
+        TestDeserializeOutbound, &row_major_deser_args, -1);
+    outbound_deser_suite.AddBenchmark("deser_outbound_columnar",
+        TestDeserializeOutbound, &columnar_deser_args, baseline);
+    cout << outbound_deser_suite.Measure() << endl;
+
+    cout << "row-major serialized size: " << RowBatch::GetSerializedSize(row_major_batch)
+         << " bytes, columnar serialized size: "
+         << RowBatch::GetSerializedSize(columnar_batch) << " bytes" << endl;
+
+    RunCodecMatrix();
   }
 };
 
@@ -30,8 +30,15 @@
 //                                                                          (relative) (relative) (relative)
 // ---------------------------------------------------------------------------------------------------------
 //                            ToThrift               83.4     84.6     84.9         1X         1X         1X
+//
+// The counter update benchmarks measure the throughput of Add() calls when all threads
+// update the same counter. A regular counter does not scale beyond one thread because
+// every update moves its cache line between the cores, a striped counter does.
 
 #include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include "common/object-pool.h"
 #include "util/benchmark.h"
@@ -85,6 +92,56 @@ void ToThriftBenchmark(int batch_size, void* dummy) {
   }
 }
 
+void CompressBenchmark(int batch_size, void* dummy) {
+  for (int i = 0; i < batch_size; ++i) {
+    TRuntimeProfileTree tprofile;
+    benchmark_profile->ToThrift(&tprofile);
+    vector<uint8_t> compressed;
+    Status status = RuntimeProfile::CompressThrift(tprofile, &compressed);
+    DCHECK(status.ok());
+  }
+}
+
+void CompressCompactBenchmark(int batch_size, void* dummy) {
+  for (int i = 0; i < batch_size; ++i) {
+    TRuntimeProfileTree tprofile;
+    benchmark_profile->ToThrift(&tprofile);
+    vector<uint8_t> compressed;
+    Status status = RuntimeProfile::CompressCompact(&tprofile, &compressed);
+    DCHECK(status.ok());
+  }
+}
+
+// 'data' points to the output of Compress() or CompressCompact().
+void DecompressBenchmark(int batch_size, void* data) {
+  const vector<uint8_t>* compressed = static_cast<const vector<uint8_t>*>(data);
+  for (int i = 0; i < batch_size; ++i) {
+    TRuntimeProfileTree tprofile;
+    Status status = RuntimeProfile::DecompressToThrift(*compressed, &tprofile);
+    DCHECK(status.ok());
+  }
+}
+
+// Number of Add() calls per thread in one iteration of the counter update benchmarks.
+static const int ADDS_PER_THREAD = 10000;
+
+struct CounterUpdateData {
+  RuntimeProfile::Counter* counter;
+  int num_threads;
+};
+
+// Every thread adds to the same counter, as the scanner threads of a scan node do.
+void CounterUpdateBenchmark(int batch_size, void* data) {
+  CounterUpdateData* d = static_cast<CounterUpdateData*>(data);
+  vector<std::thread> threads;
+  for (int i = 0; i < d->num_threads; ++i) {
+    threads.emplace_back([d, batch_size]() {
+      for (int j = 0; j < batch_size * ADDS_PER_THREAD; ++j) d->counter->Add(1);
+    });
+  }
+  for (std::thread& t : threads) t.join();
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << endl << Benchmark::GetMachineInfo() << endl;
@@ -94,6 +151,42 @@ int main(int argc, char **argv) {
   Benchmark suite("RuntimeProfile conversion");
   suite.AddBenchmark("ToThrift", ToThriftBenchmark, nullptr);
   cout << suite.Measure() << endl;
+
+  TRuntimeProfileTree tprofile;
+  benchmark_profile->ToThrift(&tprofile);
+  vector<uint8_t> thrift_compressed;
+  vector<uint8_t> compact_compressed;
+  Status status = RuntimeProfile::CompressThrift(tprofile, &thrift_compressed);
+  DCHECK(status.ok());
+  status = RuntimeProfile::CompressCompact(&tprofile, &compact_compressed);
+  DCHECK(status.ok());
+  cout << "Compressed size: Thrift " << thrift_compressed.size() << " bytes, compact "
+       << compact_compressed.size() << " bytes" << endl;
+
+  Benchmark compress_suite("RuntimeProfile compression");
+  compress_suite.AddBenchmark("Thrift", CompressBenchmark, nullptr);
+  compress_suite.AddBenchmark("Compact", CompressCompactBenchmark, nullptr);
+  cout << compress_suite.Measure() << endl;
+
+  Benchmark decompress_suite("RuntimeProfile decompression");
+  decompress_suite.AddBenchmark("Thrift", DecompressBenchmark, &thrift_compressed);
+  decompress_suite.AddBenchmark("Compact", DecompressBenchmark, &compact_compressed);
+  cout << decompress_suite.Measure() << endl;
+
+  RuntimeProfile* counter_profile = RuntimeProfile::Create(&profile_pool, "counters");
+  Benchmark counter_suite("RuntimeProfile counter updates", /* micro = */ false);
+  vector<unique_ptr<CounterUpdateData>> counter_data;
+  for (int num_threads : {1, 4, 16}) {
+    counter_data.emplace_back(new CounterUpdateData{counter_profile->AddCounter(
+        Substitute("counter$0", num_threads), TUnit::UNIT), num_threads});
+    counter_suite.AddBenchmark(Substitute("Counter $0 threads", num_threads),
+        CounterUpdateBenchmark, counter_data.back().get());
+    counter_data.emplace_back(new CounterUpdateData{counter_profile->AddStripedCounter(
+        Substitute("striped$0", num_threads), TUnit::UNIT), num_threads});
+    counter_suite.AddBenchmark(Substitute("StripedCounter $0 threads", num_threads),
+        CounterUpdateBenchmark, counter_data.back().get());
+  }
+  cout << counter_suite.Measure() << endl;
   return 0;
 }
 
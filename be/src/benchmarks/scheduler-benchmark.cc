@@ -15,15 +15,21 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <cmath>
 #include <iostream>
+#include <random>
 #include <string>
 #include <vector>
 
+#include "gutil/stringprintf.h"
 #include "gutil/strings/substitute.h"
 #include "scheduling/scheduler-test-util.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
+#include "util/pretty-printer.h"
+#include "util/stopwatch.h"
+#include "util/table-printer.h"
 #include "util/thread.h"
 
 #include "codegen/llvm-codegen.h"
@@ -31,8 +37,13 @@
 #include "common/names.h"
 #include "service/fe-support.h"
 
+DECLARE_int32(num_scan_range_assignment_threads);
+
 using namespace impala;
 using namespace impala::test;
+using std::discrete_distribution;
+using std::mt19937;
+using std::uniform_real_distribution;
 
 
 // This benchmark exercises the core scheduling method 'ComputeScanRangeAssignment()' of
@@ -82,11 +93,44 @@ using namespace impala::test;
 //                          100 Blocks               8.46     8.46     8.49     0.114X     0.113X     0.112X
 //                         1000 Blocks              0.981        1        1    0.0132X    0.0133X    0.0131X
 //                        10000 Blocks                0.1    0.102    0.103   0.00134X   0.00136X   0.00136X
+//
+// The cluster scale, replica preference, executor group and bounded load suites model
+// the production clusters that scheduling is slowest for: hundreds of executors and
+// hundreds of thousands of blocks, whose lengths follow the file size histogram
+// FILE_SIZE_HISTOGRAM. Besides the scheduling throughput, these suites print the
+// latency of a single schedule and the balance of the assignment, i.e. the maximum
+// over the average bytes assigned to an executor, and the fraction of remote bytes.
 
 static const vector<int> CLUSTER_SIZES = {3, 10, 50, 100, 500, 1000, 3000, 10000};
 static const int DEFAULT_CLUSTER_SIZE = 100;
 static const vector<int> NUM_BLOCKS_PER_TABLE = {1, 10, 100, 1000, 10000};
 static const int DEFAULT_NUM_BLOCKS_PER_TABLE = 100;
+static const vector<int> LARGE_TABLE_NUM_BLOCKS = {100000, 1000000, 2000000};
+static const vector<int> NUM_ASSIGNMENT_THREADS = {1, 2, 4, 8};
+
+static const vector<int> SCALE_NUM_EXECUTORS = {200, 500};
+static const vector<int> SCALE_NUM_BLOCKS = {100000, 300000};
+static const int SCALE_NUM_DATANODES = 500;
+static const vector<int> EXECUTOR_GROUP_SIZES = {50, 100, 250};
+static const vector<int> NUM_REMOTE_EXECUTOR_CANDIDATES = {0, 3};
+static const vector<double> REMOTE_EXECUTOR_MAX_LOAD_RATIOS = {0, 1.1, 1.25, 1.5};
+static const int64_t HDFS_BLOCK_SIZE = 128L * 1024L * 1024L;
+
+/// A bucket of a file size histogram: 'fraction' of the files have sizes between
+/// 'min_bytes' and 'max_bytes', which are distributed log-uniformly within the bucket.
+struct FileSizeBucket {
+  int64_t min_bytes;
+  int64_t max_bytes;
+  double fraction;
+};
+
+/// The file sizes of a typical fact table, with many small files from streaming ingest
+/// and fewer large files from compactions.
+static const vector<FileSizeBucket> FILE_SIZE_HISTOGRAM = {
+    {1L << 20, 16L << 20, 0.4},
+    {16L << 20, 128L << 20, 0.3},
+    {128L << 20, 256L << 20, 0.2},
+    {256L << 20, 1L << 30, 0.1}};
 
 /// Members of this struct are needed to build the test fixtures and depend on each other.
 /// Since their constructors take const references they must be constructed in order,
@@ -118,6 +162,58 @@ void InitializeTestCtx(int num_hosts, int num_blocks,
   test_ctx->scheduler_wrapper.reset(new SchedulerWrapper(*test_ctx->plan));
 }
 
+/// Returns the lengths of 'num_blocks' blocks of files whose sizes follow
+/// FILE_SIZE_HISTOGRAM. Files are split into blocks of at most HDFS_BLOCK_SIZE bytes.
+/// The lengths are the same for every call.
+vector<int64_t> GenerateBlockLengths(int num_blocks) {
+  mt19937 rng(0);
+  vector<double> fractions;
+  for (const FileSizeBucket& bucket : FILE_SIZE_HISTOGRAM) {
+    fractions.push_back(bucket.fraction);
+  }
+  discrete_distribution<int> bucket_dist(fractions.begin(), fractions.end());
+  vector<int64_t> block_lengths;
+  while (block_lengths.size() < num_blocks) {
+    const FileSizeBucket& bucket = FILE_SIZE_HISTOGRAM[bucket_dist(rng)];
+    uniform_real_distribution<double> log_size_dist(
+        log(bucket.min_bytes), log(bucket.max_bytes));
+    int64_t file_size = exp(log_size_dist(rng));
+    for (; file_size > 0 && block_lengths.size() < num_blocks;
+         file_size -= HDFS_BLOCK_SIZE) {
+      block_lengths.push_back(min(file_size, HDFS_BLOCK_SIZE));
+    }
+  }
+  return block_lengths;
+}
+
+/// Initialize a test context with 'num_executors' hosts that run an executor and a
+/// datanode and 'num_datanodes' - 'num_executors' hosts that only run a datanode. The
+/// executors form the executor group that the plan is scheduled on. The scanned table
+/// has blocks with the lengths of GenerateBlockLengths() and three replicas on random
+/// datanodes.
+void InitializeScaleTestCtx(int num_executors, int num_datanodes, int num_blocks,
+    TReplicaPreference::type replica_preference, int num_remote_executor_candidates,
+    TestCtx* test_ctx) {
+  DCHECK_LE(num_executors, num_datanodes);
+  test_ctx->cluster.reset(new Cluster());
+  test_ctx->cluster->AddHosts(num_executors, true, true);
+  test_ctx->cluster->AddHosts(num_datanodes - num_executors, false, true);
+
+  test_ctx->schema.reset(new Schema(*test_ctx->cluster));
+  test_ctx->schema->AddMultiBlockTable("T0", GenerateBlockLengths(num_blocks),
+      ReplicaPlacement::RANDOM, 3, BlockNamingPolicy::PARTITIONED_UNIQUE_FILENAMES);
+
+  test_ctx->plan.reset(new Plan(*test_ctx->schema));
+  test_ctx->plan->SetReplicaPreference(replica_preference);
+  test_ctx->plan->SetRandomReplica(false);
+  test_ctx->plan->SetNumRemoteExecutorCandidates(num_remote_executor_candidates);
+  test_ctx->plan->AddTableScan("T0");
+
+  test_ctx->result.reset(new Result(*test_ctx->plan));
+
+  test_ctx->scheduler_wrapper.reset(new SchedulerWrapper(*test_ctx->plan));
+}
+
 /// This function is passed to the test framework and executes the scheduling method
 /// repeatedly.
 void BenchmarkFunction(int num_iterations, void* data) {
@@ -162,6 +258,159 @@ void RunNumBlocksBenchmark(TReplicaPreference::type replica_preference) {
   cout << suite.Measure() << endl;
 }
 
+/// Build and run a benchmark suite for tables with millions of blocks, assigned with
+/// different values of --num_scan_range_assignment_threads.
+void RunLargeTableBenchmark(TReplicaPreference::type replica_preference) {
+  for (int num_blocks : LARGE_TABLE_NUM_BLOCKS) {
+    string suite_name = strings::Substitute("$0 Blocks, $1", num_blocks,
+        PrintThriftEnum(replica_preference));
+    Benchmark suite(suite_name, false /* micro_heuristics */);
+    vector<TestCtx> test_ctx(NUM_ASSIGNMENT_THREADS.size());
+    for (int i = 0; i < NUM_ASSIGNMENT_THREADS.size(); ++i) {
+      // The scheduler reads the flag when it is constructed.
+      FLAGS_num_scan_range_assignment_threads = NUM_ASSIGNMENT_THREADS[i];
+      InitializeTestCtx(DEFAULT_CLUSTER_SIZE, num_blocks, replica_preference,
+          &test_ctx[i]);
+      string benchmark_name =
+          strings::Substitute("$0 Threads", NUM_ASSIGNMENT_THREADS[i]);
+      suite.AddBenchmark(benchmark_name, BenchmarkFunction, &test_ctx[i]);
+    }
+    FLAGS_num_scan_range_assignment_threads = 0;
+    cout << suite.Measure() << endl;
+  }
+}
+
+/// Schedules each of 'test_ctx' once more and prints the latency of the schedule and the
+/// balance of its assignment, labeled with 'names'. 'num_executors' are the numbers of
+/// executors that each of 'test_ctx' is scheduled on.
+void PrintAssignmentBalance(const string& suite_name, const vector<string>& names,
+    const vector<int>& num_executors, vector<TestCtx>* test_ctx) {
+  TablePrinter printer;
+  printer.AddColumn(suite_name, true);
+  printer.AddColumn("Schedule Latency", false);
+  printer.AddColumn("Max Bytes/Executor", false);
+  printer.AddColumn("Avg Bytes/Executor", false);
+  printer.AddColumn("Max/Avg", false);
+  printer.AddColumn("Remote Bytes", false);
+  for (int i = 0; i < test_ctx->size(); ++i) {
+    TestCtx* ctx = &(*test_ctx)[i];
+    ctx->result->Reset();
+    MonotonicStopWatch sw;
+    sw.Start();
+    Status status = ctx->scheduler_wrapper->Compute(ctx->result.get());
+    if (!status.ok()) LOG(FATAL) << status.GetDetail();
+    sw.Stop();
+    const int64_t total_bytes = ctx->result->NumTotalAssignedBytes();
+    const int64_t max_bytes = ctx->result->MaxNumAssignedBytesPerHost();
+    const double avg_bytes = static_cast<double>(total_bytes) / num_executors[i];
+    printer.AddRow({names[i], PrettyPrinter::Print(sw.ElapsedTime(), TUnit::TIME_NS),
+        PrettyPrinter::PrintBytes(max_bytes), PrettyPrinter::PrintBytes(avg_bytes),
+        StringPrintf("%.2f", max_bytes / avg_bytes),
+        StringPrintf("%.1f%%",
+            100.0 * ctx->result->NumRemoteAssignedBytes() / total_bytes)});
+  }
+  cout << printer.ToString() << endl;
+}
+
+/// Build and run a benchmark suite for clusters with hundreds of executors and tables
+/// with hundreds of thousands of blocks. All hosts run an executor.
+void RunClusterScaleBenchmark(TReplicaPreference::type replica_preference) {
+  string suite_name = strings::Substitute(
+      "Cluster Scale, $0", PrintThriftEnum(replica_preference));
+  Benchmark suite(suite_name, false /* micro_heuristics */);
+  vector<TestCtx> test_ctx(SCALE_NUM_EXECUTORS.size() * SCALE_NUM_BLOCKS.size());
+  vector<string> names;
+  vector<int> num_executors;
+  for (int num_hosts : SCALE_NUM_EXECUTORS) {
+    for (int num_blocks : SCALE_NUM_BLOCKS) {
+      TestCtx* ctx = &test_ctx[names.size()];
+      InitializeScaleTestCtx(
+          num_hosts, num_hosts, num_blocks, replica_preference, 0, ctx);
+      names.push_back(strings::Substitute("$0 Executors, $1 Blocks", num_hosts,
+          num_blocks));
+      num_executors.push_back(num_hosts);
+      suite.AddBenchmark(names.back(), BenchmarkFunction, ctx);
+    }
+  }
+  cout << suite.Measure(50, 1) << endl;
+  PrintAssignmentBalance(suite_name, names, num_executors, &test_ctx);
+}
+
+/// Build and run a benchmark suite for the replica preferences on the largest cluster
+/// and table of the cluster scale suite.
+void RunReplicaPreferenceBenchmark() {
+  const vector<TReplicaPreference::type> preferences = {TReplicaPreference::CACHE_LOCAL,
+      TReplicaPreference::DISK_LOCAL, TReplicaPreference::REMOTE};
+  const int num_hosts = SCALE_NUM_EXECUTORS.back();
+  const string suite_name = "Replica Preference";
+  Benchmark suite(suite_name, false /* micro_heuristics */);
+  vector<TestCtx> test_ctx(preferences.size());
+  vector<string> names;
+  vector<int> num_executors;
+  for (int i = 0; i < preferences.size(); ++i) {
+    InitializeScaleTestCtx(num_hosts, num_hosts, SCALE_NUM_BLOCKS.back(), preferences[i],
+        0, &test_ctx[i]);
+    names.push_back(PrintThriftEnum(preferences[i]));
+    num_executors.push_back(num_hosts);
+    suite.AddBenchmark(names.back(), BenchmarkFunction, &test_ctx[i]);
+  }
+  cout << suite.Measure(50, 1) << endl;
+  PrintAssignmentBalance(suite_name, names, num_executors, &test_ctx);
+}
+
+/// Build and run a benchmark suite for clusters whose executors are split into executor
+/// groups. The data is spread over the datanodes of all groups, but a query is only
+/// scheduled on one group, so most of its blocks are read remotely. The executors of
+/// remote reads are picked from the hash ring of the scheduler if the number of remote
+/// executor candidates is greater than 0, and by the assigned bytes otherwise.
+void RunExecutorGroupBenchmark() {
+  const string suite_name = strings::Substitute("Executor Groups, $0 Datanodes",
+      SCALE_NUM_DATANODES);
+  Benchmark suite(suite_name, false /* micro_heuristics */);
+  vector<TestCtx> test_ctx(
+      EXECUTOR_GROUP_SIZES.size() * NUM_REMOTE_EXECUTOR_CANDIDATES.size());
+  vector<string> names;
+  vector<int> num_executors;
+  for (int group_size : EXECUTOR_GROUP_SIZES) {
+    for (int num_candidates : NUM_REMOTE_EXECUTOR_CANDIDATES) {
+      TestCtx* ctx = &test_ctx[names.size()];
+      InitializeScaleTestCtx(group_size, SCALE_NUM_DATANODES, SCALE_NUM_BLOCKS.front(),
+          TReplicaPreference::DISK_LOCAL, num_candidates, ctx);
+      names.push_back(strings::Substitute("$0 Groups of $1, $2 Candidates",
+          SCALE_NUM_DATANODES / group_size, group_size, num_candidates));
+      num_executors.push_back(group_size);
+      suite.AddBenchmark(names.back(), BenchmarkFunction, ctx);
+    }
+  }
+  cout << suite.Measure(50, 1) << endl;
+  PrintAssignmentBalance(suite_name, names, num_executors, &test_ctx);
+}
+
+/// Build and run a benchmark suite for remote scheduling on the hash ring with a bound
+/// on the bytes per executor relative to the average. A max load ratio of 0 disables
+/// the bound.
+void RunBoundedLoadBenchmark() {
+  const int group_size = 100;
+  const int num_candidates = 3;
+  const string suite_name = strings::Substitute("Bounded Load, $0 Executors of $1 "
+      "Datanodes", group_size, SCALE_NUM_DATANODES);
+  Benchmark suite(suite_name, false /* micro_heuristics */);
+  vector<TestCtx> test_ctx(REMOTE_EXECUTOR_MAX_LOAD_RATIOS.size());
+  vector<string> names;
+  vector<int> num_executors;
+  for (double ratio : REMOTE_EXECUTOR_MAX_LOAD_RATIOS) {
+    TestCtx* ctx = &test_ctx[names.size()];
+    InitializeScaleTestCtx(group_size, SCALE_NUM_DATANODES, SCALE_NUM_BLOCKS.front(),
+        TReplicaPreference::DISK_LOCAL, num_candidates, ctx);
+    ctx->plan->SetRemoteExecutorMaxLoadRatio(ratio);
+    names.push_back(strings::Substitute("Max Load Ratio $0", ratio));
+    num_executors.push_back(group_size);
+    suite.AddBenchmark(names.back(), BenchmarkFunction, ctx);
+  }
+  cout << suite.Measure(50, 1) << endl;
+  PrintAssignmentBalance(suite_name, names, num_executors, &test_ctx);
+}
+
 int main(int argc, char** argv) {
   impala::InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
   impala::InitFeSupport();
@@ -171,4 +420,11 @@ int main(int argc, char** argv) {
   RunClusterSizeBenchmark(TReplicaPreference::DISK_LOCAL);
   RunClusterSizeBenchmark(TReplicaPreference::REMOTE);
   RunNumBlocksBenchmark(TReplicaPreference::DISK_LOCAL);
+  RunLargeTableBenchmark(TReplicaPreference::DISK_LOCAL);
+  RunLargeTableBenchmark(TReplicaPreference::REMOTE);
+  RunClusterScaleBenchmark(TReplicaPreference::DISK_LOCAL);
+  RunClusterScaleBenchmark(TReplicaPreference::REMOTE);
+  RunReplicaPreferenceBenchmark();
+  RunExecutorGroupBenchmark();
+  RunBoundedLoadBenchmark();
 }
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+// Test the performance of sorting strings with and without normalized key prefixes.
+// This compares:
+// * FullCompare - sorts by comparing the StringValues.
+// * KeyPrefix - sorts by the 8 byte prefixes from
+//   TupleRowLexicalComparator::EncodeKeyPrefix() and only compares the StringValues
+//   if the prefixes are equal. This includes the time to compute the prefixes.
+// The strings share a common start of 'shared_len' bytes, so that the prefixes resolve
+// fewer comparisons as it grows.
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "gutil/strings/substitute.h"
+#include "runtime/string-value.inline.h"
+#include "runtime/types.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+#include "util/tuple-row-compare.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+/// Number of strings that each iteration sorts.
+constexpr int NUM_STRINGS = 64 * 1024;
+
+struct BenchmarkParams {
+  const vector<StringValue>* input;
+  vector<StringValue> values;
+  vector<pair<uint64_t, const StringValue*>> prefixed;
+};
+
+void FullCompareBenchmark(int batch_size, void* data) {
+  BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  for (int i = 0; i < batch_size; ++i) {
+    p->values = *p->input;
+    std::sort(p->values.begin(), p->values.end(),
+        [](const StringValue& lhs, const StringValue& rhs) {
+          return lhs.Compare(rhs) < 0;
+        });
+  }
+}
+
+void KeyPrefixBenchmark(int batch_size, void* data) {
+  BenchmarkParams* p = reinterpret_cast<BenchmarkParams*>(data);
+  const ColumnType type(TYPE_STRING);
+  for (int i = 0; i < batch_size; ++i) {
+    p->prefixed.clear();
+    for (const StringValue& value : *p->input) {
+      p->prefixed.emplace_back(
+          TupleRowLexicalComparator::EncodeKeyPrefix(&value, type, true, true), &value);
+    }
+    std::sort(p->prefixed.begin(), p->prefixed.end(),
+        [](const pair<uint64_t, const StringValue*>& lhs,
+            const pair<uint64_t, const StringValue*>& rhs) {
+          if (lhs.first != rhs.first) return lhs.first < rhs.first;
+          return lhs.second->Compare(*rhs.second) < 0;
+        });
+  }
+}
+
+int main(int argc, char** argv) {
+  CpuInfo::Init();
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> char_dist('a', 'z');
+  for (int shared_len : {0, 4, 8, 16}) {
+    const string shared(shared_len, 'x');
+    vector<string> strings;
+    for (int i = 0; i < NUM_STRINGS; ++i) {
+      string str = shared;
+      for (int j = 0; j < 16; ++j) str.push_back(char_dist(rng));
+      strings.push_back(move(str));
+    }
+    vector<StringValue> input;
+    for (const string& str : strings) input.emplace_back(str);
+
+    BenchmarkParams full_params{&input, {}, {}};
+    BenchmarkParams prefix_params{&input, {}, {}};
+    Benchmark suite(Substitute("Sort with shared length $0", shared_len));
+    suite.AddBenchmark("FullCompare", FullCompareBenchmark, &full_params);
+    suite.AddBenchmark("KeyPrefix", KeyPrefixBenchmark, &prefix_params);
+    cout << suite.Measure() << endl;
+  }
+  return 0;
+}
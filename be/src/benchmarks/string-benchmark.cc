@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <iostream>
 #include "runtime/string-value.h"
+#include "util/ascii-util.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/hash-util.h"
@@ -177,6 +178,88 @@ void InitTestData(TestData* data, int num_small_strings, int num_large_strings)
   random_shuffle(data->random_order.begin(), data->random_order.end());
 }
 
+// Strings for the kernels of upper(), lower(), length() in UTF-8 mode and rtrim():
+// ASCII values of 8 to 64 characters, padded with spaces to 64 bytes like CHAR(64).
+struct StringFunctionsData {
+  vector<string> strings;
+  vector<uint8_t> buffer;
+  int64_t result;
+};
+
+void InitStringFunctionsData(StringFunctionsData* data, int num_strings) {
+  for (int i = 0; i < num_strings; ++i) {
+    string str;
+    const int len = 8 + rand() % 57;
+    for (int j = 0; j < len; ++j) str += 'A' + rand() % 58;
+    str.resize(64, ' ');
+    data->strings.push_back(str);
+  }
+  data->buffer.resize(64);
+}
+
+void TestToUpperScalar(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    for (const string& str : data->strings) {
+      for (int j = 0; j < str.size(); ++j) data->buffer[j] = ::toupper(str[j]);
+    }
+  }
+}
+
+void TestToUpperAscii(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    for (const string& str : data->strings) {
+      AsciiUtil::ToUpper(reinterpret_cast<const uint8_t*>(str.data()), str.size(),
+          data->buffer.data());
+    }
+  }
+}
+
+void TestUtf8LengthScalar(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    data->result = 0;
+    for (const string& str : data->strings) {
+      for (char c : str) data->result += BitUtil::IsUtf8StartByte(c);
+    }
+  }
+}
+
+void TestUtf8LengthAscii(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    data->result = 0;
+    for (const string& str : data->strings) {
+      data->result += AsciiUtil::CountUtf8Chars(
+          reinterpret_cast<const uint8_t*>(str.data()), str.size());
+    }
+  }
+}
+
+void TestRtrimScalar(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    data->result = 0;
+    for (const string& str : data->strings) {
+      int end = str.size() - 1;
+      while (end >= 0 && str[end] == ' ') --end;
+      data->result += end + 1;
+    }
+  }
+}
+
+void TestRtrimAscii(int batch_size, void* d) {
+  StringFunctionsData* data = reinterpret_cast<StringFunctionsData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    data->result = 0;
+    for (const string& str : data->strings) {
+      data->result += str.size() - AsciiUtil::CountTrailing(
+          reinterpret_cast<const uint8_t*>(str.data()), str.size(), ' ');
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << Benchmark::GetMachineInfo() << endl;
@@ -196,5 +279,18 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  StringFunctionsData functions_data;
+  InitStringFunctionsData(&functions_data, 1000);
+  Benchmark functions_suite("String Functions");
+  functions_suite.AddBenchmark("Upper Scalar", TestToUpperScalar, &functions_data);
+  functions_suite.AddBenchmark("Upper Ascii", TestToUpperAscii, &functions_data);
+  functions_suite.AddBenchmark("Utf8 Length Scalar", TestUtf8LengthScalar,
+      &functions_data);
+  functions_suite.AddBenchmark("Utf8 Length Ascii", TestUtf8LengthAscii,
+      &functions_data);
+  functions_suite.AddBenchmark("Rtrim Scalar", TestRtrimScalar, &functions_data);
+  functions_suite.AddBenchmark("Rtrim Ascii", TestRtrimAscii, &functions_data);
+  cout << functions_suite.Measure();
+
   return 0;
 }
@@ -18,7 +18,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <iostream>
-#include "runtime/string-value.h"
+#include "runtime/string-value.inline.h"
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/sse-util.h"
@@ -108,6 +108,27 @@ void TestStringCompare(int batch_size, void* d) {
   }
 }
 
+// Equality as StringValue::Eq() computed it before it compared short strings without
+// memcmp().
+bool MemcmpEq(const char* s1, int n1, const char* s2, int n2) {
+  if (n1 != n2) return false;
+  return SimpleCompare<void, memcmp>(s1, n1, s2, n2, n1) == 0;
+}
+
+bool StringValueEq(const char* s1, int n1, const char* s2, int n2) {
+  const StringValue sv1(const_cast<char*>(s1), n1);
+  return sv1.Eq(StringValue(const_cast<char*>(s2), n2));
+}
+
+template<bool (*STRING_EQ)(const char* s1, int n1, const char* s2, int n2)>
+void TestStringEq(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  data->result = 0;
+  for (int i = 0; i < batch_size; ++i) {
+    data->result += STRING_EQ(data->s1, data->n1, data->s2, data->n2);
+  }
+}
+
 TestData InitTestData(int len) {
   TestData data;
   data.s1 = new char[len];
@@ -126,13 +147,18 @@ void BenchmarkAll(int len) {
   suite.AddBenchmark("strncmp", TestStringCompare<SimpleCompare<char, strncmp>>, &data);
   suite.AddBenchmark("memcmp", TestStringCompare<SimpleCompare<void, memcmp>>, &data);
   cout << suite.Measure() << endl;
+
+  Benchmark eq_suite(Substitute("Equality length $0", len));
+  eq_suite.AddBenchmark("memcmp", TestStringEq<MemcmpEq>, &data);
+  eq_suite.AddBenchmark("StringValue::Eq", TestStringEq<StringValueEq>, &data);
+  cout << eq_suite.Measure() << endl;
 }
 
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << Benchmark::GetMachineInfo() << endl << endl;
 
-  for (int len : {1, 10, 100, 10000}) {
+  for (int len : {1, 4, 10, 12, 100, 10000}) {
     BenchmarkAll(len);
   }
 
@@ -18,8 +18,11 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <iostream>
+#include <re2/re2.h>
 #include "util/benchmark.h"
+#include "gutil/strings/substitute.h"
 #include "util/cpu-info.h"
+#include "runtime/multi-string-search.h"
 #include "runtime/string-search.h"
 #include "experiments/string-search-sse.h"
 
@@ -37,6 +40,9 @@ using namespace impala;
 //                           LibC               262.2              3.201X
 //            Null Terminated SSE               212.4              2.592X
 //        Non-null Terminated SSE               139.6              1.704X
+//
+// The second suite searches for any of a set of needles, as in a disjunction of LIKE
+// predicates with '%<literal>%' patterns on the same column.
 
 struct TestData {
   vector<StringValue> needles;
@@ -161,6 +167,91 @@ void InitTestData(TestData* data) {
   }
 }
 
+struct MultiTestData {
+  vector<string> needles;
+  vector<string> haystacks;
+  vector<StringValue> haystack_values;
+  int matches;
+};
+
+// Searches for each needle with a StringSearch until one is found, which is how the
+// disjuncts of an OR of LIKE predicates are evaluated.
+void TestMultiStringSearchEach(int batch_size, void* d) {
+  MultiTestData* data = reinterpret_cast<MultiTestData*>(d);
+  vector<StringValue> needle_values;
+  for (const string& needle : data->needles) needle_values.emplace_back(needle);
+  vector<StringSearch> searches;
+  for (StringValue& needle : needle_values) searches.emplace_back(&needle);
+  for (int i = 0; i < batch_size; ++i) {
+    data->matches = 0;
+    for (StringValue& haystack : data->haystack_values) {
+      for (const StringSearch& search : searches) {
+        if (search.Search(&haystack) != -1) {
+          ++data->matches;
+          break;
+        }
+      }
+    }
+  }
+}
+
+// Searches for all needles with a single regex that is the alternation of them.
+void TestMultiRe2Alternation(int batch_size, void* d) {
+  MultiTestData* data = reinterpret_cast<MultiTestData*>(d);
+  string pattern;
+  for (const string& needle : data->needles) {
+    if (!pattern.empty()) pattern.append("|");
+    pattern.append(RE2::QuoteMeta(needle));
+  }
+  RE2 re(pattern);
+  for (int i = 0; i < batch_size; ++i) {
+    data->matches = 0;
+    for (const StringValue& haystack : data->haystack_values) {
+      if (RE2::PartialMatch(re2::StringPiece(haystack.ptr, haystack.len), re)) {
+        ++data->matches;
+      }
+    }
+  }
+}
+
+void TestMultiStringSearch(int batch_size, void* d) {
+  MultiTestData* data = reinterpret_cast<MultiTestData*>(d);
+  MultiStringSearch search(data->needles);
+  for (int i = 0; i < batch_size; ++i) {
+    data->matches = 0;
+    for (const StringValue& haystack : data->haystack_values) {
+      if (search.ContainsAny(haystack)) ++data->matches;
+    }
+  }
+}
+
+// Log messages of which a quarter contain one of the needles.
+void InitMultiTestData(int num_needles, MultiTestData* data) {
+  const char* words[] = {"timeout", "refused", "unreachable", "denied", "overflow",
+      "corrupt", "deadlock", "exhausted", "aborted", "rejected", "expired", "invalid",
+      "truncated", "mismatch", "throttled", "unavailable", "killed", "panic", "fatal",
+      "segfault", "stalled", "dropped", "missing", "conflict"};
+  const int num_words = sizeof(words) / sizeof(words[0]);
+  for (int i = 0; i < num_needles; ++i) {
+    data->needles.push_back(string("request ") + words[i % num_words]);
+  }
+  srand(0);
+  for (int i = 0; i < 1000; ++i) {
+    string haystack = Substitute("2024-01-01 00:00:$0 host$1 worker $2: processing "
+        "batch $3 of partition $4 on executor $5", i % 60, rand() % 100, rand(),
+        rand() % 10000, rand() % 500, rand() % 20);
+    if (i % 4 == 0) {
+      haystack.append(" request ").append(words[rand() % min(num_needles, num_words)]);
+    } else {
+      haystack.append(" request completed");
+    }
+    data->haystacks.push_back(haystack);
+  }
+  for (const string& haystack : data->haystacks) {
+    data->haystack_values.emplace_back(haystack);
+  }
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << Benchmark::GetMachineInfo() << endl;
@@ -175,5 +266,15 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("Non-null Terminated SSE", TestImpalaNonNullTerminated, &data);
   cout << suite.Measure();
 
+  for (int num_needles : {4, 24}) {
+    MultiTestData multi_data;
+    InitMultiTestData(num_needles, &multi_data);
+    Benchmark multi_suite(Substitute("Multi String Search ($0 needles)", num_needles));
+    multi_suite.AddBenchmark("StringSearch Each", TestMultiStringSearchEach, &multi_data);
+    multi_suite.AddBenchmark("RE2 Alternation", TestMultiRe2Alternation, &multi_data);
+    multi_suite.AddBenchmark("MultiStringSearch", TestMultiStringSearch, &multi_data);
+    cout << multi_suite.Measure();
+  }
+
   return 0;
 }
@@ -0,0 +1,159 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+#include "exec/hdfs-text-table-writer.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/date-value.h"
+#include "runtime/decimal-value.h"
+#include "runtime/raw-value.h"
+#include "runtime/timestamp-value.h"
+#include "runtime/types.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
+
+using namespace impala;
+
+// Compares formatting the values of text table rows through a stringstream with
+// RawValue::PrintValue(), which HdfsTextTableWriter used to do, to formatting them
+// directly into a string buffer with HdfsTextTableWriter::AppendValue(). The values of
+// every type are formatted as a column of rows with a field delimiter after each value.
+
+// Number of values of every type.
+static const int NUM_VALUES = 1024;
+
+struct TestData {
+  ColumnType type;
+  // The values, stored back to back in slots of 'slot_size' bytes.
+  vector<uint8_t> values;
+  int slot_size;
+
+  const void* value(int i) const { return &values[i * slot_size]; }
+};
+
+void TestStringstream(int batch_size, void* d) {
+  const TestData* data = reinterpret_cast<TestData*>(d);
+  stringstream out;
+  out.precision(RawValue::ASCII_PRECISION);
+  for (int i = 0; i < batch_size; ++i) {
+    out.str(string());
+    for (int j = 0; j < NUM_VALUES; ++j) {
+      RawValue::PrintValue(data->value(j), data->type, -1, &out);
+      out << ',';
+    }
+  }
+}
+
+void TestAppendValue(int batch_size, void* d) {
+  const TestData* data = reinterpret_cast<TestData*>(d);
+  string buffer;
+  for (int i = 0; i < batch_size; ++i) {
+    buffer.clear();
+    for (int j = 0; j < NUM_VALUES; ++j) {
+      HdfsTextTableWriter::AppendValue(data->value(j), data->type, -1, &buffer);
+      buffer.push_back(',');
+    }
+  }
+}
+
+// Returns false if the two ways of formatting produce different text.
+bool CheckResults(const TestData& data) {
+  bool ok = true;
+  for (int i = 0; i < NUM_VALUES; ++i) {
+    stringstream expected;
+    expected.precision(RawValue::ASCII_PRECISION);
+    RawValue::PrintValue(data.value(i), data.type, -1, &expected);
+    string actual;
+    HdfsTextTableWriter::AppendValue(data.value(i), data.type, -1, &actual);
+    if (actual != expected.str()) {
+      cerr << "Incorrect result for " << data.type << ": " << actual
+           << " != " << expected.str() << endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+template <typename T>
+void AddValue(const T& value, TestData* data) {
+  data->slot_size = sizeof(T);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+  data->values.insert(data->values.end(), bytes, bytes + sizeof(T));
+}
+
+int main(int argc, char** argv) {
+  CpuInfo::Init();
+  cout << Benchmark::GetMachineInfo() << endl;
+
+  mt19937 rng(1234);
+  vector<TestData> data;
+  TestData int_data{ColumnType(TYPE_INT)};
+  uniform_int_distribution<int32_t> int_dist;
+  for (int i = 0; i < NUM_VALUES; ++i) AddValue(int_dist(rng), &int_data);
+  data.push_back(move(int_data));
+
+  TestData bigint_data{ColumnType(TYPE_BIGINT)};
+  uniform_int_distribution<int64_t> bigint_dist;
+  for (int i = 0; i < NUM_VALUES; ++i) AddValue(bigint_dist(rng), &bigint_data);
+  data.push_back(move(bigint_data));
+
+  TestData double_data{ColumnType(TYPE_DOUBLE)};
+  uniform_real_distribution<double> double_dist(-1e6, 1e6);
+  for (int i = 0; i < NUM_VALUES; ++i) AddValue(double_dist(rng), &double_data);
+  data.push_back(move(double_data));
+
+  TestData decimal_data{ColumnType::CreateDecimalType(18, 4)};
+  uniform_int_distribution<int64_t> decimal_dist(-999999999999999999L,
+      999999999999999999L);
+  for (int i = 0; i < NUM_VALUES; ++i) {
+    AddValue(Decimal8Value(decimal_dist(rng)), &decimal_data);
+  }
+  data.push_back(move(decimal_data));
+
+  TestData timestamp_data{ColumnType(TYPE_TIMESTAMP)};
+  uniform_int_distribution<int64_t> unix_micros_dist(0, 2000000000L * 1000000L);
+  for (int i = 0; i < NUM_VALUES; ++i) {
+    AddValue(TimestampValue::UtcFromUnixTimeMicros(unix_micros_dist(rng)),
+        &timestamp_data);
+  }
+  data.push_back(move(timestamp_data));
+
+  TestData date_data{ColumnType(TYPE_DATE)};
+  uniform_int_distribution<int64_t> days_dist(-100000, 100000);
+  for (int i = 0; i < NUM_VALUES; ++i) AddValue(DateValue(days_dist(rng)), &date_data);
+  data.push_back(move(date_data));
+
+  bool ok = true;
+  for (TestData& test_data : data) {
+    Benchmark suite(Substitute("Format $0", test_data.type.DebugString()));
+    suite.AddBenchmark("Stringstream", TestStringstream, &test_data);
+    suite.AddBenchmark("AppendValue", TestAppendValue, &test_data);
+    cout << suite.Measure() << endl;
+    ok &= CheckResults(test_data);
+  }
+  return ok ? 0 : 1;
+}
@@ -39,6 +39,11 @@ using namespace impala;
 //                   RandomImpala              0.1437              0.358X
 //                RandomUnaligned              0.1452             0.3619X
 
+// The "Key Access" suite compares the default layout, which orders the slots by
+// descending size, with the access-aware layout of the ACCESS_AWARE_TUPLE_LAYOUT query
+// option, which places the key slots first. Only the keys of randomly ordered tuples are
+// read, as when a hash table probes its build rows.
+
 #define VALIDATE 0
 
 const int NUM_TUPLES = 1024 * 500;
@@ -69,8 +74,36 @@ struct ImpalaTupleStruct {
   double val;
 };
 
+/// 80 byte tuple with two 16 byte payload slots before the keys, as in the default
+/// layout. 'key1' and 'key2' are in different cache lines for a quarter of the tuples.
+struct DefaultLayoutTupleStruct {
+  char payload1[16];
+  char payload2[16];
+  char payload3[16];
+  int64_t key1;
+  int64_t payload4;
+  int64_t payload5;
+  int32_t key2;
+  int32_t payload6;
+};
+
+/// The same slots as DefaultLayoutTupleStruct with the keys first.
+struct HotFirstTupleStruct {
+  int64_t key1;
+  int32_t key2;
+  int32_t payload6;
+  char payload1[16];
+  char payload2[16];
+  char payload3[16];
+  int64_t payload4;
+  int64_t payload5;
+};
+
 struct TestData {
   double result;
+  int64_t key_result;
+  DefaultLayoutTupleStruct* default_layout_data;
+  HotFirstTupleStruct* hot_first_data;
   UnpaddedTupleStruct* unpadded_data;
   PaddedTupleStruct* padded_data;
   ImpalaTupleStruct* impala_data;
@@ -86,6 +119,10 @@ void InitTestData(TestData* data) {
   data->impala_data =
       (ImpalaTupleStruct*)malloc(NUM_TUPLES * sizeof(ImpalaTupleStruct));
   data->unaligned_data = (char*)malloc(NUM_TUPLES * PaddedTupleStruct::UnpaddedSize);
+  data->default_layout_data = (DefaultLayoutTupleStruct*)malloc(
+      NUM_TUPLES * sizeof(DefaultLayoutTupleStruct));
+  data->hot_first_data =
+      (HotFirstTupleStruct*)malloc(NUM_TUPLES * sizeof(HotFirstTupleStruct));
   data->rand_access_order.resize(NUM_TUPLES);
 
   char* unpadded_ptr = data->unaligned_data;
@@ -108,6 +145,12 @@ void InitTestData(TestData* data) {
     data->impala_data[i].id = rand_id;
     data->impala_data[i].val = rand_val;
 
+    int32_t rand_key2 = rand() % MAX_ID;
+    data->default_layout_data[i].key1 = rand_id;
+    data->default_layout_data[i].key2 = rand_key2;
+    data->hot_first_data[i].key1 = rand_id;
+    data->hot_first_data[i].key2 = rand_key2;
+
     *reinterpret_cast<int8_t*>(unpadded_ptr) = rand_a;
     unpadded_ptr += 1;
     *reinterpret_cast<double*>(unpadded_ptr) = rand_val;
@@ -211,6 +254,30 @@ void TestRandomUnaligned(int batch_size, void* d) {
   }
 }
 
+void TestRandomDefaultLayoutKeys(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int* order = &data->rand_access_order[0];
+    data->key_result = 0;
+    for (int j = 0; j < NUM_TUPLES; ++j) {
+      const DefaultLayoutTupleStruct& item = data->default_layout_data[order[j]];
+      if (item.key1 > MAX_ID / 2) data->key_result += item.key2;
+    }
+  }
+}
+
+void TestRandomHotFirstKeys(int batch_size, void* d) {
+  TestData* data = reinterpret_cast<TestData*>(d);
+  for (int i = 0; i < batch_size; ++i) {
+    int* order = &data->rand_access_order[0];
+    data->key_result = 0;
+    for (int j = 0; j < NUM_TUPLES; ++j) {
+      const HotFirstTupleStruct& item = data->hot_first_data[order[j]];
+      if (item.key1 > MAX_ID / 2) data->key_result += item.key2;
+    }
+  }
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << Benchmark::GetMachineInfo() << endl;
@@ -218,6 +285,8 @@ int main(int argc, char **argv) {
   DCHECK_EQ(sizeof(UnpaddedTupleStruct), 24);
   DCHECK_EQ(sizeof(PaddedTupleStruct), 32);
   DCHECK_EQ(sizeof(ImpalaTupleStruct), 24);
+  DCHECK_EQ(sizeof(DefaultLayoutTupleStruct), 80);
+  DCHECK_EQ(sizeof(HotFirstTupleStruct), 80);
 
   TestData data;
   InitTestData(&data);
@@ -237,6 +306,10 @@ int main(int argc, char **argv) {
   cout << data.result << endl;
   TestRandomUnaligned(1, &data);
   cout << data.result << endl;
+  TestRandomDefaultLayoutKeys(1, &data);
+  cout << data.key_result << endl;
+  TestRandomHotFirstKeys(1, &data);
+  cout << data.key_result << endl;
 #else
   Benchmark suite("Tuple Layout");
   suite.AddBenchmark("SequentialPadded", TestSequentialPadded, &data);
@@ -246,6 +319,11 @@ int main(int argc, char **argv) {
   suite.AddBenchmark("RandomImpala", TestRandomImpala, &data);
   suite.AddBenchmark("RandomUnaligned", TestRandomUnaligned, &data);
   cout << suite.Measure();
+
+  Benchmark key_suite("Key Access");
+  key_suite.AddBenchmark("RandomDefaultLayout", TestRandomDefaultLayoutKeys, &data);
+  key_suite.AddBenchmark("RandomHotFirst", TestRandomHotFirstKeys, &data);
+  cout << key_suite.Measure();
 #endif
 
   return 0;
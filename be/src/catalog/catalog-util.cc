@@ -75,6 +75,10 @@ jobject TopicItemSpanIterator::next(JNIEnv* env) {
     Status s;
     const TTopicItem* current = begin_++;
     if (decompress_) {
+      int64_t capacity = decompressed_buffer_.capacity();
+      if (capacity > MAX_RETAINED_BUFFER_SIZE) {
+        string().swap(decompressed_buffer_);
+      }
       s = DecompressCatalogObject(
           reinterpret_cast<const uint8_t*>(current->value.data()),
           static_cast<uint32_t>(current->value.size()), &decompressed_buffer_);
@@ -93,6 +97,9 @@ jobject TopicItemSpanIterator::next(JNIEnv* env) {
     if (s.ok()) return result;
     LOG(ERROR) << "Error creating return value: " << s.GetDetail();
   }
+  // The FE applies the objects after consuming all of them, so do not hold on to the
+  // buffer until then.
+  string().swap(decompressed_buffer_);
   return nullptr;
 }
 
@@ -110,9 +117,13 @@ jobject CatalogUpdateResultIterator::next(JNIEnv* env) {
       deleted = false;
     }
     ++pos_;
+    if (serializer_ == nullptr || last_size_ > MAX_RETAINED_BUFFER_SIZE) {
+      serializer_.reset(new ThriftSerializer(false));
+    }
     uint8_t* buf;
     uint32_t buf_size;
-    Status s = serializer_.SerializeToBuffer(current_obj, &buf_size, &buf);
+    Status s = serializer_->SerializeToBuffer(current_obj, &buf_size, &buf);
+    last_size_ = s.ok() ? buf_size : 0;
     if (!s.ok()) {
       LOG(ERROR) << "Error serializing catalog object: " << s.GetDetail();
       continue;
@@ -122,6 +133,7 @@ jobject CatalogUpdateResultIterator::next(JNIEnv* env) {
     if (s.ok()) return result;
     LOG(ERROR) << "Error creating jobject." << s.GetDetail();
   }
+  serializer_.reset();
   return nullptr;
 }
 
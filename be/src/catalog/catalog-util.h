@@ -20,6 +20,7 @@
 #define IMPALA_CATALOG_CATALOG_UTIL_H
 
 #include <jni.h>
+#include <memory>
 #include <gen-cpp/StatestoreService_types.h>
 #include <gen-cpp/CatalogService_types.h>
 #include <rpc/thrift-util.h>
@@ -48,6 +49,11 @@ class JniCatalogCacheUpdateIterator {
   virtual ~JniCatalogCacheUpdateIterator() = default;
 
  protected:
+  /// Buffers that held a serialized object larger than this are freed rather than
+  /// reused for the next object, so that a single large table does not pin its buffer
+  /// while the FE deserializes the remaining objects and applies the update.
+  static const int64_t MAX_RETAINED_BUFFER_SIZE = 16L * 1024L * 1024L;
+
   /// A helper function used to create the return value of next().
   Status createPair(JNIEnv* env, bool deleted, const uint8_t* buffer, long size,
       jobject* out);
@@ -72,6 +78,9 @@ class TopicItemSpanIterator : public JniCatalogCacheUpdateIterator {
   const TTopicItem* begin_;
   const TTopicItem* end_;
   bool decompress_;
+
+  /// Holds the object returned by the last call of next(). Freed once the iterator is
+  /// exhausted or if it exceeds MAX_RETAINED_BUFFER_SIZE.
   std::string decompressed_buffer_;
 };
 
@@ -79,14 +88,23 @@ class TopicItemSpanIterator : public JniCatalogCacheUpdateIterator {
 class CatalogUpdateResultIterator : public JniCatalogCacheUpdateIterator {
  public:
   explicit CatalogUpdateResultIterator(const TCatalogUpdateResult& catalog_update_result)
-      : result_(catalog_update_result), pos_(0), serializer_(false) {}
+      : result_(catalog_update_result),
+        pos_(0),
+        serializer_(new ThriftSerializer(false)) {}
 
   jobject next(JNIEnv* env) override;
 
  private:
   const TCatalogUpdateResult& result_;
   int pos_;
-  ThriftSerializer serializer_;
+
+  /// Holds the object returned by the last call of next() in its buffer. Recreated,
+  /// which frees the buffer, if the last object exceeded MAX_RETAINED_BUFFER_SIZE, and
+  /// freed once the iterator is exhausted.
+  std::unique_ptr<ThriftSerializer> serializer_;
+
+  /// Size of the object returned by the last call of next().
+  uint32_t last_size_ = 0;
 };
 
 /// Converts a string to the matching TCatalogObjectType enum type. Returns
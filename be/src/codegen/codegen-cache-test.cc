@@ -0,0 +1,111 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "codegen/codegen-cache.h"
+
+#include <gflags/gflags.h>
+
+#include "runtime/mem-tracker.h"
+#include "testutil/gtest-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+DECLARE_bool(cache_force_single_shard);
+
+namespace impala {
+
+static const int64_t CAPACITY = 64 * 1024;
+
+class CodegenCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() override {
+    // Makes the capacity of the cache exact.
+    FLAGS_cache_force_single_shard = true;
+    metrics_.reset(new MetricGroup("codegen-cache-test"));
+    cache_.reset(new CodegenCache(CAPACITY, &process_tracker_));
+    ASSERT_OK(cache_->Init(metrics_.get()));
+  }
+
+  virtual void TearDown() override {
+    cache_.reset();
+    EXPECT_EQ(0, process_tracker_.consumption());
+    process_tracker_.Close();
+  }
+
+  int64_t Metric(const string& key) {
+    return metrics_->GetOrCreateChildGroup("codegen-cache")
+        ->FindMetricForTesting<IntCounter>(key)->GetValue();
+  }
+
+  /// Returns an entry without an engine with 'code_bytes' bytes of code.
+  static shared_ptr<CodegenCacheEntry> MakeEntry(int64_t code_bytes) {
+    shared_ptr<CodegenCacheEntry> entry = make_shared<CodegenCacheEntry>();
+    entry->fn_ptrs["fn"] = reinterpret_cast<void*>(0x1234);
+    entry->code_bytes = code_bytes;
+    return entry;
+  }
+
+  MemTracker process_tracker_;
+  unique_ptr<MetricGroup> metrics_;
+  unique_ptr<CodegenCache> cache_;
+};
+
+TEST_F(CodegenCacheTest, Key) {
+  const string key = CodegenCache::MakeKey("cpu", "bitcode", {"fn1", "fn2"});
+  EXPECT_EQ(key, CodegenCache::MakeKey("cpu", "bitcode", {"fn1", "fn2"}));
+  EXPECT_NE(key, CodegenCache::MakeKey("cpu2", "bitcode", {"fn1", "fn2"}));
+  EXPECT_NE(key, CodegenCache::MakeKey("cpu", "bitcodf", {"fn1", "fn2"}));
+  EXPECT_NE(key, CodegenCache::MakeKey("cpu", "bitcode", {"fn1"}));
+  EXPECT_NE(key, CodegenCache::MakeKey("cpu", "bitcode", {"fn2", "fn1"}));
+}
+
+TEST_F(CodegenCacheTest, Basic) {
+  EXPECT_EQ(nullptr, cache_->Lookup("key"));
+  EXPECT_EQ(1, Metric("codegen-cache.miss-count"));
+  shared_ptr<CodegenCacheEntry> entry = MakeEntry(1024);
+  cache_->Insert("key", entry);
+  EXPECT_GT(process_tracker_.consumption(), 1024);
+  shared_ptr<const CodegenCacheEntry> hit = cache_->Lookup("key");
+  EXPECT_EQ(entry.get(), hit.get());
+  EXPECT_EQ(1, Metric("codegen-cache.hit-count"));
+
+  // Entries larger than the capacity are not cached.
+  cache_->Insert("large", MakeEntry(CAPACITY));
+  EXPECT_EQ(nullptr, cache_->Lookup("large"));
+}
+
+TEST_F(CodegenCacheTest, Eviction) {
+  shared_ptr<CodegenCacheEntry> first = MakeEntry(1024);
+  cache_->Insert("key0", first);
+  const int64_t charge = process_tracker_.consumption();
+  ASSERT_GT(charge, 0);
+  // Insert more than the capacity of the cache.
+  const int num_entries = 2 * CAPACITY / charge + 1;
+  for (int i = 1; i < num_entries; ++i) {
+    cache_->Insert(Substitute("key$0", i), MakeEntry(1024));
+  }
+  EXPECT_LE(process_tracker_.consumption(), CAPACITY);
+  EXPECT_GT(Metric("codegen-cache.eviction-count"), 0);
+
+  // The evicted entry is still owned by its users.
+  EXPECT_EQ(nullptr, cache_->Lookup("key0"));
+  EXPECT_EQ(1, first.use_count());
+}
+
+} // namespace impala
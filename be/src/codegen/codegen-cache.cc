@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "codegen/codegen-cache.h"
+
+#include <cstring>
+
+#include "gutil/strings/substitute.h"
+#include "runtime/mem-tracker.h"
+#include "util/hash-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+CodegenCache::CodegenCache(int64_t capacity, MemTracker* parent_mem_tracker)
+  : capacity_(capacity),
+    mem_tracker_(new MemTracker(-1, "Codegen Cache", parent_mem_tracker)),
+    cache_(NewCache(Cache::EvictionPolicy::LRU, capacity, "CodegenCache")) {
+  DCHECK_GT(capacity, 0);
+}
+
+CodegenCache::~CodegenCache() {
+  // Frees all entries, which releases their memory from 'mem_tracker_'.
+  cache_.reset();
+  mem_tracker_->Close();
+}
+
+Status CodegenCache::Init(MetricGroup* metrics) {
+  RETURN_IF_ERROR(cache_->Init());
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("codegen-cache");
+  hits_ = cache_metrics->AddCounter("codegen-cache.hit-count", 0);
+  misses_ = cache_metrics->AddCounter("codegen-cache.miss-count", 0);
+  evictions_ = cache_metrics->AddCounter("codegen-cache.eviction-count", 0);
+  total_bytes_ = cache_metrics->AddGauge("codegen-cache.total-bytes", 0);
+  num_entries_ = cache_metrics->AddGauge("codegen-cache.num-entries", 0);
+  return Status::OK();
+}
+
+string CodegenCache::MakeKey(
+    const string& target, const string& bitcode, const vector<string>& fn_names) {
+  uint64_t hash1 = HashUtil::XxHash64(bitcode.data(), bitcode.size(), 0);
+  uint64_t hash2 = HashUtil::FastHash64(bitcode.data(), bitcode.size(), 0);
+  for (const string& fn_name : fn_names) {
+    hash1 = HashUtil::XxHash64(fn_name.data(), fn_name.size(), hash1);
+    hash2 = HashUtil::FastHash64(fn_name.data(), fn_name.size(), hash2);
+  }
+  return Substitute("$0:$1:$2:$3:$4", bitcode.size(), fn_names.size(), hash1, hash2,
+      target);
+}
+
+shared_ptr<const CodegenCacheEntry> CodegenCache::Lookup(const string& key) {
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle == nullptr) {
+    misses_->Increment(1);
+    return nullptr;
+  }
+  Value value;
+  memcpy(&value, cache_->Value(handle).data(), sizeof(value));
+  hits_->Increment(1);
+  return *value.entry;
+}
+
+void CodegenCache::Insert(
+    const string& key, shared_ptr<const CodegenCacheEntry> entry) {
+  Value value;
+  value.charge = entry->code_bytes + key.size() + sizeof(value) + sizeof(*entry);
+  for (const auto& fn_ptr : entry->fn_ptrs) {
+    value.charge += sizeof(fn_ptr) + fn_ptr.first.capacity();
+  }
+  if (!FitsInCache(value.charge)) return;
+  Cache::UniquePendingHandle pending(
+      cache_->Allocate(key, sizeof(value), value.charge));
+  if (pending == nullptr) return;
+  value.entry = new shared_ptr<const CodegenCacheEntry>(move(entry));
+  memcpy(cache_->MutableValue(&pending), &value, sizeof(value));
+  // EvictedEntry() releases the memory, also when the insertion fails.
+  mem_tracker_->Consume(value.charge);
+  total_bytes_->Increment(value.charge);
+  num_entries_->Increment(1);
+  // Fragment instances that compile the same module concurrently may insert the same
+  // key, the last insertion replaces the earlier entries.
+  Cache::UniqueHandle handle(cache_->Insert(move(pending), this));
+}
+
+void CodegenCache::EvictedEntry(Slice key, Slice value) {
+  DCHECK_EQ(value.size(), sizeof(Value));
+  Value cache_value;
+  memcpy(&cache_value, value.data(), sizeof(cache_value));
+  delete cache_value.entry;
+  mem_tracker_->Release(cache_value.charge);
+  // The metrics are not set if the cache was never initialized.
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(-cache_value.charge);
+    num_entries_->Increment(-1);
+    evictions_->Increment(1);
+  }
+}
+
+} // namespace impala
@@ -0,0 +1,116 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/status.h"
+#include "util/cache/cache.h"
+#include "util/metrics-fwd.h"
+
+namespace llvm {
+class ExecutionEngine;
+}
+
+namespace impala {
+
+class MemTracker;
+class MetricGroup;
+
+/// The machine code of a compiled codegen module, shared by all fragment instances
+/// that generate the same module.
+struct CodegenCacheEntry {
+  /// The engine that owns the machine code. The module was removed from the engine
+  /// after compilation, so the engine does not reference any LLVMContext.
+  std::shared_ptr<llvm::ExecutionEngine> engine;
+
+  /// The addresses of the jitted functions, by function name.
+  std::unordered_map<std::string, void*> fn_ptrs;
+
+  /// The bytes of machine code and data allocated by 'engine'.
+  int64_t code_bytes = 0;
+};
+
+/// Process-wide cache of the machine code of optimized and compiled codegen modules. A
+/// hit saves the optimization and compilation of the module in
+/// LlvmCodeGen::FinalizeModule(), which is most of the codegen time of short queries
+/// that run repeatedly, e.g. from dashboards.
+///
+/// Entries are keyed by MakeKey() from the bitcode of the unoptimized module, the
+/// functions to jit and the CPU that the code is compiled for. The entries are immutable
+/// and returned as shared pointers, so their code stays valid for the fragment instances
+/// that use it after they are evicted. The cache is bounded by the capacity given to the
+/// constructor and evicts in LRU order. Entries are charged the bytes allocated for
+/// their machine code.
+///
+/// All functions are thread-safe.
+class CodegenCache : public Cache::EvictionCallback {
+ public:
+  /// 'capacity' is the maximum memory in bytes charged to the entries.
+  CodegenCache(int64_t capacity, MemTracker* parent_mem_tracker);
+  ~CodegenCache();
+
+  /// Initializes the cache and registers its metrics in 'metrics'.
+  Status Init(MetricGroup* metrics);
+
+  /// Returns the entry for 'key', or null on a miss.
+  std::shared_ptr<const CodegenCacheEntry> Lookup(const std::string& key);
+
+  /// Adds 'entry' with key 'key'. Entries larger than the capacity are not cached.
+  void Insert(const std::string& key, std::shared_ptr<const CodegenCacheEntry> entry);
+
+  /// Returns the key of the module with bitcode 'bitcode' whose functions 'fn_names'
+  /// are jitted for the CPU described by 'target'. The key holds two independent 64-bit
+  /// hashes of the bitcode and the names rather than the bitcode itself, which can be
+  /// megabytes.
+  static std::string MakeKey(const std::string& target, const std::string& bitcode,
+      const std::vector<std::string>& fn_names);
+
+  /// Called by 'cache_' when an entry is evicted or erased.
+  virtual void EvictedEntry(Slice key, Slice value) override;
+
+ private:
+  /// The value of each entry. 'entry' is owned by the cache entry.
+  struct Value {
+    int64_t charge;
+    std::shared_ptr<const CodegenCacheEntry>* entry;
+  };
+
+  /// Returns true if an entry with charge 'charge' can be added to the cache.
+  bool FitsInCache(int64_t charge) const {
+    return charge <= capacity_ && charge <= std::numeric_limits<int>::max();
+  }
+
+  const int64_t capacity_;
+  std::unique_ptr<MemTracker> mem_tracker_;
+  std::unique_ptr<Cache> cache_;
+
+  /// Metrics of the cache, registered in Init().
+  IntCounter* hits_ = nullptr;
+  IntCounter* misses_ = nullptr;
+  IntCounter* evictions_ = nullptr;
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+} // namespace impala
@@ -0,0 +1,53 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "codegen/codegen-cost-model.h"
+
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+TEST(CodegenCostModelTest, NoModules) {
+  CodegenCostModel model;
+  EXPECT_EQ(0, model.num_modules());
+  EXPECT_EQ(-1, model.EstimateCompileTimeNs(1000));
+}
+
+TEST(CodegenCostModelTest, MovingAverage) {
+  CodegenCostModel model;
+  // The first module sets the time per instruction.
+  model.RecordCompile(1000, 10000);
+  EXPECT_EQ(1, model.num_modules());
+  EXPECT_EQ(10, model.EstimateCompileTimeNs(1));
+  EXPECT_EQ(20000, model.EstimateCompileTimeNs(2000));
+  // Later modules move the average by DECAY of their difference to it.
+  model.RecordCompile(100, 11000);
+  EXPECT_EQ(2, model.num_modules());
+  EXPECT_EQ(20000, model.EstimateCompileTimeNs(1000));
+}
+
+TEST(CodegenCostModelTest, InvalidModules) {
+  CodegenCostModel model;
+  model.RecordCompile(0, 1000);
+  model.RecordCompile(1000, -1);
+  EXPECT_EQ(0, model.num_modules());
+  EXPECT_EQ(-1, model.EstimateCompileTimeNs(1000));
+}
+
+} // namespace impala
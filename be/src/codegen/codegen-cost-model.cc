@@ -0,0 +1,56 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "codegen/codegen-cost-model.h"
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+CodegenCostModel* CodegenCostModel::GetInstance() {
+  static CodegenCostModel model;
+  return &model;
+}
+
+void CodegenCostModel::RecordCompile(int64_t num_instructions, int64_t compile_time_ns) {
+  if (num_instructions <= 0 || compile_time_ns < 0) return;
+  const double ns_per_instruction =
+      static_cast<double>(compile_time_ns) / num_instructions;
+  lock_guard<mutex> l(lock_);
+  if (num_modules_ == 0) {
+    ns_per_instruction_ = ns_per_instruction;
+  } else {
+    ns_per_instruction_ = DECAY * ns_per_instruction + (1 - DECAY) * ns_per_instruction_;
+  }
+  ++num_modules_;
+}
+
+int64_t CodegenCostModel::EstimateCompileTimeNs(int64_t num_instructions) const {
+  DCHECK_GE(num_instructions, 0);
+  lock_guard<mutex> l(lock_);
+  if (num_modules_ == 0) return -1;
+  return static_cast<int64_t>(ns_per_instruction_ * num_instructions);
+}
+
+int64_t CodegenCostModel::num_modules() const {
+  lock_guard<mutex> l(lock_);
+  return num_modules_;
+}
+
+} // namespace impala
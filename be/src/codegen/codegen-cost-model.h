@@ -0,0 +1,66 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+/// A model of the time that LLVM takes to optimize and compile codegen modules, learned
+/// from the modules that this process compiled. FragmentState uses it to decide whether
+/// compiling the module of a fragment is likely to pay off. The model is an
+/// exponentially weighted moving average of the optimization and compile time per
+/// instruction, since that time grows roughly linearly with the size of the module.
+/// Thread-safe.
+class CodegenCostModel {
+ public:
+  /// The weight of the most recent module in the moving average.
+  static constexpr double DECAY = 0.1;
+
+  CodegenCostModel() = default;
+
+  /// Returns the model shared by all fragments of this process.
+  static CodegenCostModel* GetInstance();
+
+  /// Records that a module with 'num_instructions' took 'compile_time_ns' to optimize and
+  /// compile.
+  void RecordCompile(int64_t num_instructions, int64_t compile_time_ns);
+
+  /// Returns the estimated time in nanoseconds to optimize and compile a module with
+  /// 'num_instructions', or -1 if no module has been recorded yet.
+  int64_t EstimateCompileTimeNs(int64_t num_instructions) const;
+
+  /// Returns the number of modules recorded.
+  int64_t num_modules() const;
+
+ private:
+  /// Protects the members below.
+  mutable std::mutex lock_;
+
+  /// The moving average of the time per instruction.
+  double ns_per_instruction_ = 0;
+
+  int64_t num_modules_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(CodegenCostModel);
+};
+
+} // namespace impala
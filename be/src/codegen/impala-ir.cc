@@ -31,6 +31,7 @@
 #include "exec/hdfs-avro-scanner-ir.cc"
 #include "exec/hdfs-columnar-scanner-ir.cc"
 #include "exec/hdfs-scanner-ir.cc"
+#include "exec/kudu-scanner-ir.cc"
 #include "exec/kudu-util-ir.cc"
 #include "exec/non-grouping-aggregator-ir.cc"
 #include "exec/partitioned-hash-join-builder-ir.cc"
@@ -72,6 +73,7 @@
 #include "udf/udf-ir.cc"
 #include "util/bloom-filter-ir.cc"
 #include "util/hash-util-ir.cc"
+#include "util/in-list-filter-ir.cc"
 #include "util/min-max-filter-ir.cc"
 
 #pragma clang diagnostic pop
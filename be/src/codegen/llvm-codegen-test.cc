@@ -18,6 +18,7 @@
 #include <memory>
 #include <string>
 #include <boost/thread/thread.hpp>
+#include <llvm/Transforms/Utils/Cloning.h>
 
 #include "testutil/gtest-util.h"
 #include "codegen/llvm-codegen.h"
@@ -110,6 +111,47 @@ class LlvmCodeGenTest : public testing:: Test {
 
   static Status FinalizeModule(LlvmCodeGen* codegen) { return codegen->FinalizeModule(); }
 
+  // Compiles only the fast tier of the module, like FinalizeModule() does before it
+  // optimizes the module if the fast tier is enabled.
+  static Status CompileFastTier(LlvmCodeGen* codegen) {
+    RETURN_IF_ERROR(codegen->FinalizeLazyMaterialization());
+    return codegen->CompileFastTier();
+  }
+
+  // Makes FinalizeModule() compile the fast tier before the optimized module.
+  static void EnableFastTier(LlvmCodeGen* codegen) {
+    codegen->EnableOptimizations(true);
+    codegen->compile_fast_tier_ = true;
+  }
+
+  static bool HasFastTier(LlvmCodeGen* codegen) {
+    return codegen->fast_tier_engine_ != nullptr
+        && codegen->fast_tier_compile_timer_->value() > 0;
+  }
+
+  // Returns the number of function definitions in 'module'.
+  static int NumDefinedFunctions(const llvm::Module& module) {
+    int num_fns = 0;
+    for (const llvm::Function& fn : module) {
+      if (!fn.isDeclaration()) ++num_fns;
+    }
+    return num_fns;
+  }
+
+  // Prunes a copy of the module of 'codegen' with PruneModule(). Sets
+  // '*num_fns_before' and '*num_fns_after' to the number of function definitions before
+  // and after pruning and returns true if the copy still defines 'fn'.
+  static bool PruneCopyOfModule(LlvmCodeGen* codegen, llvm::Function* fn,
+      int* num_fns_before, int* num_fns_after) {
+    EXPECT_OK(codegen->FinalizeLazyMaterialization());
+    unique_ptr<llvm::Module> copy = llvm::CloneModule(codegen->module_);
+    *num_fns_before = NumDefinedFunctions(*copy);
+    codegen->PruneModule(copy.get());
+    *num_fns_after = NumDefinedFunctions(*copy);
+    llvm::Function* copied_fn = copy->getFunction(fn->getName());
+    return copied_fn != nullptr && !copied_fn->isDeclaration();
+  }
+
   static Status LinkModuleFromLocalFs(LlvmCodeGen* codegen, const string& file) {
     return codegen->LinkModuleFromLocalFs(file);
   }
@@ -487,6 +529,93 @@ TEST_F(LlvmCodeGenTest, HashTest) {
   EXPECT_EQ(result, expected_hash) << LlvmCodeGen::IsCPUFeatureEnabled(CpuInfo::SSE4_2);
 }
 
+typedef uint32_t (*ConstantHashFn)();
+
+// Generates a function that hashes constant strings with the cross-compiled and the
+// handcrafted hash functions and registers it to be jitted into 'jitted_fn'. Returns
+// the function and sets '*expected_hash' to the hash it must return.
+static llvm::Function* CodegenConstantHashFn(LlvmCodeGen* codegen,
+    CodegenFnPtr<ConstantHashFn>* jitted_fn, uint32_t* expected_hash) {
+  const char* data1 = "test string";
+  const char* data2 = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  *expected_hash = HashUtil::Hash(data1, strlen(data1), 0);
+  *expected_hash = HashUtil::Hash(data2, strlen(data2), *expected_hash);
+
+  LlvmBuilder builder(codegen->context());
+  LlvmCodeGen::FnPrototype prototype(codegen, "ConstantHash", codegen->i32_type());
+  llvm::Function* fn = prototype.GeneratePrototype(&builder, nullptr);
+  llvm::Value* seed = codegen->GetI32Constant(0);
+  seed = builder.CreateCall(codegen->GetHashFunction(strlen(data1)),
+      llvm::ArrayRef<llvm::Value*>({codegen->GetStringConstant(&builder, data1,
+          strlen(data1)), codegen->GetI32Constant(strlen(data1)), seed}));
+  seed = builder.CreateCall(codegen->GetHashFunction(),
+      llvm::ArrayRef<llvm::Value*>({codegen->GetStringConstant(&builder, data2,
+          strlen(data2)), codegen->GetI32Constant(strlen(data2)), seed}));
+  builder.CreateRet(seed);
+  fn = codegen->FinalizeFunction(fn);
+  if (fn != nullptr) codegen->AddFunctionToJit(fn, jitted_fn);
+  return fn;
+}
+
+// Test that pruning removes the functions that are not reachable from the jitted ones,
+// and that the unoptimized fast tier, which is compiled from a pruned copy of the
+// module, returns the same results as the optimized module.
+TEST_F(LlvmCodeGenTest, FastTier) {
+  uint32_t expected_hash;
+
+  // The optimized module only.
+  scoped_ptr<LlvmCodeGen> full_codegen;
+  ASSERT_OK(LlvmCodeGen::CreateImpalaCodegen(
+      fragment_state_, nullptr, "test", &full_codegen));
+  const auto close_full_codegen =
+      MakeScopeExitTrigger([&full_codegen]() { full_codegen->Close(); });
+  full_codegen->EnableOptimizations(true);
+  CodegenFnPtr<ConstantHashFn> full_fn;
+  ASSERT_TRUE(CodegenConstantHashFn(full_codegen.get(), &full_fn, &expected_hash)
+      != nullptr);
+  ASSERT_OK(FinalizeModule(full_codegen.get()));
+  ASSERT_TRUE(full_fn.load() != nullptr);
+  EXPECT_EQ(expected_hash, full_fn.load()());
+  EXPECT_FALSE(HasFastTier(full_codegen.get()));
+
+  // The fast tier only.
+  scoped_ptr<LlvmCodeGen> fast_codegen;
+  ASSERT_OK(LlvmCodeGen::CreateImpalaCodegen(
+      fragment_state_, nullptr, "test", &fast_codegen));
+  const auto close_fast_codegen =
+      MakeScopeExitTrigger([&fast_codegen]() { fast_codegen->Close(); });
+  CodegenFnPtr<ConstantHashFn> fast_fn;
+  llvm::Function* fn =
+      CodegenConstantHashFn(fast_codegen.get(), &fast_fn, &expected_hash);
+  ASSERT_TRUE(fn != nullptr);
+  int num_fns_before, num_fns_after;
+  EXPECT_TRUE(
+      PruneCopyOfModule(fast_codegen.get(), fn, &num_fns_before, &num_fns_after));
+  EXPECT_LT(num_fns_after, num_fns_before);
+  EXPECT_GT(num_fns_after, 0);
+  ASSERT_OK(CompileFastTier(fast_codegen.get()));
+  ASSERT_TRUE(fast_fn.load() != nullptr);
+  EXPECT_NE(full_fn.load(), fast_fn.load());
+  EXPECT_EQ(full_fn.load()(), fast_fn.load()());
+  EXPECT_TRUE(HasFastTier(fast_codegen.get()));
+
+  // Both tiers, as compiled by async codegen. The function pointer ends up pointing to
+  // the optimized code, the fast tier is kept until Close().
+  scoped_ptr<LlvmCodeGen> tiered_codegen;
+  ASSERT_OK(LlvmCodeGen::CreateImpalaCodegen(
+      fragment_state_, nullptr, "test", &tiered_codegen));
+  const auto close_tiered_codegen =
+      MakeScopeExitTrigger([&tiered_codegen]() { tiered_codegen->Close(); });
+  EnableFastTier(tiered_codegen.get());
+  CodegenFnPtr<ConstantHashFn> tiered_fn;
+  ASSERT_TRUE(CodegenConstantHashFn(tiered_codegen.get(), &tiered_fn, &expected_hash)
+      != nullptr);
+  ASSERT_OK(FinalizeModule(tiered_codegen.get()));
+  ASSERT_TRUE(tiered_fn.load() != nullptr);
+  EXPECT_EQ(expected_hash, tiered_fn.load()());
+  EXPECT_TRUE(HasFastTier(tiered_codegen.get()));
+}
+
 // Test that an error propagating through codegen's diagnostic handler is
 // captured by impala. An error is induced by asking Llvm to link the same lib twice.
 TEST_F(LlvmCodeGenTest, HandleLinkageError) {
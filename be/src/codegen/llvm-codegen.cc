@@ -17,6 +17,7 @@
 
 #include "codegen/llvm-codegen.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <unordered_set>
@@ -30,6 +31,7 @@
 #include <llvm/Analysis/Passes.h>
 #include <llvm/Analysis/TargetTransformInfo.h>
 #include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/ExecutionEngine/ExecutionEngine.h>
 #include <llvm/ExecutionEngine/MCJIT.h>
 #include <llvm/IR/Constants.h>
@@ -56,7 +58,9 @@
 #include <llvm/Transforms/Utils/Cloning.h>
 
 #include "codegen/codegen-anyval.h"
+#include "codegen/codegen-cache.h"
 #include "codegen/codegen-callgraph.h"
+#include "codegen/codegen-cost-model.h"
 #include "codegen/codegen-fn-ptr.h"
 #include "codegen/codegen-symbol-emitter.h"
 #include "codegen/impala-ir-data.h"
@@ -67,6 +71,7 @@
 #include "impala-ir/impala-ir-names.h"
 #include "runtime/collection-value.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/lib-cache.h"
 #include "runtime/mem-pool.h"
@@ -78,8 +83,10 @@
 #include "gutil/sysinfo.h"
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
+#include "util/event-tracer.h"
 #include "util/hdfs-util.h"
 #include "util/path-builder.h"
+#include "util/pretty-printer.h"
 #include "util/runtime-profile-counters.h"
 #include "util/symbols-util.h"
 #include "util/test-info.h"
@@ -93,6 +100,9 @@ using std::move;
 
 DEFINE_bool(print_llvm_ir_instruction_count, false,
     "if true, prints the instruction counts of all JIT'd functions");
+DEFINE_int32(codegen_profile_top_n_functions, 5,
+    "The number of JIT'd functions with the most instructions that are listed in the "
+    "'TopFunctions' info string of the codegen profile. 0 disables the breakdown.");
 DEFINE_bool(disable_optimization_passes, false,
     "if true, disables llvm optimization passes (used for testing)");
 DEFINE_bool(dump_ir, false, "if true, output IR after optimization passes");
@@ -105,6 +115,10 @@ DEFINE_string(opt_module_dir, "",
     "if set, saves optimized generated IR modules to the specified directory.");
 DEFINE_string(asm_module_dir, "",
     "if set, saves disassembly for generated IR modules to the specified directory.");
+DEFINE_int32(codegen_prepared_modules, 0,
+    "(Advanced) The number of Impala IR modules that a background thread parses ahead of "
+    "time, so that fragments don't parse the module when they prepare codegen. 0 "
+    "disables the background parsing.");
 DECLARE_string(local_library_dir);
 // IMPALA-6291: AVX-512 and other CPU attrs the community doesn't routinely test are
 // disabled. AVX-512 is affected by known bugs in LLVM 3.9.1. The following attrs that
@@ -135,6 +149,10 @@ string LlvmCodeGen::cpu_name_;
 std::unordered_set<string> LlvmCodeGen::cpu_attrs_;
 string LlvmCodeGen::target_features_attr_;
 CodegenCallGraph LlvmCodeGen::shared_call_graph_;
+mutex LlvmCodeGen::prepared_modules_lock_;
+condition_variable LlvmCodeGen::prepared_modules_cv_;
+deque<LlvmCodeGen::PreparedModule> LlvmCodeGen::prepared_modules_;
+unique_ptr<Thread> LlvmCodeGen::prepare_modules_thread_;
 
 const map<int64_t, std::string> LlvmCodeGen::cpu_flag_mappings_{
     {CpuInfo::SSSE3, "+ssse3"}, {CpuInfo::SSE4_1, "+sse4.1"},
@@ -203,9 +221,58 @@ Status LlvmCodeGen::InitializeLlvm(bool load_backend) {
   // Initialize the global shared call graph.
   shared_call_graph_.Init(init_codegen->module_);
   init_codegen->Close();
+
+  if (FLAGS_codegen_prepared_modules > 0) {
+    RETURN_IF_ERROR(Thread::Create("codegen", "prepare-codegen-modules",
+        &LlvmCodeGen::PrepareModules, &prepare_modules_thread_));
+  }
   return Status::OK();
 }
 
+unique_ptr<llvm::MemoryBuffer> LlvmCodeGen::GetImpalaIrBuffer(string* module_name) {
+  llvm::StringRef module_ir = llvm::StringRef(
+        reinterpret_cast<const char*>(impala_llvm_ir), impala_llvm_ir_len);
+#if __x86_64__
+  *module_name = "Impala IR with AVX2 support";
+#else
+  *module_name = "Impala IR";
+#endif
+  return llvm::MemoryBuffer::getMemBuffer(module_ir, "", false);
+}
+
+void LlvmCodeGen::PrepareModules() {
+  while (true) {
+    {
+      const size_t capacity = FLAGS_codegen_prepared_modules;
+      unique_lock<mutex> l(prepared_modules_lock_);
+      while (prepared_modules_.size() >= capacity) prepared_modules_cv_.wait(l);
+    }
+    PreparedModule prepared;
+    prepared.context.reset(new llvm::LLVMContext());
+    string module_name;
+    unique_ptr<llvm::MemoryBuffer> module_ir_buf = GetImpalaIrBuffer(&module_name);
+    Status status = ParseModule(move(module_ir_buf), module_name,
+        prepared.context.get(), &prepared.module);
+    if (!status.ok()) {
+      LOG(WARNING) << "Stopped parsing Impala IR modules ahead of time: "
+                   << status.GetDetail();
+      return;
+    }
+    lock_guard<mutex> l(prepared_modules_lock_);
+    prepared_modules_.push_back(move(prepared));
+  }
+}
+
+bool LlvmCodeGen::TakePreparedModule(PreparedModule* prepared) {
+  if (FLAGS_codegen_prepared_modules <= 0) return false;
+  lock_guard<mutex> l(prepared_modules_lock_);
+  if (prepared_modules_.empty()) return false;
+  *prepared = move(prepared_modules_.front());
+  prepared_modules_.pop_front();
+  prepared_modules_cv_.notify_one();
+  return true;
+}
+
 LlvmCodeGen::LlvmCodeGen(FragmentState* state, ObjectPool* pool,
     MemTracker* parent_mem_tracker, const string& id)
   : state_(state),
@@ -215,9 +282,12 @@ LlvmCodeGen::LlvmCodeGen(FragmentState* state, ObjectPool* pool,
     optimizations_enabled_(false),
     is_corrupt_(false),
     is_compiled_(false),
+    has_native_fn_mappings_(false),
+    compile_fast_tier_(false),
     context_(new llvm::LLVMContext()),
     module_(nullptr),
     memory_manager_(nullptr),
+    fast_tier_memory_manager_(nullptr),
     cross_compiled_functions_(IRFunction::FN_END, nullptr) {
   DCHECK(llvm_initialized_) << "Must call LlvmCodeGen::InitializeLlvm first.";
 
@@ -228,6 +298,7 @@ LlvmCodeGen::LlvmCodeGen(FragmentState* state, ObjectPool* pool,
   ir_generation_timer_ = ADD_TIMER(profile_, "IrGenerationTime");
   optimization_timer_ = ADD_TIMER(profile_, "OptimizationTime");
   compile_timer_ = ADD_TIMER(profile_, "CompileTime");
+  fast_tier_compile_timer_ = ADD_TIMER(profile_, "FastTierCompileTime");
   main_thread_timer_ = ADD_TIMER(profile_, "MainThreadCodegenTime");
   compile_thread_counters_ = ADD_THREAD_COUNTERS(profile_,
       ASYNC_CODEGEN_THREAD_COUNTERS_PREFIX);
@@ -266,20 +337,28 @@ Status LlvmCodeGen::CreateFromMemory(FragmentState* state, ObjectPool* pool,
 #if __x86_64__
   CHECK(IsCPUFeatureEnabled(CpuInfo::AVX2));
 #endif
-  llvm::StringRef module_ir = llvm::StringRef(
-        reinterpret_cast<const char*>(impala_llvm_ir), impala_llvm_ir_len);
-#if __x86_64__
-  string module_name = "Impala IR with AVX2 support";
-#else
-  string module_name = "Impala IR";
-#endif
-
-  unique_ptr<llvm::MemoryBuffer> module_ir_buf(
-      llvm::MemoryBuffer::getMemBuffer(module_ir, "", false));
   unique_ptr<llvm::Module> loaded_module;
-  Status status = (*codegen)->LoadModuleFromMemory(move(module_ir_buf),
-      module_name, &loaded_module);
-  if (!status.ok()) goto error;
+  PreparedModule prepared;
+  Status status;
+  // Fragments use a module that was parsed ahead of time if there is one. The
+  // InitializeLlvm() codegen object, whose 'state' is null, always parses its own.
+  if (state != nullptr && TakePreparedModule(&prepared)) {
+    (*codegen)->context_ = move(prepared.context);
+    (*codegen)->context_->setDiagnosticHandler(
+        &DiagnosticHandler::DiagnosticHandlerFn, codegen->get());
+    COUNTER_ADD((*codegen)->module_bitcode_size_, impala_llvm_ir_len);
+    loaded_module = move(prepared.module);
+    (*codegen)->profile_->AddInfoString("PreparedModule", "Hit");
+  } else {
+    if (FLAGS_codegen_prepared_modules > 0) {
+      (*codegen)->profile_->AddInfoString("PreparedModule", "Miss");
+    }
+    string module_name;
+    unique_ptr<llvm::MemoryBuffer> module_ir_buf = GetImpalaIrBuffer(&module_name);
+    status = (*codegen)->LoadModuleFromMemory(move(module_ir_buf),
+        module_name, &loaded_module);
+    if (!status.ok()) goto error;
+  }
   status = (*codegen)->Init(move(loaded_module));
   if (!status.ok()) goto error;
   return Status::OK();
@@ -313,8 +392,14 @@ Status LlvmCodeGen::LoadModuleFromMemory(unique_ptr<llvm::MemoryBuffer> module_i
     string module_name, unique_ptr<llvm::Module>* module) {
   DCHECK(!module_name.empty());
   COUNTER_ADD(module_bitcode_size_, module_ir_buf->getMemBufferRef().getBufferSize());
+  return ParseModule(move(module_ir_buf), module_name, &context(), module);
+}
+
+Status LlvmCodeGen::ParseModule(unique_ptr<llvm::MemoryBuffer> module_ir_buf,
+    const string& module_name, llvm::LLVMContext* context,
+    unique_ptr<llvm::Module>* module) {
   llvm::Expected<unique_ptr<llvm::Module>> tmp_module =
-      getOwningLazyBitcodeModule(move(module_ir_buf), context());
+      getOwningLazyBitcodeModule(move(module_ir_buf), *context);
   if (llvm::Error err = tmp_module.takeError()) {
     string err_string;
     llvm::handleAllErrors(
@@ -336,7 +421,11 @@ Status LlvmCodeGen::LoadModuleFromMemory(unique_ptr<llvm::MemoryBuffer> module_i
 Status LlvmCodeGen::LinkModuleFromLocalFs(const string& file) {
   unique_ptr<llvm::Module> new_module;
   RETURN_IF_ERROR(LoadModuleFromFile(file, &new_module));
+  return LinkModule(move(new_module), file);
+}
 
+Status LlvmCodeGen::LinkModule(
+    unique_ptr<llvm::Module> new_module, const string& module_name) {
   // The module data layout must match the one selected by the execution engine.
   new_module->setDataLayout(execution_engine_->getDataLayout());
 
@@ -358,7 +447,7 @@ Status LlvmCodeGen::LinkModuleFromLocalFs(const string& file) {
   string diagnostic_err = diagnostic_handler_.GetErrorString();
   if (error) {
     stringstream ss;
-    ss << "Problem linking " << file << " to main module.";
+    ss << "Problem linking " << module_name << " to main module.";
     if (!diagnostic_err.empty()) ss << " " << diagnostic_err;
     return Status(ss.str());
   }
@@ -369,9 +458,16 @@ Status LlvmCodeGen::LinkModuleFromHdfs(const string& hdfs_location, const time_t
   if (linked_modules_.find(hdfs_location) != linked_modules_.end()) return Status::OK();
   LibCacheEntryHandle handle;
   string local_path;
-  RETURN_IF_ERROR(LibCache::instance()->GetLocalPath(
-      hdfs_location, LibCache::TYPE_IR, mtime, &handle, &local_path));
-  RETURN_IF_ERROR(LinkModuleFromLocalFs(local_path));
+  const string* bitcode;
+  RETURN_IF_ERROR(LibCache::instance()->GetIrBitcode(
+      hdfs_location, mtime, &handle, &local_path, &bitcode));
+  // The lazily loaded module keeps reading its buffer, which must therefore outlive
+  // 'handle'.
+  unique_ptr<llvm::Module> new_module;
+  RETURN_IF_ERROR(LoadModuleFromMemory(
+      llvm::MemoryBuffer::getMemBufferCopy(*bitcode, local_path), local_path,
+      &new_module));
+  RETURN_IF_ERROR(LinkModule(move(new_module), local_path));
   linked_modules_.insert(hdfs_location);
   return Status::OK();
 }
@@ -386,6 +482,7 @@ void LlvmCodeGen::StripGlobalCtorsDtors(llvm::Module* module) {
 Status LlvmCodeGen::CreateImpalaCodegen(FragmentState* state,
     MemTracker* parent_mem_tracker, const string& id,
     scoped_ptr<LlvmCodeGen>* codegen_ret) {
+  SCOPED_TRACE_EVENT("Codegen::CreateImpalaCodegen");
   DCHECK(state != nullptr);
   RETURN_IF_ERROR(CreateFromMemory(
       state, state->obj_pool(), parent_mem_tracker, id, codegen_ret));
@@ -490,10 +587,16 @@ void LlvmCodeGen::Close() {
     mem_tracker_->Release(memory_manager_->bytes_tracked());
     memory_manager_ = nullptr;
   }
+  if (fast_tier_memory_manager_ != nullptr) {
+    mem_tracker_->Release(fast_tier_memory_manager_->bytes_tracked());
+    fast_tier_memory_manager_ = nullptr;
+  }
   if (mem_tracker_ != nullptr) mem_tracker_->Close();
 
   // Execution engine executes callback on event listener, so tear down engine first.
   execution_engine_.reset();
+  fast_tier_engine_.reset();
+  cached_code_.reset();
   symbol_emitter_.reset();
   module_ = nullptr;
 }
@@ -895,6 +998,7 @@ Status LlvmCodeGen::LoadFunction(const TFunction& fn, const string& symbol,
     // Associate the dynamically loaded function pointer with the Function* we defined.
     // This tells LLVM where the compiled function definition is located in memory.
     execution_engine_->addGlobalMapping(*llvm_fn, fn_ptr);
+    has_native_fn_mappings_ = true;
   } else if (fn.binary_type == TFunctionBinaryType::BUILTIN) {
     // In this path, we're running a builtin with the UDF interface. The IR is
     // in the llvm module. Builtin functions may use Expr::GetConstant(). Clone the
@@ -1094,6 +1198,7 @@ Status LlvmCodeGen::FinalizeLazyMaterialization() {
 }
 
 Status LlvmCodeGen::FinalizeModule() {
+  SCOPED_TRACE_EVENT("Codegen::FinalizeModule");
   DCHECK(!is_compiled_);
   is_compiled_ = true;
 
@@ -1138,7 +1243,33 @@ Status LlvmCodeGen::FinalizeModule() {
   }
 
   RETURN_IF_ERROR(FinalizeLazyMaterialization());
-  if (optimizations_enabled_ && !FLAGS_disable_optimization_passes) {
+
+  // Skip the optimization and compilation if the same module was compiled before.
+  CodegenCache* codegen_cache = GetCodegenCache();
+  string cache_key;
+  if (codegen_cache != nullptr) {
+    cache_key = GetCodegenCacheKey();
+    shared_ptr<const CodegenCacheEntry> entry = codegen_cache->Lookup(cache_key);
+    if (entry != nullptr && SetFunctionPointersFromCache(move(entry))) {
+      profile_->AddInfoString("CodegenCache", "Hit");
+      DestroyModule();
+      return Status::OK();
+    }
+    profile_->AddInfoString("CodegenCache", "Miss");
+  }
+
+  const bool optimize = optimizations_enabled_ && !FLAGS_disable_optimization_passes;
+  // The fast tier only saves time if the module is optimized. It is skipped for modules
+  // with native UDFs, whose mappings are in 'execution_engine_'.
+  if (compile_fast_tier_ && optimize && !has_native_fn_mappings_) {
+    Status status = CompileFastTier();
+    if (!status.ok()) {
+      VLOG(1) << "Could not compile the fast tier of codegen module " << id_ << ": "
+              << status.GetDetail();
+    }
+  }
+
+  if (optimize) {
     RETURN_IF_ERROR(OptimizeModule());
   }
 
@@ -1158,12 +1289,27 @@ Status LlvmCodeGen::FinalizeModule() {
     // Finalize module, which compiles all functions.
     execution_engine_->finalizeObject();
   }
+  AddTopFunctionsInfoString();
+  if (optimize) {
+    CodegenCostModel::GetInstance()->RecordCompile(num_instructions_->value(),
+        optimization_timer_->value() + compile_timer_->value());
+  }
 
   SetFunctionPointers();
+  shared_ptr<CodegenCacheEntry> cache_entry;
+  if (codegen_cache != nullptr) {
+    cache_entry = make_shared<CodegenCacheEntry>();
+    cache_entry->fn_ptrs = GetCompiledFunctionPointers();
+  }
   DestroyModule();
 
   // Track the memory consumed by the compiled code.
   int64_t bytes_allocated = memory_manager_->bytes_allocated();
+  if (cache_entry != nullptr) {
+    cache_entry->engine = execution_engine_;
+    cache_entry->code_bytes = bytes_allocated;
+    codegen_cache->Insert(cache_key, move(cache_entry));
+  }
   if (!mem_tracker_->TryConsume(bytes_allocated)) {
     const string& msg = Substitute(
         "Failed to allocate '$0' bytes for compiled code module", bytes_allocated);
@@ -1175,6 +1321,7 @@ Status LlvmCodeGen::FinalizeModule() {
 
 Status LlvmCodeGen::FinalizeModuleAsync(RuntimeProfile::EventSequence* event_sequence) {
   DCHECK(event_sequence != nullptr);
+  compile_fast_tier_ = state_->query_options().async_codegen_fast_tier;
   Status thread_start_status = Thread::Create("async-codegen", "async-codegen",
       [this, event_sequence]() {
         SCOPED_THREAD_COUNTER_MEASUREMENT(compile_thread_counters_);
@@ -1201,6 +1348,7 @@ Status LlvmCodeGen::FinalizeModuleAsync(RuntimeProfile::EventSequence* event_seq
 
 /// TODO: In asynchronous mode, return early if the query is cancelled or finished.
 Status LlvmCodeGen::OptimizeModule() {
+  SCOPED_TRACE_EVENT("Codegen::OptimizeModule");
   SCOPED_TIMER(optimization_timer_);
 
   // This pass manager will construct optimizations passes that are "typical" for
@@ -1229,19 +1377,7 @@ Status LlvmCodeGen::OptimizeModule() {
   // global dead code elimination pass. This causes all functions not registered to be
   // JIT'd to be marked as internal, and any internal functions that are not used are
   // deleted by DCE pass. This greatly decreases compile time by removing unused code.
-  unordered_set<string> exported_fn_names;
-  for (auto& entry : fns_to_jit_compile_) {
-    exported_fn_names.insert(entry.first->getName().str());
-  }
-  unique_ptr<llvm::legacy::PassManager> module_pass_manager(
-      new llvm::legacy::PassManager());
-  module_pass_manager->add(llvm::createTargetTransformInfoWrapperPass(target_analysis));
-  module_pass_manager->add(
-      llvm::createInternalizePass([&exported_fn_names](const llvm::GlobalValue& gv) {
-        return exported_fn_names.find(gv.getName().str()) != exported_fn_names.end();
-      }));
-  module_pass_manager->add(llvm::createGlobalDCEPass());
-  module_pass_manager->run(*module_);
+  PruneModule(module_);
 
   // Update counters before final optimization, but after removing unused functions. This
   // gives us a rough measure of how much work the optimization and compilation must do.
@@ -1249,6 +1385,14 @@ Status LlvmCodeGen::OptimizeModule() {
   counter.visit(*module_);
   COUNTER_SET(num_functions_, counter.GetCount(InstructionCounter::TOTAL_FUNCTIONS));
   COUNTER_SET(num_instructions_, counter.GetCount(InstructionCounter::TOTAL_INSTS));
+  jit_fn_insts_before_opt_.clear();
+  if (FLAGS_codegen_profile_top_n_functions > 0) {
+    for (const auto& fn_pair : fns_to_jit_compile_) {
+      std::unordered_set<llvm::Function*> visited;
+      jit_fn_insts_before_opt_.push_back(
+          CountReachableInstructions(fn_pair.first, &visited));
+    }
+  }
 
   int64_t estimated_memory = ESTIMATED_OPTIMIZER_BYTES_PER_INST
       * counter.GetCount(InstructionCounter::TOTAL_INSTS);
@@ -1271,10 +1415,19 @@ Status LlvmCodeGen::OptimizeModule() {
   fn_pass_manager->doFinalization();
 
   // Create and run module pass manager
-  module_pass_manager.reset(new llvm::legacy::PassManager());
+  unique_ptr<llvm::legacy::PassManager> module_pass_manager(
+      new llvm::legacy::PassManager());
   module_pass_manager->add(llvm::createTargetTransformInfoWrapperPass(target_analysis));
   pass_builder.populateModulePassManager(*module_pass_manager);
   module_pass_manager->run(*module_);
+  if (!jit_fn_insts_before_opt_.empty()) {
+    jit_fn_insts_after_opt_.clear();
+    for (const auto& fn_pair : fns_to_jit_compile_) {
+      std::unordered_set<llvm::Function*> visited;
+      jit_fn_insts_after_opt_.push_back(
+          CountReachableInstructions(fn_pair.first, &visited));
+    }
+  }
   if (FLAGS_print_llvm_ir_instruction_count) {
     for (int i = 0; i < fns_to_jit_compile_.size(); ++i) {
       InstructionCounter counter;
@@ -1288,6 +1441,123 @@ Status LlvmCodeGen::OptimizeModule() {
   return Status::OK();
 }
 
+int64_t LlvmCodeGen::CountReachableInstructions(
+    llvm::Function* fn, std::unordered_set<llvm::Function*>* visited) {
+  if (!visited->insert(fn).second) return 0;
+  vector<llvm::Function*> stack({fn});
+  InstructionCounter counter;
+  while (!stack.empty()) {
+    llvm::Function* current = stack.back();
+    stack.pop_back();
+    counter.visit(*current);
+    for (llvm::Instruction& inst : llvm::instructions(current)) {
+      for (llvm::Value* operand : inst.operand_values()) {
+        llvm::Function* callee = llvm::dyn_cast<llvm::Function>(operand);
+        if (callee == nullptr || callee->isDeclaration()) continue;
+        if (visited->insert(callee).second) stack.push_back(callee);
+      }
+    }
+  }
+  return counter.GetCount(InstructionCounter::TOTAL_INSTS);
+}
+
+int64_t LlvmCodeGen::NumInstructionsToJit() {
+  std::unordered_set<llvm::Function*> visited;
+  int64_t num_instructions = 0;
+  for (const auto& fn_pair : fns_to_jit_compile_) {
+    num_instructions += CountReachableInstructions(fn_pair.first, &visited);
+  }
+  return num_instructions;
+}
+
+void LlvmCodeGen::AddTopFunctionsInfoString() {
+  const int num_fns = fns_to_jit_compile_.size();
+  if (jit_fn_insts_before_opt_.size() != num_fns
+      || jit_fn_insts_after_opt_.size() != num_fns) {
+    return;
+  }
+  int64_t total_insts = 0;
+  vector<int> order;
+  for (int i = 0; i < num_fns; ++i) {
+    total_insts += jit_fn_insts_before_opt_[i];
+    order.push_back(i);
+  }
+  if (total_insts == 0) return;
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return jit_fn_insts_before_opt_[a] > jit_fn_insts_before_opt_[b];
+  });
+  const int64_t total_time = optimization_timer_->value() + compile_timer_->value();
+  stringstream ss;
+  for (int i = 0; i < min(num_fns, FLAGS_codegen_profile_top_n_functions); ++i) {
+    const int fn_idx = order[i];
+    const int64_t insts = jit_fn_insts_before_opt_[fn_idx];
+    if (i > 0) ss << ", ";
+    ss << fns_to_jit_compile_[fn_idx].first->getName().str() << " (" << insts << " -> "
+       << jit_fn_insts_after_opt_[fn_idx] << " insts, ~"
+       << PrettyPrinter::Print(total_time * insts / total_insts, TUnit::TIME_NS) << ")";
+  }
+  profile_->AddInfoString("TopFunctions", ss.str());
+}
+
+void LlvmCodeGen::PruneModule(llvm::Module* module) {
+  unordered_set<string> exported_fn_names;
+  for (auto& entry : fns_to_jit_compile_) {
+    exported_fn_names.insert(entry.first->getName().str());
+  }
+  unique_ptr<llvm::legacy::PassManager> module_pass_manager(
+      new llvm::legacy::PassManager());
+  module_pass_manager->add(
+      llvm::createInternalizePass([&exported_fn_names](const llvm::GlobalValue& gv) {
+        return exported_fn_names.find(gv.getName().str()) != exported_fn_names.end();
+      }));
+  module_pass_manager->add(llvm::createGlobalDCEPass());
+  module_pass_manager->run(*module);
+}
+
+Status LlvmCodeGen::CompileFastTier() {
+  SCOPED_TIMER(fast_tier_compile_timer_);
+  unique_ptr<llvm::Module> fast_module = llvm::CloneModule(module_);
+  llvm::Module* fast_module_ptr = fast_module.get();
+  llvm::EngineBuilder builder(move(fast_module));
+  builder.setEngineKind(llvm::EngineKind::JIT);
+  builder.setOptLevel(llvm::CodeGenOpt::None);
+  unique_ptr<ImpalaMCJITMemoryManager> memory_manager(new ImpalaMCJITMemoryManager);
+  ImpalaMCJITMemoryManager* memory_manager_ptr = memory_manager.get();
+  builder.setMCJITMemoryManager(move(memory_manager));
+  builder.setMCPU(cpu_name_);
+  builder.setMAttrs(cpu_attrs_);
+  string error_string;
+  builder.setErrorStr(&error_string);
+  fast_tier_engine_.reset(builder.create());
+  if (fast_tier_engine_ == nullptr) {
+    return Status("Could not create ExecutionEngine: " + error_string);
+  }
+  fast_tier_memory_manager_ = memory_manager_ptr;
+
+  PruneModule(fast_module_ptr);
+  fast_tier_engine_->finalizeObject();
+  int64_t bytes_allocated = fast_tier_memory_manager_->bytes_allocated();
+  if (!mem_tracker_->TryConsume(bytes_allocated)) {
+    const string& msg = Substitute(
+        "Failed to allocate '$0' bytes for fast tier code module", bytes_allocated);
+    return mem_tracker_->MemLimitExceeded(NULL, msg, bytes_allocated);
+  }
+  fast_tier_memory_manager_->set_bytes_tracked(bytes_allocated);
+
+  for (const std::pair<llvm::Function*, CodegenFnPtrBase*>& fn_pair
+      : fns_to_jit_compile_) {
+    llvm::Function* function = fast_module_ptr->getFunction(fn_pair.first->getName());
+    DCHECK(function != nullptr) << fn_pair.first->getName().data();
+    void* jitted_function = fast_tier_engine_->getPointerToFunction(function);
+    DCHECK(jitted_function != nullptr) << "Failed to jit " << function->getName().data();
+    fn_pair.second->store(jitted_function);
+  }
+  // The machine code is retained by the engine, the IR is not needed anymore.
+  fast_tier_engine_->removeModule(fast_module_ptr);
+  delete fast_module_ptr;
+  return Status::OK();
+}
+
 void LlvmCodeGen::SetFunctionPointers() {
   // Get pointers to all codegen'd functions.
   for (const std::pair<llvm::Function*, CodegenFnPtrBase*>& fn_pair
@@ -1299,6 +1569,54 @@ void LlvmCodeGen::SetFunctionPointers() {
   }
 }
 
+CodegenCache* LlvmCodeGen::GetCodegenCache() const {
+  // The code of modules with native UDFs depends on where their libraries are loaded,
+  // and the symbol emitter must outlive the engine, which the cache may keep longer.
+  if (has_native_fn_mappings_ || symbol_emitter_ != nullptr) return nullptr;
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  return exec_env != nullptr ? exec_env->codegen_cache() : nullptr;
+}
+
+string LlvmCodeGen::GetCodegenCacheKey() const {
+  string bitcode;
+  {
+    llvm::raw_string_ostream stream(bitcode);
+    llvm::WriteBitcodeToFile(module_, stream);
+  }
+  vector<string> fn_names;
+  for (const auto& fn_pair : fns_to_jit_compile_) {
+    fn_names.push_back(fn_pair.first->getName().str());
+  }
+  const bool optimize = optimizations_enabled_ && !FLAGS_disable_optimization_passes;
+  const string target =
+      Substitute("$0:$1:$2", cpu_name_, target_features_attr_, optimize ? 1 : 0);
+  return CodegenCache::MakeKey(target, bitcode, fn_names);
+}
+
+bool LlvmCodeGen::SetFunctionPointersFromCache(
+    shared_ptr<const CodegenCacheEntry> entry) {
+  vector<void*> fn_ptrs;
+  for (const auto& fn_pair : fns_to_jit_compile_) {
+    auto it = entry->fn_ptrs.find(fn_pair.first->getName().str());
+    if (it == entry->fn_ptrs.end()) return false;
+    fn_ptrs.push_back(it->second);
+  }
+  for (int i = 0; i < fns_to_jit_compile_.size(); ++i) {
+    fns_to_jit_compile_[i].second->store(fn_ptrs[i]);
+  }
+  cached_code_ = move(entry);
+  return true;
+}
+
+std::unordered_map<string, void*> LlvmCodeGen::GetCompiledFunctionPointers() const {
+  std::unordered_map<string, void*> fn_ptrs;
+  for (const auto& fn_pair : fns_to_jit_compile_) {
+    fn_ptrs[fn_pair.first->getName().str()] =
+        execution_engine_->getPointerToFunction(fn_pair.first);
+  }
+  return fn_ptrs;
+}
+
 void LlvmCodeGen::DestroyModule() {
   // Clear all references to LLVM objects owned by the module.
   cross_compiled_functions_.clear();
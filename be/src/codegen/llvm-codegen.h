@@ -21,10 +21,14 @@
 
 #include "common/status.h"
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <boost/scoped_ptr.hpp>
 
@@ -83,6 +87,8 @@ namespace llvm {
 
 namespace impala {
 
+class CodegenCache;
+struct CodegenCacheEntry;
 class CodegenCallGraph;
 class CodegenFnPtrBase;
 class CodegenSymbolEmitter;
@@ -336,6 +342,11 @@ class LlvmCodeGen {
     return it->second;
   }
 
+  /// Returns the number of instructions of the functions added via AddFunctionToJit()
+  /// and the functions that they call, i.e. roughly the size of the module that
+  /// FinalizeModule() optimizes and compiles.
+  int64_t NumInstructionsToJit();
+
   /// Optimize and compile the module. This should be called after all functions to JIT
   /// have been added to the module via AddFunctionToJit(). If optimizations_enabled_ is
   /// false, the module will not be optimized before compilation. After FinalizeModule()
@@ -355,6 +366,11 @@ class LlvmCodeGen {
   ///
   /// The function pointers are atomic so no locking is needed.
   ///
+  /// If the query option 'async_codegen_fast_tier' is set, a copy of the module is first
+  /// compiled without optimization passes (see CompileFastTier()), so that the query
+  /// switches to codegen'd functions earlier, and then again to the optimized functions
+  /// once the optimized module is compiled.
+  ///
   /// 'Close' calls 'Join' on '*async_compile_thread_' if it is not a nullptr.
   Status FinalizeModuleAsync(RuntimeProfile::EventSequence* event_sequence);
 
@@ -667,15 +683,35 @@ class LlvmCodeGen {
   Status LoadModuleFromMemory(std::unique_ptr<llvm::MemoryBuffer> module_ir_buf,
       std::string module_name, std::unique_ptr<llvm::Module>* module);
 
+  /// Parses the module in 'module_ir_buf' into 'context' without materializing its
+  /// functions, and names it 'module_name'.
+  static Status ParseModule(std::unique_ptr<llvm::MemoryBuffer> module_ir_buf,
+      const std::string& module_name, llvm::LLVMContext* context,
+      std::unique_ptr<llvm::Module>* module);
+
+  /// Returns a buffer over the embedded Impala IR bitcode and sets 'module_name' to the
+  /// name of its module.
+  static std::unique_ptr<llvm::MemoryBuffer> GetImpalaIrBuffer(std::string* module_name);
+
+  /// The loop of 'prepare_modules_thread_', which keeps --codegen_prepared_modules
+  /// parsed Impala IR modules in 'prepared_modules_'.
+  static void PrepareModules();
+
   /// Loads a module at 'file' and links it to the module associated with this
   /// LlvmCodeGen object. The 'file' must be on the local filesystem.
   Status LinkModuleFromLocalFs(const std::string& file);
 
   /// Same as 'LinkModuleFromLocalFs', but takes an hdfs file location instead and makes
   /// sure that the same hdfs file is not linked twice. The mtime is used ensure that the
-  /// cached hdfs_file that's used is the most recent.
+  /// cached hdfs_file that's used is the most recent. The module is parsed from the
+  /// bitcode kept by the LibCache, so the local file is not read again.
   Status LinkModuleFromHdfs(const std::string& hdfs_file, const time_t mtime);
 
+  /// Links 'new_module', which was loaded from 'module_name', to the module associated
+  /// with this LlvmCodeGen object.
+  Status LinkModule(std::unique_ptr<llvm::Module> new_module,
+      const std::string& module_name);
+
   /// Strip global constructors and destructors from an LLVM module. We never run them
   /// anyway (they must be explicitly invoked) so it is dead code.
   static void StripGlobalCtorsDtors(llvm::Module* module);
@@ -706,9 +742,50 @@ class LlvmCodeGen {
   /// Optimizes the module. This includes pruning the module of any unused functions.
   Status OptimizeModule();
 
+  /// Runs the internalize pass over 'module', which makes all functions that are not in
+  /// 'fns_to_jit_compile_' internal, and then the global dead code elimination pass,
+  /// which deletes the internal functions that are not used.
+  void PruneModule(llvm::Module* module);
+
+  /// Compiles a copy of the module without optimization passes and with the lowest code
+  /// generation level into 'fast_tier_engine_', which takes a fraction of the time of
+  /// the optimized compilation, and points the function pointers in
+  /// 'fns_to_jit_compile_' to the compiled functions. Must be called after
+  /// FinalizeLazyMaterialization().
+  Status CompileFastTier();
+
   /// Points the function pointers in 'fns_to_jit_compile_' to the compiled functions.
   void SetFunctionPointers();
 
+  /// Returns the number of instructions of 'fn' and of all functions defined in the
+  /// module that it calls or references, directly or indirectly, skipping the functions
+  /// in 'visited'. Adds the counted functions to 'visited'.
+  static int64_t CountReachableInstructions(
+      llvm::Function* fn, std::unordered_set<llvm::Function*>* visited);
+
+  /// Adds the 'TopFunctions' info string to the profile, which lists the
+  /// --codegen_profile_top_n_functions JIT'd functions with the most instructions before
+  /// optimization, their instructions after optimization, and their estimated share of
+  /// the optimization and compile time. The time of the whole module is split in
+  /// proportion to the instructions, since MCJIT compiles the module at once.
+  void AddTopFunctionsInfoString();
+
+  /// Returns the process-wide codegen cache if the compiled code of this module can be
+  /// cached, or null otherwise.
+  CodegenCache* GetCodegenCache() const;
+
+  /// Returns the key of the module in the codegen cache. Must be called after
+  /// FinalizeLazyMaterialization().
+  std::string GetCodegenCacheKey() const;
+
+  /// Points the function pointers in 'fns_to_jit_compile_' to the functions of 'entry'
+  /// and keeps the code of 'entry' alive until Close(). Returns false if 'entry' does
+  /// not have all of the functions.
+  bool SetFunctionPointersFromCache(std::shared_ptr<const CodegenCacheEntry> entry);
+
+  /// Returns the addresses of the compiled functions in 'fns_to_jit_compile_' by name.
+  std::unordered_map<std::string, void*> GetCompiledFunctionPointers() const;
+
   /// Clears generated hash fns.  This is only used for testing.
   void ClearHashFns();
 
@@ -779,6 +856,28 @@ class LlvmCodeGen {
   /// Used for determining dependencies when materializing IR functions.
   static CodegenCallGraph shared_call_graph_;
 
+  /// An Impala IR module that was parsed ahead of time, and the context that owns it.
+  /// Contexts are not thread-safe, so each module has its own, which is handed over to
+  /// the LlvmCodeGen object that uses the module.
+  struct PreparedModule {
+    std::unique_ptr<llvm::LLVMContext> context;
+    std::unique_ptr<llvm::Module> module;
+  };
+
+  /// Moves a module from 'prepared_modules_' to 'prepared' and wakes up
+  /// 'prepare_modules_thread_' to replace it. Returns false if there is none.
+  static bool TakePreparedModule(PreparedModule* prepared);
+
+  /// The modules that 'prepare_modules_thread_' parsed, which fragments take in
+  /// CreateFromMemory() instead of parsing the Impala IR on their critical path. Only
+  /// used if --codegen_prepared_modules is positive. Protected by
+  /// 'prepared_modules_lock_'. 'prepared_modules_cv_' is signalled when a module is
+  /// taken.
+  static std::mutex prepared_modules_lock_;
+  static std::condition_variable prepared_modules_cv_;
+  static std::deque<PreparedModule> prepared_modules_;
+  static std::unique_ptr<Thread> prepare_modules_thread_;
+
   /// Pointer to the FragmentState which owns this codegen object. Needed in
   /// InlineConstFnAttr() to access the query options.
   const FragmentState* state_;
@@ -810,6 +909,9 @@ class LlvmCodeGen {
   /// Time spent compiling the module.
   RuntimeProfile::Counter* compile_timer_;
 
+  /// Time spent compiling the fast tier of the module.
+  RuntimeProfile::Counter* fast_tier_compile_timer_;
+
   /// Total codegen time spent in the main thread.
   RuntimeProfile::Counter* main_thread_timer_;
 
@@ -824,6 +926,12 @@ class LlvmCodeGen {
   RuntimeProfile::Counter* num_functions_;
   RuntimeProfile::Counter* num_instructions_;
 
+  /// The instructions reachable from each function in 'fns_to_jit_compile_', by index,
+  /// before and after optimization. Only filled in if OptimizeModule() runs and
+  /// --codegen_profile_top_n_functions is positive.
+  std::vector<int64_t> jit_fn_insts_before_opt_;
+  std::vector<int64_t> jit_fn_insts_after_opt_;
+
   /// Aggregated llvm thread counters. Also includes the phase represented by
   /// 'ir_generation_timer_' and hence is also updated by FragmentInstanceState.
   RuntimeProfile::ThreadCounters* llvm_thread_counters_;
@@ -843,6 +951,14 @@ class LlvmCodeGen {
   /// functions after this point.
   bool is_compiled_;
 
+  /// If true, functions of native UDFs are mapped to their addresses in the loaded
+  /// libraries, which the compiled code depends on, so the code is not cached.
+  bool has_native_fn_mappings_;
+
+  /// If true, FinalizeModule() first compiles the fast tier. Set by
+  /// FinalizeModuleAsync().
+  bool compile_fast_tier_;
+
   /// Error string that llvm will write to
   std::string error_string_;
 
@@ -854,12 +970,23 @@ class LlvmCodeGen {
   /// module_ is set by Init(). module_ is owned by execution_engine_.
   llvm::Module* module_;
 
-  /// Execution/Jitting engine.
-  std::unique_ptr<llvm::ExecutionEngine> execution_engine_;
+  /// Execution/Jitting engine. Shared with the codegen cache once the compiled code of
+  /// the module is added to it.
+  std::shared_ptr<llvm::ExecutionEngine> execution_engine_;
+
+  /// The entry of the codegen cache whose code the function pointers point to, if the
+  /// module was found in the cache. Keeps the code alive until Close().
+  std::shared_ptr<const CodegenCacheEntry> cached_code_;
 
   /// The memory manager used by 'execution_engine_'. Owned by 'execution_engine_'.
   ImpalaMCJITMemoryManager* memory_manager_;
 
+  /// The engine that owns the code compiled by CompileFastTier() and its memory
+  /// manager. The code may still be running after the function pointers are switched to
+  /// the optimized code, so it is kept until Close().
+  std::unique_ptr<llvm::ExecutionEngine> fast_tier_engine_;
+  ImpalaMCJITMemoryManager* fast_tier_memory_manager_;
+
   /// Functions parsed from pre-compiled module. Indexed by ImpalaIR::Function enum.
   std::vector<llvm::Function*> cross_compiled_functions_;
 
@@ -141,6 +141,13 @@ class AtomicPtr {
   ALWAYS_INLINE T* Swap(T* val) {
     return reinterpret_cast<T*>(ptr_.Swap(reinterpret_cast<intptr_t>(val)));
   }
+
+  /// Atomically replace 'old_val' with 'new_val'. Returns true if the pointer was
+  /// 'old_val'. Has "barrier" memory-ordering semantic.
+  ALWAYS_INLINE bool CompareAndSwap(T* old_val, T* new_val) {
+    return ptr_.CompareAndSwap(
+        reinterpret_cast<intptr_t>(old_val), reinterpret_cast<intptr_t>(new_val));
+  }
  private:
   internal::AtomicInt<intptr_t> ptr_;
 };
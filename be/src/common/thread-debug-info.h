@@ -29,6 +29,8 @@
 
 namespace impala {
 
+struct LockContentionCounters;
+
 /// Stores information about the current thread that can be useful in a debug session.
 /// An object of this class needs to be allocated on the stack in order to include
 /// it in minidumps. While this object is alive, it is available through the global
@@ -57,6 +59,9 @@ public:
   int64_t GetSystemThreadId() const { return system_thread_id_; }
   int64_t GetParentSystemThreadId() const { return parent_.system_thread_id_; }
   const char* GetParentThreadName() const { return parent_.thread_name_; }
+  LockContentionCounters* GetLockContentionCounters() const {
+    return lock_contention_counters_;
+  }
 
   /// Saves 'query_id' to member 'query_id_'
   void SetQueryId(const TUniqueId& query_id) {
@@ -67,6 +72,12 @@ public:
     instance_id_ = instance_id;
   }
 
+  /// Sets the counters that the lock contention of the thread is attributed to. The
+  /// counters are not inherited by child threads, which may outlive them.
+  void SetLockContentionCounters(LockContentionCounters* counters) {
+    lock_contention_counters_ = counters;
+  }
+
   /// Saves param 'thread_name' to member 'thread_name_'.
   /// If the length of param 'thread_name' is larger than THREAD_NAME_SIZE,
   /// we store the front of 'thread_name' + '...' + the last few bytes
@@ -121,6 +132,8 @@ private:
   // part of query or instance execution.
   TUniqueId query_id_;
   TUniqueId instance_id_;
+  // Counters of the query of the thread, if any. Not owned.
+  LockContentionCounters* lock_contention_counters_ = nullptr;
 
   friend class ScopedThreadContext;
   friend class ThreadDebugInfo_Scoping_Test;
@@ -126,6 +126,19 @@ TEST(ValidWriteIdListTest, IsWriteIdRangeValid) {
   EXPECT_EQ(ValidWriteIdList::NONE, write_id_list.IsWriteIdRangeValid(1100, 1200));
   EXPECT_EQ(ValidWriteIdList::SOME, write_id_list.IsWriteIdRangeValid(900, 1100));
   EXPECT_EQ(ValidWriteIdList::ALL, write_id_list.IsWriteIdRangeValid(90, 950));
+
+  // Invalid write ids may be unsorted and contain duplicates.
+  write_id_list.InitFrom(MakeTValidWriteIdList(100, {30, 12, 11, 30, 10, 90}));
+  EXPECT_EQ(ValidWriteIdList::NONE, write_id_list.IsWriteIdRangeValid(10, 12));
+  EXPECT_EQ(ValidWriteIdList::NONE, write_id_list.IsWriteIdRangeValid(30, 30));
+  EXPECT_EQ(ValidWriteIdList::SOME, write_id_list.IsWriteIdRangeValid(9, 12));
+  EXPECT_EQ(ValidWriteIdList::SOME, write_id_list.IsWriteIdRangeValid(10, 13));
+  EXPECT_EQ(ValidWriteIdList::SOME, write_id_list.IsWriteIdRangeValid(91, 101));
+  EXPECT_EQ(ValidWriteIdList::ALL, write_id_list.IsWriteIdRangeValid(13, 29));
+  EXPECT_EQ(ValidWriteIdList::ALL, write_id_list.IsWriteIdRangeValid(91, 100));
+  EXPECT_EQ(ValidWriteIdList::NONE, write_id_list.IsWriteIdRangeValid(101, 200));
+  EXPECT_FALSE(write_id_list.IsWriteIdValid(11));
+  EXPECT_TRUE(write_id_list.IsWriteIdValid(13));
 }
 
 TEST(ValidWriteIdListTest, IsFileRangeValid) {
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <regex>
 
 #include "exec/acid-metadata-utils.h"
@@ -133,35 +134,36 @@ void ValidWriteIdList::InitFrom(const TValidWriteIdList& valid_write_ids) {
   } else {
     high_water_mark_ = std::numeric_limits<int64_t>::max();
   }
-  invalid_write_ids_.clear();
-  for (int64_t invalid_write_id : valid_write_ids.invalid_write_ids) {
-    invalid_write_ids_.insert(invalid_write_id);
-  }
+  invalid_write_ids_ = valid_write_ids.invalid_write_ids;
+  std::sort(invalid_write_ids_.begin(), invalid_write_ids_.end());
+  invalid_write_ids_.erase(
+      std::unique(invalid_write_ids_.begin(), invalid_write_ids_.end()),
+      invalid_write_ids_.end());
 }
 
 bool ValidWriteIdList::IsWriteIdValid(int64_t write_id) const {
   if (write_id > high_water_mark_) {
     return false;
   }
-  return invalid_write_ids_.find(write_id) == invalid_write_ids_.end();
+  return !std::binary_search(
+      invalid_write_ids_.begin(), invalid_write_ids_.end(), write_id);
 }
 
 ValidWriteIdList::RangeResponse ValidWriteIdList::IsWriteIdRangeValid(
     int64_t min_write_id, int64_t max_write_id) const {
+  if (min_write_id > max_write_id) return ALL;
   if (max_write_id <= high_water_mark_ && invalid_write_ids_.empty()) return ALL;
-
-  bool found_valid = false;
-  bool found_invalid = false;
-  for (int64_t i = min_write_id; i <= max_write_id; ++i) {
-    if (IsWriteIdValid(i)) {
-      found_valid = true;
-    } else {
-      found_invalid = true;
-    }
-    if (found_valid && found_invalid) return SOME;
-  }
-  if (found_invalid) return NONE;
-  return ALL;
+  // Write ids above the high water mark are invalid.
+  if (min_write_id > high_water_mark_) return NONE;
+  int64_t max_below_hwm = std::min(max_write_id, high_water_mark_);
+  // Number of invalid write ids in [min_write_id, max_below_hwm].
+  auto begin = invalid_write_ids_.begin();
+  auto end = invalid_write_ids_.end();
+  uint64_t num_invalid = std::upper_bound(begin, end, max_below_hwm) -
+      std::lower_bound(begin, end, min_write_id);
+  if (num_invalid == 0) return max_below_hwm == max_write_id ? ALL : SOME;
+  uint64_t range_size = static_cast<uint64_t>(max_below_hwm) - min_write_id + 1;
+  return num_invalid == range_size ? NONE : SOME;
 }
 
 ValidWriteIdList::RangeResponse ValidWriteIdList::IsFileRangeValid(
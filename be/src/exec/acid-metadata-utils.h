@@ -19,7 +19,7 @@
 
 #include <limits>
 #include <string>
-#include <unordered_set>
+#include <vector>
 
 namespace impala {
 
@@ -42,12 +42,18 @@ public:
   void InitFrom(const TValidWriteIdList& valid_write_ids);
 
   bool IsWriteIdValid(int64_t write_id) const;
+
+  /// Returns whether none, some or all write ids of [min_write_id, max_write_id] are
+  /// valid. Takes logarithmic time in the number of invalid write ids, so it can be
+  /// called for every ORC batch.
   RangeResponse IsWriteIdRangeValid(int64_t min_write_id, int64_t max_write_id) const;
   RangeResponse IsFileRangeValid(const std::string& file_path) const;
 private:
   void AddInvalidWriteIds(const std::string& invalid_ids_str);
   int64_t high_water_mark_ = std::numeric_limits<int64_t>::max();
-  std::unordered_set<int64_t> invalid_write_ids_;
+  /// The open and aborted write ids below the high water mark, sorted and without
+  /// duplicates.
+  std::vector<int64_t> invalid_write_ids_;
 };
 
 }
@@ -37,6 +37,7 @@
 
 static const int MAX_TUPLE_POOL_SIZE = 8 * 1024 * 1024; // 8MB
 static const int MIN_REQUIRED_BUFFERS = 2;
+static const int64_t MIN_WINDOW_TREE_CAPACITY = 16;
 
 using namespace strings;
 
@@ -172,11 +173,24 @@ Status AnalyticEvalNode::Prepare(RuntimeState* state) {
   prev_tuple_pool_.reset(new MemPool(mem_tracker()));
   prev_input_tuple_pool_.reset(new MemPool(mem_tracker()));
   evaluation_timer_ = ADD_TIMER(runtime_profile(), "EvaluationTime");
+  partition_rows_counter_ =
+      ADD_SUMMARY_STATS_COUNTER(runtime_profile(), "PartitionRows", TUnit::UNIT);
 
   DCHECK_EQ(result_tuple_desc_->slots().size(), analytic_fns_.size());
   RETURN_IF_ERROR(AggFnEvaluator::Create(analytic_fns_, state, pool_, expr_perm_pool(),
       expr_results_pool(), &analytic_fn_evals_));
 
+  if (fn_scope_ == ROWS && window_.__isset.window_start) {
+    // Rows leaving the window cannot be removed from the intermediate values of fns
+    // without a Remove() fn, so these are computed from the tree over the window.
+    for (int i = 0; i < analytic_fns_.size(); ++i) {
+      if (!analytic_fns_[i]->SupportsRemove() && analytic_fns_[i]->SupportsMerge()) {
+        window_tree_evals_.push_back(analytic_fn_evals_[i]);
+      }
+    }
+    window_tree_pool_.reset(new MemPool(mem_tracker()));
+  }
+
   if (partition_by_eq_expr_ != nullptr) {
     RETURN_IF_ERROR(ScalarExprEvaluator::Create(*partition_by_eq_expr_, state, pool_,
         expr_perm_pool(), expr_results_pool(), &partition_by_eq_expr_eval_));
@@ -355,6 +369,7 @@ inline Status AnalyticEvalNode::AddRow(int64_t stream_idx, TupleRow* row) {
       Tuple* tuple = row->GetTuple(0)->DeepCopy(
           *child(0)->row_desc()->tuple_descriptors()[0], curr_tuple_pool_.get());
       window_tuples_.emplace_back(stream_idx, tuple);
+      if (!window_tree_evals_.empty()) WindowTreePushBack(row);
     }
   }
 
@@ -380,12 +395,114 @@ inline Status AnalyticEvalNode::AddRow(int64_t stream_idx, TupleRow* row) {
   return Status::OK();
 }
 
+void AnalyticEvalNode::WindowTreeResetTuple(Tuple* tuple) {
+  for (AggFnEvaluator* eval : window_tree_evals_) {
+    eval->Finalize(tuple, dummy_result_tuple_);
+    eval->Init(tuple);
+  }
+}
+
+void AnalyticEvalNode::WindowTreeRecomputeNode(int64_t node_idx) {
+  DCHECK_GT(node_idx, 0);
+  DCHECK_LT(node_idx, window_tree_capacity_);
+  Tuple* node = window_tree_[node_idx];
+  WindowTreeResetTuple(node);
+  for (AggFnEvaluator* eval : window_tree_evals_) {
+    eval->Merge(window_tree_[2 * node_idx], node);
+    eval->Merge(window_tree_[2 * node_idx + 1], node);
+  }
+}
+
+void AnalyticEvalNode::WindowTreeUpdatePath(int64_t node_idx) {
+  for (int64_t i = node_idx / 2; i > 0; i /= 2) WindowTreeRecomputeNode(i);
+}
+
+void AnalyticEvalNode::WindowTreeGrow() {
+  DCHECK_EQ(window_tree_size_, window_tree_capacity_);
+  const int64_t old_capacity = window_tree_capacity_;
+  const int64_t capacity = max(2 * old_capacity, MIN_WINDOW_TREE_CAPACITY);
+  vector<Tuple*> tree(2 * capacity, nullptr);
+  // Reuse the old inner nodes, which are recomputed below, and move the old leaves to
+  // the start of the new leaves so that the ring begins at the first leaf.
+  for (int64_t i = 1; i < old_capacity; ++i) tree[i] = window_tree_[i];
+  for (int64_t i = 0; i < old_capacity; ++i) {
+    tree[capacity + i] =
+        window_tree_[old_capacity + ((window_tree_head_ + i) & (old_capacity - 1))];
+  }
+  for (int64_t i = 1; i < 2 * capacity; ++i) {
+    if (tree[i] != nullptr) continue;
+    tree[i] = Tuple::Create(intermediate_tuple_desc_->byte_size(),
+        window_tree_pool_.get());
+    for (AggFnEvaluator* eval : window_tree_evals_) eval->Init(tree[i]);
+  }
+  window_tree_.swap(tree);
+  window_tree_capacity_ = capacity;
+  window_tree_head_ = 0;
+  for (int64_t i = capacity - 1; i > 0; --i) WindowTreeRecomputeNode(i);
+}
+
+void AnalyticEvalNode::WindowTreePushBack(const TupleRow* row) {
+  if (window_tree_size_ == window_tree_capacity_) WindowTreeGrow();
+  int64_t leaf_idx = window_tree_capacity_ +
+      ((window_tree_head_ + window_tree_size_) & (window_tree_capacity_ - 1));
+  // Leaves that are not in use are initialized and empty.
+  Tuple* leaf = window_tree_[leaf_idx];
+  for (AggFnEvaluator* eval : window_tree_evals_) eval->Add(row, leaf);
+  ++window_tree_size_;
+  WindowTreeUpdatePath(leaf_idx);
+}
+
+void AnalyticEvalNode::WindowTreePopFront() {
+  DCHECK_GT(window_tree_size_, 0);
+  int64_t leaf_idx = window_tree_capacity_ + window_tree_head_;
+  WindowTreeResetTuple(window_tree_[leaf_idx]);
+  window_tree_head_ = (window_tree_head_ + 1) & (window_tree_capacity_ - 1);
+  --window_tree_size_;
+  WindowTreeUpdatePath(leaf_idx);
+}
+
+void AnalyticEvalNode::WindowTreeClear() {
+  while (window_tree_size_ > 0) WindowTreePopFront();
+  window_tree_head_ = 0;
+}
+
+void AnalyticEvalNode::WindowTreeEvaluate() {
+  WindowTreeResetTuple(curr_tuple_);
+  // Merges the nodes that exactly cover the leaves [begin, end) into 'curr_tuple_'.
+  auto merge_leaves = [this](int64_t begin, int64_t end) {
+    for (begin += window_tree_capacity_, end += window_tree_capacity_; begin < end;
+         begin /= 2, end /= 2) {
+      if (begin & 1) {
+        for (AggFnEvaluator* eval : window_tree_evals_) {
+          eval->Merge(window_tree_[begin], curr_tuple_);
+        }
+        ++begin;
+      }
+      if (end & 1) {
+        --end;
+        for (AggFnEvaluator* eval : window_tree_evals_) {
+          eval->Merge(window_tree_[end], curr_tuple_);
+        }
+      }
+    }
+  };
+  int64_t begin = window_tree_head_;
+  int64_t end = window_tree_head_ + window_tree_size_;
+  // The window may wrap around the end of the ring.
+  if (end > window_tree_capacity_) {
+    merge_leaves(0, end - window_tree_capacity_);
+    end = window_tree_capacity_;
+  }
+  merge_leaves(begin, end);
+}
+
 Status AnalyticEvalNode::AddResultTuple(int64_t stream_idx) {
   VLOG_ROW << id() << " AddResultTuple idx=" << stream_idx;
   DCHECK(curr_tuple_ != nullptr);
   MemPool* curr_tuple_pool = curr_tuple_pool_.get();
   Tuple* result_tuple = Tuple::Create(result_tuple_desc_->byte_size(), curr_tuple_pool);
 
+  if (!window_tree_evals_.empty()) WindowTreeEvaluate();
   AggFnEvaluator::GetValue(analytic_fn_evals_, curr_tuple_, result_tuple);
   // Copy any string data in 'result_tuple' into 'curr_tuple_pool'. The var-len data
   // returned by GetValue() may be backed by an allocation from
@@ -453,6 +570,7 @@ inline void AnalyticEvalNode::TryRemoveRowsBeforeWindow(int64_t stream_idx) {
   TupleRow* remove_row = reinterpret_cast<TupleRow*>(&window_tuples_.front().second);
   AggFnEvaluator::Remove(analytic_fn_evals_, remove_row, curr_tuple_);
   window_tuples_.pop_front();
+  if (!window_tree_evals_.empty()) WindowTreePopFront();
 }
 
 inline Status AnalyticEvalNode::TryAddRemainingResults(int64_t partition_idx,
@@ -495,6 +613,7 @@ inline Status AnalyticEvalNode::TryAddRemainingResults(int64_t partition_idx,
       TupleRow* remove_row = reinterpret_cast<TupleRow*>(&window_tuples_.front().second);
       AggFnEvaluator::Remove(analytic_fn_evals_, remove_row, curr_tuple_);
       window_tuples_.pop_front();
+      if (!window_tree_evals_.empty()) WindowTreePopFront();
     }
     RETURN_IF_ERROR(AddResultTuple(last_result_idx_ + 1));
   }
@@ -514,6 +633,9 @@ inline Status AnalyticEvalNode::InitNextPartition(RuntimeState* state,
   DCHECK_LT(curr_partition_idx_, stream_idx);
   int64_t prev_partition_stream_idx = curr_partition_idx_;
   curr_partition_idx_ = stream_idx;
+  if (prev_partition_stream_idx >= 0) {
+    partition_rows_counter_->UpdateCounter(stream_idx - prev_partition_stream_idx);
+  }
 
   // If the window has an end bound preceding the current row, we will have output tuples
   // for rows beyond the previous partition, so they should be removed.  Because
@@ -555,6 +677,7 @@ inline Status AnalyticEvalNode::InitNextPartition(RuntimeState* state,
     RETURN_IF_ERROR(TryAddRemainingResults(stream_idx, prev_partition_stream_idx));
   }
   window_tuples_.clear();
+  WindowTreeClear();
 
   VLOG_ROW << id() << " Reset curr_tuple";
   // Call finalize to release resources; result is not needed but the dst tuple must be
@@ -702,6 +825,7 @@ Status AnalyticEvalNode::ProcessChildBatch(RuntimeState* state) {
   if (UNLIKELY(input_eos_ && stream_idx > curr_partition_idx_)) {
     // We need to add the results for the last row(s).
     RETURN_IF_ERROR(TryAddRemainingResults(stream_idx, curr_partition_idx_));
+    partition_rows_counter_->UpdateCounter(stream_idx - curr_partition_idx_);
   }
 
   // Transfer resources to prev_tuple_pool_ when enough resources have accumulated
@@ -840,6 +964,7 @@ Status AnalyticEvalNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool*
 Status AnalyticEvalNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   result_tuples_.clear();
   window_tuples_.clear();
+  WindowTreeClear();
   last_result_idx_ = -1;
   curr_partition_idx_ = -1;
   prev_pool_last_result_idx_ = -1;
@@ -883,6 +1008,12 @@ void AnalyticEvalNode::Close(RuntimeState* state) {
   if (curr_tuple_init_)  {
     AggFnEvaluator::Finalize(analytic_fn_evals_, curr_tuple_, dummy_result_tuple_);
   }
+  for (Tuple* node : window_tree_) {
+    if (node == nullptr) continue;
+    for (AggFnEvaluator* eval : window_tree_evals_) {
+      eval->Finalize(node, dummy_result_tuple_);
+    }
+  }
   AggFnEvaluator::Close(analytic_fn_evals_, state);
 
   if (partition_by_eq_expr_eval_ != nullptr) partition_by_eq_expr_eval_->Close(state);
@@ -891,6 +1022,7 @@ void AnalyticEvalNode::Close(RuntimeState* state) {
   if (curr_tuple_pool_.get() != nullptr) curr_tuple_pool_->FreeAll();
   if (prev_tuple_pool_.get() != nullptr) prev_tuple_pool_->FreeAll();
   if (prev_input_tuple_pool_.get() != nullptr) prev_input_tuple_pool_->FreeAll();
+  if (window_tree_pool_ != nullptr) window_tree_pool_->FreeAll();
   ExecNode::Close(state);
 }
 
@@ -43,6 +43,10 @@ class AnalyticEvalPlanNode : public PlanNode {
   /// Analytic functions which live in the runtime-state's objpool.
   std::vector<AggFn*> analytic_fns_;
 
+  /// The evaluators of the analytic fns that are evaluated with 'window_tree_'. Non-empty
+  /// only for ROWS windows with a start bound. Set in Prepare().
+  std::vector<AggFnEvaluator*> window_tree_evals_;
+
   /// Indicates if each evaluator is the lead() fn. Used by ResetLeadFnSlots() to
   /// determine which slots need to be reset.
   std::vector<bool> is_lead_fn_;
@@ -83,6 +87,11 @@ class AnalyticEvalPlanNode : public PlanNode {
 /// multiple rows have the same values for the order by exprs. The number of buffered
 /// rows may be an entire partition or even the entire input. Therefore, the output
 /// rows are buffered and may spill to disk via the BufferedTupleStream.
+///
+/// Partitions are evaluated one after the other by the fragment instance's thread, since
+/// the evaluators and the current result tuple are shared by all partitions. The
+/// "PartitionRows" counter reports the number of input rows of each partition, which
+/// shows when a few large partitions dominate the running time of the node.
 
 class AnalyticEvalNode : public ExecNode {
  public:
@@ -131,7 +140,9 @@ class AnalyticEvalNode : public ExecNode {
     /// rows are buffered in window_tuples_ because they must later be removed from the
     /// window (by calling AggFnEvaluator::Remove() with the expired tuple to remove it
     /// from the current row). When either the start or end boundaries are offset from the
-    /// current row, there is special casing around partition boundaries.
+    /// current row, there is special casing around partition boundaries. Functions that
+    /// cannot Remove() but can Merge(), e.g. min() and max(), are instead evaluated with
+    /// a segment tree over the tuples in window_tuples_ (see 'window_tree_').
     ROWS
   };
 
@@ -185,6 +196,35 @@ class AnalyticEvalNode : public ExecNode {
   /// current input row from input_stream_.
   Status InitNextPartition(RuntimeState* state, int64_t stream_idx);
 
+  /// Appends a leaf for 'row' to 'window_tree_', i.e. a tuple with the intermediate
+  /// values of 'window_tree_evals_' after adding only 'row'. Grows the tree if it is
+  /// full. Called for every tuple added to 'window_tuples_'.
+  void WindowTreePushBack(const TupleRow* row);
+
+  /// Resets the leaf of the oldest tuple in the window. Called for every tuple removed
+  /// from the front of 'window_tuples_'.
+  void WindowTreePopFront();
+
+  /// Resets all leaves in use, e.g. at the start of a new partition.
+  void WindowTreeClear();
+
+  /// Sets the slots of 'window_tree_evals_' in 'curr_tuple_' to the merged intermediate
+  /// values of all rows in the window. Only touches O(log n) nodes of the tree.
+  void WindowTreeEvaluate();
+
+  /// Doubles the capacity of 'window_tree_' while keeping the leaves in window order.
+  void WindowTreeGrow();
+
+  /// Recomputes inner node 'node_idx' of 'window_tree_' from its children.
+  void WindowTreeRecomputeNode(int64_t node_idx);
+
+  /// Recomputes the inner nodes on the path from node 'node_idx' to the root.
+  void WindowTreeUpdatePath(int64_t node_idx);
+
+  /// Releases any memory of the slots of 'window_tree_evals_' in 'tuple' and
+  /// re-initializes them.
+  void WindowTreeResetTuple(Tuple* tuple);
+
   /// Produces a result tuple with analytic function results by calling GetValue() or
   /// Finalize() for 'curr_tuple_' on the 'evaluators'. The result tuple is stored in
   /// 'result_tuples_' with the index into 'input_stream_' specified by 'stream_idx'.
@@ -371,11 +411,28 @@ class AnalyticEvalNode : public ExecNode {
   /// True when there are no more input rows to consume from our child.
   bool input_eos_ = false;
 
+  /// Segment tree over the intermediate values of 'window_tree_evals_' for the tuples in
+  /// 'window_tuples_', so that the value of a sliding window can be computed without
+  /// Remove(). Node 1 is the root, the children of node i are nodes 2i and 2i + 1 and
+  /// the leaves are the nodes [window_tree_capacity_, 2 * window_tree_capacity_). Each
+  /// inner node holds the Merge() of its children. The leaves form a ring buffer of the
+  /// window: the 'window_tree_size_' leaves starting at 'window_tree_head_' hold the
+  /// tuples of 'window_tuples_' in the same order and all other leaves are initialized
+  /// but empty. Tuples are owned by 'window_tree_pool_'.
+  std::vector<Tuple*> window_tree_;
+  int64_t window_tree_capacity_ = 0;
+  int64_t window_tree_head_ = 0;
+  int64_t window_tree_size_ = 0;
+  std::unique_ptr<MemPool> window_tree_pool_;
+
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
   /// Time spent processing the child rows.
   RuntimeProfile::Counter* evaluation_timer_ = nullptr;
+
+  /// The number of input rows of each partition, to show skew between partitions.
+  RuntimeProfile::SummaryStatsCounter* partition_rows_counter_ = nullptr;
 };
 
 }
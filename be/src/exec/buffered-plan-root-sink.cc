@@ -54,7 +54,8 @@ Status BufferedPlanRootSink::Open(RuntimeState* state) {
   // max_spilled_result_spooling_mem = 0 means unbounded.
   if (max_spilled_mem <= 0) max_spilled_mem = INT64_MAX;
   batch_queue_.reset(new SpillableRowBatchQueue(name_, max_spilled_mem, state,
-      mem_tracker(), profile(), row_desc_, resource_profile_, debug_options_));
+      mem_tracker(), profile(), row_desc_, resource_profile_, debug_options_,
+      state->query_options().spool_query_results_compression));
   RETURN_IF_ERROR(batch_queue_->Open());
   return Status::OK();
 }
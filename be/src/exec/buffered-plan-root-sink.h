@@ -32,7 +32,9 @@ class DequeRowBatchQueue;
 /// 'full' when the amount of spilled data exceeds the configured limit). Any subsequent
 /// calls to Send will block until the 'consumer' (coordinator) thread has read enough
 /// RowBatches to free up sufficient space in the queue. The blocking behavior follows
-/// the same semantics as BlockingPlanRootSink.
+/// the same semantics as BlockingPlanRootSink. With SPOOL_QUERY_RESULTS_COMPRESSION, the
+/// queue keeps the RowBatches compressed in memory, so that more rows fit before it
+/// spills.
 ///
 /// FlushFinal() blocks until the consumer has read all RowBatches from the queue or
 /// until the sink is either closed or cancelled. This ensures that the coordinator
@@ -34,6 +34,7 @@
 #include "runtime/string-value.h"
 #include "runtime/timestamp-value.inline.h"
 #include "runtime/tuple-row.h"
+#include "util/bit-util.h"
 #include "util/jni-util.h"
 #include "util/periodic-counter-updater.h"
 #include "util/runtime-profile-counters.h"
@@ -66,6 +67,19 @@ const string ERROR_INVALID_DECIMAL = "Data source returned invalid decimal data.
     "This likely indicates a problem with the data source library.";
 const string ERROR_MEM_LIMIT_EXCEEDED = "DataSourceScanNode::$0() failed to allocate "
     "$1 bytes for $2.";
+const string ERROR_MIXED_COLUMN_LAYOUTS = "Data source returned columns in the Arrow "
+    "columnar layout together with other columns. This likely indicates a problem with "
+    "the data source library.";
+const string ERROR_COLUMNAR_NUM_ROWS = "Data source returned columns in the Arrow "
+    "columnar layout without setting the number of rows. This likely indicates a "
+    "problem with the data source library.";
+// $0 = column type (e.g. INT)
+const string ERROR_INVALID_COLUMNAR_DATA = "Data source returned inconsistent column "
+    "data in the Arrow columnar layout for a column of type $0. This likely indicates a "
+    "problem with the data source library.";
+
+const string GET_NEXT_TIMER = "DataSourceGetNextTime";
+const string COLUMNAR_BATCHES_COUNTER = "NumColumnarInputBatches";
 
 // Size of an encoded TIMESTAMP
 const size_t TIMESTAMP_SIZE = sizeof(int64_t) + sizeof(int32_t);
@@ -93,6 +107,9 @@ Status DataSourceScanNode::Prepare(RuntimeState* state) {
       data_src_node_.init_string));
 
   cols_next_val_idx_.resize(tuple_desc_->slots().size(), 0);
+  get_next_timer_ = ADD_TIMER(runtime_profile(), GET_NEXT_TIMER);
+  columnar_batches_counter_ =
+      ADD_COUNTER(runtime_profile(), COLUMNAR_BATCHES_COUNTER, TUnit::UNIT);
   return Status::OK();
 }
 
@@ -137,6 +154,22 @@ Status DataSourceScanNode::ValidateRowBatchSize() {
         Substitute(ERROR_NUM_COLUMNS, tuple_desc_->slots().size(), cols.size()));
   }
 
+  int num_columnar_cols = 0;
+  for (const TColumnData& col_data : cols) {
+    if (col_data.__isset.arrow_values) ++num_columnar_cols;
+  }
+  input_batch_is_columnar_ = num_columnar_cols > 0;
+  if (input_batch_is_columnar_) {
+    if (num_columnar_cols != cols.size()) return Status(ERROR_MIXED_COLUMN_LAYOUTS);
+    if (!input_batch_->rows.__isset.num_rows || input_batch_->rows.num_rows < 0) {
+      return Status(ERROR_COLUMNAR_NUM_ROWS);
+    }
+    num_rows_ = input_batch_->rows.num_rows;
+    for (int i = 0; i < cols.size(); ++i) RETURN_IF_ERROR(ValidateColumnarColumn(i));
+    COUNTER_ADD(columnar_batches_counter_, 1);
+    return Status::OK();
+  }
+
   num_rows_ = -1;
   // If num_rows was set, use that, otherwise we set it to be the number of rows in
   // the first TColumnData and then ensure the number of rows in other columns are
@@ -157,7 +190,10 @@ Status DataSourceScanNode::GetNextInputBatch() {
   Ubsan::MemSet(cols_next_val_idx_.data(), 0, sizeof(int) * cols_next_val_idx_.size());
   TGetNextParams params;
   params.__set_scan_handle(scan_handle_);
-  RETURN_IF_ERROR(data_source_executor_->GetNext(params, input_batch_.get()));
+  {
+    SCOPED_TIMER(get_next_timer_);
+    RETURN_IF_ERROR(data_source_executor_->GetNext(params, input_batch_.get()));
+  }
   RETURN_IF_ERROR(Status(input_batch_->status));
   RETURN_IF_ERROR(ValidateRowBatchSize());
   if (!InputBatchHasNext() && !input_batch_->eos) {
@@ -321,6 +357,228 @@ Status DataSourceScanNode::MaterializeNextRow(const Timezone* local_tz,
   return Status::OK();
 }
 
+/// Returns the width in bytes of the values of 'type' in the Arrow columnar layout, or 0
+/// for BOOLEAN and STRING, which are not fixed-width.
+static int ColumnarValueWidth(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_TINYINT: return 1;
+    case TYPE_SMALLINT: return 2;
+    case TYPE_INT:
+    case TYPE_FLOAT:
+    case TYPE_DATE:
+      return 4;
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+    case TYPE_TIMESTAMP:
+      return 8;
+    case TYPE_DECIMAL: return 16;
+    default: return 0;
+  }
+}
+
+Status DataSourceScanNode::ValidateColumnarColumn(int col_idx) {
+  const ColumnType& type = tuple_desc_->slots()[col_idx]->type();
+  const TColumnData& col = input_batch_->rows.cols[col_idx];
+  const int64_t num_bitmap_bytes = BitUtil::Ceil(num_rows_, 8);
+  const int64_t values_size = col.arrow_values.size();
+  bool valid = !col.__isset.arrow_validity
+      || static_cast<int64_t>(col.arrow_validity.size()) >= num_bitmap_bytes;
+  if (type.type == TYPE_BOOLEAN) {
+    valid &= values_size >= num_bitmap_bytes;
+  } else if (type.type == TYPE_STRING) {
+    // The offsets of every row are checked when the column is materialized.
+    valid &= col.__isset.arrow_offsets
+        && static_cast<int64_t>(col.arrow_offsets.size())
+            == (num_rows_ + 1) * static_cast<int64_t>(sizeof(int32_t));
+  } else {
+    int width = ColumnarValueWidth(type);
+    DCHECK_GT(width, 0) << type.DebugString();
+    valid &= values_size >= static_cast<int64_t>(num_rows_) * width;
+  }
+  if (!valid) return Status(Substitute(ERROR_INVALID_COLUMNAR_DATA, type.DebugString()));
+  return Status::OK();
+}
+
+/// Copies 'num_rows' values of type 'T' from 'values' into the slots at 'slot_offset' of
+/// the consecutive tuples of size 'tuple_size' at 'tuple_mem'.
+template <typename T>
+static void CopyFixedWidthValues(const char* values, int num_rows, int slot_offset,
+    int tuple_size, uint8_t* tuple_mem) {
+  uint8_t* slot = tuple_mem + slot_offset;
+  for (int i = 0; i < num_rows; ++i) {
+    memcpy(slot, values + i * sizeof(T), sizeof(T));
+    slot += tuple_size;
+  }
+}
+
+/// Reads the little-endian value of type 'T' at index 'idx' of 'values'.
+template <typename T>
+static T ReadColumnarValue(const char* values, int idx) {
+  T value;
+  memcpy(&value, values + idx * sizeof(T), sizeof(T));
+  return value;
+}
+
+Status DataSourceScanNode::MaterializeColumn(int col_idx, const Timezone* local_tz,
+    MemPool* tuple_pool, int num_rows, uint8_t* tuple_mem) {
+  const SlotDescriptor* slot_desc = tuple_desc_->slots()[col_idx];
+  const TColumnData& col = input_batch_->rows.cols[col_idx];
+  const int tuple_size = tuple_desc_->byte_size();
+  const int slot_offset = slot_desc->tuple_offset();
+  const int start_row = next_row_idx_;
+  const ColumnType& type = slot_desc->type();
+  const char* values =
+      col.arrow_values.data() + start_row * ColumnarValueWidth(type);
+  switch (type.type) {
+    case TYPE_TINYINT:
+      CopyFixedWidthValues<int8_t>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_SMALLINT:
+      CopyFixedWidthValues<int16_t>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_INT:
+      CopyFixedWidthValues<int32_t>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_BIGINT:
+      CopyFixedWidthValues<int64_t>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_FLOAT:
+      CopyFixedWidthValues<float>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_DOUBLE:
+      CopyFixedWidthValues<double>(values, num_rows, slot_offset, tuple_size, tuple_mem);
+      break;
+    case TYPE_BOOLEAN: {
+      const uint8_t* bitmap = reinterpret_cast<const uint8_t*>(col.arrow_values.data());
+      for (int i = 0; i < num_rows; ++i) {
+        int row = start_row + i;
+        *reinterpret_cast<int8_t*>(tuple_mem + i * tuple_size + slot_offset) =
+            BitUtil::GetBit(bitmap[row / 8], row % 8);
+      }
+      break;
+    }
+    case TYPE_DATE:
+      for (int i = 0; i < num_rows; ++i) {
+        *reinterpret_cast<DateValue*>(tuple_mem + i * tuple_size + slot_offset) =
+            DateValue(ReadColumnarValue<int32_t>(values, i));
+      }
+      break;
+    case TYPE_TIMESTAMP:
+      for (int i = 0; i < num_rows; ++i) {
+        *reinterpret_cast<TimestampValue*>(tuple_mem + i * tuple_size + slot_offset) =
+            TimestampValue::FromUnixTimeMicros(
+                ReadColumnarValue<int64_t>(values, i), local_tz);
+      }
+      break;
+    case TYPE_DECIMAL: {
+      const int byte_size = type.GetByteSize();
+      for (int i = 0; i < num_rows; ++i) {
+        __int128_t value = ReadColumnarValue<__int128_t>(values, i);
+        uint8_t* slot = tuple_mem + i * tuple_size + slot_offset;
+        if (byte_size == 4) {
+          if (UNLIKELY(value != static_cast<int32_t>(value))) {
+            return Status(ERROR_INVALID_DECIMAL);
+          }
+          *reinterpret_cast<int32_t*>(slot) = value;
+        } else if (byte_size == 8) {
+          if (UNLIKELY(value != static_cast<int64_t>(value))) {
+            return Status(ERROR_INVALID_DECIMAL);
+          }
+          *reinterpret_cast<int64_t*>(slot) = value;
+        } else {
+          DCHECK_EQ(byte_size, 16);
+          memcpy(slot, &value, sizeof(value));
+        }
+      }
+      break;
+    }
+    case TYPE_STRING: {
+      // Copy the values of all rows with a single allocation.
+      const char* offsets = col.arrow_offsets.data();
+      int32_t start_offset = ReadColumnarValue<int32_t>(offsets, start_row);
+      int32_t end_offset = ReadColumnarValue<int32_t>(offsets, start_row + num_rows);
+      if (UNLIKELY(start_offset < 0 || end_offset < start_offset
+              || end_offset > static_cast<int64_t>(col.arrow_values.size()))) {
+        return Status(Substitute(ERROR_INVALID_COLUMNAR_DATA, "STRING"));
+      }
+      int64_t total_size = end_offset - start_offset;
+      char* buffer = nullptr;
+      if (total_size > 0) {
+        buffer = reinterpret_cast<char*>(tuple_pool->TryAllocateUnaligned(total_size));
+        if (UNLIKELY(buffer == nullptr)) {
+          string details = Substitute(ERROR_MEM_LIMIT_EXCEEDED, "MaterializeColumn",
+              total_size, "string slots");
+          return tuple_pool->mem_tracker()->MemLimitExceeded(
+              nullptr, details, total_size);
+        }
+        memcpy(buffer, col.arrow_values.data() + start_offset, total_size);
+      }
+      int32_t offset = start_offset;
+      for (int i = 0; i < num_rows; ++i) {
+        int32_t next_offset = ReadColumnarValue<int32_t>(offsets, start_row + i + 1);
+        if (UNLIKELY(next_offset < offset || next_offset > end_offset)) {
+          return Status(Substitute(ERROR_INVALID_COLUMNAR_DATA, "STRING"));
+        }
+        StringValue* slot =
+            reinterpret_cast<StringValue*>(tuple_mem + i * tuple_size + slot_offset);
+        slot->ptr = buffer + (offset - start_offset);
+        slot->len = next_offset - offset;
+        offset = next_offset;
+      }
+      break;
+    }
+    default:
+      DCHECK(false) << type.DebugString();
+  }
+
+  if (col.__isset.arrow_validity) {
+    const uint8_t* validity = reinterpret_cast<const uint8_t*>(col.arrow_validity.data());
+    const NullIndicatorOffset& null_offset = slot_desc->null_indicator_offset();
+    for (int i = 0; i < num_rows; ++i) {
+      int row = start_row + i;
+      if (BitUtil::GetBit(validity[row / 8], row % 8)) continue;
+      reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size)->SetNull(null_offset);
+    }
+  }
+  return Status::OK();
+}
+
+Status DataSourceScanNode::MaterializeColumnarRows(const Timezone* local_tz,
+    RowBatch* row_batch, Tuple** tuple, int64_t* rows_read) {
+  int num_rows = min<int64_t>(
+      num_rows_ - next_row_idx_, row_batch->capacity() - row_batch->num_rows());
+  const int tuple_size = tuple_desc_->byte_size();
+  uint8_t* tuple_mem = reinterpret_cast<uint8_t*>(*tuple);
+  memset(tuple_mem, 0, num_rows * tuple_size);
+  for (int i = 0; i < tuple_desc_->slots().size(); ++i) {
+    RETURN_IF_ERROR(MaterializeColumn(
+        i, local_tz, row_batch->tuple_data_pool(), num_rows, tuple_mem));
+  }
+  next_row_idx_ += num_rows;
+  *rows_read += num_rows;
+
+  // Evaluate the conjuncts and compact the surviving tuples, so that the tuple buffer
+  // is used by the committed rows only.
+  ScalarExprEvaluator* const* evals = conjunct_evals_.data();
+  int num_conjuncts = conjuncts_.size();
+  uint8_t* dst = tuple_mem;
+  for (int i = 0; i < num_rows && !ReachedLimit(); ++i) {
+    Tuple* src = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_size);
+    TupleRow* tuple_row = row_batch->GetRow(row_batch->AddRow());
+    tuple_row->SetTuple(tuple_idx_, src);
+    if (!ExecNode::EvalConjuncts(evals, num_conjuncts, tuple_row)) continue;
+    if (dst != reinterpret_cast<uint8_t*>(src)) {
+      memcpy(dst, src, tuple_size);
+      tuple_row->SetTuple(tuple_idx_, reinterpret_cast<Tuple*>(dst));
+    }
+    row_batch->CommitLastRow();
+    dst += tuple_size;
+    IncrementNumRowsReturned(1);
+  }
+  *tuple = reinterpret_cast<Tuple*>(dst);
+  return Status::OK();
+}
+
 Status DataSourceScanNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
   ScopedGetNextEventAdder ea(this, eos);
@@ -344,16 +602,21 @@ Status DataSourceScanNode::GetNext(RuntimeState* state, RowBatch* row_batch, boo
   int num_conjuncts = conjuncts_.size();
   DCHECK_EQ(num_conjuncts, conjunct_evals_.size());
   int64_t rows_read = 0;
+  // TODO The timezone depends on flag use_local_tz_for_unix_timestamp_conversions.
+  //      Check if this is the intended behaviour.
+  const Timezone* local_tz = state->time_zone_for_unix_time_conversions();
 
   while (true) {
     {
       SCOPED_TIMER(materialize_tuple_timer());
       // copy rows until we hit the limit/capacity or until we exhaust input_batch_
       while (!ReachedLimit() && !row_batch->AtCapacity() && InputBatchHasNext()) {
-        // TODO The timezone depends on flag use_local_tz_for_unix_timestamp_conversions.
-        //      Check if this is the intended behaviour.
-        RETURN_IF_ERROR(MaterializeNextRow(
-            state->time_zone_for_unix_time_conversions(), tuple_pool, tuple));
+        if (input_batch_is_columnar_) {
+          RETURN_IF_ERROR(
+              MaterializeColumnarRows(local_tz, row_batch, &tuple, &rows_read));
+          continue;
+        }
+        RETURN_IF_ERROR(MaterializeNextRow(local_tz, tuple_pool, tuple));
         ++rows_read;
         int row_idx = row_batch->AddRow();
         TupleRow* tuple_row = row_batch->GetRow(row_idx);
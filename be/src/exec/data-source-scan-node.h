@@ -98,10 +98,38 @@ class DataSourceScanNode : public ScanNode {
   /// the next row batch.
   std::vector<int> cols_next_val_idx_;
 
+  /// True if the columns of input_batch_ are in the Arrow columnar layout, see
+  /// TColumnData.arrow_values.
+  bool input_batch_is_columnar_ = false;
+
+  /// Time spent in the data source's GetNext(), including the transfer of the rows
+  /// through JNI.
+  RuntimeProfile::Counter* get_next_timer_ = nullptr;
+
+  /// Number of row batches that the data source returned in the Arrow columnar layout.
+  RuntimeProfile::Counter* columnar_batches_counter_ = nullptr;
+
   /// Materializes the next row (next_row_idx_) into tuple. 'local_tz' is used as the
   /// local time-zone for materializing 'TYPE_TIMESTAMP' slots.
   Status MaterializeNextRow(const Timezone* local_tz, MemPool* mem_pool, Tuple* tuple);
 
+  /// Materializes as many rows of the columnar input_batch_, starting at next_row_idx_,
+  /// as fit into 'row_batch' into the tuples starting at '*tuple', one column at a
+  /// time. Adds the rows that pass the conjuncts to 'row_batch', compacting their
+  /// tuples, and advances '*tuple' past the last one. Adds the number of materialized
+  /// rows to '*rows_read'. 'local_tz' is used like in MaterializeNextRow().
+  Status MaterializeColumnarRows(const Timezone* local_tz, RowBatch* row_batch,
+      Tuple** tuple, int64_t* rows_read);
+
+  /// Materializes 'num_rows' values of column 'col_idx' of the columnar input_batch_,
+  /// starting at next_row_idx_, into the consecutive tuples at 'tuple_mem'.
+  Status MaterializeColumn(int col_idx, const Timezone* local_tz, MemPool* tuple_pool,
+      int num_rows, uint8_t* tuple_mem);
+
+  /// Validates that the buffers of column 'col_idx' of the columnar input_batch_ are
+  /// large enough for num_rows_ rows.
+  Status ValidateColumnarColumn(int col_idx);
+
   /// Gets the next batch from the data source, stored in input_batch_.
   Status GetNextInputBatch();
 
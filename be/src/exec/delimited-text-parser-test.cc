@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <random>
 #include <string>
 
 #include "exec/delimited-text-parser.inline.h"
@@ -215,6 +216,86 @@ TEST(DelimitedTextParser, SpecialDelimiters) {
   Validate(&nul_field_parser, field2, 5, TUPLE_DELIM, 3, 6);
 }
 
+/// The output of parsing a buffer with ParseFieldLocations(), as offsets into the buffer.
+struct ParseResult {
+  vector<int64_t> row_ends;
+  vector<pair<int64_t, int32_t>> fields;
+  bool operator==(const ParseResult& other) const {
+    return row_ends == other.row_ends && fields == other.fields;
+  }
+};
+
+/// Parses all of 'data' with calls to ParseFieldLocations() that return at most
+/// 'max_tuples' tuples each.
+ParseResult ParseAll(TupleDelimitedTextParser* parser, const string& data,
+    int num_cols, int max_tuples) {
+  parser->ParserReset();
+  ParseResult result;
+  char* data_ptr = const_cast<char*>(data.data());
+  char* data_end = data_ptr + data.size();
+  vector<char*> row_end_locs(max_tuples);
+  vector<FieldLocation> field_locations((max_tuples + 1) * num_cols);
+  while (data_ptr < data_end) {
+    int num_tuples = 0;
+    int num_fields = 0;
+    char* next_column_start;
+    Status status = parser->ParseFieldLocations(max_tuples, data_end - data_ptr,
+        &data_ptr, row_end_locs.data(), field_locations.data(), &num_tuples,
+        &num_fields, &next_column_start);
+    EXPECT_OK(status);
+    for (int i = 0; i < num_tuples; ++i) {
+      result.row_ends.push_back(row_end_locs[i] - data.data());
+    }
+    for (int i = 0; i < num_fields; ++i) {
+      result.fields.emplace_back(
+          field_locations[i].start - data.data(), field_locations[i].len);
+    }
+  }
+  return result;
+}
+
+// Test that the AVX2 and AVX-512 kernels find the same fields and tuples as the SSE and
+// scalar code, in particular for escape characters and \r\n at block boundaries.
+TEST(DelimitedTextParser, WideKernels) {
+  const int NUM_COLS = 4;
+  bool is_materialized_col[NUM_COLS];
+  for (int i = 0; i < NUM_COLS; ++i) is_materialized_col[i] = true;
+  TupleDelimitedTextParser no_escape_parser(
+      NUM_COLS, 0, is_materialized_col, '\n', ',', ':');
+  TupleDelimitedTextParser escape_parser(
+      NUM_COLS, 0, is_materialized_col, '\n', ',', ':', '\\');
+
+  std::mt19937 rng(1234);
+  const string chars = "abcdefgh,,::\n\r\\\\";
+  for (int iter = 0; iter < 50; ++iter) {
+    string data;
+    const int len = rng() % 1000;
+    for (int i = 0; i < len; ++i) data += chars[rng() % chars.size()];
+    for (TupleDelimitedTextParser* parser : {&no_escape_parser, &escape_parser}) {
+      for (int max_tuples : {1, 7, 1000}) {
+        ParseResult scalar_result;
+        ParseResult sse_result;
+        ParseResult avx2_result;
+        {
+          CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+          CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+          sse_result = ParseAll(parser, data, NUM_COLS, max_tuples);
+          CpuInfo::TempDisable disable_sse(CpuInfo::SSE4_2);
+          scalar_result = ParseAll(parser, data, NUM_COLS, max_tuples);
+        }
+        {
+          CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+          avx2_result = ParseAll(parser, data, NUM_COLS, max_tuples);
+        }
+        ParseResult result = ParseAll(parser, data, NUM_COLS, max_tuples);
+        EXPECT_TRUE(sse_result == scalar_result) << data;
+        EXPECT_TRUE(avx2_result == scalar_result) << data;
+        EXPECT_TRUE(result == scalar_result) << data;
+      }
+    }
+  }
+}
+
 // TODO: expand test for other delimited text parser functions/cases.
 // Not all of them work without creating a HdfsScanNode but we can expand
 // these tests quite a bit more.
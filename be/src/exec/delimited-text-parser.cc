@@ -17,6 +17,10 @@
 
 #include "exec/delimited-text-parser.inline.h"
 
+#ifndef __aarch64__
+  #include <immintrin.h>
+#endif
+
 #include "exec/hdfs-scanner.h"
 #include "util/cpu-info.h"
 
@@ -24,6 +28,45 @@
 
 using namespace impala;
 
+#ifndef __aarch64__
+
+__attribute__((target("avx2")))
+void impala::FindDelimitersAVX2(const char* buffer, const char* delims,
+    char escape_char, uint64_t* delim_mask, uint64_t* escape_mask) {
+  const __m256i d0 = _mm256_set1_epi8(delims[0]);
+  const __m256i d1 = _mm256_set1_epi8(delims[1]);
+  const __m256i d2 = _mm256_set1_epi8(delims[2]);
+  const __m256i d3 = _mm256_set1_epi8(delims[3]);
+  const __m256i e = _mm256_set1_epi8(escape_char);
+  uint64_t delims_found = 0;
+  uint64_t escapes_found = 0;
+  for (int i = 0; i < 2; ++i) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer) + i);
+    const __m256i eq = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, d0), _mm256_cmpeq_epi8(v, d1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, d2), _mm256_cmpeq_epi8(v, d3)));
+    delims_found |= static_cast<uint64_t>(
+        static_cast<uint32_t>(_mm256_movemask_epi8(eq))) << (32 * i);
+    escapes_found |= static_cast<uint64_t>(static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, e)))) << (32 * i);
+  }
+  *delim_mask = delims_found;
+  *escape_mask = escapes_found;
+}
+
+__attribute__((target("avx512bw")))
+void impala::FindDelimitersAVX512(const char* buffer, const char* delims,
+    char escape_char, uint64_t* delim_mask, uint64_t* escape_mask) {
+  const __m512i v = _mm512_loadu_si512(buffer);
+  *delim_mask = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(delims[0]))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(delims[1]))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(delims[2]))
+      | _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(delims[3]));
+  *escape_mask = _mm512_cmpeq_epi8_mask(v, _mm512_set1_epi8(escape_char));
+}
+
+#endif
+
 template<bool DELIMITED_TUPLES>
 DelimitedTextParser<DELIMITED_TUPLES>::DelimitedTextParser(
     int num_cols, int num_partition_keys, const bool* is_materialized_col,
@@ -91,7 +134,11 @@ DelimitedTextParser<DELIMITED_TUPLES>::DelimitedTextParser(
   if (collection_item_delim != '\0') search_chars[num_delims_++] = collection_item_delim_;
 
   DCHECK_GT(num_delims_, 0);
+  DCHECK_LE(num_delims_, sizeof(delim_chars_));
   xmm_delim_search_ = _mm_loadu_si128(reinterpret_cast<__m128i*>(search_chars));
+  for (int i = 0; i < sizeof(delim_chars_); ++i) {
+    delim_chars_[i] = search_chars[i < num_delims_ ? i : 0];
+  }
 
   ParserReset();
 }
@@ -132,6 +179,28 @@ Status DelimitedTextParser<DELIMITED_TUPLES>::ParseFieldLocations(int max_tuples
     last_row_delim_offset_ = -1;
   }
 
+#ifndef __aarch64__
+  FindDelimitersFn find_fn = nullptr;
+  if (CpuInfo::IsSupported(CpuInfo::AVX512BW)) {
+    find_fn = FindDelimitersAVX512;
+  } else if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    find_fn = FindDelimitersAVX2;
+  }
+  if (find_fn != nullptr) {
+    if (process_escapes_) {
+      RETURN_IF_ERROR(ParseWide<true>(find_fn, max_tuples, &remaining_len,
+          byte_buffer_ptr, row_end_locations, field_locations, num_tuples, num_fields,
+          next_column_start));
+    } else {
+      RETURN_IF_ERROR(ParseWide<false>(find_fn, max_tuples, &remaining_len,
+          byte_buffer_ptr, row_end_locations, field_locations, num_tuples, num_fields,
+          next_column_start));
+    }
+    if (*num_tuples == max_tuples) return Status::OK();
+  }
+#endif
+
+  // The remaining characters of the wide search are handled 16 at a time.
   if (CpuInfo::IsSupported(CpuInfo::SSE4_2)) {
     if (process_escapes_) {
       RETURN_IF_ERROR(ParseSse<true>(max_tuples, &remaining_len, byte_buffer_ptr,
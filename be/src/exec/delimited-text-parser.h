@@ -25,6 +25,23 @@
 
 namespace impala {
 
+/// The number of characters that the AVX2 and AVX-512 delimiter search functions
+/// process at a time.
+static const int CHARS_PER_DELIMITER_BLOCK = 64;
+
+/// Sets bit i of 'delim_mask' if character i of the CHARS_PER_DELIMITER_BLOCK characters
+/// at 'buffer' is one of the 4 'delims', and bit i of 'escape_mask' if it is
+/// 'escape_char'.
+typedef void (*FindDelimitersFn)(const char* buffer, const char* delims,
+    char escape_char, uint64_t* delim_mask, uint64_t* escape_mask);
+
+/// Implementations of FindDelimitersFn with AVX2 and AVX-512BW instructions. Must only
+/// be called if the CPU supports them.
+void FindDelimitersAVX2(const char* buffer, const char* delims, char escape_char,
+    uint64_t* delim_mask, uint64_t* escape_mask);
+void FindDelimitersAVX512(const char* buffer, const char* delims, char escape_char,
+    uint64_t* delim_mask, uint64_t* escape_mask);
+
 template <bool DELIMITED_TUPLES>
 class DelimitedTextParser {
  public:
@@ -169,6 +186,15 @@ class DelimitedTextParser {
       FieldLocation* field_locations,
       int* num_tuples, int* num_fields, char** next_column_start);
 
+  /// Like ParseSse(), but processes CHARS_PER_DELIMITER_BLOCK characters at a time.
+  /// The delimiters and escape characters of each block are found with 'find_fn'.
+  /// Stops when fewer than CHARS_PER_DELIMITER_BLOCK characters are left.
+  template <bool PROCESS_ESCAPES>
+  Status ParseWide(FindDelimitersFn find_fn, int max_tuples, int64_t* remaining_len,
+      char** byte_buffer_ptr, char** row_end_locations_,
+      FieldLocation* field_locations,
+      int* num_tuples, int* num_fields, char** next_column_start);
+
   bool IsFieldOrCollectionItemDelimiter(char c) {
     return (!DELIMITED_TUPLES && c == field_delim_) ||
       (DELIMITED_TUPLES && field_delim_ != tuple_delim_ && c == field_delim_) ||
@@ -194,6 +220,10 @@ class DelimitedTextParser {
   /// The number of delimiters contained in xmm_delim_search_, i.e. its length.
   int num_delims_;
 
+  /// The delimiters of xmm_delim_search_ for FindDelimitersFn. Unused entries repeat
+  /// the first delimiter.
+  char delim_chars_[4];
+
   /// Number of columns in the table (including partition columns)
   int num_cols_;
 
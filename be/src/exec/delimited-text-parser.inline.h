@@ -52,6 +52,34 @@ inline void ProcessEscapeMask(uint16_t escape_mask, bool* last_char_is_escape,
   *delim_mask &= ~escape_mask;
 }
 
+/// Same as ProcessEscapeMask() for a block of 64 characters. The loop only visits the
+/// escape characters, which are rare in most data.
+inline void ProcessEscapeMask64(uint64_t escape_mask, bool* last_char_is_escape,
+    uint64_t* delim_mask) {
+  // Bit i is set if the character at i is escaped.
+  uint64_t escaped = *last_char_is_escape ? 1 : 0;
+  // Escape characters that are escaped themselves do not escape the next character.
+  uint64_t unescaped_escapes = escape_mask & ~escaped;
+  *last_char_is_escape = false;
+  while (unescaped_escapes != 0) {
+    int n = __builtin_ctzll(unescaped_escapes);
+    unescaped_escapes &= unescaped_escapes - 1;
+    if (n == 63) {
+      *last_char_is_escape = true;
+      break;
+    }
+    escaped |= 1ULL << (n + 1);
+    unescaped_escapes &= ~(1ULL << (n + 1));
+  }
+  *delim_mask &= ~escaped;
+}
+
+/// Returns a mask of the bits [low, high] of a 64 bit mask.
+inline uint64_t BitRangeMask64(int low, int high) {
+  DCHECK_LE(low, high);
+  return (~0ULL << low) & (~0ULL >> (63 - high));
+}
+
 template <bool DELIMITED_TUPLES>
 template <bool PROCESS_ESCAPES>
 inline Status DelimitedTextParser<DELIMITED_TUPLES>::AddColumn(int64_t len,
@@ -232,6 +260,93 @@ inline Status DelimitedTextParser<DELIMITED_TUPLES>::ParseSse(int max_tuples,
   return Status::OK();
 }
 
+template <bool DELIMITED_TUPLES>
+template <bool PROCESS_ESCAPES>
+inline Status DelimitedTextParser<DELIMITED_TUPLES>::ParseWide(FindDelimitersFn find_fn,
+    int max_tuples, int64_t* remaining_len, char** byte_buffer_ptr,
+    char** row_end_locations, FieldLocation* field_locations,
+    int* num_tuples, int* num_fields, char** next_column_start) {
+  while (LIKELY(*remaining_len >= CHARS_PER_DELIMITER_BLOCK)) {
+    uint64_t delim_mask;
+    uint64_t escape_mask;
+    find_fn(*byte_buffer_ptr, delim_chars_, escape_char_, &delim_mask, &escape_mask);
+    if (PROCESS_ESCAPES) {
+      DCHECK(escape_char_ != '\0');
+      ProcessEscapeMask64(escape_mask, &last_char_is_escape_, &delim_mask);
+    }
+
+    char* last_char = *byte_buffer_ptr + CHARS_PER_DELIMITER_BLOCK - 1;
+    bool last_char_is_unescaped_delim = delim_mask >> (CHARS_PER_DELIMITER_BLOCK - 1);
+    if (DELIMITED_TUPLES) {
+      unfinished_tuple_ = !(last_char_is_unescaped_delim &&
+          (*last_char == tuple_delim_ || (tuple_delim_ == '\n' && *last_char == '\r')));
+    }
+
+    int last_col_idx = 0;
+    // Process all non-zero bits in the delim_mask from lsb->msb.
+    while (delim_mask != 0) {
+      int n = __builtin_ctzll(delim_mask);
+      // clear current bit
+      delim_mask &= delim_mask - 1;
+
+      if (PROCESS_ESCAPES) {
+        // Determine if there was an escape character between [last_col_idx, n]
+        bool escaped = (escape_mask & BitRangeMask64(last_col_idx, n)) != 0;
+        current_column_has_escape_ |= escaped;
+        last_col_idx = n;
+      }
+
+      char* delim_ptr = *byte_buffer_ptr + n;
+
+      if (IsFieldOrCollectionItemDelimiter(*delim_ptr)) {
+        RETURN_IF_ERROR(AddColumn<PROCESS_ESCAPES>(delim_ptr - *next_column_start,
+            next_column_start, num_fields, field_locations));
+        continue;
+      }
+
+      if (DELIMITED_TUPLES &&
+          (*delim_ptr == tuple_delim_ || (tuple_delim_ == '\n' && *delim_ptr == '\r'))) {
+        if (UNLIKELY(
+                last_row_delim_offset_ == *remaining_len - n && *delim_ptr == '\n')) {
+          // If the row ended in \r\n then move the next start past the \n
+          ++*next_column_start;
+          last_row_delim_offset_ = -1;
+          continue;
+        }
+        RETURN_IF_ERROR(AddColumn<PROCESS_ESCAPES>(delim_ptr - *next_column_start,
+            next_column_start, num_fields, field_locations));
+        Status status = FillColumns<false>(0, NULL, num_fields, field_locations);
+        DCHECK(status.ok());
+        column_idx_ = num_partition_keys_;
+        row_end_locations[*num_tuples] = delim_ptr;
+        ++(*num_tuples);
+        // Remember where we saw the last \r.
+        last_row_delim_offset_ = *delim_ptr == '\r' ? *remaining_len - n - 1 : -1;
+        if (UNLIKELY(*num_tuples == max_tuples)) {
+          (*byte_buffer_ptr) += (n + 1);
+          if (PROCESS_ESCAPES) last_char_is_escape_ = false;
+          *remaining_len -= (n + 1);
+          // If the last character we processed was \r then set the offset to 0
+          // so that we will use it at the beginning of the next batch.
+          if (last_row_delim_offset_ == *remaining_len) last_row_delim_offset_ = 0;
+          return Status::OK();
+        }
+      }
+    }
+
+    if (PROCESS_ESCAPES) {
+      // Determine if there was an escape character between (last_col_idx, 63)
+      bool unprocessed_escape = (escape_mask
+          & BitRangeMask64(last_col_idx, CHARS_PER_DELIMITER_BLOCK - 1)) != 0;
+      current_column_has_escape_ |= unprocessed_escape;
+    }
+
+    *remaining_len -= CHARS_PER_DELIMITER_BLOCK;
+    *byte_buffer_ptr += CHARS_PER_DELIMITER_BLOCK;
+  }
+  return Status::OK();
+}
+
 /// Simplified version of ParseSSE which does not handle tuple delimiters.
 template<>
 template <bool PROCESS_ESCAPES>
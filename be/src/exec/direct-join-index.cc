@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exec/direct-join-index.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "exec/hash-table.inline.h"
+#include "exprs/scalar-expr.h"
+#include "runtime/mem-tracker.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+bool DirectJoinIndex::CanIndex(const vector<ScalarExpr*>& build_exprs,
+    const vector<bool>& is_not_distinct_from) {
+  return build_exprs.size() == 1 && build_exprs[0]->type().IsIntegerType()
+      && !is_not_distinct_from[0];
+}
+
+template <typename Fn>
+void DirectJoinIndex::ForEachKey(HashTableCtx* ht_ctx, HashTable* hash_tbl, Fn fn) const {
+  HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
+  for (int64_t bucket_idx = 0; bucket_idx < hash_tbl->num_buckets(); ++bucket_idx) {
+    TupleRow* row = hash_tbl->BucketRow(bucket_idx, ht_ctx->scratch_row());
+    if (row == nullptr) continue;
+    expr_vals_cache->Reset();
+    // Rows with a NULL key are not stored, since NULLs do not match.
+    bool has_key = ht_ctx->EvalAndHashBuild(row);
+    DCHECK(has_key);
+    fn(KeyValue(ht_ctx->ExprValue(0)), bucket_idx);
+  }
+  expr_vals_cache->Reset();
+}
+
+bool DirectJoinIndex::Init(const ScalarExpr& build_expr, HashTableCtx* ht_ctx,
+    const vector<HashTable*>& hash_tbls, int64_t max_entries, MemTracker* mem_tracker) {
+  DCHECK(mem_tracker_ == nullptr);
+  key_bytes_ = build_expr.type().GetByteSize();
+  DCHECK(key_bytes_ == 1 || key_bytes_ == 2 || key_bytes_ == 4 || key_bytes_ == 8)
+      << key_bytes_;
+  int64_t num_keys = 0;
+  int64_t min_key = numeric_limits<int64_t>::max();
+  int64_t max_key = numeric_limits<int64_t>::min();
+  for (HashTable* hash_tbl : hash_tbls) {
+    if (hash_tbl == nullptr) continue;
+    // Each bucket index must fit into an entry.
+    if (hash_tbl->num_buckets() > numeric_limits<int32_t>::max()) return false;
+    ForEachKey(ht_ctx, hash_tbl, [&](int64_t key, int64_t bucket_idx) {
+      ++num_keys;
+      min_key = min(min_key, key);
+      max_key = max(max_key, key);
+    });
+  }
+  if (num_keys == 0) return false;
+  uint64_t range = static_cast<uint64_t>(max_key) - static_cast<uint64_t>(min_key) + 1;
+  if (range == 0 || range > static_cast<uint64_t>(max_entries)
+      || range > static_cast<uint64_t>(num_keys) * MAX_ENTRIES_PER_KEY) {
+    return false;
+  }
+  if (!mem_tracker->TryConsume(range * sizeof(int32_t))) return false;
+  mem_tracker_ = mem_tracker;
+  min_key_ = min_key;
+  buckets_.resize(range, EMPTY_ENTRY);
+  for (HashTable* hash_tbl : hash_tbls) {
+    if (hash_tbl == nullptr) continue;
+    ForEachKey(ht_ctx, hash_tbl, [&](int64_t key, int64_t bucket_idx) {
+      uint64_t offset = static_cast<uint64_t>(key) - static_cast<uint64_t>(min_key_);
+      DCHECK_EQ(buckets_[offset], EMPTY_ENTRY) << "Keys are unique across buckets";
+      buckets_[offset] = bucket_idx;
+    });
+  }
+  return true;
+}
+
+void DirectJoinIndex::Close() {
+  if (mem_tracker_ == nullptr) return;
+  mem_tracker_->Release(buckets_.size() * sizeof(int32_t));
+  vector<int32_t>().swap(buckets_);
+  mem_tracker_ = nullptr;
+}
+}
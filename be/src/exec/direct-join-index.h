@@ -0,0 +1,112 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "exec/hash-table.h"
+
+namespace impala {
+
+class MemTracker;
+class ScalarExpr;
+
+/// Maps the keys of a hash join on a single integer key to the hash table buckets that
+/// hold the build rows with each key. When the build keys are dense, i.e. they cover
+/// most values between their minimum and their maximum, the index is an array of bucket
+/// indices indexed by the key minus the minimum key. A probe row is looked up by
+/// reading one array entry, instead of probing the buckets of its hash and comparing
+/// its key with the build rows in them.
+///
+/// The index is built from the hash tables of all in-memory partitions of a level 0
+/// join build. The probe side still hashes its rows to find their partition. Since
+/// equal keys hash to the same partition, the bucket of an entry is valid for the hash
+/// table of the partition of any probe row that matches it.
+///
+/// The index is read-only once it is built, so several probe threads can share it.
+class DirectJoinIndex {
+ public:
+  /// Returns true if a join on 'build_exprs' can be indexed: there is a single build
+  /// expr of an integer type whose NULLs do not match.
+  static bool CanIndex(const std::vector<ScalarExpr*>& build_exprs,
+      const std::vector<bool>& is_not_distinct_from);
+
+  /// Builds the index of the rows of 'hash_tbls', which are NULL for partitions that
+  /// are not in memory. Evaluates 'build_expr' for every filled bucket with 'ht_ctx'.
+  /// Returns false if the keys span more than 'max_entries' values, if they are not
+  /// dense enough or if 'mem_tracker' has no room for the index.
+  bool Init(const ScalarExpr& build_expr, HashTableCtx* ht_ctx,
+      const std::vector<HashTable*>& hash_tbls, int64_t max_entries,
+      MemTracker* mem_tracker);
+
+  /// Releases the memory of the index.
+  void Close();
+
+  /// Returns an iterator to the rows of 'hash_tbl' that match the probe row at the
+  /// current position of the ExprValuesCache in 'ht_ctx', like
+  /// HashTable::FindProbeRow(). 'hash_tbl' is the hash table of the row's partition.
+  HashTable::Iterator IR_ALWAYS_INLINE FindProbeRow(
+      HashTable* hash_tbl, HashTableCtx* ht_ctx) const {
+    uint64_t offset = static_cast<uint64_t>(KeyValue(ht_ctx->ExprValue(0)))
+        - static_cast<uint64_t>(min_key_);
+    if (offset >= buckets_.size() || buckets_[offset] == EMPTY_ENTRY) {
+      return hash_tbl->End();
+    }
+    return hash_tbl->BucketIterator(ht_ctx, buckets_[offset]);
+  }
+
+  /// Returns the number of entries of the index.
+  int64_t num_entries() const { return buckets_.size(); }
+
+ private:
+  /// Entry of keys that no build row has.
+  static const int32_t EMPTY_ENTRY = -1;
+
+  /// The index is only built if it has at most this many entries per key.
+  static const int MAX_ENTRIES_PER_KEY = 4;
+
+  /// Returns the key at 'value', which has 'key_bytes_' bytes.
+  int64_t ALWAYS_INLINE KeyValue(const void* value) const {
+    switch (key_bytes_) {
+      case 1: return *reinterpret_cast<const int8_t*>(value);
+      case 2: return *reinterpret_cast<const int16_t*>(value);
+      case 4: return *reinterpret_cast<const int32_t*>(value);
+      default: return *reinterpret_cast<const int64_t*>(value);
+    }
+  }
+
+  /// Calls 'fn' with the key and the bucket index of every filled bucket of
+  /// 'hash_tbl'.
+  template <typename Fn>
+  void ForEachKey(HashTableCtx* ht_ctx, HashTable* hash_tbl, Fn fn) const;
+
+  /// The size of the build key in bytes.
+  int key_bytes_ = 0;
+
+  /// The smallest build key.
+  int64_t min_key_ = 0;
+
+  /// The bucket index of each key minus 'min_key_', or EMPTY_ENTRY.
+  std::vector<int32_t> buckets_;
+
+  /// Tracks the memory of 'buckets_'. Set if the index was built.
+  MemTracker* mem_tracker_ = nullptr;
+};
+}
@@ -27,6 +27,7 @@
 #include "runtime/krpc-data-stream-recvr.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
+#include "runtime/spillable-row-batch-queue.h"
 #include "util/debug-util.h"
 #include "util/runtime-profile-counters.h"
 #include "util/time.h"
@@ -131,17 +132,44 @@ Status ExchangeNode::Open(RuntimeState* state) {
   RETURN_IF_ERROR(ExecNode::Open(state));
   RETURN_IF_CANCELLED(state);
   if (is_merging_) {
-    // CreateMerger() will populate its merging heap with batches from the stream_recvr_,
+    // CreateMerger() will populate its merging tree with batches from the stream_recvr_,
     // so it is not necessary to call FillInputRowBatch().
     RETURN_IF_ERROR(
         less_than_->Open(pool_, state, expr_perm_pool(), expr_results_pool()));
-    RETURN_IF_ERROR(stream_recvr_->CreateMerger(*less_than_.get()));
+    RETURN_IF_ERROR(stream_recvr_->CreateMerger(
+        *less_than_.get(), state->query_options().sort_key_prefix));
   } else {
+    EnableRecvrSpilling(state);
     RETURN_IF_ERROR(FillInputRowBatch(state));
   }
   return Status::OK();
 }
 
+void ExchangeNode::EnableRecvrSpilling(RuntimeState* state) {
+  DCHECK(!is_merging_);
+  const TQueryOptions& query_options = state->query_options();
+  // The planner adds the read and write buffers of the queue to the maximum reservation
+  // of the exchange if EXCHANGE_MAX_SPILLED_MEM is set.
+  if (query_options.exchange_max_spilled_mem <= 0
+      || resource_profile_.max_reservation <= 0) {
+    return;
+  }
+  DCHECK_EQ(resource_profile_.min_reservation, 0);
+  spill_queue_name_ = Substitute("Exchg Spill (id=$0)", id_);
+  spill_queue_.reset(new SpillableRowBatchQueue(spill_queue_name_,
+      query_options.exchange_max_spilled_mem, state, mem_tracker(), runtime_profile(),
+      &input_row_desc_, resource_profile_, debug_options_));
+  Status status = spill_queue_->Open();
+  if (!status.ok()) {
+    // The receiver still works without the queue, it just blocks the senders.
+    VLOG_QUERY << "Not spilling exchange " << id_ << ": " << status.GetDetail();
+    spill_queue_->Close();
+    spill_queue_.reset();
+    return;
+  }
+  stream_recvr_->EnableSpilling(spill_queue_.get());
+}
+
 Status ExchangeNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   DCHECK(false) << "NYI";
   return Status("NYI");
@@ -151,6 +179,8 @@ void ExchangeNode::Close(RuntimeState* state) {
   if (is_closed()) return;
   if (less_than_.get() != nullptr) less_than_->Close(state);
   if (stream_recvr_ != nullptr) stream_recvr_->Close();
+  // The receiver does not access 'spill_queue_' after it is closed.
+  if (spill_queue_ != nullptr) spill_queue_->Close();
   ExecEnv::GetInstance()->buffer_pool()->DeregisterClient(&recvr_buffer_pool_client_);
   ExecNode::Close(state);
 }
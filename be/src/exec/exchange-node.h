@@ -29,6 +29,7 @@ namespace impala {
 class KrpcDataStreamRecvr;
 class RowBatch;
 class ScalarExpr;
+class SpillableRowBatchQueue;
 class TupleRowComparator;
 class TupleRowComparatorConfig;
 
@@ -88,6 +89,12 @@ class ExchangeNode : public ExecNode {
   /// Only used when is_merging_ is false.
   Status FillInputRowBatch(RuntimeState* state);
 
+  /// Creates 'spill_queue_' and lets 'stream_recvr_' spill to it if the
+  /// EXCHANGE_MAX_SPILLED_MEM query option is set. If the queue cannot get the
+  /// reservation for its buffers, the receiver is left as is. Only used when
+  /// is_merging_ is false.
+  void EnableRecvrSpilling(RuntimeState* state);
+
   /// Releases resources of the receiver by transferring the resource ownership of
   /// the most recently dequeued row batch to 'output_batch'. Also cancels the underlying
   /// receiver so all senders will get unblocked. This function is called after the
@@ -120,6 +127,13 @@ class ExchangeNode : public ExecNode {
   /// tuple data in row batches.
   BufferPool::ClientHandle recvr_buffer_pool_client_;
 
+  /// The queue that 'stream_recvr_' spills row batches to instead of blocking the
+  /// senders when its buffer limit is reached. Null if spilling is not enabled. Its
+  /// name is referenced by the queue. The queue uses the resource profile of this node,
+  /// which has no minimum reservation.
+  std::string spill_queue_name_;
+  boost::scoped_ptr<SpillableRowBatchQueue> spill_queue_;
+
   /// time spent reconstructing received rows
   RuntimeProfile::Counter* convert_row_batch_timer_;
 
@@ -160,9 +160,11 @@ Status PlanNode::CreatePlanNode(
       break;
     case TPlanNodeType::HBASE_SCAN_NODE:
     case TPlanNodeType::DATA_SOURCE_NODE:
-    case TPlanNodeType::KUDU_SCAN_NODE:
       *node = pool->Add(new ScanPlanNode());
       break;
+    case TPlanNodeType::KUDU_SCAN_NODE:
+      *node = pool->Add(new KuduScanPlanNode());
+      break;
     case TPlanNodeType::AGGREGATION_NODE:
       *node = pool->Add(new AggregationPlanNode());
       break;
@@ -30,6 +30,7 @@ class Function;
 namespace impala {
 
 class BloomFilter;
+class InListFilter;
 class LlvmCodeGen;
 class MinMaxFilter;
 class RuntimeState;
@@ -103,6 +104,9 @@ struct FilterContext {
   /// Working copy of local min-max filter
   MinMaxFilter* local_min_max_filter = nullptr;
 
+  /// Working copy of local in-list filter
+  InListFilter* local_in_list_filter = nullptr;
+
   /// Struct name in LLVM IR.
   static const char* LLVM_CLASS_NAME;
 
@@ -116,8 +120,8 @@ struct FilterContext {
   /// a match in 'filter'. Returns false otherwise.
   bool Eval(TupleRow* row) const noexcept;
 
-  /// Evaluates 'row' with 'expr_eval' and inserts the value into 'local_bloom_filter'
-  /// or 'local_min_max_filter' as appropriate.
+  /// Evaluates 'row' with 'expr_eval' and inserts the value into 'local_bloom_filter',
+  /// 'local_min_max_filter' or 'local_in_list_filter' as appropriate.
   void Insert(TupleRow* row) const noexcept;
 
   /// Materialize filter values by copying any values stored by filters into memory owned
@@ -133,8 +137,8 @@ struct FilterContext {
 
   /// Codegen Insert() by codegen'ing the expression 'filter_expr', replacing the type
   /// argument to RawValue::GetHashValue() with a constant, and calling into the correct
-  /// version of BloomFilter::Insert() or MinMaxFilter::Insert(), depending on the filter
-  /// desc and if 'local_bloom_filter' or 'local_min_max_filter' are null.
+  /// version of BloomFilter::Insert(), MinMaxFilter::Insert() or InListFilter::Insert(),
+  /// depending on the filter desc and if the local filter of that type is null.
   /// For bloom filters, it also selects the correct Insert() based on the presence of
   /// AVX, and for min-max filters it selects the correct Insert() based on type.
   /// On success, 'fn' is set to the generated function. On failure, an error status is
@@ -190,14 +190,31 @@ Status GroupingAggregator::AddBatchStreamingImpl(int agg_idx, bool needs_seriali
                  GetHashTable(partition_idx), in_row, hash,
                  &remaining_capacity[partition_idx], &add_batch_status_)) {
         RETURN_IF_ERROR(std::move(add_batch_status_));
-        // Tuple is not going into hash table, add it to the output batch.
-        Tuple* intermediate_tuple = ConstructIntermediateTuple(
-            agg_fn_evals_, out_batch->tuple_data_pool(), &add_batch_status_);
-        if (UNLIKELY(intermediate_tuple == nullptr)) {
-          DCHECK(!add_batch_status_.ok());
-          return std::move(add_batch_status_);
+        Tuple* intermediate_tuple;
+        if (first_level_table_.empty()) {
+          // Tuple is not going into hash table, add it to the output batch.
+          intermediate_tuple = ConstructIntermediateTuple(
+              agg_fn_evals_, out_batch->tuple_data_pool(), &add_batch_status_);
+          if (UNLIKELY(intermediate_tuple == nullptr)) {
+            DCHECK(!add_batch_status_.ok());
+            return std::move(add_batch_status_);
+          }
+          UpdateTuple(agg_fn_evals_.data(), intermediate_tuple, in_row);
+        } else {
+          // Aggregate the row in the first-level table. Only the partial aggregate that
+          // it evicts, if any, goes to the output batch.
+          Tuple* first_level_tuple = GetFirstLevelTuple(partition_idx, hash,
+              out_batch->tuple_data_pool(), &intermediate_tuple, &add_batch_status_);
+          if (UNLIKELY(first_level_tuple == nullptr)) {
+            DCHECK(!add_batch_status_.ok());
+            return std::move(add_batch_status_);
+          }
+          UpdateTuple(agg_fn_evals_.data(), first_level_tuple, in_row);
+          if (intermediate_tuple == nullptr) {
+            expr_vals_cache->NextRow();
+            continue;
+          }
         }
-        UpdateTuple(agg_fn_evals_.data(), intermediate_tuple, in_row);
         out_batch_iterator.Get()->SetTuple(agg_idx, intermediate_tuple);
         out_batch_iterator.Next();
         out_batch->CommitLastRow();
@@ -86,8 +86,9 @@ Status GroupingAggregator::Partition::InitHashTable(bool* got_memory) {
   // TODO: we could switch to 64 bit hashes and then we don't need a max size.
   // It might be reasonable to limit individual hash table size for other reasons
   // though. Always start with small buffers.
-  hash_tbl.reset(HashTable::Create(parent->ht_allocator_.get(), false, 1, nullptr,
-      1L << (32 - NUM_PARTITIONING_BITS), PAGG_DEFAULT_HASH_TABLE_SZ));
+  hash_tbl.reset(HashTable::Create(parent->hash_table_config_.group_probing,
+      parent->ht_allocator_.get(), false, 1, nullptr, 1L << (32 - NUM_PARTITIONING_BITS),
+      PAGG_DEFAULT_HASH_TABLE_SZ, parent->hash_table_config_.incremental_resize));
   // Please update the error message in CreateHashPartitions() if initial size of
   // hash table changes.
   Status status = hash_tbl->Init(got_memory);
@@ -117,6 +118,7 @@ Status GroupingAggregator::Partition::SerializeStreamForSpilling() {
     // Serialize and copy the spilled partition's stream into the new stream.
     Status status;
     BufferedTupleStream* new_stream = parent->serialize_stream_.get();
+    hash_tbl->FinishResize(parent->ht_ctx_.get());
     HashTable::Iterator it = hash_tbl->Begin(parent->ht_ctx_.get());
     // Marks if we have used the large write page reservation. We only reclaim it after we
     // finish writing to 'new_stream', because there are no other works interleaving that
@@ -246,6 +248,7 @@ void GroupingAggregator::Partition::Close(bool finalize_rows) {
       // We need to walk all the rows and Finalize them here so the UDA gets a chance
       // to cleanup. If the hash table is gone (meaning this was spilled), the rows
       // should have been finalized/serialized in Spill().
+      hash_tbl->FinishResize(parent->ht_ctx_.get());
       parent->CleanupHashTbl(agg_fn_evals, hash_tbl->Begin(parent->ht_ctx_.get()));
     }
     aggregated_row_stream->Close(nullptr, RowBatch::FlushMode::NO_FLUSH_RESOURCES);
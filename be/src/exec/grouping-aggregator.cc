@@ -23,6 +23,7 @@
 #include "exec/exec-node.h"
 #include "exec/exec-node.inline.h"
 #include "exec/hash-table.inline.h"
+#include "exec/spill-victim-policy.h"
 #include "exprs/agg-fn-evaluator.h"
 #include "exprs/scalar-expr.h"
 #include "exprs/slot-ref.h"
@@ -45,6 +46,8 @@
 
 #include "common/names.h"
 
+DECLARE_bool(suballocator_use_slabs);
+
 namespace impala {
 
 /// The minimum reduction factor (input rows divided by output rows) to grow hash tables
@@ -119,11 +122,36 @@ Status GroupingAggregatorConfig::Init(
 
   hash_table_config_ = state->obj_pool()->Add(new HashTableConfig(
       build_exprs_, grouping_exprs_, true, vector<bool>(build_exprs_.size(), true)));
+
+  // Set up the exprs to sort spilled partitions by their grouping keys. NULL slots
+  // cannot be materialized by SlotRefs, so such partitions are only repartitioned.
+  bool has_null_slots = false;
+  for (const SlotDescriptor* slot_desc : intermediate_tuple_desc_->slots()) {
+    has_null_slots |= slot_desc->type().type == TYPE_NULL;
+  }
+  if (!is_streaming_preagg_ && !has_null_slots) {
+    for (const SlotDescriptor* slot_desc : intermediate_tuple_desc_->slots()) {
+      SlotRef* slot_ref =
+          state->obj_pool()->Add(new SlotRef(slot_desc, slot_desc->type()));
+      spill_sort_tuple_exprs_.push_back(slot_ref);
+      RETURN_IF_ERROR(slot_ref->Init(intermediate_row_desc_, true, state));
+    }
+    spill_sort_key_exprs_.assign(spill_sort_tuple_exprs_.begin(),
+        spill_sort_tuple_exprs_.begin() + grouping_exprs_.size());
+    TSortInfo* tsort_info = state->obj_pool()->Add(new TSortInfo);
+    tsort_info->sorting_order = TSortingOrder::LEXICAL;
+    tsort_info->is_asc_order.resize(spill_sort_key_exprs_.size(), true);
+    tsort_info->nulls_first.resize(spill_sort_key_exprs_.size(), false);
+    spill_sort_comparator_config_ = state->obj_pool()->Add(
+        new TupleRowComparatorConfig(*tsort_info, spill_sort_key_exprs_));
+  }
   return Status::OK();
 }
 
 void GroupingAggregatorConfig::Close() {
   ScalarExpr::Close(build_exprs_);
+  // 'spill_sort_key_exprs_' are a subset of 'spill_sort_tuple_exprs_'.
+  ScalarExpr::Close(spill_sort_tuple_exprs_);
   ScalarExpr::Close(grouping_exprs_);
   AggregatorConfig::Close();
 }
@@ -142,6 +170,9 @@ GroupingAggregator::GroupingAggregator(ExecNode* exec_node, ObjectPool* pool,
     grouping_exprs_(config.grouping_exprs_),
     build_exprs_(config.build_exprs_),
     string_grouping_exprs_(config.string_grouping_exprs_),
+    spill_sort_tuple_exprs_(config.spill_sort_tuple_exprs_),
+    spill_sort_comparator_config_(config.spill_sort_comparator_config_),
+    spill_sort_helper_fn_(config.spill_sort_helper_fn_),
     resource_profile_(config.resource_profile_),
     is_in_subplan_(exec_node->IsInSubplan()),
     limit_(exec_node->limit()),
@@ -172,12 +203,24 @@ Status GroupingAggregator::Prepare(RuntimeState* state) {
         ADD_COUNTER(runtime_profile(), "ReductionFactorEstimate", TUnit::DOUBLE_VALUE);
     preagg_streaming_ht_min_reduction_ = ADD_COUNTER(
         runtime_profile(), "ReductionFactorThresholdToExpand", TUnit::DOUBLE_VALUE);
+    if (state->query_options().preagg_first_level_table) {
+      first_level_hits_counter_ =
+          ADD_COUNTER(runtime_profile(), "FirstLevelTableHits", TUnit::UNIT);
+      first_level_evictions_counter_ =
+          ADD_COUNTER(runtime_profile(), "FirstLevelTableEvictions", TUnit::UNIT);
+    }
   } else {
     num_row_repartitioned_ =
         ADD_COUNTER(runtime_profile(), "RowsRepartitioned", TUnit::UNIT);
     num_repartitions_ = ADD_COUNTER(runtime_profile(), "NumRepartitions", TUnit::UNIT);
+    num_sorted_partitions_ =
+        ADD_COUNTER(runtime_profile(), "SpilledPartitionsSorted", TUnit::UNIT);
     num_spilled_partitions_ =
         ADD_COUNTER(runtime_profile(), "SpilledPartitions", TUnit::UNIT);
+    num_spill_victims_not_largest_ =
+        ADD_COUNTER(runtime_profile(), "SpillVictimsNotLargest", TUnit::UNIT);
+    expected_spill_scratch_bytes_ =
+        ADD_COUNTER(runtime_profile(), "ExpectedSpillScratchBytes", TUnit::BYTES);
     max_partition_level_ =
         runtime_profile()->AddHighWaterMarkCounter("MaxPartitionLevel", TUnit::UNIT);
   }
@@ -241,7 +284,8 @@ Status GroupingAggregator::Open(RuntimeState* state) {
   if (ht_allocator_ == nullptr) {
     // Allocate 'serialize_stream_' and 'ht_allocator_' on the first Open() call.
     ht_allocator_.reset(new Suballocator(ExecEnv::GetInstance()->buffer_pool(),
-        buffer_pool_client(), resource_profile_.spillable_buffer_size));
+        buffer_pool_client(), resource_profile_.spillable_buffer_size,
+        FLAGS_suballocator_use_slabs, runtime_profile()));
 
     if (!is_streaming_preagg_ && needs_serialize_) {
       serialize_stream_.reset(new BufferedTupleStream(state, &intermediate_row_desc_,
@@ -263,7 +307,10 @@ Status GroupingAggregator::Open(RuntimeState* state) {
 
 Status GroupingAggregator::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos) {
   RETURN_IF_ERROR(QueryMaintenance(state));
-  if (!partition_eos_) {
+  if (first_level_output_idx_ < first_level_table_.size()) {
+    GetRowsFromFirstLevelTable(state, row_batch);
+  }
+  if (!partition_eos_ && !row_batch->AtCapacity()) {
     RETURN_IF_ERROR(GetRowsFromPartition(state, row_batch));
   }
   *eos = partition_eos_;
@@ -273,6 +320,7 @@ Status GroupingAggregator::GetNext(RuntimeState* state, RowBatch* row_batch, boo
 Status GroupingAggregator::GetRowsFromPartition(
     RuntimeState* state, RowBatch* row_batch) {
   DCHECK(!row_batch->AtCapacity());
+  if (output_sorted_) return GetRowsFromSortedPartition(state, row_batch);
   if (output_iterator_.AtEnd()) {
     // Done with this partition, move onto the next one.
     if (output_partition_ != nullptr) {
@@ -292,6 +340,7 @@ Status GroupingAggregator::GetRowsFromPartition(
     }
     // Process next partition.
     RETURN_IF_ERROR(NextPartition());
+    if (output_sorted_) return GetRowsFromSortedPartition(state, row_batch);
   }
   DCHECK(output_partition_ != nullptr);
 
@@ -342,6 +391,30 @@ Status GroupingAggregator::GetRowsFromPartition(
   return Status::OK();
 }
 
+void GroupingAggregator::GetRowsFromFirstLevelTable(
+    RuntimeState* state, RowBatch* row_batch) {
+  DCHECK(is_streaming_preagg_);
+  SCOPED_TIMER(get_results_timer_);
+  while (first_level_output_idx_ < first_level_table_.size()
+      && !row_batch->AtCapacity()) {
+    const FirstLevelEntry& entry = first_level_table_[first_level_output_idx_++];
+    if (!entry.filled) continue;
+    // The entries are reused, so the returned rows reference a copy in the batch.
+    Tuple* output_tuple = entry.tuple->DeepCopy(
+        *intermediate_tuple_desc_, row_batch->tuple_data_pool());
+    int row_idx = row_batch->AddRow();
+    TupleRow* row = row_batch->GetRow(row_idx);
+    row->SetTuple(agg_idx_, output_tuple);
+    if (ExecNode::EvalConjuncts(conjunct_evals_.data(), conjuncts_.size(), row)) {
+      row_batch->CommitLastRow();
+      ++num_rows_returned_;
+      if (ReachedLimit()) break;
+    }
+  }
+  COUNTER_SET(rows_returned_counter_, num_rows_returned_);
+  partition_eos_ = ReachedLimit();
+}
+
 bool GroupingAggregator::ShouldExpandPreaggHashTables() const {
   int64_t ht_mem = 0;
   int64_t ht_rows = 0;
@@ -422,6 +495,7 @@ Status GroupingAggregator::Reset(RuntimeState* state, RowBatch* row_batch) {
   DCHECK(!is_streaming_preagg_) << "Cannot reset preaggregation";
   partition_eos_ = false;
   streaming_idx_ = 0;
+  if (output_sorted_) CloseSortedPartition();
   // Reset the HT and the partitions for this grouping agg.
   ht_ctx_->set_level(0);
   if (output_partition_ != nullptr) {
@@ -435,7 +509,18 @@ Status GroupingAggregator::Reset(RuntimeState* state, RowBatch* row_batch) {
 
 void GroupingAggregator::Close(RuntimeState* state) {
   ClosePartitions();
-
+  if (output_sorted_) CloseSortedPartition();
+  sorted_batch_.reset();
+  if (sorter_ != nullptr) sorter_->Close(state);
+  if (sorted_group_cmp_ != nullptr) sorted_group_cmp_->Close(state);
+  if (sorted_group_pool_ != nullptr) sorted_group_pool_->FreeAll();
+
+  if (first_level_mem_usage_ > 0) {
+    first_level_table_.clear();
+    first_level_tuple_data_.reset();
+    mem_tracker_->Release(first_level_mem_usage_);
+    first_level_mem_usage_ = 0;
+  }
   if (tuple_pool_.get() != nullptr) tuple_pool_->FreeAll();
   if (ht_ctx_.get() != nullptr) {
     ht_ctx_->StatsCountersAdd(ht_stats_profile_.get());
@@ -504,6 +589,18 @@ Status GroupingAggregator::AddBatchStreaming(
     }
   }
 
+  // Aggregate the rows that do not fit into the hash tables in the first-level table
+  // rather than passing them through one by one.
+  if (first_level_table_.empty() && state->query_options().preagg_first_level_table
+      && FirstLevelTableSupported()) {
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+      if (GetHashTable(i)->NumInsertsBeforeResize() < child_batch->num_rows()) {
+        InitFirstLevelTable();
+        break;
+      }
+    }
+  }
+
   TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
   GroupingAggregatorConfig::AddBatchStreamingImplFn fn
       = add_batch_streaming_impl_fn_.load();
@@ -518,9 +615,86 @@ Status GroupingAggregator::AddBatchStreaming(
 
   num_rows_returned_ += out_batch->num_rows();
   COUNTER_SET(num_passthrough_rows_, num_rows_returned_);
+  if (!first_level_table_.empty()) {
+    COUNTER_SET(first_level_hits_counter_, first_level_hits_);
+    COUNTER_SET(first_level_evictions_counter_, first_level_evictions_);
+  }
   return Status::OK();
 }
 
+bool GroupingAggregator::FirstLevelTableSupported() const {
+  return is_streaming_preagg_ && !needs_serialize_ && string_grouping_exprs_.empty()
+      && !intermediate_tuple_desc_->HasVarlenSlots()
+      && intermediate_tuple_desc_->byte_size() > 0;
+}
+
+void GroupingAggregator::InitFirstLevelTable() {
+  DCHECK(first_level_table_.empty());
+  const int fixed_size = intermediate_tuple_desc_->byte_size();
+  const int64_t entries_per_partition = BitUtil::RoundDownToPowerOfTwo(
+      FIRST_LEVEL_TABLE_BYTES / PARTITION_FANOUT / fixed_size);
+  if (entries_per_partition == 0) return;
+  const int64_t num_entries = entries_per_partition * PARTITION_FANOUT;
+  const int64_t mem_usage =
+      num_entries * (fixed_size + static_cast<int64_t>(sizeof(FirstLevelEntry)));
+  if (!mem_tracker_->TryConsume(mem_usage)) return;
+  first_level_mem_usage_ = mem_usage;
+  first_level_tuple_data_.reset(new uint8_t[num_entries * fixed_size]);
+  first_level_table_.resize(num_entries);
+  for (int64_t i = 0; i < num_entries; ++i) {
+    first_level_table_[i].tuple =
+        reinterpret_cast<Tuple*>(first_level_tuple_data_.get() + i * fixed_size);
+    first_level_table_[i].filled = false;
+  }
+  first_level_entry_bits_ = BitUtil::Log2Floor64(entries_per_partition);
+  first_level_mask_ = entries_per_partition - 1;
+}
+
+Tuple* GroupingAggregator::GetFirstLevelTuple(int partition_idx, uint32_t hash,
+    MemPool* pool, Tuple** evicted, Status* status) noexcept {
+  FirstLevelEntry* entry = &first_level_table_[
+      (partition_idx << first_level_entry_bits_) | (hash & first_level_mask_)];
+  *evicted = nullptr;
+  if (entry->filled && entry->hash == hash && FirstLevelKeyEquals(entry->tuple)) {
+    ++first_level_hits_;
+    return entry->tuple;
+  }
+  const int fixed_size = intermediate_tuple_desc_->byte_size();
+  if (entry->filled) {
+    uint8_t* copy = pool->TryAllocate(fixed_size);
+    if (UNLIKELY(copy == nullptr)) {
+      string details = Substitute("Cannot perform aggregation at aggregator with id $0. "
+          "Failed to allocate $1 bytes for intermediate tuple.", id_, fixed_size);
+      *status = pool->mem_tracker()->MemLimitExceeded(state_, details, fixed_size);
+      return nullptr;
+    }
+    memcpy(copy, entry->tuple, fixed_size);
+    *evicted = reinterpret_cast<Tuple*>(copy);
+    ++first_level_evictions_;
+  }
+  entry->tuple->Init(fixed_size);
+  CopyGroupingValues(entry->tuple, nullptr, 0);
+  InitAggSlots(agg_fn_evals_, entry->tuple);
+  entry->hash = hash;
+  entry->filled = true;
+  return entry->tuple;
+}
+
+bool GroupingAggregator::FirstLevelKeyEquals(Tuple* tuple) {
+  for (int i = 0; i < grouping_exprs_.size(); ++i) {
+    const SlotDescriptor* slot_desc = intermediate_tuple_desc_->slots()[i];
+    const bool is_null = tuple->IsNull(slot_desc->null_indicator_offset());
+    if (ht_ctx_->ExprValueNull(i)) {
+      if (!is_null) return false;
+    } else if (is_null
+        || memcmp(tuple->GetSlot(slot_desc->tuple_offset()), ht_ctx_->ExprValue(i),
+               slot_desc->slot_size()) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Status GroupingAggregator::InputDone() {
   return MoveHashPartitions(num_input_rows_);
 }
@@ -822,6 +996,9 @@ Status GroupingAggregator::NextPartition() {
     RETURN_IF_ERROR(BuildSpilledPartition(&partition));
     if (partition != nullptr) break;
 
+    // Sort the partition if repartitioning did not make it fit in memory before.
+    if (ShouldSortSpilledPartition()) return SortSpilledPartition();
+
     // If we can't fit the partition in memory, repartition it.
     RETURN_IF_ERROR(RepartitionSpilledPartition());
   }
@@ -830,6 +1007,7 @@ Status GroupingAggregator::NextPartition() {
   DCHECK(partition->aggregated_row_stream->is_pinned());
 
   output_partition_ = partition;
+  output_partition_->hash_tbl->FinishResize(ht_ctx_.get());
   output_iterator_ = output_partition_->hash_tbl->Begin(ht_ctx_.get());
   COUNTER_ADD(this->ht_stats_profile_->num_hash_buckets_,
       output_partition_->hash_tbl->num_buckets());
@@ -933,6 +1111,199 @@ Status GroupingAggregator::RepartitionSpilledPartition() {
   return Status::OK();
 }
 
+bool GroupingAggregator::ShouldSortSpilledPartition() const {
+  DCHECK(!spilled_partitions_.empty());
+  const int sort_level = state_->query_options().agg_spill_sort_level;
+  if (sort_level < 0 || spilled_partitions_.front()->level < sort_level) return false;
+  if (spill_sort_tuple_exprs_.empty()) return false;
+  // The sorter uses pages of the default size, so it cannot hold rows that need the
+  // large pages of the partition's streams.
+  return resource_profile_.max_row_buffer_size
+      == resource_profile_.spillable_buffer_size;
+}
+
+Status GroupingAggregator::SortSpilledPartition() {
+  DCHECK(!spilled_partitions_.empty());
+  DCHECK(!is_streaming_preagg_);
+  DCHECK(hash_partitions_.empty());
+  // Leave the partition in 'spilled_partitions_' to be closed if we hit an error.
+  Partition* partition = spilled_partitions_.front();
+  DCHECK(partition->is_spilled());
+
+  // Get the read buffers for the streams before the sorter can use up the unused
+  // reservation.
+  for (BufferedTupleStream* stream : {partition->aggregated_row_stream.get(),
+           partition->unaggregated_row_stream.get()}) {
+    if (stream->num_rows() == 0) continue;
+    bool got_buffer;
+    RETURN_IF_ERROR(stream->PrepareForRead(/*attach_on_read*/ true, &got_buffer));
+    DCHECK(got_buffer) << "Accounted in min reservation"
+                       << buffer_pool_client()->DebugString();
+  }
+
+  if (sorter_ == nullptr) {
+    // The sorter does not modify the row descriptor.
+    sorter_.reset(new Sorter(*spill_sort_comparator_config_, spill_sort_tuple_exprs_,
+        const_cast<RowDescriptor*>(&intermediate_row_desc_), mem_tracker_.get(),
+        buffer_pool_client(), resource_profile_.spillable_buffer_size,
+        runtime_profile()->CreateChild("SpilledPartitionSort"), state_,
+        exec_node_->label(), true, spill_sort_helper_fn_));
+    RETURN_IF_ERROR(sorter_->Prepare(pool_));
+    DCHECK_GE(resource_profile_.min_reservation, sorter_->ComputeMinReservation());
+    sorted_group_cmp_.reset(
+        new TupleRowLexicalComparator(*spill_sort_comparator_config_));
+    RETURN_IF_ERROR(sorted_group_cmp_->Open(
+        pool_, state_, expr_perm_pool_.get(), expr_results_pool_.get()));
+    sorted_batch_.reset(
+        new RowBatch(&intermediate_row_desc_, state_->batch_size(), mem_tracker_.get()));
+    sorted_group_pool_.reset(new MemPool(mem_tracker_.get()));
+  }
+  RETURN_IF_ERROR(sorter_->Open());
+  COUNTER_ADD(num_sorted_partitions_, 1);
+
+  RETURN_IF_ERROR(AddStreamToSorter(partition->aggregated_row_stream.get(), true));
+  RETURN_IF_ERROR(AddStreamToSorter(partition->unaggregated_row_stream.get(), false));
+  partition->Close(false);
+  spilled_partitions_.pop_front();
+  RETURN_IF_ERROR(sorter_->InputDone());
+
+  DCHECK_EQ(sorted_batch_->num_rows(), 0);
+  DCHECK(sorted_group_ == nullptr);
+  sorted_batch_idx_ = 0;
+  sorter_eos_ = false;
+  output_sorted_ = true;
+  return Status::OK();
+}
+
+Status GroupingAggregator::AddStreamToSorter(
+    BufferedTupleStream* input_stream, bool aggregated_rows) {
+  if (input_stream->num_rows() > 0) {
+    const RowDescriptor* desc =
+        aggregated_rows ? &intermediate_row_desc_ : &input_row_desc_;
+    RowBatch batch(desc, state_->batch_size(), mem_tracker_.get());
+    // Holds the intermediate tuples that the unaggregated rows are converted to.
+    RowBatch intermediate_batch(
+        &intermediate_row_desc_, state_->batch_size(), mem_tracker_.get());
+    bool eos = false;
+    do {
+      RETURN_IF_ERROR(input_stream->GetNext(&batch, &eos));
+      if (aggregated_rows) {
+        RETURN_IF_ERROR(sorter_->AddBatch(&batch));
+      } else {
+        MemPool* pool = intermediate_batch.tuple_data_pool();
+        vector<ScopedResultsPool> allocate_from_batch_pool =
+            ScopedResultsPool::Create(agg_fn_evals_, pool);
+        FOREACH_ROW(&batch, 0, batch_iter) {
+          TupleRow* row = batch_iter.Get();
+          ht_ctx_->expr_values_cache()->Reset();
+          ht_ctx_->EvalAndHashProbe(row);
+          Status status;
+          Tuple* tuple = ConstructIntermediateTuple(agg_fn_evals_, pool, &status);
+          if (UNLIKELY(tuple == nullptr)) return status;
+          UpdateTuple(agg_fn_evals_.data(), tuple, row);
+          if (needs_serialize_) AggFnEvaluator::Serialize(agg_fn_evals_, tuple);
+          TupleRow* intermediate_row =
+              intermediate_batch.GetRow(intermediate_batch.AddRow());
+          intermediate_row->SetTuple(0, tuple);
+          intermediate_batch.CommitLastRow();
+        }
+        RETURN_IF_ERROR(sorter_->AddBatch(&intermediate_batch));
+        intermediate_batch.Reset();
+      }
+      RETURN_IF_ERROR(QueryMaintenance(state_));
+      batch.Reset();
+    } while (!eos);
+  }
+  input_stream->Close(nullptr, RowBatch::FlushMode::NO_FLUSH_RESOURCES);
+  return Status::OK();
+}
+
+Status GroupingAggregator::GetRowsFromSortedPartition(
+    RuntimeState* state, RowBatch* row_batch) {
+  DCHECK(output_sorted_);
+  SCOPED_TIMER(get_results_timer_);
+  while (!row_batch->AtCapacity() && !ReachedLimit()) {
+    if (sorted_batch_idx_ == sorted_batch_->num_rows()) {
+      if (sorter_eos_) {
+        // The last group ends with the last sorted row.
+        if (sorted_group_ == nullptr) break;
+        OutputSortedGroup(row_batch);
+        continue;
+      }
+      sorted_batch_->Reset();
+      sorted_batch_idx_ = 0;
+      RETURN_IF_ERROR(sorter_->GetNext(sorted_batch_.get(), &sorter_eos_));
+      RETURN_IF_CANCELLED(state);
+      RETURN_IF_ERROR(QueryMaintenance(state));
+      continue;
+    }
+    TupleRow* row = sorted_batch_->GetRow(sorted_batch_idx_);
+    Tuple* tuple = row->GetTuple(0);
+    if (sorted_group_ != nullptr
+        && sorted_group_cmp_->Compare(sorted_group_, tuple) != 0) {
+      OutputSortedGroup(row_batch);
+      continue;
+    }
+    if (sorted_group_ == nullptr) {
+      sorted_group_ =
+          tuple->DeepCopy(*intermediate_tuple_desc_, sorted_group_pool_.get());
+      InitAggSlots(agg_fn_evals_, sorted_group_);
+    }
+    UpdateTuple(agg_fn_evals_.data(), sorted_group_, row, /* is_merge */ true);
+    ++sorted_batch_idx_;
+  }
+
+  COUNTER_SET(rows_returned_counter_, num_rows_returned_);
+  partition_eos_ = ReachedLimit();
+  if (partition_eos_
+      || (sorter_eos_ && sorted_batch_idx_ == sorted_batch_->num_rows()
+          && sorted_group_ == nullptr)) {
+    CloseSortedPartition();
+  }
+  return Status::OK();
+}
+
+void GroupingAggregator::OutputSortedGroup(RowBatch* row_batch) {
+  DCHECK(sorted_group_ != nullptr);
+  Tuple* output_tuple;
+  {
+    vector<ScopedResultsPool> allocate_from_group_pool =
+        ScopedResultsPool::Create(agg_fn_evals_, sorted_group_pool_.get());
+    output_tuple =
+        GetOutputTuple(agg_fn_evals_, sorted_group_, sorted_group_pool_.get());
+  }
+  // Copy the output tuple with the grouping values that it references to the batch.
+  const TupleDescriptor* desc =
+      output_tuple == sorted_group_ ? intermediate_tuple_desc_ : output_tuple_desc_;
+  TupleRow* row = row_batch->GetRow(row_batch->AddRow());
+  row->SetTuple(agg_idx_, output_tuple->DeepCopy(*desc, row_batch->tuple_data_pool()));
+  sorted_group_ = nullptr;
+  sorted_group_pool_->Clear();
+  DCHECK_EQ(conjunct_evals_.size(), conjuncts_.size());
+  if (ExecNode::EvalConjuncts(conjunct_evals_.data(), conjuncts_.size(), row)) {
+    row_batch->CommitLastRow();
+    ++num_rows_returned_;
+  }
+}
+
+void GroupingAggregator::CloseSortedPartition() {
+  DCHECK(output_sorted_);
+  if (sorted_group_ != nullptr) {
+    // Free any memory allocated by UDAs for the group that was not returned.
+    vector<ScopedResultsPool> allocate_from_group_pool =
+        ScopedResultsPool::Create(agg_fn_evals_, sorted_group_pool_.get());
+    GetOutputTuple(agg_fn_evals_, sorted_group_, sorted_group_pool_.get());
+    sorted_group_ = nullptr;
+  }
+  sorted_group_pool_->Clear();
+  // The returned rows do not reference the sorted rows, which were copied.
+  sorted_batch_->Reset();
+  sorted_batch_idx_ = 0;
+  sorter_eos_ = false;
+  sorter_->Reset();
+  output_sorted_ = false;
+}
+
 template <bool AGGREGATED_ROWS>
 Status GroupingAggregator::ProcessStream(BufferedTupleStream* input_stream,
     bool has_more_streams) {
@@ -991,27 +1362,36 @@ Status GroupingAggregator::ProcessStream(BufferedTupleStream* input_stream,
 }
 
 Status GroupingAggregator::SpillPartition(bool more_aggregate_rows) {
-  int64_t max_freed_mem = 0;
-  int partition_idx = -1;
-
-  // Iterate over the partitions and pick the largest partition that is not spilled.
+  // Let the spill victim policy pick one of the partitions that are not spilled.
+  vector<int> partition_idxs;
+  vector<SpillCandidate> candidates;
   for (int i = 0; i < hash_partitions_.size(); ++i) {
     if (hash_partitions_[i] == nullptr) continue;
     if (hash_partitions_[i]->is_closed) continue;
     if (hash_partitions_[i]->is_spilled()) continue;
+    BufferedTupleStream* stream = hash_partitions_[i]->aggregated_row_stream.get();
     // Pass 'true' because we need to keep the write block pinned. See Partition::Spill().
-    int64_t mem = hash_partitions_[i]->aggregated_row_stream->BytesPinned(true);
+    int64_t mem = stream->BytesPinned(true);
     mem += hash_partitions_[i]->hash_tbl->ByteSize();
     mem += hash_partitions_[i]->agg_fn_perm_pool->total_reserved_bytes();
     DCHECK_GT(mem, 0); // At least the hash table buckets should occupy memory.
-    if (mem > max_freed_mem) {
-      max_freed_mem = mem;
-      partition_idx = i;
-    }
+    partition_idxs.push_back(i);
+    candidates.push_back({mem, stream->byte_size(), stream->num_rows()});
   }
-  DCHECK_NE(partition_idx, -1) << "Should have been able to spill a partition to "
+  // Expect one more input row for each aggregated row, since input rows with the
+  // grouping keys of a partition follow it to scratch once it is spilled.
+  const double input_rows_per_row = 1;
+  int candidate_idx =
+      SpillVictimPolicy::Get()->ChooseVictim(candidates, input_rows_per_row);
+  DCHECK_NE(candidate_idx, -1) << "Should have been able to spill a partition to "
                                << "reclaim memory: "
                                << buffer_pool_client()->DebugString();
+  if (candidate_idx != SpillVictimPolicy::LargestCandidate(candidates)) {
+    COUNTER_ADD(num_spill_victims_not_largest_, 1);
+  }
+  COUNTER_ADD(expected_spill_scratch_bytes_, SpillVictimPolicy::ExpectedScratchBytes(
+      candidates, candidate_idx, input_rows_per_row));
+  int partition_idx = partition_idxs[candidate_idx];
   // Remove references to the destroyed hash table from 'hash_tbls_'.
   // Additionally, we might be dealing with a rebuilt spilled partition, where all
   // partitions point to a single in-memory partition. This also ensures that 'hash_tbls_'
@@ -1224,6 +1604,7 @@ Status GroupingAggregatorConfig::CodegenAddBatchImpl(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.group_probing, 1);
 
   replaced = codegen->ReplaceCallSites(add_batch_impl_fn, update_tuple_fn, "UpdateTuple");
   DCHECK_GE(replaced, 1);
@@ -1300,6 +1681,7 @@ Status GroupingAggregatorConfig::CodegenAddBatchStreamingImpl(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.group_probing, 1);
 
   DCHECK(add_batch_streaming_impl_fn != nullptr);
   add_batch_streaming_impl_fn = codegen->FinalizeFunction(add_batch_streaming_impl_fn);
@@ -30,6 +30,7 @@
 #include "runtime/descriptors.h"
 #include "runtime/mem-pool.h"
 #include "runtime/reservation-manager.h"
+#include "runtime/sorter.h"
 
 namespace impala {
 
@@ -101,6 +102,12 @@ class Tuple;
 /// through. If the node is not a streaming pre-aggregation, it responds to memory
 /// pressure by spilling partitions to disk.
 ///
+/// Sorting spilled partitions: if a spilled partition still does not fit in memory after
+/// it was repartitioned AGG_SPILL_SORT_LEVEL times, e.g. because of skew, its rows are
+/// sorted on the grouping keys with a Sorter instead of repartitioning it again. The
+/// groups are then aggregated and returned in a single streaming pass over the sorted
+/// rows, which only needs memory for the current group.
+///
 /// TODO: Buffer rows before probing into the hash table?
 /// TODO: After spilling, we can still maintain a very small hash table just to remove
 /// some number of rows (from likely going to disk).
@@ -171,6 +178,20 @@ class GroupingAggregatorConfig : public AggregatorConfig {
   /// Jitted AddBatchStreamingImpl function pointer. Null if codegen is disabled.
   CodegenFnPtr<AddBatchStreamingImplFn> add_batch_streaming_impl_fn_;
 
+  /// Exprs that copy all slots of an intermediate tuple, used to materialize the rows of
+  /// a spilled partition in the sorter. Empty if spilled partitions cannot be sorted,
+  /// i.e. for streaming preaggregations and intermediate tuples with NULL slots.
+  std::vector<ScalarExpr*> spill_sort_tuple_exprs_;
+
+  /// SlotRefs on the grouping slots of the intermediate tuple that the rows of a spilled
+  /// partition are sorted by, and the comparator config over them. Only set if
+  /// 'spill_sort_tuple_exprs_' is not empty.
+  std::vector<ScalarExpr*> spill_sort_key_exprs_;
+  TupleRowComparatorConfig* spill_sort_comparator_config_ = nullptr;
+
+  /// Never codegen'd, the sorter of spilled partitions uses the interpreted sort.
+  CodegenFnPtr<Sorter::SortHelperFn> spill_sort_helper_fn_;
+
   int GetNumGroupingExprs() const override { return grouping_exprs_.size(); }
 
  private:
@@ -242,6 +263,10 @@ class GroupingAggregator : public Aggregator {
   /// TODO: rethink this ?
   static const int64_t PAGG_DEFAULT_HASH_TABLE_SZ = 1024;
 
+  /// Bytes of intermediate tuples in the first-level table of a streaming
+  /// preaggregation, sized to stay in the L2 cache. See PREAGG_FIRST_LEVEL_TABLE.
+  static const int64_t FIRST_LEVEL_TABLE_BYTES = 256 * 1024;
+
   /// Codegen doesn't allow for automatic Status variables because then exception
   /// handling code is needed to destruct the Status, and our function call substitution
   /// doesn't know how to deal with the LLVM IR 'invoke' instruction. Workaround that by
@@ -275,6 +300,12 @@ class GroupingAggregator : public Aggregator {
   /// All var-len grouping exprs have type string.
   std::vector<int> string_grouping_exprs_;
 
+  /// The exprs, comparator config and sort function to sort spilled partitions with.
+  /// See GroupingAggregatorConfig.
+  const std::vector<ScalarExpr*>& spill_sort_tuple_exprs_;
+  const TupleRowComparatorConfig* spill_sort_comparator_config_;
+  const CodegenFnPtr<Sorter::SortHelperFn>& spill_sort_helper_fn_;
+
   RuntimeState* state_;
 
   /// Allocator for hash table memory.
@@ -344,9 +375,17 @@ class GroupingAggregator : public Aggregator {
   /// Number of partitions that have been repartitioned.
   RuntimeProfile::Counter* num_repartitions_ = nullptr;
 
+  /// Number of spilled partitions that were sorted instead of repartitioned.
+  RuntimeProfile::Counter* num_sorted_partitions_ = nullptr;
+
   /// Number of partitions that have been spilled.
   RuntimeProfile::Counter* num_spilled_partitions_ = nullptr;
 
+  /// Number of partitions spilled by SpillPartition() that were not the ones that freed
+  /// the most memory, and the total expected scratch I/O of all spilled partitions.
+  RuntimeProfile::Counter* num_spill_victims_not_largest_ = nullptr;
+  RuntimeProfile::Counter* expected_spill_scratch_bytes_ = nullptr;
+
   /// The largest fraction after repartitioning. This is expected to be
   /// 1 / PARTITION_FANOUT. A value much larger indicates skew.
   RuntimeProfile::HighWaterMarkCounter* largest_partition_percent_ = nullptr;
@@ -363,6 +402,51 @@ class GroupingAggregator : public Aggregator {
   /// Expose the minimum reduction factor to continue growing the hash tables.
   RuntimeProfile::Counter* preagg_streaming_ht_min_reduction_ = nullptr;
 
+  /// The number of rows aggregated into an existing entry of the first-level table, and
+  /// the number of entries evicted from it to the output.
+  RuntimeProfile::Counter* first_level_hits_counter_ = nullptr;
+  RuntimeProfile::Counter* first_level_evictions_counter_ = nullptr;
+  int64_t first_level_hits_ = 0;
+  int64_t first_level_evictions_ = 0;
+
+  /// An entry of the first-level table. 'tuple' points into 'first_level_tuple_data_'.
+  struct FirstLevelEntry {
+    Tuple* tuple;
+    uint32_t hash;
+    bool filled;
+  };
+
+  /// Fixed size, direct-mapped table of partial aggregates used by a streaming
+  /// preaggregation for the rows that do not fit into its hash tables. Each partition
+  /// has 1 << 'first_level_entry_bits_' consecutive entries, indexed by the hash bits
+  /// in 'first_level_mask_'. Empty until InitFirstLevelTable() is called.
+  std::vector<FirstLevelEntry> first_level_table_;
+  uint32_t first_level_mask_ = 0;
+  int first_level_entry_bits_ = 0;
+  std::unique_ptr<uint8_t[]> first_level_tuple_data_;
+  int64_t first_level_mem_usage_ = 0;
+
+  /// The index of the next entry of 'first_level_table_' to return in GetNext().
+  int first_level_output_idx_ = 0;
+
+  /// Sorts the rows of the spilled partitions that are aggregated by sorting, see
+  /// SortSpilledPartition(). Created when the first partition is sorted.
+  std::unique_ptr<Sorter> sorter_;
+
+  /// Compares the grouping keys of sorted rows to find where the groups end.
+  std::unique_ptr<TupleRowLexicalComparator> sorted_group_cmp_;
+
+  /// The rows returned by 'sorter_', the index of the next one to aggregate and whether
+  /// 'sorter_' returned all rows.
+  std::unique_ptr<RowBatch> sorted_batch_;
+  int sorted_batch_idx_ = 0;
+  bool sorter_eos_ = false;
+
+  /// The intermediate tuple of the group that sorted rows are aggregated into, or
+  /// nullptr before the first row of a group. Allocated from 'sorted_group_pool_'.
+  Tuple* sorted_group_ = nullptr;
+  std::unique_ptr<MemPool> sorted_group_pool_;
+
   /// The estimated number of input rows from the planner.
   int64_t estimated_input_cardinality_;
 
@@ -374,6 +458,10 @@ class GroupingAggregator : public Aggregator {
   /// If true, no more rows to output from partitions.
   bool partition_eos_ = false;
 
+  /// True if rows are returned from the partition sorted in 'sorter_' rather than from
+  /// 'output_partition_'.
+  bool output_sorted_ = false;
+
   /// When streaming rows through unaggregated, if the out batch reaches capacity before
   /// the input batch is fully processed, 'streaming_idx_' indicates the position within
   /// the input batch to resume at in the next call to AddBatchStreaming(). This is used
@@ -626,6 +714,33 @@ class GroupingAggregator : public Aggregator {
       HashTable* hash_tbl, TupleRow* in_row, uint32_t hash, int* remaining_capacity,
       Status* status) WARN_UNUSED_RESULT;
 
+  /// Returns true if the rows that do not fit into the hash tables of this streaming
+  /// preaggregation can be aggregated in the first-level table. Only fixed length
+  /// intermediate tuples that need no serialization are supported, so that the entries
+  /// can be copied to the output and reinitialized in place.
+  bool FirstLevelTableSupported() const;
+
+  /// Allocates 'first_level_table_', which holds FIRST_LEVEL_TABLE_BYTES of
+  /// intermediate tuples. Does nothing if the memory cannot be allocated.
+  void InitFirstLevelTable();
+
+  /// Returns the first-level table entry for the current row of 'ht_ctx_', which was
+  /// hashed to 'hash' and belongs to partition 'partition_idx'. The returned tuple is
+  /// initialized for the row's key and must be updated with the row. If another key was
+  /// in the entry, its partial aggregate is copied to 'pool' and returned in
+  /// '*evicted'. Returns nullptr and sets 'status' if the copy cannot be allocated.
+  Tuple* GetFirstLevelTuple(int partition_idx, uint32_t hash, MemPool* pool,
+      Tuple** evicted, Status* status) noexcept;
+
+  /// Returns true if the grouping slots of 'tuple' hold the current row of 'ht_ctx_'.
+  /// Compares the slot bytes, which is exact for the fixed length grouping types. A
+  /// false mismatch only leaves a key less aggregated.
+  bool FirstLevelKeyEquals(Tuple* tuple);
+
+  /// Returns the remaining partial aggregates of the first-level table in 'row_batch'.
+  /// Sets 'partition_eos_' if the limit is reached.
+  void GetRowsFromFirstLevelTable(RuntimeState* state, RowBatch* row_batch);
+
   /// Initializes hash_partitions_. 'level' is the level for the partitions to create.
   /// If 'single_partition_idx' is provided, it must be a number in range
   /// [0, PARTITION_FANOUT), and only that partition is created - all others point to it.
@@ -643,7 +758,8 @@ class GroupingAggregator : public Aggregator {
   /// Prepares the next partition to return results from. On return, this function
   /// initializes output_iterator_ and output_partition_. This either removes
   /// a partition from aggregated_partitions_ (and is done) or removes the next
-  /// partition from aggregated_partitions_ and repartitions it.
+  /// partition from aggregated_partitions_ and repartitions it. If a spilled partition
+  /// is sorted instead, sets 'output_sorted_' and leaves 'output_partition_' nullptr.
   Status NextPartition() WARN_UNUSED_RESULT;
 
   /// Tries to build the first partition in 'spilled_partitions_'.
@@ -661,9 +777,38 @@ class GroupingAggregator : public Aggregator {
   /// * in 'aggregated_partitions_', if the output partition was not spilled.
   Status RepartitionSpilledPartition() WARN_UNUSED_RESULT;
 
-  /// Picks a partition from 'hash_partitions_' to spill. 'more_aggregate_rows' is passed
-  /// to Partition::Spill() when spilling the partition. See the Partition::Spill()
-  /// comment for further explanation.
+  /// Returns true if the first partition in 'spilled_partitions_', which did not fit in
+  /// memory, should be sorted rather than repartitioned. See AGG_SPILL_SORT_LEVEL.
+  bool ShouldSortSpilledPartition() const;
+
+  /// Removes the first partition from 'spilled_partitions_' and adds all its rows to
+  /// 'sorter_' as intermediate tuples. Sets 'output_sorted_' so that the groups of the
+  /// partition are returned by GetRowsFromSortedPartition().
+  Status SortSpilledPartition() WARN_UNUSED_RESULT;
+
+  /// Reads all rows of 'input_stream', which must be prepared for reading, and adds them
+  /// to 'sorter_'. 'aggregated_rows' is true if the stream holds intermediate tuples.
+  /// Otherwise each unaggregated row is converted to an intermediate tuple of its own.
+  Status AddStreamToSorter(
+      BufferedTupleStream* input_stream, bool aggregated_rows) WARN_UNUSED_RESULT;
+
+  /// Aggregates the sorted rows from 'sorter_' and adds the rows of the groups to
+  /// 'row_batch'. Sets 'partition_eos_' if the limit is reached. Calls
+  /// CloseSortedPartition() once all groups of the partition are returned.
+  Status GetRowsFromSortedPartition(
+      RuntimeState* state, RowBatch* row_batch) WARN_UNUSED_RESULT;
+
+  /// Computes the output tuple of 'sorted_group_' and adds it to 'row_batch' if it
+  /// passes the conjuncts. Frees 'sorted_group_'.
+  void OutputSortedGroup(RowBatch* row_batch);
+
+  /// Frees the remaining rows of the sorted partition and resets 'sorter_' so that it
+  /// can sort the next partition. Clears 'output_sorted_'.
+  void CloseSortedPartition();
+
+  /// Picks a partition from 'hash_partitions_' to spill with the SpillVictimPolicy.
+  /// 'more_aggregate_rows' is passed to Partition::Spill() when spilling the partition.
+  /// See the Partition::Spill() comment for further explanation.
   Status SpillPartition(bool more_aggregate_rows) WARN_UNUSED_RESULT;
 
   /// Moves the partitions in hash_partitions_ to aggregated_partitions_ or
@@ -71,6 +71,13 @@ class HashTableTest : public testing::Test {
   vector<ScalarExprEvaluator*> probe_expr_evals_;
   int next_query_id_ = 0;
 
+  /// Whether hash tables created by CreateHashTable() use group probing.
+  bool group_probing_ = false;
+
+  /// Whether hash tables created by CreateHashTable() resize incrementally. The hash
+  /// tables do not store duplicates in that case.
+  bool incremental_resize_ = false;
+
   virtual void SetUp() {
     test_env_.reset(new TestEnv());
     ASSERT_OK(test_env_->Init());
@@ -257,8 +264,9 @@ class HashTableTest : public testing::Test {
     // Initial_num_buckets must be a power of two.
     EXPECT_EQ(initial_num_buckets, BitUtil::RoundUpToPowerOfTwo(initial_num_buckets));
     int64_t max_num_buckets = 1L << 31;
-    *table = pool_.Add(new HashTable(
-        quadratic, allocator, true, 1, nullptr, max_num_buckets, initial_num_buckets));
+    *table = pool_.Add(new HashTable(quadratic, group_probing_, allocator,
+        !incremental_resize_, 1, nullptr, max_num_buckets, initial_num_buckets,
+        incremental_resize_));
     hash_tables_.push_back(*table);
     bool success;
     Status status = (*table)->Init(&success);
@@ -387,9 +395,10 @@ class HashTableTest : public testing::Test {
     ProbeTest(hash_table, ht_ctx.get(), probe_rows, 10, false);
 
     // Resize to 8, which is the smallest value to fit the number of filled buckets.
+    // Tables with group probing have at least one group of buckets.
     EXPECT_OK(ResizeTable(hash_table, 8, ht_ctx.get(), &success));
     EXPECT_TRUE(success);
-    EXPECT_EQ(hash_table->num_buckets(), 8);
+    EXPECT_EQ(hash_table->num_buckets(), group_probing_ ? HashTable::GROUP_SIZE : 8);
     EXPECT_EQ(hash_table->size(), 5);
     memset(scan_rows, 0, sizeof(scan_rows));
     FullScan(hash_table, ht_ctx.get(), 0, 5, true, scan_rows, build_rows);
@@ -464,8 +473,9 @@ class HashTableTest : public testing::Test {
     uint64_t num_to_add = 4;
     int expected_size = 0;
 
-    // Need enough memory for two hash table bucket directories during resize.
-    const int64_t mem_limit_mb = 128 + 64;
+    // Need enough memory for two hash table bucket directories during resize. The
+    // control bytes of group probing add 1/16th to them.
+    const int64_t mem_limit_mb = group_probing_ ? 256 : 128 + 64;
     HashTable* hash_table;
     ASSERT_TRUE(
         CreateHashTable(quadratic, num_to_add, &hash_table, 1024 * 1024, mem_limit_mb));
@@ -620,6 +630,115 @@ class HashTableTest : public testing::Test {
     ht_ctx->Close(runtime_state_);
   }
 
+  // This test inserts rows with FindBuildRowBucket() into a hash table that resizes
+  // incrementally and checks that rows inserted before a resize are found while their
+  // buckets are migrated, and that every row is migrated exactly once.
+  void IncrementalResizeTest(bool quadratic) {
+    const int num_rows = 100000;
+    HashTable* hash_table;
+    ASSERT_TRUE(CreateHashTable(quadratic, 16, &hash_table));
+    scoped_ptr<HashTableCtx> ht_ctx;
+    Status status = HashTableCtx::Create(&pool_, runtime_state_, build_exprs_,
+        probe_exprs_, false /* !stores_nulls_ */,
+        vector<bool>(build_exprs_.size(), false), 1, 0, 1, &mem_pool_,
+        &mem_pool_, &mem_pool_, &ht_ctx);
+    EXPECT_OK(status);
+
+    vector<TupleRow*> rows(num_rows);
+    int num_lookups_during_resize = 0;
+    bool found;
+    for (int i = 0; i < num_rows; ++i) {
+      bool success;
+      EXPECT_OK(hash_table->CheckAndResize(1, ht_ctx.get(), &success));
+      ASSERT_TRUE(success);
+      rows[i] = CreateTupleRow(i);
+      ASSERT_TRUE(ht_ctx->EvalAndHashBuild(rows[i]));
+      uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
+      HashTable::Iterator iter = hash_table->FindBuildRowBucket(ht_ctx.get(), &found);
+      ASSERT_FALSE(iter.AtEnd());
+      EXPECT_FALSE(found);
+      iter.SetTuple(rows[i]->GetTuple(0), hash);
+
+      // Look up an older row, which may not be migrated yet.
+      if (hash_table->old_buckets_ != nullptr) ++num_lookups_during_resize;
+      TupleRow* old_row = rows[i / 2];
+      ASSERT_TRUE(ht_ctx->EvalAndHashBuild(old_row));
+      iter = hash_table->FindBuildRowBucket(ht_ctx.get(), &found);
+      ASSERT_FALSE(iter.AtEnd());
+      EXPECT_TRUE(found);
+      EXPECT_EQ(old_row->GetTuple(0), iter.GetTuple());
+    }
+    EXPECT_GT(hash_table->num_resizes_, 0);
+    EXPECT_GT(num_lookups_during_resize, 0);
+    EXPECT_EQ(hash_table->size(), num_rows);
+
+    hash_table->FinishResize(ht_ctx.get());
+    EXPECT_TRUE(hash_table->old_buckets_ == nullptr);
+    vector<TupleRow*> results(num_rows, nullptr);
+    FullScan(hash_table, ht_ctx.get(), 0, num_rows, true, results.data(), rows.data());
+    for (int i = 0; i < num_rows; ++i) EXPECT_TRUE(results[i] != nullptr) << i;
+
+    ht_ctx->Close(runtime_state_);
+  }
+
+  // This test looks up rows with FindProbeRowsPipelined() and checks that the results
+  // are the same as those of FindProbeRow(). Value 'val' is inserted 'val % 3' times,
+  // so that some rows have no match, one match and duplicate matches.
+  void PipelinedProbeTest(bool quadratic, int table_size) {
+    HashTable* hash_table;
+    ASSERT_TRUE(CreateHashTable(quadratic, table_size, &hash_table));
+    scoped_ptr<HashTableCtx> ht_ctx;
+    Status status = HashTableCtx::Create(&pool_, runtime_state_, build_exprs_,
+        probe_exprs_, false /* !stores_nulls_ */,
+        vector<bool>(build_exprs_.size(), false), 1, 0, 1, &mem_pool_, &mem_pool_,
+        &mem_pool_, &ht_ctx);
+    EXPECT_OK(status);
+    EXPECT_OK(ht_ctx->Open(runtime_state_));
+
+    HashTableCtx::ExprValuesCache* cache = ht_ctx->expr_values_cache();
+    const int num_rows = cache->capacity();
+    bool success;
+    EXPECT_OK(hash_table->CheckAndResize(num_rows, ht_ctx.get(), &success));
+    ASSERT_TRUE(success);
+    for (int val = 0; val < num_rows; ++val) {
+      for (int i = 0; i < val % 3; ++i) {
+        TupleRow* row = CreateTupleRow(val);
+        ASSERT_TRUE(ht_ctx->EvalAndHashBuild(row));
+        ASSERT_TRUE(hash_table->Insert(ht_ctx.get(), nullptr, row, &status));
+        ASSERT_OK(status);
+      }
+    }
+
+    // Probe the values in reverse order, half of them in the table.
+    vector<HashTable*> tables(num_rows, hash_table);
+    vector<HashTable::Iterator> results(num_rows);
+    cache->Reset();
+    for (int i = 0; i < num_rows; ++i) {
+      ASSERT_TRUE(ht_ctx->EvalAndHashProbe(CreateTupleRow(num_rows - i - 1)));
+      cache->NextRow();
+    }
+    cache->ResetForRead();
+    tables[0] = nullptr;
+    HashTable::FindProbeRowsPipelined(
+        tables.data(), num_rows, ht_ctx.get(), results.data());
+    EXPECT_EQ(0, cache->CurIdx());
+    for (int i = 0; i < num_rows; ++i) {
+      HashTable::Iterator expected =
+          i == 0 ? hash_table->End() : hash_table->FindProbeRow(ht_ctx.get());
+      HashTable::Iterator actual = results[i];
+      int num_matches = 0;
+      for (; !expected.AtEnd(); expected.NextDuplicate(), actual.NextDuplicate()) {
+        ASSERT_FALSE(actual.AtEnd()) << i;
+        EXPECT_EQ(expected.GetTuple(), actual.GetTuple());
+        ++num_matches;
+      }
+      EXPECT_TRUE(actual.AtEnd()) << i;
+      if (i > 0) EXPECT_EQ((num_rows - i - 1) % 3, num_matches);
+      cache->NextRow();
+    }
+    ht_ctx->Close(runtime_state_);
+  }
+
   // This test makes sure we can tolerate the low memory case where we do not have enough
   // memory to allocate the array of buckets for the hash table.
   void VeryLowMemTest(bool quadratic) {
@@ -715,6 +834,64 @@ TEST_F(HashTableTest, QuadraticInsertFullTest) {
   InsertFullTest(true, 65536);
 }
 
+TEST_F(HashTableTest, GroupSetupTest) {
+  group_probing_ = true;
+  SetupTest(false, 1, false);
+  SetupTest(true, 1024, false);
+  SetupTest(true, 65536, false);
+  SetupTest(true, 4294967296, true); // 2^32
+}
+
+TEST_F(HashTableTest, GroupBasicTest) {
+  group_probing_ = true;
+  BasicTest(false, 1024);
+  BasicTest(true, 1);
+  BasicTest(true, 1024);
+  BasicTest(true, 65536);
+}
+
+TEST_F(HashTableTest, GroupScanTest) {
+  group_probing_ = true;
+  ScanTest(false, 1024, 1000, 500);
+  ScanTest(true, 1, 10, 5);
+  ScanTest(true, 1024, 1000, 5);
+  ScanTest(true, 1024, 1000, 500);
+}
+
+TEST_F(HashTableTest, GroupGrowTableTest) {
+  group_probing_ = true;
+  GrowTableTest(true);
+}
+
+// Full tables exercise probes that visit every group of buckets.
+TEST_F(HashTableTest, GroupInsertFullTest) {
+  group_probing_ = true;
+  InsertFullTest(false, 64);
+  InsertFullTest(true, 16);
+  InsertFullTest(true, 64);
+  InsertFullTest(true, 1024);
+  InsertFullTest(true, 65536);
+}
+
+TEST_F(HashTableTest, PipelinedProbeTest) {
+  PipelinedProbeTest(false, 1);
+  PipelinedProbeTest(false, 1024);
+  PipelinedProbeTest(true, 1);
+  PipelinedProbeTest(true, 1024);
+  // Tables with group probing are not probed with state machines, but the results
+  // must be the same.
+  group_probing_ = true;
+  PipelinedProbeTest(true, 1024);
+}
+
+TEST_F(HashTableTest, IncrementalResizeTest) {
+  incremental_resize_ = true;
+  IncrementalResizeTest(false);
+  IncrementalResizeTest(true);
+  group_probing_ = true;
+  IncrementalResizeTest(true);
+}
+
 // Test that hashing empty string updates hash value.
 TEST_F(HashTableTest, HashEmpty) {
   scoped_ptr<HashTableCtx> ht_ctx;
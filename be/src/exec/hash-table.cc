@@ -40,6 +40,16 @@ using namespace impala;
 using strings::Substitute;
 
 DEFINE_bool(enable_quadratic_probing, true, "Enable quadratic probing hash table");
+DEFINE_bool(hash_table_group_probing, false, "(Advanced) If true, the hash tables of "
+    "aggregations and hash joins keep a control byte with 7 bits of the hash per bucket "
+    "and probe groups of 16 buckets with a single SIMD compare of their control bytes. "
+    "This makes probes of nearly full hash tables cheaper, at the cost of one extra byte "
+    "per bucket.");
+DEFINE_bool(hash_table_incremental_resize, false, "(Advanced) If true, the hash tables "
+    "of aggregations keep the old bucket directory when they grow and migrate its "
+    "buckets to the new one a few at a time on the following inserts, instead of "
+    "rehashing all buckets at once. This avoids long stalls on resizes of large hash "
+    "tables.");
 
 const char* HashTableCtx::LLVM_CLASS_NAME = "class.impala::HashTableCtx";
 
@@ -93,7 +103,9 @@ HashTableConfig::HashTableConfig(const std::vector<ScalarExpr*>& build_exprs,
     finds_nulls(finds_nulls),
     finds_some_nulls(std::accumulate(
         finds_nulls.begin(), finds_nulls.end(), false, std::logical_or<bool>())),
-    build_exprs_results_row_layout(build_exprs) {
+    build_exprs_results_row_layout(build_exprs),
+    group_probing(FLAGS_hash_table_group_probing),
+    incremental_resize(FLAGS_hash_table_incremental_resize) {
   DCHECK_EQ(build_exprs.size(), finds_nulls.size());
   DCHECK_EQ(build_exprs.size(), probe_exprs.size());
 }
@@ -449,24 +461,30 @@ void HashTableCtx::ExprValuesCache::ResetForRead() {
 
 constexpr double HashTable::MAX_FILL_FACTOR;
 constexpr int64_t HashTable::DATA_PAGE_SIZE;
-
-HashTable* HashTable::Create(Suballocator* allocator, bool stores_duplicates,
-    int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-    int64_t initial_num_buckets) {
-  return new HashTable(FLAGS_enable_quadratic_probing, allocator, stores_duplicates,
-      num_build_tuples, tuple_stream, max_num_buckets, initial_num_buckets);
+constexpr int64_t HashTable::GROUP_SIZE;
+constexpr int HashTable::PIPELINED_PROBE_DEPTH;
+constexpr int64_t HashTable::MIGRATE_BUCKETS_PER_FIND;
+
+HashTable* HashTable::Create(bool group_probing, Suballocator* allocator,
+    bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+    int64_t max_num_buckets, int64_t initial_num_buckets, bool incremental_resize) {
+  return new HashTable(FLAGS_enable_quadratic_probing, group_probing, allocator,
+      stores_duplicates, num_build_tuples, tuple_stream, max_num_buckets,
+      initial_num_buckets, incremental_resize);
 }
 
-HashTable::HashTable(bool quadratic_probing, Suballocator* allocator,
+HashTable::HashTable(bool quadratic_probing, bool group_probing, Suballocator* allocator,
     bool stores_duplicates, int num_build_tuples, BufferedTupleStream* stream,
-    int64_t max_num_buckets, int64_t num_buckets)
+    int64_t max_num_buckets, int64_t num_buckets, bool incremental_resize)
   : allocator_(allocator),
     tuple_stream_(stream),
     stores_tuples_(num_build_tuples == 1),
     stores_duplicates_(stores_duplicates),
     quadratic_probing_(quadratic_probing),
+    group_probing_(group_probing),
+    incremental_resize_(incremental_resize && !stores_duplicates),
     max_num_buckets_(max_num_buckets),
-    num_buckets_(num_buckets),
+    num_buckets_(group_probing ? std::max(num_buckets, GROUP_SIZE) : num_buckets),
     num_build_tuples_(num_build_tuples) {
   DCHECK_EQ((num_buckets & (num_buckets - 1)), 0) << "num_buckets must be a power of 2";
   DCHECK_GT(num_buckets, 0) << "num_buckets must be larger than 0";
@@ -481,12 +499,29 @@ Status HashTable::Init(bool* got_memory) {
     *got_memory = false;
     return Status::OK();
   }
+  if (group_probing_) {
+    RETURN_IF_ERROR(AllocateCtrl(num_buckets_, &ctrl_allocation_));
+    if (ctrl_allocation_ == nullptr) {
+      allocator_->Free(move(bucket_allocation_));
+      num_buckets_ = 0;
+      *got_memory = false;
+      return Status::OK();
+    }
+    ctrl_ = ctrl_allocation_->data();
+  }
   buckets_ = reinterpret_cast<Bucket*>(bucket_allocation_->data());
   memset(buckets_, 0, buckets_byte_size);
   *got_memory = true;
   return Status::OK();
 }
 
+Status HashTable::AllocateCtrl(
+    int64_t num_buckets, unique_ptr<Suballocation>* allocation) {
+  RETURN_IF_ERROR(allocator_->Allocate(num_buckets, allocation));
+  if (*allocation != nullptr) memset((*allocation)->data(), EMPTY_CTRL, num_buckets);
+  return Status::OK();
+}
+
 unique_ptr<HashTableStatsProfile> HashTable::AddHashTableCounters(
     RuntimeProfile* parent_profile) {
   unique_ptr<HashTableStatsProfile> stats_profile(new HashTableStatsProfile());
@@ -513,6 +548,13 @@ void HashTable::Close() {
   for (auto& data_page : data_pages_) allocator_->Free(move(data_page));
   data_pages_.clear();
   if (bucket_allocation_ != nullptr) allocator_->Free(move(bucket_allocation_));
+  if (ctrl_allocation_ != nullptr) allocator_->Free(move(ctrl_allocation_));
+  ctrl_ = nullptr;
+  if (old_bucket_allocation_ != nullptr) allocator_->Free(move(old_bucket_allocation_));
+  if (old_ctrl_allocation_ != nullptr) allocator_->Free(move(old_ctrl_allocation_));
+  old_buckets_ = nullptr;
+  old_ctrl_ = nullptr;
+  old_num_buckets_ = 0;
 }
 
 void HashTable::StatsCountersAdd(HashTableStatsProfile* profile) {
@@ -533,6 +575,10 @@ Status HashTable::CheckAndResize(
 
 Status HashTable::ResizeBuckets(
     int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, bool* got_memory) {
+  // A resize in progress is finished first, so that there are at most two bucket
+  // directories.
+  FinishResize(ht_ctx);
+  if (group_probing_) num_buckets = std::max(num_buckets, GROUP_SIZE);
   DCHECK_EQ((num_buckets & (num_buckets - 1)), 0)
       << "num_buckets=" << num_buckets << " must be a power of 2";
   DCHECK_GT(num_buckets, num_filled_buckets_)
@@ -560,33 +606,100 @@ Status HashTable::ResizeBuckets(
     *got_memory = false;
     return Status::OK();
   }
+  unique_ptr<Suballocation> new_ctrl_allocation;
+  uint8_t* new_ctrl = nullptr;
+  if (group_probing_) {
+    Status status = AllocateCtrl(num_buckets, &new_ctrl_allocation);
+    if (!status.ok() || new_ctrl_allocation == nullptr) {
+      allocator_->Free(move(new_allocation));
+      *got_memory = false;
+      return status;
+    }
+    new_ctrl = new_ctrl_allocation->data();
+  }
   Bucket* new_buckets = reinterpret_cast<Bucket*>(new_allocation->data());
   memset(new_buckets, 0, new_size);
 
-  // Walk the old table and copy all the filled buckets to the new (resized) table.
-  // We do not have to do anything with the duplicate nodes. This operation is expected
-  // to succeed.
-  for (HashTable::Iterator iter = Begin(ht_ctx); !iter.AtEnd();
-       NextFilledBucket(&iter.bucket_idx_, &iter.node_)) {
-    Bucket* bucket_to_copy = &buckets_[iter.bucket_idx_];
-    bool found = false;
-    int64_t bucket_idx = Probe<true, false>(
-        new_buckets, num_buckets, ht_ctx, bucket_to_copy->hash, &found);
-    DCHECK(!found);
-    DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND) << " Probe failed even though "
-        " there are free buckets. " << num_buckets << " " << num_filled_buckets_;
-    Bucket* dst_bucket = &new_buckets[bucket_idx];
-    *dst_bucket = *bucket_to_copy;
+  if (incremental_resize_) {
+    // Keep the old buckets around for FindBuildRowBucket() to migrate.
+    DCHECK(old_buckets_ == nullptr);
+    old_bucket_allocation_ = move(bucket_allocation_);
+    old_ctrl_allocation_ = move(ctrl_allocation_);
+    old_buckets_ = buckets_;
+    old_ctrl_ = ctrl_;
+    old_num_buckets_ = num_buckets_;
+    migrate_idx_ = 0;
+  } else {
+    // Walk the old table and copy all the filled buckets to the new (resized) table.
+    // We do not have to do anything with the duplicate nodes. This operation is
+    // expected to succeed.
+    for (HashTable::Iterator iter = Begin(ht_ctx); !iter.AtEnd();
+         NextFilledBucket(&iter.bucket_idx_, &iter.node_)) {
+      CopyBucket(&buckets_[iter.bucket_idx_], new_buckets, new_ctrl, num_buckets, ht_ctx);
+    }
+    allocator_->Free(move(bucket_allocation_));
   }
 
   num_buckets_ = num_buckets;
-  allocator_->Free(move(bucket_allocation_));
   bucket_allocation_ = move(new_allocation);
   buckets_ = reinterpret_cast<Bucket*>(bucket_allocation_->data());
+  if (group_probing_) {
+    if (ctrl_allocation_ != nullptr) allocator_->Free(move(ctrl_allocation_));
+    ctrl_allocation_ = move(new_ctrl_allocation);
+    ctrl_ = new_ctrl;
+  }
   *got_memory = true;
   return Status::OK();
 }
 
+void HashTable::CopyBucket(const Bucket* bucket, Bucket* buckets, uint8_t* ctrl,
+    int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx) {
+  bool found = false;
+  int64_t bucket_idx =
+      Probe<true, false>(buckets, ctrl, num_buckets, ht_ctx, bucket->hash, &found);
+  DCHECK(!found);
+  DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND) << " Probe failed even though "
+      " there are free buckets. " << num_buckets << " " << num_filled_buckets_;
+  buckets[bucket_idx] = *bucket;
+  if (group_probing_) ctrl[bucket_idx] = HashCtrl(bucket->hash);
+}
+
+void HashTable::FinishResize(HashTableCtx* __restrict__ ht_ctx) {
+  if (old_buckets_ != nullptr) MigrateBuckets(old_num_buckets_, ht_ctx);
+}
+
+void HashTable::MigrateBuckets(int64_t max_buckets, HashTableCtx* __restrict__ ht_ctx) {
+  DCHECK(old_buckets_ != nullptr);
+  const int64_t end = std::min(old_num_buckets_, migrate_idx_ + max_buckets);
+  for (; migrate_idx_ < end; ++migrate_idx_) {
+    const Bucket* bucket = &old_buckets_[migrate_idx_];
+    // Buckets with 'matched' set were already migrated by MigrateBuildRowBucket().
+    if (!bucket->filled || bucket->matched) continue;
+    CopyBucket(bucket, buckets_, ctrl_, num_buckets_, ht_ctx);
+  }
+  if (migrate_idx_ < old_num_buckets_) return;
+  allocator_->Free(move(old_bucket_allocation_));
+  if (old_ctrl_allocation_ != nullptr) allocator_->Free(move(old_ctrl_allocation_));
+  old_buckets_ = nullptr;
+  old_ctrl_ = nullptr;
+  old_num_buckets_ = 0;
+}
+
+void HashTable::MigrateBuildRowBucket(HashTableCtx* __restrict__ ht_ctx, uint32_t hash,
+    int64_t bucket_idx, bool* found) {
+  DCHECK(old_buckets_ != nullptr);
+  DCHECK(!buckets_[bucket_idx].filled);
+  int64_t old_bucket_idx = Probe<true, true>(
+      old_buckets_, old_ctrl_, old_num_buckets_, ht_ctx, hash, found);
+  if (!*found) return;
+  // The old bucket stays filled so that probes of the old bucket directory for other
+  // keys still pass it, MigrateBuckets() skips it.
+  Bucket* old_bucket = &old_buckets_[old_bucket_idx];
+  buckets_[bucket_idx] = *old_bucket;
+  if (group_probing_) ctrl_[bucket_idx] = HashCtrl(hash);
+  old_bucket->matched = true;
+}
+
 bool HashTable::GrowNodeArray(Status* status) {
   unique_ptr<Suballocation> allocation;
   *status = allocator_->Allocate(DATA_PAGE_SIZE, &allocation);
@@ -1297,5 +1410,7 @@ Status HashTableCtx::ReplaceHashTableConstants(LlvmCodeGen* codegen,
       fn, stores_duplicates, "stores_duplicates");
   replacement_counts->quadratic_probing = codegen->ReplaceCallSitesWithBoolConst(
       fn, FLAGS_enable_quadratic_probing, "quadratic_probing");
+  replacement_counts->group_probing = codegen->ReplaceCallSitesWithBoolConst(
+      fn, config.group_probing, "group_probing");
   return Status::OK();
 }
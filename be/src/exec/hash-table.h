@@ -95,6 +95,14 @@ struct ScalarExprsResultsRowLayout;
 /// We choose to use linear or quadratic probing because they exhibit good (predictable)
 /// cache behavior.
 ///
+/// With group probing (see HashTableConfig::group_probing), the table also keeps one
+/// control byte per bucket, which is either EMPTY_CTRL or 7 bits of the hash of the
+/// entry in the bucket. The buckets are probed in groups of GROUP_SIZE consecutive
+/// buckets: a single SIMD compare of the control bytes of a group finds the buckets
+/// whose entry may match, and the empty buckets of the group. Only the matching buckets
+/// are read, so a probe of a nearly full table touches far fewer buckets and rows.
+/// Linear or quadratic probing then applies to the sequence of groups.
+///
 /// The first NUM_SMALL_BLOCKS of nodes_ are made of blocks less than the IO size (of 8MB)
 /// to reduce the memory footprint of small queries.
 ///
@@ -141,6 +149,14 @@ struct HashTableConfig {
 
   /// The memory efficient layout for storing the results of evaluating build expressions.
   const ScalarExprsResultsRowLayout build_exprs_results_row_layout;
+
+  /// If true, hash tables probe groups of buckets with their control bytes. Set from
+  /// FLAGS_hash_table_group_probing.
+  const bool group_probing;
+
+  /// If true, hash tables that do not store duplicates resize incrementally, see
+  /// HashTable::FinishResize(). Set from FLAGS_hash_table_incremental_resize.
+  const bool incremental_resize;
 };
 
 /// Control block for a hash table. This class contains the logic as well as the variables
@@ -238,6 +254,7 @@ class HashTableCtx {
     int stores_tuples;
     int stores_duplicates;
     int quadratic_probing;
+    int group_probing;
   };
 
   /// Replace hash table parameters with constants in 'fn'. Updates 'replacement_counts'
@@ -268,12 +285,13 @@ class HashTableCtx {
   /// - 'null_bitmap_' is a bitmap which indicates rows evaluated to NULL.
   ///
   /// ExprValuesCache provides an iterator like interface for performing a write pass
-  /// followed by a read pass. We refrain from providing an interface for random accesses
-  /// as there isn't a use case for it now and we want to avoid expensive multiplication
-  /// as the buffer size of each row is not necessarily power of two:
+  /// followed by a read pass. Random accesses with SeekToRow() are only meant for
+  /// pipelined look ups, which interleave several rows, as they need a multiplication
+  /// because the buffer size of each row is not necessarily power of two:
   /// - Reset(), ResetForRead(): reset the iterators before writing / reading cached values.
   /// - NextRow(): moves the iterators to point to the next row of cached values.
   /// - AtEnd(): returns true if all cached rows have been read. Valid in read mode only.
+  /// - SeekToRow(): moves the iterators to the row at an index.
   ///
   /// Various metadata information such as layout of results buffer is also stored in
   /// this class. Note that the result buffer doesn't store variable length data. It only
@@ -338,6 +356,21 @@ class HashTableCtx {
     /// Returns the hash values of the current row.
     uint32_t ALWAYS_INLINE CurExprValuesHash() const { return *cur_expr_values_hash_; }
 
+    /// Returns the offset in number of rows into the cached values' buffer.
+    int ALWAYS_INLINE CurIdx() const {
+      return cur_expr_values_hash_ - expr_values_hash_array_.get();
+    }
+
+    /// Moves the iterators to the row at 'idx'. Used by look ups which work on several
+    /// cached rows at once, see HashTable::FindProbeRowsPipelined().
+    void ALWAYS_INLINE SeekToRow(int idx) {
+      DCHECK_GE(idx, 0);
+      DCHECK_LT(idx, capacity_);
+      cur_expr_values_ = expr_values_array_.get() + idx * expr_values_bytes_per_row_;
+      cur_expr_values_null_ = expr_values_null_array_.get() + idx * num_exprs_;
+      cur_expr_values_hash_ = expr_values_hash_array_.get() + idx;
+    }
+
     /// Sets the hash values for the current row.
     void ALWAYS_INLINE SetCurExprValuesHash(uint32_t hash) {
       *cur_expr_values_hash_ = hash;
@@ -368,11 +401,6 @@ class HashTableCtx {
     /// Resets the iterators to the beginning of the cache values' arrays.
     void ResetIterators();
 
-    /// Returns the offset in number of rows into the cached values' buffer.
-    int ALWAYS_INLINE CurIdx() const {
-      return cur_expr_values_hash_ - expr_values_hash_array_.get();
-    }
-
     /// Max amount of memory in bytes for caching evaluated expression values.
     static const int MAX_EXPR_VALUES_ARRAY_SIZE = 256 << 10;
 
@@ -699,6 +727,8 @@ class HashTable {
 
   /// Returns a newly allocated HashTable. The probing algorithm is set by the
   /// FLAG_enable_quadratic_probing.
+  ///  - group_probing: true if buckets are probed in groups, see
+  ///    HashTableConfig::group_probing.
   ///  - allocator: allocator to allocate bucket directory and data pages from.
   ///  - stores_duplicates: true if rows with duplicate keys may be inserted into the
   ///    hash table.
@@ -711,9 +741,13 @@ class HashTable {
   ///    -1, if it unlimited.
   ///  - initial_num_buckets: number of buckets that the hash table should be initialized
   ///    with.
-  static HashTable* Create(Suballocator* allocator, bool stores_duplicates,
-      int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-      int64_t initial_num_buckets);
+  ///  - incremental_resize: true if the buckets are migrated to the resized bucket
+  ///    directory incrementally, see FinishResize(). Ignored if 'stores_duplicates' is
+  ///    true.
+  static HashTable* Create(bool group_probing, Suballocator* allocator,
+      bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+      int64_t max_num_buckets, int64_t initial_num_buckets,
+      bool incremental_resize = false);
 
   /// Allocates the initial bucket structure. Returns a non-OK status if an error is
   /// encountered. If an OK status is returned , 'got_memory' is set to indicate whether
@@ -750,6 +784,12 @@ class HashTable {
       BufferedTupleStream::FlatRowPtr flat_row, TupleRow* row,
       Status* status) WARN_UNUSED_RESULT;
 
+  /// Same as Insert(), except that the row is not inserted if the table already has a
+  /// row with the same key. Never allocates a duplicate node, so always returns true if
+  /// the table has free buckets. Used by joins that only need one build row per key.
+  bool IR_ALWAYS_INLINE InsertDistinct(HashTableCtx* __restrict__ ht_ctx,
+      BufferedTupleStream::FlatRowPtr flat_row, TupleRow* row);
+
   /// Prefetch the hash table bucket which the given hash value 'hash' maps to.
   /// Thread-safe for read-only hash tables.
   template <const bool READ>
@@ -766,10 +806,37 @@ class HashTable {
   /// Thread-safe for read-only hash tables.
   Iterator IR_ALWAYS_INLINE FindProbeRow(HashTableCtx* __restrict__ ht_ctx);
 
+  /// Returns an iterator to the rows of the filled bucket at 'bucket_idx', like
+  /// FindProbeRow() does for a probe row which matches them. Used to look up rows in
+  /// buckets which were found without probing, e.g. through a DirectJoinIndex.
+  /// Thread-safe for read-only hash tables.
+  Iterator IR_ALWAYS_INLINE BucketIterator(
+      HashTableCtx* __restrict__ ht_ctx, int64_t bucket_idx);
+
+  /// Returns the first row of the bucket at 'bucket_idx', stored in 'row', or nullptr if
+  /// the bucket is empty.
+  TupleRow* BucketRow(int64_t bucket_idx, TupleRow* row);
+
+  /// Looks up the first 'num_rows' rows of the ExprValuesCache in 'ht_ctx', which was
+  /// filled using EvalAndHashProbe(), and sets 'results[i]' to the iterator that
+  /// FindProbeRow() returns for row i in 'tables[i]', or to End() if 'tables[i]' is
+  /// NULL. Up to PIPELINED_PROBE_DEPTH look ups are in flight at once. Each one is a
+  /// small state machine which prefetches the memory that its next step reads - a
+  /// bucket, a duplicate node or the build row to compare with - and then lets the
+  /// other look ups proceed, so that their cache misses overlap. Tables with group
+  /// probing are probed with FindProbeRow() instead. Moves the ExprValuesCache back to
+  /// its first row. Used in the probe phase of hash joins.
+  /// Thread-safe for read-only hash tables.
+  static void IR_ALWAYS_INLINE FindProbeRowsPipelined(HashTable* const* tables,
+      int num_rows, HashTableCtx* __restrict__ ht_ctx, Iterator* results);
+
   /// If a match is found in the table, return an iterator as in FindProbeRow(). If a
   /// match was not present, return an iterator pointing to the empty bucket where the key
   /// should be inserted. Returns End() if the table is full. The caller can set the data
   /// in the bucket using a Set*() method on the iterator.
+  /// While an incremental resize is in progress, this also migrates a few buckets of
+  /// the old bucket directory and looks up keys that were not migrated yet in the old
+  /// bucket directory, see FinishResize().
   /// Thread-safe for read-only hash tables.
   Iterator IR_ALWAYS_INLINE FindBuildRowBucket(
       HashTableCtx* __restrict__ ht_ctx, bool* found);
@@ -827,9 +894,20 @@ class HashTable {
   Status CheckAndResize(uint64_t buckets_to_fill, HashTableCtx* __restrict__ ht_ctx,
       bool* got_memory) WARN_UNUSED_RESULT;
 
+  /// With incremental resizes, ResizeBuckets() only allocates the new bucket directory
+  /// and keeps the old one, whose buckets FindBuildRowBucket() migrates to the new one
+  /// a few at a time. This spreads the cost of rehashing over the following inserts
+  /// instead of stalling a single insert. Only FindBuildRowBucket() handles both bucket
+  /// directories, so this must be called before any other lookup, insert or iteration.
+  /// Migrates all remaining buckets and frees the old bucket directory. A no-op if no
+  /// incremental resize is in progress.
+  void FinishResize(HashTableCtx* __restrict__ ht_ctx);
+
   /// Returns the number of bytes allocated to the hash table from the block manager.
   int64_t ByteSize() const {
-    return num_buckets_ * sizeof(Bucket) + total_data_page_size_;
+    int64_t ctrl_size = group_probing_ ? num_buckets_ + old_num_buckets_ : 0;
+    return (num_buckets_ + old_num_buckets_) * sizeof(Bucket) + ctrl_size
+        + total_data_page_size_;
   }
 
   /// Returns an iterator at the beginning of the hash table.  Advancing this iterator
@@ -964,9 +1042,13 @@ class HashTable {
   /// of calling this constructor directly.
   ///  - quadratic_probing: set to true when the probing algorithm is quadratic, as
   ///    opposed to linear.
-  HashTable(bool quadratic_probing, Suballocator* allocator, bool stores_duplicates,
-      int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-      int64_t initial_num_buckets);
+  ///  - group_probing: set to true when buckets are probed in groups with their control
+  ///    bytes. 'initial_num_buckets' is rounded up to GROUP_SIZE in that case.
+  ///  - incremental_resize: set to true when buckets are migrated incrementally after
+  ///    resizes, see FinishResize().
+  HashTable(bool quadratic_probing, bool group_probing, Suballocator* allocator,
+      bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+      int64_t max_num_buckets, int64_t initial_num_buckets, bool incremental_resize);
 
   /// Performs the probing operation according to the probing algorithm (linear or
   /// quadratic. Returns one of the following:
@@ -985,6 +1067,9 @@ class HashTable {
   /// this function. The values of the expression values cache in 'ht_ctx' will be
   /// used to probe the hash table.
   ///
+  /// 'ctrl' are the control bytes of 'buckets' if group_probing() is true, or NULL
+  /// otherwise.
+  ///
   /// 'INCLUSIVE_EQUALITY' is true if NULLs and NaNs should always be
   /// considered equal when comparing two rows.
   ///
@@ -993,9 +1078,63 @@ class HashTable {
   ///
   /// There are wrappers of this function that perform the Find and Insert logic.
   template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW>
-  int64_t IR_ALWAYS_INLINE Probe(Bucket* buckets, int64_t num_buckets,
+  int64_t IR_ALWAYS_INLINE Probe(Bucket* buckets, uint8_t* ctrl, int64_t num_buckets,
       HashTableCtx* __restrict__ ht_ctx, uint32_t hash, bool* found);
 
+  /// Implementation of Probe() for group probing.
+  template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW>
+  int64_t IR_ALWAYS_INLINE ProbeGroups(Bucket* buckets, const uint8_t* ctrl,
+      int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, uint32_t hash,
+      bool* found);
+
+  /// Returns the control byte of a filled bucket with an entry with 'hash'. These are
+  /// the 7 bits below the bits that are used to partition the rows of spilling
+  /// operators, which are the same for all the entries of a hash table.
+  static uint8_t IR_ALWAYS_INLINE HashCtrl(uint32_t hash) { return (hash >> 21) & 0x7f; }
+
+  /// Allocates the control bytes for 'num_buckets' buckets and marks all of them empty.
+  /// Sets 'allocation' to nullptr if the memory could not be allocated.
+  Status AllocateCtrl(int64_t num_buckets, std::unique_ptr<Suballocation>* allocation);
+
+  /// State of a look up in FindProbeRowsPipelined().
+  struct PipelinedProbe {
+    /// The next step of the look up. The memory it reads has been prefetched.
+    enum Step {
+      /// Check the bucket at 'bucket_idx'.
+      READ_BUCKET,
+      /// Read the first duplicate node of the bucket at 'bucket_idx'.
+      READ_DUPLICATE,
+      /// Compare the row with the row of the bucket at 'bucket_idx'.
+      COMPARE_ROW
+    };
+    HashTable* table;
+    int row_idx;
+    uint32_t hash;
+    int64_t bucket_idx;
+    /// Number of buckets visited before 'bucket_idx', as 'step' in Probe().
+    int64_t num_steps;
+    Step step;
+  };
+
+  /// Initializes 'probe' for the look up of the row at 'row_idx' with 'hash' and
+  /// prefetches its first bucket.
+  void IR_ALWAYS_INLINE StartPipelinedProbe(HashTableCtx* __restrict__ ht_ctx,
+      int row_idx, uint32_t hash, PipelinedProbe* probe);
+
+  /// Performs the next step of 'probe' and prefetches the memory read by the step after
+  /// it. Returns true if the look up is finished, in which case 'result' is set if the
+  /// row was found.
+  bool IR_ALWAYS_INLINE StepPipelinedProbe(HashTableCtx* __restrict__ ht_ctx,
+      PipelinedProbe* probe, Iterator* result);
+
+  /// Moves 'probe' to the next bucket according to the probing algorithm and prefetches
+  /// it. Returns false if all buckets have been visited.
+  bool IR_ALWAYS_INLINE NextPipelinedBucket(
+      HashTableCtx* __restrict__ ht_ctx, PipelinedProbe* probe);
+
+  /// Prefetches the row pointed by 'htdata'.
+  void IR_ALWAYS_INLINE PrefetchRow(const HtData& htdata) const;
+
   /// Performs the insert logic. Returns the HtData* of the bucket or duplicate node
   /// where the data should be inserted. Returns NULL if the insert was not successful
   /// and either sets 'status' to OK if it failed because not enough reservation was
@@ -1009,10 +1148,27 @@ class HashTable {
   /// 'bucket_idx' to BUCKET_NOT_FOUND.
   void NextFilledBucket(int64_t* bucket_idx, DuplicateNode** node);
 
-  /// Resize the hash table to 'num_buckets'. 'got_memory' is false on OOM.
+  /// Resize the hash table to 'num_buckets'. 'got_memory' is false on OOM. With
+  /// incremental resizes, the buckets are not copied here, see FinishResize().
   Status ResizeBuckets(
       int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, bool* got_memory);
 
+  /// Copies 'bucket' into the first empty bucket of its probe sequence in 'buckets',
+  /// which has 'num_buckets' buckets and the control bytes 'ctrl'.
+  void CopyBucket(const Bucket* bucket, Bucket* buckets, uint8_t* ctrl,
+      int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx);
+
+  /// Migrates up to 'max_buckets' buckets of the old bucket directory to 'buckets_',
+  /// continuing at 'migrate_idx_'. Frees the old bucket directory once all its buckets
+  /// are migrated.
+  void MigrateBuckets(int64_t max_buckets, HashTableCtx* __restrict__ ht_ctx);
+
+  /// Looks up the last row evaluated in 'ht_ctx' with 'hash' in the old bucket directory.
+  /// If it is found, migrates its bucket to the empty bucket 'bucket_idx' of 'buckets_'
+  /// that FindBuildRowBucket() returned and sets 'found' to true.
+  void MigrateBuildRowBucket(HashTableCtx* __restrict__ ht_ctx, uint32_t hash,
+      int64_t bucket_idx, bool* found);
+
   /// Appends the DuplicateNode pointed by next_node_ to 'bucket' and moves the next_node_
   /// pointer to the next DuplicateNode in the page, updating the remaining node counter.
   DuplicateNode* IR_ALWAYS_INLINE AppendNextNode(Bucket* bucket);
@@ -1049,6 +1205,7 @@ class HashTable {
   bool IR_NO_INLINE stores_tuples() const { return stores_tuples_; }
   bool IR_NO_INLINE stores_duplicates() const { return stores_duplicates_; }
   bool IR_NO_INLINE quadratic_probing() const { return quadratic_probing_; }
+  bool IR_NO_INLINE group_probing() const { return group_probing_; }
 
   /// Load factor that will trigger growing the hash table on insert.  This is
   /// defined as the number of non-empty buckets / total_buckets
@@ -1059,6 +1216,25 @@ class HashTable {
   /// enough to not waste excessive memory to internal fragmentation.
   static constexpr int64_t DATA_PAGE_SIZE = 64L * 1024;
 
+  /// Number of look ups that FindProbeRowsPipelined() keeps in flight. Enough to hide
+  /// most of the memory latency without running out of line fill buffers.
+  static constexpr int PIPELINED_PROBE_DEPTH = 8;
+
+  /// Number of old buckets that each FindBuildRowBucket() call migrates during an
+  /// incremental resize. The old bucket directory has half as many buckets as the new
+  /// one, so it is migrated after inserting 1/8th of the new buckets, well before the
+  /// new bucket directory is full enough for the next resize.
+  static constexpr int64_t MIGRATE_BUCKETS_PER_FIND = 4;
+
+  /// Number of buckets that are probed together with group probing. The control bytes
+  /// of a group fit in a 128-bit SIMD register.
+  static constexpr int LOG_GROUP_SIZE = 4;
+  static constexpr int64_t GROUP_SIZE = 1L << LOG_GROUP_SIZE;
+
+  /// Control byte of an empty bucket. Only the high bit is set, which distinguishes it
+  /// from the control bytes of filled buckets.
+  static constexpr uint8_t EMPTY_CTRL = 0x80;
+
   RuntimeState* state_;
 
   /// Suballocator to allocate data pages and hash table buckets with.
@@ -1080,6 +1256,13 @@ class HashTable {
   /// Quadratic probing enabled (as opposed to linear).
   const bool quadratic_probing_;
 
+  /// Group probing enabled.
+  const bool group_probing_;
+
+  /// True if resizes migrate buckets incrementally, see FinishResize(). Only set for
+  /// hash tables that do not store duplicates.
+  const bool incremental_resize_;
+
   /// Data pages for all nodes. Allocated from suballocator to reduce memory
   /// consumption of small tables.
   std::vector<std::unique_ptr<Suballocation>> data_pages_;
@@ -1104,9 +1287,29 @@ class HashTable {
   /// Pointer to the 'buckets_' array from 'bucket_allocation_'.
   Bucket* buckets_ = nullptr;
 
+  /// Allocation containing the control bytes of all buckets. Only used with group
+  /// probing.
+  std::unique_ptr<Suballocation> ctrl_allocation_;
+
+  /// Pointer to the control bytes from 'ctrl_allocation_', one per bucket. NULL unless
+  /// group probing is enabled.
+  uint8_t* ctrl_ = nullptr;
+
   /// Total number of buckets (filled and empty).
   int64_t num_buckets_;
 
+  /// The bucket directory and control bytes before the last resize while an incremental
+  /// resize is in progress, see FinishResize(). 'old_buckets_' is NULL otherwise. Buckets
+  /// that FindBuildRowBucket() migrated ahead of 'migrate_idx_' have 'matched' set.
+  std::unique_ptr<Suballocation> old_bucket_allocation_;
+  std::unique_ptr<Suballocation> old_ctrl_allocation_;
+  Bucket* old_buckets_ = nullptr;
+  uint8_t* old_ctrl_ = nullptr;
+  int64_t old_num_buckets_ = 0;
+
+  /// The index of the next bucket of 'old_buckets_' to migrate.
+  int64_t migrate_idx_ = 0;
+
   /// Number of non-empty buckets.  Used to determine when to resize.
   int64_t num_filled_buckets_ = 0;
 
@@ -20,6 +20,7 @@
 #define IMPALA_EXEC_HASH_TABLE_INLINE_H
 
 #include "exec/hash-table.h"
+#include "util/sse-util.h"
 
 namespace impala {
 
@@ -49,11 +50,15 @@ inline void HashTableCtx::ExprValuesCache::NextRow() {
 }
 
 template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW>
-inline int64_t HashTable::Probe(Bucket* buckets, int64_t num_buckets,
+inline int64_t HashTable::Probe(Bucket* buckets, uint8_t* ctrl, int64_t num_buckets,
     HashTableCtx* __restrict__ ht_ctx, uint32_t hash, bool* found) {
   DCHECK(ht_ctx != nullptr);
   DCHECK(buckets != nullptr);
   DCHECK_GT(num_buckets, 0);
+  if (group_probing()) {
+    return ProbeGroups<INCLUSIVE_EQUALITY, COMPARE_ROW>(
+        buckets, ctrl, num_buckets, ht_ctx, hash, found);
+  }
   *found = false;
   ++ht_ctx->num_probes_;
   int64_t bucket_idx = hash & (num_buckets - 1);
@@ -93,11 +98,66 @@ inline int64_t HashTable::Probe(Bucket* buckets, int64_t num_buckets,
   return Iterator::BUCKET_NOT_FOUND;
 }
 
+template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW>
+inline int64_t HashTable::ProbeGroups(Bucket* buckets, const uint8_t* ctrl,
+    int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, uint32_t hash,
+    bool* found) {
+  DCHECK(ctrl != nullptr);
+  DCHECK_GE(num_buckets, GROUP_SIZE);
+  *found = false;
+  ++ht_ctx->num_probes_;
+  const int64_t num_groups = num_buckets >> LOG_GROUP_SIZE;
+  int64_t group_idx = (hash & (num_buckets - 1)) >> LOG_GROUP_SIZE;
+  const __m128i hash_ctrl = _mm_set1_epi8(HashCtrl(hash));
+
+  // Counts the groups visited, as 'step' in Probe() counts the buckets.
+  int64_t step = 0;
+  do {
+    const int64_t group_start = group_idx << LOG_GROUP_SIZE;
+    const __m128i group_ctrl =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl + group_start));
+    // Check the buckets whose control byte matches the hash, in order.
+    uint32_t candidates = _mm_movemask_epi8(_mm_cmpeq_epi8(group_ctrl, hash_ctrl));
+    while (candidates != 0) {
+      int64_t bucket_idx = group_start + BitUtil::CountTrailingZeros(candidates);
+      Bucket* bucket = &buckets[bucket_idx];
+      DCHECK(bucket->filled);
+      if (hash == bucket->hash) {
+        if (COMPARE_ROW
+            && ht_ctx->Equals<INCLUSIVE_EQUALITY>(GetRow(bucket, ht_ctx->scratch_row_))) {
+          *found = true;
+          return bucket_idx;
+        }
+        ++ht_ctx->num_hash_collisions_;
+      }
+      candidates &= candidates - 1;
+    }
+    // Only the high bit of EMPTY_CTRL is set, so this is the mask of empty buckets. The
+    // table does not support removes, so an entry equal to the row would have been
+    // inserted into the first empty bucket of the group.
+    uint32_t empty = _mm_movemask_epi8(group_ctrl);
+    if (LIKELY(empty != 0)) return group_start + BitUtil::CountTrailingZeros(empty);
+    ++step;
+    ++ht_ctx->travel_length_;
+    if (quadratic_probing()) {
+      group_idx = (group_idx + step) & (num_groups - 1);
+    } else {
+      group_idx = (group_idx + 1) & (num_groups - 1);
+    }
+  } while (LIKELY(step < num_groups));
+
+  DCHECK_EQ(num_filled_buckets_, num_buckets) << "Probing of a non-full table "
+      << "failed: " << quadratic_probing() << " " << hash;
+  return Iterator::BUCKET_NOT_FOUND;
+}
+
 inline HashTable::HtData* HashTable::InsertInternal(
     HashTableCtx* __restrict__ ht_ctx, Status* status) {
+  DCHECK(old_buckets_ == nullptr) << "FinishResize() was not called";
   bool found = false;
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
-  int64_t bucket_idx = Probe<true, true>(buckets_, num_buckets_, ht_ctx, hash, &found);
+  int64_t bucket_idx = Probe<true, true>(
+      buckets_, ctrl_, num_buckets_, ht_ctx, hash, &found);
   DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND);
   if (found) {
     // We need to insert a duplicate node, note that this may fail to allocate memory.
@@ -125,6 +185,25 @@ inline bool HashTable::Insert(HashTableCtx* __restrict__ ht_ctx,
   return false;
 }
 
+inline bool HashTable::InsertDistinct(HashTableCtx* __restrict__ ht_ctx,
+    BufferedTupleStream::FlatRowPtr flat_row, TupleRow* row) {
+  DCHECK(old_buckets_ == nullptr) << "FinishResize() was not called";
+  bool found = false;
+  uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
+  int64_t bucket_idx = Probe<true, true>(
+      buckets_, ctrl_, num_buckets_, ht_ctx, hash, &found);
+  DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND);
+  if (found) return true;
+  PrepareBucketForInsert(bucket_idx, hash);
+  HtData* htdata = &buckets_[bucket_idx].bucketData.htdata;
+  if (stores_tuples()) {
+    htdata->tuple = row->GetTuple(0);
+  } else {
+    htdata->flat_row = flat_row;
+  }
+  return true;
+}
+
 template<const bool READ>
 inline void HashTable::PrefetchBucket(uint32_t hash) {
   int64_t bucket_idx = hash & (num_buckets_ - 1);
@@ -134,12 +213,17 @@ inline void HashTable::PrefetchBucket(uint32_t hash) {
   // On x86, they map to instructions prefetchnta and prefetch{2-0} respectively.
   // TODO: Reconsider the locality level with smaller prefetch batch size.
   __builtin_prefetch(&buckets_[bucket_idx], READ ? 0 : 1, 1);
+  if (group_probing()) {
+    __builtin_prefetch(&ctrl_[bucket_idx & ~(GROUP_SIZE - 1)], READ ? 0 : 1, 1);
+  }
 }
 
 inline HashTable::Iterator HashTable::FindProbeRow(HashTableCtx* __restrict__ ht_ctx) {
+  DCHECK(old_buckets_ == nullptr) << "FinishResize() was not called";
   bool found = false;
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
-  int64_t bucket_idx = Probe<false, true>(buckets_, num_buckets_, ht_ctx, hash, &found);
+  int64_t bucket_idx = Probe<false, true>(
+      buckets_, ctrl_, num_buckets_, ht_ctx, hash, &found);
   if (found) {
     return Iterator(this, ht_ctx->scratch_row(), bucket_idx,
         stores_duplicates() ? buckets_[bucket_idx].bucketData.duplicates : NULL);
@@ -147,11 +231,144 @@ inline HashTable::Iterator HashTable::FindProbeRow(HashTableCtx* __restrict__ ht
   return End();
 }
 
+inline HashTable::Iterator HashTable::BucketIterator(
+    HashTableCtx* __restrict__ ht_ctx, int64_t bucket_idx) {
+  DCHECK_GE(bucket_idx, 0);
+  DCHECK_LT(bucket_idx, num_buckets_);
+  DCHECK(buckets_[bucket_idx].filled);
+  return Iterator(this, ht_ctx->scratch_row(), bucket_idx,
+      stores_duplicates() ? buckets_[bucket_idx].bucketData.duplicates : NULL);
+}
+
+inline TupleRow* HashTable::BucketRow(int64_t bucket_idx, TupleRow* row) {
+  DCHECK_GE(bucket_idx, 0);
+  DCHECK_LT(bucket_idx, num_buckets_);
+  Bucket* bucket = &buckets_[bucket_idx];
+  return bucket->filled ? GetRow(bucket, row) : nullptr;
+}
+
 // TODO: support lazy evaluation like HashTable::Insert().
+inline void HashTable::FindProbeRowsPipelined(HashTable* const* tables, int num_rows,
+    HashTableCtx* __restrict__ ht_ctx, Iterator* results) {
+  HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
+  PipelinedProbe probes[PIPELINED_PROBE_DEPTH];
+  int num_in_flight = 0;
+  int next_row = 0;
+  while (true) {
+    // Start look ups until PIPELINED_PROBE_DEPTH of them are in flight.
+    while (num_in_flight < PIPELINED_PROBE_DEPTH && next_row < num_rows) {
+      int row_idx = next_row++;
+      HashTable* table = tables[row_idx];
+      results[row_idx] = Iterator();
+      if (table == nullptr) continue;
+      expr_vals_cache->SeekToRow(row_idx);
+      if (table->group_probing()) {
+        results[row_idx] = table->FindProbeRow(ht_ctx);
+        continue;
+      }
+      table->StartPipelinedProbe(ht_ctx, row_idx, expr_vals_cache->CurExprValuesHash(),
+          &probes[num_in_flight++]);
+    }
+    if (num_in_flight == 0) break;
+    // Advance each look up by one step. Finished look ups are replaced by the last one.
+    for (int i = 0; i < num_in_flight;) {
+      PipelinedProbe* probe = &probes[i];
+      if (probe->table->StepPipelinedProbe(ht_ctx, probe, &results[probe->row_idx])) {
+        probes[i] = probes[--num_in_flight];
+      } else {
+        ++i;
+      }
+    }
+  }
+  expr_vals_cache->SeekToRow(0);
+}
+
+inline void HashTable::StartPipelinedProbe(HashTableCtx* __restrict__ ht_ctx,
+    int row_idx, uint32_t hash, PipelinedProbe* probe) {
+  DCHECK(!group_probing());
+  DCHECK_GT(num_buckets_, 0);
+  ++ht_ctx->num_probes_;
+  probe->table = this;
+  probe->row_idx = row_idx;
+  probe->hash = hash;
+  probe->bucket_idx = hash & (num_buckets_ - 1);
+  probe->num_steps = 0;
+  probe->step = PipelinedProbe::READ_BUCKET;
+  __builtin_prefetch(&buckets_[probe->bucket_idx], 0, 1);
+}
+
+inline bool HashTable::StepPipelinedProbe(HashTableCtx* __restrict__ ht_ctx,
+    PipelinedProbe* probe, Iterator* result) {
+  Bucket* bucket = &buckets_[probe->bucket_idx];
+  switch (probe->step) {
+    case PipelinedProbe::READ_BUCKET:
+      if (LIKELY(!bucket->filled)) return true;
+      if (probe->hash != bucket->hash) return !NextPipelinedBucket(ht_ctx, probe);
+      if (stores_duplicates() && bucket->hasDuplicates) {
+        __builtin_prefetch(bucket->bucketData.duplicates, 0, 1);
+        probe->step = PipelinedProbe::READ_DUPLICATE;
+      } else {
+        PrefetchRow(bucket->bucketData.htdata);
+        probe->step = PipelinedProbe::COMPARE_ROW;
+      }
+      return false;
+    case PipelinedProbe::READ_DUPLICATE:
+      PrefetchRow(bucket->bucketData.duplicates->htdata);
+      probe->step = PipelinedProbe::COMPARE_ROW;
+      return false;
+    case PipelinedProbe::COMPARE_ROW:
+      ht_ctx->expr_values_cache()->SeekToRow(probe->row_idx);
+      if (ht_ctx->Equals<false>(GetRow(bucket, ht_ctx->scratch_row_))) {
+        *result = Iterator(this, ht_ctx->scratch_row(), probe->bucket_idx,
+            stores_duplicates() ? bucket->bucketData.duplicates : NULL);
+        return true;
+      }
+      // Row equality failed. This is a hash collision. Continue searching.
+      ++ht_ctx->num_hash_collisions_;
+      probe->step = PipelinedProbe::READ_BUCKET;
+      return !NextPipelinedBucket(ht_ctx, probe);
+  }
+  DCHECK(false) << "Invalid step " << probe->step;
+  return true;
+}
+
+inline bool HashTable::NextPipelinedBucket(
+    HashTableCtx* __restrict__ ht_ctx, PipelinedProbe* probe) {
+  ++probe->num_steps;
+  ++ht_ctx->travel_length_;
+  if (UNLIKELY(probe->num_steps >= num_buckets_)) {
+    DCHECK_EQ(num_filled_buckets_, num_buckets_);
+    return false;
+  }
+  // Same probing sequence as Probe().
+  if (quadratic_probing()) {
+    probe->bucket_idx = (probe->bucket_idx + probe->num_steps) & (num_buckets_ - 1);
+  } else {
+    probe->bucket_idx = (probe->bucket_idx + 1) & (num_buckets_ - 1);
+  }
+  __builtin_prefetch(&buckets_[probe->bucket_idx], 0, 1);
+  return true;
+}
+
+inline void HashTable::PrefetchRow(const HtData& htdata) const {
+  if (stores_tuples()) {
+    __builtin_prefetch(htdata.tuple, 0, 1);
+  } else {
+    __builtin_prefetch(htdata.flat_row, 0, 1);
+  }
+}
+
 inline HashTable::Iterator HashTable::FindBuildRowBucket(
     HashTableCtx* __restrict__ ht_ctx, bool* found) {
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
-  int64_t bucket_idx = Probe<true, true>(buckets_, num_buckets_, ht_ctx, hash, found);
+  if (UNLIKELY(old_buckets_ != nullptr)) MigrateBuckets(MIGRATE_BUCKETS_PER_FIND, ht_ctx);
+  int64_t bucket_idx = Probe<true, true>(
+      buckets_, ctrl_, num_buckets_, ht_ctx, hash, found);
+  if (UNLIKELY(old_buckets_ != nullptr) && !*found
+      && LIKELY(bucket_idx != Iterator::BUCKET_NOT_FOUND)) {
+    // The row may be in a bucket that was not migrated yet.
+    MigrateBuildRowBucket(ht_ctx, hash, bucket_idx, found);
+  }
   DuplicateNode* duplicates = NULL;
   if (stores_duplicates() && LIKELY(bucket_idx != Iterator::BUCKET_NOT_FOUND)) {
     duplicates = buckets_[bucket_idx].bucketData.duplicates;
@@ -160,6 +377,7 @@ inline HashTable::Iterator HashTable::FindBuildRowBucket(
 }
 
 inline HashTable::Iterator HashTable::Begin(const HashTableCtx* ctx) {
+  DCHECK(old_buckets_ == nullptr) << "FinishResize() was not called";
   int64_t bucket_idx = Iterator::BUCKET_NOT_FOUND;
   DuplicateNode* node = NULL;
   NextFilledBucket(&bucket_idx, &node);
@@ -167,6 +385,7 @@ inline HashTable::Iterator HashTable::Begin(const HashTableCtx* ctx) {
 }
 
 inline HashTable::Iterator HashTable::FirstUnmatched(HashTableCtx* ctx) {
+  DCHECK(old_buckets_ == nullptr) << "FinishResize() was not called";
   int64_t bucket_idx = Iterator::BUCKET_NOT_FOUND;
   DuplicateNode* node = NULL;
   NextFilledBucket(&bucket_idx, &node);
@@ -204,6 +423,7 @@ inline void HashTable::PrepareBucketForInsert(int64_t bucket_idx, uint32_t hash)
   bucket->matched = false;
   bucket->hasDuplicates = false;
   bucket->hash = hash;
+  if (group_probing()) ctrl_[bucket_idx] = HashCtrl(hash);
 }
 
 inline HashTable::DuplicateNode* HashTable::AppendNextNode(Bucket* bucket) {
@@ -389,7 +609,8 @@ inline void HashTableCtx::set_level(int level) {
 }
 
 inline int64_t HashTable::CurrentMemSize() const {
-  return num_buckets_ * sizeof(Bucket) + num_duplicate_nodes_ * sizeof(DuplicateNode);
+  return (num_buckets_ + old_num_buckets_) * sizeof(Bucket)
+      + num_duplicate_nodes_ * sizeof(DuplicateNode);
 }
 
 inline int64_t HashTable::NumInsertsBeforeResize() const {
@@ -20,6 +20,7 @@
 
 #include <cstring>
 #include <algorithm>
+#include <gflags/gflags.h>
 
 #include "util/bit-util.h"
 #include "util/jni-util.h"
@@ -35,6 +36,14 @@
 using namespace impala;
 using namespace strings;
 
+DEFINE_int32(hbase_scanners_in_flight, 2, "(Advanced) The number of HBase "
+    "ResultScanners that an HBase scan node keeps open at the same time. Scanners of the "
+    "following regions are opened while the current region is scanned, so that the "
+    "region servers work on them in parallel. 1 opens one region after the other.");
+DEFINE_bool(hbase_scan_async_prefetch, true, "(Advanced) If true, HBase scans let the "
+    "HBase client prefetch the next batch of results in the background, if the HBase "
+    "version supports it.");
+
 jclass HBaseTableScanner::scan_cl_ = NULL;
 jclass HBaseTableScanner::resultscanner_cl_ = NULL;
 jclass HBaseTableScanner::result_cl_ = NULL;
@@ -46,14 +55,16 @@ jclass HBaseTableScanner::single_column_value_filter_cl_ = NULL;
 jclass HBaseTableScanner::compare_op_cl_ = NULL;
 jclass HBaseTableScanner::scanner_timeout_ex_cl_ = NULL;
 jmethodID HBaseTableScanner::scan_ctor_ = NULL;
+jmethodID HBaseTableScanner::scan_copy_ctor_ = NULL;
 jmethodID HBaseTableScanner::scan_set_max_versions_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_caching_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_cache_blocks_id_ = NULL;
+jmethodID HBaseTableScanner::scan_set_async_prefetch_id_ = NULL;
 jmethodID HBaseTableScanner::scan_add_column_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_filter_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_start_row_id_ = NULL;
 jmethodID HBaseTableScanner::scan_set_stop_row_id_ = NULL;
-jmethodID HBaseTableScanner::resultscanner_next_id_ = NULL;
+jmethodID HBaseTableScanner::resultscanner_next_batch_id_ = NULL;
 jmethodID HBaseTableScanner::resultscanner_close_id_ = NULL;
 jmethodID HBaseTableScanner::result_isempty_id_ = NULL;
 jmethodID HBaseTableScanner::result_raw_cells_id_ = NULL;
@@ -98,6 +109,10 @@ HBaseTableScanner::HBaseTableScanner(
     htable_(NULL),
     scan_(NULL),
     resultscanner_(NULL),
+    next_open_scan_range_idx_(0),
+    results_(NULL),
+    num_results_(0),
+    result_idx_(0),
     cells_(NULL),
     cell_index_(0),
     num_requested_cells_(0),
@@ -106,7 +121,11 @@ HBaseTableScanner::HBaseTableScanner(
     all_cells_present_(false),
     value_pool_(new MemPool(scan_node_->mem_tracker(), true)),
     scan_setup_timer_(ADD_TIMER(scan_node_->runtime_profile(),
-      "HBaseTableScanner.ScanSetup")) {
+      "HBaseTableScanner.ScanSetup")),
+    result_batches_counter_(ADD_COUNTER(scan_node_->runtime_profile(),
+      "HBaseTableScanner.ResultBatches", TUnit::UNIT)),
+    scanners_opened_ahead_counter_(ADD_COUNTER(scan_node_->runtime_profile(),
+      "HBaseTableScanner.ScannersOpenedAhead", TUnit::UNIT)) {
   const TQueryOptions& query_option = state->query_options();
   if (query_option.__isset.hbase_caching && query_option.hbase_caching > 0) {
     rows_cached_ = query_option.hbase_caching;
@@ -167,6 +186,9 @@ Status HBaseTableScanner::Init() {
   // Scan method ids.
   scan_ctor_ = env->GetMethodID(scan_cl_, "<init>", "()V");
   RETURN_ERROR_IF_EXC(env);
+  scan_copy_ctor_ = env->GetMethodID(scan_cl_, "<init>",
+      "(Lorg/apache/hadoop/hbase/client/Scan;)V");
+  RETURN_ERROR_IF_EXC(env);
   scan_set_max_versions_id_ = env->GetMethodID(scan_cl_, "setMaxVersions",
       "(I)Lorg/apache/hadoop/hbase/client/Scan;");
   RETURN_ERROR_IF_EXC(env);
@@ -188,6 +210,17 @@ Status HBaseTableScanner::Init() {
     RETURN_ERROR_IF_EXC(env);
   }
 
+  // setAsyncPrefetch() was added in HBase 1.1 and returns a Scan object since 2.0.
+  if (JniUtil::MethodExists(env, scan_cl_, "setAsyncPrefetch",
+      "(Z)Lorg/apache/hadoop/hbase/client/Scan;")) {
+    scan_set_async_prefetch_id_ = env->GetMethodID(scan_cl_, "setAsyncPrefetch",
+        "(Z)Lorg/apache/hadoop/hbase/client/Scan;");
+    RETURN_ERROR_IF_EXC(env);
+  } else if (JniUtil::MethodExists(env, scan_cl_, "setAsyncPrefetch", "(Z)V")) {
+    scan_set_async_prefetch_id_ = env->GetMethodID(scan_cl_, "setAsyncPrefetch", "(Z)V");
+    RETURN_ERROR_IF_EXC(env);
+  }
+
   scan_add_column_id_ = env->GetMethodID(scan_cl_, "addColumn",
       "([B[B)Lorg/apache/hadoop/hbase/client/Scan;");
   RETURN_ERROR_IF_EXC(env);
@@ -203,8 +236,8 @@ Status HBaseTableScanner::Init() {
   RETURN_ERROR_IF_EXC(env);
 
   // ResultScanner method ids.
-  resultscanner_next_id_ = env->GetMethodID(resultscanner_cl_, "next",
-      "()Lorg/apache/hadoop/hbase/client/Result;");
+  resultscanner_next_batch_id_ = env->GetMethodID(resultscanner_cl_, "next",
+      "(I)[Lorg/apache/hadoop/hbase/client/Result;");
   RETURN_ERROR_IF_EXC(env);
   resultscanner_close_id_ = env->GetMethodID(resultscanner_cl_, "close", "()V");
   RETURN_ERROR_IF_EXC(env);
@@ -322,6 +355,12 @@ Status HBaseTableScanner::ScanSetup(JNIEnv* env, const TupleDescriptor* tuple_de
   env->CallObjectMethod(scan_, scan_set_cache_blocks_id_, cache_blocks_);
   RETURN_ERROR_IF_EXC(env);
 
+  if (FLAGS_hbase_scan_async_prefetch && scan_set_async_prefetch_id_ != NULL) {
+    // scan_.setAsyncPrefetch(true);
+    env->CallObjectMethod(scan_, scan_set_async_prefetch_id_, JNI_TRUE);
+    RETURN_ERROR_IF_EXC(env);
+  }
+
   const vector<SlotDescriptor*>& slots = tuple_desc->slots();
   // Restrict scan to materialized families/qualifiers.
   for (int i = 0; i < slots.size(); ++i) {
@@ -451,14 +490,6 @@ Status HBaseTableScanner::InitScanRange(JNIEnv* env, const ScanRange& scan_range
 
 Status HBaseTableScanner::InitScanRange(JNIEnv* env, jbyteArray start_bytes,
     jbyteArray end_bytes) {
-  // scan_.setStartRow(start_bytes);
-  env->CallObjectMethod(scan_, scan_set_start_row_id_, start_bytes);
-  RETURN_ERROR_IF_EXC(env);
-
-  // scan_.setStopRow(end_bytes);
-  env->CallObjectMethod(scan_, scan_set_stop_row_id_, end_bytes);
-  RETURN_ERROR_IF_EXC(env);
-
   if (resultscanner_ != NULL) {
     // resultscanner_.close();
     env->CallObjectMethod(resultscanner_, resultscanner_close_id_);
@@ -466,13 +497,91 @@ Status HBaseTableScanner::InitScanRange(JNIEnv* env, jbyteArray start_bytes,
     env->DeleteGlobalRef(resultscanner_);
     resultscanner_ = NULL;
   }
-  // resultscanner_ = htable_.getScanner(scan_);
+  return OpenResultScanner(env, start_bytes, end_bytes, &resultscanner_);
+}
+
+Status HBaseTableScanner::OpenResultScanner(JNIEnv* env, jbyteArray start_bytes,
+    jbyteArray end_bytes, jobject* resultscanner) {
+  JniLocalFrame jni_frame;
+  RETURN_IF_ERROR(jni_frame.push(env));
+  // Every open ResultScanner needs its own Scan, since the client keeps using it.
+  // scan = new Scan(scan_);
+  jobject scan = env->NewObject(scan_cl_, scan_copy_ctor_, scan_);
+  RETURN_ERROR_IF_EXC(env);
+
+  // scan.setStartRow(start_bytes);
+  env->CallObjectMethod(scan, scan_set_start_row_id_, start_bytes);
+  RETURN_ERROR_IF_EXC(env);
+
+  // scan.setStopRow(end_bytes);
+  env->CallObjectMethod(scan, scan_set_stop_row_id_, end_bytes);
+  RETURN_ERROR_IF_EXC(env);
+
+  // resultscanner = htable_.getScanner(scan);
   jobject local_resultscanner;
-  RETURN_IF_ERROR(htable_->GetResultScanner(scan_, &local_resultscanner));
-  RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, local_resultscanner, &resultscanner_));
+  RETURN_IF_ERROR(htable_->GetResultScanner(scan, &local_resultscanner));
+  RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, local_resultscanner, resultscanner));
+  return Status::OK();
+}
+
+void HBaseTableScanner::CloseResultScanner(JNIEnv* env, jobject resultscanner) {
+  // resultscanner.close();
+  env->CallObjectMethod(resultscanner, resultscanner_close_id_);
+  // Manually check if the ResultScanner timed out so that we can log a less scary
+  // and more specific message.
+  jthrowable exc = env->ExceptionOccurred();
+  if (exc != NULL) {
+    if (scanner_timeout_ex_cl_ != NULL
+        && env->IsInstanceOf(exc, scanner_timeout_ex_cl_) == JNI_TRUE) {
+      env->ExceptionClear();
+      LOG(INFO) << "ResultScanner timed out before it was closed "
+                << "(this does not necessarily indicate a problem)";
+    } else {
+      // GetJniExceptionMsg will clear the exception status and log
+      Status status = JniUtil::GetJniExceptionMsg(env, true,
+          "Unknown error occurred while closing ResultScanner: ");
+      if (!status.ok()) LOG(WARNING) << "Error closing ResultScanner()";
+    }
+  }
+  env->DeleteGlobalRef(resultscanner);
+}
+
+Status HBaseTableScanner::OpenPendingResultScanners(JNIEnv* env) {
+  int max_open_scan_range_idx =
+      current_scan_range_idx_ + max(1, FLAGS_hbase_scanners_in_flight) - 1;
+  while (next_open_scan_range_idx_ < scan_range_vector_->size()
+      && next_open_scan_range_idx_ <= max_open_scan_range_idx) {
+    JniLocalFrame jni_frame;
+    RETURN_IF_ERROR(jni_frame.push(env));
+    const ScanRange& scan_range = (*scan_range_vector_)[next_open_scan_range_idx_];
+    jbyteArray start_bytes;
+    RETURN_IF_ERROR(CreateByteArray(env, scan_range.start_key(), &start_bytes));
+    jbyteArray end_bytes;
+    RETURN_IF_ERROR(CreateByteArray(env, scan_range.stop_key(), &end_bytes));
+    jobject resultscanner;
+    RETURN_IF_ERROR(OpenResultScanner(env, start_bytes, end_bytes, &resultscanner));
+    pending_resultscanners_.push_back(resultscanner);
+    ++next_open_scan_range_idx_;
+    COUNTER_ADD(scanners_opened_ahead_counter_, 1);
+  }
   return Status::OK();
 }
 
+Status HBaseTableScanner::NextScanRange(JNIEnv* env) {
+  DCHECK_LT(current_scan_range_idx_ + 1, scan_range_vector_->size());
+  ++current_scan_range_idx_;
+  if (pending_resultscanners_.empty()) {
+    RETURN_IF_ERROR(InitScanRange(env, (*scan_range_vector_)[current_scan_range_idx_]));
+    next_open_scan_range_idx_ = current_scan_range_idx_ + 1;
+  } else {
+    DCHECK(resultscanner_ != NULL);
+    CloseResultScanner(env, resultscanner_);
+    resultscanner_ = pending_resultscanners_.front();
+    pending_resultscanners_.pop_front();
+  }
+  return OpenPendingResultScanners(env);
+}
+
 Status HBaseTableScanner::StartScan(JNIEnv* env, const TupleDescriptor* tuple_desc,
     const ScanRangeVector& scan_range_vector, const vector<THBaseFilter>& filters) {
   DCHECK(scan_range_vector.size() > 0);
@@ -487,7 +596,9 @@ Status HBaseTableScanner::StartScan(JNIEnv* env, const TupleDescriptor* tuple_de
   // resultscanner_ is NULL and gets created in InitScanRange, so we don't
   // need to check if it timed out.
   DCHECK(resultscanner_ == NULL);
-  return InitScanRange(env, (*scan_range_vector_)[current_scan_range_idx_]);
+  RETURN_IF_ERROR(InitScanRange(env, (*scan_range_vector_)[current_scan_range_idx_]));
+  next_open_scan_range_idx_ = current_scan_range_idx_ + 1;
+  return OpenPendingResultScanners(env);
 }
 
 Status HBaseTableScanner::CreateByteArray(JNIEnv* env, const string& s,
@@ -505,6 +616,39 @@ Status HBaseTableScanner::CreateByteArray(JNIEnv* env, const string& s,
   return Status::OK();
 }
 
+Status HBaseTableScanner::FetchResults(JNIEnv* env) {
+  if (results_ != NULL) {
+    env->DeleteGlobalRef(results_);
+    results_ = NULL;
+  }
+  num_results_ = 0;
+  result_idx_ = 0;
+  JniLocalFrame jni_frame;
+  RETURN_IF_ERROR(jni_frame.push(env));
+  DCHECK(resultscanner_ != NULL);
+  // results = resultscanner_.next(rows_cached_);
+  COUNTER_ADD(result_batches_counter_, 1);
+  jobject local_results =
+      env->CallObjectMethod(resultscanner_, resultscanner_next_batch_id_, rows_cached_);
+  RETURN_ERROR_IF_EXC(env);
+  // Normally we would check for a JNI exception via RETURN_ERROR_IF_EXC, but we
+  // need to also check for scanner timeouts and handle them specially, which is
+  // done by HandleResultScannerTimeout(). If a timeout occurred, then it will
+  // re-create the ResultScanner so we can try again.
+  bool timeout;
+  RETURN_IF_ERROR(HandleResultScannerTimeout(env, &timeout));
+  if (timeout) {
+    local_results =
+        env->CallObjectMethod(resultscanner_, resultscanner_next_batch_id_, rows_cached_);
+    // There shouldn't be a timeout now, so we will just return any errors.
+    RETURN_ERROR_IF_EXC(env);
+  }
+  if (local_results == NULL) return Status::OK();
+  RETURN_IF_ERROR(JniUtil::LocalToGlobalRef(env, local_results, &results_));
+  num_results_ = env->GetArrayLength(results_);
+  return Status::OK();
+}
+
 Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
   JniLocalFrame jni_frame;
   RETURN_IF_ERROR(jni_frame.push(env));
@@ -512,36 +656,27 @@ Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
   {
     SCOPED_TIMER(scan_node_->hbase_read_timer());
     while (true) {
-      DCHECK(resultscanner_ != NULL);
-      // result_ = resultscanner_.next();
-      result = env->CallObjectMethod(resultscanner_, resultscanner_next_id_);
-      RETURN_ERROR_IF_EXC(env);
-      // Normally we would check for a JNI exception via RETURN_ERROR_IF_EXC, but we
-      // need to also check for scanner timeouts and handle them specially, which is
-      // done by HandleResultScannerTimeout(). If a timeout occurred, then it will
-      // re-create the ResultScanner so we can try again.
-      bool timeout;
-      RETURN_IF_ERROR(HandleResultScannerTimeout(env, &timeout));
-      if (timeout) {
-        result = env->CallObjectMethod(resultscanner_, resultscanner_next_id_);
-        // There shouldn't be a timeout now, so we will just return any errors.
-        RETURN_ERROR_IF_EXC(env);
-      }
-      // jump to the next region when finished with the current region.
-      if (result == NULL && current_scan_range_idx_ + 1 < scan_range_vector_->size()) {
-        ++current_scan_range_idx_;
-        RETURN_IF_ERROR(InitScanRange(env,
-            (*scan_range_vector_)[current_scan_range_idx_]));
-        continue;
+      if (result_idx_ == num_results_) {
+        RETURN_IF_ERROR(FetchResults(env));
+        if (num_results_ == 0) {
+          // jump to the next region when finished with the current region.
+          if (current_scan_range_idx_ + 1 < scan_range_vector_->size()) {
+            RETURN_IF_ERROR(NextScanRange(env));
+            continue;
+          }
+          break;
+        }
       }
+      result = env->GetObjectArrayElement(results_, result_idx_++);
+      RETURN_ERROR_IF_EXC(env);
 
       // Ignore empty rows
-      if (result != NULL) {
-        bool isEmpty = JNI_TRUE == env->CallBooleanMethod(result, result_isempty_id_);
-        RETURN_ERROR_IF_EXC(env);
-        if (isEmpty) {
-          continue;
-        }
+      bool isEmpty = JNI_TRUE == env->CallBooleanMethod(result, result_isempty_id_);
+      RETURN_ERROR_IF_EXC(env);
+      if (isEmpty) {
+        env->DeleteLocalRef(result);
+        result = NULL;
+        continue;
       }
       break;
     }
@@ -577,10 +712,104 @@ Status HBaseTableScanner::Next(JNIEnv* env, bool* has_next) {
   cell_index_ = 0;
 
   value_pool_->Clear();
+  // Only the row key is needed if no columns were requested.
+  if (num_requested_cells_ == 0) {
+    decoded_cells_.clear();
+  } else {
+    RETURN_IF_ERROR(DecodeCells(env));
+  }
   *has_next = true;
   return Status::OK();
 }
 
+Status HBaseTableScanner::CopyByteArrayRegion(JNIEnv* env, jbyteArray jdata, int begin,
+    int end, const char* fn_name, const char* what, uint8_t** data) {
+  int length = end - begin;
+  *data = value_pool_->TryAllocate(length);
+  if (UNLIKELY(*data == NULL)) {
+    string details = Substitute(HBASE_MEM_LIMIT_EXCEEDED, fn_name, length, what);
+    return value_pool_->mem_tracker()->MemLimitExceeded(state_, details, length);
+  }
+  env->GetByteArrayRegion(jdata, begin, length, reinterpret_cast<jbyte*>(*data));
+  RETURN_ERROR_IF_EXC(env);
+  return Status::OK();
+}
+
+Status HBaseTableScanner::DecodeCells(JNIEnv* env) {
+  decoded_cells_.resize(num_cells_);
+  int64_t bytes_read = 0;
+  for (int i = 0; i < num_cells_; ++i) {
+    JniLocalFrame jni_frame;
+    RETURN_IF_ERROR(jni_frame.push(env));
+    jobject cell = env->GetObjectArrayElement(cells_, i);
+    RETURN_ERROR_IF_EXC(env);
+    DecodedCell* decoded = &decoded_cells_[i];
+    int value_offset = env->CallIntMethod(cell, cell_get_value_offset_id_);
+    RETURN_ERROR_IF_EXC(env);
+    decoded->value_length = env->CallIntMethod(cell, cell_get_value_length_id_);
+    RETURN_ERROR_IF_EXC(env);
+    jbyteArray value_array =
+        (jbyteArray) env->CallObjectMethod(cell, cell_get_value_array_);
+    RETURN_ERROR_IF_EXC(env);
+    bytes_read += decoded->value_length;
+    if (all_cells_present_) {
+      // The family and qualifier are not compared, so only the value is needed.
+      decoded->family = NULL;
+      decoded->family_length = 0;
+      decoded->qualifier = NULL;
+      decoded->qualifier_length = 0;
+      RETURN_IF_ERROR(CopyByteArrayRegion(env, value_array, value_offset,
+          value_offset + decoded->value_length, "DecodeCells", "value array",
+          &decoded->value));
+      continue;
+    }
+
+    int family_offset = env->CallIntMethod(cell, cell_get_family_offset_id_);
+    RETURN_ERROR_IF_EXC(env);
+    decoded->family_length = env->CallByteMethod(cell, cell_get_family_length_id_);
+    RETURN_ERROR_IF_EXC(env);
+    jbyteArray family_array =
+        (jbyteArray) env->CallObjectMethod(cell, cell_get_family_array_);
+    RETURN_ERROR_IF_EXC(env);
+    int qualifier_offset = env->CallIntMethod(cell, cell_get_qualifier_offset_id_);
+    RETURN_ERROR_IF_EXC(env);
+    decoded->qualifier_length = env->CallIntMethod(cell, cell_get_qualifier_length_id_);
+    RETURN_ERROR_IF_EXC(env);
+    jbyteArray qualifier_array =
+        (jbyteArray) env->CallObjectMethod(cell, cell_get_qualifier_array_);
+    RETURN_ERROR_IF_EXC(env);
+    bytes_read += decoded->family_length + decoded->qualifier_length;
+
+    if (env->IsSameObject(family_array, value_array)
+        && env->IsSameObject(qualifier_array, value_array)) {
+      // A KeyValue keeps the whole cell in one array. Copy the family, the qualifier
+      // and the value, and the few bytes between them, at once.
+      int begin = min(min(family_offset, qualifier_offset), value_offset);
+      int end = max(max(family_offset + decoded->family_length,
+          qualifier_offset + decoded->qualifier_length),
+          value_offset + decoded->value_length);
+      uint8_t* data;
+      RETURN_IF_ERROR(CopyByteArrayRegion(
+          env, value_array, begin, end, "DecodeCells", "cell", &data));
+      decoded->family = data + family_offset - begin;
+      decoded->qualifier = data + qualifier_offset - begin;
+      decoded->value = data + value_offset - begin;
+    } else {
+      RETURN_IF_ERROR(CopyByteArrayRegion(env, family_array, family_offset,
+          family_offset + decoded->family_length, "DecodeCells", "family array",
+          &decoded->family));
+      RETURN_IF_ERROR(CopyByteArrayRegion(env, qualifier_array, qualifier_offset,
+          qualifier_offset + decoded->qualifier_length, "DecodeCells",
+          "qualifier array", &decoded->qualifier));
+      RETURN_IF_ERROR(CopyByteArrayRegion(env, value_array, value_offset,
+          value_offset + decoded->value_length, "DecodeCells", "value array",
+          &decoded->value));
+    }
+  }
+  COUNTER_ADD(scan_node_->bytes_read_counter(), bytes_read);
+  return Status::OK();
+}
+
 inline void HBaseTableScanner::WriteTupleSlot(const SlotDescriptor* slot_desc,
     Tuple* tuple, void* data) {
   void* slot = tuple->GetSlot(slot_desc->tuple_offset());
@@ -610,69 +839,6 @@ inline Status HBaseTableScanner::GetRowKey(JNIEnv* env, jobject cell,
   return Status::OK();
 }
 
-inline Status HBaseTableScanner::GetFamily(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_family_offset_id_);
-  RETURN_ERROR_IF_EXC(env);
-  *length = env->CallShortMethod(cell, cell_get_family_length_id_);
-  RETURN_ERROR_IF_EXC(env);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_family_array_);
-  RETURN_ERROR_IF_EXC(env);
-  *data = value_pool_->TryAllocate(*length);
-  if (UNLIKELY(*data == NULL)) {
-    string details = Substitute(HBASE_MEM_LIMIT_EXCEEDED, "GetFamily",
-        *length, "family array");
-    return value_pool_->mem_tracker()->MemLimitExceeded(state_, details, *length);
-  }
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  RETURN_ERROR_IF_EXC(env);
-  COUNTER_ADD(scan_node_->bytes_read_counter(), *length);
-  return Status::OK();
-}
-
-inline Status HBaseTableScanner::GetQualifier(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_qualifier_offset_id_);
-  RETURN_ERROR_IF_EXC(env);
-  *length = env->CallIntMethod(cell, cell_get_qualifier_length_id_);
-  RETURN_ERROR_IF_EXC(env);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_qualifier_array_);
-  RETURN_ERROR_IF_EXC(env);
-  *data = value_pool_->TryAllocate(*length);
-  if (UNLIKELY(*data == NULL)) {
-    string details = Substitute(HBASE_MEM_LIMIT_EXCEEDED, "GetQualifier",
-        *length, "qualifier array");
-    return value_pool_->mem_tracker()->MemLimitExceeded(state_, details, *length);
-  }
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  RETURN_ERROR_IF_EXC(env);
-  COUNTER_ADD(scan_node_->bytes_read_counter(), *length);
-  return Status::OK();
-}
-
-inline Status HBaseTableScanner::GetValue(JNIEnv* env, jobject cell,
-    void** data, int* length) {
-  int offset = env->CallIntMethod(cell, cell_get_value_offset_id_);
-  RETURN_ERROR_IF_EXC(env);
-  *length = env->CallIntMethod(cell, cell_get_value_length_id_);
-  RETURN_ERROR_IF_EXC(env);
-  jbyteArray jdata =
-      (jbyteArray) env->CallObjectMethod(cell, cell_get_value_array_);
-  RETURN_ERROR_IF_EXC(env);
-  *data = value_pool_->TryAllocate(*length);
-  if (UNLIKELY(*data == NULL)) {
-    string details = Substitute(HBASE_MEM_LIMIT_EXCEEDED, "GetValue",
-        *length, "value array");
-    return value_pool_->mem_tracker()->MemLimitExceeded(state_, details, *length);
-  }
-  env->GetByteArrayRegion(jdata, offset, *length, reinterpret_cast<jbyte*>(*data));
-  RETURN_ERROR_IF_EXC(env);
-  COUNTER_ADD(scan_node_->bytes_read_counter(), *length);
-  return Status::OK();
-}
-
 Status HBaseTableScanner::GetRowKey(JNIEnv* env, void** key, int* key_length) {
   JniLocalFrame jni_frame;
   RETURN_IF_ERROR(jni_frame.push(env));
@@ -698,46 +864,31 @@ Status HBaseTableScanner::GetRowKey(JNIEnv* env, const SlotDescriptor* slot_desc
   return Status::OK();
 }
 
-Status HBaseTableScanner::GetCurrentValue(JNIEnv* env, const string& family,
-    const string& qualifier, void** data, int* length, bool* is_null) {
+void HBaseTableScanner::GetCurrentValue(const string& family, const string& qualifier,
+    void** data, int* length, bool* is_null) {
   // Current row doesn't have any more cells. All remaining values are NULL.
   if (cell_index_ >= num_cells_) {
     *is_null = true;
-    return Status::OK();
+    return;
   }
-  JniLocalFrame jni_frame;
-  RETURN_IF_ERROR(jni_frame.push(env));
-  jobject cell = env->GetObjectArrayElement(cells_, cell_index_);
-  RETURN_ERROR_IF_EXC(env);
+  const DecodedCell& cell = decoded_cells_[cell_index_];
   if (!all_cells_present_) {
-    // Check family. If it doesn't match, we have a NULL value.
-    void* family_data;
-    int family_length;
-    RETURN_IF_ERROR(GetFamily(env, cell, &family_data, &family_length));
-    if (CompareStrings(family, family_data, family_length) != 0) {
+    // Check family and qualifier. If they don't match, we have a NULL value.
+    if (CompareStrings(family, cell.family, cell.family_length) != 0
+        || CompareStrings(qualifier, cell.qualifier, cell.qualifier_length) != 0) {
       *is_null = true;
-      return Status::OK();
-    }
-
-    // Check qualifier. If it doesn't match, we have a NULL value.
-    void* qualifier_data;
-    int qualifier_length;
-    RETURN_IF_ERROR(GetQualifier(env, cell, &qualifier_data, &qualifier_length));
-    if (CompareStrings(qualifier, qualifier_data, qualifier_length) != 0) {
-      *is_null = true;
-      return Status::OK();
+      return;
     }
   }
-  RETURN_IF_ERROR(GetValue(env, cell, data, length));
+  *data = cell.value;
+  *length = cell.value_length;
   *is_null = false;
-  return Status::OK();
 }
 
 Status HBaseTableScanner::GetValue(JNIEnv* env, const string& family,
     const string& qualifier, void** value, int* value_length) {
   bool is_null;
-  RETURN_IF_ERROR(GetCurrentValue(env, family, qualifier, value, value_length, &is_null));
-  RETURN_ERROR_IF_EXC(env);
+  GetCurrentValue(family, qualifier, value, value_length, &is_null);
   if (is_null) {
     *value = NULL;
     *value_length = 0;
@@ -752,9 +903,7 @@ Status HBaseTableScanner::GetValue(JNIEnv* env, const string& family,
   void* value;
   int value_length;
   bool is_null;
-  RETURN_IF_ERROR(
-      GetCurrentValue(env, family, qualifier, &value, &value_length, &is_null));
-  RETURN_ERROR_IF_EXC(env);
+  GetCurrentValue(family, qualifier, &value, &value_length, &is_null);
   if (is_null) {
     tuple->SetNull(slot_desc->null_indicator_offset());
     return Status::OK();
@@ -780,27 +929,15 @@ int HBaseTableScanner::CompareStrings(const string& s, void* data, int length) {
 
 void HBaseTableScanner::Close(JNIEnv* env) {
   if (resultscanner_ != NULL) {
-    // resultscanner_.close();
-    env->CallObjectMethod(resultscanner_, resultscanner_close_id_);
-    // Manually check if the ResultScanner timed out so that we can log a less scary
-    // and more specific message.
-    jthrowable exc = env->ExceptionOccurred();
-    if (exc != NULL) {
-      if (env->IsInstanceOf(exc, scanner_timeout_ex_cl_) == JNI_TRUE) {
-        env->ExceptionClear();
-        LOG(INFO) << "ResultScanner timed out before it was closed "
-                  << "(this does not necessarily indicate a problem)";
-      } else {
-        // GetJniExceptionMsg will clear the exception status and log
-        Status status = JniUtil::GetJniExceptionMsg(env, true,
-            "Unknown error occurred while closing ResultScanner: ");
-        if (!status.ok()) LOG(WARNING) << "Error closing ResultScanner()";
-      }
-    }
-    env->DeleteGlobalRef(resultscanner_);
+    CloseResultScanner(env, resultscanner_);
     resultscanner_ = NULL;
   }
+  for (jobject resultscanner : pending_resultscanners_) {
+    CloseResultScanner(env, resultscanner);
+  }
+  pending_resultscanners_.clear();
   if (scan_ != NULL) env->DeleteGlobalRef(scan_);
+  if (results_ != NULL) env->DeleteGlobalRef(results_);
   if (cells_ != NULL) env->DeleteGlobalRef(cells_);
 
   // Close the HTable so that the connections are not kept around.
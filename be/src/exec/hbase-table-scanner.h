@@ -18,6 +18,7 @@
 #pragma once
 
 #include <jni.h>
+#include <deque>
 #include <iosfwd>
 #include <string>
 #include <vector>
@@ -67,6 +68,18 @@ class HBaseScanNode;
 ///    simply checks for an exception and returns any error via status.
 /// Both are detected and handled in Init().
 //
+/// To reduce the number of JNI calls and round trips to the region servers:
+/// - Results are fetched with ResultScanner.next(int) in batches of the scan caching
+///   size, so that a whole Result array is transferred in one JNI call.
+/// - The cells of a row are decoded in one pass in Next(). A cell whose family,
+///   qualifier and value are backed by the same Java array, as is the case for
+///   KeyValue, is copied with a single JNI call.
+/// - With --hbase_scan_async_prefetch, the HBase client prefetches the next batch of
+///   results in the background while the current one is processed.
+/// - With --hbase_scanners_in_flight > 1, the ResultScanners of the next scan ranges,
+///   i.e. regions, are opened while the current one is scanned, so that the region
+///   servers start working on them in parallel.
+//
 /// Note: When none of the requested family/qualifiers exist in a particular row,
 /// HBase will not return the row at all, leading to "missing" NULL values.
 /// TODO: Related to filtering, there is a special filter that allows only selecting the
@@ -172,14 +185,17 @@ class HBaseTableScanner {
   static jclass scanner_timeout_ex_cl_;
 
   static jmethodID scan_ctor_;
+  static jmethodID scan_copy_ctor_;
   static jmethodID scan_set_max_versions_id_;
   static jmethodID scan_set_caching_id_;
   static jmethodID scan_set_cache_blocks_id_;
+  /// Null if Scan.setAsyncPrefetch() does not exist in this HBase version.
+  static jmethodID scan_set_async_prefetch_id_;
   static jmethodID scan_add_column_id_;
   static jmethodID scan_set_filter_id_;
   static jmethodID scan_set_start_row_id_;
   static jmethodID scan_set_stop_row_id_;
-  static jmethodID resultscanner_next_id_;
+  static jmethodID resultscanner_next_batch_id_;
   static jmethodID resultscanner_close_id_;
   static jmethodID result_isempty_id_;
   static jmethodID result_raw_cells_id_;
@@ -215,14 +231,43 @@ class HBaseTableScanner {
 
   /// Instances related to scanning a table. Set in StartScan(). They are global references
   /// because they cannot be automatically garbage collected by the JVM.
-  jobject scan_;           // Java type Scan
-  jobject resultscanner_;  // Java type ResultScanner
+  jobject scan_;           // Java type Scan, the template for the scan of every range
+  jobject resultscanner_;  // Java type ResultScanner of the current scan range
+
+  /// ResultScanners that were opened ahead for the scan ranges following the current
+  /// one, in order. Global references.
+  std::deque<jobject> pending_resultscanners_;
+
+  /// Index of the next scan range whose ResultScanner is not open yet.
+  int next_open_scan_range_idx_;
+
+  /// Results fetched from resultscanner_ with a single next(int) call. Java type
+  /// Result[]. Global reference.
+  jobjectArray results_;
+
+  /// Number of elements of 'results_' and the index of the next one to return.
+  int num_results_;
+  int result_idx_;
 
   /// Helper members for retrieving results from a scan. Updated in Next() and
-  /// used by GetRowKey() and GetValue(). Result of resultscanner_.next().raw()
+  /// used by GetRowKey(). Result of result.rawCells().
   /// Java type Cell[] or KeyValue[] depending on HBase version.
   jobjectArray cells_;
 
+  /// A cell of the current row, decoded in Next(). The pointers point into
+  /// 'value_pool_'. 'family' and 'qualifier' are only set if not 'all_cells_present_'.
+  struct DecodedCell {
+    uint8_t* family;
+    int family_length;
+    uint8_t* qualifier;
+    int qualifier_length;
+    uint8_t* value;
+    int value_length;
+  };
+
+  /// The decoded cells of the current row, in the order of 'cells_'.
+  std::vector<DecodedCell> decoded_cells_;
+
   /// Current position in cells_. Incremented in NextValue(). Reset in Next().
   int cell_index_;
 
@@ -255,6 +300,12 @@ class HBaseTableScanner {
   /// HBase specific counters
   RuntimeProfile::Counter* scan_setup_timer_;
 
+  /// Number of ResultScanner.next(int) calls, each fetching a batch of results.
+  RuntimeProfile::Counter* result_batches_counter_;
+
+  /// Number of ResultScanners that were opened before their scan range was reached.
+  RuntimeProfile::Counter* scanners_opened_ahead_counter_;
+
   /// Checks for and handles a ScannerTimeoutException which is thrown if the
   /// ResultScanner times out. If a timeout occurs, the ResultScanner is re-created
   /// (with the scan range adjusted if some results have already been returned) and
@@ -284,32 +335,43 @@ class HBaseTableScanner {
   Status InitScanRange(
       JNIEnv* env, jbyteArray start_bytes, jbyteArray end_bytes) WARN_UNUSED_RESULT;
 
-  /// Copies the row key of cell into value_pool_ and returns it via *data and *length.
-  /// Returns error status if memory limit is exceeded.
-  inline Status GetRowKey(
-      JNIEnv* env, jobject cell, void** data, int* length) WARN_UNUSED_RESULT;
+  /// Opens a ResultScanner for the rows between 'start_bytes' and 'end_bytes' with a
+  /// copy of 'scan_' and returns a global reference to it in 'resultscanner'.
+  Status OpenResultScanner(JNIEnv* env, jbyteArray start_bytes, jbyteArray end_bytes,
+      jobject* resultscanner) WARN_UNUSED_RESULT;
 
-  /// Copies the column family of cell into value_pool_ and returns it
-  /// via *data and *length. Returns error status if memory limit is exceeded.
-  inline Status GetFamily(
-      JNIEnv* env, jobject cell, void** data, int* length) WARN_UNUSED_RESULT;
+  /// Closes 'resultscanner' and deletes the global reference. Errors are logged.
+  void CloseResultScanner(JNIEnv* env, jobject resultscanner);
 
-  /// Copies the column qualifier of cell into value_pool_ and returns it
-  /// via *data and *length. Returns error status if memory limit is exceeded.
-  inline Status GetQualifier(
-      JNIEnv* env, jobject cell, void** data, int* length) WARN_UNUSED_RESULT;
+  /// Opens the ResultScanners of the scan ranges following the current one, up to
+  /// --hbase_scanners_in_flight scanners in total.
+  Status OpenPendingResultScanners(JNIEnv* env) WARN_UNUSED_RESULT;
+
+  /// Moves on to the next scan range, using its pending ResultScanner if there is one.
+  Status NextScanRange(JNIEnv* env) WARN_UNUSED_RESULT;
 
-  /// Copies the value of cell into value_pool_ and returns it via *data and *length.
+  /// Fetches the next batch of results of resultscanner_ into 'results_', handling
+  /// scanner timeouts.
+  Status FetchResults(JNIEnv* env) WARN_UNUSED_RESULT;
+
+  /// Decodes the cells of 'cells_' into 'decoded_cells_'.
+  Status DecodeCells(JNIEnv* env) WARN_UNUSED_RESULT;
+
+  /// Copies the bytes of 'jdata' between 'begin' and 'end' into 'value_pool_' and returns
+  /// them in 'data'. 'fn_name' and 'what' are used in the error message.
+  Status CopyByteArrayRegion(JNIEnv* env, jbyteArray jdata, int begin, int end,
+      const char* fn_name, const char* what, uint8_t** data) WARN_UNUSED_RESULT;
+
+  /// Copies the row key of cell into value_pool_ and returns it via *data and *length.
   /// Returns error status if memory limit is exceeded.
-  inline Status GetValue(
+  inline Status GetRowKey(
       JNIEnv* env, jobject cell, void** data, int* length) WARN_UNUSED_RESULT;
 
-  /// Returns the current value of cells_[cell_index_] in *data and *length
+  /// Returns the current value of decoded_cells_[cell_index_] in *data and *length
   /// if its family/qualifier match the given family/qualifier.
   /// Otherwise, sets *is_null to true indicating a mismatch in family or qualifier.
-  inline Status GetCurrentValue(JNIEnv* env, const std::string& family,
-      const std::string& qualifier, void** data, int* length,
-      bool* is_null) WARN_UNUSED_RESULT;
+  inline void GetCurrentValue(const std::string& family, const std::string& qualifier,
+      void** data, int* length, bool* is_null);
 
   /// Write to a tuple slot with the given hbase binary formatted data, which is in
   /// big endian.
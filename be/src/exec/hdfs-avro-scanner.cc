@@ -26,6 +26,7 @@
 #include "exec/hdfs-scan-node.h"
 #include "exec/read-write-util.h"
 #include "exec/scanner-context.inline.h"
+#include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/raw-value.h"
 #include "runtime/runtime-state.h"
@@ -33,6 +34,7 @@
 #include "util/decompress.h"
 #include "util/runtime-profile-counters.h"
 #include "util/test-info.h"
+#include "util/thread-pool.h"
 
 #include "common/names.h"
 
@@ -41,6 +43,8 @@
 using namespace impala;
 using namespace strings;
 
+DECLARE_int32(num_avro_decoding_threads);
+
 const char* HdfsAvroScanner::LLVM_CLASS_NAME = "class.impala::HdfsAvroScanner";
 
 const uint8_t HdfsAvroScanner::AVRO_VERSION_HEADER[4] = {'O', 'b', 'j', 1};
@@ -79,6 +83,15 @@ Status HdfsAvroScanner::Open(ScannerContext* context) {
   return Status::OK();
 }
 
+void HdfsAvroScanner::Close(RowBatch* row_batch) {
+  FreeDecodedBlocks();
+  if (num_errors_in_file_ > 0) {
+    VLOG_FILE << "HdfsAvroScanner (node_id=" << scan_node_->id() << ") hit "
+              << num_errors_in_file_ << " errors while decoding blocks in parallel.";
+  }
+  BaseSequenceScanner::Close(row_batch);
+}
+
 Status HdfsAvroScanner::Codegen(HdfsScanPlanNode* node,
    FragmentState* state, llvm::Function** decode_avro_data_fn) {
   *decode_avro_data_fn = nullptr;
@@ -483,6 +496,11 @@ Status HdfsAvroScanner::InitNewRange() {
   if (avro_header_->use_codegend_decode_avro_data) {
     codegend_decode_avro_data_ = scan_node_->GetCodegenFn(THdfsFileFormat::AVRO);
   }
+  parallel_decoding_ = state_->query_options().avro_parallel_decoding
+      && !scan_node_->materialized_slots().empty()
+      && ExecEnv::GetInstance()->avro_decoding_pool() != nullptr;
+  read_ahead_status_ = Status::OK();
+  num_errors_in_file_ = 0;
   if (codegend_decode_avro_data_ == nullptr) {
     scan_node_->IncNumScannersCodegenDisabled();
   } else {
@@ -494,46 +512,49 @@ Status HdfsAvroScanner::InitNewRange() {
   return Status::OK();
 }
 
+Status HdfsAvroScanner::ReadDataBlock() {
+  RETURN_IF_FALSE(stream_->ReadZLong(&num_records_in_block_, &parse_status_));
+  if (num_records_in_block_ < 0) {
+    return Status(TErrorCode::AVRO_INVALID_RECORD_COUNT, stream_->filename(),
+        num_records_in_block_, stream_->file_offset());
+  }
+  int64_t compressed_size;
+  RETURN_IF_FALSE(stream_->ReadZLong(&compressed_size, &parse_status_));
+  if (compressed_size < 0) {
+    return Status(TErrorCode::AVRO_INVALID_COMPRESSED_SIZE, stream_->filename(),
+        compressed_size, stream_->file_offset());
+  }
+  uint8_t* compressed_data;
+  RETURN_IF_FALSE(stream_->ReadBytes(
+      compressed_size, &compressed_data, &parse_status_));
+
+  if (header_->is_compressed) {
+    if (header_->compression_type == THdfsCompression::SNAPPY) {
+      // Snappy-compressed data block includes trailing 4-byte checksum,
+      // decompressor_ doesn't expect this
+      compressed_size -= SnappyDecompressor::TRAILING_CHECKSUM_LEN;
+    }
+    SCOPED_TIMER(decompress_timer_);
+    RETURN_IF_ERROR(decompressor_->ProcessBlock(false, compressed_size,
+        compressed_data, &data_block_len_, &data_block_));
+  } else {
+    data_block_ = compressed_data;
+    data_block_len_ = compressed_size;
+  }
+  data_block_end_ = data_block_ + data_block_len_;
+  record_pos_ = 0;
+  return Status::OK();
+}
+
 Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
+  if (parallel_decoding_) return ProcessRangeParallel(row_batch);
   // Process blocks until we hit eos, the limit or the batch fills up. Check
   // AtCapacity() at the end of the loop to guarantee that we process at least one row
   // so that we make progress even if the batch starts off with AtCapacity() == true,
   // which can happen if the tuple buffer is > 8MB.
   DCHECK_GT(row_batch->capacity(), row_batch->num_rows());
   while (!eos_ && !scan_node_->ReachedLimitShared()) {
-    if (record_pos_ == num_records_in_block_) {
-      // Read new data block
-      RETURN_IF_FALSE(stream_->ReadZLong(&num_records_in_block_, &parse_status_));
-      if (num_records_in_block_ < 0) {
-        return Status(TErrorCode::AVRO_INVALID_RECORD_COUNT, stream_->filename(),
-            num_records_in_block_, stream_->file_offset());
-      }
-      int64_t compressed_size;
-      RETURN_IF_FALSE(stream_->ReadZLong(&compressed_size, &parse_status_));
-      if (compressed_size < 0) {
-        return Status(TErrorCode::AVRO_INVALID_COMPRESSED_SIZE, stream_->filename(),
-            compressed_size, stream_->file_offset());
-      }
-      uint8_t* compressed_data;
-      RETURN_IF_FALSE(stream_->ReadBytes(
-          compressed_size, &compressed_data, &parse_status_));
-
-      if (header_->is_compressed) {
-        if (header_->compression_type == THdfsCompression::SNAPPY) {
-          // Snappy-compressed data block includes trailing 4-byte checksum,
-          // decompressor_ doesn't expect this
-          compressed_size -= SnappyDecompressor::TRAILING_CHECKSUM_LEN;
-        }
-        SCOPED_TIMER(decompress_timer_);
-        RETURN_IF_ERROR(decompressor_->ProcessBlock(false, compressed_size,
-            compressed_data, &data_block_len_, &data_block_));
-      } else {
-        data_block_ = compressed_data;
-        data_block_len_ = compressed_size;
-      }
-      data_block_end_ = data_block_ + data_block_len_;
-      record_pos_ = 0;
-    }
+    if (record_pos_ == num_records_in_block_) RETURN_IF_ERROR(ReadDataBlock());
 
     int64_t prev_record_pos = record_pos_;
     int block_start_row = row_batch->num_rows();
@@ -585,6 +606,171 @@ Status HdfsAvroScanner::ProcessRange(RowBatch* row_batch) {
   return Status::OK();
 }
 
+Status HdfsAvroScanner::ProcessRangeParallel(RowBatch* row_batch) {
+  DCHECK_GT(row_batch->capacity(), row_batch->num_rows());
+  while (!scan_node_->ReachedLimitShared()) {
+    if (next_decoded_block_ == decoded_blocks_.size()) {
+      FreeDecodedBlocks();
+      if (UNLIKELY(!read_ahead_status_.ok())) {
+        // Return the error only once. The caller logs it and skips to the next sync
+        // marker, after which the following blocks are read again.
+        Status status = read_ahead_status_;
+        read_ahead_status_ = Status::OK();
+        return status;
+      }
+      if (eos_) break;
+      RETURN_IF_ERROR(ReadBlocksParallel());
+      continue;
+    }
+    DecodedBlock* block = decoded_blocks_[next_decoded_block_].get();
+    if (block->next_record < block->num_records) {
+      SCOPED_TIMER(scan_node_->materialize_tuple_timer());
+      TupleRow* tuple_row = row_batch->GetRow(row_batch->AddRow());
+      const int max_tuples = min<int64_t>(row_batch->capacity() - row_batch->num_rows(),
+          block->num_records - block->next_record);
+      uint8_t* tuple_mem = block->tuple_mem + block->next_record * tuple_byte_size();
+      int num_to_commit = 0;
+      for (int i = 0; i < max_tuples; ++i) {
+        tuple_row->SetTuple(0, reinterpret_cast<Tuple*>(tuple_mem));
+        if (EvalConjuncts(tuple_row)) {
+          ++num_to_commit;
+          tuple_row = next_row(tuple_row);
+        }
+        tuple_mem += tuple_byte_size();
+      }
+      RETURN_IF_ERROR(CommitRows(num_to_commit, row_batch));
+      block->next_record += max_tuples;
+      block->returned_rows |= num_to_commit > 0;
+      COUNTER_ADD(scan_node_->rows_read_counter(), max_tuples);
+    }
+    if (block->next_record == block->num_records) {
+      // Returned rows may reference the block - need to attach it to the batch.
+      if (block->returned_rows) {
+        row_batch->tuple_data_pool()->AcquireData(block->pool.get(), false);
+      } else {
+        block->pool->FreeAll();
+      }
+      ++next_decoded_block_;
+    }
+    if (row_batch->AtCapacity()) break;
+  }
+  return Status::OK();
+}
+
+Status HdfsAvroScanner::ReadBlocksParallel() {
+  DCHECK(decoded_blocks_.empty());
+  DCHECK(!eos_);
+  CallableThreadPool* pool = ExecEnv::GetInstance()->avro_decoding_pool();
+  const int max_blocks = max(FLAGS_num_avro_decoding_threads, 1);
+  while (decoded_blocks_.size() < max_blocks && !eos_) {
+    Status status = ReadDataBlock();
+    // Copy the block unless the decompressor output can be handed over, since the I/O
+    // and decompression buffers are reused for the next block.
+    unique_ptr<DecodedBlock> block(new DecodedBlock());
+    block->pool.reset(new MemPool(scan_node_->mem_tracker()));
+    if (status.ok()) {
+      if (decompressor_ != nullptr && !decompressor_->reuse_output_buffer()) {
+        block->pool->AcquireData(data_buffer_pool_.get(), false);
+        block->data = data_block_;
+      } else {
+        block->data = block->pool->TryAllocateUnaligned(data_block_len_);
+        if (UNLIKELY(block->data == nullptr && data_block_len_ > 0)) {
+          status = block->pool->mem_tracker()->MemLimitExceeded(state_, Substitute(
+              AVRO_MEM_LIMIT_EXCEEDED, "ReadBlocksParallel", data_block_len_,
+              "data block"), data_block_len_);
+        } else if (data_block_len_ > 0) {
+          memcpy(block->data, data_block_, data_block_len_);
+        }
+      }
+    }
+    if (status.ok()) {
+      const int64_t tuple_mem_len = num_records_in_block_ * tuple_byte_size();
+      block->tuple_mem = block->pool->TryAllocate(tuple_mem_len);
+      if (UNLIKELY(block->tuple_mem == nullptr && tuple_mem_len > 0)) {
+        status = block->pool->mem_tracker()->MemLimitExceeded(state_, Substitute(
+            AVRO_MEM_LIMIT_EXCEEDED, "ReadBlocksParallel", tuple_mem_len, "tuples"),
+            tuple_mem_len);
+      }
+    }
+    if (status.ok()) status = ReadSync();
+    if (!status.ok()) {
+      block->pool->FreeAll();
+      ++num_errors_in_file_;
+      // Return the rows of the blocks read so far before the error.
+      if (decoded_blocks_.empty()) return status;
+      read_ahead_status_ = status;
+      break;
+    }
+    block->data_len = data_block_len_;
+    block->num_records = num_records_in_block_;
+    record_pos_ = num_records_in_block_;
+    decoded_blocks_.push_back(move(block));
+  }
+
+  // Decode all blocks but the first on the pool, and the first on this thread.
+  for (int i = 1; i < decoded_blocks_.size(); ++i) {
+    DecodedBlock* block = decoded_blocks_[i].get();
+    boost::function<void()> fn = [this, block]() {
+      block->decoded.Set(DecodeBlock(block));
+    };
+    if (!pool->Offer(fn)) fn();
+  }
+  {
+    SCOPED_TIMER(scan_node_->materialize_tuple_timer());
+    decoded_blocks_[0]->decoded.Set(DecodeBlock(decoded_blocks_[0].get()));
+  }
+  bool all_decoded = true;
+  for (const unique_ptr<DecodedBlock>& block : decoded_blocks_) {
+    if (!block->decoded.Get()) {
+      // Drop the rows of the block, the same as skipping to the next sync marker.
+      block->num_records = 0;
+      all_decoded = false;
+      ++num_errors_in_file_;
+    }
+  }
+  next_decoded_block_ = 0;
+  if (!all_decoded) {
+    DCHECK(!parse_status_.ok());
+    Status status = parse_status_;
+    parse_status_ = Status::OK();
+    state_->LogError(ErrorMsg(TErrorCode::SEQUENCE_SCANNER_PARSE_ERROR,
+        stream_->filename(), stream_->file_offset(), (stream_->eof() ? "(EOF)" : "")));
+    // This checks for abort_on_error.
+    RETURN_IF_ERROR(state_->LogOrReturnError(status.msg()));
+  }
+  return Status::OK();
+}
+
+bool HdfsAvroScanner::DecodeBlock(DecodedBlock* block) {
+  uint8_t* data = block->data;
+  uint8_t* data_end = block->data + block->data_len;
+  uint8_t* tuple_mem = block->tuple_mem;
+  for (int64_t i = 0; i < block->num_records; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem);
+    InitTuple(template_tuple_, tuple);
+    if (UNLIKELY(!MaterializeTuple(*avro_header_->schema.get(), block->pool.get(), &data,
+        data_end, tuple))) {
+      return false;
+    }
+    tuple_mem += tuple_byte_size();
+  }
+  return true;
+}
+
+void HdfsAvroScanner::FreeDecodedBlocks() {
+  for (const unique_ptr<DecodedBlock>& block : decoded_blocks_) block->pool->FreeAll();
+  decoded_blocks_.clear();
+  next_decoded_block_ = 0;
+}
+
+void HdfsAvroScanner::SetParseStatus(const Status& status) {
+  lock_guard<SpinLock> l(parse_status_lock_);
+  // Only blocks that are decoded in parallel can fail concurrently. The error of the
+  // first one is kept.
+  DCHECK(parse_status_.ok() || parallel_decoding_);
+  if (parse_status_.ok()) parse_status_ = status;
+}
+
 bool HdfsAvroScanner::MaterializeTuple(const AvroSchemaElement& record_schema,
     MemPool* pool, uint8_t** data, uint8_t* data_end, Tuple* tuple) {
   DCHECK_EQ(record_schema.schema->type, AVRO_RECORD);
@@ -665,7 +851,7 @@ bool HdfsAvroScanner::MaterializeTuple(const AvroSchemaElement& record_schema,
         DCHECK(false) << "Unsupported SchemaElement: " << type;
     }
     if (UNLIKELY(!success)) {
-      DCHECK(!parse_status_.ok());
+      DCHECK(parallel_decoding_ || !parse_status_.ok());
       return false;
     }
   }
@@ -673,31 +859,29 @@ bool HdfsAvroScanner::MaterializeTuple(const AvroSchemaElement& record_schema,
 }
 
 void HdfsAvroScanner::SetStatusCorruptData(TErrorCode::type error_code) {
-  DCHECK(parse_status_.ok());
   if (TestInfo::is_test()) {
-    parse_status_ = Status(error_code, "test file", 123);
+    SetParseStatus(Status(error_code, "test file", 123));
   } else {
-    parse_status_ = Status(error_code, stream_->filename(), stream_->file_offset());
+    SetParseStatus(Status(error_code, stream_->filename(), stream_->file_offset()));
   }
 }
 
 void HdfsAvroScanner::SetStatusInvalidValue(TErrorCode::type error_code, int64_t len) {
-  DCHECK(parse_status_.ok());
   if (TestInfo::is_test()) {
-    parse_status_ = Status(error_code, "test file", len, 123);
+    SetParseStatus(Status(error_code, "test file", len, 123));
   } else {
-    parse_status_ = Status(error_code, stream_->filename(), len, stream_->file_offset());
+    SetParseStatus(
+        Status(error_code, stream_->filename(), len, stream_->file_offset()));
   }
 }
 
 void HdfsAvroScanner::SetStatusValueOverflow(TErrorCode::type error_code, int64_t len,
     int64_t limit) {
-  DCHECK(parse_status_.ok());
   if (TestInfo::is_test()) {
-    parse_status_ = Status(error_code, "test file", len, limit, 123);
+    SetParseStatus(Status(error_code, "test file", len, limit, 123));
   } else {
-    parse_status_ = Status(error_code, stream_->filename(), len, limit,
-        stream_->file_offset());
+    SetParseStatus(Status(error_code, stream_->filename(), len, limit,
+        stream_->file_offset()));
   }
 }
 
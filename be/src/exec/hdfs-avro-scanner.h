@@ -48,6 +48,11 @@
 /// table schema that parses records, materializes them to tuples, and evaluates the
 /// conjuncts.
 ///
+/// If the AVRO_PARALLEL_DECODING query option is set, the scanner instead reads and
+/// decompresses several data blocks ahead and materializes their records on the
+/// avro decoding thread pool of ExecEnv, one task per block. The scanner thread then
+/// evaluates the conjuncts and returns the decoded tuples.
+///
 /// The Avro C library is used to parse the file's schema and the table's schema, which are
 /// then resolved according to the Avro spec and transformed into our own schema
 /// representation (i.e. a list of SchemaElements). Schema resolution allows users to
@@ -70,11 +75,17 @@
 
 #include "exec/base-sequence-scanner.h"
 
+#include <memory>
+#include <vector>
+
 #include <avro/basics.h>
 
 #include "exec/read-write-util.h"
+#include "runtime/mem-pool.h"
 #include "runtime/tuple.h"
 #include "runtime/tuple-row.h"
+#include "util/promise.h"
+#include "util/spinlock.h"
 
 namespace llvm {
   class BasicBlock;
@@ -92,6 +103,7 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   HdfsAvroScanner(HdfsScanNodeBase* scan_node, RuntimeState* state);
 
   virtual Status Open(ScannerContext* context) WARN_UNUSED_RESULT;
+  virtual void Close(RowBatch* row_batch);
 
   /// Codegen DecodeAvroData(). Stores the resulting function in 'decode_avro_data_fn' if
   /// codegen was successful or nullptr otherwise.
@@ -141,6 +153,41 @@ class HdfsAvroScanner : public BaseSequenceScanner {
   int64_t num_records_in_block_ = 0;
   int64_t record_pos_ = 0;
 
+  /// A data block that is decoded on the avro decoding thread pool.
+  struct DecodedBlock {
+    /// Owns the block data, which string slots point to, and the decoded tuples.
+    std::unique_ptr<MemPool> pool;
+    uint8_t* data = nullptr;
+    int64_t data_len = 0;
+    int64_t num_records = 0;
+    /// 'num_records' tuples of tuple_byte_size() bytes, written by DecodeBlock().
+    uint8_t* tuple_mem = nullptr;
+    /// The next record to return and whether any record was returned.
+    int64_t next_record = 0;
+    bool returned_rows = false;
+    /// Set to the result of DecodeBlock() once the block is decoded.
+    Promise<bool> decoded;
+  };
+
+  /// True if the current scan range is decoded with ProcessRangeParallel().
+  bool parallel_decoding_ = false;
+
+  /// The blocks read by ReadBlocksParallel() and the next one to return rows from.
+  std::vector<std::unique_ptr<DecodedBlock>> decoded_blocks_;
+  int next_decoded_block_ = 0;
+
+  /// Error that stopped ReadBlocksParallel() after some blocks were read. Returned
+  /// once the rows of those blocks are returned, and reset to OK then, so that the
+  /// scanner can recover by skipping to the next sync marker.
+  Status read_ahead_status_;
+
+  /// Number of errors that reading or decoding blocks in parallel hit in the current
+  /// scan range. Logged when the scanner is closed.
+  int num_errors_in_file_ = 0;
+
+  /// Protects 'parse_status_' while blocks are decoded in parallel.
+  SpinLock parse_status_lock_;
+
   /// Metadata keys
   static const std::string AVRO_SCHEMA_KEY;
   static const std::string AVRO_CODEC_KEY;
@@ -204,6 +251,30 @@ class HdfsAvroScanner : public BaseSequenceScanner {
       uint8_t* data_end, Tuple* tuple, TupleRow* tuple_row);
 
 
+  /// Implementation of ProcessRange() if 'parallel_decoding_' is set. Returns the
+  /// decoded tuples of 'decoded_blocks_' that pass the conjuncts, and calls
+  /// ReadBlocksParallel() when all of them were returned.
+  Status ProcessRangeParallel(RowBatch* row_batch) WARN_UNUSED_RESULT;
+
+  /// Reads up to one data block per thread of the decoding pool, or fewer if the end of
+  /// the scan range is reached, and decodes them in parallel. Waits for all of them to
+  /// be decoded. Blocks that fail to decode are dropped after their error is logged,
+  /// like the serial path skips to the next sync marker.
+  Status ReadBlocksParallel() WARN_UNUSED_RESULT;
+
+  /// Reads the next data block from 'stream_' and decompresses it into 'data_block_'.
+  Status ReadDataBlock() WARN_UNUSED_RESULT;
+
+  /// Materializes all records of 'block' into its tuples. Runs on the decoding pool.
+  /// Returns false and sets 'parse_status_' if a record could not be decoded.
+  bool DecodeBlock(DecodedBlock* block);
+
+  /// Frees the memory of the decoded blocks that were not returned yet.
+  void FreeDecodedBlocks();
+
+  /// Sets 'parse_status_' to 'status' if it does not hold an error yet. Thread-safe.
+  void SetParseStatus(const Status& status);
+
   /// Materializes a single tuple from serialized record data. Will return false and set
   /// error in parse_status_ if memory limit is exceeded when allocating new char buffer.
   /// See comments below for ReadAvroChar().
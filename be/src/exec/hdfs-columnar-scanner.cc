@@ -20,11 +20,17 @@
 #include <algorithm>
 
 #include "codegen/llvm-codegen.h"
+#include "exec/exec-node.inline.h"
+#include "exec/filter-context.h"
 #include "exec/hdfs-scan-node-base.h"
 #include "exec/scratch-tuple-batch.h"
+#include "exprs/batch-conjunct-evaluator.h"
+#include "runtime/descriptors.h"
 #include "runtime/fragment-state.h"
 #include "runtime/row-batch.h"
+#include "runtime/runtime-filter.h"
 #include "runtime/runtime-state.h"
+#include "runtime/tuple.h"
 
 namespace impala {
 
@@ -63,11 +69,97 @@ int HdfsColumnarScanner::TransferScratchTuples(RowBatch* dst_batch) {
     return num_tuples;
   }
 
-  const int num_rows_to_commit = ProcessScratchBatchCodegenOrInterpret(dst_batch);
+  const int num_rows_to_commit = scratch_batch_->has_selection ?
+      scratch_batch_->TransferSelectedTuples(dst_batch) :
+      ProcessScratchBatchCodegenOrInterpret(dst_batch);
   scratch_batch_->FinalizeTupleTransfer(dst_batch, num_rows_to_commit);
   return num_rows_to_commit;
 }
 
+int HdfsColumnarScanner::FilterScratchBatch(RowBatch* selection_batch) {
+  DCHECK_EQ(scratch_batch_->tuple_idx, 0);
+  DCHECK_GT(scratch_batch_->tuple_byte_size, 0);
+  DCHECK_LE(scratch_batch_->num_tuples, selection_batch->capacity());
+  // The selection batch only holds pointers into the scratch batch, no memory is ever
+  // attached to it.
+  selection_batch->Reset();
+  // Reuse the (possibly codegen'd) ProcessScratchBatch(). Since the selection batch
+  // cannot fill up before the scratch batch is exhausted, all tuples are evaluated.
+  const int num_selected = ProcessScratchBatchCodegenOrInterpret(selection_batch);
+  DCHECK(scratch_batch_->AtEnd());
+  scratch_batch_->SetSelection(selection_batch, num_selected);
+  return num_selected;
+}
+
+int HdfsColumnarScanner::FilterScratchBatchOnSlots(
+    const vector<const SlotDescriptor*>& filter_slots) {
+  DCHECK_EQ(scratch_batch_->tuple_idx, 0);
+  DCHECK_GT(scratch_batch_->tuple_byte_size, 0);
+  DCHECK_EQ(filter_slots.size(), filter_ctxs_.size());
+  int* selected_rows = scratch_batch_->selected_rows.get();
+  int num_selected = scratch_batch_->num_tuples;
+  for (int i = 0; i < num_selected; ++i) selected_rows[i] = i;
+  // Evaluate one filter at a time over the tuples that passed the previous ones. The
+  // filter stats are the same as with EvalRuntimeFilters(), which short-circuits.
+  for (int f = 0; f < filter_ctxs_.size() && num_selected > 0; ++f) {
+    LocalFilterStats* stats = &filter_stats_[f];
+    const RuntimeFilter* filter = filter_ctxs_[f]->filter;
+    stats->total_possible += num_selected;
+    if (!stats->enabled_for_row || !filter->HasFilter()) continue;
+    stats->considered += num_selected;
+    const SlotDescriptor* slot_desc = filter_slots[f];
+    const NullIndicatorOffset& null_offset = slot_desc->null_indicator_offset();
+    const int slot_offset = slot_desc->tuple_offset();
+    const ColumnType& type = slot_desc->type();
+    // The values are evaluated in batches with EvalBatch(). The selection is compacted
+    // in place, i.e. 'num_passed' never exceeds the index of the evaluated row.
+    void* vals[RuntimeFilter::EVAL_BATCH_SIZE];
+    bool passed[RuntimeFilter::EVAL_BATCH_SIZE];
+    int num_passed = 0;
+    for (int start = 0; start < num_selected; start += RuntimeFilter::EVAL_BATCH_SIZE) {
+      const int batch_size = min(RuntimeFilter::EVAL_BATCH_SIZE, num_selected - start);
+      for (int i = 0; i < batch_size; ++i) {
+        Tuple* tuple = scratch_batch_->GetTuple(selected_rows[start + i]);
+        vals[i] = tuple->IsNull(null_offset) ? nullptr : tuple->GetSlot(slot_offset);
+      }
+      filter->EvalBatch(vals, batch_size, type, passed);
+      for (int i = 0; i < batch_size; ++i) {
+        selected_rows[num_passed] = selected_rows[start + i];
+        num_passed += passed[i];
+      }
+    }
+    stats->rejected += num_selected - num_passed;
+    num_selected = num_passed;
+  }
+  scratch_batch_->SetSelectedRows(num_selected);
+  return num_selected;
+}
+
+int HdfsColumnarScanner::FilterSelectedScratchTuples() {
+  DCHECK(scratch_batch_->has_selection);
+  DCHECK_EQ(scratch_batch_->selected_idx, 0);
+  ScalarExprEvaluator* const* conjunct_evals = conjunct_evals_->data();
+  const int num_conjuncts = conjunct_evals_->size();
+  int* selected_rows = scratch_batch_->selected_rows.get();
+  if (batch_conjunct_eval_ != nullptr) {
+    const int num_passed = batch_conjunct_eval_->Filter(scratch_batch_->tuple_mem,
+        scratch_batch_->tuple_byte_size, selected_rows, scratch_batch_->num_selected);
+    scratch_batch_->SetSelectedRows(num_passed);
+    return num_passed;
+  }
+  int num_passed = 0;
+  for (int i = 0; i < scratch_batch_->num_selected; ++i) {
+    const int row_idx = selected_rows[i];
+    // A row of the scratch batch consists of a single tuple.
+    Tuple* tuple = scratch_batch_->GetTuple(row_idx);
+    selected_rows[num_passed] = row_idx;
+    num_passed += ExecNode::EvalConjuncts(
+        conjunct_evals, num_conjuncts, reinterpret_cast<TupleRow*>(&tuple));
+  }
+  scratch_batch_->SetSelectedRows(num_passed);
+  return num_passed;
+}
+
 Status HdfsColumnarScanner::Codegen(HdfsScanPlanNode* node, FragmentState* state,
     llvm::Function** process_scratch_batch_fn) {
   DCHECK(state->ShouldCodegen());
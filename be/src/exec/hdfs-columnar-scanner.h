@@ -23,10 +23,12 @@
 
 namespace impala {
 
+class BatchConjunctEvaluator;
 class HdfsScanNodeBase;
 class HdfsScanPlanNode;
 class RowBatch;
 class RuntimeState;
+class SlotDescriptor;
 struct ScratchTupleBatch;
 
 /// Parent class for scanners that read values into a scratch batch before applying
@@ -54,13 +56,42 @@ class HdfsColumnarScanner : public HdfsScanner {
   /// Function type: ProcessScratchBatchFn
   const CodegenFnPtrBase* codegend_process_scratch_batch_fn_ = nullptr;
 
+  /// Evaluates the conjuncts in FilterSelectedScratchTuples() over all selected tuples
+  /// at a time if the query option BATCH_CONJUNCT_EVALUATION is set, NULL otherwise.
+  /// Must be created by the subclasses once 'conjunct_evals_' are open. Owned by
+  /// 'obj_pool_'.
+  BatchConjunctEvaluator* batch_conjunct_eval_ = nullptr;
+
   /// Evaluates runtime filters and conjuncts (if any) against the tuples in
-  /// 'scratch_batch_', and adds the surviving tuples to the given batch.
+  /// 'scratch_batch_', and adds the surviving tuples to the given batch. If the scratch
+  /// batch was already filtered by FilterScratchBatch(), only the selected tuples are
+  /// added and the predicates are not evaluated again.
   /// Transfers the ownership of tuple memory to the target batch when the
   /// scratch batch is exhausted.
   /// Returns the number of rows that should be committed to the given batch.
   int TransferScratchTuples(RowBatch* row_batch);
 
+  /// Evaluates runtime filters and conjuncts against all tuples in 'scratch_batch_'
+  /// and records the surviving tuples as its selection. Used by scanners that
+  /// materialize the slots referenced by the predicates before the other slots.
+  /// 'selection_batch' is used as a temporary output batch and must have room for
+  /// all tuples of the scratch batch. Returns the number of selected tuples.
+  int FilterScratchBatch(RowBatch* selection_batch);
+
+  /// Evaluates the runtime filters against all tuples in 'scratch_batch_' and records
+  /// the surviving tuples as its selection. Unlike FilterScratchBatch(), the filter
+  /// expressions are not evaluated: 'filter_slots[i]' is the slot that the expression
+  /// of the i-th filter in 'filter_ctxs_' references, and its values are checked
+  /// against the filter directly, one filter at a time. Only the slots in
+  /// 'filter_slots' need to be materialized. Conjuncts are not evaluated. Returns the
+  /// number of selected tuples.
+  int FilterScratchBatchOnSlots(const std::vector<const SlotDescriptor*>& filter_slots);
+
+  /// Evaluates the conjuncts against the selected tuples of 'scratch_batch_' and
+  /// removes the tuples that do not pass them from the selection. Returns the number of
+  /// tuples that remain selected.
+  int FilterSelectedScratchTuples();
+
   /// Processes a single row batch for TransferScratchTuples, looping over scratch_batch_
   /// until it is exhausted or the output is full. Called for the case when there are
   /// materialized tuples. This is a separate function so it can be codegened.
@@ -17,6 +17,7 @@
 
 #include "exec/hdfs-orc-scanner.h"
 
+#include <cmath>
 #include <queue>
 
 #include "exec/exec-node.inline.h"
@@ -24,7 +25,9 @@
 #include "exec/scanner-context.inline.h"
 #include "exec/scratch-tuple-batch.h"
 #include "exprs/expr.h"
+#include "exprs/slot-ref.h"
 #include "runtime/collection-value-builder.h"
+#include "runtime/date-value.h"
 #include "runtime/exec-env.h"
 #include "runtime/io/request-context.h"
 #include "runtime/mem-tracker.h"
@@ -32,6 +35,7 @@
 #include "runtime/timestamp-value.inline.h"
 #include "runtime/tuple-row.h"
 #include "util/decompress.h"
+#include "util/min-max-filter.h"
 
 #include "common/names.h"
 
@@ -40,6 +44,9 @@ using namespace impala::io;
 
 DEFINE_bool(enable_orc_scanner, true,
     "If false, reading from ORC format tables is not supported");
+DEFINE_int64_hidden(orc_max_prefetch_bytes_per_stripe, 64L * 1024L * 1024L,
+    "Maximum number of bytes of a stripe that an ORC scanner reads asynchronously when "
+    "ORC_ASYNC_READ is true. The streams beyond it are read synchronously.");
 
 Status HdfsOrcScanner::IssueInitialRanges(HdfsScanNodeBase* scan_node,
     const vector<HdfsFileDesc*>& files) {
@@ -76,6 +83,7 @@ void HdfsOrcScanner::OrcMemPool::FreeAll() {
   }
   mem_tracker_->Release(total_bytes_released);
   chunk_sizes_.clear();
+  transferred_chunks_.clear();
 }
 
 // orc-reader will not check the malloc result. We throw an exception if we can't
@@ -94,7 +102,20 @@ char* HdfsOrcScanner::OrcMemPool::malloc(uint64_t size) {
   return addr;
 }
 
+bool HdfsOrcScanner::OrcMemPool::TransferToMemPool(char* p, MemPool* dst) {
+  auto it = chunk_sizes_.find(p);
+  if (it == chunk_sizes_.end()) return false;
+  const int64_t size = it->second;
+  mem_tracker_->TransferTo(dst->mem_tracker(), size);
+  dst->AcquireBuffer(reinterpret_cast<uint8_t*>(p), size);
+  chunk_sizes_.erase(it);
+  transferred_chunks_.insert(p);
+  return true;
+}
+
 void HdfsOrcScanner::OrcMemPool::free(char* p) {
+  // The memory is owned by an Impala MemPool now.
+  if (transferred_chunks_.erase(p) > 0) return;
   DCHECK(chunk_sizes_.find(p) != chunk_sizes_.end()) << "invalid free!" << endl
        << GetStackTrace();
   std::free(p);
@@ -103,21 +124,11 @@ void HdfsOrcScanner::OrcMemPool::free(char* p) {
   chunk_sizes_.erase(p);
 }
 
-// TODO: improve this to use async IO (IMPALA-6636).
 void HdfsOrcScanner::ScanRangeInputStream::read(void* buf, uint64_t length,
     uint64_t offset) {
-  const ScanRange* metadata_range = scanner_->metadata_range_;
-  const ScanRange* split_range =
-      reinterpret_cast<ScanRangeMetadata*>(metadata_range->meta_data())->original_split;
-  int64_t partition_id = scanner_->context_->partition_descriptor()->id();
-
-  // Set expected_local to false to avoid cache on stale data (IMPALA-6830)
-  bool expected_local = false;
-  int cache_options = split_range->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
-  ScanRange* range = scanner_->scan_node_->AllocateScanRange(
-      metadata_range->fs(), scanner_->filename(), length, offset, partition_id,
-      split_range->disk_id(), expected_local, split_range->mtime(),
-      BufferOpts::ReadInto(reinterpret_cast<uint8_t*>(buf), length, cache_options));
+  if (scanner_->ReadPrefetched(buf, length, offset)) return;
+  ScanRange* range = scanner_->AllocateReadIntoRange(
+      reinterpret_cast<uint8_t*>(buf), length, offset);
 
   unique_ptr<BufferDescriptor> io_buffer;
   Status status;
@@ -134,11 +145,108 @@ void HdfsOrcScanner::ScanRangeInputStream::read(void* buf, uint64_t length,
   if (!status.ok()) throw ResourceError(status);
 }
 
+ScanRange* HdfsOrcScanner::AllocateReadIntoRange(
+    uint8_t* buffer, int64_t length, int64_t offset) {
+  const ScanRange* split_range =
+      reinterpret_cast<ScanRangeMetadata*>(metadata_range_->meta_data())->original_split;
+  int64_t partition_id = context_->partition_descriptor()->id();
+
+  // Set expected_local to false to avoid cache on stale data (IMPALA-6830)
+  bool expected_local = false;
+  int cache_options = split_range->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
+  return scan_node_->AllocateScanRange(metadata_range_->fs(), filename(), length,
+      offset, partition_id, split_range->disk_id(), expected_local, split_range->mtime(),
+      BufferOpts::ReadInto(buffer, length, cache_options));
+}
+
+void HdfsOrcScanner::PrefetchStripe(const orc::StripeInformation& stripe) {
+  ReleasePrefetchRanges();
+  if (!state_->query_options().orc_async_read) return;
+  // Byte ranges of the file as (offset, length) pairs.
+  vector<pair<int64_t, int64_t>> ranges;
+  try {
+    const vector<bool> selected_columns = row_reader_->getSelectedColumns();
+    for (uint64_t i = 0; i < stripe.getNumberOfStreams(); ++i) {
+      unique_ptr<orc::StreamInformation> stream = stripe.getStreamInformation(i);
+      const uint64_t col_id = stream->getColumnId();
+      if (col_id >= selected_columns.size() || !selected_columns[col_id]) continue;
+      // The ORC lib does not read the row indexes and bloom filters.
+      const orc::StreamKind kind = stream->getKind();
+      if (kind == orc::StreamKind_ROW_INDEX || kind == orc::StreamKind_BLOOM_FILTER
+          || kind == orc::StreamKind_BLOOM_FILTER_UTF8) {
+        continue;
+      }
+      const int64_t offset = stream->getOffset();
+      const int64_t length = stream->getLength();
+      if (length == 0) continue;
+      if (!ranges.empty() && ranges.back().first + ranges.back().second == offset) {
+        ranges.back().second += length;
+      } else {
+        ranges.emplace_back(offset, length);
+      }
+    }
+  } catch (std::exception& e) {
+    // The synchronous reads of the ORC lib will report the error.
+    VLOG_QUERY << "Cannot prefetch stripe " << stripe_idx_ << " of ORC file "
+        << filename() << ": " << e.what();
+    return;
+  }
+
+  int64_t prefetched_bytes = 0;
+  for (const pair<int64_t, int64_t>& range : ranges) {
+    if (prefetched_bytes + range.second > FLAGS_orc_max_prefetch_bytes_per_stripe) break;
+    uint8_t* buffer = prefetch_pool_->TryAllocate(range.second);
+    if (buffer == nullptr) break;
+    ScanRange* scan_range = AllocateReadIntoRange(buffer, range.second, range.first);
+    bool needs_buffers;
+    Status status =
+        scan_node_->reader_context()->StartScanRange(scan_range, &needs_buffers);
+    DCHECK(!status.ok() || !needs_buffers) << "Already provided a buffer";
+    prefetch_ranges_.push_back(
+        {range.first, range.second, buffer, scan_range, !status.ok(), status});
+    if (!status.ok()) break;
+    prefetched_bytes += range.second;
+    COUNTER_ADD(prefetched_bytes_counter_, range.second);
+  }
+}
+
+bool HdfsOrcScanner::ReadPrefetched(void* buf, uint64_t length, uint64_t offset) {
+  const int64_t start = offset;
+  const int64_t end = offset + length;
+  for (PrefetchRange& range : prefetch_ranges_) {
+    if (start < range.offset || end > range.offset + range.length) continue;
+    WaitForPrefetchRange(&range);
+    if (!range.status.ok()) return false;
+    memcpy(buf, range.buffer + (start - range.offset), length);
+    return true;
+  }
+  return false;
+}
+
+void HdfsOrcScanner::WaitForPrefetchRange(PrefetchRange* range) {
+  if (range->done) return;
+  unique_ptr<BufferDescriptor> io_buffer;
+  {
+    SCOPED_TIMER2(state_->total_storage_wait_timer(), scan_node_->scanner_io_wait_time());
+    range->status = range->scan_range->GetNext(&io_buffer);
+  }
+  if (io_buffer != nullptr) range->scan_range->ReturnBuffer(move(io_buffer));
+  range->done = true;
+}
+
+void HdfsOrcScanner::ReleasePrefetchRanges() {
+  // The disk threads may still write into the buffers of outstanding reads.
+  for (PrefetchRange& range : prefetch_ranges_) WaitForPrefetchRange(&range);
+  prefetch_ranges_.clear();
+  prefetch_pool_->FreeAll();
+}
+
 HdfsOrcScanner::HdfsOrcScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
   : HdfsColumnarScanner(scan_node, state),
     dictionary_pool_(new MemPool(scan_node->mem_tracker())),
     data_batch_pool_(new MemPool(scan_node->mem_tracker())),
-    assemble_rows_timer_(scan_node_->materialize_tuple_timer()) {
+    assemble_rows_timer_(scan_node_->materialize_tuple_timer()),
+    prefetch_pool_(new MemPool(scan_node->mem_tracker())) {
   assemble_rows_timer_.Stop();
 }
 
@@ -147,6 +255,12 @@ HdfsOrcScanner::~HdfsOrcScanner() {
 
 Status HdfsOrcScanner::Open(ScannerContext* context) {
   RETURN_IF_ERROR(HdfsScanner::Open(context));
+  const RoaringBitmap* position_deletes;
+  RETURN_IF_ERROR(scan_node_->GetPositionDeletes(filename(), &position_deletes));
+  if (position_deletes != nullptr) {
+    return Status(Substitute("Iceberg position deletes are not supported for ORC data "
+        "file '$0'.", filename()));
+  }
   metadata_range_ = stream_->scan_range();
   num_cols_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumOrcColumns", TUnit::UNIT);
@@ -154,6 +268,14 @@ Status HdfsOrcScanner::Open(ScannerContext* context) {
       ADD_COUNTER(scan_node_->runtime_profile(), "NumOrcStripes", TUnit::UNIT);
   num_scanners_with_no_reads_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumScannersWithNoReads", TUnit::UNIT);
+  num_runtime_filtered_stripes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumRuntimeFilteredStripes", TUnit::UNIT);
+  num_invalid_write_id_stripes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumInvalidWriteIdStripes", TUnit::UNIT);
+  num_unsampled_stripes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumUnsampledStripes", TUnit::UNIT);
+  prefetched_bytes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "OrcPrefetchedBytes", TUnit::BYTES);
   process_footer_timer_stats_ =
       ADD_SUMMARY_STATS_TIMER(scan_node_->runtime_profile(), "OrcFooterProcessingTime");
 
@@ -272,6 +394,7 @@ Status HdfsOrcScanner::Open(ScannerContext* context) {
 
 void HdfsOrcScanner::Close(RowBatch* row_batch) {
   DCHECK(!is_closed_);
+  ReleasePrefetchRanges();
   if (row_batch != nullptr) {
     context_->ReleaseCompletedResources(true);
     row_batch->tuple_data_pool()->AcquireData(template_tuple_pool_.get(), false);
@@ -568,7 +691,8 @@ Status HdfsOrcScanner::GetNextInternal(RowBatch* row_batch) {
   // batches and check their validity. In that case 'currentTransaction' is the only
   // selected field from the file (in case of zero slot scans).
   if (scan_node_->IsZeroSlotTableScan() && !row_batches_need_validation_) {
-    uint64_t file_rows = reader_->getNumberOfRows();
+    if (zero_slot_num_rows_ == -1) zero_slot_num_rows_ = NumSampledRows();
+    uint64_t file_rows = zero_slot_num_rows_;
     // There are no materialized slots, e.g. count(*) over the table.  We can serve
     // this query from just the file metadata.  We don't need to read the column data.
     if (stripe_rows_read_ == file_rows) {
@@ -711,6 +835,33 @@ Status HdfsOrcScanner::NextStripe() {
       continue;
     }
 
+    // Runtime filters may have arrived since the previous stripe, so the filters are
+    // collected again for every stripe.
+    vector<OrcMinMaxFilter> minmax_filters;
+    GetOrcMinMaxFilters(&minmax_filters);
+    if (StripeRejectedByRuntimeFilters(stripe_idx_, minmax_filters)) {
+      // Synthetic row ids disable the filters, so the file row index is not affected.
+      DCHECK(acid_synthetic_rowid_ == nullptr);
+      COUNTER_ADD(num_runtime_filtered_stripes_counter_, 1);
+      continue;
+    }
+
+    if (IsStripeUnsampled(stripe_idx_)) {
+      COUNTER_ADD(num_unsampled_stripes_counter_, 1);
+      continue;
+    }
+
+    if (row_batches_need_validation_) {
+      ValidWriteIdList::RangeResponse stripe_validity =
+          GetStripeWriteIdValidity(stripe_idx_);
+      if (stripe_validity == ValidWriteIdList::NONE) {
+        DCHECK(acid_synthetic_rowid_ == nullptr);
+        COUNTER_ADD(num_invalid_write_id_stripes_counter_, 1);
+        continue;
+      }
+      stripe_rows_need_validation_ = stripe_validity == ValidWriteIdList::SOME;
+    }
+
     // TODO: check if this stripe can be skipped by stats. e.g. IMPALA-6505 In that case,
     // set the file row index in 'orc_root_reader_' accordingly.
     if (first_invocation && acid_synthetic_rowid_ != nullptr) {
@@ -730,6 +881,7 @@ Status HdfsOrcScanner::NextStripe() {
           Substitute("Error in creating ORC column readers: $0.", e.what()));
       return parse_status_;
     }
+    PrefetchStripe(*stripe);
     end_of_stripe_ = false;
     VLOG_ROW << Substitute("Created RowReader for stripe(offset=$0, len=$1) in file $2",
         stripe->getOffset(), stripe_len, filename());
@@ -740,6 +892,150 @@ Status HdfsOrcScanner::NextStripe() {
   return Status::OK();
 }
 
+void HdfsOrcScanner::GetOrcMinMaxFilters(vector<OrcMinMaxFilter>* filters) {
+  filters->clear();
+  if (!state_->query_options().orc_read_statistics) return;
+  if (acid_synthetic_rowid_ != nullptr) return;
+  const TupleDescriptor* tuple_desc = scan_node_->tuple_desc();
+  for (int i = 0; i < filter_ctxs_.size(); ++i) {
+    const FilterContext* ctx = filter_ctxs_[i];
+    if (!ctx->filter->is_min_max_filter() || !ctx->filter->HasFilter()) continue;
+    if (!filter_stats_[i].enabled_for_rowgroup) continue;
+    MinMaxFilter* minmax_filter = ctx->filter->get_min_max();
+    if (minmax_filter == nullptr || minmax_filter->AlwaysTrue()) continue;
+    const ScalarExpr& root = ctx->expr_eval->root();
+    if (!root.IsSlotRef()) continue;
+    const SlotId slot_id = static_cast<const SlotRef&>(root).slot_id();
+    const SlotDescriptor* slot_desc = nullptr;
+    for (const SlotDescriptor* slot : tuple_desc->slots()) {
+      if (slot->id() == slot_id) slot_desc = slot;
+    }
+    if (slot_desc == nullptr || IsPartitionKeySlot(slot_desc)
+        || IsMissingField(slot_desc) || slot_desc->type().IsComplexType()
+        || slot_desc->type() != root.type()) {
+      continue;
+    }
+    const orc::Type* node = nullptr;
+    bool pos_field = false;
+    bool missing_field = false;
+    if (!schema_resolver_->ResolveColumn(
+        slot_desc->col_path(), &node, &pos_field, &missing_field).ok()
+        || pos_field || missing_field) {
+      continue;
+    }
+    filters->push_back({i, minmax_filter, slot_desc, node});
+  }
+}
+
+bool HdfsOrcScanner::IsStripeUnsampled(int stripe_idx) const {
+  return scan_node_->samples_units() && acid_synthetic_rowid_ == nullptr &&
+      !scan_node_->IsUnitSampled(filename(), stripe_idx);
+}
+
+uint64_t HdfsOrcScanner::NumSampledRows() const {
+  if (!scan_node_->samples_units()) return reader_->getNumberOfRows();
+  uint64_t num_rows = 0;
+  for (int i = 0; i < reader_->getNumberOfStripes(); ++i) {
+    if (!IsStripeUnsampled(i)) num_rows += reader_->getStripe(i)->getNumberOfRows();
+  }
+  return num_rows;
+}
+
+ValidWriteIdList::RangeResponse HdfsOrcScanner::GetStripeWriteIdValidity(
+    int stripe_idx) {
+  if (stripe_idx >= reader_->getNumberOfStripeStatistics()) return ValidWriteIdList::SOME;
+  unique_ptr<orc::StripeStatistics> stripe_stats;
+  try {
+    stripe_stats = reader_->getStripeStatistics(stripe_idx);
+  } catch (std::exception& e) {
+    VLOG_QUERY << "Cannot read statistics of stripe " << stripe_idx << " in ORC file "
+        << filename() << ": " << e.what();
+    return ValidWriteIdList::SOME;
+  }
+  auto int_stats = dynamic_cast<const orc::IntegerColumnStatistics*>(
+      stripe_stats->getColumnStatistics(CURRENT_TRANSCACTION_TYPE_ID));
+  if (int_stats == nullptr || !int_stats->hasMinimum() || !int_stats->hasMaximum()) {
+    return ValidWriteIdList::SOME;
+  }
+  return valid_write_ids_.IsWriteIdRangeValid(
+      int_stats->getMinimum(), int_stats->getMaximum());
+}
+
+bool HdfsOrcScanner::StripeRejectedByRuntimeFilters(
+    int stripe_idx, const vector<OrcMinMaxFilter>& filters) {
+  if (filters.empty()) return false;
+  if (stripe_idx >= reader_->getNumberOfStripeStatistics()) return false;
+  unique_ptr<orc::StripeStatistics> stripe_stats;
+  try {
+    stripe_stats = reader_->getStripeStatistics(stripe_idx);
+  } catch (std::exception& e) {
+    VLOG_QUERY << "Cannot read statistics of stripe " << stripe_idx << " in ORC file "
+        << filename() << ": " << e.what();
+    return false;
+  }
+  for (const OrcMinMaxFilter& f : filters) {
+    // An empty build side does not let any row pass.
+    if (f.filter->AlwaysFalse()) return true;
+    const orc::ColumnStatistics* stats =
+        stripe_stats->getColumnStatistics(f.node->getColumnId());
+    // Rows with NULL values pass min-max filters.
+    if (stats == nullptr || stats->hasNull()) continue;
+    const ColumnType& type = f.slot_desc->type();
+    if (type.IsIntegerType()) {
+      auto int_stats = dynamic_cast<const orc::IntegerColumnStatistics*>(stats);
+      if (int_stats == nullptr || !int_stats->hasMinimum() || !int_stats->hasMaximum()) {
+        continue;
+      }
+      int64_t data_min = int_stats->getMinimum();
+      int64_t data_max = int_stats->getMaximum();
+      if (!f.filter->EvalOverlap(ColumnType(TYPE_BIGINT), &data_min, &data_max)) {
+        return true;
+      }
+    } else if (type.IsFloatingPointType()) {
+      auto double_stats = dynamic_cast<const orc::DoubleColumnStatistics*>(stats);
+      if (double_stats == nullptr || !double_stats->hasMinimum()
+          || !double_stats->hasMaximum()) {
+        continue;
+      }
+      double data_min = double_stats->getMinimum();
+      double data_max = double_stats->getMaximum();
+      if (std::isnan(data_min) || std::isnan(data_max)) continue;
+      if (type.type == TYPE_FLOAT) {
+        float float_min = data_min;
+        float float_max = data_max;
+        if (!f.filter->EvalOverlap(type, &float_min, &float_max)) return true;
+      } else if (!f.filter->EvalOverlap(type, &data_min, &data_max)) {
+        return true;
+      }
+    } else if (type.type == TYPE_STRING || type.type == TYPE_VARCHAR) {
+      // CHAR values are padded in the file, so their statistics are not comparable.
+      const orc::TypeKind kind = f.node->getKind();
+      if (kind != orc::STRING && kind != orc::VARCHAR) continue;
+      auto string_stats = dynamic_cast<const orc::StringColumnStatistics*>(stats);
+      if (string_stats == nullptr || !string_stats->hasMinimum()
+          || !string_stats->hasMaximum()) {
+        continue;
+      }
+      const string& min_str = string_stats->getMinimum();
+      const string& max_str = string_stats->getMaximum();
+      StringValue data_min(const_cast<char*>(min_str.data()), min_str.size());
+      StringValue data_max(const_cast<char*>(max_str.data()), max_str.size());
+      if (!f.filter->EvalOverlap(type, &data_min, &data_max)) return true;
+    } else if (type.type == TYPE_DATE) {
+      auto date_stats = dynamic_cast<const orc::DateColumnStatistics*>(stats);
+      if (date_stats == nullptr || !date_stats->hasMinimum()
+          || !date_stats->hasMaximum()) {
+        continue;
+      }
+      DateValue data_min(date_stats->getMinimum());
+      DateValue data_max(date_stats->getMaximum());
+      if (!data_min.IsValid() || !data_max.IsValid()) continue;
+      if (!f.filter->EvalOverlap(type, &data_min, &data_max)) return true;
+    }
+  }
+  return false;
+}
+
 Status HdfsOrcScanner::AssembleRows(RowBatch* row_batch) {
   bool continue_execution = !scan_node_->ReachedLimitShared() && !context_->cancelled();
   if (!continue_execution) return Status::CancelledInternal("ORC scanner");
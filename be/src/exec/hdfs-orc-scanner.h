@@ -20,6 +20,7 @@
 #define IMPALA_EXEC_HDFS_ORC_SCANNER_H
 
 #include <stack>
+#include <boost/unordered_set.hpp>
 
 #include <orc/OrcFile.hh>
 
@@ -35,6 +36,7 @@
 namespace impala {
 
 struct HdfsFileDesc;
+class MinMaxFilter;
 class OrcStructReader;
 class OrcComplexColumnReader;
 
@@ -56,6 +58,9 @@ class OrcComplexColumnReader;
 ///   * At the begining of processing a Stripe, we update 'row_reader_options_' to have
 ///     the range of the Stripe boundaries. Then create a orc::RowReader for this Stripe
 ///     (HdfsOrcScanner::NextStripe)
+///   * Submit asynchronous reads of the selected streams of the Stripe. The reads of
+///     the orc::RowReader through ScanRangeInputStream are served from their buffers
+///     (HdfsOrcScanner::PrefetchStripe)
 ///
 class HdfsOrcScanner : public HdfsColumnarScanner {
  public:
@@ -85,10 +90,19 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
 
     void FreeAll();
 
+    /// Hands the allocation at 'p' over to 'dst', which frees it or transfers it to a
+    /// row batch like its own memory. The ORC lib's later free() of 'p' is ignored.
+    /// Returns false if 'p' was not allocated by this pool.
+    bool TransferToMemPool(char* p, MemPool* dst);
+
    private:
     HdfsOrcScanner* scanner_;
     MemTracker* mem_tracker_;
     boost::unordered_map<char*, uint64_t> chunk_sizes_;
+
+    /// Allocations that were handed over by TransferToMemPool() but not yet freed by
+    /// the ORC lib.
+    boost::unordered_set<char*> transferred_chunks_;
   };
 
   /// A wrapper of DiskIoMgr to be used by the ORC lib.
@@ -158,6 +172,10 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// Counts the number of rows processed for the current stripe.
   int64_t stripe_rows_read_ = 0;
 
+  /// The number of rows that zero slot scans return for the file: the rows of the
+  /// stripes in the sample of the scan. -1 until computed.
+  int64_t zero_slot_num_rows_ = -1;
+
   /// Indicates whether we should advance to the next stripe in the next GetNext().
   /// Starts out as true to move to the very first stripe.
   bool advance_stripe_ = true;
@@ -174,8 +192,9 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// Pool to copy dictionary buffer into.
   /// This pool is shared across all the batches in a stripe.
   boost::scoped_ptr<MemPool> dictionary_pool_;
-  /// Pool to copy non-dictionary buffer into. This pool is responsible for handling
-  /// vector batches that do not necessarily fit into one row batch.
+  /// Pool that takes over the string blobs of non-dictionary encoded vector batches
+  /// from 'reader_mem_pool_'. This pool is responsible for handling vector batches that
+  /// do not necessarily fit into one row batch.
   boost::scoped_ptr<MemPool> data_batch_pool_;
 
   std::unique_ptr<OrcSchemaResolver> schema_resolver_ = nullptr;
@@ -230,12 +249,17 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   const SlotDescriptor* acid_synthetic_rowid_ = nullptr;
 
   /// True if we need to validate the row batches against the valid write id list. This
-  /// only needs to be done for Hive Streaming Ingestion. The 'write id' will be the same
-  /// within a stripe, but we still need to read the row batches for validation because
-  /// there are no statistics written.
+  /// only needs to be done for Hive Streaming Ingestion. The 'write id' is usually the
+  /// same within a stripe, but the rows still need to be validated if the statistics of
+  /// the stripe don't show that all or none of its write ids are valid.
   /// For files not written by Streaming Ingestion we can assume that every row is valid.
   bool row_batches_need_validation_ = false;
 
+  /// True if the rows of the current stripe need to be validated. Only set if
+  /// 'row_batches_need_validation_' is true. False if the statistics of the write ids of
+  /// the stripe show that all of them are valid.
+  bool stripe_rows_need_validation_ = false;
+
   /// Timer for materializing rows. This ignores time getting the next buffer.
   ScopedTimer<MonotonicStopWatch> assemble_rows_timer_;
 
@@ -252,6 +276,49 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// with the midpoint of any stripe in the file.
   RuntimeProfile::Counter* num_scanners_with_no_reads_counter_ = nullptr;
 
+  /// Number of stripes skipped because their statistics do not overlap with a min-max
+  /// runtime filter.
+  RuntimeProfile::Counter* num_runtime_filtered_stripes_counter_ = nullptr;
+
+  /// Number of stripes skipped because the statistics of their write ids show that none
+  /// of their rows are valid.
+  RuntimeProfile::Counter* num_invalid_write_id_stripes_counter_ = nullptr;
+
+  /// Number of stripes skipped because they are not in the sample of the scan.
+  RuntimeProfile::Counter* num_unsampled_stripes_counter_ = nullptr;
+
+  /// Number of bytes of stripe streams submitted as asynchronous reads.
+  RuntimeProfile::Counter* prefetched_bytes_counter_ = nullptr;
+
+  /// A byte range of the current stripe that was submitted to the DiskIoMgr when the
+  /// stripe was started. Reads of the ORC lib that fall into it are served from
+  /// 'buffer'.
+  struct PrefetchRange {
+    int64_t offset;
+    int64_t length;
+    uint8_t* buffer;
+    io::ScanRange* scan_range;
+    /// True once the read finished. If 'status' is an error, reads of the range fall
+    /// back to synchronous reads.
+    bool done;
+    Status status;
+  };
+
+  /// The ranges of the selected streams of the current stripe, in file order.
+  std::vector<PrefetchRange> prefetch_ranges_;
+
+  /// Pool for the buffers of 'prefetch_ranges_'. Freed when the next stripe starts.
+  boost::scoped_ptr<MemPool> prefetch_pool_;
+
+  /// An arrived min-max runtime filter that targets a column of the ORC file.
+  struct OrcMinMaxFilter {
+    /// Index of the filter in 'filter_ctxs_'.
+    int filter_idx;
+    MinMaxFilter* filter;
+    const SlotDescriptor* slot_desc;
+    const orc::Type* node;
+  };
+
   /// Number of collection items read in current row batch. It is a scanner-local counter
   /// used to reduce the frequency of updating HdfsScanNode counter. It is updated by the
   /// callees of AssembleRows() and is merged into the HdfsScanNode counter at the end of
@@ -266,6 +333,52 @@ class HdfsOrcScanner : public HdfsColumnarScanner {
   /// row_reader_ to scan it.
   Status NextStripe() WARN_UNUSED_RESULT;
 
+  /// Allocates a scan range that reads 'length' bytes at 'offset' of the file into
+  /// 'buffer'.
+  io::ScanRange* AllocateReadIntoRange(uint8_t* buffer, int64_t length, int64_t offset);
+
+  /// Submits asynchronous reads of the streams of 'stripe' that 'row_reader_' needs,
+  /// merging adjacent streams into one read. Does nothing if ORC_ASYNC_READ is false.
+  /// At most --orc_max_prefetch_bytes_per_stripe bytes are prefetched. The streams
+  /// beyond it, or that do not fit into the memory limit, are read synchronously.
+  void PrefetchStripe(const orc::StripeInformation& stripe);
+
+  /// Copies 'length' bytes at 'offset' of the file to 'buf' if they are within one of
+  /// 'prefetch_ranges_', waiting for its read to finish. Returns false if the bytes were
+  /// not prefetched or the prefetch failed.
+  bool ReadPrefetched(void* buf, uint64_t length, uint64_t offset);
+
+  /// Waits for the read of 'range' to finish.
+  void WaitForPrefetchRange(PrefetchRange* range);
+
+  /// Waits for the outstanding reads of 'prefetch_ranges_' and frees their buffers.
+  void ReleasePrefetchRanges();
+
+  /// Collects the arrived min-max runtime filters whose target is a slot reference to a
+  /// primitive column of the file into 'filters'. Filters are only pushed down if
+  /// ORC_READ_STATISTICS is set and no synthetic row ids are generated, since those
+  /// require reading every row.
+  void GetOrcMinMaxFilters(std::vector<OrcMinMaxFilter>* filters);
+
+  /// Returns true if the statistics of stripe 'stripe_idx' show that none of its rows
+  /// can pass one of 'filters'.
+  bool StripeRejectedByRuntimeFilters(
+      int stripe_idx, const std::vector<OrcMinMaxFilter>& filters);
+
+  /// Returns true if stripe 'stripe_idx' is not in the sample of the scan. Stripes are
+  /// not sampled if synthetic row ids are generated, since those require reading every
+  /// stripe.
+  bool IsStripeUnsampled(int stripe_idx) const;
+
+  /// Returns the number of rows of the stripes of the file that are in the sample of
+  /// the scan.
+  uint64_t NumSampledRows() const;
+
+  /// Returns whether none, some or all of the write ids of the rows of stripe
+  /// 'stripe_idx' are valid according to the statistics of the 'currentTransaction'
+  /// column. Returns SOME if the statistics are missing.
+  ValidWriteIdList::RangeResponse GetStripeWriteIdValidity(int stripe_idx);
+
   /// Reads data to materialize instances of 'tuple_desc'.
   /// Returns a non-OK status if a non-recoverable error was encountered and execution
   /// of this query should be terminated immediately.
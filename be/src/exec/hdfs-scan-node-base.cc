@@ -50,6 +50,7 @@
 #include "runtime/runtime-state.h"
 #include "util/compression-util.h"
 #include "util/disk-info.h"
+#include "util/hash-util.h"
 #include "util/hdfs-util.h"
 #include "util/impalad-metrics.h"
 #include "util/metrics.h"
@@ -72,7 +73,7 @@ using namespace impala::io;
 using namespace strings;
 
 namespace impala {
-PROFILE_DEFINE_TIMER(TotalRawHdfsReadTime, STABLE_LOW, "Aggregate wall clock time"
+PROFILE_DEFINE_STRIPED_TIMER(TotalRawHdfsReadTime, STABLE_LOW, "Aggregate wall clock time"
     " across all Disk I/O threads in HDFS read operations.");
 PROFILE_DEFINE_TIMER(TotalRawHdfsOpenFileTime, STABLE_LOW, "Aggregate wall clock time"
     " spent across all Disk I/O threads in HDFS open operations.");
@@ -81,7 +82,7 @@ PROFILE_DEFINE_DERIVED_COUNTER(PerReadThreadRawHdfsThroughput, STABLE_LOW,
     " while it is executing I/O operations on behalf of a scan.");
 PROFILE_DEFINE_COUNTER(ScanRangesComplete, STABLE_LOW, TUnit::UNIT,
     "Number of scan ranges that have been completed by a scan node.");
-PROFILE_DEFINE_COUNTER(CollectionItemsRead, STABLE_LOW, TUnit::UNIT,
+PROFILE_DEFINE_STRIPED_COUNTER(CollectionItemsRead, STABLE_LOW, TUnit::UNIT,
     "Total number of nested collection items read by the scan. Only created for scans "
     "(e.g. Parquet) that support nested types.");
 PROFILE_DEFINE_COUNTER(NumDisksAccessed, STABLE_LOW, TUnit::UNIT, "Number of distinct "
@@ -103,6 +104,17 @@ PROFILE_DEFINE_SUMMARY_STATS_COUNTER(InitialRangeActualReservation, DEBUG,
     "Use this to determine if the scan got all of the reservation it wanted. Does not "
     "include subsequent reservation increases done by scanner implementation "
     "(e.g. for Parquet columns).");
+PROFILE_DEFINE_SUMMARY_STATS_COUNTER(ScanRangeReadAheadDepth, DEBUG, TUnit::UNIT,
+    "Tracks the number of buffers that scan ranges read ahead of the scanner when "
+    "--adaptive_scan_range_read_ahead is enabled. Updated whenever a scan range "
+    "changes its read-ahead depth.");
+PROFILE_DEFINE_SUMMARY_STATS_COUNTER(DiskQueueWaitTime, DEBUG, TUnit::TIME_NS,
+    "Tracks the time that the scan waited on the I/O manager's disk queues, including "
+    "the remote queues, each time a disk thread picked it up. High values show that "
+    "the I/O requests are queueing rather than being slow on the device.");
+PROFILE_DEFINE_SUMMARY_STATS_COUNTER(DiskQueueDepth, DEBUG, TUnit::UNIT,
+    "Tracks the number of scans, including this one, that were waiting on a disk queue "
+    "each time a disk thread picked up this scan.");
 PROFILE_DEFINE_COUNTER(BytesReadLocal, STABLE_LOW, TUnit::BYTES,
     "The total number of bytes read locally");
 PROFILE_DEFINE_COUNTER(BytesReadShortCircuit, STABLE_LOW, TUnit::BYTES,
@@ -120,8 +132,8 @@ PROFILE_DEFINE_COUNTER(CachedFileHandlesMissCount, STABLE_LOW, TUnit::UNIT,
 PROFILE_DEFINE_HIGH_WATER_MARK_COUNTER(MaxCompressedTextFileLength, STABLE_LOW,
     TUnit::BYTES, "The size of the largest compressed text file to be scanned. "
     "This is used to estimate scanner thread memory usage.");
-PROFILE_DEFINE_TIMER(ScannerIoWaitTime, STABLE_LOW, "Total amount of time scanner "
-    "threads spent waiting for I/O. This value can be compared to the value of "
+PROFILE_DEFINE_STRIPED_TIMER(ScannerIoWaitTime, STABLE_LOW, "Total amount of time "
+    "scanner threads spent waiting for I/O. This value can be compared to the value of "
     "ScannerThreadsTotalWallClockTime of MT_DOP = 0 scan nodes or otherwise compared "
     "to the total time reported for MT_DOP > 0 scan nodes. High values show that "
     "scanner threads are spending significant time waiting for I/O instead of "
@@ -227,6 +239,11 @@ Status HdfsScanPlanNode::Init(const TPlanNode& tnode, FragmentState* state) {
   // Transfer overlap predicate descs.
   overlap_predicate_descs_ = tnode.hdfs_scan_node.overlap_predicate_descs;
 
+  if (tnode.hdfs_scan_node.__isset.iceberg_position_deletes) {
+    shared_state_.serialized_position_deletes_ =
+        &tnode.hdfs_scan_node.iceberg_position_deletes;
+  }
+
   RETURN_IF_ERROR(ProcessScanRangesAndInitSharedState(state));
 
   state->CheckAndAddCodegenDisabledMessage(codegen_status_msgs_);
@@ -406,6 +423,8 @@ HdfsScanNodeBase::HdfsScanNodeBase(ObjectPool* pool, const HdfsScanPlanNode& pno
             hdfs_scan_node.parquet_count_star_slot_offset :
             -1),
     is_partition_key_scan_(hdfs_scan_node.is_partition_key_scan),
+    sample_rate_(hdfs_scan_node.__isset.sample_rate ? hdfs_scan_node.sample_rate : 1.0),
+    sample_seed_(hdfs_scan_node.__isset.sample_seed ? hdfs_scan_node.sample_seed : 0),
     tuple_desc_(pnode.tuple_desc_),
     hdfs_table_(pnode.hdfs_table_),
     avro_schema_(*pnode.avro_schema_.get()),
@@ -423,6 +442,14 @@ HdfsScanNodeBase::HdfsScanNodeBase(ObjectPool* pool, const HdfsScanPlanNode& pno
 
 HdfsScanNodeBase::~HdfsScanNodeBase() {}
 
+bool HdfsScanNodeBase::IsUnitSampled(const char* filename, int64_t unit_idx) const {
+  DCHECK(samples_units());
+  uint64_t hash = HashUtil::MurmurHash2_64(filename, strlen(filename), sample_seed_);
+  hash = HashUtil::MurmurHash2_64(&unit_idx, sizeof(unit_idx), hash);
+  // Maps the top 53 bits of the hash to a uniformly distributed double in [0, 1).
+  return (hash >> 11) * (1.0 / (1LL << 53)) < sample_rate_;
+}
+
 Status HdfsScanNodeBase::Prepare(RuntimeState* state) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
   RETURN_IF_ERROR(ScanNode::Prepare(state));
@@ -525,7 +552,11 @@ Status HdfsScanNodeBase::Open(RuntimeState* state) {
   RETURN_IF_ERROR(ScalarExprEvaluator::Open(min_max_conjunct_evals_, state));
 
   RETURN_IF_ERROR(ClaimBufferReservation(state));
-  reader_context_ = ExecEnv::GetInstance()->disk_io_mgr()->RegisterContext();
+  DiskIoMgr* io_mgr = ExecEnv::GetInstance()->disk_io_mgr();
+  reader_context_ = io_mgr->RegisterContext();
+  reader_context_->set_io_weight(state->query_options().io_scheduling_weight);
+  reader_context_->set_queue_delay_metric(
+      io_mgr->GetPoolQueueDelayMetric(state->query_ctx().request_pool));
 
   // Initialize HdfsScanNode specific counters
   hdfs_read_timer_ = PROFILE_TotalRawHdfsReadTime.Instantiate(runtime_profile());
@@ -552,6 +583,10 @@ Status HdfsScanNodeBase::Open(RuntimeState* state) {
   data_cache_miss_count_ = PROFILE_DataCacheMissCount.Instantiate(runtime_profile());
   data_cache_hit_bytes_ = PROFILE_DataCacheHitBytes.Instantiate(runtime_profile());
   data_cache_miss_bytes_ = PROFILE_DataCacheMissBytes.Instantiate(runtime_profile());
+  read_ahead_depth_stats_ =
+      PROFILE_ScanRangeReadAheadDepth.Instantiate(runtime_profile());
+  disk_queue_wait_time_stats_ = PROFILE_DiskQueueWaitTime.Instantiate(runtime_profile());
+  disk_queue_depth_stats_ = PROFILE_DiskQueueDepth.Instantiate(runtime_profile());
 
   reader_context_->set_bytes_read_counter(bytes_read_counter());
   reader_context_->set_read_timer(hdfs_read_timer_);
@@ -563,6 +598,9 @@ Status HdfsScanNodeBase::Open(RuntimeState* state) {
   reader_context_->set_data_cache_miss_counter(data_cache_miss_count_);
   reader_context_->set_data_cache_hit_bytes_counter(data_cache_hit_bytes_);
   reader_context_->set_data_cache_miss_bytes_counter(data_cache_miss_bytes_);
+  reader_context_->set_read_ahead_depth_counter(read_ahead_depth_stats_);
+  reader_context_->set_queue_wait_counter(disk_queue_wait_time_stats_);
+  reader_context_->set_queue_depth_counter(disk_queue_depth_stats_);
 
   average_hdfs_read_thread_concurrency_ =
       PROFILE_AverageHdfsReadThreadConcurrency.Instantiate(runtime_profile(),
@@ -1165,6 +1203,28 @@ const HdfsFileDesc* ScanRangeSharedState::GetFileDesc(
   return file_descs_[file_desc_map_key];
 }
 
+Status ScanRangeSharedState::GetPositionDeletes(
+    const string& filename, const RoaringBitmap** deletes) {
+  *deletes = nullptr;
+  if (serialized_position_deletes_ == nullptr) return Status::OK();
+  auto serialized = serialized_position_deletes_->find(filename);
+  if (serialized == serialized_position_deletes_->end()) return Status::OK();
+  lock_guard<mutex> l(position_deletes_lock_);
+  unique_ptr<RoaringBitmap>& bitmap = position_deletes_[filename];
+  if (bitmap == nullptr) {
+    unique_ptr<RoaringBitmap> new_bitmap = make_unique<RoaringBitmap>();
+    if (!new_bitmap->UnionSerialized(
+            reinterpret_cast<const uint8_t*>(serialized->second.data()),
+            serialized->second.size())) {
+      return Status(Substitute(
+          "Invalid Iceberg position deletes of data file '$0'.", filename));
+    }
+    bitmap = move(new_bitmap);
+  }
+  *deletes = bitmap.get();
+  return Status::OK();
+}
+
 void ScanRangeSharedState::SetFileMetadata(
     int64_t partition_id, const string& filename, void* metadata) {
   unique_lock<mutex> l(metadata_lock_);
@@ -1209,7 +1269,13 @@ void ScanRangeSharedState::EnqueueScanRange(
         scan_range_queue_.PushFront(scan_range);
         continue;
       }
-      scan_range_queue_.Enqueue(scan_range);
+      // The scanner of a footer or header range scans the whole split that it stands
+      // for.
+      const ScanRangeMetadata* metadata =
+          static_cast<const ScanRangeMetadata*>(scan_range->meta_data());
+      const ScanRange* split = metadata != nullptr && metadata->original_split != nullptr
+          ? metadata->original_split : scan_range;
+      scan_range_queue_.Push(scan_range, split->len());
     }
   } else {
     for (ScanRange* scan_range : ranges) {
@@ -1222,7 +1288,7 @@ Status ScanRangeSharedState::GetNextScanRange(
     RuntimeState* state, ScanRange** scan_range) {
   DCHECK(use_mt_scan_node_) << "Should only be called by MT scan nodes";
   while (true) {
-    *scan_range = scan_range_queue_.Dequeue();
+    *scan_range = scan_range_queue_.Pop();
     if (*scan_range != nullptr) return Status::OK();
     {
       unique_lock<mutex> l(scan_range_submission_lock_);
@@ -20,6 +20,7 @@
 #define IMPALA_EXEC_HDFS_SCAN_NODE_BASE_H_
 
 #include <stdint.h>
+#include <map>
 #include <memory>
 #include <tuple>
 #include <unordered_set>
@@ -32,12 +33,14 @@
 #include "codegen/codegen-fn-ptr.h"
 #include "exec/filter-context.h"
 #include "exec/scan-node.h"
+#include "exec/scan-range-queue.h"
 #include "runtime/descriptors.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
 #include "util/avro-util.h"
 #include "util/container-util.h"
 #include "util/progress-updater.h"
+#include "util/roaring-bitmap.h"
 #include "util/spinlock.h"
 #include "util/unique-id-hash.h"
 
@@ -142,6 +145,12 @@ class ScanRangeSharedState {
   /// partition identified by 'partition_id' .
   Tuple* GetTemplateTupleForPartitionId(int64_t partition_id);
 
+  /// Sets 'deletes' to the bitmap of the positions of the rows of 'filename' that
+  /// Iceberg position delete files deleted, or to nullptr if no rows of the file were
+  /// deleted. The bitmap of a file is deserialized once and shared by all scanners of
+  /// the file. Thread safe.
+  Status GetPositionDeletes(const std::string& filename, const RoaringBitmap** deletes);
+
   ObjectPool* obj_pool() { return &obj_pool_; }
   ProgressUpdater& progress() { return progress_; }
   HdfsFileDesc::FileFormatsMap& per_type_files() { return per_type_files_; }
@@ -169,7 +178,8 @@ class ScanRangeSharedState {
   /// The following public methods are only used by MT scan nodes.
 
   /// Adds all scan ranges to the queue. If 'at_front' is true or the range has
-  /// USE_HDFS_CACHE option set, then adds it to the front of the queue.
+  /// USE_HDFS_CACHE option set, then adds it to the front of the queue. The other ranges
+  /// are handed out largest first, see ScanRangeQueue.
   void EnqueueScanRange(const std::vector<io::ScanRange*>& ranges, bool at_front);
 
   /// Sets a reference to the next scan range in input variable 'scan_range' from a queue
@@ -179,6 +189,10 @@ class ScanRangeSharedState {
   /// left to read.
   Status GetNextScanRange(RuntimeState* state, io::ScanRange** scan_range);
 
+  /// Like GetNextScanRange(), but returns nullptr instead of blocking if the queue is
+  /// empty.
+  io::ScanRange* TryGetNextScanRange() { return scan_range_queue_.Pop(); }
+
   /// Add the required hooks to the runtime state that gets triggered in case of
   /// cancellation. Must be called before adding or removing scan ranges to the queue.
   void AddCancellationHook(RuntimeState* state);
@@ -205,6 +219,16 @@ class ScanRangeSharedState {
   std::mutex metadata_lock_;
   std::unordered_map<HdfsFileDesc::PartitionFileKey, void*, pair_hash> per_file_metadata_;
 
+  /// The serialized bitmaps of the deleted rows of data files, by file path. Points to
+  /// THdfsScanNode.iceberg_position_deletes of the plan node, or nullptr if it is not
+  /// set.
+  const std::map<std::string, std::string>* serialized_position_deletes_ = nullptr;
+
+  /// The deserialized bitmaps of 'serialized_position_deletes_', by file path, and the
+  /// lock that protects them.
+  std::mutex position_deletes_lock_;
+  std::unordered_map<std::string, std::unique_ptr<RoaringBitmap>> position_deletes_;
+
   /// Map from partition ID to a template tuple (owned by template_pool_) which has only
   /// the partition columns for that partition materialized. Used to filter files and scan
   /// ranges on partition-column filters. Populated in HdfsScanPlanNode::Init().
@@ -245,7 +269,7 @@ class ScanRangeSharedState {
 
   /// Queue of all scan ranges that need to be read. Shared by all instances of this
   /// fragment. Only used for MT scans.
-  InternalQueue<io::ScanRange> scan_range_queue_;
+  ScanRangeQueue scan_range_queue_;
 
   /// END: Members that are used only by MT scan nodes(use_mt_scan_node_ is true).
   /////////////////////////////////////////////////////////////////////
@@ -436,6 +460,16 @@ class HdfsScanNodeBase : public ScanNode {
   int parquet_count_star_slot_offset() const { return parquet_count_star_slot_offset_; }
   bool is_partition_key_scan() const { return is_partition_key_scan_; }
 
+  /// True if the Parquet and ORC scanners only read a sample of the row groups and
+  /// stripes of their files. See IsUnitSampled().
+  bool samples_units() const { return sample_rate_ < 1.0; }
+
+  /// Returns true if the unit 'unit_idx' of the file 'filename', i.e. a row group of a
+  /// Parquet file or a stripe of an ORC file, is in the sample of the scan. Every unit is
+  /// sampled with probability 'sample_rate_', by a hash of 'filename', 'unit_idx' and
+  /// 'sample_seed_'. Only valid if samples_units() is true.
+  bool IsUnitSampled(const char* filename, int64_t unit_idx) const;
+
   typedef std::unordered_map<TupleId, std::vector<ScalarExprEvaluator*>>
     ConjunctEvaluatorsMap;
   const ConjunctEvaluatorsMap& conjuncts_map() const { return conjunct_evals_map_; }
@@ -542,6 +576,13 @@ class HdfsScanNodeBase : public ScanNode {
     return shared_state_->GetFileMetadata(partition_id, filename);
   }
 
+  /// Sets 'deletes' to the positions of the deleted rows of 'filename', or to nullptr if
+  /// it has none. See ScanRangeSharedState::GetPositionDeletes().
+  inline Status GetPositionDeletes(
+      const std::string& filename, const RoaringBitmap** deletes) {
+    return shared_state_->GetPositionDeletes(filename, deletes);
+  }
+
   /// Called by scanners when a range is complete. Used to record progress.
   /// This *must* only be called after a scanner has completely finished its
   /// scan range (i.e. context->Flush()), and has returned the final row batch.
@@ -653,6 +694,11 @@ class HdfsScanNodeBase : public ScanNode {
   // to do the minimum possible work to materialise one row.
   const bool is_partition_key_scan_;
 
+  /// Fraction of the row groups and stripes that are read and the seed of the sample.
+  /// See THdfsScanNode.sample_rate.
+  const double sample_rate_;
+  const int64_t sample_seed_;
+
   /// RequestContext object to use with the disk-io-mgr for reads.
   std::unique_ptr<io::RequestContext> reader_context_;
 
@@ -735,6 +781,9 @@ class HdfsScanNodeBase : public ScanNode {
   RuntimeProfile::Counter* hdfs_open_file_timer_ = nullptr;
   RuntimeProfile::SummaryStatsCounter* initial_range_ideal_reservation_stats_ = nullptr;
   RuntimeProfile::SummaryStatsCounter* initial_range_actual_reservation_stats_ = nullptr;
+  RuntimeProfile::SummaryStatsCounter* read_ahead_depth_stats_ = nullptr;
+  RuntimeProfile::SummaryStatsCounter* disk_queue_wait_time_stats_ = nullptr;
+  RuntimeProfile::SummaryStatsCounter* disk_queue_depth_stats_ = nullptr;
   RuntimeProfile::SummaryStatsCounter* compressed_bytes_read_per_column_counter_ =
       nullptr;
   RuntimeProfile::SummaryStatsCounter* uncompressed_bytes_read_per_column_counter_ =
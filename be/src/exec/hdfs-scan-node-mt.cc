@@ -24,6 +24,7 @@
 #include "runtime/runtime-state.h"
 #include "runtime/row-batch.h"
 #include "runtime/exec-env.h"
+#include "runtime/io/disk-io-mgr.h"
 #include "util/debug-util.h"
 #include "util/runtime-profile-counters.h"
 
@@ -73,8 +74,12 @@ Status HdfsScanNodeMt::GetNext(RuntimeState* state, RowBatch* row_batch, bool* e
       scanner_->Close(row_batch);
       scanner_.reset();
     }
-    int64_t scanner_reservation = buffer_pool_client()->GetReservation();
-    RETURN_IF_ERROR(StartNextScanRange(filter_ctxs_, &scanner_reservation, &scan_range_));
+    int64_t scanner_reservation;
+    RETURN_IF_ERROR(NextPrefetchedScanRange(&scanner_reservation));
+    if (scan_range_ == nullptr) {
+      RETURN_IF_ERROR(
+          StartNextScanRange(filter_ctxs_, &scanner_reservation, &scan_range_));
+    }
     if (scan_range_ == nullptr) {
       *eos = true;
       StopAndFinalizeCounters();
@@ -95,6 +100,7 @@ Status HdfsScanNodeMt::GetNext(RuntimeState* state, RowBatch* row_batch, bool* e
       scan_range_->Cancel(status);
       return status;
     }
+    RETURN_IF_ERROR(PrefetchScanRanges());
   }
 
   // We only need one row per partition. Limit the capacity to prevent the scanner
@@ -112,6 +118,7 @@ Status HdfsScanNodeMt::GetNext(RuntimeState* state, RowBatch* row_batch, bool* e
     scan_range_ = NULL;
     scanner_->Close(row_batch);
     scanner_.reset();
+    CancelPrefetchedScanRanges();
     *eos = true;
   } else if (row_batch->num_rows() > 0 && is_partition_key_scan_) {
     // Only return one from each scan range.
@@ -136,10 +143,82 @@ Status HdfsScanNodeMt::CreateAndOpenScanner(HdfsPartitionDescriptor* partition,
   return status;
 }
 
+Status HdfsScanNodeMt::PrefetchScanRanges() {
+  DiskIoMgr* io_mgr = ExecEnv::GetInstance()->disk_io_mgr();
+  while (prefetched_ranges_.size() < MAX_PREFETCHED_SCAN_RANGES) {
+    ScanRange* scan_range = shared_state_->TryGetNextScanRange();
+    if (scan_range == nullptr) break;
+    bool needs_buffers;
+    RETURN_IF_ERROR(reader_context_->StartScanRange(scan_range, &needs_buffers));
+    if (!needs_buffers) {
+      prefetched_ranges_.push_back({scan_range, 0, false});
+      continue;
+    }
+    // A single I/O buffer is enough to overlap the first round trip. The range gets no
+    // more buffers once it is scanned, so larger ranges are read one buffer at a time.
+    int64_t reservation = min(io_mgr->ComputeIdealBufferReservation(
+        scan_range->bytes_to_read()), io_mgr->max_buffer_size());
+    if (!buffer_pool_client()->IncreaseReservation(reservation)) {
+      // The range is scanned next and gets its buffers from the reservation of the
+      // scanner then.
+      prefetched_ranges_.push_back({scan_range, 0, true});
+      break;
+    }
+    Status status =
+        io_mgr->AllocateBuffersForRange(buffer_pool_client(), scan_range, reservation);
+    if (!status.ok()) {
+      scan_range->Cancel(status);
+      return status;
+    }
+    prefetched_ranges_.push_back({scan_range, reservation, false});
+    prefetched_reservation_ += reservation;
+  }
+  return Status::OK();
+}
+
+Status HdfsScanNodeMt::NextPrefetchedScanRange(int64_t* reservation) {
+  scan_range_ = nullptr;
+  bool needs_buffers = false;
+  while (scan_range_ == nullptr && !prefetched_ranges_.empty()) {
+    PrefetchedScanRange prefetched = prefetched_ranges_.front();
+    prefetched_ranges_.pop_front();
+    prefetched_reservation_ -= prefetched.reservation;
+    // Filters may have arrived since the range was prefetched.
+    int64_t partition_id =
+        static_cast<ScanRangeMetadata*>(prefetched.scan_range->meta_data())->partition_id;
+    if (filter_ctxs_.size() > 0
+        && !PartitionPassesFilters(partition_id, FilterStats::SPLITS_KEY, filter_ctxs_)) {
+      SkipScanRange(prefetched.scan_range);
+      continue;
+    }
+    scan_range_ = prefetched.scan_range;
+    needs_buffers = prefetched.needs_buffers;
+  }
+  *reservation = buffer_pool_client()->GetReservation() - prefetched_reservation_;
+  if (needs_buffers) {
+    // Same as in StartNextScanRange().
+    DiskIoMgr* io_mgr = ExecEnv::GetInstance()->disk_io_mgr();
+    *reservation = IncreaseReservationIncrementally(*reservation,
+        io_mgr->ComputeIdealBufferReservation(scan_range_->bytes_to_read()));
+    RETURN_IF_ERROR(
+        io_mgr->AllocateBuffersForRange(buffer_pool_client(), scan_range_, *reservation));
+  }
+  return Status::OK();
+}
+
+void HdfsScanNodeMt::CancelPrefetchedScanRanges() {
+  for (const PrefetchedScanRange& prefetched : prefetched_ranges_) {
+    prefetched.scan_range->Cancel(Status::CancelledInternal("Scan range prefetch"));
+  }
+  prefetched_ranges_.clear();
+  prefetched_reservation_ = 0;
+}
+
 void HdfsScanNodeMt::Close(RuntimeState* state) {
   if (is_closed()) return;
   if (scanner_.get() != nullptr) scanner_->Close(nullptr);
   scanner_.reset();
+  CancelPrefetchedScanRanges();
   scanner_ctx_.reset();
   HdfsScanNodeBase::Close(state);
 }
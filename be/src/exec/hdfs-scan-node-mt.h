@@ -19,6 +19,8 @@
 #ifndef IMPALA_EXEC_HDFS_SCAN_NODE_MT_H_
 #define IMPALA_EXEC_HDFS_SCAN_NODE_MT_H_
 
+#include <deque>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "exec/hdfs-scanner.h"
@@ -35,6 +37,12 @@ class TPlanNode;
 
 /// Scan node that materializes tuples, evaluates conjuncts and runtime filters
 /// in the thread calling GetNext(). Uses the HdfsScanner::GetNext() interface.
+///
+/// While a scanner decodes the current scan range, the scan node starts the I/O for up
+/// to MAX_PREFETCHED_SCAN_RANGES of the next ranges in the shared queue, e.g. the footers
+/// of the next Parquet or ORC files, so that their round trip to remote storage overlaps
+/// with the decoding. The buffers of the prefetched ranges are allocated from additional
+/// reservation, so the look-ahead is bounded by the maximum reservation of the node.
 class HdfsScanNodeMt : public HdfsScanNodeBase {
  public:
   HdfsScanNodeMt(
@@ -65,6 +73,38 @@ class HdfsScanNodeMt : public HdfsScanNodeBase {
   Status CreateAndOpenScanner(HdfsPartitionDescriptor* partition,
       ScannerContext* context, boost::scoped_ptr<HdfsScanner>* scanner);
 
+  /// The maximum number of scan ranges that are started ahead of the current one.
+  static constexpr int MAX_PREFETCHED_SCAN_RANGES = 2;
+
+  /// A scan range that was started by PrefetchScanRanges() before it is scanned.
+  struct PrefetchedScanRange {
+    io::ScanRange* scan_range;
+    /// The reservation used by the buffers allocated to 'scan_range'.
+    int64_t reservation;
+    /// True if 'scan_range' needs buffers but none were allocated, because the
+    /// reservation could not be increased.
+    bool needs_buffers;
+  };
+
+  /// Starts the next ranges of the shared queue until MAX_PREFETCHED_SCAN_RANGES ranges
+  /// are prefetched, the queue is empty or the reservation for their buffers cannot be
+  /// increased. Does not block waiting for ranges.
+  Status PrefetchScanRanges() WARN_UNUSED_RESULT;
+
+  /// Sets 'scan_range_' to the first prefetched range that passes the partition filters,
+  /// or to nullptr if there is none. Prefetched ranges that do not pass are skipped.
+  /// Sets 'reservation' to the reservation available to the next scanner, which
+  /// includes the buffers of 'scan_range_'.
+  Status NextPrefetchedScanRange(int64_t* reservation) WARN_UNUSED_RESULT;
+
+  /// Frees the buffers of the prefetched ranges that were not scanned yet.
+  void CancelPrefetchedScanRanges();
+
+  /// Ranges started by PrefetchScanRanges() in queue order and the reservation reserved
+  /// for their buffers, which is not available to the current scanner.
+  std::deque<PrefetchedScanRange> prefetched_ranges_;
+  int64_t prefetched_reservation_ = 0;
+
   /// Current scan range and corresponding scanner.
   io::ScanRange* scan_range_;
   boost::scoped_ptr<ScannerContext> scanner_ctx_;
@@ -29,18 +29,20 @@
 #include "exprs/scalar-expr-evaluator.h"
 #include "runtime/blocking-row-batch-queue.h"
 #include "runtime/descriptors.h"
-#include "runtime/fragment-instance-state.h"
 #include "runtime/io/request-context.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/pool-cgroup-mgr.h"
 #include "runtime/query-state.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-filter.inline.h"
 #include "runtime/runtime-state.h"
 #include "runtime/scanner-mem-limiter.h"
 #include "runtime/thread-resource-mgr.h"
+#include "util/cpu-sampler.h"
 #include "util/debug-util.h"
 #include "util/disk-info.h"
 #include "util/runtime-profile-counters.h"
+#include "util/time.h"
 
 #include "common/names.h"
 
@@ -62,6 +64,10 @@ using namespace impala::io;
 DEFINE_int64_hidden(hdfs_scanner_thread_max_estimated_bytes, 32L * 1024L * 1024L,
     "Estimated bytes of memory consumed by HDFS scanner thread.");
 
+DEFINE_int32_hidden(scanner_thread_target_sample_interval_ms, 200,
+    "The interval, in ms, at which scan nodes that choose the number of their scanner "
+    "threads from their throughput (query option DYNAMIC_SCANNER_THREADS) sample it.");
+
 // Estimated upper bound on the compression ratio of compressed text files. Used to
 // estimate scanner thread memory usage.
 const int COMPRESSED_TEXT_COMPRESSION_RATIO = 11;
@@ -130,6 +136,7 @@ Status HdfsScanNode::GetNextInternal(
     return Status::OK();
   }
   *eos = false;
+  if (concurrency_controller_ != nullptr) UpdateScannerThreadTarget();
   unique_ptr<RowBatch> materialized_batch = thread_state_.batch_queue()->GetBatch();
   if (materialized_batch != NULL) {
     row_batch->AcquireState(materialized_batch.get());
@@ -166,6 +173,20 @@ Status HdfsScanNode::Open(RuntimeState* state) {
   ScopedOpenEventAdder ea(this);
   RETURN_IF_ERROR(HdfsScanNodeBase::Open(state));
   thread_state_.Open(this, FLAGS_max_row_batches);
+  scanner_thread_target_.Store(thread_state_.max_num_scanner_threads());
+  if (state->query_options().dynamic_scanner_threads) {
+    concurrency_controller_.reset(
+        new ScannerConcurrencyController(thread_state_.max_num_scanner_threads()));
+    scanner_thread_target_.Store(concurrency_controller_->target());
+    runtime_profile()->AddSamplingTimeSeriesCounter("ScannerThreadTarget", TUnit::UNIT,
+        [this]() { return static_cast<int64_t>(scanner_thread_target_.Load()); });
+    scanner_thread_target_increases_counter_ =
+        ADD_COUNTER(runtime_profile(), "NumScannerThreadTargetIncreases", TUnit::UNIT);
+    scanner_thread_target_decreases_counter_ =
+        ADD_COUNTER(runtime_profile(), "NumScannerThreadTargetDecreases", TUnit::UNIT);
+    scanner_threads_stopped_by_target_counter_ =
+        ADD_COUNTER(runtime_profile(), "NumScannerThreadsStoppedByTarget", TUnit::UNIT);
+  }
 
   thread_avail_cb_id_ = runtime_state_->resource_pool()->AddThreadAvailableCb(
       bind<void>(mem_fn(&HdfsScanNode::ThreadTokenAvailableCb), this, _1));
@@ -265,7 +286,8 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
   //     estimated memory consumption (include reservation and non-reserved memory).
   //  7. Don't start up a thread if it is an extra thread and we can't reserve another
   //     minimum reservation's worth of memory for the thread.
-  //  8. Don't start up more than maximum number of scanner threads configured.
+  //  8. Don't start up more than maximum number of scanner threads configured, or
+  //     than the target number of threads, if it is chosen from their throughput.
   //  9. Don't start up if there are no thread tokens.
 
   // Case 4. We have not issued the initial ranges so don't start a scanner thread.
@@ -325,7 +347,7 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
     if (first_thread) {
       // The first thread is required to make progress on the scan.
       pool->AcquireThreadToken();
-    } else if (thread_state_.GetNumActive() >= thread_state_.max_num_scanner_threads()
+    } else if (thread_state_.GetNumActive() >= scanner_thread_target_.Load()
         || !pool->TryAcquireThreadToken()) {
       scanner_mem_limiter->ReleaseMemoryForScannerThread(this, est_mem);
       ReturnReservationFromScannerThread(lock, scanner_thread_reservation);
@@ -338,9 +360,9 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
     auto fn = [this, first_thread, scanner_thread_reservation]() {
       this->ScannerThread(first_thread, scanner_thread_reservation);
     };
-    std::unique_ptr<Thread> t;
-    status = Thread::Create(
-        FragmentInstanceState::FINST_THREAD_GROUP_NAME, name, fn, &t, true);
+    // Scanner threads run on the process-wide pool of scanner workers, which avoids
+    // creating a thread every time that a thread token becomes available.
+    status = thread_state_.AddPooledThread(name, fn);
     if (!status.ok()) {
       if (!first_thread) {
         scanner_mem_limiter->ReleaseMemoryForScannerThread(this, est_mem);
@@ -348,8 +370,8 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
       ReturnReservationFromScannerThread(lock, scanner_thread_reservation);
       // Release the token and skip running callbacks to find a replacement. Skipping
       // serves two purposes. First, it prevents a mutual recursion between this function
-      // and ReleaseThreadToken()->InvokeCallbacks(). Second, Thread::Create() failed and
-      // is likely to continue failing for future callbacks.
+      // and ReleaseThreadToken()->InvokeCallbacks(). Second, creating a thread failed
+      // and is likely to continue failing for future callbacks.
       pool->ReleaseThreadToken(first_thread, true);
 
       // Abort the query. This is still holding the lock_, so done_ is known to be
@@ -358,14 +380,45 @@ void HdfsScanNode::ThreadTokenAvailableCb(ThreadResourcePool* pool) {
       SetDoneInternal(status);
       break;
     }
-    // Thread successfully started
-    thread_state_.AddThread(move(t));
   }
 }
 
+void HdfsScanNode::UpdateScannerThreadTarget() {
+  DCHECK(concurrency_controller_ != nullptr);
+  const int64_t now_ns = MonotonicNanos();
+  const int64_t rows_read = rows_read_counter()->value();
+  if (last_sample_time_ns_ == 0) {
+    // The first interval starts with the first GetNext() call, after the scanner
+    // threads may have waited for runtime filters.
+    last_sample_time_ns_ = now_ns;
+    last_sample_rows_read_ = rows_read;
+    return;
+  }
+  const int64_t duration_ns = now_ns - last_sample_time_ns_;
+  if (duration_ns < FLAGS_scanner_thread_target_sample_interval_ms * 1000000L) return;
+  const int old_target = concurrency_controller_->target();
+  const int target = concurrency_controller_->AddSample(thread_state_.GetNumActive(),
+      rows_read - last_sample_rows_read_, duration_ns,
+      thread_state_.batch_queue()->IsFull());
+  last_sample_time_ns_ = now_ns;
+  last_sample_rows_read_ = rows_read;
+  if (target == old_target) return;
+  scanner_thread_target_.Store(target);
+  COUNTER_SET(scanner_thread_target_increases_counter_,
+      concurrency_controller_->num_increases());
+  COUNTER_SET(scanner_thread_target_decreases_counter_,
+      concurrency_controller_->num_decreases());
+  // Threads above a lowered target stop on their own after their current scan range.
+  if (target > old_target) ThreadTokenAvailableCb(runtime_state_->resource_pool());
+}
+
 void HdfsScanNode::ScannerThread(bool first_thread, int64_t scanner_thread_reservation) {
   SCOPED_THREAD_COUNTER_MEASUREMENT(thread_state_.thread_counters());
   SCOPED_THREAD_COUNTER_MEASUREMENT(runtime_state_->total_thread_statistics());
+  ScopedCpuSampler cpu_sampler(runtime_state_->cpu_samples());
+  ScopedPoolCGroup pool_cgroup(runtime_state_->query_ctx().request_pool);
+  ScopedLockContentionCounters lock_contention(
+      runtime_state_->query_state()->lock_contention_counters());
   // Make thread-local copy of filter contexts to prune scan ranges, and to pass to the
   // scanner for finer-grained filtering. Use a thread-local MemPool for the filter
   // contexts as the embedded expression evaluators may allocate from it and MemPool
@@ -444,6 +497,15 @@ void HdfsScanNode::ScannerThread(bool first_thread, int64_t scanner_thread_reser
       break;
     }
 
+    // Stop extra threads if there are more than the target number of threads. This check
+    // is racy like the one for optional tokens: if too many threads stop,
+    // ThreadTokenAvailableCb() starts new ones.
+    if (!first_thread && concurrency_controller_ != nullptr
+        && thread_state_.GetNumActive() > scanner_thread_target_.Load()) {
+      COUNTER_ADD(scanner_threads_stopped_by_target_counter_, 1);
+      break;
+    }
+
     if (scan_range == nullptr) COUNTER_ADD(scanner_thread_workless_loops_counter_, 1);
   }
 
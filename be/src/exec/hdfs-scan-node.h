@@ -28,6 +28,7 @@
 #include "common/atomic.h"
 #include "exec/filter-context.h"
 #include "exec/hdfs-scan-node-base.h"
+#include "exec/scanner-concurrency-controller.h"
 #include "util/counting-barrier.h"
 
 namespace impala {
@@ -156,6 +157,29 @@ class HdfsScanNode : public HdfsScanNodeBase {
   /// Number of times scanner thread didn't find work to do.
   RuntimeProfile::Counter* scanner_thread_workless_loops_counter_ = nullptr;
 
+  /// Chooses the number of scanner threads from their throughput if the
+  /// DYNAMIC_SCANNER_THREADS query option is set, nullptr otherwise. Created in Open()
+  /// and only used by the thread that calls GetNext().
+  std::unique_ptr<ScannerConcurrencyController> concurrency_controller_;
+
+  /// The maximum number of scanner threads that the scan node runs. The target of
+  /// 'concurrency_controller_' if there is one, otherwise the maximum number of scanner
+  /// threads of 'thread_state_'. Set in Open().
+  AtomicInt32 scanner_thread_target_{0};
+
+  /// Time in MonotonicNanos() and value of rows_read_counter() at the last sample that
+  /// was added to 'concurrency_controller_'. 'last_sample_time_ns_' is 0 before the
+  /// first sample.
+  int64_t last_sample_time_ns_ = 0;
+  int64_t last_sample_rows_read_ = 0;
+
+  /// Number of times that 'concurrency_controller_' raised or lowered the target and
+  /// number of scanner threads that stopped because there were more than the target.
+  /// Only created if 'concurrency_controller_' is used.
+  RuntimeProfile::Counter* scanner_thread_target_increases_counter_ = nullptr;
+  RuntimeProfile::Counter* scanner_thread_target_decreases_counter_ = nullptr;
+  RuntimeProfile::Counter* scanner_threads_stopped_by_target_counter_ = nullptr;
+
   /// Compute the estimated memory consumption of a scanner thread in bytes for the
   /// purposes of deciding whether to start a new scanner thread.
   int64_t EstimateScannerThreadMemConsumption() const;
@@ -164,6 +188,11 @@ class HdfsScanNode : public HdfsScanNodeBase {
   /// (e.g., when adding new ranges) or when threads are available for this scan node.
   void ThreadTokenAvailableCb(ThreadResourcePool* pool);
 
+  /// Adds a sample of the throughput of the scanner threads to 'concurrency_controller_'
+  /// if the sample interval passed, and starts more scanner threads if that raised the
+  /// target. Called from GetNextInternal() if 'concurrency_controller_' is used.
+  void UpdateScannerThreadTarget();
+
   /// Main function for scanner thread. This thread pulls the next range to be
   /// processed from the IoMgr and then processes the entire range end to end.
   /// This thread terminates when all scan ranges are complete or an error occurred.
@@ -16,6 +16,7 @@
 // under the License.
 
 #include "exec/hdfs-table-sink.h"
+#include "common/atomic.h"
 #include "exec/exec-node.h"
 #include "exec/hdfs-table-writer.h"
 #include "exec/hdfs-text-table-writer.h"
@@ -24,6 +25,7 @@
 #include "exprs/scalar-expr.h"
 #include "gen-cpp/ImpalaInternalService_constants.h"
 #include "gutil/stringprintf.h"
+#include "runtime/fragment-instance-state.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.inline.h"
@@ -34,6 +36,7 @@
 #include "util/hdfs-util.h"
 #include "util/impalad-metrics.h"
 #include "util/metrics.h"
+#include "util/thread.h"
 
 #include <limits>
 #include <vector>
@@ -48,6 +51,11 @@
 
 #include "common/names.h"
 
+DEFINE_int32(insert_file_close_threads, 16, "The maximum number of threads that an "
+    "HdfsTableSink uses to close the files of its output partitions concurrently when it "
+    "finishes. Closing a file on an object store like S3 waits for its upload to "
+    "complete. If 1, the files are closed one at a time.");
+
 using boost::posix_time::microsec_clock;
 using boost::posix_time::ptime;
 using namespace strings;
@@ -721,7 +729,7 @@ Status HdfsTableSink::Send(RuntimeState* state, RowBatch* batch) {
 }
 
 Status HdfsTableSink::FinalizePartitionFile(
-    RuntimeState* state, OutputPartition* partition) {
+    RuntimeState* state, OutputPartition* partition, bool close_file) {
   if (partition->tmp_hdfs_file == nullptr && !overwrite_) return Status::OK();
   SCOPED_TIMER(ADD_TIMER(profile(), "FinalizePartitionFileTimer"));
 
@@ -734,10 +742,47 @@ Status HdfsTableSink::FinalizePartitionFile(
     state->dml_exec_state()->AddCreatedFile(*partition);
   }
 
-  RETURN_IF_ERROR(ClosePartitionFile(state, partition));
+  if (close_file) RETURN_IF_ERROR(ClosePartitionFile(state, partition));
   return Status::OK();
 }
 
+Status HdfsTableSink::ClosePartitionFiles(
+    RuntimeState* state, const vector<OutputPartition*>& partitions) {
+  const int num_threads =
+      min<int>(max(FLAGS_insert_file_close_threads, 1), partitions.size());
+  if (num_threads <= 1) {
+    for (OutputPartition* partition : partitions) {
+      RETURN_IF_ERROR(ClosePartitionFile(state, partition));
+    }
+    return Status::OK();
+  }
+  SCOPED_TIMER(ADD_TIMER(profile(), "ClosePartitionFilesTimer"));
+  // Every thread closes the next file that no thread closed yet.
+  AtomicInt32 next_partition_idx(0);
+  vector<Status> statuses(partitions.size());
+  auto close_files = [&]() {
+    for (int i = next_partition_idx.Add(1) - 1; i < partitions.size();
+         i = next_partition_idx.Add(1) - 1) {
+      statuses[i] = ClosePartitionFile(state, partitions[i]);
+    }
+  };
+  vector<unique_ptr<Thread>> threads;
+  Status status;
+  for (int i = 0; i < num_threads - 1; ++i) {
+    unique_ptr<Thread> thread;
+    status = Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME,
+        Substitute("hdfs-file-close (finst:$0)", PrintId(state->fragment_instance_id())),
+        close_files, &thread);
+    // The files are still closed by the threads that were started and this thread.
+    if (!status.ok()) break;
+    threads.push_back(move(thread));
+  }
+  close_files();
+  for (unique_ptr<Thread>& thread : threads) thread->Join();
+  for (const Status& close_status : statuses) status.MergeStatus(close_status);
+  return status;
+}
+
 Status HdfsTableSink::ClosePartitionFile(
     RuntimeState* state, OutputPartition* partition) {
   if (partition->tmp_hdfs_file == nullptr) return Status::OK();
@@ -764,13 +809,18 @@ Status HdfsTableSink::FlushFinal(RuntimeState* state) {
     RETURN_IF_ERROR(GetOutputPartition(state, nullptr, ROOT_PARTITION_KEY, &dummy, true));
   }
 
-  // Close Hdfs files, and update stats in runtime state.
+  // Update stats in runtime state, and close Hdfs files. The files of all partitions
+  // are finalized before they are closed concurrently.
+  vector<OutputPartition*> partitions_to_close;
   for (PartitionMap::iterator cur_partition =
           partition_keys_to_output_partitions_.begin();
       cur_partition != partition_keys_to_output_partitions_.end();
       ++cur_partition) {
-    RETURN_IF_ERROR(FinalizePartitionFile(state, cur_partition->second.first.get()));
+    OutputPartition* partition = cur_partition->second.first.get();
+    RETURN_IF_ERROR(FinalizePartitionFile(state, partition, false));
+    if (partition->tmp_hdfs_file != nullptr) partitions_to_close.push_back(partition);
   }
+  RETURN_IF_ERROR(ClosePartitionFiles(state, partitions_to_close));
   // Returns OK if there is no debug action.
   return DebugAction(state->query_options(), "FIS_FAIL_HDFS_TABLE_SINK_FLUSH_FINAL");
 }
@@ -189,9 +189,16 @@ class HdfsTableSink : public DataSink {
   Status WriteClusteredRowBatch(RuntimeState* state, RowBatch* batch) WARN_UNUSED_RESULT;
 
   /// Updates runtime stats of HDFS with rows written, then closes the file associated
-  /// with the partition by calling ClosePartitionFile()
-  Status FinalizePartitionFile(RuntimeState* state, OutputPartition* partition)
-      WARN_UNUSED_RESULT;
+  /// with the partition by calling ClosePartitionFile() if 'close_file' is true.
+  Status FinalizePartitionFile(RuntimeState* state, OutputPartition* partition,
+      bool close_file = true) WARN_UNUSED_RESULT;
+
+  /// Closes the files of 'partitions' with up to --insert_file_close_threads threads.
+  /// Closing a file on an object store like S3 waits for its upload to complete, so
+  /// closing the files of many partitions one at a time makes the sink bound by the
+  /// latency of the uploads. Returns the first error.
+  Status ClosePartitionFiles(RuntimeState* state,
+      const std::vector<OutputPartition*>& partitions) WARN_UNUSED_RESULT;
 
   /// Closes the hdfs file for this partition as well as the writer.
   Status ClosePartitionFile(RuntimeState* state, OutputPartition* partition)
@@ -42,6 +42,7 @@
 #include "gen-cpp/ErrorCodes_types.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/descriptors.h"
+#include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
@@ -53,6 +54,7 @@
 #include "runtime/tuple.h"
 #include "util/codec.h"
 #include "util/error-util.h"
+#include "util/parallel-decompress.h"
 #include "util/runtime-profile-counters.h"
 #include "util/stopwatch.h"
 
@@ -82,6 +84,15 @@ const string HdfsTextScanner::LZO_INDEX_SUFFIX = ".index";
 // progress.
 const int64_t COMPRESSED_DATA_FIXED_READ_SIZE = 1 * 1024 * 1024;
 
+// Number of bytes to read when no complete frame was found in the first buffer of
+// 'stream_' for parallel decompression.
+const int64_t PARALLEL_DECOMPRESSION_FIXED_READ_SIZE = 4 * 1024 * 1024;
+
+// Maximum number of frames and decompressed bytes of a single FillByteBufferParallel()
+// call.
+const int PARALLEL_DECOMPRESSION_MAX_FRAMES = 1024;
+const int64_t PARALLEL_DECOMPRESSION_MAX_LEN = 64 * 1024 * 1024;
+
 HdfsTextScanner::HdfsTextScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
     : HdfsScanner(scan_node, state),
       byte_buffer_ptr_(nullptr),
@@ -237,6 +248,13 @@ Status HdfsTextScanner::InitNewRange() {
     compression_type = THdfsCompression::DEFAULT;
   }
   RETURN_IF_ERROR(UpdateDecompressor(compression_type));
+  // Multi-frame files can be split into frames that are decompressed in parallel.
+  // Otherwise the streaming decompressor takes over at the next frame boundary.
+  parallel_decompression_ = decompressor_ != nullptr
+      && decompressor_->supports_streaming()
+      && state_->query_options().text_parallel_decompression
+      && ParallelDecompressor::SupportsFormat(compression_type)
+      && ExecEnv::GetInstance()->text_decompression_pool() != nullptr;
 
   HdfsPartitionDescriptor* hdfs_partition = context_->partition_descriptor();
   char field_delim = hdfs_partition->field_delim();
@@ -528,6 +546,9 @@ Status HdfsTextScanner::FillByteBuffer(MemPool* pool, bool* eosr, int num_bytes)
           reinterpret_cast<uint8_t**>(&byte_buffer_ptr_), &byte_buffer_read_size_));
     }
     *eosr = stream_->eosr();
+  } else if (parallel_decompression_) {
+    DCHECK_EQ(num_bytes, 0);
+    RETURN_IF_ERROR(FillByteBufferParallel(pool, eosr));
   } else if (decompressor_->supports_streaming()) {
     DCHECK_EQ(num_bytes, 0);
     RETURN_IF_ERROR(FillByteBufferCompressedStream(pool, eosr));
@@ -639,6 +660,85 @@ Status HdfsTextScanner::FillByteBufferCompressedStream(MemPool* pool, bool* eosr
   return Status::OK();
 }
 
+Status HdfsTextScanner::FillByteBufferParallel(MemPool* pool, bool* eosr) {
+  DCHECK(parallel_decompression_);
+  // Attach the memory from previous decompression rounds to 'pool'.
+  if (pool != nullptr) {
+    pool->AcquireData(data_buffer_pool_.get(), false);
+  } else {
+    data_buffer_pool_->FreeAll();
+  }
+
+  do {
+    uint8_t* compressed_buffer = nullptr;
+    int64_t compressed_buffer_size = 0;
+    RETURN_IF_ERROR(stream_->GetBuffer(true, &compressed_buffer,
+        &compressed_buffer_size));
+    vector<ParallelDecompressor::Frame> frames;
+    bool supported = ParallelDecompressor::FindFrames(decompression_type_,
+        compressed_buffer, compressed_buffer_size, PARALLEL_DECOMPRESSION_MAX_FRAMES,
+        PARALLEL_DECOMPRESSION_MAX_LEN, &frames);
+    if (supported && frames.empty() && !stream_->eosr()) {
+      // The first frame continues in the next buffer.
+      Status status;
+      if (!stream_->GetBytes(PARALLEL_DECOMPRESSION_FIXED_READ_SIZE, &compressed_buffer,
+          &compressed_buffer_size, &status, true)) {
+        DCHECK(!status.ok());
+        return status;
+      }
+      supported = ParallelDecompressor::FindFrames(decompression_type_,
+          compressed_buffer, compressed_buffer_size, PARALLEL_DECOMPRESSION_MAX_FRAMES,
+          PARALLEL_DECOMPRESSION_MAX_LEN, &frames);
+    }
+    if (!supported || frames.empty()) {
+      // 'stream_' is at a frame boundary, so the streaming decompressor can continue
+      // from here. It also reports truncated and corrupt frames.
+      VLOG_FILE << "Falling back to streaming decompression of " << stream_->filename()
+                << " at offset " << stream_->file_offset();
+      parallel_decompression_ = false;
+      return FillByteBufferCompressedStream(pool, eosr);
+    }
+
+    int64_t decompressed_len = 0;
+    for (const ParallelDecompressor::Frame& frame : frames) {
+      decompressed_len += frame.decompressed_len;
+    }
+    uint8_t* decompressed_buffer = data_buffer_pool_->TryAllocate(decompressed_len);
+    if (UNLIKELY(decompressed_buffer == nullptr)) {
+      string details = Substitute("HdfsTextScanner::FillByteBufferParallel() failed to "
+          "allocate $0 bytes.", decompressed_len);
+      return scan_node_->mem_tracker()->MemLimitExceeded(state_, details,
+          decompressed_len);
+    }
+    {
+      SCOPED_TIMER(decompress_timer_);
+      Status status = ParallelDecompressor::DecompressFrames(decompression_type_,
+          compressed_buffer, frames, ExecEnv::GetInstance()->text_decompression_pool(),
+          decompressed_buffer);
+      if (!status.ok()) {
+        status.AddDetail(Substitute("file=$0, offset=$1", stream_->filename(),
+            stream_->file_offset()));
+        return status;
+      }
+    }
+    // Skip the bytes in stream_ that were decompressed.
+    const ParallelDecompressor::Frame& last_frame = frames.back();
+    Status status;
+    if (!stream_->SkipBytes(last_frame.offset + last_frame.compressed_len, &status)) {
+      DCHECK(!status.ok());
+      return status;
+    }
+    byte_buffer_ptr_ = reinterpret_cast<char*>(decompressed_buffer);
+    byte_buffer_read_size_ = decompressed_len;
+    *eosr = stream_->eosr();
+    // Frames without content, e.g. the empty BGZF end-of-file marker, do not fill the
+    // buffer.
+  } while (byte_buffer_read_size_ == 0 && !*eosr);
+
+  if (*eosr) context_->ReleaseCompletedResources(true);
+  return Status::OK();
+}
+
 Status HdfsTextScanner::FillByteBufferCompressedFile(bool* eosr) {
   // For other compressed text: attempt to read and decompress the entire file, point
   // to the decompressed buffer, and then continue normal processing.
@@ -796,6 +896,10 @@ Status HdfsTextScanner::Codegen(HdfsScanPlanNode* node, FragmentState* state,
   *write_aligned_tuples_fn = nullptr;
   DCHECK(state->ShouldCodegen());
   DCHECK(state->codegen() != nullptr);
+  if (state->query_options().text_batched_conversion) {
+    return Status::Expected(
+        "HdfsTextScanner::Codegen(): TEXT_BATCHED_CONVERSION is enabled.");
+  }
   llvm::Function* write_complete_tuple_fn;
   RETURN_IF_ERROR(CodegenWriteCompleteTuple(node, state, &write_complete_tuple_fn));
   DCHECK(write_complete_tuple_fn != nullptr);
@@ -894,9 +998,12 @@ int HdfsTextScanner::WriteFields(int num_fields, int num_tuples, MemPool* pool,
           delimited_text_parser_->escape_char() == '\0');
     }
 
-    int tuples_returned = WriteAlignedTuplesCodegenOrInterpret(pool, row, fields,
-        num_tuples, max_added_tuples, scan_node_->materialized_slots().size(),
-        num_tuples_processed, copy_strings);
+    int tuples_returned = state_->query_options().text_batched_conversion ?
+        WriteAlignedTuplesBatched(
+            pool, row, fields, num_tuples, max_added_tuples, copy_strings) :
+        WriteAlignedTuplesCodegenOrInterpret(pool, row, fields, num_tuples,
+            max_added_tuples, scan_node_->materialized_slots().size(),
+            num_tuples_processed, copy_strings);
 
     if (tuples_returned == -1) return 0;
     DCHECK_EQ(slot_idx_, 0);
@@ -923,6 +1030,57 @@ int HdfsTextScanner::WriteFields(int num_fields, int num_tuples, MemPool* pool,
   return num_tuples_materialized;
 }
 
+int HdfsTextScanner::WriteAlignedTuplesBatched(MemPool* pool, TupleRow* tuple_row,
+    FieldLocation* fields, int num_tuples, int max_added_tuples, bool copy_strings) {
+  DCHECK(tuple_ != nullptr);
+  const vector<SlotDescriptor*>& slots = scan_node_->materialized_slots();
+  const int num_slots = slots.size();
+  uint8_t* tuple_mem = reinterpret_cast<uint8_t*>(tuple_);
+  // Each row is converted into its own tuple. The row batch has room for all of them.
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_byte_size_);
+    InitTuple(template_tuple_, tuple);
+  }
+  conversion_errors_.assign(num_tuples * num_slots, false);
+  for (int i = 0; i < num_slots; ++i) {
+    text_converter_->WriteSlots(slots[i], fields + i, num_slots, num_tuples, tuple_mem,
+        tuple_byte_size_, pool, &conversion_errors_[i], num_slots);
+  }
+
+  int tuples_returned = 0;
+  for (int i = 0; i < num_tuples; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_byte_size_);
+    tuple_row->SetTuple(0, tuple);
+    if (EvalConjuncts(tuple_row)) {
+      // Move the tuple next to the previous surviving one. Its slot is free, because the
+      // tuple that was converted there has either been moved or filtered out.
+      Tuple* dst = reinterpret_cast<Tuple*>(
+          tuple_mem + tuples_returned * tuple_byte_size_);
+      if (dst != tuple) {
+        memcpy(dst, tuple, tuple_byte_size_);
+        tuple_row->SetTuple(0, dst);
+      }
+      if (copy_strings) {
+        if (UNLIKELY(!dst->CopyStrings("HdfsTextScanner::WriteAlignedTuplesBatched()",
+              state_, string_slot_offsets_.data(), string_slot_offsets_.size(), pool,
+              &parse_status_))) {
+          return -1;
+        }
+      }
+      ++tuples_returned;
+      tuple_row = next_row(tuple_row);
+    }
+
+    // Report parse errors
+    uint8_t* errors = &conversion_errors_[i * num_slots];
+    if (UNLIKELY(memchr(errors, true, num_slots) != nullptr)) {
+      if (!ReportTupleParseError(fields + i * num_slots, errors)) return -1;
+    }
+    if (tuples_returned == max_added_tuples) break;
+  }
+  return tuples_returned;
+}
+
 Status HdfsTextScanner::CopyBoundaryField(FieldLocation* data, MemPool* pool) {
   bool needs_escape = data->len < 0;
   int copy_len = needs_escape ? -data->len : data->len;
@@ -191,6 +191,14 @@ class HdfsTextScanner : public HdfsScanner {
   /// by returned batches to 'pool'. If 'pool' is nullptr the buffers are freed instead.
   Status FillByteBufferCompressedStream(MemPool* pool, bool* eosr) WARN_UNUSED_RESULT;
 
+  /// Fills the next byte buffer by decompressing the complete frames at the start of
+  /// stream_ in parallel on the text decompression pool of ExecEnv. Falls back to
+  /// FillByteBufferCompressedStream() for the rest of the scan range and clears
+  /// 'parallel_decompression_' if the data cannot be split into frames.
+  /// Attaches decompression buffers from previous calls that might still be referenced
+  /// by returned batches to 'pool'. If 'pool' is nullptr the buffers are freed instead.
+  Status FillByteBufferParallel(MemPool* pool, bool* eosr) WARN_UNUSED_RESULT;
+
   /// Used by FillByteBufferCompressedStream() to decompress data from 'stream_'.
   /// Returns COMPRESSED_FILE_DECOMPRESSOR_NO_PROGRESS if it needs more input.
   /// If bytes_to_read > 0, will read specified size.
@@ -223,6 +231,14 @@ class HdfsTextScanner : public HdfsScanner {
   /// Returns the number of rows added to the row batch.
   int WriteFields(int num_fields, int num_tuples, MemPool* pool, TupleRow* row);
 
+  /// Column-at-a-time version of WriteAlignedTuples() that is used if the
+  /// TEXT_BATCHED_CONVERSION query option is set. Converts each materialized column of
+  /// the 'num_tuples' complete tuples at 'fields' with TextConverter::WriteSlots(), then
+  /// evaluates the conjuncts row by row, compacts the surviving tuples and reports the
+  /// parse errors. Returns the number of rows added at 'tuple_row' or -1 on error.
+  int WriteAlignedTuplesBatched(MemPool* pool, TupleRow* tuple_row,
+      FieldLocation* fields, int num_tuples, int max_added_tuples, bool copy_strings);
+
   /// Utility function to parse 'num_fields' and materialize the resulting slots into
   /// 'partial_tuple_'.  The data of var-len fields is copied into 'boundary_pool_'.
   void WritePartialTuple(FieldLocation*, int num_fields);
@@ -263,10 +279,18 @@ class HdfsTextScanner : public HdfsScanner {
   /// processed in the current batch.  Used to report row errors.
   std::vector<char*> row_end_locations_;
 
+  /// Parse errors of WriteAlignedTuplesBatched(), one entry per field of
+  /// 'field_locations_'.
+  std::vector<uint8_t> conversion_errors_;
+
   /// Pointer into byte_buffer that is the start of the current batch being
   /// processed.
   char* batch_start_ptr_;
 
+  /// True if FillByteBuffer() decompresses the current scan range with
+  /// FillByteBufferParallel(). Set in InitNewRange().
+  bool parallel_decompression_ = false;
+
   /// Whether or not there was a parse error in the current row. Used for counting the
   /// number of errors per file.  Once the error log is full, error_in_row will still be
   /// set, in order to be able to record the errors per file, even if the details are not
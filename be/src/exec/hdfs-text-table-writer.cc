@@ -19,15 +19,21 @@
 #include "exec/exec-node.h"
 #include "exprs/scalar-expr.h"
 #include "exprs/scalar-expr-evaluator.h"
+#include "runtime/date-value.h"
+#include "runtime/decimal-value.inline.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "runtime/string-value.inline.h"
+#include "runtime/timestamp-value.h"
 #include "util/hdfs-util.h"
 #include "util/runtime-profile-counters.h"
 
+#include <cmath>
+#include <cstdio>
+#include <sstream>
 #include <hdfs.h>
 #include <stdlib.h>
 
@@ -35,6 +41,193 @@
 
 namespace impala {
 
+namespace {
+
+// Writes the digits of the non-negative 'value' backwards into the buffer that ends at
+// 'end' and returns the position of the first digit.
+template <typename T>
+inline char* FormatDigitsBackwards(T value, char* end) {
+  do {
+    *--end = '0' + static_cast<int>(value % 10);
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
+
+// Writes the 'width' last digits of the non-negative 'value' to 'out', padded with
+// leading zeros, and returns the position after them.
+inline char* FormatFixedWidth(int64_t value, int width, char* out) {
+  for (int i = width - 1; i >= 0; --i) {
+    out[i] = '0' + value % 10;
+    value /= 10;
+  }
+  return out + width;
+}
+
+inline void AppendInt(int64_t value, string* buffer) {
+  char buf[24];
+  char* end = buf + sizeof(buf);
+  // The absolute value is computed as unsigned, so that the minimum value works.
+  uint64_t abs_value = value < 0 ? -static_cast<uint64_t>(value) : value;
+  char* begin = FormatDigitsBackwards(abs_value, end);
+  if (value < 0) *--begin = '-';
+  buffer->append(begin, end - begin);
+}
+
+// Same format as DecimalValue::ToString().
+template <typename T>
+void AppendDecimal(const DecimalValue<T>& value, int scale, string* buffer) {
+  // Room for 38 digits, the decimal point, a leading zero and the sign.
+  char buf[48];
+  char* end = buf + sizeof(buf);
+  char* begin = end;
+  T remaining = value.value() < 0 ? -value.value() : value.value();
+  for (int i = 0; i < scale; ++i) {
+    *--begin = '0' + static_cast<int>(remaining % 10);
+    remaining /= 10;
+  }
+  if (scale > 0) *--begin = '.';
+  begin = FormatDigitsBackwards(remaining, begin);
+  if (value.value() < 0) *--begin = '-';
+  buffer->append(begin, end - begin);
+}
+
+// Same format as printing to a stringstream with precision RawValue::ASCII_PRECISION,
+// or with 'scale' digits after the decimal point if 'scale' is not -1.
+template <typename T>
+void AppendFloatingPoint(T value, int scale, string* buffer) {
+  if (UNLIKELY(!std::isfinite(value))) {
+    // 'Infinity' and 'NaN' are Java's text representations, see RawValue::PrintValue().
+    if (std::isinf(value)) {
+      buffer->append(value < 0 ? "-Infinity" : "Infinity");
+    } else {
+      buffer->append("NaN");
+    }
+    return;
+  }
+  const double d = value;
+  char buf[64];
+  int len = scale > -1 ? snprintf(buf, sizeof(buf), "%.*f", scale, d) :
+      snprintf(buf, sizeof(buf), "%.*g", RawValue::ASCII_PRECISION, d);
+  if (LIKELY(len < static_cast<int>(sizeof(buf)))) {
+    buffer->append(buf, len);
+    return;
+  }
+  // Very large values with a scale don't fit into 'buf'.
+  const int64_t old_size = buffer->size();
+  buffer->resize(old_size + len + 1);
+  snprintf(&(*buffer)[old_size], len + 1, "%.*f", scale, d);
+  buffer->resize(old_size + len);
+}
+
+// Same format as TimestampValue::ToString(), e.g. "2020-01-31 12:34:56.123".
+void AppendTimestamp(const TimestampValue& value, string* buffer) {
+  const boost::gregorian::date& date = value.date();
+  const boost::posix_time::time_duration& time = value.time();
+  if (UNLIKELY(!value.HasDateAndTime() || time.is_negative() || time.hours() >= 24 ||
+      date.year() < 1000)) {
+    buffer->append(value.ToString());
+    return;
+  }
+  const boost::gregorian::date::ymd_type ymd = date.year_month_day();
+  char buf[32];
+  char* out = FormatFixedWidth(ymd.year, 4, buf);
+  *out++ = '-';
+  out = FormatFixedWidth(ymd.month, 2, out);
+  *out++ = '-';
+  out = FormatFixedWidth(ymd.day, 2, out);
+  *out++ = ' ';
+  out = FormatFixedWidth(time.hours(), 2, out);
+  *out++ = ':';
+  out = FormatFixedWidth(time.minutes(), 2, out);
+  *out++ = ':';
+  out = FormatFixedWidth(time.seconds(), 2, out);
+  // Like boost, only prints the fractional seconds if they are not 0, with all digits.
+  const int64_t frac = time.fractional_seconds();
+  if (frac != 0) {
+    *out++ = '.';
+    out = FormatFixedWidth(
+        frac, boost::posix_time::time_duration::num_fractional_digits(), out);
+  }
+  buffer->append(buf, out - buf);
+}
+
+// Same format as DateValue::ToString(), e.g. "2020-01-31".
+void AppendDate(const DateValue& value, string* buffer) {
+  int year, month, day;
+  if (UNLIKELY(!value.ToYearMonthDay(&year, &month, &day))) return;
+  if (UNLIKELY(year < 0 || year > 9999)) {
+    buffer->append(value.ToString());
+    return;
+  }
+  char buf[10];
+  char* out = FormatFixedWidth(year, 4, buf);
+  *out++ = '-';
+  out = FormatFixedWidth(month, 2, out);
+  *out++ = '-';
+  out = FormatFixedWidth(day, 2, out);
+  buffer->append(buf, out - buf);
+}
+
+}
+
+void HdfsTextTableWriter::AppendValue(const void* value, const ColumnType& type,
+    int scale, string* buffer) {
+  DCHECK(value != nullptr);
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+      buffer->append(*reinterpret_cast<const bool*>(value) ? "true" : "false");
+      break;
+    case TYPE_TINYINT:
+      AppendInt(*reinterpret_cast<const int8_t*>(value), buffer);
+      break;
+    case TYPE_SMALLINT:
+      AppendInt(*reinterpret_cast<const int16_t*>(value), buffer);
+      break;
+    case TYPE_INT:
+      AppendInt(*reinterpret_cast<const int32_t*>(value), buffer);
+      break;
+    case TYPE_BIGINT:
+      AppendInt(*reinterpret_cast<const int64_t*>(value), buffer);
+      break;
+    case TYPE_FLOAT:
+      AppendFloatingPoint(*reinterpret_cast<const float*>(value), scale, buffer);
+      break;
+    case TYPE_DOUBLE:
+      AppendFloatingPoint(*reinterpret_cast<const double*>(value), scale, buffer);
+      break;
+    case TYPE_TIMESTAMP:
+      AppendTimestamp(*reinterpret_cast<const TimestampValue*>(value), buffer);
+      break;
+    case TYPE_DATE:
+      AppendDate(*reinterpret_cast<const DateValue*>(value), buffer);
+      break;
+    case TYPE_DECIMAL:
+      switch (type.GetByteSize()) {
+        case 4:
+          AppendDecimal(
+              *reinterpret_cast<const Decimal4Value*>(value), type.scale, buffer);
+          break;
+        case 8:
+          AppendDecimal(
+              *reinterpret_cast<const Decimal8Value*>(value), type.scale, buffer);
+          break;
+        case 16:
+          AppendDecimal(
+              *reinterpret_cast<const Decimal16Value*>(value), type.scale, buffer);
+          break;
+        default: DCHECK(false) << type;
+      }
+      break;
+    default: {
+      stringstream out;
+      out.precision(RawValue::ASCII_PRECISION);
+      RawValue::PrintValue(value, type, scale, &out);
+      buffer->append(out.str());
+    }
+  }
+}
+
 HdfsTextTableWriter::HdfsTextTableWriter(HdfsTableSink* parent,
     RuntimeState* state, OutputPartition* output,
     const HdfsPartitionDescriptor* partition,
@@ -44,15 +237,11 @@ HdfsTextTableWriter::HdfsTextTableWriter(HdfsTableSink* parent,
   field_delim_ = partition->field_delim();
   escape_char_ = partition->escape_char();
   flush_size_ = HDFS_FLUSH_WRITE_SIZE;
-
-  // The default stringstream output precision is not very high, making it impossible
-  // to properly output doubles (they get rounded to ints).  Set a more reasonable
-  // precision.
-  rowbatch_stringstream_.precision(RawValue::ASCII_PRECISION);
 }
 
 Status HdfsTextTableWriter::Init() {
   parent_->mem_tracker()->Consume(flush_size_);
+  buffer_.reserve(flush_size_);
   return Status::OK();
 }
 
@@ -101,25 +290,25 @@ Status HdfsTextTableWriter::AppendRows(
           } else if (type.IsVarLenStringType()) {
             PrintEscaped(reinterpret_cast<const StringValue*>(value));
           } else {
-            output_expr_evals_[j]->PrintValue(value, &rowbatch_stringstream_);
+            AppendValue(value, type, output_expr_evals_[j]->output_scale(), &buffer_);
           }
         } else {
           // NULLs in hive are encoded based on the 'serialization.null.format' property.
-          rowbatch_stringstream_ << table_desc_->null_column_value();
+          buffer_.append(table_desc_->null_column_value());
         }
         // Append field delimiter.
         if (j + 1 < num_non_partition_cols) {
-          rowbatch_stringstream_ << field_delim_;
+          buffer_.push_back(field_delim_);
         }
       }
       // Append tuple delimiter.
-      rowbatch_stringstream_ << tuple_delim_;
+      buffer_.push_back(tuple_delim_);
       ++output_->current_file_rows;
     }
   }
 
   *new_file = false;
-  if (rowbatch_stringstream_.tellp() >= flush_size_) RETURN_IF_ERROR(Flush());
+  if (buffer_.size() >= flush_size_) RETURN_IF_ERROR(Flush());
 
   RETURN_IF_ERROR(state_->CheckQueryState());
   return Status::OK();
@@ -133,36 +322,43 @@ Status HdfsTextTableWriter::InitNewFile() {
   // Write empty header lines for tables with 'skip.header.line.count' property set to
   // non-zero.
   for (int i = 0; i < parent_->skip_header_line_count(); ++i) {
-    rowbatch_stringstream_ << '\n';
+    buffer_.push_back('\n');
   }
   return Status::OK();
 }
 
 Status HdfsTextTableWriter::Flush() {
-  string rowbatch_string = rowbatch_stringstream_.str();
-  rowbatch_stringstream_.str(string());
-  const uint8_t* data =
-      reinterpret_cast<const uint8_t*>(rowbatch_string.data());
-  int64_t len = rowbatch_string.size();
-
   {
     SCOPED_TIMER(parent_->hdfs_write_timer());
-    RETURN_IF_ERROR(Write(data, len));
+    RETURN_IF_ERROR(Write(reinterpret_cast<const uint8_t*>(buffer_.data()),
+        buffer_.size()));
+  }
+  buffer_.clear();
+  // Release the memory of buffers that grew far beyond the flush size for rows with
+  // very large values.
+  if (buffer_.capacity() > 2 * flush_size_) {
+    buffer_.shrink_to_fit();
+    buffer_.reserve(flush_size_);
   }
-
   return Status::OK();
 }
 
 inline void HdfsTextTableWriter::PrintEscaped(const StringValue* str_val) {
-  for (int i = 0; i < str_val->len; ++i) {
-    if (escape_char_ == '\0') {
-      rowbatch_stringstream_ << str_val->ptr[i];
-    } else {
-      if (UNLIKELY(str_val->ptr[i] == field_delim_ || str_val->ptr[i] == escape_char_)) {
-        rowbatch_stringstream_ << escape_char_;
-      }
-      rowbatch_stringstream_ << str_val->ptr[i];
+  if (escape_char_ == '\0') {
+    buffer_.append(str_val->ptr, str_val->len);
+    return;
+  }
+  // Appends the runs of characters that don't need to be escaped at once.
+  const char* run_start = str_val->ptr;
+  const char* end = str_val->ptr + str_val->len;
+  for (const char* c = str_val->ptr; c < end; ++c) {
+    if (UNLIKELY(*c == field_delim_ || *c == escape_char_)) {
+      buffer_.append(run_start, c - run_start);
+      buffer_.push_back(escape_char_);
+      // The escaped character starts the next run.
+      run_start = c;
     }
   }
+  buffer_.append(run_start, end - run_start);
 }
 }
@@ -20,7 +20,7 @@
 #define IMPALA_EXEC_HDFS_TEXT_TABLE_WRITER_H
 
 #include <hdfs.h>
-#include <sstream>
+#include <string>
 #include <boost/scoped_ptr.hpp>
 
 #include "runtime/descriptors.h"
@@ -30,6 +30,7 @@
 namespace impala {
 
 class Codec;
+class ColumnType;
 class Expr;
 class MemPool;
 struct OutputPartition;
@@ -62,14 +63,20 @@ class HdfsTextTableWriter : public HdfsTableWriter {
   Status AppendRows(RowBatch* current_row, const std::vector<int32_t>& row_group_indices,
       bool* new_file);
 
+  /// Appends the text representation of the non-NULL, non-string 'value' of type 'type'
+  /// to 'buffer', which is the same as that of RawValue::PrintValue() with 'scale'.
+  /// Numbers, decimals, booleans, dates and timestamps are formatted directly into the
+  /// buffer, other types fall back to RawValue::PrintValue().
+  static void AppendValue(const void* value, const ColumnType& type, int scale,
+      std::string* buffer);
+
  private:
   /// Escapes occurrences of field_delim_ and escape_char_ with escape_char_ and
-  /// writes the escaped result into rowbatch_stringstream_. Neither Hive nor Impala
-  /// support escaping tuple_delim_.
+  /// appends the escaped result to 'buffer_'. Neither Hive nor Impala support escaping
+  /// tuple_delim_.
   inline void PrintEscaped(const StringValue* str_val);
 
-  /// Writes the buffered data in rowbatch_stringstream_ to HDFS, applying
-  /// compression if necessary.
+  /// Writes the data in 'buffer_' to HDFS.
   Status Flush();
 
   /// Character delimiting tuples.
@@ -81,12 +88,12 @@ class HdfsTextTableWriter : public HdfsTableWriter {
   /// Escape character.
   char escape_char_;
 
-  /// Size in rowbatch_stringstream_ before we call flush.
+  /// Size of 'buffer_' before we call flush.
   int64_t flush_size_;
 
-  /// Stringstream to buffer output.  The stream is cleared between HDFS
-  /// Write calls to allow for the internal buffers to be reused.
-  std::stringstream rowbatch_stringstream_;
+  /// Buffers the output. The buffer is cleared between HDFS Write calls, so that its
+  /// memory is reused.
+  std::string buffer_;
 };
 
 }
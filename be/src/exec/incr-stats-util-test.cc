@@ -71,6 +71,28 @@ TEST(IncrStatsUtilTest, TestEncode) {
   ASSERT_EQ(DecodeNdv(encoded, is_encoded), test);
 }
 
+TEST(IncrStatsUtilTest, TestMergeEncodedNdv) {
+  // Sparse registers, like those of partitions with few distinct values.
+  string sparse(DEFAULT_HLL_LEN, 0);
+  for (int i = 0; i < DEFAULT_HLL_LEN; i += 97) sparse[i] = i % 7 + 1;
+  string dense(DEFAULT_HLL_LEN, 0);
+  for (int i = 0; i < DEFAULT_HLL_LEN; ++i) dense[i] = i % 5;
+
+  bool is_encoded;
+  const string& encoded = EncodeNdv(sparse, &is_encoded);
+  ASSERT_TRUE(is_encoded);
+  PerColumnStats decoded_stats;
+  decoded_stats.MergeNdv(dense, false);
+  decoded_stats.MergeNdv(sparse, false);
+  PerColumnStats encoded_stats;
+  encoded_stats.MergeNdv(dense, false);
+  encoded_stats.MergeNdv(encoded, true);
+  ASSERT_EQ(decoded_stats.intermediate_ndv, encoded_stats.intermediate_ndv);
+  for (int i = 0; i < DEFAULT_HLL_LEN; ++i) {
+    ASSERT_EQ(::max(sparse[i], dense[i]), encoded_stats.intermediate_ndv[i]);
+  }
+}
+
 void checkLowAndHighValueInt(
     const TColumnStats& stats, int expected_low, int expected_high) {
   ASSERT_TRUE(stats.low_value.__isset.int_val);
@@ -18,6 +18,7 @@
 #include "incr-stats-util.h"
 
 #include <boost/unordered_set.hpp>
+#include <gflags/gflags.h>
 #include <gutil/strings/substitute.h>
 #include <cmath>
 #include <sstream>
@@ -30,9 +31,15 @@
 #include "exprs/aggregate-functions.h"
 #include "service/hs2-util.h"
 #include "udf/udf.h"
+#include "util/hll-simd.h"
+#include "util/thread.h"
 
 #include "common/names.h"
 
+DEFINE_int32(incremental_stats_merge_threads, 8, "The maximum number of threads that "
+    "merge the existing incremental statistics of the partitions of a table in "
+    "COMPUTE INCREMENTAL STATS. The columns are split among the threads.");
+
 using namespace apache::hive::service::cli::thrift;
 using namespace impala;
 using namespace impala_udf;
@@ -153,17 +160,14 @@ void PerColumnStats::UpdateHighValue(const impala::TColumnValue& value) {
 void PerColumnStats::Update(const string& ndv, int64_t num_new_rows, double new_avg_width,
     int32_t max_new_width, int64_t num_new_nulls, int64_t num_new_trues,
     int64_t num_new_falses, const impala::TColumnValue& low_value_new,
-    const impala::TColumnValue& high_value_new) {
-  DCHECK_EQ(intermediate_ndv.size(), ndv.size()) << "Incompatible intermediate NDVs";
+    const impala::TColumnValue& high_value_new, bool is_ndv_encoded) {
   DCHECK_GE(num_new_rows, 0);
   DCHECK_GE(max_new_width, 0);
   DCHECK_GE(new_avg_width, 0);
   DCHECK_GE(num_new_nulls, -1); // '-1' needed to be backward compatible
   DCHECK_GE(num_trues, 0);
   DCHECK_GE(num_falses, 0);
-  for (int j = 0; j < ndv.size(); ++j) {
-    intermediate_ndv[j] = ::max(intermediate_ndv[j], ndv[j]);
-  }
+  MergeNdv(ndv, is_ndv_encoded);
   // Earlier the 'num_nulls' were initialized and persisted with '-1', this condition
   // ensures metadata backward compatibility between releases
   if (num_nulls >= 0) {
@@ -184,6 +188,36 @@ void PerColumnStats::Update(const string& ndv, int64_t num_new_rows, double new_
   UpdateHighValue(high_value_new);
 }
 
+void PerColumnStats::MergeNdv(const string& ndv, bool is_encoded) {
+  // The registers are below 64, so comparing them as unsigned bytes is the same as
+  // comparing them as chars.
+  uint8_t* dst = reinterpret_cast<uint8_t*>(&intermediate_ndv[0]);
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(ndv.data());
+  const int len = intermediate_ndv.size();
+  if (!is_encoded) {
+    DCHECK_EQ(len, ndv.size()) << "Incompatible intermediate NDVs";
+    if (HllSimd::IsSupported() && len % HllSimd::BATCH_SIZE == 0) {
+      HllSimd::MergeAVX2(dst, src, len);
+      return;
+    }
+    for (int i = 0; i < len; ++i) dst[i] = ::max(dst[i], src[i]);
+    return;
+  }
+  // See EncodeNdv() for the format. Runs of zero registers, which are the most common
+  // ones, don't change 'intermediate_ndv'.
+  DCHECK_EQ(ndv.size() % 2, 0);
+  int idx = 0;
+  for (int i = 0; i + 1 < ndv.size(); i += 2) {
+    const int run_end = ::min(len, idx + src[i] + 1);
+    const uint8_t value = src[i + 1];
+    if (value != 0) {
+      for (int j = idx; j < run_end; ++j) dst[j] = ::max(dst[j], value);
+    }
+    idx = run_end;
+  }
+  DCHECK_EQ(idx, len);
+}
+
 void PerColumnStats::Finalize() {
   ndv_estimate = AggregateFunctions::HllFinalEstimate(
       reinterpret_cast<const uint8_t*>(intermediate_ndv.data()));
@@ -216,6 +250,79 @@ string PerColumnStats::DebugString() const {
 
 namespace impala {
 
+/// Merges the existing intermediate statistics of the columns [begin_col, end_col) of
+/// all partitions in 'existing_part_stats' into 'stats'.
+static void MergeExistingColumnStats(const vector<const string*>& col_names,
+    const vector<TPartitionStats>& existing_part_stats, int begin_col, int end_col,
+    vector<PerColumnStats>* stats) {
+  for (const TPartitionStats& existing_stats: existing_part_stats) {
+    for (int i = begin_col; i < end_col; ++i) {
+      const string& col_name = *col_names[i];
+      map<string, TIntermediateColumnStats>::const_iterator it =
+          existing_stats.intermediate_col_stats.find(col_name);
+      if (it == existing_stats.intermediate_col_stats.end()) {
+        VLOG(2) << "Could not find column in existing column stat state: " << col_name;
+        continue;
+      }
+
+      const TIntermediateColumnStats& int_stats = it->second;
+      VLOG(3) << "Updated intermediate value for column=[" << col_name << "], "
+              << "statistics={" << int_stats.intermediate_ndv << ","
+              << int_stats.num_rows << "，" << int_stats.avg_width << ","
+              << int_stats.max_width << ","<< int_stats.num_nulls << ","
+              << int_stats.num_trues << "," << int_stats.num_falses << ","
+              << int_stats.low_value << "," << int_stats.high_value << "}";
+      (*stats)[i].Update(int_stats.intermediate_ndv, int_stats.num_rows,
+          int_stats.avg_width, int_stats.max_width, int_stats.num_nulls,
+          int_stats.num_trues, int_stats.num_falses, int_stats.low_value,
+          int_stats.high_value, int_stats.is_ndv_encoded);
+    }
+  }
+}
+
+/// Merges the existing intermediate statistics of all partitions into 'stats'. The
+/// columns are split among up to --incremental_stats_merge_threads threads, which merge
+/// the statistics of their columns of all partitions. Every column is merged by one
+/// thread, so the threads don't need to synchronize and no partial results are kept.
+static void MergeExistingStats(const vector<const string*>& col_names,
+    const vector<TPartitionStats>& existing_part_stats, vector<PerColumnStats>* stats) {
+  // Starting threads only pays off if there are many statistics to merge, so those of
+  // small tables are merged by the calling thread.
+  static const int64_t MIN_COLUMN_STATS_PER_THREAD = 64 * 1024;
+  const int num_cols = col_names.size();
+  const int64_t num_col_stats = num_cols * existing_part_stats.size();
+  const int num_threads = ::max<int64_t>(1, ::min<int64_t>(
+      {FLAGS_incremental_stats_merge_threads, num_cols,
+       num_col_stats / MIN_COLUMN_STATS_PER_THREAD}));
+  if (num_threads == 1) {
+    MergeExistingColumnStats(col_names, existing_part_stats, 0, num_cols, stats);
+    return;
+  }
+  auto merge_range = [&](int thread_idx) {
+    MergeExistingColumnStats(col_names, existing_part_stats,
+        num_cols * thread_idx / num_threads, num_cols * (thread_idx + 1) / num_threads,
+        stats);
+  };
+  vector<unique_ptr<Thread>> threads;
+  int thread_idx = 1;
+  for (; thread_idx < num_threads; ++thread_idx) {
+    unique_ptr<Thread> thread;
+    Status status = Thread::Create("catalog-op", "merge-incremental-stats",
+        [&merge_range, thread_idx]() { merge_range(thread_idx); }, &thread);
+    if (!status.ok()) {
+      LOG(WARNING) << "Could not start a thread to merge incremental stats: "
+                   << status.GetDetail();
+      break;
+    }
+    threads.push_back(move(thread));
+  }
+  // The columns of the threads that could not be started are merged by this thread.
+  MergeExistingColumnStats(col_names, existing_part_stats,
+      num_cols * thread_idx / num_threads, num_cols, stats);
+  merge_range(0);
+  for (unique_ptr<Thread>& thread : threads) thread->Join();
+}
+
 void FinalizePartitionedColumnStats(const TTableSchema& col_stats_schema,
     const vector<TPartitionStats>& existing_part_stats,
     const vector<vector<string>>& expected_partitions, const TRowSet& rowset,
@@ -326,31 +433,15 @@ void FinalizePartitionedColumnStats(const TTableSchema& col_stats_schema,
   // Now aggregate the existing statistics. The FE will ensure that the set of
   // partitions accessed by the query and this list are disjoint and cover the entire
   // set of partitions.
+  vector<const string*> col_names(num_cols);
+  for (int i = 0; i < num_cols; ++i) {
+    col_names[i] = &col_stats_schema.columns[i * COLUMNS_PER_STAT].columnName;
+  }
   for (const TPartitionStats& existing_stats: existing_part_stats) {
     DCHECK_LE(existing_stats.intermediate_col_stats.size(),
         col_stats_schema.columns.size());
-    for (int i = 0; i < num_cols; ++i) {
-      const string& col_name = col_stats_schema.columns[i * COLUMNS_PER_STAT].columnName;
-      map<string, TIntermediateColumnStats>::const_iterator it =
-          existing_stats.intermediate_col_stats.find(col_name);
-      if (it == existing_stats.intermediate_col_stats.end()) {
-        VLOG(2) << "Could not find column in existing column stat state: " << col_name;
-        continue;
-      }
-
-      const TIntermediateColumnStats& int_stats = it->second;
-      VLOG(3) << "Updated intermediate value for column=[" << col_name << "], "
-              << "statistics={" << int_stats.intermediate_ndv << ","
-              << int_stats.num_rows << "，" << int_stats.avg_width << ","
-              << int_stats.max_width << ","<< int_stats.num_nulls << ","
-              << int_stats.num_trues << "," << int_stats.num_falses << ","
-              << int_stats.low_value << "," << int_stats.high_value << "}";
-      stats[i].Update(DecodeNdv(int_stats.intermediate_ndv, int_stats.is_ndv_encoded),
-          int_stats.num_rows, int_stats.avg_width, int_stats.max_width,
-          int_stats.num_nulls, int_stats.num_trues, int_stats.num_falses,
-          int_stats.low_value, int_stats.high_value);
-    }
   }
+  MergeExistingStats(col_names, existing_part_stats, &stats);
 
   // Compute the final results now that all aggregations are done, and save those as
   // column stats for each column in turn.
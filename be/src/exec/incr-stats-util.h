@@ -76,11 +76,17 @@ struct PerColumnStats {
       num_falses(0),
       total_width(0) {}
 
-  /// Updates all aggregate statistics with a new set of measurements.
+  /// Updates all aggregate statistics with a new set of measurements. 'ndv' is the
+  /// intermediate NDV state, which is RLE-encoded if 'is_ndv_encoded' is true.
   void Update(const string& ndv, int64_t num_new_rows, double new_avg_width,
       int32_t max_new_width, int64_t num_new_nulls, int64_t num_new_trues,
       int64_t num_new_falses, const impala::TColumnValue& low_value,
-      const impala::TColumnValue& high_value);
+      const impala::TColumnValue& high_value, bool is_ndv_encoded = false);
+
+  /// Merges the HLL registers of the intermediate NDV state 'ndv' into
+  /// 'intermediate_ndv'. RLE-encoded states are merged run by run, without decoding
+  /// them first.
+  void MergeNdv(const string& ndv, bool is_encoded);
 
   /// Performs any stats computations that are not distributive, that is they may not be
   /// computed in part during Update(). After this method returns, ndv_estimate and
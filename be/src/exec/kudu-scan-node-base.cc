@@ -24,10 +24,12 @@
 #include <thrift/protocol/TDebugProtocol.h>
 #include <vector>
 
+#include "codegen/llvm-codegen.h"
 #include "exec/kudu-scanner.h"
 #include "exec/kudu-util.h"
 #include "exprs/expr.h"
 #include "runtime/exec-env.h"
+#include "runtime/fragment-state.h"
 #include "runtime/mem-pool.h"
 #include "runtime/query-state.h"
 #include "runtime/runtime-state.h"
@@ -52,10 +54,41 @@ const string KuduScanNodeBase::KUDU_REMOTE_TOKENS = "KuduRemoteScanTokens";
 ///   client, either waiting for data from Kudu or processing data.
 const string KuduScanNodeBase::KUDU_CLIENT_TIME = "KuduClientTime";
 
+void KuduScanPlanNode::Codegen(FragmentState* state) {
+  DCHECK(state->ShouldCodegen());
+  PlanNode::Codegen(state);
+  if (IsNodeCodegenDisabled()) return;
+  AddCodegenStatus(CodegenDecodeRowsIntoRowBatch(state));
+}
+
+Status KuduScanPlanNode::CodegenDecodeRowsIntoRowBatch(FragmentState* state) {
+  LlvmCodeGen* codegen = state->codegen();
+  DCHECK(codegen != nullptr);
+  llvm::Function* decode_rows_fn =
+      codegen->GetFunction(IRFunction::KUDU_SCANNER_DECODE_ROWS_INTO_ROW_BATCH, true);
+  DCHECK(decode_rows_fn != nullptr);
+
+  llvm::Function* eval_conjuncts_fn;
+  RETURN_IF_ERROR(
+      ExecNode::CodegenEvalConjuncts(codegen, conjuncts_, &eval_conjuncts_fn));
+
+  int replaced = codegen->ReplaceCallSites(decode_rows_fn, eval_conjuncts_fn,
+      "EvalConjuncts");
+  DCHECK_REPLACE_COUNT(replaced, 1);
+  decode_rows_fn = codegen->FinalizeFunction(decode_rows_fn);
+  if (decode_rows_fn == nullptr) {
+    return Status("Failed to finalize DecodeRowsIntoRowBatch().");
+  }
+  codegen->AddFunctionToJit(decode_rows_fn, &codegend_decode_rows_fn_);
+  return Status::OK();
+}
+
 KuduScanNodeBase::KuduScanNodeBase(
     ObjectPool* pool, const ScanPlanNode& pnode, const DescriptorTbl& descs)
   : ScanNode(pool, pnode, descs),
     tuple_id_(pnode.tnode_->kudu_scan_node.tuple_id),
+    codegend_decode_rows_fn_(
+        static_cast<const KuduScanPlanNode&>(pnode).codegend_decode_rows_fn_),
     count_star_slot_offset_(
             pnode.tnode_->kudu_scan_node.__isset.count_star_slot_offset ?
             pnode.tnode_->kudu_scan_node.count_star_slot_offset : -1) {
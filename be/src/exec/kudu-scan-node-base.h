@@ -20,12 +20,28 @@
 #include <gtest/gtest.h>
 #include <kudu/client/client.h>
 
+#include "codegen/codegen-fn-ptr.h"
 #include "exec/scan-node.h"
 #include "runtime/descriptors.h"
 
 namespace impala {
 
 class KuduScanner;
+class RowBatch;
+class Tuple;
+
+class KuduScanPlanNode : public ScanPlanNode {
+ public:
+  virtual void Codegen(FragmentState* state) override;
+
+  /// Codegened version of KuduScanner::DecodeRowsIntoRowBatch().
+  typedef Status (*DecodeRowsIntoRowBatchFn)(KuduScanner*, RowBatch*, Tuple**);
+  CodegenFnPtr<DecodeRowsIntoRowBatchFn> codegend_decode_rows_fn_;
+
+ private:
+  /// Codegens KuduScanner::DecodeRowsIntoRowBatch() with the conjuncts of this node.
+  Status CodegenDecodeRowsIntoRowBatch(FragmentState* state);
+};
 
 /// Base class for the two Kudu scan node implementations. Contains the code that is
 /// independent of whether the rows are materialized by scanner threads (KuduScanNode)
@@ -76,6 +92,10 @@ class KuduScanNodeBase : public ScanNode {
   /// Descriptor of the Kudu table.
   const KuduTableDescriptor* table_desc_ = nullptr;
 
+  /// Codegened version of KuduScanner::DecodeRowsIntoRowBatch(), owned by the plan node.
+  const CodegenFnPtr<KuduScanPlanNode::DecodeRowsIntoRowBatchFn>&
+      codegend_decode_rows_fn_;
+
   /// Pointer to the KuduClient, which is stored on the QueryState and shared between
   /// scanners and fragment instances.
   kudu::client::KuduClient* client_ = nullptr;
@@ -33,6 +33,7 @@
 #include "runtime/scanner-mem-limiter.h"
 #include "runtime/thread-resource-mgr.h"
 #include "runtime/tuple-row.h"
+#include "util/cpu-sampler.h"
 #include "util/debug-util.h"
 #include "util/runtime-profile-counters.h"
 
@@ -226,6 +227,9 @@ void KuduScanNode::RunScannerThread(
   DCHECK(initial_token != nullptr);
   SCOPED_THREAD_COUNTER_MEASUREMENT(thread_state_.thread_counters());
   SCOPED_THREAD_COUNTER_MEASUREMENT(runtime_state_->total_thread_statistics());
+  ScopedCpuSampler cpu_sampler(runtime_state_->cpu_samples());
+  ScopedLockContentionCounters lock_contention(
+      runtime_state_->query_state()->lock_contention_counters());
   KuduScanner scanner(this, runtime_state_);
 
   const string* scan_token = initial_token;
@@ -17,6 +17,7 @@
 
 #include "exec/kudu-scanner.h"
 
+#include <cstring>
 #include <string>
 #include <vector>
 #include <kudu/client/row_result.h>
@@ -32,6 +33,7 @@
 #include "gutil/strings/substitute.h"
 #include "kudu/util/block_bloom_filter.h"
 #include "kudu/util/slice.h"
+#include "runtime/fragment-instance-state.h"
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.h"
@@ -43,6 +45,7 @@
 #include "runtime/tuple-row.h"
 #include "util/bloom-filter.h"
 #include "util/debug-util.h"
+#include "util/in-list-filter.h"
 #include "util/jni-util.h"
 #include "util/min-max-filter.h"
 #include "util/periodic-counter-updater.h"
@@ -51,6 +54,7 @@
 #include "common/names.h"
 
 using kudu::client::KuduClient;
+using kudu::client::KuduColumnarScanBatch;
 using kudu::client::KuduPredicate;
 using kudu::client::KuduScanBatch;
 using kudu::client::KuduSchema;
@@ -68,6 +72,35 @@ DECLARE_int32(kudu_operation_timeout_ms);
 
 namespace impala {
 
+namespace {
+
+/// Copies 'num_rows' values of SIZE bytes from the column buffer 'data' to the slot
+/// at 'slot_offset' of the tuples at 'tuples'.
+template <int SIZE>
+void CopyFixedLengthColumn(const uint8_t* data, int num_rows, int slot_offset,
+    int tuple_byte_size, uint8_t* tuples) {
+  uint8_t* dst = tuples + slot_offset;
+  for (int i = 0; i < num_rows; ++i) {
+    memcpy(dst, data + i * SIZE, SIZE);
+    dst += tuple_byte_size;
+  }
+}
+
+/// Sets the null indicator of the 'num_rows' tuples at 'tuples' for the rows from
+/// 'start_row' that are null according to the Kudu 'non_null_bitmap'. The null
+/// indicators must be cleared before.
+void SetNullIndicators(const uint8_t* non_null_bitmap, int start_row, int num_rows,
+    const NullIndicatorOffset& null_offset, int tuple_byte_size, uint8_t* tuples) {
+  uint8_t* dst = tuples + null_offset.byte_offset;
+  for (int i = 0; i < num_rows; ++i) {
+    const int row = start_row + i;
+    const bool is_null = (non_null_bitmap[row >> 3] & (1 << (row & 7))) == 0;
+    *dst |= is_null ? null_offset.bit_mask : 0;
+    dst += tuple_byte_size;
+  }
+}
+
+}
 
 KuduScanner::KuduScanner(KuduScanNodeBase* scan_node, RuntimeState* state)
   : scan_node_(scan_node),
@@ -87,6 +120,16 @@ Status KuduScanner::Open() {
       varchar_slots_.push_back(slot);
     }
   }
+  if (state_->query_options().kudu_scan_prefetch) {
+    string name = Substitute("kudu-fetch-thread (finst:$0, plan-node-id:$1)",
+        PrintId(state_->fragment_instance_id()), scan_node_->id());
+    Status status = Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME, name,
+        &KuduScanner::FetchThread, this, &fetch_thread_);
+    // Fetching on the scanner's own thread still works, only slower.
+    if (!status.ok()) {
+      LOG(WARNING) << "Could not start the Kudu fetch thread: " << status.GetDetail();
+    }
+  }
   return ScalarExprEvaluator::Clone(&obj_pool_, state_, expr_perm_pool_.get(),
       expr_results_pool_.get(), scan_node_->conjunct_evals(), &conjunct_evals_);
 }
@@ -98,6 +141,13 @@ void KuduScanner::KeepKuduScannerAlive() {
   if (now < last_alive_time_micros_ + keepalive_us) {
     return;
   }
+  // The fetch thread must not use 'scanner_' at the same time. A running fetch keeps the
+  // scanner alive anyway.
+  unique_lock<mutex> l(fetch_lock_, std::defer_lock);
+  if (fetch_in_flight_) {
+    l.lock();
+    if (!fetch_done_) return;
+  }
   // If we fail to send a keepalive, it isn't a big deal. The Kudu
   // client code doesn't handle cross-replica failover or retries when
   // the server is busy, so it's better to just ignore errors here. In
@@ -113,11 +163,11 @@ void KuduScanner::KeepKuduScannerAlive() {
 
 Status KuduScanner::GetNextWithCountStarOptimization(RowBatch* row_batch, bool* eos) {
   int64_t counter = 0;
-  while (scanner_->HasMoreRows()) {
+  while (HasMoreBatches()) {
     RETURN_IF_CANCELLED(state_);
     RETURN_IF_ERROR(GetNextScannerBatch());
 
-    cur_kudu_batch_num_read_ = static_cast<int64_t>(cur_kudu_batch_.NumRows());
+    cur_kudu_batch_num_read_ = static_cast<int64_t>(cur_kudu_batch_->NumRows());
     counter += cur_kudu_batch_num_read_;
   }
   *eos = true;
@@ -159,12 +209,23 @@ Status KuduScanner::GetNext(RowBatch* row_batch, bool* eos) {
   while (!*eos) {
     RETURN_IF_CANCELLED(state_);
 
-    if (cur_kudu_batch_num_read_ < cur_kudu_batch_.NumRows()) {
-      RETURN_IF_ERROR(DecodeRowsIntoRowBatch(row_batch, &tuple));
+    if (cur_kudu_batch_num_read_ < CurBatchNumRows()) {
+      if (columnar_scan_) {
+        RETURN_IF_ERROR(DecodeColumnarBatchIntoRowBatch(row_batch, &tuple));
+      } else {
+        KuduScanPlanNode::DecodeRowsIntoRowBatchFn decode_rows_fn =
+            scan_node_->codegend_decode_rows_fn_.load();
+        if (decode_rows_fn != nullptr) {
+          RETURN_IF_ERROR(decode_rows_fn(this, row_batch, &tuple));
+        } else {
+          RETURN_IF_ERROR(DecodeRowsIntoRowBatch(row_batch, &tuple));
+        }
+      }
       if (row_batch->AtCapacity()) break;
     }
 
-    if (scanner_->HasMoreRows() && !scan_node_->ReachedLimitShared()) {
+    if (HasMoreBatches() && !scan_node_->ReachedLimitShared()
+        && NumRowsLeftInLimit(row_batch) != 0) {
       RETURN_IF_ERROR(GetNextScannerBatch());
       continue;
     }
@@ -177,6 +238,15 @@ Status KuduScanner::GetNext(RowBatch* row_batch, bool* eos) {
 
 void KuduScanner::Close() {
   if (scanner_) CloseCurrentClientScanner();
+  if (fetch_thread_ != nullptr) {
+    {
+      lock_guard<mutex> l(fetch_lock_);
+      fetch_thread_shutdown_ = true;
+    }
+    fetch_requested_cv_.NotifyOne();
+    fetch_thread_->Join();
+    fetch_thread_.reset();
+  }
   ScalarExprEvaluator::Close(conjunct_evals_, state_);
   expr_perm_pool_->FreeAll();
   expr_results_pool_->FreeAll();
@@ -215,7 +285,32 @@ Status KuduScanner::OpenNextScanToken(const string& scan_token, bool* eos) {
            << " node with id=" << scan_node_->id()
            << " Kudu table=" << scan_node_->table_desc()->table_name();
 
-  if (!timestamp_slots_.empty()) {
+  // The count(*) optimization and empty projections only need the number of rows.
+  columnar_scan_ = state_->query_options().kudu_columnar_scan
+      && !scan_node_->optimize_count_star()
+      && !scan_node_->tuple_desc()->slots().empty();
+  if (columnar_scan_) {
+    KUDU_RETURN_IF_ERROR(
+        scanner_->SetRowFormatFlags(kudu::client::KuduScanner::COLUMNAR_LAYOUT),
+        BuildErrorString("Could not set columnar row format"));
+    // Columns of the columnar batches are accessed by their index in the projection.
+    KuduSchema projection = scanner_->GetProjectionSchema();
+    const KuduSchema& table_schema = scanner_->GetKuduTable()->schema();
+    projection_col_idxs_.clear();
+    for (const SlotDescriptor* slot : scan_node_->tuple_desc()->slots()) {
+      const string col_name = table_schema.Column(slot->col_pos()).name();
+      int col_idx = 0;
+      while (col_idx < projection.num_columns()
+          && projection.Column(col_idx).name() != col_name) {
+        ++col_idx;
+      }
+      if (col_idx == projection.num_columns()) {
+        return Status(BuildErrorString(
+            Substitute("Column '$0' is not in the projection", col_name).c_str()));
+      }
+      projection_col_idxs_.push_back(col_idx);
+    }
+  } else if (!timestamp_slots_.empty()) {
     uint64_t row_format_flags =
         kudu::client::KuduScanner::PAD_UNIXTIME_MICROS_TO_16_BYTES;
     scanner_->SetRowFormatFlags(row_format_flags);
@@ -252,6 +347,35 @@ Status KuduScanner::OpenNextScanToken(const string& scan_token, bool* eos) {
             scanner_->AddConjunctPredicate(
                 scanner_->GetKuduTable()->NewInBloomFilterPredicate(col_name, bbf_vec)),
             BuildErrorString("Failed to add bloom filter predicate"));
+      } else if (ctx.filter->is_in_list_filter()) {
+        InListFilter* filter = ctx.filter->get_in_list_filter();
+        DCHECK(filter != nullptr);
+        // The planner only assigns in-list filters to Kudu for columns without a cast
+        // and for '=' join predicates, so the values can be pushed down as they are and
+        // a NULL in the filter doesn't match any row.
+        DCHECK_EQ(ColumnType::FromThrift(target_desc.kudu_col_type).type, filter->type());
+        vector<KuduValue*> values;
+        if (filter->type() == TYPE_STRING || filter->type() == TYPE_VARCHAR) {
+          for (const StringValue& sv : filter->str_values()) {
+            values.push_back(KuduValue::CopyString(
+                kudu::Slice(reinterpret_cast<uint8_t*>(sv.ptr), sv.len)));
+          }
+        } else {
+          // Integers and dates, which are days since the epoch in both Impala and Kudu.
+          for (int64_t value : filter->values()) {
+            values.push_back(KuduValue::FromInt(value));
+          }
+        }
+        if (values.empty()) {
+          // Only NULL is in the filter, which doesn't match any row.
+          CloseCurrentClientScanner();
+          *eos = true;
+          return Status::OK();
+        }
+        // NewInListPredicate() takes ownership of the values.
+        KUDU_RETURN_IF_ERROR(scanner_->AddConjunctPredicate(
+            scanner_->GetKuduTable()->NewInListPredicate(col_name, &values)),
+            BuildErrorString("Failed to add in-list predicate"));
       } else {
         DCHECK(ctx.filter->is_min_max_filter());
         MinMaxFilter* filter = ctx.filter->get_min_max();
@@ -311,12 +435,14 @@ Status KuduScanner::OpenNextScanToken(const string& scan_token, bool* eos) {
 
 void KuduScanner::CloseCurrentClientScanner() {
   DCHECK_NOTNULL(scanner_.get());
+  // The batch of a fetch in flight is not needed anymore, e.g. if the limit was reached.
+  if (fetch_in_flight_) WaitForFetch();
   scanner_->Close();
   scanner_.reset();
 }
 
 Status KuduScanner::HandleEmptyProjection(RowBatch* row_batch) {
-  int num_rows_remaining = cur_kudu_batch_.NumRows() - cur_kudu_batch_num_read_;
+  int num_rows_remaining = cur_kudu_batch_->NumRows() - cur_kudu_batch_num_read_;
   int rows_to_add = std::min(row_batch->capacity() - row_batch->num_rows(),
       num_rows_remaining);
   int num_to_commit = 0;
@@ -340,86 +466,145 @@ Status KuduScanner::HandleEmptyProjection(RowBatch* row_batch) {
   return Status::OK();
 }
 
-Status KuduScanner::DecodeRowsIntoRowBatch(RowBatch* row_batch, Tuple** tuple_mem) {
-  // Short-circuit for empty projection cases.
-  if (scan_node_->tuple_desc()->slots().empty()) {
-    return HandleEmptyProjection(row_batch);
-  }
+int64_t KuduScanner::NumRowsLeftInLimit(const RowBatch* row_batch) const {
+  if (scan_node_->limit() == -1) return -1;
+  return max<int64_t>(0,
+      scan_node_->limit() - scan_node_->rows_returned_shared() - row_batch->num_rows());
+}
 
-  // Iterate through the Kudu rows, evaluate conjuncts and deep-copy survivors into
-  // 'row_batch'.
-  bool has_conjuncts = !conjunct_evals_.empty();
-  int num_rows = cur_kudu_batch_.NumRows();
-
-  for (int krow_idx = cur_kudu_batch_num_read_; krow_idx < num_rows; ++krow_idx) {
-    Tuple* kudu_tuple = const_cast<Tuple*>(
-        reinterpret_cast<const Tuple*>(cur_kudu_batch_.direct_data().data()
-            + (krow_idx * scan_node_->row_desc()->GetRowSize())));
-    ++cur_kudu_batch_num_read_;
-
-    // Kudu tuples containing TIMESTAMP columns (UNIXTIME_MICROS in Kudu, stored as an
-    // int64) have 8 bytes of padding following the timestamp. Because this padding is
-    // provided, Impala can convert these unixtime values to Impala's TimestampValue
-    // format in place and copy the rows to Impala row batches.
-    // TODO: avoid mem copies with a Kudu mem 'release' mechanism, attaching mem to the
-    // batch.
-    // TODO: consider codegen for this per-timestamp col fixup
-    for (const SlotDescriptor* slot : timestamp_slots_) {
-      DCHECK(slot->type().type == TYPE_TIMESTAMP);
-      if (slot->is_nullable() && kudu_tuple->IsNull(slot->null_indicator_offset())) {
-        continue;
+Status KuduScanner::DecodeColumnarBatchIntoRowBatch(
+    RowBatch* row_batch, Tuple** tuple_mem) {
+  const TupleDescriptor& tuple_desc = *scan_node_->tuple_desc();
+  const int tuple_byte_size = tuple_desc.byte_size();
+  const int start_row = cur_kudu_batch_num_read_;
+  const int num_rows = std::min(row_batch->capacity() - row_batch->num_rows(),
+      cur_columnar_batch_->NumRows() - start_row);
+  uint8_t* tuples = reinterpret_cast<uint8_t*>(*tuple_mem);
+  // Clears the null indicators, which are then only set for the null values.
+  memset(tuples, 0, static_cast<int64_t>(num_rows) * tuple_byte_size);
+
+  // Materialize all rows one column at a time.
+  for (int s = 0; s < tuple_desc.slots().size(); ++s) {
+    const SlotDescriptor* slot = tuple_desc.slots()[s];
+    const int col_idx = projection_col_idxs_[s];
+    if (slot->is_nullable()) {
+      kudu::Slice non_null_bitmap;
+      KUDU_RETURN_IF_ERROR(
+          cur_columnar_batch_->GetNonNullBitmapForColumn(col_idx, &non_null_bitmap),
+          BuildErrorString("Unable to get the null bitmap of a column"));
+      SetNullIndicators(non_null_bitmap.data(), start_row, num_rows,
+          slot->null_indicator_offset(), tuple_byte_size, tuples);
+    }
+    const PrimitiveType type = slot->type().type;
+    if (type == TYPE_STRING || type == TYPE_VARCHAR || type == TYPE_BINARY) {
+      kudu::Slice offsets_data;
+      kudu::Slice var_len_data;
+      KUDU_RETURN_IF_ERROR(cur_columnar_batch_->GetVariableLengthColumn(
+          col_idx, &offsets_data, &var_len_data),
+          BuildErrorString("Unable to get a variable length column"));
+      // 'offsets' has one more entry than there are rows. The values of consecutive
+      // rows are contiguous, so they are copied with a single memcpy().
+      const uint32_t* offsets =
+          reinterpret_cast<const uint32_t*>(offsets_data.data()) + start_row;
+      const int64_t total_len = offsets[num_rows] - offsets[0];
+      char* buffer = reinterpret_cast<char*>(
+          row_batch->tuple_data_pool()->TryAllocateUnaligned(total_len));
+      if (UNLIKELY(buffer == nullptr && total_len > 0)) {
+        return row_batch->tuple_data_pool()->mem_tracker()->MemLimitExceeded(state_,
+            "Failed to allocate string data for a Kudu columnar batch", total_len);
       }
-      int64_t ts_micros = *reinterpret_cast<int64_t*>(
-          kudu_tuple->GetSlot(slot->tuple_offset()));
-      TimestampValue tv = TimestampValue::UtcFromUnixTimeMicros(ts_micros);
-      if (tv.HasDateAndTime()) {
-        RawValue::Write(&tv, kudu_tuple, slot, nullptr);
-      } else {
-        kudu_tuple->SetNull(slot->null_indicator_offset());
-        RETURN_IF_ERROR(state_->LogOrReturnError(
-            ErrorMsg::Init(TErrorCode::KUDU_TIMESTAMP_OUT_OF_RANGE,
-              scan_node_->table_desc()->table_name(),
-              scanner_->GetKuduTable()->schema().Column(slot->col_pos()).name())));
+      if (total_len > 0) memcpy(buffer, var_len_data.data() + offsets[0], total_len);
+      // VARCHAR values longer than the column are truncated, see
+      // DecodeRowsIntoRowBatch().
+      const int max_len = type == TYPE_VARCHAR ? slot->type().len : INT_MAX;
+      uint8_t* dst = tuples + slot->tuple_offset();
+      for (int i = 0; i < num_rows; ++i) {
+        StringValue* sv = reinterpret_cast<StringValue*>(dst);
+        sv->ptr = buffer + (offsets[i] - offsets[0]);
+        sv->len = std::min<int64_t>(offsets[i + 1] - offsets[i], max_len);
+        dst += tuple_byte_size;
       }
+      continue;
     }
 
-    // Kudu tuples containing VARCHAR columns use characters instead of bytes to limit
-    // the length. In the case of ASCII values there is no difference. However, if
-    // multi-byte characters are written to Kudu the length could be longer than allowed.
-    // This checks the actual length and truncates the value length if it is too long.
-    // TODO(IMPALA-5675): Remove this when Impala supports UTF-8 character VARCHAR length.
-    for (const SlotDescriptor* slot : varchar_slots_) {
-      DCHECK(slot->type().type == TYPE_VARCHAR);
-      if (slot->is_nullable() && kudu_tuple->IsNull(slot->null_indicator_offset())) {
-        continue;
-      }
-      StringValue* sv = reinterpret_cast<StringValue*>(
-          kudu_tuple->GetSlot(slot->tuple_offset()));
-      int src_len = sv->len;
-      int dst_len = slot->type().len;
-      if (src_len > dst_len) {
-        sv->len = dst_len;
+    kudu::Slice fixed_data;
+    KUDU_RETURN_IF_ERROR(
+        cur_columnar_batch_->GetFixedLengthColumn(col_idx, &fixed_data),
+        BuildErrorString("Unable to get a fixed length column"));
+    if (type == TYPE_TIMESTAMP) {
+      // Kudu stores UNIXTIME_MICROS as an int64 without padding, so the values are
+      // converted into the slots rather than copied.
+      const int64_t* micros =
+          reinterpret_cast<const int64_t*>(fixed_data.data()) + start_row;
+      for (int i = 0; i < num_rows; ++i) {
+        Tuple* tuple = reinterpret_cast<Tuple*>(tuples + i * tuple_byte_size);
+        if (slot->is_nullable() && tuple->IsNull(slot->null_indicator_offset())) {
+          continue;
+        }
+        TimestampValue tv = TimestampValue::UtcFromUnixTimeMicros(micros[i]);
+        if (tv.HasDateAndTime()) {
+          RawValue::Write(&tv, tuple, slot, nullptr);
+        } else {
+          tuple->SetNull(slot->null_indicator_offset());
+          RETURN_IF_ERROR(state_->LogOrReturnError(
+              ErrorMsg::Init(TErrorCode::KUDU_TIMESTAMP_OUT_OF_RANGE,
+                scan_node_->table_desc()->table_name(),
+                scanner_->GetKuduTable()->schema().Column(slot->col_pos()).name())));
+        }
       }
+      continue;
+    }
+    // The other types have the same size and representation in Kudu and Impala.
+    const int slot_size = slot->slot_size();
+    const uint8_t* data = fixed_data.data() + static_cast<int64_t>(start_row) * slot_size;
+    const int slot_offset = slot->tuple_offset();
+    switch (slot_size) {
+      case 1:
+        CopyFixedLengthColumn<1>(data, num_rows, slot_offset, tuple_byte_size, tuples);
+        break;
+      case 2:
+        CopyFixedLengthColumn<2>(data, num_rows, slot_offset, tuple_byte_size, tuples);
+        break;
+      case 4:
+        CopyFixedLengthColumn<4>(data, num_rows, slot_offset, tuple_byte_size, tuples);
+        break;
+      case 8:
+        CopyFixedLengthColumn<8>(data, num_rows, slot_offset, tuple_byte_size, tuples);
+        break;
+      case 16:
+        CopyFixedLengthColumn<16>(data, num_rows, slot_offset, tuple_byte_size, tuples);
+        break;
+      default:
+        DCHECK(false) << "Unexpected slot size " << slot_size << " for "
+                      << slot->type().DebugString();
+        return Status(BuildErrorString("Unsupported column type for columnar scan"));
     }
+  }
 
-    // Evaluate the conjuncts that haven't been pushed down to Kudu. Conjunct evaluation
-    // is performed directly on the Kudu tuple because its memory layout is identical to
-    // Impala's. We only copy the surviving tuples to Impala's output row batch.
+  // Evaluate the conjuncts that haven't been pushed down to Kudu and compact the
+  // surviving tuples, so that the tuple buffer is used by the committed rows only.
+  // Stop once the committed rows reach the LIMIT of the scan node. The rows after that
+  // count as not read.
+  bool has_conjuncts = !conjunct_evals_.empty();
+  int64_t rows_left = NumRowsLeftInLimit(row_batch);
+  uint8_t* dst = tuples;
+  int num_evaluated = 0;
+  while (num_evaluated < num_rows && rows_left != 0) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuples + num_evaluated * tuple_byte_size);
+    ++num_evaluated;
     if (has_conjuncts && !ExecNode::EvalConjuncts(conjunct_evals_.data(),
-            conjunct_evals_.size(), reinterpret_cast<TupleRow*>(&kudu_tuple))) {
+            conjunct_evals_.size(), reinterpret_cast<TupleRow*>(&tuple))) {
       continue;
     }
-    // Deep copy the tuple, set it in a new row, and commit the row.
-    kudu_tuple->DeepCopy(*tuple_mem, *scan_node_->tuple_desc(),
-        row_batch->tuple_data_pool());
+    if (dst != reinterpret_cast<uint8_t*>(tuple)) memcpy(dst, tuple, tuple_byte_size);
     TupleRow* row = row_batch->GetRow(row_batch->AddRow());
-    row->SetTuple(0, *tuple_mem);
+    row->SetTuple(0, reinterpret_cast<Tuple*>(dst));
     row_batch->CommitLastRow();
-    // If we've reached the capacity, or the LIMIT for the scan, return.
-    if (row_batch->AtCapacity() || scan_node_->ReachedLimitShared()) break;
-    // Move to the next tuple in the tuple buffer.
-    *tuple_mem = next_tuple(*tuple_mem);
+    dst += tuple_byte_size;
+    if (rows_left > 0) --rows_left;
   }
+  cur_kudu_batch_num_read_ += num_evaluated;
+  *tuple_mem = reinterpret_cast<Tuple*>(dst);
   expr_results_pool_->Clear();
 
   // Check the status in case an error status was set during conjunct evaluation.
@@ -427,17 +612,68 @@ Status KuduScanner::DecodeRowsIntoRowBatch(RowBatch* row_batch, Tuple** tuple_me
 }
 
 Status KuduScanner::GetNextScannerBatch() {
+  // With prefetching, this only measures the time that the fetch was not hidden.
   SCOPED_TIMER2(state_->total_storage_wait_timer(), scan_node_->kudu_client_time());
   int64_t now = MonotonicMicros();
-  KUDU_RETURN_IF_ERROR(scanner_->NextBatch(&cur_kudu_batch_),
-      BuildErrorString("Unable to advance iterator"));
+  if (fetch_thread_ != nullptr) {
+    if (!fetch_in_flight_) StartFetch();
+    KUDU_RETURN_IF_ERROR(WaitForFetch(), BuildErrorString("Unable to advance iterator"));
+    swap(cur_kudu_batch_, next_kudu_batch_);
+    swap(cur_columnar_batch_, next_columnar_batch_);
+    // The fetch thread is idle, so 'scanner_' can be used here.
+    if (scanner_->HasMoreRows()) StartFetch();
+  } else if (columnar_scan_) {
+    KUDU_RETURN_IF_ERROR(scanner_->NextBatch(cur_columnar_batch_),
+        BuildErrorString("Unable to advance iterator"));
+  } else {
+    KUDU_RETURN_IF_ERROR(scanner_->NextBatch(cur_kudu_batch_),
+        BuildErrorString("Unable to advance iterator"));
+  }
   COUNTER_ADD(scan_node_->kudu_round_trips(), 1);
   cur_kudu_batch_num_read_ = 0;
-  COUNTER_ADD(scan_node_->rows_read_counter(), cur_kudu_batch_.NumRows());
+  COUNTER_ADD(scan_node_->rows_read_counter(), CurBatchNumRows());
   last_alive_time_micros_ = now;
   return Status::OK();
 }
 
+void KuduScanner::StartFetch() {
+  DCHECK(fetch_thread_ != nullptr);
+  DCHECK(!fetch_in_flight_);
+  {
+    lock_guard<mutex> l(fetch_lock_);
+    fetch_requested_ = true;
+    fetch_done_ = false;
+  }
+  fetch_requested_cv_.NotifyOne();
+  fetch_in_flight_ = true;
+}
+
+kudu::Status KuduScanner::WaitForFetch() {
+  DCHECK(fetch_in_flight_);
+  unique_lock<mutex> l(fetch_lock_);
+  while (!fetch_done_) fetch_done_cv_.Wait(l);
+  fetch_in_flight_ = false;
+  return fetch_status_;
+}
+
+void KuduScanner::FetchThread() {
+  unique_lock<mutex> l(fetch_lock_);
+  while (true) {
+    while (!fetch_requested_ && !fetch_thread_shutdown_) fetch_requested_cv_.Wait(l);
+    if (fetch_thread_shutdown_) return;
+    fetch_requested_ = false;
+    l.unlock();
+    // The scanner thread does not touch 'scanner_' or the next batches until the fetch
+    // is done.
+    kudu::Status status = columnar_scan_ ? scanner_->NextBatch(next_columnar_batch_)
+                                         : scanner_->NextBatch(next_kudu_batch_);
+    l.lock();
+    fetch_status_ = status;
+    fetch_done_ = true;
+    fetch_done_cv_.NotifyOne();
+  }
+}
+
 string KuduScanner::BuildErrorString(const char* msg) {
   return Substitute("$0 for node with id '$1' for Kudu table '$2'", msg, scan_node_->id(),
       scan_node_->table_desc()->table_name());
@@ -18,12 +18,18 @@
 #ifndef IMPALA_EXEC_KUDU_SCANNER_H_
 #define IMPALA_EXEC_KUDU_SCANNER_H_
 
+#include <memory>
+#include <mutex>
+
 #include <boost/scoped_ptr.hpp>
 #include <kudu/client/client.h>
+#include <kudu/client/columnar_scan_batch.h>
 
 #include "common/object-pool.h"
 #include "exec/kudu-scan-node-base.h"
 #include "runtime/descriptors.h"
+#include "util/condition-variable.h"
+#include "util/thread.h"
 
 namespace impala {
 
@@ -35,6 +41,16 @@ class Tuple;
 /// Wraps a Kudu client scanner to fetch row batches from Kudu. The Kudu client scanner
 /// is created from a scan token in OpenNextScanToken(), which then provides rows fetched
 /// by GetNext() until it reaches eos, and the caller may open another scan token.
+///
+/// By default, Kudu returns rows in the memory layout of Impala tuples, which are
+/// converted and copied one row at a time. If the KUDU_COLUMNAR_SCAN query option is set,
+/// the scanner instead requests batches in columnar layout and copies whole column
+/// buffers into the tuples of the row batch (see DecodeColumnarBatchIntoRowBatch()).
+///
+/// If the KUDU_SCAN_PREFETCH query option is set, the scanner has a fetch thread which
+/// fetches the next batch from the tablet server while the current batch is decoded.
+/// The kudu::client::KuduScanner is not thread-safe, so only the fetch thread uses it
+/// while a fetch is in flight, see StartFetch() and WaitForFetch().
 class KuduScanner {
  public:
   KuduScanner(KuduScanNodeBase* scan_node, RuntimeState* state);
@@ -73,18 +89,53 @@ class KuduScanner {
   /// and add a row to the row batch only when the conjuncts evaluate to true.
   Status HandleEmptyProjection(RowBatch* row_batch);
 
-  /// Decodes rows previously fetched from kudu, now in 'cur_rows_' into a RowBatch.
+  /// Decodes rows previously fetched from kudu, now in 'cur_kudu_batch_' into a RowBatch.
   ///  - 'batch' is the batch that will point to the new tuples.
   ///  - *tuple_mem should be the location to output tuples.
   /// Returns OK when one of the following conditions occur:
   ///  - cur_kudu_batch_ is fully consumed
   ///  - batch is full
   ///  - scan_node_ limit has been reached
+  /// Cross-compiled to IR. KuduScanPlanNode::Codegen() replaces the conjunct
+  /// evaluation with the codegen'd conjuncts.
   Status DecodeRowsIntoRowBatch(RowBatch* batch, Tuple** tuple_mem);
 
-  /// Fetches the next batch of rows from the current kudu::client::KuduScanner.
+  /// Decodes the rows of 'cur_columnar_batch_' into 'row_batch' one column at a time.
+  /// The tuples are written starting at *tuple_mem, the conjuncts are evaluated and the
+  /// surviving tuples are compacted to the front. Returns OK under the same conditions
+  /// as DecodeRowsIntoRowBatch().
+  Status DecodeColumnarBatchIntoRowBatch(RowBatch* row_batch, Tuple** tuple_mem);
+
+  /// Returns how many more rows 'row_batch' can take before the scan node reaches its
+  /// LIMIT, counting the rows the scan node already returned. Returns -1 if the scan
+  /// node has no LIMIT.
+  int64_t NumRowsLeftInLimit(const RowBatch* row_batch) const;
+
+  /// Fetches the next batch of rows from the current kudu::client::KuduScanner. With
+  /// prefetching, takes the batch of the fetch in flight and starts fetching the next.
   Status GetNextScannerBatch();
 
+  /// Returns true if the current kudu::client::KuduScanner has more batches, including
+  /// the batch of a fetch in flight.
+  bool HasMoreBatches() const { return fetch_in_flight_ || scanner_->HasMoreRows(); }
+
+  /// Hands the fetch of the next batch of the current kudu::client::KuduScanner to the
+  /// fetch thread. No fetch must be in flight.
+  void StartFetch();
+
+  /// Waits for the fetch in flight and returns its status. The fetched batch is in
+  /// 'next_kudu_batch_' or 'next_columnar_batch_'.
+  kudu::Status WaitForFetch();
+
+  /// Body of 'fetch_thread_'. Fetches a batch whenever StartFetch() asks for one until
+  /// Close() shuts it down.
+  void FetchThread();
+
+  /// Returns the number of rows of the current batch.
+  int CurBatchNumRows() const {
+    return columnar_scan_ ? cur_columnar_batch_->NumRows() : cur_kudu_batch_->NumRows();
+  }
+
   /// Closes the current kudu::client::KuduScanner.
   void CloseCurrentClientScanner();
 
@@ -115,10 +166,62 @@ class KuduScanner {
   /// created for each scan token using KuduScanToken::DeserializeIntoScanner().
   boost::scoped_ptr<kudu::client::KuduScanner> scanner_;
 
+  /// The batches that 'cur_kudu_batch_' and 'next_kudu_batch_' point to, and likewise
+  /// for columnar batches. Each batch owns the RPC response it was filled from, so
+  /// fetching into one batch does not invalidate the other.
+  kudu::client::KuduScanBatch kudu_batches_[2];
+  kudu::client::KuduColumnarScanBatch columnar_batches_[2];
+
   /// The current batch of retrieved rows.
-  kudu::client::KuduScanBatch cur_kudu_batch_;
+  kudu::client::KuduScanBatch* cur_kudu_batch_ = &kudu_batches_[0];
+
+  /// The batch that the next batch of rows is fetched into. Swapped with
+  /// 'cur_kudu_batch_' once fetched.
+  kudu::client::KuduScanBatch* next_kudu_batch_ = &kudu_batches_[1];
+
+  /// True if batches are fetched in columnar layout into 'cur_columnar_batch_' instead
+  /// of 'cur_kudu_batch_'. Set in OpenNextScanToken().
+  bool columnar_scan_ = false;
+
+  /// The current batch of retrieved columns if 'columnar_scan_' is true.
+  kudu::client::KuduColumnarScanBatch* cur_columnar_batch_ = &columnar_batches_[0];
+
+  /// The batch that the next batch of columns is fetched into.
+  kudu::client::KuduColumnarScanBatch* next_columnar_batch_ = &columnar_batches_[1];
+
+  /// Fetches batches if the KUDU_SCAN_PREFETCH query option is set. Started in Open().
+  std::unique_ptr<Thread> fetch_thread_;
+
+  /// True between StartFetch() and WaitForFetch(). Only accessed by the thread that
+  /// calls GetNext().
+  bool fetch_in_flight_ = false;
+
+  /// Protects the state below, which hands fetches to and from 'fetch_thread_'.
+  std::mutex fetch_lock_;
+
+  /// Signalled when 'fetch_requested_' or 'fetch_thread_shutdown_' is set.
+  ConditionVariable fetch_requested_cv_;
+
+  /// Signalled when 'fetch_done_' is set.
+  ConditionVariable fetch_done_cv_;
+
+  /// Set by StartFetch() and cleared by the fetch thread when it starts fetching.
+  bool fetch_requested_ = false;
+
+  /// Set by the fetch thread when the requested fetch is done.
+  bool fetch_done_ = false;
+
+  /// The status of the last fetch of the fetch thread.
+  kudu::Status fetch_status_;
+
+  /// Set by Close() to end the fetch thread.
+  bool fetch_thread_shutdown_ = false;
+
+  /// The index of the column in the Kudu projection for each slot of the tuple
+  /// descriptor, in the same order. Only set if 'columnar_scan_' is true.
+  vector<int> projection_col_idxs_;
 
-  /// The number of rows already read from cur_kudu_batch_.
+  /// The number of rows already read from the current batch.
   int cur_kudu_batch_num_read_;
 
   /// The last time a keepalive request or successful RPC was sent.
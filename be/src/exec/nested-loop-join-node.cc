@@ -17,6 +17,7 @@
 
 #include "exec/nested-loop-join-node.h"
 
+#include <algorithm>
 #include <sstream>
 #include <gutil/strings/substitute.h>
 
@@ -27,9 +28,11 @@
 #include "exec/join-op.h"
 #include "exprs/scalar-expr-evaluator.h"
 #include "exprs/scalar-expr.h"
+#include "exprs/slot-ref.h"
 #include "gen-cpp/PlanNodes_types.h"
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/raw-value.inline.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
 #include "util/bitmap.h"
@@ -50,11 +53,27 @@ Status NestedLoopJoinPlanNode::Init(const TPlanNode& tnode, FragmentState* state
   DCHECK(tnode.join_node.join_op != TJoinOp::CROSS_JOIN
       || join_conjuncts_.size() == 0)
       << "Join conjuncts in a cross join";
+  const TNestedLoopJoinNode& tnlj = tnode.join_node.nested_loop_join_node;
+  if (tnlj.__isset.range_build_expr) {
+    DCHECK(!tnlj.range_bounds.empty());
+    RETURN_IF_ERROR(ScalarExpr::Create(
+        tnlj.range_build_expr, build_row_desc(), state, &range_build_expr_));
+    DCHECK(range_build_expr_->IsSlotRef());
+    for (const TNestedLoopJoinRangeBound& bound : tnlj.range_bounds) {
+      ScalarExpr* probe_expr;
+      RETURN_IF_ERROR(
+          ScalarExpr::Create(bound.probe_expr, probe_row_desc(), state, &probe_expr));
+      range_ops_.push_back(bound.op);
+      range_probe_exprs_.push_back(probe_expr);
+    }
+  }
   return Status::OK();
 }
 
 void NestedLoopJoinPlanNode::Close() {
   ScalarExpr::Close(join_conjuncts_);
+  if (range_build_expr_ != nullptr) range_build_expr_->Close();
+  ScalarExpr::Close(range_probe_exprs_);
   PlanNode::Close();
 }
 
@@ -71,7 +90,17 @@ NestedLoopJoinNode::NestedLoopJoinNode(
     build_batches_(NULL),
     current_build_row_idx_(0),
     process_unmatched_build_rows_(false),
-    join_conjuncts_(pnode.join_conjuncts_) {}
+    join_conjuncts_(pnode.join_conjuncts_),
+    range_ops_(pnode.range_ops_),
+    range_probe_exprs_(pnode.range_probe_exprs_) {
+  if (pnode.range_build_expr_ != nullptr) {
+    SlotId slot_id = static_cast<const SlotRef*>(pnode.range_build_expr_)->slot_id();
+    range_slot_desc_ = descs.GetSlotDescriptor(slot_id);
+    DCHECK(range_slot_desc_ != nullptr);
+    range_tuple_idx_ =
+        pnode.build_row_desc().GetTupleIdx(range_slot_desc_->parent()->id());
+  }
+}
 
 NestedLoopJoinNode::~NestedLoopJoinNode() {
   DCHECK(is_closed());
@@ -88,6 +117,7 @@ Status NestedLoopJoinNode::Open(RuntimeState* state) {
     DCHECK(builder_ != nullptr);
   }
   RETURN_IF_ERROR(ScalarExprEvaluator::Open(join_conjunct_evals_, state));
+  RETURN_IF_ERROR(ScalarExprEvaluator::Open(range_probe_expr_evals_, state));
 
   // Check for errors and free expr result allocations before opening children.
   RETURN_IF_CANCELLED(state);
@@ -112,6 +142,7 @@ Status NestedLoopJoinNode::Open(RuntimeState* state) {
     if (matching_build_rows_ != NULL) {
       RETURN_IF_ERROR(ResetMatchingBuildRows(state, build_batches_->total_num_rows()));
     }
+    if (range_slot_desc_ != nullptr) RETURN_IF_ERROR(BuildRangeIndex(state));
   }
   RETURN_IF_ERROR(BlockingJoinNode::GetFirstProbeRow(state));
   ResetForProbe();
@@ -123,6 +154,12 @@ Status NestedLoopJoinNode::Prepare(RuntimeState* state) {
   RETURN_IF_ERROR(BlockingJoinNode::Prepare(state));
   RETURN_IF_ERROR(ScalarExprEvaluator::Create(join_conjuncts_, state,
       pool_, expr_perm_pool(), expr_results_pool(), &join_conjunct_evals_));
+  RETURN_IF_ERROR(ScalarExprEvaluator::Create(range_probe_exprs_, state,
+      pool_, expr_perm_pool(), expr_results_pool(), &range_probe_expr_evals_));
+  if (range_slot_desc_ != nullptr) {
+    range_search_candidates_counter_ =
+        ADD_COUNTER(runtime_profile(), "RangeSearchCandidateRows", TUnit::UNIT);
+  }
 
   if (!UseSeparateBuild(state->query_options())) {
     builder_ = NljBuilder::CreateEmbeddedBuilder(&build_row_desc(), state, id_);
@@ -158,12 +195,14 @@ Status NestedLoopJoinNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   current_probe_row_ = NULL;
   probe_batch_pos_ = 0;
   process_unmatched_build_rows_ = false;
+  ClearRangeIndex();
   return BlockingJoinNode::Reset(state, row_batch);
 }
 
 void NestedLoopJoinNode::Close(RuntimeState* state) {
   if (is_closed()) return;
   ScalarExprEvaluator::Close(join_conjunct_evals_, state);
+  ScalarExprEvaluator::Close(range_probe_expr_evals_, state);
   if (builder_ != NULL) {
     // IMPALA-6595: builder must be closed before child. The separate build case is
     // handled in FragmentInstanceState.
@@ -179,6 +218,7 @@ void NestedLoopJoinNode::Close(RuntimeState* state) {
     mem_tracker()->Release(matching_build_rows_->MemUsage());
     matching_build_rows_.reset();
   }
+  ClearRangeIndex();
   BlockingJoinNode::Close(state);
 }
 
@@ -224,6 +264,94 @@ void NestedLoopJoinNode::ResetForProbe() {
   build_row_iterator_ = build_batches_->Iterator();
   current_build_row_idx_ = 0;
   matched_probe_ = false;
+  if (use_range_search_ && current_probe_row_ != NULL) SetProbeRange();
+}
+
+const void* NestedLoopJoinNode::GetRangeSlot(TupleRow* build_row) const {
+  Tuple* tuple = build_row->GetTuple(range_tuple_idx_);
+  if (tuple == nullptr || tuple->IsNull(range_slot_desc_->null_indicator_offset())) {
+    return nullptr;
+  }
+  return tuple->GetSlot(range_slot_desc_->tuple_offset());
+}
+
+Status NestedLoopJoinNode::BuildRangeIndex(RuntimeState* state) {
+  DCHECK(range_slot_desc_ != nullptr);
+  DCHECK(range_index_.empty());
+  int64_t num_build_rows = build_batches_->total_num_rows();
+  int64_t mem_usage = num_build_rows * sizeof(RangeIndexEntry);
+  if (!mem_tracker()->TryConsume(mem_usage)) {
+    return mem_tracker()->MemLimitExceeded(state,
+        "Could not allocate range index in nested loop join", mem_usage);
+  }
+  range_index_mem_usage_ = mem_usage;
+  range_index_.reserve(num_build_rows);
+  int64_t build_row_idx = 0;
+  for (RowBatchList::TupleRowIterator it = build_batches_->Iterator(); !it.AtEnd();
+       it.Next()) {
+    TupleRow* build_row = it.GetRow();
+    const void* key = GetRangeSlot(build_row);
+    if (key != nullptr) range_index_.push_back({key, build_row, build_row_idx});
+    ++build_row_idx;
+  }
+  DCHECK_EQ(build_row_idx, num_build_rows);
+  const ColumnType& type = range_slot_desc_->type();
+  std::sort(range_index_.begin(), range_index_.end(),
+      [&type](const RangeIndexEntry& a, const RangeIndexEntry& b) {
+        return RawValue::Compare(a.key, b.key, type) < 0;
+      });
+  use_range_search_ = true;
+  return Status::OK();
+}
+
+void NestedLoopJoinNode::ClearRangeIndex() {
+  mem_tracker()->Release(range_index_mem_usage_);
+  range_index_mem_usage_ = 0;
+  // Swap to free the memory of the vector.
+  std::vector<RangeIndexEntry>().swap(range_index_);
+  use_range_search_ = false;
+  range_pos_ = 0;
+  range_end_ = 0;
+}
+
+void NestedLoopJoinNode::SetProbeRange() {
+  DCHECK(current_probe_row_ != NULL);
+  const ColumnType& type = range_slot_desc_->type();
+  auto key_less = [&type](const RangeIndexEntry& entry, const void* value) {
+    return RawValue::Compare(entry.key, value, type) < 0;
+  };
+  auto value_less = [&type](const void* value, const RangeIndexEntry& entry) {
+    return RawValue::Compare(value, entry.key, type) < 0;
+  };
+  auto begin = range_index_.begin();
+  auto end = range_index_.end();
+  for (int i = 0; i < range_probe_expr_evals_.size() && begin < end; ++i) {
+    const void* value = range_probe_expr_evals_[i]->GetValue(current_probe_row_);
+    if (value == nullptr) {
+      // A comparison with NULL is never true.
+      end = begin;
+      break;
+    }
+    switch (range_ops_[i]) {
+      case extdatasource::TComparisonOp::LT:
+        end = std::lower_bound(begin, end, value, key_less);
+        break;
+      case extdatasource::TComparisonOp::LE:
+        end = std::upper_bound(begin, end, value, value_less);
+        break;
+      case extdatasource::TComparisonOp::GE:
+        begin = std::lower_bound(begin, end, value, key_less);
+        break;
+      case extdatasource::TComparisonOp::GT:
+        begin = std::upper_bound(begin, end, value, value_less);
+        break;
+      default:
+        DCHECK(false) << "Unexpected range bound op: " << range_ops_[i];
+    }
+  }
+  range_pos_ = begin - range_index_.begin();
+  range_end_ = std::max(begin, end) - range_index_.begin();
+  COUNTER_ADD(range_search_candidates_counter_, range_end_ - range_pos_);
 }
 
 Status NestedLoopJoinNode::GetNext(
@@ -620,6 +748,9 @@ Status NestedLoopJoinNode::ProcessUnmatchedBuildRows(
 
 Status NestedLoopJoinNode::FindBuildMatches(
     RuntimeState* state, RowBatch* output_batch, bool* return_output_batch) {
+  if (use_range_search_) {
+    return FindBuildMatchesInRange(state, output_batch, return_output_batch);
+  }
   *return_output_batch = false;
   ScalarExprEvaluator* const* join_conjunct_evals = join_conjunct_evals_.data();
   size_t num_join_conjuncts = join_conjuncts_.size();
@@ -666,6 +797,56 @@ Status NestedLoopJoinNode::FindBuildMatches(
   return Status::OK();
 }
 
+Status NestedLoopJoinNode::FindBuildMatchesInRange(
+    RuntimeState* state, RowBatch* output_batch, bool* return_output_batch) {
+  DCHECK(use_range_search_);
+  *return_output_batch = false;
+  ScalarExprEvaluator* const* join_conjunct_evals = join_conjunct_evals_.data();
+  size_t num_join_conjuncts = join_conjuncts_.size();
+  DCHECK_EQ(num_join_conjuncts, join_conjunct_evals_.size());
+  ScalarExprEvaluator* const* conjunct_evals = conjunct_evals_.data();
+  size_t num_conjuncts = conjuncts_.size();
+  DCHECK_EQ(num_conjuncts, conjunct_evals_.size());
+
+  const int N = BitUtil::RoundUpToPowerOfTwo(state->batch_size());
+  while (range_pos_ < range_end_) {
+    DCHECK(current_probe_row_ != NULL);
+    const RangeIndexEntry& entry = range_index_[range_pos_];
+    TupleRow* output_row = output_batch->GetRow(output_batch->AddRow());
+    CreateOutputRow(output_row, current_probe_row_, entry.row);
+    ++range_pos_;
+
+    // The range can be large if the range bounds are not selective. Do expensive query
+    // maintenance after every N iterations.
+    if ((range_pos_ & (N - 1)) == 0) {
+      if (ReachedLimit()) {
+        eos_ = true;
+        *return_output_batch = true;
+        return Status::OK();
+      }
+      RETURN_IF_CANCELLED(state);
+      RETURN_IF_ERROR(QueryMaintenance(state));
+    }
+    // The range bounds are join conjuncts too, so all join conjuncts are evaluated.
+    if (!EvalConjuncts(join_conjunct_evals, num_join_conjuncts, output_row)) {
+      continue;
+    }
+    matched_probe_ = true;
+    if (matching_build_rows_ != NULL) {
+      matching_build_rows_->Set(entry.build_row_idx, true);
+    }
+    if (!EvalConjuncts(conjunct_evals, num_conjuncts, output_row)) continue;
+    VLOG_ROW << "match row: " << PrintRow(output_row, *row_desc());
+    output_batch->CommitLastRow();
+    IncrementNumRowsReturned(1);
+    if (output_batch->AtCapacity()) {
+      *return_output_batch = true;
+      return Status::OK();
+    }
+  }
+  return Status::OK();
+}
+
 Status NestedLoopJoinNode::NextProbeRow(RuntimeState* state, RowBatch* output_batch) {
   current_probe_row_ = NULL;
   matched_probe_ = false;
@@ -688,6 +869,7 @@ Status NestedLoopJoinNode::NextProbeRow(RuntimeState* state, RowBatch* output_ba
   // We have a valid probe row; reset the build row iterator.
   build_row_iterator_ = build_batches_->Iterator();
   current_build_row_idx_ = 0;
+  if (use_range_search_) SetProbeRange();
   VLOG_ROW << "left row: " << GetLeftChildRowString(current_probe_row_);
   return Status::OK();
 }
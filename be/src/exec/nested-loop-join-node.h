@@ -20,6 +20,7 @@
 
 #include <boost/scoped_ptr.hpp>
 #include <string>
+#include <vector>
 
 #include "exec/exec-node.h"
 #include "exec/blocking-join-node.h"
@@ -31,6 +32,7 @@ namespace impala {
 
 class Bitmap;
 class RowBatch;
+class SlotDescriptor;
 class TupleRow;
 
 class NestedLoopJoinPlanNode : public BlockingJoinPlanNode {
@@ -38,6 +40,15 @@ class NestedLoopJoinPlanNode : public BlockingJoinPlanNode {
   /// Join conjuncts.
   std::vector<ScalarExpr*> join_conjuncts_;
 
+  /// Slot ref on the build side that the build rows are sorted on for the range search.
+  /// NULL if the join conjuncts have no range bounds.
+  ScalarExpr* range_build_expr_ = nullptr;
+
+  /// The range bounds: the join conjuncts 'range_build_expr_ <op> probe expr'. The
+  /// probe exprs are evaluated over probe rows.
+  std::vector<extdatasource::TComparisonOp::type> range_ops_;
+  std::vector<ScalarExpr*> range_probe_exprs_;
+
   virtual Status Init(const TPlanNode& tnode, FragmentState* state) override;
   virtual void Close() override;
   virtual Status CreateExecNode(RuntimeState* state, ExecNode** node) const override;
@@ -49,10 +60,27 @@ class NestedLoopJoinPlanNode : public BlockingJoinPlanNode {
 /// This operator does not support spill to disk. Supports all join modes except
 /// null-aware left anti-join.
 ///
+/// If the planner found join conjuncts that compare a build-side slot to exprs over the
+/// probe side (range bounds), the node sorts the build rows on that slot after the build
+/// and, for each probe row, finds the range of build rows that satisfy all range bounds
+/// with a binary search. The join conjuncts are then only evaluated on the build rows in
+/// that range. Build rows with a NULL slot can never satisfy a range bound and are left
+/// out of the sorted index.
+///
 /// TODO: Add support for null-aware left-anti join.
 
 class NestedLoopJoinNode : public BlockingJoinNode {
  public:
+  /// An entry of the sorted index of build rows used by the range search.
+  struct RangeIndexEntry {
+    /// The non-NULL value of the range slot in 'row'.
+    const void* key;
+    TupleRow* row;
+    /// Ordinal position of 'row' in the build batches, used for
+    /// 'matching_build_rows_'.
+    int64_t build_row_idx;
+  };
+
   NestedLoopJoinNode(
       ObjectPool* pool, const NestedLoopJoinPlanNode& pnode, const DescriptorTbl& descs);
   virtual ~NestedLoopJoinNode();
@@ -90,6 +118,22 @@ class NestedLoopJoinNode : public BlockingJoinNode {
   /// RIGHT OUTER JOIN, RIGHT ANTI JOIN and FULL OUTER JOIN modes.
   bool process_unmatched_build_rows_ = false;
 
+  /// True if the build rows that can match a probe row are looked up in
+  /// 'range_index_'. Set in Open() when the node has range bounds and a regular build.
+  bool use_range_search_ = false;
+
+  /// The build rows with a non-NULL range slot, sorted on the range slot. Built in
+  /// Open().
+  std::vector<RangeIndexEntry> range_index_;
+
+  /// Bytes of 'range_index_' counted against mem_tracker().
+  int64_t range_index_mem_usage_ = 0;
+
+  /// The range [range_pos_, range_end_) of 'range_index_' that remains to be searched
+  /// for matches of the current probe row.
+  int64_t range_pos_ = 0;
+  int64_t range_end_ = 0;
+
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
@@ -97,6 +141,20 @@ class NestedLoopJoinNode : public BlockingJoinNode {
   const std::vector<ScalarExpr*>& join_conjuncts_;
   std::vector<ScalarExprEvaluator*> join_conjunct_evals_;
 
+  /// The range bounds, see NestedLoopJoinPlanNode.
+  const std::vector<extdatasource::TComparisonOp::type>& range_ops_;
+  const std::vector<ScalarExpr*>& range_probe_exprs_;
+  std::vector<ScalarExprEvaluator*> range_probe_expr_evals_;
+
+  /// The build-side slot of the range search and the index of its tuple in build rows.
+  /// NULL if the node has no range bounds.
+  const SlotDescriptor* range_slot_desc_ = nullptr;
+  int range_tuple_idx_ = -1;
+
+  /// Number of build rows in the ranges found by the range search, i.e. the build rows
+  /// that the join conjuncts were evaluated on.
+  RuntimeProfile::Counter* range_search_candidates_counter_ = nullptr;
+
   /// Optimized build for the case where the right child is a SingularRowSrcNode.
   Status ConstructSingularBuildSide(RuntimeState* state);
 
@@ -107,6 +165,20 @@ class NestedLoopJoinNode : public BlockingJoinNode {
   /// Prepares for probing the first batch.
   void ResetForProbe();
 
+  /// Sorts the non-NULL build rows of 'build_batches_' on the range slot into
+  /// 'range_index_'. Returns an error if the memory limit is exceeded.
+  Status BuildRangeIndex(RuntimeState* state);
+
+  /// Frees 'range_index_' and releases its memory.
+  void ClearRangeIndex();
+
+  /// Sets [range_pos_, range_end_) to the entries of 'range_index_' that satisfy all
+  /// range bounds for 'current_probe_row_'.
+  void SetProbeRange();
+
+  /// Returns the value of the range slot in 'build_row', or NULL if it is NULL.
+  const void* GetRangeSlot(TupleRow* build_row) const;
+
   Status GetNextInnerJoin(RuntimeState* state, RowBatch* output_batch);
   Status GetNextLeftOuterJoin(RuntimeState* state, RowBatch* output_batch);
   Status GetNextRightOuterJoin(RuntimeState* state, RowBatch* output_batch);
@@ -124,6 +196,11 @@ class NestedLoopJoinNode : public BlockingJoinNode {
   Status FindBuildMatches(RuntimeState* state, RowBatch* output_batch,
       bool* return_output_batch);
 
+  /// Same as FindBuildMatches(), but only evaluates the build rows in the range
+  /// [range_pos_, range_end_) of 'range_index_'.
+  Status FindBuildMatchesInRange(RuntimeState* state, RowBatch* output_batch,
+      bool* return_output_batch);
+
   /// Retrieves the next probe row from the left child. This function does
   /// not guarantee that a valid probe row is produced as it may exit if
   /// the output_batch is at capacity. If a valid probe row is retrieved, the
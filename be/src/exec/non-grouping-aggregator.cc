@@ -17,12 +17,16 @@
 
 #include "exec/non-grouping-aggregator.h"
 
+#include <cmath>
 #include <sstream>
+#include <type_traits>
 
 #include "codegen/llvm-codegen.h"
 #include "exec/exec-node.h"
 #include "exec/exec-node.inline.h"
 #include "exprs/agg-fn-evaluator.h"
+#include "exprs/agg-fn.h"
+#include "exprs/slot-ref.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/descriptors.h"
 #include "runtime/fragment-state.h"
@@ -41,6 +45,81 @@ NonGroupingAggregatorConfig::NonGroupingAggregatorConfig(
     const TAggregator& taggregator, FragmentState* state, PlanNode* pnode, int agg_idx)
   : AggregatorConfig(taggregator, state, pnode, agg_idx) {}
 
+Status NonGroupingAggregatorConfig::Init(
+    const TAggregator& taggregator, FragmentState* state, PlanNode* pnode) {
+  RETURN_IF_ERROR(AggregatorConfig::Init(taggregator, state, pnode));
+  vector<SimpleAggFn> simple_agg_fns;
+  for (AggFn* agg_fn : aggregate_functions_) {
+    SimpleAggFn simple_fn;
+    if (!GetSimpleAggFn(state->desc_tbl(), *agg_fn, &simple_fn)) return Status::OK();
+    simple_agg_fns.push_back(simple_fn);
+  }
+  simple_agg_fns_ = move(simple_agg_fns);
+  return Status::OK();
+}
+
+static bool IsFixedWidthNumericType(PrimitiveType type) {
+  switch (type) {
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool NonGroupingAggregatorConfig::GetSimpleAggFn(const DescriptorTbl& desc_tbl,
+    const AggFn& agg_fn, SimpleAggFn* simple_fn) const {
+  const SlotDescriptor& dst_slot_desc = agg_fn.intermediate_slot_desc();
+  simple_fn->dst_offset = dst_slot_desc.tuple_offset();
+  simple_fn->dst_null_indicator_offset = dst_slot_desc.null_indicator_offset();
+  if (agg_fn.is_count_star()) {
+    simple_fn->op = SimpleAggFn::COUNT_STAR;
+    return true;
+  }
+  // The frontend wraps inputs of other types in casts, and those take the regular path.
+  if (agg_fn.GetNumChildren() != 1 || !agg_fn.GetChild(0)->IsSlotRef()) return false;
+  const SlotDescriptor* slot_desc = desc_tbl.GetSlotDescriptor(
+      static_cast<const SlotRef*>(agg_fn.GetChild(0))->slot_id());
+  if (slot_desc == nullptr) return false;
+  simple_fn->type = slot_desc->type().type;
+  simple_fn->tuple_idx = input_row_desc_.GetTupleIdx(slot_desc->parent()->id());
+  if (simple_fn->tuple_idx == RowDescriptor::INVALID_IDX) return false;
+  simple_fn->slot_offset = slot_desc->tuple_offset();
+  simple_fn->null_indicator_offset = slot_desc->null_indicator_offset();
+
+  const PrimitiveType type = simple_fn->type;
+  const PrimitiveType dst_type = agg_fn.intermediate_type().type;
+  switch (agg_fn.agg_op()) {
+    case AggFn::COUNT:
+      if (agg_fn.is_merge()) {
+        simple_fn->op = SimpleAggFn::SUM;
+        return type == TYPE_BIGINT && dst_type == TYPE_BIGINT;
+      }
+      simple_fn->op = SimpleAggFn::COUNT;
+      return dst_type == TYPE_BIGINT;
+    case AggFn::SUM:
+      simple_fn->op = SimpleAggFn::SUM;
+      return (type == TYPE_BIGINT || type == TYPE_DOUBLE) && dst_type == type;
+    case AggFn::MIN:
+    case AggFn::MAX:
+      simple_fn->op = agg_fn.agg_op() == AggFn::MIN ? SimpleAggFn::MIN : SimpleAggFn::MAX;
+      return IsFixedWidthNumericType(type) && dst_type == type;
+    case AggFn::AVG:
+      // The intermediate value is the AvgState of AggregateFunctions::AvgUpdate().
+      simple_fn->op = SimpleAggFn::AVG;
+      return !agg_fn.is_merge() && (type == TYPE_BIGINT || type == TYPE_DOUBLE)
+          && dst_type == TYPE_FIXED_UDA_INTERMEDIATE
+          && dst_slot_desc.slot_size() == sizeof(double) + sizeof(int64_t);
+    default:
+      return false;
+  }
+}
+
 void NonGroupingAggregatorConfig::Codegen(FragmentState* state) {
   LlvmCodeGen* codegen = state->codegen();
   DCHECK(codegen != nullptr);
@@ -53,11 +132,15 @@ NonGroupingAggregator::NonGroupingAggregator(
     ExecNode* exec_node, ObjectPool* pool, const NonGroupingAggregatorConfig& config)
   : Aggregator(
         exec_node, pool, config, Substitute("NonGroupingAggregator $0", config.agg_idx_)),
-    add_batch_impl_fn_(config.add_batch_impl_fn_) {}
+    add_batch_impl_fn_(config.add_batch_impl_fn_),
+    simple_agg_fns_(config.simple_agg_fns_) {}
 
 Status NonGroupingAggregator::Prepare(RuntimeState* state) {
   RETURN_IF_ERROR(Aggregator::Prepare(state));
   singleton_tuple_pool_.reset(new MemPool(mem_tracker_.get()));
+  if (!simple_agg_fns_.empty()) {
+    runtime_profile()->AppendExecOption("Simple Aggregate Functions");
+  }
   return Status::OK();
 }
 
@@ -71,6 +154,10 @@ Status NonGroupingAggregator::Open(RuntimeState* state) {
   // Check for failures during AggFnEvaluator::Init().
   RETURN_IF_ERROR(state->GetQueryStatus());
   singleton_output_tuple_returned_ = false;
+  has_batch_update_agg_fns_ = false;
+  for (AggFnEvaluator* eval : agg_fn_evals_) {
+    has_batch_update_agg_fns_ |= eval->HasBatchUpdate();
+  }
 
   return Status::OK();
 }
@@ -125,6 +212,14 @@ Status NonGroupingAggregator::AddBatch(RuntimeState* state, RowBatch* batch) {
   SCOPED_TIMER(build_timer_);
   RETURN_IF_ERROR(QueryMaintenance(state));
 
+  if (!simple_agg_fns_.empty()) {
+    AddBatchSimpleAggFns(batch);
+    return Status::OK();
+  }
+  if (has_batch_update_agg_fns_) {
+    AddBatchWithBatchUpdates(batch);
+    return Status::OK();
+  }
   NonGroupingAggregatorConfig::AddBatchImplFn add_batch_impl_fn
       = add_batch_impl_fn_.load();
   if (add_batch_impl_fn != nullptr) {
@@ -136,6 +231,155 @@ Status NonGroupingAggregator::AddBatch(RuntimeState* state, RowBatch* batch) {
   return Status::OK();
 }
 
+/// Sets 'val' to the input slot of 'fn' in 'row'. Returns false if it is NULL.
+template <typename T>
+static inline bool GetSimpleAggInput(const SimpleAggFn& fn, TupleRow* row, T* val) {
+  const Tuple* tuple = row->GetTuple(fn.tuple_idx);
+  if (tuple == nullptr || tuple->IsNull(fn.null_indicator_offset)) return false;
+  *val = *reinterpret_cast<const T*>(tuple->GetSlot(fn.slot_offset));
+  return true;
+}
+
+static void UpdateSimpleCount(const SimpleAggFn& fn, RowBatch* batch, Tuple* dst) {
+  int64_t count = 0;
+  FOREACH_ROW(batch, 0, batch_iter) {
+    const Tuple* tuple = batch_iter.Get()->GetTuple(fn.tuple_idx);
+    count += tuple != nullptr && !tuple->IsNull(fn.null_indicator_offset);
+  }
+  *dst->GetBigIntSlot(fn.dst_offset) += count;
+}
+
+template <typename T>
+static void UpdateSimpleSum(const SimpleAggFn& fn, RowBatch* batch, Tuple* dst) {
+  T* dst_val = reinterpret_cast<T*>(dst->GetSlot(fn.dst_offset));
+  bool is_null = dst->IsNull(fn.dst_null_indicator_offset);
+  // Add the values in row order, so that floating point sums are the same as with
+  // AggregateFunctions::Sum().
+  T sum = is_null ? 0 : *dst_val;
+  FOREACH_ROW(batch, 0, batch_iter) {
+    T val;
+    if (!GetSimpleAggInput(fn, batch_iter.Get(), &val)) continue;
+    sum += val;
+    is_null = false;
+  }
+  if (is_null) return;
+  *dst_val = sum;
+  dst->SetNotNull(fn.dst_null_indicator_offset);
+}
+
+/// Same as AggregateFunctions::Min() and AggregateFunctions::Max(), including their
+/// handling of NaN.
+template <typename T, bool IS_MIN>
+static void UpdateSimpleMinMax(const SimpleAggFn& fn, RowBatch* batch, Tuple* dst) {
+  T* dst_val = reinterpret_cast<T*>(dst->GetSlot(fn.dst_offset));
+  bool is_null = dst->IsNull(fn.dst_null_indicator_offset);
+  T result = *dst_val;
+  FOREACH_ROW(batch, 0, batch_iter) {
+    T val;
+    if (!GetSimpleAggInput(fn, batch_iter.Get(), &val)) continue;
+    if (is_null || (IS_MIN ? val < result : val > result)
+        || (std::is_floating_point<T>::value && std::isnan(val))) {
+      result = val;
+      is_null = false;
+    }
+  }
+  if (is_null) return;
+  *dst_val = result;
+  dst->SetNotNull(fn.dst_null_indicator_offset);
+}
+
+/// Same as AggregateFunctions::AvgUpdate().
+template <typename T>
+static void UpdateSimpleAvg(const SimpleAggFn& fn, RowBatch* batch, Tuple* dst) {
+  double* sum = reinterpret_cast<double*>(dst->GetSlot(fn.dst_offset));
+  int64_t* count = reinterpret_cast<int64_t*>(sum + 1);
+  double sum_val = *sum;
+  int64_t count_val = 0;
+  FOREACH_ROW(batch, 0, batch_iter) {
+    T val;
+    if (!GetSimpleAggInput(fn, batch_iter.Get(), &val)) continue;
+    sum_val += val;
+    ++count_val;
+  }
+  if (count_val == 0) return;
+  *sum = sum_val;
+  *count += count_val;
+  dst->SetNotNull(fn.dst_null_indicator_offset);
+}
+
+template <bool IS_MIN>
+static void UpdateSimpleMinOrMax(const SimpleAggFn& fn, RowBatch* batch, Tuple* dst) {
+  switch (fn.type) {
+    case TYPE_TINYINT:
+      UpdateSimpleMinMax<int8_t, IS_MIN>(fn, batch, dst);
+      break;
+    case TYPE_SMALLINT:
+      UpdateSimpleMinMax<int16_t, IS_MIN>(fn, batch, dst);
+      break;
+    case TYPE_INT:
+      UpdateSimpleMinMax<int32_t, IS_MIN>(fn, batch, dst);
+      break;
+    case TYPE_BIGINT:
+      UpdateSimpleMinMax<int64_t, IS_MIN>(fn, batch, dst);
+      break;
+    case TYPE_FLOAT:
+      UpdateSimpleMinMax<float, IS_MIN>(fn, batch, dst);
+      break;
+    case TYPE_DOUBLE:
+      UpdateSimpleMinMax<double, IS_MIN>(fn, batch, dst);
+      break;
+    default:
+      DCHECK(false) << fn.type;
+  }
+}
+
+void NonGroupingAggregator::AddBatchSimpleAggFns(RowBatch* batch) {
+  Tuple* dst = singleton_output_tuple_;
+  for (const SimpleAggFn& fn : simple_agg_fns_) {
+    switch (fn.op) {
+      case SimpleAggFn::COUNT_STAR:
+        *dst->GetBigIntSlot(fn.dst_offset) += batch->num_rows();
+        break;
+      case SimpleAggFn::COUNT:
+        UpdateSimpleCount(fn, batch, dst);
+        break;
+      case SimpleAggFn::SUM:
+        if (fn.type == TYPE_BIGINT) {
+          UpdateSimpleSum<int64_t>(fn, batch, dst);
+        } else {
+          UpdateSimpleSum<double>(fn, batch, dst);
+        }
+        break;
+      case SimpleAggFn::MIN:
+        UpdateSimpleMinOrMax<true>(fn, batch, dst);
+        break;
+      case SimpleAggFn::MAX:
+        UpdateSimpleMinOrMax<false>(fn, batch, dst);
+        break;
+      case SimpleAggFn::AVG:
+        if (fn.type == TYPE_BIGINT) {
+          UpdateSimpleAvg<int64_t>(fn, batch, dst);
+        } else {
+          UpdateSimpleAvg<double>(fn, batch, dst);
+        }
+        break;
+    }
+  }
+}
+
+void NonGroupingAggregator::AddBatchWithBatchUpdates(RowBatch* batch) {
+  Tuple* dst = singleton_output_tuple_;
+  for (AggFnEvaluator* eval : agg_fn_evals_) {
+    if (eval->HasBatchUpdate()) {
+      eval->AddBatch(batch, dst);
+      continue;
+    }
+    FOREACH_ROW(batch, 0, batch_iter) {
+      eval->Add(batch_iter.Get(), dst);
+    }
+  }
+}
+
 Status NonGroupingAggregator::AddBatchStreaming(
     RuntimeState* state, RowBatch* out_batch, RowBatch* child_batch, bool* eos) {
   *eos = true;
@@ -23,10 +23,12 @@
 
 #include "codegen/codegen-fn-ptr.h"
 #include "exec/aggregator.h"
+#include "runtime/descriptors.h"
 #include "runtime/mem-pool.h"
 
 namespace impala {
 
+class AggFn;
 class AggFnEvaluator;
 class AggregationPlanNode;
 class DescriptorTbl;
@@ -40,10 +42,43 @@ class RuntimeState;
 class TAggregator;
 class Tuple;
 
+/// A builtin aggregate function that NonGroupingAggregator computes directly from the
+/// slots of the input rows, one function at a time over a whole batch, rather than
+/// calling UpdateTuple() for every row. These are COUNT(*), and COUNT, SUM, MIN, MAX or
+/// AVG of a slot of a fixed width numeric type.
+struct SimpleAggFn {
+  enum Op {
+    COUNT_STAR,
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG,
+  };
+
+  /// The merge of a COUNT is a SUM.
+  Op op;
+
+  /// Type of the input slot. Unused for COUNT_STAR.
+  PrimitiveType type = INVALID_TYPE;
+
+  /// Index of the input slot's tuple in the input row, its offset and its null
+  /// indicator. Unused for COUNT_STAR.
+  int tuple_idx = -1;
+  int slot_offset = 0;
+  NullIndicatorOffset null_indicator_offset;
+
+  /// Offset and null indicator of the slot in the intermediate tuple.
+  int dst_offset = 0;
+  NullIndicatorOffset dst_null_indicator_offset;
+};
+
 class NonGroupingAggregatorConfig : public AggregatorConfig {
  public:
   NonGroupingAggregatorConfig(const TAggregator& taggregator, FragmentState* state,
       PlanNode* pnode, int agg_idx);
+  Status Init(const TAggregator& taggregator, FragmentState* state,
+      PlanNode* pnode) override WARN_UNUSED_RESULT;
   void Codegen(FragmentState* state) override;
   ~NonGroupingAggregatorConfig() override {}
 
@@ -53,7 +88,15 @@ class NonGroupingAggregatorConfig : public AggregatorConfig {
 
   int GetNumGroupingExprs() const override { return 0; }
 
+  /// The aggregate functions as SimpleAggFns. Empty unless all of the aggregate
+  /// functions are simple.
+  std::vector<SimpleAggFn> simple_agg_fns_;
+
  private:
+  /// Returns true and sets 'simple_fn' if 'agg_fn' is a simple aggregate function.
+  bool GetSimpleAggFn(const DescriptorTbl& desc_tbl, const AggFn& agg_fn,
+      SimpleAggFn* simple_fn) const;
+
   /// Codegen the non-streaming add row batch loop in NonGroupingAggregator::AddBatch()
   /// (Assuming AGGREGATED_ROWS = false). The loop has already been compiled to IR and
   /// loaded into the codegen object. UpdateAggTuple has also been codegen'd to IR. This
@@ -107,6 +150,10 @@ class NonGroupingAggregator : public Aggregator {
   /// Jitted AddBatchImpl function pointer. Null if codegen is disabled.
   const CodegenFnPtr<NonGroupingAggregatorConfig::AddBatchImplFn>& add_batch_impl_fn_;
 
+  /// If non-empty, all aggregate functions are simple and AddBatch() calls
+  /// AddBatchSimpleAggFns().
+  const std::vector<SimpleAggFn>& simple_agg_fns_;
+
   /////////////////////////////////////////
   /// BEGIN: Members that must be Reset()
 
@@ -116,6 +163,11 @@ class NonGroupingAggregator : public Aggregator {
   Tuple* singleton_output_tuple_ = nullptr;
   bool singleton_output_tuple_returned_ = true;
 
+  /// True if any of the aggregate functions registered a batch update function when
+  /// 'singleton_output_tuple_' was initialized. AddBatch() then calls
+  /// AddBatchWithBatchUpdates().
+  bool has_batch_update_agg_fns_ = false;
+
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
@@ -127,6 +179,13 @@ class NonGroupingAggregator : public Aggregator {
   /// This function is replaced by codegen.
   Status AddBatchImpl(RowBatch* batch) WARN_UNUSED_RESULT;
 
+  /// Does the aggregation for all tuple rows in the batch with 'simple_agg_fns_'.
+  void AddBatchSimpleAggFns(RowBatch* batch);
+
+  /// Does the aggregation for all tuple rows in the batch one aggregate function at a
+  /// time, with a single call for the functions that have batch update functions.
+  void AddBatchWithBatchUpdates(RowBatch* batch);
+
   /// Output 'singleton_output_tuple_' and transfer memory to 'row_batch'.
   void GetSingletonOutput(RowBatch* row_batch);
 };
@@ -35,11 +35,48 @@ string PrintNode(const orc::Type* node) {
   return Substitute("$0 column (ORC id=$1)", node->toString(), node->getColumnId());
 }
 
+void OrcRowValidator::UpdateTransactionBatch(orc::LongVectorBatch* batch) {
+  write_ids_ = batch;
+  if (write_ids_ == nullptr || write_ids_->numElements == 0) {
+    batch_validity_ = ValidWriteIdList::ALL;
+    return;
+  }
+  const int64_t* data = write_ids_->data.data();
+  int64_t min_write_id = data[0];
+  int64_t max_write_id = data[0];
+  for (int i = 1; i < write_ids_->numElements; ++i) {
+    min_write_id = std::min(min_write_id, data[i]);
+    max_write_id = std::max(max_write_id, data[i]);
+  }
+  batch_validity_ = valid_write_ids_.IsWriteIdRangeValid(min_write_id, max_write_id);
+}
+
 bool OrcRowValidator::IsRowBatchValid() const {
-  if (write_ids_ == nullptr || write_ids_->numElements == 0) return true;
+  if (batch_validity_ != ValidWriteIdList::SOME) {
+    return batch_validity_ == ValidWriteIdList::ALL;
+  }
+  return valid_write_ids_.IsWriteIdValid(write_ids_->data[0]);
+}
 
-  int64_t write_id = write_ids_->data[0];
-  return valid_write_ids_.IsWriteIdValid(write_id);
+int OrcRowValidator::GetRowRun(int row_idx, int num_rows, bool* valid) const {
+  DCHECK_LT(row_idx, num_rows);
+  if (batch_validity_ != ValidWriteIdList::SOME) {
+    *valid = batch_validity_ == ValidWriteIdList::ALL;
+    return num_rows;
+  }
+  DCHECK_LE(num_rows, write_ids_->numElements);
+  const int64_t* data = write_ids_->data.data();
+  // Consecutive rows usually have the same write id, so the write ids are only looked
+  // up when they change.
+  int64_t write_id = data[row_idx];
+  *valid = valid_write_ids_.IsWriteIdValid(write_id);
+  int end = row_idx + 1;
+  for (; end < num_rows; ++end) {
+    if (data[end] == write_id) continue;
+    write_id = data[end];
+    if (valid_write_ids_.IsWriteIdValid(write_id) != *valid) break;
+  }
+  return end;
 }
 
 OrcColumnReader* OrcColumnReader::Create(const orc::Type* node,
@@ -161,8 +198,7 @@ Status OrcBoolColumnReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool)
 }
 
 Status OrcStringColumnReader::InitBlob(orc::DataBuffer<char>* blob, MemPool* pool) {
-  // TODO: IMPALA-9310: Possible improvement is moving the buffer out from orc::DataBuffer
-  // instead of copying and let Impala free the memory later.
+  orc_blob_ = blob->data();
   blob_ = reinterpret_cast<char*>(pool->TryAllocateUnaligned(blob->size()));
   if (UNLIKELY(blob_ == nullptr)) {
     string details = Substitute("Could not allocate string buffer of $0 bytes "
@@ -174,6 +210,25 @@ Status OrcStringColumnReader::InitBlob(orc::DataBuffer<char>* blob, MemPool* poo
   return Status::OK();
 }
 
+Status OrcStringColumnReader::AcquireBlob() {
+  char* data = batch_->blob.data();
+  if (data == nullptr) {
+    blob_ = nullptr;
+    orc_blob_ = nullptr;
+    return Status::OK();
+  }
+  if (!scanner_->reader_mem_pool_->TransferToMemPool(
+      data, scanner_->data_batch_pool_.get())) {
+    return InitBlob(&batch_->blob, scanner_->data_batch_pool_.get());
+  }
+  blob_ = data;
+  orc_blob_ = data;
+  // The moved-out buffer frees 'data' when it goes out of scope, which the ORC memory
+  // pool ignores since the memory was handed over.
+  orc::DataBuffer<char> detached_blob(std::move(batch_->blob));
+  return Status::OK();
+}
+
 Status OrcStringColumnReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool) {
   if (IsNull(DCHECK_NOTNULL(batch_), row_idx)) {
     SetNullSlot(tuple);
@@ -196,7 +251,7 @@ Status OrcStringColumnReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool
     src_len = offsets[index + 1] - offsets[index];
   } else {
     // The pointed data is now in blob_, a buffer handled by Impala.
-    src_ptr = blob_ + (batch_->data[row_idx] - batch_->blob.data());
+    src_ptr = blob_ + (batch_->data[row_idx] - orc_blob_);
     src_len = batch_->length[row_idx];
   }
   int dst_len = slot_desc_->type().len;
@@ -410,27 +465,50 @@ Status OrcStructReader::ReadValue(int row_idx, Tuple* tuple, MemPool* pool) {
 
 Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
     MemPool* pool) {
-  // Validate row batch if needed.
-  if (row_validator_) DCHECK(scanner_->row_batches_need_validation_);
-  if (row_validator_ && !row_validator_->IsRowBatchValid()) {
-    row_idx_ = NumElements();
-    return Status::OK();
-  }
   // Saving the initial value of num_tuples because each child->ReadValueBatch() will
   // update it.
   int scratch_batch_idx = scratch_batch->num_tuples;
+  // End of the rows of the batch to read in this call.
+  int end_row_idx = NumElements();
+  // Validate row batch if needed.
+  if (row_validator_) {
+    DCHECK(scanner_->row_batches_need_validation_);
+    if (MaterializeTuple()) {
+      // Only read the run of valid rows starting at 'row_idx_', or skip the run of
+      // invalid rows.
+      bool valid;
+      end_row_idx = row_validator_->GetRowRun(row_idx_, end_row_idx, &valid);
+      if (!valid) {
+        row_idx_ = end_row_idx;
+        return Status::OK();
+      }
+    } else if (!row_validator_->IsRowBatchValid()) {
+      // The rows of the items of collections are not aligned with the write ids of the
+      // batch, so the batch is validated by its first row.
+      row_idx_ = NumElements();
+      return Status::OK();
+    }
+  }
+  // Limit the children to the valid rows.
+  int capacity = scratch_batch->capacity;
+  scratch_batch->capacity =
+      std::min<int64_t>(capacity, scratch_batch_idx + end_row_idx - row_idx_);
+  Status status;
   int item_count = -1;
   for (OrcColumnReader* child : children_) {
-    RETURN_IF_ERROR(
-        child->ReadValueBatch(row_idx_, scratch_batch, pool, scratch_batch_idx));
+    status = child->ReadValueBatch(row_idx_, scratch_batch, pool, scratch_batch_idx);
+    if (UNLIKELY(!status.ok())) break;
     // Check if each column reader reads the same amount of values.
     if (item_count == -1) item_count = scratch_batch->num_tuples;
     if (item_count != scratch_batch->num_tuples) {
-      return Status(Substitute("Corrupt ORC file '$0':  Expected number of items in "
+      status = Status(Substitute("Corrupt ORC file '$0':  Expected number of items in "
           "each column: $1 Actual number in col '$2': $3", scanner_->filename(),
           item_count, orc_column_id_, scratch_batch->num_tuples));
+      break;
     }
   }
+  scratch_batch->capacity = capacity;
+  RETURN_IF_ERROR(status);
   int num_rows_read = scratch_batch->num_tuples - scratch_batch_idx;
   if (children_.empty()) {
     // We allow empty 'children_' for original files, because we might select the
@@ -447,7 +525,7 @@ Status OrcStructReader::TopLevelReadValueBatch(ScratchTupleBatch* scratch_batch,
     }
     DCHECK_EQ(0, num_rows_read);
     num_rows_read = std::min(scratch_batch->capacity - scratch_batch->num_tuples,
-                             NumElements() - row_idx_);
+                             end_row_idx - row_idx_);
     scratch_batch->num_tuples += num_rows_read;
   }
   if (scanner_->acid_synthetic_rowid_ != nullptr) {
@@ -501,8 +579,8 @@ Status OrcStructReader::UpdateInputBatch(orc::ColumnVectorBatch* orc_batch) {
         batch_->fields[current_write_id_field_index_];
     DCHECK_EQ(static_cast<orc::LongVectorBatch*>(write_id_batch),
               dynamic_cast<orc::LongVectorBatch*>(write_id_batch));
-    row_validator_->UpdateTransactionBatch(
-        static_cast<orc::LongVectorBatch*>(write_id_batch));
+    row_validator_->UpdateTransactionBatch(scanner_->stripe_rows_need_validation_ ?
+        static_cast<orc::LongVectorBatch*>(write_id_batch) : nullptr);
   }
   return Status::OK();
 }
@@ -28,19 +28,32 @@ namespace impala {
 
 class HdfsOrcScanner;
 
+/// Validates the rows of ORC batches against the valid write id list. The range of the
+/// write ids of every batch is checked first, so that the rows of batches whose write
+/// ids are all valid or all invalid don't need to be checked one by one.
 class OrcRowValidator {
  public:
   OrcRowValidator(const ValidWriteIdList& valid_write_ids) :
       valid_write_ids_(valid_write_ids) {}
 
-  void UpdateTransactionBatch(orc::LongVectorBatch* batch) {
-    write_ids_ = batch;
-  }
+  /// Sets the write ids of the rows of the next batch. 'batch' is nullptr if the rows of
+  /// the batch are known to be valid.
+  void UpdateTransactionBatch(orc::LongVectorBatch* batch);
 
+  /// Returns true if the first row of the batch is valid.
   bool IsRowBatchValid() const;
+
+  /// Returns the end of the run of rows starting at 'row_idx' that are either all valid
+  /// or all invalid, and sets 'valid' to whether they are valid. 'row_idx' must be less
+  /// than 'num_rows', the number of rows of the batch, which is the end of the last run.
+  int GetRowRun(int row_idx, int num_rows, bool* valid) const;
+
  private:
   const ValidWriteIdList& valid_write_ids_;
-  orc::LongVectorBatch* write_ids_;
+  orc::LongVectorBatch* write_ids_ = nullptr;
+
+  /// Whether none, some or all of the write ids of 'write_ids_' are valid.
+  ValidWriteIdList::RangeResponse batch_validity_ = ValidWriteIdList::ALL;
 };
 
 /// Base class for reading an ORC column. Each column reader will keep track of an
@@ -333,7 +346,7 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
     // through the whole stripe.
     if(!orc_batch->isEncoded) {
       DCHECK(batch_ == dynamic_cast<orc::StringVectorBatch*>(orc_batch));
-      return InitBlob(&batch_->blob, scanner_->data_batch_pool_.get());
+      return AcquireBlob();
     }
     DCHECK(static_cast<orc::EncodedStringVectorBatch*>(batch_) ==
         dynamic_cast<orc::EncodedStringVectorBatch*>(orc_batch));
@@ -352,9 +365,11 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
   friend class OrcPrimitiveColumnReader<OrcStringColumnReader>;
 
   orc::StringVectorBatch* batch_ = nullptr;
-  // We copy the blob from the batch, so the memory will be handled by Impala, and not
-  // by the ORC lib.
+  // The blob of the batch in memory handled by Impala, and not by the ORC lib. Either
+  // the ORC lib's buffer itself, see AcquireBlob(), or a copy of it.
   char* blob_ = nullptr;
+  // The start of the blob that the values of the batch point into.
+  const char* orc_blob_ = nullptr;
 
   // We cache the last stripe so we know when we have to update the blob (in case of
   // dictionary encoding).
@@ -364,6 +379,13 @@ class OrcStringColumnReader : public OrcPrimitiveColumnReader<OrcStringColumnRea
   /// Unfortunately, this cannot be done in UpdateInputBatch, since we do not have
   /// access to the pool there.
   Status InitBlob(orc::DataBuffer<char>* blob, MemPool* pool);
+
+  /// Takes over the blob of a non-encoded batch without copying it. Its buffer is
+  /// handed over to 'data_batch_pool_', which is attached to a row batch before the ORC
+  /// lib reads the next batch, and is moved out of the batch so that the ORC lib
+  /// allocates a new buffer instead of overwriting it. Falls back to InitBlob() if the
+  /// buffer cannot be handed over.
+  Status AcquireBlob();
 };
 
 class OrcTimestampReader : public OrcPrimitiveColumnReader<OrcTimestampReader> {
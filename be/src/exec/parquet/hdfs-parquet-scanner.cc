@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <queue>
 #include <stack>
+#include <unordered_set>
 
 #include <gflags/gflags.h>
 #include <gutil/strings/substitute.h>
@@ -29,9 +30,12 @@
 #include "exec/hdfs-scan-node.h"
 #include "exec/parquet/parquet-collection-column-reader.h"
 #include "exec/parquet/parquet-column-readers.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/scanner-context.inline.h"
 #include "exec/scratch-tuple-batch.h"
+#include "exprs/batch-conjunct-evaluator.h"
 #include "exprs/scalar-expr-evaluator.h"
+#include "exprs/slot-ref.h"
 #include "rpc/thrift-util.h"
 #include "runtime/collection-value-builder.h"
 #include "runtime/exec-env.h"
@@ -42,6 +46,8 @@
 #include "runtime/scoped-buffer.h"
 #include "service/hs2-util.h"
 #include "util/dict-encoding.h"
+#include "util/in-list-filter.h"
+#include "util/parquet-bloom-filter.h"
 #include "util/pretty-printer.h"
 #include "util/scope-exit-trigger.h"
 
@@ -110,6 +116,10 @@ HdfsParquetScanner::HdfsParquetScanner(HdfsScanNodeBase* scan_node, RuntimeState
 
 Status HdfsParquetScanner::Open(ScannerContext* context) {
   RETURN_IF_ERROR(HdfsScanner::Open(context));
+  if (state_->query_options().batch_conjunct_evaluation && !conjunct_evals_->empty()) {
+    RETURN_IF_ERROR(BatchConjunctEvaluator::Create(
+        state_, &obj_pool_, *conjunct_evals_, &batch_conjunct_eval_));
+  }
   metadata_range_ = stream_->scan_range();
   num_cols_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumColumns", TUnit::UNIT);
@@ -128,14 +138,37 @@ Status HdfsParquetScanner::Open(ScannerContext* context) {
           TUnit::UNIT);
   num_stats_filtered_pages_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumStatsFilteredPages", TUnit::UNIT);
+  num_late_materialization_skipped_rows_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumLateMaterializationSkippedRows", TUnit::UNIT);
+  late_materialization_skipped_bytes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "LateMaterializationSkippedBytes", TUnit::BYTES);
+  num_early_runtime_filtered_rows_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumEarlyRuntimeFilteredRows", TUnit::UNIT);
   num_minmax_filtered_pages_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumRuntimeFilteredPages", TUnit::UNIT);
   num_pages_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumPages", TUnit::UNIT);
+  num_position_deleted_rows_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumIcebergPositionDeletedRows", TUnit::UNIT);
+  RETURN_IF_ERROR(scan_node_->GetPositionDeletes(filename(), &position_deletes_));
+  num_unsampled_row_groups_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumUnsampledRowGroups", TUnit::UNIT);
   num_scanners_with_no_reads_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumScannersWithNoReads", TUnit::UNIT);
   num_dict_filtered_row_groups_counter_ =
       ADD_COUNTER(scan_node_->runtime_profile(), "NumDictFilteredRowGroups", TUnit::UNIT);
+  num_bloom_filtered_row_groups_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumBloomFilteredRowGroups", TUnit::UNIT);
+  num_coalesced_reads_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumCoalescedColumnChunkReads", TUnit::UNIT);
+  num_coalesced_column_chunks_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumCoalescedColumnChunks", TUnit::UNIT);
+  coalesced_gap_bytes_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "CoalescedColumnChunkGapBytes", TUnit::BYTES);
+  num_dict_code_filtered_values_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumDictCodeFilteredValues", TUnit::UNIT);
+  num_pages_decompressed_ahead_counter_ = ADD_COUNTER(
+      scan_node_->runtime_profile(), "NumPagesDecompressedAhead", TUnit::UNIT);
   process_footer_timer_stats_ =
       ADD_SUMMARY_STATS_TIMER(scan_node_->runtime_profile(), "FooterProcessingTime");
   parquet_compressed_page_size_counter_ = ADD_SUMMARY_STATS_COUNTER(
@@ -223,9 +256,107 @@ Status HdfsParquetScanner::Open(ScannerContext* context) {
   template_tuple_ = template_tuple_map_[scan_node_->tuple_desc()];
 
   RETURN_IF_ERROR(InitDictFilterStructures());
+  InitLateMaterialization();
   return Status::OK();
 }
 
+void HdfsParquetScanner::InitLateMaterialization() {
+  filter_readers_.clear();
+  non_filter_readers_.clear();
+  early_filter_slots_.clear();
+  conjunct_readers_.clear();
+  non_filter_slot_bytes_ = 0;
+  conjunct_slot_bytes_ = 0;
+  late_materialization_threshold_ =
+      state_->query_options().parquet_late_materialization_threshold;
+  if (late_materialization_threshold_ < 0) return;
+  if (scratch_batch_->tuple_byte_size == 0) return;
+  if (conjunct_evals_->empty() && filter_ctxs_.empty()) return;
+
+  std::unordered_set<SlotId> filter_slots;
+  vector<SlotId> slot_ids;
+  for (ScalarExprEvaluator* eval : *conjunct_evals_) eval->root().GetSlotIds(&slot_ids);
+  for (const FilterContext* ctx : filter_ctxs_) {
+    ctx->expr_eval->root().GetSlotIds(&slot_ids);
+  }
+  filter_slots.insert(slot_ids.begin(), slot_ids.end());
+
+  vector<ParquetColumnReader*> filter_readers;
+  vector<BaseScalarColumnReader*> non_filter_readers;
+  for (ParquetColumnReader* reader : column_readers_) {
+    // Nested data and counting readers are always read with the regular code path.
+    if (reader->IsCollectionReader() || reader->max_rep_level() > 0
+        || reader->slot_desc() == nullptr) {
+      return;
+    }
+    if (filter_slots.find(reader->slot_desc()->id()) != filter_slots.end()) {
+      filter_readers.push_back(reader);
+    } else {
+      non_filter_readers.push_back(static_cast<BaseScalarColumnReader*>(reader));
+    }
+  }
+  // Nothing to gain if the predicates only reference partition columns.
+  if (filter_readers.empty()) return;
+
+  // Split off the readers of the slots that are only referenced by conjuncts if the
+  // runtime filters can be evaluated on the other filter readers first.
+  vector<const SlotDescriptor*> early_filter_slots;
+  vector<BaseScalarColumnReader*> conjunct_readers;
+  if (state_->query_options().parquet_early_runtime_filtering
+      && GetEarlyRuntimeFilterSlots(filter_readers, &early_filter_slots)) {
+    vector<ParquetColumnReader*> key_readers;
+    for (ParquetColumnReader* reader : filter_readers) {
+      if (find(early_filter_slots.begin(), early_filter_slots.end(), reader->slot_desc())
+          != early_filter_slots.end()) {
+        key_readers.push_back(reader);
+      } else {
+        conjunct_readers.push_back(static_cast<BaseScalarColumnReader*>(reader));
+      }
+    }
+    filter_readers = move(key_readers);
+  }
+  // Nothing to gain if all columns are needed to evaluate the predicates.
+  if (non_filter_readers.empty() && conjunct_readers.empty()) return;
+
+  filter_readers_ = move(filter_readers);
+  non_filter_readers_ = move(non_filter_readers);
+  early_filter_slots_ = move(early_filter_slots);
+  conjunct_readers_ = move(conjunct_readers);
+  for (BaseScalarColumnReader* reader : non_filter_readers_) {
+    non_filter_slot_bytes_ += reader->slot_desc()->slot_size();
+  }
+  for (BaseScalarColumnReader* reader : conjunct_readers_) {
+    conjunct_slot_bytes_ += reader->slot_desc()->slot_size();
+  }
+  if (selection_batch_ == nullptr) {
+    selection_batch_.reset(new RowBatch(scan_node_->row_desc(),
+        scratch_batch_->capacity, scan_node_->mem_tracker()));
+  }
+}
+
+bool HdfsParquetScanner::GetEarlyRuntimeFilterSlots(
+    const vector<ParquetColumnReader*>& filter_readers,
+    vector<const SlotDescriptor*>* filter_slots) const {
+  filter_slots->clear();
+  if (filter_ctxs_.empty()) return false;
+  for (const FilterContext* ctx : filter_ctxs_) {
+    const ScalarExpr& root = ctx->expr_eval->root();
+    if (!root.IsSlotRef()) return false;
+    const SlotId slot_id = static_cast<const SlotRef&>(root).slot_id();
+    auto it = find_if(filter_readers.begin(), filter_readers.end(),
+        [slot_id](ParquetColumnReader* reader) {
+          return reader->slot_desc()->id() == slot_id;
+        });
+    if (it == filter_readers.end()) return false;
+    const SlotDescriptor* slot_desc = (*it)->slot_desc();
+    if (!slot_desc->type().IsIntegerType() || slot_desc->type() != root.type()) {
+      return false;
+    }
+    filter_slots->push_back(slot_desc);
+  }
+  return true;
+}
+
 void HdfsParquetScanner::Close(RowBatch* row_batch) {
   DCHECK(!is_closed_);
   if (row_batch != nullptr) {
@@ -240,6 +371,7 @@ void HdfsParquetScanner::Close(RowBatch* row_batch) {
     dictionary_pool_->FreeAll();
     context_->ReleaseCompletedResources(true);
     for (ParquetColumnReader* col_reader : column_readers_) col_reader->Close(nullptr);
+    FreeCoalescedChunkBuffers();
     // The scratch batch may still contain tuple data. We can get into this case if
     // Open() fails or if the query is cancelled.
     scratch_batch_->ReleaseResources(nullptr);
@@ -252,6 +384,7 @@ void HdfsParquetScanner::Close(RowBatch* row_batch) {
   // Verify all resources (if any) have been transferred.
   DCHECK_EQ(template_tuple_pool_->total_allocated_bytes(), 0);
   DCHECK_EQ(dictionary_pool_->total_allocated_bytes(), 0);
+  DCHECK(coalesced_chunk_buffers_.empty());
   DCHECK_EQ(scratch_batch_->total_allocated_bytes(), 0);
 
   // Collect compression types for reporting completed ranges.
@@ -406,6 +539,13 @@ Status HdfsParquetScanner::GetNextInternal(RowBatch* row_batch) {
       int64_t* dst_slot =
           dst_tuple->GetBigIntSlot(scan_node_->parquet_count_star_slot_offset());
       *dst_slot = file_metadata_.row_groups[row_group_idx_].num_rows;
+      if (position_deletes_ != nullptr) {
+        const int64_t first_row = GetRowGroupFirstRow(row_group_idx_);
+        const int64_t num_deleted =
+            NumPositionDeletedRows(first_row, first_row + *dst_slot - 1);
+        COUNTER_ADD(num_position_deleted_rows_counter_, num_deleted);
+        *dst_slot -= num_deleted;
+      }
       row_group_rows_read_ += *dst_slot;
       dst_row->SetTuple(0, dst_tuple);
       row_batch->CommitLastRow();
@@ -421,6 +561,29 @@ Status HdfsParquetScanner::GetNextInternal(RowBatch* row_batch) {
       eos_ = true;
       return Status::OK();
     }
+    if (row_group_rows_read_ == 0 &&
+        (position_deletes_ != nullptr || scan_node_->samples_units())) {
+      // The deleted rows and the rows of the row groups that are not sampled are counted
+      // as read, so that only the remaining rows are returned.
+      int64_t first_row = 0;
+      for (int i = 0; i < file_metadata_.row_groups.size(); ++i) {
+        const int64_t num_rows = file_metadata_.row_groups[i].num_rows;
+        if (scan_node_->samples_units() && !scan_node_->IsUnitSampled(filename(), i)) {
+          COUNTER_ADD(num_unsampled_row_groups_counter_, 1);
+          row_group_rows_read_ += num_rows;
+        } else if (position_deletes_ != nullptr && num_rows > 0) {
+          const int64_t num_deleted =
+              NumPositionDeletedRows(first_row, first_row + num_rows - 1);
+          COUNTER_ADD(num_position_deleted_rows_counter_, num_deleted);
+          row_group_rows_read_ += num_deleted;
+        }
+        first_row += num_rows;
+      }
+      if (row_group_rows_read_ >= file_metadata_.num_rows) {
+        eos_ = true;
+        return Status::OK();
+      }
+    }
     assemble_rows_timer_.Start();
     DCHECK_LE(row_group_rows_read_, file_metadata_.num_rows);
     int64_t rows_remaining = file_metadata_.num_rows - row_group_rows_read_;
@@ -628,6 +791,52 @@ bool HdfsParquetScanner::FilterAlreadyDisabledOrOverlapWithColumnStats(
   return false;
 }
 
+Status HdfsParquetScanner::EvaluateInListFiltersForRowGroup(
+    const parquet::FileMetaData& file_metadata, const parquet::RowGroup& row_group,
+    bool* skip_row_group) {
+  *skip_row_group = false;
+  if (!state_->query_options().parquet_read_statistics) return Status::OK();
+  const TupleDescriptor* tuple_desc = scan_node_->tuple_desc();
+  for (int i = 0; i < filter_ctxs_.size(); ++i) {
+    const FilterContext* ctx = filter_ctxs_[i];
+    if (!ctx->filter->is_in_list_filter() || !ctx->filter->HasFilter()) continue;
+    const InListFilter* in_list_filter = ctx->filter->get_in_list_filter();
+    if (in_list_filter == nullptr || in_list_filter->AlwaysTrue()
+        || in_list_filter->contains_null()) {
+      continue;
+    }
+    const ScalarExpr& root = ctx->expr_eval->root();
+    if (!root.IsSlotRef()) continue;
+    const SlotId slot_id = static_cast<const SlotRef&>(root).slot_id();
+    SlotDescriptor* slot_desc = nullptr;
+    for (SlotDescriptor* slot : tuple_desc->slots()) {
+      if (slot->id() == slot_id) slot_desc = slot;
+    }
+    if (slot_desc == nullptr || slot_desc->col_pos() < scan_node_->num_partition_keys()
+        || slot_desc->type().IsComplexType() || slot_desc->type() != root.type()) {
+      continue;
+    }
+
+    bool missing_field = false;
+    SchemaNode* node = nullptr;
+    RETURN_IF_ERROR(ResolveSchemaForStatFiltering(slot_desc, &missing_field, &node));
+    // The values of a missing column are NULL, which the filter rejects, but leave that
+    // to the row level evaluation.
+    if (missing_field) continue;
+    ColumnStatsReader stats_reader =
+        CreateStatsReader(file_metadata, row_group, node, slot_desc->type());
+    // Large enough for the slot of any type the filter supports.
+    int64_t min_slot[2];
+    int64_t max_slot[2];
+    static_assert(sizeof(min_slot) >= sizeof(StringValue), "Slot is too small");
+    if (!stats_reader.ReadMinMaxFromThrift(min_slot, max_slot)) continue;
+    *skip_row_group = !in_list_filter->HasValueInRange(min_slot, max_slot);
+    ctx->stats->IncrCounters(FilterStats::ROW_GROUPS_KEY, 1, 1, *skip_row_group);
+    if (*skip_row_group) break;
+  }
+  return Status::OK();
+}
+
 Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
     const parquet::FileMetaData& file_metadata, const parquet::RowGroup& row_group,
     bool* skip_row_group) {
@@ -780,6 +989,9 @@ Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
 }
 
 bool HdfsParquetScanner::ShouldProcessPageIndex() {
+  // The deleted rows are skipped with the page index, except for count(*), which
+  // subtracts them from the row counts of the row groups.
+  if (position_deletes_ != nullptr) return !scan_node_->optimize_parquet_count_star();
   if (!state_->query_options().parquet_read_page_index) return false;
   if (!min_max_conjunct_evals_.empty()) return true;
   for (auto desc : GetOverlapPredicateDescs()) {
@@ -846,6 +1058,13 @@ Status HdfsParquetScanner::NextRowGroup() {
       continue;
     }
 
+    // Row groups that are not in the sample are skipped without reading them.
+    if (scan_node_->samples_units() &&
+        !scan_node_->IsUnitSampled(filename(), row_group_idx_)) {
+      COUNTER_ADD(num_unsampled_row_groups_counter_, 1);
+      continue;
+    }
+
     COUNTER_ADD(num_row_groups_counter_, 1);
     if (!row_group.columns.empty() &&
         row_group.columns.front().__isset.offset_index_offset) {
@@ -870,10 +1089,21 @@ Status HdfsParquetScanner::NextRowGroup() {
       continue;
     }
 
+    // Evaluate row group statistics with IN-list filters.
+    bool skip_row_group_on_in_list;
+    RETURN_IF_ERROR(EvaluateInListFiltersForRowGroup(
+        file_metadata_, row_group, &skip_row_group_on_in_list));
+    if (skip_row_group_on_in_list) {
+      COUNTER_ADD(num_minmax_filtered_row_groups_counter_, 1);
+      continue;
+    }
+
     // Evaluate page index with min-max conjuncts and/or min/max overlap predicates.
     if (ShouldProcessPageIndex()) {
       Status page_index_status = ProcessPageIndex();
       if (!page_index_status.ok()) {
+        // Deleted rows would be returned without page filtering.
+        if (position_deletes_ != nullptr) return page_index_status;
         RETURN_IF_ERROR(state_->LogOrReturnError(page_index_status.msg()));
       }
       if (filter_pages_ && candidate_ranges_.empty()) {
@@ -888,6 +1118,18 @@ Status HdfsParquetScanner::NextRowGroup() {
       }
     }
 
+    // Probe the Bloom filters of the column chunks with the equality and IN predicates.
+    bool skip_row_group_on_bloom_filters;
+    Status bloom_filter_status = EvalBloomFilters(
+        row_group, file_desc->file_length, &skip_row_group_on_bloom_filters);
+    if (!bloom_filter_status.ok()) {
+      // Treat this like a missing filter unless errors must be reported.
+      RETURN_IF_ERROR(state_->LogOrReturnError(bloom_filter_status.msg()));
+    } else if (skip_row_group_on_bloom_filters) {
+      COUNTER_ADD(num_bloom_filtered_row_groups_counter_, 1);
+      continue;
+    }
+
     InitCollectionColumns();
     RETURN_IF_ERROR(InitScalarColumns());
 
@@ -1056,6 +1298,16 @@ Status HdfsParquetScanner::ProcessPageIndex() {
   single_process_page_index_timer.Start();
   ResetPageFiltering();
   RETURN_IF_ERROR(page_index_.ReadAll(row_group_idx_));
+  if (position_deletes_ != nullptr
+      && (page_index_.IsEmpty() || scalar_readers_.empty())) {
+    const parquet::RowGroup& row_group = file_metadata_.row_groups[row_group_idx_];
+    const int64_t first_row = GetRowGroupFirstRow(row_group_idx_);
+    if (NumPositionDeletedRows(first_row, first_row + row_group.num_rows - 1) > 0) {
+      return Status(Substitute("Cannot skip the rows of row group $0 of Parquet file "
+          "'$1' that Iceberg position delete files deleted: the row group has no page "
+          "index or the scan reads no column values.", row_group_idx_, filename()));
+    }
+  }
   if (page_index_.IsEmpty()) return Status::OK();
   // We can release the raw page index buffer when we exit this function.
   const auto scope_exit = MakeScopeExitTrigger([this](){page_index_.Release();});
@@ -1211,7 +1463,10 @@ Status HdfsParquetScanner::EvaluatePageIndex() {
   parquet::RowGroup& row_group = file_metadata_.row_groups[row_group_idx_];
   vector<RowRange> skip_ranges;
 
-  for (int i = 0; i < min_max_conjunct_evals_.size(); ++i) {
+  // The page index is also read to skip the rows deleted by Iceberg position deletes,
+  // in which case the statistics are only used if PARQUET_READ_PAGE_INDEX is true.
+  const bool filter_on_stats = state_->query_options().parquet_read_page_index;
+  for (int i = 0; filter_on_stats && i < min_max_conjunct_evals_.size(); ++i) {
     ScalarExprEvaluator* eval = min_max_conjunct_evals_[i];
     SlotDescriptor* slot_desc = scan_node_->min_max_tuple_desc()->slots()[i];
 
@@ -1264,11 +1519,17 @@ Status HdfsParquetScanner::EvaluatePageIndex() {
   }
 
   // On top of min/max conjuncts, apply min/max filters to filter out pages.
-  if (state_->query_options().minmax_filtering_level
+  if (filter_on_stats && state_->query_options().minmax_filtering_level
       != TMinmaxFilteringLevel::ROW_GROUP) {
     RETURN_IF_ERROR(FindSkipRangesForPagesWithMinMaxFilters(&skip_ranges));
   }
 
+  // Skip the rows that Iceberg position delete files deleted.
+  if (position_deletes_ != nullptr) {
+    COUNTER_ADD(num_position_deleted_rows_counter_,
+        AddPositionDeleteSkipRanges(&skip_ranges));
+  }
+
   if (skip_ranges.empty()) return Status::OK();
 
   for (BaseScalarColumnReader* scalar_reader : scalar_readers_) {
@@ -1326,6 +1587,8 @@ void HdfsParquetScanner::FlushRowGroupResources(RowBatch* row_batch) {
   context_->ReleaseCompletedResources(true);
   for (ParquetColumnReader* col_reader : column_readers_) col_reader->Close(row_batch);
   context_->ClearStreams();
+  // The column readers copy the data they return, so the buffers are not referenced.
+  FreeCoalescedChunkBuffers();
 }
 
 void HdfsParquetScanner::ReleaseSkippedRowGroupResources() {
@@ -1334,6 +1597,15 @@ void HdfsParquetScanner::ReleaseSkippedRowGroupResources() {
   context_->ReleaseCompletedResources(true);
   for (ParquetColumnReader* col_reader : column_readers_) col_reader->Close(nullptr);
   context_->ClearStreams();
+  FreeCoalescedChunkBuffers();
+}
+
+void HdfsParquetScanner::FreeCoalescedChunkBuffers() {
+  BufferPool* buffer_pool = ExecEnv::GetInstance()->buffer_pool();
+  for (BufferPool::BufferHandle& buffer : coalesced_chunk_buffers_) {
+    buffer_pool->FreeBuffer(context_->bp_client(), &buffer);
+  }
+  coalesced_chunk_buffers_.clear();
 }
 
 bool HdfsParquetScanner::IsDictFilterable(BaseScalarColumnReader* col_reader) {
@@ -1471,6 +1743,11 @@ Status HdfsParquetScanner::EvalDictionaryFilters(const parquet::RowGroup& row_gr
   *row_group_eliminated = false;
   // Check if there's anything to do here.
   if (dict_filterable_readers_.empty()) return Status::OK();
+  for (BaseScalarColumnReader* scalar_reader : dict_filterable_readers_) {
+    scalar_reader->use_dict_code_filter_ = false;
+  }
+  const bool dict_code_filtering =
+      state_->query_options().parquet_dictionary_code_filtering;
 
   // Legacy impala files (< 2.9) require special handling, because they do not encode
   // information about whether the column is 100% dictionary encoded.
@@ -1531,8 +1808,21 @@ Status HdfsParquetScanner::EvalDictionaryFilters(const parquet::RowGroup& row_gr
 
     DCHECK(dict_filter_tuple != nullptr);
     void* slot = dict_filter_tuple->GetSlot(slot_desc->tuple_offset());
-    bool column_has_match = false;
-    for (int dict_idx = 0; dict_idx < dictionary->num_entries(); ++dict_idx) {
+    // Check whether the result of the conjuncts for each dictionary entry can be used
+    // to filter the values of the column by their dictionary codes. The values that
+    // don't pass are materialized as NULL, so this is only correct for nullable
+    // top-level slots whose values are not converted or validated by the reader. It
+    // is also only worth it if the dictionary is smaller than the row group, because
+    // every entry needs to be evaluated.
+    const int num_entries = dictionary->num_entries();
+    const bool build_code_filter = dict_code_filtering
+        && scalar_reader->max_rep_level() == 0
+        && tuple_desc == scan_node_->tuple_desc() && slot_desc->is_nullable()
+        && !scalar_reader->NeedsConversion() && !scalar_reader->NeedsValidation()
+        && num_entries < row_group.num_rows;
+    if (build_code_filter) scalar_reader->dict_code_filter_.Reset(num_entries);
+    int num_matches = 0;
+    for (int dict_idx = 0; dict_idx < num_entries; ++dict_idx) {
       if (dict_idx % 1024 == 0) {
         // Don't let expr result allocations accumulate too much for large dictionaries or
         // many row groups.
@@ -1541,17 +1831,22 @@ Status HdfsParquetScanner::EvalDictionaryFilters(const parquet::RowGroup& row_gr
       dictionary->GetValue(dict_idx, slot);
 
       // We can only eliminate this row group if no value from the dictionary matches.
-      // If any dictionary value passes the conjuncts, then move on to the next column.
+      // If any dictionary value passes the conjuncts, then move on to the next column,
+      // unless the code filter needs the result for every entry.
       TupleRow row;
       row.SetTuple(0, dict_filter_tuple);
       if (ExecNode::EvalConjuncts(dict_filter_conjunct_evals.data(),
               dict_filter_conjunct_evals.size(), &row)) {
-        column_has_match = true;
-        break;
+        ++num_matches;
+        if (!build_code_filter) break;
+        scalar_reader->dict_code_filter_.Set(dict_idx, true);
       }
     }
     // Free all expr result allocations now that we're done with the filter.
     context_->expr_results_pool()->Clear();
+    bool column_has_match = num_matches > 0;
+    scalar_reader->use_dict_code_filter_ =
+        build_code_filter && column_has_match && num_matches < num_entries;
 
     if (!column_has_match) {
       // The column contains no value that matches the conjunct. The row group
@@ -1568,6 +1863,209 @@ Status HdfsParquetScanner::EvalDictionaryFilters(const parquet::RowGroup& row_gr
   return Status::OK();
 }
 
+Status HdfsParquetScanner::EvalBloomFilters(const parquet::RowGroup& row_group,
+    int64_t file_length, bool* skip_row_group) {
+  *skip_row_group = false;
+  if (!state_->query_options().parquet_bloom_filtering) return Status::OK();
+  if (conjunct_evals_ == nullptr || conjunct_evals_->empty()) return Status::OK();
+
+  ScopedBuffer filter_buffer(scan_node_->mem_tracker());
+  vector<uint64_t> hashes;
+  for (BaseScalarColumnReader* scalar_reader : scalar_readers_) {
+    const SlotDescriptor* slot_desc = scalar_reader->slot_desc();
+    if (slot_desc == nullptr || slot_desc->parent() != scan_node_->tuple_desc()) continue;
+    const parquet::ColumnChunk& col_chunk = row_group.columns[scalar_reader->col_idx()];
+    if (!col_chunk.meta_data.__isset.bloom_filter_offset) continue;
+
+    // The filter is read lazily, once the first usable conjunct is found.
+    ParquetBloomFilter filter;
+    bool filter_read = false;
+    for (ScalarExprEvaluator* conjunct : *conjunct_evals_) {
+      hashes.clear();
+      if (!GetBloomFilterProbeHashes(conjunct, scalar_reader, &hashes)) continue;
+      if (!filter_read) {
+        filter_buffer.Release();
+        RETURN_IF_ERROR(ReadBloomFilter(col_chunk, file_length, &filter_buffer, &filter));
+        filter_read = true;
+      }
+      bool any_found = false;
+      for (uint64_t hash : hashes) {
+        if (filter.Find(hash)) {
+          any_found = true;
+          break;
+        }
+      }
+      if (!any_found) {
+        *skip_row_group = true;
+        return Status::OK();
+      }
+    }
+  }
+  return Status::OK();
+}
+
+bool HdfsParquetScanner::GetBloomFilterProbeHashes(ScalarExprEvaluator* conjunct,
+    const BaseScalarColumnReader* reader, vector<uint64_t>* hashes) {
+  const ScalarExpr& root = conjunct->root();
+  const string& fn_name = root.function_name();
+  if (fn_name != "eq" && fn_name != "in_iterate" && fn_name != "in_set_lookup") {
+    return false;
+  }
+  if (root.GetNumChildren() < 2) return false;
+  // Binary predicates may have the slot on either side, IN predicates have it first.
+  int slot_child = 0;
+  if (fn_name == "eq" && !root.GetChild(0)->IsSlotRef()) slot_child = 1;
+  const ScalarExpr* slot_expr = root.GetChild(slot_child);
+  if (!slot_expr->IsSlotRef()) return false;
+  const SlotDescriptor* slot_desc = reader->slot_desc();
+  if (static_cast<const SlotRef*>(slot_expr)->slot_id() != slot_desc->id()) return false;
+
+  // Only types whose slot value is the PLAIN encoded value of the column are supported.
+  // Readers that convert or validate values may map several encoded values to the same
+  // slot value.
+  BaseScalarColumnReader* mutable_reader = const_cast<BaseScalarColumnReader*>(reader);
+  if (mutable_reader->NeedsConversion() || mutable_reader->NeedsValidation()) {
+    return false;
+  }
+  const parquet::SchemaElement& element = reader->schema_element();
+  if (element.__isset.converted_type
+      && (element.converted_type == parquet::ConvertedType::UINT_8
+          || element.converted_type == parquet::ConvertedType::UINT_16
+          || element.converted_type == parquet::ConvertedType::UINT_32
+          || element.converted_type == parquet::ConvertedType::UINT_64)) {
+    return false;
+  }
+  const PrimitiveType slot_type = slot_desc->type().type;
+  switch (slot_type) {
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+      if (element.type != parquet::Type::INT32) return false;
+      break;
+    case TYPE_BIGINT:
+      if (element.type != parquet::Type::INT64) return false;
+      break;
+    case TYPE_STRING:
+      if (element.type != parquet::Type::BYTE_ARRAY) return false;
+      break;
+    default:
+      return false;
+  }
+
+  for (int i = 0; i < root.GetNumChildren(); ++i) {
+    if (i == slot_child) continue;
+    const ScalarExpr* literal = root.GetChild(i);
+    if (!literal->IsLiteral() || literal->type().type != slot_type) return false;
+    void* value = conjunct->GetValue(*literal, nullptr);
+    if (value == nullptr) return false;
+    switch (slot_type) {
+      case TYPE_TINYINT: {
+        int32_t v = *reinterpret_cast<int8_t*>(value);
+        hashes->push_back(ParquetBloomFilter::Hash(&v, sizeof(v)));
+        break;
+      }
+      case TYPE_SMALLINT: {
+        int32_t v = *reinterpret_cast<int16_t*>(value);
+        hashes->push_back(ParquetBloomFilter::Hash(&v, sizeof(v)));
+        break;
+      }
+      case TYPE_INT:
+        hashes->push_back(ParquetBloomFilter::Hash(value, sizeof(int32_t)));
+        break;
+      case TYPE_BIGINT:
+        hashes->push_back(ParquetBloomFilter::Hash(value, sizeof(int64_t)));
+        break;
+      case TYPE_STRING: {
+        const StringValue* sv = reinterpret_cast<StringValue*>(value);
+        hashes->push_back(ParquetBloomFilter::Hash(sv->ptr, sv->len));
+        break;
+      }
+      default:
+        DCHECK(false);
+    }
+  }
+  return !hashes->empty();
+}
+
+Status HdfsParquetScanner::ReadBloomFilter(const parquet::ColumnChunk& col_chunk,
+    int64_t file_length, ScopedBuffer* buffer, ParquetBloomFilter* filter) {
+  // Large enough for any BloomFilterHeader written with the compact protocol.
+  const int64_t MAX_HEADER_SIZE = 128;
+  const parquet::ColumnMetaData& col_metadata = col_chunk.meta_data;
+  const int64_t offset = col_metadata.bloom_filter_offset;
+  if (offset < 0 || offset >= file_length) {
+    return Status(Substitute("Invalid Bloom filter offset $0 in file '$1'.",
+        offset, filename()));
+  }
+  // Read the header and, if the total length is known, the bitset with a single I/O.
+  int64_t read_size = min(MAX_HEADER_SIZE, file_length - offset);
+  if (col_metadata.__isset.bloom_filter_length) {
+    read_size = col_metadata.bloom_filter_length;
+    if (read_size <= 0 || read_size > file_length - offset) {
+      return Status(Substitute("Invalid Bloom filter length $0 in file '$1'.",
+          read_size, filename()));
+    }
+  }
+  if (!buffer->TryAllocate(read_size)) {
+    string details = Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "ReadBloomFilter",
+        read_size, "Bloom filter");
+    return scan_node_->mem_tracker()->MemLimitExceeded(state_, details, read_size);
+  }
+  RETURN_IF_ERROR(ReadFileRange(offset, read_size, buffer->buffer()));
+
+  parquet::BloomFilterHeader header;
+  uint32_t header_size = read_size;
+  RETURN_IF_ERROR(DeserializeThriftMsg(buffer->buffer(), &header_size, true, &header));
+  if (!header.algorithm.__isset.BLOCK || !header.hash.__isset.XXHASH
+      || !header.compression.__isset.UNCOMPRESSED) {
+    return Status(Substitute("Unsupported Bloom filter in file '$0'.", filename()));
+  }
+  const int64_t num_bytes = header.numBytes;
+  if (num_bytes < ParquetBloomFilter::MIN_BYTES
+      || num_bytes > ParquetBloomFilter::MAX_BYTES
+      || num_bytes > file_length - offset - header_size) {
+    return Status(Substitute("Invalid Bloom filter size $0 in file '$1'.",
+        num_bytes, filename()));
+  }
+  if (header_size + num_bytes <= read_size) {
+    return filter->Init(buffer->buffer() + header_size, num_bytes, false);
+  }
+  if (col_metadata.__isset.bloom_filter_length) {
+    return Status(Substitute("Bloom filter of $0 bytes does not fit its length $1 in "
+        "file '$2'.", num_bytes, read_size, filename()));
+  }
+  // The bitset was not covered by the first read.
+  buffer->Release();
+  if (!buffer->TryAllocate(num_bytes)) {
+    string details = Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "ReadBloomFilter",
+        num_bytes, "Bloom filter");
+    return scan_node_->mem_tracker()->MemLimitExceeded(state_, details, num_bytes);
+  }
+  RETURN_IF_ERROR(ReadFileRange(offset + header_size, num_bytes, buffer->buffer()));
+  return filter->Init(buffer->buffer(), num_bytes, false);
+}
+
+Status HdfsParquetScanner::ReadFileRange(int64_t offset, int64_t length,
+    uint8_t* buffer) {
+  int64_t partition_id = context_->partition_descriptor()->id();
+  int cache_options = metadata_range_->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
+  ScanRange* object_range = scan_node_->AllocateScanRange(metadata_range_->fs(),
+      filename(), length, offset, partition_id, metadata_range_->disk_id(),
+      metadata_range_->expected_local(), metadata_range_->mtime(),
+      BufferOpts::ReadInto(buffer, length, cache_options));
+  unique_ptr<BufferDescriptor> io_buffer;
+  bool needs_buffers;
+  RETURN_IF_ERROR(
+      scan_node_->reader_context()->StartScanRange(object_range, &needs_buffers));
+  DCHECK(!needs_buffers) << "Already provided a buffer";
+  RETURN_IF_ERROR(object_range->GetNext(&io_buffer));
+  DCHECK_EQ(io_buffer->buffer(), buffer);
+  DCHECK_EQ(io_buffer->len(), length);
+  DCHECK(io_buffer->eosr());
+  object_range->ReturnBuffer(move(io_buffer));
+  return Status::OK();
+}
+
 /// High-level steps of this function:
 /// 1. Allocate 'scratch' memory for tuples able to hold a full batch
 /// 2. Populate the slots of all scratch tuples one column reader at a time,
@@ -1588,45 +2086,19 @@ Status HdfsParquetScanner::AssembleRows(
   DCHECK_EQ(*skip_row_group, false);
   DCHECK(scratch_batch_ != nullptr);
 
+  const bool late_materialize = UseLateMaterialization();
   int64_t num_rows_read = 0;
   while (!column_readers[0]->RowGroupAtEnd()) {
     // Start a new scratch batch.
     RETURN_IF_ERROR(scratch_batch_->Reset(state_));
     InitTupleBuffer(template_tuple_, scratch_batch_->tuple_mem, scratch_batch_->capacity);
 
-    // Materialize the top-level slots into the scratch batch column-by-column.
-    int last_num_tuples = -1;
-    for (int c = 0; c < column_readers.size(); ++c) {
-      ParquetColumnReader* col_reader = column_readers[c];
-      bool continue_execution;
-      if (col_reader->max_rep_level() > 0) {
-        continue_execution = col_reader->ReadValueBatch(&scratch_batch_->aux_mem_pool,
-            scratch_batch_->capacity, tuple_byte_size_, scratch_batch_->tuple_mem,
-            &scratch_batch_->num_tuples);
-      } else {
-        continue_execution = col_reader->ReadNonRepeatedValueBatch(
-            &scratch_batch_->aux_mem_pool, scratch_batch_->capacity, tuple_byte_size_,
-            scratch_batch_->tuple_mem, &scratch_batch_->num_tuples);
-      }
-      // Check that all column readers populated the same number of values.
-      bool num_tuples_mismatch = c != 0 && last_num_tuples != scratch_batch_->num_tuples;
-      if (UNLIKELY(!continue_execution || num_tuples_mismatch)) {
-        // Skipping this row group. Free up all the resources with this row group.
-        FlushRowGroupResources(row_batch);
-        scratch_batch_->num_tuples = 0;
-        DCHECK(scratch_batch_->AtEnd());
-        *skip_row_group = true;
-        if (num_tuples_mismatch && continue_execution) {
-          Status err(Substitute("Corrupt Parquet file '$0': column '$1' "
-              "had $2 remaining values but expected $3", filename(),
-              col_reader->schema_element().name, last_num_tuples,
-              scratch_batch_->num_tuples));
-          parse_status_.MergeStatus(err);
-        }
-        return Status::OK();
-      }
-      last_num_tuples = scratch_batch_->num_tuples;
+    if (late_materialize) {
+      RETURN_IF_ERROR(FillScratchBatchLateMaterialized(row_batch, skip_row_group));
+    } else {
+      RETURN_IF_ERROR(FillScratchBatch(column_readers, row_batch, skip_row_group));
     }
+    if (*skip_row_group) return Status::OK();
     RETURN_IF_ERROR(CheckPageFiltering());
     num_rows_read += scratch_batch_->num_tuples;
     int num_row_to_commit = TransferScratchTuples(row_batch);
@@ -1638,6 +2110,158 @@ Status HdfsParquetScanner::AssembleRows(
   // Merge Scanner-local counter into HdfsScanNode counter and reset.
   COUNTER_ADD(scan_node_->collection_items_read_counter(), coll_items_read_counter_);
   coll_items_read_counter_ = 0;
+  for (BaseScalarColumnReader* scalar_reader : dict_filterable_readers_) {
+    COUNTER_ADD(num_dict_code_filtered_values_counter_,
+        scalar_reader->num_dict_code_filtered_values_);
+    scalar_reader->num_dict_code_filtered_values_ = 0;
+  }
+  return Status::OK();
+}
+
+Status HdfsParquetScanner::FillScratchBatch(
+    const vector<ParquetColumnReader*>& column_readers, RowBatch* row_batch,
+    bool* skip_row_group) {
+  // Materialize the top-level slots into the scratch batch column-by-column.
+  int last_num_tuples = -1;
+  for (int c = 0; c < column_readers.size(); ++c) {
+    ParquetColumnReader* col_reader = column_readers[c];
+    bool continue_execution;
+    if (col_reader->max_rep_level() > 0) {
+      continue_execution = col_reader->ReadValueBatch(&scratch_batch_->aux_mem_pool,
+          scratch_batch_->capacity, tuple_byte_size_, scratch_batch_->tuple_mem,
+          &scratch_batch_->num_tuples);
+    } else {
+      continue_execution = col_reader->ReadNonRepeatedValueBatch(
+          &scratch_batch_->aux_mem_pool, scratch_batch_->capacity, tuple_byte_size_,
+          scratch_batch_->tuple_mem, &scratch_batch_->num_tuples);
+    }
+    // Check that all column readers populated the same number of values.
+    bool num_tuples_mismatch = c != 0 && last_num_tuples != scratch_batch_->num_tuples;
+    if (UNLIKELY(!continue_execution || num_tuples_mismatch)) {
+      // Skipping this row group. Free up all the resources with this row group.
+      FlushRowGroupResources(row_batch);
+      scratch_batch_->num_tuples = 0;
+      DCHECK(scratch_batch_->AtEnd());
+      *skip_row_group = true;
+      if (num_tuples_mismatch && continue_execution) {
+        Status err(Substitute("Corrupt Parquet file '$0': column '$1' "
+            "had $2 remaining values but expected $3", filename(),
+            col_reader->schema_element().name, last_num_tuples,
+            scratch_batch_->num_tuples));
+        parse_status_.MergeStatus(err);
+      }
+      return Status::OK();
+    }
+    last_num_tuples = scratch_batch_->num_tuples;
+  }
+  return Status::OK();
+}
+
+Status HdfsParquetScanner::FillScratchBatchLateMaterialized(
+    RowBatch* row_batch, bool* skip_row_group) {
+  DCHECK(!filter_readers_.empty());
+  DCHECK(!non_filter_readers_.empty() || !conjunct_readers_.empty());
+  RETURN_IF_ERROR(FillScratchBatch(filter_readers_, row_batch, skip_row_group));
+  if (*skip_row_group) return Status::OK();
+  const int num_tuples = scratch_batch_->num_tuples;
+  bool at_end = filter_readers_[0]->RowGroupAtEnd();
+  // A batch can only be partially filled at the end of the row group.
+  DCHECK(!at_end || num_tuples < scratch_batch_->capacity);
+
+  if (!early_filter_slots_.empty()) {
+    // Apply the runtime filters on the decoded key columns, then read the rest of the
+    // predicate columns only for the rows that passed them.
+    int num_selected = 0;
+    if (num_tuples > 0) num_selected = FilterScratchBatchOnSlots(early_filter_slots_);
+    COUNTER_ADD(num_early_runtime_filtered_rows_counter_, num_tuples - num_selected);
+    int num_materialized = 0;
+    RETURN_IF_ERROR(ReadSelectedRows(conjunct_readers_, at_end, row_batch,
+        &num_materialized, skip_row_group));
+    if (*skip_row_group) return Status::OK();
+    COUNTER_ADD(late_materialization_skipped_bytes_counter_,
+        (num_tuples - num_materialized) * conjunct_slot_bytes_);
+    if (num_selected > 0 && !conjunct_evals_->empty()) FilterSelectedScratchTuples();
+  } else if (num_tuples > 0) {
+    FilterScratchBatch(selection_batch_.get());
+  }
+
+  int num_materialized = 0;
+  RETURN_IF_ERROR(ReadSelectedRows(non_filter_readers_, at_end, row_batch,
+      &num_materialized, skip_row_group));
+  if (*skip_row_group) return Status::OK();
+  const int64_t num_skipped_rows = num_tuples - num_materialized;
+  COUNTER_ADD(num_late_materialization_skipped_rows_counter_, num_skipped_rows);
+  COUNTER_ADD(late_materialization_skipped_bytes_counter_,
+      num_skipped_rows * non_filter_slot_bytes_);
+  return Status::OK();
+}
+
+Status HdfsParquetScanner::ReadSelectedRows(
+    const vector<BaseScalarColumnReader*>& readers, bool at_end, RowBatch* row_batch,
+    int* num_materialized, bool* skip_row_group) {
+  const int num_tuples = scratch_batch_->num_tuples;
+  *num_materialized = num_tuples;
+  if (readers.empty()) return Status::OK();
+  micro_batches_.clear();
+  if (scratch_batch_->has_selection) {
+    ScratchTupleBatch::GetMicroBatches(scratch_batch_->selected_rows.get(),
+        scratch_batch_->num_selected, late_materialization_threshold_, &micro_batches_);
+  } else if (num_tuples > 0) {
+    micro_batches_.push_back({0, num_tuples - 1});
+  }
+
+  *num_materialized = 0;
+  for (const ScratchMicroBatch& micro_batch : micro_batches_) {
+    *num_materialized += micro_batch.length();
+  }
+  for (BaseScalarColumnReader* col_reader : readers) {
+    bool continue_execution = true;
+    int num_values_read = 0;
+    int next_row = 0;
+    for (const ScratchMicroBatch& micro_batch : micro_batches_) {
+      if (micro_batch.start > next_row) {
+        continue_execution = col_reader->SkipRows(micro_batch.start - next_row);
+        if (UNLIKELY(!continue_execution)) break;
+      }
+      int num_values = 0;
+      continue_execution = col_reader->ReadNonRepeatedValueBatch(
+          &scratch_batch_->aux_mem_pool, micro_batch.length(), tuple_byte_size_,
+          scratch_batch_->tuple_mem + micro_batch.start * tuple_byte_size_,
+          &num_values);
+      num_values_read += num_values;
+      if (UNLIKELY(!continue_execution || num_values != micro_batch.length())) break;
+      next_row = micro_batch.end + 1;
+    }
+    if (continue_execution && num_values_read == *num_materialized
+        && num_tuples > next_row) {
+      continue_execution = col_reader->SkipRows(num_tuples - next_row);
+    }
+    if (continue_execution && num_values_read == *num_materialized && at_end) {
+      // Observe the end of the row group in this column too. There is room for at
+      // least one more tuple in the scratch batch, which must not get any value.
+      int num_values = 0;
+      continue_execution = col_reader->ReadNonRepeatedValueBatch(
+          &scratch_batch_->aux_mem_pool, 1, tuple_byte_size_,
+          scratch_batch_->tuple_mem + num_tuples * tuple_byte_size_, &num_values);
+      num_values_read += num_values;
+    }
+    bool num_values_mismatch = num_values_read != *num_materialized;
+    if (UNLIKELY(!continue_execution || num_values_mismatch)) {
+      FlushRowGroupResources(row_batch);
+      scratch_batch_->num_tuples = 0;
+      scratch_batch_->has_selection = false;
+      scratch_batch_->tuple_idx = 0;
+      DCHECK(scratch_batch_->AtEnd());
+      *skip_row_group = true;
+      if (num_values_mismatch && continue_execution) {
+        Status err(Substitute("Corrupt Parquet file '$0': column '$1' "
+            "had $2 remaining values but expected $3", filename(),
+            col_reader->schema_element().name, num_values_read, *num_materialized));
+        parse_status_.MergeStatus(err);
+      }
+      return Status::OK();
+    }
+  }
   return Status::OK();
 }
 
@@ -1675,6 +2299,40 @@ Status HdfsParquetScanner::CheckPageFiltering() {
   return Status::OK();
 }
 
+int64_t HdfsParquetScanner::GetRowGroupFirstRow(int row_group_idx) const {
+  int64_t first_row = 0;
+  for (int i = 0; i < row_group_idx; ++i) {
+    first_row += file_metadata_.row_groups[i].num_rows;
+  }
+  return first_row;
+}
+
+int64_t HdfsParquetScanner::NumPositionDeletedRows(int64_t first, int64_t last) const {
+  DCHECK(position_deletes_ != nullptr);
+  vector<pair<uint64_t, uint64_t>> runs;
+  position_deletes_->GetRuns(first, last, &runs);
+  int64_t num_deleted = 0;
+  for (const auto& run : runs) num_deleted += run.second - run.first + 1;
+  return num_deleted;
+}
+
+int64_t HdfsParquetScanner::AddPositionDeleteSkipRanges(vector<RowRange>* skip_ranges) {
+  DCHECK(position_deletes_ != nullptr);
+  const parquet::RowGroup& row_group = file_metadata_.row_groups[row_group_idx_];
+  const int64_t first_row = GetRowGroupFirstRow(row_group_idx_);
+  vector<pair<uint64_t, uint64_t>> runs;
+  position_deletes_->GetRuns(first_row, first_row + row_group.num_rows - 1, &runs);
+  int64_t num_deleted = 0;
+  for (const auto& run : runs) {
+    RowRange row_range;
+    row_range.first = run.first - first_row;
+    row_range.last = run.second - first_row;
+    skip_ranges->push_back(row_range);
+    num_deleted += run.second - run.first + 1;
+  }
+  return num_deleted;
+}
+
 Status HdfsParquetScanner::CommitRows(RowBatch* dst_batch, int num_rows) {
   DCHECK(dst_batch != nullptr);
   dst_batch->CommitRows(num_rows);
@@ -1799,7 +2457,7 @@ inline bool HdfsParquetScanner::ReadCollectionItem(
   return continue_execution;
 }
 
-Status HdfsParquetScanner::ProcessFooter() {
+Status HdfsParquetScanner::ReadFooter() {
   const int64_t file_len = stream_->file_desc()->file_length;
   const int64_t scan_range_len = stream_->scan_range()->len();
 
@@ -1909,6 +2567,19 @@ Status HdfsParquetScanner::ProcessFooter() {
         "at file offset $2, Error = $3.", filename(), file_len, metadata_start,
         status.GetDetail()));
   }
+  return Status::OK();
+}
+
+Status HdfsParquetScanner::ProcessFooter() {
+  const HdfsFileDesc* file_desc = stream_->file_desc();
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  if (metadata_cache == nullptr
+      || !metadata_cache->LookupFooter(*file_desc, &file_metadata_)) {
+    RETURN_IF_ERROR(ReadFooter());
+    if (metadata_cache != nullptr) {
+      metadata_cache->InsertFooter(*file_desc, file_metadata_);
+    }
+  }
 
   RETURN_IF_ERROR(ParquetMetadataUtils::ValidateFileVersion(file_metadata_, filename()));
 
@@ -2127,6 +2798,107 @@ Status HdfsParquetScanner::InitScalarColumns() {
     RETURN_IF_ERROR(scalar_reader->Reset(*file_desc, col_chunk, row_group_idx_));
   }
   RETURN_IF_ERROR(DivideReservationBetweenColumns(scalar_readers_));
+  return CoalesceColumnChunks();
+}
+
+Status HdfsParquetScanner::CoalesceColumnChunks() {
+  const int64_t max_gap_size = state_->query_options().parquet_coalesce_gap_size;
+  if (max_gap_size <= 0 || scalar_readers_.size() < 2) return Status::OK();
+  DiskIoMgr* io_mgr = ExecEnv::GetInstance()->disk_io_mgr();
+  const int64_t min_buffer_size = io_mgr->min_buffer_size();
+  const int64_t max_read_len = io_mgr->max_buffer_size();
+  // Ranges with sub-ranges only read some of the pages and ranges that may be read from
+  // the HDFS cache need no request, so they are not coalesced.
+  vector<BaseScalarColumnReader*> readers;
+  for (BaseScalarColumnReader* reader : scalar_readers_) {
+    const ScanRange* range = reader->scan_range();
+    if (range->HasSubRanges() || range->UseHdfsCache() || range->len() > max_read_len) {
+      continue;
+    }
+    readers.push_back(reader);
+  }
+  sort(readers.begin(), readers.end(),
+      [](const BaseScalarColumnReader* a, const BaseScalarColumnReader* b) {
+        return a->scan_range()->offset() < b->scan_range()->offset();
+      });
+
+  // A group of column chunks 'readers[begin, end)' that is read with one request.
+  struct CoalescedRead {
+    int begin;
+    int end;
+    int64_t offset;
+    int64_t len;
+    uint8_t* buffer;
+    ScanRange* range;
+  };
+  vector<CoalescedRead> reads;
+  for (int i = 0; i < readers.size();) {
+    const ScanRange* first = readers[i]->scan_range();
+    int64_t read_end = first->offset() + first->len();
+    int64_t chunk_bytes = first->len();
+    int j = i + 1;
+    for (; j < readers.size(); ++j) {
+      const ScanRange* next = readers[j]->scan_range();
+      const int64_t next_end = max(read_end, next->offset() + next->len());
+      if (next->offset() - read_end > max_gap_size
+          || next_end - first->offset() > max_read_len) {
+        break;
+      }
+      read_end = next_end;
+      chunk_bytes += next->len();
+    }
+    const int64_t read_len = read_end - first->offset();
+    // The preloaded scan ranges of the group need no I/O buffers, so the buffer is
+    // allocated from the reservation assigned to its columns. Each column keeps the
+    // minimum buffer size in case its stream reads past the end of its range. If the
+    // buffer does not fit, the column chunks are read on their own.
+    int64_t spare_reservation = 0;
+    for (int k = i; k < j; ++k) {
+      spare_reservation += readers[k]->io_reservation() - min_buffer_size;
+    }
+    const int64_t buffer_len =
+        BitUtil::RoundUpToPowerOfTwo(max(read_len, min_buffer_size));
+    if (j - i > 1 && buffer_len <= spare_reservation) {
+      BufferPool::BufferHandle buffer;
+      RETURN_IF_ERROR(ExecEnv::GetInstance()->buffer_pool()->AllocateBuffer(
+          context_->bp_client(), buffer_len, &buffer));
+      for (int k = i; k < j; ++k) readers[k]->set_io_reservation(min_buffer_size);
+      reads.push_back({i, j, first->offset(), read_len, buffer.data(), nullptr});
+      coalesced_chunk_buffers_.push_back(move(buffer));
+      COUNTER_ADD(num_coalesced_column_chunks_counter_, j - i);
+      COUNTER_ADD(coalesced_gap_bytes_counter_, max<int64_t>(0, read_len - chunk_bytes));
+    }
+    i = j;
+  }
+  if (reads.empty()) return Status::OK();
+  COUNTER_ADD(num_coalesced_reads_counter_, reads.size());
+
+  // Issue all reads before waiting for any of them, like ReadFileRange() for each.
+  int64_t partition_id = context_->partition_descriptor()->id();
+  int cache_options = metadata_range_->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
+  for (CoalescedRead& read : reads) {
+    read.range = scan_node_->AllocateScanRange(metadata_range_->fs(), filename(),
+        read.len, read.offset, partition_id, metadata_range_->disk_id(),
+        metadata_range_->expected_local(), metadata_range_->mtime(),
+        BufferOpts::ReadInto(read.buffer, read.len, cache_options));
+    bool needs_buffers;
+    RETURN_IF_ERROR(
+        scan_node_->reader_context()->StartScanRange(read.range, &needs_buffers));
+    DCHECK(!needs_buffers) << "Already provided a buffer";
+  }
+  for (CoalescedRead& read : reads) {
+    unique_ptr<BufferDescriptor> io_buffer;
+    RETURN_IF_ERROR(read.range->GetNext(&io_buffer));
+    DCHECK_EQ(io_buffer->buffer(), read.buffer);
+    DCHECK_EQ(io_buffer->len(), read.len);
+    DCHECK(io_buffer->eosr());
+    read.range->ReturnBuffer(move(io_buffer));
+    for (int i = read.begin; i < read.end; ++i) {
+      BaseScalarColumnReader* reader = readers[i];
+      reader->SetPreloadedBuffer(
+          read.buffer + (reader->scan_range()->offset() - read.offset));
+    }
+  }
   return Status::OK();
 }
 
@@ -24,6 +24,7 @@
 #include "exec/parquet/parquet-common.h"
 #include "exec/parquet/parquet-metadata-utils.h"
 #include "exec/parquet/parquet-page-index.h"
+#include "exec/scratch-tuple-batch.h"
 #include "util/runtime-profile-counters.h"
 
 namespace impala {
@@ -46,6 +47,7 @@ template<typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALI
 class ScalarColumnReader;
 class BoolColumnReader;
 class ParquetPageReader;
+class ParquetBloomFilter;
 
 /// This scanner parses Parquet files located in HDFS, and writes the content as tuples in
 /// the Impala in-memory representation of data, e.g.  (tuples, rows, row batches).
@@ -331,6 +333,19 @@ class ParquetPageReader;
 /// conjuncts against the column index and determines the surviving pages with the help of
 /// the offset index. Then it will configure the column readers to only scan the pages
 /// and row ranges that have a chance to store rows that pass the conjuncts.
+///
+/// ---- Late materialization ----
+/// For flat (non-nested) tables, the columns referenced by conjuncts and runtime filters
+/// ('filter_readers_') are read into the scratch batch first. The predicates are then
+/// evaluated to find the surviving rows, and the remaining columns
+/// ('non_filter_readers_') are only decoded for ranges of surviving rows. Runs of at
+/// least PARQUET_LATE_MATERIALIZATION_THRESHOLD filtered rows are skipped without
+/// decoding them. Late materialization is not used in row groups with page filtering.
+/// If all runtime filters target top-level integer columns with a plain slot reference,
+/// e.g. the probe key of a join, only those columns are read first. Their decoded values
+/// are checked against the runtime filters directly, without evaluating the filter
+/// expressions, and the other predicate columns ('conjunct_readers_') are only read for
+/// the rows that pass, see PARQUET_EARLY_RUNTIME_FILTERING.
 class HdfsParquetScanner : public HdfsColumnarScanner {
  public:
   HdfsParquetScanner(HdfsScanNodeBase* scan_node, RuntimeState* state);
@@ -399,6 +414,40 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// Column reader for each top-level materialized slot in the output tuple.
   std::vector<ParquetColumnReader*> column_readers_;
 
+  /// Readers in 'column_readers_' of the slots referenced by conjuncts or runtime
+  /// filters. Only non-empty if late materialization is used for this file, see
+  /// InitLateMaterialization().
+  std::vector<ParquetColumnReader*> filter_readers_;
+
+  /// The rest of the readers in 'column_readers_' if late materialization is used.
+  std::vector<BaseScalarColumnReader*> non_filter_readers_;
+
+  /// Set if the runtime filters are evaluated early. Holds the slot referenced by each
+  /// filter in 'filter_ctxs_'. 'filter_readers_' then only holds the readers of these
+  /// slots and the readers of the slots that are only referenced by conjuncts are in
+  /// 'conjunct_readers_'.
+  std::vector<const SlotDescriptor*> early_filter_slots_;
+  std::vector<BaseScalarColumnReader*> conjunct_readers_;
+
+  /// Minimum number of consecutive filtered rows that are skipped in
+  /// 'non_filter_readers_'. Set from PARQUET_LATE_MATERIALIZATION_THRESHOLD.
+  int late_materialization_threshold_ = -1;
+
+  /// Total slot size of 'non_filter_readers_', i.e. the number of bytes that are not
+  /// materialized for each skipped row.
+  int64_t non_filter_slot_bytes_ = 0;
+
+  /// Total slot size of 'conjunct_readers_'.
+  int64_t conjunct_slot_bytes_ = 0;
+
+  /// Batch that receives the rows of the scratch batch that survive filtering. Only
+  /// holds pointers into the scratch batch. Allocated if late materialization is used.
+  boost::scoped_ptr<RowBatch> selection_batch_;
+
+  /// Ranges of selected rows in the current scratch batch. Reused across scratch
+  /// batches to avoid allocations.
+  std::vector<ScratchMicroBatch> micro_batches_;
+
   /// File metadata thrift object
   parquet::FileMetaData file_metadata_;
 
@@ -416,6 +465,11 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// pages in a column chunk.
   boost::scoped_ptr<MemPool> stats_batch_read_pool_;
 
+  /// The buffers of the coalesced column chunk reads of the current row group, see
+  /// CoalesceColumnChunks(). Allocated from the scanner's reservation and freed once
+  /// the streams of the row group are released.
+  std::vector<BufferPool::BufferHandle> coalesced_chunk_buffers_;
+
   /// True, if we filter pages based on the Parquet page index.
   bool filter_pages_ = false;
 
@@ -489,6 +543,17 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// 'num_pages_counter_ - num_stats_filtered_pages_counter_' pages.
   RuntimeProfile::Counter* num_pages_counter_;
 
+  /// Number of rows skipped because Iceberg position delete files deleted them.
+  RuntimeProfile::Counter* num_position_deleted_rows_counter_ = nullptr;
+
+  /// Number of row groups skipped because they are not in the sample of the scan.
+  RuntimeProfile::Counter* num_unsampled_row_groups_counter_ = nullptr;
+
+  /// The positions of the rows of the file that Iceberg position delete files deleted,
+  /// or nullptr if no rows were deleted. Set in Open(). Owned by the scan node and
+  /// shared by all scanners of the file.
+  const RoaringBitmap* position_deletes_ = nullptr;
+
   /// Number of scanners that end up doing no reads because their splits don't overlap
   /// with the midpoint of any row-group in the file.
   RuntimeProfile::Counter* num_scanners_with_no_reads_counter_;
@@ -496,6 +561,37 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// Number of row groups skipped due to dictionary filter
   RuntimeProfile::Counter* num_dict_filtered_row_groups_counter_;
 
+  /// Number of row groups skipped because the Parquet Bloom filter of a column chunk
+  /// contains none of the values of an equality or IN predicate.
+  RuntimeProfile::Counter* num_bloom_filtered_row_groups_counter_ = nullptr;
+
+  /// Number of reads that each covered several column chunks, the number of column
+  /// chunks read by them and the bytes between the column chunks that were read only
+  /// to save requests.
+  RuntimeProfile::Counter* num_coalesced_reads_counter_ = nullptr;
+  RuntimeProfile::Counter* num_coalesced_column_chunks_counter_ = nullptr;
+  RuntimeProfile::Counter* coalesced_gap_bytes_counter_ = nullptr;
+
+  /// Number of values that were set to NULL because their dictionary code did not pass
+  /// the dictionary filter conjuncts of their column. See
+  /// BaseScalarColumnReader::dict_code_filter_.
+  RuntimeProfile::Counter* num_dict_code_filtered_values_counter_ = nullptr;
+
+  /// Number of top-level rows that were not decoded in the non-predicate columns
+  /// because they were rejected by conjuncts or runtime filters.
+  RuntimeProfile::Counter* num_late_materialization_skipped_rows_counter_ = nullptr;
+
+  /// Number of slot bytes that were not materialized thanks to late materialization.
+  RuntimeProfile::Counter* late_materialization_skipped_bytes_counter_ = nullptr;
+
+  /// Number of top-level rows that were rejected by runtime filters evaluated on the
+  /// decoded key columns, before the other predicate columns were read.
+  RuntimeProfile::Counter* num_early_runtime_filtered_rows_counter_ = nullptr;
+
+  /// Number of data pages that were decompressed ahead of time on the parquet
+  /// decompression thread pool. See the query option parquet_decompress_ahead_pages.
+  RuntimeProfile::Counter* num_pages_decompressed_ahead_counter_ = nullptr;
+
   /// Tracks the size of any compressed pages read. If no compressed pages are read, this
   /// counter is empty
   RuntimeProfile::SummaryStatsCounter* parquet_compressed_page_size_counter_;
@@ -545,6 +641,14 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
     const parquet::FileMetaData& file_metadata, const parquet::RowGroup& row_group,
     bool* skip_row_group);
 
+  /// Evaluates the IN-list runtime filters of 'filter_ctxs_' that target a column of the
+  /// file against the parquet::Statistics of 'row_group'. Sets 'skip_row_group' to true
+  /// if no value of one of the filters lies within the min/max range of the column
+  /// chunk, 'false' otherwise.
+  Status EvaluateInListFiltersForRowGroup(
+    const parquet::FileMetaData& file_metadata, const parquet::RowGroup& row_group,
+    bool* skip_row_group);
+
   /// Return true if filter 'minmax_filter' of fitler id 'filter_id' is too close to
   /// column min/max stats available at the target desc entry targets[0] in
   /// 'filter_ctxs_[idx]', utilizing 'threshold' as the threshold. Return 'false'
@@ -640,6 +744,17 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// Check that the scalar readers agree on the top-level row being scanned.
   Status CheckPageFiltering();
 
+  /// Returns the position in the file of the first row of row group 'row_group_idx'.
+  int64_t GetRowGroupFirstRow(int row_group_idx) const;
+
+  /// Returns the number of rows in the range of positions [first, last] of the file
+  /// that are in 'position_deletes_'.
+  int64_t NumPositionDeletedRows(int64_t first, int64_t last) const;
+
+  /// Returns the number of deleted rows of the current row group and appends their row
+  /// ranges, relative to the first row of the row group, to 'skip_ranges'.
+  int64_t AddPositionDeleteSkipRanges(std::vector<RowRange>* skip_ranges);
+
   /// Find out if the enabled_for_page flag at filter_stats_[filter_idx] is true. If so,
   /// the filter at filter_ctx_[filter_idx] is worthy to evaluate the overlap predicate.
   bool IsFilterWorthyForOverlapCheck(int filter_idx);
@@ -670,6 +785,45 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   Status AssembleRows(const std::vector<ParquetColumnReader*>& column_readers,
       RowBatch* row_batch, bool* skip_row_group) WARN_UNUSED_RESULT;
 
+  /// Fills the scratch batch by reading a batch of values with each reader in
+  /// 'column_readers'. On error sets *skip_row_group and frees the row group's
+  /// resources, see AssembleRows().
+  Status FillScratchBatch(const std::vector<ParquetColumnReader*>& column_readers,
+      RowBatch* row_batch, bool* skip_row_group) WARN_UNUSED_RESULT;
+
+  /// Late materialization version of FillScratchBatch(). Reads 'filter_readers_',
+  /// evaluates the predicates on the scratch batch and then only reads the surviving
+  /// row ranges with 'non_filter_readers_', skipping the others.
+  Status FillScratchBatchLateMaterialized(RowBatch* row_batch, bool* skip_row_group)
+      WARN_UNUSED_RESULT;
+
+  /// Reads the values of the selected rows of the scratch batch with each reader in
+  /// 'readers' and skips the values of the other rows. All rows are read if the scratch
+  /// batch has no selection. 'at_end' is true if the filter readers reached the end of
+  /// the row group. Sets '*num_materialized' to the number of rows that were read,
+  /// including short runs of unselected rows. On error sets *skip_row_group and frees
+  /// the row group's resources, see AssembleRows().
+  Status ReadSelectedRows(const std::vector<BaseScalarColumnReader*>& readers,
+      bool at_end, RowBatch* row_batch, int* num_materialized, bool* skip_row_group)
+      WARN_UNUSED_RESULT;
+
+  /// Returns the slot referenced by each runtime filter in 'filter_ctxs_' in
+  /// 'filter_slots' if all of them can be evaluated early on one of 'filter_readers',
+  /// see FilterScratchBatchOnSlots(). Returns false otherwise.
+  bool GetEarlyRuntimeFilterSlots(const std::vector<ParquetColumnReader*>& filter_readers,
+      std::vector<const SlotDescriptor*>* filter_slots) const;
+
+  /// Decides whether late materialization can be used for the current file and
+  /// populates 'filter_readers_' and 'non_filter_readers_' accordingly. Late
+  /// materialization requires predicates and only top-level scalar columns, some of
+  /// which are not referenced by the predicates.
+  void InitLateMaterialization();
+
+  /// Returns true if the current row group should use late materialization.
+  bool UseLateMaterialization() const {
+    return !filter_readers_.empty() && candidate_ranges_.empty();
+  }
+
   /// Commit num_rows to the given row batch.
   /// Returns OK if the query is not cancelled and hasn't exceeded any mem limits.
   /// Scanner can call this with 0 rows to flush any pending resources (attached pools
@@ -703,9 +857,14 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
       bool materialize_tuple, MemPool* pool, Tuple* tuple) const;
 
   /// Process the file footer and parse file_metadata_.  This should be called with the
-  /// last FOOTER_SIZE bytes in context_.
+  /// last FOOTER_SIZE bytes in context_. The footer is taken from the process-wide
+  /// ParquetMetadataCache if it is enabled and holds the footer of this file.
   Status ProcessFooter() WARN_UNUSED_RESULT;
 
+  /// Reads the footer from the last FOOTER_SIZE bytes in context_, and from the file if
+  /// it is larger, and deserializes it into file_metadata_. Called by ProcessFooter().
+  Status ReadFooter() WARN_UNUSED_RESULT;
+
   /// Populates 'column_readers' for the slots in 'tuple_desc', including creating child
   /// readers for any collections. Schema resolution is handled in this function as
   /// well. Fills in the appropriate template tuple slot with NULL for any materialized
@@ -737,6 +896,18 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// does not start any scan ranges.
   Status InitScalarColumns() WARN_UNUSED_RESULT;
 
+  /// If the PARQUET_COALESCE_GAP_SIZE query option is set, reads the column chunks of
+  /// 'scalar_readers_' that are separated by at most that many bytes with one request
+  /// per group, up to the max I/O buffer size per request, and makes the readers scan
+  /// their part of the buffer. Must be called after InitScalarColumns() and before the
+  /// scans are started. A group is only coalesced if its buffer fits into the
+  /// reservation that its columns do not need for I/O buffers anymore. Otherwise its
+  /// column chunks are read on their own.
+  Status CoalesceColumnChunks() WARN_UNUSED_RESULT;
+
+  /// Frees 'coalesced_chunk_buffers_'.
+  void FreeCoalescedChunkBuffers();
+
   /// Decides how to divide stream_->reservation() between the columns. May increase
   /// the reservation if more reservation would enable more efficient I/O for the
   /// current columns being scanned. Sets the reservation on each corresponding reader
@@ -811,6 +982,32 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   Status EvalDictionaryFilters(const parquet::RowGroup& row_group,
       bool* skip_row_group) WARN_UNUSED_RESULT;
 
+  /// Checks to see if this row group can be eliminated based on the Parquet split block
+  /// Bloom filters of its column chunks. The filters are probed with the literals of
+  /// the 'slot = literal' and 'slot IN (literals)' conjuncts of scalar columns of the
+  /// top-level tuple. If a filter contains none of the literals of such a conjunct,
+  /// no row of the row group can pass and 'skip_row_group' is set to true.
+  /// 'file_length' is used to validate the filter offsets.
+  Status EvalBloomFilters(const parquet::RowGroup& row_group, int64_t file_length,
+      bool* skip_row_group) WARN_UNUSED_RESULT;
+
+  /// Computes the hashes of the literals of 'conjunct' that are used to probe the Bloom
+  /// filter of the column read by 'reader'. Returns false if 'conjunct' is not an
+  /// equality or IN predicate on the slot of 'reader' with only non-NULL literals of a
+  /// type whose Parquet PLAIN encoding can be derived from the slot value.
+  bool GetBloomFilterProbeHashes(ScalarExprEvaluator* conjunct,
+      const BaseScalarColumnReader* reader, std::vector<uint64_t>* hashes);
+
+  /// Reads the Bloom filter of 'col_chunk' into 'buffer' and initializes 'filter' to
+  /// point to its bitset. Returns an error if the filter is corrupt or uses an
+  /// unsupported algorithm, hash or compression.
+  Status ReadBloomFilter(const parquet::ColumnChunk& col_chunk, int64_t file_length,
+      ScopedBuffer* buffer, ParquetBloomFilter* filter) WARN_UNUSED_RESULT;
+
+  /// Synchronously reads 'length' bytes of the file at 'offset' into 'buffer'.
+  Status ReadFileRange(int64_t offset, int64_t length, uint8_t* buffer)
+      WARN_UNUSED_RESULT;
+
   /// Updates the counter parquet_compressed_page_size_counter_ with the given compressed
   /// page size. Called by ParquetColumnReader for each page read.
   void UpdateCompressedPageSizeCounter(int64_t compressed_page_size);
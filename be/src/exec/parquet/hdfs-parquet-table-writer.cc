@@ -21,7 +21,9 @@
 
 #include "common/version.h"
 #include "exec/hdfs-table-sink.h"
+#include "exec/parquet/parquet-byte-stream-split.h"
 #include "exec/parquet/parquet-column-stats.inline.h"
+#include "exec/parquet/parquet-delta-encoding.h"
 #include "exec/parquet/parquet-metadata-utils.h"
 #include "exprs/scalar-expr-evaluator.h"
 #include "exprs/scalar-expr.h"
@@ -29,9 +31,11 @@
 #include "runtime/date-value.h"
 #include "runtime/decimal-value.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/exec-env.h"
 #include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-state.h"
+#include "runtime/scoped-buffer.h"
 #include "runtime/string-value.inline.h"
 #include "util/bit-stream-utils.h"
 #include "util/bit-util.h"
@@ -41,8 +45,10 @@
 #include "util/dict-encoding.h"
 #include "util/hdfs-util.h"
 #include "util/pretty-printer.h"
+#include "util/promise.h"
 #include "util/rle-encoding.h"
 #include "util/string-util.h"
+#include "util/thread-pool.h"
 
 #include <sstream>
 
@@ -130,7 +136,8 @@ class HdfsParquetTableWriter::BaseColumnWriter {
       page_stats_base_(nullptr),
       row_group_stats_base_(nullptr),
       table_sink_mem_tracker_(parent_->parent_->mem_tracker()),
-      column_name_(std::move(column_name)) {
+      column_name_(std::move(column_name)),
+      compression_task_(table_sink_mem_tracker_) {
     static_assert(std::is_same<decltype(parent_->parent_), HdfsTableSink*>::value,
         "'table_sink_mem_tracker_' must point to the mem tracker of an HdfsTableSink");
     def_levels_ = parent_->state_->obj_pool()->Add(
@@ -156,7 +163,8 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // would also solve this problem.
   Status AppendRow(TupleRow* row) WARN_UNUSED_RESULT;
 
-  // Flushes all buffered data pages to the file.
+  // Flushes all buffered data pages to the file. Finalizes the last data page and the
+  // dictionary page first if that was not done yet.
   // *file_pos is an output parameter and will be incremented by
   // the number of bytes needed to write all the data pages for this column.
   // first_data_page and first_dictionary_page are also out parameters and
@@ -208,11 +216,20 @@ class HdfsParquetTableWriter::BaseColumnWriter {
     column_index_.null_counts.clear();
     valid_column_index_ = true;
     write_page_index_ = parent_->state_->query_options().parquet_write_page_index;
+    DCHECK(compression_task_.status == nullptr);
+    dict_page_finalized_ = false;
   }
 
   // Close this writer. This is only called after Flush() and no more rows will
   // be added.
   void Close() {
+    // A compression may still be running if the writer failed.
+    if (compression_task_.status != nullptr) {
+      compression_task_.status->Get();
+      compression_task_.status.reset();
+    }
+    compression_task_.input_buffer.Release();
+    compression_task_.output_buffer.Release();
     if (compressor_.get() != nullptr) compressor_->Close();
     if (dict_encoder_base_ != nullptr) dict_encoder_base_->Close();
     // We must release the memory consumption of this column writer.
@@ -310,6 +327,24 @@ class HdfsParquetTableWriter::BaseColumnWriter {
   // Encodes out all data for the current page and updates the metadata.
   virtual Status FinalizeCurrentPage() WARN_UNUSED_RESULT;
 
+  // Encodes the dictionary into 'dict_page_header_' and 'dict_page_data_'. No-op if the
+  // column is not dictionary encoded or the page was already finalized.
+  Status FinalizeDictPage() WARN_UNUSED_RESULT;
+
+  // Starts compressing 'input_len' bytes at 'input' on the encoding pool of the parent.
+  // 'page_idx' is the index of the data page in 'pages_', or -1 for the dictionary page.
+  // Must only be called if no compression of this column is in flight.
+  Status StartCompression(int page_idx, const uint8_t* input, int input_len)
+      WARN_UNUSED_RESULT;
+
+  // Waits for the compression that was started by StartCompression(), if any, and
+  // stores its output in the page. No-op if no compression is in flight.
+  Status WaitForCompression() WARN_UNUSED_RESULT;
+
+  // Makes 'buffer' at least 'size' bytes large. The contents are not preserved.
+  Status AllocateCompressionBuffer(ScopedBuffer* buffer, int64_t size,
+      const char* details) WARN_UNUSED_RESULT;
+
   // Update current_page_ to a new page, reusing pages allocated if possible.
   void NewPage();
 
@@ -336,6 +371,10 @@ class HdfsParquetTableWriter::BaseColumnWriter {
     int num_non_null;
   };
 
+  // Adds the size of the finalized 'page' and its header to the size totals and to the
+  // file size estimate.
+  Status AddPageSizes(const DataPage& page) WARN_UNUSED_RESULT;
+
   HdfsParquetTableWriter* parent_;
   ScalarExprEvaluator* expr_eval_;
 
@@ -419,6 +458,40 @@ class HdfsParquetTableWriter::BaseColumnWriter {
 
   // Column name in the HdfsTableDescriptor.
   const string column_name_;
+
+  // Header and data of the dictionary page. Set by FinalizeDictPage().
+  parquet::PageHeader dict_page_header_;
+  uint8_t* dict_page_data_ = nullptr;
+  bool dict_page_finalized_ = false;
+
+  // State of a page compression that runs on the encoding pool of the parent. A column
+  // has at most one compression in flight, since 'compressor_' must not be used by two
+  // threads at the same time. The buffers are reused across pages.
+  struct CompressionTask {
+    CompressionTask(MemTracker* mem_tracker)
+      : input_buffer(mem_tracker), output_buffer(mem_tracker) {}
+
+    // Index of the data page in 'pages_', or -1 for the dictionary page.
+    int page_idx = -1;
+
+    // Data to compress. For data pages this is 'input_buffer', since the buffers of the
+    // column are reused for the next page while the page is compressed.
+    const uint8_t* input = nullptr;
+    int input_len = 0;
+    ScopedBuffer input_buffer;
+
+    // Output of the compression. Copied to the per-file pool once it is done.
+    ScopedBuffer output_buffer;
+    int output_len = 0;
+
+    // Upper bound of the bytes the page adds to the file size estimate.
+    int64_t size_bound = 0;
+
+    // Set by the pool thread when the compression is done. NULL if no compression is
+    // in flight.
+    std::unique_ptr<Promise<Status>> status;
+  };
+  CompressionTask compression_task_;
 };
 
 // Per type column writer.
@@ -451,9 +524,20 @@ class HdfsParquetTableWriter::ColumnWriter :
     row_group_stats_.reset(
         new ColumnStats<T>(parent_->per_file_mem_pool_.get(), plain_encoded_value_size_));
     row_group_stats_base_ = row_group_stats_.get();
+    fallback_encoding_ = FallbackEncoding();
   }
 
  protected:
+  virtual Status FinalizeCurrentPage() {
+    DCHECK(current_page_ != nullptr);
+    if (!current_page_->finalized && current_encoding_ == parquet::Encoding::PLAIN
+        && fallback_encoding_ != parquet::Encoding::PLAIN
+        && current_page_->num_non_null > 0) {
+      ReencodePlainValues();
+    }
+    return BaseColumnWriter::FinalizeCurrentPage();
+  }
+
   virtual bool ProcessValue(void* value, int64_t* bytes_needed) {
     T* val = CastValue(value);
     if (IsDictionaryEncoding(current_encoding_)) {
@@ -529,6 +613,81 @@ class HdfsParquetTableWriter::ColumnWriter :
   inline T* CastValue(void* value) {
     return reinterpret_cast<T*>(value);
   }
+
+  // Returns the encoding to use instead of PLAIN for the values of this column, or PLAIN
+  // if the PARQUET_FALLBACK_ENCODINGS query option is not set or no other encoding
+  // applies to its physical type.
+  parquet::Encoding::type FallbackEncoding() const {
+    if (!parent_->state_->query_options().parquet_fallback_encodings) {
+      return parquet::Encoding::PLAIN;
+    }
+    switch (ParquetMetadataUtils::ConvertInternalToParquetType(
+        type().type, parent_->timestamp_type_)) {
+      case parquet::Type::INT32:
+      case parquet::Type::INT64:
+        return parquet::Encoding::DELTA_BINARY_PACKED;
+      case parquet::Type::BYTE_ARRAY:
+        return parquet::Encoding::DELTA_BYTE_ARRAY;
+      case parquet::Type::FLOAT:
+      case parquet::Type::DOUBLE:
+        return parquet::Encoding::BYTE_STREAM_SPLIT;
+      default:
+        return parquet::Encoding::PLAIN;
+    }
+  }
+
+  // Re-encodes the PLAIN values of the current page with 'fallback_encoding_' and
+  // replaces them in 'values_buffer_' if the result is not larger. BYTE_STREAM_SPLIT
+  // does not change the size, but makes the page compress better.
+  void ReencodePlainValues() {
+    const int64_t plain_len = current_page_->header.uncompressed_page_size;
+    const int64_t num_values = current_page_->num_non_null;
+    vector<uint8_t>& buffer = parent_->encoding_staging_buffer_;
+    int64_t encoded_len = -1;
+    // 'values_buffer_' is allocated from a MemPool, so fixed width PLAIN values in it are
+    // aligned.
+    switch (fallback_encoding_) {
+      case parquet::Encoding::DELTA_BINARY_PACKED:
+        if (plain_encoded_value_size_ == sizeof(int32_t)) {
+          buffer.resize(
+              ParquetDeltaBinaryPackedEncoder<int32_t>::MaxEncodedSize(num_values));
+          encoded_len = ParquetDeltaBinaryPackedEncoder<int32_t>::Encode(
+              reinterpret_cast<const int32_t*>(values_buffer_), num_values,
+              buffer.data(), buffer.size());
+        } else {
+          DCHECK_EQ(plain_encoded_value_size_, sizeof(int64_t));
+          buffer.resize(
+              ParquetDeltaBinaryPackedEncoder<int64_t>::MaxEncodedSize(num_values));
+          encoded_len = ParquetDeltaBinaryPackedEncoder<int64_t>::Encode(
+              reinterpret_cast<const int64_t*>(values_buffer_), num_values,
+              buffer.data(), buffer.size());
+        }
+        break;
+      case parquet::Encoding::DELTA_BYTE_ARRAY:
+        buffer.resize(
+            ParquetDeltaByteArrayEncoder::MaxEncodedSize(plain_len, num_values));
+        encoded_len = ParquetDeltaByteArrayEncoder::Encode(
+            values_buffer_, plain_len, num_values, buffer.data(), buffer.size());
+        break;
+      case parquet::Encoding::BYTE_STREAM_SPLIT:
+        buffer.resize(plain_len);
+        ParquetByteStreamSplit::Encode(
+            values_buffer_, num_values, plain_encoded_value_size_, buffer.data());
+        encoded_len = plain_len;
+        break;
+      default:
+        DCHECK(false);
+    }
+    DCHECK_GE(encoded_len, 0);
+    if (encoded_len < 0 || encoded_len > plain_len) return;
+    memcpy(values_buffer_, buffer.data(), encoded_len);
+    current_page_->header.uncompressed_page_size = encoded_len;
+    current_encoding_ = fallback_encoding_;
+  }
+
+  // The encoding that replaces PLAIN for pages that are not dictionary encoded. Set in
+  // Reset().
+  parquet::Encoding::type fallback_encoding_ = parquet::Encoding::PLAIN;
  protected:
   // Size of each encoded value in plain encoding. -1 if the type is variable-length.
   int64_t plain_encoded_value_size_;
@@ -753,6 +912,166 @@ inline void HdfsParquetTableWriter::BaseColumnWriter::WriteDictDataPage() {
   current_page_->header.uncompressed_page_size = len;
 }
 
+Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeDictPage() {
+  DCHECK(current_page_ != nullptr);
+  if (dict_encoder_base_ == nullptr || dict_page_finalized_) return Status::OK();
+  dict_page_finalized_ = true;
+
+  parquet::DictionaryPageHeader dict_header;
+  dict_header.num_values = dict_encoder_base_->num_entries();
+  dict_header.encoding = DictPageEncoding();
+  ++dict_encoding_stats_[dict_header.encoding];
+
+  parquet::PageHeader& header = dict_page_header_;
+  header = parquet::PageHeader();
+  header.type = parquet::PageType::DICTIONARY_PAGE;
+  header.uncompressed_page_size = dict_encoder_base_->dict_encoded_size();
+  header.__set_dictionary_page_header(dict_header);
+
+  // Write the dictionary page data, compressing it if necessary.
+  uint8_t* dict_buffer =
+      parent_->per_file_mem_pool_->TryAllocate(header.uncompressed_page_size);
+  if (UNLIKELY(dict_buffer == nullptr)) {
+    string details = (Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "BaseColumnWriter::Flush",
+        header.uncompressed_page_size, "dictionary page"));
+    return parent_->per_file_mem_pool_->mem_tracker()->MemLimitExceeded(
+        parent_->state_, details, header.uncompressed_page_size);
+  }
+  dict_encoder_base_->WriteDict(dict_buffer);
+  if (compressor_.get() == nullptr) {
+    header.compressed_page_size = header.uncompressed_page_size;
+    dict_page_data_ = dict_buffer;
+  } else if (parent_->encoding_pool_ != nullptr) {
+    // The last data page may still be compressed with 'compressor_'.
+    RETURN_IF_ERROR(WaitForCompression());
+    RETURN_IF_ERROR(StartCompression(-1, dict_buffer, header.uncompressed_page_size));
+  } else {
+    SCOPED_TIMER(parent_->parent_->compress_timer());
+    int64_t max_compressed_size =
+        compressor_->MaxOutputLen(header.uncompressed_page_size);
+    DCHECK_GT(max_compressed_size, 0);
+    uint8_t* compressed_data =
+        parent_->per_file_mem_pool_->TryAllocate(max_compressed_size);
+    if (UNLIKELY(compressed_data == nullptr)) {
+      string details =
+          (Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "BaseColumnWriter::Flush",
+              max_compressed_size, "compressed dictionary page"));
+      return parent_->per_file_mem_pool_->mem_tracker()->MemLimitExceeded(
+          parent_->state_, details, max_compressed_size);
+    }
+    header.compressed_page_size = max_compressed_size;
+    const Status& status =
+        compressor_->ProcessBlock32(true, header.uncompressed_page_size, dict_buffer,
+            &header.compressed_page_size, &compressed_data);
+    if (!status.ok()) {
+      return Status(Substitute("Error writing parquet file '$0' column '$1': $2",
+          parent_->output_->current_file_name, column_name(), status.GetDetail()));
+    }
+    dict_page_data_ = compressed_data;
+    // We allocated the output based on the guessed size, return the extra allocated
+    // bytes back to the mem pool.
+    parent_->per_file_mem_pool_->ReturnPartialAllocation(
+        max_compressed_size - header.compressed_page_size);
+  }
+  return Status::OK();
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::AllocateCompressionBuffer(
+    ScopedBuffer* buffer, int64_t size, const char* details) {
+  if (buffer->Size() >= size) return Status::OK();
+  buffer->Release();
+  if (UNLIKELY(!buffer->TryAllocate(size))) {
+    string msg = Substitute(PARQUET_MEM_LIMIT_EXCEEDED,
+        "BaseColumnWriter::AllocateCompressionBuffer", size, details);
+    return table_sink_mem_tracker_->MemLimitExceeded(parent_->state_, msg, size);
+  }
+  return Status::OK();
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::StartCompression(int page_idx,
+    const uint8_t* input, int input_len) {
+  DCHECK(parent_->encoding_pool_ != nullptr);
+  DCHECK(compressor_.get() != nullptr);
+  DCHECK(compression_task_.status == nullptr);
+  CompressionTask* task = &compression_task_;
+  int64_t max_compressed_size = compressor_->MaxOutputLen(input_len);
+  DCHECK_GT(max_compressed_size, 0);
+  RETURN_IF_ERROR(AllocateCompressionBuffer(
+      &task->output_buffer, max_compressed_size, "compressed page"));
+  task->page_idx = page_idx;
+  task->input = input;
+  task->input_len = input_len;
+  task->output_len = max_compressed_size;
+  task->size_bound = 0;
+  if (page_idx >= 0) {
+    // The header can only get shorter with the actual compressed size, so serializing
+    // it with the maximum gives an upper bound.
+    parquet::PageHeader& header = pages_[page_idx].header;
+    header.compressed_page_size = max_compressed_size;
+    uint8_t* header_buffer;
+    uint32_t header_len = 0;
+    RETURN_IF_ERROR(parent_->thrift_serializer_->SerializeToBuffer(
+        &header, &header_len, &header_buffer));
+    task->size_bound = header_len + max_compressed_size;
+  }
+  parent_->pending_compression_bytes_ += task->size_bound;
+  task->status.reset(new Promise<Status>());
+
+  Codec* compressor = compressor_.get();
+  RuntimeProfile::Counter* compress_timer = parent_->parent_->compress_timer();
+  boost::function<void()> fn = [task, compressor, compress_timer]() {
+    SCOPED_TIMER(compress_timer);
+    uint8_t* output = task->output_buffer.buffer();
+    Status status = compressor->ProcessBlock32(true, task->input_len, task->input,
+        &task->output_len, &output);
+    task->status->Set(status);
+  };
+  // If the pool was shut down, compress on this thread.
+  if (!parent_->encoding_pool_->Offer(fn)) fn();
+  return Status::OK();
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::WaitForCompression() {
+  CompressionTask* task = &compression_task_;
+  if (task->status == nullptr) return Status::OK();
+  Status status = task->status->Get();
+  task->status.reset();
+  parent_->pending_compression_bytes_ -= task->size_bound;
+  if (!status.ok()) {
+    return Status(Substitute("Error writing parquet file '$0' column '$1': $2",
+        parent_->output_->current_file_name, column_name(), status.GetDetail()));
+  }
+  // The output buffer is reused for the next page, copy the data to the per-file pool.
+  uint8_t* data = parent_->per_file_mem_pool_->TryAllocate(task->output_len);
+  if (UNLIKELY(data == nullptr)) {
+    string details = Substitute(PARQUET_MEM_LIMIT_EXCEEDED,
+        "BaseColumnWriter::WaitForCompression", task->output_len, "compressed page");
+    return parent_->per_file_mem_pool_->mem_tracker()->MemLimitExceeded(
+        parent_->state_, details, task->output_len);
+  }
+  memcpy(data, task->output_buffer.buffer(), task->output_len);
+  if (task->page_idx < 0) {
+    dict_page_header_.compressed_page_size = task->output_len;
+    dict_page_data_ = data;
+    return Status::OK();
+  }
+  DataPage* page = &pages_[task->page_idx];
+  page->header.compressed_page_size = task->output_len;
+  page->data = data;
+  return AddPageSizes(*page);
+}
+
+Status HdfsParquetTableWriter::BaseColumnWriter::AddPageSizes(const DataPage& page) {
+  uint8_t* header_buffer;
+  uint32_t header_len = 0;
+  RETURN_IF_ERROR(parent_->thrift_serializer_->SerializeToBuffer(
+      &page.header, &header_len, &header_buffer));
+  total_compressed_byte_size_ += header_len + page.header.compressed_page_size;
+  total_uncompressed_byte_size_ += header_len + page.header.uncompressed_page_size;
+  parent_->file_size_estimate_ += header_len + page.header.compressed_page_size;
+  return Status::OK();
+}
+
 Status HdfsParquetTableWriter::BaseColumnWriter::Flush(int64_t* file_pos,
    int64_t* first_data_page, int64_t* first_dictionary_page) {
   if (current_page_ == nullptr) {
@@ -763,63 +1082,14 @@ Status HdfsParquetTableWriter::BaseColumnWriter::Flush(int64_t* file_pos,
   }
 
   RETURN_IF_ERROR(FinalizeCurrentPage());
+  RETURN_IF_ERROR(FinalizeDictPage());
+  RETURN_IF_ERROR(WaitForCompression());
 
   *first_dictionary_page = -1;
   // First write the dictionary page before any of the data pages.
   if (dict_encoder_base_ != nullptr) {
     *first_dictionary_page = *file_pos;
-    // Write dictionary page header
-    parquet::DictionaryPageHeader dict_header;
-    dict_header.num_values = dict_encoder_base_->num_entries();
-    dict_header.encoding = DictPageEncoding();
-    ++dict_encoding_stats_[dict_header.encoding];
-
-    parquet::PageHeader header;
-    header.type = parquet::PageType::DICTIONARY_PAGE;
-    header.uncompressed_page_size = dict_encoder_base_->dict_encoded_size();
-    header.__set_dictionary_page_header(dict_header);
-
-    // Write the dictionary page data, compressing it if necessary.
-    uint8_t* dict_buffer =
-        parent_->per_file_mem_pool_->TryAllocate(header.uncompressed_page_size);
-    if (UNLIKELY(dict_buffer == nullptr)) {
-      string details = (Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "BaseColumnWriter::Flush",
-          header.uncompressed_page_size, "dictionary page"));
-      return parent_->per_file_mem_pool_->mem_tracker()->MemLimitExceeded(
-          parent_->state_, details, header.uncompressed_page_size);
-    }
-    dict_encoder_base_->WriteDict(dict_buffer);
-    if (compressor_.get() != nullptr) {
-      SCOPED_TIMER(parent_->parent_->compress_timer());
-      int64_t max_compressed_size =
-          compressor_->MaxOutputLen(header.uncompressed_page_size);
-      DCHECK_GT(max_compressed_size, 0);
-      uint8_t* compressed_data =
-          parent_->per_file_mem_pool_->TryAllocate(max_compressed_size);
-      if (UNLIKELY(compressed_data == nullptr)) {
-        string details =
-            (Substitute(PARQUET_MEM_LIMIT_EXCEEDED, "BaseColumnWriter::Flush",
-                max_compressed_size, "compressed dictionary page"));
-        return parent_->per_file_mem_pool_->mem_tracker()->MemLimitExceeded(
-            parent_->state_, details, max_compressed_size);
-      }
-      header.compressed_page_size = max_compressed_size;
-      const Status& status =
-          compressor_->ProcessBlock32(true, header.uncompressed_page_size, dict_buffer,
-              &header.compressed_page_size, &compressed_data);
-      if (!status.ok()) {
-        return Status(Substitute("Error writing parquet file '$0' column '$1': $2",
-            parent_->output_->current_file_name, column_name(), status.GetDetail()));
-      }
-      dict_buffer = compressed_data;
-      // We allocated the output based on the guessed size, return the extra allocated
-      // bytes back to the mem pool.
-      parent_->per_file_mem_pool_->ReturnPartialAllocation(
-          max_compressed_size - header.compressed_page_size);
-    } else {
-      header.compressed_page_size = header.uncompressed_page_size;
-    }
-
+    const parquet::PageHeader& header = dict_page_header_;
     uint8_t* header_buffer;
     uint32_t header_len;
     RETURN_IF_ERROR(parent_->thrift_serializer_->SerializeToBuffer(
@@ -829,7 +1099,7 @@ Status HdfsParquetTableWriter::BaseColumnWriter::Flush(int64_t* file_pos,
     total_compressed_byte_size_ += header_len;
     total_uncompressed_byte_size_ += header_len;
 
-    RETURN_IF_ERROR(parent_->Write(dict_buffer, header.compressed_page_size));
+    RETURN_IF_ERROR(parent_->Write(dict_page_data_, header.compressed_page_size));
     *file_pos += header.compressed_page_size;
     total_compressed_byte_size_ += header.compressed_page_size;
     total_uncompressed_byte_size_ += header.uncompressed_page_size;
@@ -906,6 +1176,13 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
   if (compressor_.get() == nullptr) {
     uncompressed_data =
         parent_->per_file_mem_pool_->Allocate(header.uncompressed_page_size);
+  } else if (parent_->encoding_pool_ != nullptr) {
+    // Combine into the input buffer of the compression task, which may still be used by
+    // the previous page of this column.
+    RETURN_IF_ERROR(WaitForCompression());
+    RETURN_IF_ERROR(AllocateCompressionBuffer(&compression_task_.input_buffer,
+        header.uncompressed_page_size, "uncompressed page"));
+    uncompressed_data = compression_task_.input_buffer.buffer();
   } else {
     // We have compression.  Combine into the staging buffer.
     parent_->compression_staging_buffer_.resize(
@@ -927,6 +1204,10 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
   if (compressor_.get() == nullptr) {
     current_page_->data = uncompressed_data;
     header.compressed_page_size = header.uncompressed_page_size;
+  } else if (parent_->encoding_pool_ != nullptr) {
+    // The sizes of the page are added once the compression is done.
+    RETURN_IF_ERROR(StartCompression(current_page_ - pages_.data(), uncompressed_data,
+        header.uncompressed_page_size));
   } else {
     SCOPED_TIMER(parent_->parent_->compress_timer());
     int64_t max_compressed_size =
@@ -957,16 +1238,10 @@ Status HdfsParquetTableWriter::BaseColumnWriter::FinalizeCurrentPage() {
   RETURN_IF_ERROR(row_group_stats_base_->MaterializeStringValuesToInternalBuffers());
   row_group_stats_base_->Merge(*page_stats_base_);
 
-  // Add the size of the data page header
-  uint8_t* header_buffer;
-  uint32_t header_len = 0;
-  RETURN_IF_ERROR(parent_->thrift_serializer_->SerializeToBuffer(
-      &current_page_->header, &header_len, &header_buffer));
+  // Add the size of the data page and its header.
+  if (compression_task_.status == nullptr) RETURN_IF_ERROR(AddPageSizes(*current_page_));
 
   current_page_->finalized = true;
-  total_compressed_byte_size_ += header_len + header.compressed_page_size;
-  total_uncompressed_byte_size_ += header_len + header.uncompressed_page_size;
-  parent_->file_size_estimate_ += header_len + header.compressed_page_size;
   def_levels_->Clear();
   return Status::OK();
 }
@@ -1070,6 +1345,12 @@ Status HdfsParquetTableWriter::Init() {
     page_row_count_limit_ = query_options.parquet_page_row_count_limit;
   }
 
+  // Compression is the only work that can be done by the pool, so it is not used for
+  // uncompressed files.
+  if (query_options.parquet_parallel_encoding && codec != THdfsCompression::NONE) {
+    encoding_pool_ = ExecEnv::GetInstance()->parquet_encoding_pool();
+  }
+
   int num_cols = table_desc_->num_cols() - table_desc_->num_clustering_cols();
   // When opening files using the hdfsOpenFile() API, the maximum block size is limited to
   // 2GB.
@@ -1292,6 +1573,7 @@ Status HdfsParquetTableWriter::InitNewFile() {
   file_pos_ = 0;
   row_count_ = 0;
   file_size_estimate_ = 0;
+  DCHECK_EQ(pending_compression_bytes_, 0);
 
   file_metadata_.row_groups.clear();
   RETURN_IF_ERROR(AddRowGroup());
@@ -1322,10 +1604,15 @@ Status HdfsParquetTableWriter::AppendRows(
     ++row_count_;
     ++output_->current_file_rows;
 
-    if (file_size_estimate_ > file_size_limit_) {
-      // This file is full.  We need a new file.
-      *new_file = true;
-      return Status::OK();
+    if (file_size_estimate_ + pending_compression_bytes_ > file_size_limit_) {
+      // The pages that are still being compressed may take the file over the limit.
+      // Wait for them to get the exact estimate.
+      RETURN_IF_ERROR(WaitForCompressions());
+      if (file_size_estimate_ > file_size_limit_) {
+        // This file is full.  We need a new file.
+        *new_file = true;
+        return Status::OK();
+      }
     }
   }
 
@@ -1386,9 +1673,31 @@ Status HdfsParquetTableWriter::WriteFileHeader() {
   return Status::OK();
 }
 
+Status HdfsParquetTableWriter::WaitForCompressions() {
+  for (unique_ptr<BaseColumnWriter>& column : columns_) {
+    RETURN_IF_ERROR(column->WaitForCompression());
+  }
+  DCHECK_EQ(pending_compression_bytes_, 0);
+  return Status::OK();
+}
+
 Status HdfsParquetTableWriter::FlushCurrentRowGroup() {
   if (current_row_group_ == nullptr) return Status::OK();
 
+  if (encoding_pool_ != nullptr) {
+    // Start compressing the last data page and then the dictionary page of all columns
+    // before writing any of them, so that the columns are compressed in parallel. The
+    // pages are written in column order by Flush() below.
+    for (unique_ptr<BaseColumnWriter>& column : columns_) {
+      if (column->current_page_ != nullptr) {
+        RETURN_IF_ERROR(column->FinalizeCurrentPage());
+      }
+    }
+    for (unique_ptr<BaseColumnWriter>& column : columns_) {
+      if (column->current_page_ != nullptr) RETURN_IF_ERROR(column->FinalizeDictPage());
+    }
+  }
+
   for (int i = 0; i < columns_.size(); ++i) {
     int64_t data_page_offset, dict_page_offset;
     // Flush this column.  This updates the final metadata sizes for this column.
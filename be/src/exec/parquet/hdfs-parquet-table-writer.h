@@ -34,6 +34,7 @@
 
 namespace impala {
 
+class CallableThreadPool;
 class Expr;
 struct OutputPartition;
 class RuntimeState;
@@ -166,6 +167,10 @@ class HdfsParquetTableWriter : public HdfsTableWriter {
   /// Updates output partition with some summary about the written file.
   void FinalizePartitionInfo();
 
+  /// Waits for the page compressions that run on 'encoding_pool_' of all columns. This
+  /// makes 'file_size_estimate_' exact.
+  Status WaitForCompressions();
+
   /// Thrift serializer utility object.  Reusing this object allows for
   /// fewer memory allocations.
   boost::scoped_ptr<ThriftSerializer> thrift_serializer_;
@@ -194,6 +199,16 @@ class HdfsParquetTableWriter : public HdfsTableWriter {
   /// Limit on the total size of the file.
   int64_t file_size_limit_;
 
+  /// Pool that compresses the pages of the columns if the query option
+  /// PARQUET_PARALLEL_ENCODING is set, otherwise NULL. Not owned.
+  CallableThreadPool* encoding_pool_ = nullptr;
+
+  /// Upper bound of the bytes that the pages that are being compressed on
+  /// 'encoding_pool_' will add to 'file_size_estimate_'. The estimate is only made exact
+  /// if this bound could take it over 'file_size_limit_', so the files are split at
+  /// the same rows as with serial compression.
+  int64_t pending_compression_bytes_ = 0;
+
   /// The file location in the current output file.  This is the number of bytes
   /// that have been written to the file so far.  The metadata uses file offsets
   /// in a few places.
@@ -216,6 +231,10 @@ class HdfsParquetTableWriter : public HdfsTableWriter {
   /// enabled and is reused between all data pages.
   std::vector<uint8_t> compression_staging_buffer_;
 
+  /// Staging buffer to re-encode the PLAIN values of a data page with the
+  /// PARQUET_FALLBACK_ENCODINGS query option. Reused between all data pages.
+  std::vector<uint8_t> encoding_staging_buffer_;
+
   /// For each column, the on disk size written.
   ParquetDmlStatsPB parquet_dml_stats_;
 
@@ -0,0 +1,138 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-byte-stream-split.h"
+
+#ifndef __aarch64__
+#include <emmintrin.h>
+#endif
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+namespace {
+
+/// Decodes values [start, num_values) one byte at a time.
+template <int WIDTH>
+void DecodeScalar(const uint8_t* __restrict__ in, int64_t start, int64_t num_values,
+    uint8_t* __restrict__ out) {
+  for (int64_t i = start; i < num_values; ++i) {
+    for (int b = 0; b < WIDTH; ++b) out[i * WIDTH + b] = in[b * num_values + i];
+  }
+}
+
+/// Returns the number of values that were decoded, a multiple of 16.
+int64_t Decode4(const uint8_t* __restrict__ in, int64_t num_values,
+    uint8_t* __restrict__ out) {
+  int64_t i = 0;
+#ifndef __aarch64__
+  for (; i + 16 <= num_values; i += 16) {
+    const __m128i s0 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(in + i));
+    const __m128i s1 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(in + num_values + i));
+    const __m128i s2 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(in + 2 * num_values + i));
+    const __m128i s3 = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(in + 3 * num_values + i));
+    // Interleave bytes 0 and 1, and bytes 2 and 3 of each value.
+    const __m128i lo01 = _mm_unpacklo_epi8(s0, s1);
+    const __m128i hi01 = _mm_unpackhi_epi8(s0, s1);
+    const __m128i lo23 = _mm_unpacklo_epi8(s2, s3);
+    const __m128i hi23 = _mm_unpackhi_epi8(s2, s3);
+    __m128i* dst = reinterpret_cast<__m128i*>(out + i * 4);
+    _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo01, lo23));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo01, lo23));
+    _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi01, hi23));
+    _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi01, hi23));
+  }
+#endif
+  return i;
+}
+
+/// Returns the number of values that were decoded, a multiple of 16.
+int64_t Decode8(const uint8_t* __restrict__ in, int64_t num_values,
+    uint8_t* __restrict__ out) {
+  int64_t i = 0;
+#ifndef __aarch64__
+  for (; i + 16 <= num_values; i += 16) {
+    __m128i s[8];
+    for (int b = 0; b < 8; ++b) {
+      s[b] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + b * num_values + i));
+    }
+    // Interleave pairs of streams: 2-byte groups of values 0-7 and 8-15.
+    __m128i lo[4];
+    __m128i hi[4];
+    for (int p = 0; p < 4; ++p) {
+      lo[p] = _mm_unpacklo_epi8(s[2 * p], s[2 * p + 1]);
+      hi[p] = _mm_unpackhi_epi8(s[2 * p], s[2 * p + 1]);
+    }
+    // 4-byte groups of values 0-3, 4-7, 8-11 and 12-15, for bytes 0-3 and 4-7.
+    const __m128i a0 = _mm_unpacklo_epi16(lo[0], lo[1]);
+    const __m128i a1 = _mm_unpackhi_epi16(lo[0], lo[1]);
+    const __m128i a2 = _mm_unpacklo_epi16(hi[0], hi[1]);
+    const __m128i a3 = _mm_unpackhi_epi16(hi[0], hi[1]);
+    const __m128i b0 = _mm_unpacklo_epi16(lo[2], lo[3]);
+    const __m128i b1 = _mm_unpackhi_epi16(lo[2], lo[3]);
+    const __m128i b2 = _mm_unpacklo_epi16(hi[2], hi[3]);
+    const __m128i b3 = _mm_unpackhi_epi16(hi[2], hi[3]);
+    __m128i* dst = reinterpret_cast<__m128i*>(out + i * 8);
+    _mm_storeu_si128(dst, _mm_unpacklo_epi32(a0, b0));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi32(a0, b0));
+    _mm_storeu_si128(dst + 2, _mm_unpacklo_epi32(a1, b1));
+    _mm_storeu_si128(dst + 3, _mm_unpackhi_epi32(a1, b1));
+    _mm_storeu_si128(dst + 4, _mm_unpacklo_epi32(a2, b2));
+    _mm_storeu_si128(dst + 5, _mm_unpackhi_epi32(a2, b2));
+    _mm_storeu_si128(dst + 6, _mm_unpacklo_epi32(a3, b3));
+    _mm_storeu_si128(dst + 7, _mm_unpackhi_epi32(a3, b3));
+  }
+#endif
+  return i;
+}
+
+}
+
+void ParquetByteStreamSplit::Decode(const uint8_t* __restrict__ in, int64_t num_values,
+    int width, uint8_t* __restrict__ out) {
+  DCHECK_GT(width, 0);
+  switch (width) {
+    case 4:
+      DecodeScalar<4>(in, Decode4(in, num_values, out), num_values, out);
+      break;
+    case 8:
+      DecodeScalar<8>(in, Decode8(in, num_values, out), num_values, out);
+      break;
+    default:
+      for (int64_t i = 0; i < num_values; ++i) {
+        for (int b = 0; b < width; ++b) out[i * width + b] = in[b * num_values + i];
+      }
+  }
+}
+
+void ParquetByteStreamSplit::Encode(const uint8_t* __restrict__ in, int64_t num_values,
+    int width, uint8_t* __restrict__ out) {
+  DCHECK_GT(width, 0);
+  for (int b = 0; b < width; ++b) {
+    uint8_t* stream = out + b * num_values;
+    for (int64_t i = 0; i < num_values; ++i) stream[i] = in[i * width + b];
+  }
+}
+
+}
@@ -0,0 +1,44 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+namespace impala {
+
+/// The BYTE_STREAM_SPLIT encoding of fixed width values. For values of 'width' bytes,
+/// byte i of every value is stored in stream i, and the 'width' streams are concatenated.
+/// The encoding does not reduce the size of the data, but makes it compress better, in
+/// particular for floating point values.
+///
+/// Values of 4 and 8 bytes, i.e. FLOAT, DOUBLE, INT32 and INT64, are interleaved 16 at a
+/// time with SSE2 byte unpacking. Other widths use a scalar loop.
+class ParquetByteStreamSplit {
+ public:
+  /// Decodes the 'num_values' values of 'width' bytes at 'in' to their PLAIN encoding
+  /// at 'out'. 'in' and 'out' must not overlap.
+  static void Decode(const uint8_t* __restrict__ in, int64_t num_values, int width,
+      uint8_t* __restrict__ out);
+
+  /// Encodes the 'num_values' PLAIN encoded values of 'width' bytes at 'in' to 'out'.
+  /// 'in' and 'out' must not overlap.
+  static void Encode(const uint8_t* __restrict__ in, int64_t num_values, int width,
+      uint8_t* __restrict__ out);
+};
+
+}
@@ -19,10 +19,13 @@
 
 #include <string>
 
+#include "runtime/exec-env.h"
 #include "runtime/mem-pool.h"
 #include "runtime/runtime-state.h"
 #include "runtime/scoped-buffer.h"
 #include "util/codec.h"
+#include "util/promise.h"
+#include "util/thread-pool.h"
 
 #include "common/names.h"
 
@@ -43,6 +46,32 @@ static bool RequiresSkippedDictionaryHeaderCheck(
   return v.VersionEq(1,1,0) || (v.VersionEq(1,2,0) && v.is_impala_internal);
 }
 
+struct ParquetColumnChunkReader::PrefetchedPage {
+  explicit PrefetchedPage(MemTracker* mem_tracker)
+    : compressed_pool(mem_tracker), data_pool(mem_tracker) {}
+
+  ~PrefetchedPage() {
+    compressed_pool.FreeAll();
+    data_pool.FreeAll();
+  }
+
+  parquet::PageHeader header;
+
+  /// Holds the copy of the compressed page data.
+  MemPool compressed_pool;
+  uint8_t* compressed_data = nullptr;
+
+  /// Holds the decompressed page data.
+  MemPool data_pool;
+  uint8_t* data = nullptr;
+
+  /// Number of bytes produced by the decompressor. Set before 'decompress_status'.
+  int decompressed_size = 0;
+
+  /// Set by the decompression task when it is done.
+  Promise<Status> decompress_status;
+};
+
 ParquetColumnChunkReader::ParquetColumnChunkReader(HdfsParquetScanner* parent,
     string schema_name, int slot_id, ValueMemoryType value_mem_type)
   : parent_(parent),
@@ -54,14 +83,31 @@ ParquetColumnChunkReader::ParquetColumnChunkReader(HdfsParquetScanner* parent,
 {
 }
 
-ParquetColumnChunkReader::~ParquetColumnChunkReader() {}
+ParquetColumnChunkReader::~ParquetColumnChunkReader() {
+  ClearPrefetchedPages();
+}
 
 Status ParquetColumnChunkReader::InitColumnChunk(const HdfsFileDesc& file_desc,
     const parquet::ColumnChunk& col_chunk, int row_group_idx,
     std::vector<io::ScanRange::SubRange>&& sub_ranges) {
+  ClearPrefetchedPages();
+  decompress_ahead_pages_ = 0;
   if (col_chunk.meta_data.codec != parquet::CompressionCodec::UNCOMPRESSED) {
-    RETURN_IF_ERROR(Codec::CreateDecompressor(nullptr, false,
-        ConvertParquetToImpalaCodec(col_chunk.meta_data.codec), &decompressor_));
+    const THdfsCompression::type codec =
+        ConvertParquetToImpalaCodec(col_chunk.meta_data.codec);
+    RETURN_IF_ERROR(Codec::CreateDecompressor(nullptr, false, codec, &decompressor_));
+
+    const int ahead_pages =
+        parent_->state_->query_options().parquet_decompress_ahead_pages;
+    if (ahead_pages > 0 && value_mem_type_ != ValueMemoryType::NO_SLOT_DESC
+        && ExecEnv::GetInstance()->parquet_decompression_pool() != nullptr) {
+      for (int i = 0; i < ahead_pages; ++i) {
+        boost::scoped_ptr<Codec> decompressor;
+        RETURN_IF_ERROR(Codec::CreateDecompressor(nullptr, false, codec, &decompressor));
+        prefetch_decompressors_.emplace_back(decompressor.release());
+      }
+      decompress_ahead_pages_ = ahead_pages;
+    }
   }
 
   RETURN_IF_ERROR(page_reader_.InitColumnChunk(file_desc, col_chunk,
@@ -71,6 +117,7 @@ Status ParquetColumnChunkReader::InitColumnChunk(const HdfsFileDesc& file_desc,
 }
 
 void ParquetColumnChunkReader::Close(MemPool* mem_pool) {
+  ClearPrefetchedPages();
   if (mem_pool != nullptr && value_mem_type_ == ValueMemoryType::VAR_LEN_STR) {
     mem_pool->AcquireData(data_page_pool_.get(), false);
   } else {
@@ -209,6 +256,17 @@ Status ParquetColumnChunkReader::ReadNextDataPage(bool* eos, uint8_t** data,
   // be called after we know that the first page is not a dictionary page. Therefore, if
   // we find a dictionary page, it is an error in the parquet file and we return a non-ok
   // status (returned by page_reader_.ReadPageHeader()).
+  if (UsePipeline()) {
+    FillPrefetchQueue();
+    if (!prefetched_pages_.empty() || !prefetch_status_.ok()) {
+      return ReadNextPrefetchedDataPage(eos, data, data_size);
+    }
+    // The end of the stream was reached or reading ahead was disabled. In the latter
+    // case 'page_reader_' may already hold the header of the next data page.
+  }
+  current_page_is_prefetched_ = false;
+  current_prefetched_page_.reset();
+
   bool next_data_page_found = false;
   while (!next_data_page_found) {
     RETURN_IF_ERROR(page_reader_.ReadPageHeader(eos));
@@ -261,11 +319,7 @@ Status ParquetColumnChunkReader::ReadDataPageData(uint8_t** data, int* data_size
     }
     *data = decompressed_buffer;
 
-    if (has_slot_desc) {
-      parent_->scan_node_->UpdateBytesRead(slot_id_, uncompressed_size, compressed_size);
-      parent_->UpdateUncompressedPageSizeCounter(uncompressed_size);
-      parent_->UpdateCompressedPageSizeCounter(compressed_size);
-    }
+    if (has_slot_desc) UpdateDataPageCounters(uncompressed_size, compressed_size);
   } else {
     if (compressed_size != uncompressed_size) {
       return Status(Substitute("Error reading data page in file '$0'. "
@@ -287,15 +341,137 @@ Status ParquetColumnChunkReader::ReadDataPageData(uint8_t** data, int* data_size
     } else {
       *data = compressed_data;
     }
-    if (has_slot_desc) {
-      parent_->scan_node_->UpdateBytesRead(slot_id_, uncompressed_size, 0);
-      parent_->UpdateUncompressedPageSizeCounter(uncompressed_size);
+    if (has_slot_desc) UpdateDataPageCounters(uncompressed_size, 0);
+  }
+
+  return Status::OK();
+}
+
+void ParquetColumnChunkReader::UpdateDataPageCounters(
+    int uncompressed_size, int compressed_size) {
+  parent_->scan_node_->UpdateBytesRead(slot_id_, uncompressed_size, compressed_size);
+  parent_->UpdateUncompressedPageSizeCounter(uncompressed_size);
+  if (compressed_size > 0) parent_->UpdateCompressedPageSizeCounter(compressed_size);
+}
+
+void ParquetColumnChunkReader::FillPrefetchQueue() {
+  while (prefetch_status_.ok() && !prefetch_eos_ && !prefetch_disabled_
+      && static_cast<int>(prefetched_pages_.size()) < decompress_ahead_pages_) {
+    bool eos;
+    prefetch_status_ = page_reader_.ReadPageHeader(&eos);
+    if (!prefetch_status_.ok()) return;
+    if (eos) {
+      prefetch_eos_ = true;
+      return;
+    }
+    if (page_reader_.CurrentPageHeader().type != parquet::PageType::DATA_PAGE) {
+      // We can safely skip non-data pages
+      prefetch_status_ = SkipPageData();
+      continue;
+    }
+    if (!PrefetchDataPage(&prefetch_status_)) {
+      VLOG_FILE << "Could not allocate memory to decompress ahead a data page of "
+                << schema_name_ << " in file " << filename();
+      prefetch_disabled_ = true;
     }
   }
+}
+
+bool ParquetColumnChunkReader::PrefetchDataPage(Status* status) {
+  const parquet::PageHeader& header = page_reader_.CurrentPageHeader();
+  std::unique_ptr<PrefetchedPage> page(
+      new PrefetchedPage(parent_->scan_node_->mem_tracker()));
+  page->compressed_data = page->compressed_pool.TryAllocate(header.compressed_page_size);
+  page->data = page->data_pool.TryAllocate(header.uncompressed_page_size);
+  if (page->compressed_data == nullptr || page->data == nullptr) return false;
+
+  // Copy the compressed data, the I/O buffers may be recycled before the decompression
+  // task runs.
+  uint8_t* compressed_data;
+  *status = page_reader_.ReadPageData(&compressed_data);
+  if (!status->ok()) return true;
+  memcpy(page->compressed_data, compressed_data, header.compressed_page_size);
+  page->header = header;
+
+  // Pages are returned in order and at most 'decompress_ahead_pages_' are in flight, so
+  // no decompressor is used by two tasks at the same time.
+  Codec* decompressor =
+      prefetch_decompressors_[num_pages_prefetched_ % decompress_ahead_pages_].get();
+  PrefetchedPage* page_ptr = page.get();
+  prefetched_pages_.push_back(move(page));
+  ++num_pages_prefetched_;
+  boost::function<void()> task = [decompressor, page_ptr]() {
+    int decompressed_size = page_ptr->header.uncompressed_page_size;
+    Status status = decompressor->ProcessBlock32(true,
+        page_ptr->header.compressed_page_size, page_ptr->compressed_data,
+        &decompressed_size, &page_ptr->data);
+    page_ptr->decompressed_size = decompressed_size;
+    page_ptr->decompress_status.Set(status);
+  };
+  // If the pool was shut down, decompress on this thread.
+  if (!ExecEnv::GetInstance()->parquet_decompression_pool()->Offer(task)) task();
+  return true;
+}
 
+Status ParquetColumnChunkReader::ReadNextPrefetchedDataPage(bool* eos, uint8_t** data,
+    int* data_size) {
+  *eos = false;
+  current_page_is_prefetched_ = false;
+  current_prefetched_page_.reset();
+  if (prefetched_pages_.empty()) {
+    DCHECK(!prefetch_status_.ok());
+    return prefetch_status_;
+  }
+  std::unique_ptr<PrefetchedPage> page = move(prefetched_pages_.front());
+  prefetched_pages_.pop_front();
+  Status status;
+  {
+    // Only the time the scanner thread is blocked on decompression is counted.
+    SCOPED_TIMER(parent_->decompress_timer_);
+    status = page->decompress_status.Get();
+  }
+  RETURN_IF_ERROR(status);
+  const parquet::PageHeader& header = page->header;
+  VLOG_FILE << "Decompressed " << header.compressed_page_size
+            << " to " << page->decompressed_size;
+  if (header.uncompressed_page_size != page->decompressed_size) {
+    return Status(Substitute("Error decompressing data page in file '$0'. "
+        "Expected $1 uncompressed bytes but got $2", filename(),
+        header.uncompressed_page_size, page->decompressed_size));
+  }
+  data_page_pool_->AcquireData(&page->data_pool, false);
+  page->compressed_pool.FreeAll();
+  *data = page->data;
+  *data_size = header.uncompressed_page_size;
+  UpdateDataPageCounters(header.uncompressed_page_size, header.compressed_page_size);
+  COUNTER_ADD(parent_->num_pages_decompressed_ahead_counter_, 1);
+  current_prefetched_header_ = header;
+  current_page_is_prefetched_ = true;
+  current_prefetched_page_ = move(page);
+
+  // Keep the pipeline full while the caller decodes this page.
+  FillPrefetchQueue();
   return Status::OK();
 }
 
+void ParquetColumnChunkReader::ClearPrefetchedPages() {
+  // The decompression tasks reference the pages, so they must finish first.
+  for (std::unique_ptr<PrefetchedPage>& page : prefetched_pages_) {
+    discard_result(page->decompress_status.Get());
+  }
+  prefetched_pages_.clear();
+  current_prefetched_page_.reset();
+  current_page_is_prefetched_ = false;
+  for (std::unique_ptr<Codec>& decompressor : prefetch_decompressors_) {
+    decompressor->Close();
+  }
+  prefetch_decompressors_.clear();
+  num_pages_prefetched_ = 0;
+  prefetch_eos_ = false;
+  prefetch_disabled_ = false;
+  prefetch_status_ = Status::OK();
+}
+
 Status ParquetColumnChunkReader::AllocateUncompressedDataPage(int64_t size,
     const char* err_ctx, uint8_t** buffer) {
   *buffer = data_page_pool_->TryAllocate(size);
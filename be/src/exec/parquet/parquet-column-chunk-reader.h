@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <deque>
+#include <memory>
+#include <vector>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "exec/parquet/hdfs-parquet-scanner.h"
@@ -32,6 +36,18 @@ class ScopedBuffer;
 /// and the possible copying of the data buffers.
 /// Before reading, InitColumnChunk(), set_io_reservation() and StartScan() must be called
 /// in this order.
+///
+/// ---- Decompression pipeline ----
+/// If the column chunk is compressed and the query option parquet_decompress_ahead_pages
+/// is N > 0, ReadNextDataPage() keeps up to N data pages in flight: their headers are
+/// read and the compressed data is copied out of the I/O buffers, then the pages are
+/// decompressed on ExecEnv's parquet decompression thread pool while the scanner thread
+/// decodes the current page. The pages are handed out in file order. Each in-flight page
+/// owns its buffers in MemPools that are tracked by the scan node's MemTracker, like
+/// 'data_page_pool_'. When a page is returned, its buffer is transferred to
+/// 'data_page_pool_', so the memory management of returned pages is unchanged. If
+/// memory for a page cannot be allocated, pages are read and decompressed synchronously
+/// again once the in-flight pages have been returned.
 class ParquetColumnChunkReader {
  public:
 
@@ -53,10 +69,14 @@ class ParquetColumnChunkReader {
   const char* filename() const { return parent_->filename(); }
 
   const parquet::PageHeader& CurrentPageHeader() const {
+    // If the pipeline is active, 'page_reader_' is already positioned after the page
+    // that was returned last.
+    if (current_page_is_prefetched_) return current_prefetched_header_;
     return page_reader_.CurrentPageHeader();
   }
 
   io::ScanRange* scan_range() const { return page_reader_.scan_range(); }
+  void SetPreloadedBuffer(uint8_t* buffer) { page_reader_.SetPreloadedBuffer(buffer); }
   parquet::PageType::type page_type() const { return CurrentPageHeader().type; }
   ScannerContext::Stream* stream() const { return page_reader_.stream(); }
 
@@ -80,6 +100,7 @@ class ParquetColumnChunkReader {
   void set_io_reservation(int bytes) {
     io_reservation_ = bytes;
   }
+  int64_t io_reservation() const { return io_reservation_; }
 
   /// Starts the column scan range. InitColumnChunk() has to have been called and the
   /// reader must have a reservation assigned via set_io_reservation(). This must be
@@ -126,6 +147,14 @@ class ParquetColumnChunkReader {
   /// resources.
   void ReleaseResourcesOfLastPage(MemPool& mem_pool);
 
+  /// Allocates 'size' bytes for the decoded values of the current data page from
+  /// 'data_page_pool_', so that they are released with the page or attached to batches
+  /// like its data. On success, 'buffer' points to the allocated memory. Otherwise an
+  /// error status is returned.
+  Status AllocateDecodedDataPage(int64_t size, uint8_t** buffer) {
+    return AllocateUncompressedDataPage(size, "decoded values", buffer);
+  }
+
  private:
   HdfsParquetScanner* parent_;
   std::string schema_name_;
@@ -167,7 +196,70 @@ class ParquetColumnChunkReader {
   Status AllocateUncompressedDataPage(
       int64_t size, const char* err_ctx, uint8_t** buffer);
 
+  /// Updates the scanner's byte and page size counters for a data page that was read.
+  void UpdateDataPageCounters(int uncompressed_size, int compressed_size);
+
   ValueMemoryType value_mem_type_;
+
+  /// A data page that is decompressed ahead of time. Defined in the .cc file.
+  struct PrefetchedPage;
+
+  /// Maximum number of in-flight pages. 0 if the pipeline is disabled for this column
+  /// chunk. Set by InitColumnChunk().
+  int decompress_ahead_pages_ = 0;
+
+  /// In-flight pages in file order.
+  std::deque<std::unique_ptr<PrefetchedPage>> prefetched_pages_;
+
+  /// One decompressor per in-flight page, since the Codecs are not thread-safe. The
+  /// i-th page read ahead in the column chunk uses decompressor i % N.
+  std::vector<std::unique_ptr<Codec>> prefetch_decompressors_;
+
+  /// Number of pages read ahead so far in the column chunk.
+  int64_t num_pages_prefetched_ = 0;
+
+  /// Set when 'page_reader_' reached the end of the stream while reading ahead.
+  bool prefetch_eos_ = false;
+
+  /// Error hit while reading ahead. Returned once the pages before it have been
+  /// returned, so the caller sees the same sequence as with synchronous reading.
+  Status prefetch_status_;
+
+  /// Set if memory for an in-flight page could not be allocated. No more pages are read
+  /// ahead in this column chunk.
+  bool prefetch_disabled_ = false;
+
+  /// Header of the page returned last by the pipeline and whether it is valid.
+  parquet::PageHeader current_prefetched_header_;
+  bool current_page_is_prefetched_ = false;
+
+  /// The page returned last by the pipeline. Its buffers have been transferred to
+  /// 'data_page_pool_', but it is kept alive until the next page is returned because a
+  /// returned empty page points into its MemPool.
+  std::unique_ptr<PrefetchedPage> current_prefetched_page_;
+
+  /// True if ReadNextDataPage() should use the pipeline.
+  bool UsePipeline() const {
+    return decompress_ahead_pages_ > 0
+        && (!prefetched_pages_.empty() || !prefetch_status_.ok()
+            || (!prefetch_disabled_ && !prefetch_eos_));
+  }
+
+  /// Reads ahead and starts decompressing data pages until 'decompress_ahead_pages_'
+  /// pages are in flight, the end of the stream is reached or an error occurs. Errors
+  /// are stored in 'prefetch_status_'.
+  void FillPrefetchQueue();
+
+  /// Reads the data of the data page whose header was just read by 'page_reader_' and
+  /// submits its decompression. Returns false if the memory for the page could not be
+  /// allocated, in which case nothing was read.
+  bool PrefetchDataPage(Status* status);
+
+  /// Returns the next data page from the pipeline. Same contract as ReadNextDataPage().
+  Status ReadNextPrefetchedDataPage(bool* eos, uint8_t** data, int* data_size);
+
+  /// Waits for all in-flight pages and frees them.
+  void ClearPrefetchedPages();
 };
 
 } // namespace impala
@@ -114,16 +114,27 @@ class ScalarColumnReader : public BaseScalarColumnReader {
   /// conservatively assumes that buffers like 'tuple_mem', 'num_values' or the
   /// 'def_levels_' 'rep_levels_' buffers may alias 'this', especially with
   /// -fno-strict-alias).
-  template <bool IN_COLLECTION, Encoding::type ENCODING, bool NEEDS_CONVERSION>
+  /// PAGE_FILTERING must be equal to DoesPageFiltering(). It is a template argument so
+  /// that the check of the candidate range is compiled out of the per-value loop when
+  /// there is no page filtering, which is the common case.
+  template <bool IN_COLLECTION, Encoding::type ENCODING, bool NEEDS_CONVERSION,
+      bool PAGE_FILTERING>
   bool MaterializeValueBatch(int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
       int* RESTRICT num_values) RESTRICT;
 
   /// Same as above, but dispatches to the appropriate templated implementation of
-  /// MaterializeValueBatch() based on 'page_encoding_' and NeedsConversionInline().
+  /// MaterializeValueBatch() based on 'page_encoding_', NeedsConversionInline() and
+  /// DoesPageFiltering().
   template <bool IN_COLLECTION>
   bool MaterializeValueBatch(int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
       int* RESTRICT num_values) RESTRICT;
 
+  /// Helper for the dispatching MaterializeValueBatch() above, with PAGE_FILTERING
+  /// already resolved.
+  template <bool IN_COLLECTION, bool PAGE_FILTERING>
+  bool MaterializeValueBatch(int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
+      int* RESTRICT num_values) RESTRICT;
+
   /// Fast path for MaterializeValueBatch() that materializes values for a run of
   /// repeated definition levels. Read up to 'max_values' values into 'tuple_mem',
   /// returning the number of values materialised in 'num_values'.
@@ -144,6 +155,13 @@ class ScalarColumnReader : public BaseScalarColumnReader {
   bool ReadSlotsNoConversion(
       int64_t num_to_read, int tuple_size, uint8_t* RESTRICT tuple_mem) RESTRICT;
 
+  /// Read 'num_to_read' dictionary-encoded values into a batch of tuples starting at
+  /// 'tuple_mem', checking the dictionary code of each value against
+  /// 'dict_code_filter_'. Values that are rejected by the filter are set to NULL
+  /// instead of being materialized. Only used if 'page_uses_dict_code_filter_' is true.
+  bool ReadDictCodeFilteredSlots(
+      int64_t num_to_read, int tuple_size, uint8_t* RESTRICT tuple_mem) RESTRICT;
+
   /// Read 'num_to_read' position values into a batch of tuples starting at 'tuple_mem'.
   void ReadPositions(
       int64_t num_to_read, int tuple_size, uint8_t* RESTRICT tuple_mem) RESTRICT;
@@ -318,6 +336,9 @@ Status ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::InitDataPag
   DCHECK(slot_desc_ == nullptr || slot_desc_->type().type != TYPE_BOOLEAN)
       << "Bool has specialized impl";
   page_encoding_ = col_chunk_reader_.encoding();
+  if (ParquetPlainTranscoder::IsSupported(page_encoding_, PARQUET_TYPE)) {
+    RETURN_IF_ERROR(TranscodeDataPage(data, size));
+  }
   if (!IsDictionaryEncoding(page_encoding_)
       && page_encoding_ != parquet::Encoding::PLAIN) {
     return GetUnsupportedDecodingError();
@@ -331,6 +352,8 @@ Status ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::InitDataPag
     }
     RETURN_IF_ERROR(dict_decoder_.SetData(data, size));
   }
+  page_uses_dict_code_filter_ = use_dict_code_filter_
+      && IsDictionaryEncoding(page_encoding_) && slot_desc_ != nullptr;
   // Allocate a temporary buffer to hold InternalType values if we need to convert
   // before writing to the final slot.
   if (NeedsConversionInline() && conversion_buffer_ == nullptr) {
@@ -501,11 +524,13 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::ReadValueBatc
 }
 
 template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
-template <bool IN_COLLECTION, Encoding::type ENCODING, bool NEEDS_CONVERSION>
+template <bool IN_COLLECTION, Encoding::type ENCODING, bool NEEDS_CONVERSION,
+    bool PAGE_FILTERING>
 bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::MaterializeValueBatch(
     int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
     int* RESTRICT num_values) RESTRICT {
   DCHECK(MATERIALIZED || IN_COLLECTION);
+  DCHECK_EQ(PAGE_FILTERING, DoesPageFiltering());
   DCHECK_GT(num_buffered_values_, 0);
   DCHECK(def_levels_.CacheHasNext());
   if (IN_COLLECTION && (pos_slot_desc_ != nullptr || DoesPageFiltering())) {
@@ -517,7 +542,7 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::MaterializeVa
   DCHECK_LE(def_levels_.CacheRemaining(), num_buffered_values_);
   max_values = min(max_values, num_buffered_values_);
   while (def_levels_.CacheHasNext() && val_count < max_values) {
-    if (DoesPageFiltering()) {
+    if (PAGE_FILTERING) {
       int peek_rep_level = IN_COLLECTION ? rep_levels_.PeekLevel() : 0;
       if (RowsRemainingInCandidateRange() == 0 && peek_rep_level == 0) break;
     }
@@ -643,21 +668,35 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::MaterializeVa
     int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
     int* RESTRICT num_values) RESTRICT {
   // Dispatch to the correct templated implementation of MaterializeValueBatch().
+  if (DoesPageFiltering()) {
+    return MaterializeValueBatch<IN_COLLECTION, true>(
+        max_values, tuple_size, tuple_mem, num_values);
+  } else {
+    return MaterializeValueBatch<IN_COLLECTION, false>(
+        max_values, tuple_size, tuple_mem, num_values);
+  }
+}
+
+template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
+template <bool IN_COLLECTION, bool PAGE_FILTERING>
+bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::MaterializeValueBatch(
+    int max_values, int tuple_size, uint8_t* RESTRICT tuple_mem,
+    int* RESTRICT num_values) RESTRICT {
   if (IsDictionaryEncoding(page_encoding_)) {
     if (NeedsConversionInline()) {
-      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN_DICTIONARY, true>(
-          max_values, tuple_size, tuple_mem, num_values);
+      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN_DICTIONARY, true,
+          PAGE_FILTERING>(max_values, tuple_size, tuple_mem, num_values);
     } else {
-      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN_DICTIONARY, false>(
-          max_values, tuple_size, tuple_mem, num_values);
+      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN_DICTIONARY, false,
+          PAGE_FILTERING>(max_values, tuple_size, tuple_mem, num_values);
     }
   } else {
     DCHECK_EQ(page_encoding_, Encoding::PLAIN);
     if (NeedsConversionInline()) {
-      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN, true>(
+      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN, true, PAGE_FILTERING>(
           max_values, tuple_size, tuple_mem, num_values);
     } else {
-      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN, false>(
+      return MaterializeValueBatch<IN_COLLECTION, Encoding::PLAIN, false, PAGE_FILTERING>(
           max_values, tuple_size, tuple_mem, num_values);
     }
   }
@@ -674,6 +713,10 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::ReadSlot(
   InternalType* val_ptr =
       reinterpret_cast<InternalType*>(NEEDS_CONVERSION ? val_buf : slot);
 
+  if (IsDictionaryEncoding(ENCODING) && !NEEDS_CONVERSION
+      && UNLIKELY(page_uses_dict_code_filter_)) {
+    return ReadDictCodeFilteredSlots(1, 0, reinterpret_cast<uint8_t*>(tuple));
+  }
   if (UNLIKELY(!DecodeValue<ENCODING>(&data_, data_end_, val_ptr))) return false;
   if (UNLIKELY(NeedsValidationInline() && !ValidateValue(val_ptr))) {
     if (UNLIKELY(!parent_->parse_status_.ok())) return false;
@@ -727,6 +770,9 @@ template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIAL
 bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::ReadSlotsNoConversion(
     int64_t num_to_read, int tuple_size, uint8_t* RESTRICT tuple_mem) RESTRICT {
   DCHECK(!NeedsConversionInline());
+  if (UNLIKELY(page_uses_dict_code_filter_)) {
+    return ReadDictCodeFilteredSlots(num_to_read, tuple_size, tuple_mem);
+  }
   // No conversion needed - decode directly into the output slots.
   InternalType* first_slot = reinterpret_cast<InternalType*>(tuple_mem + tuple_offset_);
   if (!DecodeValues(tuple_size, num_to_read, first_slot)) return false;
@@ -747,6 +793,38 @@ bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::ReadSlotsNoCo
   return true;
 }
 
+template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
+bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::
+    ReadDictCodeFilteredSlots(
+    int64_t num_to_read, int tuple_size, uint8_t* RESTRICT tuple_mem) RESTRICT {
+  DCHECK(page_uses_dict_code_filter_);
+  DCHECK(!NeedsConversionInline());
+  DCHECK(!NeedsValidationInline());
+  constexpr int BATCH_SIZE = 64;
+  uint32_t indices[BATCH_SIZE];
+  uint8_t* curr_tuple = tuple_mem;
+  while (num_to_read > 0) {
+    int batch_size = std::min<int64_t>(num_to_read, BATCH_SIZE);
+    if (UNLIKELY(!dict_decoder_.GetNextIndices(batch_size, indices))) {
+      SetDictDecodeError();
+      return false;
+    }
+    for (int i = 0; i < batch_size; ++i, curr_tuple += tuple_size) {
+      Tuple* tuple = reinterpret_cast<Tuple*>(curr_tuple);
+      if (dict_code_filter_.Get(indices[i])) {
+        // IMPALA-959: Use memcpy() since slots are not always aligned.
+        memcpy(tuple->GetSlot(tuple_offset_), &dict_decoder_.ValueAt(indices[i]),
+            sizeof(InternalType));
+      } else {
+        tuple->SetNull(null_indicator_offset_);
+        ++num_dict_code_filtered_values_;
+      }
+    }
+    num_to_read -= batch_size;
+  }
+  return true;
+}
+
 template <typename InternalType, parquet::Type::type PARQUET_TYPE, bool MATERIALIZED>
 template <Encoding::type ENCODING>
 bool ScalarColumnReader<InternalType, PARQUET_TYPE, MATERIALIZED>::DecodeValue(
@@ -1308,6 +1386,34 @@ bool BaseScalarColumnReader::SkipTopLevelRows(int64_t num_rows) {
   return SkipEncodedValuesInPage(num_values_to_skip);
 }
 
+bool BaseScalarColumnReader::SkipRows(int64_t num_rows) {
+  DCHECK_EQ(max_rep_level(), 0);
+  DCHECK(!DoesPageFiltering());
+  DCHECK_GE(num_rows, 0);
+  while (num_rows > 0) {
+    if (num_buffered_values_ == 0) {
+      if (!NextPage()) {
+        if (parent_->parse_status_.ok()) {
+          parent_->parse_status_ = Status(Substitute("Corrupt Parquet file '$0': "
+              "column '$1' has fewer values than the other columns of the row group",
+              filename(), schema_element().name));
+        }
+        return false;
+      }
+    }
+    int64_t rows_in_page = min<int64_t>(num_rows, num_buffered_values_);
+    if (!SkipTopLevelRows(rows_in_page)) {
+      if (parent_->parse_status_.ok()) {
+        parent_->parse_status_ = Status(Substitute("Couldn't skip rows in column '$0' "
+            "of file $1.", schema_element().name, filename()));
+      }
+      return false;
+    }
+    num_rows -= rows_in_page;
+  }
+  return true;
+}
+
 int BaseScalarColumnReader::FillPositionsInCandidateRange(int rows_remaining,
     int max_values, uint8_t* RESTRICT tuple_mem, int tuple_size) {
   DCHECK_GT(max_rep_level_, 0);
@@ -1378,6 +1484,25 @@ bool BaseScalarColumnReader::JumpToNextPage() {
   return NextPage();
 }
 
+Status BaseScalarColumnReader::TranscodeDataPage(uint8_t* data, int size) {
+  Status status = plain_transcoder_.Init(page_encoding_, schema_element().type,
+      schema_element().type_length, data, size, num_buffered_values_);
+  uint8_t* plain_data = nullptr;
+  if (status.ok()) {
+    RETURN_IF_ERROR(col_chunk_reader_.AllocateDecodedDataPage(
+        plain_transcoder_.plain_size(), &plain_data));
+    status = plain_transcoder_.Transcode(plain_data);
+  }
+  if (!status.ok()) {
+    return Status(TErrorCode::PARQUET_CORRUPT_ENCODED_VALUES, filename(),
+        PrintThriftEnum(page_encoding_), schema_element().name, status.GetDetail());
+  }
+  data_ = plain_data;
+  data_end_ = plain_data + plain_transcoder_.plain_size();
+  page_encoding_ = parquet::Encoding::PLAIN;
+  return Status::OK();
+}
+
 Status BaseScalarColumnReader::GetUnsupportedDecodingError() {
   return Status(Substitute(
       "File '$0' is corrupt: unexpected encoding: $1 for data page of column '$2'.",
@@ -24,6 +24,8 @@
 #include "exec/parquet/hdfs-parquet-scanner.h"
 #include "exec/parquet/parquet-level-decoder.h"
 #include "exec/parquet/parquet-column-chunk-reader.h"
+#include "exec/parquet/parquet-plain-transcoder.h"
+#include "util/bitmap.h"
 
 namespace impala {
 
@@ -275,6 +277,14 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   virtual void Close(RowBatch* row_batch);
 
   io::ScanRange* scan_range() const { return col_chunk_reader_.scan_range(); }
+
+  /// Makes the scan of the current column chunk return 'buffer', which already holds the
+  /// bytes of scan_range(), instead of reading the file. Must be called before
+  /// StartScan().
+  void SetPreloadedBuffer(uint8_t* buffer) {
+    col_chunk_reader_.SetPreloadedBuffer(buffer);
+  }
+
   int64_t total_len() const { return metadata_->total_compressed_size; }
   int col_idx() const { return node_.col_idx; }
   THdfsCompression::type codec() const {
@@ -282,6 +292,7 @@ class BaseScalarColumnReader : public ParquetColumnReader {
     return ConvertParquetToImpalaCodec(metadata_->codec);
   }
   void set_io_reservation(int bytes) { col_chunk_reader_.set_io_reservation(bytes); }
+  int64_t io_reservation() const { return col_chunk_reader_.io_reservation(); }
 
   /// Reads the next definition and repetition levels for this column. Initializes the
   /// next data page if necessary.
@@ -308,9 +319,12 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   // need to be validated when read from disk.
   virtual bool NeedsValidation() { return false; }
 
-  // TODO: Some encodings might benefit a lot from a SkipValues(int num_rows) if
-  // we know this row can be skipped. This could be very useful with stats and big
-  // sections can be skipped. Implement that when we can benefit from it.
+  /// Skips the next 'num_rows' top-level rows without materializing their values,
+  /// moving on to the following data pages if needed. Used for late materialization.
+  /// Only valid for columns that are not nested in a collection and when page filtering
+  /// is not active. Returns false if execution should be aborted, in which case
+  /// 'parent_->parse_status_' holds the error.
+  bool SkipRows(int64_t num_rows);
 
  protected:
   // Friend parent scanner so it can perform validation (e.g. ValidateEndOfRowGroup())
@@ -337,6 +351,10 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   /// InitDataPage().
   parquet::Encoding::type page_encoding_ = parquet::Encoding::PLAIN_DICTIONARY;
 
+  /// True if 'dict_code_filter_' applies to the values of the current data page. Set in
+  /// InitDataPage().
+  bool page_uses_dict_code_filter_ = false;
+
   /// Num values remaining in the current data page
   int num_buffered_values_ = 0;
 
@@ -350,6 +368,24 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   /// Metadata for the column for the current row group.
   const parquet::ColumnMetaData* metadata_ = nullptr;
 
+  /// Bit i is set if dictionary entry i passes the dictionary filter conjuncts of this
+  /// column. Only valid if 'use_dict_code_filter_' is true. Values of dictionary-encoded
+  /// pages whose bit is not set are materialized as NULL, which the conjuncts are
+  /// guaranteed to reject, so that the rows are dropped without evaluating the conjuncts
+  /// on them. Set by HdfsParquetScanner::EvalDictionaryFilters() for each row group.
+  Bitmap dict_code_filter_{0};
+
+  /// True if 'dict_code_filter_' is valid for the current row group.
+  bool use_dict_code_filter_ = false;
+
+  /// Number of values rejected by 'dict_code_filter_' since the last time the parent
+  /// scanner's counter was updated.
+  int64_t num_dict_code_filtered_values_ = 0;
+
+  /// Decodes data pages with encodings that are not read directly to PLAIN values.
+  /// See TranscodeDataPage().
+  ParquetPlainTranscoder plain_transcoder_;
+
 
   /////////////////////////////////////////
   /// BEGIN: Members used for page filtering
@@ -435,6 +471,12 @@ class BaseScalarColumnReader : public ParquetColumnReader {
   /// 'size' bytes remaining.
   virtual Status InitDataPage(uint8_t* data, int size) = 0;
 
+  /// Decodes the 'size' bytes of values at 'data' of the current data page, which use
+  /// an encoding supported by ParquetPlainTranscoder, to their PLAIN encoding. Points
+  /// 'data_' and 'data_end_' to the PLAIN values and sets 'page_encoding_' to PLAIN.
+  /// Called from InitDataPage().
+  Status TranscodeDataPage(uint8_t* data, int size);
+
   ParquetColumnChunkReader::ValueMemoryType PageReaderValueMemoryType() {
     if (slot_desc_ == nullptr) {
       return ParquetColumnChunkReader::ValueMemoryType::NO_SLOT_DESC;
@@ -253,6 +253,7 @@ ParquetTimestampDecoder::ParquetTimestampDecoder(const parquet::SchemaElement& e
   DCHECK(valid_schema); // Invalid schemas should be rejected in an earlier step.
   if (e.type == parquet::Type::INT96 && convert_int96_timestamps) needs_conversion = true;
   if (needs_conversion) timezone_ = timezone;
+  tz_cache_.Reset(timezone_);
 }
 
 void ParquetTimestampDecoder::ConvertMinStatToLocalTime(TimestampValue* v) const {
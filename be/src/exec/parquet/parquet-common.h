@@ -28,6 +28,7 @@
 #include "runtime/decimal-value.h"
 #include "runtime/string-value.h"
 #include "runtime/timestamp-value.inline.h"
+#include "runtime/timezone-offset-cache.h"
 #include "util/bit-util.h"
 #include "util/decimal-util.h"
 #include "util/mem-util.h"
@@ -745,7 +746,8 @@ public:
 
   void ConvertToLocalTime(TimestampValue* v) const {
     DCHECK(timezone_ != nullptr);
-    if (v->HasDateAndTime()) v->UtcToLocal(*timezone_);
+    DCHECK_EQ(tz_cache_.timezone(), timezone_);
+    if (v->HasDateAndTime()) v->UtcToLocal(&tz_cache_);
   }
 
   /// Timezone conversion of min/max stats need some extra logic because UTC->local
@@ -774,6 +776,10 @@ private:
   /// Timezone used for UTC->Local conversions. If it is UTCPTR, no conversion is needed.
   const Timezone* timezone_ = UTCPTR;
 
+  /// UTC offsets of 'timezone_' around the last converted value. Values of a column are
+  /// often close to each other, so most conversions do not need a lookup in cctz.
+  mutable TimezoneOffsetCache tz_cache_;
+
   /// Unit of the encoded timestamp. Used to decide between milli and microseconds during
   /// INT64 decoding. INT64 with nanosecond precision (and reduced range) is also planned
   /// to be implemented once it is added in Parquet (PARQUET-1387).
@@ -0,0 +1,265 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "exec/parquet/parquet-byte-stream-split.h"
+#include "exec/parquet/parquet-delta-encoding.h"
+#include "exec/parquet/parquet-plain-transcoder.h"
+#include "testutil/gtest-util.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+template <typename T>
+void TestDeltaBinaryPackedRoundTrip(const vector<T>& values) {
+  vector<uint8_t> buffer(
+      ParquetDeltaBinaryPackedEncoder<T>::MaxEncodedSize(values.size()));
+  int64_t len = ParquetDeltaBinaryPackedEncoder<T>::Encode(
+      values.data(), values.size(), buffer.data(), buffer.size());
+  ASSERT_GT(len, 0);
+
+  // Decode in batches of varying sizes.
+  ParquetDeltaBinaryPackedDecoder<T> decoder;
+  ASSERT_TRUE(decoder.Init(buffer.data(), len));
+  EXPECT_EQ(values.size(), decoder.total_values());
+  vector<T> decoded(values.size());
+  int64_t pos = 0;
+  int batch_size = 1;
+  while (pos < values.size()) {
+    int64_t count = min<int64_t>(batch_size, values.size() - pos);
+    ASSERT_TRUE(decoder.GetValues(count, decoded.data() + pos));
+    pos += count;
+    batch_size = batch_size * 3 % 200 + 1;
+  }
+  EXPECT_EQ(values, decoded);
+  EXPECT_EQ(buffer.data() + len, decoder.end());
+  T extra;
+  EXPECT_FALSE(decoder.GetValues(1, &extra));
+}
+
+template <typename T>
+void TestDeltaBinaryPacked() {
+  mt19937 rng(42);
+  for (int num_values : {0, 1, 2, 31, 32, 33, 127, 128, 129, 1000, 5000}) {
+    // Increasing values with small deltas.
+    vector<T> values(num_values);
+    T v = -100;
+    for (T& value : values) {
+      v += rng() % 16;
+      value = v;
+    }
+    TestDeltaBinaryPackedRoundTrip(values);
+
+    // Random values, including the extremes, whose deltas overflow.
+    uniform_int_distribution<T> dist(
+        numeric_limits<T>::min(), numeric_limits<T>::max());
+    for (T& value : values) value = dist(rng);
+    if (num_values > 2) {
+      values[0] = numeric_limits<T>::max();
+      values[1] = numeric_limits<T>::min();
+    }
+    TestDeltaBinaryPackedRoundTrip(values);
+
+    // Constant values.
+    fill(values.begin(), values.end(), 7);
+    TestDeltaBinaryPackedRoundTrip(values);
+  }
+}
+
+TEST(ParquetDeltaEncoding, DeltaBinaryPackedInt32) {
+  TestDeltaBinaryPacked<int32_t>();
+}
+
+TEST(ParquetDeltaEncoding, DeltaBinaryPackedInt64) {
+  TestDeltaBinaryPacked<int64_t>();
+}
+
+/// Decodes data written by another writer: 1, 2, 3, 4, 5 with a block size of 128, 4
+/// miniblocks, a first value of 1, a min delta of 1 and bit widths of 0.
+TEST(ParquetDeltaEncoding, DeltaBinaryPackedKnownData) {
+  const vector<uint8_t> data{0x80, 0x01, 0x04, 0x05, 0x02, 0x02, 0x00, 0x00, 0x00, 0x00};
+  ParquetDeltaBinaryPackedDecoder<int32_t> decoder;
+  ASSERT_TRUE(decoder.Init(data.data(), data.size()));
+  vector<int32_t> decoded(5);
+  ASSERT_TRUE(decoder.GetValues(decoded.size(), decoded.data()));
+  EXPECT_EQ(vector<int32_t>({1, 2, 3, 4, 5}), decoded);
+  EXPECT_EQ(data.data() + data.size(), decoder.end());
+}
+
+TEST(ParquetDeltaEncoding, DeltaBinaryPackedCorrupt) {
+  vector<int64_t> values(300);
+  for (int i = 0; i < values.size(); ++i) values[i] = i * i;
+  vector<uint8_t> buffer(
+      ParquetDeltaBinaryPackedEncoder<int64_t>::MaxEncodedSize(values.size()));
+  int64_t len = ParquetDeltaBinaryPackedEncoder<int64_t>::Encode(
+      values.data(), values.size(), buffer.data(), buffer.size());
+  ASSERT_GT(len, 0);
+  vector<int64_t> decoded(values.size());
+
+  // Truncated data.
+  ParquetDeltaBinaryPackedDecoder<int64_t> decoder;
+  ASSERT_TRUE(decoder.Init(buffer.data(), len / 2));
+  EXPECT_FALSE(decoder.GetValues(values.size(), decoded.data()));
+
+  // Too small buffer for the encoder.
+  EXPECT_EQ(-1, ParquetDeltaBinaryPackedEncoder<int64_t>::Encode(
+      values.data(), values.size(), buffer.data(), len - 1));
+
+  // A block size that is not a multiple of 128.
+  const vector<uint8_t> bad_block_size{0x40, 0x04, 0x05, 0x02};
+  EXPECT_FALSE(decoder.Init(bad_block_size.data(), bad_block_size.size()));
+
+  // A bit width that is larger than the values.
+  const vector<uint8_t> bad_bit_width{0x80, 0x01, 0x04, 0x05, 0x02, 0x02, 0x41, 0x00,
+      0x00, 0x00};
+  ASSERT_TRUE(decoder.Init(bad_bit_width.data(), bad_bit_width.size()));
+  EXPECT_FALSE(decoder.GetValues(5, decoded.data()));
+}
+
+/// Returns the PLAIN encoding of 'values' as BYTE_ARRAY values.
+string PlainEncodeByteArrays(const vector<string>& values) {
+  string plain;
+  for (const string& value : values) {
+    int32_t len = value.size();
+    plain.append(reinterpret_cast<const char*>(&len), sizeof(len));
+    plain.append(value);
+  }
+  return plain;
+}
+
+/// Transcodes the 'len' bytes at 'data' with 'encoding' and returns the PLAIN values.
+Status Transcode(parquet::Encoding::type encoding, parquet::Type::type type,
+    int fixed_len_size, const uint8_t* data, int64_t len, int64_t max_values,
+    string* plain) {
+  ParquetPlainTranscoder transcoder;
+  RETURN_IF_ERROR(
+      transcoder.Init(encoding, type, fixed_len_size, data, len, max_values));
+  vector<uint64_t> out(BitUtil::Ceil(transcoder.plain_size(), sizeof(uint64_t)));
+  RETURN_IF_ERROR(transcoder.Transcode(reinterpret_cast<uint8_t*>(out.data())));
+  plain->assign(reinterpret_cast<const char*>(out.data()), transcoder.plain_size());
+  return Status::OK();
+}
+
+TEST(ParquetDeltaEncoding, DeltaByteArray) {
+  const vector<string> values{"", "apple", "applesauce", "apply", "banana", "band", "",
+      "band", "bandana", "bandanas", string(300, 'x'), string(200, 'x') + "y"};
+  const string plain = PlainEncodeByteArrays(values);
+  const uint8_t* plain_data = reinterpret_cast<const uint8_t*>(plain.data());
+  vector<uint8_t> buffer(
+      ParquetDeltaByteArrayEncoder::MaxEncodedSize(plain.size(), values.size()));
+  int64_t len = ParquetDeltaByteArrayEncoder::Encode(
+      plain_data, plain.size(), values.size(), buffer.data(), buffer.size());
+  ASSERT_GT(len, 0);
+  // The shared prefixes are not stored.
+  EXPECT_LT(len, plain.size());
+
+  string transcoded;
+  ASSERT_OK(Transcode(parquet::Encoding::DELTA_BYTE_ARRAY, parquet::Type::BYTE_ARRAY, 0,
+      buffer.data(), len, values.size(), &transcoded));
+  EXPECT_EQ(plain, transcoded);
+
+  // More values than the page has.
+  EXPECT_FALSE(Transcode(parquet::Encoding::DELTA_BYTE_ARRAY, parquet::Type::BYTE_ARRAY,
+      0, buffer.data(), len, values.size() - 1, &transcoded).ok());
+  // Truncated suffixes.
+  EXPECT_FALSE(Transcode(parquet::Encoding::DELTA_BYTE_ARRAY, parquet::Type::BYTE_ARRAY,
+      0, buffer.data(), len - 1, values.size(), &transcoded).ok());
+}
+
+TEST(ParquetDeltaEncoding, DeltaByteArrayFixedLen) {
+  const vector<string> values{"abcd", "abce", "abce", "xbce", "xyzw"};
+  string plain;
+  for (const string& value : values) plain.append(value);
+  const string plain_byte_arrays = PlainEncodeByteArrays(values);
+  vector<uint8_t> buffer(ParquetDeltaByteArrayEncoder::MaxEncodedSize(
+      plain_byte_arrays.size(), values.size()));
+  int64_t len = ParquetDeltaByteArrayEncoder::Encode(
+      reinterpret_cast<const uint8_t*>(plain_byte_arrays.data()),
+      plain_byte_arrays.size(), values.size(), buffer.data(), buffer.size());
+  ASSERT_GT(len, 0);
+
+  string transcoded;
+  ASSERT_OK(Transcode(parquet::Encoding::DELTA_BYTE_ARRAY,
+      parquet::Type::FIXED_LEN_BYTE_ARRAY, 4, buffer.data(), len, values.size(),
+      &transcoded));
+  EXPECT_EQ(plain, transcoded);
+  // Values that do not have the fixed length are rejected.
+  EXPECT_FALSE(Transcode(parquet::Encoding::DELTA_BYTE_ARRAY,
+      parquet::Type::FIXED_LEN_BYTE_ARRAY, 5, buffer.data(), len, values.size(),
+      &transcoded).ok());
+}
+
+TEST(ParquetDeltaEncoding, DeltaLengthByteArray) {
+  const vector<string> values{"foo", "", "barbaz", "qux", string(1000, 'q')};
+  vector<int32_t> lengths;
+  string suffixes;
+  for (const string& value : values) {
+    lengths.push_back(value.size());
+    suffixes.append(value);
+  }
+  vector<uint8_t> buffer(
+      ParquetDeltaBinaryPackedEncoder<int32_t>::MaxEncodedSize(lengths.size())
+      + suffixes.size());
+  int64_t len = ParquetDeltaBinaryPackedEncoder<int32_t>::Encode(
+      lengths.data(), lengths.size(), buffer.data(), buffer.size());
+  ASSERT_GT(len, 0);
+  memcpy(buffer.data() + len, suffixes.data(), suffixes.size());
+  len += suffixes.size();
+
+  string transcoded;
+  ASSERT_OK(Transcode(parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY,
+      parquet::Type::BYTE_ARRAY, 0, buffer.data(), len, values.size(), &transcoded));
+  EXPECT_EQ(PlainEncodeByteArrays(values), transcoded);
+}
+
+TEST(ParquetDeltaEncoding, ByteStreamSplit) {
+  mt19937 rng(7);
+  for (int width : {3, 4, 8, 16}) {
+    for (int num_values : {0, 1, 15, 16, 17, 100, 1023}) {
+      vector<uint8_t> plain(num_values * width);
+      for (uint8_t& b : plain) b = rng();
+      vector<uint8_t> encoded(plain.size());
+      ParquetByteStreamSplit::Encode(plain.data(), num_values, width, encoded.data());
+      for (int i = 0; i < num_values; ++i) {
+        for (int b = 0; b < width; ++b) {
+          ASSERT_EQ(plain[i * width + b], encoded[b * num_values + i]);
+        }
+      }
+      vector<uint8_t> decoded(plain.size());
+      ParquetByteStreamSplit::Decode(encoded.data(), num_values, width, decoded.data());
+      EXPECT_EQ(plain, decoded) << width << " " << num_values;
+    }
+  }
+
+  // Data that is not a multiple of the value size is corrupt.
+  const vector<uint8_t> data(10);
+  string transcoded;
+  EXPECT_FALSE(Transcode(parquet::Encoding::BYTE_STREAM_SPLIT, parquet::Type::DOUBLE, 0,
+      data.data(), data.size(), 10, &transcoded).ok());
+  EXPECT_OK(Transcode(parquet::Encoding::BYTE_STREAM_SPLIT,
+      parquet::Type::FIXED_LEN_BYTE_ARRAY, 5, data.data(), data.size(), 10,
+      &transcoded));
+}
+
+}
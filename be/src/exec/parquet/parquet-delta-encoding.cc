@@ -0,0 +1,245 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-delta-encoding.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "util/bit-stream-utils.inline.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+template <typename T>
+bool ParquetDeltaBinaryPackedDecoder<T>::Init(const uint8_t* data, int64_t len) {
+  reader_.Reset(data, len);
+  data_end_ = data + len;
+  uint32_t block_size;
+  uint32_t num_miniblocks;
+  uint64_t total_values;
+  T first_value;
+  if (!reader_.GetUleb128(&block_size) || !reader_.GetUleb128(&num_miniblocks)
+      || !reader_.GetUleb128(&total_values) || !reader_.GetZigZagInteger(&first_value)) {
+    return false;
+  }
+  // The block size must be a multiple of 128 and the number of values in a miniblock a
+  // multiple of 32.
+  if (block_size == 0 || block_size % 128 != 0 || num_miniblocks == 0
+      || block_size % num_miniblocks != 0) {
+    return false;
+  }
+  values_per_miniblock_ = block_size / num_miniblocks;
+  if (values_per_miniblock_ % 32 != 0
+      || values_per_miniblock_ > MAX_VALUES_PER_MINIBLOCK
+      || total_values > numeric_limits<int32_t>::max()) {
+    return false;
+  }
+  num_miniblocks_ = num_miniblocks;
+  total_values_ = total_values;
+  num_values_left_ = total_values_;
+  num_deltas_left_ = max<int64_t>(total_values_ - 1, 0);
+  last_value_ = first_value;
+  first_value_pending_ = total_values_ > 0;
+  bit_widths_.resize(num_miniblocks_);
+  deltas_.resize(values_per_miniblock_);
+  // Start with an exhausted block and miniblock.
+  miniblock_idx_ = num_miniblocks_;
+  num_deltas_ = 0;
+  delta_idx_ = 0;
+  return true;
+}
+
+template <typename T>
+bool ParquetDeltaBinaryPackedDecoder<T>::InitBlock() {
+  T min_delta;
+  if (UNLIKELY(!reader_.GetZigZagInteger(&min_delta))) return false;
+  min_delta_ = min_delta;
+  for (uint32_t i = 0; i < num_miniblocks_; ++i) {
+    if (UNLIKELY(!reader_.GetBytes(1, &bit_widths_[i]))) return false;
+  }
+  miniblock_idx_ = 0;
+  return true;
+}
+
+template <typename T>
+bool ParquetDeltaBinaryPackedDecoder<T>::InitMiniBlock() {
+  DCHECK_GT(num_deltas_left_, 0);
+  if (miniblock_idx_ == num_miniblocks_ && UNLIKELY(!InitBlock())) return false;
+  const int bit_width = bit_widths_[miniblock_idx_++];
+  if (UNLIKELY(bit_width > sizeof(T) * 8)) return false;
+  const int num_to_unpack = min<int64_t>(values_per_miniblock_, num_deltas_left_);
+  if (UNLIKELY(reader_.UnpackBatch(bit_width, num_to_unpack, deltas_.data())
+          != num_to_unpack)) {
+    return false;
+  }
+  if (num_to_unpack < values_per_miniblock_) {
+    // This is the last miniblock. Skip its padding so that end() points after it. Some
+    // writers do not pad the last miniblock, so the padding may be missing.
+    int64_t padding = static_cast<int64_t>(bit_width) * values_per_miniblock_ / 8
+        - BitUtil::Ceil(static_cast<int64_t>(bit_width) * num_to_unpack, 8);
+    padding = min<int64_t>(padding, reader_.bytes_left());
+    const uint8_t* pos = data_end_ - reader_.bytes_left();
+    reader_.Reset(pos + padding, reader_.bytes_left() - padding);
+  }
+  num_deltas_left_ -= num_to_unpack;
+  num_deltas_ = num_to_unpack;
+  delta_idx_ = 0;
+  return true;
+}
+
+template <typename T>
+bool ParquetDeltaBinaryPackedDecoder<T>::GetValues(int64_t count, T* out) {
+  DCHECK_GE(count, 0);
+  if (UNLIKELY(count > num_values_left_)) return false;
+  num_values_left_ -= count;
+  if (count > 0 && first_value_pending_) {
+    *out++ = static_cast<T>(last_value_);
+    --count;
+    first_value_pending_ = false;
+  }
+  while (count > 0) {
+    if (delta_idx_ == num_deltas_ && UNLIKELY(!InitMiniBlock())) return false;
+    const int n = min<int64_t>(count, num_deltas_ - delta_idx_);
+    const UnsignedT* deltas = deltas_.data() + delta_idx_;
+    const UnsignedT min_delta = min_delta_;
+    UnsignedT value = last_value_;
+    for (int i = 0; i < n; ++i) {
+      value += min_delta + deltas[i];
+      out[i] = static_cast<T>(value);
+    }
+    last_value_ = value;
+    delta_idx_ += n;
+    out += n;
+    count -= n;
+  }
+  return true;
+}
+
+template <typename T>
+int64_t ParquetDeltaBinaryPackedEncoder<T>::MaxEncodedSize(int64_t num_values) {
+  // The header has two 32-bit and two 64-bit ULEB128 values of at most 5 and 10 bytes.
+  constexpr int64_t MAX_HEADER_SIZE = 30;
+  // Each block has its min delta, the bit widths and full miniblocks.
+  constexpr int64_t MAX_BLOCK_SIZE = 10 + NUM_MINIBLOCKS + BLOCK_SIZE * sizeof(T);
+  const int64_t num_blocks = BitUtil::Ceil(max<int64_t>(num_values - 1, 0), BLOCK_SIZE);
+  return MAX_HEADER_SIZE + num_blocks * MAX_BLOCK_SIZE;
+}
+
+template <typename T>
+int64_t ParquetDeltaBinaryPackedEncoder<T>::Encode(
+    const T* values, int64_t num_values, uint8_t* buffer, int buffer_len) {
+  typedef std::make_unsigned_t<T> UnsignedT;
+  DCHECK_GE(num_values, 0);
+  BitWriter writer(buffer, buffer_len);
+  bool ok = writer.PutUleb128<uint32_t>(BLOCK_SIZE)
+      && writer.PutUleb128<uint32_t>(NUM_MINIBLOCKS)
+      && writer.PutUleb128<uint64_t>(num_values)
+      && writer.PutZigZagInteger<T>(num_values > 0 ? values[0] : 0);
+  UnsignedT deltas[BLOCK_SIZE];
+  for (int64_t start = 1; ok && start < num_values; start += BLOCK_SIZE) {
+    const int n = min<int64_t>(BLOCK_SIZE, num_values - start);
+    T min_delta = numeric_limits<T>::max();
+    for (int i = 0; i < n; ++i) {
+      deltas[i] = static_cast<UnsignedT>(values[start + i])
+          - static_cast<UnsignedT>(values[start + i - 1]);
+      min_delta = min(min_delta, static_cast<T>(deltas[i]));
+    }
+    ok &= writer.PutZigZagInteger<T>(min_delta);
+    // The miniblocks after the last one with values are not written, but their bit
+    // widths are, as 0.
+    uint8_t bit_widths[NUM_MINIBLOCKS] = {0};
+    const int num_miniblocks = BitUtil::Ceil(n, VALUES_PER_MINIBLOCK);
+    for (int m = 0; m < num_miniblocks; ++m) {
+      UnsignedT all_bits = 0;
+      for (int i = m * VALUES_PER_MINIBLOCK;
+           i < min(n, (m + 1) * VALUES_PER_MINIBLOCK); ++i) {
+        deltas[i] -= static_cast<UnsignedT>(min_delta);
+        all_bits |= deltas[i];
+      }
+      bit_widths[m] = all_bits == 0 ?
+          0 : sizeof(UnsignedT) * 8 - BitUtil::CountLeadingZeros(all_bits);
+    }
+    for (int m = 0; m < NUM_MINIBLOCKS; ++m) {
+      ok &= writer.PutAligned<uint8_t>(bit_widths[m], 1);
+    }
+    for (int i = 0; ok && i < num_miniblocks * VALUES_PER_MINIBLOCK; ++i) {
+      // The last miniblock is padded with zeros.
+      ok &= writer.PutValue(i < n ? deltas[i] : 0, bit_widths[i / VALUES_PER_MINIBLOCK]);
+    }
+  }
+  if (!ok) return -1;
+  writer.Flush();
+  return writer.bytes_written();
+}
+
+int64_t ParquetDeltaByteArrayEncoder::MaxEncodedSize(
+    int64_t plain_len, int64_t num_values) {
+  return 2 * ParquetDeltaBinaryPackedEncoder<int32_t>::MaxEncodedSize(num_values)
+      + plain_len;
+}
+
+int64_t ParquetDeltaByteArrayEncoder::Encode(const uint8_t* plain, int64_t plain_len,
+    int64_t num_values, uint8_t* buffer, int buffer_len) {
+  vector<int32_t> prefix_lengths(num_values);
+  vector<int32_t> suffix_lengths(num_values);
+  vector<pair<const uint8_t*, int32_t>> suffixes(num_values);
+  const uint8_t* pos = plain;
+  const uint8_t* plain_end = plain + plain_len;
+  const uint8_t* prev = nullptr;
+  int32_t prev_len = 0;
+  for (int64_t i = 0; i < num_values; ++i) {
+    int32_t len;
+    if (plain_end - pos < sizeof(len)) return -1;
+    memcpy(&len, pos, sizeof(len));
+    pos += sizeof(len);
+    if (len < 0 || plain_end - pos < len) return -1;
+    int32_t prefix_len = 0;
+    const int32_t max_prefix_len = min(len, prev_len);
+    while (prefix_len < max_prefix_len && pos[prefix_len] == prev[prefix_len]) {
+      ++prefix_len;
+    }
+    prefix_lengths[i] = prefix_len;
+    suffix_lengths[i] = len - prefix_len;
+    suffixes[i] = make_pair(pos + prefix_len, len - prefix_len);
+    prev = pos;
+    prev_len = len;
+    pos += len;
+  }
+  int64_t written = ParquetDeltaBinaryPackedEncoder<int32_t>::Encode(
+      prefix_lengths.data(), num_values, buffer, buffer_len);
+  if (written < 0) return -1;
+  int64_t suffix_lengths_len = ParquetDeltaBinaryPackedEncoder<int32_t>::Encode(
+      suffix_lengths.data(), num_values, buffer + written, buffer_len - written);
+  if (suffix_lengths_len < 0) return -1;
+  written += suffix_lengths_len;
+  for (const pair<const uint8_t*, int32_t>& suffix : suffixes) {
+    if (buffer_len - written < suffix.second) return -1;
+    memcpy(buffer + written, suffix.first, suffix.second);
+    written += suffix.second;
+  }
+  return written;
+}
+
+template class ParquetDeltaBinaryPackedDecoder<int32_t>;
+template class ParquetDeltaBinaryPackedDecoder<int64_t>;
+template class ParquetDeltaBinaryPackedEncoder<int32_t>;
+template class ParquetDeltaBinaryPackedEncoder<int64_t>;
+}
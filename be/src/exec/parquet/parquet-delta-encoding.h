@@ -0,0 +1,148 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "common/compiler-util.h"
+#include "util/bit-stream-utils.h"
+
+namespace impala {
+
+/// Decoder for the DELTA_BINARY_PACKED encoding of INT32 and INT64 values. The encoded
+/// data starts with a header
+///   <block size> <number of miniblocks per block> <total value count> <first value>
+/// that is followed by blocks of the deltas between consecutive values:
+///   <min delta> <bit width of each miniblock> <miniblocks>
+/// Each miniblock holds the deltas minus <min delta>, bit packed with the bit width of
+/// the miniblock. Miniblocks are unpacked with BitPacking, so the SIMD unpacking kernels
+/// are used when the CPU supports them. Arithmetic on deltas wraps around, like it does
+/// in the writers.
+template <typename T>
+class ParquetDeltaBinaryPackedDecoder {
+ public:
+  static_assert(std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value,
+      "Only INT32 and INT64 values are supported");
+
+  /// Initializes the decoder to read the values encoded in the 'len' bytes at 'data'.
+  /// Returns false if the header is invalid.
+  bool Init(const uint8_t* data, int64_t len) WARN_UNUSED_RESULT;
+
+  /// The total number of values in the encoded data.
+  int64_t total_values() const { return total_values_; }
+
+  /// Decodes the next 'count' values to 'out'. Returns false if fewer than 'count'
+  /// values are left or if the data is corrupt.
+  bool GetValues(int64_t count, T* out) WARN_UNUSED_RESULT;
+
+  /// Returns a pointer to the byte after the encoded values. Only valid once all values
+  /// were decoded.
+  const uint8_t* end() { return data_end_ - reader_.bytes_left(); }
+
+ private:
+  typedef std::make_unsigned_t<T> UnsignedT;
+
+  /// Upper limit for the number of values in a miniblock. The format does not limit it,
+  /// but writers use miniblocks of 32 or 64 values. Larger ones are treated as corrupt
+  /// to bound the size of 'deltas_'.
+  static constexpr uint32_t MAX_VALUES_PER_MINIBLOCK = 1 << 16;
+
+  /// Reads the header of the next block.
+  bool InitBlock();
+
+  /// Unpacks the deltas of the next miniblock to 'deltas_', reading the header of the
+  /// next block first if needed.
+  bool InitMiniBlock();
+
+  BatchedBitReader reader_;
+  const uint8_t* data_end_ = nullptr;
+
+  int64_t total_values_ = 0;
+
+  /// The number of values that were not returned by GetValues() yet.
+  int64_t num_values_left_ = 0;
+
+  /// The number of deltas that were not unpacked yet.
+  int64_t num_deltas_left_ = 0;
+
+  uint32_t num_miniblocks_ = 0;
+  uint32_t values_per_miniblock_ = 0;
+
+  /// The last value returned or, before the first call to GetValues(), the first value.
+  UnsignedT last_value_ = 0;
+
+  /// True if the first value, which is stored in the header, was not returned yet.
+  bool first_value_pending_ = false;
+
+  /// The minimum delta of the current block.
+  UnsignedT min_delta_ = 0;
+
+  /// The bit widths of the miniblocks of the current block and the index of the next
+  /// miniblock to unpack.
+  std::vector<uint8_t> bit_widths_;
+  int miniblock_idx_ = 0;
+
+  /// The unpacked deltas of the current miniblock. 'num_deltas_' of them are valid and
+  /// the next one to apply is at 'delta_idx_'.
+  std::vector<UnsignedT> deltas_;
+  int num_deltas_ = 0;
+  int delta_idx_ = 0;
+};
+
+/// Encoder for the DELTA_BINARY_PACKED encoding, see ParquetDeltaBinaryPackedDecoder.
+/// Writes blocks of 128 values with 4 miniblocks each, like parquet-mr does.
+template <typename T>
+class ParquetDeltaBinaryPackedEncoder {
+ public:
+  static_assert(std::is_same<T, int32_t>::value || std::is_same<T, int64_t>::value,
+      "Only INT32 and INT64 values are supported");
+
+  static constexpr int BLOCK_SIZE = 128;
+  static constexpr int NUM_MINIBLOCKS = 4;
+  static constexpr int VALUES_PER_MINIBLOCK = BLOCK_SIZE / NUM_MINIBLOCKS;
+
+  /// Returns an upper bound of the encoded size of 'num_values' values.
+  static int64_t MaxEncodedSize(int64_t num_values);
+
+  /// Encodes the 'num_values' values at 'values' to 'buffer', which has room for
+  /// 'buffer_len' bytes. Returns the number of bytes written or -1 if 'buffer' is too
+  /// small.
+  static int64_t Encode(
+      const T* values, int64_t num_values, uint8_t* buffer, int buffer_len);
+};
+
+/// Encoder for the DELTA_BYTE_ARRAY encoding of BYTE_ARRAY values. The input is the
+/// PLAIN encoding of the values. The encoded data consists of the lengths of the
+/// prefixes shared with the previous value, their suffix lengths, both
+/// DELTA_BINARY_PACKED encoded, and the concatenated suffixes.
+class ParquetDeltaByteArrayEncoder {
+ public:
+  /// Returns an upper bound of the encoded size of 'num_values' PLAIN encoded values that
+  /// take 'plain_len' bytes.
+  static int64_t MaxEncodedSize(int64_t plain_len, int64_t num_values);
+
+  /// Encodes the 'num_values' PLAIN encoded values in the 'plain_len' bytes at 'plain'
+  /// to 'buffer', which has room for 'buffer_len' bytes. Returns the number of bytes
+  /// written or -1 if 'buffer' is too small or 'plain' is not valid.
+  static int64_t Encode(const uint8_t* plain, int64_t plain_len, int64_t num_values,
+      uint8_t* buffer, int buffer_len);
+};
+
+}
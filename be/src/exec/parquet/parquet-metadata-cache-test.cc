@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-metadata-cache.h"
+
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "exec/hdfs-scan-node-base.h"
+#include "gen-cpp/parquet_types.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/scoped-buffer.h"
+#include "testutil/gtest-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+DECLARE_bool(cache_force_single_shard);
+
+namespace impala {
+
+static const int64_t CAPACITY = 64 * 1024;
+
+class ParquetMetadataCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() override {
+    // Makes the capacity of the cache exact.
+    FLAGS_cache_force_single_shard = true;
+    metrics_.reset(new MetricGroup("parquet-metadata-cache-test"));
+    cache_.reset(new ParquetMetadataCache(CAPACITY, &process_tracker_));
+    ASSERT_OK(cache_->Init(metrics_.get()));
+  }
+
+  virtual void TearDown() override {
+    cache_.reset();
+    EXPECT_EQ(0, process_tracker_.consumption());
+    process_tracker_.Close();
+  }
+
+  /// Returns a file descriptor for 'path' with the given modification time and length.
+  static HdfsFileDesc MakeFileDesc(const string& path, int64_t mtime, int64_t len) {
+    HdfsFileDesc file_desc(path);
+    file_desc.mtime = mtime;
+    file_desc.file_length = len;
+    return file_desc;
+  }
+
+  /// Returns a footer with 'num_row_groups' row groups of one column each.
+  static parquet::FileMetaData MakeFooter(int num_row_groups) {
+    parquet::FileMetaData file_metadata;
+    file_metadata.__set_version(1);
+    file_metadata.__set_num_rows(num_row_groups * 100);
+    file_metadata.__set_created_by("impala version 4.0");
+    parquet::SchemaElement root;
+    root.__set_name("schema");
+    file_metadata.schema.push_back(root);
+    for (int i = 0; i < num_row_groups; ++i) {
+      parquet::RowGroup row_group;
+      row_group.__set_num_rows(100);
+      parquet::ColumnChunk col_chunk;
+      col_chunk.meta_data.path_in_schema.push_back("col");
+      col_chunk.meta_data.__set_data_page_offset(4 + i * 1000);
+      row_group.columns.push_back(col_chunk);
+      file_metadata.row_groups.push_back(row_group);
+    }
+    return file_metadata;
+  }
+
+  int64_t Metric(const string& key) {
+    return metrics_->GetOrCreateChildGroup("parquet-metadata-cache")
+        ->FindMetricForTesting<IntCounter>(key)->GetValue();
+  }
+
+  MemTracker process_tracker_;
+  unique_ptr<MetricGroup> metrics_;
+  unique_ptr<ParquetMetadataCache> cache_;
+};
+
+TEST_F(ParquetMetadataCacheTest, Footer) {
+  HdfsFileDesc file_desc = MakeFileDesc("hdfs://nn/t/f0.parq", 1000, 4096);
+  parquet::FileMetaData footer = MakeFooter(3);
+  parquet::FileMetaData result;
+  EXPECT_FALSE(cache_->LookupFooter(file_desc, &result));
+  cache_->InsertFooter(file_desc, footer);
+  EXPECT_GT(process_tracker_.consumption(),
+      ParquetMetadataCache::EstimateMemoryUsage(footer) - 1);
+  ASSERT_TRUE(cache_->LookupFooter(file_desc, &result));
+  EXPECT_EQ(footer, result);
+  EXPECT_EQ(1, Metric("parquet-metadata-cache.hit-count"));
+  EXPECT_EQ(1, Metric("parquet-metadata-cache.miss-count"));
+
+  // A file that was modified or has a different length must not be served from the
+  // cache.
+  EXPECT_FALSE(cache_->LookupFooter(MakeFileDesc(file_desc.filename, 1001, 4096),
+      &result));
+  EXPECT_FALSE(cache_->LookupFooter(MakeFileDesc(file_desc.filename, 1000, 4097),
+      &result));
+}
+
+TEST_F(ParquetMetadataCacheTest, PageIndex) {
+  HdfsFileDesc file_desc = MakeFileDesc("hdfs://nn/t/f1.parq", 1000, 4096);
+  vector<uint8_t> page_index(100);
+  for (int i = 0; i < page_index.size(); ++i) page_index[i] = i;
+  cache_->InsertPageIndex(file_desc, 1, page_index.data(), page_index.size());
+
+  ScopedBuffer buffer(&process_tracker_);
+  EXPECT_FALSE(cache_->LookupPageIndex(file_desc, 0, &buffer));
+  ASSERT_TRUE(cache_->LookupPageIndex(file_desc, 1, &buffer));
+  ASSERT_EQ(page_index.size(), buffer.Size());
+  EXPECT_EQ(0, memcmp(page_index.data(), buffer.buffer(), page_index.size()));
+  buffer.Release();
+
+  // The footer of the same file is a different entry.
+  parquet::FileMetaData result;
+  EXPECT_FALSE(cache_->LookupFooter(file_desc, &result));
+}
+
+// Entries are evicted once the capacity is exceeded and entries larger than the
+// capacity are not cached at all.
+TEST_F(ParquetMetadataCacheTest, Eviction) {
+  vector<uint8_t> page_index(CAPACITY / 8);
+  for (int i = 0; i < 32; ++i) {
+    cache_->InsertPageIndex(MakeFileDesc(Substitute("f$0.parq", i), 1, 4096), 0,
+        page_index.data(), page_index.size());
+    EXPECT_LE(process_tracker_.consumption(), CAPACITY);
+  }
+  EXPECT_GT(Metric("parquet-metadata-cache.eviction-count"), 0);
+  ScopedBuffer buffer(&process_tracker_);
+  EXPECT_FALSE(cache_->LookupPageIndex(MakeFileDesc("f0.parq", 1, 4096), 0, &buffer));
+  EXPECT_TRUE(cache_->LookupPageIndex(MakeFileDesc("f31.parq", 1, 4096), 0, &buffer));
+  buffer.Release();
+
+  vector<uint8_t> too_large(CAPACITY + 1);
+  cache_->InsertPageIndex(MakeFileDesc("large.parq", 1, 4096), 0, too_large.data(),
+      too_large.size());
+  EXPECT_FALSE(cache_->LookupPageIndex(MakeFileDesc("large.parq", 1, 4096), 0, &buffer));
+}
+
+}
@@ -0,0 +1,200 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-metadata-cache.h"
+
+#include <cstring>
+#include <limits>
+
+#include "exec/hdfs-scan-node-base.h"
+#include "gen-cpp/parquet_types.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/scoped-buffer.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static int64_t StringUsage(const string& s) {
+  return sizeof(string) + s.capacity();
+}
+
+template <typename T>
+static int64_t VectorUsage(const vector<T>& v) {
+  return sizeof(v) + v.capacity() * sizeof(T);
+}
+
+static int64_t KeyValueUsage(const vector<parquet::KeyValue>& key_values) {
+  int64_t usage = VectorUsage(key_values);
+  for (const parquet::KeyValue& kv : key_values) {
+    usage += kv.key.capacity() + kv.value.capacity();
+  }
+  return usage;
+}
+
+static int64_t StatisticsUsage(const parquet::Statistics& stats) {
+  return stats.max.capacity() + stats.min.capacity() + stats.max_value.capacity()
+      + stats.min_value.capacity();
+}
+
+int64_t ParquetMetadataCache::EstimateMemoryUsage(
+    const parquet::FileMetaData& file_metadata) {
+  int64_t usage = sizeof(file_metadata) + StringUsage(file_metadata.created_by);
+  usage += VectorUsage(file_metadata.schema);
+  for (const parquet::SchemaElement& element : file_metadata.schema) {
+    usage += element.name.capacity();
+  }
+  usage += KeyValueUsage(file_metadata.key_value_metadata);
+  usage += VectorUsage(file_metadata.column_orders);
+  usage += VectorUsage(file_metadata.row_groups);
+  for (const parquet::RowGroup& row_group : file_metadata.row_groups) {
+    usage += VectorUsage(row_group.columns) + VectorUsage(row_group.sorting_columns);
+    for (const parquet::ColumnChunk& col_chunk : row_group.columns) {
+      const parquet::ColumnMetaData& col_metadata = col_chunk.meta_data;
+      usage += col_chunk.file_path.capacity();
+      usage += VectorUsage(col_metadata.encodings);
+      usage += VectorUsage(col_metadata.path_in_schema);
+      for (const string& path : col_metadata.path_in_schema) usage += path.capacity();
+      usage += KeyValueUsage(col_metadata.key_value_metadata);
+      usage += StatisticsUsage(col_metadata.statistics);
+      usage += VectorUsage(col_metadata.encoding_stats);
+    }
+  }
+  return usage;
+}
+
+ParquetMetadataCache::ParquetMetadataCache(
+    int64_t capacity, MemTracker* parent_mem_tracker)
+  : capacity_(capacity),
+    mem_tracker_(new MemTracker(-1, "Parquet Metadata Cache", parent_mem_tracker)),
+    cache_(NewCache(Cache::EvictionPolicy::LRU, capacity, "ParquetMetadataCache")) {
+  DCHECK_GT(capacity, 0);
+}
+
+ParquetMetadataCache::~ParquetMetadataCache() {
+  // Frees all entries, which releases their memory from 'mem_tracker_'.
+  cache_.reset();
+  mem_tracker_->Close();
+}
+
+Status ParquetMetadataCache::Init(MetricGroup* metrics) {
+  RETURN_IF_ERROR(cache_->Init());
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("parquet-metadata-cache");
+  hits_ = cache_metrics->AddCounter("parquet-metadata-cache.hit-count", 0);
+  misses_ = cache_metrics->AddCounter("parquet-metadata-cache.miss-count", 0);
+  evictions_ = cache_metrics->AddCounter("parquet-metadata-cache.eviction-count", 0);
+  total_bytes_ = cache_metrics->AddGauge("parquet-metadata-cache.total-bytes", 0);
+  num_entries_ = cache_metrics->AddGauge("parquet-metadata-cache.num-entries", 0);
+  return Status::OK();
+}
+
+string ParquetMetadataCache::MakeKey(EntryType type, const HdfsFileDesc& file_desc,
+    int row_group_idx) {
+  return Substitute("$0:$1:$2:$3:$4", static_cast<char>(type), file_desc.mtime,
+      file_desc.file_length, row_group_idx, file_desc.filename);
+}
+
+bool ParquetMetadataCache::LookupFooter(const HdfsFileDesc& file_desc,
+    parquet::FileMetaData* file_metadata) {
+  const string key = MakeKey(EntryType::FOOTER, file_desc, -1);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle == nullptr) {
+    misses_->Increment(1);
+    return false;
+  }
+  EntryHeader header;
+  memcpy(&header, cache_->Value(handle).data(), sizeof(header));
+  DCHECK(header.metadata != nullptr);
+  *file_metadata = *header.metadata;
+  hits_->Increment(1);
+  return true;
+}
+
+void ParquetMetadataCache::InsertFooter(const HdfsFileDesc& file_desc,
+    const parquet::FileMetaData& file_metadata) {
+  const string key = MakeKey(EntryType::FOOTER, file_desc, -1);
+  EntryHeader header;
+  header.charge = EstimateMemoryUsage(file_metadata) + sizeof(header) + key.size();
+  if (!FitsInCache(header.charge)) return;
+  header.metadata = new parquet::FileMetaData(file_metadata);
+  Insert(key, header, nullptr, 0);
+}
+
+bool ParquetMetadataCache::LookupPageIndex(const HdfsFileDesc& file_desc,
+    int row_group_idx, ScopedBuffer* buffer) {
+  const string key = MakeKey(EntryType::PAGE_INDEX, file_desc, row_group_idx);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle == nullptr) {
+    misses_->Increment(1);
+    return false;
+  }
+  Slice value = cache_->Value(handle);
+  DCHECK_GE(value.size(), sizeof(EntryHeader));
+  const int64_t len = value.size() - sizeof(EntryHeader);
+  if (!buffer->TryAllocate(len)) return false;
+  memcpy(buffer->buffer(), value.data() + sizeof(EntryHeader), len);
+  hits_->Increment(1);
+  return true;
+}
+
+void ParquetMetadataCache::InsertPageIndex(const HdfsFileDesc& file_desc,
+    int row_group_idx, const uint8_t* data, int64_t len) {
+  const string key = MakeKey(EntryType::PAGE_INDEX, file_desc, row_group_idx);
+  EntryHeader header;
+  header.charge = len + sizeof(header) + key.size();
+  if (!FitsInCache(header.charge)) return;
+  header.metadata = nullptr;
+  Insert(key, header, data, len);
+}
+
+void ParquetMetadataCache::Insert(const string& key, EntryHeader header,
+    const uint8_t* data, int64_t len) {
+  Cache::UniquePendingHandle pending(
+      cache_->Allocate(key, sizeof(header) + len, header.charge));
+  if (pending == nullptr) {
+    delete header.metadata;
+    return;
+  }
+  uint8_t* value = cache_->MutableValue(&pending);
+  memcpy(value, &header, sizeof(header));
+  if (len > 0) memcpy(value + sizeof(header), data, len);
+  // EvictedEntry() releases the memory, also when the insertion fails.
+  mem_tracker_->Consume(header.charge);
+  total_bytes_->Increment(header.charge);
+  num_entries_->Increment(1);
+  // Concurrent scanners may insert the same key, the last insertion replaces the
+  // earlier entries.
+  Cache::UniqueHandle handle(cache_->Insert(move(pending), this));
+}
+
+void ParquetMetadataCache::EvictedEntry(Slice key, Slice value) {
+  DCHECK_GE(value.size(), sizeof(EntryHeader));
+  EntryHeader header;
+  memcpy(&header, value.data(), sizeof(header));
+  delete header.metadata;
+  mem_tracker_->Release(header.charge);
+  // The metrics are not set if the cache was never initialized.
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(-header.charge);
+    num_entries_->Increment(-1);
+    evictions_->Increment(1);
+  }
+}
+
+}
@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include "common/status.h"
+#include "util/cache/cache.h"
+#include "util/metrics-fwd.h"
+
+namespace parquet {
+class FileMetaData;
+}
+
+namespace impala {
+
+struct HdfsFileDesc;
+class MemTracker;
+class MetricGroup;
+class ScopedBuffer;
+
+/// Process-wide cache of Parquet file metadata, shared by all scanners of an impalad.
+/// Two kinds of entries are cached:
+/// * Deserialized FileMetaData footers. A hit saves reading the footer when it is
+///   larger than the initial footer scan range and the Thrift deserialization.
+/// * The raw bytes of the page index (column indexes and offset indexes) of a row
+///   group. A hit saves the small, latency-bound read of the page index.
+///
+/// Entries are keyed by the file path, modification time and length, so a file that is
+/// rewritten in place is never served from stale metadata. The cache is bounded by the
+/// capacity given to the constructor and evicts in LRU order. The memory of the entries
+/// is tracked by the cache's own MemTracker, a child of the process MemTracker.
+///
+/// All functions are thread-safe.
+class ParquetMetadataCache : public Cache::EvictionCallback {
+ public:
+  /// 'capacity' is the maximum memory in bytes used by the entries.
+  ParquetMetadataCache(int64_t capacity, MemTracker* parent_mem_tracker);
+  ~ParquetMetadataCache();
+
+  /// Initializes the cache and registers its metrics in 'metrics'.
+  Status Init(MetricGroup* metrics);
+
+  /// Looks up the footer of the file described by 'file_desc'. On a hit, copies it to
+  /// 'file_metadata' and returns true.
+  bool LookupFooter(const HdfsFileDesc& file_desc, parquet::FileMetaData* file_metadata);
+
+  /// Adds the footer 'file_metadata' of the file described by 'file_desc'. Entries
+  /// larger than the capacity are not cached.
+  void InsertFooter(const HdfsFileDesc& file_desc,
+      const parquet::FileMetaData& file_metadata);
+
+  /// Looks up the page index of row group 'row_group_idx' of the file described by
+  /// 'file_desc'. On a hit, allocates 'buffer' and copies the page index to it. Returns
+  /// false on a miss or if 'buffer' cannot be allocated.
+  bool LookupPageIndex(const HdfsFileDesc& file_desc, int row_group_idx,
+      ScopedBuffer* buffer);
+
+  /// Adds the 'len' bytes of page index at 'data' of row group 'row_group_idx'.
+  void InsertPageIndex(const HdfsFileDesc& file_desc, int row_group_idx,
+      const uint8_t* data, int64_t len);
+
+  /// Called by 'cache_' when an entry is evicted or erased.
+  virtual void EvictedEntry(Slice key, Slice value) override;
+
+  /// Returns an estimate of the heap memory used by 'file_metadata'.
+  static int64_t EstimateMemoryUsage(const parquet::FileMetaData& file_metadata);
+
+ private:
+  /// Prefix of the keys of the two kinds of entries.
+  enum class EntryType : char {
+    FOOTER = 'F',
+    PAGE_INDEX = 'P'
+  };
+
+  /// Stored at the start of the value of each entry. 'metadata' is only set for footer
+  /// entries and is owned by the entry. Page index entries are followed by the bytes of
+  /// the page index.
+  struct EntryHeader {
+    int64_t charge;
+    parquet::FileMetaData* metadata;
+  };
+
+  /// Returns true if an entry with charge 'charge' can be added to the cache.
+  bool FitsInCache(int64_t charge) const {
+    return charge <= capacity_ && charge <= std::numeric_limits<int>::max();
+  }
+
+  static std::string MakeKey(EntryType type, const HdfsFileDesc& file_desc,
+      int row_group_idx);
+
+  /// Adds an entry with key 'key' and value 'header' followed by the 'len' bytes of
+  /// 'data' to the cache. Takes ownership of 'header.metadata'.
+  void Insert(const std::string& key, EntryHeader header, const uint8_t* data,
+      int64_t len);
+
+  const int64_t capacity_;
+  std::unique_ptr<MemTracker> mem_tracker_;
+  std::unique_ptr<Cache> cache_;
+
+  /// Metrics of the cache, registered in Init().
+  IntCounter* hits_ = nullptr;
+  IntCounter* misses_ = nullptr;
+  IntCounter* evictions_ = nullptr;
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+}
@@ -95,6 +95,10 @@ static bool IsEncodingSupported(parquet::Encoding::type e) {
     case parquet::Encoding::BIT_PACKED:
     case parquet::Encoding::RLE:
     case parquet::Encoding::RLE_DICTIONARY:
+    case parquet::Encoding::DELTA_BINARY_PACKED:
+    case parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY:
+    case parquet::Encoding::DELTA_BYTE_ARRAY:
+    case parquet::Encoding::BYTE_STREAM_SPLIT:
       return true;
     default:
       return false;
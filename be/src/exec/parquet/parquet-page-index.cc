@@ -17,9 +17,11 @@
 
 #include "common/logging.h"
 #include "exec/parquet/hdfs-parquet-scanner.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/parquet/parquet-page-index.h"
 #include "gutil/strings/substitute.h"
 #include "rpc/thrift-util.h"
+#include "runtime/exec-env.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
 
@@ -75,6 +77,16 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
   // It's not an error if there is no page index.
   if (!has_page_index) return Status::OK();
 
+  const HdfsFileDesc* file_desc = scanner_->scan_node_->GetFileDesc(
+      scanner_->context_->partition_descriptor()->id(), scanner_->filename());
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  if (metadata_cache != nullptr) {
+    if (metadata_cache->LookupPageIndex(*file_desc, row_group_idx, &page_index_buffer_)) {
+      DCHECK_EQ(page_index_buffer_.Size(), column_index_size_ + offset_index_size_);
+      return Status::OK();
+    }
+  }
+
   int64_t scan_range_start = column_index_base_offset_;
   int64_t scan_range_size =
       offset_index_base_offset_ + offset_index_size_ - column_index_base_offset_;
@@ -115,6 +127,10 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
   DCHECK(io_buffer->eosr());
   object_range->ReturnBuffer(move(io_buffer));
 
+  if (metadata_cache != nullptr) {
+    metadata_cache->InsertPageIndex(*file_desc, row_group_idx,
+        page_index_buffer_.buffer(), page_index_buffer_.Size());
+  }
   return Status::OK();
 }
 
@@ -99,6 +99,16 @@ Status ParquetPageReader::InitColumnChunk(const HdfsFileDesc& file_desc,
   return Status::OK();
 }
 
+void ParquetPageReader::SetPreloadedBuffer(uint8_t* buffer) {
+  DCHECK_EQ(state_, State::Initialized);
+  DCHECK(!scan_range_->HasSubRanges());
+  int64_t partition_id = parent_->context_->partition_descriptor()->id();
+  scan_range_ = parent_->scan_node_->AllocateScanRange(scan_range_->fs(), filename(),
+      scan_range_->len(), scan_range_->offset(), partition_id, scan_range_->disk_id(),
+      scan_range_->expected_local(), scan_range_->mtime(),
+      BufferOpts::Preloaded(buffer, scan_range_->len()));
+}
+
 Status ParquetPageReader::StartScan(int io_reservation) {
   DCHECK_EQ(state_, State::Initialized);
   DCHECK_GT(io_reservation, 0);
@@ -43,6 +43,11 @@ class ParquetPageReader {
       const parquet::ColumnChunk& col_chunk, int row_group_idx,
       std::vector<io::ScanRange::SubRange>&& sub_ranges);
 
+  /// Replaces the scan range created by InitColumnChunk() with one that returns
+  /// 'buffer', which already holds the bytes of the column chunk, instead of reading the
+  /// file. Must be called before StartScan().
+  void SetPreloadedBuffer(uint8_t* buffer);
+
   /// Starts the column scan range. InitColumnChunk() needs to be called before this. This
   /// method must be called before any of the column data can be read (including
   /// dictionary and data pages). 'io_reservation' is the amount of reservation assigned
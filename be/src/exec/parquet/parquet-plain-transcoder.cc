@@ -0,0 +1,217 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-plain-transcoder.h"
+
+#include <cstring>
+#include <limits>
+
+#include <gutil/strings/substitute.h>
+
+#include "exec/parquet/parquet-byte-stream-split.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static Status TooManyValuesError(int64_t num_values, int64_t max_values) {
+  return Status(Substitute("$0 values but the page has only $1", num_values, max_values));
+}
+
+bool ParquetPlainTranscoder::IsSupported(
+    parquet::Encoding::type encoding, parquet::Type::type type) {
+  switch (encoding) {
+    case parquet::Encoding::DELTA_BINARY_PACKED:
+      return type == parquet::Type::INT32 || type == parquet::Type::INT64;
+    case parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY:
+      return type == parquet::Type::BYTE_ARRAY;
+    case parquet::Encoding::DELTA_BYTE_ARRAY:
+      return type == parquet::Type::BYTE_ARRAY
+          || type == parquet::Type::FIXED_LEN_BYTE_ARRAY;
+    case parquet::Encoding::BYTE_STREAM_SPLIT:
+      return type == parquet::Type::FLOAT || type == parquet::Type::DOUBLE
+          || type == parquet::Type::INT32 || type == parquet::Type::INT64
+          || type == parquet::Type::FIXED_LEN_BYTE_ARRAY;
+    default:
+      return false;
+  }
+}
+
+Status ParquetPlainTranscoder::Init(parquet::Encoding::type encoding,
+    parquet::Type::type type, int fixed_len_size, const uint8_t* data, int64_t len,
+    int64_t max_values) {
+  DCHECK(IsSupported(encoding, type));
+  encoding_ = encoding;
+  type_ = type;
+  data_ = data;
+  prefix_lengths_.clear();
+  suffix_lengths_.clear();
+  switch (type) {
+    case parquet::Type::INT32:
+    case parquet::Type::FLOAT:
+      value_width_ = sizeof(int32_t);
+      break;
+    case parquet::Type::INT64:
+    case parquet::Type::DOUBLE:
+      value_width_ = sizeof(int64_t);
+      break;
+    case parquet::Type::FIXED_LEN_BYTE_ARRAY:
+      value_width_ = fixed_len_size;
+      break;
+    default:
+      value_width_ = 0;
+  }
+
+  switch (encoding) {
+    case parquet::Encoding::DELTA_BINARY_PACKED: {
+      bool ok = type == parquet::Type::INT32 ? int32_decoder_.Init(data, len) :
+                                               int64_decoder_.Init(data, len);
+      if (!ok) return Status("invalid header");
+      num_values_ = type == parquet::Type::INT32 ? int32_decoder_.total_values() :
+                                                   int64_decoder_.total_values();
+      if (num_values_ > max_values) return TooManyValuesError(num_values_, max_values);
+      plain_size_ = num_values_ * value_width_;
+      return Status::OK();
+    }
+    case parquet::Encoding::BYTE_STREAM_SPLIT:
+      if (value_width_ <= 0 || len % value_width_ != 0) {
+        return Status(Substitute("$0 bytes of data is not a multiple of the $1 byte "
+            "values", len, value_width_));
+      }
+      num_values_ = len / value_width_;
+      if (num_values_ > max_values) return TooManyValuesError(num_values_, max_values);
+      plain_size_ = len;
+      return Status::OK();
+    case parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY:
+      RETURN_IF_ERROR(InitDeltaLengths(data, len, max_values));
+      return InitByteArrayValues();
+    case parquet::Encoding::DELTA_BYTE_ARRAY: {
+      if (!int32_decoder_.Init(data, len)) return Status("invalid prefix lengths header");
+      if (int32_decoder_.total_values() > max_values) {
+        return TooManyValuesError(int32_decoder_.total_values(), max_values);
+      }
+      prefix_lengths_.resize(int32_decoder_.total_values());
+      if (!int32_decoder_.GetValues(prefix_lengths_.size(), prefix_lengths_.data())) {
+        return Status("corrupt prefix lengths");
+      }
+      const uint8_t* suffix_data = int32_decoder_.end();
+      RETURN_IF_ERROR(
+          InitDeltaLengths(suffix_data, data + len - suffix_data, max_values));
+      if (prefix_lengths_.size() != suffix_lengths_.size()) {
+        return Status(Substitute("$0 prefix lengths but $1 suffix lengths",
+            prefix_lengths_.size(), suffix_lengths_.size()));
+      }
+      return InitByteArrayValues();
+    }
+    default:
+      DCHECK(false);
+      return Status("unsupported encoding");
+  }
+}
+
+Status ParquetPlainTranscoder::InitDeltaLengths(
+    const uint8_t* data, int64_t len, int64_t max_values) {
+  if (!int32_decoder_.Init(data, len)) return Status("invalid lengths header");
+  if (int32_decoder_.total_values() > max_values) {
+    return TooManyValuesError(int32_decoder_.total_values(), max_values);
+  }
+  suffix_lengths_.resize(int32_decoder_.total_values());
+  if (!int32_decoder_.GetValues(suffix_lengths_.size(), suffix_lengths_.data())) {
+    return Status("corrupt lengths");
+  }
+  suffixes_ = int32_decoder_.end();
+  int64_t suffixes_len = 0;
+  for (int32_t suffix_len : suffix_lengths_) {
+    if (suffix_len < 0) return Status(Substitute("invalid length $0", suffix_len));
+    suffixes_len += suffix_len;
+  }
+  if (suffixes_len > data + len - suffixes_) {
+    return Status(Substitute("values need $0 bytes but only $1 are left", suffixes_len,
+        data + len - suffixes_));
+  }
+  return Status::OK();
+}
+
+Status ParquetPlainTranscoder::InitByteArrayValues() {
+  num_values_ = suffix_lengths_.size();
+  const bool has_prefixes = !prefix_lengths_.empty();
+  int64_t total_len = 0;
+  int64_t prev_len = 0;
+  for (int64_t i = 0; i < num_values_; ++i) {
+    int64_t prefix_len = has_prefixes ? prefix_lengths_[i] : 0;
+    if (prefix_len < 0 || prefix_len > prev_len) {
+      return Status(Substitute("invalid prefix length $0 for value $1", prefix_len, i));
+    }
+    int64_t value_len = prefix_len + suffix_lengths_[i];
+    if (value_len > numeric_limits<int32_t>::max()) {
+      return Status(Substitute("value $0 is too long: $1 bytes", i, value_len));
+    }
+    if (type_ == parquet::Type::FIXED_LEN_BYTE_ARRAY && value_len != value_width_) {
+      return Status(Substitute("value $0 has $1 bytes instead of $2", i, value_len,
+          value_width_));
+    }
+    total_len += value_len;
+    prev_len = value_len;
+  }
+  // PLAIN encoded BYTE_ARRAY values are prefixed with their length.
+  if (type_ == parquet::Type::BYTE_ARRAY) total_len += num_values_ * sizeof(int32_t);
+  plain_size_ = total_len;
+  return Status::OK();
+}
+
+Status ParquetPlainTranscoder::Transcode(uint8_t* out) {
+  switch (encoding_) {
+    case parquet::Encoding::DELTA_BINARY_PACKED: {
+      bool ok = type_ == parquet::Type::INT32 ?
+          int32_decoder_.GetValues(num_values_, reinterpret_cast<int32_t*>(out)) :
+          int64_decoder_.GetValues(num_values_, reinterpret_cast<int64_t*>(out));
+      if (!ok) return Status("corrupt values");
+      return Status::OK();
+    }
+    case parquet::Encoding::BYTE_STREAM_SPLIT:
+      ParquetByteStreamSplit::Decode(data_, num_values_, value_width_, out);
+      return Status::OK();
+    case parquet::Encoding::DELTA_LENGTH_BYTE_ARRAY:
+    case parquet::Encoding::DELTA_BYTE_ARRAY: {
+      const bool has_prefixes = !prefix_lengths_.empty();
+      const bool add_lengths = type_ == parquet::Type::BYTE_ARRAY;
+      const uint8_t* suffix = suffixes_;
+      const uint8_t* prev = nullptr;
+      for (int64_t i = 0; i < num_values_; ++i) {
+        int32_t prefix_len = has_prefixes ? prefix_lengths_[i] : 0;
+        int32_t suffix_len = suffix_lengths_[i];
+        int32_t value_len = prefix_len + suffix_len;
+        if (add_lengths) {
+          memcpy(out, &value_len, sizeof(value_len));
+          out += sizeof(value_len);
+        }
+        // The prefix is copied from the previous value, which was already written.
+        if (prefix_len > 0) memcpy(out, prev, prefix_len);
+        memcpy(out + prefix_len, suffix, suffix_len);
+        suffix += suffix_len;
+        prev = out;
+        out += value_len;
+      }
+      return Status::OK();
+    }
+    default:
+      DCHECK(false);
+      return Status("unsupported encoding");
+  }
+}
+
+}
@@ -0,0 +1,92 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/status.h"
+#include "exec/parquet/parquet-delta-encoding.h"
+#include "gen-cpp/parquet_types.h"
+
+namespace impala {
+
+/// Decodes the values of a data page that uses DELTA_BINARY_PACKED,
+/// DELTA_LENGTH_BYTE_ARRAY, DELTA_BYTE_ARRAY or BYTE_STREAM_SPLIT encoding to their
+/// PLAIN encoding. The column readers transcode such pages once when they start reading
+/// them and then materialize the values like those of a PLAIN page, which keeps the
+/// per-value code paths of the readers, including skipping values for page filtering
+/// and late materialization, the same for all encodings.
+///
+/// Usage: Init() parses the encoded data and computes plain_size(). The caller allocates
+/// a buffer of plain_size() bytes and passes it to Transcode().
+class ParquetPlainTranscoder {
+ public:
+  /// Returns true if values of physical type 'type' that are encoded with 'encoding' can
+  /// be transcoded.
+  static bool IsSupported(parquet::Encoding::type encoding, parquet::Type::type type);
+
+  /// Parses the 'len' bytes of values at 'data', which are encoded with 'encoding'.
+  /// 'type' is the physical type of the values and 'fixed_len_size' the size of
+  /// FIXED_LEN_BYTE_ARRAY values. 'data' must stay valid until Transcode() is called.
+  /// Returns an error if the data is corrupt or has more than 'max_values' values.
+  Status Init(parquet::Encoding::type encoding, parquet::Type::type type,
+      int fixed_len_size, const uint8_t* data, int64_t len,
+      int64_t max_values) WARN_UNUSED_RESULT;
+
+  /// The number of values in the page. Valid after Init().
+  int64_t num_values() const { return num_values_; }
+
+  /// The size of the PLAIN encoding of the values. Valid after Init().
+  int64_t plain_size() const { return plain_size_; }
+
+  /// Writes the PLAIN encoding of the values to 'out', which must have room for
+  /// plain_size() bytes and be aligned to 8 bytes. Returns an error if the data is
+  /// corrupt.
+  Status Transcode(uint8_t* out) WARN_UNUSED_RESULT;
+
+ private:
+  /// Decodes the DELTA_LENGTH_BYTE_ARRAY encoded values in the 'len' bytes at 'data' to
+  /// 'suffix_lengths_' and 'suffixes_'.
+  Status InitDeltaLengths(const uint8_t* data, int64_t len, int64_t max_values);
+
+  /// Validates the decoded prefix and suffix lengths and computes 'plain_size_'. An
+  /// empty 'prefix_lengths_' means that there are no prefixes.
+  Status InitByteArrayValues();
+
+  parquet::Encoding::type encoding_ = parquet::Encoding::PLAIN;
+  parquet::Type::type type_ = parquet::Type::INT32;
+  const uint8_t* data_ = nullptr;
+  int64_t num_values_ = 0;
+  int64_t plain_size_ = 0;
+
+  /// The size of fixed width values.
+  int value_width_ = 0;
+
+  /// The decoders of DELTA_BINARY_PACKED values.
+  ParquetDeltaBinaryPackedDecoder<int32_t> int32_decoder_;
+  ParquetDeltaBinaryPackedDecoder<int64_t> int64_decoder_;
+
+  /// The decoded lengths of DELTA_LENGTH_BYTE_ARRAY and DELTA_BYTE_ARRAY values, and the
+  /// start of their concatenated suffixes.
+  std::vector<int32_t> prefix_lengths_;
+  std::vector<int32_t> suffix_lengths_;
+  const uint8_t* suffixes_ = nullptr;
+};
+
+}
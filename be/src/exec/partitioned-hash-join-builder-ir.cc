@@ -84,6 +84,7 @@ bool PhjBuilderPartition::InsertBatch(TPrefetchMode::type prefetch_mode,
   HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
   const int prefetch_size = expr_vals_cache->capacity();
   const BufferedTupleStream::FlatRowPtr* flat_rows_data = flat_rows.data();
+  const bool dedup_build_keys = parent_->dedup_build_keys_;
   for (int prefetch_group_row = 0; prefetch_group_row < num_rows;
        prefetch_group_row += prefetch_size) {
     int cur_row = prefetch_group_row;
@@ -103,9 +104,12 @@ bool PhjBuilderPartition::InsertBatch(TPrefetchMode::type prefetch_mode,
     FOREACH_ROW_LIMIT(batch, cur_row, prefetch_size, batch_iter) {
       TupleRow* row = batch_iter.Get();
       BufferedTupleStream::FlatRowPtr flat_row = flat_rows_data[cur_row];
-      if (!expr_vals_cache->IsRowNull()
-          && UNLIKELY(!hash_tbl_->Insert(ht_ctx, flat_row, row, status))) {
-        return false;
+      if (!expr_vals_cache->IsRowNull()) {
+        if (dedup_build_keys) {
+          hash_tbl_->InsertDistinct(ht_ctx, flat_row, row);
+        } else if (UNLIKELY(!hash_tbl_->Insert(ht_ctx, flat_row, row, status))) {
+          return false;
+        }
       }
       expr_vals_cache->NextRow();
       ++cur_row;
@@ -24,6 +24,7 @@
 
 #include "codegen/llvm-codegen.h"
 #include "exec/hash-table.inline.h"
+#include "exec/spill-victim-policy.h"
 #include "exprs/scalar-expr-evaluator.h"
 #include "exprs/scalar-expr.h"
 #include "runtime/buffered-tuple-stream.h"
@@ -36,9 +37,11 @@
 #include "runtime/runtime-filter.h"
 #include "runtime/runtime-state.h"
 #include "service/hs2-util.h"
+#include "util/bit-util.h"
 #include "util/bloom-filter.h"
 #include "util/cyclic-barrier.h"
 #include "util/debug-util.h"
+#include "util/in-list-filter.h"
 #include "util/min-max-filter.h"
 #include "util/pretty-printer.h"
 #include "util/runtime-profile-counters.h"
@@ -47,6 +50,23 @@
 
 #include "common/names.h"
 
+DECLARE_bool(suballocator_use_slabs);
+DECLARE_double(max_filter_error_rate);
+
+DEFINE_int64(hash_join_build_cluster_bytes, 0, "(Advanced) If greater than 0, the build "
+    "rows of in-memory hash join partitions whose hash table buckets take more than this "
+    "many bytes are grouped by the range of buckets they hash to before they are "
+    "inserted, with the buckets of a range taking about this many bytes. Inserting the "
+    "rows one range at a time keeps the buckets written to in the CPU caches. A good "
+    "value is the size of the L2 cache. 0 inserts the rows in the order of the build "
+    "stream.");
+
+DEFINE_int64(hash_join_direct_index_max_entries, 0, "(Advanced) If greater than 0, "
+    "in-memory hash joins on a single integer key whose build keys span at most this "
+    "many values, and are dense, index the build rows with an array indexed by the key. "
+    "Probe rows are looked up through the array instead of probing the hash table "
+    "buckets. Each entry of the array takes 4 bytes. 0 disables the index.");
+
 static const string PREPARE_FOR_READ_FAILED_ERROR_MSG =
     "Failed to acquire initial read "
     "buffer for stream in hash join node $0. Reducing query concurrency or increasing "
@@ -78,12 +98,13 @@ Status PhjBuilderConfig::CreateConfig(FragmentState* state, int join_node_id,
     TJoinOp::type join_op, const RowDescriptor* build_row_desc,
     const std::vector<TEqJoinCondition>& eq_join_conjuncts,
     const std::vector<TRuntimeFilterDesc>& filters, uint32_t hash_seed,
-    PhjBuilderConfig** sink) {
+    bool is_switchable_broadcast, bool dedup_build_keys, PhjBuilderConfig** sink) {
   ObjectPool* pool = state->obj_pool();
   TDataSink* tsink = pool->Add(new TDataSink());
   PhjBuilderConfig* data_sink = pool->Add(new PhjBuilderConfig());
   RETURN_IF_ERROR(data_sink->Init(state, join_node_id, join_op, build_row_desc,
-      eq_join_conjuncts, filters, hash_seed, tsink));
+      eq_join_conjuncts, filters, hash_seed, is_switchable_broadcast, dedup_build_keys,
+      tsink));
   *sink = data_sink;
   return Status::OK();
 }
@@ -139,12 +160,15 @@ Status PhjBuilderConfig::InitExprsAndFilters(FragmentState* state,
 Status PhjBuilderConfig::Init(FragmentState* state, int join_node_id,
     TJoinOp::type join_op, const RowDescriptor* build_row_desc,
     const vector<TEqJoinCondition>& eq_join_conjuncts,
-    const vector<TRuntimeFilterDesc>& filters, uint32_t hash_seed, TDataSink* tsink) {
+    const vector<TRuntimeFilterDesc>& filters, uint32_t hash_seed,
+    bool is_switchable_broadcast, bool dedup_build_keys, TDataSink* tsink) {
   tsink->__isset.join_build_sink = true;
   tsink->join_build_sink.__set_dest_node_id(join_node_id);
   tsink->join_build_sink.__set_join_op(join_op);
   RETURN_IF_ERROR(JoinBuilderConfig::Init(*tsink, build_row_desc, state));
   hash_seed_ = hash_seed;
+  is_switchable_broadcast_ = is_switchable_broadcast;
+  dedup_build_keys_ = dedup_build_keys;
   return InitExprsAndFilters(state, eq_join_conjuncts, filters);
 }
 
@@ -153,6 +177,8 @@ Status PhjBuilderConfig::Init(const TDataSink& tsink, const RowDescriptor* input
   RETURN_IF_ERROR(JoinBuilderConfig::Init(tsink, input_row_desc, state));
   const TJoinBuildSink& build_sink = tsink.join_build_sink;
   hash_seed_ = build_sink.hash_seed;
+  is_switchable_broadcast_ = build_sink.is_switchable_broadcast;
+  dedup_build_keys_ = build_sink.dedup_build_keys;
   resource_profile_ = &tsink.resource_profile;
   return InitExprsAndFilters(
       state, tsink.join_build_sink.eq_join_conjuncts, build_sink.runtime_filters);
@@ -181,7 +207,11 @@ PhjBuilder::PhjBuilder(
     process_build_batch_fn_(sink_config.process_build_batch_fn_),
     process_build_batch_fn_level0_(sink_config.process_build_batch_fn_level0_),
     insert_batch_fn_(sink_config.insert_batch_fn_),
-    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_) {
+    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_),
+    runtime_broadcast_bytes_limit_(sink_config.is_switchable_broadcast_ ?
+            max<int64_t>(0, state->query_options().runtime_broadcast_bytes_limit) :
+            0),
+    dedup_build_keys_(sink_config.dedup_build_keys_) {
   DCHECK_GT(sink_config.hash_seed_, 0);
   DCHECK(num_probe_threads_ <= 1 || !NeedToProcessUnmatchedBuildRows(join_op_))
       << "Returning rows with build partitions is not supported with shared builds";
@@ -216,7 +246,11 @@ PhjBuilder::PhjBuilder(const PhjBuilderConfig& sink_config,
     process_build_batch_fn_(sink_config.process_build_batch_fn_),
     process_build_batch_fn_level0_(sink_config.process_build_batch_fn_level0_),
     insert_batch_fn_(sink_config.insert_batch_fn_),
-    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_) {
+    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_),
+    runtime_broadcast_bytes_limit_(sink_config.is_switchable_broadcast_ ?
+            max<int64_t>(0, state->query_options().runtime_broadcast_bytes_limit) :
+            0),
+    dedup_build_keys_(sink_config.dedup_build_keys_) {
   DCHECK_GT(sink_config.hash_seed_, 0);
   DCHECK_EQ(1, num_probe_threads_) << "Embedded builders cannot be shared";
   for (const TRuntimeFilterDesc& filter_desc : sink_config.filter_descs_) {
@@ -259,10 +293,18 @@ Status PhjBuilder::Prepare(RuntimeState* state, MemTracker* parent_mem_tracker)
   ht_stats_profile_ = HashTable::AddHashTableCounters(profile());
   num_spilled_partitions_ = ADD_COUNTER(profile(), "SpilledPartitions", TUnit::UNIT);
   num_repartitions_ = ADD_COUNTER(profile(), "NumRepartitions", TUnit::UNIT);
+  num_spill_victims_not_largest_ =
+      ADD_COUNTER(profile(), "SpillVictimsNotLargest", TUnit::UNIT);
+  expected_spill_scratch_bytes_ =
+      ADD_COUNTER(profile(), "ExpectedSpillScratchBytes", TUnit::BYTES);
   partition_build_rows_timer_ = ADD_TIMER(profile(), "BuildRowsPartitionTime");
   build_hash_table_timer_ = ADD_TIMER(profile(), "HashTablesBuildTime");
   num_hash_table_builds_skipped_ =
       ADD_COUNTER(profile(), "NumHashTableBuildsSkipped", TUnit::UNIT);
+  num_clustered_hash_table_builds_ =
+      ADD_COUNTER(profile(), "NumClusteredHashTableBuilds", TUnit::UNIT);
+  direct_join_index_entries_ =
+      ADD_COUNTER(profile(), "DirectJoinIndexEntries", TUnit::UNIT);
   repartition_timer_ = ADD_TIMER(profile(), "RepartitionTime");
   return Status::OK();
 }
@@ -275,6 +317,9 @@ Status PhjBuilder::Open(RuntimeState* state) {
     DCHECK_GE(resource_profile_->min_reservation, MinReservation().second);
     RETURN_IF_ERROR(reservation_manager_.ClaimBufferReservation(state));
   }
+  // Spilled partitions are only read back after the probe side of all partitions has
+  // been processed.
+  buffer_pool_client_->MarkSpilledPagesCold();
   // Need to init here instead of constructor so that buffer_pool_client_ is registered.
   if (probe_stream_reservation_.is_closed()) {
     probe_stream_reservation_.Init(buffer_pool_client_);
@@ -288,7 +333,8 @@ Status PhjBuilder::Open(RuntimeState* state) {
   if (ht_allocator_ == nullptr) {
     // Create 'ht_allocator_' on the first call to Open().
     ht_allocator_.reset(new Suballocator(ExecEnv::GetInstance()->buffer_pool(),
-        buffer_pool_client_, spillable_buffer_size_));
+        buffer_pool_client_, spillable_buffer_size_, FLAGS_suballocator_use_slabs,
+        profile()));
   }
   RETURN_IF_ERROR(CreateHashPartitions(0));
   AllocateRuntimeFilters();
@@ -304,9 +350,23 @@ Status PhjBuilder::Send(RuntimeState* state, RowBatch* batch) {
   SCOPED_TIMER(partition_build_rows_timer_);
   RETURN_IF_ERROR(AddBatch(batch));
   COUNTER_ADD(num_build_rows_, batch->num_rows());
+  if (runtime_broadcast_bytes_limit_ > 0) {
+    RETURN_IF_ERROR(CheckRuntimeBroadcastBytesLimit());
+  }
   return Status::OK();
 }
 
+Status PhjBuilder::CheckRuntimeBroadcastBytesLimit() const {
+  int64_t build_bytes = 0;
+  for (const unique_ptr<PhjBuilderPartition>& partition : hash_partitions_) {
+    if (!partition->IsClosed()) build_bytes += partition->build_rows()->byte_size();
+  }
+  if (build_bytes <= runtime_broadcast_bytes_limit_) return Status::OK();
+  return Status(TErrorCode::RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED, join_node_id_,
+      PrettyPrinter::PrintBytes(build_bytes),
+      PrettyPrinter::PrintBytes(runtime_broadcast_bytes_limit_));
+}
+
 Status PhjBuilder::AddBatch(RowBatch* batch) {
   bool build_filters = ht_ctx_->level() == 0 && filter_ctxs_.size() > 0;
 
@@ -525,6 +585,8 @@ Status PhjBuilder::CreateAndPreparePartition(
 
 Status PhjBuilder::CreateHashPartitions(int level) {
   DCHECK(hash_partitions_.empty());
+  // Without spilled probe rows to go by, expect one probe row per build row.
+  if (level == 0) probe_rows_per_build_row_ = 1;
   ht_ctx_->set_level(level); // Set the hash function for partitioning input.
   for (int i = 0; i < PARTITION_FANOUT; ++i) {
     unique_ptr<PhjBuilderPartition> new_partition;
@@ -550,7 +612,6 @@ bool PhjBuilder::AppendRowStreamFull(
   }
 }
 
-// TODO: can we do better with a different spilling heuristic?
 Status PhjBuilder::SpillPartition(BufferedTupleStream::UnpinMode mode,
     PhjBuilderPartition** spilled_partition) {
   DCHECK_EQ(hash_partitions_.size(), PARTITION_FANOUT);
@@ -559,8 +620,9 @@ Status PhjBuilder::SpillPartition(BufferedTupleStream::UnpinMode mode,
     // Spill null-aware partition first if possible - it is always processed last.
     best_candidate = null_aware_partition_.get();
   } else {
-    // Iterate over the partitions and pick the largest partition to spill.
-    int64_t max_freed_mem = 0;
+    // Let the spill victim policy pick one of the partitions that can be spilled.
+    vector<PhjBuilderPartition*> partitions;
+    vector<SpillCandidate> candidates;
     for (const unique_ptr<PhjBuilderPartition>& candidate : hash_partitions_) {
       if (!candidate->CanSpill()) continue;
       int64_t mem = candidate->build_rows()->BytesPinned(false);
@@ -570,10 +632,19 @@ Status PhjBuilder::SpillPartition(BufferedTupleStream::UnpinMode mode,
         DCHECK(!candidate->hash_tbl()->HasMatches());
         mem += candidate->hash_tbl()->ByteSize();
       }
-      if (mem > max_freed_mem) {
-        max_freed_mem = mem;
-        best_candidate = candidate.get();
+      partitions.push_back(candidate.get());
+      candidates.push_back({mem, candidate->build_rows()->byte_size(),
+          candidate->build_rows()->num_rows()});
+    }
+    int idx =
+        SpillVictimPolicy::Get()->ChooseVictim(candidates, probe_rows_per_build_row_);
+    if (idx != -1) {
+      best_candidate = partitions[idx];
+      if (idx != SpillVictimPolicy::LargestCandidate(candidates)) {
+        COUNTER_ADD(num_spill_victims_not_largest_, 1);
       }
+      COUNTER_ADD(expected_spill_scratch_bytes_, SpillVictimPolicy::ExpectedScratchBytes(
+          candidates, idx, probe_rows_per_build_row_));
     }
   }
 
@@ -645,6 +716,7 @@ Status PhjBuilder::BuildHashTablesAndReserveProbeBuffers(HashJoinState next_stat
   // We may have spilled additional partitions while building hash tables, we need to
   // reserve memory for the probe buffers for those additional spilled partitions.
   RETURN_IF_ERROR(ReserveProbeBuffers(next_state));
+  if (ht_ctx_->level() == 0) BuildDirectJoinIndex();
   if (is_separate_build_) {
     // The builder may have some surplus reservation. Release it so that it can be
     // used by the probe side or by other operators.
@@ -683,7 +755,8 @@ Status PhjBuilder::BeginInitialProbe(
   DCHECK_ENUM_EQ(state_, HashJoinState::PARTITIONING_PROBE);
   DCHECK_EQ(PARTITION_FANOUT, hash_partitions_.size());
   RETURN_IF_ERROR(TransferProbeStreamReservation(probe_client));
-  *partitions = HashPartitions(ht_ctx_->level(), &hash_partitions_, non_empty_build_);
+  *partitions = HashPartitions(ht_ctx_->level(), &hash_partitions_, non_empty_build_,
+      direct_join_index_.get());
   return Status::OK();
 }
 
@@ -787,6 +860,34 @@ Status PhjBuilder::DoneProbingHashPartitions(
   return Status::OK();
 }
 
+void PhjBuilder::BuildDirectJoinIndex() {
+  DCHECK(direct_join_index_ == nullptr);
+  if (FLAGS_hash_join_direct_index_max_entries <= 0
+      || join_op_ == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN
+      || !DirectJoinIndex::CanIndex(build_exprs_, is_not_distinct_from_)) {
+    return;
+  }
+  vector<HashTable*> hash_tbls;
+  for (const unique_ptr<PhjBuilderPartition>& partition : hash_partitions_) {
+    if (partition->is_spilled()) return;
+    hash_tbls.push_back(partition->IsClosed() ? nullptr : partition->hash_tbl());
+  }
+  unique_ptr<DirectJoinIndex> index = make_unique<DirectJoinIndex>();
+  if (index->Init(*build_exprs_[0], ht_ctx_.get(), hash_tbls,
+          FLAGS_hash_join_direct_index_max_entries, mem_tracker())) {
+    COUNTER_SET(direct_join_index_entries_, index->num_entries());
+    direct_join_index_ = move(index);
+  }
+  // Free any expr result allocations made while evaluating the build keys.
+  expr_results_pool_->Clear();
+}
+
+void PhjBuilder::CloseDirectJoinIndex() {
+  if (direct_join_index_ == nullptr) return;
+  direct_join_index_->Close();
+  direct_join_index_.reset();
+}
+
 void PhjBuilder::CleanUpHashPartitions(
     deque<unique_ptr<PhjBuilderPartition>>* output_partitions, RowBatch* batch) {
   SCOPED_TIMER(profile()->total_time_counter());
@@ -797,6 +898,7 @@ void PhjBuilder::CleanUpHashPartitions(
     spilled_partitions_.pop_back();
   }
 
+  CloseDirectJoinIndex();
   for (int i = 0; i < PARTITION_FANOUT; ++i) {
     unique_ptr<PhjBuilderPartition> partition = std::move(hash_partitions_[i]);
     if (partition->IsClosed()) continue;
@@ -924,6 +1026,7 @@ void PhjBuilder::CloseNullAwarePartition() {
 
 void PhjBuilder::CloseAndDeletePartitions(RowBatch* row_batch) {
   // Close all the partitions and clean up all references to them.
+  CloseDirectJoinIndex();
   for (unique_ptr<PhjBuilderPartition>& partition : hash_partitions_) {
     partition->Close(row_batch);
   }
@@ -944,6 +1047,11 @@ void PhjBuilder::AllocateRuntimeFilters() {
       filter_ctxs_[i].local_bloom_filter =
           runtime_state_->filter_bank()->AllocateScratchBloomFilter(
               filter_ctxs_[i].filter->id());
+    } else if (filter_ctxs_[i].filter->is_in_list_filter()) {
+      filter_ctxs_[i].local_in_list_filter =
+          runtime_state_->filter_bank()->AllocateScratchInListFilter(
+              filter_ctxs_[i].filter->id(), filter_ctxs_[i].expr_eval->root().type(),
+              runtime_state_->query_options().runtime_in_list_filter_entry_limit);
     } else {
       DCHECK(filter_ctxs_[i].filter->is_min_max_filter());
       filter_ctxs_[i].local_min_max_filter =
@@ -964,6 +1072,46 @@ void PhjBuilder::InsertRuntimeFilters(
   for (const FilterContext& ctx : filter_ctxs_) ctx.Insert(build_row);
 }
 
+BloomFilter* PhjBuilder::FinalizeBloomFilter(
+    const FilterContext& ctx, int64_t num_build_rows) {
+  BloomFilter* bloom_filter = ctx.local_bloom_filter;
+  const TQueryOptions& query_options = runtime_state_->query_options();
+  const int log_space = bloom_filter->GetBlockBloomFilter()->log_space_bytes();
+  const int64_t ndv = min(bloom_filter->EstimateNdv(), num_build_rows);
+  double fpp = BloomFilter::FalsePositiveProb(ndv, log_space);
+  string detail = Substitute("NDV $0, $1", PrettyPrinter::Print(ndv, TUnit::UNIT),
+      PrettyPrinter::Print(1LL << log_space, TUnit::BYTES));
+  if (query_options.runtime_filter_max_fpp > 0
+      && fpp > query_options.runtime_filter_max_fpp) {
+    profile()->AddInfoString(Substitute("Runtime filter $0", ctx.filter->id()),
+        Substitute("$0, FPP $1, disabled", detail, fpp));
+    return BloomFilter::ALWAYS_TRUE_FILTER;
+  }
+  // The filters of the builders of a partitioned join are merged, which requires all of
+  // them to have the planned size, but a broadcast join filter is published as it is.
+  if (ctx.filter->filter_desc().is_broadcast_join) {
+    const double target_fpp = query_options.__isset.runtime_filter_error_rate ?
+        query_options.runtime_filter_error_rate : FLAGS_max_filter_error_rate;
+    const int min_log_space = max(BloomFilter::MinLogSpace(ndv, target_fpp),
+        BitUtil::Log2Ceiling64(query_options.runtime_filter_min_size));
+    if (min_log_space < log_space) {
+      Status status = bloom_filter->Fold(min_log_space);
+      if (status.ok()) {
+        fpp = BloomFilter::FalsePositiveProb(ndv, min_log_space);
+        detail = Substitute("NDV $0, $1 folded to $2",
+            PrettyPrinter::Print(ndv, TUnit::UNIT),
+            PrettyPrinter::Print(1LL << log_space, TUnit::BYTES),
+            PrettyPrinter::Print(1LL << min_log_space, TUnit::BYTES));
+      } else {
+        LOG(WARNING) << status.GetDetail();
+      }
+    }
+  }
+  profile()->AddInfoString(Substitute("Runtime filter $0", ctx.filter->id()),
+      Substitute("$0, FPP $1", detail, fpp));
+  return bloom_filter;
+}
+
 void PhjBuilder::PublishRuntimeFilters(int64_t num_build_rows) {
   VLOG(3) << "Join builder (join_node_id_=" << join_node_id_ << ") publishing "
           << filter_ctxs_.size() << " filters.";
@@ -971,8 +1119,10 @@ void PhjBuilder::PublishRuntimeFilters(int64_t num_build_rows) {
   for (const FilterContext& ctx : filter_ctxs_) {
     BloomFilter* bloom_filter = nullptr;
     if (ctx.local_bloom_filter != nullptr) {
-      bloom_filter = ctx.local_bloom_filter;
-      ++num_enabled_filters;
+      bloom_filter = FinalizeBloomFilter(ctx, num_build_rows);
+      if (bloom_filter != BloomFilter::ALWAYS_TRUE_FILTER) ++num_enabled_filters;
+    } else if (ctx.local_in_list_filter != nullptr) {
+      if (!ctx.local_in_list_filter->AlwaysTrue()) ++num_enabled_filters;
     } else if (ctx.local_min_max_filter != nullptr) {
       /// Apply the column min/max stats (if applicable) to shut down the min/max
       /// filter early by setting always true flag for the filter. Do this only if
@@ -1006,8 +1156,8 @@ void PhjBuilder::PublishRuntimeFilters(int64_t num_build_rows) {
       }
     }
 
-    runtime_state_->filter_bank()->UpdateFilterFromLocal(
-        ctx.filter->id(), bloom_filter, ctx.local_min_max_filter);
+    runtime_state_->filter_bank()->UpdateFilterFromLocal(ctx.filter->id(), bloom_filter,
+        ctx.local_min_max_filter, ctx.local_in_list_filter);
 
     if ( ctx.local_min_max_filter != nullptr ) {
       VLOG(3) << "HJBuilder published min/max filter: "
@@ -1057,7 +1207,7 @@ Status PhjBuilder::BeginSpilledProbe(BufferPool::ClientHandle* probe_client,
     DCHECK_ENUM_EQ(HashJoinState::REPARTITIONING_PROBE, state_);
     *repartitioned = true;
     *new_partitions =
-        HashPartitions(ht_ctx_->level(), &hash_partitions_, non_empty_build_);
+        HashPartitions(ht_ctx_->level(), &hash_partitions_, non_empty_build_, nullptr);
   }
   return Status::OK();
 }
@@ -1167,6 +1317,10 @@ Status PhjBuilder::RepartitionBuildInput(PhjBuilderPartition* input_partition) {
     return mem_tracker()->MemLimitExceeded(
         state, Substitute(PREPARE_FOR_READ_FAILED_ERROR_MSG, join_node_id_));
   }
+  // The probe rows of the input partition hash to the new partitions like its build
+  // rows do.
+  probe_rows_per_build_row_ = input_partition->num_spilled_probe_rows()
+      / static_cast<double>(max<int64_t>(1, build_rows->num_rows()));
   RETURN_IF_ERROR(CreateHashPartitions(new_level));
 
   // Repartition 'input_stream' into 'hash_partitions_'.
@@ -1301,10 +1455,16 @@ Status PhjBuilderPartition::BuildHashTable(bool* built) {
   // TODO: Try to allocate the hash table before pinning the stream to avoid needlessly
   // reading all of the spilled rows from disk when we won't succeed anyway.
   int64_t estimated_num_buckets = HashTable::EstimateNumBuckets(build_rows()->num_rows());
-  hash_tbl_.reset(HashTable::Create(parent_->ht_allocator_.get(),
-      true /* store_duplicates */, parent_->row_desc_->tuple_descriptors().size(),
-      build_rows(), 1 << (32 - PhjBuilder::NUM_PARTITIONING_BITS),
+  hash_tbl_.reset(HashTable::Create(parent_->hash_table_config_.group_probing,
+      parent_->ht_allocator_.get(), true /* store_duplicates */,
+      parent_->row_desc_->tuple_descriptors().size(), build_rows(),
+      1 << (32 - PhjBuilder::NUM_PARTITIONING_BITS),
       estimated_num_buckets));
+  // The clusters hold a pointer to each build row. Twice that much memory is tracked to
+  // leave room for the clusters to grow.
+  const int num_clusters = NumInsertClusters();
+  const int64_t cluster_mem =
+      2 * build_rows()->num_rows() * sizeof(BufferedTupleStream::FlatRowPtr);
   bool success;
   Status status = hash_tbl_->Init(&success);
   if (!status.ok() || !success) goto not_built;
@@ -1312,35 +1472,45 @@ Status PhjBuilderPartition::BuildHashTable(bool* built) {
   if (!status.ok()) goto not_built;
   DCHECK(success) << "Stream was already pinned.";
 
-  do {
-    status = build_rows_->GetNext(&batch, &eos, &flat_rows);
-    if (!status.ok()) goto not_built;
-    DCHECK_EQ(batch.num_rows(), flat_rows.size());
-    DCHECK_LE(batch.num_rows(), hash_tbl_->EmptyBuckets());
-    TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
-
-    InsertBatchFn insert_batch_fn;
-    if (level() == 0) {
-      insert_batch_fn = parent_->insert_batch_fn_level0_.load();
-    } else {
-      insert_batch_fn = parent_->insert_batch_fn_.load();
-    }
+  if (num_clusters > 1 && parent_->mem_tracker()->TryConsume(cluster_mem)) {
+    COUNTER_ADD(parent_->num_clustered_hash_table_builds_, 1);
+    success = InsertClusteredRows(num_clusters, &status);
+    parent_->mem_tracker()->Release(cluster_mem);
+    if (UNLIKELY(!success)) goto not_built;
+    RETURN_IF_CANCELLED(state);
+    RETURN_IF_ERROR(state->GetQueryStatus());
+  } else {
+    do {
+      status = build_rows_->GetNext(&batch, &eos, &flat_rows);
+      if (!status.ok()) goto not_built;
+      DCHECK_EQ(batch.num_rows(), flat_rows.size());
+      DCHECK_LE(batch.num_rows(), hash_tbl_->EmptyBuckets());
+      TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
+
+      InsertBatchFn insert_batch_fn;
+      if (level() == 0) {
+        insert_batch_fn = parent_->insert_batch_fn_level0_.load();
+      } else {
+        insert_batch_fn = parent_->insert_batch_fn_.load();
+      }
 
-    if (insert_batch_fn != nullptr) {
-      if (UNLIKELY(
-            !insert_batch_fn(this, prefetch_mode, ctx, &batch, flat_rows, &status))) {
+      if (insert_batch_fn != nullptr) {
+        if (UNLIKELY(
+              !insert_batch_fn(this, prefetch_mode, ctx, &batch, flat_rows, &status))) {
+          goto not_built;
+        }
+      } else if (UNLIKELY(
+                     !InsertBatch(prefetch_mode, ctx, &batch, flat_rows, &status))) {
         goto not_built;
       }
-    } else if (UNLIKELY(!InsertBatch(prefetch_mode, ctx, &batch, flat_rows, &status))) {
-      goto not_built;
-    }
 
-    RETURN_IF_CANCELLED(state);
-    RETURN_IF_ERROR(state->GetQueryStatus());
-    // Free any expr result allocations made while inserting.
-    parent_->expr_results_pool_->Clear();
-    batch.Reset();
-  } while (!eos);
+      RETURN_IF_CANCELLED(state);
+      RETURN_IF_ERROR(state->GetQueryStatus());
+      // Free any expr result allocations made while inserting.
+      parent_->expr_results_pool_->Clear();
+      batch.Reset();
+    } while (!eos);
+  }
 
   // The hash table fits in memory and is built.
   DCHECK(*built);
@@ -1359,6 +1529,84 @@ not_built:
   return status;
 }
 
+int PhjBuilderPartition::NumInsertClusters() const {
+  if (FLAGS_hash_join_build_cluster_bytes <= 0) return 1;
+  const int64_t num_buckets = hash_tbl_->num_buckets();
+  const int64_t bucket_bytes = num_buckets * HashTable::BucketSize();
+  if (bucket_bytes <= FLAGS_hash_join_build_cluster_bytes) return 1;
+  int64_t num_clusters = BitUtil::RoundUpToPowerOfTwo(
+      BitUtil::Ceil(bucket_bytes, FLAGS_hash_join_build_cluster_bytes));
+  return min(num_clusters, min<int64_t>(num_buckets, MAX_INSERT_CLUSTERS));
+}
+
+bool PhjBuilderPartition::InsertClusteredRows(int num_clusters, Status* status) {
+  DCHECK(BitUtil::IsPowerOf2(num_clusters));
+  RuntimeState* state = parent_->runtime_state_;
+  HashTableCtx* ctx = parent_->ht_ctx_.get();
+  HashTableCtx::ExprValuesCache* expr_vals_cache = ctx->expr_values_cache();
+  const int64_t num_buckets = hash_tbl_->num_buckets();
+  // The cluster of a row is given by the top bits of its bucket index.
+  const int cluster_shift =
+      BitUtil::Log2Ceiling64(num_buckets) - BitUtil::Log2Ceiling64(num_clusters);
+  vector<vector<BufferedTupleStream::FlatRowPtr>> clusters(num_clusters);
+  for (auto& cluster : clusters) {
+    cluster.reserve(build_rows_->num_rows() / num_clusters);
+  }
+  RowBatch batch(parent_->row_desc_, state->batch_size(), parent_->mem_tracker());
+  vector<BufferedTupleStream::FlatRowPtr> flat_rows;
+
+  // Group the rows by the cluster of buckets they hash to. Rows which are not inserted
+  // because of NULLs are dropped, like in InsertBatch().
+  bool eos = false;
+  do {
+    *status = build_rows_->GetNext(&batch, &eos, &flat_rows);
+    if (UNLIKELY(!status->ok())) return false;
+    DCHECK_EQ(batch.num_rows(), flat_rows.size());
+    for (int i = 0; i < batch.num_rows(); ++i) {
+      if (i % expr_vals_cache->capacity() == 0) expr_vals_cache->Reset();
+      if (ctx->EvalAndHashBuild(batch.GetRow(i))) {
+        int64_t bucket_idx = expr_vals_cache->CurExprValuesHash() & (num_buckets - 1);
+        clusters[bucket_idx >> cluster_shift].push_back(flat_rows[i]);
+      }
+      expr_vals_cache->NextRow();
+    }
+    if (UNLIKELY(state->is_cancelled())) {
+      *status = Status::CANCELLED;
+      return false;
+    }
+    parent_->expr_results_pool_->Clear();
+    batch.Reset();
+  } while (!eos);
+
+  // Insert the rows one cluster at a time.
+  TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
+  InsertBatchFn insert_batch_fn = level() == 0 ?
+      parent_->insert_batch_fn_level0_.load() : parent_->insert_batch_fn_.load();
+  for (auto& cluster : clusters) {
+    for (int64_t start = 0; start < cluster.size(); start += state->batch_size()) {
+      int64_t end = min<int64_t>(cluster.size(), start + state->batch_size());
+      flat_rows.assign(cluster.begin() + start, cluster.begin() + end);
+      for (BufferedTupleStream::FlatRowPtr flat_row : flat_rows) {
+        build_rows_->GetTupleRow(flat_row, batch.GetRow(batch.AddRow()));
+        batch.CommitLastRow();
+      }
+      bool inserted = insert_batch_fn != nullptr ?
+          insert_batch_fn(this, prefetch_mode, ctx, &batch, flat_rows, status) :
+          InsertBatch(prefetch_mode, ctx, &batch, flat_rows, status);
+      if (UNLIKELY(!inserted)) return false;
+      if (UNLIKELY(state->is_cancelled())) {
+        *status = Status::CANCELLED;
+        return false;
+      }
+      parent_->expr_results_pool_->Clear();
+      batch.Reset();
+    }
+    // Free the memory of the cluster as soon as it is inserted.
+    vector<BufferedTupleStream::FlatRowPtr>().swap(cluster);
+  }
+  return true;
+}
+
 std::string PhjBuilderPartition::DebugString() {
   stringstream ss;
   ss << "<Partition>: ptr=" << this << " id=" << id_;
@@ -1468,6 +1716,7 @@ Status PhjBuilderConfig::CodegenProcessBuildBatch(LlvmCodeGen* codegen,
   DCHECK_EQ(replaced_constants.stores_duplicates, 0);
   DCHECK_EQ(replaced_constants.stores_tuples, 0);
   DCHECK_EQ(replaced_constants.quadratic_probing, 0);
+  DCHECK_EQ(replaced_constants.group_probing, 0);
 
   llvm::Value* is_null_aware_arg = codegen->GetArgument(process_build_batch_fn, 5);
   is_null_aware_arg->replaceAllUsesWith(
@@ -1534,7 +1783,7 @@ Status PhjBuilderConfig::CodegenInsertBatch(LlvmCodeGen* codegen, llvm::Function
   // Replace the parameter 'prefetch_mode' with constant.
   llvm::Value* prefetch_mode_arg = codegen->GetArgument(insert_batch_fn, 1);
   DCHECK_GE(prefetch_mode, TPrefetchMode::NONE);
-  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET);
+  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET_PIPELINED);
   prefetch_mode_arg->replaceAllUsesWith(codegen->GetI32Constant(prefetch_mode));
 
   // Use codegen'd EvalBuildRow() function
@@ -1556,6 +1805,7 @@ Status PhjBuilderConfig::CodegenInsertBatch(LlvmCodeGen* codegen, llvm::Function
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.group_probing, 1);
 
   llvm::Function* insert_batch_fn_level0 = codegen->CloneFunction(insert_batch_fn);
 
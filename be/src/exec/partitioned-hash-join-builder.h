@@ -28,6 +28,7 @@
 #include "codegen/codegen-fn-ptr.h"
 #include "common/object-pool.h"
 #include "common/status.h"
+#include "exec/direct-join-index.h"
 #include "exec/filter-context.h"
 #include "exec/hash-table.h"
 #include "exec/join-builder.h"
@@ -71,6 +72,7 @@ class PhjBuilderConfig : public JoinBuilderConfig {
       TJoinOp::type join_op, const RowDescriptor* build_row_desc,
       const std::vector<TEqJoinCondition>& eq_join_conjuncts,
       const std::vector<TRuntimeFilterDesc>& filters, uint32_t hash_seed,
+      bool is_switchable_broadcast, bool dedup_build_keys,
       PhjBuilderConfig** sink);
 
   void Close() override;
@@ -96,6 +98,14 @@ class PhjBuilderConfig : public JoinBuilderConfig {
   /// Seed used for hashing rows. Must match seed used in the PartitionedHashJoinNode.
   uint32_t hash_seed_;
 
+  /// True if this is the build of a broadcast join that the query can be planned again
+  /// without, see THashJoinNode.is_switchable_broadcast.
+  bool is_switchable_broadcast_ = false;
+
+  /// True if the hash tables only keep the first build row of each distinct key, see
+  /// THashJoinNode.dedup_build_keys.
+  bool dedup_build_keys_ = false;
+
   /// Resource information sent from the frontend. Non-null if this is a separate join
   /// build.
   const TBackendResourceProfile* resource_profile_ = nullptr;
@@ -132,6 +142,7 @@ class PhjBuilderConfig : public JoinBuilderConfig {
       const RowDescriptor* build_row_desc,
       const std::vector<TEqJoinCondition>& eq_join_conjuncts,
       const std::vector<TRuntimeFilterDesc>& filters, uint32_t hash_seed,
+      bool is_switchable_broadcast, bool dedup_build_keys,
       TDataSink* tsink);
 
   /// Initializes the build and filter expressions, creates a copy of the filter
@@ -249,6 +260,9 @@ class PhjBuilderPartition {
   }
 
  private:
+  /// Upper bound on the number of clusters returned by NumInsertClusters().
+  static const int MAX_INSERT_CLUSTERS = 1024;
+
   /// Inserts each row in 'batch' into 'hash_tbl_' using 'ctx'. 'flat_rows' is an array
   /// containing the rows in the hash table's tuple stream.
   /// 'prefetch_mode' is the prefetching mode in use. If it's not PREFETCH_NONE, hash
@@ -262,6 +276,19 @@ class PhjBuilderPartition {
       RowBatch* batch, const std::vector<BufferedTupleStream::FlatRowPtr>& flat_rows,
       Status* status);
 
+  /// Returns the number of clusters into which the rows of the pinned 'build_rows_'
+  /// are grouped before they are inserted into 'hash_tbl_', so that the buckets of
+  /// a cluster take about --hash_join_build_cluster_bytes. Returns 1 if the rows are
+  /// inserted in stream order.
+  int NumInsertClusters() const;
+
+  /// Inserts all rows of the pinned 'build_rows_' into 'hash_tbl_' in two passes. The
+  /// first pass reads the stream and groups the rows by the range of buckets which they
+  /// hash to into 'num_clusters' clusters. The second pass inserts the rows one cluster
+  /// at a time, so the inserts of a cluster only touch a cache-sized part of the
+  /// buckets. Returns true and sets 'status' the same way as InsertBatch().
+  bool InsertClusteredRows(int num_clusters, Status* status);
+
   const PhjBuilder* parent_;
 
   /// Id for this partition that is unique within the builder.
@@ -394,15 +421,17 @@ class PhjBuilder : public JoinBuilder {
     HashPartitions() { Reset(); }
     HashPartitions(int level,
         const std::vector<std::unique_ptr<PhjBuilderPartition>>* hash_partitions,
-        bool non_empty_build)
+        bool non_empty_build, const DirectJoinIndex* direct_join_index)
       : level(level),
         hash_partitions(hash_partitions),
-        non_empty_build(non_empty_build) {}
+        non_empty_build(non_empty_build),
+        direct_join_index(direct_join_index) {}
 
     void Reset() {
       level = -1;
       hash_partitions = nullptr;
       non_empty_build = false;
+      direct_join_index = nullptr;
     }
 
     // The partitioning level of this set of partitions. -1 indicates that this is
@@ -416,6 +445,10 @@ class PhjBuilder : public JoinBuilder {
 
     // True iff the build side had at least one row in a partition.
     bool non_empty_build;
+
+    // Index of the build rows of all partitions, or NULL if there is none. Valid until
+    // DoneProbingHashPartitions() is called.
+    const DirectJoinIndex* direct_join_index;
   };
 
   /// Get hash partitions and reservation for the initial partitioning of the probe
@@ -600,6 +633,11 @@ class PhjBuilder : public JoinBuilder {
   /// counters. Also used by RepartitionBuildInput().
   Status AddBatch(RowBatch* build_batch);
 
+  /// Returns a RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED error if the build rows added so
+  /// far exceed 'runtime_broadcast_bytes_limit_'. The coordinator then plans the query
+  /// again with partitioned joins.
+  Status CheckRuntimeBroadcastBytesLimit() const;
+
   /// Helper method for FlushFinal() that does the actual work. Also used by
   /// RepartitionBuildInput().
   Status FinalizeBuild(RuntimeState* state);
@@ -622,9 +660,9 @@ class PhjBuilder : public JoinBuilder {
 
   /// Frees memory by spilling one of the hash partitions. The 'mode' argument is passed
   /// to the Spill() call for the selected partition. The current policy is to spill the
-  /// null-aware partition first (if a NAAJ), then the largest partition. Returns non-ok
-  /// status if we couldn't spill a partition. If 'spilled_partition' is non-NULL, set
-  /// to the partition that was the one spilled.
+  /// null-aware partition first (if a NAAJ), then the partition chosen by the
+  /// SpillVictimPolicy. Returns non-ok status if we couldn't spill a partition. If
+  /// 'spilled_partition' is non-NULL, set to the partition that was the one spilled.
   Status SpillPartition(BufferedTupleStream::UnpinMode mode,
       PhjBuilderPartition** spilled_partition = nullptr) WARN_UNUSED_RESULT;
 
@@ -684,6 +722,14 @@ class PhjBuilder : public JoinBuilder {
   /// Returns the largest build row count out of the current hash partitions.
   int64_t LargestPartitionRows() const;
 
+  /// Builds 'direct_join_index_' for 'hash_partitions_' if the join keys and the
+  /// build rows allow it. Called once all hash tables of the level 0 partitions are
+  /// built.
+  void BuildDirectJoinIndex();
+
+  /// Closes and clears 'direct_join_index_' if it was built.
+  void CloseDirectJoinIndex();
+
   /// Helper for DoneProbingHashPartitions() that processes and cleans up the hash
   /// partitions.
   void CleanUpHashPartitions(
@@ -721,6 +767,13 @@ class PhjBuilder : public JoinBuilder {
   /// unacceptably high false-positive rate.
   void PublishRuntimeFilters(int64_t num_build_rows);
 
+  /// Returns the Bloom filter of 'ctx' to publish. The NDV of the filter is estimated
+  /// from its set bits. If the false positive probability at that NDV is above
+  /// RUNTIME_FILTER_MAX_FPP, returns ALWAYS_TRUE_FILTER. Otherwise a broadcast join
+  /// filter is folded to the smallest size that keeps the target FPP, but not below
+  /// RUNTIME_FILTER_MIN_SIZE. Adds the NDV, size and FPP to the profile.
+  BloomFilter* FinalizeBloomFilter(const FilterContext& ctx, int64_t num_build_rows);
+
   // Determine the usefulness of min/max filters in the context of column min/max stats.
   // Set AlwaysTrue to true for each not useful. Called at the end of AddBatch().
   void DetermineUsefulnessForMinmaxFilters();
@@ -809,6 +862,16 @@ class PhjBuilder : public JoinBuilder {
   /// Number of partitions that have been repartitioned.
   RuntimeProfile::Counter* num_repartitions_ = nullptr;
 
+  /// Number of partitions spilled by SpillPartition() that were not the ones that freed
+  /// the most memory, and the total expected scratch I/O of all spilled partitions.
+  RuntimeProfile::Counter* num_spill_victims_not_largest_ = nullptr;
+  RuntimeProfile::Counter* expected_spill_scratch_bytes_ = nullptr;
+
+  /// Expected number of probe rows for each build row of the hash partitions, passed to
+  /// the SpillVictimPolicy. Set from the spilled probe rows of the input partition when
+  /// repartitioning.
+  double probe_rows_per_build_row_ = 1;
+
   /// Time spent partitioning build rows.
   RuntimeProfile::Counter* partition_build_rows_timer_ = nullptr;
 
@@ -819,6 +882,13 @@ class PhjBuilder : public JoinBuilder {
   /// hash table.
   RuntimeProfile::Counter* num_hash_table_builds_skipped_ = nullptr;
 
+  /// Number of hash tables which were built with the rows grouped into clusters of
+  /// buckets, see --hash_join_build_cluster_bytes.
+  RuntimeProfile::Counter* num_clustered_hash_table_builds_ = nullptr;
+
+  /// Number of entries of the direct join index, if one was built.
+  RuntimeProfile::Counter* direct_join_index_entries_ = nullptr;
+
   /// Time spent repartitioning and building hash tables of any resulting partitions
   /// that were not spilled.
   RuntimeProfile::Counter* repartition_timer_ = nullptr;
@@ -852,6 +922,11 @@ class PhjBuilder : public JoinBuilder {
   /// This is not used when processing a single spilled partition.
   std::vector<std::unique_ptr<PhjBuilderPartition>> hash_partitions_;
 
+  /// Index of the build rows of 'hash_partitions_'. Only built at level 0, if all
+  /// partitions are in memory and --hash_join_direct_index_max_entries allows it. Closed
+  /// when 'hash_partitions_' are cleared.
+  std::unique_ptr<DirectJoinIndex> direct_join_index_;
+
   /// Spilled partitions that need further processing. Populated in
   /// DoneProbingHashPartitions() with the spilled hash partitions.
   ///
@@ -900,6 +975,14 @@ class PhjBuilder : public JoinBuilder {
   /// Jitted Partition::InsertBatch() function pointers. NULL if codegen is disabled.
   const CodegenFnPtr<InsertBatchFn>& insert_batch_fn_;
   const CodegenFnPtr<InsertBatchFn>& insert_batch_fn_level0_;
+
+  /// If non-zero, the max bytes of build rows of a switchable broadcast join build,
+  /// from the RUNTIME_BROADCAST_BYTES_LIMIT query option. Checked by Send().
+  const int64_t runtime_broadcast_bytes_limit_;
+
+  /// Copied from PhjBuilderConfig. If true, PhjBuilderPartition::InsertBatch() skips
+  /// build rows whose key is already in the hash table.
+  const bool dedup_build_keys_;
 };
 } // namespace impala
 #endif
@@ -254,9 +254,10 @@ bool IR_ALWAYS_INLINE PartitionedHashJoinNode::ProcessProbeRow(
 
 template<int const JoinOp>
 bool IR_ALWAYS_INLINE PartitionedHashJoinNode::NextProbeRow(
-    HashTableCtx* ht_ctx, RowBatch::Iterator* probe_batch_iterator,
-    int* remaining_capacity, Status* status) {
+    TPrefetchMode::type prefetch_mode, HashTableCtx* ht_ctx,
+    RowBatch::Iterator* probe_batch_iterator, int* remaining_capacity, Status* status) {
   HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
+  const DirectJoinIndex* direct_join_index = build_hash_partitions_.direct_join_index;
   while (!expr_vals_cache->AtEnd()) {
     // Establish current_probe_row_ and find its corresponding partition.
     DCHECK(!probe_batch_iterator->AtEnd());
@@ -302,7 +303,13 @@ bool IR_ALWAYS_INLINE PartitionedHashJoinNode::NextProbeRow(
     } else {
       // The build partition is in memory. Return this row for probing.
       if (LIKELY(hash_tbl != NULL)) {
-        hash_tbl_iterator_ = hash_tbl->FindProbeRow(ht_ctx);
+        if (direct_join_index != nullptr) {
+          hash_tbl_iterator_ = direct_join_index->FindProbeRow(hash_tbl, ht_ctx);
+        } else if (prefetch_mode == TPrefetchMode::HT_BUCKET_PIPELINED) {
+          hash_tbl_iterator_ = pipelined_probe_results_[expr_vals_cache->CurIdx()];
+        } else {
+          hash_tbl_iterator_ = hash_tbl->FindProbeRow(ht_ctx);
+        }
       } else {
         // The build partition is either empty or spilled.
         PhjBuilderPartition* build_partition =
@@ -345,22 +352,35 @@ void IR_ALWAYS_INLINE PartitionedHashJoinNode::EvalAndHashProbePrefetchGroup(
   const int prefetch_size = expr_vals_cache->capacity();
   DCHECK(expr_vals_cache->AtEnd());
 
+  // The buckets of the rows are not prefetched or pipelined if they are looked up
+  // through a direct join index.
+  const bool probe_buckets = build_hash_partitions_.direct_join_index == nullptr;
   expr_vals_cache->Reset();
+  int num_rows = 0;
   FOREACH_ROW_LIMIT(probe_batch, probe_batch_pos_, prefetch_size, batch_iter) {
     TupleRow* row = batch_iter.Get();
+    HashTable* hash_tbl = nullptr;
     if (ht_ctx->EvalAndHashProbe(row)) {
-      if (prefetch_mode != TPrefetchMode::NONE) {
+      if (prefetch_mode != TPrefetchMode::NONE && probe_buckets) {
         uint32_t hash = expr_vals_cache->CurExprValuesHash();
         const uint32_t partition_idx = hash >> (32 - NUM_PARTITIONING_BITS);
-        HashTable* hash_tbl = hash_tbls_[partition_idx];
+        hash_tbl = hash_tbls_[partition_idx];
         if (LIKELY(hash_tbl != NULL)) hash_tbl->PrefetchBucket<true>(hash);
       }
     } else {
       expr_vals_cache->SetRowNull();
     }
+    if (prefetch_mode == TPrefetchMode::HT_BUCKET_PIPELINED) {
+      pipelined_probe_tables_[num_rows] = hash_tbl;
+    }
+    ++num_rows;
     expr_vals_cache->NextRow();
   }
   expr_vals_cache->ResetForRead();
+  if (prefetch_mode == TPrefetchMode::HT_BUCKET_PIPELINED) {
+    HashTable::FindProbeRowsPipelined(pipelined_probe_tables_.data(), num_rows, ht_ctx,
+        pipelined_probe_results_.data());
+  }
 }
 
 // CreateOutputRow, EvalOtherJoinConjuncts, and EvalConjuncts are replaced by codegen.
@@ -418,8 +438,8 @@ int PartitionedHashJoinNode::ProcessProbeBatch(TPrefetchMode::type prefetch_mode
       // moving to the next row.
       DCHECK(hash_tbl_iterator_.AtEnd());
       DCHECK(status->ok());
-    } while (NextProbeRow<JoinOp>(ht_ctx, &probe_batch_iterator, &remaining_capacity,
-        status));
+    } while (NextProbeRow<JoinOp>(prefetch_mode, ht_ctx, &probe_batch_iterator,
+        &remaining_capacity, status));
     // NextProbeRow() returns false either when it exhausts its input or hits
     // an error. Otherwise we must have filled up the output batch.
     DCHECK((ht_ctx->expr_values_cache()->AtEnd() && current_probe_row_ == nullptr)
@@ -89,7 +89,10 @@ Status PartitionedHashJoinPlanNode::Init(
   RETURN_IF_ERROR(
       PhjBuilderConfig::CreateConfig(state, tnode_->node_id, tnode_->join_node.join_op,
           &build_row_desc(), eq_join_conjuncts, tnode_->runtime_filters,
-          tnode_->join_node.hash_join_node.hash_seed, &phj_builder_config_));
+          tnode_->join_node.hash_join_node.hash_seed,
+          tnode_->join_node.hash_join_node.is_switchable_broadcast,
+          tnode_->join_node.hash_join_node.dedup_build_keys,
+          &phj_builder_config_));
   state->CheckAndAddCodegenDisabledMessage(codegen_status_msgs_);
   return Status::OK();
 }
@@ -156,6 +159,11 @@ Status PartitionedHashJoinNode::Prepare(RuntimeState* state) {
   RETURN_IF_ERROR(HashTableCtx::Create(pool_, state, hash_table_config_, hash_seed(),
       MAX_PARTITION_DEPTH, build_row_desc().tuple_descriptors().size(), expr_perm_pool(),
       expr_results_pool(), probe_expr_results_pool_.get(), &ht_ctx_));
+  if (state->query_options().prefetch_mode == TPrefetchMode::HT_BUCKET_PIPELINED) {
+    int capacity = ht_ctx_->expr_values_cache()->capacity();
+    pipelined_probe_tables_.resize(capacity);
+    pipelined_probe_results_.resize(capacity);
+  }
   if (join_op_ == TJoinOp::NULL_AWARE_LEFT_ANTI_JOIN) {
     null_aware_eval_timer_ = ADD_TIMER(runtime_profile(), "NullAwareAntiJoinEvalTime");
   }
@@ -1452,7 +1460,7 @@ Status PartitionedHashJoinPlanNode::CodegenProcessProbeBatch(
   // Replace the parameter 'prefetch_mode' with constant.
   llvm::Value* prefetch_mode_arg = codegen->GetArgument(process_probe_batch_fn, 1);
   DCHECK_GE(prefetch_mode, TPrefetchMode::NONE);
-  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET);
+  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET_PIPELINED);
   prefetch_mode_arg->replaceAllUsesWith(codegen->GetI32Constant(prefetch_mode));
 
   // Codegen HashTable::Equals
@@ -1532,6 +1540,7 @@ Status PartitionedHashJoinPlanNode::CodegenProcessProbeBatch(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.group_probing, 1);
 
   llvm::Function* process_probe_batch_fn_level0 =
       codegen->CloneFunction(process_probe_batch_fn);
@@ -384,8 +384,11 @@ class PartitionedHashJoinNode : public BlockingJoinNode {
   /// values are stored in the expression values cache in 'ht_ctx'. The number of rows
   /// processed depends on the capacity available in 'ht_ctx->expr_values_cache_'.
   /// 'prefetch_mode' specifies the prefetching mode in use. If it's not PREFETCH_NONE,
-  /// hash table buckets will be prefetched based on the hash values computed. Note
-  /// that 'prefetch_mode' will be substituted with constants during codegen time.
+  /// hash table buckets will be prefetched based on the hash values computed. If it is
+  /// HT_BUCKET_PIPELINED, the rows are also looked up in their hash tables with
+  /// HashTable::FindProbeRowsPipelined() and the results are stored in
+  /// 'pipelined_probe_results_'. Note that 'prefetch_mode' will be substituted with
+  /// constants during codegen time.
   void EvalAndHashProbePrefetchGroup(TPrefetchMode::type prefetch_mode,
       HashTableCtx* ctx);
 
@@ -394,8 +397,9 @@ class PartitionedHashJoinNode : public BlockingJoinNode {
   /// next probe row and its corresponding partition. 'status' may be updated if
   /// append to the spilled partitions' BTS or null probe rows' BTS fail.
   template <int const JoinOp>
-  bool inline NextProbeRow(HashTableCtx* ht_ctx, RowBatch::Iterator* probe_batch_iterator,
-      int* remaining_capacity, Status* status) WARN_UNUSED_RESULT;
+  bool inline NextProbeRow(TPrefetchMode::type prefetch_mode, HashTableCtx* ht_ctx,
+      RowBatch::Iterator* probe_batch_iterator, int* remaining_capacity,
+      Status* status) WARN_UNUSED_RESULT;
 
   /// Process probe rows from probe_batch_. Returns either if out_batch is full or
   /// probe_batch_ is entirely consumed.
@@ -573,6 +577,12 @@ class PartitionedHashJoinNode : public BlockingJoinNode {
   /// The iterator that corresponds to the look up of current_probe_row_.
   HashTable::Iterator hash_tbl_iterator_;
 
+  /// Used with TPrefetchMode::HT_BUCKET_PIPELINED, one entry per row of the expression
+  /// values cache of 'ht_ctx_': the hash table that the row is looked up in, or NULL if
+  /// it is not looked up, and the result of the look up.
+  std::vector<HashTable*> pipelined_probe_tables_;
+  std::vector<HashTable::Iterator> pipelined_probe_results_;
+
   /// Number of probe rows that have been partitioned.
   RuntimeProfile::Counter* num_probe_rows_partitioned_ = nullptr;
 
@@ -59,9 +59,9 @@ using boost::algorithm::join;
 
 namespace impala {
 
-PROFILE_DEFINE_COUNTER(BytesRead, STABLE_HIGH, TUnit::BYTES, "Total bytes read from "
-    "disk by a scan node.");
-PROFILE_DEFINE_COUNTER(RowsRead, STABLE_HIGH, TUnit::UNIT, "Number of top-level "
+PROFILE_DEFINE_STRIPED_COUNTER(BytesRead, STABLE_HIGH, TUnit::BYTES, "Total bytes read "
+    "from disk by a scan node.");
+PROFILE_DEFINE_STRIPED_COUNTER(RowsRead, STABLE_HIGH, TUnit::UNIT, "Number of top-level "
     "rows/tuples read from the storage layer, including those discarded by predicate "
     "evaluation. Used for all types of scans.");
 PROFILE_DEFINE_RATE_COUNTER(TotalReadThroughput, STABLE_LOW, TUnit::BYTES_PER_SECOND,
@@ -157,7 +157,8 @@ Status ScanNode::Prepare(RuntimeState* state) {
     filter_ctx.filter = state->filter_bank()->RegisterConsumer(filter_desc);
     // TODO: Enable stats for min-max filters when Kudu exposes info about filters
     // (KUDU-2162).
-    if (filter_ctx.filter->is_bloom_filter() || filter_ctx.filter->is_min_max_filter()) {
+    if (filter_ctx.filter->is_bloom_filter() || filter_ctx.filter->is_min_max_filter()
+        || filter_ctx.filter->is_in_list_filter()) {
       string filter_profile_title = Substitute("Filter $0 ($1)", filter_desc.filter_id,
           PrettyPrinter::Print(filter_ctx.filter->filter_size(), TUnit::BYTES));
       RuntimeProfile* profile =
@@ -217,8 +218,15 @@ bool ScanNode::WaitForRuntimeFilters() {
   vector<string> arrived_filter_ids;
   vector<string> missing_filter_ids;
   int32_t max_arrival_delay = 0;
+  int num_topn_filters = 0;
   int64_t start = MonotonicMillis();
   for (auto& ctx: filter_ctxs_) {
+    // A top-n above this scan only publishes its filter after consuming rows of this
+    // scan, so waiting for it would only delay the scan. It is applied once it arrives.
+    if (ctx.filter->filter_desc().is_topn_filter) {
+      ++num_topn_filters;
+      continue;
+    }
     string filter_id = Substitute("$0", ctx.filter->id());
     if (ctx.filter->WaitForArrival(wait_time_ms)) {
       arrived_filter_ids.push_back(filter_id);
@@ -231,7 +239,7 @@ bool ScanNode::WaitForRuntimeFilters() {
   const string& wait_time = PrettyPrinter::Print(end - start, TUnit::TIME_MS);
   const string& arrival_delay = PrettyPrinter::Print(max_arrival_delay, TUnit::TIME_MS);
 
-  if (arrived_filter_ids.size() == filter_ctxs_.size()) {
+  if (arrived_filter_ids.size() + num_topn_filters == filter_ctxs_.size()) {
     runtime_profile()->AddInfoString("Runtime filters",
         Substitute("All filters arrived. Waited $0. Maximum arrival delay: $1.",
                                          wait_time, arrival_delay));
@@ -324,6 +332,22 @@ void ScanNode::ScannerThreadState::AddThread(unique_ptr<Thread> thread) {
   scanner_threads_.AddThread(move(thread));
 }
 
+Status ScanNode::ScannerThreadState::AddPooledThread(
+    const string& name, const Thread::ThreadFunctor& fn) {
+  // The scanner thread may finish before Run() returns, so it is counted first.
+  num_active_.Add(1);
+  peak_concurrency_->Add(1);
+  Status status =
+      ScannerThreadPool::GetInstance()->Run(name, fn, &pooled_scanner_threads_);
+  if (!status.ok()) {
+    DecrementNumActive();
+    return status;
+  }
+  VLOG_RPC << "Thread started: " << name;
+  COUNTER_ADD(num_threads_started_, 1);
+  return Status::OK();
+}
+
 bool ScanNode::ScannerThreadState::DecrementNumActive() {
   peak_concurrency_->Add(-1);
   return num_active_.Add(-1) == 0;
@@ -362,6 +386,7 @@ void ScanNode::ScannerThreadState::Shutdown() {
 
 void ScanNode::ScannerThreadState::Close(ScanNode* parent) {
   scanner_threads_.JoinAll();
+  pooled_scanner_threads_.Wait();
   DCHECK_EQ(num_active_.Load(), 0) << "There should be no active threads";
   if (batch_queue_ != nullptr) {
     row_batches_peak_mem_consumption_->Set(row_batches_mem_tracker_->peak_consumption());
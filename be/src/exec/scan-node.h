@@ -20,6 +20,7 @@
 #include <string>
 #include "exec/exec-node.h"
 #include "exec/filter-context.h"
+#include "exec/scanner-thread-pool.h"
 #include "util/runtime-profile.h"
 #include "util/thread.h"
 #include "gen-cpp/ImpalaInternalService_types.h"
@@ -225,6 +226,12 @@ class ScanNode : public ExecNode {
     /// should call AddThread() at a time.
     void AddThread(std::unique_ptr<Thread> thread);
 
+    /// Runs 'fn' as a new scanner thread 'name' on a worker of the process-wide
+    /// ScannerThreadPool instead of on a thread of its own. Counts the scanner thread as
+    /// active before it starts. Returns an error if the thread could not be started.
+    /// Not thread-safe, like AddThread().
+    Status AddPooledThread(const std::string& name, const Thread::ThreadFunctor& fn);
+
     /// Get the number of active scanner threads. Thread-safe.
     int32_t GetNumActive() const { return num_active_.Load(); }
 
@@ -260,6 +267,9 @@ class ScanNode : public ExecNode {
     /// Thread group for all scanner threads.
     ThreadGroup scanner_threads_;
 
+    /// Scanner threads that run on workers of the ScannerThreadPool.
+    ScannerThreadPool::TaskGroup pooled_scanner_threads_;
+
     /// Maximum number of scanner threads. Set to 'NUM_SCANNER_THREADS' if that query
     /// option is set. Otherwise, it's set to the number of cpu cores. Scanner threads
     /// are generally cpu bound so there is no benefit in spinning up more threads than
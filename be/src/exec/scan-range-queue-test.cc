@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/scan-range-queue.h"
+#include "runtime/io/request-ranges.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+using io::ScanRange;
+
+TEST(ScanRangeQueueTest, LargestFirst) {
+  ScanRangeQueue queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(nullptr, queue.Pop());
+  ScanRange ranges[5];
+  queue.Push(&ranges[0], 100);
+  queue.Push(&ranges[1], 1000);
+  queue.Push(&ranges[2], 10);
+  // Ranges with the same expected work are handed out in the order they were added.
+  queue.Push(&ranges[3], 1000);
+  queue.Push(&ranges[4], 100);
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(&ranges[1], queue.Pop());
+  EXPECT_EQ(&ranges[3], queue.Pop());
+  EXPECT_EQ(&ranges[0], queue.Pop());
+  EXPECT_EQ(&ranges[4], queue.Pop());
+  EXPECT_EQ(&ranges[2], queue.Pop());
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(nullptr, queue.Pop());
+}
+
+TEST(ScanRangeQueueTest, FrontRangesFirst) {
+  ScanRangeQueue queue;
+  ScanRange ranges[4];
+  queue.Push(&ranges[0], 1000);
+  queue.PushFront(&ranges[1]);
+  queue.Push(&ranges[2], 2000);
+  queue.PushFront(&ranges[3]);
+  // The ranges added to the front come first, the most recent one first.
+  EXPECT_EQ(&ranges[3], queue.Pop());
+  EXPECT_EQ(&ranges[1], queue.Pop());
+  EXPECT_EQ(&ranges[2], queue.Pop());
+  EXPECT_EQ(&ranges[0], queue.Pop());
+  EXPECT_TRUE(queue.empty());
+}
+
+}
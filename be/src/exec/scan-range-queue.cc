@@ -0,0 +1,57 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/scan-range-queue.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "common/names.h"
+
+namespace impala {
+
+void ScanRangeQueue::Push(io::ScanRange* range, int64_t expected_bytes) {
+  lock_guard<SpinLock> l(lock_);
+  heap_.push_back({expected_bytes, num_pushed_++, range});
+  std::push_heap(heap_.begin(), heap_.end(), HandOutLater);
+}
+
+void ScanRangeQueue::PushFront(io::ScanRange* range) {
+  lock_guard<SpinLock> l(lock_);
+  front_ranges_.push_front(range);
+}
+
+io::ScanRange* ScanRangeQueue::Pop() {
+  lock_guard<SpinLock> l(lock_);
+  if (!front_ranges_.empty()) {
+    io::ScanRange* range = front_ranges_.front();
+    front_ranges_.pop_front();
+    return range;
+  }
+  if (heap_.empty()) return nullptr;
+  std::pop_heap(heap_.begin(), heap_.end(), HandOutLater);
+  io::ScanRange* range = heap_.back().range;
+  heap_.pop_back();
+  return range;
+}
+
+bool ScanRangeQueue::empty() {
+  lock_guard<SpinLock> l(lock_);
+  return front_ranges_.empty() && heap_.empty();
+}
+
+}
@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "gutil/macros.h"
+#include "util/spinlock.h"
+
+namespace impala {
+
+namespace io {
+class ScanRange;
+}
+
+/// Queue of the scan ranges that the instances of an MT scan node take their work from.
+/// Every instance takes the next range when it finished its previous one, so the
+/// ranges are balanced dynamically across the instances. What remains unbalanced is the
+/// end of the scan: if a large range is taken last, the other instances sit idle while
+/// one instance scans it. The queue therefore hands out the largest ranges first
+/// (longest processing time first scheduling), so that the ranges that are left at the
+/// end of the scan are small ones that fill the gaps between the instances.
+///
+/// Ranges that must be read before the others, e.g. the remainder of a sequence file
+/// after its header or ranges cached by HDFS, are added to the front and handed out in
+/// LIFO order before any other range, like in a plain queue. Thread-safe.
+class ScanRangeQueue {
+ public:
+  ScanRangeQueue() = default;
+
+  /// Adds 'range', which takes about 'expected_bytes' bytes of work, e.g. the length of
+  /// the split that it stands for.
+  void Push(io::ScanRange* range, int64_t expected_bytes);
+
+  /// Adds 'range' in front of all ranges added with Push() and before all ranges added
+  /// with PushFront() earlier.
+  void PushFront(io::ScanRange* range);
+
+  /// Removes and returns the next range, or nullptr if the queue is empty.
+  io::ScanRange* Pop();
+
+  bool empty();
+
+ private:
+  struct Entry {
+    int64_t expected_bytes;
+    /// Number of the Push() call that added the range. Among ranges with the same
+    /// expected work, the one added first is handed out first.
+    int64_t seq;
+    io::ScanRange* range;
+  };
+
+  /// Orders 'heap_' so that the entry that should be handed out first is at the front.
+  static bool HandOutLater(const Entry& a, const Entry& b) {
+    if (a.expected_bytes != b.expected_bytes) return a.expected_bytes < b.expected_bytes;
+    return a.seq > b.seq;
+  }
+
+  SpinLock lock_;
+
+  /// Ranges added with PushFront(), the most recent one first.
+  std::deque<io::ScanRange*> front_ranges_;
+
+  /// Ranges added with Push(), as a heap ordered by HandOutLater().
+  std::vector<Entry> heap_;
+  int64_t num_pushed_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScanRangeQueue);
+};
+
+}
@@ -0,0 +1,92 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/scanner-concurrency-controller.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static const int64_t SAMPLE_NS = 200L * 1000L * 1000L;
+
+// Adds samples to 'controller' as if every thread up to 'saturation_threads' read
+// 'rows_per_thread' rows per sample and further threads did not add any rows, with the
+// scan node always running as many threads as the target. Returns the target after
+// 'num_samples' samples.
+static int Simulate(ScannerConcurrencyController* controller, int saturation_threads,
+    int64_t rows_per_thread, int num_samples) {
+  for (int i = 0; i < num_samples; ++i) {
+    const int num_threads = controller->target();
+    const int64_t num_rows = min(num_threads, saturation_threads) * rows_per_thread;
+    controller->AddSample(num_threads, num_rows, SAMPLE_NS, false);
+  }
+  return controller->target();
+}
+
+TEST(ScannerConcurrencyControllerTest, GrowsWhileThroughputScales) {
+  ScannerConcurrencyController controller(16);
+  EXPECT_EQ(1, controller.target());
+  // Every added thread pays off, so the target grows to the maximum.
+  EXPECT_EQ(16, Simulate(&controller, 100, 1000, 20));
+  EXPECT_EQ(0, controller.num_decreases());
+  EXPECT_EQ(4, controller.num_increases());
+}
+
+TEST(ScannerConcurrencyControllerTest, ShrinksWhenThreadsDoNotHelp) {
+  ScannerConcurrencyController controller(64);
+  // The throughput does not grow beyond 4 threads: the controller probes 8 threads,
+  // sees that they did not help and falls back to 4.
+  Simulate(&controller, 4, 1000, 8);
+  EXPECT_EQ(4, controller.target());
+  EXPECT_EQ(1, controller.num_decreases());
+  // While the target is held, it is not raised again.
+  const int hold_samples = ScannerConcurrencyController::HOLD_SAMPLES;
+  EXPECT_EQ(4, Simulate(&controller, 4, 1000, hold_samples));
+  // After that, the controller probes more threads again and returns to 4.
+  Simulate(&controller, 4, 1000, 3);
+  EXPECT_EQ(4, controller.target());
+  EXPECT_EQ(2, controller.num_decreases());
+}
+
+TEST(ScannerConcurrencyControllerTest, ShrinksWhenQueueIsFull) {
+  ScannerConcurrencyController controller(8);
+  EXPECT_EQ(8, Simulate(&controller, 100, 1000, 10));
+  // A full row batch queue lowers the target by one thread.
+  EXPECT_EQ(7, controller.AddSample(8, 8000, SAMPLE_NS, true));
+  // The first sample after a change is ignored.
+  EXPECT_EQ(7, controller.AddSample(8, 8000, SAMPLE_NS, true));
+  EXPECT_EQ(6, controller.AddSample(7, 7000, SAMPLE_NS, true));
+  // The target never drops below one thread.
+  ScannerConcurrencyController single_thread(8);
+  EXPECT_EQ(1, single_thread.AddSample(1, 1000, SAMPLE_NS, true));
+}
+
+TEST(ScannerConcurrencyControllerTest, DoesNotGrowBelowTarget) {
+  ScannerConcurrencyController controller(8);
+  EXPECT_EQ(2, controller.AddSample(1, 1000, SAMPLE_NS, false));
+  controller.AddSample(1, 1000, SAMPLE_NS, false);
+  // The scan node only runs one of the two threads, e.g. because it ran out of scan
+  // ranges, so the controller cannot tell whether more threads would help.
+  EXPECT_EQ(2, controller.AddSample(1, 1000, SAMPLE_NS, false));
+  EXPECT_EQ(2, controller.AddSample(1, 1000, SAMPLE_NS, false));
+  // Empty samples are ignored.
+  EXPECT_EQ(2, controller.AddSample(0, 0, SAMPLE_NS, false));
+  EXPECT_EQ(2, controller.AddSample(2, 0, 0, false));
+}
+
+}
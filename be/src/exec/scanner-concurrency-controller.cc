@@ -0,0 +1,84 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/scanner-concurrency-controller.h"
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+constexpr double ScannerConcurrencyController::MIN_MARGINAL_GAIN;
+constexpr int ScannerConcurrencyController::HOLD_SAMPLES;
+
+ScannerConcurrencyController::ScannerConcurrencyController(int max_threads)
+  : max_threads_(max_threads) {
+  DCHECK_GT(max_threads, 0);
+}
+
+int ScannerConcurrencyController::AddSample(
+    int num_threads, int64_t num_rows, int64_t duration_ns, bool queue_full) {
+  if (num_threads <= 0 || duration_ns <= 0) return target_;
+  if (num_samples_to_skip_ > 0) {
+    --num_samples_to_skip_;
+    return target_;
+  }
+  if (queue_full) {
+    // The consumer of the scan does not keep up with the scanner threads, so fewer
+    // threads produce the rows as fast as it can take them.
+    SetTarget(max(1, num_threads - 1));
+    base_threads_ = 0;
+    num_samples_to_hold_ = HOLD_SAMPLES;
+    return target_;
+  }
+  const double throughput = num_rows * 1e9 / duration_ns;
+  if (base_threads_ > 0 && num_threads > base_threads_) {
+    const double marginal_throughput =
+        (throughput - base_throughput_) / (num_threads - base_threads_);
+    if (marginal_throughput < MIN_MARGINAL_GAIN * base_throughput_ / base_threads_) {
+      // The threads added since the base sample did not pay off.
+      SetTarget(base_threads_);
+      num_samples_to_hold_ = HOLD_SAMPLES;
+      return target_;
+    }
+  }
+  base_threads_ = num_threads;
+  base_throughput_ = throughput;
+  if (num_samples_to_hold_ > 0) {
+    --num_samples_to_hold_;
+    return target_;
+  }
+  // Only try more threads if the scan node actually runs as many threads as it may.
+  if (num_threads >= target_) SetTarget(min(max_threads_, 2 * num_threads));
+  return target_;
+}
+
+void ScannerConcurrencyController::SetTarget(int target) {
+  DCHECK_GE(target, 1);
+  DCHECK_LE(target, max_threads_);
+  if (target == target_) return;
+  if (target > target_) {
+    ++num_increases_;
+  } else {
+    ++num_decreases_;
+  }
+  target_ = target;
+  num_samples_to_skip_ = 1;
+}
+
+}
@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+/// Chooses how many scanner threads a multi-threaded scan node should run from the
+/// throughput that its scanner threads achieve, for the DYNAMIC_SCANNER_THREADS query
+/// option. Without it, a scan node runs as many scanner threads as it gets thread tokens
+/// for, even if the additional threads only contend for the same disks or wait for a
+/// full row batch queue, and holds on to tokens that other queries could use.
+///
+/// The scan node periodically reports the rows that its scanner threads read in the
+/// last interval with AddSample(). The controller starts with one thread and doubles
+/// the target as long as the added threads raise the throughput by at least a quarter
+/// of the throughput per thread before they were added. Otherwise, or if the row batch
+/// queue is full, i.e. the consumer of the scan is the bottleneck, it lowers the target
+/// and holds it for a while before it tries more threads again. The first sample after
+/// every change of the target is ignored to give the threads time to start or stop.
+///
+/// Not thread-safe.
+class ScannerConcurrencyController {
+ public:
+  /// 'max_threads' is the maximum number of scanner threads of the scan node.
+  explicit ScannerConcurrencyController(int max_threads);
+
+  /// Adds a sample of an interval of 'duration_ns' in which 'num_threads' scanner threads
+  /// read 'num_rows' rows. 'queue_full' is true if the row batch queue was full at the
+  /// end of the interval. Returns the new target.
+  int AddSample(int num_threads, int64_t num_rows, int64_t duration_ns, bool queue_full);
+
+  /// The number of scanner threads that the scan node should run, between 1 and
+  /// 'max_threads'.
+  int target() const { return target_; }
+
+  /// The number of times that the target was raised or lowered.
+  int64_t num_increases() const { return num_increases_; }
+  int64_t num_decreases() const { return num_decreases_; }
+
+  /// Minimum throughput that every added thread must add, as a fraction of the
+  /// throughput per thread before they were added.
+  static constexpr double MIN_MARGINAL_GAIN = 0.25;
+
+  /// Number of samples that the target is held for after it was lowered.
+  static constexpr int HOLD_SAMPLES = 10;
+
+ private:
+  void SetTarget(int target);
+
+  const int max_threads_;
+  int target_ = 1;
+
+  /// Number of threads and throughput in rows per second of the most recent sample that
+  /// the controller accepted as a good number of threads. 'base_threads_' is 0 if there
+  /// is no such sample.
+  int base_threads_ = 0;
+  double base_throughput_ = 0;
+
+  /// Number of samples to ignore, and to not raise the target for.
+  int num_samples_to_skip_ = 0;
+  int num_samples_to_hold_ = 0;
+
+  int64_t num_increases_ = 0;
+  int64_t num_decreases_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScannerConcurrencyController);
+};
+
+}
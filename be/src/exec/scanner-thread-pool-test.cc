@@ -0,0 +1,110 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <set>
+
+#include <gflags/gflags.h>
+
+#include "common/atomic.h"
+#include "common/thread-debug-info.h"
+#include "exec/scanner-thread-pool.h"
+#include "testutil/gtest-util.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+DECLARE_int32(scanner_thread_pool_idle_timeout_ms);
+
+namespace impala {
+
+// Waits until the pool has no idle workers, so that every test starts from an empty
+// pool. Workers only become idle after their task group learned that they finished.
+static void WaitForIdleWorkersToExit() {
+  while (ScannerThreadPool::GetInstance()->num_idle_workers() > 0) SleepForMs(10);
+}
+
+TEST(ScannerThreadPoolTest, RunsAllTasks) {
+  google::FlagSaver saver;
+  FLAGS_scanner_thread_pool_idle_timeout_ms = 100;
+  WaitForIdleWorkersToExit();
+  const int NUM_TASKS = 50;
+  AtomicInt32 num_run(0);
+  ScannerThreadPool::TaskGroup group;
+  for (int i = 0; i < NUM_TASKS; ++i) {
+    ASSERT_OK(ScannerThreadPool::GetInstance()->Run(
+        Substitute("task-$0", i), [&num_run]() { num_run.Add(1); }, &group));
+  }
+  group.Wait();
+  EXPECT_EQ(NUM_TASKS, num_run.Load());
+  // The idle workers exit after the timeout.
+  WaitForIdleWorkersToExit();
+}
+
+TEST(ScannerThreadPoolTest, ReusesIdleWorkers) {
+  google::FlagSaver saver;
+  FLAGS_scanner_thread_pool_idle_timeout_ms = 60000;
+  ScannerThreadPool* pool = ScannerThreadPool::GetInstance();
+  // Tasks that run one after the other all run on the same worker.
+  set<int64_t> tids;
+  for (int i = 0; i < 10; ++i) {
+    ScannerThreadPool::TaskGroup group;
+    ASSERT_OK(pool->Run("task",
+        [&tids]() { tids.insert(GetThreadDebugInfo()->GetSystemThreadId()); }, &group));
+    group.Wait();
+    // The worker becomes idle right after the group is done.
+    while (pool->num_idle_workers() == 0) SleepForMs(1);
+  }
+  EXPECT_EQ(1, tids.size());
+  EXPECT_EQ(1, pool->num_idle_workers());
+
+  // Make the idle worker exit after its next task.
+  FLAGS_scanner_thread_pool_idle_timeout_ms = 0;
+  ScannerThreadPool::TaskGroup group;
+  ASSERT_OK(pool->Run("task", []() {}, &group));
+  group.Wait();
+  WaitForIdleWorkersToExit();
+}
+
+TEST(ScannerThreadPoolTest, ThreadDebugInfo) {
+  google::FlagSaver saver;
+  FLAGS_scanner_thread_pool_idle_timeout_ms = 100;
+  TUniqueId query_id;
+  query_id.__set_hi(123);
+  query_id.__set_lo(456);
+  TUniqueId instance_id;
+  instance_id.__set_hi(123);
+  instance_id.__set_lo(457);
+  ThreadDebugInfo tdi;
+  ScopedThreadContext tdi_context(&tdi, query_id, instance_id);
+  ScannerThreadPool::TaskGroup group;
+  TUniqueId task_query_id;
+  TUniqueId task_instance_id;
+  string task_name;
+  ASSERT_OK(ScannerThreadPool::GetInstance()->Run("scanner-thread (test)", [&]() {
+    const ThreadDebugInfo* task_tdi = GetThreadDebugInfo();
+    task_query_id = task_tdi->GetQueryId();
+    task_instance_id = task_tdi->GetInstanceId();
+    task_name = task_tdi->GetThreadName();
+  }, &group));
+  group.Wait();
+  EXPECT_EQ(query_id, task_query_id);
+  EXPECT_EQ(instance_id, task_instance_id);
+  EXPECT_EQ("scanner-thread (test)", task_name);
+  WaitForIdleWorkersToExit();
+}
+
+}
@@ -0,0 +1,148 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/scanner-thread-pool.h"
+
+#include <algorithm>
+
+#include <gflags/gflags.h>
+
+#include "common/thread-debug-info.h"
+#include "gutil/strings/substitute.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+DEFINE_int32(scanner_thread_pool_idle_timeout_ms, 10000, "(Advanced) The time, in ms, "
+    "that a worker thread of the scanner thread pool waits for the next scanner thread "
+    "to run before it exits. If 0, every scanner thread runs on a new thread that exits "
+    "when the scanner thread finishes.");
+
+namespace impala {
+
+static const string SCANNER_THREAD_POOL_THREAD_GROUP_NAME = "scanner-thread-pool";
+
+void ScannerThreadPool::TaskGroup::Wait() {
+  unique_lock<mutex> l(lock_);
+  while (num_running_ > 0) all_done_cv_.Wait(l);
+}
+
+void ScannerThreadPool::TaskGroup::AddTask() {
+  lock_guard<mutex> l(lock_);
+  ++num_running_;
+}
+
+void ScannerThreadPool::TaskGroup::TaskDone() {
+  // The group may be destroyed as soon as Wait() returns, so it must not be accessed
+  // after the lock is released.
+  lock_guard<mutex> l(lock_);
+  DCHECK_GT(num_running_, 0);
+  if (--num_running_ == 0) all_done_cv_.NotifyAll();
+}
+
+ScannerThreadPool* ScannerThreadPool::GetInstance() {
+  // Leaked on purpose: idle workers may still wait on the pool when the process exits.
+  static ScannerThreadPool* pool = new ScannerThreadPool();
+  return pool;
+}
+
+Status ScannerThreadPool::Run(
+    const string& name, const Thread::ThreadFunctor& fn, TaskGroup* group) {
+  Task task;
+  task.name = name;
+  task.fn = fn;
+  task.group = group;
+  const ThreadDebugInfo* tdi = GetThreadDebugInfo();
+  if (tdi != nullptr) {
+    task.query_id = tdi->GetQueryId();
+    task.instance_id = tdi->GetInstanceId();
+  }
+  group->AddTask();
+
+  int64_t worker_idx;
+  {
+    lock_guard<mutex> l(lock_);
+    if (!idle_workers_.empty()) {
+      Worker* worker = idle_workers_.back();
+      idle_workers_.pop_back();
+      DCHECK(!worker->has_task);
+      worker->task = move(task);
+      worker->has_task = true;
+      worker->task_cv.NotifyOne();
+      return Status::OK();
+    }
+    worker_idx = num_workers_created_++;
+  }
+
+  Worker* worker = new Worker(move(task));
+  unique_ptr<Thread> t;
+  Status status = Thread::Create(SCANNER_THREAD_POOL_THREAD_GROUP_NAME,
+      Substitute("scanner-worker-$0", worker_idx),
+      [this, worker]() { this->WorkerLoop(worker); }, &t, true);
+  if (!status.ok()) {
+    delete worker;
+    group->TaskDone();
+    return status;
+  }
+  // The worker threads exit on their own when they time out.
+  t->Detach();
+  return Status::OK();
+}
+
+int ScannerThreadPool::num_idle_workers() {
+  lock_guard<mutex> l(lock_);
+  return idle_workers_.size();
+}
+
+void ScannerThreadPool::WorkerLoop(Worker* worker) {
+  unique_ptr<Worker> worker_ptr(worker);
+  ThreadDebugInfo* tdi = GetThreadDebugInfo();
+  DCHECK(tdi != nullptr);
+  const string worker_name = tdi->GetThreadName();
+  while (true) {
+    Task* task = &worker->task;
+    {
+      // Show the scanner thread in the debug info of the worker while it runs.
+      tdi->SetThreadName(task->name);
+      ScopedThreadContext tdi_context(tdi, task->query_id, task->instance_id);
+      task->fn();
+      tdi->SetThreadName(worker_name);
+    }
+    // Release the resources of the task before the group learns that it finished.
+    TaskGroup* group = task->group;
+    task->fn = nullptr;
+    group->TaskDone();
+
+    unique_lock<mutex> l(lock_);
+    worker->has_task = false;
+    if (FLAGS_scanner_thread_pool_idle_timeout_ms <= 0) return;
+    idle_workers_.push_back(worker);
+    timespec deadline;
+    TimeFromNowMicros(FLAGS_scanner_thread_pool_idle_timeout_ms * 1000L, &deadline);
+    while (!worker->has_task) {
+      if (!worker->task_cv.WaitUntil(l, deadline) && !worker->has_task) {
+        // Timed out. Run() did not pick the worker, so it is still in the idle list.
+        auto it = std::find(idle_workers_.begin(), idle_workers_.end(), worker);
+        DCHECK(it != idle_workers_.end());
+        idle_workers_.erase(it);
+        return;
+      }
+    }
+  }
+}
+
+}
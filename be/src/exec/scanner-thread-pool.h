@@ -0,0 +1,123 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/status.h"
+#include "gen-cpp/Types_types.h"
+#include "gutil/macros.h"
+#include "util/condition-variable.h"
+#include "util/thread.h"
+
+namespace impala {
+
+/// Process-wide pool of the worker threads that run the scanner threads of the
+/// multi-threaded scan nodes, e.g. HdfsScanNode. A scan node starts a scanner thread
+/// whenever it gets a thread token and stops it when it runs out of scan ranges or has
+/// to give up the token, so scanner threads used to be created and destroyed very often.
+/// Run() hands a scanner thread to an idle worker if there is one and only creates a new
+/// thread otherwise. A worker that finished its scanner thread waits for the next one
+/// for up to --scanner_thread_pool_idle_timeout_ms before it exits.
+///
+/// The pool does not decide how many scanner threads run: the scan nodes still only
+/// start a scanner thread when the ThreadResourceMgr, the memory limits and their
+/// maximum number of scanner threads allow it, so the pool has as many busy workers as
+/// there are running scanner threads.
+///
+/// A scanner thread runs with the query and instance id of the thread that started it
+/// in its ThreadDebugInfo, like a thread created with Thread::Create().
+class ScannerThreadPool {
+ public:
+  /// The scanner threads that one scan node started. Thread-safe.
+  class TaskGroup {
+   public:
+    TaskGroup() = default;
+    ~TaskGroup() { DCHECK_EQ(num_running_, 0); }
+
+    /// Waits until all scanner threads of the group have finished.
+    void Wait();
+
+   private:
+    friend class ScannerThreadPool;
+
+    void AddTask();
+    void TaskDone();
+
+    std::mutex lock_;
+    ConditionVariable all_done_cv_;
+    int num_running_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(TaskGroup);
+  };
+
+  /// Returns the process-wide pool.
+  static ScannerThreadPool* GetInstance();
+
+  /// Runs 'fn' as the scanner thread 'name' of 'group' on an idle worker or on a new
+  /// worker thread. Returns an error if a new thread was needed but could not be
+  /// created, in which case 'fn' is not run.
+  Status Run(const std::string& name, const Thread::ThreadFunctor& fn, TaskGroup* group);
+
+  /// Returns the number of workers that wait for a scanner thread to run.
+  int num_idle_workers();
+
+ private:
+  struct Task {
+    std::string name;
+    Thread::ThreadFunctor fn;
+    TaskGroup* group = nullptr;
+    TUniqueId query_id;
+    TUniqueId instance_id;
+  };
+
+  /// A worker thread. Owned by the thread that it describes.
+  struct Worker {
+    explicit Worker(Task task) : task(std::move(task)) {}
+
+    /// The scanner thread to run. Only valid if 'has_task' is true.
+    Task task;
+    bool has_task = true;
+
+    /// Signalled when the worker is given a task while it is idle.
+    ConditionVariable task_cv;
+  };
+
+  ScannerThreadPool() = default;
+
+  /// Loop of the worker threads. Runs the task of 'worker' and then waits for new tasks
+  /// until it times out. Deletes 'worker' before returning.
+  void WorkerLoop(Worker* worker);
+
+  /// Protects all members below and the 'task' and 'has_task' of the workers.
+  std::mutex lock_;
+
+  /// The idle workers. The most recently idle worker is given the next task, so that the
+  /// other workers time out if there are more idle workers than needed.
+  std::vector<Worker*> idle_workers_;
+
+  /// Number of worker threads created, used to name them.
+  int64_t num_workers_created_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScannerThreadPool);
+};
+
+}
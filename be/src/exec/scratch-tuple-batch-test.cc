@@ -0,0 +1,62 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <vector>
+
+#include "exec/scratch-tuple-batch.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Checks that GetMicroBatches() groups 'selected_rows' into the expected ranges.
+static void TestMicroBatches(const vector<int>& selected_rows, int skip_threshold,
+    const vector<pair<int, int>>& expected) {
+  vector<ScratchMicroBatch> micro_batches;
+  ScratchTupleBatch::GetMicroBatches(selected_rows.data(), selected_rows.size(),
+      skip_threshold, &micro_batches);
+  ASSERT_EQ(expected.size(), micro_batches.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i].first, micro_batches[i].start);
+    EXPECT_EQ(expected[i].second, micro_batches[i].end);
+    EXPECT_EQ(expected[i].second - expected[i].first + 1, micro_batches[i].length());
+  }
+}
+
+TEST(ScratchTupleBatchTest, EmptySelection) {
+  TestMicroBatches({}, 0, {});
+  TestMicroBatches({}, 20, {});
+}
+
+TEST(ScratchTupleBatchTest, ContiguousSelection) {
+  TestMicroBatches({0}, 0, {{0, 0}});
+  TestMicroBatches({5, 6, 7, 8}, 0, {{5, 8}});
+  TestMicroBatches({5, 6, 7, 8}, 100, {{5, 8}});
+}
+
+TEST(ScratchTupleBatchTest, SplitOnGaps) {
+  // With a threshold of 0 every gap is skipped.
+  TestMicroBatches({1, 3, 4, 10}, 0, {{1, 1}, {3, 4}, {10, 10}});
+  // Gaps shorter than the threshold are decoded together with the selected rows.
+  TestMicroBatches({1, 3, 4, 10}, 2, {{1, 4}, {10, 10}});
+  TestMicroBatches({1, 3, 4, 10}, 5, {{1, 4}, {10, 10}});
+  TestMicroBatches({1, 3, 4, 10}, 6, {{1, 10}});
+  TestMicroBatches({0, 100, 1023}, 20, {{0, 0}, {100, 100}, {1023, 1023}});
+}
+
+}
@@ -18,12 +18,25 @@
 #ifndef IMPALA_EXEC_PARQUET_SCRATCH_TUPLE_BATCH_H
 #define IMPALA_EXEC_PARQUET_SCRATCH_TUPLE_BATCH_H
 
+#include <algorithm>
+#include <vector>
+#include <boost/scoped_array.hpp>
+
 #include "runtime/descriptors.h"
 #include "runtime/row-batch.h"
 #include "runtime/tuple-row.h"
 
 namespace impala {
 
+/// A contiguous range of rows [start, end] in a scratch batch that must be materialized.
+/// Used for late materialization, where the columns that are not referenced by
+/// conjuncts or runtime filters are only read for rows that survived filtering.
+struct ScratchMicroBatch {
+  int start;
+  int end;
+  int length() const { return end - start + 1; }
+};
+
 /// Helper struct that holds a batch of tuples allocated from a mem pool, as well
 /// as state associated with iterating over its tuples and transferring
 /// them to an output batch in TransferScratchTuples().
@@ -44,6 +57,18 @@ struct ScratchTupleBatch {
   // Bytes of fixed-length data per tuple.
   const int tuple_byte_size;
 
+  // Set to true if the tuples were already filtered by runtime filters and conjuncts
+  // and 'selected_rows' holds the indexes of the surviving tuples. In that case the
+  // tuples that were filtered out are not required to be fully materialized.
+  bool has_selection = false;
+  // Indexes of the tuples that survived filtering, in ascending order. Only valid if
+  // 'has_selection' is true. Has room for 'capacity' entries.
+  boost::scoped_array<int> selected_rows;
+  // Number of valid entries in 'selected_rows'.
+  int num_selected = 0;
+  // Index of the next entry in 'selected_rows' to transfer to an output batch.
+  int selected_idx = 0;
+
   // Pool used to allocate 'tuple_mem' and nothing else.
   MemPool tuple_mem_pool;
 
@@ -64,6 +89,7 @@ struct ScratchTupleBatch {
       const RowDescriptor& row_desc, int batch_size, MemTracker* mem_tracker)
     : capacity(batch_size),
       tuple_byte_size(row_desc.GetRowSize()),
+      selected_rows(new int[batch_size]),
       tuple_mem_pool(mem_tracker),
       aux_mem_pool(mem_tracker) {
     DCHECK_EQ(row_desc.tuple_descriptors().size(), 1);
@@ -73,6 +99,9 @@ struct ScratchTupleBatch {
     tuple_idx = 0;
     num_tuples = 0;
     num_tuples_transferred = 0;
+    has_selection = false;
+    num_selected = 0;
+    selected_idx = 0;
     if (tuple_mem == nullptr) {
       int64_t dummy;
       RETURN_IF_ERROR(RowBatch::ResizeAndAllocateTupleBuffer(
@@ -152,6 +181,73 @@ struct ScratchTupleBatch {
     return true;
   }
 
+  /// Records the tuples pointed to by the first 'num_rows' rows of 'batch' as the
+  /// selected tuples of this scratch batch. The rows must reference tuples of this
+  /// scratch batch in ascending order. Rewinds 'tuple_idx' so that the selected tuples
+  /// can be transferred with TransferSelectedTuples() once they are fully materialized.
+  void SetSelection(RowBatch* batch, int num_rows) {
+    DCHECK_LE(num_rows, num_tuples);
+    for (int i = 0; i < num_rows; ++i) {
+      uint8_t* tuple = reinterpret_cast<uint8_t*>(batch->GetRow(i)->GetTuple(0));
+      DCHECK_GE(tuple, tuple_mem);
+      DCHECK_LT(tuple, TupleEnd());
+      selected_rows[i] = (tuple - tuple_mem) / tuple_byte_size;
+      DCHECK(i == 0 || selected_rows[i - 1] < selected_rows[i]);
+    }
+    SetSelectedRows(num_rows);
+  }
+
+  /// Like SetSelection(), but the indexes of the selected tuples were already written
+  /// to 'selected_rows[0..num_rows)' in ascending order.
+  void SetSelectedRows(int num_rows) {
+    DCHECK_LE(num_rows, num_tuples);
+    num_selected = num_rows;
+    selected_idx = 0;
+    has_selection = true;
+    tuple_idx = num_selected > 0 ? selected_rows[0] : num_tuples;
+  }
+
+  /// Adds the remaining selected tuples to 'dst_batch' without re-evaluating any
+  /// predicates. Returns the number of rows added, which still need to be passed to
+  /// FinalizeTupleTransfer() and committed.
+  int TransferSelectedTuples(RowBatch* dst_batch) {
+    DCHECK(has_selection);
+    Tuple** output_row =
+        reinterpret_cast<Tuple**>(dst_batch->GetRow(dst_batch->num_rows()));
+    const int num_to_transfer = std::min(dst_batch->capacity() - dst_batch->num_rows(),
+        num_selected - selected_idx);
+    for (int i = 0; i < num_to_transfer; ++i) {
+      output_row[i] = GetTuple(selected_rows[selected_idx + i]);
+    }
+    selected_idx += num_to_transfer;
+    tuple_idx = selected_idx < num_selected ? selected_rows[selected_idx] : num_tuples;
+    return num_to_transfer;
+  }
+
+  /// Groups the ascending row indexes 'selected_rows[0..num_selected)' into ranges of
+  /// rows to materialize. Two selected rows end up in the same range if fewer than
+  /// 'skip_threshold' unselected rows lie between them, because skipping very short
+  /// runs of values is not cheaper than decoding them. Adjacent rows are always in the
+  /// same range. The ranges are appended to
+  /// 'micro_batches', which is cleared first.
+  static void GetMicroBatches(const int* selected_rows, int num_selected,
+      int skip_threshold, std::vector<ScratchMicroBatch>* micro_batches) {
+    DCHECK_GE(skip_threshold, 0);
+    micro_batches->clear();
+    if (num_selected == 0) return;
+    ScratchMicroBatch curr{selected_rows[0], selected_rows[0]};
+    for (int i = 1; i < num_selected; ++i) {
+      DCHECK_GT(selected_rows[i], curr.end);
+      const int gap = selected_rows[i] - curr.end - 1;
+      if (gap > 0 && gap >= skip_threshold) {
+        micro_batches->push_back(curr);
+        curr.start = selected_rows[i];
+      }
+      curr.end = selected_rows[i];
+    }
+    micro_batches->push_back(curr);
+  }
+
   Tuple* GetTuple(int tuple_idx) const {
     return reinterpret_cast<Tuple*>(tuple_mem + tuple_idx * tuple_byte_size);
   }
@@ -41,3 +41,17 @@ void SelectNode::CopyRows(RowBatch* output_batch) {
     }
   }
 }
+
+int SelectNode::FilterRows(RowBatch* batch, int* selected) {
+  ScalarExprEvaluator* const* conjunct_evals = conjunct_evals_.data();
+  int num_conjuncts = conjuncts_.size();
+  DCHECK_EQ(num_conjuncts, conjunct_evals_.size());
+
+  int num_selected = 0;
+  FOREACH_ROW(batch, 0, batch_iter) {
+    // Always write the index, it is only kept if the row passes.
+    selected[num_selected] = batch_iter.RowNum();
+    num_selected += EvalConjuncts(conjunct_evals, num_conjuncts, batch_iter.Get());
+  }
+  return num_selected;
+}
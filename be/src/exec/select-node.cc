@@ -19,6 +19,7 @@
 
 #include "codegen/llvm-codegen.h"
 #include "exec/exec-node-util.h"
+#include "exprs/batch-conjunct-evaluator.h"
 #include "exprs/scalar-expr-evaluator.h"
 #include "exprs/scalar-expr.h"
 #include "gen-cpp/PlanNodes_types.h"
@@ -32,6 +33,15 @@
 
 namespace impala {
 
+/// Returns true if 'batch' has neither rows nor attached resources, so that the child
+/// can return its rows in it.
+static bool IsEmptyBatch(RowBatch* batch) {
+  return batch->num_rows() == 0 && batch->num_buffers() == 0
+      && batch->tuple_data_pool()->total_allocated_bytes() == 0
+      && batch->flush_mode() == RowBatch::FlushMode::NO_FLUSH_RESOURCES
+      && !batch->needs_deep_copy();
+}
+
 Status SelectPlanNode::CreateExecNode(RuntimeState* state, ExecNode** node) const {
   ObjectPool* pool = state->obj_pool();
   *node = pool->Add(new SelectNode(pool, *this, state->desc_tbl()));
@@ -44,7 +54,8 @@ SelectNode::SelectNode(
     child_row_batch_(NULL),
     child_row_idx_(0),
     child_eos_(false),
-    codegend_copy_rows_fn_(pnode.codegend_copy_rows_fn_) {}
+    codegend_copy_rows_fn_(pnode.codegend_copy_rows_fn_),
+    codegend_filter_rows_fn_(pnode.codegend_filter_rows_fn_) {}
 
 Status SelectNode::Prepare(RuntimeState* state) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
@@ -56,20 +67,22 @@ void SelectPlanNode::Codegen(FragmentState* state) {
   DCHECK(state->ShouldCodegen());
   PlanNode::Codegen(state);
   if (IsNodeCodegenDisabled()) return;
-  AddCodegenStatus(CodegenCopyRows(state));
+  llvm::Function* eval_conjuncts_fn;
+  Status status =
+      ExecNode::CodegenEvalConjuncts(state->codegen(), conjuncts_, &eval_conjuncts_fn);
+  if (status.ok()) status = CodegenCopyRows(state, eval_conjuncts_fn);
+  if (status.ok()) status = CodegenFilterRows(state, eval_conjuncts_fn);
+  AddCodegenStatus(status);
 }
 
-Status SelectPlanNode::CodegenCopyRows(FragmentState* state) {
+Status SelectPlanNode::CodegenCopyRows(
+    FragmentState* state, llvm::Function* eval_conjuncts_fn) {
   LlvmCodeGen* codegen = state->codegen();
   DCHECK(codegen != nullptr);
   llvm::Function* copy_rows_fn =
       codegen->GetFunction(IRFunction::SELECT_NODE_COPY_ROWS, true);
   DCHECK(copy_rows_fn != nullptr);
 
-  llvm::Function* eval_conjuncts_fn;
-  RETURN_IF_ERROR(
-      ExecNode::CodegenEvalConjuncts(codegen, conjuncts_, &eval_conjuncts_fn));
-
   int replaced = codegen->ReplaceCallSites(copy_rows_fn, eval_conjuncts_fn,
       "EvalConjuncts");
   DCHECK_REPLACE_COUNT(replaced, 1);
@@ -79,10 +92,35 @@ Status SelectPlanNode::CodegenCopyRows(FragmentState* state) {
   return Status::OK();
 }
 
+Status SelectPlanNode::CodegenFilterRows(
+    FragmentState* state, llvm::Function* eval_conjuncts_fn) {
+  LlvmCodeGen* codegen = state->codegen();
+  DCHECK(codegen != nullptr);
+  llvm::Function* filter_rows_fn =
+      codegen->GetFunction(IRFunction::SELECT_NODE_FILTER_ROWS, true);
+  DCHECK(filter_rows_fn != nullptr);
+
+  int replaced = codegen->ReplaceCallSites(filter_rows_fn, eval_conjuncts_fn,
+      "EvalConjuncts");
+  DCHECK_REPLACE_COUNT(replaced, 1);
+  filter_rows_fn = codegen->FinalizeFunction(filter_rows_fn);
+  if (filter_rows_fn == nullptr) return Status("Failed to finalize FilterRows().");
+  codegen->AddFunctionToJit(filter_rows_fn, &codegend_filter_rows_fn_);
+  return Status::OK();
+}
+
 Status SelectNode::Open(RuntimeState* state) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
   ScopedOpenEventAdder ea(this);
   RETURN_IF_ERROR(ExecNode::Open(state));
+  // The evaluator is kept across Open() calls, e.g. in a subplan, since a new one would
+  // allocate the constants of the conjuncts again.
+  if (state->query_options().batch_conjunct_evaluation && batch_conjunct_eval_ == nullptr
+      && !conjunct_evals_.empty()) {
+    RETURN_IF_ERROR(BatchConjunctEvaluator::Create(
+        state, pool_, conjunct_evals_, &batch_conjunct_eval_));
+  }
+  selected_rows_.resize(state->batch_size());
   RETURN_IF_ERROR(child(0)->Open(state));
   child_row_batch_.reset(
       new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
@@ -97,6 +135,15 @@ Status SelectNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
   do {
     RETURN_IF_CANCELLED(state);
     RETURN_IF_ERROR(QueryMaintenance(state));
+    if (child_row_batch_->num_rows() == 0 && IsEmptyBatch(row_batch)) {
+      // Let the child return its rows directly in 'row_batch' and drop the ones that do
+      // not pass in place, instead of copying the passing ones from another batch.
+      RETURN_IF_ERROR(child(0)->GetNext(state, row_batch, &child_eos_));
+      FilterInPlace(row_batch);
+      COUNTER_SET(rows_returned_counter_, rows_returned());
+      *eos = ReachedLimit() || child_eos_;
+      continue;
+    }
     if (child_row_batch_->num_rows() == 0) {
       // Fetch rows from child if either child row batch has been
       // consumed completely or it is empty.
@@ -104,7 +151,9 @@ Status SelectNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
     }
 
     SelectPlanNode::CopyRowsFn copy_rows_fn = codegend_copy_rows_fn_.load();
-    if (copy_rows_fn != nullptr) {
+    if (batch_conjunct_eval_ != nullptr) {
+      CopyRowsBatched(row_batch);
+    } else if (copy_rows_fn != nullptr) {
       copy_rows_fn(this, row_batch);
     } else {
       CopyRows(row_batch);
@@ -121,6 +170,45 @@ Status SelectNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
   return Status::OK();
 }
 
+void SelectNode::FilterInPlace(RowBatch* batch) {
+  const int num_rows = batch->num_rows();
+  if (selected_rows_.size() < num_rows) selected_rows_.resize(num_rows);
+  int* selected_rows = selected_rows_.data();
+  int num_selected;
+  if (batch_conjunct_eval_ != nullptr) {
+    for (int i = 0; i < num_rows; ++i) selected_rows[i] = i;
+    num_selected = batch_conjunct_eval_->Filter(batch, selected_rows, num_rows);
+  } else {
+    SelectPlanNode::FilterRowsFn filter_rows_fn = codegend_filter_rows_fn_.load();
+    num_selected = filter_rows_fn != nullptr ?
+        filter_rows_fn(this, batch, selected_rows) :
+        FilterRows(batch, selected_rows);
+  }
+  if (limit_ != -1) num_selected = min<int64_t>(num_selected, limit_ - rows_returned());
+  batch->SetSelection(selected_rows, num_selected);
+  batch->CompactSelection();
+  IncrementNumRowsReturned(num_selected);
+}
+
+void SelectNode::CopyRowsBatched(RowBatch* output_batch) {
+  const int num_rows = min(child_row_batch_->num_rows() - child_row_idx_,
+      output_batch->capacity() - output_batch->num_rows());
+  DCHECK_LE(num_rows, static_cast<int>(selected_rows_.size()));
+  int* selected_rows = selected_rows_.data();
+  for (int i = 0; i < num_rows; ++i) selected_rows[i] = child_row_idx_ + i;
+  int num_selected =
+      batch_conjunct_eval_->Filter(child_row_batch_.get(), selected_rows, num_rows);
+  child_row_idx_ += num_rows;
+  if (limit_ != -1) num_selected = min<int64_t>(num_selected, limit_ - rows_returned());
+  const int dst_row_idx = output_batch->num_rows();
+  for (int i = 0; i < num_selected; ++i) {
+    output_batch->CopyRow(child_row_batch_->GetRow(selected_rows[i]),
+        output_batch->GetRow(dst_row_idx + i));
+  }
+  output_batch->CommitRows(num_selected);
+  IncrementNumRowsReturned(num_selected);
+}
+
 Status SelectNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   child_row_batch_->TransferResourceOwnership(row_batch);
   child_row_idx_ = 0;
@@ -19,6 +19,8 @@
 #ifndef IMPALA_EXEC_SELECT_NODE_H
 #define IMPALA_EXEC_SELECT_NODE_H
 
+#include <vector>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "codegen/codegen-fn-ptr.h"
@@ -27,6 +29,7 @@
 
 namespace impala {
 
+class BatchConjunctEvaluator;
 class SelectNode;
 class Tuple;
 class TupleRow;
@@ -42,13 +45,24 @@ class SelectPlanNode : public PlanNode {
   typedef void (*CopyRowsFn)(SelectNode*, RowBatch*);
   CodegenFnPtr<CopyRowsFn> codegend_copy_rows_fn_;
 
+  /// Codegened version of SelectNode::FilterRows().
+  typedef int (*FilterRowsFn)(SelectNode*, RowBatch*, int*);
+  CodegenFnPtr<FilterRowsFn> codegend_filter_rows_fn_;
+
  private:
-  /// Codegen SelectNode::CopyRows().
-  Status CodegenCopyRows(FragmentState* state);
+  /// Codegen SelectNode::CopyRows() and SelectNode::FilterRows() with the codegened
+  /// 'eval_conjuncts_fn'.
+  Status CodegenCopyRows(FragmentState* state, llvm::Function* eval_conjuncts_fn);
+  Status CodegenFilterRows(FragmentState* state, llvm::Function* eval_conjuncts_fn);
 };
 
 /// Node that evaluates conjuncts and enforces a limit but otherwise passes along
 /// the rows pulled from its child unchanged.
+///
+/// If the output batch is empty, the child returns its rows directly in it, and the
+/// rows that do not pass the conjuncts are dropped in place through a selection vector
+/// (see RowBatch::SetSelection()). Otherwise the passing rows of 'child_row_batch_' are
+/// copied into the output batch until it is at capacity.
 
 class SelectNode : public ExecNode {
  public:
@@ -76,13 +90,34 @@ class SelectNode : public ExecNode {
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
-  /// Reference to the codegened function pointer owned by the SelectPlanNode object that
-  /// was used to create this instance.
+  /// Evaluates the conjuncts over many rows at a time if the query option
+  /// BATCH_CONJUNCT_EVALUATION is set, NULL otherwise. Owned by 'pool_'.
+  BatchConjunctEvaluator* batch_conjunct_eval_ = nullptr;
+
+  /// Indices of the rows of the batch that the conjuncts selected, the selection vector
+  /// of FilterInPlace() and CopyRowsBatched().
+  std::vector<int> selected_rows_;
+
+  /// References to the codegened function pointers owned by the SelectPlanNode object
+  /// that was used to create this instance.
   const CodegenFnPtr<SelectPlanNode::CopyRowsFn>& codegend_copy_rows_fn_;
+  const CodegenFnPtr<SelectPlanNode::FilterRowsFn>& codegend_filter_rows_fn_;
 
   /// Copy rows from child_row_batch_ for which conjuncts_ evaluate to true to
   /// output_batch, up to limit_ or till the output row batch reaches capacity.
   void CopyRows(RowBatch* output_batch);
+
+  /// Same as CopyRows() but evaluates the conjuncts with 'batch_conjunct_eval_' over as
+  /// many rows of child_row_batch_ as fit into 'output_batch'.
+  void CopyRowsBatched(RowBatch* output_batch);
+
+  /// Writes the indices of the rows of 'batch' for which conjuncts_ evaluate to true to
+  /// 'selected' and returns their number.
+  int FilterRows(RowBatch* batch, int* selected);
+
+  /// Drops the rows of 'batch' that do not pass the conjuncts or exceed the limit in
+  /// place, leaving it with a dense selection of the others.
+  void FilterInPlace(RowBatch* batch);
 };
 
 }
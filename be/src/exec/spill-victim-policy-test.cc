@@ -0,0 +1,65 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/spill-victim-policy.h"
+
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+DECLARE_string(spill_victim_policy);
+
+namespace impala {
+
+// Two partitions that free the same memory. The second one holds a tenth of the rows, so
+// fewer later rows follow it to scratch.
+static const vector<SpillCandidate> SAME_SIZE_CANDIDATES = {
+    {1000, 900, 100}, {1000, 900, 10}};
+
+TEST(SpillVictimPolicyTest, Largest) {
+  google::FlagSaver saver;
+  FLAGS_spill_victim_policy = "largest";
+  const SpillVictimPolicy* policy = SpillVictimPolicy::Get();
+  EXPECT_EQ(-1, policy->ChooseVictim({}, 1));
+  EXPECT_EQ(1, policy->ChooseVictim({{100, 100, 1}, {200, 100, 1}, {150, 100, 1}}, 1));
+  // Ties go to the first partition.
+  EXPECT_EQ(0, policy->ChooseVictim(SAME_SIZE_CANDIDATES, 1));
+}
+
+TEST(SpillVictimPolicyTest, MinScratchIo) {
+  google::FlagSaver saver;
+  FLAGS_spill_victim_policy = "min_scratch_io";
+  const SpillVictimPolicy* policy = SpillVictimPolicy::Get();
+  EXPECT_EQ(-1, policy->ChooseVictim({}, 1));
+  EXPECT_EQ(-1, policy->ChooseVictim({{0, 0, 0}}, 1));
+  EXPECT_EQ(1, policy->ChooseVictim(SAME_SIZE_CANDIDATES, 1));
+  // Without later rows, the partition with the least spilled bytes per freed byte wins,
+  // e.g. the one with the larger hash table.
+  EXPECT_EQ(1, policy->ChooseVictim({{1000, 900, 10}, {1000, 500, 10}}, 0));
+  // Of partitions with the same cost, the one that frees more memory wins.
+  EXPECT_EQ(1, policy->ChooseVictim({{100, 100, 1}, {200, 200, 2}}, 1));
+}
+
+TEST(SpillVictimPolicyTest, ExpectedScratchBytes) {
+  // The average row is 1800 / 110 bytes wide, so 100 later rows make up ~1636 bytes.
+  EXPECT_EQ(2 * (900 + 1636),
+      SpillVictimPolicy::ExpectedScratchBytes(SAME_SIZE_CANDIDATES, 0, 1));
+  EXPECT_EQ(2 * 900, SpillVictimPolicy::ExpectedScratchBytes(SAME_SIZE_CANDIDATES, 0, 0));
+  EXPECT_EQ(2 * (900 + 327),
+      SpillVictimPolicy::ExpectedScratchBytes(SAME_SIZE_CANDIDATES, 1, 2));
+}
+}
@@ -0,0 +1,108 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/spill-victim-policy.h"
+
+#include <gflags/gflags.h>
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+DEFINE_string(spill_victim_policy, "min_scratch_io", "(Advanced) How hash joins and "
+    "grouping aggregations choose the partition to spill when they need memory. "
+    "'largest' spills the partition that frees the most memory. 'min_scratch_io' spills "
+    "the partition with the least expected scratch reads and writes, including those of "
+    "the later probe or input rows of the partition, per byte of freed memory.");
+
+DEFINE_validator(spill_victim_policy, [](const char* name, const string& val) {
+  if (val == "largest" || val == "min_scratch_io") return true;
+  LOG(ERROR) << "Invalid value for --" << name << ": must be one of 'largest' or "
+      << "'min_scratch_io'";
+  return false;
+});
+
+namespace {
+
+class LargestPolicy : public SpillVictimPolicy {
+ public:
+  int ChooseVictim(const vector<SpillCandidate>& candidates,
+      double later_rows_per_row) const override {
+    return LargestCandidate(candidates);
+  }
+};
+
+class MinScratchIoPolicy : public SpillVictimPolicy {
+ public:
+  int ChooseVictim(const vector<SpillCandidate>& candidates,
+      double later_rows_per_row) const override {
+    int best_idx = -1;
+    double best_cost = 0;
+    for (int i = 0; i < candidates.size(); ++i) {
+      if (candidates[i].freed_bytes <= 0) continue;
+      double cost = ExpectedScratchBytes(candidates, i, later_rows_per_row)
+          / static_cast<double>(candidates[i].freed_bytes);
+      // Prefer the partition that frees more memory if the costs are equal.
+      if (best_idx == -1 || cost < best_cost
+          || (cost == best_cost
+              && candidates[i].freed_bytes > candidates[best_idx].freed_bytes)) {
+        best_idx = i;
+        best_cost = cost;
+      }
+    }
+    return best_idx;
+  }
+};
+
+}
+
+int64_t SpillVictimPolicy::ExpectedScratchBytes(const vector<SpillCandidate>& candidates,
+    int idx, double later_rows_per_row) {
+  DCHECK_GE(idx, 0);
+  DCHECK_LT(idx, candidates.size());
+  int64_t total_bytes = 0;
+  int64_t total_rows = 0;
+  for (const SpillCandidate& candidate : candidates) {
+    total_bytes += candidate.spilled_bytes;
+    total_rows += candidate.num_rows;
+  }
+  double row_bytes = total_rows == 0 ? 0 : total_bytes / static_cast<double>(total_rows);
+  double later_bytes = candidates[idx].num_rows * later_rows_per_row * row_bytes;
+  // All bytes are written once and read back once.
+  return 2 * (candidates[idx].spilled_bytes + static_cast<int64_t>(later_bytes));
+}
+
+int SpillVictimPolicy::LargestCandidate(const vector<SpillCandidate>& candidates) {
+  int largest_idx = -1;
+  int64_t max_freed_bytes = 0;
+  for (int i = 0; i < candidates.size(); ++i) {
+    if (candidates[i].freed_bytes > max_freed_bytes) {
+      max_freed_bytes = candidates[i].freed_bytes;
+      largest_idx = i;
+    }
+  }
+  return largest_idx;
+}
+
+const SpillVictimPolicy* SpillVictimPolicy::Get() {
+  static const LargestPolicy largest_policy;
+  static const MinScratchIoPolicy min_scratch_io_policy;
+  if (FLAGS_spill_victim_policy == "largest") return &largest_policy;
+  return &min_scratch_io_policy;
+}
@@ -0,0 +1,67 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace impala {
+
+/// A partition of a hash join build or a grouping aggregation that can be spilled.
+struct SpillCandidate {
+  /// Bytes of memory that spilling the partition frees.
+  int64_t freed_bytes;
+  /// Bytes of rows of the partition that are written to scratch and read back.
+  int64_t spilled_bytes;
+  /// Number of rows in the partition.
+  int64_t num_rows;
+};
+
+/// Chooses the partition that a hash join build or a grouping aggregation spills when it
+/// needs more memory. The policy is selected with --spill_victim_policy:
+///  'largest': spill the partition that frees the most memory.
+///  'min_scratch_io': spill the partition with the least expected scratch I/O per byte
+///    of freed memory. Spilling a partition writes its rows to scratch and reads them
+///    back, and also sends the later rows that hash to the partition (probe rows of a
+///    join, input rows of an aggregation) to scratch and back. The number of later rows
+///    is estimated from the number of rows in the partition, so of two partitions that
+///    hold the same bytes, the one with fewer and wider rows is cheaper to spill.
+class SpillVictimPolicy {
+ public:
+  virtual ~SpillVictimPolicy() {}
+
+  /// Returns the index of the partition to spill in 'candidates' or -1 if there is
+  /// none. 'later_rows_per_row' is the expected number of later rows for each row of a
+  /// partition.
+  virtual int ChooseVictim(const std::vector<SpillCandidate>& candidates,
+      double later_rows_per_row) const = 0;
+
+  /// Returns the expected bytes that are written to and read from scratch if candidate
+  /// 'idx' is spilled. The later rows are assumed to be as wide as the average row of
+  /// 'candidates'.
+  static int64_t ExpectedScratchBytes(const std::vector<SpillCandidate>& candidates,
+      int idx, double later_rows_per_row);
+
+  /// Returns the index of the candidate that frees the most memory or -1 if there is
+  /// none.
+  static int LargestCandidate(const std::vector<SpillCandidate>& candidates);
+
+  /// Returns the policy selected with --spill_victim_policy.
+  static const SpillVictimPolicy* Get();
+};
+}
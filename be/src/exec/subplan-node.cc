@@ -18,6 +18,7 @@
 #include "exec/subplan-node.h"
 
 #include "exec/exec-node-util.h"
+#include "exec/nested-loop-join-node.h"
 #include "exec/singular-row-src-node.h"
 #include "exec/subplan-node.h"
 #include "exec/unnest-node.h"
@@ -91,14 +92,64 @@ Status SubplanNode::Prepare(RuntimeState* state) {
   RETURN_IF_ERROR(ExecNode::Prepare(state));
   input_batch_.reset(
       new RowBatch(child(0)->row_desc(), state->batch_size(), mem_tracker()));
+  InitBatchedUnnest(state);
   return Status::OK();
 }
 
+void SubplanNode::InitBatchedUnnest(RuntimeState* state) {
+  if (!state->query_options().batched_subplan_unnest) return;
+  ExecNode* join = child(1);
+  if (join->type() != TPlanNodeType::NESTED_LOOP_JOIN_NODE) return;
+  if (join->num_children() != 2 || !join->conjuncts().empty() || join->limit() != -1) {
+    return;
+  }
+  const NestedLoopJoinPlanNode& join_pnode =
+      static_cast<const NestedLoopJoinPlanNode&>(join->plan_node());
+  if (!join_pnode.join_conjuncts_.empty()) return;
+
+  // The unnest can be either child of the join. The output rows of the join consist of
+  // the tuples of its first child followed by the tuples of its second child.
+  const int unnest_child_idx =
+      join->child(0)->type() == TPlanNodeType::UNNEST_NODE ? 0 : 1;
+  ExecNode* unnest = join->child(unnest_child_idx);
+  ExecNode* row_src = join->child(1 - unnest_child_idx);
+  if (unnest->type() != TPlanNodeType::UNNEST_NODE || unnest->limit() != -1) return;
+  if (row_src->type() != TPlanNodeType::SINGULAR_ROW_SRC_NODE || row_src->limit() != -1
+      || !row_src->conjuncts().empty()) {
+    return;
+  }
+  switch (join_pnode.join_op()) {
+    case TJoinOp::INNER_JOIN:
+    case TJoinOp::CROSS_JOIN:
+      batched_outer_join_ = false;
+      break;
+    case TJoinOp::LEFT_OUTER_JOIN:
+      if (unnest_child_idx != 1) return;
+      batched_outer_join_ = true;
+      break;
+    case TJoinOp::RIGHT_OUTER_JOIN:
+      if (unnest_child_idx != 0) return;
+      batched_outer_join_ = true;
+      break;
+    default:
+      return;
+  }
+  num_input_tuples_ = child(0)->row_desc()->tuple_descriptors().size();
+  DCHECK_EQ(num_input_tuples_, row_src->row_desc()->tuple_descriptors().size());
+  DCHECK_EQ(num_input_tuples_ + 1, row_desc()->tuple_descriptors().size());
+  batched_unnest_ = static_cast<UnnestNode*>(unnest);
+  DCHECK(batched_unnest_->get_containing_subplan() == this);
+  batched_item_tuple_idx_ = unnest_child_idx == 0 ? 0 : num_input_tuples_;
+  batched_input_tuple_idx_ = unnest_child_idx == 0 ? 1 : 0;
+  runtime_profile_->AppendExecOption("Batched Unnest");
+}
+
 Status SubplanNode::Open(RuntimeState* state) {
   SCOPED_TIMER(runtime_profile_->total_time_counter());
   ScopedOpenEventAdder ea(this);
   RETURN_IF_ERROR(ExecNode::Open(state));
   RETURN_IF_ERROR(child(0)->Open(state));
+  if (batched_unnest_ != nullptr) RETURN_IF_ERROR(batched_unnest_->OpenExprs(state));
   return Status::OK();
 }
 
@@ -108,6 +159,7 @@ Status SubplanNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
   RETURN_IF_CANCELLED(state);
   RETURN_IF_ERROR(QueryMaintenance(state));
   *eos = false;
+  if (batched_unnest_ != nullptr) return GetNextBatched(state, row_batch, eos);
 
   while (true) {
     if (subplan_is_open_) {
@@ -165,11 +217,77 @@ Status SubplanNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
   return Status::OK();
 }
 
+Status SubplanNode::GetNextBatched(
+    RuntimeState* state, RowBatch* row_batch, bool* eos) {
+  // Frees the results of the conjuncts of the unnest.
+  RETURN_IF_ERROR(batched_unnest_->QueryMaintenance(state));
+  const int item_byte_size = batched_unnest_->item_byte_size_;
+  while (!row_batch->AtCapacity()) {
+    if (input_row_idx_ >= input_batch_->num_rows()) {
+      input_batch_->TransferResourceOwnership(row_batch);
+      if (input_eos_) {
+        *eos = true;
+        break;
+      }
+      // Could be at capacity after resources have been transferred to it.
+      if (row_batch->AtCapacity()) break;
+      // Continue fetching input rows.
+      input_batch_->Reset();
+      RETURN_IF_ERROR(child(0)->GetNext(state, input_batch_.get(), &input_eos_));
+      input_row_idx_ = 0;
+      continue;
+    }
+
+    TupleRow* input_row = input_batch_->GetRow(input_row_idx_);
+    if (batched_coll_value_ == nullptr) {
+      batched_coll_value_ = batched_unnest_->RetrieveCollection(input_row);
+      batched_item_idx_ = 0;
+      batched_item_matched_ = false;
+    }
+    const int num_items = batched_coll_value_->num_tuples;
+    while (batched_item_idx_ < num_items && !row_batch->AtCapacity()) {
+      Tuple* item = reinterpret_cast<Tuple*>(
+          batched_coll_value_->ptr + batched_item_idx_ * item_byte_size);
+      ++batched_item_idx_;
+      if (!batched_unnest_->EvalItemConjuncts(item)) continue;
+      AddBatchedRow(input_row, item, row_batch);
+      batched_item_matched_ = true;
+    }
+    // The output batch is at capacity before all items of the input row were unnested.
+    if (batched_item_idx_ < num_items) break;
+    if (batched_outer_join_ && !batched_item_matched_) {
+      if (row_batch->AtCapacity()) break;
+      AddBatchedRow(input_row, nullptr, row_batch);
+    }
+    batched_coll_value_ = nullptr;
+    ++input_row_idx_;
+  }
+
+  if (limit_ != -1 && rows_returned() + row_batch->num_rows() >= limit_) {
+    row_batch->set_num_rows(limit_ - rows_returned());
+    *eos = true;
+  }
+  IncrementNumRowsReturned(row_batch->num_rows());
+  COUNTER_SET(rows_returned_counter_, rows_returned());
+  return Status::OK();
+}
+
+void SubplanNode::AddBatchedRow(TupleRow* input_row, Tuple* item, RowBatch* row_batch) {
+  DCHECK(!row_batch->AtCapacity());
+  TupleRow* row = row_batch->GetRow(row_batch->AddRow());
+  for (int i = 0; i < num_input_tuples_; ++i) {
+    row->SetTuple(batched_input_tuple_idx_ + i, input_row->GetTuple(i));
+  }
+  row->SetTuple(batched_item_tuple_idx_, item);
+  row_batch->CommitLastRow();
+}
+
 Status SubplanNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   input_batch_->TransferResourceOwnership(row_batch);
   input_eos_ = false;
   input_row_idx_ = 0;
   subplan_eos_ = false;
+  batched_coll_value_ = nullptr;
   SetNumRowsReturned(0);
   RETURN_IF_ERROR(child(0)->Reset(state, row_batch));
   // If child(1) is not open it means that we have just Reset() it and returned from
@@ -23,7 +23,10 @@
 
 namespace impala {
 
+class CollectionValue;
+class Tuple;
 class TupleRow;
+class UnnestNode;
 
 class SubplanPlanNode : public PlanNode {
  public:
@@ -61,6 +64,18 @@ class SubplanPlanNode : public PlanNode {
 /// The resources owned by batches from the first child of this node are always
 /// transferred to the output batch right before fetching a new batch from the
 /// first child.
+///
+/// Batched Unnest:
+/// The most common subplans only join every input row with the items of one of its
+/// collections, i.e. the second child is a cross, inner or outer NestedLoopJoinNode
+/// without join conjuncts over a SingularRowSrcNode and an UnnestNode. Opening, pulling
+/// one row batch from and resetting such a subplan tree for every input row dominates
+/// queries over small collections. With the BATCHED_SUBPLAN_UNNEST query option, this
+/// node instead unnests the collections of all rows of an input batch in one pass and
+/// produces the rows of the join itself, evaluating the conjuncts of the UnnestNode on
+/// the items. The nodes of the second child are prepared and closed, but never opened.
+/// The output rows reference the input tuples and the collection items, whose memory
+/// is owned by the input batch, exactly like the rows of the subplan tree would.
 
 class SubplanNode : public ExecNode {
  public:
@@ -82,6 +97,20 @@ class SubplanNode : public ExecNode {
   /// the children nodes have this set before prepare is called on them.
   void SetContainingSubplan(SubplanNode* ancestor, ExecNode* node);
 
+  /// Sets 'batched_unnest_' and the layout of the output rows if the second child can be
+  /// evaluated by this node for whole input batches. Called in Prepare().
+  void InitBatchedUnnest(RuntimeState* state);
+
+  /// GetNext() if 'batched_unnest_' is set: unnests the collections of the rows of
+  /// 'input_batch_' and adds a row to 'row_batch' for every item that passes the
+  /// conjuncts of 'batched_unnest_', and for every input row without such an item if
+  /// 'batched_outer_join_' is true.
+  Status GetNextBatched(RuntimeState* state, RowBatch* row_batch, bool* eos);
+
+  /// Adds the output row of 'input_row' and the collection item 'item', which may be
+  /// NULL, to 'row_batch', which must not be at capacity.
+  void AddBatchedRow(TupleRow* input_row, Tuple* item, RowBatch* row_batch);
+
   /// Returns the current row from child(0) or NULL if no rows from child(0) have been
   /// retrieved yet (GetNext() has not yet been called). This function is called by
   /// singular-row-src and unnest nodes while evaluating child(1).
@@ -105,6 +134,31 @@ class SubplanNode : public ExecNode {
 
   /// Saved from the last call to GetNext() on our second child.
   bool subplan_eos_;
+
+  /// The UnnestNode of the second child if this node unnests the collections of its
+  /// input itself. NULL otherwise. See the class comment.
+  UnnestNode* batched_unnest_ = nullptr;
+
+  /// True if input rows without any item that passes the conjuncts produce an output
+  /// row with a NULL item tuple, i.e. the input rows are the outer side of the join.
+  bool batched_outer_join_ = false;
+
+  /// Index of the item tuple and of the first tuple of the input row in output rows.
+  int batched_item_tuple_idx_ = 0;
+  int batched_input_tuple_idx_ = 0;
+
+  /// Number of tuples of the rows of the first child.
+  int num_input_tuples_ = 0;
+
+  /// The collection of the input row at 'input_row_idx_', or NULL if it was not
+  /// retrieved yet.
+  const CollectionValue* batched_coll_value_ = nullptr;
+
+  /// Index of the next item of 'batched_coll_value_' to unnest.
+  int batched_item_idx_ = 0;
+
+  /// True if an item of 'batched_coll_value_' passed the conjuncts.
+  bool batched_item_matched_ = false;
 };
 
 }
@@ -0,0 +1,104 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <string>
+#include <vector>
+
+#include "exec/text-converter.inline.h"
+#include "runtime/types.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Checks that TextConverter::ParseInt() matches StringParser::StringToInt().
+template <typename T>
+void TestParseInt(const string& str) {
+  StringParser::ParseResult expected_result;
+  const T expected = StringParser::StringToInt<T>(str.data(), str.size(),
+      &expected_result);
+  StringParser::ParseResult result;
+  const T actual = TextConverter::ParseInt<T>(str.data(), str.size(), &result);
+  EXPECT_EQ(result, expected_result) << str;
+  if (result == StringParser::PARSE_SUCCESS) EXPECT_EQ(actual, expected) << str;
+}
+
+// Checks that TextConverter::ParseDecimal() matches StringParser::StringToDecimal().
+template <typename T>
+void TestParseDecimal(const string& str, int precision, int scale) {
+  const ColumnType type = ColumnType::CreateDecimalType(precision, scale);
+  StringParser::ParseResult expected_result;
+  const DecimalValue<T> expected = StringParser::StringToDecimal<T>(
+      str.data(), str.size(), type, false, &expected_result);
+  StringParser::ParseResult result;
+  const DecimalValue<T> actual =
+      TextConverter::ParseDecimal<T>(str.data(), str.size(), type, &result);
+  EXPECT_EQ(result, expected_result) << str;
+  if (result == StringParser::PARSE_SUCCESS) EXPECT_TRUE(actual == expected) << str;
+}
+
+// Checks that TextConverter::ParseTimestamp() matches
+// TimestampValue::ParseSimpleDateFormat().
+void TestParseTimestamp(const string& str) {
+  const TimestampValue expected =
+      TimestampValue::ParseSimpleDateFormat(str.data(), str.size());
+  const TimestampValue actual = TextConverter::ParseTimestamp(str.data(), str.size());
+  EXPECT_EQ(actual.HasDate(), expected.HasDate()) << str;
+  EXPECT_EQ(actual.HasTime(), expected.HasTime()) << str;
+  if (expected.HasDate()) EXPECT_EQ(actual, expected) << str;
+}
+
+TEST(TextConverterTest, ParseInt) {
+  const vector<string> values = {"0", "7", "-7", "+7", "42", "-128", "127", "128",
+      "12345678", "-12345678", "123456789", "2147483647", "2147483648", "-2147483648",
+      "9223372036854775807", "-9223372036854775808", "9223372036854775808",
+      "123456781234567812", "00000000000000000001", "", "-", "+", " 12", "12 ", "1a",
+      "12345678a", "a2345678", "1234/678", "1234:678", "--1", "1.5"};
+  for (const string& value : values) {
+    TestParseInt<int8_t>(value);
+    TestParseInt<int16_t>(value);
+    TestParseInt<int32_t>(value);
+    TestParseInt<int64_t>(value);
+  }
+}
+
+TEST(TextConverterTest, ParseDecimal) {
+  const vector<string> values = {"0", "1", "-1", "1.5", "-1.5", "12.34", "12.345",
+      "123456.789", "0.001", ".5", "5.", ".", "-", "", " 1.5", "1.5 ", "1..5", "1.5a",
+      "00012.5", "99999.9999", "100000", "123456789012345678", "1234567890.12345678"};
+  for (const string& value : values) {
+    TestParseDecimal<int32_t>(value, 9, 4);
+    TestParseDecimal<int64_t>(value, 18, 6);
+    TestParseDecimal<int128_t>(value, 38, 10);
+    TestParseDecimal<int128_t>(value, 38, 0);
+  }
+}
+
+TEST(TextConverterTest, ParseTimestamp) {
+  const vector<string> values = {"2020-01-01", "2020-02-29", "2021-02-29",
+      "1399-12-31", "1400-01-01", "9999-12-31", "2020-13-01", "2020-00-01",
+      "2020-01-00", "2020-01-32", "2020-01-01 00:00:00", "2020-01-01 23:59:59",
+      "2020-01-01 24:00:00", "2020-01-01 12:60:00", "2020-01-01 12:00:60",
+      "2020-01-01 12:34:56.7", "2020-01-01 12:34:56.123", "2020-01-01 12:34:56.123456",
+      "2020-01-01 12:34:56.123456789", "2020-01-01 12:34:56.", "2020-01-01T12:34:56",
+      "2020/01/01", "2020-1-1", "20-01-01", "2020-01-01 12:34", "12:34:56",
+      "2020-01-0a", "2020-01-01 12:34:5a"};
+  for (const string& value : values) TestParseTimestamp(value);
+}
+
+}
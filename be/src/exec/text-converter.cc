@@ -20,6 +20,8 @@
 #include <boost/algorithm/string.hpp>
 
 #include "codegen/llvm-codegen.h"
+#include "exec/hdfs-scanner.h"
+#include "exec/text-converter.inline.h"
 #include "runtime/descriptors.h"
 #include "runtime/mem-pool.h"
 #include "runtime/runtime-state.h"
@@ -42,6 +44,124 @@ TextConverter::TextConverter(char escape_char, const string& null_col_val,
     strict_mode_(strict_mode) {
 }
 
+bool TextConverter::IsNullColVal(const char* data, int len) const {
+  return check_null_ && len == null_col_val_.size()
+      && StringCompare(data, len, null_col_val_.data(), null_col_val_.size(), len) == 0;
+}
+
+template <typename ParseFn>
+void TextConverter::WriteSlotsInternal(const SlotDescriptor* slot_desc,
+    const FieldLocation* fields, int fields_stride, int num_tuples, uint8_t* tuple_mem,
+    int tuple_byte_size, uint8_t* errors, int errors_stride, const ParseFn& parse_fn) {
+  const NullIndicatorOffset& null_offset = slot_desc->null_indicator_offset();
+  const int slot_offset = slot_desc->tuple_offset();
+  for (int i = 0; i < num_tuples; ++i) {
+    const FieldLocation& field = fields[i * fields_stride];
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_byte_size);
+    // Escapes do not matter for non-string types.
+    const int len = abs(field.len);
+    if (len == 0 || field.start == nullptr || IsNullColVal(field.start, len)) {
+      tuple->SetNull(null_offset);
+      continue;
+    }
+    StringParser::ParseResult result =
+        parse_fn(field.start, len, tuple->GetSlot(slot_offset));
+    if (UNLIKELY(result != StringParser::PARSE_SUCCESS)
+        && (result == StringParser::PARSE_FAILURE
+            || (strict_mode_ && result == StringParser::PARSE_OVERFLOW))) {
+      tuple->SetNull(null_offset);
+      errors[i * errors_stride] = true;
+    }
+  }
+}
+
+namespace {
+
+template <typename T>
+StringParser::ParseResult ParseIntSlot(const char* data, int len, void* slot) {
+  StringParser::ParseResult result;
+  *reinterpret_cast<T*>(slot) = TextConverter::ParseInt<T>(data, len, &result);
+  return result;
+}
+
+template <typename T>
+struct ParseDecimalSlot {
+  const ColumnType& type;
+
+  StringParser::ParseResult operator()(const char* data, int len, void* slot) const {
+    StringParser::ParseResult result;
+    *reinterpret_cast<DecimalValue<T>*>(slot) =
+        TextConverter::ParseDecimal<T>(data, len, type, &result);
+    // Don't accept underflow and overflow for decimals.
+    return result == StringParser::PARSE_SUCCESS ? result : StringParser::PARSE_FAILURE;
+  }
+};
+
+StringParser::ParseResult ParseTimestampSlot(const char* data, int len, void* slot) {
+  TimestampValue* ts_slot = reinterpret_cast<TimestampValue*>(slot);
+  *ts_slot = TextConverter::ParseTimestamp(data, len);
+  return ts_slot->HasDate() ? StringParser::PARSE_SUCCESS : StringParser::PARSE_FAILURE;
+}
+
+}
+
+void TextConverter::WriteSlots(const SlotDescriptor* slot_desc,
+    const FieldLocation* fields, int fields_stride, int num_tuples, uint8_t* tuple_mem,
+    int tuple_byte_size, MemPool* pool, uint8_t* errors, int errors_stride) {
+  const ColumnType& type = slot_desc->type();
+  switch (type.type) {
+    case TYPE_TINYINT:
+      WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+          tuple_byte_size, errors, errors_stride, ParseIntSlot<int8_t>);
+      return;
+    case TYPE_SMALLINT:
+      WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+          tuple_byte_size, errors, errors_stride, ParseIntSlot<int16_t>);
+      return;
+    case TYPE_INT:
+      WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+          tuple_byte_size, errors, errors_stride, ParseIntSlot<int32_t>);
+      return;
+    case TYPE_BIGINT:
+      WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+          tuple_byte_size, errors, errors_stride, ParseIntSlot<int64_t>);
+      return;
+    case TYPE_TIMESTAMP:
+      WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+          tuple_byte_size, errors, errors_stride, ParseTimestampSlot);
+      return;
+    case TYPE_DECIMAL:
+      switch (slot_desc->slot_size()) {
+        case 4:
+          WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+              tuple_byte_size, errors, errors_stride, ParseDecimalSlot<int32_t>{type});
+          return;
+        case 8:
+          WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+              tuple_byte_size, errors, errors_stride, ParseDecimalSlot<int64_t>{type});
+          return;
+        case 16:
+          WriteSlotsInternal(slot_desc, fields, fields_stride, num_tuples, tuple_mem,
+              tuple_byte_size, errors, errors_stride, ParseDecimalSlot<int128_t>{type});
+          return;
+        default:
+          DCHECK(false) << "Decimal slots can't be this size.";
+          return;
+      }
+    default:
+      break;
+  }
+  // Strings and the remaining types are converted one value at a time.
+  for (int i = 0; i < num_tuples; ++i) {
+    const FieldLocation& field = fields[i * fields_stride];
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem + i * tuple_byte_size);
+    if (!WriteSlot(slot_desc, tuple, field.start, abs(field.len), false, field.len < 0,
+        pool)) {
+      errors[i * errors_stride] = true;
+    }
+  }
+}
+
 void TextConverter::UnescapeString(const char* src, char* dest, int* len,
     int64_t maxlen) {
   const char* src_end = src + *len;
@@ -21,7 +21,12 @@
 
 #include "text-converter.h"
 
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
 #include <boost/algorithm/string.hpp>
+#include <boost/date_time/gregorian_calendar.hpp>
 
 #include "runtime/runtime-state.h"
 #include "runtime/descriptors.h"
@@ -33,6 +38,7 @@
 #include "runtime/mem-pool.h"
 #include "runtime/string-value.inline.h"
 #include "exprs/string-functions.h"
+#include "util/decimal-util.h"
 
 namespace impala {
 
@@ -191,6 +197,116 @@ inline bool TextConverter::WriteSlot(const SlotDescriptor* slot_desc, Tuple* tup
   return true;
 }
 
+namespace text_converter_internal {
+
+/// Parses the 'len' ASCII digits at 's' into 'val'. 'len' must be at most 19, so that
+/// the value fits. Returns false if one of the characters is not a digit.
+inline bool ParseDigits(const char* s, int len, uint64_t* val) {
+  DCHECK_LE(len, std::numeric_limits<uint64_t>::digits10);
+  uint64_t result = 0;
+  bool valid = true;
+  int i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t chunk;
+    memcpy(&chunk, s + i, sizeof(chunk));
+    valid &= StringParser::AllDigits(chunk);
+    result = result * 100000000 + StringParser::ParseEightDigits(chunk);
+  }
+  for (; i < len; ++i) {
+    const uint8_t digit = static_cast<uint8_t>(s[i] - '0');
+    valid &= digit <= 9;
+    result = result * 10 + digit;
+  }
+  *val = result;
+  return valid;
+}
+
+}
+
+template <typename T>
+inline T TextConverter::ParseInt(const char* data, int len,
+    StringParser::ParseResult* result) {
+  const bool negative = len > 0 && data[0] == '-';
+  const int num_digits = len - negative;
+  // Fast path for plain digits that cannot overflow 'T'.
+  uint64_t val;
+  if (LIKELY(num_digits > 0 && num_digits <= std::numeric_limits<T>::digits10
+      && text_converter_internal::ParseDigits(data + negative, num_digits, &val))) {
+    *result = StringParser::PARSE_SUCCESS;
+    return negative ? -static_cast<T>(val) : static_cast<T>(val);
+  }
+  return StringParser::StringToInt<T>(data, len, result);
+}
+
+template <typename T>
+inline DecimalValue<T> TextConverter::ParseDecimal(const char* data, int len,
+    const ColumnType& type, StringParser::ParseResult* result) {
+  // Fast path for '[-]digits[.digits]' that fits the type without rounding and that
+  // can be computed in 64 bits.
+  const bool negative = len > 0 && data[0] == '-';
+  const char* whole = data + negative;
+  const char* end = data + len;
+  const char* dot = static_cast<const char*>(memchr(whole, '.', end - whole));
+  const int whole_len = (dot == nullptr ? end : dot) - whole;
+  const int fraction_len = dot == nullptr ? 0 : end - dot - 1;
+  if (LIKELY(whole_len > 0 && whole_len <= type.precision - type.scale
+      && fraction_len <= type.scale && (dot == nullptr || fraction_len > 0)
+      && whole_len + type.scale <= std::numeric_limits<int64_t>::digits10)) {
+    uint64_t whole_val;
+    uint64_t fraction_val = 0;
+    if (LIKELY(text_converter_internal::ParseDigits(whole, whole_len, &whole_val)
+        && (fraction_len == 0 || text_converter_internal::ParseDigits(
+            dot + 1, fraction_len, &fraction_val)))) {
+      const int64_t val =
+          whole_val * DecimalUtil::GetScaleMultiplier<int64_t>(type.scale)
+          + fraction_val * DecimalUtil::GetScaleMultiplier<int64_t>(
+              type.scale - fraction_len);
+      *result = StringParser::PARSE_SUCCESS;
+      return DecimalValue<T>(negative ? -static_cast<T>(val) : static_cast<T>(val));
+    }
+  }
+  return StringParser::StringToDecimal<T>(data, len, type, false, result);
+}
+
+inline TimestampValue TextConverter::ParseTimestamp(const char* data, int len) {
+  // Fast path for 'yyyy-MM-dd', 'yyyy-MM-dd HH:mm:ss' and 'yyyy-MM-dd HH:mm:ss.S...'
+  // with up to 9 fractional digits. Anything else, including out-of-range fields, is
+  // left to the generic parser.
+  constexpr int DATE_LEN = 10;
+  constexpr int DATE_TIME_LEN = 19;
+  constexpr int MAX_FRACTION_LEN = 9;
+  const bool has_time = len == DATE_TIME_LEN || len > DATE_TIME_LEN + 1;
+  if ((len == DATE_LEN || (has_time && len <= DATE_TIME_LEN + 1 + MAX_FRACTION_LEN))
+      && data[4] == '-' && data[7] == '-'
+      && (!has_time || (data[10] == ' ' && data[13] == ':' && data[16] == ':'))
+      && (len <= DATE_TIME_LEN || data[19] == '.')) {
+    uint64_t year, month, day;
+    uint64_t hour = 0, minute = 0, second = 0, fraction = 0;
+    bool valid = text_converter_internal::ParseDigits(data, 4, &year)
+        & text_converter_internal::ParseDigits(data + 5, 2, &month)
+        & text_converter_internal::ParseDigits(data + 8, 2, &day);
+    if (has_time) {
+      valid &= text_converter_internal::ParseDigits(data + 11, 2, &hour)
+          & text_converter_internal::ParseDigits(data + 14, 2, &minute)
+          & text_converter_internal::ParseDigits(data + 17, 2, &second);
+      if (len > DATE_TIME_LEN) {
+        const int fraction_len = len - DATE_TIME_LEN - 1;
+        valid &= text_converter_internal::ParseDigits(
+            data + DATE_TIME_LEN + 1, fraction_len, &fraction);
+        fraction *= DecimalUtil::GetScaleMultiplier<int64_t>(
+            MAX_FRACTION_LEN - fraction_len);
+      }
+    }
+    if (LIKELY(valid && year >= 1400 && month >= 1 && month <= 12 && day >= 1
+        && hour < 24 && minute < 60 && second < 60
+        && day <= boost::gregorian::gregorian_calendar::end_of_month_day(year, month))) {
+      return TimestampValue(boost::gregorian::date(year, month, day),
+          boost::posix_time::time_duration(hour, minute, second, fraction));
+    }
+  }
+  return TimestampValue::ParseSimpleDateFormat(data, len);
+}
+
 }
 
 #endif
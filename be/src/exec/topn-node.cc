@@ -18,6 +18,7 @@
 #include "exec/topn-node.h"
 
 #include <algorithm>
+#include <limits>
 #include <sstream>
 
 #include "codegen/llvm-codegen.h"
@@ -25,17 +26,22 @@
 #include "exprs/scalar-expr-evaluator.h"
 #include "exprs/scalar-expr.h"
 #include "exprs/slot-ref.h"
+#include "runtime/date-value.h"
 #include "runtime/descriptors.h"
 #include "runtime/fragment-state.h"
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/row-batch.h"
+#include "runtime/runtime-filter-bank.h"
+#include "runtime/runtime-filter.h"
 #include "runtime/runtime-state.h"
 #include "runtime/sorter.h"
 #include "runtime/sorter-internal.h" // For TupleSorter
+#include "runtime/timestamp-value.h"
 #include "runtime/tuple-row.h"
 #include "runtime/tuple.h"
 #include "util/debug-util.h"
+#include "util/min-max-filter.h"
 #include "util/runtime-profile-counters.h"
 #include "util/tuple-row-compare.h"
 
@@ -101,6 +107,14 @@ Status TopNPlanNode::Init(const TPlanNode& tnode, FragmentState* state) {
       RETURN_IF_ERROR(slot_ref->Init(*row_descriptor_, true, state));
     }
   }
+  for (const TRuntimeFilterDesc& filter_desc : tnode.runtime_filters) {
+    DCHECK(!is_partitioned());
+    DCHECK(filter_desc.is_topn_filter);
+    DCHECK(topn_filter_desc_ == nullptr) << "Top-N produces at most one filter";
+    RETURN_IF_ERROR(ScalarExpr::Create(
+        filter_desc.src_expr, *row_descriptor_, state, &topn_filter_expr_));
+    topn_filter_desc_ = &filter_desc;
+  }
   DCHECK_EQ(conjuncts_.size(), 0) << "TopNNode should never have predicates to evaluate.";
   state->CheckAndAddCodegenDisabledMessage(codegen_status_msgs_);
   return Status::OK();
@@ -112,6 +126,7 @@ void TopNPlanNode::Close() {
   ScalarExpr::Close(intra_partition_ordering_exprs_);
   ScalarExpr::Close(output_tuple_exprs_);
   ScalarExpr::Close(noop_tuple_exprs_);
+  if (topn_filter_expr_ != nullptr) topn_filter_expr_->Close();
   PlanNode::Close();
 }
 
@@ -175,6 +190,11 @@ Status TopNNode::Prepare(RuntimeState* state) {
     DCHECK_GE(resource_profile_.min_reservation, sorter_->ComputeMinReservation());
   } else {
     heap_.reset(new Heap(*order_cmp_, pnode.heap_capacity(), pnode.include_ties()));
+    if (pnode.topn_filter_desc_ != nullptr) {
+      topn_filter_ = state->filter_bank()->RegisterProducer(*pnode.topn_filter_desc_);
+      RETURN_IF_ERROR(ScalarExprEvaluator::Create(*pnode.topn_filter_expr_, state, pool_,
+          expr_perm_pool(), expr_results_pool(), &topn_filter_eval_));
+    }
   }
   return Status::OK();
 }
@@ -293,6 +313,7 @@ Status TopNNode::Open(RuntimeState* state) {
   RETURN_IF_ERROR(
       order_cmp_->Open(pool_, state, expr_perm_pool(), expr_results_pool()));
   RETURN_IF_ERROR(ScalarExprEvaluator::Open(output_tuple_expr_evals_, state));
+  if (topn_filter_eval_ != nullptr) RETURN_IF_ERROR(topn_filter_eval_->Open(state));
   if (is_partitioned()) {
     // Set up state required by partitioned top-N implementation. Claim reservation
     // after the child has been opened to reduce the peak reservation requirement.
@@ -338,11 +359,20 @@ Status TopNNode::Open(RuntimeState* state) {
         } else if (rows_to_reclaim_ > 2 * unpartitioned_capacity()) {
           RETURN_IF_ERROR(ReclaimTuplePool(state));
         }
+        if (topn_filter_ != nullptr && !topn_filter_published_
+            && heap_->num_tuples() >= heap_->heap_capacity()) {
+          PublishTopNFilter(state);
+        }
       }
       RETURN_IF_CANCELLED(state);
       RETURN_IF_ERROR(QueryMaintenance(state));
     } while (!eos);
   }
+  if (topn_filter_ != nullptr) {
+    runtime_profile()->AddInfoString("Runtime filters", topn_filter_published_ ?
+        "1 of 1 Runtime Filter Published" :
+        "0 of 1 Runtime Filter Published, 1 Disabled");
+  }
   RETURN_IF_ERROR(PrepareForOutput(state));
 
   // Unless we are inside a subplan expecting to call Open()/GetNext() on the child
@@ -502,9 +532,75 @@ void TopNNode::Close(RuntimeState* state) {
   if (sorter_ != nullptr) sorter_->Close(state);
   sort_out_batch_.reset();
   ScalarExprEvaluator::Close(output_tuple_expr_evals_, state);
+  if (topn_filter_eval_ != nullptr) topn_filter_eval_->Close(state);
   ExecNode::Close(state);
 }
 
+/// Inserts into 'filter' the lowest value of the integer type 'T' if 'lowest' is true,
+/// or its highest value otherwise.
+template <typename T>
+static void InsertIntLimit(bool lowest, MinMaxFilter* filter) {
+  T v = lowest ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+  filter->Insert(&v);
+}
+
+/// Inserts into 'filter' the value of 'type' that sorts first if 'lowest' is true, or
+/// the value that sorts last otherwise.
+static void InsertValueRangeEnd(
+    const ColumnType& type, bool lowest, MinMaxFilter* filter) {
+  switch (type.type) {
+    case TYPE_TINYINT:
+      InsertIntLimit<int8_t>(lowest, filter);
+      break;
+    case TYPE_SMALLINT:
+      InsertIntLimit<int16_t>(lowest, filter);
+      break;
+    case TYPE_INT:
+      InsertIntLimit<int32_t>(lowest, filter);
+      break;
+    case TYPE_BIGINT:
+      InsertIntLimit<int64_t>(lowest, filter);
+      break;
+    case TYPE_DATE: {
+      DateValue v = lowest ? DateValue::MIN_DATE : DateValue::MAX_DATE;
+      filter->Insert(&v);
+      break;
+    }
+    case TYPE_TIMESTAMP: {
+      TimestampValue v = lowest ?
+          TimestampValue(boost::gregorian::date(boost::date_time::min_date_time),
+              boost::posix_time::time_duration(0, 0, 0, 0)) :
+          TimestampValue(boost::gregorian::date(boost::date_time::max_date_time),
+              boost::posix_time::hours(24) - boost::posix_time::nanoseconds(1));
+      filter->Insert(&v);
+      break;
+    }
+    default:
+      DCHECK(false) << "Unexpected type of top-n filter: " << type;
+  }
+}
+
+void TopNNode::PublishTopNFilter(RuntimeState* state) {
+  DCHECK(!is_partitioned());
+  DCHECK(!topn_filter_published_);
+  Tuple* head = const_cast<Tuple*>(heap_->top());
+  const void* bound = topn_filter_eval_->GetValue(reinterpret_cast<TupleRow*>(&head));
+  // NULLs sort last, so rows can only be skipped based on a non-NULL head.
+  if (bound == nullptr) return;
+  const ColumnType& type = topn_filter_eval_->root().type();
+  MinMaxFilter* filter =
+      state->filter_bank()->AllocateScratchMinMaxFilter(topn_filter_->id(), type);
+  if (filter == nullptr) return;
+  const TopNPlanNode& pnode = static_cast<const TopNPlanNode&>(plan_node_);
+  filter->Insert(bound);
+  InsertValueRangeEnd(type, pnode.tnode_->sort_node.sort_info.is_asc_order[0], filter);
+  state->filter_bank()->UpdateFilterFromLocal(
+      topn_filter_->id(), nullptr, filter, nullptr);
+  topn_filter_published_ = true;
+  VLOG(3) << "Top-N (id=" << id() << ") published min/max filter: "
+          << filter->DebugString();
+}
+
 Status TopNNode::EvictPartitions(RuntimeState* state, bool evict_final) {
   DCHECK(is_partitioned());
   vector<unique_ptr<Heap>> heaps_to_evict;
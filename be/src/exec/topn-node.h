@@ -31,7 +31,10 @@
 namespace impala {
 
 class MemPool;
+class MinMaxFilter;
+class RuntimeFilter;
 class RuntimeState;
+class ScalarExprEvaluator;
 class Sorter;
 class TopNNode;
 class Tuple;
@@ -97,6 +100,12 @@ class TopNPlanNode : public PlanNode {
   /// no-ops. Non-empty if this is a partitioned top N.
   std::vector<ScalarExpr*> noop_tuple_exprs_;
 
+  /// The min-max runtime filter that this node builds from the bound of its heap for
+  /// the scan below it, and the expr over the output tuple it is built on. NULL if the
+  /// planner did not assign a filter to this node. Only set for unpartitioned Top-N.
+  const TRuntimeFilterDesc* topn_filter_desc_ = nullptr;
+  ScalarExpr* topn_filter_expr_ = nullptr;
+
   /// Config used to create a TupleRowComparator instance for 'ordering_exprs_'.
   TupleRowComparatorConfig* ordering_comparator_config_ = nullptr;
 
@@ -254,6 +263,12 @@ class TopNNode : public ExecNode {
   /// Initialize 'tmp_tuple_' with memory from 'pool'.
   Status InitTmpTuple(RuntimeState* state, MemPool* pool);
 
+  /// Publishes 'topn_filter_' once 'heap_' is full. Rows that sort after the head of
+  /// the heap can no longer make it into the top-n, so the filter lets through the
+  /// values between the head's value and the end of the value range that sorts first.
+  /// Does nothing if the head's value is NULL.
+  void PublishTopNFilter(RuntimeState* state);
+
   IR_NO_INLINE int tuple_byte_size() const noexcept {
     return output_tuple_desc_->byte_size();
   }
@@ -318,6 +333,13 @@ class TopNNode : public ExecNode {
   /// Only initialized for partitioned Top-N.
   RuntimeProfile::Counter* in_mem_heap_rows_filtered_counter_ = nullptr;
 
+  /// The runtime filter that this node produces for its scan child and the evaluator of
+  /// its source expr. NULL if this node produces no filter. The filter is published at
+  /// most once, because consumers do not expect it to change once it arrived.
+  RuntimeFilter* topn_filter_ = nullptr;
+  ScalarExprEvaluator* topn_filter_eval_ = nullptr;
+  bool topn_filter_published_ = false;
+
   /////////////////////////////////////////
   /// BEGIN: Members that must be Reset()
 
@@ -115,38 +115,54 @@ Status UnnestNode::Open(RuntimeState* state) {
   DCHECK(IsInSubplan());
   // Omit ScopedOpenEventAdder since this is always in a subplan.
   SCOPED_TIMER(runtime_profile_->total_time_counter());
+  RETURN_IF_ERROR(OpenExprs(state));
+  DCHECK(containing_subplan_->current_row() != nullptr);
+  coll_value_ = RetrieveCollection(containing_subplan_->current_input_row_);
+  return Status::OK();
+}
+
+Status UnnestNode::OpenExprs(RuntimeState* state) {
   RETURN_IF_ERROR(ExecNode::Open(state));
-  RETURN_IF_ERROR(coll_expr_eval_->Open(state));
+  return coll_expr_eval_->Open(state);
+}
 
-  DCHECK(containing_subplan_->current_row() != nullptr);
-  Tuple* tuple = containing_subplan_->current_input_row_->GetTuple(coll_tuple_idx_);
+const CollectionValue* UnnestNode::RetrieveCollection(TupleRow* row) {
+  const CollectionValue* coll_value;
+  Tuple* tuple = row->GetTuple(coll_tuple_idx_);
   if (tuple != nullptr) {
     // Retrieve the collection value to be unnested directly from the tuple. We purposely
     // ignore the null bit of the slot because we may have set it in a previous Open() of
     // this same unnest node for projection.
-    coll_value_ = reinterpret_cast<const CollectionValue*>(
+    coll_value = reinterpret_cast<const CollectionValue*>(
         tuple->GetSlot(coll_slot_desc_->tuple_offset()));
     // Projection: Set the slot containing the collection value to nullptr.
     tuple->SetNull(coll_slot_desc_->null_indicator_offset());
   } else {
-    coll_value_ = &EMPTY_COLLECTION_VALUE;
-    DCHECK_EQ(coll_value_->num_tuples, 0);
+    coll_value = &EMPTY_COLLECTION_VALUE;
+    DCHECK_EQ(coll_value->num_tuples, 0);
   }
 
   ++num_collections_;
   COUNTER_SET(num_collections_counter_, num_collections_);
-  total_collection_size_ += coll_value_->num_tuples;
+  total_collection_size_ += coll_value->num_tuples;
   COUNTER_SET(avg_collection_size_counter_,
       static_cast<double>(total_collection_size_) / num_collections_);
-  if (max_collection_size_ == -1 || coll_value_->num_tuples > max_collection_size_) {
-    max_collection_size_ = coll_value_->num_tuples;
+  if (max_collection_size_ == -1 || coll_value->num_tuples > max_collection_size_) {
+    max_collection_size_ = coll_value->num_tuples;
     COUNTER_SET(max_collection_size_counter_, max_collection_size_);
   }
-  if (min_collection_size_ == -1 || coll_value_->num_tuples < min_collection_size_) {
-    min_collection_size_ = coll_value_->num_tuples;
+  if (min_collection_size_ == -1 || coll_value->num_tuples < min_collection_size_) {
+    min_collection_size_ = coll_value->num_tuples;
     COUNTER_SET(min_collection_size_counter_, min_collection_size_);
   }
-  return Status::OK();
+  return coll_value;
+}
+
+bool UnnestNode::EvalItemConjuncts(Tuple* item) {
+  // A row of this node only consists of the item tuple.
+  TupleRow* row = reinterpret_cast<TupleRow*>(&item);
+  DCHECK_EQ(conjuncts_.size(), conjunct_evals_.size());
+  return EvalConjuncts(conjunct_evals_.data(), conjuncts_.size(), row);
 }
 
 Status UnnestNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos) {
@@ -169,8 +185,7 @@ Status UnnestNode::GetNext(RuntimeState* state, RowBatch* row_batch, bool* eos)
     TupleRow* row = row_batch->GetRow(row_idx);
     row->SetTuple(0, item);
     // TODO: Ideally these should be evaluated by the parent scan node.
-    DCHECK_EQ(conjuncts_.size(), conjunct_evals_.size());
-    if (EvalConjuncts(conjunct_evals_.data(), conjuncts_.size(), row)) {
+    if (EvalItemConjuncts(item)) {
       row_batch->CommitLastRow();
       // The limit is handled outside of this loop.
       if (row_batch->AtCapacity()) break;
@@ -72,6 +72,10 @@ class UnnestPlanNode : public PlanNode {
 /// outside of a single UnnestNode, so setting such a slot to NULL is safe after the
 /// UnnestNode has retrieved the collection value from the corresponding slot.
 ///
+/// The containing SubplanNode may unnest the collections of its input rows itself, in
+/// which case this node is never opened per input row and only provides the collection
+/// slot, the item conjuncts and the collection stats. See SubplanNode::GetNextBatched().
+///
 /// TODO: Setting the collection-typed slots to NULL should be replaced by a proper
 /// projection at materialization points. The current solution purposely ignores the
 /// conventional NULL semantics of slots - it is a temporary hack which must be removed.
@@ -91,6 +95,17 @@ class UnnestNode : public ExecNode {
 
   static const CollectionValue EMPTY_COLLECTION_VALUE;
 
+  /// Opens the conjuncts and the collection expr. Called by Open() and by the containing
+  /// SubplanNode if it unnests the collections itself.
+  Status OpenExprs(RuntimeState* state);
+
+  /// Returns the collection to be unnested of 'row', a row of the containing SubplanNode,
+  /// sets its slot to NULL for projection and updates the collection stats.
+  const CollectionValue* RetrieveCollection(TupleRow* row);
+
+  /// Returns true if the collection item 'item' passes the conjuncts of this node.
+  bool EvalItemConjuncts(Tuple* item);
+
   /// Size of a collection item tuple in bytes. Set in Prepare().
   int item_byte_size_;
 
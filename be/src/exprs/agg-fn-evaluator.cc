@@ -33,6 +33,7 @@
 #include "runtime/date-value.h"
 #include "runtime/descriptors.h"
 #include "runtime/raw-value.h"
+#include "runtime/row-batch.h"
 #include "runtime/string-value.h"
 #include "runtime/timestamp-value.h"
 #include "runtime/tuple.h"
@@ -375,6 +376,36 @@ void AggFnEvaluator::Update(const TupleRow* row, Tuple* dst, void* fn) {
   SetDstSlot(staging_intermediate_val_, slot_desc, dst);
 }
 
+void AggFnEvaluator::AddBatch(RowBatch* batch, Tuple* dst) {
+  DCHECK(HasBatchUpdate());
+  const int num_rows = batch->num_rows();
+  if (num_rows == 0) return;
+  if (batch_input_bufs_.size() != input_evals_.size()) {
+    batch_input_bufs_.resize(input_evals_.size());
+    batch_input_vals_.resize(input_evals_.size());
+    for (int i = 0; i < input_evals_.size(); ++i) {
+      batch_input_bufs_[i].Init(agg_fn_.GetChild(i)->type());
+    }
+  }
+  for (int i = 0; i < input_evals_.size(); ++i) {
+    batch_input_bufs_[i].Reserve(num_rows);
+    batch_input_vals_[i] = batch_input_bufs_[i].val();
+  }
+  for (int row_idx = 0; row_idx < num_rows; ++row_idx) {
+    const TupleRow* row = batch->GetRow(row_idx);
+    for (int i = 0; i < input_evals_.size(); ++i) {
+      batch_input_bufs_[i].Set(row_idx, input_evals_[i]->GetValue(row));
+    }
+  }
+
+  agg_fn_ctx_->impl()->IncrementNumUpdates(num_rows);
+  const SlotDescriptor& slot_desc = intermediate_slot_desc();
+  SetAnyVal(slot_desc, dst, staging_intermediate_val_);
+  agg_fn_ctx_->impl()->batch_update_fn()(agg_fn_ctx_.get(), num_rows,
+      batch_input_vals_.data(), staging_intermediate_val_);
+  SetDstSlot(staging_intermediate_val_, slot_desc, dst);
+}
+
 void AggFnEvaluator::Merge(Tuple* src, Tuple* dst) {
   DCHECK(agg_fn_.merge_fn_ != nullptr);
 
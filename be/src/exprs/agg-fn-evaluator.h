@@ -24,6 +24,7 @@
 #include <boost/scoped_ptr.hpp>
 #include "common/status.h"
 #include "exprs/agg-fn.h"
+#include "exprs/anyval-util.h"
 #include "runtime/descriptors.h"
 #include "runtime/lib-cache.h"
 #include "runtime/tuple-row.h"
@@ -40,6 +41,7 @@ namespace impala {
 class MemPool;
 class MemTracker;
 class ObjectPool;
+class RowBatch;
 class RowDescriptor;
 class RuntimeState;
 class SlotDescriptor;
@@ -132,6 +134,17 @@ class AggFnEvaluator {
   /// ultimately backed by the permanent MemPool).
   void Add(const TupleRow* src, Tuple* dst);
 
+  /// Returns true if this is not a merging aggregation and the UDA registered a batch
+  /// update function in Init(), so that AddBatch() can be used.
+  bool HasBatchUpdate() const {
+    return !agg_fn_.is_merge() && agg_fn_ctx_->impl()->batch_update_fn() != nullptr;
+  }
+
+  /// Same as calling Add() with 'dst' for each row of 'batch', but evaluates the input
+  /// expressions for all rows first and then calls the batch update function of the UDA
+  /// once. Only valid if HasBatchUpdate() is true.
+  void AddBatch(RowBatch* batch, Tuple* dst);
+
   /// Updates the intermediate state dst to remove the input src row, i.e. undo
   /// Add(src, dst). Only used internally for analytic fn builtins. Any var-len string
   /// data referenced from the tuple must be backed by an expr-managed allocation from
@@ -221,6 +234,11 @@ class AggFnEvaluator {
   impala_udf::AnyVal* staging_intermediate_val_ = nullptr;
   impala_udf::AnyVal* staging_merge_input_val_ = nullptr;
 
+  /// The values of the input expressions for AddBatch(), and the BatchVals of
+  /// 'batch_input_bufs_'. Set up by the first call of AddBatch().
+  std::vector<BatchValBuffer> batch_input_bufs_;
+  std::vector<impala_udf::BatchVal> batch_input_vals_;
+
   /// Use Create() instead.
   AggFnEvaluator(const AggFn& agg_fn, bool is_clone);
 
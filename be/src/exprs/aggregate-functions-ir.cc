@@ -47,8 +47,10 @@
 #include "thirdparty/datasketches/theta_intersection.hpp"
 #include "thirdparty/datasketches/kll_sketch.hpp"
 #include "util/arithmetic-util.h"
+#include "util/hll-simd.h"
 #include "util/mpfit-util.h"
 #include "util/pretty-printer.h"
+#include "util/roaring-bitmap.h"
 
 #include "common/names.h"
 
@@ -197,6 +199,8 @@ constexpr int AggregateFunctions::MAX_HLL_PRECISION;
 constexpr int AggregateFunctions::DEFAULT_HLL_LEN;
 constexpr int AggregateFunctions::MIN_HLL_LEN;
 constexpr int AggregateFunctions::MAX_HLL_LEN;
+static_assert(AggregateFunctions::MIN_HLL_LEN % HllSimd::BATCH_SIZE == 0,
+    "HLL lengths must be a multiple of the HllSimd batch size");
 
 void AggregateFunctions::InitNull(FunctionContext*, AnyVal* dst) {
   dst->is_null = true;
@@ -1564,6 +1568,10 @@ void AggregateFunctions::HllMerge(
   DCHECK_IN_RANGE(src.len, MIN_HLL_LEN, MAX_HLL_LEN);
   DCHECK_EQ(src.len, dst->len);
 
+  if (HllSimd::IsSupported()) {
+    HllSimd::MergeAVX2(dst->ptr, src.ptr, src.len);
+    return;
+  }
   for (int i = 0; i < src.len; ++i) {
     dst->ptr[i] = ::max(dst->ptr[i], src.ptr[i]);
   }
@@ -1589,9 +1597,13 @@ uint64_t AggregateFunctions::HllFinalEstimate(const uint8_t* buckets, int hll_le
 
   double harmonic_mean = 0;
   int num_zero_registers = 0;
-  for (int i = 0; i < hll_len; ++i) {
-    harmonic_mean += ldexp(1.0, -buckets[i]);
-    if (buckets[i] == 0) ++num_zero_registers;
+  if (HllSimd::IsSupported()) {
+    harmonic_mean = HllSimd::SumAVX2(buckets, hll_len, &num_zero_registers);
+  } else {
+    for (int i = 0; i < hll_len; ++i) {
+      harmonic_mean += ldexp(1.0, -buckets[i]);
+      if (buckets[i] == 0) ++num_zero_registers;
+    }
   }
   harmonic_mean = 1.0 / harmonic_mean;
 
@@ -2447,6 +2459,85 @@ StringVal AggregateFunctions::DsKllUnionFinalize(FunctionContext* ctx,
   return DsKllFinalizeHelper(ctx, src);
 }
 
+/// Sets an error on 'ctx' for a serialized bitmap that could not be read.
+static void LogBitmapDeserializationError(FunctionContext* ctx) {
+  ctx->SetError("Unable to deserialize bitmap.");
+}
+
+/// Serializes the bitmap in 'src' into a new StringVal and frees 'src'.
+static StringVal SerializeAndFreeBitmap(FunctionContext* ctx, const StringVal& src) {
+  DCHECK(!src.is_null);
+  DCHECK_EQ(src.len, sizeof(RoaringBitmap));
+  RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(src.ptr);
+  StringVal dst(ctx, bitmap->SerializedSize());
+  if (!dst.is_null) bitmap->Serialize(dst.ptr);
+  bitmap->~RoaringBitmap();
+  ctx->Free(src.ptr);
+  return dst;
+}
+
+void AggregateFunctions::BitmapInit(FunctionContext* ctx, StringVal* slot) {
+  AllocBuffer(ctx, slot, sizeof(RoaringBitmap));
+  if (UNLIKELY(slot->is_null)) {
+    DCHECK(!ctx->impl()->state()->GetQueryStatus().ok());
+    return;
+  }
+  // Like the sketches above, only the RoaringBitmap object is in the StringVal. Its
+  // containers are on the heap.
+  new (slot->ptr) RoaringBitmap();
+}
+
+template <typename T>
+void AggregateFunctions::BitmapUpdate(FunctionContext* ctx, const T& src,
+    StringVal* dst) {
+  if (src.is_null) return;
+  DCHECK(!dst->is_null);
+  DCHECK_EQ(dst->len, sizeof(RoaringBitmap));
+  reinterpret_cast<RoaringBitmap*>(dst->ptr)->Add(static_cast<uint64_t>(src.val));
+}
+
+StringVal AggregateFunctions::BitmapSerialize(FunctionContext* ctx,
+    const StringVal& src) {
+  return SerializeAndFreeBitmap(ctx, src);
+}
+
+void AggregateFunctions::BitmapMerge(
+    FunctionContext* ctx, const StringVal& src, StringVal* dst) {
+  DCHECK(!src.is_null);
+  DCHECK(!dst->is_null);
+  DCHECK_EQ(dst->len, sizeof(RoaringBitmap));
+  RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(dst->ptr);
+  if (!bitmap->UnionSerialized(src.ptr, src.len)) LogBitmapDeserializationError(ctx);
+}
+
+BigIntVal AggregateFunctions::BitmapFinalize(FunctionContext* ctx, const StringVal& src) {
+  DCHECK(!src.is_null);
+  DCHECK_EQ(src.len, sizeof(RoaringBitmap));
+  RoaringBitmap* bitmap = reinterpret_cast<RoaringBitmap*>(src.ptr);
+  BigIntVal result(bitmap->Cardinality());
+  bitmap->~RoaringBitmap();
+  ctx->Free(src.ptr);
+  return result;
+}
+
+StringVal AggregateFunctions::BitmapFinalizeBitmap(FunctionContext* ctx,
+    const StringVal& src) {
+  DCHECK(!src.is_null);
+  DCHECK_EQ(src.len, sizeof(RoaringBitmap));
+  if (reinterpret_cast<RoaringBitmap*>(src.ptr)->Cardinality() == 0) {
+    reinterpret_cast<RoaringBitmap*>(src.ptr)->~RoaringBitmap();
+    ctx->Free(src.ptr);
+    return StringVal::null();
+  }
+  return SerializeAndFreeBitmap(ctx, src);
+}
+
+void AggregateFunctions::BitmapUnionUpdate(FunctionContext* ctx, const StringVal& src,
+    StringVal* dst) {
+  if (src.is_null) return;
+  BitmapMerge(ctx, src, dst);
+}
+
 /// Intermediate aggregation state for the SampledNdv() function.
 /// Stores NUM_HLL_BUCKETS of the form <row_count, hll_state>.
 /// The 'row_count' keeps track of how many input rows were aggregated into that
@@ -3401,6 +3492,11 @@ template void AggregateFunctions::DsHllUpdate(
 template void AggregateFunctions::DsHllUpdate(
     FunctionContext*, const DateVal&, StringVal*);
 
+template void AggregateFunctions::BitmapUpdate(
+    FunctionContext*, const IntVal&, StringVal*);
+template void AggregateFunctions::BitmapUpdate(
+    FunctionContext*, const BigIntVal&, StringVal*);
+
 template void AggregateFunctions::DsCpcUpdate(
     FunctionContext*, const BooleanVal&, StringVal*);
 template void AggregateFunctions::DsCpcUpdate(
@@ -313,6 +313,23 @@ class AggregateFunctions {
   static void DsKllUnionMerge(FunctionContext*, const StringVal& src, StringVal* dst);
   static StringVal DsKllUnionFinalize(FunctionContext*, const StringVal& src);
 
+  /// These functions implement bitmap_count_distinct() and bitmap_build(), which count
+  /// the distinct values of integers exactly with a RoaringBitmap. The intermediate
+  /// StringVal holds the RoaringBitmap object, which is serialized for the exchange.
+  /// bitmap_build() returns the serialized bitmap so that bitmap_union_count() can roll
+  /// up the distinct counts of several groups.
+  static void BitmapInit(FunctionContext*, StringVal* slot);
+  template <typename T>
+  static void BitmapUpdate(FunctionContext*, const T& src, StringVal* dst);
+  static StringVal BitmapSerialize(FunctionContext*, const StringVal& src);
+  static void BitmapMerge(FunctionContext*, const StringVal& src, StringVal* dst);
+  static BigIntVal BitmapFinalize(FunctionContext*, const StringVal& src);
+  static StringVal BitmapFinalizeBitmap(FunctionContext*, const StringVal& src);
+
+  /// Update function of bitmap_union_count(), which adds a bitmap from bitmap_build()
+  /// to the intermediate bitmap. The other functions are the ones above.
+  static void BitmapUnionUpdate(FunctionContext*, const StringVal& src, StringVal* dst);
+
   /// Estimates the number of distinct values (NDV) based on a sample of data and the
   /// corresponding sampling rate. The main idea of this function is to collect several
   /// (x,y) data points where x is the number of rows and y is the corresponding NDV
@@ -40,6 +40,36 @@ Status AllocateAnyVal(RuntimeState* state, MemPool* pool, const ColumnType& type
   return Status::OK();
 }
 
+int BatchValBuffer::ValueByteSize(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_BOOLEAN: return sizeof(bool);
+    case TYPE_TINYINT: return sizeof(int8_t);
+    case TYPE_SMALLINT: return sizeof(int16_t);
+    case TYPE_INT: return sizeof(int32_t);
+    case TYPE_BIGINT: return sizeof(int64_t);
+    case TYPE_FLOAT: return sizeof(float);
+    case TYPE_DOUBLE: return sizeof(double);
+    case TYPE_DATE: return sizeof(int32_t);
+    default: return AnyValUtil::AnyValSize(type);
+  }
+}
+
+void BatchValBuffer::Init(const ColumnType& type) {
+  type_ = type;
+  value_byte_size_ = ValueByteSize(type);
+}
+
+void BatchValBuffer::Reserve(int capacity) {
+  DCHECK_GT(value_byte_size_, 0);
+  if (capacity <= capacity_) return;
+  const int64_t values_len = static_cast<int64_t>(capacity) * value_byte_size_;
+  values_.resize((values_len + sizeof(__int128_t) - 1) / sizeof(__int128_t));
+  nulls_.resize((capacity + 7) / 8);
+  capacity_ = capacity;
+  val_.values = values_.data();
+  val_.nulls = nulls_.data();
+}
+
 FunctionContext::TypeDesc AnyValUtil::ColumnTypeToTypeDesc(const ColumnType& type) {
   FunctionContext::TypeDesc out;
   switch (type.type) {
@@ -19,6 +19,7 @@
 #define IMPALA_EXPRS_ANYVAL_UTIL_H
 
 #include <algorithm>
+#include <vector>
 
 #include "runtime/date-value.h"
 #include "runtime/runtime-state.h"
@@ -42,6 +43,7 @@ using impala_udf::TimestampVal;
 using impala_udf::StringVal;
 using impala_udf::DecimalVal;
 using impala_udf::DateVal;
+using impala_udf::BatchVal;
 
 class ObjectPool;
 
@@ -349,6 +351,41 @@ class AnyValUtil {
       int precision, const DecimalVal& x, const DecimalVal& y);
 };
 
+/// Owns the values and the null bitmap of a BatchVal of a column type, which is the
+/// layout in which the batch entry points of UDFs and UDAs take their arguments and
+/// return their results (see udf.h).
+class BatchValBuffer {
+ public:
+  /// Returns the byte size of a value of 'type' in a BatchVal.
+  static int ValueByteSize(const ColumnType& type);
+
+  /// Sets the type of the values. Must be called before Reserve().
+  void Init(const ColumnType& type);
+
+  /// Makes room for at least 'capacity' values.
+  void Reserve(int capacity);
+
+  /// Marks all values as not NULL.
+  void ClearNulls() { memset(nulls_.data(), 0, nulls_.size()); }
+
+  /// Sets the value with index 'i' to the value of the slot 'slot', or to NULL if
+  /// 'slot' is NULL. String values reference the string data of the slot.
+  void Set(int i, const void* slot);
+
+  const BatchVal& val() const { return val_; }
+  BatchVal* mutable_val() { return &val_; }
+  int capacity() const { return capacity_; }
+
+ private:
+  ColumnType type_;
+  int value_byte_size_ = 0;
+  int capacity_ = 0;
+  /// Backing memory of 'val_'. The values are 16-byte aligned, as DecimalVals need.
+  std::vector<__int128_t> values_;
+  std::vector<uint8_t> nulls_;
+  BatchVal val_;
+};
+
 /// Allocates an AnyVal subclass of 'type' from 'pool'. The AnyVal's memory is
 /// initialized to all 0's. Returns a MemLimitExceeded() error with message
 /// 'mem_limit_exceeded_msg' if the allocation cannot be made because of a memory
@@ -356,6 +393,36 @@ class AnyValUtil {
 Status AllocateAnyVal(RuntimeState* state, MemPool* pool, const ColumnType& type,
     const std::string& mem_limit_exceeded_msg, AnyVal** result);
 
+inline void BatchValBuffer::Set(int i, const void* slot) {
+  DCHECK_GE(i, 0);
+  DCHECK_LT(i, capacity_);
+  uint8_t* null_byte = &val_.nulls[i >> 3];
+  const uint8_t null_bit = 1 << (i & 7);
+  if (slot == nullptr) {
+    *null_byte |= null_bit;
+    return;
+  }
+  *null_byte &= ~null_bit;
+  uint8_t* dst = reinterpret_cast<uint8_t*>(val_.values) + i * value_byte_size_;
+  switch (type_.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+      memcpy(dst, slot, value_byte_size_);
+      return;
+    case TYPE_DATE:
+      *reinterpret_cast<int32_t*>(dst) =
+          reinterpret_cast<const DateValue*>(slot)->ToDateVal().val;
+      return;
+    default:
+      AnyValUtil::SetAnyVal(slot, type_, reinterpret_cast<AnyVal*>(dst));
+  }
+}
+
 template <typename T>
 inline bool AnyValUtil::EqualsInternal(const T& x, const T& y) {
   DCHECK(!x.is_null);
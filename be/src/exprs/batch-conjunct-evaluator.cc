@@ -0,0 +1,462 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exprs/batch-conjunct-evaluator.h"
+
+#include "common/object-pool.h"
+#include "exprs/anyval-util.h"
+#include "exprs/hive-udf-call.h"
+#include "exprs/scalar-expr-evaluator.h"
+#include "exprs/scalar-expr.h"
+#include "exprs/scalar-fn-call.h"
+#include "exprs/slot-ref.h"
+#include "runtime/date-value.h"
+#include "runtime/row-batch.h"
+#include "runtime/string-value.inline.h"
+#include "runtime/tuple-row.h"
+#include "runtime/tuple.h"
+#include "udf/udf.h"
+
+#include "common/names.h"
+
+using namespace impala_udf;
+
+namespace impala {
+
+namespace {
+
+/// Accesses the rows of a RowBatch.
+class BatchRows {
+ public:
+  explicit BatchRows(RowBatch* batch) : batch_(batch) {}
+
+  TupleRow* GetRow(int row_idx) { return batch_->GetRow(row_idx); }
+
+  Tuple* GetTuple(int row_idx, int tuple_idx) {
+    return batch_->GetRow(row_idx)->GetTuple(tuple_idx);
+  }
+
+ private:
+  RowBatch* const batch_;
+};
+
+/// Accesses rows that consist of a single tuple in a buffer of fixed-size tuples.
+class TupleMemRows {
+ public:
+  TupleMemRows(uint8_t* tuple_mem, int tuple_byte_size)
+    : tuple_mem_(tuple_mem), tuple_byte_size_(tuple_byte_size) {}
+
+  /// The returned row is only valid until the next call.
+  TupleRow* GetRow(int row_idx) {
+    tuple_ = GetTuple(row_idx, 0);
+    return reinterpret_cast<TupleRow*>(&tuple_);
+  }
+
+  Tuple* GetTuple(int row_idx, int tuple_idx) {
+    DCHECK_EQ(tuple_idx, 0);
+    return reinterpret_cast<Tuple*>(
+        tuple_mem_ + static_cast<int64_t>(row_idx) * tuple_byte_size_);
+  }
+
+ private:
+  uint8_t* const tuple_mem_;
+  const int tuple_byte_size_;
+  Tuple* tuple_ = nullptr;
+};
+
+} // anonymous namespace
+
+struct BatchConjunctEvaluator::BatchUdf {
+  const ScalarFnCall* fn_call = nullptr;
+  UdfBatchFn batch_fn = nullptr;
+  /// The values of the children of 'fn_call', and the BatchVals of 'arg_buffers'.
+  vector<BatchValBuffer> arg_buffers;
+  vector<BatchVal> args;
+  BatchValBuffer result;
+
+  /// Makes room for the arguments and results of 'num_rows' rows.
+  void Reserve(int num_rows) {
+    if (num_rows <= result.capacity()) return;
+    for (int i = 0; i < arg_buffers.size(); ++i) {
+      arg_buffers[i].Reserve(num_rows);
+      args[i] = arg_buffers[i].val();
+    }
+    result.Reserve(num_rows);
+  }
+};
+
+Status BatchConjunctEvaluator::Create(RuntimeState* state, ObjectPool* pool,
+    const vector<ScalarExprEvaluator*>& evals, BatchConjunctEvaluator** result) {
+  BatchConjunctEvaluator* evaluator = pool->Add(new BatchConjunctEvaluator());
+  evaluator->conjuncts_.resize(evals.size());
+  for (int i = 0; i < evals.size(); ++i) {
+    Conjunct* conjunct = &evaluator->conjuncts_[i];
+    RETURN_IF_ERROR(Analyze(state, pool, evals[i], conjunct));
+    if (conjunct->kind != Kind::ROW_AT_A_TIME) ++evaluator->num_batch_conjuncts_;
+  }
+  *result = evaluator;
+  return Status::OK();
+}
+
+Status BatchConjunctEvaluator::Analyze(RuntimeState* state, ObjectPool* pool,
+    ScalarExprEvaluator* eval, Conjunct* conjunct) {
+  DCHECK(eval->opened());
+  conjunct->eval = eval;
+  const ScalarExpr& root = eval->root();
+  if (root.IsScalarFnCall() && root.type().type == TYPE_BOOLEAN) {
+    const ScalarFnCall* fn_call = static_cast<const ScalarFnCall*>(&root);
+    UdfBatchFn batch_fn = fn_call->GetBatchFn(eval);
+    if (batch_fn != nullptr) {
+      BatchUdf* batch_udf = pool->Add(new BatchUdf());
+      batch_udf->fn_call = fn_call;
+      batch_udf->batch_fn = batch_fn;
+      batch_udf->arg_buffers.resize(root.GetNumChildren());
+      batch_udf->args.resize(root.GetNumChildren());
+      for (int i = 0; i < root.GetNumChildren(); ++i) {
+        batch_udf->arg_buffers[i].Init(root.GetChild(i)->type());
+      }
+      batch_udf->result.Init(root.type());
+      conjunct->batch_udf = batch_udf;
+      conjunct->kind = Kind::BATCH_UDF;
+      return Status::OK();
+    }
+  }
+  if (root.IsHiveUdfCall() && root.type().type == TYPE_BOOLEAN) {
+    const HiveUdfCall* hive_udf = static_cast<const HiveUdfCall*>(&root);
+    if (hive_udf->GetBatchCapacity(eval) > 0) {
+      conjunct->hive_udf = hive_udf;
+      conjunct->kind = Kind::HIVE_UDF;
+      return Status::OK();
+    }
+  }
+  const string& fn_name = root.function_name();
+  if (fn_name == "is_null_pred" || fn_name == "is_not_null_pred") {
+    if (root.GetNumChildren() != 1 || !root.GetChild(0)->IsSlotRef()) {
+      return Status::OK();
+    }
+    const SlotRef* slot_ref = static_cast<const SlotRef*>(root.GetChild(0));
+    conjunct->tuple_idx = slot_ref->tuple_idx();
+    conjunct->null_offset = slot_ref->null_indicator_offset();
+    conjunct->kind = fn_name == "is_null_pred" ? Kind::IS_NULL : Kind::IS_NOT_NULL;
+    return Status::OK();
+  }
+
+  CompareOp op;
+  if (fn_name == "eq") {
+    op = CompareOp::EQ;
+  } else if (fn_name == "ne") {
+    op = CompareOp::NE;
+  } else if (fn_name == "lt") {
+    op = CompareOp::LT;
+  } else if (fn_name == "le") {
+    op = CompareOp::LE;
+  } else if (fn_name == "gt") {
+    op = CompareOp::GT;
+  } else if (fn_name == "ge") {
+    op = CompareOp::GE;
+  } else {
+    return Status::OK();
+  }
+  if (root.GetNumChildren() != 2) return Status::OK();
+  // The slot may be on either side. Swap the operands of the comparison if it is on the
+  // right.
+  const int slot_child = root.GetChild(0)->IsSlotRef() ? 0 : 1;
+  const ScalarExpr* slot_expr = root.GetChild(slot_child);
+  const ScalarExpr* const_expr = root.GetChild(1 - slot_child);
+  if (!slot_expr->IsSlotRef() || !const_expr->is_constant()) return Status::OK();
+  const ColumnType& type = slot_expr->type();
+  if (const_expr->type() != type) return Status::OK();
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_FLOAT:
+    case TYPE_DOUBLE:
+    case TYPE_DATE:
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+      break;
+    default:
+      return Status::OK();
+  }
+  if (slot_child == 1) {
+    if (op == CompareOp::LT) {
+      op = CompareOp::GT;
+    } else if (op == CompareOp::LE) {
+      op = CompareOp::GE;
+    } else if (op == CompareOp::GT) {
+      op = CompareOp::LT;
+    } else if (op == CompareOp::GE) {
+      op = CompareOp::LE;
+    }
+  }
+
+  AnyVal* value;
+  RETURN_IF_ERROR(eval->GetConstValue(state, *const_expr, &value));
+  DCHECK(value != nullptr);
+  const SlotRef* slot_ref = static_cast<const SlotRef*>(slot_expr);
+  conjunct->tuple_idx = slot_ref->tuple_idx();
+  conjunct->slot_offset = slot_ref->slot_offset();
+  conjunct->null_offset = slot_ref->null_indicator_offset();
+  // A comparison with NULL is never true.
+  if (value->is_null) {
+    conjunct->kind = Kind::ALWAYS_FALSE;
+    return Status::OK();
+  }
+  conjunct->kind = Kind::COMPARE;
+  conjunct->type = type.type;
+  conjunct->op = op;
+  uint8_t* constant = conjunct->constant;
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+      *reinterpret_cast<bool*>(constant) = static_cast<BooleanVal*>(value)->val;
+      break;
+    case TYPE_TINYINT:
+      *reinterpret_cast<int8_t*>(constant) = static_cast<TinyIntVal*>(value)->val;
+      break;
+    case TYPE_SMALLINT:
+      *reinterpret_cast<int16_t*>(constant) = static_cast<SmallIntVal*>(value)->val;
+      break;
+    case TYPE_INT:
+      *reinterpret_cast<int32_t*>(constant) = static_cast<IntVal*>(value)->val;
+      break;
+    case TYPE_BIGINT:
+      *reinterpret_cast<int64_t*>(constant) = static_cast<BigIntVal*>(value)->val;
+      break;
+    case TYPE_FLOAT:
+      *reinterpret_cast<float*>(constant) = static_cast<FloatVal*>(value)->val;
+      break;
+    case TYPE_DOUBLE:
+      *reinterpret_cast<double*>(constant) = static_cast<DoubleVal*>(value)->val;
+      break;
+    case TYPE_DATE:
+      *reinterpret_cast<DateValue*>(constant) =
+          DateValue::FromDateVal(*static_cast<DateVal*>(value));
+      break;
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+      static_assert(sizeof(StringValue) <= sizeof(Conjunct::constant),
+          "constant is too small for a StringValue");
+      *reinterpret_cast<StringValue*>(constant) =
+          StringValue::FromStringVal(*static_cast<StringVal*>(value));
+      break;
+    default:
+      DCHECK(false) << type;
+  }
+  return Status::OK();
+}
+
+int BatchConjunctEvaluator::Filter(RowBatch* batch, int* selected, int num_selected) {
+  BatchRows rows(batch);
+  return FilterRows(&rows, selected, num_selected);
+}
+
+int BatchConjunctEvaluator::Filter(
+    uint8_t* tuple_mem, int tuple_byte_size, int* selected, int num_selected) {
+  TupleMemRows rows(tuple_mem, tuple_byte_size);
+  return FilterRows(&rows, selected, num_selected);
+}
+
+template <typename Rows>
+int BatchConjunctEvaluator::FilterRows(Rows* rows, int* selected, int num_selected) {
+  for (const Conjunct& conjunct : conjuncts_) {
+    if (num_selected == 0) break;
+    switch (conjunct.kind) {
+      case Kind::ALWAYS_FALSE:
+        num_selected = 0;
+        break;
+      case Kind::IS_NULL:
+        num_selected = FilterNull(conjunct, true, rows, selected, num_selected);
+        break;
+      case Kind::IS_NOT_NULL:
+        num_selected = FilterNull(conjunct, false, rows, selected, num_selected);
+        break;
+      case Kind::COMPARE:
+        switch (conjunct.type) {
+          case TYPE_BOOLEAN:
+            num_selected = FilterCompare<bool>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_TINYINT:
+            num_selected = FilterCompare<int8_t>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_SMALLINT:
+            num_selected =
+                FilterCompare<int16_t>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_INT:
+            num_selected =
+                FilterCompare<int32_t>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_BIGINT:
+            num_selected =
+                FilterCompare<int64_t>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_FLOAT:
+            num_selected = FilterCompare<float>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_DOUBLE:
+            num_selected = FilterCompare<double>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_DATE:
+            num_selected =
+                FilterCompare<DateValue>(conjunct, rows, selected, num_selected);
+            break;
+          case TYPE_STRING:
+          case TYPE_VARCHAR:
+            num_selected =
+                FilterCompare<StringValue>(conjunct, rows, selected, num_selected);
+            break;
+          default:
+            DCHECK(false) << conjunct.type;
+        }
+        break;
+      case Kind::BATCH_UDF:
+        num_selected = FilterBatchUdf(conjunct, rows, selected, num_selected);
+        break;
+      case Kind::HIVE_UDF:
+        num_selected = FilterHiveUdf(conjunct, rows, selected, num_selected);
+        break;
+      case Kind::ROW_AT_A_TIME: {
+        int num_passed = 0;
+        for (int i = 0; i < num_selected; ++i) {
+          const int row_idx = selected[i];
+          selected[num_passed] = row_idx;
+          num_passed += conjunct.eval->EvalPredicate(rows->GetRow(row_idx));
+        }
+        num_selected = num_passed;
+        break;
+      }
+    }
+  }
+  return num_selected;
+}
+
+template <typename Rows>
+int BatchConjunctEvaluator::FilterNull(const Conjunct& conjunct, bool is_null,
+    Rows* rows, int* selected, int num_selected) {
+  int num_passed = 0;
+  for (int i = 0; i < num_selected; ++i) {
+    const int row_idx = selected[i];
+    const Tuple* tuple = rows->GetTuple(row_idx, conjunct.tuple_idx);
+    const bool slot_is_null = tuple == nullptr || tuple->IsNull(conjunct.null_offset);
+    selected[num_passed] = row_idx;
+    num_passed += slot_is_null == is_null;
+  }
+  return num_passed;
+}
+
+template <typename T, typename Rows>
+int BatchConjunctEvaluator::FilterCompare(
+    const Conjunct& conjunct, Rows* rows, int* selected, int num_selected) {
+  switch (conjunct.op) {
+    case CompareOp::EQ:
+      return FilterCompareOp<T, CompareOp::EQ>(
+          conjunct, rows, selected, num_selected);
+    case CompareOp::NE:
+      return FilterCompareOp<T, CompareOp::NE>(
+          conjunct, rows, selected, num_selected);
+    case CompareOp::LT:
+      return FilterCompareOp<T, CompareOp::LT>(
+          conjunct, rows, selected, num_selected);
+    case CompareOp::LE:
+      return FilterCompareOp<T, CompareOp::LE>(
+          conjunct, rows, selected, num_selected);
+    case CompareOp::GT:
+      return FilterCompareOp<T, CompareOp::GT>(
+          conjunct, rows, selected, num_selected);
+    case CompareOp::GE:
+      return FilterCompareOp<T, CompareOp::GE>(
+          conjunct, rows, selected, num_selected);
+  }
+  DCHECK(false);
+  return num_selected;
+}
+
+template <typename T, BatchConjunctEvaluator::CompareOp OP, typename Rows>
+int BatchConjunctEvaluator::FilterCompareOp(
+    const Conjunct& conjunct, Rows* rows, int* selected, int num_selected) {
+  const T& value = *reinterpret_cast<const T*>(conjunct.constant);
+  int num_passed = 0;
+  for (int i = 0; i < num_selected; ++i) {
+    const int row_idx = selected[i];
+    const Tuple* tuple = rows->GetTuple(row_idx, conjunct.tuple_idx);
+    bool passed = false;
+    if (tuple != nullptr && !tuple->IsNull(conjunct.null_offset)) {
+      const T& slot = *reinterpret_cast<const T*>(tuple->GetSlot(conjunct.slot_offset));
+      switch (OP) {
+        case CompareOp::EQ: passed = slot == value; break;
+        case CompareOp::NE: passed = slot != value; break;
+        case CompareOp::LT: passed = slot < value; break;
+        case CompareOp::LE: passed = slot <= value; break;
+        case CompareOp::GT: passed = slot > value; break;
+        case CompareOp::GE: passed = slot >= value; break;
+      }
+    }
+    selected[num_passed] = row_idx;
+    num_passed += passed;
+  }
+  return num_passed;
+}
+
+template <typename Rows>
+int BatchConjunctEvaluator::FilterBatchUdf(
+    const Conjunct& conjunct, Rows* rows, int* selected, int num_selected) {
+  BatchUdf* batch_udf = conjunct.batch_udf;
+  batch_udf->Reserve(num_selected);
+  for (int i = 0; i < num_selected; ++i) {
+    batch_udf->fn_call->EvaluateBatchArgs(
+        conjunct.eval, rows->GetRow(selected[i]), i, batch_udf->arg_buffers.data());
+  }
+  batch_udf->fn_call->CallBatchFn(conjunct.eval, batch_udf->batch_fn, num_selected,
+      batch_udf->args.data(), &batch_udf->result);
+  const BatchVal& result = batch_udf->result.val();
+  const bool* values = result.Values<bool>();
+  int num_passed = 0;
+  for (int i = 0; i < num_selected; ++i) {
+    selected[num_passed] = selected[i];
+    num_passed += !result.IsNull(i) && values[i];
+  }
+  return num_passed;
+}
+
+template <typename Rows>
+int BatchConjunctEvaluator::FilterHiveUdf(
+    const Conjunct& conjunct, Rows* rows, int* selected, int num_selected) {
+  const HiveUdfCall* hive_udf = conjunct.hive_udf;
+  const int capacity = hive_udf->GetBatchCapacity(conjunct.eval);
+  int num_passed = 0;
+  // Evaluate the selected rows in chunks that fit into the buffers of the UDF.
+  for (int start = 0; start < num_selected; start += capacity) {
+    const int num_rows = std::min(capacity, num_selected - start);
+    for (int i = 0; i < num_rows; ++i) {
+      hive_udf->EvaluateBatchArgs(conjunct.eval, rows->GetRow(selected[start + i]), i);
+    }
+    const uint8_t* values;
+    const uint8_t* nulls;
+    hive_udf->EvaluateBatch(conjunct.eval, num_rows, &values, &nulls);
+    for (int i = 0; i < num_rows; ++i) {
+      selected[num_passed] = selected[start + i];
+      num_passed += !nulls[i] && *reinterpret_cast<const bool*>(values + i);
+    }
+  }
+  return num_passed;
+}
+
+} // namespace impala
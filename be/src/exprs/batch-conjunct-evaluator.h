@@ -0,0 +1,140 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <vector>
+
+#include "common/status.h"
+#include "runtime/descriptors.h"
+#include "runtime/types.h"
+
+namespace impala {
+
+class HiveUdfCall;
+class ObjectPool;
+class RowBatch;
+class RuntimeState;
+class ScalarExprEvaluator;
+
+/// Evaluates a list of conjuncts over many rows at a time. The rows to evaluate are
+/// given as a selection vector of row indices. Each conjunct shrinks the selection in
+/// place to the rows for which it returns true, so that a conjunct only sees the rows
+/// that passed the conjuncts before it, as with ExecNode::EvalConjuncts().
+///
+/// Conjuncts of the following shapes are evaluated by tight loops over the slot values,
+/// without calls into the expr tree and without boxing the values into AnyVals:
+///  - <slot> <op> <constant> and <constant> <op> <slot>, where <op> is one of =, !=, <,
+///    <=, > and >=, and the slot is a BOOLEAN, TINYINT, SMALLINT, INT, BIGINT, FLOAT,
+///    DOUBLE, DATE, STRING or VARCHAR slot of the same type as the constant.
+///  - <slot> IS NULL and <slot> IS NOT NULL.
+/// Conjuncts that are calls of functions with a batch entry point (see UdfBatchFn in
+/// udf.h) evaluate their arguments row by row and then call the batch entry point once
+/// for all selected rows. Conjuncts that are calls of Hive UDFs that can be evaluated in
+/// batches (see HiveUdfCall) also evaluate their arguments row by row and then cross
+/// into the JVM once per batch of selected rows.
+/// All other conjuncts are evaluated one row at a time by their evaluators, which use
+/// the codegen'd compute functions if there are any.
+class BatchConjunctEvaluator {
+ public:
+  /// Creates an evaluator for the conjuncts evaluated by 'evals', which must be open and
+  /// must outlive the new evaluator. The new evaluator is owned by 'pool'.
+  static Status Create(RuntimeState* state, ObjectPool* pool,
+      const std::vector<ScalarExprEvaluator*>& evals,
+      BatchConjunctEvaluator** result) WARN_UNUSED_RESULT;
+
+  /// Evaluates the conjuncts over the rows of 'batch' with the 'num_selected' indices in
+  /// 'selected' and removes the indices of the rows that do not pass all conjuncts from
+  /// 'selected', keeping the order of the others. Returns the number of indices left.
+  int Filter(RowBatch* batch, int* selected, int num_selected);
+
+  /// Same as above for rows that consist of a single tuple, where the tuple of the row
+  /// with index i starts at 'tuple_mem' + i * 'tuple_byte_size'.
+  int Filter(uint8_t* tuple_mem, int tuple_byte_size, int* selected, int num_selected);
+
+  /// Returns the number of conjuncts that are not evaluated one row at a time.
+  int num_batch_conjuncts() const { return num_batch_conjuncts_; }
+
+ private:
+  enum class Kind {
+    ROW_AT_A_TIME, ALWAYS_FALSE, IS_NULL, IS_NOT_NULL, COMPARE, BATCH_UDF, HIVE_UDF
+  };
+  enum class CompareOp { EQ, NE, LT, LE, GT, GE };
+
+  /// The function and the argument and result buffers of a BATCH_UDF conjunct.
+  struct BatchUdf;
+
+  /// A conjunct and how it is evaluated.
+  struct Conjunct {
+    ScalarExprEvaluator* eval = nullptr;
+    Kind kind = Kind::ROW_AT_A_TIME;
+
+    /// The slot of IS_NULL, IS_NOT_NULL and COMPARE conjuncts.
+    int tuple_idx = 0;
+    int slot_offset = 0;
+    NullIndicatorOffset null_offset;
+
+    /// The comparison of COMPARE conjuncts, with the slot as the left operand, and its
+    /// constant in the slot layout of 'type'. Constant strings are owned by 'eval'.
+    PrimitiveType type = INVALID_TYPE;
+    CompareOp op = CompareOp::EQ;
+    alignas(8) uint8_t constant[16];
+
+    /// The function of BATCH_UDF conjuncts. Owned by the ObjectPool passed to Create().
+    BatchUdf* batch_udf = nullptr;
+
+    /// The root of HIVE_UDF conjuncts.
+    const HiveUdfCall* hive_udf = nullptr;
+  };
+
+  BatchConjunctEvaluator() = default;
+
+  /// Determines how the conjunct of 'eval' is evaluated.
+  static Status Analyze(RuntimeState* state, ObjectPool* pool,
+      ScalarExprEvaluator* eval, Conjunct* conjunct);
+
+  /// Implementation of Filter(), with the rows accessed through 'rows'.
+  template <typename Rows>
+  int FilterRows(Rows* rows, int* selected, int num_selected);
+
+  template <typename Rows>
+  static int FilterNull(const Conjunct& conjunct, bool is_null, Rows* rows,
+      int* selected, int num_selected);
+
+  /// Dispatches on the comparison op of 'conjunct'.
+  template <typename T, typename Rows>
+  static int FilterCompare(const Conjunct& conjunct, Rows* rows, int* selected,
+      int num_selected);
+
+  template <typename T, CompareOp OP, typename Rows>
+  static int FilterCompareOp(const Conjunct& conjunct, Rows* rows, int* selected,
+      int num_selected);
+
+  template <typename Rows>
+  static int FilterBatchUdf(const Conjunct& conjunct, Rows* rows, int* selected,
+      int num_selected);
+
+  template <typename Rows>
+  static int FilterHiveUdf(const Conjunct& conjunct, Rows* rows, int* selected,
+      int num_selected);
+
+  std::vector<Conjunct> conjuncts_;
+  int num_batch_conjuncts_ = 0;
+};
+
+} // namespace impala
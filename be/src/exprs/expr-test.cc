@@ -3819,6 +3819,32 @@ TEST_P(ExprTest, LikePredicate) {
   TestIsNull("NULL REGEXP 'a'", TYPE_BOOLEAN);
   TestIsNull("'a' REGEXP NULL", TYPE_BOOLEAN);
   TestIsNull("NULL REGEXP NULL", TYPE_BOOLEAN);
+  // Regex patterns that are alternations of constant strings.
+  TestValue("'connection refused' REGEXP 'timeout|refused'", TYPE_BOOLEAN, true);
+  TestValue("'connection reset' REGEXP 'timeout|refused|error'", TYPE_BOOLEAN, false);
+  TestValue("'connection reset' REGEXP 'timeout||refused'", TYPE_BOOLEAN, true);
+  TestValue("'connection reset' REGEXP 'timeout|^conn'", TYPE_BOOLEAN, true);
+  TestValue("'Connection Refused' IREGEXP 'timeout|refused'", TYPE_BOOLEAN, true);
+  // like_any() and ilike_any(), which disjunctions of LIKE predicates are rewritten to.
+  TestValue("like_any('connection refused', '%timeout%', '%refused%')", TYPE_BOOLEAN,
+      true);
+  TestValue("like_any('connection reset', '%timeout%', '%refused%')", TYPE_BOOLEAN,
+      false);
+  TestValue("like_any('connection reset', '%timeout%', 'conn%')", TYPE_BOOLEAN, true);
+  TestValue("like_any('connection reset', '%timeout%', 'conn_')", TYPE_BOOLEAN, false);
+  TestValue("like_any('a%a', '%b%', 'a\\%a')", TYPE_BOOLEAN, true);
+  TestValue("like_any('a123a', '%b%', 'a\\%a')", TYPE_BOOLEAN, false);
+  TestValue("like_any('ab%', '%b\\%%')", TYPE_BOOLEAN, true);
+  TestValue("like_any('abc', '%b\\%%')", TYPE_BOOLEAN, false);
+  TestValue("like_any('abc', '%%', '%x%')", TYPE_BOOLEAN, true);
+  TestValue("like_any('abc', NULL, '%b%')", TYPE_BOOLEAN, true);
+  TestIsNull("like_any('abc', NULL, '%x%')", TYPE_BOOLEAN);
+  TestIsNull("like_any(NULL, '%a%', '%b%')", TYPE_BOOLEAN);
+  TestValue("ilike_any('Connection Refused', '%timeout%', '%refused%')", TYPE_BOOLEAN,
+      true);
+  TestValue("ilike_any('Connection Reset', '%timeout%', '%refused%')", TYPE_BOOLEAN,
+      false);
+  TestValue("ilike_any('Connection Reset', '%timeout%', 'conn%')", TYPE_BOOLEAN, true);
   // Test multi-line strings.
   TestValue("'abc\n123' LIKE 'abc_123'", TYPE_BOOLEAN, true);
   TestValue("'abc\n\n123' LIKE 'abc_123'", TYPE_BOOLEAN, false);
@@ -3981,6 +4007,46 @@ TEST_P(ExprTest, InPredicate) {
   TestValue("cast('ab' as char(2)) in (cast('ab' as char(2)), cast('cd' as char(2)))",
             TYPE_BOOLEAN, true);
 
+  // Test long IN lists, which are looked up in a bitmap, a sorted array or a hash table
+  // depending on the type and the values.
+  string dense_ints;
+  string sparse_ints;
+  string strs;
+  for (int i = 0; i < 100; ++i) {
+    if (i > 0) {
+      dense_ints += ", ";
+      sparse_ints += ", ";
+      strs += ", ";
+    }
+    dense_ints += lexical_cast<string>(3 * i - 100);
+    sparse_ints += lexical_cast<string>(1000003LL * i - 50000000LL);
+    strs += "'str" + lexical_cast<string>(3 * i) + "'";
+  }
+  for (const string& type : {"smallint", "int", "bigint"}) {
+    TestValue("cast(-100 as " + type + ") in (" + dense_ints + ")", TYPE_BOOLEAN, true);
+    TestValue("cast(197 as " + type + ") in (" + dense_ints + ")", TYPE_BOOLEAN, true);
+    TestValue("cast(-101 as " + type + ") in (" + dense_ints + ")", TYPE_BOOLEAN, false);
+    TestValue("cast(198 as " + type + ") in (" + dense_ints + ")", TYPE_BOOLEAN, false);
+    TestValue("cast(1 as " + type + ") in (" + dense_ints + ")", TYPE_BOOLEAN, false);
+    TestValue("cast(2 as " + type + ") not in (" + dense_ints + ")", TYPE_BOOLEAN, false);
+    TestIsNull("cast(1 as " + type + ") in (" + dense_ints + ", NULL)", TYPE_BOOLEAN);
+  }
+  for (const string& type : {"int", "bigint"}) {
+    TestValue("cast(-50000000 as " + type + ") in (" + sparse_ints + ")", TYPE_BOOLEAN,
+        true);
+    TestValue("cast(49000297 as " + type + ") in (" + sparse_ints + ")", TYPE_BOOLEAN,
+        true);
+    TestValue("cast(49000298 as " + type + ") in (" + sparse_ints + ")", TYPE_BOOLEAN,
+        false);
+    TestValue("cast(0 as " + type + ") in (" + sparse_ints + ")", TYPE_BOOLEAN, false);
+  }
+  TestValue("'str0' in (" + strs + ")", TYPE_BOOLEAN, true);
+  TestValue("'str297' in (" + strs + ")", TYPE_BOOLEAN, true);
+  TestValue("'str1' in (" + strs + ")", TYPE_BOOLEAN, false);
+  TestValue("'str' in (" + strs + ")", TYPE_BOOLEAN, false);
+  TestValue("'' in (" + strs + ", '')", TYPE_BOOLEAN, true);
+  TestValue("'str1' not in (" + strs + ")", TYPE_BOOLEAN, true);
+
   // Test timestamps.
   TestValue(default_timestamp_str_ + " "
       "in (cast('2011-11-23 09:10:11' as timestamp), "
@@ -4278,6 +4344,12 @@ TEST_P(ExprTest, StringFunctions) {
   TestStringValue("ucase('hello')", "HELLO");
   TestIsNull("upper(NULL)", TYPE_STRING);
   TestIsNull("ucase(NULL)", TYPE_STRING);
+  // Strings longer than the 16 bytes that are converted at once.
+  TestStringValue("upper('The quick brown fox jumps @ [the] `lazy` {dog}')",
+      "THE QUICK BROWN FOX JUMPS @ [THE] `LAZY` {DOG}");
+  TestStringValue("lower('The QUICK brown FOX jumps @ [the] `LAZY` {dog}')",
+      "the quick brown fox jumps @ [the] `lazy` {dog}");
+  TestStringValue("upper('café naïve résumé')", "CAFé NAïVE RéSUMé");
 
   TestStringValue("initcap('')", "");
   TestStringValue("initcap('a')", "A");
@@ -4460,6 +4532,13 @@ TEST_P(ExprTest, StringFunctions) {
   TestStringValue("trim('')", "");
   TestStringValue("trim('      ')", "");
   TestStringValue("trim('   abcdefg   ')", "abcdefg");
+  TestStringValue("trim('                    abc def                    ')",
+      "abc def");
+  TestStringValue("ltrim('                    abc def                    ')",
+      "abc def                    ");
+  TestStringValue("rtrim('                    abc def                    ')",
+      "                    abc def");
+  TestStringValue("rtrim('                                        ')", "");
   TestStringValue("trim('abcdefg   ')", "abcdefg");
   TestStringValue("trim('   abcdefg')", "abcdefg");
   TestStringValue("trim('abc  defg')", "abc  defg");
@@ -10117,6 +10196,24 @@ TEST_P(ExprTest, JsonTest) {
       "[1,2]");
   TestStringValue("get_json_object('{\"a\":1, \"1\":2, \"c\":3}', '$.1')", "2");
 
+  // Tests about values found without parsing the whole document
+  TestStringValue(
+      "get_json_object('{\"a\": {\"b\": [1, \"]}\"]}, \"c\": [0, {\"d\": 12}]}', "
+      "'$.c[1].d')", "12");
+  TestStringValue("get_json_object('{\"a\":1, \"a\":2}', '$.a')", "1");
+  TestStringValue("get_json_object('{\"a\": 1.50}', '$.a')", "1.5");
+  TestStringValue("get_json_object('{\"a\": 1e2}', '$.a')", "100.0");
+  TestStringValue("get_json_object('{\"a\": -123}', '$.a')", "-123");
+  TestStringValue("get_json_object('{\"a\": \"x\\\\ty\"}', '$.a')", "x\ty");
+  TestStringValue("get_json_object('{\"a\": \"\\\\u00e9\"}', '$.a')", "\xc3\xa9");
+  TestStringValue("get_json_object('{\"a\": { \"b\" : [ 1 , 2 ] }}', '$.a')",
+      "{\"b\":[1,2]}");
+  TestStringValue("get_json_object('{\"\\\\u0061\": 1, \"b\": 2}', '$.a')", "1");
+  TestIsNull("get_json_object('{\"a\": null}', '$.a')", TYPE_STRING);
+  TestIsNull("get_json_object('{\"a\": [1, 2]}', '$.a[2]')", TYPE_STRING);
+  TestIsNull("get_json_object('{\"a\": tru}', '$.a')", TYPE_STRING);
+  TestIsNull("get_json_object('[1,2]', '$[')", TYPE_STRING);
+
   // Tests about NULL
   TestIsNull("get_json_object('{\"a\": 1}', '$.b')", TYPE_STRING);
   TestIsNull("get_json_object('{\"a\": 1}', '$[0]')", TYPE_STRING);
@@ -10630,6 +10727,7 @@ TEST_P(ExprTest, Utf8Test) {
   TestValue("utf8_length('你好hello')", TYPE_INT, 7);
   TestValue("utf8_length('你好 hello 你好')", TYPE_INT, 11);
   TestValue("utf8_length('hello')", TYPE_INT, 5);
+  TestValue("utf8_length('你好 hello 你好 hello 你好 hello')", TYPE_INT, 26);
 
   // Verifies position and length of utf8_substring() are UTF-8 aware.
   // '你' and '好' are both encoded into 3 bytes.
@@ -10671,6 +10769,14 @@ TEST_P(ExprTest, Utf8Test) {
   TestStringValue("utf8_substring('你好hello你好', -10)", "");
   TestStringValue("utf8_substring('你好hello你好', -3, cast(2 as bigint))", "o你");
   TestStringValue("utf8_substring('你好hello你好', -1, -1)", "");
+  // ASCII strings, and ones with UTF-8 characters outside of the substring.
+  TestStringValue("utf8_substring('hello world, hello', 7, 5)", "world");
+  TestStringValue("utf8_substring('hello world, hello', -5)", "hello");
+  TestStringValue("utf8_substring('hello world, hello', -11, 5)", "world");
+  TestStringValue("utf8_substring('hello world你好', 7, 5)", "world");
+  TestStringValue("utf8_substring('hello world你好', 7, 6)", "world你");
+  TestStringValue("utf8_substring('你好hello world', -5)", "world");
+  TestStringValue("utf8_substring('你好hello world', -12, 3)", "好he");
 
   // Verifies utf8_reverse() reverses the UTF-8 characters (code points).
   // '你' and '好' are both encoded into 3 bytes.
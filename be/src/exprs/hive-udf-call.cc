@@ -38,6 +38,7 @@
 const char* EXECUTOR_CLASS = "org/apache/impala/hive/executor/UdfExecutor";
 const char* EXECUTOR_CTOR_SIGNATURE ="([B)V";
 const char* EXECUTOR_EVALUATE_SIGNATURE = "()V";
+const char* EXECUTOR_EVALUATE_BATCH_SIGNATURE = "(I)V";
 const char* EXECUTOR_CLOSE_SIGNATURE = "()V";
 
 namespace impala {
@@ -47,6 +48,7 @@ class LlvmCodeGen;
 jclass HiveUdfCall::executor_cl_ = NULL;
 jmethodID HiveUdfCall::executor_ctor_id_ = NULL;
 jmethodID HiveUdfCall::executor_evaluate_id_ = NULL;
+jmethodID HiveUdfCall::executor_evaluate_batch_id_ = NULL;
 jmethodID HiveUdfCall::executor_close_id_ = NULL;
 
 HiveUdfCall::HiveUdfCall(const TExprNode& node)
@@ -72,36 +74,8 @@ AnyVal* HiveUdfCall::Evaluate(ScalarExprEvaluator* eval, const TupleRow* row) co
     if (v == nullptr) {
       jni_ctx->input_nulls_buffer[i] = 1;
     } else {
-      uint8_t* input_ptr = jni_ctx->input_values_buffer + input_byte_offsets_[i];
       jni_ctx->input_nulls_buffer[i] = 0;
-      switch (GetChild(i)->type().type) {
-        case TYPE_BOOLEAN:
-        case TYPE_TINYINT:
-          // Using explicit sizes helps the compiler unroll memcpy
-          memcpy(input_ptr, v, 1);
-          break;
-        case TYPE_SMALLINT:
-          memcpy(input_ptr, v, 2);
-          break;
-        case TYPE_INT:
-        case TYPE_FLOAT:
-        case TYPE_DATE:
-          memcpy(input_ptr, v, 4);
-          break;
-        case TYPE_BIGINT:
-        case TYPE_DOUBLE:
-          memcpy(input_ptr, v, 8);
-          break;
-        case TYPE_TIMESTAMP:
-          memcpy(input_ptr, v, sizeof(TimestampValue));
-          break;
-        case TYPE_STRING:
-        case TYPE_VARCHAR:
-          memcpy(input_ptr, v, sizeof(StringValue));
-          break;
-        default:
-          DCHECK(false) << "NYI";
-      }
+      CopyChildValue(i, v, jni_ctx->input_values_buffer + input_byte_offsets_[i]);
     }
   }
 
@@ -111,13 +85,7 @@ AnyVal* HiveUdfCall::Evaluate(ScalarExprEvaluator* eval, const TupleRow* row) co
       jni_ctx->executor, executor_cl_, executor_evaluate_id_, nullptr);
   Status status = JniUtil::GetJniExceptionMsg(env);
   if (!status.ok()) {
-    if (!jni_ctx->warning_logged) {
-      stringstream ss;
-      ss << "Hive UDF path=" << fn_.hdfs_location << " class=" << fn_.scalar_fn.symbol
-        << " failed due to: " << status.GetDetail();
-      fn_ctx->AddWarning(ss.str().c_str());
-      jni_ctx->warning_logged = true;
-    }
+    LogUdfFailure(fn_ctx, jni_ctx, status);
     jni_ctx->output_anyval->is_null = true;
     return jni_ctx->output_anyval;
   }
@@ -131,6 +99,87 @@ AnyVal* HiveUdfCall::Evaluate(ScalarExprEvaluator* eval, const TupleRow* row) co
   return jni_ctx->output_anyval;
 }
 
+void HiveUdfCall::CopyChildValue(int child_idx, const void* v, uint8_t* dst) const {
+  switch (GetChild(child_idx)->type().type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+      // Using explicit sizes helps the compiler unroll memcpy
+      memcpy(dst, v, 1);
+      break;
+    case TYPE_SMALLINT:
+      memcpy(dst, v, 2);
+      break;
+    case TYPE_INT:
+    case TYPE_FLOAT:
+    case TYPE_DATE:
+      memcpy(dst, v, 4);
+      break;
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+      memcpy(dst, v, 8);
+      break;
+    case TYPE_TIMESTAMP:
+      memcpy(dst, v, sizeof(TimestampValue));
+      break;
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+      memcpy(dst, v, sizeof(StringValue));
+      break;
+    default:
+      DCHECK(false) << "NYI";
+  }
+}
+
+void HiveUdfCall::LogUdfFailure(
+    FunctionContext* fn_ctx, JniContext* jni_ctx, const Status& status) {
+  if (jni_ctx->warning_logged) return;
+  stringstream ss;
+  ss << "Hive UDF path=" << jni_ctx->hdfs_location << " class="
+     << jni_ctx->scalar_fn_symbol << " failed due to: " << status.GetDetail();
+  fn_ctx->AddWarning(ss.str().c_str());
+  jni_ctx->warning_logged = true;
+}
+
+int HiveUdfCall::GetBatchCapacity(ScalarExprEvaluator* eval) const {
+  return GetJniContext(eval->fn_context(fn_ctx_idx_))->batch_capacity;
+}
+
+void HiveUdfCall::EvaluateBatchArgs(
+    ScalarExprEvaluator* eval, const TupleRow* row, int row_idx) const {
+  JniContext* jni_ctx = GetJniContext(eval->fn_context(fn_ctx_idx_));
+  DCHECK_LT(row_idx, jni_ctx->batch_capacity);
+  const int capacity = jni_ctx->batch_capacity;
+  for (int i = 0; i < GetNumChildren(); ++i) {
+    void* v = eval->GetValue(*GetChild(i), row);
+    jni_ctx->batch_input_nulls[i * capacity + row_idx] = v == nullptr;
+    if (v == nullptr) continue;
+    uint8_t* column = jni_ctx->batch_input_values + input_byte_offsets_[i] * capacity;
+    CopyChildValue(i, v, column + row_idx * input_byte_sizes_[i]);
+  }
+}
+
+void HiveUdfCall::EvaluateBatch(ScalarExprEvaluator* eval, int num_rows,
+    const uint8_t** values, const uint8_t** nulls) const {
+  FunctionContext* fn_ctx = eval->fn_context(fn_ctx_idx_);
+  JniContext* jni_ctx = GetJniContext(fn_ctx);
+  DCHECK_LE(num_rows, jni_ctx->batch_capacity);
+  *values = jni_ctx->batch_output_values;
+  *nulls = jni_ctx->batch_output_nulls;
+  if (num_rows == 0) return;
+
+  JNIEnv* env = JniUtil::GetJNIEnv();
+  DCHECK(env != nullptr);
+  // The executor writes the result of every row that it gets to. Rows after an
+  // unexpected failure stay NULL.
+  memset(jni_ctx->batch_output_nulls, 1, num_rows);
+  jvalue arg;
+  arg.i = num_rows;
+  env->CallNonvirtualVoidMethodA(
+      jni_ctx->executor, executor_cl_, executor_evaluate_batch_id_, &arg);
+  Status status = JniUtil::GetJniExceptionMsg(env);
+  if (!status.ok()) LogUdfFailure(fn_ctx, jni_ctx, status);
+}
+
 Status HiveUdfCall::InitEnv() {
   DCHECK(executor_cl_ == NULL) << "Init() already called!";
   JNIEnv* env = JniUtil::GetJNIEnv();
@@ -142,6 +191,9 @@ Status HiveUdfCall::InitEnv() {
   executor_evaluate_id_ = env->GetMethodID(
       executor_cl_, "evaluate", EXECUTOR_EVALUATE_SIGNATURE);
   RETURN_ERROR_IF_EXC(env);
+  executor_evaluate_batch_id_ = env->GetMethodID(
+      executor_cl_, "evaluateBatch", EXECUTOR_EVALUATE_BATCH_SIGNATURE);
+  RETURN_ERROR_IF_EXC(env);
   executor_close_id_ = env->GetMethodID(
       executor_cl_, "close", EXECUTOR_CLOSE_SIGNATURE);
   RETURN_ERROR_IF_EXC(env);
@@ -160,6 +212,7 @@ Status HiveUdfCall::Init(
     // Align all values up to 8 bytes. We don't care about footprint since we allocate
     // one buffer for all rows and we never copy the entire buffer.
     input_buffer_size_ = BitUtil::RoundUpNumBytes(input_buffer_size_) * 8;
+    input_byte_sizes_.push_back(input_buffer_size_ - input_byte_offsets_.back());
   }
   return Status::OK();
 }
@@ -204,6 +257,27 @@ Status HiveUdfCall::OpenEvaluator(FunctionContext::FunctionStateScope scope,
     ctor_params.output_buffer_ptr = (int64_t)jni_ctx->output_value_buffer;
     ctor_params.output_null_ptr = (int64_t)&jni_ctx->output_null_value;
 
+    // Strings returned by the executor only stay valid until its next evaluation, so
+    // UDFs that return strings are evaluated one row at a time.
+    if (!type().IsStringType()) {
+      const int capacity = state->batch_size();
+      DCHECK_GT(capacity, 0);
+      jni_ctx->batch_capacity = capacity;
+      jni_ctx->batch_input_values = new uint8_t[input_buffer_size_ * capacity];
+      jni_ctx->batch_input_nulls = new uint8_t[GetNumChildren() * capacity];
+      jni_ctx->batch_output_values = new uint8_t[type().GetSlotSize() * capacity];
+      jni_ctx->batch_output_nulls = new uint8_t[capacity];
+      ctor_params.__set_batch_capacity(capacity);
+      ctor_params.__set_input_byte_sizes(input_byte_sizes_);
+      ctor_params.__set_batch_input_buffer_ptr(
+          (int64_t)jni_ctx->batch_input_values);
+      ctor_params.__set_batch_input_nulls_ptr((int64_t)jni_ctx->batch_input_nulls);
+      ctor_params.__set_batch_output_buffer_ptr(
+          (int64_t)jni_ctx->batch_output_values);
+      ctor_params.__set_batch_output_null_ptr((int64_t)jni_ctx->batch_output_nulls);
+      ctor_params.__set_output_byte_size(type().GetSlotSize());
+    }
+
     jbyteArray ctor_params_bytes;
 
     // Pushed frame will be popped when jni_frame goes out-of-scope.
@@ -251,6 +325,10 @@ void HiveUdfCall::CloseEvaluator(FunctionContext::FunctionStateScope scope,
         delete[] jni_ctx->output_value_buffer;
         jni_ctx->output_value_buffer = NULL;
       }
+      delete[] jni_ctx->batch_input_values;
+      delete[] jni_ctx->batch_input_nulls;
+      delete[] jni_ctx->batch_output_values;
+      delete[] jni_ctx->batch_output_nulls;
       jni_ctx->output_anyval = NULL;
       delete jni_ctx;
       fn_ctx->SetFunctionState(FunctionContext::THREAD_LOCAL, nullptr);
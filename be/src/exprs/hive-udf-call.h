@@ -72,12 +72,39 @@ class TExprNode;
 /// The BE reads the StringValue as normal.
 //
 /// If the UDF ran into an error, the FE throws an exception.
+//
+/// UDFs that do not return strings can also be evaluated over many rows with a single
+/// JNI call, which amortizes the JNI transition over the rows. The arguments of the
+/// rows are staged with EvaluateBatchArgs() in columnar buffers with one column of
+/// values and one column of null bytes per argument, and EvaluateBatch() then calls
+/// UdfExecutor.evaluateBatch(), which writes the results to a column of values and a
+/// column of null bytes. These buffers are allocated in OpenEvaluator() with room for
+/// a row batch and are passed to the UdfExecutor in the constructor.
 class HiveUdfCall : public ScalarExpr {
  public:
   /// Must be called before creating any HiveUdfCall instances. This is called at impalad
   /// startup time.
   static Status InitEnv() WARN_UNUSED_RESULT;
 
+  virtual bool IsHiveUdfCall() const override { return true; }
+
+  /// Returns the number of rows that 'eval' can evaluate with one call to
+  /// EvaluateBatch(), or 0 if this UDF can only be evaluated one row at a time.
+  int GetBatchCapacity(ScalarExprEvaluator* eval) const;
+
+  /// Evaluates the children of this expr over 'row' and stores their values as the
+  /// arguments of row 'row_idx' of the next EvaluateBatch() call.
+  void EvaluateBatchArgs(
+      ScalarExprEvaluator* eval, const TupleRow* row, int row_idx) const;
+
+  /// Evaluates the UDF over the arguments of rows 0 to 'num_rows' - 1, which must be at
+  /// most GetBatchCapacity(). Sets '*values' to the results, in the slot layout of
+  /// type() with one slot per row, and '*nulls' to one byte per row that is 1 if the
+  /// result is NULL. Both stay valid until the next call. As in Evaluate(), the result
+  /// of a row for which the UDF fails is NULL and a warning is logged.
+  void EvaluateBatch(ScalarExprEvaluator* eval, int num_rows, const uint8_t** values,
+      const uint8_t** nulls) const;
+
   virtual Status GetCodegendComputeFnImpl(LlvmCodeGen* codegen, llvm::Function** fn)
       override WARN_UNUSED_RESULT;
   virtual std::string DebugString() const override;
@@ -114,10 +141,17 @@ class HiveUdfCall : public ScalarExpr {
       llvm::Function* function, llvm::Value* (*args)[2], llvm::Value* jni_ctx,
       llvm::BasicBlock* const first_block, llvm::BasicBlock** next_block);
 
+  /// Copies the value 'v' of child 'child_idx' to 'dst'.
+  void CopyChildValue(int child_idx, const void* v, uint8_t* dst) const;
+
   /// input_byte_offsets_[i] is the byte offset child ith's input argument should
   /// be written to.
   std::vector<int> input_byte_offsets_;
 
+  /// input_byte_sizes_[i] is the number of bytes that child ith's input argument takes
+  /// in the input buffer, i.e. its slot size rounded up to 8 bytes.
+  std::vector<int> input_byte_sizes_;
+
   /// The size of the buffer for passing in input arguments.
   int input_buffer_size_;
 
@@ -126,6 +160,7 @@ class HiveUdfCall : public ScalarExpr {
   static jclass executor_cl_;
   static jmethodID executor_ctor_id_;
   static jmethodID executor_evaluate_id_;
+  static jmethodID executor_evaluate_batch_id_;
   static jmethodID executor_close_id_;
 
   struct JniContext {
@@ -137,6 +172,17 @@ class HiveUdfCall : public ScalarExpr {
     uint8_t output_null_value;
     bool warning_logged = false;
 
+    /// The columnar buffers for EvaluateBatch(), with room for 'batch_capacity' rows.
+    /// The column of child i's values starts at input_byte_offsets_[i] *
+    /// 'batch_capacity' in 'batch_input_values' and the column of its null bytes at
+    /// i * 'batch_capacity' in 'batch_input_nulls'. All are null and 'batch_capacity'
+    /// is 0 if the UDF returns strings.
+    int batch_capacity = 0;
+    uint8_t* batch_input_values = nullptr;
+    uint8_t* batch_input_nulls = nullptr;
+    uint8_t* batch_output_values = nullptr;
+    uint8_t* batch_output_nulls = nullptr;
+
     /// Used for logging errors.
     const char* hdfs_location = nullptr;
     const char* scalar_fn_symbol = nullptr;
@@ -151,6 +197,11 @@ class HiveUdfCall : public ScalarExpr {
    static uint8_t* GetInputValuesBufferAtOffset(JniContext* jni_ctx, int offset);
   };
 
+  /// Adds a warning for the failure 'status' of the UDF to 'fn_ctx', unless one was
+  /// already added for 'jni_ctx'.
+  static void LogUdfFailure(
+      FunctionContext* fn_ctx, JniContext* jni_ctx, const Status& status);
+
   /// Static helper functions for codegen.
   static jclass* GetExecutorClass();
   static jmethodID* GetExecutorEvaluateId();
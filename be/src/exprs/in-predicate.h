@@ -19,7 +19,11 @@
 #ifndef IMPALA_EXPRS_IN_PREDICATE_H_
 #define IMPALA_EXPRS_IN_PREDICATE_H_
 
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <type_traits>
+#include <vector>
 #include <boost/container/flat_set.hpp>
 #include <boost/unordered_set.hpp>
 #include "exprs/predicate.h"
@@ -27,9 +31,197 @@
 #include "runtime/decimal-value.inline.h"
 #include "runtime/string-value.inline.h"
 #include "udf/udf.h"
+#include "util/bit-util.h"
+#include "util/hash-util.h"
 
 namespace impala {
 
+/// The set of the non-NULL constant values of an IN list that SET_LOOKUP searches.
+/// Init() builds it from all values at once.
+template <typename SetType>
+class InListSet {
+ public:
+  void Init(const std::vector<SetType>& values) {
+    set_.insert(values.begin(), values.end());
+  }
+
+  bool Contains(const SetType& v) const { return set_.find(v) != set_.end(); }
+
+ private:
+  boost::unordered_set<SetType> set_;
+};
+
+/// IMPALA-6621: Due to an implementation detail in boost, floats are slower when using
+/// unordered_set as compared to flat_set.
+template <>
+class InListSet<float> {
+ public:
+  void Init(const std::vector<float>& values) {
+    set_.insert(values.begin(), values.end());
+  }
+
+  bool Contains(float v) const { return set_.find(v) != set_.end(); }
+
+ private:
+  boost::container::flat_set<float> set_;
+};
+
+/// The set of the values of an IN list of integers. The representation is chosen by
+/// Init() from the number and the range of the values:
+/// * BITMAP: one bit per value in [min, max], if the range is small compared to the
+///   number of values. A lookup is a range check and one load.
+/// * LINEAR: up to LINEAR_MAX_VALUES values in an array that is scanned without
+///   branches. The compiler vectorizes the scan.
+/// * SORTED: a sorted array that is searched with a branchless binary search.
+template <typename T>
+class IntegerInListSet {
+ public:
+  /// The most values that are scanned linearly.
+  static constexpr int LINEAR_MAX_VALUES = 16;
+
+  /// A bitmap is used if it has at most this many bits per value, or at most
+  /// BITMAP_MIN_BITS bits.
+  static constexpr int64_t BITMAP_BITS_PER_VALUE = 64;
+  static constexpr int64_t BITMAP_MIN_BITS = 4096;
+
+  enum class Kind { BITMAP, LINEAR, SORTED };
+
+  void Init(const std::vector<T>& values) {
+    values_ = values;
+    std::sort(values_.begin(), values_.end());
+    values_.erase(std::unique(values_.begin(), values_.end()), values_.end());
+    if (values_.empty()) {
+      kind_ = Kind::LINEAR;
+      return;
+    }
+    min_ = values_.front();
+    range_ = static_cast<UnsignedT>(values_.back()) - static_cast<UnsignedT>(min_);
+    const int64_t max_bitmap_bits = std::max(
+        BITMAP_MIN_BITS, static_cast<int64_t>(values_.size()) * BITMAP_BITS_PER_VALUE);
+    if (static_cast<uint64_t>(range_) < static_cast<uint64_t>(max_bitmap_bits)) {
+      kind_ = Kind::BITMAP;
+      bitmap_.assign(BitUtil::RoundUpNumi64(static_cast<int64_t>(range_) + 1), 0);
+      for (T v : values_) {
+        const UnsignedT offset = static_cast<UnsignedT>(v) - static_cast<UnsignedT>(min_);
+        bitmap_[offset >> 6] |= 1ULL << (offset & 63);
+      }
+      std::vector<T>().swap(values_);
+    } else if (values_.size() <= LINEAR_MAX_VALUES) {
+      kind_ = Kind::LINEAR;
+    } else {
+      kind_ = Kind::SORTED;
+    }
+  }
+
+  bool Contains(T v) const {
+    switch (kind_) {
+      case Kind::BITMAP: {
+        const UnsignedT offset = static_cast<UnsignedT>(v) - static_cast<UnsignedT>(min_);
+        if (offset > range_) return false;
+        return (bitmap_[offset >> 6] >> (offset & 63)) & 1;
+      }
+      case Kind::LINEAR: {
+        bool found = false;
+        for (T value : values_) found |= value == v;
+        return found;
+      }
+      case Kind::SORTED: {
+        // Finds the last value that is not greater than 'v', or the first value.
+        const T* base = values_.data();
+        int64_t n = values_.size();
+        while (n > 1) {
+          const int64_t half = n / 2;
+          base = base[half] <= v ? base + half : base;
+          n -= half;
+        }
+        return *base == v;
+      }
+    }
+    return false;
+  }
+
+  Kind kind() const { return kind_; }
+
+ private:
+  typedef typename std::make_unsigned<T>::type UnsignedT;
+
+  Kind kind_ = Kind::LINEAR;
+
+  /// The smallest value and the difference to the largest value. Only used for BITMAP.
+  T min_ = 0;
+  UnsignedT range_ = 0;
+
+  /// The bits of the values, relative to 'min_'. Only used for BITMAP.
+  std::vector<uint64_t> bitmap_;
+
+  /// The sorted distinct values. Only used for LINEAR and SORTED.
+  std::vector<T> values_;
+};
+
+template <>
+class InListSet<int8_t> : public IntegerInListSet<int8_t> {};
+
+template <>
+class InListSet<int16_t> : public IntegerInListSet<int16_t> {};
+
+template <>
+class InListSet<int32_t> : public IntegerInListSet<int32_t> {};
+
+template <>
+class InListSet<int64_t> : public IntegerInListSet<int64_t> {};
+
+/// The set of the values of an IN list of strings, as an open addressing hash table
+/// with linear probing. Each bucket holds the hash of its value, so a lookup only
+/// compares the bytes of values with the same hash and length. The values are not
+/// copied and must outlive the set.
+template <>
+class InListSet<StringValue> {
+ public:
+  void Init(const std::vector<StringValue>& values) {
+    const int64_t num_buckets =
+        BitUtil::RoundUpToPowerOfTwo(std::max<int64_t>(values.size() * 2, 8));
+    buckets_.assign(num_buckets, Bucket());
+    mask_ = num_buckets - 1;
+    for (const StringValue& v : values) {
+      const uint32_t hash = Hash(v);
+      Bucket* bucket = &buckets_[hash & mask_];
+      while (bucket->len >= 0 && !bucket->Matches(hash, v)) {
+        bucket = &buckets_[(bucket - buckets_.data() + 1) & mask_];
+      }
+      *bucket = {hash, v.len, v.ptr};
+    }
+  }
+
+  bool Contains(const StringValue& v) const {
+    const uint32_t hash = Hash(v);
+    for (uint32_t i = hash & mask_;; i = (i + 1) & mask_) {
+      const Bucket& bucket = buckets_[i];
+      if (bucket.len < 0) return false;
+      if (bucket.Matches(hash, v)) return true;
+    }
+  }
+
+ private:
+  struct Bucket {
+    uint32_t hash = 0;
+    /// -1 if the bucket is empty.
+    int32_t len = -1;
+    const char* ptr = nullptr;
+
+    bool Matches(uint32_t h, const StringValue& v) const {
+      return hash == h && len == v.len && (len == 0 || memcmp(ptr, v.ptr, len) == 0);
+    }
+  };
+
+  static uint32_t Hash(const StringValue& v) {
+    if (v.len == 0) return HashUtil::HASH_COMBINE_SEED;
+    return HashUtil::Hash(v.ptr, v.len, HashUtil::HASH_COMBINE_SEED);
+  }
+
+  std::vector<Bucket> buckets_;
+  uint32_t mask_ = 0;
+};
+
 /// Utilities for evaluating expressions of the form "val [NOT] IN (x1, x2, x3...)".
 /// In predicates are implemented using ScalarFnCall and the UDF interface.
 ///
@@ -307,7 +499,7 @@ class InPredicate {
     bool contains_null;
 
     /// The set of all non-NULL constant values in the IN list.
-    boost::unordered_set<SetType> val_set;
+    InListSet<SetType> val_set;
 
     /// The type of the arguments
     const FunctionContext::TypeDesc* type;
@@ -370,8 +562,8 @@ void InPredicate::SetLookupPrepare(
   SetLookupState<SetType>* state = new SetLookupState<SetType>;
   state->type = ctx->GetArgType(0);
   state->contains_null = false;
-  // Collect all values in a vector to use the bulk insert API to avoid N^2 behavior
-  // with flat_set.
+  // Collect all values in a vector to build the set at once, which avoids N^2 behavior
+  // with flat_set and lets the set choose its representation from all values.
   std::vector<SetType> element_list;
   element_list.reserve(ctx->GetNumArgs() - 1);
   for (int i = 1; i < ctx->GetNumArgs(); ++i) {
@@ -383,7 +575,7 @@ void InPredicate::SetLookupPrepare(
       element_list.push_back(GetVal<T, SetType>(state->type, *arg));
     }
   }
-  state->val_set.insert(element_list.begin(), element_list.end());
+  state->val_set.Init(element_list);
   ctx->SetFunctionState(scope, state);
 }
 
@@ -401,7 +593,7 @@ template <typename T, typename SetType>
 BooleanVal InPredicate::SetLookup(SetLookupState<SetType>* state, const T& v) {
   DCHECK(state != NULL);
   SetType val = GetVal<T, SetType>(state->type, v);
-  bool found = state->val_set.find(val) != state->val_set.end();
+  bool found = state->val_set.Contains(val);
   if (found) return BooleanVal(true);
   if (state->contains_null) return BooleanVal::null();
   return BooleanVal(false);
@@ -453,28 +645,6 @@ inline Decimal16Value InPredicate::GetVal(
   }
 }
 
-// IMPALA-6621: Due to an implementation detail in boost, these 3 types are slower when
-// using unordered_map as compared to flat_set.
-template <>
-struct InPredicate::SetLookupState<int32_t> {
-  bool contains_null;
-  boost::container::flat_set<int32_t> val_set;
-  const FunctionContext::TypeDesc* type;
-};
-
-template <>
-struct InPredicate::SetLookupState<int64_t> {
-  bool contains_null;
-  boost::container::flat_set<int64_t> val_set;
-  const FunctionContext::TypeDesc* type;
-};
-
-template <>
-struct InPredicate::SetLookupState<float> {
-  bool contains_null;
-  boost::container::flat_set<float> val_set;
-  const FunctionContext::TypeDesc* type;
-};
 }
 
 #endif
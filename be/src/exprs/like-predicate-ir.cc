@@ -28,6 +28,26 @@ BooleanVal LikePredicate::Like(FunctionContext* context, const StringVal& val,
   return (state->function_)(context, val, pattern);
 }
 
+BooleanVal LikePredicate::LikeAny(FunctionContext* context, const StringVal& val,
+    int num_patterns, const StringVal* patterns) {
+  if (val.is_null) return BooleanVal::null();
+  LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
+      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  if (!state->constant_patterns_) {
+    return LikeAnyNonConstant(context, val, num_patterns, patterns);
+  }
+  if (state->multi_search_ != nullptr
+      && state->multi_search_->ContainsAny(StringValue::FromStringVal(val))) {
+    return BooleanVal(true);
+  }
+  if (state->regex_ != nullptr
+      && RE2::FullMatch(re2::StringPiece(reinterpret_cast<const char*>(val.ptr), val.len),
+             *state->regex_)) {
+    return BooleanVal(true);
+  }
+  return state->has_null_pattern_ ? BooleanVal::null() : BooleanVal(false);
+}
+
 BooleanVal LikePredicate::Regex(FunctionContext* context, const StringVal& val,
     const StringVal& pattern) {
   LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
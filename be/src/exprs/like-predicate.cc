@@ -22,6 +22,7 @@
 #include <re2/stringpiece.h>
 #include <sstream>
 
+#include "exprs/regex-cache.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/string-value.inline.h"
 #include "string-functions.h"
@@ -48,6 +49,12 @@ static const RE2 STARTS_WITH_RE(
 // A regex to match any regex pattern which is equivalent to a constant string match.
 static const RE2 EQUALS_RE("\\^([^\\.\\^\\{\\[\\(\\|\\)\\]\\}\\+\\*\\?\\$\\\\]*)\\$");
 
+// A regex to match any regex pattern which is an alternation of non-empty constant
+// strings, which is equivalent to a search for any of them.
+static const RE2 ALTERNATION_RE(
+    "[^\\.\\^\\{\\[\\(\\|\\)\\]\\}\\+\\*\\?\\$\\\\]+"
+    "(?:\\|[^\\.\\^\\{\\[\\(\\|\\)\\]\\}\\+\\*\\?\\$\\\\]+)+");
+
 void LikePredicate::LikePrepare(FunctionContext* context,
     FunctionContext::FunctionStateScope scope) {
   LikePrepareInternal(context, scope, true);
@@ -99,7 +106,7 @@ void LikePredicate::LikePrepareInternal(FunctionContext* context,
       opts.set_never_nl(false);
       opts.set_dot_nl(true);
       opts.set_case_sensitive(case_sensitive);
-      state->regex_.reset(new RE2(re_pattern, opts));
+      state->regex_ = RegexCache::Compile(re_pattern, opts);
       if (!state->regex_->ok()) {
         context->SetError(Substitute("Invalid regex: $0", pattern_str).c_str());
       }
@@ -117,6 +124,81 @@ void LikePredicate::LikeClose(FunctionContext* context,
   }
 }
 
+void LikePredicate::LikeAnyPrepare(FunctionContext* context,
+    FunctionContext::FunctionStateScope scope) {
+  LikeAnyPrepareInternal(context, scope, true);
+}
+
+void LikePredicate::ILikeAnyPrepare(FunctionContext* context,
+    FunctionContext::FunctionStateScope scope) {
+  LikeAnyPrepareInternal(context, scope, false);
+}
+
+// If the patterns are constant, the case-sensitive patterns of the form '%<literal>%'
+// are searched for with a single MultiStringSearch, and the other patterns are combined
+// into a single regex. ILIKE patterns always go to the regex because RE2 folds some
+// ASCII letters onto non-ASCII characters, e.g. 'k' onto the Kelvin sign.
+void LikePredicate::LikeAnyPrepareInternal(FunctionContext* context,
+    FunctionContext::FunctionStateScope scope, bool case_sensitive) {
+  if (scope != FunctionContext::THREAD_LOCAL) return;
+  LikePredicateState* state = new LikePredicateState();
+  state->case_sensitive_ = case_sensitive;
+  context->SetFunctionState(scope, state);
+  for (int i = 1; i < context->GetNumArgs(); ++i) {
+    if (!context->IsArgConstant(i)) return;
+  }
+  state->constant_patterns_ = true;
+  re2::RE2 substring_re("(?:%+)([^%_]*)(?:%+)");
+  vector<string> substrings;
+  string alternation;
+  for (int i = 1; i < context->GetNumArgs(); ++i) {
+    StringVal* pattern_val = reinterpret_cast<StringVal*>(context->GetConstantArg(i));
+    if (pattern_val->is_null) {
+      state->has_null_pattern_ = true;
+      continue;
+    }
+    string pattern_str(reinterpret_cast<const char*>(pattern_val->ptr), pattern_val->len);
+    string search_string;
+    if (case_sensitive && RE2::FullMatch(pattern_str, substring_re, &search_string)
+        && search_string.find(state->escape_char_) == string::npos) {
+      substrings.push_back(search_string);
+      continue;
+    }
+    string re_pattern;
+    ConvertLikePattern(context, *pattern_val, &re_pattern);
+    if (!alternation.empty()) alternation.append("|");
+    alternation.append("(?:").append(re_pattern).append(")");
+  }
+  if (!substrings.empty()) state->multi_search_.reset(new MultiStringSearch(substrings));
+  if (!alternation.empty()) {
+    RE2::Options opts;
+    opts.set_never_nl(false);
+    opts.set_dot_nl(true);
+    opts.set_case_sensitive(case_sensitive);
+    state->regex_ = RegexCache::Compile(alternation, opts);
+    if (!state->regex_->ok()) {
+      context->SetError(Substitute("Invalid regex: $0", alternation).c_str());
+    }
+  }
+}
+
+BooleanVal LikePredicate::LikeAnyNonConstant(FunctionContext* context,
+    const StringVal& val, int num_patterns, const StringVal* patterns) {
+  LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
+      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  bool has_null_pattern = false;
+  for (int i = 0; i < num_patterns; ++i) {
+    if (patterns[i].is_null) {
+      has_null_pattern = true;
+      continue;
+    }
+    BooleanVal result =
+        NonConstantPatternMatch(context, val, patterns[i], true, state->case_sensitive_);
+    if (result.val) return result;
+  }
+  return has_null_pattern ? BooleanVal::null() : BooleanVal(false);
+}
+
 void LikePredicate::RegexPrepare(FunctionContext* context,
     FunctionContext::FunctionStateScope scope) {
   RegexPrepareInternal(context, scope, true);
@@ -159,10 +241,20 @@ void LikePredicate::RegexPrepareInternal(FunctionContext* context,
         RE2::FullMatch(pattern_str, SUBSTRING_RE, &search_string)) {
       state->SetSearchString(search_string);
       state->function_ = ConstantSubstringFn;
+    } else if (case_sensitive && RE2::FullMatch(pattern_str, ALTERNATION_RE)) {
+      vector<string> substrings;
+      size_t start = 0;
+      for (size_t end; (end = pattern_str.find('|', start)) != string::npos;
+           start = end + 1) {
+        substrings.push_back(pattern_str.substr(start, end - start));
+      }
+      substrings.push_back(pattern_str.substr(start));
+      state->multi_search_.reset(new MultiStringSearch(substrings));
+      state->function_ = ConstantMultiSubstringFn;
     } else {
       RE2::Options opts;
       opts.set_case_sensitive(case_sensitive);
-      state->regex_.reset(new RE2(pattern_str, opts));
+      state->regex_ = RegexCache::Compile(pattern_str, opts);
       if (!state->regex_->ok()) {
         context->SetError(
             Substitute("Invalid regex expression: '$0'", pattern_str).c_str());
@@ -199,7 +291,7 @@ void LikePredicate::RegexpLikePrepare(FunctionContext* context,
       return;
     }
     string pattern_str(reinterpret_cast<const char*>(pattern->ptr), pattern->len);
-    state->regex_.reset(new RE2(pattern_str, opts));
+    state->regex_ = RegexCache::Compile(pattern_str, opts);
     if (!state->regex_->ok()) {
       context->SetError(
           Substitute("Invalid regex expression: '$0'", pattern_str).c_str());
@@ -303,6 +395,14 @@ BooleanVal LikePredicate::ConstantEqualsFn(FunctionContext* context, const Strin
   return BooleanVal(state->search_string_sv_.Eq(StringValue::FromStringVal(val)));
 }
 
+BooleanVal LikePredicate::ConstantMultiSubstringFn(FunctionContext* context,
+    const StringVal& val, const StringVal& pattern) {
+  if (val.is_null) return BooleanVal::null();
+  LikePredicateState* state = reinterpret_cast<LikePredicateState*>(
+      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  return BooleanVal(state->multi_search_->ContainsAny(StringValue::FromStringVal(val)));
+}
+
 BooleanVal LikePredicate::ConstantRegexFnPartial(FunctionContext* context,
     const StringVal& val, const StringVal& pattern) {
   if (val.is_null) return BooleanVal::null();
@@ -336,33 +436,41 @@ BooleanVal LikePredicate::RegexMatch(FunctionContext* context,
           operand_value.ptr), operand_value.len), *state->regex_.get());
     }
   } else {
-    string re_pattern;
-    RE2::Options opts;
+    return NonConstantPatternMatch(
+        context, operand_value, pattern_value, is_like_pattern, true);
+  }
+}
+
+BooleanVal LikePredicate::NonConstantPatternMatch(FunctionContext* context,
+    const StringVal& operand_value, const StringVal& pattern_value,
+    bool is_like_pattern, bool case_sensitive) {
+  string re_pattern;
+  RE2::Options opts;
+  opts.set_case_sensitive(case_sensitive);
+  if (is_like_pattern) {
+    ConvertLikePattern(context, pattern_value, &re_pattern);
+    opts.set_never_nl(false);
+    opts.set_dot_nl(true);
+  } else {
+    re_pattern =
+      string(reinterpret_cast<const char*>(pattern_value.ptr), pattern_value.len);
+  }
+  re2::RE2 re(re_pattern, opts);
+  if (re.ok()) {
     if (is_like_pattern) {
-      ConvertLikePattern(context, pattern_value, &re_pattern);
-      opts.set_never_nl(false);
-      opts.set_dot_nl(true);
+      return RE2::FullMatch(re2::StringPiece(
+          reinterpret_cast<const char*>(operand_value.ptr), operand_value.len), re);
     } else {
-      re_pattern =
-        string(reinterpret_cast<const char*>(pattern_value.ptr), pattern_value.len);
-    }
-    re2::RE2 re(re_pattern, opts);
-    if (re.ok()) {
-      if (is_like_pattern) {
-        return RE2::FullMatch(re2::StringPiece(
-            reinterpret_cast<const char*>(operand_value.ptr), operand_value.len), re);
-      } else {
-        return RE2::PartialMatch(
-            re2::StringPiece(
-                reinterpret_cast<const char*>(operand_value.ptr), operand_value.len),
-            re);
-      }
-    } else {
-      string pattern_str(
-          reinterpret_cast<const char*>(pattern_value.ptr), pattern_value.len);
-      context->SetError(Substitute("Invalid regex: $0", pattern_str).c_str());
-      return BooleanVal(false);
+      return RE2::PartialMatch(
+          re2::StringPiece(
+              reinterpret_cast<const char*>(operand_value.ptr), operand_value.len),
+          re);
     }
+  } else {
+    string pattern_str(
+        reinterpret_cast<const char*>(pattern_value.ptr), pattern_value.len);
+    context->SetError(Substitute("Invalid regex: $0", pattern_str).c_str());
+    return BooleanVal(false);
   }
 }
 
@@ -19,12 +19,14 @@
 #ifndef IMPALA_EXPRS_LIKE_PREDICATE_H_
 #define IMPALA_EXPRS_LIKE_PREDICATE_H_
 
+#include <memory>
 #include <boost/scoped_ptr.hpp>
 #include <re2/re2.h>
 #include <string>
 
 #include "exprs/predicate.h"
 #include "gen-cpp/Exprs_types.h"
+#include "runtime/multi-string-search.h"
 #include "runtime/string-search.h"
 #include "udf/udf.h"
 
@@ -77,7 +79,24 @@ class LikePredicate: public Predicate {
     StringSearch substring_pattern_;
 
     /// Used for RLIKE and REGEXP predicates if the pattern is a constant argument.
-    boost::scoped_ptr<re2::RE2> regex_;
+    /// For like_any(), the alternation of the constant patterns that are not in
+    /// 'multi_search_'. Shared with the RegexCache.
+    std::shared_ptr<const re2::RE2> regex_;
+
+    /// Used for like_any() if the patterns are constant arguments, for the patterns of
+    /// the form '%<literal>%', and for REGEXP predicates if the pattern is an
+    /// alternation of literals.
+    boost::scoped_ptr<MultiStringSearch> multi_search_;
+
+    /// Set for like_any() if any of the constant patterns is NULL.
+    bool has_null_pattern_ = false;
+
+    /// Set for like_any() if all patterns are constant arguments.
+    bool constant_patterns_ = false;
+
+    /// Whether like_any() or ilike_any() is evaluated. Only used if the patterns are not
+    /// constant arguments.
+    bool case_sensitive_ = true;
 
     LikePredicateState() : escape_char_('\\') {
     }
@@ -106,6 +125,29 @@ class LikePredicate: public Predicate {
   static void LikeClose(impala_udf::FunctionContext* context,
       impala_udf::FunctionContext::FunctionStateScope scope);
 
+  static void LikeAnyPrepare(impala_udf::FunctionContext* context,
+      impala_udf::FunctionContext::FunctionStateScope scope);
+
+  static void ILikeAnyPrepare(impala_udf::FunctionContext* context,
+      impala_udf::FunctionContext::FunctionStateScope scope);
+
+  static void LikeAnyPrepareInternal(impala_udf::FunctionContext* context,
+      impala_udf::FunctionContext::FunctionStateScope scope, bool case_sensitive);
+
+  /// Implements like_any(val, pattern1, pattern2, ...) and ilike_any(), which the
+  /// planner substitutes for disjunctions of LIKE or ILIKE predicates on the same value.
+  /// Returns true if 'val' matches any of the 'num_patterns' patterns, NULL if it
+  /// matches none of them and 'val' or any of the patterns is NULL, and false otherwise.
+  static impala_udf::BooleanVal LikeAny(impala_udf::FunctionContext* context,
+      const impala_udf::StringVal& val, int num_patterns,
+      const impala_udf::StringVal* patterns);
+
+  /// Handles like_any() and ilike_any() if any of the patterns is not constant. The
+  /// patterns are compiled for every row.
+  static impala_udf::BooleanVal LikeAnyNonConstant(impala_udf::FunctionContext* context,
+      const impala_udf::StringVal& val, int num_patterns,
+      const impala_udf::StringVal* patterns);
+
   static void RegexPrepare(impala_udf::FunctionContext* context,
       impala_udf::FunctionContext::FunctionStateScope scope);
 
@@ -159,6 +201,12 @@ class LikePredicate: public Predicate {
   static impala_udf::BooleanVal ConstantEqualsFn(impala_udf::FunctionContext* context,
       const impala_udf::StringVal& val, const impala_udf::StringVal& pattern);
 
+  /// Handling of regex predicates that are an alternation of literals, which can be
+  /// implemented with a MultiStringSearch.
+  static impala_udf::BooleanVal ConstantMultiSubstringFn(
+      impala_udf::FunctionContext* context, const impala_udf::StringVal& val,
+      const impala_udf::StringVal& pattern);
+
   static impala_udf::BooleanVal ConstantRegexFnPartial(
       impala_udf::FunctionContext* context, const impala_udf::StringVal& val,
       const impala_udf::StringVal& pattern);
@@ -170,6 +218,13 @@ class LikePredicate: public Predicate {
       const impala_udf::StringVal& val, const impala_udf::StringVal& pattern,
       bool is_like_pattern);
 
+  /// Compiles 'pattern_value' and matches 'operand_value' against it. Used if the
+  /// pattern is not a constant argument.
+  static impala_udf::BooleanVal NonConstantPatternMatch(
+      impala_udf::FunctionContext* context, const impala_udf::StringVal& operand_value,
+      const impala_udf::StringVal& pattern_value, bool is_like_pattern,
+      bool case_sensitive);
+
   /// Convert a LIKE pattern (with embedded % and _) into the corresponding
   /// regular expression pattern. Escaped chars are copied verbatim.
   static void ConvertLikePattern(impala_udf::FunctionContext* context,
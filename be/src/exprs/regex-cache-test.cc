@@ -0,0 +1,108 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exprs/regex-cache.h"
+
+#include <gflags/gflags.h>
+
+#include "runtime/mem-tracker.h"
+#include "testutil/gtest-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+DECLARE_bool(cache_force_single_shard);
+
+namespace impala {
+
+static const int64_t CAPACITY = 64 * 1024;
+
+class RegexCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() override {
+    // Makes the capacity of the cache exact.
+    FLAGS_cache_force_single_shard = true;
+    metrics_.reset(new MetricGroup("regex-cache-test"));
+    cache_.reset(new RegexCache(CAPACITY, &process_tracker_));
+    ASSERT_OK(cache_->Init(metrics_.get()));
+  }
+
+  virtual void TearDown() override {
+    cache_.reset();
+    EXPECT_EQ(0, process_tracker_.consumption());
+    process_tracker_.Close();
+  }
+
+  int64_t Metric(const string& key) {
+    return metrics_->GetOrCreateChildGroup("regex-cache")
+        ->FindMetricForTesting<IntCounter>(key)->GetValue();
+  }
+
+  MemTracker process_tracker_;
+  unique_ptr<MetricGroup> metrics_;
+  unique_ptr<RegexCache> cache_;
+};
+
+TEST_F(RegexCacheTest, Basic) {
+  re2::RE2::Options options;
+  shared_ptr<const re2::RE2> re = cache_->GetOrCompile("a.*b", options);
+  ASSERT_TRUE(re->ok());
+  EXPECT_TRUE(re2::RE2::FullMatch("axxb", *re));
+  EXPECT_GT(process_tracker_.consumption(), 0);
+  EXPECT_EQ(re.get(), cache_->GetOrCompile("a.*b", options).get());
+  EXPECT_EQ(1, Metric("regex-cache.hit-count"));
+  EXPECT_EQ(1, Metric("regex-cache.miss-count"));
+
+  // Regexes with different options are different entries.
+  re2::RE2::Options case_insensitive;
+  case_insensitive.set_case_sensitive(false);
+  shared_ptr<const re2::RE2> re_ci = cache_->GetOrCompile("a.*b", case_insensitive);
+  EXPECT_NE(re.get(), re_ci.get());
+  EXPECT_TRUE(re2::RE2::FullMatch("AxxB", *re_ci));
+  EXPECT_FALSE(re2::RE2::FullMatch("AxxB", *re));
+  EXPECT_EQ(2, Metric("regex-cache.miss-count"));
+}
+
+TEST_F(RegexCacheTest, InvalidPattern) {
+  re2::RE2::Options options;
+  options.set_log_errors(false);
+  EXPECT_FALSE(cache_->GetOrCompile("(a", options)->ok());
+  EXPECT_FALSE(cache_->GetOrCompile("(a", options)->ok());
+  EXPECT_EQ(0, Metric("regex-cache.hit-count"));
+  EXPECT_EQ(0, process_tracker_.consumption());
+}
+
+TEST_F(RegexCacheTest, Eviction) {
+  re2::RE2::Options options;
+  shared_ptr<const re2::RE2> first = cache_->GetOrCompile("pattern0[a-z]+", options);
+  const int64_t charge = process_tracker_.consumption();
+  ASSERT_GT(charge, 0);
+  // Insert more than the capacity of the cache.
+  const int num_patterns = 2 * CAPACITY / charge + 1;
+  for (int i = 1; i < num_patterns; ++i) {
+    ASSERT_TRUE(cache_->GetOrCompile(Substitute("pattern$0[a-z]+", i), options)->ok());
+  }
+  EXPECT_LE(process_tracker_.consumption(), CAPACITY);
+  EXPECT_GT(Metric("regex-cache.eviction-count"), 0);
+
+  // The evicted regex is still usable and is compiled again on the next lookup.
+  EXPECT_TRUE(re2::RE2::FullMatch("pattern0abc", *first));
+  EXPECT_NE(first.get(), cache_->GetOrCompile("pattern0[a-z]+", options).get());
+}
+
+} // namespace impala
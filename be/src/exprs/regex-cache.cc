@@ -0,0 +1,134 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "exprs/regex-cache.h"
+
+#include <cstring>
+
+#include "gutil/strings/substitute.h"
+#include "runtime/exec-env.h"
+#include "runtime/mem-tracker.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Estimated bytes per instruction of a compiled RE2 program, including the one-pass
+/// and bit state data that RE2 may build for it.
+static constexpr int64_t BYTES_PER_INST = 32;
+
+RegexCache::RegexCache(int64_t capacity, MemTracker* parent_mem_tracker)
+  : capacity_(capacity),
+    mem_tracker_(new MemTracker(-1, "Regex Cache", parent_mem_tracker)),
+    cache_(NewCache(Cache::EvictionPolicy::LRU, capacity, "RegexCache")) {
+  DCHECK_GT(capacity, 0);
+}
+
+RegexCache::~RegexCache() {
+  // Frees all entries, which releases their memory from 'mem_tracker_'.
+  cache_.reset();
+  mem_tracker_->Close();
+}
+
+Status RegexCache::Init(MetricGroup* metrics) {
+  RETURN_IF_ERROR(cache_->Init());
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("regex-cache");
+  hits_ = cache_metrics->AddCounter("regex-cache.hit-count", 0);
+  misses_ = cache_metrics->AddCounter("regex-cache.miss-count", 0);
+  evictions_ = cache_metrics->AddCounter("regex-cache.eviction-count", 0);
+  total_bytes_ = cache_metrics->AddGauge("regex-cache.total-bytes", 0);
+  num_entries_ = cache_metrics->AddGauge("regex-cache.num-entries", 0);
+  return Status::OK();
+}
+
+int64_t RegexCache::EstimateMemoryUsage(const re2::RE2& re, const string& key) {
+  return sizeof(re2::RE2) + re.pattern().capacity() + key.size()
+      + re.ProgramSize() * BYTES_PER_INST + sizeof(Entry);
+}
+
+string RegexCache::MakeKey(const string& pattern, const re2::RE2::Options& options) {
+  const bool flags[] = {options.posix_syntax(), options.longest_match(),
+      options.log_errors(), options.literal(), options.never_nl(), options.dot_nl(),
+      options.never_capture(), options.case_sensitive(), options.perl_classes(),
+      options.word_boundary(), options.one_line()};
+  string key = Substitute("$0:$1:", static_cast<int>(options.encoding()),
+      options.max_mem());
+  for (bool flag : flags) key.push_back(flag ? '1' : '0');
+  key.push_back(':');
+  key.append(pattern);
+  return key;
+}
+
+shared_ptr<const re2::RE2> RegexCache::GetOrCompile(
+    const string& pattern, const re2::RE2::Options& options) {
+  const string key = MakeKey(pattern, options);
+  {
+    Cache::UniqueHandle handle(cache_->Lookup(key));
+    if (handle != nullptr) {
+      Entry entry;
+      memcpy(&entry, cache_->Value(handle).data(), sizeof(entry));
+      hits_->Increment(1);
+      return *entry.re;
+    }
+  }
+  misses_->Increment(1);
+  shared_ptr<const re2::RE2> re = make_shared<re2::RE2>(pattern, options);
+  if (!re->ok()) return re;
+  Entry entry;
+  entry.charge = EstimateMemoryUsage(*re, key);
+  if (!FitsInCache(entry.charge)) return re;
+  Cache::UniquePendingHandle pending(
+      cache_->Allocate(key, sizeof(entry), entry.charge));
+  if (pending == nullptr) return re;
+  entry.re = new shared_ptr<const re2::RE2>(re);
+  memcpy(cache_->MutableValue(&pending), &entry, sizeof(entry));
+  // EvictedEntry() releases the memory, also when the insertion fails.
+  mem_tracker_->Consume(entry.charge);
+  total_bytes_->Increment(entry.charge);
+  num_entries_->Increment(1);
+  // Concurrent callers may insert the same key, the last insertion replaces the
+  // earlier entries.
+  Cache::UniqueHandle handle(cache_->Insert(move(pending), this));
+  return re;
+}
+
+shared_ptr<const re2::RE2> RegexCache::Compile(
+    const string& pattern, const re2::RE2::Options& options) {
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  if (exec_env != nullptr && exec_env->regex_cache() != nullptr) {
+    return exec_env->regex_cache()->GetOrCompile(pattern, options);
+  }
+  return make_shared<re2::RE2>(pattern, options);
+}
+
+void RegexCache::EvictedEntry(Slice key, Slice value) {
+  DCHECK_EQ(value.size(), sizeof(Entry));
+  Entry entry;
+  memcpy(&entry, value.data(), sizeof(entry));
+  delete entry.re;
+  mem_tracker_->Release(entry.charge);
+  // The metrics are not set if the cache was never initialized.
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(-entry.charge);
+    num_entries_->Increment(-1);
+    evictions_->Increment(1);
+  }
+}
+
+} // namespace impala
@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+
+#include <re2/re2.h>
+
+#include "common/status.h"
+#include "util/cache/cache.h"
+#include "util/metrics-fwd.h"
+
+namespace impala {
+
+class MemTracker;
+class MetricGroup;
+
+/// Process-wide cache of compiled regular expressions for the constant patterns of
+/// LIKE, REGEXP and the regexp_*() functions, shared by the FunctionContexts of all
+/// fragment instances. A hit saves compiling the pattern in the Prepare() of each
+/// function instance.
+///
+/// Entries are keyed by the pattern and all RE2 options. The compiled regexes are
+/// immutable and returned as shared pointers, so they can be used concurrently by many
+/// threads and stay valid after they are evicted. The cache is bounded by the capacity
+/// given to the constructor and evicts in LRU order. Entries are charged the estimated
+/// size of their compiled program; the DFA states that RE2 builds lazily while matching
+/// are not charged, but are bounded by the max_mem option of each regex.
+///
+/// All functions are thread-safe.
+class RegexCache : public Cache::EvictionCallback {
+ public:
+  /// 'capacity' is the maximum memory in bytes charged to the entries.
+  RegexCache(int64_t capacity, MemTracker* parent_mem_tracker);
+  ~RegexCache();
+
+  /// Initializes the cache and registers its metrics in 'metrics'.
+  Status Init(MetricGroup* metrics);
+
+  /// Returns the regex compiled from 'pattern' with 'options'. Compiles the pattern
+  /// and adds it to the cache on a miss. Patterns that fail to compile are not cached;
+  /// the caller must check ok() of the result.
+  std::shared_ptr<const re2::RE2> GetOrCompile(
+      const std::string& pattern, const re2::RE2::Options& options);
+
+  /// Compiles 'pattern' with 'options' through the regex cache of the process, or
+  /// without caching if there is none.
+  static std::shared_ptr<const re2::RE2> Compile(
+      const std::string& pattern, const re2::RE2::Options& options);
+
+  /// Called by 'cache_' when an entry is evicted or erased.
+  virtual void EvictedEntry(Slice key, Slice value) override;
+
+  /// Returns the charge of an entry for 're' with key 'key'.
+  static int64_t EstimateMemoryUsage(const re2::RE2& re, const std::string& key);
+
+ private:
+  /// The value of each entry. 're' is owned by the entry.
+  struct Entry {
+    int64_t charge;
+    std::shared_ptr<const re2::RE2>* re;
+  };
+
+  /// Returns true if an entry with charge 'charge' can be added to the cache.
+  bool FitsInCache(int64_t charge) const {
+    return charge <= capacity_ && charge <= std::numeric_limits<int>::max();
+  }
+
+  static std::string MakeKey(
+      const std::string& pattern, const re2::RE2::Options& options);
+
+  const int64_t capacity_;
+  std::unique_ptr<MemTracker> mem_tracker_;
+  std::unique_ptr<Cache> cache_;
+
+  /// Metrics of the cache, registered in Init().
+  IntCounter* hits_ = nullptr;
+  IntCounter* misses_ = nullptr;
+  IntCounter* evictions_ = nullptr;
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+} // namespace impala
@@ -166,6 +166,12 @@ class ScalarExpr : public Expr {
   /// Returns true if this is a literal expression. Overridden by Literal.
   virtual bool IsLiteral() const { return false; }
 
+  /// Returns true if this expression is a ScalarFnCall. Overridden by ScalarFnCall.
+  virtual bool IsScalarFnCall() const { return false; }
+
+  /// Returns true if this expression is a HiveUdfCall. Overridden by HiveUdfCall.
+  virtual bool IsHiveUdfCall() const { return false; }
+
   /// Returns true if this expr uses a FunctionContext to track its runtime state.
   /// Overridden by exprs which use FunctionContext.
   virtual bool HasFnCtx() const { return false; }
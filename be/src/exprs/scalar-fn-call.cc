@@ -458,6 +458,25 @@ void ScalarFnCall::EvaluateNonConstantChildren(
   }
 }
 
+UdfBatchFn ScalarFnCall::GetBatchFn(ScalarExprEvaluator* eval) const {
+  if (vararg_start_idx_ != -1) return nullptr;
+  return eval->fn_context(fn_ctx_idx_)->impl()->batch_fn();
+}
+
+void ScalarFnCall::EvaluateBatchArgs(ScalarExprEvaluator* eval, const TupleRow* row,
+    int i, BatchValBuffer* args) const {
+  for (int child_idx = 0; child_idx < children_.size(); ++child_idx) {
+    args[child_idx].Set(i, eval->GetValue(*children_[child_idx], row));
+  }
+}
+
+void ScalarFnCall::CallBatchFn(ScalarExprEvaluator* eval, UdfBatchFn batch_fn,
+    int num_rows, const BatchVal* args, BatchValBuffer* result) const {
+  DCHECK_LE(num_rows, result->capacity());
+  result->ClearNulls();
+  batch_fn(eval->fn_context(fn_ctx_idx_), num_rows, args, result->mutable_val());
+}
+
 template<typename RETURN_TYPE>
 RETURN_TYPE ScalarFnCall::InterpretEval(ScalarExprEvaluator* eval,
     const TupleRow* row) const {
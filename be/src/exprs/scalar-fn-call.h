@@ -40,6 +40,7 @@ using impala_udf::StringVal;
 using impala_udf::DecimalVal;
 using impala_udf::DateVal;
 
+class BatchValBuffer;
 class ScalarExprEvaluator;
 class TExprNode;
 
@@ -70,6 +71,22 @@ class ScalarFnCall : public ScalarExpr {
   virtual Status GetCodegendComputeFnImpl(LlvmCodeGen* codegen, llvm::Function** fn)
       override WARN_UNUSED_RESULT;
   virtual std::string DebugString() const override;
+  virtual bool IsScalarFnCall() const override { return true; }
+
+  /// Returns the batch entry point that the function registered from its prepare
+  /// function when 'eval' was opened, or nullptr if there is none.
+  impala_udf::UdfBatchFn GetBatchFn(ScalarExprEvaluator* eval) const;
+
+  /// Evaluates the children for 'row' and stores their values as the values with index
+  /// 'i' of 'args', which has one buffer per child.
+  void EvaluateBatchArgs(ScalarExprEvaluator* eval, const TupleRow* row, int i,
+      BatchValBuffer* args) const;
+
+  /// Calls the batch entry point 'batch_fn' of this function for the first 'num_rows'
+  /// values of 'args', which has one BatchVal per child, and writes the results to
+  /// 'result'.
+  void CallBatchFn(ScalarExprEvaluator* eval, impala_udf::UdfBatchFn batch_fn,
+      int num_rows, const impala_udf::BatchVal* args, BatchValBuffer* result) const;
 
  protected:
   friend class ScalarExpr;
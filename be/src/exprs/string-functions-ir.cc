@@ -26,11 +26,13 @@
 #include <boost/static_assert.hpp>
 
 #include "exprs/anyval-util.h"
+#include "exprs/regex-cache.h"
 #include "exprs/scalar-expr.h"
 #include "gutil/strings/charset.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/string-value.inline.h"
 #include "runtime/tuple-row.h"
+#include "util/ascii-util.h"
 #include "util/bit-util.h"
 #include "util/coding-util.h"
 #include "util/pretty-printer.h"
@@ -84,6 +86,20 @@ StringVal StringFunctions::Utf8Substring(FunctionContext* context, const StringV
     const BigIntVal& pos, const BigIntVal& len) {
   if (str.is_null || pos.is_null || len.is_null) return StringVal::null();
   if (str.len == 0 || pos.val == 0 || len.val <= 0) return StringVal();
+  // There are at most as many characters as bytes.
+  if (pos.val > str.len || -pos.val > str.len) return StringVal();
+
+  // If the bytes that the UTF-8 scans below would look at are ASCII, then characters
+  // are bytes. The scan from the start also looks at the byte after the substring.
+  const int64_t ascii_begin = pos.val > 0 ? 0 : str.len + pos.val;
+  const int64_t ascii_end = pos.val > 0 ?
+      std::min<int64_t>(str.len, pos.val + std::min<int64_t>(len.val, str.len)) :
+      str.len;
+  if (AsciiUtil::IsAscii(str.ptr + ascii_begin, ascii_end - ascii_begin)) {
+    const int64_t byte_start = pos.val > 0 ? pos.val - 1 : str.len + pos.val;
+    return StringVal(str.ptr + byte_start,
+        std::min<int64_t>(len.val, str.len - byte_start));
+  }
 
   int byte_pos;
   int utf8_cnt = 0;
@@ -267,20 +283,14 @@ IntVal StringFunctions::CharLength(FunctionContext* context, const StringVal& st
 
 IntVal StringFunctions::Utf8Length(FunctionContext* context, const StringVal& str) {
   if (str.is_null) return IntVal::null();
-  int len = 0;
-  for (int i = 0; i < str.len; ++i) {
-    if (BitUtil::IsUtf8StartByte(str.ptr[i])) ++len;
-  }
-  return IntVal(len);
+  return IntVal(AsciiUtil::CountUtf8Chars(str.ptr, str.len));
 }
 
 StringVal StringFunctions::Lower(FunctionContext* context, const StringVal& str) {
   if (str.is_null) return StringVal::null();
   StringVal result(context, str.len);
   if (UNLIKELY(result.is_null)) return StringVal::null();
-  for (int i = 0; i < str.len; ++i) {
-    result.ptr[i] = ::tolower(str.ptr[i]);
-  }
+  AsciiUtil::ToLower(str.ptr, str.len, result.ptr);
   return result;
 }
 
@@ -288,9 +298,7 @@ StringVal StringFunctions::Upper(FunctionContext* context, const StringVal& str)
   if (str.is_null) return StringVal::null();
   StringVal result(context, str.len);
   if (UNLIKELY(result.is_null)) return StringVal::null();
-  for (int i = 0; i < str.len; ++i) {
-    result.ptr[i] = ::toupper(str.ptr[i]);
-  }
+  AsciiUtil::ToUpper(str.ptr, str.len, result.ptr);
   return result;
 }
 
@@ -592,6 +600,16 @@ StringVal StringFunctions::DoTrimString(FunctionContext* ctx,
       unique_chars->set(static_cast<int>(chars_to_trim.ptr[i]), true);
     }
   }
+  if (IS_IMPLICIT_WHITESPACE) {
+    // Only spaces are trimmed, which can be compared 16 bytes at a time.
+    int32_t begin = 0;
+    int32_t len = str.len;
+    if (D == LEADING || D == BOTH) begin = AsciiUtil::CountLeading(str.ptr, len, ' ');
+    if (D == TRAILING || D == BOTH) {
+      len -= AsciiUtil::CountTrailing(str.ptr + begin, len - begin, ' ');
+    }
+    return StringVal(str.ptr + begin, len - begin);
+  }
   // Find new starting position.
   int32_t begin = 0;
   int32_t end = str.len - 1;
@@ -734,11 +752,12 @@ IntVal StringFunctions::LocatePos(FunctionContext* context, const StringVal& sub
   }
 }
 
-// The caller owns the returned regex. Returns NULL if the pattern could not be compiled.
-re2::RE2* CompileRegex(const StringVal& pattern, string* error_str,
-    const StringVal& match_parameter) {
+// Returns nullptr if the pattern could not be compiled. Constant patterns are compiled
+// through the RegexCache, which shares the regex with other function instances.
+static shared_ptr<const re2::RE2> CompileRegex(const StringVal& pattern,
+    string* error_str, const StringVal& match_parameter, bool use_cache) {
   DCHECK(error_str != NULL);
-  re2::StringPiece pattern_sp(reinterpret_cast<char*>(pattern.ptr), pattern.len);
+  string pattern_str(reinterpret_cast<char*>(pattern.ptr), pattern.len);
   re2::RE2::Options options;
   // Disable error logging in case e.g. every row causes an error
   options.set_log_errors(false);
@@ -746,16 +765,17 @@ re2::RE2* CompileRegex(const StringVal& pattern, string* error_str,
   options.set_longest_match(true);
   if (!match_parameter.is_null &&
       !StringFunctions::SetRE2Options(match_parameter, error_str, &options)) {
-    return NULL;
+    return nullptr;
   }
-  re2::RE2* re = new re2::RE2(pattern_sp, options);
+  shared_ptr<const re2::RE2> re = use_cache ?
+      RegexCache::Compile(pattern_str, options) :
+      make_shared<re2::RE2>(pattern_str, options);
   if (!re->ok()) {
     stringstream ss;
     ss << "Could not compile regexp pattern: " << AnyValUtil::ToString(pattern) << endl
        << "Error: " << re->error();
     *error_str = ss.str();
-    delete re;
-    return NULL;
+    return nullptr;
   }
   return re;
 }
@@ -799,22 +819,35 @@ void StringFunctions::RegexpPrepare(
   if (pattern->is_null) return;
 
   string error_str;
-  re2::RE2* re = CompileRegex(*pattern, &error_str, StringVal::null());
-  if (re == NULL) {
+  shared_ptr<const re2::RE2> re =
+      CompileRegex(*pattern, &error_str, StringVal::null(), true);
+  if (re == nullptr) {
     context->SetError(error_str.c_str());
     return;
   }
-  context->SetFunctionState(scope, re);
+  context->SetFunctionState(scope, new shared_ptr<const re2::RE2>(move(re)));
 }
 
 void StringFunctions::RegexpClose(
     FunctionContext* context, FunctionContext::FunctionStateScope scope) {
   if (scope != FunctionContext::THREAD_LOCAL) return;
-  re2::RE2* re = reinterpret_cast<re2::RE2*>(context->GetFunctionState(scope));
-  delete re;
+  delete reinterpret_cast<shared_ptr<const re2::RE2>*>(context->GetFunctionState(scope));
   context->SetFunctionState(scope, nullptr);
 }
 
+// Returns the regex that was compiled in the prepare function, or compiles 'pattern'
+// into 'local_re' if it is not constant. Returns nullptr if 'pattern' cannot be
+// compiled.
+static const re2::RE2* GetRegex(FunctionContext* context, const StringVal& pattern,
+    const StringVal& match_parameter, shared_ptr<const re2::RE2>* local_re,
+    string* error_str) {
+  shared_ptr<const re2::RE2>* state = reinterpret_cast<shared_ptr<const re2::RE2>*>(
+      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  if (state != nullptr) return state->get();
+  *local_re = CompileRegex(pattern, error_str, match_parameter, false);
+  return local_re->get();
+}
+
 StringVal StringFunctions::RegexpEscape(FunctionContext* context, const StringVal& str) {
   if (str.is_null) return StringVal::null();
   if (str.len == 0) return str;
@@ -842,18 +875,14 @@ StringVal StringFunctions::RegexpExtract(FunctionContext* context, const StringV
   if (str.is_null || pattern.is_null || index.is_null) return StringVal::null();
   if (index.val < 0) return StringVal();
 
-  re2::RE2* re = reinterpret_cast<re2::RE2*>(
-      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
-  scoped_ptr<re2::RE2> scoped_re; // destroys re if we have to locally compile it
-  if (re == NULL) {
+  shared_ptr<const re2::RE2> local_re;
+  string error_str;
+  const re2::RE2* re =
+      GetRegex(context, pattern, StringVal::null(), &local_re, &error_str);
+  if (re == nullptr) {
     DCHECK(!context->IsArgConstant(1));
-    string error_str;
-    re = CompileRegex(pattern, &error_str, StringVal::null());
-    if (re == NULL) {
-      context->AddWarning(error_str.c_str());
-      return StringVal::null();
-    }
-    scoped_re.reset(re);
+    context->AddWarning(error_str.c_str());
+    return StringVal::null();
   }
 
   re2::StringPiece str_sp(reinterpret_cast<char*>(str.ptr), str.len);
@@ -874,18 +903,14 @@ StringVal StringFunctions::RegexpReplace(FunctionContext* context, const StringV
     const StringVal& pattern, const StringVal& replace) {
   if (str.is_null || pattern.is_null || replace.is_null) return StringVal::null();
 
-  re2::RE2* re = reinterpret_cast<re2::RE2*>(
-      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
-  scoped_ptr<re2::RE2> scoped_re; // destroys re if state->re is NULL
-  if (re == NULL) {
+  shared_ptr<const re2::RE2> local_re;
+  string error_str;
+  const re2::RE2* re =
+      GetRegex(context, pattern, StringVal::null(), &local_re, &error_str);
+  if (re == nullptr) {
     DCHECK(!context->IsArgConstant(1));
-    string error_str;
-    re = CompileRegex(pattern, &error_str, StringVal::null());
-    if (re == NULL) {
-      context->AddWarning(error_str.c_str());
-      return StringVal::null();
-    }
-    scoped_re.reset(re);
+    context->AddWarning(error_str.c_str());
+    return StringVal::null();
   }
 
   re2::StringPiece replace_str =
@@ -912,13 +937,13 @@ void StringFunctions::RegexpMatchCountPrepare(FunctionContext* context,
     match_parameter = reinterpret_cast<StringVal*>(context->GetConstantArg(3));
   }
   string error_str;
-  re2::RE2* re = CompileRegex(*pattern, &error_str, match_parameter == NULL ?
-      StringVal::null() : *match_parameter);
-  if (re == NULL) {
+  shared_ptr<const re2::RE2> re = CompileRegex(*pattern, &error_str,
+      match_parameter == NULL ? StringVal::null() : *match_parameter, true);
+  if (re == nullptr) {
     context->SetError(error_str.c_str());
     return;
   }
-  context->SetFunctionState(scope, re);
+  context->SetFunctionState(scope, new shared_ptr<const re2::RE2>(move(re)));
 }
 
 IntVal StringFunctions::RegexpMatchCount2Args(FunctionContext* context,
@@ -943,20 +968,15 @@ IntVal StringFunctions::RegexpMatchCount4Args(FunctionContext* context,
     return IntVal::null();
   }
 
-  re2::RE2* re = reinterpret_cast<re2::RE2*>(
-      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
-  // Destroys re if we have to locally compile it.
-  scoped_ptr<re2::RE2> scoped_re;
-  if (re == NULL) {
+  shared_ptr<const re2::RE2> local_re;
+  string error_str;
+  const re2::RE2* re =
+      GetRegex(context, pattern, match_parameter, &local_re, &error_str);
+  if (re == nullptr) {
     DCHECK(!context->IsArgConstant(1) || (context->GetNumArgs() == 4 &&
         !context->IsArgConstant(3)));
-    string error_str;
-    re = CompileRegex(pattern, &error_str, match_parameter);
-    if (re == NULL) {
-      context->SetError(error_str.c_str());
-      return IntVal::null();
-    }
-    scoped_re.reset(re);
+    context->SetError(error_str.c_str());
+    return IntVal::null();
   }
 
   DCHECK_GE(str.len, offset);
@@ -199,11 +199,41 @@ static void ExtractValues(JsonUdfValue* queue, JsonUdfAllocator* allocator) {
   queue->Erase(queue->Begin(), queue->Begin() + old_items);
 }
 
+/// One step of a compiled json path.
+struct JsonPathStep {
+  enum Kind {
+    /// Selects the value of 'key' in objects.
+    KEY,
+    /// Selects the element at 'index' in arrays.
+    INDEX,
+    /// Selects all values of objects.
+    WILDCARD_KEY,
+    /// Selects all elements of arrays.
+    WILDCARD_INDEX
+  };
+
+  Kind kind;
+  string key;
+  int index = 0;
+};
+
+/// A json path compiled into the steps that select its values, so that a constant path
+/// is parsed once in GetJsonObjectPrepare() instead of for every row.
+struct JsonPath {
+  vector<JsonPathStep> steps;
+
+  /// True if the path ends in an open '[', in which case it selects nothing.
+  bool selects_nothing = false;
+
+  /// True if the path has at least one step and only KEY and INDEX steps, so that it
+  /// selects at most one value and ScanJsonPath() can find it.
+  bool is_simple = false;
+};
+
 /// Process wildcard(*) in value selection. path_idx is the index after the wildcard in
 /// path_str. Return next unprocessed index in path_str. Return -1 for errors.
 static int ProcessWildcardKey(FunctionContext* ctx, const StringVal& path_str,
-    int path_idx, JsonUdfValue* queue, JsonUdfAllocator* allocator) {
-  DCHECK(queue->IsArray());
+    int path_idx, JsonPath* json_path) {
   const uint8_t* path = path_str.ptr;
   while (path_idx < path_str.len) {
     if (path[path_idx] == '[' || path[path_idx] == '.') break;
@@ -216,14 +246,15 @@ static int ProcessWildcardKey(FunctionContext* ctx, const StringVal& path_str,
     }
     ++path_idx;
   }
-  RETURN_IF_OOM(ExtractValues(queue, allocator), -1);
+  json_path->steps.emplace_back();
+  json_path->steps.back().kind = JsonPathStep::WILDCARD_KEY;
   return path_idx;
 }
 
 /// Process wildcard(*) in array selection. path_idx is the index after the wildcard in
 /// path_str. Return next unprocessed index in path_str. Return -1 for errors.
 static int ProcessWildcardIndex(FunctionContext* ctx, const StringVal& path_str,
-    int path_idx, JsonUdfValue* queue, JsonUdfAllocator* allocator) {
+    int path_idx, JsonPath* json_path) {
   const uint8_t* path = path_str.ptr;
   while (path_idx < path_str.len && path[path_idx] != ']') {
     if (path[path_idx] != ' ') { // have something else illegal
@@ -241,14 +272,15 @@ static int ProcessWildcardIndex(FunctionContext* ctx, const StringVal& path_str,
     ctx->SetError(msg.c_str());
     return -1;
   }
-  RETURN_IF_OOM(ExpandArrays(queue, allocator), -1);
+  json_path->steps.emplace_back();
+  json_path->steps.back().kind = JsonPathStep::WILDCARD_INDEX;
   return path_idx + 1;  // path_idx points at ']'
 }
 
 /// Process number in array selection. path_idx points at the start of the number in
 /// path_str. Return next unprocessed index in path_str. Return -1 for errors.
 static int ProcessNumberIndex(FunctionContext* ctx, const StringVal& path_str,
-    int path_idx, JsonUdfValue* queue, JsonUdfAllocator* allocator) {
+    int path_idx, JsonPath* json_path) {
   const uint8_t* path = path_str.ptr;
   const char* number_start = reinterpret_cast<const char*>(path + path_idx);
   int i = path_idx;
@@ -275,36 +307,19 @@ static int ProcessNumberIndex(FunctionContext* ctx, const StringVal& path_str,
     ctx->SetError(msg.c_str());
     return -1;
   }
-  RETURN_IF_OOM(SelectByIndex(index, queue, allocator), -1);
+  json_path->steps.emplace_back();
+  json_path->steps.back().kind = JsonPathStep::INDEX;
+  json_path->steps.back().index = index;
   return i + 1;  // i points at ']'
 }
 
-/// Parse json_str into Document. Return false for errors.
-static bool ParseStringVal(FunctionContext* ctx, const StringVal& json_str,
-    JsonUdfDocument* doc) {
-  StringValStream stream(&json_str);
-  RETURN_IF_OOM(doc->ParseStream(stream), false);
-  if (doc->HasParseError()) {
-    string msg = Substitute("Failed to parse json at position $0 since: $1."
-        " Json string:\n$2", doc->GetErrorOffset(),
-        GetParseError_En(doc->GetParseError()), AnyValUtil::ToString(json_str));
-    ctx->AddWarning(msg.c_str());
-    return false;
-  }
-  return true;
-}
-
-// Initial capacity of the BFS queue used in GetJsonObjectImpl
-static const int INITIAL_QUEUE_CAPACITY = 64;
-
-/// TODO(IMPALA-7610): parse the JSON path and cache it so we don't need to parse it
-/// everytime
-StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
-    const StringVal& json_str, const StringVal& path_str) {
-  if (UNLIKELY(json_str.is_null || json_str.len == 0)) return StringVal::null();
+/// Compiles 'path_str' into 'json_path'. Sets an error in 'ctx' and returns false if
+/// 'path_str' is not a valid json path.
+static bool CompileJsonPath(FunctionContext* ctx, const StringVal& path_str,
+    JsonPath* json_path) {
   if (UNLIKELY(path_str.is_null || path_str.len == 0)) {
     ctx->SetError("Empty json path");
-    return StringVal::null();
+    return false;
   }
   int beg = 0;
   // Strip off preceding whitespace.
@@ -314,28 +329,18 @@ StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
     string msg = Substitute("Failed to parse json path '$0': Should start with '$$'",
         AnyValUtil::ToString(path_str));
     ctx->SetError(msg.c_str());
-    return StringVal::null();
+    return false;
   }
 
-  JsonUdfAllocator allocator(ctx);
-  JsonUdfDocument document(&allocator);
-  if (!ParseStringVal(ctx, json_str, &document)) return StringVal::null();
-
-  // BFS to extract selected values. We use array of RapidJson instead of std::vector to
-  // track its memory.
-  JsonUdfValue queue(kArrayType);
-  RETURN_NULL_IF_OOM(queue.Reserve(INITIAL_QUEUE_CAPACITY, allocator));
-  RETURN_NULL_IF_OOM(queue.PushBack(document, allocator));
   const uint8_t* path = path_str.ptr;
   const uint8_t* path_end = path + path_str.len;
   for (int i = beg + 1; i < path_str.len;) {
-    // Each round we extract new items into the queue. Old items will be removed.
     switch (path[i]) {
       case '$': {
         string msg = Substitute("Failed to parse json path '$0':"
             " $$ should only be placed at start", AnyValUtil::ToString(path_str));
         ctx->SetError(msg.c_str());
-        return StringVal::null();
+        return false;
       }
       case '.': {
         // Hive does not skip the heading and trailing whitespaces since it simply splits
@@ -346,11 +351,11 @@ StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
           string msg = Substitute("Failed to parse json path '$0': Found a trailing '.'",
               AnyValUtil::ToString(path_str));
           ctx->SetError(msg.c_str());
-          return StringVal::null();
+          return false;
         }
         if (path[i] == '*') {
-          i = ProcessWildcardKey(ctx, path_str, ++i, &queue, &allocator);
-          if (i < 0) return StringVal::null();
+          i = ProcessWildcardKey(ctx, path_str, ++i, json_path);
+          if (i < 0) return false;
           break;
         }
         const uint8_t* start = path + i;
@@ -361,11 +366,11 @@ StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
               "Failed to parse json path '$0': Expected key at position $1",
               AnyValUtil::ToString(path_str), i);
           ctx->SetError(msg.c_str());
-          return StringVal::null();
+          return false;
         }
-        // Convert to string to automatically null terminate.
-        string key = string(start, end);
-        RETURN_NULL_IF_OOM(SelectByKey(key, &queue, &allocator));
+        json_path->steps.emplace_back();
+        json_path->steps.back().kind = JsonPathStep::KEY;
+        json_path->steps.back().key.assign(start, end);
         i += (end - start);
         break;
       }
@@ -375,15 +380,18 @@ StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
         // https://dev.mysql.com/worklog/task/?id=9831 and
         // https://github.com/mysql/mysql-server/commit/9f4678a
         for (++i; i < path_str.len && path[i] == ' '; ++i);  // skip whitespaces
-        if (i == path_str.len) return StringVal::null();
+        if (i == path_str.len) {
+          json_path->selects_nothing = true;
+          break;
+        }
         if (path[i] == '*') {
-          i = ProcessWildcardIndex(ctx, path_str, ++i, &queue, &allocator);
-          if (i < 0) return StringVal::null();
+          i = ProcessWildcardIndex(ctx, path_str, ++i, json_path);
+          if (i < 0) return false;
           break;
         }
         // else it should be a number
-        i = ProcessNumberIndex(ctx, path_str, i, &queue, &allocator);
-        if (i < 0) return StringVal::null();
+        i = ProcessNumberIndex(ctx, path_str, i, json_path);
+        if (i < 0) return false;
         break;
       }
       case ' ':
@@ -394,11 +402,260 @@ StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
             "Failed to parse json path '$0': Unexpected char '$1' at position $2",
             AnyValUtil::ToString(path_str), static_cast<char>(path[i]), i);
         ctx->SetError(msg.c_str());
-        return StringVal::null();
+        return false;
       }
     }
   }
+  json_path->is_simple = !json_path->steps.empty();
+  for (const JsonPathStep& step : json_path->steps) {
+    if (step.kind != JsonPathStep::KEY && step.kind != JsonPathStep::INDEX) {
+      json_path->is_simple = false;
+    }
+  }
+  return true;
+}
+
+/// Parse json_str into Document. Return false for errors.
+static bool ParseStringVal(FunctionContext* ctx, const StringVal& json_str,
+    JsonUdfDocument* doc) {
+  StringValStream stream(&json_str);
+  RETURN_IF_OOM(doc->ParseStream(stream), false);
+  if (doc->HasParseError()) {
+    string msg = Substitute("Failed to parse json at position $0 since: $1."
+        " Json string:\n$2", doc->GetErrorOffset(),
+        GetParseError_En(doc->GetParseError()), AnyValUtil::ToString(json_str));
+    ctx->AddWarning(msg.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Initial capacity of the BFS queue used in SelectJsonValues()
+static const int INITIAL_QUEUE_CAPACITY = 64;
+
+/// Parses 'json_str' and returns the values that 'json_path' selects from it.
+static StringVal SelectJsonValues(FunctionContext* ctx, const StringVal& json_str,
+    const JsonPath& json_path) {
+  JsonUdfAllocator allocator(ctx);
+  JsonUdfDocument document(&allocator);
+  if (!ParseStringVal(ctx, json_str, &document)) return StringVal::null();
 
+  // BFS to extract selected values. We use array of RapidJson instead of std::vector to
+  // track its memory.
+  JsonUdfValue queue(kArrayType);
+  RETURN_NULL_IF_OOM(queue.Reserve(INITIAL_QUEUE_CAPACITY, allocator));
+  RETURN_NULL_IF_OOM(queue.PushBack(document, allocator));
+  for (const JsonPathStep& step : json_path.steps) {
+    // Each round we extract new items into the queue. Old items will be removed.
+    switch (step.kind) {
+      case JsonPathStep::KEY:
+        RETURN_NULL_IF_OOM(SelectByKey(step.key, &queue, &allocator));
+        break;
+      case JsonPathStep::INDEX:
+        RETURN_NULL_IF_OOM(SelectByIndex(step.index, &queue, &allocator));
+        break;
+      case JsonPathStep::WILDCARD_KEY:
+        RETURN_NULL_IF_OOM(ExtractValues(&queue, &allocator));
+        break;
+      case JsonPathStep::WILDCARD_INDEX:
+        RETURN_NULL_IF_OOM(ExpandArrays(&queue, &allocator));
+        break;
+    }
+  }
   return ToStringVal(ctx, queue, &allocator);
 }
+
+static inline const char* SkipJsonWhitespace(const char* p, const char* end) {
+  while (p != end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p;
+  return p;
+}
+
+/// Returns the end of the json value that starts at 'p', or nullptr if it is not
+/// terminated before 'end'. Only checks the structure that is needed to find the end.
+static const char* SkipJsonValue(const char* p, const char* end) {
+  if (p == end) return nullptr;
+  if (*p == '"') {
+    for (++p; p != end; ++p) {
+      if (*p == '\\') {
+        if (++p == end) return nullptr;
+      } else if (*p == '"') {
+        return p + 1;
+      }
+    }
+    return nullptr;
+  }
+  if (*p == '{' || *p == '[') {
+    int depth = 0;
+    for (; p != end; ++p) {
+      if (*p == '"') {
+        p = SkipJsonValue(p, end);
+        if (p == nullptr) return nullptr;
+        --p;
+      } else if (*p == '{' || *p == '[') {
+        ++depth;
+      } else if (*p == '}' || *p == ']') {
+        if (--depth == 0) return p + 1;
+      }
+    }
+    return nullptr;
+  }
+  const char* start = p;
+  while (p != end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n'
+      && *p != '\r' && *p != '\t') {
+    ++p;
+  }
+  return p == start ? nullptr : p;
+}
+
+/// Returns true if 'c' can start a json value.
+static inline bool IsJsonValueStart(char c) {
+  return c == '{' || c == '[' || c == '"' || c == '-' || (c >= '0' && c <= '9')
+      || c == 't' || c == 'f' || c == 'n';
+}
+
+enum class JsonScanResult { FOUND, NOT_FOUND, UNSUPPORTED };
+
+/// Finds the value that the simple 'json_path' selects in 'json_str' by scanning the
+/// text, without building a document for it. Skipped values are only checked for
+/// their structure and the scan stops at the end of the selected value, so text after
+/// it is not validated. Returns FOUND and sets 'value_begin' and 'value_end' to the
+/// selected value, or NOT_FOUND if the path selects nothing. Returns UNSUPPORTED if
+/// the text cannot be scanned, e.g. because it is malformed or a key has escapes, in
+/// which case the caller should parse it with RapidJSON.
+static JsonScanResult ScanJsonPath(const StringVal& json_str, const JsonPath& json_path,
+    const char** value_begin, const char** value_end) {
+  DCHECK(json_path.is_simple);
+  const char* p = reinterpret_cast<const char*>(json_str.ptr);
+  const char* end = p + json_str.len;
+  p = SkipJsonWhitespace(p, end);
+  for (const JsonPathStep& step : json_path.steps) {
+    if (p == end) return JsonScanResult::UNSUPPORTED;
+    const char open = step.kind == JsonPathStep::KEY ? '{' : '[';
+    const char close = step.kind == JsonPathStep::KEY ? '}' : ']';
+    if (*p != open) {
+      return IsJsonValueStart(*p) ? JsonScanResult::NOT_FOUND :
+                                    JsonScanResult::UNSUPPORTED;
+    }
+    p = SkipJsonWhitespace(p + 1, end);
+    if (p != end && *p == close) return JsonScanResult::NOT_FOUND;
+    for (int i = 0;; ++i) {
+      if (step.kind == JsonPathStep::KEY) {
+        if (p == end || *p != '"') return JsonScanResult::UNSUPPORTED;
+        const char* key = p + 1;
+        const char* key_end = static_cast<const char*>(memchr(key, '"', end - key));
+        if (key_end == nullptr || memchr(key, '\\', key_end - key) != nullptr) {
+          return JsonScanResult::UNSUPPORTED;
+        }
+        p = SkipJsonWhitespace(key_end + 1, end);
+        if (p == end || *p != ':') return JsonScanResult::UNSUPPORTED;
+        p = SkipJsonWhitespace(p + 1, end);
+        // Like RapidJSON, select the first member with the key.
+        if (static_cast<size_t>(key_end - key) == step.key.size()
+            && memcmp(key, step.key.data(), step.key.size()) == 0) {
+          break;
+        }
+      } else if (i == step.index) {
+        break;
+      }
+      p = SkipJsonValue(p, end);
+      if (p == nullptr) return JsonScanResult::UNSUPPORTED;
+      p = SkipJsonWhitespace(p, end);
+      if (p == end) return JsonScanResult::UNSUPPORTED;
+      if (*p == close) return JsonScanResult::NOT_FOUND;
+      if (*p != ',') return JsonScanResult::UNSUPPORTED;
+      p = SkipJsonWhitespace(p + 1, end);
+    }
+  }
+  if (p == end || !IsJsonValueStart(*p)) return JsonScanResult::UNSUPPORTED;
+  *value_begin = p;
+  *value_end = SkipJsonValue(p, end);
+  return *value_end == nullptr ? JsonScanResult::UNSUPPORTED : JsonScanResult::FOUND;
+}
+
+/// Returns the value in [begin, end) as ToStringVal() would return it if it is written
+/// the same way by RapidJSON: a string without escapes or control characters, a
+/// boolean, or an integer that fits into an int64_t. Sets 'done' to false otherwise.
+static StringVal CopyPlainJsonValue(FunctionContext* ctx, const char* begin,
+    const char* end, bool* done) {
+  const int len = end - begin;
+  *done = true;
+  if (*begin == '"') {
+    for (const char* p = begin + 1; p != end - 1; ++p) {
+      if (*p == '\\' || static_cast<unsigned char>(*p) < 0x20) {
+        *done = false;
+        return StringVal::null();
+      }
+    }
+    return StringVal::CopyFrom(ctx, reinterpret_cast<const uint8_t*>(begin + 1), len - 2);
+  }
+  if ((len == 4 && memcmp(begin, "true", 4) == 0)
+      || (len == 5 && memcmp(begin, "false", 5) == 0)) {
+    return StringVal::CopyFrom(ctx, reinterpret_cast<const uint8_t*>(begin), len);
+  }
+  const char* digits = *begin == '-' ? begin + 1 : begin;
+  // At most 18 digits always fit into an int64_t. "-0" is left to RapidJSON.
+  bool is_int = digits != end && end - digits <= 18
+      && (*digits != '0' || (end - digits == 1 && digits == begin));
+  for (const char* p = digits; is_int && p != end; ++p) is_int = *p >= '0' && *p <= '9';
+  if (is_int) {
+    return StringVal::CopyFrom(ctx, reinterpret_cast<const uint8_t*>(begin), len);
+  }
+  *done = false;
+  return StringVal::null();
+}
+
+void StringFunctions::GetJsonObjectPrepare(
+    FunctionContext* ctx, FunctionContext::FunctionStateScope scope) {
+  if (scope != FunctionContext::THREAD_LOCAL) return;
+  if (!ctx->IsArgConstant(1)) return;
+  StringVal* path_str = reinterpret_cast<StringVal*>(ctx->GetConstantArg(1));
+  if (path_str->is_null || path_str->len == 0) return;
+  JsonPath* json_path = new JsonPath();
+  if (!CompileJsonPath(ctx, *path_str, json_path)) {
+    delete json_path;
+    return;
+  }
+  ctx->SetFunctionState(scope, json_path);
+}
+
+void StringFunctions::GetJsonObjectClose(
+    FunctionContext* ctx, FunctionContext::FunctionStateScope scope) {
+  if (scope != FunctionContext::THREAD_LOCAL) return;
+  delete reinterpret_cast<JsonPath*>(ctx->GetFunctionState(scope));
+  ctx->SetFunctionState(scope, nullptr);
+}
+
+StringVal StringFunctions::GetJsonObjectImpl(FunctionContext* ctx,
+    const StringVal& json_str, const StringVal& path_str) {
+  if (UNLIKELY(json_str.is_null || json_str.len == 0)) return StringVal::null();
+  const JsonPath* json_path = reinterpret_cast<const JsonPath*>(
+      ctx->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  JsonPath local_path;
+  if (json_path == nullptr) {
+    if (!CompileJsonPath(ctx, path_str, &local_path)) return StringVal::null();
+    json_path = &local_path;
+  }
+  if (json_path->selects_nothing) return StringVal::null();
+  if (!json_path->is_simple) return SelectJsonValues(ctx, json_str, *json_path);
+
+  const char* value_begin;
+  const char* value_end;
+  switch (ScanJsonPath(json_str, *json_path, &value_begin, &value_end)) {
+    case JsonScanResult::NOT_FOUND:
+      return StringVal::null();
+    case JsonScanResult::UNSUPPORTED:
+      return SelectJsonValues(ctx, json_str, *json_path);
+    case JsonScanResult::FOUND:
+      break;
+  }
+  bool done;
+  StringVal result = CopyPlainJsonValue(ctx, value_begin, value_end, &done);
+  if (done) return result;
+  // Let RapidJSON parse and write the selected value, e.g. to normalize numbers and
+  // to unescape strings.
+  StringVal value(reinterpret_cast<uint8_t*>(const_cast<char*>(value_begin)),
+      value_end - value_begin);
+  const JsonPath root_path;
+  return SelectJsonValues(ctx, value, root_path);
+}
 }
@@ -154,6 +154,10 @@ class StringFunctions {
   static StringVal Base64Encode(FunctionContext* ctx, const StringVal& str);
   static StringVal Base64Decode(FunctionContext* ctx, const StringVal& str);
 
+  /// Compiles the json path if it is constant, so that GetJsonObject() does not parse
+  /// it for every row.
+  static void GetJsonObjectPrepare(FunctionContext*, FunctionContext::FunctionStateScope);
+  static void GetJsonObjectClose(FunctionContext*, FunctionContext::FunctionStateScope);
   static StringVal GetJsonObject(FunctionContext* ctx, const StringVal& json_str,
       const StringVal& path_str);
   /// Implementation of GetJsonObject, not cross-compiled since no significant benefits
@@ -25,6 +25,7 @@
 #include "runtime/string-value.inline.h"
 #include "runtime/timestamp-value.h"
 #include "runtime/timestamp-value.inline.h"
+#include "runtime/timezone-offset-cache.h"
 #include "udf/udf-internal.h"
 #include "udf/udf.h"
 
@@ -85,6 +86,60 @@ const map<string, int> TimestampFunctions::DAYNAME_MAP = {
     {"sat", 6}, {"saturday", 6},
 };
 
+namespace {
+/// Thread-local state of FromUtc() and ToUtc().
+struct TimezoneConversionState {
+  /// The timezone of a constant timezone argument. Null if the argument is not constant
+  /// or does not name a timezone.
+  const Timezone* constant_tz = nullptr;
+  /// UTC offsets of the last timezone that a timestamp was converted in.
+  TimezoneOffsetCache cache;
+};
+
+/// Returns the timezone named by 'tz_string_value' or null if there is none, and sets
+/// 'cache' to the offset cache to convert in it, or null if there is no state.
+const Timezone* FindTimezoneAndCache(FunctionContext* context,
+    const StringValue& tz_string_value, TimezoneOffsetCache** cache) {
+  TimezoneConversionState* state = reinterpret_cast<TimezoneConversionState*>(
+      context->GetFunctionState(FunctionContext::THREAD_LOCAL));
+  const Timezone* timezone = state != nullptr ? state->constant_tz : nullptr;
+  if (timezone == nullptr) {
+    timezone = TimezoneDatabase::FindTimezone(
+        string(tz_string_value.ptr, tz_string_value.len));
+  }
+  *cache = nullptr;
+  if (state != nullptr && timezone != nullptr) {
+    if (state->cache.timezone() != timezone) state->cache.Reset(timezone);
+    *cache = &state->cache;
+  }
+  return timezone;
+}
+}
+
+void TimestampFunctions::TimezoneConversionPrepare(FunctionContext* context,
+    FunctionContext::FunctionStateScope scope) {
+  if (scope != FunctionContext::THREAD_LOCAL) return;
+  TimezoneConversionState* state = new TimezoneConversionState();
+  if (context->IsArgConstant(1)) {
+    const StringVal* tz_string_val =
+        reinterpret_cast<StringVal*>(context->GetConstantArg(1));
+    if (tz_string_val != nullptr && !tz_string_val->is_null) {
+      state->constant_tz = TimezoneDatabase::FindTimezone(string(
+          reinterpret_cast<const char*>(tz_string_val->ptr), tz_string_val->len));
+    }
+  }
+  context->SetFunctionState(scope, state);
+}
+
+void TimestampFunctions::TimezoneConversionClose(FunctionContext* context,
+    FunctionContext::FunctionStateScope scope) {
+  if (scope != FunctionContext::THREAD_LOCAL) return;
+  TimezoneConversionState* state =
+      reinterpret_cast<TimezoneConversionState*>(context->GetFunctionState(scope));
+  delete state;
+  context->SetFunctionState(scope, nullptr);
+}
+
 TimestampVal TimestampFunctions::FromUtc(FunctionContext* context,
     const TimestampVal& ts_val, const StringVal& tz_string_val) {
   if (ts_val.is_null || tz_string_val.is_null) return TimestampVal::null();
@@ -92,8 +147,8 @@ TimestampVal TimestampFunctions::FromUtc(FunctionContext* context,
   if (UNLIKELY(!ts_value.HasDateAndTime())) return TimestampVal::null();
 
   const StringValue& tz_string_value = StringValue::FromStringVal(tz_string_val);
-  const Timezone* timezone = TimezoneDatabase::FindTimezone(
-      string(tz_string_value.ptr, tz_string_value.len));
+  TimezoneOffsetCache* cache;
+  const Timezone* timezone = FindTimezoneAndCache(context, tz_string_value, &cache);
   if (UNLIKELY(timezone == nullptr)) {
     // Although this is an error, Hive ignores it. We will issue a warning but otherwise
     // ignore the error too.
@@ -104,7 +159,11 @@ TimestampVal TimestampFunctions::FromUtc(FunctionContext* context,
   }
 
   TimestampValue ts_value_ret = ts_value;
-  ts_value_ret.UtcToLocal(*timezone);
+  if (LIKELY(cache != nullptr)) {
+    ts_value_ret.UtcToLocal(cache);
+  } else {
+    ts_value_ret.UtcToLocal(*timezone);
+  }
   if (UNLIKELY(!ts_value_ret.HasDateAndTime())) {
     const string msg = Substitute(
         "Timestamp '$0' did not convert to a valid local time in timezone '$1'",
@@ -125,8 +184,8 @@ TimestampVal TimestampFunctions::ToUtc(FunctionContext* context,
   if (!ts_value.HasDateAndTime()) return TimestampVal::null();
 
   const StringValue& tz_string_value = StringValue::FromStringVal(tz_string_val);
-  const Timezone* timezone = TimezoneDatabase::FindTimezone(
-      string(tz_string_value.ptr, tz_string_value.len));
+  TimezoneOffsetCache* cache;
+  const Timezone* timezone = FindTimezoneAndCache(context, tz_string_value, &cache);
   if (UNLIKELY(timezone == nullptr)) {
     // Although this is an error, Hive ignores it. We will issue a warning but otherwise
     // ignore the error too.
@@ -137,7 +196,11 @@ TimestampVal TimestampFunctions::ToUtc(FunctionContext* context,
   }
 
   TimestampValue ts_value_ret = ts_value;
-  ts_value_ret.LocalToUtc(*timezone);
+  if (LIKELY(cache != nullptr)) {
+    ts_value_ret.LocalToUtc(cache);
+  } else {
+    ts_value_ret.LocalToUtc(*timezone);
+  }
   if (UNLIKELY(!ts_value_ret.HasDateAndTime())) {
     const string& msg =
         Substitute("Timestamp '$0' in timezone '$1' could not be converted to UTC",
@@ -159,6 +159,13 @@ class TimestampFunctions {
   static TimestampVal ToUtc(FunctionContext* context,
       const TimestampVal& ts_val, const StringVal& tz_string_val);
 
+  /// Looks up a constant timezone once and sets up the thread-local cache of UTC offsets
+  /// that FromUtc() and ToUtc() use.
+  static void TimezoneConversionPrepare(FunctionContext* context,
+      FunctionContext::FunctionStateScope scope);
+  static void TimezoneConversionClose(FunctionContext* context,
+      FunctionContext::FunctionStateScope scope);
+
   /// Functions to extract parts of the timestamp, return integers.
   static IntVal Year(FunctionContext* context, const TimestampVal& ts_val);
   static IntVal Quarter(FunctionContext* context, const TimestampVal& ts_val);
@@ -38,6 +38,7 @@ CPU::CPU()
     has_sse42_(false),
     has_avx_(false),
     has_avx2_(false),
+    has_avx512f_(false),
     has_aesni_(false),
     has_non_stop_time_stamp_counter_(false),
     has_broken_neon_(false),
@@ -242,6 +243,9 @@ void CPU::Initialize() {
         (_xgetbv(0) & 6) == 6 /* XSAVE enabled by kernel */;
     has_aesni_ = (cpu_info[2] & 0x02000000) != 0;
     has_avx2_ = has_avx_ && (cpu_info7[1] & 0x00000020) != 0;
+    // AVX-512 additionally requires the kernel to save the opmask and ZMM registers.
+    has_avx512f_ = has_avx2_ && (cpu_info7[1] & 0x00010000) != 0 &&
+        (_xgetbv(0) & 0xe6) == 0xe6;
   }
 
   // Get the brand string of the cpu.
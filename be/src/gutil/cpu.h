@@ -46,6 +46,7 @@ class CPU {
   bool has_sse42() const { return has_sse42_; }
   bool has_avx() const { return has_avx_; }
   bool has_avx2() const { return has_avx2_; }
+  bool has_avx512f() const { return has_avx512f_; }
   bool has_aesni() const { return has_aesni_; }
   bool has_non_stop_time_stamp_counter() const {
     return has_non_stop_time_stamp_counter_;
@@ -78,6 +79,7 @@ class CPU {
   bool has_sse42_;
   bool has_avx_;
   bool has_avx2_;
+  bool has_avx512f_;
   bool has_aesni_;
   bool has_non_stop_time_stamp_counter_;
   bool has_broken_neon_;
@@ -53,6 +53,7 @@ namespace kudu {
 
 // Initialize the static member variables from BlockBloomFilter class.
 constexpr uint32_t BlockBloomFilter::kRehash[8] __attribute__((aligned(32)));
+constexpr int BlockBloomFilter::kFindBatchGroupSize;
 const base::CPU BlockBloomFilter::kCpu = base::CPU();
 // constexpr data member requires initialization in the class declaration.
 // Hence no duplicate initialization in the definition here.
@@ -262,6 +263,37 @@ bool BlockBloomFilter::Find(const uint32_t hash) const noexcept {
   return (this->*bucket_find_func_ptr_)(bucket_idx, hash);
 }
 
+void BlockBloomFilter::FindBatch(const uint32_t* hashes, int num_hashes,
+                                 bool* found) const noexcept {
+  if (always_false_) {
+    memset(found, 0, num_hashes * sizeof(bool));
+    return;
+  }
+  uint32_t bucket_idxs[kFindBatchGroupSize];
+  for (int start = 0; start < num_hashes; start += kFindBatchGroupSize) {
+    const int group_size = std::min(kFindBatchGroupSize, num_hashes - start);
+    for (int i = 0; i < group_size; ++i) {
+      bucket_idxs[i] = Rehash32to32(hashes[start + i]) & directory_mask_;
+      __builtin_prefetch(&directory_[bucket_idxs[i]]);
+    }
+#ifdef USE_AVX2
+    if (has_avx512()) {
+      BucketFindGroupAVX512(bucket_idxs, hashes + start, group_size, found + start);
+      continue;
+    }
+#endif
+    BucketFindGroup(bucket_idxs, hashes + start, group_size, found + start);
+  }
+}
+
+void BlockBloomFilter::BucketFindGroup(const uint32_t* bucket_idxs, const uint32_t* hashes,
+                                       int num_hashes, bool* found) const noexcept {
+  DCHECK(bucket_find_func_ptr_);
+  for (int i = 0; i < num_hashes; ++i) {
+    found[i] = (this->*bucket_find_func_ptr_)(bucket_idxs[i], hashes[i]);
+  }
+}
+
 void BlockBloomFilter::CopyToPB(BlockBloomFilterPB* bf_dst) const {
   bf_dst->mutable_bloom_data()->assign(reinterpret_cast<const char*>(directory_), directory_size());
   bf_dst->set_log_space_bytes(log_space_bytes());
@@ -326,6 +358,24 @@ void BlockBloomFilter::OrEqualArrayNoAVX2(size_t n, const uint8_t* __restrict__
   }
 }
 
+Status BlockBloomFilter::Fold(int log_space_bytes) {
+  const int log_num_buckets = log_space_bytes - kLogBucketByteSize;
+  if (log_num_buckets < 0 || log_num_buckets > log_num_buckets_) {
+    return Status::InvalidArgument(Substitute("Cannot fold a filter of $0 bytes to $1 bytes",
+        directory_size(), 1LL << log_space_bytes));
+  }
+  // The bucket of an element is the low bits of its rehashed hash, so the bucket of every
+  // element in the upper half moves to the same index in the lower half.
+  while (log_num_buckets_ > log_num_buckets) {
+    const size_t half_size = directory_size() / 2;
+    OrEqualArrayInternal(half_size, reinterpret_cast<const uint8*>(directory_) + half_size,
+                         reinterpret_cast<uint8*>(directory_));
+    --log_num_buckets_;
+    directory_mask_ = (1ULL << log_num_buckets_) - 1;
+  }
+  return Status::OK();
+}
+
 Status BlockBloomFilter::Or(const BlockBloomFilter& other) {
   // AlwaysTrueFilter is a special case implemented with a nullptr.
   // Hence Or'ing with an AlwaysTrueFilter will result in a Bloom filter that also
@@ -361,6 +411,10 @@ bool BlockBloomFilter::has_avx2() {
   return !FLAGS_disable_blockbloomfilter_avx2 && kCpu.has_avx2();
 }
 
+bool BlockBloomFilter::has_avx512() {
+  return has_avx2() && kCpu.has_avx512f();
+}
+
 shared_ptr<DefaultBlockBloomFilterBufferAllocator>
     DefaultBlockBloomFilterBufferAllocator::GetSingletonSharedPtr() {
   // Meyer's Singleton.
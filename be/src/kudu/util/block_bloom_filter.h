@@ -125,6 +125,11 @@ class BlockBloomFilter {
     return Find(HashUtil::ComputeHash32(key, hash_algorithm_, hash_seed_));
   }
 
+  // Finds the 'num_hashes' elements in 'hashes' in the BloomFilter and sets found[i] to
+  // Find(hashes[i]). The buckets of a group of elements are prefetched before they are
+  // probed, so that the cache misses of the probes of large filters overlap.
+  void FindBatch(const uint32_t* hashes, int num_hashes, bool* found) const noexcept;
+
   // As more distinct items are inserted into a BloomFilter, the false positive rate
   // rises. MaxNdv() returns the NDV (number of distinct values) at which a BloomFilter
   // constructed with (1 << log_space_bytes) bytes of space hits false positive
@@ -160,6 +165,13 @@ class BlockBloomFilter {
   // - Or'ing with kAlwaysTrueFilter is disallowed.
   Status Or(const BlockBloomFilter& other);
 
+  // Shrinks the filter to (1 << log_space_bytes) bytes by or'ing every bucket into the
+  // bucket that its index maps to in the smaller directory. Elements found before are
+  // still found, at a higher false positive rate. The buffer keeps its original size.
+  // 'log_space_bytes' must not be larger than log_space_bytes() and must be large
+  // enough for one bucket.
+  Status Fold(int log_space_bytes);
+
   // Computes out[i] |= in[i] for the arrays 'in' and 'out' of length 'n' bytes where 'n'
   // is multiple of 32-bytes.
   static Status OrEqualArray(size_t n, const uint8_t* __restrict__ in,
@@ -237,6 +249,14 @@ class BlockBloomFilter {
 
   bool BucketFind(uint32_t bucket_idx, uint32_t hash) const noexcept;
 
+  // Number of elements whose buckets FindBatch() prefetches at a time.
+  static constexpr int kFindBatchGroupSize = 32;
+
+  // Sets found[i] for the 'num_hashes' <= kFindBatchGroupSize elements in 'hashes' whose
+  // buckets are 'bucket_idxs', with 'bucket_find_func_ptr_'.
+  void BucketFindGroup(const uint32_t* bucket_idxs, const uint32_t* hashes,
+                       int num_hashes, bool* found) const noexcept;
+
   // Computes out[i] |= in[i] for the arrays 'in' and 'out' of length 'n' without using AVX2
   // operations.
   static void OrEqualArrayNoAVX2(size_t n, const uint8_t* __restrict__ in,
@@ -262,6 +282,11 @@ class BlockBloomFilter {
   // instructions. 'n' must be a multiple of 32.
   static void OrEqualArrayAVX2(size_t n, const uint8_t* __restrict__ in,
                                uint8_t* __restrict__ out) __attribute__((target("avx2")));
+
+  // Same as BucketFindGroup(), but tests two buckets at a time with AVX-512 instructions.
+  void BucketFindGroupAVX512(const uint32_t* bucket_idxs, const uint32_t* hashes,
+                             int num_hashes, bool* found) const noexcept
+      __attribute__((__target__("avx512f")));
 #endif
 
   // Function pointers initialized in the constructor to avoid run-time cost in hot-path
@@ -277,6 +302,9 @@ class BlockBloomFilter {
   // Detect at run-time whether CPU supports AVX2
   static bool has_avx2();
 
+  // Detect at run-time whether CPU supports AVX-512F. Implies has_avx2().
+  static bool has_avx512();
+
   // Some constants used in hashing. #defined for efficiency reasons.
 #define BLOOM_HASH_CONSTANTS                                             \
   0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, \
@@ -80,6 +80,39 @@ void BlockBloomFilter::InsertAvx2(const uint32_t hash) noexcept {
   BucketInsertAVX2(bucket_idx, hash);
 }
 
+// Same as MakeMask() for two hashes at a time: the lower 256 bits are the mask of 'hash0'
+// and the upper 256 bits are the mask of 'hash1'.
+static inline ATTRIBUTE_ALWAYS_INLINE __attribute__((__target__("avx512f"))) __m512i
+MakeMask2(const uint32_t hash0, const uint32_t hash1) {
+  const __m512i ones = _mm512_set1_epi32(1);
+  const __m512i rehash = _mm512_broadcast_i64x4(_mm256_setr_epi32(BLOOM_HASH_CONSTANTS));
+  __m512i hash_data = _mm512_inserti64x4(
+      _mm512_castsi256_si512(_mm256_set1_epi32(hash0)), _mm256_set1_epi32(hash1), 1);
+  hash_data = _mm512_mullo_epi32(rehash, hash_data);
+  hash_data = _mm512_srli_epi32(hash_data, 27);
+  return _mm512_sllv_epi32(ones, hash_data);
+}
+
+void BlockBloomFilter::BucketFindGroupAVX512(const uint32_t* bucket_idxs,
+                                             const uint32_t* hashes, int num_hashes,
+                                             bool* found) const noexcept {
+  const __m256i* const directory = reinterpret_cast<const __m256i*>(directory_);
+  int i = 0;
+  for (; i + 2 <= num_hashes; i += 2) {
+    const __m512i mask = MakeMask2(hashes[i], hashes[i + 1]);
+    const __m512i buckets = _mm512_inserti64x4(
+        _mm512_castsi256_si512(_mm256_load_si256(&directory[bucket_idxs[i]])),
+        _mm256_load_si256(&directory[bucket_idxs[i + 1]]), 1);
+    // A lane is set in 'missing' if 'mask' has a one in it where the bucket does not.
+    // The lower 8 lanes belong to the first bucket, the upper 8 lanes to the second.
+    const __mmask16 missing = _mm512_test_epi32_mask(mask, _mm512_andnot_si512(buckets, mask));
+    found[i] = (missing & 0xff) == 0;
+    found[i + 1] = (missing >> 8) == 0;
+  }
+  if (i < num_hashes) found[i] = BucketFindAVX2(bucket_idxs[i], hashes[i]);
+  _mm256_zeroupper();
+}
+
 void BlockBloomFilter::OrEqualArrayAVX2(size_t n, const uint8_t* __restrict__ in,
                                         uint8_t* __restrict__ out) {
   static constexpr size_t kAVXRegisterBytes = sizeof(__m256d);
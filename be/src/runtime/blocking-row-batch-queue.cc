@@ -16,6 +16,9 @@
 // under the License.
 
 #include "runtime/blocking-row-batch-queue.h"
+
+#include <gflags/gflags.h>
+
 #include "runtime/row-batch.h"
 #include "util/runtime-profile-counters.h"
 
@@ -23,20 +26,34 @@
 
 using namespace std;
 
+DEFINE_bool(use_lock_free_row_batch_queue, false, "(Advanced) If true, the row batch "
+    "queues of scan nodes use a lock-free ring buffer instead of a mutex-protected "
+    "queue. This reduces the contention between many scanner threads that add batches.");
+
 namespace impala {
 
 BlockingRowBatchQueue::BlockingRowBatchQueue(int max_batches, int64_t max_bytes,
     RuntimeProfile::Counter* get_batch_wait_timer,
-    RuntimeProfile::Counter* add_batch_wait_timer)
-  : batch_queue_(new BlockingQueue<std::unique_ptr<RowBatch>, RowBatchBytesFn>(
-        max_batches, max_bytes, get_batch_wait_timer, add_batch_wait_timer)) {}
+    RuntimeProfile::Counter* add_batch_wait_timer) {
+  if (FLAGS_use_lock_free_row_batch_queue) {
+    lock_free_batch_queue_.reset(
+        new LockFreeBlockingQueue<unique_ptr<RowBatch>, RowBatchBytesFn>(
+            max_batches, max_bytes, get_batch_wait_timer, add_batch_wait_timer));
+  } else {
+    batch_queue_.reset(new BlockingQueue<unique_ptr<RowBatch>, RowBatchBytesFn>(
+        max_batches, max_bytes, get_batch_wait_timer, add_batch_wait_timer));
+  }
+}
 
 BlockingRowBatchQueue::~BlockingRowBatchQueue() {
   DCHECK(cleanup_queue_.empty());
 }
 
 void BlockingRowBatchQueue::AddBatch(unique_ptr<RowBatch> batch) {
-  if (!batch_queue_->BlockingPut(move(batch))) {
+  bool added = lock_free_batch_queue_ != nullptr ?
+      lock_free_batch_queue_->BlockingPut(move(batch)) :
+      batch_queue_->BlockingPut(move(batch));
+  if (!added) {
     lock_guard<SpinLock> l(lock_);
     cleanup_queue_.push_back(move(batch));
   }
@@ -44,22 +61,34 @@ void BlockingRowBatchQueue::AddBatch(unique_ptr<RowBatch> batch) {
 
 bool BlockingRowBatchQueue::AddBatchWithTimeout(
     unique_ptr<RowBatch>&& batch, int64_t timeout_micros) {
+  if (lock_free_batch_queue_ != nullptr) {
+    return lock_free_batch_queue_->BlockingPutWithTimeout(
+        forward<unique_ptr<RowBatch>>(batch), timeout_micros);
+  }
   return batch_queue_->BlockingPutWithTimeout(
       forward<unique_ptr<RowBatch>>(batch), timeout_micros);
 }
 
 unique_ptr<RowBatch> BlockingRowBatchQueue::GetBatch() {
   unique_ptr<RowBatch> result;
-  if (batch_queue_->BlockingGet(&result)) return result;
+  bool got = lock_free_batch_queue_ != nullptr ?
+      lock_free_batch_queue_->BlockingGet(&result) :
+      batch_queue_->BlockingGet(&result);
+  if (got) return result;
   return unique_ptr<RowBatch>();
 }
 
 bool BlockingRowBatchQueue::IsFull() const {
+  if (lock_free_batch_queue_ != nullptr) return lock_free_batch_queue_->AtCapacity();
   return batch_queue_->AtCapacity();
 }
 
 void BlockingRowBatchQueue::Shutdown() {
-  batch_queue_->Shutdown();
+  if (lock_free_batch_queue_ != nullptr) {
+    lock_free_batch_queue_->Shutdown();
+  } else {
+    batch_queue_->Shutdown();
+  }
 }
 
 void BlockingRowBatchQueue::Cleanup() {
@@ -22,6 +22,7 @@
 
 #include "runtime/row-batch.h"
 #include "util/blocking-queue.h"
+#include "util/lock-free-blocking-queue.h"
 #include "util/spinlock.h"
 
 namespace impala {
@@ -53,6 +54,10 @@ struct RowBatchBytesFn {
 /// to be added to the queue. 'add_batch_wait_timer' tracks how long AddBatch spends
 /// blocking waiting for space to be available in the queue.
 ///
+/// With --use_lock_free_row_batch_queue the batches are stored in a
+/// LockFreeBlockingQueue instead of a BlockingQueue, which scales better with many
+/// producer threads.
+///
 /// All functions are thread safe.
 class BlockingRowBatchQueue {
  public:
@@ -108,7 +113,10 @@ class BlockingRowBatchQueue {
   /// batches in this queue.
   std::list<std::unique_ptr<RowBatch>> cleanup_queue_;
 
-  /// BlockingQueue that stores the RowBatches
-  BlockingQueue<std::unique_ptr<RowBatch>, RowBatchBytesFn>* batch_queue_;
+  /// Queue that stores the RowBatches. Exactly one of them is set.
+  std::unique_ptr<BlockingQueue<std::unique_ptr<RowBatch>, RowBatchBytesFn>>
+      batch_queue_;
+  std::unique_ptr<LockFreeBlockingQueue<std::unique_ptr<RowBatch>, RowBatchBytesFn>>
+      lock_free_batch_queue_;
 };
 }
@@ -50,6 +50,8 @@
 using kudu::FreeDeleter;
 using std::numeric_limits;
 
+DECLARE_bool(disk_spill_columnar_encoding);
+
 static const int BATCH_SIZE = 250;
 // Allow arbitrarily small pages in our test buffer pool.
 static const int MIN_PAGE_LEN = 1;
@@ -727,6 +729,31 @@ TEST_F(SimpleTupleStreamTest, UnpinPinVarlen) {
   TestUnpinPin(false, false);
 }
 
+// Test that spilled pages are read back correctly with the columnar encoding, both
+// when a stream is read after writing and when it is read while writing.
+TEST_F(SimpleTupleStreamTest, ManyBufferSpillColumnarEncoding) {
+  google::FlagSaver saver;
+  FLAGS_disk_spill_columnar_encoding = true;
+  int buffer_size = 128 * sizeof(int);
+  Init(10 * buffer_size);
+
+  TestValues<int>(1, int_desc_, false, true, buffer_size);
+  TestValues<int>(100, int_desc_, false, true, buffer_size);
+  TestValues<StringValue>(1, string_desc_, false, true, buffer_size);
+  TestValues<StringValue>(100, string_desc_, false, true, buffer_size);
+
+  TestIntValuesInterleaved(10, 5, true, buffer_size);
+  TestIntValuesInterleaved(100, 15, true, buffer_size);
+}
+
+// Test that encoded pages are decoded when an unpinned stream is pinned again.
+TEST_F(SimpleTupleStreamTest, UnpinPinColumnarEncoding) {
+  google::FlagSaver saver;
+  FLAGS_disk_spill_columnar_encoding = true;
+  TestUnpinPin(false, false);
+  TestUnpinPin(true, false);
+}
+
 void SimpleTupleStreamTest::TestTransferMemory(bool pin_stream, bool read_write) {
   // Use smaller buffers so that the explicit FLUSH_RESOURCES flag is required to
   // make the batch at capacity.
@@ -1667,6 +1694,17 @@ TEST_F(MultiTupleStreamTest, MultiTupleManyBufferSpill) {
   TestIntValuesInterleaved(100, 15, true, buffer_size);
 }
 
+TEST_F(MultiTupleStreamTest, MultiTupleManyBufferSpillColumnarEncoding) {
+  google::FlagSaver saver;
+  FLAGS_disk_spill_columnar_encoding = true;
+  int buffer_size = 128 * sizeof(int);
+  Init(10 * buffer_size);
+
+  TestValues<int>(100, int_desc_, false, true, buffer_size);
+  TestValues<StringValue>(100, string_desc_, false, true, buffer_size);
+  TestIntValuesInterleaved(100, 15, true, buffer_size);
+}
+
 // Test that we can allocate a row in the stream and copy in multiple tuples then
 // read it back from the stream.
 TEST_F(MultiTupleStreamTest, MultiTupleAddRowCustom) {
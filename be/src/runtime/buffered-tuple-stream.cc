@@ -22,6 +22,7 @@
 
 #include "runtime/bufferpool/reservation-tracker.h"
 #include "runtime/collection-value.h"
+#include "runtime/columnar-page-codec.h"
 #include "runtime/descriptors.h"
 #include "runtime/exec-env.h"
 #include "runtime/mem-tracker.h"
@@ -47,6 +48,12 @@
 using namespace impala;
 using namespace strings;
 
+DEFINE_bool(disk_spill_columnar_encoding, false, "(Advanced) If true, pages of "
+    "spilled tuple streams, e.g. of hash join and aggregation partitions, are "
+    "transposed into columns with frame-of-reference encoded integers before they "
+    "are written to scratch, which makes them compress better with "
+    "--disk_spill_compression_codec.");
+
 using BufferHandle = BufferPool::BufferHandle;
 using FlushMode = RowBatch::FlushMode;
 
@@ -96,6 +103,10 @@ BufferedTupleStream::BufferedTupleStream(RuntimeState* state,
       inlined_coll_slots_.push_back(make_pair(i, tuple_coll_slots));
     }
   }
+  if (FLAGS_disk_spill_columnar_encoding && !has_nullable_tuple_
+      && inlined_coll_slots_.empty() && desc_->GetRowSize() > 0) {
+    page_codec_.reset(new ColumnarPageCodec(*desc_, inlined_string_slots_));
+  }
 }
 
 void BufferedTupleStream::CheckConsistencyFull(const ReadIterator& read_it) const {
@@ -211,8 +222,9 @@ void BufferedTupleStream::Page::AttachBufferToBatch(
 }
 
 string BufferedTupleStream::Page::DebugString() const {
-  return Substitute("$0 num_rows=$1 retrieved_buffer=$2 attached_to_output_batch=$3",
-      handle.DebugString(), num_rows, retrieved_buffer.Load(), attached_to_output_batch);
+  return Substitute("$0 num_rows=$1 retrieved_buffer=$2 attached_to_output_batch=$3 "
+      "encoded_len=$4", handle.DebugString(), num_rows, retrieved_buffer.Load(),
+      attached_to_output_batch, encoded_len);
 }
 
 Status BufferedTupleStream::Init(const string& caller_label, bool pinned) {
@@ -312,6 +324,7 @@ void BufferedTupleStream::UnpinPageIfNeeded(Page* page, bool stream_pinned) {
   int new_pin_count = ExpectedPinCount(stream_pinned, page);
   if (new_pin_count != page->pin_count()) {
     DCHECK_EQ(new_pin_count, page->pin_count() - 1);
+    if (new_pin_count == 0) EncodePageIfPossible(page);
     buffer_pool_->Unpin(buffer_pool_client_, &page->handle);
     bytes_pinned_ -= page->len();
     DCHECK_GE(bytes_pinned_, 0);
@@ -320,6 +333,54 @@ void BufferedTupleStream::UnpinPageIfNeeded(Page* page, bool stream_pinned) {
   }
 }
 
+void BufferedTupleStream::EncodePageIfPossible(Page* page) {
+  if (page_codec_ == nullptr || page->len() != default_page_len_ || page->num_rows == 0
+      || page->encoded_len > 0 || page->rows_returned.Load()
+      || !page->retrieved_buffer.Load()) {
+    return;
+  }
+  // Only fails if the page is not in memory, which 'retrieved_buffer' rules out.
+  const BufferHandle* buffer;
+  Status status = page->GetBuffer(&buffer);
+  DCHECK(status.ok()) << status.GetDetail();
+  // The encoded rows are built in a temporary buffer that is only needed while copying.
+  const int64_t page_len = page->len();
+  MemTracker* tracker = state_->instance_mem_tracker();
+  if (!tracker->TryConsume(page_len)) return;
+  unique_ptr<uint8_t[]> encoded(new uint8_t[page_len]);
+  int64_t encoded_len =
+      page_codec_->Encode(buffer->data(), page->num_rows, encoded.get(), page_len);
+  if (encoded_len >= 0) {
+    memcpy(buffer->data(), encoded.get(), encoded_len);
+    // Clear the rest of the page, so that it compresses to almost nothing.
+    memset(buffer->data() + encoded_len, 0, page_len - encoded_len);
+    page->encoded_len = encoded_len;
+  }
+  encoded.reset();
+  tracker->Release(page_len);
+}
+
+Status BufferedTupleStream::DecodePageIfNeeded(Page* page) {
+  if (page->encoded_len == 0) return Status::OK();
+  DCHECK(page->is_pinned());
+  DCHECK(page_codec_ != nullptr);
+  const BufferHandle* buffer;
+  RETURN_IF_ERROR(page->GetBuffer(&buffer));
+  // Decoding must not fail because of memory, because the rows could not be read
+  // otherwise.
+  MemTracker* tracker = state_->instance_mem_tracker();
+  tracker->Consume(page->encoded_len);
+  unique_ptr<uint8_t[]> encoded(new uint8_t[page->encoded_len]);
+  memcpy(encoded.get(), buffer->data(), page->encoded_len);
+  Status status = page_codec_->Decode(
+      encoded.get(), page->encoded_len, page->num_rows, buffer->data(), buffer->len());
+  encoded.reset();
+  tracker->Release(page->encoded_len);
+  RETURN_IF_ERROR(status);
+  page->encoded_len = 0;
+  return Status::OK();
+}
+
 bool BufferedTupleStream::NeedWriteReservation() const {
   return NeedWriteReservation(pinned_);
 }
@@ -570,6 +631,7 @@ Status BufferedTupleStream::NextReadPage(ReadIterator* read_iter) {
   // deleting or unpinning the previous page and ensured that, if the page was larger,
   // that the reservation is available with the above check.
   RETURN_IF_ERROR(PinPageIfNeeded(&*read_iter->read_page_, pinned_));
+  RETURN_IF_ERROR(DecodePageIfNeeded(&*read_iter->read_page_));
   RETURN_IF_ERROR(read_iter->InitReadPtrs());
 
   // We may need to save reservation for the write page in the case when the write page
@@ -653,6 +715,7 @@ Status BufferedTupleStream::PrepareForReadInternal(
     // Check if we need to increment the pin count of the read page.
     RETURN_IF_ERROR(PinPageIfNeeded(&*read_iter->read_page_, pinned_));
     DCHECK(read_iter->read_page_->is_pinned());
+    RETURN_IF_ERROR(DecodePageIfNeeded(&*read_iter->read_page_));
     RETURN_IF_ERROR(read_iter->InitReadPtrs());
   }
   CHECK_CONSISTENCY_FULL(*read_iter);
@@ -698,6 +761,9 @@ Status BufferedTupleStream::PinStream(bool* pinned) {
   // If the page data was evicted from memory, the read I/O can happen in parallel
   // because we defer calling GetBuffer() until NextReadPage().
   for (Page& page : pages_) RETURN_IF_ERROR(PinPageIfNeeded(&page, true));
+  // Decode the pages now, since external read iterators of the pinned stream may read
+  // them concurrently. The reads of encoded pages were all started above.
+  for (Page& page : pages_) RETURN_IF_ERROR(DecodePageIfNeeded(&page));
 
   pinned_ = true;
   *pinned = true;
@@ -823,6 +889,9 @@ Status BufferedTupleStream::GetNextInternal(ReadIterator* RESTRICT read_iter,
   DCHECK(read_iter->read_page_->is_pinned()) << DebugString();
   DCHECK_GE(read_iter->read_page_rows_returned_, 0);
 
+  if (!read_iter->read_page_->rows_returned.Load()) {
+    read_iter->read_page_->rows_returned.Store(true);
+  }
   int rows_left_in_page = read_iter->GetRowsLeftInPage();
   int rows_to_fill = std::min(batch->capacity() - batch->num_rows(), rows_left_in_page);
   DCHECK_GE(rows_to_fill, 1);
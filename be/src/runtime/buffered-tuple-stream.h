@@ -18,6 +18,7 @@
 #ifndef IMPALA_RUNTIME_BUFFERED_TUPLE_STREAM_H
 #define IMPALA_RUNTIME_BUFFERED_TUPLE_STREAM_H
 
+#include <memory>
 #include <set>
 #include <vector>
 #include <boost/function.hpp>
@@ -29,6 +30,7 @@
 #include "common/status.h"
 #include "gutil/macros.h"
 #include "runtime/bufferpool/buffer-pool.h"
+#include "runtime/columnar-page-codec.h"
 #include "runtime/row-batch.h"
 
 namespace impala {
@@ -128,6 +130,14 @@ class TupleRow;
 /// page's data may be relocated to a different buffer. The pointers are updated lazily
 /// upon reading the stream via GetNext().
 ///
+/// Columnar spill encoding:
+/// If --disk_spill_columnar_encoding is true, default-length pages of an unpinned stream
+/// are transposed into columns with ColumnarPageCodec in place when they are unpinned,
+/// so that the page written to scratch compresses better. Only pages that no row has
+/// been read from are encoded, since returned rows may still reference the page. The
+/// row layout is restored when the page is pinned again. Streams with nullable tuples
+/// or inlined collections are not encoded.
+///
 /// Example layout for a row with two non-nullable tuples ((1, "hello"), (2, "world"))
 /// with all var len data stored in the stream:
 ///  <---- tuple 1 -----> <------ tuple 2 ------> <- var len -> <- next row ...
@@ -430,7 +440,9 @@ class BufferedTupleStream {
       : handle(std::move(src.handle)),
         num_rows(src.num_rows),
         retrieved_buffer(src.retrieved_buffer.Load()),
-        attached_to_output_batch(src.attached_to_output_batch) {}
+        attached_to_output_batch(src.attached_to_output_batch),
+        rows_returned(src.rows_returned.Load()),
+        encoded_len(src.encoded_len) {}
 
     inline int len() const { return handle.len(); }
     inline bool is_pinned() const { return handle.is_pinned(); }
@@ -462,6 +474,15 @@ class BufferedTupleStream {
     /// If the page was just attached to the output batch on the last GetNext() call while
     /// in attach_on_read mode. If true, then 'handle' is closed.
     bool attached_to_output_batch = false;
+
+    /// Whether GetNext() returned rows from this page with any iterator. Such pages are
+    /// not encoded when they are unpinned. This is atomic because multiple iterators may
+    /// set it concurrently.
+    AtomicBool rows_returned{false};
+
+    /// The length of the page's data if it holds rows encoded with 'page_codec_', or 0
+    /// if it holds rows in the normal layout.
+    int64_t encoded_len = 0;
   };
 
  public:
@@ -661,6 +682,10 @@ class BufferedTupleStream {
   /// Whether any tuple in the rows is nullable.
   const bool has_nullable_tuple_;
 
+  /// Encodes unpinned pages if --disk_spill_columnar_encoding is true and the stream's
+  /// rows are supported. NULL otherwise.
+  std::unique_ptr<ColumnarPageCodec> page_codec_;
+
   bool closed_ = false; // Used for debugging.
 
   /// If true, this stream has been explicitly pinned by the caller and all pages are
@@ -758,6 +783,16 @@ class BufferedTupleStream {
   /// Pins page and updates tracking stats.
   Status PinPage(Page* page);
 
+  /// Encodes the rows of 'page' in place with 'page_codec_' if it has a codec, the page
+  /// is a default-length page in memory and no rows were read from it. Called before the
+  /// page is unpinned. Leaves the page as it is if the encoded rows do not fit or the
+  /// memory for encoding cannot be allocated.
+  void EncodePageIfPossible(Page* page);
+
+  /// Restores the normal row layout of 'page' if it was encoded. 'page' must be pinned.
+  /// Blocks until the page's data is in memory.
+  Status DecodePageIfNeeded(Page* page) WARN_UNUSED_RESULT;
+
   /// Increment the page's pin count if this page needs a higher pin count given the
   /// current read and write iterator positions and whether the stream will be pinned
   /// ('stream_pinned'). Assumes that no scenarios occur when the pin count needs to
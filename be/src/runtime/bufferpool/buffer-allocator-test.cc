@@ -15,8 +15,12 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
+#include <random>
 #include <vector>
 
+#include <boost/thread/thread.hpp>
+
 #include "common/object-pool.h"
 #include "runtime/bufferpool/buffer-allocator.h"
 #include "runtime/bufferpool/buffer-pool-internal.h"
@@ -160,6 +164,48 @@ TEST_F(BufferAllocatorTest, FreeListSizes) {
   ASSERT_EQ(0, GetFreeListSize(&allocator, CORE, TEST_BUFFER_LEN));
 }
 
+// Stress test for the free buffer caches: threads allocate and free buffers of different
+// sizes on all cores while using up the memory limit together, so that allocations need
+// to take buffers from other arenas or scavenge them.
+TEST_F(BufferAllocatorTest, ConcurrentAllocFree) {
+  const int NUM_THREADS = 8;
+  const int NUM_ITERS = 2000;
+  const int MAX_BUFFER_MULTIPLE = 4;
+  const int64_t THREAD_BYTES = 2 * MAX_BUFFER_MULTIPLE * TEST_BUFFER_LEN;
+  const int64_t TOTAL_BYTES = NUM_THREADS * THREAD_BYTES;
+  BufferAllocator allocator(
+      dummy_pool_, test_env_->metrics(), TEST_BUFFER_LEN, TOTAL_BYTES, TOTAL_BYTES);
+
+  thread_group workers;
+  for (int t = 0; t < NUM_THREADS; ++t) {
+    workers.add_thread(new thread([&allocator, this, t]() {
+      std::mt19937 rng(t);
+      vector<BufferHandle> buffers;
+      int64_t bytes_allocated = 0;
+      for (int i = 0; i < NUM_ITERS; ++i) {
+        const int64_t len = TEST_BUFFER_LEN << (rng() % 3);
+        // Free buffers until this thread stays within its share of the memory.
+        while (bytes_allocated + len > THREAD_BYTES) {
+          bytes_allocated -= buffers.back().len();
+          allocator.Free(move(buffers.back()));
+          buffers.pop_back();
+          std::shuffle(buffers.begin(), buffers.end(), rng);
+        }
+        buffers.emplace_back();
+        ASSERT_OK(allocator.Allocate(&dummy_client_, len, &buffers.back()));
+        memset(buffers.back().data(), t, len);
+        bytes_allocated += len;
+      }
+      for (BufferHandle& buffer : buffers) allocator.Free(move(buffer));
+    }));
+  }
+  workers.join_all();
+  EXPECT_EQ(allocator.GetFreeBufferBytes(), allocator.GetSystemBytesAllocated())
+      << allocator.DebugString();
+  allocator.ReleaseMemory(TOTAL_BYTES);
+  EXPECT_EQ(0, allocator.GetNumFreeBuffers());
+}
+
 class SystemAllocatorTest : public ::testing::Test {
  public:
   virtual void SetUp() {}
@@ -43,6 +43,14 @@ static constexpr int64_t ALLOC_STAT_SAMPLE_RATE = 64;
 // > 4GB are extremely rare so we don't need to collect precise stats on them.
 static constexpr int64_t STATS_MAX_BUFFER_SIZE = 4L * 1024L * 1024L * 1024L;
 
+// Number of free buffers of each size that an arena caches in front of its free list.
+// Buffers are added to and taken from the cache without acquiring the arena lock.
+static constexpr int FREE_BUFFER_CACHE_SLOTS = 8;
+
+// Value of a cache slot that does not accept buffers, because a thread that scavenges
+// memory holds the arena lock. See BufferAllocator::ScavengeBuffers().
+static uint8_t* const CLOSED_CACHE_SLOT = reinterpret_cast<uint8_t*>(1);
+
 /// Decrease 'bytes_remaining' by up to 'max_decrease', down to a minimum of 0.
 /// If 'require_full_decrease' is true, only decrease if we can decrease it
 /// 'max_decrease'. Returns the amount it was decreased by.
@@ -53,8 +61,8 @@ static int64_t DecreaseBytesRemaining(
 /// particular core. All public methods are thread-safe.
 class BufferPool::FreeBufferArena : public CacheLineAligned {
  public:
-  FreeBufferArena(
-      BufferAllocator* parent, MetricGroup* metrics, const std::string& arena_name);
+  FreeBufferArena(BufferAllocator* parent, int core, MetricGroup* metrics,
+      const std::string& arena_name);
 
   // Destructor should only run in backend tests.
   ~FreeBufferArena();
@@ -79,10 +87,16 @@ class BufferPool::FreeBufferArena : public CacheLineAligned {
   /// number of bytes freed and the actual number of bytes claimed.
   ///
   /// Caller should not hold 'lock_'. If 'arena_lock' is non-null, ownership of the
-  /// arena lock is transferred to the caller.
+  /// arena lock is transferred to the caller. The free buffer caches of the arena do not
+  /// accept buffers until the caller calls ReopenFreeBufferCaches(), so that all free
+  /// buffers added to the arena go through the lock.
   pair<int64_t, int64_t> FreeSystemMemory(int64_t target_bytes_to_free,
       int64_t target_bytes_to_claim, std::unique_lock<SpinLock>* arena_lock);
 
+  /// Lets the free buffer caches accept buffers again after FreeSystemMemory() returned
+  /// 'arena_lock' to the caller. 'arena_lock' must still be held.
+  void ReopenFreeBufferCaches(const std::unique_lock<SpinLock>& arena_lock);
+
   /// Add a clean page to the arena. Caller must hold the page's client's lock and not
   /// hold 'lock_' or any Page::lock_.
   void AddCleanPage(Page* page);
@@ -132,6 +146,16 @@ class BufferPool::FreeBufferArena : public CacheLineAligned {
   struct PerSizeLists {
     PerSizeLists() : num_free_buffers(0), low_water_mark(0), num_clean_pages(0) {}
 
+    /// Returns the number of buffers in 'cached_buffers'. May be approximate.
+    int64_t NumCachedBuffers() const {
+      int64_t num_cached = 0;
+      for (const AtomicPtr<uint8_t>& slot : cached_buffers) {
+        uint8_t* data = slot.Load();
+        if (data != nullptr && data != CLOSED_CACHE_SLOT) ++num_cached;
+      }
+      return num_cached;
+    }
+
     /// Helper to add a free buffer and increment the counter.
     /// FreeBufferArena::lock_ must be held by the caller.
     void AddFreeBuffer(BufferHandle&& buffer) {
@@ -148,6 +172,14 @@ class BufferPool::FreeBufferArena : public CacheLineAligned {
     /// corresponding to this arena.
     FreeList free_buffers;
 
+    /// A small cache of free buffers in front of 'free_buffers', which is accessed
+    /// without holding FreeBufferArena::lock_. Each slot holds the start of a free,
+    /// poisoned buffer, nullptr if it is empty, or CLOSED_CACHE_SLOT. Buffers are only
+    /// moved between the slots and 'free_buffers' in batches when a slot is not
+    /// available, so most allocations and frees on a core take no lock. The buffers
+    /// are not counted in 'num_free_buffers' or 'low_water_mark'.
+    AtomicPtr<uint8_t> cached_buffers[FREE_BUFFER_CACHE_SLOTS];
+
     /// The minimum size of 'free_buffers' since the last Maintenance() call.
     int low_water_mark;
 
@@ -180,8 +212,28 @@ class BufferPool::FreeBufferArena : public CacheLineAligned {
   int64_t SumOverSizes(
       std::function<int64_t(PerSizeLists* lists, int64_t buffer_size)> compute_fn);
 
+  /// Tries to add 'buffer' to the cache of 'lists' without locking the arena. Returns
+  /// true and resets 'buffer' if it was added, or false if no slot was available.
+  bool AddCachedBuffer(PerSizeLists* lists, BufferHandle* buffer);
+
+  /// Tries to take a buffer of 'buffer_len' bytes from the cache of 'lists' without
+  /// locking the arena. Returns true and sets 'buffer' if one was found. The buffer is
+  /// still poisoned.
+  bool PopCachedBuffer(PerSizeLists* lists, int64_t buffer_len, BufferHandle* buffer);
+
+  /// Moves the cached buffers of 'lists' to 'lists->free_buffers'. If 'close' is true,
+  /// the slots do not accept buffers afterwards. 'lock_' must be held by the caller.
+  void FlushCachedBuffers(PerSizeLists* lists, bool close);
+
+  /// Calls FlushCachedBuffers() for all buffer sizes. 'lock_' must be held by the
+  /// caller.
+  void FlushAllCachedBuffers(bool close);
+
   BufferAllocator* const parent_;
 
+  /// The core that the buffers in this arena were allocated on.
+  const int core_;
+
   /// Protects all data structures in the arena. See buffer-pool-internal.h for lock
   /// order.
   SpinLock lock_;
@@ -248,7 +300,7 @@ BufferPool::BufferAllocator::BufferAllocator(BufferPool* pool, MetricGroup* metr
   MetricGroup* buffer_pool_metrics = metrics->GetOrCreateChildGroup("buffer-pool");
   for (int i = 0; i < per_core_arenas_.size(); ++i) {
     per_core_arenas_[i].reset(
-        new FreeBufferArena(this, buffer_pool_metrics, Substitute("arena-$0", i)));
+        new FreeBufferArena(this, i, buffer_pool_metrics, Substitute("arena-$0", i)));
   }
 }
 
@@ -323,12 +375,17 @@ Status BufferPool::BufferAllocator::AllocateInternal(
     }
 
     // Fast-ish path: evict a clean page of the right size from the current NUMA node.
-    for (int i = 0; i < numa_node_cores.size(); ++i) {
-      int other_core = numa_node_cores[(numa_node_core_idx + i) % numa_node_cores.size()];
-      FreeBufferArena* other_core_arena = per_core_arenas_[other_core].get();
-      if (other_core_arena->EvictCleanPage(len, buffer)) {
-        current_core_arena->clean_page_hits()->Increment(1);
-        return Status::OK();
+    {
+      SCOPED_TIMER(client->counters().clean_page_eviction_time);
+      for (int i = 0; i < numa_node_cores.size(); ++i) {
+        int other_core =
+            numa_node_cores[(numa_node_core_idx + i) % numa_node_cores.size()];
+        FreeBufferArena* other_core_arena = per_core_arenas_[other_core].get();
+        if (other_core_arena->EvictCleanPage(len, buffer)) {
+          current_core_arena->clean_page_hits()->Increment(1);
+          COUNTER_ADD(client->counters().num_clean_page_evictions, 1);
+          return Status::OK();
+        }
       }
     }
 
@@ -397,7 +454,9 @@ int64_t BufferPool::BufferAllocator::ScavengeBuffers(
   //    have had to return the equivalent amount of memory to an earlier arena or added
   //    it back into 'systems_bytes_reamining_'. The former can't happen since we're
   //    still holding those locks, and the latter is solved by trying to decrease
-  //    system_bytes_remaining_ with DecreaseBytesRemaining() at the end.
+  //    system_bytes_remaining_ with DecreaseBytesRemaining() at the end. The free buffer
+  //    caches of the arenas we hold locks for are closed, so that buffers can't be
+  //    returned to them without the lock either.
   DCHECK_GT(target_bytes, 0);
   // First make sure we've used up all the headroom in the buffer limit.
   int64_t bytes_found =
@@ -431,6 +490,13 @@ int64_t BufferPool::BufferAllocator::ScavengeBuffers(
         target_bytes - bytes_found, true, &system_bytes_remaining_);
     DCHECK_EQ(bytes_found, target_bytes) << DebugString();
   }
+  if (slow_but_sure) {
+    for (int i = 0; i < arena_locks.size(); ++i) {
+      if (arena_locks[i].owns_lock()) {
+        per_core_arenas_[i]->ReopenFreeBufferCaches(arena_locks[i]);
+      }
+    }
+  }
   return bytes_found;
 }
 
@@ -538,9 +604,10 @@ string BufferPool::BufferAllocator::DebugString() {
   return ss.str();
 }
 
-BufferPool::FreeBufferArena::FreeBufferArena(
-    BufferAllocator* parent, MetricGroup* metrics, const std::string& arena_name)
+BufferPool::FreeBufferArena::FreeBufferArena(BufferAllocator* parent, int core,
+    MetricGroup* metrics, const std::string& arena_name)
   : parent_(parent),
+    core_(core),
     system_alloc_time_(
         metrics->AddCounter("buffer-pool.$0.system-alloc-time", 0, arena_name)),
     local_arena_free_buffer_hits_(metrics->AddCounter(
@@ -560,7 +627,8 @@ BufferPool::FreeBufferArena::FreeBufferArena(
 
 BufferPool::FreeBufferArena::~FreeBufferArena() {
   for (int i = 0; i < NumBufferSizes(); ++i) {
-    // Clear out the free lists.
+    // Clear out the caches and free lists.
+    FlushCachedBuffers(&buffer_sizes_[i], false);
     FreeList* list = &buffer_sizes_[i].free_buffers;
     vector<BufferHandle> buffers = list->GetBuffersToFree(list->Size());
     parent_->system_bytes_remaining_.Add(parent_->FreeToSystem(move(buffers)));
@@ -571,11 +639,71 @@ BufferPool::FreeBufferArena::~FreeBufferArena() {
 }
 
 void BufferPool::FreeBufferArena::AddFreeBuffer(BufferHandle&& buffer) {
-  lock_guard<SpinLock> al(lock_);
   PerSizeLists* lists = GetListsForSize(buffer.len());
+  if (AddCachedBuffer(lists, &buffer)) return;
+  // The cache is full. Hand off all of its buffers to the free list while we hold the
+  // lock, so that the next frees can go to the cache again.
+  lock_guard<SpinLock> al(lock_);
+  FlushCachedBuffers(lists, false);
   lists->AddFreeBuffer(move(buffer));
 }
 
+bool BufferPool::FreeBufferArena::AddCachedBuffer(
+    PerSizeLists* lists, BufferHandle* buffer) {
+  DCHECK_EQ(core_, buffer->home_core_);
+  uint8_t* data = buffer->data();
+  for (AtomicPtr<uint8_t>& slot : lists->cached_buffers) {
+    // Check before the compare-and-swap to avoid contending for full slots.
+    if (slot.Load() != nullptr) continue;
+    if (slot.CompareAndSwap(nullptr, data)) {
+      buffer->Reset();
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BufferPool::FreeBufferArena::PopCachedBuffer(
+    PerSizeLists* lists, int64_t buffer_len, BufferHandle* buffer) {
+  for (AtomicPtr<uint8_t>& slot : lists->cached_buffers) {
+    uint8_t* data = slot.Load();
+    if (data == nullptr || data == CLOSED_CACHE_SLOT) continue;
+    // The slot holds a free buffer as long as it holds 'data', even if other threads
+    // took and returned the buffer in the meantime.
+    if (slot.CompareAndSwap(data, nullptr)) {
+      buffer->Open(data, buffer_len, core_);
+      return true;
+    }
+  }
+  return false;
+}
+
+void BufferPool::FreeBufferArena::FlushCachedBuffers(PerSizeLists* lists, bool close) {
+  const int64_t buffer_len = 1L << (lists - buffer_sizes_ + parent_->log_min_buffer_len_);
+  for (AtomicPtr<uint8_t>& slot : lists->cached_buffers) {
+    uint8_t* data = slot.Swap(close ? CLOSED_CACHE_SLOT : nullptr);
+    if (data == nullptr || data == CLOSED_CACHE_SLOT) continue;
+    BufferHandle buffer;
+    buffer.Open(data, buffer_len, core_);
+    lists->AddFreeBuffer(move(buffer));
+  }
+}
+
+void BufferPool::FreeBufferArena::FlushAllCachedBuffers(bool close) {
+  for (int i = 0; i < NumBufferSizes(); ++i) FlushCachedBuffers(&buffer_sizes_[i], close);
+}
+
+void BufferPool::FreeBufferArena::ReopenFreeBufferCaches(
+    const std::unique_lock<SpinLock>& arena_lock) {
+  DCHECK(arena_lock.mutex() == &lock_ && arena_lock.owns_lock());
+  for (int i = 0; i < NumBufferSizes(); ++i) {
+    for (AtomicPtr<uint8_t>& slot : buffer_sizes_[i].cached_buffers) {
+      DCHECK(slot.Load() == CLOSED_CACHE_SLOT);
+      slot.Store(nullptr);
+    }
+  }
+}
+
 bool BufferPool::FreeBufferArena::RemoveCleanPage(bool claim_buffer, Page* page) {
   lock_guard<SpinLock> al(lock_);
   PerSizeLists* lists = GetListsForSize(page->len);
@@ -597,6 +725,10 @@ bool BufferPool::FreeBufferArena::RemoveCleanPage(bool claim_buffer, Page* page)
 bool BufferPool::FreeBufferArena::PopFreeBuffer(
     int64_t buffer_len, BufferHandle* buffer) {
   PerSizeLists* lists = GetListsForSize(buffer_len);
+  if (PopCachedBuffer(lists, buffer_len, buffer)) {
+    buffer->Unpoison();
+    return true;
+  }
   // Check before acquiring lock.
   if (lists->num_free_buffers.Load() == 0) return false;
 
@@ -605,7 +737,19 @@ bool BufferPool::FreeBufferArena::PopFreeBuffer(
   DCHECK_EQ(lists->num_free_buffers.Load(), list->Size());
   if (!list->PopFreeBuffer(buffer)) return false;
   buffer->Unpoison();
-  lists->num_free_buffers.Add(-1);
+  // Refill part of the cache while we hold the lock, so that the next allocations
+  // don't need it.
+  int64_t num_popped = 1;
+  BufferHandle cached_buffer;
+  while (num_popped <= FREE_BUFFER_CACHE_SLOTS / 2
+      && list->PopFreeBuffer(&cached_buffer)) {
+    if (!AddCachedBuffer(lists, &cached_buffer)) {
+      list->AddFreeBuffer(move(cached_buffer));
+      break;
+    }
+    ++num_popped;
+  }
+  lists->num_free_buffers.Add(-num_popped);
   lists->low_water_mark = min<int>(lists->low_water_mark, list->Size());
   return true;
 }
@@ -637,7 +781,10 @@ pair<int64_t, int64_t> BufferPool::FreeBufferArena::FreeSystemMemory(
   // Otherwise lazily acquire the lock the first time we find some memory
   // to free.
   std::unique_lock<SpinLock> al(lock_, std::defer_lock_t());
-  if (arena_lock != nullptr) al.lock();
+  if (arena_lock != nullptr) {
+    al.lock();
+    FlushAllCachedBuffers(true);
+  }
 
   vector<BufferHandle> buffers;
   // Search from largest to smallest to avoid freeing many small buffers unless
@@ -646,10 +793,12 @@ pair<int64_t, int64_t> BufferPool::FreeBufferArena::FreeSystemMemory(
     PerSizeLists* lists = &buffer_sizes_[i];
     // Check before acquiring lock to avoid expensive lock acquisition and make scanning
     // empty lists much cheaper.
-    if (lists->num_free_buffers.Load() == 0 && lists->num_clean_pages.Load() == 0) {
+    if (lists->num_free_buffers.Load() == 0 && lists->num_clean_pages.Load() == 0
+        && lists->NumCachedBuffers() == 0) {
       continue;
     }
     if (!al.owns_lock()) al.lock();
+    if (arena_lock == nullptr) FlushCachedBuffers(lists, false);
     FreeList* free_buffers = &lists->free_buffers;
     InternalList<Page>* clean_pages = &lists->clean_pages;
     DCHECK_EQ(lists->num_free_buffers.Load(), free_buffers->Size());
@@ -739,6 +888,9 @@ void BufferPool::FreeBufferArena::Maintenance() {
   lock_guard<SpinLock> al(lock_);
   for (int i = 0; i < NumBufferSizes(); ++i) {
     PerSizeLists* lists = &buffer_sizes_[i];
+    // Cached buffers go back to the free list, so that they are freed if they stay
+    // unused until the next call.
+    FlushCachedBuffers(lists, false);
     DCHECK_LE(lists->low_water_mark, lists->free_buffers.Size());
     if (lists->low_water_mark != 0) {
       // We haven't needed the buffers below the low water mark since the previous
@@ -756,6 +908,7 @@ void BufferPool::FreeBufferArena::Maintenance() {
 int BufferPool::FreeBufferArena::GetFreeListSize(int64_t len) {
   lock_guard<SpinLock> al(lock_);
   PerSizeLists* lists = GetListsForSize(len);
+  FlushCachedBuffers(lists, false);
   DCHECK_EQ(lists->num_free_buffers.Load(), lists->free_buffers.Size());
   return lists->free_buffers.Size();
 }
@@ -772,13 +925,13 @@ int64_t BufferPool::FreeBufferArena::SumOverSizes(
 
 int64_t BufferPool::FreeBufferArena::GetNumFreeBuffers() {
   return SumOverSizes([](PerSizeLists* lists, int64_t buffer_size) {
-    return lists->num_free_buffers.Load();
+    return lists->num_free_buffers.Load() + lists->NumCachedBuffers();
   });
 }
 
 int64_t BufferPool::FreeBufferArena::GetFreeBufferBytes() {
   return SumOverSizes([](PerSizeLists* lists, int64_t buffer_size) {
-    return lists->num_free_buffers.Load() * buffer_size;
+    return (lists->num_free_buffers.Load() + lists->NumCachedBuffers()) * buffer_size;
   });
 }
 
@@ -797,6 +950,7 @@ string BufferPool::FreeBufferArena::DebugString() {
     PerSizeLists& lists = buffer_sizes_[i];
     ss << "  " << PrettyPrinter::PrintBytes(buffer_len) << ":"
        << " free buffers: " << lists.num_free_buffers.Load()
+       << " cached buffers: " << lists.NumCachedBuffers()
        << " low water mark: " << lists.low_water_mark
        << " clean pages: " << lists.num_clean_pages.Load() << " ";
     lists.clean_pages.Iterate(bind<bool>(Page::DebugStringCallback, &ss, _1));
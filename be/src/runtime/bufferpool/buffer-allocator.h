@@ -78,6 +78,10 @@ namespace impala {
 /// pages of the same size: there is a separate list for every power-of-two size. Each
 /// arena is protected by a separate lock, so in the common case where threads are able
 /// to fulfill allocations from their own arena, there will be no lock contention.
+/// In front of each free buffer list, the arena caches a few free buffers in atomic
+/// slots, which are taken and returned without the lock. Buffers move between the
+/// cache and the locked list in batches, so most allocations and frees take no lock.
+/// Scavenging that locks an arena also closes its cache until it is done.
 ///
 class BufferPool::BufferAllocator {
  public:
@@ -34,6 +34,15 @@ struct BufferPoolClientCounters {
   /// Total amount of time spent compressing and decompressing data when spiling.
   RuntimeProfile::Counter* compression_time;
 
+  /// Bytes of the pages that were compressed when spilling and their compressed size.
+  /// The compressed size of a page that did not get smaller is its uncompressed size.
+  RuntimeProfile::Counter* compression_input_bytes;
+  RuntimeProfile::Counter* compression_output_bytes;
+
+  /// Number of pages that were spilled without compression because recent pages of the
+  /// client did not compress well. See SpillCompressionState.
+  RuntimeProfile::Counter* compression_bypassed_pages;
+
   /// Total amount of time spent encrypting and decrypting data when spilling.
   RuntimeProfile::Counter* encryption_time;
 
@@ -55,6 +64,14 @@ struct BufferPoolClientCounters {
   /// Amount of time spent waiting for writes to disk to complete.
   RuntimeProfile::Counter* write_wait_time;
 
+  /// Number of times the client had to wait for writes before it could use memory.
+  RuntimeProfile::Counter* num_write_waits;
+
+  /// Number of buffers allocated by evicting a clean page and the time spent on it. An
+  /// eviction does not have to wait for a write in contrast to 'num_write_waits'.
+  RuntimeProfile::Counter* num_clean_page_evictions;
+  RuntimeProfile::Counter* clean_page_eviction_time;
+
   /// Total number of write I/O operations issued.
   RuntimeProfile::Counter* write_io_ops;
 
@@ -81,6 +81,7 @@
 #include "runtime/bufferpool/buffer-pool-counters.h"
 #include "runtime/bufferpool/buffer-pool.h"
 #include "runtime/bufferpool/reservation-tracker.h"
+#include "runtime/tmp-file-mgr.h"
 #include "util/condition-variable.h"
 #include "util/internal-queue.h"
 #include "util/spinlock.h"
@@ -268,6 +269,18 @@ class BufferPool::Client {
   /// Implementations of ClientHandle::TransferReservationTo().
   Status TransferReservationTo(ReservationTracker* dst, int64_t bytes, bool* transferred);
 
+  /// Implementation of ClientHandle::UseSortSpillCompression().
+  void UseSortSpillCompression() {
+    std::lock_guard<std::mutex> cl(lock_);
+    spill_compression_.use_sort_codec = true;
+  }
+
+  /// Implementation of ClientHandle::MarkSpilledPagesCold().
+  void MarkSpilledPagesCold() {
+    std::lock_guard<std::mutex> cl(lock_);
+    spilled_pages_cold_ = true;
+  }
+
   /// Called after a buffer of 'len' is freed via the FreeBuffer() API to update
   /// internal accounting and release the buffer to the client's reservation. No page or
   /// client locks should be held by the caller.
@@ -331,10 +344,20 @@ class BufferPool::Client {
 
   /// Initiates asynchronous writes of dirty unpinned pages to disk. Ensures that at
   /// least 'min_bytes_to_write' bytes of writes will be written asynchronously. May
-  /// start writes more aggressively so that I/O and compute can be overlapped. If
-  /// any errors are encountered, 'write_status_' is set. 'write_status_' must therefore
-  /// be checked before reading back any pages. 'lock_' must be held by the caller.
-  void WriteDirtyPagesAsync(int64_t min_bytes_to_write = 0);
+  /// start writes more aggressively so that I/O and compute can be overlapped, unless
+  /// the headroom after allocating 'bytes_to_allocate' is above
+  /// --buffer_pool_clean_ahead_bytes. If any errors are encountered, 'write_status_' is
+  /// set. 'write_status_' must therefore be checked before reading back any pages.
+  /// 'lock_' must be held by the caller.
+  void WriteDirtyPagesAsync(
+      int64_t min_bytes_to_write = 0, int64_t bytes_to_allocate = 0);
+
+  /// Returns the reservation that is left after allocating 'bytes_to_allocate' and is not
+  /// used by buffers, pinned pages, dirty unpinned pages or pages with writes in flight.
+  /// Dirty pages only have to be written once this drops to zero, so writing ahead
+  /// earlier means that buffers can be found by evicting clean pages instead of waiting
+  /// for writes. 'lock_' must be held by the caller.
+  int64_t GetCleanAheadHeadroom(int64_t bytes_to_allocate);
 
   /// Called when a write for 'page' completes.
   void WriteCompleteCallback(Page* page, const Status& write_status);
@@ -367,6 +390,13 @@ class BufferPool::Client {
   /// All non-NULL.
   BufferPoolClientCounters counters_;
 
+  /// The state of adaptive spill compression for this client. Protected by 'lock_'.
+  SpillCompressionState spill_compression_;
+
+  /// Whether the pages that this client writes are cold, see MarkSpilledPagesCold().
+  /// Protected by 'lock_'.
+  bool spilled_pages_cold_ = false;
+
   /// Debug option to delay write completion.
   int debug_write_delay_ms_;
 
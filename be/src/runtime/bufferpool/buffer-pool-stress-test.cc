@@ -0,0 +1,383 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// Stress test and benchmark of the BufferPool, ReservationTracker and TmpFileMgr.
+//
+// Every client of the buffer pool runs in a thread of its own and randomly creates,
+// pins, unpins and destroys pages of the sizes in --stress_page_sizes, and allocates
+// and frees buffers. Every client owns more pages than its reservation can pin, so
+// pages are spilled to the scratch directories of --scratch_dirs and read back. The
+// part of the buffer pool that is not reserved by the clients, which is set with
+// --stress_reservation_slack, holds free buffers and clean pages, so the lower the
+// slack, the more buffers are scavenged. The contents of pages that are read back are
+// verified.
+//
+// At the end the test prints the latency percentiles of the allocations, the number of
+// scavenges and the bandwidth of the spilling, e.g.:
+//   buffer-pool-stress-test --stress_num_clients=32 --stress_page_sizes=64KB,2MB \
+//       --stress_reservation_slack=0.1 --scratch_dirs=/data/1,/data/2
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+
+#include <boost/thread/thread.hpp>
+#include <gflags/gflags.h>
+
+#include "common/init.h"
+#include "common/object-pool.h"
+#include "gutil/strings/split.h"
+#include "runtime/bufferpool/buffer-pool.h"
+#include "runtime/bufferpool/reservation-tracker.h"
+#include "runtime/exec-env.h"
+#include "runtime/test-env.h"
+#include "runtime/tmp-file-mgr.h"
+#include "service/fe-support.h"
+#include "util/bit-util.h"
+#include "util/cpu-info.h"
+#include "util/hdr-histogram.h"
+#include "util/metrics.h"
+#include "util/parse-util.h"
+#include "util/pretty-printer.h"
+#include "util/runtime-profile-counters.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+using namespace impala;
+using std::mt19937;
+using std::uniform_int_distribution;
+using std::uniform_real_distribution;
+
+DEFINE_int64(stress_duration_sec, 10, "Duration of the stress test in seconds.");
+DEFINE_int32(stress_num_clients, 16,
+    "Number of clients of the buffer pool, each of which runs in its own thread.");
+DEFINE_string(stress_page_sizes, "64KB,512KB,2MB", "Comma-separated list of the sizes "
+    "of the pages of the clients. The sizes must be powers of two.");
+DEFINE_int32(stress_pages_per_client, 64, "Number of pages of every client.");
+DEFINE_string(stress_buffer_pool_limit, "1GB", "Capacity of the buffer pool.");
+DEFINE_string(stress_clean_pages_limit, "10%", "Limit on the clean pages of the buffer "
+    "pool. A percentage is relative to --stress_buffer_pool_limit.");
+DEFINE_double(stress_reservation_slack, 0.25, "Fraction of the capacity of the buffer "
+    "pool that is not reserved by the clients. Must be in [0, 1).");
+DEFINE_int32(stress_seed, 0, "Seed of the random operations of the clients.");
+
+namespace {
+
+// Probabilities of the operations of the clients, which are picked per page.
+const double DESTROY_PAGE_PROBABILITY = 0.05;
+const double ALLOCATE_BUFFER_PROBABILITY = 0.1;
+
+// Latencies are tracked up to a minute with 3 significant digits.
+const uint64_t MAX_LATENCY_NS = 60L * 1000L * 1000L * 1000L;
+const int LATENCY_SIGNIFICANT_DIGITS = 3;
+
+// The latencies of one kind of operation of all clients.
+struct LatencyHistogram {
+  explicit LatencyHistogram(const string& name)
+    : name(name), histogram(MAX_LATENCY_NS, LATENCY_SIGNIFICANT_DIGITS) {}
+
+  void Add(int64_t start_ns) { histogram.Increment(MonotonicNanos() - start_ns); }
+
+  string ToString() const {
+    if (histogram.TotalCount() == 0) return Substitute("$0: no operations", name);
+    auto percentile = [this](double p) {
+      return PrettyPrinter::Print(histogram.ValueAtPercentile(p), TUnit::TIME_NS);
+    };
+    return Substitute("$0: count=$1 p50=$2 p90=$3 p99=$4 p99.9=$5 max=$6", name,
+        histogram.TotalCount(), percentile(50), percentile(90), percentile(99),
+        percentile(99.9), PrettyPrinter::Print(histogram.MaxValue(), TUnit::TIME_NS));
+  }
+
+  const string name;
+  HdrHistogram histogram;
+};
+
+class BufferPoolStress {
+ public:
+  BufferPoolStress(TestEnv* test_env, const vector<int64_t>& page_sizes,
+      int64_t buffer_pool_limit, int64_t clean_pages_limit)
+    : test_env_(test_env),
+      page_sizes_(page_sizes),
+      buffer_pool_limit_(buffer_pool_limit),
+      pool_(&metrics_, page_sizes.front(), buffer_pool_limit, clean_pages_limit),
+      create_page_latency_("CreatePage"),
+      pin_latency_("Pin"),
+      allocate_buffer_latency_("AllocateBuffer") {}
+
+  /// Runs 'num_clients' clients for 'duration_sec' seconds and prints the results.
+  Status Run(int num_clients, int pages_per_client, double reservation_slack,
+      int64_t duration_sec);
+
+ private:
+  struct Client {
+    BufferPool::ClientHandle handle;
+    TmpFileGroup* file_group = nullptr;
+    RuntimeProfile* profile = nullptr;
+    vector<BufferPool::PageHandle> pages;
+    /// The value that the first bytes of every open page hold, by page.
+    vector<int64_t> page_values;
+  };
+
+  /// The loop of the thread of 'client'. Runs the random operations until 'stop_' is
+  /// set. Stops the test if an operation fails.
+  void ClientLoop(Client* client, int seed);
+
+  /// Runs a random operation on page 'idx' of 'client'.
+  Status PageOperation(Client* client, int idx, mt19937* rng);
+
+  /// Allocates a buffer of a random size and frees it.
+  Status AllocateAndFreeBuffer(Client* client, mt19937* rng);
+
+  /// Unpins pages of 'client' until it has 'bytes' of unused reservation.
+  void MakeRoom(Client* client, int64_t bytes, mt19937* rng);
+
+  /// Returns the sum of the buffer pool metric of every arena called 'metric_name'.
+  int64_t SumArenaMetric(const string& metric_name);
+
+  /// Prints the results of a run that took 'elapsed_ns'.
+  void PrintResults(int64_t elapsed_ns);
+
+  TestEnv* const test_env_;
+  const vector<int64_t> page_sizes_;
+  const int64_t buffer_pool_limit_;
+  ObjectPool obj_pool_;
+  MetricGroup metrics_{"buffer-pool-stress"};
+  BufferPool pool_;
+  ReservationTracker root_reservation_;
+  vector<unique_ptr<Client>> clients_;
+
+  LatencyHistogram create_page_latency_;
+  LatencyHistogram pin_latency_;
+  LatencyHistogram allocate_buffer_latency_;
+  AtomicInt64 num_operations_{0};
+
+  std::atomic<bool> stop_{false};
+  SpinLock status_lock_;
+  Status status_;
+};
+
+Status BufferPoolStress::Run(int num_clients, int pages_per_client,
+    double reservation_slack, int64_t duration_sec) {
+  const int64_t min_page_size = page_sizes_.front();
+  const int64_t max_page_size = page_sizes_.back();
+  const int64_t client_reservation = BitUtil::RoundDown(
+      static_cast<int64_t>(buffer_pool_limit_ * (1 - reservation_slack) / num_clients),
+      min_page_size);
+  if (client_reservation < max_page_size) {
+    return Status(Substitute("The reservation of a client, $0, cannot fit a page of "
+        "$1. Use fewer clients, smaller pages or a larger buffer pool.",
+        PrettyPrinter::PrintBytes(client_reservation),
+        PrettyPrinter::PrintBytes(max_page_size)));
+  }
+  root_reservation_.InitRootTracker(nullptr, buffer_pool_limit_);
+  for (int i = 0; i < num_clients; ++i) {
+    unique_ptr<Client> client(new Client);
+    client->profile = RuntimeProfile::Create(&obj_pool_, Substitute("Client $0", i));
+    client->file_group = obj_pool_.Add(new TmpFileGroup(test_env_->tmp_file_mgr(),
+        test_env_->exec_env()->disk_io_mgr(), client->profile, TUniqueId()));
+    RETURN_IF_ERROR(pool_.RegisterClient(Substitute("Client $0", i), client->file_group,
+        &root_reservation_, nullptr, client_reservation, client->profile,
+        &client->handle));
+    if (!client->handle.IncreaseReservation(client_reservation)) {
+      return Status(Substitute("Could not reserve $0 for client $1",
+          PrettyPrinter::PrintBytes(client_reservation), i));
+    }
+    client->pages.resize(pages_per_client);
+    client->page_values.resize(pages_per_client);
+    clients_.push_back(move(client));
+  }
+  printf("Running %d clients with a reservation of %s each for %ld seconds.\n",
+      num_clients, PrettyPrinter::PrintBytes(client_reservation).c_str(), duration_sec);
+
+  const int64_t start_ns = MonotonicNanos();
+  thread_group threads;
+  for (int i = 0; i < num_clients; ++i) {
+    threads.add_thread(new thread(&BufferPoolStress::ClientLoop, this,
+        clients_[i].get(), FLAGS_stress_seed + i));
+  }
+  const int64_t end_ns = start_ns + duration_sec * NANOS_PER_SEC;
+  while (!stop_.load() && MonotonicNanos() < end_ns) SleepForMs(100);
+  stop_.store(true);
+  threads.join_all();
+  const int64_t elapsed_ns = MonotonicNanos() - start_ns;
+
+  for (unique_ptr<Client>& client : clients_) {
+    for (BufferPool::PageHandle& page : client->pages) {
+      pool_.DestroyPage(&client->handle, &page);
+    }
+    pool_.DeregisterClient(&client->handle);
+    client->file_group->Close();
+  }
+  root_reservation_.Close();
+  RETURN_IF_ERROR(status_);
+  PrintResults(elapsed_ns);
+  return Status::OK();
+}
+
+void BufferPoolStress::ClientLoop(Client* client, int seed) {
+  mt19937 rng(seed);
+  uniform_int_distribution<int> page_dist(0, client->pages.size() - 1);
+  uniform_real_distribution<double> op_dist(0, 1);
+  while (!stop_.load()) {
+    Status status = op_dist(rng) < ALLOCATE_BUFFER_PROBABILITY ?
+        AllocateAndFreeBuffer(client, &rng) :
+        PageOperation(client, page_dist(rng), &rng);
+    if (!status.ok()) {
+      lock_guard<SpinLock> l(status_lock_);
+      if (status_.ok()) status_ = status;
+      stop_.store(true);
+      return;
+    }
+    num_operations_.Add(1);
+  }
+}
+
+Status BufferPoolStress::PageOperation(Client* client, int idx, mt19937* rng) {
+  BufferPool::PageHandle* page = &client->pages[idx];
+  int64_t* value = &client->page_values[idx];
+  if (!page->is_open()) {
+    const int64_t len =
+        page_sizes_[uniform_int_distribution<int>(0, page_sizes_.size() - 1)(*rng)];
+    MakeRoom(client, len, rng);
+    const BufferPool::BufferHandle* buffer;
+    const int64_t start_ns = MonotonicNanos();
+    RETURN_IF_ERROR(pool_.CreatePage(&client->handle, len, page, &buffer));
+    create_page_latency_.Add(start_ns);
+    *value = (*rng)();
+    *reinterpret_cast<int64_t*>(buffer->data()) = *value;
+  } else if (page->is_pinned()) {
+    if (uniform_real_distribution<double>(0, 1)(*rng) < DESTROY_PAGE_PROBABILITY) {
+      pool_.DestroyPage(&client->handle, page);
+    } else {
+      pool_.Unpin(&client->handle, page);
+    }
+  } else {
+    MakeRoom(client, page->len(), rng);
+    // The latency of a pin includes reading the page back if it was evicted.
+    const BufferPool::BufferHandle* buffer;
+    const int64_t start_ns = MonotonicNanos();
+    RETURN_IF_ERROR(pool_.Pin(&client->handle, page));
+    RETURN_IF_ERROR(page->GetBuffer(&buffer));
+    pin_latency_.Add(start_ns);
+    const int64_t actual = *reinterpret_cast<int64_t*>(buffer->data());
+    if (actual != *value) {
+      return Status(Substitute("Page contents corrupted: expected $0 but got $1",
+          *value, actual));
+    }
+  }
+  return Status::OK();
+}
+
+Status BufferPoolStress::AllocateAndFreeBuffer(Client* client, mt19937* rng) {
+  const int64_t len =
+      page_sizes_[uniform_int_distribution<int>(0, page_sizes_.size() - 1)(*rng)];
+  MakeRoom(client, len, rng);
+  BufferPool::BufferHandle buffer;
+  const int64_t start_ns = MonotonicNanos();
+  RETURN_IF_ERROR(pool_.AllocateBuffer(&client->handle, len, &buffer));
+  allocate_buffer_latency_.Add(start_ns);
+  pool_.FreeBuffer(&client->handle, &buffer);
+  return Status::OK();
+}
+
+void BufferPoolStress::MakeRoom(Client* client, int64_t bytes, mt19937* rng) {
+  // The reservation of a client fits the largest page, so it always has enough pinned
+  // pages to unpin.
+  int idx = uniform_int_distribution<int>(0, client->pages.size() - 1)(*rng);
+  while (client->handle.GetUnusedReservation() < bytes) {
+    BufferPool::PageHandle* page = &client->pages[idx];
+    if (page->is_pinned()) pool_.Unpin(&client->handle, page);
+    idx = (idx + 1) % client->pages.size();
+  }
+}
+
+int64_t BufferPoolStress::SumArenaMetric(const string& metric_name) {
+  int64_t sum = 0;
+  for (int i = 0; i < CpuInfo::GetMaxNumCores(); ++i) {
+    IntCounter* counter = metrics_.FindMetricForTesting<IntCounter>(
+        Substitute("buffer-pool.arena-$0.$1", i, metric_name));
+    if (counter != nullptr) sum += counter->GetValue();
+  }
+  return sum;
+}
+
+void BufferPoolStress::PrintResults(int64_t elapsed_ns) {
+  int64_t bytes_written = 0;
+  int64_t bytes_read = 0;
+  for (const unique_ptr<Client>& client : clients_) {
+    bytes_written += client->profile->GetCounter("ScratchBytesWritten")->value();
+    bytes_read += client->profile->GetCounter("ScratchBytesRead")->value();
+  }
+  const double elapsed_sec = static_cast<double>(elapsed_ns) / NANOS_PER_SEC;
+  printf("Operations: %ld in %.1f seconds\n", num_operations_.Load(), elapsed_sec);
+  printf("%s\n", create_page_latency_.ToString().c_str());
+  printf("%s\n", pin_latency_.ToString().c_str());
+  printf("%s\n", allocate_buffer_latency_.ToString().c_str());
+  printf("Scavenges: %ld, of which %ld locked all arenas\n",
+      SumArenaMetric("num-scavenges"), SumArenaMetric("num-final-scavenges"));
+  printf("Clean page hits: %ld, direct allocations: %ld\n",
+      SumArenaMetric("clean-page-hits"), SumArenaMetric("direct-alloc-count"));
+  printf("Spilled: %s written (%s/s), %s read (%s/s)\n",
+      PrettyPrinter::PrintBytes(bytes_written).c_str(),
+      PrettyPrinter::PrintBytes(bytes_written / elapsed_sec).c_str(),
+      PrettyPrinter::PrintBytes(bytes_read).c_str(),
+      PrettyPrinter::PrintBytes(bytes_read / elapsed_sec).c_str());
+}
+
+}
+
+int main(int argc, char** argv) {
+  impala::InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
+  impala::InitFeSupport();
+
+  vector<int64_t> page_sizes;
+  for (const string& spec : strings::Split(FLAGS_stress_page_sizes, ",",
+           strings::SkipWhitespace())) {
+    bool is_percent;
+    int64_t page_size = ParseUtil::ParseMemSpec(spec, &is_percent, 0);
+    CHECK(page_size > 0 && !is_percent && BitUtil::IsPowerOf2(page_size))
+        << "Invalid page size: " << spec;
+    page_sizes.push_back(page_size);
+  }
+  CHECK(!page_sizes.empty()) << "--stress_page_sizes must not be empty";
+  sort(page_sizes.begin(), page_sizes.end());
+  CHECK_GT(FLAGS_stress_num_clients, 0);
+  CHECK_GT(FLAGS_stress_pages_per_client, 0);
+  CHECK(FLAGS_stress_reservation_slack >= 0 && FLAGS_stress_reservation_slack < 1)
+      << "--stress_reservation_slack must be in [0, 1)";
+  bool is_percent;
+  const int64_t buffer_pool_limit =
+      ParseUtil::ParseMemSpec(FLAGS_stress_buffer_pool_limit, &is_percent, 0);
+  CHECK(buffer_pool_limit > 0 && !is_percent)
+      << "Invalid --stress_buffer_pool_limit: " << FLAGS_stress_buffer_pool_limit;
+  const int64_t clean_pages_limit = ParseUtil::ParseMemSpec(
+      FLAGS_stress_clean_pages_limit, &is_percent, buffer_pool_limit);
+  CHECK_GE(clean_pages_limit, 0)
+      << "Invalid --stress_clean_pages_limit: " << FLAGS_stress_clean_pages_limit;
+
+  // The scratch directories of the TmpFileMgr are taken from --scratch_dirs.
+  TestEnv test_env;
+  test_env.DisableBufferPool();
+  Status status = test_env.Init();
+  CHECK(status.ok()) << status.GetDetail();
+  BufferPoolStress stress(&test_env, page_sizes, buffer_pool_limit, clean_pages_limit);
+  status = stress.Run(FLAGS_stress_num_clients, FLAGS_stress_pages_per_client,
+      FLAGS_stress_reservation_slack, FLAGS_stress_duration_sec);
+  CHECK(status.ok()) << status.GetDetail();
+  return 0;
+}
@@ -62,6 +62,7 @@ DECLARE_bool(disk_spill_punch_holes);
 DECLARE_string(remote_tmp_file_block_size);
 DECLARE_string(remote_tmp_file_size);
 DECLARE_bool(allow_spill_to_hdfs);
+DECLARE_int64(buffer_pool_clean_ahead_bytes);
 
 // This suffix is appended to a tmp dir
 const string SCRATCH_SUFFIX = "/impala-scratch";
@@ -1440,6 +1441,57 @@ TEST_F(BufferPoolTest, EvictionPolicy) {
   TestEvictionPolicy(2 * 1024 * 1024);
 }
 
+// With a clean-ahead watermark, writes of unpinned pages are deferred until the unused
+// reservation of the client drops to the watermark.
+TEST_F(BufferPoolTest, CleanAheadWatermark) {
+  google::FlagSaver saver;
+  // Clean pages on other NUMA nodes are not evicted, see TestEvictionPolicy().
+  if (CpuInfo::GetMaxNumNumaNodes() > 1) CpuTestUtil::PinToCore(0);
+  FLAGS_buffer_pool_clean_ahead_bytes = TEST_BUFFER_LEN;
+  const int MAX_NUM_BUFFERS = 4;
+  int64_t total_mem = MAX_NUM_BUFFERS * TEST_BUFFER_LEN;
+  global_reservations_.InitRootTracker(NewProfile(), total_mem);
+  BufferPool pool(test_env_->metrics(), TEST_BUFFER_LEN, total_mem, total_mem);
+
+  ClientHandle client;
+  RuntimeProfile* profile = NewProfile();
+  ASSERT_OK(pool.RegisterClient("test client", NewFileGroup(), &global_reservations_,
+      nullptr, total_mem, profile, &client));
+  ASSERT_TRUE(client.IncreaseReservation(total_mem));
+  RuntimeProfileBase* buffer_pool_profile = nullptr;
+  vector<RuntimeProfileBase*> profile_children;
+  profile->GetChildren(&profile_children);
+  for (RuntimeProfileBase* child : profile_children) {
+    if (child->name() == "Buffer pool") buffer_pool_profile = child;
+  }
+  ASSERT_TRUE(buffer_pool_profile != nullptr);
+  RuntimeProfile::Counter* write_ios = buffer_pool_profile->GetCounter("WriteIoOps");
+
+  // Half of the reservation is unused after unpinning two pages, so nothing is written.
+  vector<PageHandle> pages;
+  CreatePages(&pool, &client, TEST_BUFFER_LEN, 2 * TEST_BUFFER_LEN, &pages);
+  WriteData(pages, 0);
+  UnpinAll(&pool, &client, &pages);
+  EXPECT_EQ(0, write_ios->value());
+
+  // Allocating a buffer brings the headroom down to the watermark, so the dirty pages
+  // are written ahead of the next allocation, which can evict a clean page.
+  vector<BufferHandle> buffers;
+  AllocateBuffers(&pool, &client, TEST_BUFFER_LEN, TEST_BUFFER_LEN, &buffers);
+  EXPECT_EQ(2, write_ios->value());
+  WaitForAllWrites(&client);
+  AllocateBuffers(&pool, &client, TEST_BUFFER_LEN, 2 * TEST_BUFFER_LEN, &buffers);
+  EXPECT_EQ(0, buffer_pool_profile->GetCounter("WriteIoWaits")->value());
+  EXPECT_EQ(1, NumEvicted(pages));
+
+  FreeBuffers(&pool, &client, &buffers);
+  ASSERT_OK(PinAll(&pool, &client, &pages));
+  VerifyData(pages, 0);
+  DestroyAll(&pool, &client, &pages);
+  pool.DeregisterClient(&client);
+  global_reservations_.Close();
+}
+
 void BufferPoolTest::TestEvictionPolicy(int64_t page_size) {
   // The eviction policy changes if there are multiple NUMA nodes, because buffers from
   // clean pages on the local node are claimed in preference to free buffers on the
@@ -28,6 +28,7 @@
 #include "util/bit-util.h"
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
+#include "util/event-tracer.h"
 #include "util/metrics.h"
 #include "util/runtime-profile-counters.h"
 #include "util/scope-exit-trigger.h"
@@ -38,6 +39,14 @@ DEFINE_int32(concurrent_scratch_ios_per_device, 2,
     "scratch files. This is multiplied by the number of active scratch directories to "
     "obtain the target number of scratch write I/Os per query.");
 
+DEFINE_int64(buffer_pool_clean_ahead_bytes, -1, "(Advanced) If 0 or more, a buffer pool "
+    "client only starts writing its dirty unpinned pages in the background once its "
+    "unused reservation that is not covered by dirty pages drops to this many bytes, so "
+    "that pages which are pinned again before their memory is needed are not written. "
+    "The writes are then issued ahead of the allocations that need the memory, up to "
+    "--concurrent_scratch_ios_per_device. If -1, all dirty unpinned pages are written as "
+    "soon as possible.");
+
 namespace impala {
 
 constexpr int BufferPool::LOG_MAX_BUFFER_BYTES;
@@ -176,6 +185,7 @@ void BufferPool::DestroyPage(ClientHandle* client, PageHandle* handle) {
 }
 
 Status BufferPool::Pin(ClientHandle* client, PageHandle* handle) {
+  SCOPED_TRACE_EVENT("BufferPool::Pin");
   DCHECK(client->is_registered());
   DCHECK(handle->is_open());
   DCHECK_EQ(handle->client_, client);
@@ -192,6 +202,7 @@ Status BufferPool::Pin(ClientHandle* client, PageHandle* handle) {
 }
 
 void BufferPool::Unpin(ClientHandle* client, PageHandle* handle) {
+  SCOPED_TRACE_EVENT("BufferPool::Unpin");
   DCHECK(handle->is_open());
   DCHECK(client->is_registered());
   DCHECK_EQ(handle->client_, client);
@@ -372,6 +383,14 @@ void BufferPool::ClientHandle::RestoreAllReservation(SubReservation* src) {
   RestoreReservation(src, src->GetReservation());
 }
 
+void BufferPool::ClientHandle::UseSortSpillCompression() {
+  impl_->UseSortSpillCompression();
+}
+
+void BufferPool::ClientHandle::MarkSpilledPagesCold() {
+  impl_->MarkSpilledPagesCold();
+}
+
 void BufferPool::ClientHandle::SetDebugDenyIncreaseReservation(double probability) {
   impl_->reservation()->SetDebugDenyIncreaseReservation(probability);
 }
@@ -429,6 +448,12 @@ BufferPool::Client::Client(BufferPool* pool, TmpFileGroup* file_group,
   counters_.alloc_time = ADD_TIMER(child_profile, "AllocTime");
   counters_.sys_alloc_time = ADD_TIMER(child_profile, "SystemAllocTime");
   counters_.compression_time = ADD_TIMER(child_profile, "CompressionTime");
+  counters_.compression_input_bytes =
+      ADD_COUNTER(child_profile, "CompressionInputBytes", TUnit::BYTES);
+  counters_.compression_output_bytes =
+      ADD_COUNTER(child_profile, "CompressionOutputBytes", TUnit::BYTES);
+  counters_.compression_bypassed_pages =
+      ADD_COUNTER(child_profile, "CompressionBypassedPages", TUnit::UNIT);
   counters_.encryption_time = ADD_TIMER(child_profile, "EncryptionTime");
   counters_.cumulative_allocations =
       ADD_COUNTER(child_profile, "CumulativeAllocations", TUnit::UNIT);
@@ -438,6 +463,10 @@ BufferPool::Client::Client(BufferPool* pool, TmpFileGroup* file_group,
   counters_.read_io_ops = ADD_COUNTER(child_profile, "ReadIoOps", TUnit::UNIT);
   counters_.bytes_read = ADD_COUNTER(child_profile, "ReadIoBytes", TUnit::BYTES);
   counters_.write_wait_time = ADD_TIMER(child_profile, "WriteIoWaitTime");
+  counters_.num_write_waits = ADD_COUNTER(child_profile, "WriteIoWaits", TUnit::UNIT);
+  counters_.clean_page_eviction_time = ADD_TIMER(child_profile, "CleanPageEvictionTime");
+  counters_.num_clean_page_evictions =
+      ADD_COUNTER(child_profile, "CleanPageEvictions", TUnit::UNIT);
   counters_.write_io_ops = ADD_COUNTER(child_profile, "WriteIoOps", TUnit::UNIT);
   counters_.bytes_written = ADD_COUNTER(child_profile, "WriteIoBytes", TUnit::BYTES);
   counters_.peak_unpinned_bytes =
@@ -581,6 +610,7 @@ void BufferPool::Client::UndoMoveEvictedToPinned(Page* page) {
 }
 
 Status BufferPool::Client::FinishMoveEvictedToPinned(Page* page) {
+  SCOPED_TRACE_EVENT("BufferPool::WaitForRead");
   SCOPED_TIMER(counters().read_wait_time);
   lock_guard<SpinLock> pl(page->buffer_lock);
   // Another thread may have moved it to pinned in the meantime.
@@ -657,6 +687,7 @@ Status BufferPool::Client::TransferReservationTo(
 
 Status BufferPool::Client::CleanPages(
     unique_lock<mutex>* client_lock, int64_t len, bool lazy_flush) {
+  SCOPED_TRACE_EVENT("BufferPool::CleanPages");
   DCHECK_GE(len, 0);
   DCHECK_LE(len, reservation_.GetReservation());
   DCheckHoldsLock(*client_lock);
@@ -693,7 +724,7 @@ Status BufferPool::Client::CleanPages(
     cleaning_pages_ = false;
     clean_pages_done_cv_.NotifyAll();
   });
-  WriteDirtyPagesAsync(min_bytes_to_write);
+  WriteDirtyPagesAsync(min_bytes_to_write, len);
 
   // One of the writes we initiated, or an earlier in-flight write may have hit an error.
   RETURN_IF_ERROR(write_status_);
@@ -702,6 +733,10 @@ Status BufferPool::Client::CleanPages(
   // violating the eviction policy. I.e. so that other clients can immediately get the
   // memory they're entitled to without waiting for this client's write to complete.
   DCHECK_GE(in_flight_write_pages_.bytes(), min_bytes_to_write) << DebugStringLocked();
+  if (dirty_unpinned_pages_.bytes() + in_flight_write_pages_.bytes()
+      > target_dirty_bytes) {
+    COUNTER_ADD(counters().num_write_waits, 1);
+  }
   while (dirty_unpinned_pages_.bytes() + in_flight_write_pages_.bytes()
       > target_dirty_bytes) {
     SCOPED_TIMER(counters().write_wait_time);
@@ -711,7 +746,8 @@ Status BufferPool::Client::CleanPages(
   return Status::OK();
 }
 
-void BufferPool::Client::WriteDirtyPagesAsync(int64_t min_bytes_to_write) {
+void BufferPool::Client::WriteDirtyPagesAsync(
+    int64_t min_bytes_to_write, int64_t bytes_to_allocate) {
   DCHECK_GE(min_bytes_to_write, 0) << DebugStringLocked();
   DCHECK_LE(min_bytes_to_write, dirty_unpinned_pages_.bytes()) << DebugStringLocked();
   if (file_group_ == NULL) {
@@ -730,11 +766,15 @@ void BufferPool::Client::WriteDirtyPagesAsync(int64_t min_bytes_to_write) {
   // future we could track the # of writes per-disk.
   const int64_t target_writes = FLAGS_concurrent_scratch_ios_per_device
       * file_group_->tmp_file_mgr()->NumActiveTmpDevices();
+  // Writing a dirty page does not change the headroom, so it only needs to be checked
+  // once.
+  const bool write_ahead = FLAGS_buffer_pool_clean_ahead_bytes < 0
+      || GetCleanAheadHeadroom(bytes_to_allocate) <= FLAGS_buffer_pool_clean_ahead_bytes;
 
   int64_t bytes_written = 0;
   while (!dirty_unpinned_pages_.empty()
       && (bytes_written < min_bytes_to_write
-             || in_flight_write_pages_.size() < target_writes)) {
+             || (write_ahead && in_flight_write_pages_.size() < target_writes))) {
     Page* page = dirty_unpinned_pages_.tail(); // LIFO.
     DCHECK(page != NULL) << "Should have been enough dirty unpinned pages";
     {
@@ -744,7 +784,7 @@ void BufferPool::Client::WriteDirtyPagesAsync(int64_t min_bytes_to_write) {
       Status status = file_group_->Write(page->buffer.mem_range(),
           [this, page](
               const Status& write_status) { WriteCompleteCallback(page, write_status); },
-          &page->write_handle, &counters_);
+          &page->write_handle, &counters_, &spill_compression_, spilled_pages_cold_);
       // Exit early on error: there is no point in starting more writes because future
       /// operations for this client will fail regardless.
       if (!status.ok()) {
@@ -762,6 +802,12 @@ void BufferPool::Client::WriteDirtyPagesAsync(int64_t min_bytes_to_write) {
   }
 }
 
+int64_t BufferPool::Client::GetCleanAheadHeadroom(int64_t bytes_to_allocate) {
+  return reservation_.GetReservation() - buffers_allocated_bytes_ - pinned_pages_.bytes()
+      - dirty_unpinned_pages_.bytes() - in_flight_write_pages_.bytes()
+      - bytes_to_allocate;
+}
+
 void BufferPool::Client::WriteCompleteCallback(Page* page, const Status& write_status) {
 #ifndef NDEBUG
   if (debug_write_delay_ms_ > 0) SleepForMs(debug_write_delay_ms_);
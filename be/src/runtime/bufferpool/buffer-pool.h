@@ -394,6 +394,15 @@ class BufferPool::ClientHandle {
   Status TransferReservationTo(ReservationTracker* dst, int64_t bytes, bool* transferred);
   Status TransferReservationTo(ClientHandle* dst, int64_t bytes, bool* transferred);
 
+  /// Compress the pages that this client spills with the codec for sort runs, see
+  /// --disk_spill_compression_codec_sort. Thread-safe.
+  void UseSortSpillCompression();
+
+  /// Mark the pages that this client spills as cold, i.e. not read back soon, so that
+  /// they are written to remote scratch space first if --remote_tmp_cold_pages_first is
+  /// set. Thread-safe.
+  void MarkSpilledPagesCold();
+
   /// Call SetDebugDenyIncreaseReservation() on this client's ReservationTracker.
   void SetDebugDenyIncreaseReservation(double probability);
 
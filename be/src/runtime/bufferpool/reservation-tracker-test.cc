@@ -19,6 +19,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/thread/thread.hpp>
+
 #include "runtime/bufferpool/reservation-tracker.h"
 #include "runtime/bufferpool/reservation-util.h"
 #include "runtime/test-env.h"
@@ -32,6 +34,8 @@
 
 #include "common/names.h"
 
+DECLARE_int64(reservation_tracker_child_slack_bytes);
+
 namespace impala {
 
 class ReservationTrackerTest : public ::testing::Test {
@@ -598,6 +602,99 @@ TEST_F(ReservationTrackerTest, MemTrackerDeadlock) {
   reservation->Close();
   mem_tracker->Close();
 }
+
+// Test that reservation that children give back is kept as slack by their parent, up to
+// --reservation_tracker_child_slack_bytes, and used for their next increases.
+TEST_F(ReservationTrackerTest, ChildSlack) {
+  google::FlagSaver saver;
+  FLAGS_reservation_tracker_child_slack_bytes = 4 * MIN_BUFFER_LEN;
+  root_.InitRootTracker(nullptr, 100 * MIN_BUFFER_LEN);
+  ReservationTracker query;
+  query.InitChildTracker(nullptr, &root_, nullptr, numeric_limits<int64_t>::max());
+  ReservationTracker child;
+  child.InitChildTracker(nullptr, &query, nullptr, numeric_limits<int64_t>::max());
+
+  ASSERT_TRUE(child.IncreaseReservation(8 * MIN_BUFFER_LEN));
+  ASSERT_EQ(8 * MIN_BUFFER_LEN, query.GetReservation());
+  ASSERT_EQ(8 * MIN_BUFFER_LEN, root_.GetReservation());
+
+  // 'query' keeps up to the limit when the child decreases its reservation.
+  child.DecreaseReservation(6 * MIN_BUFFER_LEN);
+  ASSERT_EQ(2 * MIN_BUFFER_LEN, child.GetReservation());
+  ASSERT_EQ(6 * MIN_BUFFER_LEN, query.GetReservation());
+  ASSERT_EQ(2 * MIN_BUFFER_LEN, query.GetChildReservations());
+  ASSERT_EQ(4 * MIN_BUFFER_LEN, query.GetUnusedReservation());
+  ASSERT_EQ(6 * MIN_BUFFER_LEN, root_.GetReservation());
+
+  // An increase that fits in the slack does not change the ancestors.
+  ASSERT_TRUE(child.IncreaseReservation(3 * MIN_BUFFER_LEN));
+  ASSERT_EQ(5 * MIN_BUFFER_LEN, child.GetReservation());
+  ASSERT_EQ(6 * MIN_BUFFER_LEN, query.GetReservation());
+  ASSERT_EQ(MIN_BUFFER_LEN, query.GetUnusedReservation());
+  ASSERT_EQ(6 * MIN_BUFFER_LEN, root_.GetReservation());
+
+  // A larger increase uses the rest of the slack and increases the ancestors.
+  ASSERT_TRUE(child.IncreaseReservation(2 * MIN_BUFFER_LEN));
+  ASSERT_EQ(7 * MIN_BUFFER_LEN, child.GetReservation());
+  ASSERT_EQ(7 * MIN_BUFFER_LEN, query.GetReservation());
+  ASSERT_EQ(0, query.GetUnusedReservation());
+  ASSERT_EQ(7 * MIN_BUFFER_LEN, root_.GetReservation());
+
+  // The slack can be used at 'query' itself.
+  child.Close();
+  ASSERT_EQ(4 * MIN_BUFFER_LEN, query.GetReservation());
+  ASSERT_EQ(0, query.GetChildReservations());
+  ASSERT_EQ(4 * MIN_BUFFER_LEN, query.GetUnusedReservation());
+  query.AllocateFrom(4 * MIN_BUFFER_LEN);
+  query.ReleaseTo(4 * MIN_BUFFER_LEN);
+
+  // Closing 'query' releases the slack to the root.
+  query.Close();
+  ASSERT_EQ(0, root_.GetReservation());
+  ASSERT_EQ(0, root_.GetChildReservations());
+}
+
+// Stress test for the child slack: threads increase and decrease the reservations of
+// sibling trackers concurrently.
+TEST_F(ReservationTrackerTest, ChildSlackConcurrent) {
+  google::FlagSaver saver;
+  FLAGS_reservation_tracker_child_slack_bytes = 16 * MIN_BUFFER_LEN;
+  const int NUM_THREADS = 8;
+  const int64_t CHILD_LIMIT = 8 * MIN_BUFFER_LEN;
+  root_.InitRootTracker(nullptr, NUM_THREADS * CHILD_LIMIT);
+  ReservationTracker query;
+  query.InitChildTracker(nullptr, &root_, nullptr, numeric_limits<int64_t>::max());
+  ReservationTracker children[NUM_THREADS];
+  thread_group workers;
+  for (int t = 0; t < NUM_THREADS; ++t) {
+    children[t].InitChildTracker(nullptr, &query, nullptr, CHILD_LIMIT);
+    workers.add_thread(new thread([&children, t]() {
+      ReservationTracker* child = &children[t];
+      for (int i = 0; i < 10000; ++i) {
+        int64_t bytes = (i % 4 + 1) * MIN_BUFFER_LEN;
+        if (child->IncreaseReservation(bytes)) {
+          child->AllocateFrom(bytes);
+          child->ReleaseTo(bytes);
+        }
+        if (i % 3 == 0) child->DecreaseReservation(child->GetReservation());
+      }
+    }));
+  }
+  workers.join_all();
+
+  int64_t total_child_reservation = 0;
+  for (int t = 0; t < NUM_THREADS; ++t) {
+    total_child_reservation += children[t].GetReservation();
+  }
+  ASSERT_EQ(total_child_reservation, query.GetChildReservations());
+  ASSERT_EQ(query.GetReservation(), root_.GetReservation());
+  ASSERT_LE(query.GetReservation(),
+      total_child_reservation + FLAGS_reservation_tracker_child_slack_bytes);
+  for (int t = 0; t < NUM_THREADS; ++t) children[t].Close();
+  ASSERT_EQ(0, query.GetChildReservations());
+  query.Close();
+  ASSERT_EQ(0, root_.GetReservation());
+}
 }
 
 int main(int argc, char **argv) {
@@ -32,6 +32,11 @@
 
 #include "common/names.h"
 
+DEFINE_int64(reservation_tracker_child_slack_bytes, 0, "(Advanced) The maximum "
+    "reservation in bytes that a reservation tracker below the process-wide tracker "
+    "keeps when its children decrease their reservation, so that their next increases "
+    "can be granted without locking the tracker and its ancestors. 0 disables it.");
+
 namespace impala {
 
 ReservationTracker::ReservationTracker() {}
@@ -42,7 +47,7 @@ ReservationTracker::~ReservationTracker() {
 
 void ReservationTracker::InitRootTracker(
     RuntimeProfile* profile, int64_t reservation_limit) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DCHECK(!initialized_);
   parent_ = nullptr;
   mem_tracker_ = nullptr;
@@ -50,6 +55,8 @@ void ReservationTracker::InitRootTracker(
   reservation_.Store(0);
   used_reservation_.Store(0);
   child_reservations_.Store(0);
+  child_slack_.Store(0);
+  child_slack_limit_ = 0;
   initialized_ = true;
 
   InitCounters(profile, reservation_limit);
@@ -64,7 +71,7 @@ void ReservationTracker::InitChildTracker(RuntimeProfile* profile,
   DCHECK(parent != nullptr);
   DCHECK_GE(reservation_limit, 0);
 
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DCHECK(!initialized_);
   parent_ = parent;
   mem_tracker_ = mem_tracker;
@@ -74,6 +81,8 @@ void ReservationTracker::InitChildTracker(RuntimeProfile* profile,
   reservation_.Store(0);
   used_reservation_.Store(0);
   child_reservations_.Store(0);
+  child_slack_.Store(0);
+  child_slack_limit_ = max<int64_t>(0, FLAGS_reservation_tracker_child_slack_bytes);
   initialized_ = true;
 
   if (mem_tracker_ != nullptr) {
@@ -124,8 +133,9 @@ void ReservationTracker::InitCounters(
 }
 
 void ReservationTracker::Close() {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   if (!initialized_) return;
+  ReclaimChildSlackLocked();
   CheckConsistency();
   DCHECK_EQ(used_reservation_.Load(), 0);
   DCHECK_EQ(child_reservations_.Load(), 0);
@@ -137,18 +147,18 @@ void ReservationTracker::Close() {
 }
 
 bool ReservationTracker::IncreaseReservation(int64_t bytes, Status* error_status) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   return IncreaseReservationInternalLocked(bytes, false, false, error_status);
 }
 
 bool ReservationTracker::IncreaseReservationToFit(int64_t bytes, Status* error_status) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   return IncreaseReservationInternalLocked(bytes, true, false, error_status);
 }
 
 bool ReservationTracker::IncreaseReservationToFitAndAllocate(
     int64_t bytes, Status* error_status) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   if (!IncreaseReservationInternalLocked(bytes, true, false, error_status)) return false;
   AllocateFromLocked(bytes);
   return true;
@@ -157,6 +167,7 @@ bool ReservationTracker::IncreaseReservationToFitAndAllocate(
 bool ReservationTracker::IncreaseReservationInternalLocked(int64_t bytes,
     bool use_existing_reservation, bool is_child_reservation, Status* error_status) {
   DCHECK(initialized_);
+  if (use_existing_reservation && bytes > unused_reservation()) ReclaimChildSlackLocked();
   int64_t reservation_increase =
       use_existing_reservation ? max<int64_t>(0, bytes - unused_reservation()) : bytes;
   DCHECK_GE(reservation_increase, 0);
@@ -208,8 +219,11 @@ bool ReservationTracker::IncreaseReservationInternalLocked(int64_t bytes,
     DCHECK(mem_tracker_ == nullptr) << "Root cannot have linked MemTracker";
     granted = true;
   } else {
-    {
-      lock_guard<SpinLock> l(parent_->lock_);
+    // Take the increase from the parent's child slack if possible, so that neither the
+    // parent nor any other ancestor needs to be locked.
+    granted = parent_->TryTakeChildSlack(reservation_increase);
+    if (!granted) {
+      lock_guard<TrackedSpinLock> l(parent_->lock_);
       granted = parent_->IncreaseReservationInternalLocked(
           reservation_increase, true, true, error_status);
     }
@@ -264,7 +278,7 @@ void ReservationTracker::ReleaseToMemTracker(int64_t reservation_decrease) {
 }
 
 void ReservationTracker::DecreaseReservation(int64_t bytes, bool is_child_reservation) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DecreaseReservationLocked(bytes, is_child_reservation);
 }
 
@@ -277,10 +291,40 @@ void ReservationTracker::DecreaseReservationLocked(
   UpdateReservation(-bytes);
   ReleaseToMemTracker(bytes);
   // The reservation should be returned up the tree.
-  if (parent_ != nullptr) parent_->DecreaseReservation(bytes, true);
+  if (parent_ != nullptr) parent_->ReturnChildReservation(bytes);
   CheckConsistency();
 }
 
+bool ReservationTracker::TryTakeChildSlack(int64_t bytes) {
+  DCHECK_GT(bytes, 0);
+  while (true) {
+    int64_t slack = child_slack_.Load();
+    if (slack < bytes) return false;
+    // The bytes stay in 'child_reservations_', now as part of the child's reservation.
+    if (child_slack_.CompareAndSwap(slack, slack - bytes)) return true;
+  }
+}
+
+void ReservationTracker::ReturnChildReservation(int64_t bytes) {
+  int64_t kept = 0;
+  while (true) {
+    int64_t slack = child_slack_.Load();
+    kept = min(bytes, child_slack_limit_ - slack);
+    if (kept <= 0) {
+      kept = 0;
+      break;
+    }
+    // The bytes stay in 'child_reservations_', now as part of the slack.
+    if (child_slack_.CompareAndSwap(slack, slack + kept)) break;
+  }
+  if (kept < bytes) DecreaseReservation(bytes - kept, true);
+}
+
+void ReservationTracker::ReclaimChildSlackLocked() {
+  int64_t slack = child_slack_.Swap(0);
+  if (slack > 0) child_reservations_.Add(-slack);
+}
+
 bool ReservationTracker::TransferReservationTo(ReservationTracker* other, int64_t bytes) {
   if (other == this) return true;
   // Find the path to the root from both. The root is guaranteed to be a common ancestor.
@@ -311,7 +355,7 @@ bool ReservationTracker::TransferReservationTo(ReservationTracker* other, int64_
 
   // Lock all of the trackers so we can do the update atomically. Need to be careful to
   // lock subtrees in the correct order.
-  vector<unique_lock<SpinLock>> locks;
+  vector<unique_lock<TrackedSpinLock>> locks;
   bool lock_first = path_to_common.empty() || other_path_to_common.empty()
       || lock_sibling_subtree_first(path_to_common.back(), other_path_to_common.back());
   if (lock_first) {
@@ -324,6 +368,10 @@ bool ReservationTracker::TransferReservationTo(ReservationTracker* other, int64_
     for (ReservationTracker* tracker : path_to_common) locks.emplace_back(tracker->lock_);
   }
 
+  // The reservation may be in the child slack of 'this', which is locked if it is not
+  // the common ancestor.
+  if (!path_to_common.empty()) ReclaimChildSlackLocked();
+
   // Check reservation limits will not be violated before applying any updates.
   for (ReservationTracker* tracker : other_path_to_common) {
     if (tracker->reservation_.Load() + bytes > tracker->reservation_limit_.Load()) {
@@ -353,7 +401,7 @@ bool ReservationTracker::TransferReservationTo(ReservationTracker* other, int64_
   if (common_ancestor == other) {
     other->child_reservations_.Add(-bytes);
 #ifndef NDEBUG
-    lock_guard<SpinLock> l(other->lock_);
+    lock_guard<TrackedSpinLock> l(other->lock_);
     other->CheckConsistency();
 #endif
   }
@@ -361,7 +409,7 @@ bool ReservationTracker::TransferReservationTo(ReservationTracker* other, int64_
   if (common_ancestor == this) {
     child_reservations_.Add(bytes);
 #ifndef NDEBUG
-    lock_guard<SpinLock> l(lock_);
+    lock_guard<TrackedSpinLock> l(lock_);
     CheckConsistency();
 #endif
   }
@@ -379,20 +427,21 @@ vector<ReservationTracker*> ReservationTracker::FindPathToRoot() {
 }
 
 void ReservationTracker::AllocateFrom(int64_t bytes) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   AllocateFromLocked(bytes);
 }
 
 void ReservationTracker::AllocateFromLocked(int64_t bytes) {
   DCHECK(initialized_);
   DCHECK_GE(bytes, 0);
+  if (bytes > unused_reservation()) ReclaimChildSlackLocked();
   DCHECK_LE(bytes, unused_reservation());
   UpdateUsedReservation(bytes);
   CheckConsistency();
 }
 
 void ReservationTracker::ReleaseTo(int64_t bytes) {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DCHECK(initialized_);
   DCHECK_GE(bytes, 0);
   DCHECK_LE(bytes, used_reservation_.Load());
@@ -415,16 +464,16 @@ int64_t ReservationTracker::GetUsedReservation() {
 }
 
 int64_t ReservationTracker::GetUnusedReservation() {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DCHECK(initialized_);
-  return unused_reservation();
+  return unused_reservation() + child_slack_.Load();
 }
 
 int64_t ReservationTracker::GetChildReservations() {
   // Don't acquire lock - there is no point in holding it for this function only since
   // the value read can change as soon as we release it.
   DCHECK(initialized_);
-  return child_reservations_.Load();
+  return child_reservations_.Load() - child_slack_.Load();
 }
 
 void ReservationTracker::CheckConsistency() const {
@@ -432,6 +481,7 @@ void ReservationTracker::CheckConsistency() const {
   DCHECK_GE(reservation_.Load(), 0);
   DCHECK_LE(reservation_.Load(), reservation_limit_.Load());
   DCHECK_GE(child_reservations_.Load(), 0);
+  DCHECK_GE(child_slack_.Load(), 0);
   DCHECK_GE(used_reservation_.Load(), 0);
   DCHECK_LE(used_reservation_.Load() + child_reservations_.Load(), reservation_.Load())
       << used_reservation_.Load() << " + " << child_reservations_.Load() << " > "
@@ -459,14 +509,14 @@ void ReservationTracker::UpdateReservation(int64_t delta) {
 }
 
 string ReservationTracker::DebugString() {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   if (!initialized_) return "<ReservationTracker>: uninitialized";
 
   string parent_debug_string = parent_ == nullptr ? "NULL" : parent_->DebugString();
   return Substitute(
       "<ReservationTracker>: reservation_limit $0 reservation $1 used_reservation $2 "
-      "child_reservations $3 parent:\n$4",
+      "child_reservations $3 child_slack $4 parent:\n$5",
       reservation_limit_.Load(), reservation_.Load(), used_reservation_.Load(),
-      child_reservations_.Load(), parent_debug_string);
+      child_reservations_.Load(), child_slack_.Load(), parent_debug_string);
 }
 }
@@ -25,7 +25,7 @@
 #include "common/status.h"
 #include "runtime/bufferpool/reservation-tracker-counters.h"
 #include "runtime/mem-tracker-types.h"
-#include "util/spinlock.h"
+#include "util/lock-contention.h"
 
 namespace impala {
 
@@ -60,6 +60,17 @@ class RuntimeProfile;
 ///   the unused reservation:
 ///     child_reservations + used_reservation + unused_reservation = reservation.
 ///
+/// Child slack:
+/// A child tracker that is not the root can keep up to
+/// --reservation_tracker_child_slack_bytes of the reservation that its children give
+/// back, instead of releasing it up the tree. Children increase their reservation from
+/// this slack with an atomic compare-and-swap, without acquiring the lock of the tracker
+/// or of any of its ancestors, and return reservation to it the same way. The slack is
+/// part of the tracker's reservation, so limits and MemTracker consumption include it.
+/// It is folded back into the unused reservation whenever the tracker needs more
+/// unused reservation than it has, so it never causes a request to be denied, and it is
+/// released when the tracker is closed.
+///
 /// Thread-safety:
 /// All public ReservationTracker methods are thread-safe. If multiple threads
 /// concurrently invoke methods on a ReservationTracker, each operation is applied
@@ -111,7 +122,8 @@ class ReservationTracker {
   /// relinquishing all this tracker's reservation. All of the reservation must be unused
   /// and all the tracker's children must be closed before calling this method.
   /// TODO: decide on and implement policy for how far to release the reservation up
-  /// the tree. Currently the reservation is released all the way to the root.
+  /// the tree. Currently the reservation is released all the way to the root, except
+  /// for the part that ancestors keep as child slack.
   void Close();
 
   /// Request to increase reservation by 'bytes'. The request is either granted in
@@ -169,11 +181,12 @@ class ReservationTracker {
   int64_t GetUsedReservation();
 
   /// Returns the amount of the reservation neither used nor given to childrens'
-  /// reservations at this tracker in bytes. Acquires the internal lock.
+  /// reservations at this tracker in bytes, including the child slack. Acquires the
+  /// internal lock.
   int64_t GetUnusedReservation();
 
-  /// Returns the total reservations of children in bytes. Does not acquire the
-  /// internal lock.
+  /// Returns the total reservations of children in bytes, not including the child
+  /// slack. Does not acquire the internal lock.
   int64_t GetChildReservations();
 
   /// Support for debug actions: deny reservation increase with probability 'probability'.
@@ -236,6 +249,20 @@ class ReservationTracker {
   /// Same as DecreaseReservation(), but 'lock_' must be held by caller.
   void DecreaseReservationLocked(int64_t bytes, bool is_child_reservation);
 
+  /// Takes 'bytes' from 'child_slack_' for the reservation of a child. Returns false
+  /// without changing anything if the slack is less than 'bytes'. Does not acquire
+  /// 'lock_'.
+  bool TryTakeChildSlack(int64_t bytes);
+
+  /// Gives back 'bytes' of the reservation of a child. Up to 'child_slack_limit_' is
+  /// kept in 'child_slack_' without acquiring 'lock_', the rest is released with
+  /// DecreaseReservation().
+  void ReturnChildReservation(int64_t bytes);
+
+  /// Moves all of 'child_slack_' to the unused reservation. 'lock_' must be held by
+  /// caller.
+  void ReclaimChildSlackLocked();
+
   /// Return a vector containing the trackers on the path to the root tracker. Includes
   /// the current tracker and the root tracker.
   std::vector<ReservationTracker*> FindPathToRoot();
@@ -282,7 +309,7 @@ class ReservationTracker {
   /// order, if a MemTracker::child_trackers_lock_ is acquired while holding a lock_, any
   /// more calls to acquire a lock_ should not be made to avoid any deadlock that might
   /// occur due to ReservationTracker's bottom-up lock order.
-  SpinLock lock_;
+  TrackedSpinLock lock_{LockContention::RESERVATION_TRACKER};
 
   /// True if the tracker is initialized.
   bool initialized_ = false;
@@ -324,6 +351,15 @@ class ReservationTracker {
   /// 'used_reservation_' + 'child_reservations_' <= 'reservation_'.
   /// Can be read without holding lock.
   AtomicInt64 used_reservation_;
+
+  /// Reservation given back by children that is kept for them, see "Child slack" above.
+  /// Included in 'child_reservations_'. Updated with atomic operations by children
+  /// without holding 'lock_'.
+  AtomicInt64 child_slack_;
+
+  /// The maximum of 'child_slack_'. 0 for the root tracker. Does not change after
+  /// initialization.
+  int64_t child_slack_limit_ = 0;
 };
 }
 
@@ -349,6 +349,94 @@ TEST_F(SuballocatorTest, RandomAllocations) {
   ExpectReservationUnused(client);
 }
 
+/// Test that small allocations are served from slabs, which share MIN_ALLOCATION_BYTES
+/// buddy allocations and are freed when all their slots are free.
+TEST_F(SuballocatorTest, SlabAllocations) {
+  const int64_t TOTAL_MEM = TEST_BUFFER_LEN * 100;
+  InitPool(TEST_BUFFER_LEN, TOTAL_MEM);
+  BufferPool::ClientHandle* client;
+  RegisterClient(&global_reservation_, &client);
+  RuntimeProfile* profile = RuntimeProfile::Create(&obj_pool_, "slab profile");
+  Suballocator allocator(buffer_pool(), client, TEST_BUFFER_LEN, true, profile);
+
+  // Allocate one buffer worth of each slab class. Sizes are rounded up to the slab
+  // class, and the smallest class is MIN_SLAB_ALLOCATION_BYTES.
+  vector<unique_ptr<Suballocation>> allocs;
+  int64_t requested = 0;
+  for (int64_t len = Suballocator::MIN_SLAB_ALLOCATION_BYTES;
+       len <= Suballocator::MAX_SLAB_ALLOCATION_BYTES; len *= 2) {
+    for (int i = 0; i < TEST_BUFFER_LEN / len; ++i) {
+      int64_t alloc_size = i % 2 == 0 ? len : len / 2 + 1;
+      if (len == Suballocator::MIN_SLAB_ALLOCATION_BYTES && i % 4 == 1) alloc_size = 0;
+      allocs.emplace_back();
+      ASSERT_OK(allocator.Allocate(alloc_size, &allocs.back()));
+      ASSERT_TRUE(allocs.back() != nullptr) << alloc_size;
+      EXPECT_EQ(len, allocs.back()->len()) << alloc_size;
+      requested += alloc_size;
+    }
+  }
+  AssertMemoryValid(allocs);
+  const int NUM_SLAB_CLASSES = 4;
+  EXPECT_EQ(NUM_SLAB_CLASSES * TEST_BUFFER_LEN, allocator.allocated_bytes());
+  EXPECT_EQ(NUM_SLAB_CLASSES * TEST_BUFFER_LEN, client->GetUsedReservation());
+  EXPECT_EQ(allocator.allocated_bytes() - requested, allocator.internal_fragmentation());
+  EXPECT_EQ(allocator.internal_fragmentation(),
+      profile->GetCounter("PeakSuballocatorFragmentation")->value());
+  EXPECT_EQ(static_cast<int64_t>(allocs.size()),
+      profile->GetCounter("SuballocatorSlabAllocations")->value());
+
+  // Free every other allocation: no slab becomes empty, so no memory is released. New
+  // allocations of the same sizes reuse the free slots.
+  for (int i = 0; i < allocs.size(); i += 2) {
+    const int64_t len = allocs[i]->len();
+    allocator.Free(move(allocs[i]));
+    EXPECT_EQ(NUM_SLAB_CLASSES * TEST_BUFFER_LEN, client->GetUsedReservation());
+    ASSERT_OK(allocator.Allocate(len, &allocs[i]));
+    ASSERT_TRUE(allocs[i] != nullptr);
+  }
+  EXPECT_EQ(NUM_SLAB_CLASSES * TEST_BUFFER_LEN, client->GetUsedReservation());
+  AssertMemoryValid(allocs);
+
+  // All memory is released when the allocations are freed.
+  FreeAllocations(&allocator, &allocs);
+  EXPECT_EQ(0, allocator.internal_fragmentation());
+  ExpectReservationUnused(client);
+}
+
+/// Randomised test of a mix of slab and buddy allocations.
+TEST_F(SuballocatorTest, RandomSlabAllocations) {
+  const int64_t TOTAL_MEM = TEST_BUFFER_LEN * 100;
+  InitPool(TEST_BUFFER_LEN, TOTAL_MEM);
+  BufferPool::ClientHandle* client;
+  RegisterClient(&global_reservation_, &client);
+  Suballocator allocator(buffer_pool(), client, TEST_BUFFER_LEN, true);
+
+  vector<unique_ptr<Suballocation>> allocs;
+  for (int iter = 0; iter < 10000; ++iter) {
+    if (allocs.empty() || uniform_int_distribution<int>(0, 2)(rng_) != 0) {
+      int64_t alloc_size = uniform_int_distribution<int64_t>(
+          1, 2 * Suballocator::MIN_ALLOCATION_BYTES)(rng_);
+      unique_ptr<Suballocation> alloc;
+      ASSERT_OK(allocator.Allocate(alloc_size, &alloc));
+      if (alloc == nullptr) continue;
+      EXPECT_GE(alloc->len(), alloc_size);
+      EXPECT_LE(alloc->len(),
+          max(2 * alloc_size, Suballocator::MIN_SLAB_ALLOCATION_BYTES));
+      allocs.push_back(move(alloc));
+    } else {
+      int idx = uniform_int_distribution<int>(0, allocs.size() - 1)(rng_);
+      swap(allocs[idx], allocs.back());
+      allocator.Free(move(allocs.back()));
+      allocs.pop_back();
+    }
+    if (iter % 1000 == 0) AssertMemoryValid(allocs);
+  }
+  AssertMemoryValid(allocs);
+  FreeAllocations(&allocator, &allocs);
+  EXPECT_EQ(0, allocator.allocated_bytes());
+  ExpectReservationUnused(client);
+}
+
 void SuballocatorTest::AssertMemoryValid(
     const vector<unique_ptr<Suballocation>>& allocs) {
   for (int64_t i = 0; i < allocs.size(); ++i) {
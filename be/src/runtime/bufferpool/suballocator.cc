@@ -21,27 +21,78 @@
 
 #include "runtime/bufferpool/reservation-tracker.h"
 #include "util/bit-util.h"
+#include "util/runtime-profile-counters.h"
 
 #include "common/names.h"
 
+DEFINE_bool(suballocator_use_slabs, true, "(Advanced) If true, hash tables serve their "
+    "allocations of less than 4KB from slabs instead of rounding them up to 4KB.");
+
 namespace impala {
 
 constexpr int Suballocator::LOG_MAX_ALLOCATION_BYTES;
 constexpr int64_t Suballocator::MAX_ALLOCATION_BYTES;
 constexpr int Suballocator::LOG_MIN_ALLOCATION_BYTES;
 constexpr int64_t Suballocator::MIN_ALLOCATION_BYTES;
+constexpr int Suballocator::LOG_MIN_SLAB_ALLOCATION_BYTES;
+constexpr int64_t Suballocator::MIN_SLAB_ALLOCATION_BYTES;
+constexpr int64_t Suballocator::MAX_SLAB_ALLOCATION_BYTES;
 const int Suballocator::NUM_FREE_LISTS;
-
-Suballocator::Suballocator(
-    BufferPool* pool, BufferPool::ClientHandle* client, int64_t min_buffer_len)
-  : pool_(pool), client_(client), min_buffer_len_(min_buffer_len), allocated_(0) {}
+const int Suballocator::NUM_SLAB_CLASSES;
+
+/// A MIN_ALLOCATION_BYTES allocation of the buddy allocator that is divided into equal
+/// sized slots for the allocations of one slab class.
+struct Suballocator::Slab {
+  /// The buddy allocation with the memory of the slots.
+  unique_ptr<Suballocation> memory;
+
+  /// Index of the slab class.
+  int class_idx = -1;
+
+  /// Bit i is set if slot i is free. A slab has at most
+  /// MIN_ALLOCATION_BYTES / MIN_SLAB_ALLOCATION_BYTES slots.
+  uint32_t free_slots = 0;
+
+  /// True if the slab is in 'full_slabs_', false if it is in 'partial_slabs_'.
+  bool full = false;
+
+  /// The next slab in the list, which is owned by this slab, and the previous slab in
+  /// the list, which owns this slab. nullptr at the end and start of the list.
+  unique_ptr<Slab> next;
+  Slab* prev = nullptr;
+};
+
+static_assert(Suballocator::MIN_ALLOCATION_BYTES / Suballocator::MIN_SLAB_ALLOCATION_BYTES
+        <= 32, "Slab::free_slots must have a bit per slot");
+
+Suballocator::Suballocator(BufferPool* pool, BufferPool::ClientHandle* client,
+    int64_t min_buffer_len, bool use_slabs, RuntimeProfile* profile)
+  : pool_(pool),
+    client_(client),
+    min_buffer_len_(min_buffer_len),
+    allocated_(0),
+    use_slabs_(use_slabs) {
+  if (profile != nullptr) {
+    peak_fragmentation_counter_ =
+        profile->AddHighWaterMarkCounter("PeakSuballocatorFragmentation", TUnit::BYTES);
+    if (use_slabs_) {
+      slab_allocations_counter_ =
+          ADD_COUNTER(profile, "SuballocatorSlabAllocations", TUnit::UNIT);
+    }
+  }
+}
 
 Suballocator::~Suballocator() {
   // All allocations should be free and buffers deallocated.
   DCHECK_EQ(allocated_, 0);
+  DCHECK_EQ(requested_, 0);
   for (int i = 0; i < NUM_FREE_LISTS; ++i) {
     DCHECK(free_lists_[i] == nullptr);
   }
+  for (int i = 0; i < NUM_SLAB_CLASSES; ++i) {
+    DCHECK(partial_slabs_[i] == nullptr);
+    DCHECK(full_slabs_[i] == nullptr);
+  }
 }
 
 Status Suballocator::Allocate(int64_t bytes, unique_ptr<Suballocation>* result) {
@@ -51,8 +102,32 @@ Status Suballocator::Allocate(int64_t bytes, unique_ptr<Suballocation>* result)
                              "supported of $1 bytes",
         bytes, MAX_ALLOCATION_BYTES));
   }
+  unique_ptr<Suballocation> allocation;
+  if (use_slabs_ && bytes <= MAX_SLAB_ALLOCATION_BYTES) {
+    RETURN_IF_ERROR(AllocateFromSlab(bytes, &allocation));
+    if (allocation != nullptr && slab_allocations_counter_ != nullptr) {
+      slab_allocations_counter_->Add(1);
+    }
+  } else {
+    RETURN_IF_ERROR(AllocateBuddy(max(bytes, MIN_ALLOCATION_BYTES), &allocation));
+  }
+  if (allocation == nullptr) {
+    *result = nullptr;
+    return Status::OK();
+  }
+  allocation->requested_len_ = bytes;
+  allocated_ += allocation->len_;
+  requested_ += bytes;
+  if (peak_fragmentation_counter_ != nullptr) {
+    peak_fragmentation_counter_->Set(internal_fragmentation());
+  }
+  *result = move(allocation);
+  return Status::OK();
+}
+
+Status Suballocator::AllocateBuddy(int64_t bytes, unique_ptr<Suballocation>* result) {
+  DCHECK_GE(bytes, MIN_ALLOCATION_BYTES);
   unique_ptr<Suballocation> free_node;
-  bytes = max(bytes, MIN_ALLOCATION_BYTES);
   const int target_list_idx = ComputeListIndex(bytes);
   for (int i = target_list_idx; i < NUM_FREE_LISTS; ++i) {
     free_node = PopFreeListHead(i);
@@ -76,11 +151,51 @@ Status Suballocator::Allocate(int64_t bytes, unique_ptr<Suballocation>* result)
   }
 
   free_node->in_use_ = true;
-  allocated_ += free_node->len_;
   *result = move(free_node);
   return Status::OK();
 }
 
+Status Suballocator::AllocateFromSlab(int64_t bytes, unique_ptr<Suballocation>* result) {
+  DCHECK_LE(bytes, MAX_SLAB_ALLOCATION_BYTES);
+  const int class_idx = ComputeSlabClassIndex(bytes);
+  const int64_t slot_len = MIN_SLAB_ALLOCATION_BYTES << class_idx;
+  unique_ptr<Suballocation> allocation;
+  RETURN_IF_ERROR(Suballocation::Create(&allocation));
+  if (partial_slabs_[class_idx] == nullptr) {
+    unique_ptr<Slab> slab(new (nothrow) Slab());
+    if (slab == nullptr) return Status(TErrorCode::MEM_ALLOC_FAILED, sizeof(Slab));
+    RETURN_IF_ERROR(AllocateBuddy(MIN_ALLOCATION_BYTES, &slab->memory));
+    if (slab->memory == nullptr) {
+      *result = nullptr;
+      return Status::OK();
+    }
+    slab->class_idx = class_idx;
+    const int num_slots = MIN_ALLOCATION_BYTES / slot_len;
+    slab->free_slots = num_slots == 32 ? ~0U : (1U << num_slots) - 1;
+    AddToSlabList(&partial_slabs_[class_idx], move(slab));
+  }
+  Slab* slab = partial_slabs_[class_idx].get();
+  DCHECK_NE(slab->free_slots, 0);
+  const int slot = BitUtil::CountTrailingZeros(slab->free_slots);
+  slab->free_slots = BitUtil::UnsetBit(slab->free_slots, slot);
+  if (slab->free_slots == 0) {
+    unique_ptr<Slab> full_slab = RemoveFromSlabList(&partial_slabs_[class_idx], slab);
+    full_slab->full = true;
+    AddToSlabList(&full_slabs_[class_idx], move(full_slab));
+  }
+  allocation->data_ = slab->memory->data_ + slot * slot_len;
+  allocation->len_ = slot_len;
+  allocation->slab_ = slab;
+  allocation->in_use_ = true;
+  *result = move(allocation);
+  return Status::OK();
+}
+
+int Suballocator::ComputeSlabClassIndex(int64_t bytes) {
+  return max(0, BitUtil::Log2CeilingNonZero64(max<int64_t>(bytes, 1))
+      - LOG_MIN_SLAB_ALLOCATION_BYTES);
+}
+
 int Suballocator::ComputeListIndex(int64_t bytes) const {
   return BitUtil::Log2CeilingNonZero64(bytes) - LOG_MIN_ALLOCATION_BYTES;
 }
@@ -156,6 +271,56 @@ void Suballocator::Free(unique_ptr<Suballocation> allocation) {
   DCHECK(allocation->in_use_);
   allocation->in_use_ = false;
   allocated_ -= allocation->len_;
+  requested_ -= allocation->requested_len_;
+  if (allocation->slab_ != nullptr) {
+    FreeToSlab(move(allocation));
+  } else {
+    FreeBuddy(move(allocation));
+  }
+}
+
+void Suballocator::FreeToSlab(unique_ptr<Suballocation> allocation) {
+  DCHECK(!allocation->in_use_);
+  Slab* slab = allocation->slab_;
+  const int class_idx = slab->class_idx;
+  const int slot = (allocation->data_ - slab->memory->data_) / allocation->len_;
+  const int num_slots = MIN_ALLOCATION_BYTES / allocation->len_;
+  allocation.reset();
+  if (slab->full) {
+    unique_ptr<Slab> partial_slab = RemoveFromSlabList(&full_slabs_[class_idx], slab);
+    partial_slab->full = false;
+    AddToSlabList(&partial_slabs_[class_idx], move(partial_slab));
+  }
+  slab->free_slots = BitUtil::SetBit(slab->free_slots, slot);
+  if (slab->free_slots == (num_slots == 32 ? ~0U : (1U << num_slots) - 1)) {
+    // No slot is in use anymore, return the memory to the buddy allocator.
+    unique_ptr<Slab> free_slab = RemoveFromSlabList(&partial_slabs_[class_idx], slab);
+    free_slab->memory->in_use_ = false;
+    FreeBuddy(move(free_slab->memory));
+  }
+}
+
+void Suballocator::AddToSlabList(unique_ptr<Slab>* head, unique_ptr<Slab> slab) {
+  DCHECK(slab->prev == nullptr);
+  DCHECK(slab->next == nullptr);
+  if (*head != nullptr) (*head)->prev = slab.get();
+  slab->next = move(*head);
+  *head = move(slab);
+}
+
+unique_ptr<Suballocator::Slab> Suballocator::RemoveFromSlabList(
+    unique_ptr<Slab>* head, Slab* slab) {
+  if (slab->next != nullptr) slab->next->prev = slab->prev;
+  unique_ptr<Slab>* ptr_from_prev = slab->prev == nullptr ? head : &slab->prev->next;
+  slab->prev = nullptr;
+  unique_ptr<Slab> result = move(*ptr_from_prev);
+  *ptr_from_prev = move(slab->next);
+  return result;
+}
+
+void Suballocator::FreeBuddy(unique_ptr<Suballocation> allocation) {
+  DCHECK(!allocation->in_use_);
+  DCHECK(allocation->slab_ == nullptr);
 
   // Iteratively coalesce buddies until the buddy is in use or we get to the root.
   // This ensures that all buddies in the free lists are coalesced. I.e. we do not
@@ -22,6 +22,7 @@
 #include <memory>
 
 #include "runtime/bufferpool/buffer-pool.h"
+#include "util/runtime-profile.h"
 
 namespace impala {
 
@@ -39,7 +40,16 @@ class Suballocation;
 /// the implementation's constant-factor overhead is not optimised. Thus, the allocator
 /// is best suited for relatively large allocations where the constant CPU/memory
 /// overhead per allocation is not paramount, e.g. bucket directories of hash tables.
-/// All allocations less than MIN_ALLOCATION_BYTES are rounded up to that amount.
+/// All allocations less than MIN_ALLOCATION_BYTES are rounded up to that amount, unless
+/// the suballocator uses slabs.
+///
+/// Slabs:
+/// If enabled, allocations of at most MAX_SLAB_ALLOCATION_BYTES are served from slabs
+/// instead, e.g. the bucket directories of the hash tables of small join partitions.
+/// Each slab is a MIN_ALLOCATION_BYTES buddy allocation divided into equal-sized slots
+/// of a power-of-two slab class, with a bitmap of the free slots. Each slab class has a
+/// list of slabs with free slots, which allocations are served from, and a list of full
+/// slabs. A slab is returned to the buddy allocator as soon as all its slots are free.
 ///
 /// Methods of Suballocator are not thread safe.
 ///
@@ -66,15 +76,18 @@ class Suballocator {
  public:
   /// Constructs a suballocator that allocates memory from 'pool' with 'client'.
   /// Suballocations smaller than 'min_buffer_len' are handled by allocating a
-  /// buffer of 'min_buffer_len' and recursively splitting it.
-  Suballocator(
-      BufferPool* pool, BufferPool::ClientHandle* client, int64_t min_buffer_len);
+  /// buffer of 'min_buffer_len' and recursively splitting it. Small suballocations are
+  /// served from slabs if 'use_slabs' is true. If 'profile' is not nullptr, counters for
+  /// the internal fragmentation and the slab allocations are added to it.
+  Suballocator(BufferPool* pool, BufferPool::ClientHandle* client,
+      int64_t min_buffer_len, bool use_slabs = false, RuntimeProfile* profile = nullptr);
 
   ~Suballocator();
 
   /// Allocate bytes from BufferPool. The allocation is nullptr if unsuccessful because
   /// the client's reservation was insufficient. If an unexpected error is encountered,
   /// returns that status. The allocation size is rounded up to the next power-of-two.
+  /// The difference is accounted as internal fragmentation.
   /// The caller must always free the allocation by calling Free() (otherwise destructing
   /// the returned 'result' will DCHECK on debug builds or otherwise misbehave on release
   /// builds).
@@ -98,8 +111,50 @@ class Suballocator {
   static constexpr int LOG_MIN_ALLOCATION_BYTES = 12;
   static constexpr int64_t MIN_ALLOCATION_BYTES = 1L << LOG_MIN_ALLOCATION_BYTES;
 
+  /// The range of allocation sizes served from slabs, if enabled. Smaller allocations
+  /// are rounded up to MIN_SLAB_ALLOCATION_BYTES.
+  static constexpr int LOG_MIN_SLAB_ALLOCATION_BYTES = 8;
+  static constexpr int64_t MIN_SLAB_ALLOCATION_BYTES =
+      1L << LOG_MIN_SLAB_ALLOCATION_BYTES;
+  static constexpr int64_t MAX_SLAB_ALLOCATION_BYTES = MIN_ALLOCATION_BYTES / 2;
+
+  /// Returns the bytes of allocations that are not freed yet.
+  int64_t allocated_bytes() const { return allocated_; }
+
+  /// Returns the bytes that allocations which are not freed yet were rounded up by.
+  int64_t internal_fragmentation() const { return allocated_ - requested_; }
+
  private:
   DISALLOW_COPY_AND_ASSIGN(Suballocator);
+  friend class Suballocation;
+
+  struct Slab;
+
+  /// Allocate 'bytes' with the buddy allocator. 'bytes' must be at least
+  /// MIN_ALLOCATION_BYTES. Same semantics as Allocate() otherwise.
+  Status AllocateBuddy(int64_t bytes, std::unique_ptr<Suballocation>* result);
+
+  /// Free an allocation of the buddy allocator. The allocation must not be in use.
+  void FreeBuddy(std::unique_ptr<Suballocation> allocation);
+
+  /// Allocate 'bytes' <= MAX_SLAB_ALLOCATION_BYTES from a slab of the slab class that
+  /// fits 'bytes', allocating a new slab if no slab of the class has a free slot. Same
+  /// semantics as Allocate() otherwise.
+  Status AllocateFromSlab(int64_t bytes, std::unique_ptr<Suballocation>* result);
+
+  /// Free an allocation of a slab. The allocation must not be in use. Frees the slab if
+  /// none of its slots is in use anymore.
+  void FreeToSlab(std::unique_ptr<Suballocation> allocation);
+
+  /// Compute the index of the slab class for allocations of 'bytes'.
+  static int ComputeSlabClassIndex(int64_t bytes);
+
+  /// Add 'slab' to the front of the doubly-linked list starting at 'head'.
+  static void AddToSlabList(std::unique_ptr<Slab>* head, std::unique_ptr<Slab> slab);
+
+  /// Remove 'slab' from the doubly-linked list starting at 'head'.
+  static std::unique_ptr<Slab> RemoveFromSlabList(
+      std::unique_ptr<Slab>* head, Slab* slab);
 
   /// Compute the index for allocations of size 'bytes' in 'free_lists_'. 'bytes' is
   /// rounded up to the next power-of-two if it is not already a power-of-two.
@@ -144,6 +199,26 @@ class Suballocator {
   /// Track how much memory has been returned in allocations but not freed.
   int64_t allocated_;
 
+  /// The bytes requested for the allocations in 'allocated_', before rounding up.
+  int64_t requested_ = 0;
+
+  /// Whether allocations of at most MAX_SLAB_ALLOCATION_BYTES are served from slabs.
+  const bool use_slabs_;
+
+  /// Slabs of each slab class, indexed by log2 of the slot size minus
+  /// LOG_MIN_SLAB_ALLOCATION_BYTES. Slabs with free slots are in 'partial_slabs_', the
+  /// other slabs are in 'full_slabs_'. Both are doubly-linked lists.
+  static constexpr int NUM_SLAB_CLASSES =
+      LOG_MIN_ALLOCATION_BYTES - LOG_MIN_SLAB_ALLOCATION_BYTES;
+  std::unique_ptr<Slab> partial_slabs_[NUM_SLAB_CLASSES];
+  std::unique_ptr<Slab> full_slabs_[NUM_SLAB_CLASSES];
+
+  /// Peak of internal_fragmentation(). nullptr if no profile was provided.
+  RuntimeProfile::HighWaterMarkCounter* peak_fragmentation_counter_ = nullptr;
+
+  /// Number of allocations served from slabs. nullptr if no profile was provided.
+  RuntimeProfile::Counter* slab_allocations_counter_ = nullptr;
+
   /// Free lists for each supported power-of-two size. Statically allocate the maximum
   /// possible number of lists for simplicity. Indexed by log2 of the allocation size
   /// minus log2 of the minimum allocation size, e.g. 16k allocations are at index 2.
@@ -183,12 +258,25 @@ class Suballocation {
 
   // The actual constructor - Create() is used for its better error handling.
   Suballocation()
-    : data_(nullptr), len_(-1), buddy_(nullptr), prev_free_(nullptr), in_use_(false) {}
+    : data_(nullptr),
+      len_(-1),
+      requested_len_(0),
+      slab_(nullptr),
+      buddy_(nullptr),
+      prev_free_(nullptr),
+      in_use_(false) {}
 
   /// The allocation's data and its length.
   uint8_t* data_;
   int64_t len_;
 
+  /// The length that was passed to Allocate(), if this was returned by Allocate().
+  int64_t requested_len_;
+
+  /// The slab that the allocation is a slot of, or nullptr if the allocation was made by
+  /// the buddy allocator. Slab allocations are not part of any tree of buddies.
+  Suballocator::Slab* slab_;
+
   /// The buffer backing the Suballocation, if the Suballocation is backed by an entire
   /// buffer. Otherwise uninitialized. 'buffer_' is open iff 'buddy_' is nullptr.
   BufferPool::BufferHandle buffer_;
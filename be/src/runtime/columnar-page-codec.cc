@@ -0,0 +1,296 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/columnar-page-codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "runtime/descriptors.h"
+#include "runtime/string-value.h"
+#include "runtime/tuple.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+namespace {
+
+/// Returns the number of bits needed to store the differences in [min_val, max_val].
+int BitWidth(int64_t min_val, int64_t max_val) {
+  const uint64_t range = static_cast<uint64_t>(max_val) - static_cast<uint64_t>(min_val);
+  return range == 0 ? 0 : BitUtil::Log2Floor64(range) + 1;
+}
+
+/// Bit-packed values of 'bit_width' bits are stored little-endian, with value 'idx'
+/// starting at bit 'idx' * 'bit_width'. The buffer must have FOR_PADDING_LEN bytes
+/// after the packed values.
+inline void PutBits(uint8_t* packed, int64_t idx, int bit_width, uint64_t v) {
+  if (bit_width == 0) return;
+  const int64_t bit_pos = idx * bit_width;
+  uint8_t* p = packed + (bit_pos >> 3);
+  const int shift = bit_pos & 7;
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  word |= v << shift;
+  memcpy(p, &word, sizeof(word));
+  if (shift + bit_width > 64) p[sizeof(word)] |= v >> (64 - shift);
+}
+
+inline uint64_t GetBits(const uint8_t* packed, int64_t idx, int bit_width) {
+  if (bit_width == 0) return 0;
+  const int64_t bit_pos = idx * bit_width;
+  const uint8_t* p = packed + (bit_pos >> 3);
+  const int shift = bit_pos & 7;
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  uint64_t v = word >> shift;
+  if (shift + bit_width > 64) v |= static_cast<uint64_t>(p[sizeof(word)]) << (64 - shift);
+  return bit_width == 64 ? v : v & ((1UL << bit_width) - 1);
+}
+
+bool IsIntegerType(PrimitiveType type) {
+  switch (type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_DATE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+Status CorruptPageError() {
+  return Status(TErrorCode::INTERNAL_ERROR, "Spilled tuple stream page is corrupt");
+}
+
+}
+
+ColumnarPageCodec::ColumnarPageCodec(const RowDescriptor& row_desc,
+    const vector<pair<int, vector<SlotDescriptor*>>>& inlined_string_slots) {
+  vector<int> tuple_offsets;
+  for (const TupleDescriptor* tuple_desc : row_desc.tuple_descriptors()) {
+    tuple_offsets.push_back(fixed_row_len_);
+    AddTupleColumns(tuple_desc->slots(), fixed_row_len_, tuple_desc->byte_size());
+    fixed_row_len_ += tuple_desc->byte_size();
+  }
+  for (const auto& tuple_slots : inlined_string_slots) {
+    for (const SlotDescriptor* slot : tuple_slots.second) {
+      string_slots_.emplace_back(tuple_offsets[tuple_slots.first], slot);
+    }
+  }
+}
+
+void ColumnarPageCodec::AddTupleColumns(
+    const vector<SlotDescriptor*>& slots, int tuple_offset, int tuple_len) {
+  vector<const SlotDescriptor*> sorted_slots(slots.begin(), slots.end());
+  sort(sorted_slots.begin(), sorted_slots.end(),
+      [](const SlotDescriptor* a, const SlotDescriptor* b) {
+        return a->tuple_offset() < b->tuple_offset();
+      });
+  // Bytes that are not part of a slot, e.g. null indicators, get a column each.
+  int pos = 0;
+  auto add_bytes_until = [this, tuple_offset, &pos](int end) {
+    for (; pos < end; ++pos) columns_.push_back({tuple_offset + pos, 1, true, false});
+  };
+  for (const SlotDescriptor* slot : sorted_slots) {
+    const int offset = slot->tuple_offset();
+    const int len = slot->slot_size();
+    if (len <= 0 || offset < pos || offset + len > tuple_len) continue;
+    add_bytes_until(offset);
+    const bool frame_of_reference = IsIntegerType(slot->type().type)
+        && (len == 1 || len == 2 || len == 4 || len == 8);
+    columns_.push_back({tuple_offset + offset, len, frame_of_reference, true});
+    pos = offset + len;
+  }
+  add_bytes_until(tuple_len);
+}
+
+int64_t ColumnarPageCodec::ReadValue(const Column& col, const uint8_t* row) {
+  const uint8_t* p = row + col.offset;
+  switch (col.len) {
+    case 1:
+      return col.is_signed ? *reinterpret_cast<const int8_t*>(p) : *p;
+    case 2: {
+      int16_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    case 4: {
+      int32_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+    default: {
+      DCHECK_EQ(col.len, 8);
+      int64_t v;
+      memcpy(&v, p, sizeof(v));
+      return v;
+    }
+  }
+}
+
+int64_t ColumnarPageCodec::VarLenBytes(const uint8_t* row) const {
+  int64_t len = 0;
+  for (const auto& string_slot : string_slots_) {
+    const Tuple* tuple = reinterpret_cast<const Tuple*>(row + string_slot.first);
+    const SlotDescriptor* slot = string_slot.second;
+    if (tuple->IsNull(slot->null_indicator_offset())) continue;
+    const int slot_len = tuple->GetStringSlot(slot->tuple_offset())->len;
+    // Only possible for corrupt pages.
+    if (UNLIKELY(slot_len < 0)) return -1;
+    len += slot_len;
+  }
+  return len;
+}
+
+int64_t ColumnarPageCodec::Encode(
+    const uint8_t* rows, int num_rows, uint8_t* out, int64_t out_len) const {
+  DCHECK_GT(num_rows, 0);
+  // Find the range of each frame-of-reference column.
+  vector<int64_t> min_vals(columns_.size(), numeric_limits<int64_t>::max());
+  vector<int64_t> max_vals(columns_.size(), numeric_limits<int64_t>::min());
+  int64_t var_len_bytes = 0;
+  const uint8_t* row = rows;
+  for (int r = 0; r < num_rows; ++r) {
+    for (int c = 0; c < columns_.size(); ++c) {
+      if (!columns_[c].frame_of_reference) continue;
+      const int64_t v = ReadValue(columns_[c], row);
+      min_vals[c] = min(min_vals[c], v);
+      max_vals[c] = max(max_vals[c], v);
+    }
+    const int64_t row_var_len_bytes = VarLenBytes(row);
+    DCHECK_GE(row_var_len_bytes, 0);
+    var_len_bytes += row_var_len_bytes;
+    row += fixed_row_len_ + row_var_len_bytes;
+  }
+
+  // Lay out and write the headers.
+  vector<int> bit_widths(columns_.size(), 0);
+  vector<int64_t> column_starts(columns_.size());
+  int64_t pos = 0;
+  for (int c = 0; c < columns_.size(); ++c) {
+    if (columns_[c].frame_of_reference) pos += FOR_HEADER_LEN;
+  }
+  for (int c = 0; c < columns_.size(); ++c) {
+    column_starts[c] = pos;
+    if (columns_[c].frame_of_reference) {
+      bit_widths[c] = BitWidth(min_vals[c], max_vals[c]);
+      pos += BitUtil::Ceil(static_cast<int64_t>(num_rows) * bit_widths[c], 8)
+          + FOR_PADDING_LEN;
+    } else {
+      pos += static_cast<int64_t>(num_rows) * columns_[c].len;
+    }
+  }
+  int64_t var_len_pos = pos;
+  const int64_t encoded_len = pos + var_len_bytes;
+  if (encoded_len > out_len) return -1;
+  uint8_t* header = out;
+  for (int c = 0; c < columns_.size(); ++c) {
+    if (!columns_[c].frame_of_reference) continue;
+    memcpy(header, &min_vals[c], sizeof(int64_t));
+    header[sizeof(int64_t)] = bit_widths[c];
+    header += FOR_HEADER_LEN;
+    // PutBits() ORs the values into the column.
+    const int64_t column_end =
+        c + 1 < columns_.size() ? column_starts[c + 1] : var_len_pos;
+    memset(out + column_starts[c], 0, column_end - column_starts[c]);
+  }
+
+  // Write the values.
+  row = rows;
+  for (int r = 0; r < num_rows; ++r) {
+    for (int c = 0; c < columns_.size(); ++c) {
+      const Column& col = columns_[c];
+      uint8_t* column = out + column_starts[c];
+      if (col.frame_of_reference) {
+        const uint64_t delta = static_cast<uint64_t>(ReadValue(col, row))
+            - static_cast<uint64_t>(min_vals[c]);
+        PutBits(column, r, bit_widths[c], delta);
+      } else {
+        memcpy(column + static_cast<int64_t>(r) * col.len, row + col.offset, col.len);
+      }
+    }
+    const int64_t row_var_len_bytes = VarLenBytes(row);
+    memcpy(out + var_len_pos, row + fixed_row_len_, row_var_len_bytes);
+    var_len_pos += row_var_len_bytes;
+    row += fixed_row_len_ + row_var_len_bytes;
+  }
+  DCHECK_EQ(var_len_pos, encoded_len);
+  return encoded_len;
+}
+
+Status ColumnarPageCodec::Decode(const uint8_t* in, int64_t in_len, int num_rows,
+    uint8_t* rows, int64_t rows_len) const {
+  // Read the headers and lay out the columns like Encode().
+  vector<int64_t> min_vals(columns_.size(), 0);
+  vector<int> bit_widths(columns_.size(), 0);
+  vector<int64_t> column_starts(columns_.size());
+  int64_t pos = 0;
+  for (int c = 0; c < columns_.size(); ++c) {
+    if (!columns_[c].frame_of_reference) continue;
+    if (pos + FOR_HEADER_LEN > in_len) return CorruptPageError();
+    memcpy(&min_vals[c], in + pos, sizeof(int64_t));
+    bit_widths[c] = in[pos + sizeof(int64_t)];
+    if (bit_widths[c] > 64) return CorruptPageError();
+    pos += FOR_HEADER_LEN;
+  }
+  for (int c = 0; c < columns_.size(); ++c) {
+    column_starts[c] = pos;
+    if (columns_[c].frame_of_reference) {
+      pos += BitUtil::Ceil(static_cast<int64_t>(num_rows) * bit_widths[c], 8)
+          + FOR_PADDING_LEN;
+    } else {
+      pos += static_cast<int64_t>(num_rows) * columns_[c].len;
+    }
+  }
+  if (pos > in_len) return CorruptPageError();
+  int64_t var_len_pos = pos;
+
+  uint8_t* row = rows;
+  const uint8_t* rows_end = rows + rows_len;
+  for (int r = 0; r < num_rows; ++r) {
+    if (row + fixed_row_len_ > rows_end) return CorruptPageError();
+    for (int c = 0; c < columns_.size(); ++c) {
+      const Column& col = columns_[c];
+      const uint8_t* column = in + column_starts[c];
+      if (col.frame_of_reference) {
+        const uint64_t v =
+            static_cast<uint64_t>(min_vals[c]) + GetBits(column, r, bit_widths[c]);
+        // The low-order bytes hold the value on little-endian machines.
+        memcpy(row + col.offset, &v, col.len);
+      } else {
+        memcpy(row + col.offset, column + static_cast<int64_t>(r) * col.len, col.len);
+      }
+    }
+    const int64_t row_var_len_bytes = VarLenBytes(row);
+    if (row_var_len_bytes < 0 || var_len_pos + row_var_len_bytes > in_len
+        || row + fixed_row_len_ + row_var_len_bytes > rows_end) {
+      return CorruptPageError();
+    }
+    memcpy(row + fixed_row_len_, in + var_len_pos, row_var_len_bytes);
+    var_len_pos += row_var_len_bytes;
+    row += fixed_row_len_ + row_var_len_bytes;
+  }
+  return Status::OK();
+}
+}
@@ -0,0 +1,107 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/status.h"
+
+namespace impala {
+
+class RowDescriptor;
+class SlotDescriptor;
+
+/// Transposes the rows of a BufferedTupleStream page into columns before the page is
+/// spilled, and restores the row layout when the page is read back. The encoding is
+/// lossless, so the restored page is byte for byte the page that was encoded.
+///
+/// Only streams without nullable tuples and without inlined collections are supported.
+/// All rows of such a stream have the same fixed length part, followed by the inlined
+/// string data of the row, so a column of a page is a slot, or a byte between slots, of
+/// every row. Integer slots and the bytes between slots, which hold the null indicators,
+/// are stored with frame-of-reference encoding: the minimum value of the page followed
+/// by the bit-packed differences to it. Other slots are stored as they are, one after
+/// the other. The inlined string data of all rows follows the columns. Storing values of
+/// the same slot next to each other makes the page shrink much more with the disk spill
+/// compression codec.
+///
+/// Encoded page layout:
+///  <- headers -> <- column 0 -> ... <- column n -> <- string data ->
+/// with a 9 byte header (minimum, bit width) per frame-of-reference column.
+class ColumnarPageCodec {
+ public:
+  /// 'inlined_string_slots' are the string slots whose data is stored in the stream,
+  /// grouped by tuple index, as in BufferedTupleStream.
+  ColumnarPageCodec(const RowDescriptor& row_desc,
+      const std::vector<std::pair<int, std::vector<SlotDescriptor*>>>&
+          inlined_string_slots);
+
+  /// Encodes the 'num_rows' rows that start at 'rows' to 'out', which has room for
+  /// 'out_len' bytes. Returns the length of the encoded page, or -1 if it does not fit.
+  int64_t Encode(const uint8_t* rows, int num_rows, uint8_t* out, int64_t out_len) const;
+
+  /// Restores the 'num_rows' rows of the 'in_len' bytes at 'in', which were encoded
+  /// with Encode(), to 'rows', which has room for 'rows_len' bytes. Returns an error if
+  /// the encoded page is corrupt.
+  Status Decode(const uint8_t* in, int64_t in_len, int num_rows, uint8_t* rows,
+      int64_t rows_len) const WARN_UNUSED_RESULT;
+
+ private:
+  /// A slot or a byte between slots of the fixed length part of the rows.
+  struct Column {
+    /// Offset in the fixed length part of the row.
+    int offset;
+    /// Size of the values in bytes.
+    int len;
+    /// Whether the values are stored with frame-of-reference encoding. Only set for
+    /// values of 1, 2, 4 or 8 bytes.
+    bool frame_of_reference;
+    /// Whether frame-of-reference values are signed.
+    bool is_signed;
+  };
+
+  /// Bytes of the header of a frame-of-reference column: the minimum and the bit width.
+  static constexpr int FOR_HEADER_LEN = sizeof(int64_t) + 1;
+
+  /// Extra bytes after bit-packed values, so that a value can be read and written with
+  /// unaligned 8 byte loads and stores.
+  static constexpr int FOR_PADDING_LEN = sizeof(uint64_t) + 1;
+
+  /// Appends the columns for a tuple of 'tuple_len' bytes at 'tuple_offset' to
+  /// 'columns_'.
+  void AddTupleColumns(const std::vector<SlotDescriptor*>& slots, int tuple_offset,
+      int tuple_len);
+
+  /// Returns the value of 'col' in the fixed length part 'row'.
+  static int64_t ReadValue(const Column& col, const uint8_t* row);
+
+  /// Returns the bytes of inlined string data of the row whose fixed length part is
+  /// 'row'.
+  int64_t VarLenBytes(const uint8_t* row) const;
+
+  /// Length of the fixed length part of a row.
+  int fixed_row_len_ = 0;
+
+  std::vector<Column> columns_;
+
+  /// The inlined string slots, with the offset of their tuple in the row.
+  std::vector<std::pair<int, const SlotDescriptor*>> string_slots_;
+};
+}
@@ -38,6 +38,7 @@
 #include "runtime/fragment-instance-state.h"
 #include "runtime/krpc-data-stream-sender.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/query-exec-mgr.h"
 #include "service/control-service.h"
 #include "service/data-stream-service.h"
 #include "util/counting-barrier.h"
@@ -227,17 +228,7 @@ void Coordinator::BackendState::ExecCompleteCb(
       goto done;
     }
 
-    Status exec_status = Status(exec_response_.status());
-    if (!exec_status.ok()) {
-      SetExecError(exec_status, exec_status_barrier);
-      goto done;
-    }
-
-    for (const auto& entry : instance_stats_map_) entry.second->stopwatch_.Start();
-    VLOG_FILE << "rpc succeeded: ExecQueryFInstances query_id=" << PrintId(query_id_);
-    exec_done_ = true;
-    last_report_time_ms_ = GenerateReportTimestamp();
-    exec_status_barrier->Notify(Status::OK());
+    SetExecStatus(Status(exec_response_.status()), exec_status_barrier);
   }
 done:
   // Notify after releasing 'lock_' so that we don't wake up a thread just to have it
@@ -262,6 +253,12 @@ void Coordinator::BackendState::ExecAsync(const DebugOptions& debug_options,
       goto done;
     }
 
+    if (backend_exec_params_.is_coord_backend()
+        && exec_params_.query_options().start_local_fragments_directly) {
+      StartLocally(debug_options, filter_routing_table, exec_status_barrier);
+      goto done;
+    }
+
     std::unique_ptr<ControlServiceProxy> proxy;
     Status get_proxy_status = ControlService::GetProxy(
         FromNetworkAddressPB(krpc_host_), host_.hostname(), &proxy);
@@ -324,6 +321,37 @@ done:
   exec_done_cv_.NotifyAll();
 }
 
+void Coordinator::BackendState::StartLocally(const DebugOptions& debug_options,
+    const FilterRoutingTable& filter_routing_table,
+    TypedCountingBarrier<Status>* exec_status_barrier) {
+  ExecQueryFInstancesRequestPB request;
+  TExecPlanFragmentInfo fragment_info;
+  SetRpcParams(debug_options, filter_routing_table, &request, &fragment_info);
+  VLOG_FILE << "starting fragment instances locally query_id=" << PrintId(query_id_);
+  const int64_t start_ms = MonotonicMillis();
+  // Like the rpc handler, StartQuery() only initializes the QueryState and hands the
+  // execution over to a new thread.
+  Status exec_status = ExecEnv::GetInstance()->query_exec_mgr()->StartQuery(
+      &request, query_ctx_, fragment_info);
+  rpc_latency_ = MonotonicMillis() - start_ms;
+  // Cancel() sends a CancelQueryFInstances rpc, the same as for a started rpc.
+  exec_rpc_sent_ = true;
+  SetExecStatus(exec_status, exec_status_barrier);
+}
+
+void Coordinator::BackendState::SetExecStatus(
+    const Status& exec_status, TypedCountingBarrier<Status>* exec_status_barrier) {
+  if (!exec_status.ok()) {
+    SetExecError(exec_status, exec_status_barrier);
+    return;
+  }
+  for (const auto& entry : instance_stats_map_) entry.second->stopwatch_.Start();
+  VLOG_FILE << "ExecQueryFInstances succeeded query_id=" << PrintId(query_id_);
+  exec_done_ = true;
+  last_report_time_ms_ = GenerateReportTimestamp();
+  exec_status_barrier->Notify(Status::OK());
+}
+
 Status Coordinator::BackendState::GetStatus(bool* is_fragment_failure,
     TUniqueId* failed_instance_id) {
   lock_guard<mutex> l(lock_);
@@ -352,6 +380,46 @@ void Coordinator::BackendState::MergeErrorLog(ErrorLogMap* merged) {
   if (error_log_.size() > 0)  MergeErrorMaps(error_log_, merged);
 }
 
+void Coordinator::BackendState::GetScanRates(
+    int64_t min_completion_time_ns, std::unordered_map<int, double>* rates) {
+  lock_guard<mutex> l(lock_);
+  DCHECK(exec_done_) << "May only be called after WaitOnExecRpc() completes.";
+  // Total split size and completion time of the finished instances per fragment.
+  std::unordered_map<int, std::pair<int64_t, int64_t>> totals;
+  for (const auto& entry : instance_stats_map_) {
+    const InstanceStats* instance_stats = entry.second;
+    if (!instance_stats->done_ || !instance_stats->completion_time_set_) continue;
+    if (instance_stats->total_split_size_ == 0) continue;
+    if (instance_stats->completion_time_ < min_completion_time_ns) continue;
+    int fragment_idx = instance_stats->exec_params_.fragment_idx();
+    std::pair<int64_t, int64_t>* total = &totals[fragment_idx];
+    total->first += instance_stats->total_split_size_;
+    total->second += instance_stats->completion_time_;
+  }
+  for (const auto& entry : totals) {
+    (*rates)[entry.first] = entry.second.first / (entry.second.second / 1e9);
+  }
+}
+
+void Coordinator::BackendState::GetScanInstanceTimes(
+    std::unordered_map<int, vector<int64_t>>* completion_times,
+    std::unordered_map<int, vector<int64_t>>* running_times) {
+  lock_guard<mutex> l(lock_);
+  DCHECK(exec_done_) << "May only be called after WaitOnExecRpc() completes.";
+  for (const auto& entry : instance_stats_map_) {
+    const InstanceStats* instance_stats = entry.second;
+    if (instance_stats->total_split_size_ == 0) continue;
+    int fragment_idx = instance_stats->exec_params_.fragment_idx();
+    // The stopwatch is stopped once the final report of the instance arrives.
+    int64_t elapsed_time = instance_stats->stopwatch_.ElapsedTime();
+    if (instance_stats->done_) {
+      (*completion_times)[fragment_idx].push_back(elapsed_time);
+    } else {
+      (*running_times)[fragment_idx].push_back(elapsed_time);
+    }
+  }
+}
+
 bool Coordinator::BackendState::HasFragmentIdx(int fragment_idx) const {
   return fragments_.count(fragment_idx) > 0;
 }
@@ -819,6 +887,7 @@ void Coordinator::BackendState::InstanceStats::UpdateExecStats(
   if (!completion_time_set_ && (finalize || done_)) {
     // Set the completion time if the query or instance finished.
     int64_t completion_time = stopwatch_.ElapsedTime();
+    completion_time_ = completion_time;
     RuntimeProfile::Counter* completion_timer =
         PROFILE_CompletionTime.Instantiate(profile_);
     completion_timer->Set(completion_time);
@@ -95,7 +95,9 @@ class Coordinator::BackendState {
   /// GetStatus() after WaitOnExecRpc() returns.
   /// Uses 'filter_routing_table' to remove filters that weren't selected during its
   /// construction.
-  /// No RPC is issued if there are no fragment instances scheduled on this backend.
+  /// No RPC is issued if there are no fragment instances scheduled on this backend, or
+  /// if this is the coordinator's backend and START_LOCAL_FRAGMENTS_DIRECTLY is set, in
+  /// which case the instances are started on the calling thread.
   /// The 'debug_options' are applied to the appropriate TPlanFragmentInstanceCtxs, based
   /// on their node_id/instance_idx.
   void ExecAsync(const DebugOptions& debug_options,
@@ -194,6 +196,20 @@ class Coordinator::BackendState {
   /// Merge the accumulated error log into 'merged'.
   void MergeErrorLog(ErrorLogMap* merged);
 
+  /// Adds the scan rate of this backend for each fragment that scans splits to 'rates',
+  /// keyed by the fragment index. The rate is the total split size in bytes of the
+  /// finished instances of the fragment divided by their total completion time in
+  /// seconds. Only instances that ran for at least 'min_completion_time_ns' count.
+  void GetScanRates(
+      int64_t min_completion_time_ns, std::unordered_map<int, double>* rates);
+
+  /// Adds the completion time in ns of each finished instance of this backend that scans
+  /// splits to 'completion_times' and the time in ns that each unfinished such instance
+  /// has been running so far to 'running_times', both keyed by the fragment index.
+  void GetScanInstanceTimes(
+      std::unordered_map<int, std::vector<int64_t>>* completion_times,
+      std::unordered_map<int, std::vector<int64_t>>* running_times);
+
   /// Return true if this backend has instances of the fragment with the index
   /// 'fragment_idx'
   bool HasFragmentIdx(int fragment_idx) const;
@@ -320,6 +336,9 @@ class Coordinator::BackendState {
     /// wall clock timer for this instance
     MonotonicStopWatch stopwatch_;
 
+    /// Completion time in ns of this instance, set with 'completion_time_set_'.
+    int64_t completion_time_ = 0;
+
     /// Descriptor string for the last query status report time in the profile.
     static const char* LAST_REPORT_TIME_DESC;
 
@@ -450,6 +469,20 @@ class Coordinator::BackendState {
   void SetExecError(
       const Status& status, TypedCountingBarrier<Status>* exec_status_barrier);
 
+  /// Starts the fragment instances of this backend, which must be the coordinator's
+  /// backend, by calling QueryExecMgr::StartQuery() directly instead of issuing an
+  /// ExecQueryFInstances rpc. Used if the query option START_LOCAL_FRAGMENTS_DIRECTLY
+  /// is set. Notifies 'exec_status_barrier' with the result. Caller must hold 'lock_'.
+  void StartLocally(const DebugOptions& debug_options,
+      const FilterRoutingTable& filter_routing_table,
+      TypedCountingBarrier<Status>* exec_status_barrier);
+
+  /// Completes the start of execution on this backend with 'exec_status', the result of
+  /// the ExecQueryFInstances rpc or of StartLocally(), and notifies
+  /// 'exec_status_barrier'. Caller must hold 'lock_'.
+  void SetExecStatus(
+      const Status& exec_status, TypedCountingBarrier<Status>* exec_status_barrier);
+
   /// Same as WaitOnExecRpc(), except 'l' must own 'lock_'.
   void WaitOnExecLocked(std::unique_lock<std::mutex>* l);
 
@@ -20,6 +20,7 @@
 #include <cerrno>
 #include <iomanip>
 #include <sstream>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <thrift/protocol/TDebugProtocol.h>
@@ -57,10 +58,13 @@
 #include "util/hdfs-bulk-ops.h"
 #include "util/hdfs-util.h"
 #include "util/histogram-metric.h"
+#include "util/in-list-filter.h"
 #include "util/kudu-status-util.h"
 #include "util/min-max-filter.h"
+#include "util/network-util.h"
 #include "util/pretty-printer.h"
 #include "util/table-printer.h"
+#include "util/time.h"
 #include "util/uid-util.h"
 
 #include "common/names.h"
@@ -80,6 +84,27 @@ using boost::filesystem::path;
 DECLARE_bool(gen_experimental_profile);
 DECLARE_string(hostname);
 
+DEFINE_double(slow_executor_rate_ratio, 0, "(Advanced) If greater than 0, the "
+    "coordinator of a successful query reports an executor to the cluster membership "
+    "as slow if the executor scanned a fragment's splits at a rate more than this many "
+    "times lower than the median rate of all executors of the fragment. Executors that "
+    "are reported repeatedly are deprioritized by the scheduler and eventually "
+    "blacklisted, see --slow_executor_reports_to_suspect. 0 disables the detection.");
+
+/// Minimum number of backends that a fragment must run on for its per-backend scan
+/// rates to be compared in Coordinator::DetectSlowBackends().
+static const int MIN_BACKENDS_FOR_SLOW_DETECTION = 3;
+
+/// Minimum completion time of a fragment instance for its scan rate to be meaningful.
+static const int64_t MIN_COMPLETION_TIME_FOR_SLOW_DETECTION = 1000L * 1000L * 1000L;
+
+/// Minimum time between two checks for stragglers in Coordinator::CheckForStragglers().
+static const int64_t STRAGGLER_CHECK_INTERVAL_MS = 1000;
+
+/// Minimum time that a scan fragment instance must have been running to be considered
+/// a straggler, so that short queries are never retried.
+static const int64_t MIN_STRAGGLER_RUNNING_TIME_NS = 5L * 1000L * 1000L * 1000L;
+
 using namespace impala;
 
 PROFILE_DEFINE_COUNTER(NumBackends, STABLE_HIGH, TUnit::UNIT,
@@ -381,10 +406,10 @@ void Coordinator::InitFilterRoutingTable() {
       if (!plan_node.__isset.runtime_filters) continue;
       for (const TRuntimeFilterDesc& filter: plan_node.runtime_filters) {
         DCHECK(filter_mode_ == TRuntimeFilterMode::GLOBAL || filter.has_local_targets);
-        // Currently hash joins are the only filter sources. Otherwise it must be
+        // Hash joins and top-n nodes are the only filter sources. Otherwise it must be
         // a filter consumer.
-        if (plan_node.__isset.join_node &&
-            plan_node.join_node.__isset.hash_join_node) {
+        if ((plan_node.__isset.join_node && plan_node.join_node.__isset.hash_join_node)
+            || plan_node.__isset.sort_node) {
           AddFilterSource(
               fragment_params, num_instances, num_backends, filter, plan_node.node_id);
         } else if (plan_node.__isset.hdfs_scan_node || plan_node.__isset.kudu_scan_node) {
@@ -416,10 +441,9 @@ void Coordinator::AddFilterSource(const FragmentExecParamsPB& src_fragment_param
   // Set the 'pending_count_' to zero to indicate that for a filter with
   // local-only targets the coordinator does not expect to receive any filter
   // updates. We expect to receive a single aggregated filter from each backend
-  // for partitioned joins.
+  // for partitioned joins, or from each intermediate aggregator, see below.
   int pending_count = filter.is_broadcast_join
       ? (filter.has_remote_targets ? 1 : 0) : num_backends;
-  f->set_pending_count(pending_count);
 
   // Determine which instances will produce the filters.
   // TODO: IMPALA-9333: having a shared RuntimeFilterBank between all fragments on
@@ -455,6 +479,57 @@ void Coordinator::AddFilterSource(const FragmentExecParamsPB& src_fragment_param
         filter_src);
   }
   f->set_num_producers(src_idxs.size());
+
+  // Let intermediate aggregators merge the updates of groups of backends if there are
+  // too many backends for the coordinator.
+  int max_aggregated =
+      query_ctx().client_request.query_options.max_num_filters_aggregated_per_host;
+  if (!filter.is_broadcast_join && filter.has_remote_targets && max_aggregated > 1
+      && num_backends > max_aggregated) {
+    pending_count =
+        AssignFilterAggregators(src_fragment_params, filter.filter_id, max_aggregated);
+  }
+  f->set_pending_count(pending_count);
+}
+
+int Coordinator::AssignFilterAggregators(
+    const FragmentExecParamsPB& src_fragment_params, int filter_id, int group_size) {
+  // The backends that produce the filter, with the indexes of their instances.
+  vector<pair<const BackendState*, vector<int>>> producers;
+  for (const BackendState* backend_state : backend_states_) {
+    vector<int> instance_idxs;
+    for (const FInstanceExecParamsPB& instance_params :
+        backend_state->exec_params().instance_params()) {
+      if (instance_params.fragment_idx() != src_fragment_params.fragment_idx()) continue;
+      instance_idxs.push_back(GetInstanceIdx(instance_params.instance_id()));
+    }
+    if (!instance_idxs.empty()) producers.emplace_back(backend_state, instance_idxs);
+  }
+  auto& produced_map = filter_routing_table_->finstance_filters_produced;
+  int num_groups = 0;
+  for (int group_start = 0; group_start < producers.size(); group_start += group_size) {
+    int group_end = min<int>(group_start + group_size, producers.size());
+    // Spread the aggregation of different filters over the backends of a group.
+    int aggregator_idx = group_start + filter_id % (group_end - group_start);
+    const BackendState* aggregator = producers[aggregator_idx].first;
+    TNetworkAddress aggregator_krpc_address =
+        FromNetworkAddressPB(aggregator->krpc_impalad_address());
+    for (int i = group_start; i < group_end; ++i) {
+      for (int instance_idx : producers[i].second) {
+        // The source of this filter was the last one added for the instance.
+        TRuntimeFilterSource& filter_src = produced_map[instance_idx].back();
+        DCHECK_EQ(filter_src.filter_id, filter_id);
+        if (i == aggregator_idx) {
+          filter_src.__set_num_aggregated_updates(group_end - group_start - 1);
+        } else {
+          filter_src.__set_aggregator_krpc_address(aggregator_krpc_address);
+          filter_src.__set_aggregator_hostname(aggregator->impalad_address().hostname());
+        }
+      }
+    }
+    ++num_groups;
+  }
+  return num_groups;
 }
 
 void Coordinator::WaitOnExecRpcs() {
@@ -644,6 +719,22 @@ string Coordinator::FilterDebugString() {
       row.push_back(ss.str());
       row.push_back("");
       row.push_back("");
+    } else if (state.is_in_list_filter()) {
+      // Add the filter type and the number of values for in-list filters.
+      row.push_back(PrintThriftEnum(state.desc().type));
+      row.push_back("");
+      const InListFilterPB& in_list_filterPB =
+          const_cast<FilterState*>(&state)->in_list_filter();
+      if (state.AlwaysTrueFilterReceived()) {
+        row.push_back("AlwaysTrue");
+      } else if (!state.received_all_updates()) {
+        row.push_back("PartialUpdates");
+      } else if (state.AlwaysFalseFlippedToFalse()) {
+        row.push_back("AlwaysFalse");
+      } else {
+        row.push_back(Substitute("$0 values", in_list_filterPB.value_size()));
+      }
+      row.push_back("");
     } else {
       // Add the filter type for minmax filters.
       row.push_back(PrintThriftEnum(state.desc().type));
@@ -794,6 +885,7 @@ void Coordinator::HandleExecStateTransition(
   // WaitForBackends() and CancelBackends() ensures that.
   // TODO: should move this off of the query execution path?
   ComputeQuerySummary();
+  if (new_state == ExecState::RETURNED_RESULTS) DetectSlowBackends();
   finalized_.Set(true);
 }
 
@@ -1049,12 +1141,18 @@ Status Coordinator::UpdateBackendExecStatus(const ReportExecStatusRequestPB& req
     if (!status.ok() && retryable_status.ok()) {
       retryable_status = UpdateBlacklistWithBackendState(status, backend_state);
     }
+    // A broadcast join build that exceeded RUNTIME_BROADCAST_BYTES_LIMIT does not
+    // blacklist any node, but the query is retried with partitioned joins.
+    if (!status.ok() && retryable_status.ok()
+        && status.code() == TErrorCode::RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED) {
+      retryable_status = status;
+    }
 
-    // If any nodes were blacklisted, retry the query. This needs to be done before
-    // UpdateExecState is called with the error status to avoid exposing the error to any
-    // clients. If a retry is attempted, the ClientRequestState::query_status_ will be
-    // set by TryQueryRetry, which prevents the error status from being exposed to any
-    // clients.
+    // If any nodes were blacklisted or the query must be planned again, retry the query.
+    // This needs to be done before UpdateExecState is called with the error status to
+    // avoid exposing the error to any clients. If a retry is attempted, the
+    // ClientRequestState::query_status_ will be set by TryQueryRetry, which prevents the
+    // error status from being exposed to any clients.
     if (!retryable_status.ok()) {
       parent_query_driver_->TryQueryRetry(parent_request_state_, &retryable_status);
     }
@@ -1108,6 +1206,8 @@ Status Coordinator::UpdateBackendExecStatus(const ReportExecStatusRequestPB& req
     }
   }
 
+  CheckForStragglers();
+
   // If query execution has terminated, return a cancelled status to force the fragment
   // instance to stop executing.
   // After cancelling backend_state, it's possible that current exec_state is still
@@ -1250,7 +1350,107 @@ int64_t Coordinator::GetMaxBackendStateLagMs(NetworkAddressPB* address) {
   return current_time - min_last_report_time_ms;
 }
 
+void Coordinator::CheckForStragglers() {
+  const TQueryOptions& query_options = query_state_->query_options();
+  double factor = query_options.straggler_retry_factor;
+  if (factor <= 0 || !query_options.retry_failed_queries) return;
+  if (straggler_retry_triggered_.Load() || !IsExecuting()) return;
+  // Reports arrive from all backends, so only look at all of them once in a while.
+  int64_t now = MonotonicMillis();
+  int64_t last_check_ms = last_straggler_check_ms_.Load();
+  if (now - last_check_ms < STRAGGLER_CHECK_INTERVAL_MS) return;
+  if (!last_straggler_check_ms_.CompareAndSwap(last_check_ms, now)) return;
+  if (!exec_rpcs_complete_.Load()) return;
+
+  std::unordered_map<int, vector<int64_t>> completion_times;
+  vector<std::unordered_map<int, vector<int64_t>>> running_times(backend_states_.size());
+  for (int i = 0; i < backend_states_.size(); ++i) {
+    backend_states_[i]->GetScanInstanceTimes(&completion_times, &running_times[i]);
+  }
+  for (auto& entry : completion_times) {
+    vector<int64_t>& times = entry.second;
+    int num_running = 0;
+    for (const auto& backend_running_times : running_times) {
+      auto it = backend_running_times.find(entry.first);
+      if (it != backend_running_times.end()) num_running += it->second.size();
+    }
+    // Wait until the median is known.
+    if (num_running == 0 || times.size() < num_running) continue;
+    auto median_it = times.begin() + times.size() / 2;
+    std::nth_element(times.begin(), median_it, times.end());
+    int64_t threshold = max(static_cast<int64_t>(*median_it * factor),
+        MIN_STRAGGLER_RUNNING_TIME_NS);
+    for (int i = 0; i < backend_states_.size(); ++i) {
+      auto it = running_times[i].find(entry.first);
+      if (it == running_times[i].end()) continue;
+      int64_t running_time = *std::max_element(it->second.begin(), it->second.end());
+      if (running_time < threshold) continue;
+      BackendState* backend_state = backend_states_[i];
+      if (!straggler_retry_triggered_.CompareAndSwap(false, true)) return;
+      string detail = Substitute("An instance of $0 on $1 has been running for $2, $3 "
+          "times the median completion time $4 of the fragment",
+          fragment_stats_[entry.first]->root_profile()->name(),
+          NetworkAddressPBToString(backend_state->impalad_address()),
+          PrettyPrinter::Print(running_time, TUnit::TIME_NS),
+          PrettyPrinter::Print(factor, TUnit::DOUBLE_VALUE),
+          PrettyPrinter::Print(*median_it, TUnit::TIME_NS));
+      LOG(INFO) << "Retrying query " << PrintId(query_id()) << ": " << detail;
+      query_profile_->AddInfoString("Straggler retry", detail);
+      ExecEnv::GetInstance()->cluster_membership_mgr()->ReportSlowExecutor(
+          backend_state->exec_params().backend_id(), detail);
+      parent_request_state_->AddBlacklistedExecutorAddress(
+          backend_state->exec_params().address());
+      Status retryable_status = Status::Expected(detail);
+      parent_query_driver_->TryQueryRetry(parent_request_state_, &retryable_status);
+      return;
+    }
+  }
+}
+
 // TODO: add histogram/percentile
+void Coordinator::DetectSlowBackends() {
+  if (FLAGS_slow_executor_rate_ratio <= 0) return;
+  DCHECK(exec_rpcs_complete_.Load()) << "Exec() must be called first";
+  if (!has_called_wait_.Load()) return;
+  if (backend_states_.size() < MIN_BACKENDS_FOR_SLOW_DETECTION) return;
+  // Scan rates of all backends, per fragment.
+  unordered_map<int, vector<pair<double, BackendState*>>> fragment_rates;
+  for (BackendState* backend_state : backend_states_) {
+    std::unordered_map<int, double> rates;
+    backend_state->GetScanRates(MIN_COMPLETION_TIME_FOR_SLOW_DETECTION, &rates);
+    for (const auto& entry : rates) {
+      fragment_rates[entry.first].emplace_back(entry.second, backend_state);
+    }
+  }
+  std::unordered_set<BackendState*> slow_backends;
+  stringstream ss;
+  for (auto& entry : fragment_rates) {
+    vector<pair<double, BackendState*>>& rates = entry.second;
+    if (rates.size() < MIN_BACKENDS_FOR_SLOW_DETECTION) continue;
+    auto median_it = rates.begin() + rates.size() / 2;
+    std::nth_element(rates.begin(), median_it, rates.end(),
+        [](const pair<double, BackendState*>& a, const pair<double, BackendState*>& b) {
+          return a.first < b.first;
+        });
+    double median_rate = median_it->first;
+    for (const pair<double, BackendState*>& rate : rates) {
+      if (rate.first * FLAGS_slow_executor_rate_ratio >= median_rate) continue;
+      BackendState* backend_state = rate.second;
+      // Only report each backend once per query, for the first slow fragment.
+      if (!slow_backends.insert(backend_state).second) continue;
+      string detail = Substitute("fragment $0 scanned $1/sec, median $2/sec",
+          fragment_stats_[entry.first]->root_profile()->name(),
+          PrettyPrinter::PrintBytes(rate.first), PrettyPrinter::PrintBytes(median_rate));
+      if (!ss.str().empty()) ss << ", ";
+      ss << backend_state->impalad_address() << " (" << detail << ")";
+      ExecEnv::GetInstance()->cluster_membership_mgr()->ReportSlowExecutor(
+          backend_state->exec_params().backend_id(),
+          Substitute("query $0: $1", PrintId(query_id()), detail));
+    }
+  }
+  if (!slow_backends.empty()) query_profile_->AddInfoString("Slow executors", ss.str());
+}
+
 void Coordinator::ComputeQuerySummary() {
   DCHECK(exec_rpcs_complete_.Load()) << "Exec() must be called first";
   // In this case, the query did not even get to start all fragment instances.
@@ -1489,9 +1689,11 @@ void Coordinator::UpdateFilter(const UpdateFilterParamsPB& params, RpcContext* c
           || rpc_params.bloom_filter().always_true()
           || !state->bloom_filter_directory().empty());
 
-    } else {
-      DCHECK(state->is_min_max_filter());
+    } else if (state->is_min_max_filter()) {
       MinMaxFilter::Copy(state->min_max_filter(), rpc_params.mutable_min_max_filter());
+    } else {
+      DCHECK(state->is_in_list_filter());
+      InListFilter::Copy(state->in_list_filter(), rpc_params.mutable_in_list_filter());
     }
 
     // Filter is complete. We disable it so future UpdateFilter rpcs will be ignored,
@@ -1572,6 +1774,23 @@ void Coordinator::FilterState::ApplyUpdate(
             sidecar_slice.size());
       }
     }
+  } else if (is_in_list_filter()) {
+    DCHECK(params.has_in_list_filter());
+    if (params.in_list_filter().always_true()) {
+      // An always_true filter is received. We don't need to wait for other pending
+      // backends.
+      always_true_filter_received_ = true;
+      DisableAndRelease(coord->filter_mem_tracker_, true);
+    } else {
+      InListFilter::Or(params.in_list_filter(), &in_list_filter_,
+          coord->query_ctx().client_request.query_options
+              .runtime_in_list_filter_entry_limit);
+      if (in_list_filter_.always_true()) {
+        // The aggregated filter got too many values, so it is always true as well.
+        always_true_filter_received_ = true;
+        DisableAndRelease(coord->filter_mem_tracker_, true);
+      }
+    }
   } else {
     DCHECK(is_min_max_filter());
     DCHECK(params.has_min_max_filter());
@@ -1623,6 +1842,10 @@ void Coordinator::FilterState::Disable(const bool all_updates_received) {
       always_false_flipped_to_false_ = true;
     }
     min_max_filter_.set_always_false(false);
+  } else {
+    DCHECK(is_in_list_filter());
+    if (InListFilter::AlwaysFalse(in_list_filter_)) always_false_flipped_to_false_ = true;
+    in_list_filter_.set_always_true(true);
   }
 }
 
@@ -406,6 +406,12 @@ class Coordinator { // NOLINT: The member variables could be re-ordered to save
   /// True if all Exec() rpcs have completed.
   AtomicBool exec_rpcs_complete_{false};
 
+  /// Set once CheckForStragglers() found a straggler and tried to retry the query.
+  AtomicBool straggler_retry_triggered_{false};
+
+  /// MonotonicMillis() of the last time CheckForStragglers() looked at the backends.
+  AtomicInt64 last_straggler_check_ms_{0};
+
   /// Barrier that is released when all backends have indicated execution completion,
   /// or when all backends are cancelled due to an execution error or client requested
   /// cancellation. Initialized in StartBackendExec().
@@ -538,6 +544,18 @@ class Coordinator { // NOLINT: The member variables could be re-ordered to save
   /// profiles must not be updated while this is running.
   void ComputeQuerySummary();
 
+  /// Retries the query if an instance of a scan fragment has been running for more than
+  /// STRAGGLER_RETRY_FACTOR times the median completion time of the finished instances
+  /// of the fragment. The backend of the straggler is excluded from the retry. Called
+  /// after each status report, but only looks at the backends once in a while.
+  void CheckForStragglers();
+
+  /// Compares the scan rates of the backends of each fragment at the end of a
+  /// successful query and reports backends that are much slower than their peers to
+  /// the cluster membership, see --slow_executor_rate_ratio. Must be called after
+  /// ComputeQuerySummary().
+  void DetectSlowBackends();
+
   /// Perform any post-query cleanup required for HDFS (or other Hadoop FileSystem)
   /// INSERT. Called by Wait() only after all fragment instances have returned, or if
   /// the query has failed, in which case it only cleans up temporary data rather than
@@ -573,6 +591,15 @@ class Coordinator { // NOLINT: The member variables could be re-ordered to save
   void AddFilterSource(const FragmentExecParamsPB& src_fragment_params, int num_instances,
       int num_backends, const TRuntimeFilterDesc& filter, int join_node_id);
 
+  /// Helper for AddFilterSource() that splits the backends that produce partitioned join
+  /// filter 'filter_id' into groups of at most 'group_size' backends. One backend of each
+  /// group is the intermediate aggregator of the updates of the group. Sets this up in
+  /// the filter sources of the producer instances, which must have been added to the
+  /// routing table. Returns the number of groups, i.e. the number of updates the
+  /// coordinator receives.
+  int AssignFilterAggregators(
+      const FragmentExecParamsPB& src_fragment_params, int filter_id, int group_size);
+
   /// Helper for HandleExecStateTransition(). Releases all resources associated with
   /// query execution. The ExecState state-machine ensures this is called exactly once.
   void ReleaseExecResources();
@@ -39,7 +39,10 @@
 #include "runtime/descriptors.h"
 #include "runtime/client-cache.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/query-exec-mgr.h"
 #include "runtime/raw-value.inline.h"
+#include "runtime/spillable-row-batch-queue.h"
+#include "runtime/tmp-file-mgr.h"
 #include "service/data-stream-service.h"
 #include "service/fe-support.h"
 #include "util/cpu-info.h"
@@ -48,6 +51,7 @@
 #include "util/thread.h"
 #include "util/time.h"
 #include "util/mem-info.h"
+#include "util/memory-metrics.h"
 #include "util/parse-util.h"
 #include "util/test-info.h"
 #include "util/tuple-row-compare.h"
@@ -86,6 +90,8 @@ static const int PER_ROW_DATA = 8;
 static const int TOTAL_DATA_SIZE = 8 * 1024;
 static const int NUM_BATCHES = TOTAL_DATA_SIZE / BATCH_CAPACITY / PER_ROW_DATA;
 static const int SHORT_SERVICE_QUEUE_MEM_LIMIT = 16;
+// The page size and the unpinned bytes limit of the spill queues.
+static const int64_t SPILL_PAGE_LEN = 32 * 1024;
 
 namespace impala {
 
@@ -257,6 +263,8 @@ class DataStreamTest : public testing::Test {
   boost::scoped_ptr<ExecEnv> exec_env_;
   scoped_ptr<RuntimeState> runtime_state_;
   FragmentState* fragment_state_;
+  // The query options of the senders' RuntimeStates.
+  TQueryOptions sender_query_options_;
   UniqueIdPB next_instance_id_;
   string stmt_;
   // The sorting expression for the single BIGINT column.
@@ -289,6 +297,8 @@ class DataStreamTest : public testing::Test {
     unique_ptr<thread> thread_handle;
     Status status;
     int num_bytes_sent = 0;
+    int64_t num_local_batches_sent = 0;
+    string slowest_destinations;
   };
   // Allocate each SenderInfo separately so the address doesn't change.
   vector<unique_ptr<SenderInfo>> sender_info_;
@@ -303,6 +313,9 @@ class DataStreamTest : public testing::Test {
     Status status;
     int num_rows_received = 0;
     multiset<int64_t> data_values;
+    // The values in the order in which they were read. Only set by ReadStream().
+    vector<int64_t> ordered_values;
+    RuntimeProfile* profile = nullptr;
 
     ReceiverInfo(TPartitionType::type stream_type, int num_senders, int receiver_num)
       : stream_type(stream_type),
@@ -390,9 +403,11 @@ class DataStreamTest : public testing::Test {
     }
   }
 
-  // Start receiver (expecting given number of senders) in separate thread.
+  // Start receiver (expecting given number of senders) in separate thread. If
+  // 'spill_queue' is not null, the receiver spills to it.
   void StartReceiver(TPartitionType::type stream_type, int num_senders, int receiver_num,
-      int buffer_size, bool is_merging, TUniqueId* out_id = nullptr) {
+      int buffer_size, bool is_merging, TUniqueId* out_id = nullptr,
+      SpillableRowBatchQueue* spill_queue = nullptr) {
     VLOG_QUERY << "start receiver";
     RuntimeProfile* profile = RuntimeProfile::Create(&obj_pool_, "TestReceiver");
     TUniqueId instance_id;
@@ -403,6 +418,8 @@ class DataStreamTest : public testing::Test {
     info->stream_recvr = stream_mgr_->CreateRecvr(row_desc_, *runtime_state_.get(),
         instance_id, DEST_NODE_ID, num_senders, buffer_size, is_merging, profile,
         &tracker_, &buffer_pool_client_);
+    info->profile = profile;
+    if (spill_queue != nullptr) info->stream_recvr->EnableSpilling(spill_queue);
    if (!is_merging) {
       info->thread_handle.reset(new thread(&DataStreamTest::ReadStream, this, info));
     } else {
@@ -433,7 +450,9 @@ class DataStreamTest : public testing::Test {
       VLOG_QUERY << "read batch #rows=" << batch->num_rows();
       for (int i = 0; i < batch->num_rows(); ++i) {
         TupleRow* row = batch->GetRow(i);
-        info->data_values.insert(*static_cast<int64_t*>(row->GetTuple(0)->GetSlot(0)));
+        const int64_t value = *static_cast<int64_t*>(row->GetTuple(0)->GetSlot(0));
+        info->data_values.insert(value);
+        info->ordered_values.push_back(value);
       }
       SleepForMs(100);  // slow down receiver to exercise buffering logic
     }
@@ -566,6 +585,9 @@ class DataStreamTest : public testing::Test {
     ASSERT_OK(rpc_mgr->StartServices());
   }
 
+  // Makes the senders see the receivers as being in this process.
+  void SetLocalKrpcAddress() { exec_env_->krpc_address_ = krpc_address_; }
+
   void StopKrpcBackend() {
     exec_env_->rpc_mgr()->Shutdown();
   }
@@ -589,7 +611,9 @@ class DataStreamTest : public testing::Test {
 
   void Sender(int sender_num, int channel_buffer_size,
       TPartitionType::type partition_type, SenderInfo* info, bool reset_hash_seed) {
-    RuntimeState state(TQueryCtx(), exec_env_.get(), desc_tbl_);
+    TQueryCtx query_ctx;
+    query_ctx.client_request.__set_query_options(sender_query_options_);
+    RuntimeState state(query_ctx, exec_env_.get(), desc_tbl_);
     VLOG_QUERY << "create sender " << sender_num;
     const TDataSink sink = GetSink(partition_type);
     TPlanFragment fragment;
@@ -631,6 +655,13 @@ class DataStreamTest : public testing::Test {
     sender->Close(&state);
     info->num_bytes_sent = static_cast<KrpcDataStreamSender*>(
         sender.get())->GetNumDataBytesSent();
+    info->num_local_batches_sent =
+        sender->profile()->GetCounter("LocalRowBatchesSent")->value();
+    const string* slowest_destinations =
+        sender->profile()->GetInfoString("SlowestDestinations");
+    if (slowest_destinations != nullptr) {
+      info->slowest_destinations = *slowest_destinations;
+    }
 
     batch->Reset();
     state.ReleaseResources();
@@ -686,6 +717,117 @@ class DataStreamTestShortServiceQueue : public DataStreamTest {
   }
 };
 
+// A separate test class in which the receivers can spill to SpillableRowBatchQueues
+// with a tiny limit, like exchanges with a small EXCHANGE_MAX_SPILLED_MEM. The queues
+// need the reservations and the scratch space of a real query.
+class DataStreamTestSpilling : public DataStreamTest {
+ protected:
+  virtual void SetUp() {
+    DataStreamTest::SetUp();
+    ASSERT_OK(exec_env_->disk_io_mgr()->Init());
+    ASSERT_OK(exec_env_->tmp_file_mgr()->Init(exec_env_->metrics()));
+    // QueryState::Init() reads the JVM metrics, which can only be registered once.
+    if (jvm_metrics_ == nullptr) {
+      jvm_metrics_.reset(new MetricGroup("data-stream-test-jvm-metrics"));
+      ASSERT_OK(RegisterMemoryMetrics(jvm_metrics_.get(), true, nullptr, nullptr));
+    }
+
+    TQueryCtx query_ctx;
+    query_ctx.query_id.hi = 0;
+    query_ctx.query_id.lo = 1;
+    query_ctx.request_pool = "test-pool";
+    query_ctx.coord_hostname = "localhost";
+    query_ctx.coord_ip_address = krpc_address_;
+    query_state_ = exec_env_->query_exec_mgr()->CreateQueryState(query_ctx, -1);
+    ExecQueryFInstancesRequestPB rpc_params;
+    rpc_params.set_coord_state_idx(0);
+    rpc_params.add_fragment_ctxs();
+    rpc_params.add_fragment_instance_ctxs();
+    TExecPlanFragmentInfo fragment_info;
+    fragment_info.__set_fragments(vector<TPlanFragment>({TPlanFragment()}));
+    fragment_info.__set_fragment_instance_ctxs(
+        vector<TPlanFragmentInstanceCtx>({TPlanFragmentInstanceCtx()}));
+    ASSERT_OK(query_state_->Init(&rpc_params, fragment_info));
+    spill_state_ = query_state_->obj_pool()->Add(new RuntimeState(query_state_,
+        spill_fragment_, spill_instance_ctx_, spill_fragment_ctx_,
+        spill_instance_ctx_pb_, exec_env_.get()));
+    spill_mem_tracker_ = spill_state_->obj_pool()->Add(
+        new MemTracker(-1, "Spill Queues", spill_state_->instance_mem_tracker()));
+
+    spill_resource_profile_.__set_min_reservation(0);
+    spill_resource_profile_.__set_max_reservation(2 * SPILL_PAGE_LEN);
+    spill_resource_profile_.__set_spillable_buffer_size(SPILL_PAGE_LEN);
+    spill_resource_profile_.__set_max_row_buffer_size(SPILL_PAGE_LEN);
+  }
+
+  virtual void TearDown() {
+    // The receivers were closed by JoinReceivers().
+    for (unique_ptr<SpillableRowBatchQueue>& spill_queue : spill_queues_) {
+      spill_queue->Close();
+    }
+    spill_queues_.clear();
+    if (spill_state_ != nullptr) spill_state_->ReleaseResources();
+    if (query_state_ != nullptr) {
+      // Acquired by QueryState::Init().
+      query_state_->ReleaseBackendResourceRefcount();
+      exec_env_->query_exec_mgr()->ReleaseQueryState(query_state_);
+    }
+    DataStreamTest::TearDown();
+  }
+
+  // Returns a new open spill queue that is full once SPILL_PAGE_LEN bytes are unpinned.
+  SpillableRowBatchQueue* CreateSpillQueue() {
+    RuntimeProfile* profile = RuntimeProfile::Create(&obj_pool_, "TestSpillQueue");
+    spill_queues_.emplace_back(make_unique<SpillableRowBatchQueue>(spill_queue_name_,
+        SPILL_PAGE_LEN, spill_state_, spill_mem_tracker_, profile, row_desc_,
+        spill_resource_profile_, spill_debug_options_));
+    EXPECT_OK(spill_queues_.back()->Open());
+    return spill_queues_.back().get();
+  }
+
+  // Returns the number of batches that the receiver of 'info' spilled.
+  int64_t NumSpilledBatches(const ReceiverInfo* info) {
+    vector<RuntimeProfile::Counter*> counters;
+    info->profile->GetCounters("TotalBatchesSpilled", &counters);
+    int64_t num_spilled_batches = 0;
+    for (RuntimeProfile::Counter* counter : counters) {
+      num_spilled_batches += counter->value();
+    }
+    return num_spilled_batches;
+  }
+
+  // Checks that the receiver of an unpartitioned stream read the rows of each sender in
+  // the order in which they were sent. All senders send the same increasing values, so
+  // the i-th occurrence of a value must be read after the i-th occurrence of the
+  // previous value.
+  void CheckOrder(const ReceiverInfo* info) {
+    unordered_map<int64_t, int> num_occurrences;
+    for (int64_t value : info->ordered_values) {
+      const int count = ++num_occurrences[value];
+      if (value > 0) ASSERT_LE(count, num_occurrences[value - 1]) << "value=" << value;
+    }
+  }
+
+  static scoped_ptr<MetricGroup> jvm_metrics_;
+
+  QueryState* query_state_ = nullptr;
+  // The RuntimeState of the fragment instance that owns the spill queues.
+  RuntimeState* spill_state_ = nullptr;
+  TPlanFragment spill_fragment_;
+  TPlanFragmentInstanceCtx spill_instance_ctx_;
+  PlanFragmentCtxPB spill_fragment_ctx_;
+  PlanFragmentInstanceCtxPB spill_instance_ctx_pb_;
+  MemTracker* spill_mem_tracker_ = nullptr;
+
+  // The spill queues keep references to these.
+  const string spill_queue_name_ = "Test Spill Queue";
+  TBackendResourceProfile spill_resource_profile_;
+  TDebugOptions spill_debug_options_;
+  vector<unique_ptr<SpillableRowBatchQueue>> spill_queues_;
+};
+
+scoped_ptr<MetricGroup> DataStreamTestSpilling::jvm_metrics_;
+
 TEST_F(DataStreamTest, UnknownSenderSmallResult) {
   // starting a sender w/o a corresponding receiver results in an error. No bytes should
   // be sent.
@@ -740,6 +882,74 @@ TEST_F(DataStreamTest, BasicTest) {
   }
 }
 
+// Test hash partitioned streams when the sender shares one buffer between its channels.
+TEST_F(DataStreamTest, SharedBufferTest) {
+  sender_query_options_.__set_shared_exchange_buffer(true);
+  int sender_nums[] = {1, 4};
+  int receiver_nums[] = {2, 4};
+  bool merging[] = {false, true};
+  for (int num_senders : sender_nums) {
+    for (int num_receivers : receiver_nums) {
+      for (bool is_merging : merging) {
+        TestStream(TPartitionType::HASH_PARTITIONED, num_senders, num_receivers, 1024,
+            is_merging);
+      }
+    }
+  }
+}
+
+// Test broadcast streams when the receivers relay the row batches to each other.
+TEST_F(DataStreamTest, RelayTest) {
+  sender_query_options_.__set_broadcast_relay_fanout(2);
+  int sender_nums[] = {1, 4};
+  int receiver_nums[] = {3, 7};
+  bool merging[] = {false, true};
+  for (int num_senders : sender_nums) {
+    for (int num_receivers : receiver_nums) {
+      for (bool is_merging : merging) {
+        TestStream(TPartitionType::UNPARTITIONED, num_senders, num_receivers, 1024,
+            is_merging);
+      }
+    }
+  }
+}
+
+// Test streams when the senders hand the row batches to the receivers in this process
+// without RPCs.
+TEST_F(DataStreamTest, LocalExchangeTest) {
+  SetLocalKrpcAddress();
+  sender_query_options_.__set_local_exchange_shortcut(true);
+  TPartitionType::type stream_types[] = {TPartitionType::UNPARTITIONED,
+      TPartitionType::RANDOM, TPartitionType::HASH_PARTITIONED};
+  int sender_nums[] = {1, 4};
+  int receiver_nums[] = {1, 3};
+  int buffer_sizes[] = {1024, 1024 * 1024};
+  bool merging[] = {false, true};
+  for (TPartitionType::type stream_type : stream_types) {
+    for (int num_senders : sender_nums) {
+      for (int num_receivers : receiver_nums) {
+        for (int buffer_size : buffer_sizes) {
+          for (bool is_merging : merging) {
+            TestStream(stream_type, num_senders, num_receivers, buffer_size, is_merging);
+            for (const unique_ptr<SenderInfo>& info : sender_info_) {
+              EXPECT_GT(info->num_local_batches_sent, 0);
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Test that the senders report the RPC latency of their destinations in the profile.
+TEST_F(DataStreamTest, DestinationStatsTest) {
+  TestStream(TPartitionType::HASH_PARTITIONED, 2, 3, 1024, false);
+  for (const unique_ptr<SenderInfo>& info : sender_info_) {
+    EXPECT_NE(info->slowest_destinations.find("rpcs="), string::npos);
+    EXPECT_NE(info->slowest_destinations.find("p99="), string::npos);
+  }
+}
+
 // Test streams with different query ids should hash to different destinations.
 TEST_F(DataStreamTest, HashPartitionTest) {
   bool result = false;
@@ -814,6 +1024,58 @@ TEST_F(DataStreamTestShortServiceQueue, TestLargePayload) {
       TPartitionType::UNPARTITIONED, 4, 1, SHORT_SERVICE_QUEUE_MEM_LIMIT * 2, false);
 }
 
+// Test that a receiver that spills to a queue with a tiny limit returns all rows, and
+// the rows of each sender in order.
+TEST_F(DataStreamTestSpilling, SpillInOrder) {
+  const int num_senders = 8;
+  StartReceiver(TPartitionType::UNPARTITIONED, num_senders, 0, 1024, false, nullptr,
+      CreateSpillQueue());
+  for (int i = 0; i < num_senders; ++i) StartSender(TPartitionType::UNPARTITIONED);
+  JoinSenders();
+  CheckSenders();
+  JoinReceivers();
+  CheckReceivers(TPartitionType::UNPARTITIONED, num_senders);
+  const ReceiverInfo* info = receiver_info_[0].get();
+  EXPECT_GT(NumSpilledBatches(info), 0);
+  CheckOrder(info);
+}
+
+// Test cancelling a receiver while it has spilled batches that were not read yet.
+TEST_F(DataStreamTestSpilling, CancelWhileSpilled) {
+  const int num_senders = 4;
+  TUniqueId instance_id;
+  StartReceiver(TPartitionType::UNPARTITIONED, num_senders, 0, 1024, false,
+      &instance_id, CreateSpillQueue());
+  for (int i = 0; i < num_senders; ++i) StartSender(TPartitionType::UNPARTITIONED);
+  const ReceiverInfo* info = receiver_info_[0].get();
+  while (NumSpilledBatches(info) == 0) SleepForMs(1);
+  stream_mgr_->Cancel(GetQueryId(instance_id));
+  JoinSenders();
+  JoinReceivers();
+  EXPECT_TRUE(info->status.IsCancelled());
+}
+
+// Test merging receivers, which never spill, next to a spilling receiver of the same
+// stream.
+TEST_F(DataStreamTestSpilling, MergingReceivers) {
+  const int num_senders = 4;
+  const int num_receivers = 3;
+  StartReceiver(TPartitionType::HASH_PARTITIONED, num_senders, 0, 1024, false, nullptr,
+      CreateSpillQueue());
+  for (int i = 1; i < num_receivers; ++i) {
+    StartReceiver(TPartitionType::HASH_PARTITIONED, num_senders, i, 1024, true);
+  }
+  for (int i = 0; i < num_senders; ++i) StartSender(TPartitionType::HASH_PARTITIONED);
+  JoinSenders();
+  CheckSenders();
+  JoinReceivers();
+  CheckReceivers(TPartitionType::HASH_PARTITIONED, num_senders);
+  EXPECT_GT(NumSpilledBatches(receiver_info_[0].get()), 0);
+  for (int i = 1; i < num_receivers; ++i) {
+    EXPECT_EQ(NumSpilledBatches(receiver_info_[i].get()), 0);
+  }
+}
+
 // TODO: more tests:
 // - test case for transmission error in last batch
 // - receivers getting created concurrently
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <random>
 #include <sstream>
 #include <boost/lexical_cast.hpp>
 #include "runtime/decimal-value.inline.h"
@@ -33,6 +34,7 @@
 
 using std::max;
 using std::min;
+using std::mt19937_64;
 
 namespace impala {
 
@@ -403,6 +405,16 @@ TEST(DecimalTest, StringToDecimalLarge) {
       Decimal16Value(1234567L), StringParser::PARSE_UNDERFLOW,
       Decimal16Value(1234568L), StringParser::PARSE_UNDERFLOW);
 
+  // Runs of eight digits, including ones that span the dot.
+  VerifyParse("1234567.1234567891", 18, 10,
+      Decimal8Value(12345671234567891L), StringParser::PARSE_SUCCESS);
+  VerifyParse("-12345678901234567890123456789.1234567", 38, 7,
+      Decimal16Value(-(static_cast<int128_t>(123456789012345678L) * 100000000000000000L
+      + 90123456789123456L) * 10 - 7), StringParser::PARSE_SUCCESS);
+  VerifyParse("12345678.123456789", 16, 8,
+      Decimal8Value(1234567812345678L), StringParser::PARSE_UNDERFLOW,
+      Decimal8Value(1234567812345679L), StringParser::PARSE_UNDERFLOW);
+
   // Test max unscaled value for each of the decimal types.
   VerifyParse("999999999", 9, 0,
       Decimal4Value(999999999), StringParser::PARSE_SUCCESS);
@@ -711,6 +723,64 @@ TEST(DecimalTest, MultiplyScaleOverflow) {
   EXPECT_FALSE(overflow);
 }
 
+// Random unscaled value with up to 38 digits.
+static int128_t RandInt128(mt19937_64* gen) {
+  int num_digits = (*gen)() % 38 + 1;
+  int128_t value = 0;
+  for (int i = 0; i < num_digits; ++i) value = value * 10 + (*gen)() % 10;
+  return (*gen)() % 2 == 0 ? value : -value;
+}
+
+// Multiply() and Divide() of DECIMAL(38, x) values use 64-bit limbs instead of int256_t
+// for products that do not fit into 128 bits. Compare them with the same operations
+// done with int256_t.
+TEST(DecimalTest, Int128MultiplyDivideMatchInt256) {
+  mt19937_64 gen(1234);
+  const int256_t max_value = ConvertToInt256(MAX_UNSCALED_DECIMAL16);
+  for (int i = 0; i < 200000; ++i) {
+    const int128_t x = RandInt128(&gen);
+    const int128_t y = RandInt128(&gen);
+    if (x == 0 || y == 0) continue;
+    const bool round = gen() % 2 == 0;
+    // Scales as if DECIMAL(38, s1) * DECIMAL(38, s2) was capped to DECIMAL(38, 6).
+    const int s1 = gen() % 39;
+    const int s2 = gen() % 39;
+    const int result_scale = min(s1 + s2, 6);
+    const int delta_scale = s1 + s2 - result_scale;
+
+    int256_t expected = ConvertToInt256(x) * ConvertToInt256(y);
+    if (delta_scale > 0) {
+      expected = DecimalUtil::ScaleDownAndRound<int256_t>(expected, delta_scale, round);
+    }
+    bool overflow = false;
+    Decimal16Value result = Decimal16Value(x).Multiply<int128_t>(
+        s1, Decimal16Value(y), s2, 38, result_scale, round, &overflow);
+    ASSERT_EQ(overflow, abs(expected) > max_value) << i;
+    if (!overflow) ASSERT_TRUE(ConvertToInt256(result.value()) == expected) << i;
+
+    // Divide by 'y' after scaling 'x' up by 'scale_by'.
+    const int scale_by = gen() % 39;
+    const int256_t dividend =
+        ConvertToInt256(x) * DecimalUtil::GetScaleMultiplier<int256_t>(scale_by);
+    const int256_t divisor = ConvertToInt256(y);
+    expected = dividend / divisor;
+    if (round && abs(2 * (dividend % divisor)) >= abs(divisor)) {
+      expected += (x < 0) != (y < 0) ? -1 : 1;
+    }
+    overflow = false;
+    bool is_nan = false;
+    result = Decimal16Value(x).Divide<int128_t>(
+        0, Decimal16Value(y), 0, 38, scale_by, round, &is_nan, &overflow);
+    EXPECT_FALSE(is_nan);
+    if (abs(dividend / divisor) > max_value) {
+      ASSERT_TRUE(overflow) << i;
+    } else {
+      ASSERT_EQ(overflow, abs(expected) > max_value) << i;
+      if (!overflow) ASSERT_TRUE(ConvertToInt256(result.value()) == expected) << i;
+    }
+  }
+}
+
 // Test that unaligned decimal values are handled correctly.
 TEST(DecimalTest, UnalignedValues) {
   // Regression test for IMPALA-7473 that triggered a crash in release builds.
@@ -190,6 +190,26 @@ inline int MaxBitsRequiredAfterScaling(int128_t num, int scale_by) {
   return num_occupied + MaxBitsRequiredIncreaseAfterScaling(scale_by);
 }
 
+// Scales the unsigned 256-bit 'value', stored as four 64-bit limbs with the least
+// significant first, down by 10^delta_scale in place. Rounds half away from zero if
+// 'round' is true.
+inline void ScaleDownAndRoundUint256(uint64_t value[4], int delta_scale, bool round) {
+  DCHECK_GT(delta_scale, 0);
+  // Powers of ten up to 10^18 fit in a 64-bit divisor. The digits beyond the last
+  // division are truncated; only the remainder of the last division decides the
+  // rounding, since the truncated digits are less significant than all of its digits.
+  const int MAX_STEP = 18;
+  while (delta_scale > MAX_STEP) {
+    DivideUint256By64(value, DecimalUtil::GetScaleMultiplier<int64_t>(MAX_STEP));
+    delta_scale -= MAX_STEP;
+  }
+  const uint64_t divisor = DecimalUtil::GetScaleMultiplier<int64_t>(delta_scale);
+  const uint64_t remainder = DivideUint256By64(value, divisor);
+  if (round && remainder >= divisor / 2) {
+    for (int i = 0; i < 4 && ++value[i] == 0; ++i) {}
+  }
+}
+
 // Returns the minimum number of leading zero x or y would have after one of them gets
 // scaled up to match the scale of the other one.
 template<typename T>
@@ -416,27 +436,22 @@ DecimalValue<RESULT_T> DecimalValue<T>::Multiply(int this_scale,
     // This check is quick, but conservative. In some cases it will indicate that
     // converting to 256 bits is necessary, when it's not actually the case.
     needs_int256 = total_leading_zeros <= 128;
-    if (UNLIKELY(needs_int256 && delta_scale == 0)) {
-      if (LIKELY(abs(x) > MAX_UNSCALED_DECIMAL16 / abs(y))) {
-        // If the intermediate value does not fit into 128 bits, we indicate overflow
-        // because the final value would also not fit into 128 bits since delta_scale is
-        // zero.
-        *overflow = true;
-      } else {
-        // We've verified that the intermediate (and final) value will fit into 128 bits.
-        needs_int256 = false;
-      }
-    }
   }
   if (UNLIKELY(needs_int256)) {
-    if (delta_scale == 0) {
-      DCHECK(*overflow);
+    // The product may not fit into 128 bits. Compute all 256 bits of it from 64-bit
+    // limbs and scale it down in place, which is several times faster than doing the
+    // same with int256_t.
+    uint64_t product[4];
+    MultiplyUint128(abs(x), abs(y), product);
+    if (delta_scale > 0) detail::ScaleDownAndRoundUint256(product, delta_scale, round);
+    const __uint128_t abs_result =
+        (static_cast<__uint128_t>(product[1]) << 64) | product[0];
+    if (product[2] != 0 || product[3] != 0
+        || abs_result > static_cast<__uint128_t>(MAX_UNSCALED_DECIMAL16)) {
+      *overflow = true;
     } else {
-      int256_t intermediate_result = ConvertToInt256(x) * ConvertToInt256(y);
-      intermediate_result = DecimalUtil::ScaleDownAndRound<int256_t>(
-          intermediate_result, delta_scale, round);
-      result = ConvertToInt128(
-          intermediate_result, MAX_UNSCALED_DECIMAL16, overflow);
+      result = (x < 0) != (y < 0) ? -static_cast<int128_t>(abs_result) :
+                                    static_cast<int128_t>(abs_result);
     }
   } else {
     if (delta_scale == 0) {
@@ -492,13 +507,54 @@ inline DecimalValue<RESULT_T> DecimalValue<T>::Divide(int this_scale,
   // large numbers very quickly (and get eliminated by the int divide).
   if (sizeof(T) == 16) {
     int128_t x_sp = value();
+    int128_t y_sp = other.value();
+    if (LIKELY(scale_by <= 38)) {
+      // Scale the dividend up into 256 bits from 64-bit limbs. The division can then
+      // be done without int256_t if the dividend fits into 128 bits or the divisor into
+      // 64 bits, which covers most of the values in practice.
+      uint64_t dividend[4];
+      MultiplyUint128(abs(x_sp), DecimalUtil::GetScaleMultiplier<int128_t>(scale_by),
+          dividend);
+      const __uint128_t abs_y = abs(y_sp);
+      bool divided = true;
+      bool quotient_overflow = false;
+      __uint128_t quotient = 0;
+      __uint128_t remainder = 0;
+      if (dividend[2] == 0 && dividend[3] == 0) {
+        const __uint128_t abs_x =
+            (static_cast<__uint128_t>(dividend[1]) << 64) | dividend[0];
+        quotient = abs_x / abs_y;
+        remainder = abs_x % abs_y;
+      } else if ((abs_y >> 64) == 0) {
+        remainder = DivideUint256By64(dividend, static_cast<uint64_t>(abs_y));
+        quotient_overflow = dividend[2] != 0 || dividend[3] != 0;
+        quotient = (static_cast<__uint128_t>(dividend[1]) << 64) | dividend[0];
+      } else {
+        divided = false;
+      }
+      if (divided) {
+        const __uint128_t max_value = MAX_UNSCALED_DECIMAL16;
+        // Same as the conversion of the int256_t quotient below.
+        if (UNLIKELY(quotient_overflow || quotient > max_value)) {
+          *overflow = true;
+          return DecimalValue<RESULT_T>();
+        }
+        // 'remainder' is less than 'abs_y', so doubling it fits into 128 bits.
+        if (round && 2 * remainder >= abs_y) ++quotient;
+        // Check overflow again after rounding since +1 could cause decimal overflow
+        if (result_precision == ColumnType::MAX_PRECISION) {
+          *overflow |= quotient > max_value;
+        }
+        const int128_t r = static_cast<int128_t>(quotient);
+        return DecimalValue<RESULT_T>((x_sp < 0) != (y_sp < 0) ? -r : r);
+      }
+    }
     // There is a test in expr-test.cc that shows that it OK to check for overflow this
     // way (and that no additional checks are required).
     bool ovf = scale_by > 38 && detail::MaxBitsRequiredAfterScaling(x_sp, scale_by) > 255;
     int256_t x = DecimalUtil::MultiplyByScale<int256_t>(
         ConvertToInt256(x_sp), scale_by, ovf);
     *overflow |= ovf;
-    int128_t y_sp = other.value();
     int256_t y = ConvertToInt256(y_sp);
     int128_t r = ConvertToInt128(x / y, MAX_UNSCALED_DECIMAL16, overflow);
     if (round) {
@@ -778,8 +778,9 @@ llvm::StructType* TupleDescriptor::GetLlvmStruct(LlvmCodeGen* codegen) const {
   // Construct the struct type. Use the packed layout although not strictly necessary
   // because the fields are already aligned, so LLVM should not add any padding. The
   // fields are already aligned because we order the slots by descending size and only
-  // have powers-of-two slot sizes. Note that STRING and TIMESTAMP slots both occupy
-  // 16 bytes although their useful payload is only 12 bytes.
+  // have powers-of-two slot sizes. The FE keeps this property when it places hot slots
+  // first. Note that STRING and TIMESTAMP slots both occupy 16 bytes although their
+  // useful payload is only 12 bytes.
   llvm::StructType* tuple_struct = llvm::StructType::get(codegen->context(),
       llvm::ArrayRef<llvm::Type*>(struct_fields), true);
   const llvm::DataLayout& data_layout = codegen->execution_engine()->getDataLayout();
@@ -262,9 +262,11 @@ Status DmlExecState::FinalizeHdfsInsert(const TFinalizeParams& params,
         PopulatePathPermissionCache(
             partition_fs_connection, part_path, &permissions_cache);
       }
-      if (hdfsExists(partition_fs_connection, part_path.c_str()) == -1) {
-        partition_create_ops.Add(CREATE_DIR, part_path);
-      }
+      // Creating a directory that exists succeeds, so the directories are created
+      // without checking whether they exist first, which would take a round trip to
+      // the filesystem per partition in this thread. The operations are executed
+      // concurrently below.
+      partition_create_ops.Add(CREATE_DIR, part_path);
     }
   }
 
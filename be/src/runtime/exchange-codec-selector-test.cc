@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/exchange-codec-selector.h"
+
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Tries each codec once and records that it serializes 1000 bytes of tuple data into
+/// the given number of bytes in the given time: NONE is cheap but does not shrink the
+/// data, ZSTD is the slowest and shrinks it the most.
+static void MeasureCodecs(ExchangeCodecSelector* selector) {
+  EXPECT_EQ(CompressionTypePB::NONE, selector->NextCodec());
+  selector->RecordSerialize(CompressionTypePB::NONE, 1000, 1000, 100);
+  EXPECT_EQ(CompressionTypePB::LZ4, selector->NextCodec());
+  selector->RecordSerialize(CompressionTypePB::LZ4, 1000, 500, 1000);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector->NextCodec());
+  selector->RecordSerialize(CompressionTypePB::ZSTD, 1000, 300, 3000);
+}
+
+TEST(ExchangeCodecSelectorTest, NoNetworkSamples) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  // Without a network sample the sender keeps to LZ4.
+  EXPECT_EQ(CompressionTypePB::LZ4, selector.NextCodec());
+}
+
+TEST(ExchangeCodecSelectorTest, SlowNetwork) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  selector.RecordTransmit(1000, 100000);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector.NextCodec());
+}
+
+TEST(ExchangeCodecSelectorTest, FastNetwork) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  selector.RecordTransmit(1000, 10);
+  EXPECT_EQ(CompressionTypePB::NONE, selector.NextCodec());
+}
+
+TEST(ExchangeCodecSelectorTest, Broadcast) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  selector.RecordTransmit(1000, 4000);
+  EXPECT_EQ(CompressionTypePB::LZ4, selector.NextCodec(1));
+  // Every serialized byte is sent to each receiver, so compressing pays off more.
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector.NextCodec(10));
+}
+
+TEST(ExchangeCodecSelectorTest, Explore) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  selector.RecordTransmit(1000, 10);
+  for (int i = 3; i < ExchangeCodecSelector::EXPLORE_INTERVAL; ++i) {
+    EXPECT_EQ(CompressionTypePB::NONE, selector.NextCodec());
+  }
+  // The codecs are re-measured in turn.
+  EXPECT_EQ(CompressionTypePB::LZ4, selector.NextCodec());
+  EXPECT_EQ(CompressionTypePB::NONE, selector.NextCodec());
+}
+
+TEST(ExchangeCodecSelectorTest, MovingAverage) {
+  ExchangeCodecSelector selector;
+  MeasureCodecs(&selector);
+  selector.RecordTransmit(1000, 10);
+  EXPECT_EQ(CompressionTypePB::NONE, selector.NextCodec());
+  // The network slows down: the average moves towards the new samples until
+  // compressing pays off.
+  for (int i = 0; i < 20; ++i) selector.RecordTransmit(1000, 100000);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector.NextCodec());
+}
+
+} // namespace impala
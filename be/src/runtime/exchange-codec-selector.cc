@@ -0,0 +1,95 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/exchange-codec-selector.h"
+
+#include <mutex>
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+constexpr double ExchangeCodecSelector::DECAY;
+constexpr int ExchangeCodecSelector::EXPLORE_INTERVAL;
+constexpr int ExchangeCodecSelector::NUM_CODECS;
+
+const CompressionTypePB::type ExchangeCodecSelector::CODECS[NUM_CODECS] = {
+    CompressionTypePB::NONE, CompressionTypePB::LZ4, CompressionTypePB::ZSTD};
+
+/// Adds 'sample' to the moving average 'avg', which is negative if it has no samples.
+static void UpdateAverage(double sample, double* avg) {
+  if (*avg < 0) {
+    *avg = sample;
+  } else {
+    *avg += ExchangeCodecSelector::DECAY * (sample - *avg);
+  }
+}
+
+int ExchangeCodecSelector::CodecIdx(CompressionTypePB::type codec) {
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    if (CODECS[i] == codec) return i;
+  }
+  DCHECK(false) << "Unexpected codec: " << codec;
+  return 0;
+}
+
+CompressionTypePB::type ExchangeCodecSelector::NextCodec(int num_receivers) {
+  DCHECK_GT(num_receivers, 0);
+  lock_guard<SpinLock> l(lock_);
+  const int64_t batch_idx = num_batches_++;
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    if (stats_[i].ratio < 0) return CODECS[i];
+  }
+  // Until an RPC completes there is no way to weigh CPU time against bytes on the
+  // network, so keep to the codec that the sender used before codecs were chosen.
+  if (network_ns_per_byte_ < 0) return CompressionTypePB::LZ4;
+  if (batch_idx % EXPLORE_INTERVAL == 0) {
+    return CODECS[(batch_idx / EXPLORE_INTERVAL) % NUM_CODECS];
+  }
+  int best_idx = 0;
+  double best_cost = -1;
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    const double cost = stats_[i].serialize_ns_per_byte
+        + stats_[i].ratio * network_ns_per_byte_ * num_receivers;
+    if (best_cost < 0 || cost < best_cost) {
+      best_idx = i;
+      best_cost = cost;
+    }
+  }
+  return CODECS[best_idx];
+}
+
+void ExchangeCodecSelector::RecordSerialize(CompressionTypePB::type codec,
+    int64_t uncompressed_bytes, int64_t serialized_bytes, int64_t serialize_ns) {
+  if (uncompressed_bytes <= 0) return;
+  const int idx = CodecIdx(codec);
+  lock_guard<SpinLock> l(lock_);
+  UpdateAverage(static_cast<double>(serialize_ns) / uncompressed_bytes,
+      &stats_[idx].serialize_ns_per_byte);
+  UpdateAverage(static_cast<double>(serialized_bytes) / uncompressed_bytes,
+      &stats_[idx].ratio);
+}
+
+void ExchangeCodecSelector::RecordTransmit(int64_t serialized_bytes, int64_t network_ns) {
+  if (serialized_bytes <= 0 || network_ns <= 0) return;
+  lock_guard<SpinLock> l(lock_);
+  UpdateAverage(static_cast<double>(network_ns) / serialized_bytes, &network_ns_per_byte_);
+}
+
+} // namespace impala
@@ -0,0 +1,93 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "gen-cpp/row_batch.pb.h"
+#include "gutil/macros.h"
+#include "util/spinlock.h"
+
+namespace impala {
+
+/// Chooses the codec that a data stream sender compresses each outbound row batch with,
+/// from NONE, LZ4 and ZSTD. It keeps moving averages of how long serializing a byte of
+/// tuple data takes and how much it shrinks with each codec, and of how long sending a
+/// serialized byte to the receivers takes. The chosen codec is the one that minimizes
+/// the estimated time to serialize and send a batch: a slow network favours the codec
+/// with the best ratio and a fast one favours not compressing at all.
+///
+/// Each codec is tried in turn until it has been measured once, and every
+/// EXPLORE_INTERVAL batches one codec is tried again so that the estimates follow
+/// changes in the data and the network. The decompression time on the receiver is not
+/// part of the estimate.
+///
+/// Thread-safe: RecordTransmit() is called from the RPC completion callbacks while the
+/// other functions are called from the fragment instance execution thread.
+class ExchangeCodecSelector {
+ public:
+  /// Weight of the latest sample in the moving averages.
+  static constexpr double DECAY = 0.2;
+
+  /// Number of batches between re-measurements of a codec.
+  static constexpr int EXPLORE_INTERVAL = 64;
+
+  ExchangeCodecSelector() = default;
+
+  /// Returns the codec to serialize the next batch with, if it is sent to
+  /// 'num_receivers' receivers.
+  CompressionTypePB::type NextCodec(int num_receivers = 1);
+
+  /// Records that serializing 'uncompressed_bytes' of tuple data, with 'codec' requested,
+  /// produced 'serialized_bytes' and took 'serialize_ns' nanoseconds.
+  void RecordSerialize(CompressionTypePB::type codec, int64_t uncompressed_bytes,
+      int64_t serialized_bytes, int64_t serialize_ns);
+
+  /// Records that sending 'serialized_bytes' to a receiver spent 'network_ns' nanoseconds
+  /// on the network.
+  void RecordTransmit(int64_t serialized_bytes, int64_t network_ns);
+
+ private:
+  /// The codecs to choose from, in the order in which they are first tried.
+  static constexpr int NUM_CODECS = 3;
+  static const CompressionTypePB::type CODECS[NUM_CODECS];
+
+  /// Moving averages for one codec, per uncompressed byte. Negative if not measured yet.
+  struct CodecStats {
+    double serialize_ns_per_byte = -1;
+    double ratio = -1;
+  };
+
+  /// Returns the index of 'codec' in CODECS.
+  static int CodecIdx(CompressionTypePB::type codec);
+
+  /// Protects all fields below.
+  SpinLock lock_;
+
+  CodecStats stats_[NUM_CODECS];
+
+  /// Moving average of the network time per serialized byte. Negative if not measured.
+  double network_ns_per_byte_ = -1;
+
+  /// Number of calls to NextCodec().
+  int64_t num_batches_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ExchangeCodecSelector);
+};
+
+} // namespace impala
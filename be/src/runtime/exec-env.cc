@@ -26,20 +26,25 @@
 
 #include "catalog/catalog-service-client-wrapper.h"
 #include "common/logging.h"
+#include "codegen/codegen-cache.h"
 #include "common/object-pool.h"
 #include "exec/kudu-util.h"
+#include "exec/parquet/parquet-metadata-cache.h"
+#include "exprs/regex-cache.h"
 #include "kudu/rpc/service_if.h"
 #include "rpc/rpc-mgr.h"
 #include "runtime/bufferpool/buffer-pool.h"
 #include "runtime/bufferpool/reservation-tracker.h"
 #include "runtime/client-cache.h"
 #include "runtime/coordinator.h"
+#include "runtime/fragment-result-cache.h"
 #include "runtime/hbase-table-factory.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/io/disk-io-mgr.h"
 #include "runtime/krpc-data-stream-mgr.h"
 #include "runtime/lib-cache.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/pool-cgroup-mgr.h"
 #include "runtime/query-exec-mgr.h"
 #include "runtime/thread-resource-mgr.h"
 #include "runtime/tmp-file-mgr.h"
@@ -55,8 +60,10 @@
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
 #include "util/default-path-handlers.h"
+#include "util/event-tracer.h"
 #include "util/hdfs-bulk-ops.h"
 #include "util/impalad-metrics.h"
+#include "util/lock-contention.h"
 #include "util/mem-info.h"
 #include "util/memory-metrics.h"
 #include "util/metrics.h"
@@ -65,9 +72,12 @@
 #include "util/parse-util.h"
 #include "util/periodic-counter-updater.h"
 #include "util/pretty-printer.h"
+#include "util/scope-exit-trigger.h"
+#include "util/stopwatch.h"
 #include "util/system-state-info.h"
 #include "util/test-info.h"
 #include "util/thread-pool.h"
+#include "util/thread.h"
 #include "util/uid-util.h"
 #include "util/webserver.h"
 
@@ -89,6 +99,69 @@ DEFINE_int32(state_store_subscriber_port, 23000,
     "port where StatestoreSubscriberService should be exported");
 DEFINE_int32(num_hdfs_worker_threads, 16,
     "(Advanced) The number of threads in the global HDFS operation pool");
+DEFINE_int32(num_parquet_decompression_threads, 8,
+    "(Advanced) The number of threads in the pool that decompresses Parquet data pages "
+    "ahead of time when the query option parquet_decompress_ahead_pages is set. If 0, "
+    "pages are always decompressed by the scanner threads.");
+DEFINE_int32(num_parquet_encoding_threads, 8,
+    "(Advanced) The number of threads in the pool that compresses the pages written by "
+    "the Parquet table writer when the query option parquet_parallel_encoding is set. If "
+    "0, pages are always compressed by the table sink threads.");
+DEFINE_int32(num_text_decompression_threads, 8,
+    "(Advanced) The number of threads in the pool that decompresses the frames of "
+    "compressed text files when the query option text_parallel_decompression is set. If "
+    "0, the files are always decompressed by the scanner threads.");
+DEFINE_int32(num_avro_decoding_threads, 8,
+    "(Advanced) The number of threads in the pool that decodes the data blocks of Avro "
+    "files when the query option avro_parallel_decoding is set. If 0, the blocks are "
+    "always decoded by the scanner threads.");
+DEFINE_int32(num_sort_threads, 16,
+    "(Advanced) The number of threads in the pool that sorts ranges of in-memory sort "
+    "runs when the query option sort_run_threads is greater than 1. If 0, the runs are "
+    "always sorted by the fragment instance threads.");
+DEFINE_int32(num_result_conversion_threads, 16,
+    "(Advanced) The number of threads in the pool of coordinators that converts query "
+    "results into the columns of HS2 fetch results when the query option "
+    "result_conversion_threads is greater than 1. If 0, the results are always "
+    "converted by the thread that adds them to the fetch result.");
+DEFINE_string(parquet_metadata_cache_capacity, "0",
+    "(Advanced) Memory limit of the process-wide cache of deserialized Parquet footers "
+    "and page indexes, e.g. 256MB, or a percentage of the physical memory. The cache is "
+    "disabled if this is 0.");
+DEFINE_string(regex_cache_capacity, "0",
+    "(Advanced) Memory limit of the process-wide cache of regular expressions compiled "
+    "from the constant patterns of LIKE, REGEXP and the regexp functions, e.g. 64MB, or "
+    "a percentage of the physical memory. The cache is disabled if this is 0.");
+DEFINE_string(codegen_cache_capacity, "0",
+    "(Advanced) Memory limit of the process-wide cache of the machine code of compiled "
+    "codegen modules, e.g. 256MB, or a percentage of the physical memory. Fragment "
+    "instances that generate a module that is in the cache skip its optimization and "
+    "compilation. The cache is disabled if this is 0.");
+DEFINE_string(fragment_result_cache_dir, "",
+    "(Advanced) Local directory, e.g. on the disk of the data cache, in which the "
+    "executor caches the output of fragment instances that only scan, filter and "
+    "pre-aggregate HDFS tables, for queries with the query option "
+    "ENABLE_FRAGMENT_RESULT_CACHE. The files are kept in a subdirectory that is cleared "
+    "on startup. The cache is disabled if this is empty.");
+DEFINE_string(fragment_result_cache_capacity, "10GB",
+    "(Advanced) Maximum size on disk of the fragment result cache, e.g. 10GB.");
+DEFINE_string(fragment_result_cache_max_entry_size, "256MB",
+    "(Advanced) Maximum size on disk of the output of a single fragment instance in the "
+    "fragment result cache. Larger outputs are not cached.");
+DEFINE_bool(pool_cgroup_cpu_isolation, false,
+    "(Advanced) If true, the threads that execute the fragment instances of a query run "
+    "in a cgroup v2 sub-group of the cgroup of impalad that belongs to the query's "
+    "resource pool, so that the pools share the CPUs by --pool_cgroup_cpu_weights and "
+    "--pool_cgroup_cpu_max. Requires that the cgroup of impalad is delegated to it with "
+    "the cpu controller available.");
+DEFINE_string(pool_cgroup_cpu_weights, "",
+    "(Advanced) Comma-separated list of <pool>:<weight> entries with the cgroup "
+    "cpu.weight, between 1 and 10000, of resource pools with "
+    "--pool_cgroup_cpu_isolation. Pools that are not listed have the weight 100.");
+DEFINE_string(pool_cgroup_cpu_max, "",
+    "(Advanced) Comma-separated list of <pool>:<cores> entries that limit the CPU usage "
+    "of the threads of resource pools with --pool_cgroup_cpu_isolation to a possibly "
+    "fractional number of cores, e.g. root.adhoc:4.5.");
 DEFINE_int32(max_concurrent_queries, 0,
     "(Deprecated) This has been replaced with --admission_control_slots, which "
     "better accounts for the higher parallelism of queries with mt_dop > 1. "
@@ -251,6 +324,30 @@ ExecEnv::ExecEnv(int krpc_port, int subscriber_port, int webserver_port,
     hdfs_op_thread_pool_.reset(
         CreateHdfsOpThreadPool("hdfs-worker-pool", FLAGS_num_hdfs_worker_threads, 1024));
   }
+  if (FLAGS_num_parquet_decompression_threads > 0) {
+    parquet_decompression_pool_.reset(new CallableThreadPool("parquet-decompression",
+        "parquet-decompressor", FLAGS_num_parquet_decompression_threads, 10000));
+  }
+  if (FLAGS_num_parquet_encoding_threads > 0) {
+    parquet_encoding_pool_.reset(new CallableThreadPool("parquet-encoding",
+        "parquet-encoder", FLAGS_num_parquet_encoding_threads, 10000));
+  }
+  if (FLAGS_num_text_decompression_threads > 0) {
+    text_decompression_pool_.reset(new CallableThreadPool("text-decompression",
+        "text-decompressor", FLAGS_num_text_decompression_threads, 10000));
+  }
+  if (FLAGS_num_avro_decoding_threads > 0) {
+    avro_decoding_pool_.reset(new CallableThreadPool("avro-decoding",
+        "avro-decoder", FLAGS_num_avro_decoding_threads, 10000));
+  }
+  if (FLAGS_num_sort_threads > 0) {
+    sort_pool_.reset(new CallableThreadPool("sort", "sorter", FLAGS_num_sort_threads,
+        10000));
+  }
+  if (FLAGS_is_coordinator && FLAGS_num_result_conversion_threads > 0) {
+    result_conversion_pool_.reset(new CallableThreadPool("result-conversion",
+        "result-converter", FLAGS_num_result_conversion_threads, 10000));
+  }
   if (FLAGS_is_coordinator && !AdmissionServiceEnabled()) {
     // We only need a Scheduler if we're performing admission control locally, i.e. if
     // this is a coordinator and there isn't an admissiond.
@@ -297,11 +394,29 @@ Status ExecEnv::InitForFeSupport() {
 
 Status ExecEnv::Init() {
   LOG(INFO) << "Initializing impalad with backend uuid: " << PrintId(backend_id_);
+  EventTracer::Init();
+  LockContention::InitMetrics(metrics_.get());
   // Initialize thread pools
   if (FLAGS_is_coordinator) {
     RETURN_IF_ERROR(hdfs_op_thread_pool_->Init());
   }
   RETURN_IF_ERROR(async_rpc_pool_->Init());
+  if (parquet_decompression_pool_ != nullptr) {
+    RETURN_IF_ERROR(parquet_decompression_pool_->Init());
+  }
+  if (parquet_encoding_pool_ != nullptr) {
+    RETURN_IF_ERROR(parquet_encoding_pool_->Init());
+  }
+  if (text_decompression_pool_ != nullptr) {
+    RETURN_IF_ERROR(text_decompression_pool_->Init());
+  }
+  if (avro_decoding_pool_ != nullptr) {
+    RETURN_IF_ERROR(avro_decoding_pool_->Init());
+  }
+  if (sort_pool_ != nullptr) RETURN_IF_ERROR(sort_pool_->Init());
+  if (result_conversion_pool_ != nullptr) {
+    RETURN_IF_ERROR(result_conversion_pool_->Init());
+  }
 
   int64_t bytes_limit;
   RETURN_IF_ERROR(ChooseProcessMemLimit(&bytes_limit));
@@ -384,6 +499,27 @@ Status ExecEnv::Init() {
 
   InitMemTracker(bytes_limit);
 
+  // Starting the disk I/O threads and loading the data cache from its directories can
+  // take a long time on hosts with many disks, and nothing needs the DiskIoMgr before
+  // the webserver starts. Initialize it in the background while the RPC services and the
+  // caches below are initialized. It needs the process MemTracker for its memory tiers.
+  MonotonicStopWatch disk_io_mgr_timer;
+  disk_io_mgr_timer.Start();
+  Status disk_io_mgr_status;
+  unique_ptr<Thread> disk_io_mgr_init_thread;
+  RETURN_IF_ERROR(Thread::Create("impala-server", "disk-io-mgr-init",
+      [this, &disk_io_mgr_status, &disk_io_mgr_timer]() {
+        disk_io_mgr_status = disk_io_mgr_->Init();
+        disk_io_mgr_timer.Stop();
+      }, &disk_io_mgr_init_thread));
+  auto join_disk_io_mgr_init = [&disk_io_mgr_init_thread]() {
+    if (disk_io_mgr_init_thread == nullptr) return;
+    disk_io_mgr_init_thread->Join();
+    disk_io_mgr_init_thread.reset();
+  };
+  // Wait for the thread on all error paths, it references local variables.
+  const auto join_on_exit = MakeScopeExitTrigger(join_disk_io_mgr_init);
+
   // Initializes the RPCMgr, ControlServices and DataStreamServices.
   // Initialization needs to happen in the following order due to dependencies:
   // - RPC manager, DataStreamService and DataStreamManager.
@@ -426,7 +562,73 @@ Status ExecEnv::Init() {
 #endif
   mem_tracker_->RegisterMetrics(metrics_.get(), "mem-tracker.process");
 
-  RETURN_IF_ERROR(disk_io_mgr_->Init());
+  int64_t metadata_cache_capacity = ParseUtil::ParseMemSpec(
+      FLAGS_parquet_metadata_cache_capacity, &is_percent, MemInfo::physical_mem());
+  if (metadata_cache_capacity < 0) {
+    return Status(Substitute("Invalid --parquet_metadata_cache_capacity value, must be "
+        "a bytes value or percentage: $0", FLAGS_parquet_metadata_cache_capacity));
+  }
+  if (metadata_cache_capacity > 0) {
+    parquet_metadata_cache_.reset(
+        new ParquetMetadataCache(metadata_cache_capacity, mem_tracker_.get()));
+    RETURN_IF_ERROR(parquet_metadata_cache_->Init(metrics_.get()));
+    LOG(INFO) << "Parquet metadata cache capacity: "
+              << PrettyPrinter::Print(metadata_cache_capacity, TUnit::BYTES);
+  }
+
+  int64_t regex_cache_capacity = ParseUtil::ParseMemSpec(
+      FLAGS_regex_cache_capacity, &is_percent, MemInfo::physical_mem());
+  if (regex_cache_capacity < 0) {
+    return Status(Substitute("Invalid --regex_cache_capacity value, must be a bytes "
+        "value or percentage: $0", FLAGS_regex_cache_capacity));
+  }
+  if (regex_cache_capacity > 0) {
+    regex_cache_.reset(new RegexCache(regex_cache_capacity, mem_tracker_.get()));
+    RETURN_IF_ERROR(regex_cache_->Init(metrics_.get()));
+    LOG(INFO) << "Regex cache capacity: "
+              << PrettyPrinter::Print(regex_cache_capacity, TUnit::BYTES);
+  }
+
+  int64_t codegen_cache_capacity = ParseUtil::ParseMemSpec(
+      FLAGS_codegen_cache_capacity, &is_percent, MemInfo::physical_mem());
+  if (codegen_cache_capacity < 0) {
+    return Status(Substitute("Invalid --codegen_cache_capacity value, must be a bytes "
+        "value or percentage: $0", FLAGS_codegen_cache_capacity));
+  }
+  if (codegen_cache_capacity > 0) {
+    codegen_cache_.reset(new CodegenCache(codegen_cache_capacity, mem_tracker_.get()));
+    RETURN_IF_ERROR(codegen_cache_->Init(metrics_.get()));
+    LOG(INFO) << "Codegen cache capacity: "
+              << PrettyPrinter::Print(codegen_cache_capacity, TUnit::BYTES);
+  }
+
+  if (!FLAGS_fragment_result_cache_dir.empty()) {
+    int64_t capacity = ParseUtil::ParseMemSpec(
+        FLAGS_fragment_result_cache_capacity, &is_percent, 0);
+    int64_t max_entry_size = ParseUtil::ParseMemSpec(
+        FLAGS_fragment_result_cache_max_entry_size, &is_percent, 0);
+    if (capacity <= 0 || max_entry_size <= 0) {
+      return Status(Substitute("Invalid --fragment_result_cache_capacity or "
+          "--fragment_result_cache_max_entry_size value, must be a positive bytes value: "
+          "$0, $1", FLAGS_fragment_result_cache_capacity,
+          FLAGS_fragment_result_cache_max_entry_size));
+    }
+    fragment_result_cache_.reset(new FragmentResultCache(
+        FLAGS_fragment_result_cache_dir, capacity, max_entry_size));
+    RETURN_IF_ERROR(fragment_result_cache_->Init(metrics_.get()));
+    LOG(INFO) << "Fragment result cache in " << FLAGS_fragment_result_cache_dir
+              << " with capacity " << PrettyPrinter::Print(capacity, TUnit::BYTES);
+  }
+
+  if (FLAGS_pool_cgroup_cpu_isolation) {
+    pool_cgroup_mgr_.reset(
+        new PoolCGroupMgr(FLAGS_pool_cgroup_cpu_weights, FLAGS_pool_cgroup_cpu_max));
+    RETURN_IF_ERROR(pool_cgroup_mgr_->Init(metrics_.get()));
+  }
+
+  join_disk_io_mgr_init();
+  RETURN_IF_ERROR(disk_io_mgr_status);
+  RecordStartupPhase("disk-io-mgr", disk_io_mgr_timer.ElapsedTime());
 
   // Start services in order to ensure that dependencies between them are met
   if (enable_webserver_) {
@@ -446,9 +648,21 @@ Status ExecEnv::Init() {
 
   RETURN_IF_ERROR(admission_controller_->Init());
   RETURN_IF_ERROR(InitHadoopConfig());
+  // Load the UDF libraries that previous processes used most while the server starts.
+  RETURN_IF_ERROR(LibCache::instance()->StartPrefetch());
   return Status::OK();
 }
 
+static const string STARTUP_PHASE_METRIC_KEY_TEMPLATE =
+    "impala-server.startup.phase-duration-ms.$0";
+
+void ExecEnv::RecordStartupPhase(const string& phase, int64_t duration_ns) {
+  int64_t duration_ms = duration_ns / (NANOS_PER_MICRO * MICROS_PER_MILLI);
+  metrics_->AddGauge(STARTUP_PHASE_METRIC_KEY_TEMPLATE, duration_ms, phase);
+  LOG(INFO) << "Startup phase " << phase << " took "
+            << PrettyPrinter::Print(duration_ns, TUnit::TIME_NS);
+}
+
 Status ExecEnv::InitHadoopConfig() {
   if (frontend_ != nullptr) {
     // Get the fs.defaultFS value set in core-site.xml and assign it to
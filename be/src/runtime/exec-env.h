@@ -44,10 +44,12 @@ class AdmissionController;
 class BufferPool;
 class CallableThreadPool;
 class ClusterMembershipMgr;
+class CodegenCache;
 class ControlService;
 class DataStreamMgr;
 class DataStreamService;
 class QueryExecMgr;
+class FragmentResultCache;
 class Frontend;
 class HBaseTableFactory;
 class HdfsFsCache;
@@ -56,9 +58,12 @@ class KrpcDataStreamMgr;
 class LibCache;
 class MemTracker;
 class MetricGroup;
+class ParquetMetadataCache;
+class PoolCGroupMgr;
 class PoolMemTrackerRegistry;
 class ObjectPool;
 class QueryResourceMgr;
+class RegexCache;
 class RequestPoolService;
 class ReservationTracker;
 class RpcMgr;
@@ -113,6 +118,11 @@ class ExecEnv {
   /// once.
   void SetImpalaServer(ImpalaServer* server);
 
+  /// Exports the time that the startup phase 'phase' took as the metric
+  /// "impala-server.startup.phase-duration-ms.<phase>" and logs it. Must be called at
+  /// most once per phase, after Init() registered the metrics.
+  void RecordStartupPhase(const std::string& phase, int64_t duration_ns);
+
   const BackendIdPB& backend_id() const { return backend_id_; }
 
   KrpcDataStreamMgr* stream_mgr() { return stream_mgr_.get(); }
@@ -137,6 +147,46 @@ class ExecEnv {
   }
   RequestPoolService* request_pool_service() { return request_pool_service_.get(); }
   CallableThreadPool* rpc_pool() { return async_rpc_pool_.get(); }
+  /// Pool used by the Parquet scanner to decompress data pages ahead of decoding. NULL
+  /// if --num_parquet_decompression_threads is 0.
+  CallableThreadPool* parquet_decompression_pool() {
+    return parquet_decompression_pool_.get();
+  }
+  /// Pool used by the Parquet table writer to compress pages in parallel. NULL if
+  /// --num_parquet_encoding_threads is 0.
+  CallableThreadPool* parquet_encoding_pool() { return parquet_encoding_pool_.get(); }
+  /// Pool used by the text scanner to decompress the frames of compressed files in
+  /// parallel. NULL if --num_text_decompression_threads is 0.
+  CallableThreadPool* text_decompression_pool() {
+    return text_decompression_pool_.get();
+  }
+  /// Pool used by the Avro scanner to decode data blocks in parallel. NULL if
+  /// --num_avro_decoding_threads is 0.
+  CallableThreadPool* avro_decoding_pool() { return avro_decoding_pool_.get(); }
+  /// Pool used by sorters to sort ranges of in-memory runs in parallel. NULL if
+  /// --num_sort_threads is 0.
+  CallableThreadPool* sort_pool() { return sort_pool_.get(); }
+  /// Pool used to convert query results into HS2 columns in parallel. NULL if this is
+  /// not a coordinator or --num_result_conversion_threads is 0.
+  CallableThreadPool* result_conversion_pool() { return result_conversion_pool_.get(); }
+
+  /// Process-wide cache of Parquet footers and page indexes. NULL if
+  /// --parquet_metadata_cache_capacity is 0.
+  ParquetMetadataCache* parquet_metadata_cache() {
+    return parquet_metadata_cache_.get();
+  }
+  /// Process-wide cache of compiled regular expressions. NULL if
+  /// --regex_cache_capacity is 0.
+  RegexCache* regex_cache() { return regex_cache_.get(); }
+  /// Process-wide cache of compiled codegen modules. NULL if --codegen_cache_capacity
+  /// is 0.
+  CodegenCache* codegen_cache() { return codegen_cache_.get(); }
+  /// Executor-local cache of the output of fragment instances. NULL if
+  /// --fragment_result_cache_dir is empty.
+  FragmentResultCache* fragment_result_cache() { return fragment_result_cache_.get(); }
+  /// Places the threads of the pools into cgroups. NULL if --pool_cgroup_cpu_isolation is
+  /// false.
+  PoolCGroupMgr* pool_cgroup_mgr() { return pool_cgroup_mgr_.get(); }
   QueryExecMgr* query_exec_mgr() { return query_exec_mgr_.get(); }
   RpcMgr* rpc_mgr() const { return rpc_mgr_.get(); }
   PoolMemTrackerRegistry* pool_mem_trackers() { return pool_mem_trackers_.get(); }
@@ -216,6 +266,12 @@ class ExecEnv {
   boost::scoped_ptr<Frontend> frontend_;
 
   boost::scoped_ptr<CallableThreadPool> async_rpc_pool_;
+  boost::scoped_ptr<CallableThreadPool> parquet_decompression_pool_;
+  boost::scoped_ptr<CallableThreadPool> parquet_encoding_pool_;
+  boost::scoped_ptr<CallableThreadPool> text_decompression_pool_;
+  boost::scoped_ptr<CallableThreadPool> avro_decoding_pool_;
+  boost::scoped_ptr<CallableThreadPool> sort_pool_;
+  boost::scoped_ptr<CallableThreadPool> result_conversion_pool_;
   boost::scoped_ptr<QueryExecMgr> query_exec_mgr_;
   boost::scoped_ptr<RpcMgr> rpc_mgr_;
   boost::scoped_ptr<ControlService> control_svc_;
@@ -230,6 +286,24 @@ class ExecEnv {
   /// Tracks system resource usage which we then include in profiles.
   boost::scoped_ptr<SystemStateInfo> system_state_info_;
 
+  /// Created in Init() if --parquet_metadata_cache_capacity is set. Declared after
+  /// 'mem_tracker_' so that its entries are freed first.
+  boost::scoped_ptr<ParquetMetadataCache> parquet_metadata_cache_;
+
+  /// Created in Init() if --regex_cache_capacity is set. Declared after 'mem_tracker_'
+  /// so that its entries are freed first.
+  boost::scoped_ptr<RegexCache> regex_cache_;
+
+  /// Created in Init() if --codegen_cache_capacity is set. Declared after
+  /// 'mem_tracker_' so that its entries are freed first.
+  boost::scoped_ptr<CodegenCache> codegen_cache_;
+
+  /// Created in Init() if --fragment_result_cache_dir is set.
+  boost::scoped_ptr<FragmentResultCache> fragment_result_cache_;
+
+  /// Created in Init() if --pool_cgroup_cpu_isolation is true.
+  boost::scoped_ptr<PoolCGroupMgr> pool_cgroup_mgr_;
+
   /// Not owned by this class
   ImpalaServer* impala_server_ = nullptr;
   MetricGroup* rpc_metrics_ = nullptr;
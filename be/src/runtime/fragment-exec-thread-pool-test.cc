@@ -0,0 +1,84 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <gutil/strings/substitute.h>
+
+#include "common/thread-debug-info.h"
+#include "runtime/fragment-exec-thread-pool.h"
+#include "testutil/gtest-util.h"
+#include "util/promise.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+const int NUM_THREADS = 2;
+
+/// Waits until 'pool' has 'num_idle' idle workers.
+static void WaitForIdleThreads(FragmentExecThreadPool* pool, int num_idle) {
+  while (pool->NumIdleThreads() != num_idle) usleep(1000);
+}
+
+TEST(FragmentExecThreadPoolTest, TryOffer) {
+  FragmentExecThreadPool pool("fragment-exec-test", "worker", NUM_THREADS);
+  ASSERT_OK(pool.Init());
+  WaitForIdleThreads(&pool, NUM_THREADS);
+
+  // Block all workers and check that further work is rejected instead of queued.
+  Promise<bool> release;
+  Promise<string> names[NUM_THREADS];
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    Promise<string>* name = &names[i];
+    ASSERT_TRUE(pool.TryOffer(Substitute("instance-$0", i), [name, &release]() {
+      name->Set(GetThreadDebugInfo()->GetThreadName());
+      release.Get();
+    }));
+  }
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    EXPECT_EQ(Substitute("instance-$0", i), names[i].Get());
+  }
+  EXPECT_EQ(0, pool.NumIdleThreads());
+  EXPECT_FALSE(pool.TryOffer("rejected", []() { FAIL() << "Should not run"; }));
+
+  // Workers become idle again once their work is done.
+  release.Set(true);
+  WaitForIdleThreads(&pool, NUM_THREADS);
+  Promise<string> name;
+  ASSERT_TRUE(pool.TryOffer("instance", [&name]() {
+    name.Set(GetThreadDebugInfo()->GetThreadName());
+  }));
+  EXPECT_EQ("instance", name.Get());
+}
+
+TEST(FragmentExecThreadPoolTest, Shutdown) {
+  // The destructor waits for running work to finish.
+  bool done = false;
+  {
+    FragmentExecThreadPool pool("fragment-exec-test", "worker", NUM_THREADS);
+    ASSERT_OK(pool.Init());
+    WaitForIdleThreads(&pool, NUM_THREADS);
+    ASSERT_TRUE(pool.TryOffer("instance", [&done]() {
+      usleep(100000);
+      done = true;
+    }));
+  }
+  EXPECT_TRUE(done);
+}
+
+} // namespace impala
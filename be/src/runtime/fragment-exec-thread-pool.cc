@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/fragment-exec-thread-pool.h"
+
+#include <gutil/strings/substitute.h>
+
+#include "common/logging.h"
+#include "common/thread-debug-info.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+FragmentExecThreadPool::FragmentExecThreadPool(
+    const string& group, const string& name_prefix, int num_threads)
+  : group_(group), name_prefix_(name_prefix) {
+  DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) workers_.emplace_back(new Worker());
+}
+
+FragmentExecThreadPool::~FragmentExecThreadPool() {
+  {
+    lock_guard<mutex> l(lock_);
+    shutdown_ = true;
+    for (auto& worker : workers_) worker->cv.NotifyOne();
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread != nullptr) worker->thread->Join();
+  }
+}
+
+Status FragmentExecThreadPool::Init() {
+  for (int i = 0; i < workers_.size(); ++i) {
+    unique_ptr<Thread> thread;
+    RETURN_IF_ERROR(Thread::Create(group_, Substitute("$0-$1", name_prefix_, i),
+        &FragmentExecThreadPool::WorkerLoop, this, i, &thread));
+    lock_guard<mutex> l(lock_);
+    workers_[i]->thread = move(thread);
+  }
+  return Status::OK();
+}
+
+bool FragmentExecThreadPool::TryOffer(
+    const string& thread_name, std::function<void()> fn) {
+  DCHECK(fn);
+  lock_guard<mutex> l(lock_);
+  if (shutdown_ || idle_workers_.empty()) return false;
+  Worker* worker = workers_[idle_workers_.back()].get();
+  idle_workers_.pop_back();
+  DCHECK(!worker->fn);
+  worker->fn = move(fn);
+  worker->thread_name = thread_name;
+  worker->cv.NotifyOne();
+  return true;
+}
+
+int FragmentExecThreadPool::NumIdleThreads() {
+  lock_guard<mutex> l(lock_);
+  return idle_workers_.size();
+}
+
+void FragmentExecThreadPool::WorkerLoop(int worker_idx) {
+  Worker* worker = workers_[worker_idx].get();
+  ThreadDebugInfo* debug_info = GetThreadDebugInfo();
+  DCHECK(debug_info != nullptr);
+  const string idle_name = debug_info->GetThreadName();
+  unique_lock<mutex> l(lock_);
+  while (true) {
+    idle_workers_.push_back(worker_idx);
+    while (!shutdown_ && !worker->fn) worker->cv.Wait(l);
+    if (!worker->fn) break;
+    std::function<void()> fn = move(worker->fn);
+    worker->fn = nullptr;
+    debug_info->SetThreadName(worker->thread_name);
+    l.unlock();
+    fn();
+    // Destroy the function and what it captured before the worker is idle again.
+    fn = nullptr;
+    debug_info->SetThreadName(idle_name);
+    l.lock();
+  }
+}
+
+} // namespace impala
@@ -0,0 +1,103 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/status.h"
+#include "util/condition-variable.h"
+#include "util/thread.h"
+
+namespace impala {
+
+/// A pool of pre-spawned threads that execute fragment instances. Starting an instance
+/// on an idle worker avoids creating, registering and tearing down a thread per
+/// instance, which is a noticeable share of the latency of short queries with a high
+/// mt_dop.
+///
+/// Unlike ThreadPool, work is never queued: a fragment instance may block until other
+/// instances of its query make progress, so waiting for a busy worker could deadlock.
+/// TryOffer() only hands work to an idle worker and returns false if there is none, in
+/// which case the caller starts a dedicated thread instead.
+///
+/// Workers are registered with the ThreadMgr once, under the fragment execution thread
+/// group. While a worker executes a function, its ThreadDebugInfo carries the name that
+/// a dedicated thread would have had. Per-thread CPU counters of the executing code are
+/// based on deltas of the thread's resource usage and work unchanged.
+/// Thread-safe.
+class FragmentExecThreadPool {
+ public:
+  /// Creates a pool with 'num_threads' workers named '<name_prefix>-<i>' in the thread
+  /// group 'group'. Workers are started by Init().
+  FragmentExecThreadPool(
+      const std::string& group, const std::string& name_prefix, int num_threads);
+
+  /// Shuts down the pool and waits for all workers to finish their current work.
+  ~FragmentExecThreadPool();
+
+  /// Starts all workers. Returns an error if a thread could not be created.
+  Status Init() WARN_UNUSED_RESULT;
+
+  /// Runs 'fn' on an idle worker, with 'thread_name' as the name in the worker's
+  /// ThreadDebugInfo while it runs. Returns false without running 'fn' if all workers
+  /// are busy or the pool is shut down.
+  bool TryOffer(const std::string& thread_name, std::function<void()> fn);
+
+  /// Returns the number of workers that are currently idle.
+  int NumIdleThreads();
+
+ private:
+  /// State of a single worker, protected by 'lock_'.
+  struct Worker {
+    /// The function to run next. Empty while the worker is idle.
+    std::function<void()> fn;
+
+    /// The ThreadDebugInfo name while running 'fn'.
+    std::string thread_name;
+
+    /// Signalled when 'fn' is set or the pool shuts down.
+    ConditionVariable cv;
+
+    std::unique_ptr<Thread> thread;
+  };
+
+  /// Main loop of the worker with index 'worker_idx'.
+  void WorkerLoop(int worker_idx);
+
+  const std::string group_;
+  const std::string name_prefix_;
+
+  /// Protects all members below, including the state of all workers.
+  std::mutex lock_;
+
+  /// All workers. Not resized after construction.
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  /// Indexes into 'workers_' of the idle workers. The most recently idle workers are at
+  /// the end and get work first, so that their stacks and caches are still warm.
+  std::vector<int> idle_workers_;
+
+  /// True once the destructor started.
+  bool shutdown_ = false;
+};
+
+} // namespace impala
@@ -22,6 +22,7 @@
 #include <boost/bind.hpp>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/thread/thread_time.hpp>
+#include <gutil/strings/substitute.h>
 #include <thrift/protocol/TDebugProtocol.h>
 
 #include "codegen/llvm-codegen.h"
@@ -34,20 +35,26 @@
 #include "exec/plan-root-sink.h"
 #include "exec/scan-node.h"
 #include "gen-cpp/ImpalaInternalService_types.h"
+#include "gen-cpp/Results_types.h"
 #include "kudu/rpc/rpc_context.h"
+#include "rpc/thrift-util.h"
 #include "runtime/client-cache.h"
+#include "runtime/descriptors.h"
 #include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
 #include "runtime/krpc-data-stream-sender.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/pool-cgroup-mgr.h"
 #include "runtime/query-state.h"
 #include "runtime/row-batch.h"
 #include "runtime/runtime-filter-bank.h"
 #include "runtime/runtime-state.h"
 #include "runtime/thread-resource-mgr.h"
 #include "util/container-util.h"
+#include "util/cpu-sampler.h"
 #include "util/debug-util.h"
 #include "util/periodic-counter-updater.h"
+#include "util/query-cache-util.h"
 #include "util/uid-util.h"
 
 #include "common/names.h"
@@ -56,6 +63,8 @@ using google::protobuf::RepeatedPtrField;
 using kudu::rpc::RpcContext;
 using namespace apache::thrift;
 
+DECLARE_int32(status_report_full_profile_interval);
+
 namespace impala {
 
 const string FragmentInstanceState::PER_HOST_PEAK_MEM_COUNTER = "PerHostPeakMemUsage";
@@ -65,9 +74,15 @@ const string FragmentInstanceState::FINST_THREAD_NAME_PREFIX = "exec-finstance";
 static const string OPEN_TIMER_NAME = "OpenTime";
 static const string PREPARE_TIMER_NAME = "PrepareTime";
 static const string EXEC_TIMER_NAME = "ExecTime";
+static const string RESULT_CACHE_KEY = "Fragment Result Cache";
+static const string CPU_PROFILE_KEY = "CPU Profile (folded stacks)";
+static const string CPU_PROFILE_SAMPLES_KEY = "CPU Profile Samples";
+
+// Maximum number of distinct stacks in the CPU profile of a fragment instance.
+static const int MAX_CPU_PROFILE_STACKS = 500;
 
 PROFILE_DECLARE_COUNTER(ScanRangesComplete);
-PROFILE_DECLARE_COUNTER(BytesRead);
+PROFILE_DECLARE_STRIPED_COUNTER(BytesRead);
 
 FragmentInstanceState::FragmentInstanceState(QueryState* query_state,
     FragmentState* fragment_state, const TPlanFragmentInstanceCtx& instance_ctx,
@@ -83,6 +98,10 @@ Status FragmentInstanceState::Exec() {
   bool is_prepared = false;
   Status status = Prepare();
   DCHECK(runtime_state_ != nullptr);  // we need to guarantee at least that
+  // Samples this thread until Close(), which adds the samples to the profile.
+  ScopedCpuSampler cpu_sampler(runtime_state_->cpu_samples());
+  // Runs this thread in the cgroup of the query's pool, if enabled.
+  ScopedPoolCGroup pool_cgroup(query_state_->query_ctx().request_pool);
 
   if (!status.ok()) {
     discard_result(opened_promise_.Set(status));
@@ -105,6 +124,7 @@ Status FragmentInstanceState::Exec() {
   }
 
 done:
+  cpu_sampler.Stop();
   // Don't transition to completion until Close() is called as some new errors may be
   // logged in RuntimeState:error_log_.
   Close();
@@ -299,6 +319,18 @@ void FragmentInstanceState::GetStatusReport(FragmentInstanceExecStatusPB* instan
   } else {
     DCHECK(unagg_profile != nullptr);
     profile()->ToThrift(unagg_profile);
+    // The coordinator merges the reported profile into its copy of the profile, so it is
+    // enough to send what changed since the last report that it received. Full profiles
+    // are still sent periodically and in the final report, in case a report was applied
+    // only partially.
+    pending_profile_ = *unagg_profile;
+    if (has_reported_profile_ && !done
+        && num_delta_profile_reports_ + 1 < FLAGS_status_report_full_profile_interval) {
+      RuntimeProfile::RemoveUnchangedFromThrift(reported_profile_, unagg_profile);
+      ++num_delta_profile_reports_;
+    } else {
+      num_delta_profile_reports_ = 0;
+    }
   }
 
   // Pull out and aggregate counters from the profile.
@@ -384,13 +416,19 @@ void FragmentInstanceState::GetStatusReport(FragmentInstanceExecStatusPB* instan
 }
 
 void FragmentInstanceState::ReportSuccessful(
-    const FragmentInstanceExecStatusPB& instance_exec_status) {
+    const FragmentInstanceExecStatusPB& instance_exec_status, bool profile_sent) {
   prev_stateful_reports_.clear();
+  if (profile_sent && !pending_profile_.nodes.empty()) {
+    reported_profile_ = move(pending_profile_);
+    has_reported_profile_ = true;
+  }
+  pending_profile_.nodes.clear();
   if (instance_exec_status.done()) final_report_sent_ = true;
 }
 
 void FragmentInstanceState::ReportFailed(
     const FragmentInstanceExecStatusPB& instance_exec_status) {
+  pending_profile_.nodes.clear();
   int num_reports = instance_exec_status.stateful_report_size();
   if (num_reports > 0 && prev_stateful_reports_.size() != num_reports) {
     // If a stateful report was generated in GetStatusReport(), copy it to
@@ -412,6 +450,26 @@ Status FragmentInstanceState::Open() {
       ADD_TIMER(timings_profile_, OPEN_TIMER_NAME));
   SCOPED_THREAD_COUNTER_MEASUREMENT(runtime_state_->total_thread_statistics());
 
+  string result_cache_key;
+  if (GetResultCacheKey(&result_cache_key)) {
+    FragmentResultCache* result_cache = ExecEnv::GetInstance()->fragment_result_cache();
+    RuntimeProfile::Counter* hits_counter =
+        ADD_COUNTER(profile(), "FragmentResultCacheHits", TUnit::UNIT);
+    RuntimeProfile::Counter* misses_counter =
+        ADD_COUNTER(profile(), "FragmentResultCacheMisses", TUnit::UNIT);
+    result_cache_reader_ = result_cache->Lookup(result_cache_key);
+    if (result_cache_reader_ != nullptr) {
+      // Neither codegen nor the exec tree are needed to replay the cached output.
+      COUNTER_ADD(hits_counter, 1);
+      profile()->AddInfoString(RESULT_CACHE_KEY, "Hit");
+      UpdateState(StateEvent::OPEN_START);
+      return sink_->Open(runtime_state_);
+    }
+    COUNTER_ADD(misses_counter, 1);
+    profile()->AddInfoString(RESULT_CACHE_KEY, "Miss");
+    result_cache_writer_ = result_cache->StartInsert(result_cache_key);
+  }
+
   if (fragment_state_->ShouldCodegen()) {
     UpdateState(StateEvent::CODEGEN_START);
     RETURN_IF_ERROR(fragment_state_->InvokeCodegen(event_sequence_));
@@ -428,6 +486,103 @@ Status FragmentInstanceState::Open() {
   return sink_->Open(runtime_state_);
 }
 
+bool FragmentInstanceState::GetResultCacheKey(string* key) const {
+  if (!query_state_->query_options().enable_fragment_result_cache) return false;
+  if (ExecEnv::GetInstance()->fragment_result_cache() == nullptr) return false;
+  // The planner flags queries that call non-deterministic, time or user-defined
+  // functions anywhere, also in the definitions of views.
+  if (!HasDeterministicResults(query_state_->query_ctx())) return false;
+  // Instances of the same fragment on a backend share their scan ranges, so the output
+  // of one instance depends on the progress of the others.
+  if (fragment_state_->instance_ctxs().size() != 1) return false;
+  if (!fragment_.__isset.plan || !instance_ctx_pb_.join_build_inputs().empty()) {
+    return false;
+  }
+  for (const TPlanNode& node : fragment_.plan.nodes) {
+    if (node.node_type != TPlanNodeType::HDFS_SCAN_NODE
+        && node.node_type != TPlanNodeType::SELECT_NODE
+        && node.node_type != TPlanNodeType::AGGREGATION_NODE) {
+      return false;
+    }
+    // Which rows pass a limit depends on the order in which scan ranges are read.
+    // Runtime filters depend on the other fragments of the query.
+    if (node.limit >= 0 || !node.runtime_filters.empty()) return false;
+  }
+
+  // The key consists of the plan, the query options, the layout of the output rows and
+  // the scanned files with their versions.
+  ThriftSerializer serializer(/* compact */ true);
+  string plan;
+  string query_options;
+  if (!serializer.SerializeToString(&fragment_.plan, &plan).ok()
+      || !serializer.SerializeToString(&query_state_->query_options(), &query_options)
+          .ok()) {
+    return false;
+  }
+  stringstream ss;
+  ss << plan << "\n" << query_options << "\n"
+     << query_state_->query_ctx().local_time_zone << "\n";
+  for (const TupleDescriptor* tuple_desc : exec_tree_->row_desc()->tuple_descriptors()) {
+    ss << tuple_desc->DebugString() << "\n";
+  }
+  const DescriptorTbl& desc_tbl = query_state_->desc_tbl();
+  for (const TPlanNode& node : fragment_.plan.nodes) {
+    if (node.node_type != TPlanNodeType::HDFS_SCAN_NODE) continue;
+    const TupleDescriptor* tuple_desc =
+        desc_tbl.GetTupleDescriptor(node.hdfs_scan_node.tuple_id);
+    const HdfsTableDescriptor* table_desc =
+        static_cast<const HdfsTableDescriptor*>(tuple_desc->table_desc());
+    ss << tuple_desc->DebugString() << "\n" << table_desc->fully_qualified_name();
+    auto ranges = instance_ctx_pb_.per_node_scan_ranges().find(node.node_id);
+    if (ranges == instance_ctx_pb_.per_node_scan_ranges().end()) continue;
+    for (const ScanRangeParamsPB& params : ranges->second.scan_ranges()) {
+      if (!params.scan_range().has_hdfs_file_split()) return false;
+      const HdfsFileSplitPB& split = params.scan_range().hdfs_file_split();
+      const HdfsPartitionDescriptor* partition =
+          table_desc->GetPartition(split.partition_id());
+      if (partition == nullptr) return false;
+      ss << "\n" << partition->location() << "/" << split.relative_path() << ":"
+         << split.offset() << ":" << split.length() << ":" << split.file_length() << ":"
+         << split.mtime();
+    }
+    ss << "\n";
+  }
+  *key = ss.str();
+  return true;
+}
+
+Status FragmentInstanceState::GetNextCachedBatch(unique_ptr<RowBatch>* batch, bool* eos) {
+  string block;
+  RETURN_IF_ERROR(result_cache_reader_->GetNext(&block, eos));
+  TRowBatch thrift_batch;
+  uint32_t len = block.size();
+  RETURN_IF_ERROR(DeserializeThriftMsg(reinterpret_cast<const uint8_t*>(block.data()),
+      &len, /* compact */ true, &thrift_batch));
+  // Free the previous batch before allocating the next one.
+  batch->reset();
+  batch->reset(new RowBatch(exec_tree_->row_desc(), thrift_batch,
+      runtime_state_->instance_mem_tracker()));
+  return Status::OK();
+}
+
+void FragmentInstanceState::AddBatchToResultCache(RowBatch* batch, bool eos) {
+  DCHECK(result_cache_writer_ != nullptr);
+  TRowBatch thrift_batch;
+  string block;
+  ThriftSerializer serializer(/* compact */ true);
+  Status status = batch->Serialize(&thrift_batch);
+  if (status.ok()) status = serializer.SerializeToString(&thrift_batch, &block);
+  if (!status.ok() || !result_cache_writer_->Append(block)) {
+    profile()->AddInfoString(RESULT_CACHE_KEY, "Miss, output not cached");
+    result_cache_writer_.reset();
+    return;
+  }
+  if (!eos) return;
+  result_cache_writer_->Commit();
+  result_cache_writer_.reset();
+  profile()->AddInfoString(RESULT_CACHE_KEY, "Miss, output cached");
+}
+
 Status FragmentInstanceState::ExecInternal() {
   DCHECK_EQ(current_state_.Load(), FInstanceExecStatePB::WAITING_FOR_OPEN);
   // Inject failure if debug actions are enabled.
@@ -437,23 +592,32 @@ Status FragmentInstanceState::ExecInternal() {
       ADD_CHILD_TIMER(timings_profile_, "ExecTreeExecTime", EXEC_TIMER_NAME);
   SCOPED_THREAD_COUNTER_MEASUREMENT(runtime_state_->total_thread_statistics());
   bool exec_tree_complete = false;
+  // The current batch of the cached output if it is replayed.
+  unique_ptr<RowBatch> cached_batch;
   UpdateState(StateEvent::WAITING_FOR_FIRST_BATCH);
   do {
     Status status;
     row_batch_->Reset();
+    RowBatch* batch = row_batch_.get();
     {
       SCOPED_TIMER(plan_exec_timer);
-      RETURN_IF_ERROR(
-          exec_tree_->GetNext(runtime_state_, row_batch_.get(), &exec_tree_complete));
+      if (result_cache_reader_ != nullptr) {
+        RETURN_IF_ERROR(GetNextCachedBatch(&cached_batch, &exec_tree_complete));
+        batch = cached_batch.get();
+      } else {
+        RETURN_IF_ERROR(exec_tree_->GetNext(runtime_state_, batch, &exec_tree_complete));
+      }
     }
     UpdateState(StateEvent::BATCH_PRODUCED);
-    if (VLOG_ROW_IS_ON) row_batch_->VLogRows("FragmentInstanceState::ExecInternal()");
-    COUNTER_ADD(rows_produced_counter_, row_batch_->num_rows());
-    RETURN_IF_ERROR(sink_->Send(runtime_state_, row_batch_.get()));
+    if (VLOG_ROW_IS_ON) batch->VLogRows("FragmentInstanceState::ExecInternal()");
+    COUNTER_ADD(rows_produced_counter_, batch->num_rows());
+    if (result_cache_writer_ != nullptr) AddBatchToResultCache(batch, exec_tree_complete);
+    RETURN_IF_ERROR(sink_->Send(runtime_state_, batch));
     UpdateState(StateEvent::BATCH_SENT);
   } while (!exec_tree_complete);
   // Release resources from final row batch.
   row_batch_->Reset();
+  cached_batch.reset();
 
   UpdateState(StateEvent::LAST_BATCH_SENT);
 
@@ -490,8 +654,20 @@ void FragmentInstanceState::Close() {
 
   // Delete row_batch_ to free resources associated with it.
   row_batch_.reset();
+  // Discard an uncommitted result cache entry.
+  result_cache_writer_.reset();
+  result_cache_reader_.reset();
   if (exec_tree_ != nullptr) exec_tree_->Close(runtime_state_);
   runtime_state_->ReleaseResources();
+  // All threads that were sampled have stopped by now.
+  CpuSampleCollector* cpu_samples = runtime_state_->cpu_samples();
+  if (cpu_samples != nullptr) {
+    profile()->AddInfoString(CPU_PROFILE_SAMPLES_KEY,
+        Substitute("$0 at $1 Hz of CPU time ($2 dropped)", cpu_samples->num_samples(),
+            cpu_samples->sampling_hz(), cpu_samples->num_dropped()));
+    profile()->AddInfoString(
+        CPU_PROFILE_KEY, cpu_samples->ToFoldedStacks(MAX_CPU_PROFILE_STACKS));
+  }
 
   // Sanity timer checks
 #ifndef NDEBUG
@@ -30,6 +30,7 @@
 #include "gen-cpp/data_stream_service.pb.h"
 #include "gen-cpp/ImpalaInternalService_types.h"
 #include "gutil/threading/thread_collision_warner.h" // for DFAKE_*
+#include "runtime/fragment-result-cache.h"
 #include "runtime/row-batch.h"
 #include "util/condition-variable.h"
 #include "util/promise.h"
@@ -103,7 +104,10 @@ class FragmentInstanceState {
   /// Called periodically by query state thread to get the current status of this fragment
   /// instance. The fragment instance's status is stored in 'instance_status' and its
   /// Thrift runtime profile is stored in either 'unagg_profile' or 'agg_profile',
-  /// depending on whether aggregated profiles are enabled.
+  /// depending on whether aggregated profiles are enabled. 'unagg_profile' only contains
+  /// the changes since the profile of the last successful report, except for every
+  /// --status_report_full_profile_interval-th report and the final report, which
+  /// contain the full profile.
   void GetStatusReport(FragmentInstanceExecStatusPB* instance_status,
       TRuntimeProfileTree* unagg_profile, AggregatedRuntimeProfile* agg_profile,
       const Status& overall_status);
@@ -111,8 +115,10 @@ class FragmentInstanceState {
   /// After each call to GetStatusReport(), the query state thread should call one of the
   /// following to indicate if the report rpc was successful. Note that in the case of
   /// ReportFailed(), the report may have been received by the coordinator even though the
-  /// rpc appeared to fail.
-  void ReportSuccessful(const FragmentInstanceExecStatusPB& instance_status);
+  /// rpc appeared to fail. 'profile_sent' is false if the report was sent without the
+  /// profile, e.g. because it could not be serialized.
+  void ReportSuccessful(
+      const FragmentInstanceExecStatusPB& instance_status, bool profile_sent);
   void ReportFailed(const FragmentInstanceExecStatusPB& instance_status);
 
   /// Accessor functions for this fragment instance's sink. Valid after the Prepare
@@ -202,6 +208,19 @@ class FragmentInstanceState {
   /// number should not be bumped for future reports.
   bool final_report_generated_ = false;
 
+  /// The full profile of the last report that was received by the coordinator, which
+  /// later reports only send the changes from. Only used without aggregated profiles.
+  TRuntimeProfileTree reported_profile_;
+  bool has_reported_profile_ = false;
+
+  /// The full profile of the report that is being sent. Becomes 'reported_profile_' if
+  /// the report is successful.
+  TRuntimeProfileTree pending_profile_;
+
+  /// The number of reports with only the changes of the profile since the last report
+  /// with the full profile.
+  int num_delta_profile_reports_ = 0;
+
   /// Total scan ranges complete across all scan nodes. Set in GetStatusReport().
   int64_t scan_ranges_complete_ = 0;
 
@@ -269,6 +288,16 @@ class FragmentInstanceState {
   /// should live in obj_pool(), but managed separately so we can delete it in Close()
   boost::scoped_ptr<RowBatch> row_batch_;
 
+  /// Set in Open() if the output of this instance is served from the
+  /// FragmentResultCache. 'exec_tree_' is not opened and executed in that case.
+  std::unique_ptr<FragmentResultCache::Reader> result_cache_reader_;
+
+  /// Set in Open() if the output of this instance can be cached but was not found in
+  /// the FragmentResultCache. The output of 'exec_tree_' is written to it and the entry
+  /// is committed at the end of the output. Reset if the output exceeds the maximum
+  /// entry size.
+  std::unique_ptr<FragmentResultCache::Writer> result_cache_writer_;
+
   /// Set when OpenInternal() returns.
   Promise<Status> opened_promise_;
 
@@ -315,6 +344,22 @@ class FragmentInstanceState {
   /// Executes Open() logic and returns resulting status.
   Status Open() WARN_UNUSED_RESULT;
 
+  /// Returns true and sets 'key' to the key of the output of this instance in the
+  /// FragmentResultCache if the output can be cached. The output can be cached if it
+  /// only depends on the scanned HDFS files, i.e. the fragment only consists of HDFS
+  /// scans, selects and aggregations without limits, runtime filters or
+  /// non-deterministic functions, and if it is the only instance of the fragment on
+  /// this backend, so that it reads all of its scan ranges itself.
+  bool GetResultCacheKey(std::string* key) const;
+
+  /// Reads the next batch of the cached output from 'result_cache_reader_' into 'batch'.
+  Status GetNextCachedBatch(std::unique_ptr<RowBatch>* batch, bool* eos)
+      WARN_UNUSED_RESULT;
+
+  /// Appends 'batch' to 'result_cache_writer_' and commits the entry if 'eos' is true.
+  /// Discards the entry if the batch cannot be added.
+  void AddBatchToResultCache(RowBatch* batch, bool eos);
+
   /// Pulls row batches from exec_tree_ and pushes them to sink_ in a loop. Returns
   /// OK if the input was exhausted and sent to the sink successfully, an error otherwise.
   /// If ExecInternal() returns without an error condition, all rows will have been sent
@@ -0,0 +1,129 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <gutil/strings/substitute.h>
+
+#include "runtime/fragment-result-cache.h"
+#include "testutil/gtest-util.h"
+#include "util/filesystem-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+class FragmentResultCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    dir_ = Substitute("/tmp/fragment-result-cache-test-$0", getpid());
+    ASSERT_OK(FileSystemUtil::RemoveAndCreateDirectory(dir_));
+  }
+
+  virtual void TearDown() {
+    ASSERT_OK(FileSystemUtil::RemovePaths({dir_}));
+  }
+
+  /// Writes and commits an entry with 'key' consisting of 'blocks'. Returns false if the
+  /// entry could not be written.
+  static bool Insert(FragmentResultCache* cache, const string& key,
+      const vector<string>& blocks) {
+    unique_ptr<FragmentResultCache::Writer> writer = cache->StartInsert(key);
+    if (writer == nullptr) return false;
+    for (const string& block : blocks) {
+      if (!writer->Append(block)) return false;
+    }
+    writer->Commit();
+    return true;
+  }
+
+  /// Reads all blocks of the entry with 'key' into 'blocks'. Returns false on a miss.
+  static bool Read(FragmentResultCache* cache, const string& key,
+      vector<string>* blocks) {
+    unique_ptr<FragmentResultCache::Reader> reader = cache->Lookup(key);
+    if (reader == nullptr) return false;
+    blocks->clear();
+    bool eos = false;
+    while (!eos) {
+      string block;
+      EXPECT_OK(reader->GetNext(&block, &eos));
+      blocks->push_back(block);
+    }
+    return true;
+  }
+
+  string dir_;
+  MetricGroup metrics_{"fragment-result-cache-test"};
+};
+
+TEST_F(FragmentResultCacheTest, InsertAndLookup) {
+  FragmentResultCache cache(dir_, 1024 * 1024, 1024 * 1024);
+  ASSERT_OK(cache.Init(&metrics_));
+  vector<string> blocks;
+  EXPECT_FALSE(Read(&cache, "k1", &blocks));
+
+  // Entries are only visible after they were committed.
+  {
+    unique_ptr<FragmentResultCache::Writer> writer = cache.StartInsert("k1");
+    ASSERT_NE(nullptr, writer);
+    EXPECT_TRUE(writer->Append("abc"));
+    EXPECT_FALSE(Read(&cache, "k1", &blocks));
+  }
+  EXPECT_FALSE(Read(&cache, "k1", &blocks));
+
+  ASSERT_TRUE(Insert(&cache, "k1", {"abc", "", string(1000, 'x')}));
+  ASSERT_TRUE(Read(&cache, "k1", &blocks));
+  EXPECT_EQ((vector<string>{"abc", "", string(1000, 'x')}), blocks);
+
+  // A new entry replaces an existing one.
+  ASSERT_TRUE(Insert(&cache, "k1", {"def"}));
+  ASSERT_TRUE(Read(&cache, "k1", &blocks));
+  EXPECT_EQ(vector<string>{"def"}, blocks);
+}
+
+TEST_F(FragmentResultCacheTest, Eviction) {
+  // Every entry takes 8 bytes for the length and 100 bytes for the block. There is
+  // room for two entries, but not three.
+  FragmentResultCache cache(dir_, 250, 150);
+  ASSERT_OK(cache.Init(&metrics_));
+  ASSERT_TRUE(Insert(&cache, "k1", {string(100, 'x')}));
+  ASSERT_TRUE(Insert(&cache, "k2", {string(100, 'y')}));
+
+  // Use "k1", so that "k2" is the least recently used entry. An evicted entry remains
+  // readable by an existing Reader.
+  unique_ptr<FragmentResultCache::Reader> reader = cache.Lookup("k2");
+  ASSERT_NE(nullptr, reader);
+  vector<string> blocks;
+  EXPECT_TRUE(Read(&cache, "k1", &blocks));
+  ASSERT_TRUE(Insert(&cache, "k3", {string(100, 'z')}));
+  EXPECT_TRUE(Read(&cache, "k1", &blocks));
+  EXPECT_FALSE(Read(&cache, "k2", &blocks));
+  EXPECT_TRUE(Read(&cache, "k3", &blocks));
+  string block;
+  bool eos;
+  ASSERT_OK(reader->GetNext(&block, &eos));
+  EXPECT_EQ(string(100, 'y'), block);
+  EXPECT_TRUE(eos);
+
+  // Entries that are larger than the maximum entry size are not cached.
+  EXPECT_FALSE(Insert(&cache, "k4", {string(100, 'x'), string(100, 'x')}));
+  EXPECT_FALSE(Read(&cache, "k4", &blocks));
+  EXPECT_TRUE(Read(&cache, "k3", &blocks));
+}
+
+} // namespace impala
@@ -0,0 +1,181 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/fragment-result-cache.h"
+
+#include <cstdio>
+
+#include <gutil/strings/substitute.h>
+
+#include "util/filesystem-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Name of the subdirectory of the configured directory with the files of the cache.
+static const string CACHE_SUBDIR = "impala-fragment-result-cache";
+
+FragmentResultCache::Reader::Reader(const string& path)
+  : path_(path), file_(path, std::ios::binary) {}
+
+Status FragmentResultCache::Reader::GetNext(string* block, bool* eos) {
+  int64_t len;
+  file_.read(reinterpret_cast<char*>(&len), sizeof(len));
+  if (!file_ || len < 0) {
+    return Status(Substitute("Could not read fragment result cache file $0", path_));
+  }
+  block->resize(len);
+  file_.read(&(*block)[0], len);
+  if (!file_) {
+    return Status(Substitute("Could not read fragment result cache file $0", path_));
+  }
+  *eos = file_.peek() == std::ifstream::traits_type::eof();
+  return Status::OK();
+}
+
+FragmentResultCache::Writer::Writer(
+    FragmentResultCache* cache, const string& key, const string& path)
+  : cache_(cache), key_(key), path_(path),
+    file_(path, std::ios::binary | std::ios::trunc) {}
+
+FragmentResultCache::Writer::~Writer() {
+  if (committed_) return;
+  file_.close();
+  remove(path_.c_str());
+}
+
+bool FragmentResultCache::Writer::Append(const string& block) {
+  DCHECK(!committed_);
+  const int64_t len = block.size();
+  bytes_written_ += sizeof(len) + len;
+  if (bytes_written_ > cache_->max_entry_bytes_) return false;
+  file_.write(reinterpret_cast<const char*>(&len), sizeof(len));
+  file_.write(block.data(), len);
+  return static_cast<bool>(file_);
+}
+
+void FragmentResultCache::Writer::Commit() {
+  DCHECK(!committed_);
+  file_.close();
+  if (!file_) {
+    LOG(WARNING) << "Could not write fragment result cache file " << path_;
+    return;
+  }
+  committed_ = true;
+  cache_->Insert(key_, path_, bytes_written_);
+}
+
+FragmentResultCache::FragmentResultCache(
+    const string& dir, int64_t capacity, int64_t max_entry_bytes)
+  : dir_(Substitute("$0/$1", dir, CACHE_SUBDIR)),
+    capacity_(capacity),
+    max_entry_bytes_(min(max_entry_bytes, capacity)) {
+  DCHECK_GT(capacity, 0);
+}
+
+FragmentResultCache::~FragmentResultCache() {
+  lock_guard<mutex> l(lock_);
+  while (!entries_.empty()) Erase(entries_.begin());
+}
+
+Status FragmentResultCache::Init(MetricGroup* metrics) {
+  RETURN_IF_ERROR(FileSystemUtil::RemoveAndCreateDirectory(dir_));
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("fragment-result-cache");
+  hits_metric_ = cache_metrics->AddCounter("fragment-result-cache.hit-count", 0);
+  misses_metric_ = cache_metrics->AddCounter("fragment-result-cache.miss-count", 0);
+  evictions_metric_ =
+      cache_metrics->AddCounter("fragment-result-cache.eviction-count", 0);
+  total_bytes_metric_ = cache_metrics->AddGauge("fragment-result-cache.total-bytes", 0);
+  num_entries_metric_ = cache_metrics->AddGauge("fragment-result-cache.num-entries", 0);
+  return Status::OK();
+}
+
+unique_ptr<FragmentResultCache::Reader> FragmentResultCache::Lookup(const string& key) {
+  lock_guard<mutex> l(lock_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    if (misses_metric_ != nullptr) misses_metric_->Increment(1);
+    return nullptr;
+  }
+  // Open the file while holding 'lock_', so that it cannot be deleted before. An open
+  // file remains readable after it is deleted.
+  unique_ptr<Reader> reader(new Reader(it->second.path));
+  if (!reader->file_.is_open()) {
+    LOG(WARNING) << "Could not open fragment result cache file " << it->second.path;
+    Erase(it);
+    if (misses_metric_ != nullptr) misses_metric_->Increment(1);
+    return nullptr;
+  }
+  lru_list_.splice(lru_list_.end(), lru_list_, it->second.lru_it);
+  if (hits_metric_ != nullptr) hits_metric_->Increment(1);
+  return reader;
+}
+
+unique_ptr<FragmentResultCache::Writer> FragmentResultCache::StartInsert(
+    const string& key) {
+  string path;
+  {
+    lock_guard<mutex> l(lock_);
+    path = Substitute("$0/entry-$1", dir_, next_file_id_++);
+  }
+  unique_ptr<Writer> writer(new Writer(this, key, path));
+  if (!writer->file_.is_open()) {
+    LOG(WARNING) << "Could not create fragment result cache file " << path;
+    return nullptr;
+  }
+  return writer;
+}
+
+void FragmentResultCache::Insert(const string& key, const string& path, int64_t bytes) {
+  DCHECK_LE(bytes, capacity_);
+  lock_guard<mutex> l(lock_);
+  // Concurrent instances may insert the same key, the last insertion replaces the
+  // earlier entries.
+  auto existing = entries_.find(key);
+  if (existing != entries_.end()) Erase(existing);
+  while (total_bytes_ + bytes > capacity_) {
+    DCHECK(!lru_list_.empty());
+    Erase(entries_.find(lru_list_.front()));
+    if (evictions_metric_ != nullptr) evictions_metric_->Increment(1);
+  }
+  lru_list_.push_back(key);
+  entries_.emplace(key, CacheValue{path, bytes, std::prev(lru_list_.end())});
+  total_bytes_ += bytes;
+  if (total_bytes_metric_ != nullptr) {
+    total_bytes_metric_->Increment(bytes);
+    num_entries_metric_->Increment(1);
+  }
+}
+
+void FragmentResultCache::Erase(std::unordered_map<string, CacheValue>::iterator it) {
+  DCHECK(it != entries_.end());
+  if (remove(it->second.path.c_str()) != 0) {
+    LOG(WARNING) << "Could not delete fragment result cache file " << it->second.path;
+  }
+  const int64_t bytes = it->second.bytes;
+  lru_list_.erase(it->second.lru_it);
+  entries_.erase(it);
+  total_bytes_ -= bytes;
+  if (total_bytes_metric_ != nullptr) {
+    total_bytes_metric_->Increment(-bytes);
+    num_entries_metric_->Increment(-1);
+  }
+}
+
+}
@@ -0,0 +1,156 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/status.h"
+#include "util/metrics-fwd.h"
+
+namespace impala {
+
+class MetricGroup;
+
+/// Executor-local cache of the output of fragment instances, stored in files on local
+/// disk. Fragment instances that only scan, filter and pre-aggregate HDFS tables
+/// produce the same rows whenever they read the same versions of the same files, so a
+/// repeated instance can replay the cached output instead of executing its plan (see
+/// FragmentInstanceState). The caller computes the key, which must cover everything
+/// the output depends on, e.g. the plan, the row layout, the query options and the
+/// scan ranges including the modification times of the files.
+///
+/// An entry is a sequence of opaque blocks, the serialized row batches of the instance.
+/// Entries are added incrementally with a Writer while the instance executes and
+/// become visible once the Writer is committed. The cache is bounded in bytes on disk
+/// and evicts in LRU order. Entries do not survive a restart: Init() removes all files
+/// of a previous process.
+///
+/// All functions are thread-safe. Readers and Writers must only be used by one thread.
+class FragmentResultCache {
+ public:
+  /// Reads the blocks of an entry in the order they were written. The entry remains
+  /// readable if it is evicted while the Reader exists.
+  class Reader {
+   public:
+    /// Reads the next block into 'block'. Sets 'eos' if it was the last block.
+    Status GetNext(std::string* block, bool* eos) WARN_UNUSED_RESULT;
+
+   private:
+    friend class FragmentResultCache;
+    Reader(const std::string& path);
+
+    const std::string path_;
+    std::ifstream file_;
+  };
+
+  /// Writes a new entry. The entry is discarded unless Commit() is called.
+  class Writer {
+   public:
+    ~Writer();
+
+    /// Appends 'block' to the entry. Returns false if the entry would exceed the maximum
+    /// entry size or the block could not be written, in which case the Writer must be
+    /// discarded.
+    bool Append(const std::string& block);
+
+    /// Adds the entry to the cache, replacing the existing entry with the same key.
+    void Commit();
+
+   private:
+    friend class FragmentResultCache;
+    Writer(FragmentResultCache* cache, const std::string& key, const std::string& path);
+
+    FragmentResultCache* const cache_;
+    const std::string key_;
+    const std::string path_;
+    std::ofstream file_;
+    int64_t bytes_written_ = 0;
+    bool committed_ = false;
+  };
+
+  /// Stores the entries in a subdirectory of 'dir'. 'capacity' is the maximum size in
+  /// bytes of all entries on disk. Entries larger than 'max_entry_bytes' are not cached.
+  FragmentResultCache(const std::string& dir, int64_t capacity, int64_t max_entry_bytes);
+  ~FragmentResultCache();
+
+  /// Creates the directory of the cache, removing the files of a previous process, and
+  /// registers the metrics of the cache in 'metrics'.
+  Status Init(MetricGroup* metrics) WARN_UNUSED_RESULT;
+
+  /// Returns a Reader for the entry with 'key', or nullptr on a miss.
+  std::unique_ptr<Reader> Lookup(const std::string& key);
+
+  /// Returns a Writer for a new entry with 'key', or nullptr if its file could not be
+  /// created.
+  std::unique_ptr<Writer> StartInsert(const std::string& key);
+
+ private:
+  typedef std::list<std::string> LruList;
+
+  struct CacheValue {
+    /// Path of the file of the entry.
+    std::string path;
+
+    /// Size of the file.
+    int64_t bytes;
+
+    /// Position of the key in 'lru_list_'.
+    LruList::iterator lru_it;
+  };
+
+  /// Called by Writer::Commit() for the written file at 'path'.
+  void Insert(const std::string& key, const std::string& path, int64_t bytes);
+
+  /// Removes the entry pointed to by 'it' and deletes its file. 'lock_' must be held.
+  void Erase(std::unordered_map<std::string, CacheValue>::iterator it);
+
+  /// Directory of the files of the cache.
+  const std::string dir_;
+  const int64_t capacity_;
+  const int64_t max_entry_bytes_;
+
+  /// Protects all members below.
+  std::mutex lock_;
+
+  /// All entries, keyed by the caller's key.
+  std::unordered_map<std::string, CacheValue> entries_;
+
+  /// Keys of all entries, with the least recently used at the front.
+  LruList lru_list_;
+
+  /// Size of the files of all entries.
+  int64_t total_bytes_ = 0;
+
+  /// Used to name the files of new entries.
+  int64_t next_file_id_ = 0;
+
+  /// Metrics of the cache, registered in Init().
+  IntCounter* hits_metric_ = nullptr;
+  IntCounter* misses_metric_ = nullptr;
+  IntCounter* evictions_metric_ = nullptr;
+  IntGauge* total_bytes_metric_ = nullptr;
+  IntGauge* num_entries_metric_ = nullptr;
+};
+
+}
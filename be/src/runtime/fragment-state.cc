@@ -19,6 +19,7 @@
 
 #include <gutil/strings/substitute.h>
 
+#include "codegen/codegen-cost-model.h"
 #include "codegen/llvm-codegen.h"
 #include "exec/exec-node.h"
 #include "exec/data-sink.h"
@@ -27,11 +28,17 @@
 #include "gen-cpp/ImpalaInternalService_types.h"
 #include "util/debug-util.h"
 #include "util/impalad-metrics.h"
+#include "util/pretty-printer.h"
 #include "util/runtime-profile.h"
 #include "util/runtime-profile-counters.h"
 
 #include "common/names.h"
 
+DEFINE_int32(codegen_saved_ns_per_row, 20,
+    "(Advanced) The time in nanoseconds that codegen is assumed to save for each row "
+    "that a plan node processes. Used by the ADAPTIVE_CODEGEN query option to decide "
+    "whether compiling the codegen module of a fragment pays off.");
+
 namespace impala {
 
 const string FragmentState::FSTATE_THREAD_GROUP_NAME = "fragment-init";
@@ -124,6 +131,14 @@ Status FragmentState::CodegenHelper(RuntimeProfile::EventSequence* event_sequenc
   LlvmCodeGen* llvm_codegen = codegen();
   DCHECK(llvm_codegen != nullptr);
 
+  // The compilation can only be skipped if the fragment can be interpreted. Functions
+  // that were added to the module are then never compiled and their function pointers
+  // stay null, so the interpreted code runs.
+  if (query_options().adaptive_codegen && is_interpretable()
+      && !ShouldCompileCodegen()) {
+    return Status::OK();
+  }
+
   // In case we need codegen, we cannot use asynchronous codegen because we cannot
   // interpret the query until codegen has run.
   const bool async_enabled = query_options().async_codegen;
@@ -136,6 +151,34 @@ Status FragmentState::CodegenHelper(RuntimeProfile::EventSequence* event_sequenc
   return Status::OK();
 }
 
+bool FragmentState::ShouldCompileCodegen() {
+  RuntimeProfile* codegen_profile = codegen_->runtime_profile();
+  double estimated_rows = 0;
+  for (const TPlanNode& node : fragment_.plan.nodes) {
+    if (!node.__isset.estimated_stats || !node.estimated_stats.__isset.cardinality
+        || node.estimated_stats.cardinality < 0) {
+      codegen_profile->AddInfoString("CodegenDecision", "Compile (no row estimate)");
+      return true;
+    }
+    estimated_rows += node.estimated_stats.cardinality;
+  }
+  const int64_t compile_ns = CodegenCostModel::GetInstance()->EstimateCompileTimeNs(
+      codegen_->NumInstructionsToJit());
+  if (compile_ns < 0) {
+    codegen_profile->AddInfoString(
+        "CodegenDecision", "Compile (no compile time estimate)");
+    return true;
+  }
+  const double saved_ns = estimated_rows * FLAGS_codegen_saved_ns_per_row;
+  const bool compile = saved_ns >= compile_ns;
+  codegen_profile->AddInfoString("CodegenDecision", Substitute(
+      "$0 (estimated compile time $1, estimated saving $2 for $3 rows)",
+      compile ? "Compile" : "Skip", PrettyPrinter::Print(compile_ns, TUnit::TIME_NS),
+      PrettyPrinter::Print(static_cast<int64_t>(min(saved_ns, 1e18)), TUnit::TIME_NS),
+      static_cast<int64_t>(min(estimated_rows, 1e18))));
+  return compile;
+}
+
 FragmentState::FragmentState(QueryState* query_state, const TPlanFragment& fragment,
     const PlanFragmentCtxPB& fragment_ctx)
   : query_state_(query_state), fragment_(fragment), fragment_ctx_(fragment_ctx) {
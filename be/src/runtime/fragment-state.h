@@ -225,6 +225,13 @@ class FragmentState {
   /// Helper method used by InvokeCodegen(). Does the actual codegen work.
   Status CodegenHelper(RuntimeProfile::EventSequence* event_sequence);
 
+  /// Used by CodegenHelper() if the ADAPTIVE_CODEGEN query option is set. Returns false
+  /// if the estimated time to optimize and compile the codegen module, based on the
+  /// CodegenCostModel, is more than the time that codegen is estimated to save, which
+  /// is --codegen_saved_ns_per_row for every row that the planner expects each plan
+  /// node of the fragment to process. Records the decision in the codegen profile.
+  bool ShouldCompileCodegen();
+
   /// Create the plan tree, data sink config.
   Status Init();
 };
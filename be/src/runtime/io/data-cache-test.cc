@@ -34,6 +34,7 @@
 #include "testutil/scoped-flag-setter.h"
 #include "util/counting-barrier.h"
 #include "util/filesystem-util.h"
+#include "util/impalad-metrics.h"
 #include "util/simple-logger.h"
 #include "util/thread.h"
 
@@ -58,11 +59,16 @@
 
 DECLARE_bool(cache_force_single_shard);
 DECLARE_bool(data_cache_anonymize_trace);
+DECLARE_bool(data_cache_direct_io);
 DECLARE_bool(data_cache_enable_tracing);
 DECLARE_int64(data_cache_file_max_size_bytes);
 DECLARE_int32(data_cache_max_opened_files);
 DECLARE_int32(data_cache_write_concurrency);
 DECLARE_string(data_cache_eviction_policy);
+DECLARE_string(data_cache_memory_tier_capacity);
+DECLARE_bool(data_cache_persistent_index);
+DECLARE_bool(data_cache_async_delete_stale_files);
+DECLARE_int64(data_cache_memory_tier_max_entry_bytes);
 DECLARE_string(data_cache_trace_dir);
 DECLARE_int32(max_data_cache_trace_file_size);
 DECLARE_int32(data_cache_trace_percentage);
@@ -487,6 +493,142 @@ TEST_P(DataCacheTest, LRUEviction) {
   ASSERT_OK(cache.CloseFilesAndVerifySizes());
 }
 
+// Tests that entries are promoted to the memory tier on their first hit in a partition
+// and that storing a longer entry invalidates the copy in the memory tier.
+TEST_P(DataCacheTest, MemoryTier) {
+  FLAGS_data_cache_memory_tier_capacity = "1MB";
+  FLAGS_data_cache_memory_tier_max_entry_bytes = TEMP_BUFFER_SIZE;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0],
+      std::to_string(DEFAULT_CACHE_SIZE)));
+  ASSERT_OK(cache.Init());
+  IntCounter* memory_hits =
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT;
+  const int64_t initial_memory_hits = memory_hits->GetValue();
+
+  uint8_t buffer[TEMP_BUFFER_SIZE];
+  const int64_t small_len = TEMP_BUFFER_SIZE / 2;
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), small_len));
+  // The first lookup reads the partition and promotes the entry.
+  ASSERT_EQ(small_len, cache.Lookup(FNAME, MTIME, 0, small_len, buffer));
+  ASSERT_EQ(0, memcmp(buffer, test_buffer(), small_len));
+  ASSERT_EQ(initial_memory_hits, memory_hits->GetValue());
+  // The second lookup is served by the memory tier.
+  memset(buffer, 0, TEMP_BUFFER_SIZE);
+  ASSERT_EQ(small_len, cache.Lookup(FNAME, MTIME, 0, small_len, buffer));
+  ASSERT_EQ(0, memcmp(buffer, test_buffer(), small_len));
+  ASSERT_EQ(initial_memory_hits + 1, memory_hits->GetValue());
+
+  // A longer entry replaces the shorter one in both tiers.
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+  for (int i = 0; i < 2; ++i) {
+    memset(buffer, 0, TEMP_BUFFER_SIZE);
+    ASSERT_EQ(TEMP_BUFFER_SIZE,
+        cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_EQ(0, memcmp(buffer, test_buffer(), TEMP_BUFFER_SIZE));
+    ASSERT_EQ(initial_memory_hits + 1 + i, memory_hits->GetValue());
+  }
+
+  // Entries larger than --data_cache_memory_tier_max_entry_bytes are not promoted.
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, TEST_BUFFER_SIZE, test_buffer(),
+      TEST_BUFFER_SIZE));
+  uint8_t large_buffer[TEST_BUFFER_SIZE];
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(TEST_BUFFER_SIZE, cache.Lookup(FNAME, MTIME, TEST_BUFFER_SIZE,
+        TEST_BUFFER_SIZE, large_buffer));
+  }
+  ASSERT_EQ(initial_memory_hits + 2, memory_hits->GetValue());
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
+// Tests that entries are read and written correctly with O_DIRECT, whether or not the
+// buffers and lengths are aligned. Buffered I/O is used instead if the filesystem of the
+// cache directory does not support O_DIRECT.
+TEST_P(DataCacheTest, DirectIo) {
+  FLAGS_data_cache_direct_io = true;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0],
+      std::to_string(DEFAULT_CACHE_SIZE)));
+  ASSERT_OK(cache.Init());
+
+  void* aligned_ptr;
+  ASSERT_EQ(0, posix_memalign(&aligned_ptr, 4096, 2 * 4096));
+  unique_ptr<uint8_t, decltype(&free)> aligned(
+      reinterpret_cast<uint8_t*>(aligned_ptr), &free);
+  // An aligned entry of two pages.
+  memcpy(aligned.get(), test_buffer(), 2 * 4096);
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, aligned.get(), 2 * 4096));
+  // An unaligned entry of a partial page.
+  const int64_t unaligned_len = 1000;
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 1, test_buffer() + 1, unaligned_len));
+
+  memset(aligned.get(), 0, 2 * 4096);
+  ASSERT_EQ(2 * 4096, cache.Lookup(FNAME, MTIME, 0, 2 * 4096, aligned.get()));
+  ASSERT_EQ(0, memcmp(aligned.get(), test_buffer(), 2 * 4096));
+  uint8_t buffer[TEMP_BUFFER_SIZE];
+  memset(buffer, 0, TEMP_BUFFER_SIZE);
+  ASSERT_EQ(unaligned_len, cache.Lookup(FNAME, MTIME, 1, unaligned_len, buffer + 1));
+  ASSERT_EQ(0, memcmp(buffer + 1, test_buffer() + 1, unaligned_len));
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
+// Tests that the cached data is reloaded with a persistent index and that a corrupt index
+// is discarded.
+TEST_P(DataCacheTest, PersistentIndex) {
+  FLAGS_data_cache_persistent_index = true;
+  const string config = Substitute("$0,$1:$2", data_cache_dirs()[0],
+      data_cache_dirs()[1], std::to_string(DEFAULT_CACHE_SIZE));
+  if (GetParam() != "LRU") {
+    DataCache cache(config);
+    ASSERT_FALSE(cache.Init().ok());
+    return;
+  }
+  const int num_entries = 16;
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    for (int i = 0; i < num_entries; ++i) {
+      ASSERT_TRUE(cache.Store(FNAME, MTIME, i, test_buffer() + i, TEMP_BUFFER_SIZE));
+    }
+    // The index is checkpointed again when the cache is destroyed.
+    cache.Checkpoint();
+  }
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    for (int i = 0; i < num_entries; ++i) {
+      memset(buffer, 0, TEMP_BUFFER_SIZE);
+      ASSERT_EQ(TEMP_BUFFER_SIZE,
+          cache.Lookup(FNAME, MTIME, i, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_EQ(0, memcmp(buffer, test_buffer() + i, TEMP_BUFFER_SIZE));
+    }
+    ASSERT_TRUE(cache.Store(FNAME, MTIME, num_entries, test_buffer(), TEMP_BUFFER_SIZE));
+  }
+  // Corrupt the indexes. The cache starts empty and deletes the old backing files.
+  for (int i = 0; i < 2; ++i) {
+    const string index_path = Substitute("$0/impala-cache-index", data_cache_dirs()[i]);
+    bool exists;
+    ASSERT_OK(FileSystemUtil::PathExists(index_path, &exists));
+    if (!exists) continue;
+    FILE* index_file = fopen(index_path.c_str(), "r+");
+    ASSERT_TRUE(index_file != nullptr);
+    ASSERT_EQ(0, fseek(index_file, 16, SEEK_SET));
+    ASSERT_EQ(1, fwrite("x", 1, 1, index_file));
+    ASSERT_EQ(0, fclose(index_file));
+  }
+  {
+    DataCache cache(config);
+    ASSERT_OK(cache.Init());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    for (int i = 0; i <= num_entries; ++i) {
+      ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, i, TEMP_BUFFER_SIZE, buffer));
+    }
+  }
+  // Remove the leftover index files.
+  for (const string& dir_path : data_cache_dirs()) {
+    ASSERT_OK(FileSystemUtil::RemoveAndCreateDirectory(dir_path));
+  }
+}
+
 // Tests insertion and lookup with the cache with multiple threads.
 // Inserts a working set which will fit in the cache. Despite potential
 // collision during insertion, all entries in the working set should be found.
@@ -531,6 +673,57 @@ TEST_P(DataCacheTest, MultiPartitions) {
       expect_misses);
 }
 
+// Tests that the backing files left by a previous process are deleted, either during
+// Init() or asynchronously after it, and that files of other names are kept. Uses
+// multiple partitions, which are initialized concurrently.
+TEST_P(DataCacheTest, StaleFiles) {
+  StringPiece delimiter(",");
+  string cache_base = JoinStrings(data_cache_dirs(), delimiter);
+  const int64_t cache_size = DEFAULT_CACHE_SIZE;
+  for (bool async_delete : {false, true}) {
+    FLAGS_data_cache_async_delete_stale_files = async_delete;
+    vector<string> stale_paths;
+    vector<string> other_paths;
+    for (const string& dir_path : data_cache_dirs()) {
+      stale_paths.push_back(Substitute("$0/impala-cache-file-stale", dir_path));
+      other_paths.push_back(Substitute("$0/other-file", dir_path));
+      for (const string& file_path : {stale_paths.back(), other_paths.back()}) {
+        std::ofstream file(file_path);
+        file << string(TEMP_BUFFER_SIZE, 'x');
+        ASSERT_TRUE(file.good());
+      }
+    }
+    {
+      DataCache cache(Substitute("$0:$1", cache_base, std::to_string(cache_size)));
+      ASSERT_OK(cache.Init());
+      // Allow for 10 seconds latency for the stale file deleter thread to run.
+      const int num_wait_secs = async_delete ? 10 : 0;
+      for (const string& stale_path : stale_paths) {
+        for (int i = 0; i <= num_wait_secs; ++i) {
+          bool exists;
+          ASSERT_OK(FileSystemUtil::PathExists(stale_path, &exists));
+          if (!exists) break;
+          // Flag a failure on the last time around this loop.
+          ASSERT_LT(i, num_wait_secs) << stale_path;
+          sleep(1);
+        }
+      }
+      for (const string& other_path : other_paths) {
+        bool exists;
+        ASSERT_OK(FileSystemUtil::PathExists(other_path, &exists));
+        EXPECT_TRUE(exists) << other_path;
+      }
+      // Every partition is usable.
+      int64_t max_start_offset = 512;
+      bool use_per_thread_filename = false;
+      bool expect_misses = false;
+      MultiThreadedReadWrite(&cache, max_start_offset, use_per_thread_filename,
+          expect_misses);
+    }
+    ASSERT_OK(FileSystemUtil::RemovePaths(other_paths));
+  }
+}
+
 // Tests insertion of a working set whose size is 1/8 of the total memory size.
 // This likely exceeds the size of the page cache and forces write back of dirty pages in
 // the page cache to the backing files and also read from the backing files during lookup.
@@ -24,11 +24,16 @@
 #include <rapidjson/ostreamwrapper.h>
 #include <rapidjson/writer.h>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/init.h"
 #include "common/status.h"
+#include "gutil/strings/split.h"
 #include "gutil/strings/substitute.h"
 #include "runtime/io/data-cache-trace.h"
+#include "util/parse-util.h"
+#include "util/pretty-printer.h"
 
 #include "common/names.h"
 
@@ -53,6 +58,10 @@
 // data-cache-trace-replayer --trace_directory /path/to/trace/directory
 //     --data_cache="/cache_path:100GB" --data_cache_eviction_policy=LIRS
 //
+// To compare several eviction policies at the same cache size in one run:
+// data-cache-trace-replayer --trace_directory /path/to/trace/directory
+//     --data_cache="/cache_path:100GB" --eviction_policies=LRU,LIRS,TINYLFU
+//
 // The replayer produces two different types of cache hit statistics. The first is
 // the cache hit statistics from the original trace (i.e. the original 100GB cache
 // using LRU). This is a fixed property of a given set of trace files, and it will
@@ -60,6 +69,11 @@
 // hit statistics from the replay using the replay configuration (e.g. a replay using
 // a smaller cache may show fewer hits, etc).
 //
+// To compare many cache sizes and eviction policies in one fast pass over the trace,
+// using in-memory models of the cache instead of a DataCache:
+// data-cache-trace-replayer --trace_directory /path/to/trace/directory
+//     --simulate_capacities=50GB,100GB,200GB,400GB --eviction_policies=LRU,LIRS
+//
 // These commands put output in the glog INFO file. For JSON output, see the
 // output_file option.
 
@@ -79,6 +93,22 @@ DEFINE_string(data_cache_configuration, "", "Cache configuration string in the s
 // filename. If not specified, output goes to the INFO log.
 DEFINE_string(output_file, "", "File to write with JSON output containing hits/misses");
 
+// If specified, the trace is replayed once per eviction policy, each time against a new
+// cache, and data_cache_eviction_policy is ignored.
+DEFINE_string(eviction_policies, "", "Comma separated list of cache eviction policies "
+    "to replay the trace with, e.g. 'LRU,LIRS,TINYLFU'. If empty, the trace is replayed "
+    "once with the policy of data_cache_eviction_policy.");
+
+// If specified, the trace is replayed against in-memory models of the cache instead of
+// a DataCache. See CacheSimulator.
+DEFINE_string(simulate_capacities, "", "Comma separated list of cache capacities, e.g. "
+    "'50GB,100GB,200GB'. If specified, the trace is replayed in a single pass against "
+    "in-memory models of the cache with every combination of these capacities and the "
+    "eviction_policies, and data_cache_configuration is ignored. The models are faster "
+    "than a DataCache but do not model its partitions or concurrency limits.");
+
+DECLARE_string(data_cache_eviction_policy);
+
 using namespace impala;
 using namespace impala::io;
 using namespace impala::io::trace;
@@ -113,17 +143,31 @@ void DumpStatisticsToLog(const CacheHitStatistics& stats) {
 }
 
 // Write a JSON structure with both the original trace cache hit statistics and
-// the replay cache hit statistics.
+// the replay cache hit statistics. 'replay_stats' has the statistics of each replay,
+// keyed by eviction policy. The statistics of the first replay are written as
+// "replay_stats" and, if there were several replays, all of them are written as
+// "replay_stats_by_policy".
 void DumpStatisticsToJSON(const CacheHitStatistics& trace_stats,
-    const CacheHitStatistics& replay_stats, std::string filename) {
+    const vector<pair<string, CacheHitStatistics>>& replay_stats, std::string filename) {
+  DCHECK(!replay_stats.empty());
   Document document;
   document.SetObject();
 
   // Add trace stats
   Value trace_stats_json = CacheHitStatisticsToJson(&document, trace_stats);
   document.AddMember("original_trace_stats", trace_stats_json, document.GetAllocator());
-  Value replay_stats_json = CacheHitStatisticsToJson(&document, replay_stats);
+  Value replay_stats_json = CacheHitStatisticsToJson(&document, replay_stats[0].second);
   document.AddMember("replay_stats", replay_stats_json, document.GetAllocator());
+  if (replay_stats.size() > 1) {
+    Value by_policy_json(kObjectType);
+    for (const auto& policy_stats : replay_stats) {
+      Value policy_name(policy_stats.first.c_str(), document.GetAllocator());
+      Value policy_stats_json = CacheHitStatisticsToJson(&document, policy_stats.second);
+      by_policy_json.AddMember(policy_name, policy_stats_json, document.GetAllocator());
+    }
+    document.AddMember("replay_stats_by_policy", by_policy_json,
+        document.GetAllocator());
+  }
 
   ofstream ofs(filename);
   OStreamWrapper osw(ofs);
@@ -131,9 +175,100 @@ void DumpStatisticsToJSON(const CacheHitStatistics& trace_stats,
   document.Accept(writer);
 }
 
+// Fraction of the lookups of 'stats' that were complete hits.
+double HitRatio(const CacheHitStatistics& stats) {
+  uint64_t lookups = stats.hits + stats.partial_hits + stats.misses;
+  return lookups == 0 ? 0 : static_cast<double>(stats.hits) / lookups;
+}
+
+// Fraction of the bytes looked up in 'stats' that were read from the cache.
+double ByteHitRatio(const CacheHitStatistics& stats) {
+  uint64_t lookup_bytes = stats.hit_bytes + stats.miss_bytes;
+  return lookup_bytes == 0 ? 0 : static_cast<double>(stats.hit_bytes) / lookup_bytes;
+}
+
+// Write a JSON structure with the statistics of every simulated cache of 'simulator'.
+void DumpSimulationToJSON(const CacheSimulator& simulator, std::string filename) {
+  Document document;
+  document.SetObject();
+  Value simulations_json(kArrayType);
+  for (int i = 0; i < simulator.configurations().size(); ++i) {
+    const CacheSimulator::Configuration& config = simulator.configurations()[i];
+    CacheHitStatistics stats = simulator.GetStatistics(i);
+    Value simulation_json(kObjectType);
+    Value policy(config.eviction_policy.c_str(), document.GetAllocator());
+    simulation_json.AddMember("eviction_policy", policy, document.GetAllocator());
+    simulation_json.AddMember("capacity", Value(config.capacity),
+        document.GetAllocator());
+    simulation_json.AddMember("hit_ratio", Value(HitRatio(stats)),
+        document.GetAllocator());
+    simulation_json.AddMember("byte_hit_ratio", Value(ByteHitRatio(stats)),
+        document.GetAllocator());
+    Value stats_json = CacheHitStatisticsToJson(&document, stats);
+    simulation_json.AddMember("stats", stats_json, document.GetAllocator());
+    simulations_json.PushBack(simulation_json, document.GetAllocator());
+  }
+  document.AddMember("simulations", simulations_json, document.GetAllocator());
+
+  ofstream ofs(filename);
+  OStreamWrapper osw(ofs);
+  Writer<OStreamWrapper> writer(osw);
+  document.Accept(writer);
+}
+
+// Output the hit ratio and byte hit ratio of every simulated cache of 'simulator' to the
+// INFO glog, as one curve over the capacities per eviction policy.
+void DumpSimulationToLog(const CacheSimulator& simulator) {
+  string policy;
+  for (int i = 0; i < simulator.configurations().size(); ++i) {
+    const CacheSimulator::Configuration& config = simulator.configurations()[i];
+    if (config.eviction_policy != policy) {
+      policy = config.eviction_policy;
+      LOG(INFO) << "Simulated cache hit ratios with eviction policy " << policy << ":";
+    }
+    CacheHitStatistics stats = simulator.GetStatistics(i);
+    LOG(INFO) << "Capacity: " << PrettyPrinter::PrintBytes(config.capacity)
+              << " hit ratio: " << HitRatio(stats)
+              << " byte hit ratio: " << ByteHitRatio(stats)
+              << " stores: " << std::to_string(stats.stores)
+              << " failed stores: " << std::to_string(stats.failed_stores);
+  }
+}
+
+// Replay the trace against in-memory models of the cache with every combination of
+// 'policies' and the capacities of simulate_capacities, and output their statistics.
+Status Simulate(const vector<string>& policies) {
+  vector<int64_t> capacities;
+  for (const string& capacity_str : strings::Split(FLAGS_simulate_capacities, ",",
+           strings::SkipWhitespace())) {
+    bool is_percent;
+    int64_t capacity = ParseUtil::ParseMemSpec(capacity_str, &is_percent, 0);
+    if (capacity <= 0 || is_percent) {
+      return Status(Substitute("Invalid capacity in simulate_capacities: $0",
+          capacity_str));
+    }
+    capacities.push_back(capacity);
+  }
+  CacheSimulator simulator(policies, capacities);
+  RETURN_IF_ERROR(simulator.Init());
+  if (FLAGS_trace_file.size() != 0) {
+    LOG(INFO) << "Simulating file: " << FLAGS_trace_file;
+    RETURN_IF_ERROR(simulator.ReplayFile(FLAGS_trace_file));
+  } else {
+    LOG(INFO) << "Simulating directory: " << FLAGS_trace_directory;
+    RETURN_IF_ERROR(simulator.ReplayDirectory(FLAGS_trace_directory));
+  }
+  if (FLAGS_output_file.size() != 0) {
+    DumpSimulationToJSON(simulator, FLAGS_output_file);
+  } else {
+    DumpSimulationToLog(simulator);
+  }
+  return Status::OK();
+}
+
 Status ValidateFlags() {
-  // data_cache_configuration is required
-  if (FLAGS_data_cache_configuration.size() == 0) {
+  // data_cache_configuration is required, unless the replay is simulated
+  if (FLAGS_data_cache_configuration.size() == 0 && FLAGS_simulate_capacities.empty()) {
     return Status("data_cache_configuration must be specified.");
   }
   // trace_file and trace_directory are mutually exclusive
@@ -168,36 +303,63 @@ Status ValidateFlags() {
   return Status::OK();
 }
 
-int main(int argc, char **argv) {
-  InitCommonRuntime(argc, argv, false);
-
-  Status status = ValidateFlags();
-  if (!status.ok()) CLEAN_EXIT_WITH_ERROR(status.GetDetail());
-
-  LOG(INFO) << "Initialize cache with configuration: " << FLAGS_data_cache_configuration;
+// Replay the trace against a new cache with the eviction policy of
+// data_cache_eviction_policy. Sets 'original_trace_stats' and 'replay_stats'.
+Status Replay(CacheHitStatistics* original_trace_stats,
+    CacheHitStatistics* replay_stats) {
+  LOG(INFO) << "Initialize cache with configuration: " << FLAGS_data_cache_configuration
+            << " eviction policy: " << FLAGS_data_cache_eviction_policy;
   TraceReplayer replayer(FLAGS_data_cache_configuration);
-  status = replayer.Init();
-  if (!status.ok()) CLEAN_EXIT_WITH_ERROR(status.GetDetail());
+  RETURN_IF_ERROR(replayer.Init());
 
   if (FLAGS_trace_file.size() != 0) {
     LOG(INFO) << "Replaying file: " << FLAGS_trace_file;
-    status = replayer.ReplayFile(FLAGS_trace_file);
+    RETURN_IF_ERROR(replayer.ReplayFile(FLAGS_trace_file));
   } else if (FLAGS_trace_directory.size() != 0) {
     LOG(INFO) << "Replaying directory: " << FLAGS_trace_directory;
-    status = replayer.ReplayDirectory(FLAGS_trace_directory);
+    RETURN_IF_ERROR(replayer.ReplayDirectory(FLAGS_trace_directory));
   }
+  *original_trace_stats = replayer.GetOriginalTraceStatistics();
+  *replay_stats = replayer.GetReplayStatistics();
+  return Status::OK();
+}
+
+int main(int argc, char **argv) {
+  InitCommonRuntime(argc, argv, false);
+
+  Status status = ValidateFlags();
   if (!status.ok()) CLEAN_EXIT_WITH_ERROR(status.GetDetail());
 
-  CacheHitStatistics original_trace_stats = replayer.GetOriginalTraceStatistics();
-  CacheHitStatistics replay_stats = replayer.GetReplayStatistics();
+  vector<string> policies = strings::Split(FLAGS_eviction_policies, ",",
+      strings::SkipWhitespace());
+  if (policies.empty()) policies.push_back(FLAGS_data_cache_eviction_policy);
+
+  if (!FLAGS_simulate_capacities.empty()) {
+    status = Simulate(policies);
+    if (!status.ok()) CLEAN_EXIT_WITH_ERROR(status.GetDetail());
+    return 0;
+  }
+
+  CacheHitStatistics original_trace_stats;
+  vector<pair<string, CacheHitStatistics>> replay_stats;
+  for (const string& policy : policies) {
+    FLAGS_data_cache_eviction_policy = policy;
+    CacheHitStatistics policy_stats;
+    status = Replay(&original_trace_stats, &policy_stats);
+    if (!status.ok()) CLEAN_EXIT_WITH_ERROR(status.GetDetail());
+    replay_stats.emplace_back(policy, policy_stats);
+  }
 
   if (FLAGS_output_file.size() != 0) {
     DumpStatisticsToJSON(original_trace_stats, replay_stats, FLAGS_output_file);
   } else {
     LOG(INFO) << "Cache hit statistics from the original trace:";
     DumpStatisticsToLog(original_trace_stats);
-    LOG(INFO) << "Cache hit statistics from the replay:";
-    DumpStatisticsToLog(replay_stats);
+    for (const auto& policy_stats : replay_stats) {
+      LOG(INFO) << "Cache hit statistics from the replay with eviction policy "
+                << policy_stats.first << ":";
+      DumpStatisticsToLog(policy_stats.second);
+    }
   }
   return 0;
 }
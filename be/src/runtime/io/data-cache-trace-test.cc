@@ -333,6 +333,54 @@ TEST_F(DataCacheTraceTest, TraceReplayPartialHits) {
   EXPECT_EQ(replay_stats.stores, 2);
   EXPECT_EQ(replay_stats.failed_stores, 0);
 }
+
+TEST_F(DataCacheTraceTest, CacheSimulator) {
+  path simulation_path = tmp_dir() / "simulation";
+  unique_ptr<Tracer> tracer = CreateSimpleTracer(simulation_path);
+  ASSERT_OK(tracer->Init());
+  TraceEvent event = GetTemplateTraceEvent();
+  event.lookup_length = 4096;
+  // Read ten chunks twice. Store events are ignored by the simulator.
+  for (int pass = 0; pass < 2; ++pass) {
+    event.type = pass == 0 ? EventType::MISS : EventType::HIT;
+    event.entry_length = pass == 0 ? -1 : 4096;
+    for (int i = 0; i < 10; ++i) {
+      event.offset = i * 4096;
+      TraceFromTraceEvent(tracer.get(), event);
+    }
+  }
+  tracer->Flush();
+
+  // The smaller capacity cannot hold any of the chunks.
+  CacheSimulator simulator({"LRU", "LIRS"}, {1024, 1L << 30});
+  ASSERT_OK(simulator.Init());
+  ASSERT_OK(simulator.ReplayDirectory(simulation_path.string()));
+  ASSERT_EQ(4, simulator.configurations().size());
+  for (int i = 0; i < 4; ++i) {
+    const CacheSimulator::Configuration& config = simulator.configurations()[i];
+    EXPECT_EQ(i < 2 ? "LRU" : "LIRS", config.eviction_policy);
+    CacheHitStatistics stats = simulator.GetStatistics(i);
+    if (config.capacity == 1024) {
+      EXPECT_EQ(stats.hits, 0);
+      EXPECT_EQ(stats.misses, 20);
+      EXPECT_EQ(stats.miss_bytes, 20 * 4096);
+      EXPECT_EQ(stats.stores, 0);
+      EXPECT_EQ(stats.failed_stores, 20);
+    } else {
+      EXPECT_EQ(stats.hits, 10);
+      EXPECT_EQ(stats.hit_bytes, 10 * 4096);
+      EXPECT_EQ(stats.partial_hits, 0);
+      EXPECT_EQ(stats.misses, 10);
+      EXPECT_EQ(stats.miss_bytes, 10 * 4096);
+      EXPECT_EQ(stats.stores, 10);
+      EXPECT_EQ(stats.failed_stores, 0);
+    }
+  }
+
+  // Unknown eviction policies are rejected.
+  CacheSimulator invalid_simulator({"MRU"}, {1L << 30});
+  EXPECT_FALSE(invalid_simulator.Init().ok());
+}
 } // namespace trace
 } // namespace io
 } // namespace impala
@@ -17,8 +17,10 @@
 
 #include "runtime/io/data-cache-trace.h"
 
+#include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <functional>
 #include <glog/logging.h>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
@@ -32,6 +34,8 @@
 #include "kudu/util/jsonwriter.h"
 #include "kudu/util/path_util.h"
 #include "runtime/io/data-cache.h"
+#include "util/bit-util.h"
+#include "util/cache/cache.h"
 #include "util/filesystem-util.h"
 #include "util/simple-logger.h"
 
@@ -260,6 +264,66 @@ string Tracer::AnonymizeFilename(Slice filename) {
   return b64_out;
 }
 
+// Calls 'replay_fn' for every TraceEvent of the trace file 'filename'.
+static Status ReplayTraceFile(const string& filename,
+    const std::function<void(const TraceEvent&)>& replay_fn) {
+  TraceFileIterator file_iter(filename);
+  RETURN_IF_ERROR(file_iter.Init());
+  while (true) {
+    bool done = false;
+    TraceEvent trace_event;
+    RETURN_IF_ERROR(file_iter.GetNextEvent(&trace_event, &done));
+    if (done) break;
+    replay_fn(trace_event);
+  }
+  return Status::OK();
+}
+
+// Calls 'replay_fn' for every TraceEvent of the trace files in 'directory', in the
+// order in which the files were written.
+static Status ReplayTraceDirectory(const string& directory,
+    const std::function<void(const TraceEvent&)>& replay_fn) {
+  vector<string> trace_files;
+  RETURN_IF_ERROR(SimpleLogger::GetLogFiles(directory, TRACE_FILE_PREFIX, &trace_files));
+  for (const string& trace_file : trace_files) {
+    RETURN_IF_ERROR(ReplayTraceFile(trace_file, replay_fn));
+  }
+  return Status::OK();
+}
+
+// Replays the lookup of 'entry', which is a HIT or MISS, and updates 'stats'. This
+// mirrors the behavior of DiskIoMgr: it tries to read the whole chunk with 'lookup_fn',
+// which returns the number of bytes read from the cache. If the read is not complete,
+// the rest is a miss, and it tries to store the complete chunk with 'store_fn'.
+static void ReplayLookup(const TraceEvent& entry,
+    const std::function<int64_t()>& lookup_fn, const std::function<bool()>& store_fn,
+    CacheHitStatistics* stats) {
+  DCHECK(entry.type == EventType::HIT || entry.type == EventType::MISS);
+  DCHECK_GT(entry.lookup_length, 0);
+  int64_t bytes_read = lookup_fn();
+  DCHECK_LE(bytes_read, entry.lookup_length);
+  if (bytes_read == entry.lookup_length) {
+    // Total hit, nothing to store to the cache
+    ++stats->hits;
+    stats->hit_bytes += bytes_read;
+    return;
+  }
+  if (bytes_read == 0) {
+    // Complete miss, and we try to store the whole chunk into the cache
+    ++stats->misses;
+  } else {
+    // Partial hit, store complete entry to the cache
+    ++stats->partial_hits;
+    stats->hit_bytes += bytes_read;
+  }
+  stats->miss_bytes += entry.lookup_length - bytes_read;
+  if (store_fn()) {
+    ++stats->stores;
+  } else {
+    ++stats->failed_stores;
+  }
+}
+
 TraceReplayer::TraceReplayer(string trace_configuration)
   : trace_configuration_(trace_configuration) {}
 
@@ -274,26 +338,14 @@ Status TraceReplayer::Init() {
 
 Status TraceReplayer::ReplayFile(string filename) {
   DCHECK(initialized_);
-  TraceFileIterator file_iter(filename);
-  RETURN_IF_ERROR(file_iter.Init());
-  while (true) {
-    bool done = false;
-    TraceEvent trace_event;
-    RETURN_IF_ERROR(file_iter.GetNextEvent(&trace_event, &done));
-    if (done) break;
-    ReplayEntry(trace_event);
-  }
-  return Status::OK();
+  return ReplayTraceFile(
+      filename, [this](const TraceEvent& entry) { ReplayEntry(entry); });
 }
 
 Status TraceReplayer::ReplayDirectory(string directory) {
   DCHECK(initialized_);
-  vector<string> trace_files;
-  RETURN_IF_ERROR(SimpleLogger::GetLogFiles(directory, TRACE_FILE_PREFIX, &trace_files));
-  for (const string& trace_file : trace_files) {
-    RETURN_IF_ERROR(ReplayFile(trace_file));
-  }
-  return Status::OK();
+  return ReplayTraceDirectory(
+      directory, [this](const TraceEvent& entry) { ReplayEntry(entry); });
 }
 
 void TraceReplayer::UpdateTraceStats(const TraceEvent& entry) {
@@ -329,46 +381,140 @@ void TraceReplayer::ReplayEntry(const TraceEvent& entry) {
   UpdateTraceStats(entry);
 
   // Second, do the actual replay against the current cache (which may have different
-  // settings from the original cache). This mirrors the behavior of DiskIoMgr.
-  // Replay only needs hits and misses.
+  // settings from the original cache). Replay only needs hits and misses.
   if (entry.type != EventType::HIT && entry.type != EventType::MISS) {
     return;
   }
-  DCHECK_GT(entry.lookup_length, 0);
-  // Try to read the whole chunk from the cache. If it does a partial read,
-  // the rest is a miss, but it will try to store the complete read into the cache.
-  int64_t bytes_read = data_cache_->Lookup(entry.filename, entry.mtime, entry.offset,
-      entry.lookup_length, /* buffer */ nullptr);
-  DCHECK_LE(bytes_read, entry.lookup_length);
-  if (bytes_read == 0) {
-    // Complete miss, and we try to store the whole chunk into the cache
-    ++replay_stats_.misses;
-    replay_stats_.miss_bytes += entry.lookup_length;
-    bool success = data_cache_->Store(entry.filename, entry.mtime, entry.offset,
-        /* buffer */ nullptr, entry.lookup_length);
-    if (success) {
-      ++replay_stats_.stores;
-    } else {
-      ++replay_stats_.failed_stores;
+  ReplayLookup(entry,
+      [this, &entry]() {
+        return data_cache_->Lookup(entry.filename, entry.mtime, entry.offset,
+            entry.lookup_length, /* buffer */ nullptr);
+      },
+      [this, &entry]() {
+        return data_cache_->Store(entry.filename, entry.mtime, entry.offset,
+            /* buffer */ nullptr, entry.lookup_length);
+      },
+      &replay_stats_);
+}
+
+// Charges of the entries of the simulated caches are rounded up to this, like the
+// DataCache rounds them up to its page size.
+static const int64_t SIMULATED_PAGE_SIZE = 1L << 12;
+
+class CacheSimulator::SimulatedCache {
+ public:
+  explicit SimulatedCache(const Configuration& config) : config_(config) {}
+
+  Status Init() {
+    cache_.reset(NewCache(Cache::ParseEvictionPolicy(config_.eviction_policy),
+        config_.capacity, "CacheSimulator"));
+    return cache_->Init();
+  }
+
+  // Replays 'entry', which is a HIT or MISS of the cache entry 'key'.
+  void Replay(const TraceEvent& entry, const Slice& key) {
+    ReplayLookup(entry, [this, &entry, &key]() { return Lookup(key, entry); },
+        [this, &entry, &key]() { return Store(key, entry.lookup_length); }, &stats_);
+  }
+
+  const CacheHitStatistics& stats() const { return stats_; }
+
+ private:
+  // Returns the number of bytes of 'entry' that are in the cache.
+  int64_t Lookup(const Slice& key, const TraceEvent& entry) {
+    Cache::UniqueHandle handle(cache_->Lookup(key));
+    if (handle == nullptr) return 0;
+    return min(EntryLength(handle), entry.lookup_length);
+  }
+
+  // Stores an entry of 'len' bytes, unless it does not fit into the cache or the
+  // cache already has a longer entry. Returns true if the entry was stored.
+  bool Store(const Slice& key, int64_t len) {
+    const int64_t charge = BitUtil::RoundUp(len, SIMULATED_PAGE_SIZE);
+    if (charge > config_.capacity) return false;
+    {
+      Cache::UniqueHandle handle(cache_->Lookup(key, Cache::NO_UPDATE));
+      if (handle != nullptr && EntryLength(handle) >= len) return false;
     }
-  } else if (bytes_read == entry.lookup_length) {
-    // Total hit, nothing to store to the cache
-    ++replay_stats_.hits;
-    replay_stats_.hit_bytes += bytes_read;
-  } else {
-    // Partial hit, store complete entry to the cache
-    ++replay_stats_.partial_hits;
-    replay_stats_.hit_bytes += bytes_read;
-    replay_stats_.miss_bytes += entry.lookup_length - bytes_read;
-    bool success = data_cache_->Store(entry.filename, entry.mtime, entry.offset,
-        /* buffer */ nullptr, entry.lookup_length);
-    if (success) {
-      ++replay_stats_.stores;
-    } else {
-      ++replay_stats_.failed_stores;
+    Cache::UniquePendingHandle pending(cache_->Allocate(key, sizeof(len), charge));
+    if (pending == nullptr) return false;
+    memcpy(cache_->MutableValue(&pending), &len, sizeof(len));
+    Cache::UniqueHandle handle(
+        cache_->Insert(std::move(pending), /* eviction_callback */ nullptr));
+    return handle != nullptr;
+  }
+
+  int64_t EntryLength(const Cache::UniqueHandle& handle) const {
+    Slice value = cache_->Value(handle);
+    DCHECK_EQ(value.size(), sizeof(int64_t));
+    int64_t len;
+    memcpy(&len, value.data(), sizeof(len));
+    return len;
+  }
+
+  const Configuration config_;
+  std::unique_ptr<Cache> cache_;
+  CacheHitStatistics stats_;
+};
+
+CacheSimulator::CacheSimulator(const vector<string>& eviction_policies,
+    const vector<int64_t>& capacities) {
+  for (const string& eviction_policy : eviction_policies) {
+    for (int64_t capacity : capacities) {
+      configurations_.push_back({eviction_policy, capacity});
+    }
+  }
+}
+
+CacheSimulator::~CacheSimulator() {}
+
+Status CacheSimulator::Init() {
+  for (const Configuration& config : configurations_) {
+    const string policy = boost::to_upper_copy(config.eviction_policy);
+    if (policy != "LRU" && policy != "LIRS" && policy != "FIFO" && policy != "TINYLFU"
+        && policy != "CLOCK") {
+      return Status(
+          Substitute("Unsupported eviction policy: $0", config.eviction_policy));
+    }
+    if (config.capacity <= 0) {
+      return Status(Substitute("Invalid cache capacity: $0", config.capacity));
     }
+    caches_.emplace_back(new SimulatedCache(config));
+    RETURN_IF_ERROR(caches_.back()->Init());
   }
+  initialized_ = true;
+  return Status::OK();
 }
+
+Status CacheSimulator::ReplayFile(string filename) {
+  DCHECK(initialized_);
+  return ReplayTraceFile(
+      filename, [this](const TraceEvent& entry) { ReplayEntry(entry); });
+}
+
+Status CacheSimulator::ReplayDirectory(string directory) {
+  DCHECK(initialized_);
+  return ReplayTraceDirectory(
+      directory, [this](const TraceEvent& entry) { ReplayEntry(entry); });
+}
+
+CacheHitStatistics CacheSimulator::GetStatistics(int i) const {
+  DCHECK(initialized_);
+  DCHECK_GE(i, 0);
+  DCHECK_LT(i, caches_.size());
+  return caches_[i]->stats();
+}
+
+void CacheSimulator::ReplayEntry(const TraceEvent& entry) {
+  if (entry.type != EventType::HIT && entry.type != EventType::MISS) return;
+  // The key is built like the keys of the DataCache: the filename followed by the
+  // mtime and the offset.
+  string key = entry.filename;
+  key.append(reinterpret_cast<const char*>(&entry.mtime), sizeof(entry.mtime));
+  key.append(reinterpret_cast<const char*>(&entry.offset), sizeof(entry.offset));
+  for (const unique_ptr<SimulatedCache>& cache : caches_) cache->Replay(entry, key);
+}
+
 } // namespace trace
 } // namespace io
 } // namespace impala
@@ -242,6 +242,59 @@ class TraceReplayer {
   // outcome can differ from the original trace due to concurrency.
   CacheHitStatistics replay_stats_;
 };
+
+// The CacheSimulator replays traces against in-memory models of the cache with several
+// eviction policies and capacities in a single pass, for capacity planning. Every model
+// is a Cache (see util/cache/cache.h) of one eviction policy that only holds the lengths
+// of the entries, which are charged and replaced like the DataCache does. Unlike the
+// TraceReplayer, it does not model the partitions, cache files or concurrency limits of
+// the DataCache, so it is much faster but approximates the DataCache.
+class CacheSimulator {
+ public:
+  struct Configuration {
+    std::string eviction_policy;
+    int64_t capacity;
+  };
+
+  // Simulates a cache for every combination of 'eviction_policies' (in the format of
+  // the 'data_cache_eviction_policy' startup flag) and 'capacities' in bytes.
+  CacheSimulator(const std::vector<std::string>& eviction_policies,
+      const std::vector<int64_t>& capacities);
+
+  ~CacheSimulator();
+
+  // Initialize the simulator. Fails if an eviction policy is not supported.
+  Status Init();
+
+  // Replay a single trace file against all simulated caches
+  Status ReplayFile(std::string filename);
+
+  // Replay a directory of trace files as generated by the Tracer against all simulated
+  // caches.
+  Status ReplayDirectory(std::string directory);
+
+  // Returns the configurations of the simulated caches, ordered by eviction policy and
+  // then by capacity, in the order of the constructor arguments.
+  const std::vector<Configuration>& configurations() const { return configurations_; }
+
+  // Get the hit statistics of the simulated cache with the configuration
+  // configurations()[i].
+  CacheHitStatistics GetStatistics(int i) const;
+
+ private:
+  class SimulatedCache;
+
+  // Replay an individual TraceEvent against all simulated caches.
+  void ReplayEntry(const TraceEvent& entry);
+
+  std::vector<Configuration> configurations_;
+
+  // Set to true in Init().
+  bool initialized_ = false;
+
+  // The simulated caches, one for each of 'configurations_'.
+  std::vector<std::unique_ptr<SimulatedCache>> caches_;
+};
 } // namespace trace
 } // namespace io
 } // namespace impala
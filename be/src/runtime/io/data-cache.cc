@@ -34,7 +34,10 @@
 #include "gutil/port.h"
 #include "gutil/strings/split.h"
 #include "gutil/walltime.h"
+#include "runtime/exec-env.h"
 #include "runtime/io/data-cache-trace.h"
+#include "runtime/io/local-file-system.h"
+#include "runtime/mem-tracker.h"
 #include "util/bit-util.h"
 #include "util/cache/cache.h"
 #include "util/error-util.h"
@@ -47,6 +50,7 @@
 #include "util/pretty-printer.h"
 #include "util/scope-exit-trigger.h"
 #include "util/test-info.h"
+#include "util/thread.h"
 #include "util/uid-util.h"
 
 #ifndef FALLOC_FL_PUNCH_HOLE
@@ -105,13 +109,49 @@ DEFINE_int32(max_data_cache_trace_files, 10, "Maximum number of data cache trace
 
 DEFINE_string(data_cache_eviction_policy, "LRU",
     "(Advanced) The cache eviction policy to use for the data cache. "
-    "Either 'LRU' (default) or 'LIRS' (experimental)");
+    "Either 'LRU' (default), 'LIRS' (experimental), 'TINYLFU' (experimental) or 'CLOCK' "
+    "(experimental). TINYLFU only admits new entries which are accessed more frequently "
+    "than the entries they would evict, so that large scans do not flush the cache. "
+    "CLOCK approximates LRU with lookups that do not serialize on a lock.");
+
+DEFINE_bool(data_cache_persistent_index, false,
+    "(Advanced) If true, each data cache partition persists its metadata in an index "
+    "file, which is checkpointed periodically and on clean shutdown, and reloaded at "
+    "startup so that the cached data survives restarts. Requires the LRU eviction "
+    "policy.");
+DEFINE_int32(data_cache_index_checkpoint_interval_s, 600,
+    "(Advanced) Interval in seconds between checkpoints of the data cache index if "
+    "--data_cache_persistent_index is true.");
+
+DEFINE_bool(data_cache_direct_io, false,
+    "(Advanced) If true, the data cache reads and writes its backing files with "
+    "O_DIRECT, which bypasses the page cache, so that cache insertions do not evict "
+    "other data from it or cause writeback stalls. Buffers which are not aligned to 4KB "
+    "are copied through an aligned buffer. Falls back to buffered I/O if the filesystem "
+    "does not support O_DIRECT.");
+
+DEFINE_string(data_cache_memory_tier_capacity, "0",
+    "(Advanced) The capacity of the in-memory tier of the data cache, e.g. 1GB. Small "
+    "entries which are hit in the data cache are copied to this tier, so that further "
+    "hits do not need to read the cache files. Disabled if 0.");
+DEFINE_int64(data_cache_memory_tier_max_entry_bytes, 64L * 1024L,
+    "(Advanced) The maximum size in bytes of an entry in the in-memory tier of the data "
+    "cache.");
+
+DEFINE_bool(data_cache_async_delete_stale_files, true,
+    "(Advanced) If true, the backing files that a previous process left in the data "
+    "cache directories are deleted by a background thread after startup instead of "
+    "during it. Their space counts as available when checking the capacity.");
 
 namespace impala {
 namespace io {
 
 static const int64_t PAGE_SIZE = 1L << 12;
 const char* DataCache::Partition::CACHE_FILE_PREFIX = "impala-cache-file-";
+const char* DataCache::Partition::INDEX_FILE_NAME = "impala-cache-index";
+/// Identifies an index file and its format version.
+static const char INDEX_MAGIC[] = "IMPDCIX1";
+static const int INDEX_MAGIC_LEN = sizeof(INDEX_MAGIC) - 1;
 const int MAX_FILE_DELETER_QUEUE_SIZE = 500;
 static const char* PARTITION_PATH_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.remote-data-cache-partition-$0.path";
@@ -152,17 +192,52 @@ class DataCache::CacheFile {
  public:
   ~CacheFile() {
     // Close file if it's not closed already.
-    DeleteFile();
+    if (keep_file_) {
+      Close();
+    } else {
+      DeleteFile();
+    }
   }
 
   static Status Create(std::string path, std::unique_ptr<CacheFile>* cache_file_ptr) {
     unique_ptr<CacheFile> cache_file(new CacheFile(path));
     KUDU_RETURN_IF_ERROR(kudu::Env::Default()->NewRWFile(path, &cache_file->file_),
         "Failed to create cache file");
+    if (FLAGS_data_cache_direct_io) cache_file->OpenDirect();
+    *cache_file_ptr = std::move(cache_file);
+    return Status::OK();
+  }
+
+  // Opens the existing backing file at 'path', which was referenced by a persisted
+  // index. Nothing is appended to a reopened file.
+  static Status Open(std::string path, std::unique_ptr<CacheFile>* cache_file_ptr) {
+    unique_ptr<CacheFile> cache_file(new CacheFile(path));
+    kudu::RWFileOptions opts;
+    opts.mode = Env::MUST_EXIST;
+    KUDU_RETURN_IF_ERROR(Env::Default()->NewRWFile(opts, path, &cache_file->file_),
+        "Failed to open cache file");
+    uint64_t size;
+    KUDU_RETURN_IF_ERROR(cache_file->file_->Size(&size), "Failed to get file size");
+    // Keep offsets page-aligned. Reads past the end of the file fail.
+    cache_file->current_offset_.Store(BitUtil::RoundUp(size, PAGE_SIZE));
+    cache_file->allow_append_ = false;
+    if (FLAGS_data_cache_direct_io) cache_file->OpenDirect();
     *cache_file_ptr = std::move(cache_file);
     return Status::OK();
   }
 
+  // Flushes the data written to the file to the storage device.
+  Status Sync() {
+    kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
+    if (!file_) return Status::OK();
+    KUDU_RETURN_IF_ERROR(file_->Sync(), Substitute("Failed to sync $0", path_));
+    return Status::OK();
+  }
+
+  // Makes the destructor close the file instead of deleting it, so that it can be
+  // reloaded with the persisted index.
+  void KeepFile() { keep_file_ = true; }
+
   // Close the underlying file so it cannot be read or written to anymore.
   void Close() {
     // Explicitly hold the lock in write mode to block all readers. This ensures that
@@ -176,6 +251,10 @@ class DataCache::CacheFile {
           status.ToString());
     }
     file_.reset();
+    if (direct_fd_ >= 0) {
+      close(direct_fd_);
+      direct_fd_ = -1;
+    }
     allow_append_ = false;
   }
 
@@ -220,6 +299,7 @@ class DataCache::CacheFile {
     kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
     if (UNLIKELY(!file_)) return false;
     DCHECK_LE(offset + bytes_to_read, current_offset_.Load());
+    if (direct_fd_ >= 0) return ReadDirect(offset, buffer, bytes_to_read);
     kudu::Status status = file_->Read(offset, Slice(buffer, bytes_to_read));
     if (UNLIKELY(!status.ok())) {
       LOG(ERROR) << Substitute("Failed to read from $0 at offset $1 for $2 bytes: $3",
@@ -239,6 +319,7 @@ class DataCache::CacheFile {
     kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
     if (UNLIKELY(!file_)) return false;
     DCHECK_LE(offset + buffer_len, current_offset_.Load());
+    if (direct_fd_ >= 0) return WriteDirect(offset, buffer, buffer_len);
     kudu::Status status = file_->Write(offset, Slice(buffer, buffer_len));
     if (UNLIKELY(!status.ok())) {
       LOG(ERROR) << Substitute("Failed to write to $0 at offset $1 for $2 bytes: $3",
@@ -264,10 +345,16 @@ class DataCache::CacheFile {
 
   const string& path() const { return path_; }
 
+  // The current size of the file, i.e. the offset of the next allocation.
+  int64_t size() const { return current_offset_.Load(); }
+
  private:
   /// Full path of the backing file in the local storage.
   const string path_;
 
+  /// If true, the file is not deleted when this object is destroyed.
+  bool keep_file_ = false;
+
   /// The underlying backing file. NULL if the file has been closed.
   unique_ptr<RWFile> file_;
 
@@ -285,9 +372,88 @@ class DataCache::CacheFile {
   /// punched after it has been closed. The only operation allowed is to deletion.
   percpu_rwlock lock_;
 
+  /// A descriptor of the backing file opened with O_DIRECT if --data_cache_direct_io
+  /// is true and the filesystem supports it, otherwise -1. Used for reads and writes
+  /// instead of 'file_'. Closed together with 'file_'.
+  int direct_fd_ = -1;
+
   /// C'tor of CacheFile to be called by Create() only.
   explicit CacheFile(std::string path) : path_(move(path)) { }
 
+  void OpenDirect() {
+    direct_fd_ = open(path_.c_str(), O_RDWR | O_DIRECT);
+    if (direct_fd_ < 0) {
+      LOG(WARNING) << Substitute("Failed to open $0 with O_DIRECT, using buffered I/O: "
+          "$1", path_, GetStrErrMsg());
+    }
+  }
+
+  /// Returns a buffer of 'len' bytes for O_DIRECT, or NULL if the allocation fails.
+  static unique_ptr<uint8_t, decltype(&free)> AllocateAligned(int64_t len) {
+    void* ptr;
+    if (posix_memalign(&ptr, LocalFileSystem::DIRECT_IO_ALIGNMENT, len) != 0) {
+      ptr = nullptr;
+    }
+    return unique_ptr<uint8_t, decltype(&free)>(reinterpret_cast<uint8_t*>(ptr), &free);
+  }
+
+  /// Implements Read() with 'direct_fd_'. The read is rounded up to PAGE_SIZE, through
+  /// an aligned buffer if 'buffer' does not meet the alignment requirements. It may end
+  /// early at the end of the file, which is not padded if it was written without
+  /// O_DIRECT.
+  bool ReadDirect(int64_t offset, uint8_t* buffer, int64_t bytes_to_read) {
+    const int64_t aligned_len = BitUtil::RoundUp(bytes_to_read, PAGE_SIZE);
+    unique_ptr<uint8_t, decltype(&free)> bounce(nullptr, &free);
+    uint8_t* dst = buffer;
+    if (!LocalFileSystem::IsDirectIoAligned(buffer, bytes_to_read, offset)) {
+      bounce = AllocateAligned(aligned_len);
+      if (UNLIKELY(bounce == nullptr)) return false;
+      dst = bounce.get();
+    }
+    int64_t bytes_read = 0;
+    while (bytes_read < bytes_to_read) {
+      ssize_t r = pread(
+          direct_fd_, dst + bytes_read, aligned_len - bytes_read, offset + bytes_read);
+      if (UNLIKELY(r <= 0)) {
+        LOG(ERROR) << Substitute("Failed to read from $0 at offset $1 for $2 bytes: $3",
+            path_, offset, PrettyPrinter::PrintBytes(bytes_to_read),
+            r == 0 ? "unexpected end of file" : GetStrErrMsg());
+        return false;
+      }
+      bytes_read += r;
+    }
+    if (dst != buffer) memcpy(buffer, dst, bytes_to_read);
+    return true;
+  }
+
+  /// Implements Write() with 'direct_fd_'. The write is padded with zeros to a multiple
+  /// of PAGE_SIZE, which Allocate() reserved, through an aligned buffer if 'buffer'
+  /// does not meet the alignment requirements.
+  bool WriteDirect(int64_t offset, const uint8_t* buffer, int64_t buffer_len) {
+    const int64_t aligned_len = BitUtil::RoundUp(buffer_len, PAGE_SIZE);
+    unique_ptr<uint8_t, decltype(&free)> bounce(nullptr, &free);
+    const uint8_t* src = buffer;
+    if (!LocalFileSystem::IsDirectIoAligned(buffer, buffer_len, offset)) {
+      bounce = AllocateAligned(aligned_len);
+      if (UNLIKELY(bounce == nullptr)) return false;
+      memcpy(bounce.get(), buffer, buffer_len);
+      memset(bounce.get() + buffer_len, 0, aligned_len - buffer_len);
+      src = bounce.get();
+    }
+    int64_t bytes_written = 0;
+    while (bytes_written < aligned_len) {
+      ssize_t r = pwrite(direct_fd_, src + bytes_written, aligned_len - bytes_written,
+          offset + bytes_written);
+      if (UNLIKELY(r < 0)) {
+        LOG(ERROR) << Substitute("Failed to write to $0 at offset $1 for $2 bytes: $3",
+            path_, offset, PrettyPrinter::PrintBytes(buffer_len), GetStrErrMsg());
+        return false;
+      }
+      bytes_written += r;
+    }
+    return true;
+  }
+
   DISALLOW_COPY_AND_ASSIGN(CacheFile);
 };
 
@@ -337,6 +503,11 @@ struct DataCache::CacheKey {
     key_.append(filename);
   }
 
+  /// Copies an encoded key, e.g. of an evicted entry.
+  explicit CacheKey(const Slice& key) : key_(key.size()) {
+    key_.append(key.data(), key.size());
+  }
+
   int64_t Hash() const {
     return HashUtil::FastHash64(key_.data(), key_.size(), 0);
   }
@@ -371,7 +542,9 @@ struct DataCache::CacheKey {
 
 static Cache::EvictionPolicy GetCacheEvictionPolicy(const std::string& policy_string) {
   Cache::EvictionPolicy policy = Cache::ParseEvictionPolicy(policy_string);
-  if (policy != Cache::EvictionPolicy::LRU && policy != Cache::EvictionPolicy::LIRS) {
+  if (policy != Cache::EvictionPolicy::LRU && policy != Cache::EvictionPolicy::LIRS
+      && policy != Cache::EvictionPolicy::TINYLFU
+      && policy != Cache::EvictionPolicy::CLOCK) {
     LOG(FATAL) << "Unsupported eviction policy: " << policy_string;
   }
   return policy;
@@ -379,12 +552,14 @@ static Cache::EvictionPolicy GetCacheEvictionPolicy(const std::string& policy_st
 
 DataCache::Partition::Partition(
     int32_t index, const string& path, int64_t capacity, int max_opened_files,
-    bool trace_replay)
+    bool trace_replay, int num_partitions)
   : index_(index),
     path_(path),
     capacity_(max<int64_t>(capacity, PAGE_SIZE)),
     max_opened_files_(max_opened_files),
     trace_replay_(trace_replay),
+    num_partitions_(num_partitions),
+    persistent_index_(FLAGS_data_cache_persistent_index && !trace_replay),
     meta_cache_(NewCache(GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy),
         capacity_, path_)) {}
 
@@ -404,14 +579,30 @@ Status DataCache::Partition::CreateCacheFile() {
   return Status::OK();
 }
 
-Status DataCache::Partition::DeleteExistingFiles() const {
+Status DataCache::Partition::DeleteExistingFiles(int64_t* stale_bytes) {
   DCHECK(!trace_replay_);
+  *stale_bytes = 0;
   vector<string> entries;
   RETURN_IF_ERROR(FileSystemUtil::Directory::GetEntryNames(path_, &entries, 0,
       FileSystemUtil::Directory::EntryType::DIR_ENTRY_REG));
   for (const string& entry : entries) {
     if (entry.find(CACHE_FILE_PREFIX) == 0) {
       const string file_path = JoinPathSegments(path_, entry);
+      // Keep the files reloaded from the persisted index.
+      bool reloaded = false;
+      for (const unique_ptr<CacheFile>& cache_file : cache_files_) {
+        reloaded |= cache_file->path() == file_path;
+      }
+      if (reloaded) continue;
+      if (FLAGS_data_cache_async_delete_stale_files) {
+        uint64_t size_on_disk;
+        KUDU_RETURN_IF_ERROR(
+            kudu::Env::Default()->GetFileSizeOnDisk(file_path, &size_on_disk),
+            Substitute("Failed to get the size of old cache file $0", file_path));
+        *stale_bytes += size_on_disk;
+        stale_files_.push_back(file_path);
+        continue;
+      }
       KUDU_RETURN_IF_ERROR(kudu::Env::Default()->DeleteFile(file_path),
           Substitute("Failed to delete old cache file $0", file_path));
       LOG(INFO) << Substitute("Deleted old cache file $0", file_path);
@@ -420,6 +611,20 @@ Status DataCache::Partition::DeleteExistingFiles() const {
   return Status::OK();
 }
 
+void DataCache::Partition::DeleteStaleFiles(const std::atomic<bool>& shut_down) {
+  for (const string& file_path : stale_files_) {
+    if (shut_down.load()) return;
+    kudu::Status status = kudu::Env::Default()->DeleteFile(file_path);
+    if (status.ok()) {
+      LOG(INFO) << Substitute("Deleted old cache file $0", file_path);
+    } else {
+      LOG(WARNING) << Substitute("Failed to delete old cache file $0: $1", file_path,
+          status.ToString());
+    }
+  }
+  stale_files_.clear();
+}
+
 Status DataCache::Partition::Init() {
   std::unique_lock<SpinLock> partition_lock(lock_);
 
@@ -435,13 +640,29 @@ Status DataCache::Partition::Init() {
   }
   RETURN_IF_ERROR(FileSystemUtil::VerifyIsDirectory(path_));
 
-  // Delete all existing backing files left over from previous runs.
-  RETURN_IF_ERROR(DeleteExistingFiles());
+  int64_t loaded_bytes = 0;
+  if (persistent_index_) {
+    Status load_status = LoadIndex(&loaded_bytes);
+    if (load_status.ok()) {
+      LOG(INFO) << Substitute("Reloaded $0 of cached data in $1",
+          PrettyPrinter::PrintBytes(loaded_bytes), path_);
+    } else {
+      LOG(INFO) << Substitute("Not reloading the data cache index in $0: $1", path_,
+          load_status.GetDetail());
+    }
+  }
+
+  // Delete all existing backing files left over from previous runs, except for the
+  // reloaded ones, or collect them for deletion in the background.
+  int64_t stale_bytes;
+  RETURN_IF_ERROR(DeleteExistingFiles(&stale_bytes));
 
-  // Check if there is enough space available at this point in time.
+  // Check if there is enough space available at this point in time. The reloaded
+  // entries already use some of the capacity, and the stale files free their space
+  // once they are deleted.
   uint64_t available_bytes;
   RETURN_IF_ERROR(FileSystemUtil::GetSpaceAvailable(path_, &available_bytes));
-  if (available_bytes < capacity_) {
+  if (available_bytes + loaded_bytes + stale_bytes < capacity_) {
     const string& err = Substitute("Insufficient space for $0. Required $1. Only $2 is "
         "available", path_, PrettyPrinter::PrintBytes(capacity_),
         PrettyPrinter::PrintBytes(available_bytes));
@@ -484,6 +705,230 @@ Status DataCache::Partition::Init() {
   return Status::OK();
 }
 
+namespace {
+
+template <typename T>
+void AppendToIndex(const T& value, faststring* index) {
+  index->append(&value, sizeof(T));
+}
+
+/// Reads values from a serialized index.
+class IndexReader {
+ public:
+  IndexReader(const uint8_t* data, int64_t len) : pos_(data), end_(data + len) {}
+
+  /// Reads a value of type T. Returns false if the index is truncated.
+  template <typename T>
+  bool Read(T* value) {
+    if (end_ - pos_ < static_cast<int64_t>(sizeof(T))) return false;
+    memcpy(value, pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+
+  /// Points 'value' to the next 'len' bytes. Returns false if the index is truncated.
+  bool ReadSlice(int64_t len, Slice* value) {
+    if (end_ - pos_ < len) return false;
+    *value = Slice(pos_, len);
+    pos_ += len;
+    return true;
+  }
+
+ private:
+  const uint8_t* pos_;
+  const uint8_t* const end_;
+};
+
+/// Returns true if the 'len' bytes at 'offset' of the file 'fd' contain no hole, i.e.
+/// were written and were not evicted by punching a hole since.
+bool IsRangeAllocated(int fd, int64_t offset, int64_t len) {
+  if (lseek(fd, offset, SEEK_DATA) != offset) return false;
+  return lseek(fd, offset, SEEK_HOLE) >= offset + len;
+}
+
+}
+
+// The index file consists of:
+// - INDEX_MAGIC
+// - the number of backing files, followed by the name of each file as its length and
+//   its characters
+// - the number of entries, followed by each entry as the index of its backing file,
+//   the offset, length and checksum of its content, and the key as its length and its
+//   bytes, from the least to the most recently used entry
+// - a hash of all the above
+Status DataCache::Partition::Checkpoint() {
+  DCHECK(persistent_index_);
+  std::lock_guard<std::mutex> checkpoint_lock(checkpoint_lock_);
+  // Snapshot the opened backing files. Files deleted after this are skipped when the
+  // index is reloaded.
+  vector<CacheFile*> files;
+  std::unordered_map<const CacheFile*, uint32_t> file_idxs;
+  {
+    std::unique_lock<SpinLock> partition_lock(lock_);
+    if (closed_) return Status::OK();
+    for (int i = max(oldest_opened_file_, 0); i < cache_files_.size(); ++i) {
+      file_idxs.emplace(cache_files_[i].get(), files.size());
+      files.push_back(cache_files_[i].get());
+    }
+  }
+  faststring index;
+  index.append(INDEX_MAGIC, INDEX_MAGIC_LEN);
+  AppendToIndex<uint32_t>(files.size(), &index);
+  for (const CacheFile* file : files) {
+    const string name = file->path().substr(path_.size() + 1);
+    AppendToIndex<uint32_t>(name.size(), &index);
+    index.append(name);
+  }
+  // Collect the entries in order of recency without invalidating any of them. Entries
+  // are only inserted after their content was written, so syncing the files below makes
+  // the content of all collected entries durable.
+  faststring entries;
+  uint64_t num_entries = 0;
+  meta_cache_->Invalidate(Cache::InvalidationControl([&](Slice key, Slice value) {
+    CacheEntry entry(value);
+    auto it = file_idxs.find(entry.file());
+    if (it == file_idxs.end()) return true;
+    AppendToIndex<uint32_t>(it->second, &entries);
+    AppendToIndex<int64_t>(entry.offset(), &entries);
+    AppendToIndex<int64_t>(entry.len(), &entries);
+    AppendToIndex<uint64_t>(entry.checksum(), &entries);
+    AppendToIndex<uint32_t>(key.size(), &entries);
+    entries.append(key.data(), key.size());
+    ++num_entries;
+    return true;
+  }));
+  AppendToIndex<uint64_t>(num_entries, &index);
+  index.append(entries.data(), entries.size());
+  AppendToIndex<uint64_t>(HashUtil::FastHash64(index.data(), index.size(), 0), &index);
+
+  for (CacheFile* file : files) RETURN_IF_ERROR(file->Sync());
+  // Write to a temporary file first so that a crash cannot leave a partial index.
+  const string index_path = JoinPathSegments(path_, INDEX_FILE_NAME);
+  const string tmp_path = index_path + ".tmp";
+  Env* env = Env::Default();
+  {
+    unique_ptr<WritableFile> tmp_file;
+    KUDU_RETURN_IF_ERROR(env->NewWritableFile(tmp_path, &tmp_file),
+        Substitute("Failed to create $0", tmp_path));
+    KUDU_RETURN_IF_ERROR(tmp_file->Append(Slice(index.data(), index.size())),
+        Substitute("Failed to write $0", tmp_path));
+    KUDU_RETURN_IF_ERROR(tmp_file->Sync(), Substitute("Failed to sync $0", tmp_path));
+    KUDU_RETURN_IF_ERROR(tmp_file->Close(), Substitute("Failed to close $0", tmp_path));
+  }
+  KUDU_RETURN_IF_ERROR(env->RenameFile(tmp_path, index_path),
+      Substitute("Failed to rename $0", tmp_path));
+  KUDU_RETURN_IF_ERROR(env->SyncDir(path_), Substitute("Failed to sync $0", path_));
+  VLOG(1) << Substitute("Checkpointed $0 data cache entries in $1", num_entries, path_);
+  return Status::OK();
+}
+
+Status DataCache::Partition::LoadIndex(int64_t* loaded_bytes) {
+  lock_.DCheckLocked();
+  DCHECK(cache_files_.empty());
+  *loaded_bytes = 0;
+  const string index_path = JoinPathSegments(path_, INDEX_FILE_NAME);
+  Env* env = Env::Default();
+  if (!env->FileExists(index_path)) return Status("No index found");
+  faststring index;
+  KUDU_RETURN_IF_ERROR(kudu::ReadFileToString(env, index_path, &index),
+      Substitute("Failed to read $0", index_path));
+  // Verify the magic and the hash first, so that a corrupt index is not reloaded at all.
+  if (index.size() < INDEX_MAGIC_LEN + sizeof(uint64_t)
+      || memcmp(index.data(), INDEX_MAGIC, INDEX_MAGIC_LEN) != 0) {
+    return Status(Substitute("Invalid index $0", index_path));
+  }
+  const int64_t hashed_len = index.size() - sizeof(uint64_t);
+  uint64_t hash;
+  memcpy(&hash, index.data() + hashed_len, sizeof(hash));
+  if (hash != HashUtil::FastHash64(index.data(), hashed_len, 0)) {
+    return Status(Substitute("Corrupt index $0", index_path));
+  }
+  const Status truncated(Substitute("Truncated index $0", index_path));
+  IndexReader reader(index.data() + INDEX_MAGIC_LEN, hashed_len - INDEX_MAGIC_LEN);
+
+  // Open the backing files. Entries of files that cannot be opened are dropped.
+  uint32_t num_files;
+  if (!reader.Read(&num_files)) return truncated;
+  vector<unique_ptr<CacheFile>> files(num_files);
+  vector<int> fds(num_files, -1);
+  auto close_fds = MakeScopeExitTrigger([&fds]() {
+    for (int fd : fds) {
+      if (fd >= 0) close(fd);
+    }
+  });
+  for (int i = 0; i < num_files; ++i) {
+    uint32_t name_len;
+    Slice name;
+    if (!reader.Read(&name_len) || !reader.ReadSlice(name_len, &name)) return truncated;
+    const string file_path = JoinPathSegments(path_, name.ToString());
+    if (name.ToString().find(CACHE_FILE_PREFIX) != 0) continue;
+    Status status = CacheFile::Open(file_path, &files[i]);
+    if (status.ok()) {
+      // Used to check whether the ranges of the entries were evicted since.
+      fds[i] = open(file_path.c_str(), O_RDONLY);
+      if (fds[i] < 0) files[i].reset();
+    }
+    if (files[i] == nullptr) {
+      LOG(WARNING) << Substitute("Dropping the cached data in $0: $1", file_path,
+          status.ok() ? GetStrErrMsg() : status.GetDetail());
+    }
+  }
+
+  // The reloaded files are owned by the partition from here on, as entries refer to them.
+  vector<CacheFile*> file_ptrs(num_files, nullptr);
+  for (int i = 0; i < num_files; ++i) {
+    if (files[i] == nullptr) continue;
+    file_ptrs[i] = files[i].get();
+    cache_files_.emplace_back(move(files[i]));
+  }
+
+  uint64_t num_entries;
+  if (!reader.Read(&num_entries)) return truncated;
+  int64_t num_loaded = 0;
+  for (uint64_t i = 0; i < num_entries; ++i) {
+    uint32_t file_idx;
+    int64_t offset;
+    int64_t len;
+    uint64_t checksum;
+    uint32_t key_len;
+    Slice key;
+    if (!reader.Read(&file_idx) || !reader.Read(&offset) || !reader.Read(&len)
+        || !reader.Read(&checksum) || !reader.Read(&key_len)
+        || !reader.ReadSlice(key_len, &key)) {
+      return truncated;
+    }
+    // Drop entries which are damaged, were evicted after the checkpoint or belong to
+    // another partition, e.g. if the number of partitions changed.
+    if (file_idx >= num_files || file_ptrs[file_idx] == nullptr) continue;
+    CacheFile* file = file_ptrs[file_idx];
+    if (offset < 0 || offset % PAGE_SIZE != 0 || len <= 0 || offset + len > file->size()
+        || !IsRangeAllocated(fds[file_idx], offset, len)) {
+      continue;
+    }
+    if (CacheKey(key).Hash() % num_partitions_ != index_) continue;
+    if (InsertLoadedEntry(key, CacheEntry(file, offset, len, checksum))) {
+      *loaded_bytes += BitUtil::RoundUp(len, PAGE_SIZE);
+      ++num_loaded;
+    }
+  }
+  LOG(INFO) << Substitute("Reloaded $0 of $1 entries from $2", num_loaded, num_entries,
+      index_path);
+  return Status::OK();
+}
+
+bool DataCache::Partition::InsertLoadedEntry(const Slice& key, const CacheEntry& entry) {
+  const int64_t charge_len = BitUtil::RoundUp(entry.len(), PAGE_SIZE);
+  Cache::UniquePendingHandle pending_handle(
+      meta_cache_->Allocate(key, sizeof(CacheEntry), charge_len));
+  if (UNLIKELY(pending_handle.get() == nullptr)) return false;
+  memcpy(meta_cache_->MutableValue(&pending_handle), &entry, sizeof(CacheEntry));
+  Cache::UniqueHandle handle(meta_cache_->Insert(std::move(pending_handle), this));
+  if (UNLIKELY(handle.get() == nullptr)) return false;
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES->Increment(charge_len);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES->Increment(1);
+  return true;
+}
+
 void DataCache::Partition::InitMetrics() {
   const string& i_string = Substitute("$0", index_);
   // Backend tests may instantiate the data cache (and its associated partitions)
@@ -554,17 +999,28 @@ Status DataCache::Partition::CloseFilesAndVerifySizes() {
 }
 
 void DataCache::Partition::ReleaseResources() {
+  if (persistent_index_ && !closed_) {
+    Status status = Checkpoint();
+    if (!status.ok()) {
+      LOG(WARNING) << Substitute("Failed to checkpoint the data cache index in $0: $1",
+          path_, status.GetDetail());
+    }
+  }
   std::unique_lock<SpinLock> partition_lock(lock_);
   if (closed_) return;
   closed_ = true;
-  // Close and delete all backing files in this partition.
+  // Close and delete all backing files in this partition. Keep them for the next run
+  // with a persistent index.
+  if (persistent_index_) {
+    for (unique_ptr<CacheFile>& cache_file : cache_files_) cache_file->KeepFile();
+  }
   cache_files_.clear();
   // Free all memory consumed by the metadata cache.
   meta_cache_.reset();
 }
 
 int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to_read,
-    uint8_t* buffer) {
+    uint8_t* buffer, int64_t* entry_len) {
   DCHECK(!closed_);
   DCHECK(trace_replay_ ? buffer == nullptr : buffer != nullptr);
   Slice key = cache_key.ToSlice();
@@ -579,6 +1035,7 @@ int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to
   CacheEntry entry(meta_cache_->Value(handle));
 
   Trace(trace::EventType::HIT, cache_key, bytes_to_read, entry.len());
+  if (entry_len != nullptr) *entry_len = entry.len();
 
   bytes_to_read = min(entry.len(), bytes_to_read);
   // Skip the actual reads if doing trace replay
@@ -803,6 +1260,79 @@ bool DataCache::Partition::VerifyChecksum(const string& ops_name, const CacheEnt
   return true;
 }
 
+DataCache::MemoryTier::MemoryTier(DataCache* data_cache, int64_t capacity)
+  : data_cache_(data_cache),
+    cache_(NewCache(GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy),
+        capacity, "DataCacheMemoryTier")) {}
+
+DataCache::MemoryTier::~MemoryTier() {
+  if (!closed_) ReleaseResources();
+}
+
+Status DataCache::MemoryTier::Init() {
+  RETURN_IF_ERROR(cache_->Init());
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  mem_tracker_.reset(new MemTracker(-1, "Data Cache Memory Tier",
+      exec_env != nullptr ? exec_env->process_mem_tracker() : nullptr));
+  return Status::OK();
+}
+
+void DataCache::MemoryTier::ReleaseResources() {
+  if (closed_) return;
+  closed_ = true;
+  // Frees all entries, which releases their memory from 'mem_tracker_'.
+  cache_.reset();
+  if (mem_tracker_ == nullptr) return;
+  if (mem_tracker_->parent() != nullptr) {
+    mem_tracker_->CloseAndUnregisterFromParent();
+  } else {
+    mem_tracker_->Close();
+  }
+}
+
+int64_t DataCache::MemoryTier::Lookup(const CacheKey& cache_key, int64_t bytes_to_read,
+    uint8_t* buffer) {
+  DCHECK(!closed_);
+  Cache::UniqueHandle handle(cache_->Lookup(cache_key.ToSlice()));
+  if (handle.get() == nullptr) return 0;
+  Slice value = cache_->Value(handle);
+  bytes_to_read = min<int64_t>(value.size(), bytes_to_read);
+  memcpy(buffer, value.data(), bytes_to_read);
+  return bytes_to_read;
+}
+
+void DataCache::MemoryTier::Insert(const CacheKey& cache_key, const uint8_t* buffer,
+    int64_t buffer_len) {
+  DCHECK(!closed_);
+  Slice key = cache_key.ToSlice();
+  const int64_t charge = key.size() + buffer_len;
+  Cache::UniquePendingHandle pending_handle(cache_->Allocate(key, buffer_len, charge));
+  if (pending_handle.get() == nullptr) return;
+  memcpy(cache_->MutableValue(&pending_handle), buffer, buffer_len);
+  // Consume before inserting, since the entry may be evicted during Insert().
+  mem_tracker_->Consume(charge);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES->Increment(charge);
+  Cache::UniqueHandle handle(cache_->Insert(move(pending_handle), this));
+}
+
+void DataCache::MemoryTier::Erase(const CacheKey& cache_key) {
+  DCHECK(!closed_);
+  cache_->Erase(cache_key.ToSlice());
+}
+
+void DataCache::MemoryTier::EvictedEntry(Slice key, Slice value) {
+  const int64_t charge = key.size() + value.size();
+  mem_tracker_->Release(charge);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES->Increment(-charge);
+  if (closed_) return;
+  // Entries are only promoted from a partition, so usually the partition still has the
+  // entry and this is only a lookup. Storing it again keeps hot data that stayed in
+  // memory while the partition evicted it. Like Store(), this writes synchronously on
+  // the thread that caused the eviction.
+  data_cache_->StoreInPartition(
+      CacheKey(key), reinterpret_cast<const uint8_t*>(value.data()), value.size());
+}
+
 Status DataCache::Init() {
   // Verifies all the configured flags are sane.
   if (FLAGS_data_cache_file_max_size_bytes < PAGE_SIZE) {
@@ -841,19 +1371,58 @@ Status DataCache::Init() {
     return Status(Substitute("Misconfigured --data_cache_max_opened_files: $0. Must be "
         "at least $1.", FLAGS_data_cache_max_opened_files, cache_dirs.size()));
   }
+  const bool persistent_index = FLAGS_data_cache_persistent_index && !trace_replay_;
+  // Checkpointing iterates over the entries with Cache::Invalidate(), which only the LRU
+  // cache implements.
+  if (persistent_index
+      && GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy)
+          != Cache::EvictionPolicy::LRU) {
+    return Status(Substitute("--data_cache_persistent_index requires the LRU eviction "
+        "policy. Configured policy: $0", FLAGS_data_cache_eviction_policy));
+  }
   int32_t partition_idx = 0;
+  vector<unique_ptr<Partition>> partitions;
   for (const string& dir_path : cache_dirs) {
     LOG(INFO) << "Adding partition " << dir_path << " with capacity "
               << PrettyPrinter::PrintBytes(capacity);
-    std::unique_ptr<Partition> partition =
-        make_unique<Partition>(partition_idx, dir_path, capacity,
-            max_opened_files_per_partition, trace_replay_);
-    RETURN_IF_ERROR(partition->Init());
-    partitions_.emplace_back(move(partition));
+    partitions.emplace_back(make_unique<Partition>(partition_idx, dir_path, capacity,
+        max_opened_files_per_partition, trace_replay_, cache_dirs.size()));
     ++partition_idx;
   }
+  // The partitions are usually on different disks, and reloading the index of one or
+  // scanning its directory can take a while, so they are initialized concurrently.
+  vector<Status> init_statuses(partitions.size());
+  vector<unique_ptr<Thread>> init_threads(partitions.size());
+  for (int i = 0; i < partitions.size(); ++i) {
+    Partition* partition = partitions[i].get();
+    Status* init_status = &init_statuses[i];
+    init_statuses[i] = Thread::Create("impala-server",
+        Substitute("data-cache-init-$0", i),
+        [partition, init_status]() { *init_status = partition->Init(); },
+        &init_threads[i]);
+  }
+  for (int i = 0; i < partitions.size(); ++i) {
+    if (init_threads[i] != nullptr) init_threads[i]->Join();
+  }
+  for (const Status& init_status : init_statuses) RETURN_IF_ERROR(init_status);
+  partitions_ = move(partitions);
   CHECK_GT(partitions_.size(), 0);
 
+  int64_t memory_tier_capacity =
+      ParseUtil::ParseMemSpec(FLAGS_data_cache_memory_tier_capacity, &is_percent, 0);
+  if (memory_tier_capacity < 0 || is_percent) {
+    return Status(Substitute("Malformed --data_cache_memory_tier_capacity: $0",
+        FLAGS_data_cache_memory_tier_capacity));
+  }
+  // The memory tier only saves reads of the backing files, so there is no point in it
+  // for trace replays.
+  if (memory_tier_capacity > 0 && LIKELY(!trace_replay_)) {
+    LOG(INFO) << "Adding data cache memory tier with capacity "
+              << PrettyPrinter::PrintBytes(memory_tier_capacity);
+    memory_tier_.reset(new MemoryTier(this, memory_tier_capacity));
+    RETURN_IF_ERROR(memory_tier_->Init());
+  }
+
   if (LIKELY(!trace_replay_)) {
     // Starts a thread pool which deletes old files from partitions. DataCache::Store()
     // will enqueue a request (i.e. a partition index) when it notices the number of files
@@ -865,14 +1434,58 @@ Status DataCache::Init() {
     RETURN_IF_ERROR(file_deleter_pool_->Init());
   }
 
+  if (persistent_index) {
+    RETURN_IF_ERROR(Thread::Create("impala-server", "data-cache-checkpoint",
+        &DataCache::CheckpointThread, this, &checkpoint_thread_));
+  }
+  if (FLAGS_data_cache_async_delete_stale_files && LIKELY(!trace_replay_)) {
+    RETURN_IF_ERROR(Thread::Create("impala-server", "data-cache-stale-file-deleter",
+        [this]() {
+          for (auto& partition : partitions_) {
+            partition->DeleteStaleFiles(stale_file_deleter_shut_down_);
+          }
+        }, &stale_file_deleter_thread_));
+  }
   return Status::OK();
 }
 
 void DataCache::ReleaseResources() {
+  if (stale_file_deleter_thread_ != nullptr) {
+    stale_file_deleter_shut_down_.store(true);
+    stale_file_deleter_thread_->Join();
+    stale_file_deleter_thread_.reset();
+  }
+  if (checkpoint_thread_ != nullptr) {
+    checkpoint_thread_shutdown_.Set(true);
+    checkpoint_thread_->Join();
+  }
   if (file_deleter_pool_) file_deleter_pool_->Shutdown();
+  // Release the memory tier first, since it demotes entries to the partitions.
+  if (memory_tier_) memory_tier_->ReleaseResources();
   for (auto& partition : partitions_) partition->ReleaseResources();
 }
 
+void DataCache::Checkpoint() {
+  if (!FLAGS_data_cache_persistent_index || trace_replay_) return;
+  for (auto& partition : partitions_) {
+    Status status = partition->Checkpoint();
+    if (!status.ok()) {
+      LOG(WARNING) << "Failed to checkpoint data cache index: " << status.GetDetail();
+    }
+  }
+}
+
+void DataCache::CheckpointThread() {
+  const int64_t interval_ms =
+      max(FLAGS_data_cache_index_checkpoint_interval_s, 1) * 1000L;
+  while (true) {
+    bool timed_out;
+    checkpoint_thread_shutdown_.Get(interval_ms, &timed_out);
+    if (!timed_out) return;
+    Checkpoint();
+  }
+}
+
 int64_t DataCache::Lookup(const string& filename, int64_t mtime, int64_t offset,
     int64_t bytes_to_read, uint8_t* buffer) {
   DCHECK(!partitions_.empty());
@@ -885,8 +1498,26 @@ int64_t DataCache::Lookup(const string& filename, int64_t mtime, int64_t offset,
 
   // Construct a cache key. The cache key is also hashed to compute the partition index.
   const CacheKey key(filename, mtime, offset);
-  int idx = key.Hash() % partitions_.size();
-  int64_t bytes_read = partitions_[idx]->Lookup(key, bytes_to_read, buffer);
+  int64_t bytes_read = 0;
+  if (memory_tier_ != nullptr) {
+    bytes_read = memory_tier_->Lookup(key, bytes_to_read, buffer);
+    if (bytes_read > 0) {
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES->Increment(
+          bytes_read);
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT->Increment(1);
+    }
+  }
+  if (bytes_read == 0) {
+    int idx = key.Hash() % partitions_.size();
+    int64_t entry_len = 0;
+    bytes_read = partitions_[idx]->Lookup(key, bytes_to_read, buffer, &entry_len);
+    // Promote small entries on their first hit in the partition, i.e. the second time
+    // they are read. Only complete entries can be promoted.
+    if (memory_tier_ != nullptr && bytes_read > 0 && bytes_read == entry_len
+        && entry_len <= FLAGS_data_cache_memory_tier_max_entry_bytes) {
+      memory_tier_->Insert(key, buffer, bytes_read);
+    }
+  }
   if (VLOG_IS_ON(3)) {
     stringstream ss;
     ss << std::hex << reinterpret_cast<int64_t>(buffer);
@@ -909,15 +1540,24 @@ bool DataCache::Store(const string& filename, int64_t mtime, int64_t offset,
 
   // Construct a cache key. The cache key is also hashed to compute the partition index.
   const CacheKey key(filename, mtime, offset);
-  int idx = key.Hash() % partitions_.size();
-  bool start_reclaim;
-  bool stored = partitions_[idx]->Store(key, buffer, buffer_len, &start_reclaim);
+  bool stored = StoreInPartition(key, buffer, buffer_len);
+  // A longer entry replaced the entry in the partition, so the copy in the memory tier
+  // is stale.
+  if (stored && memory_tier_ != nullptr) memory_tier_->Erase(key);
   if (VLOG_IS_ON(3)) {
     stringstream ss;
     ss << std::hex << reinterpret_cast<int64_t>(buffer);
     LOG(INFO) << Substitute("Storing $0 mtime: $1 offset: $2 bytes_to_read: $3 "
         "buffer: 0x$4 stored: $5", filename, mtime, offset, buffer_len, ss.str(), stored);
   }
+  return stored;
+}
+
+bool DataCache::StoreInPartition(const CacheKey& key, const uint8_t* buffer,
+    int64_t buffer_len) {
+  int idx = key.Hash() % partitions_.size();
+  bool start_reclaim;
+  bool stored = partitions_[idx]->Store(key, buffer, buffer_len, &start_reclaim);
   if (start_reclaim) file_deleter_pool_->Offer(idx);
   return stored;
 }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <mutex>
 #include <string>
 #include <unistd.h>
@@ -27,6 +28,7 @@
 #include "common/status.h"
 #include "util/cache/cache.h"
 #include "util/metrics-fwd.h"
+#include "util/promise.h"
 #include "util/spinlock.h"
 #include "util/thread-pool.h"
 #include "kudu/util/faststring.h"
@@ -87,6 +89,23 @@
 /// via the knob --data_cache_write_concurrency. Also, Store() has a minimum granularity
 /// of 4KB so any data inserted will be rounded up to the nearest multiple of 4KB.
 ///
+/// Optionally, a memory tier sized by --data_cache_memory_tier_capacity sits in front of
+/// the partitions. It holds copies of small entries (up to
+/// --data_cache_memory_tier_max_entry_bytes) which were hit in a partition, i.e. which
+/// were read again after they were stored, so that repeated hits on hot data such as
+/// file footers or dictionary pages skip the read from the backing file and the
+/// checksum. Its memory is tracked by a MemTracker and it uses the same eviction policy
+/// as the partitions. Entries evicted from the memory tier are demoted, i.e. written
+/// back to their partition if the partition evicted them in the meantime.
+///
+/// Optionally, with --data_cache_persistent_index, the cache survives restarts. Each
+/// partition periodically checkpoints its metadata - the cache keys and where their
+/// content is stored - to an index file in its directory, and also does so on clean
+/// shutdown. At startup, the backing files referenced by the index are kept and the
+/// entries are reloaded, except for entries whose backing file ranges are missing or
+/// were evicted since the checkpoint (i.e. have holes punched). Checksums, if enabled,
+/// are verified lazily on lookup as usual. This requires the LRU eviction policy.
+///
 /// The number of backing files in all partitions is bound by
 /// --data_cache_max_opened_files. Once the number of files exceeds that set limit, files
 /// are closed and deleted asynchronously by thread in 'file_deleter_pool_'. Stale cache
@@ -105,6 +124,10 @@
 ///
 
 namespace impala {
+
+class MemTracker;
+class Thread;
+
 namespace io {
 
 namespace trace {
@@ -184,6 +207,10 @@ class DataCache {
   bool Store(const std::string& filename, int64_t mtime, int64_t offset,
       const uint8_t* buffer, int64_t buffer_len);
 
+  /// Checkpoints the index of each partition if --data_cache_persistent_index is set.
+  /// Called periodically and on clean shutdown. Failures are logged.
+  void Checkpoint();
+
   /// Utility function to verify that all partitions' consumption don't exceed their
   /// quotas. Return error status if checking files' sizes failed or if the total space
   /// consumed by a partition exceeded its capacity. Will close the backing files of
@@ -199,6 +226,49 @@ class DataCache {
   struct CacheKey;
   class CacheEntry;
 
+  /// The in-memory tier in front of the partitions. The value of each entry in its cache
+  /// is the cached content itself.
+  class MemoryTier : public Cache::EvictionCallback {
+   public:
+    /// 'data_cache' is the cache which owns this tier, whose partitions evicted entries
+    /// are demoted to. 'capacity' is the memory limit in bytes.
+    MemoryTier(DataCache* data_cache, int64_t capacity);
+
+    ~MemoryTier();
+
+    Status Init();
+
+    /// Frees all entries without demoting them.
+    void ReleaseResources();
+
+    /// Looks up 'cache_key' and copies up to 'bytes_to_read' bytes of its content into
+    /// 'buffer'. Returns the number of bytes copied, or 0 on a miss.
+    int64_t Lookup(const CacheKey& cache_key, int64_t bytes_to_read, uint8_t* buffer);
+
+    /// Inserts a copy of the 'buffer_len' bytes of 'buffer' with key 'cache_key'.
+    void Insert(const CacheKey& cache_key, const uint8_t* buffer, int64_t buffer_len);
+
+    /// Removes the entry with key 'cache_key', if any.
+    void Erase(const CacheKey& cache_key);
+
+    /// Callback invoked when an entry is evicted from the cache. Demotes the entry to
+    /// its partition and releases its memory.
+    virtual void EvictedEntry(kudu::Slice key, kudu::Slice value) override;
+
+   private:
+    DataCache* const data_cache_;
+
+    /// Tracks the memory of the cached entries. A child of the process MemTracker if
+    /// there is one.
+    std::unique_ptr<MemTracker> mem_tracker_;
+
+    /// Maps a cache key to the cached content.
+    std::unique_ptr<Cache> cache_;
+
+    /// Set by ReleaseResources() so that freeing the entries does not demote them.
+    bool closed_ = false;
+  };
+
   /// An implementation of a cache partition. Each partition maintains its own set of
   /// cache keys in a LRU cache.
   class Partition : public Cache::EvictionCallback {
@@ -207,14 +277,18 @@ class DataCache {
     /// 'max_opened_files' is the maximum number of opened files allowed per partition.
     /// If 'trace_replay' is true, this only performs metadata operations for the
     /// access trace functionality.
+    /// 'num_partitions' is the number of partitions in the cache, which determines the
+    /// entries of a persisted index that belong to this partition.
     Partition(int32_t index, const std::string& path, int64_t capacity,
-        int max_opened_files, bool trace_replay);
+        int max_opened_files, bool trace_replay, int num_partitions = 1);
 
     ~Partition();
 
     /// Initializes the current partition:
     /// - verifies if the specified directory is valid
-    /// - removes any stale backing file in this partition
+    /// - reloads the persisted index if --data_cache_persistent_index is set
+    /// - removes any stale backing file in this partition, i.e. any file not referenced
+    ///   by the reloaded index
     /// - checks if there is enough storage space
     /// - checks if the filesystem supports hole punching
     /// - creates an empty backing file.
@@ -222,15 +296,26 @@ class DataCache {
     /// Returns error if there is any of the above steps fails. Returns OK otherwise.
     Status Init();
 
+    /// Deletes the stale backing files that Init() left for deletion in the background.
+    /// Stops early once 'shut_down' is set.
+    void DeleteStaleFiles(const std::atomic<bool>& shut_down);
+
     /// Close and delete all backing files created for this partition. Also releases
-    /// the memory held by the metadata cache.
+    /// the memory held by the metadata cache. With a persistent index, the index is
+    /// checkpointed and the backing files are kept instead.
     void ReleaseResources();
 
+    /// Writes the metadata of all entries in the opened backing files to the index
+    /// file, after syncing the backing files. The index is replaced atomically.
+    Status Checkpoint();
+
     /// Looks up in the meta-data cache with key 'cache_key'. If found, try copying
     /// 'bytes_to_read' bytes from the backing file into 'buffer'. If trace_replay
     /// is enabled, the buffer is null and no bytes are copied. Returns number
     /// of bytes read from the cache. Returns 0 if there is a cache miss.
-    int64_t Lookup(const CacheKey& cache_key, int64_t bytes_to_read, uint8_t* buffer);
+    /// If 'entry_len' is not NULL, it is set to the length of the entry on a hit.
+    int64_t Lookup(const CacheKey& cache_key, int64_t bytes_to_read, uint8_t* buffer,
+        int64_t* entry_len = nullptr);
 
     /// Inserts a entry with key 'cache_key' and data in 'buffer' into the cache.
     /// 'buffer' is nullptr for trace replay. 'buffer_len' is the length of buffer.
@@ -291,6 +376,19 @@ class DataCache {
     /// The prefix of the names of the cache backing files.
     static const char* CACHE_FILE_PREFIX;
 
+    /// The name of the persisted index file.
+    static const char* INDEX_FILE_NAME;
+
+    /// Number of partitions in the cache.
+    const int num_partitions_;
+
+    /// True if the index is persisted. See --data_cache_persistent_index.
+    const bool persistent_index_;
+
+    /// Serializes checkpoints, which may be taken by the checkpoint thread and on
+    /// shutdown at the same time.
+    std::mutex checkpoint_lock_;
+
     /// Protects the following fields.
     SpinLock lock_;
 
@@ -302,6 +400,10 @@ class DataCache {
     /// 'lock_' held.
     std::vector<std::unique_ptr<CacheFile>> cache_files_;
 
+    /// Paths of the backing files of previous processes that are left for
+    /// DeleteStaleFiles(). Only accessed by Init() and then by DeleteStaleFiles().
+    std::vector<std::string> stale_files_;
+
     /// This set tracks cache keys of entries in progress of being inserted into the
     /// cache. As we don't hold locks while writing to the backing file, this set is
     /// used to prevent multiple insertion into the cache with the same cache key.
@@ -336,9 +438,21 @@ class DataCache {
     /// error on failure.
     Status CreateCacheFile();
 
-    /// Utility function to delete cache files left over from previous runs of Impala.
-    /// Returns error on failure.
-    Status DeleteExistingFiles() const;
+    /// Utility function to delete cache files left over from previous runs of Impala,
+    /// except for the files in 'cache_files_'. With
+    /// --data_cache_async_delete_stale_files, the files are only added to 'stale_files_'
+    /// and 'stale_bytes' is set to the disk space they use. Returns error on failure.
+    Status DeleteExistingFiles(int64_t* stale_bytes);
+
+    /// Reloads the entries of the persisted index and opens their backing files. Entries
+    /// whose backing file ranges are not valid anymore are dropped. Sets 'loaded_bytes'
+    /// to the charge of the reloaded entries. Returns an error if there is no index or it
+    /// is corrupt, in which case nothing is reloaded. 'lock_' must be held.
+    Status LoadIndex(int64_t* loaded_bytes);
+
+    /// Inserts 'entry' reloaded from the persisted index with key 'key' into the cache.
+    /// Returns false if it was not inserted.
+    bool InsertLoadedEntry(const kudu::Slice& key, const CacheEntry& entry);
 
     /// Utility function for computing the checksum of 'buffer' with length 'buffer_len'.
     static uint64_t Checksum(const uint8_t* buffer, int64_t buffer_len);
@@ -390,6 +504,12 @@ class DataCache {
   /// The set of all cache partitions.
   std::vector<std::unique_ptr<Partition>> partitions_;
 
+  /// The optional memory tier in front of 'partitions_'. NULL if disabled.
+  std::unique_ptr<MemoryTier> memory_tier_;
+
+  /// Stores 'buffer' with key 'key' in the partition the key hashes to. See Store().
+  bool StoreInPartition(const CacheKey& key, const uint8_t* buffer, int64_t buffer_len);
+
   /// Thread pool for deleting old files from partitions to keep the number of opened
   /// files within --date_cache_max_opened_files. This allows deletion requests
   /// to be queued for deferred processing. There is only one thread in this pool.
@@ -399,6 +519,24 @@ class DataCache {
   /// in partitions_[partition_idx].
   void DeleteOldFiles(uint32_t thread_id, int partition_idx);
 
+  /// Thread which checkpoints the partitions every
+  /// --data_cache_index_checkpoint_interval_s seconds. Only started if
+  /// --data_cache_persistent_index is set.
+  std::unique_ptr<Thread> checkpoint_thread_;
+
+  /// Set to stop 'checkpoint_thread_'.
+  Promise<bool> checkpoint_thread_shutdown_;
+
+  /// Thread function of 'checkpoint_thread_'.
+  void CheckpointThread();
+
+  /// Thread which deletes the stale backing files of the partitions after Init(). Only
+  /// started if --data_cache_async_delete_stale_files is set.
+  std::unique_ptr<Thread> stale_file_deleter_thread_;
+
+  /// Set to stop 'stale_file_deleter_thread_'.
+  std::atomic<bool> stale_file_deleter_shut_down_{false};
+
 };
 
 } // namespace io
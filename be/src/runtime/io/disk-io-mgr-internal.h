@@ -28,7 +28,9 @@
 #include "util/condition-variable.h"
 #include "util/hdfs-util.h"
 #include "util/impalad-metrics.h"
+#include "util/lock-contention.h"
 #include "util/runtime-profile-counters.h"
+#include "util/time.h"
 
 /// This file contains internal structures shared between submodules of the IoMgr. Users
 /// of the IoMgr do not need to include this file.
@@ -60,8 +62,13 @@ static inline bool is_file_handle_caching_enabled() {
 }
 
 /// Global queue of requests for a disk. One or more disk threads pull requests off
-/// a given queue. RequestContexts are scheduled in round-robin order to provide some
-/// level of fairness between RequestContexts.
+/// a given queue. RequestContexts are scheduled with deficit round robin to share the
+/// disk between them in proportion to their I/O weights: each context has a deficit of
+/// bytes that it may read or write on this disk. A context with a positive deficit at
+/// the front of the queue is served, which charges it for the size of the request, and
+/// stays at the front. Otherwise the context gets a quantum of its weight times the max
+/// buffer size and moves to the back of the queue. With equal weights, this is the
+/// same as round robin between contexts that issue max-sized reads.
 class DiskQueue {
  public:
   DiskQueue(int disk_id) : disk_id_(disk_id) {}
@@ -74,14 +81,31 @@ class DiskQueue {
   /// of Range. There can be multiple threads per disk running this loop.
   void DiskThreadLoop(DiskIoMgr* io_mgr);
 
-  /// Enqueue the request context to the disk queue.
+  /// Disk worker thread loop used for local disks if --disk_io_uring_queue_depth > 0.
+  /// Instead of one blocking read at a time, it issues the reads of up to that many
+  /// ranges through an io_uring and processes them as they complete. Ranges that
+  /// cannot be read asynchronously, e.g. writes, are processed like in
+  /// DiskThreadLoop(). Falls back to DiskThreadLoop() if io_uring is not available.
+  void IoUringThreadLoop(DiskIoMgr* io_mgr);
+
+  /// Enqueue the request context to the disk queue. A context which still has a
+  /// positive deficit goes to the front, since it was just served and its turn is not
+  /// over yet.
   void EnqueueContext(RequestContext* worker) {
     {
-      std::unique_lock<std::mutex> disk_lock(lock_);
+      std::unique_lock<std::mutex> disk_lock(lock_, std::defer_lock);
+      LockContention::Lock(&disk_lock, LockContention::DISK_QUEUE);
       // Check that the reader is not already on the queue
-      DCHECK(find(request_contexts_.begin(), request_contexts_.end(), worker) ==
-          request_contexts_.end());
-      request_contexts_.push_back(worker);
+      DCHECK(std::find_if(request_contexts_.begin(), request_contexts_.end(),
+          [worker](const QueuedContext& c) { return c.context == worker; })
+          == request_contexts_.end());
+      QueuedContext queued{worker, MonotonicNanos()};
+      if (worker->io_deficit(disk_id_) > 0) {
+        request_contexts_.push_front(queued);
+      } else {
+        request_contexts_.push_back(queued);
+      }
+      if (queue_depth_ != nullptr) queue_depth_->SetValue(request_contexts_.size());
     }
     work_available_.NotifyAll();
   }
@@ -113,19 +137,52 @@ class DiskQueue {
     DCHECK(write_io_err_ == nullptr);
     write_io_err_ = write_io_err;
   }
+  void set_queue_wait(HistogramMetric* queue_wait) {
+    DCHECK(queue_wait_ == nullptr);
+    queue_wait_ = queue_wait;
+  }
+  void set_queue_depth(IntGauge* queue_depth) {
+    DCHECK(queue_depth_ == nullptr);
+    queue_depth_ = queue_depth;
+  }
 
   HistogramMetric* read_latency() const { return read_latency_; }
   HistogramMetric* read_size() const { return read_size_; }
   HistogramMetric* write_latency() const { return write_latency_; }
   HistogramMetric* write_size() const { return write_size_; }
   IntCounter* write_io_err() const { return write_io_err_; }
+  HistogramMetric* queue_wait() const { return queue_wait_; }
+  IntGauge* queue_depth() const { return queue_depth_; }
 
  private:
   /// Called from the disk thread to get the next range to process. Wait until a scan
   /// is available to process, a write range is available, or 'shut_down_' is set to
   /// true. Returns the range to process and the RequestContext that the range belongs
   /// to. Only returns NULL if the disk thread should be shut down.
-  RequestRange* GetNextRequestRange(RequestContext** request_context);
+  /// If 'wait' is false, returns NULL instead of waiting if there is no work.
+  RequestRange* GetNextRequestRange(RequestContext** request_context, bool wait = true);
+
+  /// Reads or writes 'range' of 'worker_context' with blocking calls.
+  void ProcessRequestRange(RequestContext* worker_context, RequestRange* range);
+
+  /// A read issued by IoUringThreadLoop().
+  struct AsyncReadRequest {
+    RequestContext* context = nullptr;
+    /// The range being read. NULL if the request is not in use.
+    ScanRange* range = nullptr;
+    ScanRange::AsyncRead read;
+    int64_t start_time = 0;
+  };
+
+  /// Completes 'read'. If 'status' is an error, the read failed.
+  void FinishAsyncRead(AsyncReadRequest* read, const Status& status);
+
+  /// A context on the queue.
+  struct QueuedContext {
+    RequestContext* context;
+    /// The time at which the context was enqueued, from MonotonicNanos().
+    int64_t enqueue_time;
+  };
 
   /// Disk id (0-based)
   const int disk_id_;
@@ -145,6 +202,12 @@ class DiskQueue {
   /// Metric that tracks write io errors for this queue.
   IntCounter* write_io_err_ = nullptr;
 
+  /// Metric that tracks the time that contexts wait on this queue.
+  HistogramMetric* queue_wait_ = nullptr;
+
+  /// Metric that tracks the number of contexts on this queue.
+  IntGauge* queue_depth_ = nullptr;
+
   /// Lock that protects below members.
   std::mutex lock_;
 
@@ -155,7 +218,7 @@ class DiskQueue {
   ConditionVariable work_available_;
 
   /// list of all request contexts that have work queued on this disk
-  std::list<RequestContext*> request_contexts_;
+  std::list<QueuedContext> request_contexts_;
 
   /// True if the IoMgr should be torn down. Worker threads check this when dequeueing
   /// from 'request_contexts_' and terminate themselves once it is true. Only used in
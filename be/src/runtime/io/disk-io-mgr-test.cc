@@ -26,6 +26,7 @@
 #include "runtime/io/disk-io-mgr-internal.h"
 #include "runtime/io/disk-io-mgr-stress.h"
 #include "runtime/io/disk-io-mgr.h"
+#include "runtime/io/file-reader.h"
 #include "runtime/io/local-file-system-with-fault-injection.h"
 #include "runtime/io/request-context.h"
 #include "runtime/test-env.h"
@@ -57,6 +58,11 @@ DECLARE_int32(num_ozone_io_threads);
 DECLARE_int32(num_oss_io_threads);
 DECLARE_int32(num_remote_hdfs_file_oper_io_threads);
 DECLARE_int32(num_s3_file_oper_io_threads);
+DECLARE_int32(disk_io_uring_queue_depth);
+DECLARE_bool(adaptive_scan_range_read_ahead);
+DECLARE_int32(max_parallel_remote_reads_per_range);
+DECLARE_int64(min_parallel_remote_read_range_bytes);
+DECLARE_bool(parallel_local_reads_for_testing);
 
 #ifndef NDEBUG
 DECLARE_int32(stress_disk_read_delay_ms);
@@ -83,6 +89,73 @@ namespace io {
 static Status CONTEXT_CANCELLED_STATUS =
     Status::CancelledInternal("IoMgr RequestContext");
 
+/// File reader for the tests of parallel reads. Serves reads from 'data', delays the
+/// read at 'slow_offset' by SLOW_READ_MS and fails the read at 'fail_offset'. Records
+/// the offsets of the reads in the order in which they finished.
+class ParallelReadTestStub : public FileReader {
+ public:
+  static const int SLOW_READ_MS = 200;
+
+  ParallelReadTestStub(ScanRange* scan_range, const string* data,
+      int64_t slow_offset = -1, int64_t fail_offset = -1)
+    : FileReader(scan_range),
+      data_(data),
+      slow_offset_(slow_offset),
+      fail_offset_(fail_offset) {}
+
+  virtual Status Open(bool use_file_handle_cache) override { return Status::OK(); }
+
+  virtual Status ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_t* buffer,
+      int64_t bytes_to_read, int64_t* bytes_read, bool* eof) override {
+    {
+      lock_guard<mutex> l(stub_lock_);
+      ++num_reads_in_flight_;
+      max_reads_in_flight_ = max(max_reads_in_flight_, num_reads_in_flight_);
+    }
+    if (file_offset == slow_offset_) SleepForMs(SLOW_READ_MS);
+    Status status;
+    if (file_offset == fail_offset_) {
+      *bytes_read = 0;
+      status = Status("Injected read failure");
+    } else {
+      *bytes_read = min<int64_t>(bytes_to_read, data_->size() - file_offset);
+      memcpy(buffer, data_->data() + file_offset, *bytes_read);
+      *eof = *bytes_read < bytes_to_read;
+    }
+    lock_guard<mutex> l(stub_lock_);
+    --num_reads_in_flight_;
+    finished_offsets_.push_back(file_offset);
+    return status;
+  }
+
+  virtual void CachedFile(uint8_t** data, int64_t* length) override {
+    *data = nullptr;
+    *length = 0;
+  }
+
+  virtual void Close() override {}
+
+  int max_reads_in_flight() {
+    lock_guard<mutex> l(stub_lock_);
+    return max_reads_in_flight_;
+  }
+
+  vector<int64_t> finished_offsets() {
+    lock_guard<mutex> l(stub_lock_);
+    return finished_offsets_;
+  }
+
+ private:
+  const string* const data_;
+  const int64_t slow_offset_;
+  const int64_t fail_offset_;
+
+  mutex stub_lock_;
+  int num_reads_in_flight_ = 0;
+  int max_reads_in_flight_ = 0;
+  vector<int64_t> finished_offsets_;
+};
+
 class DiskIoMgrTest : public testing::Test {
  public:
   virtual void SetUp() {
@@ -294,6 +367,10 @@ class DiskIoMgrTest : public testing::Test {
     scan_range->SetFileReader(move(reader_stub));
   }
 
+  static int MaxParallelReads(ScanRange* scan_range) {
+    return scan_range->max_parallel_reads_;
+  }
+
   ScanRange* InitRange(ObjectPool* pool, const char* file_path, int offset, int len,
       int disk_id, int64_t mtime, void* meta_data = nullptr, bool is_hdfs_cached = false,
       std::vector<ScanRange::SubRange> sub_ranges = {}) {
@@ -741,6 +818,23 @@ TEST_F(DiskIoMgrTest, SingleReader) {
   SingleReaderTestBody(data, data);
 }
 
+// Same as SingleReader, but the disk threads read through io_uring. If the kernel does
+// not support io_uring, the disk threads fall back to blocking reads.
+TEST_F(DiskIoMgrTest, SingleReaderIoUring) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  auto s = ScopedFlagSetter<int32_t>::Make(&FLAGS_disk_io_uring_queue_depth, 4);
+  const char* data = "abcdefghijklm";
+  SingleReaderTestBody(data, data);
+}
+
+// Same as SingleReader, but the scan ranges adapt their read-ahead depth.
+TEST_F(DiskIoMgrTest, SingleReaderAdaptiveReadAhead) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  auto s = ScopedFlagSetter<bool>::Make(&FLAGS_adaptive_scan_range_read_ahead, true);
+  const char* data = "abcdefghijklm";
+  SingleReaderTestBody(data, data);
+}
+
 TEST_F(DiskIoMgrTest, SingleReaderSubRanges) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
   const char* data = "abcdefghijklm";
@@ -1328,6 +1422,84 @@ TEST_F(DiskIoMgrTest, MultipleReader) {
   EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
 }
 
+// Readers with different I/O weights share the disk queues. Every reader must read all
+// of its data, and the waits of the readers on the queues are recorded in the queue
+// delay histogram of their pool, in the queue wait histograms of the disk queues and
+// in the queue counters of each reader.
+TEST_F(DiskIoMgrTest, WeightedReaders) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  const int NUM_READERS = 3;
+  const int DATA_LEN = 50;
+  const char* tmp_file = "/tmp/disk_io_mgr_test.txt";
+  const char* data = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwx";
+  CreateTempFile(tmp_file, data);
+  struct stat stat_val;
+  stat(tmp_file, &stat_val);
+
+  for (int threads_per_disk = 1; threads_per_disk <= 3; ++threads_per_disk) {
+    ObjectPool tmp_pool;
+    DiskIoMgr io_mgr(2, threads_per_disk, threads_per_disk, MIN_BUFFER_SIZE,
+        MAX_BUFFER_SIZE);
+    ASSERT_OK(io_mgr.Init());
+    HistogramMetric* queue_delay = io_mgr.GetPoolQueueDelayMetric("weighted-pool");
+    ASSERT_TRUE(queue_delay != nullptr);
+    EXPECT_EQ(queue_delay, io_mgr.GetPoolQueueDelayMetric("weighted-pool"));
+    queue_delay->Reset();
+    HistogramMetric* queue_wait =
+        ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<HistogramMetric>(
+            "impala-server.io-mgr.queue-0.queue-wait");
+    ASSERT_TRUE(queue_wait != nullptr);
+    const uint64_t initial_queue_waits = queue_wait->TotalCount();
+    RuntimeProfile* profile = RuntimeProfile::Create(&tmp_pool, "weighted-readers");
+    vector<RuntimeProfile::SummaryStatsCounter*> queue_wait_counters(NUM_READERS);
+    vector<RuntimeProfile::SummaryStatsCounter*> queue_depth_counters(NUM_READERS);
+
+    unique_ptr<BufferPool::ClientHandle[]> clients(
+        new BufferPool::ClientHandle[NUM_READERS]);
+    vector<unique_ptr<RequestContext>> readers(NUM_READERS);
+    for (int i = 0; i < NUM_READERS; ++i) {
+      RegisterBufferPoolClient(
+          LARGE_RESERVATION_LIMIT, LARGE_INITIAL_RESERVATION, &clients[i]);
+      readers[i] = io_mgr.RegisterContext();
+      readers[i]->set_io_weight(1 + 3 * i);
+      readers[i]->set_queue_delay_metric(queue_delay);
+      queue_wait_counters[i] = profile->AddSummaryStatsCounter(
+          Substitute("QueueWait$0", i), TUnit::TIME_NS);
+      queue_depth_counters[i] = profile->AddSummaryStatsCounter(
+          Substitute("QueueDepth$0", i), TUnit::UNIT);
+      readers[i]->set_queue_wait_counter(queue_wait_counters[i]);
+      readers[i]->set_queue_depth_counter(queue_depth_counters[i]);
+      vector<ScanRange*> ranges;
+      for (int j = 0; j < DATA_LEN; ++j) {
+        ranges.push_back(
+            InitRange(&tmp_pool, tmp_file, j, 1, j % 2, stat_val.st_mtime));
+      }
+      ASSERT_OK(readers[i]->AddScanRanges(ranges, EnqueueLocation::TAIL));
+    }
+
+    AtomicInt32 num_ranges_processed;
+    thread_group threads;
+    for (int i = 0; i < NUM_READERS; ++i) {
+      threads.add_thread(new thread(ScanRangeThread, &io_mgr, readers[i].get(),
+          &clients[i], data, DATA_LEN, Status::OK(), 0, &num_ranges_processed));
+    }
+    threads.join_all();
+    EXPECT_EQ(num_ranges_processed.Load(), DATA_LEN * NUM_READERS);
+    EXPECT_GE(queue_delay->TotalCount(), DATA_LEN * NUM_READERS);
+    EXPECT_GT(queue_wait->TotalCount(), initial_queue_waits);
+    for (int i = 0; i < NUM_READERS; ++i) {
+      EXPECT_GE(queue_wait_counters[i]->TotalNumValues(), DATA_LEN);
+      EXPECT_GE(queue_depth_counters[i]->MinValue(), 1);
+      EXPECT_LE(queue_depth_counters[i]->MaxValue(), NUM_READERS);
+    }
+    for (int i = 0; i < NUM_READERS; ++i) {
+      io_mgr.UnregisterContext(readers[i].get());
+      buffer_pool()->DeregisterClient(&clients[i]);
+    }
+  }
+  EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
+}
+
 // Stress test for multiple clients with cancellation
 // TODO: the stress app should be expanded to include sync reads and adding scan
 // ranges in the middle.
@@ -1337,6 +1509,22 @@ TEST_F(DiskIoMgrTest, StressTest) {
   test.Run(2); // In seconds
 }
 
+// Same as StressTest, but with reads through io_uring, to compare with the blocking
+// reads.
+TEST_F(DiskIoMgrTest, StressTestIoUring) {
+  auto s = ScopedFlagSetter<int32_t>::Make(&FLAGS_disk_io_uring_queue_depth, 8);
+  DiskIoMgrStress test(5, 5, 10, true);
+  test.Run(2); // In seconds
+}
+
+// Same as StressTest, but the scan ranges adapt their read-ahead depth. Cancellation
+// must also clean up ranges that are blocked on their read-ahead depth.
+TEST_F(DiskIoMgrTest, StressTestAdaptiveReadAhead) {
+  auto s = ScopedFlagSetter<bool>::Make(&FLAGS_adaptive_scan_range_read_ahead, true);
+  DiskIoMgrStress test(5, 5, 10, true);
+  test.Run(2); // In seconds
+}
+
 // IMPALA-2366: handle partial read where range goes past end of file.
 TEST_F(DiskIoMgrTest, PartialRead) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
@@ -1613,6 +1801,39 @@ TEST_F(DiskIoMgrTest, ReadIntoClientBuffer) {
   EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
 }
 
+// Test that a range with a preloaded client buffer returns the buffer without reading
+// the file, which does not exist.
+TEST_F(DiskIoMgrTest, PreloadedClientBuffer) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  const char* tmp_file = "/tmp/disk_io_mgr_test_preloaded_missing.txt";
+  const char* data = "the quick brown fox jumped over the lazy dog";
+  int len = strlen(data);
+  remove(tmp_file);
+
+  scoped_ptr<DiskIoMgr> io_mgr(new DiskIoMgr(1, 1, 1, 4, 4));
+  ASSERT_OK(io_mgr->Init());
+  unique_ptr<RequestContext> reader = io_mgr->RegisterContext();
+
+  vector<uint8_t> client_buffer(data, data + len);
+  ScanRange* range = pool_.Add(new ScanRange);
+  range->Reset(nullptr, tmp_file, len, 0, 0, true, ScanRange::INVALID_MTIME,
+      BufferOpts::Preloaded(client_buffer.data(), len));
+  bool needs_buffers;
+  ASSERT_OK(reader->StartScanRange(range, &needs_buffers));
+  ASSERT_FALSE(needs_buffers);
+
+  unique_ptr<BufferDescriptor> io_buffer;
+  ASSERT_OK(range->GetNext(&io_buffer));
+  ASSERT_TRUE(io_buffer->eosr());
+  ASSERT_EQ(len, io_buffer->len());
+  ASSERT_EQ(client_buffer.data(), io_buffer->buffer());
+  EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
+  range->ReturnBuffer(move(io_buffer));
+
+  io_mgr->UnregisterContext(reader.get());
+  EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
+}
+
 // Test reading into a client-allocated buffer using sub-ranges.
 TEST_F(DiskIoMgrTest, ReadIntoClientBufferSubRanges) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
@@ -1671,6 +1892,51 @@ TEST_F(DiskIoMgrTest, ReadIntoClientBufferSubRanges) {
   EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
 }
 
+// Sub-ranges that are read into one buffer are read with FileReader::ReadVectored().
+// Test sub-ranges with gaps that are merged into one read and gaps that are not.
+TEST_F(DiskIoMgrTest, ReadIntoClientBufferVectored) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  const char* tmp_file = "/tmp/disk_io_mgr_test.txt";
+  const int64_t MAX_GAP = FileReader::MAX_VECTORED_READ_GAP;
+  const int64_t data_len = 3 * MAX_GAP;
+  vector<uint8_t> data(data_len);
+  for (int64_t i = 0; i < data_len; ++i) data[i] = i % 251;
+  CreateTempFile(tmp_file, reinterpret_cast<const char*>(data.data()), data_len);
+  struct stat stat_val;
+  stat(tmp_file, &stat_val);
+
+  scoped_ptr<DiskIoMgr> io_mgr(new DiskIoMgr(1, 1, 1, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE));
+  ASSERT_OK(io_mgr->Init());
+  unique_ptr<RequestContext> reader = io_mgr->RegisterContext();
+
+  vector<ScanRange::SubRange> sub_ranges = {{0, 10}, {20, 10}, {MAX_GAP, 100},
+      {2 * MAX_GAP + 200, 100}, {data_len - 10, 10}};
+  vector<uint8_t> expected_result;
+  for (const ScanRange::SubRange& sub_range : sub_ranges) {
+    expected_result.insert(expected_result.end(), data.begin() + sub_range.offset,
+        data.begin() + sub_range.offset + sub_range.length);
+  }
+  const int64_t result_len = expected_result.size();
+  vector<uint8_t> client_buffer(result_len);
+  ScanRange* range = pool_.Add(new ScanRange);
+  range->Reset(nullptr, tmp_file, data_len, 0, 0, true, stat_val.st_mtime,
+      BufferOpts::ReadInto(client_buffer.data(), result_len, BufferOpts::NO_CACHING),
+      move(sub_ranges));
+  bool needs_buffers;
+  ASSERT_OK(reader->StartScanRange(range, &needs_buffers));
+  ASSERT_FALSE(needs_buffers);
+
+  unique_ptr<BufferDescriptor> io_buffer;
+  ASSERT_OK(range->GetNext(&io_buffer));
+  ASSERT_TRUE(io_buffer->eosr());
+  ASSERT_EQ(result_len, io_buffer->len());
+  ASSERT_EQ(memcmp(io_buffer->buffer(), expected_result.data(), result_len), 0);
+  range->ReturnBuffer(move(io_buffer));
+
+  io_mgr->UnregisterContext(reader.get());
+  EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
+}
+
 // Test reading into a client-allocated buffer where the read fails.
 TEST_F(DiskIoMgrTest, ReadIntoClientBufferError) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
@@ -1712,6 +1978,151 @@ TEST_F(DiskIoMgrTest, ReadIntoClientBufferError) {
   EXPECT_EQ(root_reservation_.GetChildReservations(), 0);
 }
 
+// Tests of parallel reads of a single scan range, which are only done for large ranges
+// of S3 and ABFS files outside of tests.
+const int PARALLEL_READ_DISK_THREADS = 4;
+const int PARALLEL_READ_BUFFERS = 4;
+const int PARALLEL_READ_DATA_LEN = 10 * MAX_BUFFER_SIZE + 17;
+
+class DiskIoMgrParallelReadTest : public DiskIoMgrTest {
+ protected:
+  virtual void SetUp() override {
+    DiskIoMgrTest::SetUp();
+    InitRootReservation(LARGE_RESERVATION_LIMIT);
+    for (int i = 0; i < PARALLEL_READ_DATA_LEN; ++i) data_.push_back('a' + i % 26);
+    CreateTempFile(tmp_file_, data_.data(), data_.size());
+    struct stat stat_val;
+    stat(tmp_file_, &stat_val);
+    mtime_ = stat_val.st_mtime;
+    io_mgr_.reset(new DiskIoMgr(1, PARALLEL_READ_DISK_THREADS,
+        PARALLEL_READ_DISK_THREADS, MIN_BUFFER_SIZE, MAX_BUFFER_SIZE));
+    ASSERT_OK(io_mgr_->Init());
+    RegisterBufferPoolClient(
+        LARGE_RESERVATION_LIMIT, LARGE_INITIAL_RESERVATION, &read_client_);
+    reader_ = io_mgr_->RegisterContext();
+  }
+
+  virtual void TearDown() override {
+    io_mgr_->UnregisterContext(reader_.get());
+    EXPECT_EQ(0, read_client_.GetUsedReservation());
+    buffer_pool()->DeregisterClient(&read_client_);
+    io_mgr_.reset();
+    EXPECT_EQ(0, root_reservation_.GetChildReservations());
+    DiskIoMgrTest::TearDown();
+  }
+
+  /// Starts a range over the whole file with PARALLEL_READ_BUFFERS buffers. If 'stub'
+  /// is not nullptr, the range reads through a ParallelReadTestStub created with
+  /// 'slow_offset' and 'fail_offset', which '*stub' is set to.
+  ScanRange* StartRange(ParallelReadTestStub** stub = nullptr,
+      int64_t slow_offset = -1, int64_t fail_offset = -1) {
+    ScanRange* range = InitRange(&pool_, tmp_file_, 0, PARALLEL_READ_DATA_LEN, 0, mtime_);
+    if (stub != nullptr) {
+      *stub = new ParallelReadTestStub(range, &data_, slow_offset, fail_offset);
+      SetReaderStub(range, unique_ptr<FileReader>(*stub));
+    }
+    bool needs_buffers;
+    EXPECT_OK(reader_->StartScanRange(range, &needs_buffers));
+    EXPECT_TRUE(needs_buffers);
+    EXPECT_EQ(PARALLEL_READ_BUFFERS, MaxParallelReads(range));
+    EXPECT_OK(io_mgr_->AllocateBuffersForRange(
+        &read_client_, range, PARALLEL_READ_BUFFERS * MAX_BUFFER_SIZE));
+    return range;
+  }
+
+  /// Reads 'range' to the end and checks that the buffers contain the file in order.
+  void ValidateRange(ScanRange* range) {
+    int64_t offset = 0;
+    while (true) {
+      unique_ptr<BufferDescriptor> buffer;
+      ASSERT_OK(range->GetNext(&buffer));
+      ASSERT_TRUE(buffer != nullptr);
+      ASSERT_LE(offset + buffer->len(), PARALLEL_READ_DATA_LEN);
+      EXPECT_EQ(0, memcmp(data_.data() + offset, buffer->buffer(), buffer->len()))
+          << "offset " << offset;
+      offset += buffer->len();
+      bool eosr = buffer->eosr();
+      range->ReturnBuffer(move(buffer));
+      if (eosr) break;
+    }
+    EXPECT_EQ(PARALLEL_READ_DATA_LEN, offset);
+  }
+
+  const char* tmp_file_ = "/tmp/disk_io_mgr_parallel_read_test.txt";
+  string data_;
+  int64_t mtime_ = 0;
+  scoped_ptr<DiskIoMgr> io_mgr_;
+  unique_ptr<RequestContext> reader_;
+  BufferPool::ClientHandle read_client_;
+
+  ScopedFlagSetter<bool> parallel_local_reads_ =
+      ScopedFlagSetter<bool>::Make(&FLAGS_parallel_local_reads_for_testing, true);
+  ScopedFlagSetter<int32_t> max_parallel_reads_ = ScopedFlagSetter<int32_t>::Make(
+      &FLAGS_max_parallel_remote_reads_per_range, PARALLEL_READ_BUFFERS);
+  ScopedFlagSetter<int64_t> min_parallel_read_bytes_ = ScopedFlagSetter<int64_t>::Make(
+      &FLAGS_min_parallel_remote_read_range_bytes, MAX_BUFFER_SIZE);
+};
+
+// Reads of a local file complete in any order, but the buffers are returned in file
+// order. Once the last read queued the EOSR buffer, the other disk threads may still
+// find the range queued again by an earlier read, which must not be processed twice.
+TEST_F(DiskIoMgrParallelReadTest, LocalFile) {
+  for (int i = 0; i < 50; ++i) {
+    ScanRange* range = StartRange();
+    ValidateRange(range);
+  }
+}
+
+// The first read is slower than the other ones, so the buffers after it are read first
+// and held back until it finishes.
+TEST_F(DiskIoMgrParallelReadTest, OutOfOrderCompletion) {
+  ParallelReadTestStub* stub;
+  ScanRange* range = StartRange(&stub, 0);
+  ValidateRange(range);
+  EXPECT_GT(stub->max_reads_in_flight(), 1);
+  vector<int64_t> finished_offsets = stub->finished_offsets();
+  ASSERT_FALSE(finished_offsets.empty());
+  EXPECT_NE(0, finished_offsets[0]);
+}
+
+// Cancelling the range waits for all reads in flight and releases all buffers.
+TEST_F(DiskIoMgrParallelReadTest, CancelWithReadsInFlight) {
+  ParallelReadTestStub* stub;
+  ScanRange* range = StartRange(&stub, 0);
+  // Let the reads after the slow one finish, so that their buffers are held back.
+  while (stub->finished_offsets().size() < PARALLEL_READ_BUFFERS - 1) SleepForMs(1);
+  range->Cancel(Status::CancelledInternal("ParallelReadTest"));
+  EXPECT_EQ(0, read_client_.GetUsedReservation());
+  unique_ptr<BufferDescriptor> buffer;
+  Status status = range->GetNext(&buffer);
+  EXPECT_TRUE(status.IsCancelled()) << status.GetDetail();
+  EXPECT_TRUE(buffer == nullptr);
+}
+
+// The error of one failed read is returned once the buffers before it were consumed,
+// while the other reads of the range finish and clean up their buffers.
+TEST_F(DiskIoMgrParallelReadTest, OneReadFails) {
+  ParallelReadTestStub* stub;
+  const int64_t fail_offset = 2 * MAX_BUFFER_SIZE;
+  ScanRange* range = StartRange(&stub, 0, fail_offset);
+  int64_t offset = 0;
+  Status status;
+  while (true) {
+    unique_ptr<BufferDescriptor> buffer;
+    status = range->GetNext(&buffer);
+    if (!status.ok()) break;
+    ASSERT_TRUE(buffer != nullptr);
+    EXPECT_EQ(0, memcmp(data_.data() + offset, buffer->buffer(), buffer->len()));
+    offset += buffer->len();
+    ASSERT_FALSE(buffer->eosr());
+    range->ReturnBuffer(move(buffer));
+  }
+  EXPECT_EQ("Injected read failure", status.GetDetail().substr(0, 21));
+  EXPECT_LE(offset, fail_offset);
+  range->Cancel(status);
+  EXPECT_EQ(0, read_client_.GetUsedReservation());
+}
+
 // Test to verify configuration parameters for number of I/O threads per disk.
 TEST_F(DiskIoMgrTest, VerifyNumThreadsParameter) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
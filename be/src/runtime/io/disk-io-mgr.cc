@@ -28,6 +28,7 @@
 #include "runtime/io/error-converter.h"
 #include "runtime/io/file-writer.h"
 #include "runtime/io/handle-cache.inline.h"
+#include "runtime/io/io-uring.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
@@ -100,6 +101,20 @@ static const string num_io_threads_per_solid_state_disk_help_msg = Substitute("N
 DEFINE_int32(num_io_threads_per_solid_state_disk, 0,
     num_io_threads_per_solid_state_disk_help_msg.c_str());
 
+// If > 0, the local disk queues issue reads through io_uring instead of doing blocking
+// reads, so that each disk thread keeps up to this many reads in flight. Requires Linux
+// 5.1 or newer; falls back to blocking reads if io_uring can not be set up.
+DEFINE_int32(disk_io_uring_queue_depth, 0, "If greater than 0, local disk I/O threads "
+    "submit reads of local files through io_uring with up to this many reads in flight "
+    "per thread, instead of one blocking read per thread. Writes are still done with "
+    "blocking calls.");
+
+// Since every thread has multiple reads in flight with io_uring, far fewer threads than
+// with blocking reads are needed to saturate a disk.
+DEFINE_int32(num_io_uring_threads_per_disk, 1, "Number of I/O threads per local disk "
+    "if --disk_io_uring_queue_depth is set. Replaces the number of threads per "
+    "rotational and solid state disk.");
+
 // The maximum number of remote HDFS I/O threads.  HDFS access that are expected to be
 // remote are placed on a separate remote disk queue.  This is the queue depth for that
 // queue.  If 0, then the remote queue is not used and instead ranges are round-robined
@@ -139,6 +154,28 @@ DEFINE_int32(num_gcs_io_threads, 16, "Number of GCS I/O threads");
 // The maximum number of Ozone I/O threads. TODO: choose the default empirically.
 DEFINE_int32(num_ozone_io_threads, 16, "Number of Ozone I/O threads");
 
+// The throughput of a single request to S3 or ABFS is far below that of the network, so
+// large scan ranges on them are read with several concurrent reads on the remote I/O
+// threads. Each read fills one I/O buffer, so a range also can't have more reads in
+// flight than the buffers that the scan's reservation allows for it.
+DEFINE_int32(max_parallel_remote_reads_per_range, 4, "(Advanced) The maximum number of "
+    "concurrent reads of a single scan range on S3 or ABFS. Only used if the file "
+    "handle cache is enabled for the filesystem. 1 disables parallel reads.");
+DEFINE_int64(min_parallel_remote_read_range_bytes, 16L * 1024L * 1024L, "(Advanced) "
+    "The minimum length of scan ranges on S3 or ABFS that are read with concurrent "
+    "reads, see --max_parallel_remote_reads_per_range.");
+DEFINE_bool(parallel_local_reads_for_testing, false, "(Debugging) If true, local scan "
+    "ranges are read with parallel reads like large ranges on S3 and ABFS, see "
+    "--max_parallel_remote_reads_per_range. Only used by tests.");
+
+// Reading far ahead of a slow consumer ties up I/O threads that other ranges could use,
+// while a fast consumer of a high-latency filesystem needs many reads in flight.
+DEFINE_bool(adaptive_scan_range_read_ahead, false, "(Experimental) If true, each scan "
+    "range adapts the number of buffers that it reads ahead of its consumer, within the "
+    "buffers that the scan's reservation allows for it. The depth starts at two buffers, "
+    "doubles whenever the consumer has to wait for a read and decreases by one whenever "
+    "all the buffers read ahead are waiting for the consumer.");
+
 // The number of cached file handles defines how much memory can be used per backend for
 // caching frequently used file handles. Measurements indicate that a single file handle
 // uses about 6kB of memory. 20k file handles will thus reserve ~120MB of memory.
@@ -172,6 +209,13 @@ DEFINE_uint64(unused_file_handle_timeout_sec, 21600, "Maximum time, in seconds,
 DEFINE_uint64(num_file_handle_cache_partitions, 16, "Number of partitions used by the "
     "file handle cache.");
 
+// Opening a file handle on S3 or ABFS can take tens of milliseconds, which the I/O
+// thread otherwise spends idle. The prefetch threads open the handles of the files of
+// newly added scan ranges ahead of time.
+DEFINE_int32(num_file_handle_prefetch_threads, 0, "(Advanced) Number of threads that "
+    "open the cached file handles of the files of newly issued scan ranges in the "
+    "background, so that I/O threads do not wait for the open. Disabled if set to 0.");
+
 // This parameter controls whether remote HDFS file handles are cached. It does not impact
 // S3, ADLS, or ABFS file handles.
 DEFINE_bool(cache_remote_file_handles, true, "Enable the file handle cache for "
@@ -199,6 +243,12 @@ static const char* WRITE_SIZE_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.queue-$0.write-size";
 static const char* WRITE_IO_ERR_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.queue-$0.write-io-error";
+static const char* QUEUE_WAIT_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.queue-$0.queue-wait";
+static const char* QUEUE_DEPTH_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.queue-$0.queue-depth";
+static const char* POOL_QUEUE_DELAY_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.pool-$0.queue-delay";
 
 AtomicInt32 DiskIoMgr::next_disk_id_;
 
@@ -412,7 +462,8 @@ DiskIoMgr::DiskIoMgr() :
     file_handle_cache_(min(FLAGS_max_cached_file_handles,
         FileSystemUtil::MaxNumFileHandles()),
         FLAGS_num_file_handle_cache_partitions,
-        FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_) {
+        FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_,
+        FLAGS_num_file_handle_prefetch_threads) {
   DCHECK_LE(READ_SIZE_MIN_VALUE, FLAGS_read_size);
   int num_local_disks = DiskInfo::num_disks();
   if (FLAGS_num_disks < 0 || FLAGS_num_disks > DiskInfo::num_disks()) {
@@ -436,7 +487,8 @@ DiskIoMgr::DiskIoMgr(int num_local_disks, int threads_per_rotational_disk,
     file_handle_cache_(min(FLAGS_max_cached_file_handles,
         FileSystemUtil::MaxNumFileHandles()),
         FLAGS_num_file_handle_cache_partitions,
-        FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_) {
+        FLAGS_unused_file_handle_timeout_sec, &hdfs_monitor_,
+        FLAGS_num_file_handle_prefetch_threads) {
   if (num_local_disks == 0) num_local_disks = DiskInfo::num_disks();
   disk_queues_.resize(num_local_disks + REMOTE_NUM_DISKS);
   CheckSseSupport();
@@ -459,6 +511,7 @@ Status DiskIoMgr::Init() {
     disk_queues_[i] = new DiskQueue(i);
     int num_threads_per_disk;
     string device_name;
+    bool use_io_uring = false;
     if (i == RemoteDfsDiskId()) {
       num_threads_per_disk = FLAGS_num_remote_hdfs_io_threads;
       device_name = "HDFS remote";
@@ -490,11 +543,21 @@ Status DiskIoMgr::Init() {
       num_threads_per_disk = num_io_threads_per_rotational_disk_;
       // During tests, i may not point to an existing disk.
       device_name = i < DiskInfo::num_disks() ? DiskInfo::device_name(i) : to_string(i);
+      use_io_uring = FLAGS_disk_io_uring_queue_depth > 0;
     } else {
       num_threads_per_disk = num_io_threads_per_solid_state_disk_;
       // During tests, i may not point to an existing disk.
       device_name = i < DiskInfo::num_disks() ? DiskInfo::device_name(i) : to_string(i);
+      use_io_uring = FLAGS_disk_io_uring_queue_depth > 0;
+    }
+#ifndef IMPALA_HAVE_IO_URING
+    if (use_io_uring) {
+      LOG_FIRST_N(WARNING, 1) << "Ignoring --disk_io_uring_queue_depth because this "
+                              << "build does not support io_uring";
+      use_io_uring = false;
     }
+#endif
+    if (use_io_uring) num_threads_per_disk = max(1, FLAGS_num_io_uring_threads_per_disk);
     const string& i_string = Substitute("$0", i);
 
     // Unit tests may create multiple DiskIoMgrs, so we need to avoid re-registering the
@@ -512,6 +575,8 @@ Status DiskIoMgr::Init() {
     HistogramMetric* write_latency = nullptr;
     HistogramMetric* write_size = nullptr;
     IntCounter* write_io_err = nullptr;
+    HistogramMetric* queue_wait = nullptr;
+    IntGauge* queue_depth = nullptr;
 
     if (TestInfo::is_test()) {
       read_latency =
@@ -527,6 +592,10 @@ Status DiskIoMgr::Init() {
           Substitute(WRITE_SIZE_METRIC_KEY_TEMPLATE, i_string));
       write_io_err = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<IntCounter>(
           Substitute(WRITE_IO_ERR_METRIC_KEY_TEMPLATE, i_string));
+      queue_wait = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<HistogramMetric>(
+          Substitute(QUEUE_WAIT_METRIC_KEY_TEMPLATE, i_string));
+      queue_depth = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<IntGauge>(
+          Substitute(QUEUE_DEPTH_METRIC_KEY_TEMPLATE, i_string));
     }
 
     int64_t ONE_HOUR_IN_NS = 60L * 60L * NANOS_PER_SEC;
@@ -554,18 +623,29 @@ Status DiskIoMgr::Init() {
       write_io_err = ImpaladMetrics::IO_MGR_METRICS->RegisterMetric(
           new IntCounter(MetricDefs::Get(WRITE_IO_ERR_METRIC_KEY_TEMPLATE, i_string), 0));
     }
+    if (queue_wait == nullptr) {
+      queue_wait = ImpaladMetrics::IO_MGR_METRICS->RegisterMetric(new HistogramMetric(
+          MetricDefs::Get(QUEUE_WAIT_METRIC_KEY_TEMPLATE, i_string), ONE_HOUR_IN_NS, 3));
+    }
+    if (queue_depth == nullptr) {
+      queue_depth = ImpaladMetrics::IO_MGR_METRICS->RegisterMetric(
+          new IntGauge(MetricDefs::Get(QUEUE_DEPTH_METRIC_KEY_TEMPLATE, i_string), 0));
+    }
 
     disk_queues_[i]->set_read_latency(read_latency);
     disk_queues_[i]->set_read_size(read_size);
     disk_queues_[i]->set_write_latency(write_latency);
     disk_queues_[i]->set_write_size(write_size);
     disk_queues_[i]->set_write_io_err(write_io_err);
+    disk_queues_[i]->set_queue_wait(queue_wait);
+    disk_queues_[i]->set_queue_depth(queue_depth);
 
     for (int j = 0; j < num_threads_per_disk; ++j) {
       stringstream ss;
       ss << "work-loop(Disk: " << device_name << ", Thread: " << j << ")";
       std::unique_ptr<Thread> t;
-      RETURN_IF_ERROR(Thread::Create("disk-io-mgr", ss.str(), &DiskQueue::DiskThreadLoop,
+      RETURN_IF_ERROR(Thread::Create("disk-io-mgr", ss.str(),
+          use_io_uring ? &DiskQueue::IoUringThreadLoop : &DiskQueue::DiskThreadLoop,
           disk_queues_[i], this, &t));
       disk_thread_group_.AddThread(move(t));
     }
@@ -599,6 +679,23 @@ void DiskIoMgr::UnregisterContext(RequestContext* reader) {
   reader->CancelAndMarkInactive();
 }
 
+HistogramMetric* DiskIoMgr::GetPoolQueueDelayMetric(const string& pool) {
+  lock_guard<mutex> l(pool_queue_delay_metrics_lock_);
+  HistogramMetric*& metric = pool_queue_delay_metrics_[pool];
+  if (metric != nullptr) return metric;
+  // Unit tests may create multiple DiskIoMgrs, which share the metrics.
+  if (TestInfo::is_test()) {
+    metric = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<HistogramMetric>(
+        Substitute(POOL_QUEUE_DELAY_METRIC_KEY_TEMPLATE, pool));
+  }
+  if (metric == nullptr) {
+    metric = ImpaladMetrics::IO_MGR_METRICS->RegisterMetric(new HistogramMetric(
+        MetricDefs::Get(POOL_QUEUE_DELAY_METRIC_KEY_TEMPLATE, pool),
+        60L * 60L * NANOS_PER_SEC, 3));
+  }
+  return metric;
+}
+
 Status DiskIoMgr::ValidateScanRange(ScanRange* range) {
   int disk_id = range->disk_id();
   if (disk_id < 0 || disk_id >= disk_queues_.size()) {
@@ -692,29 +789,50 @@ int64_t DiskIoMgr::ComputeIdealBufferReservation(int64_t scan_range_len) {
 //  - A ScanRange with a buffer available, or
 //  - A WriteRange in unstarted_write_ranges_ or
 //  - A RemoteOperRange in unstarted_remote_upload_ranges_
-RequestRange* DiskQueue::GetNextRequestRange(RequestContext** request_context) {
+RequestRange* DiskQueue::GetNextRequestRange(
+    RequestContext** request_context, bool wait) {
   // This loops returns either with work to do or when the disk IoMgr shuts down.
   while (true) {
     *request_context = nullptr;
+    int64_t queue_delay;
+    int64_t queue_depth;
     {
-      unique_lock<mutex> disk_lock(lock_);
-      while (!shut_down_ && request_contexts_.empty()) {
+      unique_lock<mutex> disk_lock(lock_, std::defer_lock);
+      LockContention::Lock(&disk_lock, LockContention::DISK_QUEUE);
+      while (wait && !shut_down_ && request_contexts_.empty()) {
         // wait if there are no readers on the queue
         work_available_.Wait(disk_lock);
       }
       if (shut_down_) break;
+      if (request_contexts_.empty()) return nullptr;
       DCHECK(!request_contexts_.empty());
 
+      // Contexts which used up their deficit get their quantum for the next round and
+      // move to the back. This terminates, since the quantum of a context is at least
+      // as large as the most it can be charged for a request.
+      while (request_contexts_.front().context->io_deficit(disk_id_) <= 0) {
+        RequestContext* context = request_contexts_.front().context;
+        context->AddIoDeficit(
+            disk_id_, context->io_weight() * context->parent_->max_buffer_size());
+        request_contexts_.splice(
+            request_contexts_.end(), request_contexts_, request_contexts_.begin());
+      }
+
       // Get the next reader and remove the reader so that another disk thread
       // can't pick it up. It will be enqueued before issuing the read to HDFS
       // so this is not a big deal (i.e. multiple disk threads can read for the
       // same reader).
-      *request_context = request_contexts_.front();
+      *request_context = request_contexts_.front().context;
+      queue_delay = MonotonicNanos() - request_contexts_.front().enqueue_time;
+      queue_depth = request_contexts_.size();
       request_contexts_.pop_front();
+      if (queue_depth_ != nullptr) queue_depth_->SetValue(request_contexts_.size());
       DCHECK(*request_context != nullptr);
       // Must increment refcount to keep RequestContext after dropping 'disk_lock'
       (*request_context)->IncrementDiskThreadAfterDequeue(disk_id_);
     }
+    if (queue_wait_ != nullptr) queue_wait_->Update(queue_delay);
+    (*request_context)->UpdateQueueStats(queue_delay, queue_depth);
     // Get the next range to process for this reader. If this context does not have a
     // range, rinse and repeat.
     RequestRange* range = (*request_context)->GetNextRequestRange(disk_id_);
@@ -735,48 +853,166 @@ void DiskQueue::DiskThreadLoop(DiskIoMgr* io_mgr) {
       DCHECK(shut_down_);
       return;
     }
-    // We are now working on behalf of a query, so set thread state appropriately.
-    // See also IMPALA-6254 and IMPALA-6417.
-    ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
-        worker_context->instance_id());
-
-    switch (range->request_type()) {
-      case RequestType::READ: {
-        ScanRange* scan_range = static_cast<ScanRange*>(range);
-        ReadOutcome outcome = scan_range->DoRead(this, disk_id_);
+    ProcessRequestRange(worker_context, range);
+  }
+}
+
+void DiskQueue::IoUringThreadLoop(DiskIoMgr* io_mgr) {
+#ifndef IMPALA_HAVE_IO_URING
+  DiskThreadLoop(io_mgr);
+#else
+  IoUring ring;
+  Status status = ring.Init(FLAGS_disk_io_uring_queue_depth);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not set up io_uring for disk " << disk_id_
+                 << ", falling back to blocking reads: " << status.GetDetail();
+    DiskThreadLoop(io_mgr);
+    return;
+  }
+  // The reads in flight, indexed by the user data of their io_uring request.
+  vector<AsyncReadRequest> reads(ring.queue_depth());
+  vector<int> free_slots;
+  for (int i = ring.queue_depth() - 1; i >= 0; --i) free_slots.push_back(i);
+  while (true) {
+    // Fill the ring with reads. Only block waiting for work if no read is in flight.
+    while (!free_slots.empty()) {
+      RequestContext* worker_context = nullptr;
+      RequestRange* range =
+          GetNextRequestRange(&worker_context, ring.num_pending() == 0);
+      if (range == nullptr) break;
+      bool is_async_read = range->request_type() == RequestType::READ
+          && static_cast<ScanRange*>(range)->CanReadAsync();
+      if (!is_async_read) {
+        // Writes and reads of other kinds of ranges are done synchronously.
+        ProcessRequestRange(worker_context, range);
+        continue;
+      }
+      ScanRange* scan_range = static_cast<ScanRange*>(range);
+      AsyncReadRequest* read = &reads[free_slots.back()];
+      ReadOutcome outcome;
+      if (!scan_range->StartAsyncRead(disk_id_, &read->read, &outcome)) {
         worker_context->ReadDone(disk_id_, outcome, scan_range);
-        break;
+        continue;
       }
-      case RequestType::WRITE: {
-        WriteRange* write_range = static_cast<WriteRange*>(range);
-        Status status = write_range->DoWrite();
-        worker_context->OperDone(write_range, status);
-        break;
+      read->context = worker_context;
+      read->range = scan_range;
+      read->start_time = MonotonicNanos();
+      bool queued = ring.PrepareRead(read->read.fd, read->read.buffer_desc->buffer(),
+          read->read.len, read->read.offset, free_slots.back());
+      DCHECK(queued);
+      free_slots.pop_back();
+    }
+    if (ring.num_pending() == 0) {
+      // GetNextRequestRange() only returns no range when waiting if the queue is shut
+      // down.
+      DCHECK(shut_down_);
+      return;
+    }
+    status = ring.Submit(1);
+    if (!status.ok()) {
+      // Only the reads that were queued since the last Submit() failed. The kernel may
+      // still write to the buffers of the reads that were submitted before, so those
+      // stay in flight and are completed below.
+      LOG(WARNING) << "Could not submit reads for disk " << disk_id_ << ": "
+                   << status.GetDetail();
+      vector<uint64_t> failed_slots;
+      ring.DiscardUnsubmitted(&failed_slots);
+      for (uint64_t slot : failed_slots) {
+        DCHECK_LT(slot, reads.size());
+        FinishAsyncRead(&reads[slot], status);
+        free_slots.push_back(slot);
       }
-      case RequestType::FILE_UPLOAD: {
-        RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
-        int64_t size = oper_range->block_size();
-        // Use malloc to get the memory in case there is no available space
-        // in the buffer pool because spilling to disk happens when scarcity
-        // of memory in the buffer pool. Be better to preserve memory than
-        // malloc.
-        uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
-        if (UNLIKELY(buffer == nullptr)) {
-          worker_context->OperDone(oper_range,
-              Status(Substitute("Couldn't allocate memory for remote file operations, "
-                                "block size: '$0'",
-                  size)));
-        } else {
-          Status oper_status = oper_range->DoOper(buffer, size);
-          worker_context->OperDone(oper_range, oper_status);
-          free(buffer);
+      continue;
+    }
+    uint64_t slot;
+    int result;
+    while (ring.PopCompletion(&slot, &result)) {
+      DCHECK_LT(slot, reads.size());
+      AsyncReadRequest* read = &reads[slot];
+      ScanRange::AsyncRead* async_read = &read->read;
+      if (result < 0) {
+        FinishAsyncRead(read, Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+            Substitute("Error reading from $0 at byte offset: $1: $2",
+                *read->range->file_string(), async_read->offset + async_read->bytes_read,
+                GetStrErrMsg(-result))));
+      } else {
+        async_read->bytes_read += result;
+        DCHECK_LE(async_read->bytes_read, async_read->len);
+        if (result > 0 && async_read->bytes_read < async_read->len) {
+          // A short read does not mean that the end of the file was reached, e.g. if
+          // the read was interrupted. Read the rest of the buffer, which reuses the
+          // slot that just completed.
+          bool queued = ring.PrepareRead(async_read->fd,
+              async_read->buffer_desc->buffer() + async_read->bytes_read,
+              async_read->len - async_read->bytes_read,
+              async_read->offset + async_read->bytes_read, slot);
+          DCHECK(queued);
+          continue;
         }
-        break;
+        FinishAsyncRead(read, Status::OK());
       }
-      default:
-        DCHECK(false) << "Invalid request type: " << range->request_type();
+      free_slots.push_back(slot);
     }
   }
+#endif
+}
+
+void DiskQueue::FinishAsyncRead(AsyncReadRequest* read, const Status& status) {
+  DCHECK(read->range != nullptr);
+  read_latency_->Update(MonotonicNanos() - read->start_time);
+  RequestContext* worker_context = read->context;
+  ScanRange* scan_range = read->range;
+  read->context = nullptr;
+  read->range = nullptr;
+  ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
+      worker_context->instance_id());
+  ReadOutcome outcome = scan_range->FinishAsyncRead(this, &read->read, status);
+  worker_context->ReadDone(disk_id_, outcome, scan_range);
+}
+
+void DiskQueue::ProcessRequestRange(
+    RequestContext* worker_context, RequestRange* range) {
+  // We are now working on behalf of a query, so set thread state appropriately.
+  // See also IMPALA-6254 and IMPALA-6417.
+  ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
+      worker_context->instance_id());
+
+  switch (range->request_type()) {
+    case RequestType::READ: {
+      ScanRange* scan_range = static_cast<ScanRange*>(range);
+      ReadOutcome outcome = scan_range->DoRead(this, disk_id_);
+      worker_context->ReadDone(disk_id_, outcome, scan_range);
+      break;
+    }
+    case RequestType::WRITE: {
+      WriteRange* write_range = static_cast<WriteRange*>(range);
+      Status status = write_range->DoWrite();
+      worker_context->OperDone(write_range, status);
+      break;
+    }
+    case RequestType::FILE_UPLOAD: {
+      RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
+      int64_t size = oper_range->block_size();
+      // Use malloc to get the memory in case there is no available space
+      // in the buffer pool because spilling to disk happens when scarcity
+      // of memory in the buffer pool. Be better to preserve memory than
+      // malloc.
+      uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
+      if (UNLIKELY(buffer == nullptr)) {
+        worker_context->OperDone(oper_range,
+            Status(Substitute("Couldn't allocate memory for remote file operations, "
+                              "block size: '$0'",
+                size)));
+      } else {
+        Status oper_status = oper_range->DoOper(buffer, size);
+        worker_context->OperDone(oper_range, oper_status);
+        free(buffer);
+      }
+      break;
+    }
+    default:
+      DCHECK(false) << "Invalid request type: " << range->request_type();
+  }
 }
 
 void DiskIoMgr::Write(RequestContext* writer_context, WriteRange* write_range) {
@@ -791,7 +1027,7 @@ void DiskIoMgr::Write(RequestContext* writer_context, WriteRange* write_range) {
         write_range->file(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR, &file_handle);
     if (!ret_status.ok()) goto end;
 
-    ret_status = WriteRangeHelper(file_handle, write_range);
+    ret_status = WriteRangeHelper(file_handle, write_range, false);
 
     close_status = local_file_system_->Fclose(file_handle, write_range->file());
     if (ret_status.ok() && !close_status.ok()) ret_status = close_status;
@@ -806,17 +1042,21 @@ end:
   writer_context->OperDone(write_range, ret_status);
 }
 
-Status DiskIoMgr::WriteRangeHelper(FILE* file_handle, WriteRange* write_range) {
-  // Seek to the correct offset and perform the write.
-  RETURN_IF_ERROR(local_file_system_->Fseek(
-      file_handle, write_range->offset(), SEEK_SET, write_range));
-
+Status DiskIoMgr::WriteRangeHelper(
+    FILE* file_handle, WriteRange* write_range, bool direct_io) {
 #ifndef NDEBUG
   if (FLAGS_stress_scratch_write_delay_ms > 0) {
     SleepForMs(FLAGS_stress_scratch_write_delay_ms);
   }
 #endif
-  RETURN_IF_ERROR(local_file_system_->Fwrite(file_handle, write_range));
+  if (direct_io) {
+    RETURN_IF_ERROR(local_file_system_->Pwrite(fileno(file_handle), write_range));
+  } else {
+    // Seek to the correct offset and perform the write.
+    RETURN_IF_ERROR(local_file_system_->Fseek(
+        file_handle, write_range->offset(), SEEK_SET, write_range));
+    RETURN_IF_ERROR(local_file_system_->Fwrite(file_handle, write_range));
+  }
 
   ImpaladMetrics::IO_MGR_BYTES_WRITTEN->Increment(write_range->len());
   return Status::OK();
@@ -900,6 +1140,15 @@ void DiskIoMgr::ReleaseCachedHdfsFileHandle(std::string* fname,
   ImpaladMetrics::IO_MGR_NUM_FILE_HANDLES_OUTSTANDING->Increment(-1L);
 }
 
+void DiskIoMgr::PrefetchFileHandle(ScanRange* range) {
+  if (range->fs() == nullptr || range->mtime() <= 0 || range->UseHdfsCache()
+      || !range->UseFileHandleCache()) {
+    return;
+  }
+  file_handle_cache_.PrefetchFileHandle(range->fs(), *range->file_string(),
+      range->mtime());
+}
+
 Status DiskIoMgr::ReopenCachedHdfsFileHandle(const hdfsFS& fs, std::string* fname,
     int64_t mtime, RequestContext* reader, CachedHdfsFileHandle** fid) {
   bool cache_hit;
@@ -932,14 +1181,15 @@ void DiskQueue::DebugString(stringstream* ss) {
   *ss << "DiskQueue id=" << disk_id_ << " ptr=" << static_cast<void*>(this) << ":" ;
   if (!request_contexts_.empty()) {
     *ss << " Readers: ";
-    for (RequestContext* req_context: request_contexts_) {
-      *ss << static_cast<void*>(req_context);
+    for (const QueuedContext& queued : request_contexts_) {
+      *ss << static_cast<void*>(queued.context)
+          << " (deficit=" << queued.context->io_deficit(disk_id_) << ") ";
     }
   }
 }
 
 DiskQueue::~DiskQueue() {
-  for (RequestContext* context : request_contexts_) {
-    context->UnregisterDiskQueue(disk_id_);
+  for (const QueuedContext& queued : request_contexts_) {
+    queued.context->UnregisterDiskQueue(disk_id_);
   }
 }
@@ -22,6 +22,8 @@
 #define IMPALA_RUNTIME_IO_DISK_IO_MGR_H
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/atomic.h"
@@ -37,6 +39,9 @@
 #include "util/thread.h"
 
 namespace impala {
+
+class HistogramMetric;
+
 namespace io {
 
 class DataCache;
@@ -202,7 +207,11 @@ class DiskQueue;
 /// queue. Also note that reading from a remote filesystem service can be more CPU
 /// intensive than local disk/hdfs because of non-direct I/O and SSL processing, and can
 /// be CPU bottlenecked especially if not enough I/O threads for these queues are
-/// started.
+/// started. Since the throughput of a single connection is limited, large scan ranges
+/// on S3 and ABFS are read with several reads in flight at a time, each into its own
+/// buffer and on its own thread of the queue (see --max_parallel_remote_reads_per_range).
+/// The buffers are returned to the client in file order, and the number of reads in
+/// flight is limited by the buffers that the client allocated for the range.
 ///
 /// Remote filesystem data caching:
 /// To reduce latency and avoid being network bound when reading from remote filesystems,
@@ -270,6 +279,11 @@ class DiskIoMgr : public CacheLineAligned {
   /// up.
   void UnregisterContext(RequestContext* context);
 
+  /// Returns the histogram of the time that the contexts of queries in resource pool
+  /// 'pool' wait on the disk queues, registering it on the first call for 'pool'. The
+  /// caller passes it to RequestContext::set_queue_delay_metric().
+  HistogramMetric* GetPoolQueueDelayMetric(const std::string& pool);
+
   /// Allocates up to 'max_bytes' buffers to read the data from 'range' into and schedules
   /// the range. Called after StartScanRange() or reader->GetNextUnstartedRange()
   /// returns *needs_buffers=true.
@@ -366,6 +380,11 @@ class DiskIoMgr : public CacheLineAligned {
   /// Releases a file handle back to the file handle cache when it is no longer in use.
   void ReleaseCachedHdfsFileHandle(std::string* fname, CachedHdfsFileHandle* fid);
 
+  /// Opens the cached file handle of 'range' asynchronously if the range will read
+  /// through the file handle cache and file handle prefetching is enabled (see
+  /// --num_file_handle_prefetch_threads). 'range' must have been initialized.
+  void PrefetchFileHandle(ScanRange* range);
+
   /// Reopens a file handle by destroying the file handle and getting a fresh
   /// file handle from the cache. Records the time spent reopening the handle
   /// in 'reader'. Returns an error if the file could not be reopened.
@@ -480,8 +499,11 @@ class DiskIoMgr : public CacheLineAligned {
 
   /// Helper method to write a range using the specified FILE handle. Returns Status:OK
   /// if the write succeeded, or a RUNTIME_ERROR with an appropriate message otherwise.
-  /// Does not open or close the file that is written.
-  Status WriteRangeHelper(FILE* file_handle, WriteRange* write_range) WARN_UNUSED_RESULT;
+  /// Does not open or close the file that is written. If 'direct_io' is true, the file
+  /// was opened with O_DIRECT and the range is written with pwrite() instead of the
+  /// buffered stream.
+  Status WriteRangeHelper(FILE* file_handle, WriteRange* write_range,
+      bool direct_io) WARN_UNUSED_RESULT;
 
   /// Helper for AllocateBuffersForRange() to compute the buffer sizes for a scan range
   /// with length 'scan_range_len', given that 'max_bytes' of memory should be allocated.
@@ -491,6 +513,12 @@ class DiskIoMgr : public CacheLineAligned {
   /// non-local reads and data read from remote data nodes will be stored in it. If not
   /// configured, this would be NULL.
   std::unique_ptr<DataCache> remote_data_cache_;
+
+  /// Protects 'pool_queue_delay_metrics_'.
+  std::mutex pool_queue_delay_metrics_lock_;
+
+  /// The queue delay histograms by resource pool. See GetPoolQueueDelayMetric().
+  std::unordered_map<std::string, HistogramMetric*> pool_queue_delay_metrics_;
 };
 }
 }
@@ -0,0 +1,58 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/io/file-reader.h"
+
+#include <algorithm>
+
+#include "runtime/io/request-ranges.h"
+
+#include "common/names.h"
+
+namespace impala {
+namespace io {
+
+constexpr int64_t FileReader::MAX_VECTORED_READ_GAP;
+
+Status FileReader::ReadVectored(DiskQueue* queue, vector<ReadRange>* ranges) {
+  SortReadRanges(ranges);
+  for (const ReadRange& range : *ranges) {
+    int64_t bytes_read;
+    bool eof;
+    RETURN_IF_ERROR(
+        ReadFromPos(queue, range.offset, range.buffer, range.len, &bytes_read, &eof));
+    if (bytes_read != range.len) return IncompleteReadError(range, bytes_read);
+  }
+  return Status::OK();
+}
+
+void FileReader::SortReadRanges(vector<ReadRange>* ranges) {
+  sort(ranges->begin(), ranges->end(),
+      [](const ReadRange& a, const ReadRange& b) { return a.offset < b.offset; });
+  DCHECK(adjacent_find(ranges->begin(), ranges->end(),
+      [](const ReadRange& a, const ReadRange& b) { return a.offset + a.len > b.offset; })
+      == ranges->end()) << "Overlapping ranges";
+}
+
+Status FileReader::IncompleteReadError(const ReadRange& range, int64_t bytes_read) const {
+  DCHECK_LT(bytes_read, range.len);
+  return Status(TErrorCode::SCANNER_INCOMPLETE_READ, range.len, bytes_read,
+      scan_range_->file(), range.offset);
+}
+
+}
+}
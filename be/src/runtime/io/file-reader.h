@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "util/spinlock.h"
 
@@ -53,6 +55,25 @@ public:
   virtual Status ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_t* buffer,
       int64_t bytes_to_read, int64_t* bytes_read, bool* eof) = 0;
 
+  /// A read of 'len' bytes at 'offset' of the file into 'buffer'.
+  struct ReadRange {
+    int64_t offset;
+    int64_t len;
+    uint8_t* buffer;
+  };
+
+  /// Reads each of 'ranges', which must not overlap, fully into its buffer. Sorts
+  /// 'ranges' by offset. Returns an error if the file ends before one of the ranges
+  /// does. Implementations may use a single file handle for all the ranges and merge
+  /// ranges that are at most MAX_VECTORED_READ_GAP bytes apart into a single read.
+  /// The default implementation calls ReadFromPos() for each range. Metrics in 'queue'
+  /// are updated like in ReadFromPos().
+  virtual Status ReadVectored(DiskQueue* queue, std::vector<ReadRange>* ranges);
+
+  /// See ReadVectored(). The bytes in the gaps between merged ranges are read and
+  /// discarded.
+  static constexpr int64_t MAX_VECTORED_READ_GAP = 64 * 1024;
+
   /// ***Currently only for HDFS***
   /// When successful, sets 'data' to a buffer that contains the contents of a file,
   /// and 'length' is set to the length of the data.
@@ -71,11 +92,19 @@ public:
 
   SpinLock& lock() { return lock_; }
 protected:
+  /// Sorts 'ranges' by offset.
+  static void SortReadRanges(std::vector<ReadRange>* ranges);
+
+  /// Returns the error for a read of 'range' that ended after 'bytes_read' bytes.
+  Status IncompleteReadError(const ReadRange& range, int64_t bytes_read) const;
+
   /// Lock that should be taken during fs calls. Only one thread (the disk reading
   /// thread) calls into fs at a time so this lock does not have performance impact.
   /// This lock only serves to coordinate cleanup. Specifically it serves to ensure
   /// that the disk threads are finished with FS calls before scan_range_->is_cancelled_
-  /// is set to true and cleanup starts.
+  /// is set to true and cleanup starts. Ranges with parallel reads (see
+  /// ScanRange::MaxParallelReads()) are the exception: several disk threads call into fs
+  /// at a time, and HdfsFileReader only holds this lock while checking for cancellation.
   /// If this lock and scan_range_->lock_ need to be taken, scan_range_->lock_ must be
   /// taken first.
   SpinLock lock_;
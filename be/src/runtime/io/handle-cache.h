@@ -22,14 +22,20 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <unordered_set>
 
 #include "common/hdfs.h"
 #include "common/status.h"
 #include "util/aligned-new.h"
+#include "util/metrics-fwd.h"
 #include "util/spinlock.h"
+#include "util/thread-pool.h"
 #include "util/thread.h"
 
 namespace impala {
+
+class HistogramMetric;
+
 namespace io {
 
 class HdfsMonitor;
@@ -105,6 +111,15 @@ class ExclusiveHdfsFileHandle : public HdfsFileHandle {
 /// file handle that has been unused for longer than threshold specified by
 /// `unused_handle_timeout_secs`. Eviction is disabled when the threshold is 0.
 ///
+/// Opening a file handle can take tens of milliseconds on remote file systems such as
+/// S3 or ABFS, which an I/O thread otherwise spends idle. If `num_prefetch_threads` is
+/// positive, PrefetchFileHandle() opens handles for files that will be read soon on a
+/// separate thread pool and adds them to the cache as unused handles, so that the I/O
+/// thread finds them with GetFileHandle().
+///
+/// Every partition keeps counters of its hits, misses and evictions, and the latency of
+/// all opens of file handles is tracked in a histogram.
+///
 /// TODO: The cache should also evict file handles more aggressively if the file handle's
 /// mtime is older than the file's current mtime.
 class FileHandleCache {
@@ -113,14 +128,17 @@ class FileHandleCache {
   /// partitions. If the capacity does not split evenly, then the capacity is rounded
   /// up. The cache will age out any file handle that is unused for
   /// `unused_handle_timeout_secs` seconds. Age out is disabled if this is set to zero.
+  /// `num_prefetch_threads` is the number of threads that open prefetched file handles.
+  /// Prefetching is disabled if it is zero.
   FileHandleCache(size_t capacity, size_t num_partitions,
-      uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor);
+      uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor,
+      int num_prefetch_threads = 0);
 
   /// Destructor is only called for backend tests
   ~FileHandleCache();
 
   /// Starts up a thread that monitors the age of file handles and evicts any that
-  /// exceed the limit.
+  /// exceed the limit, and the prefetch threads. Registers the metrics of the cache.
   Status Init() WARN_UNUSED_RESULT;
 
   /// Get a file handle from the cache for the specified filename (fname) and
@@ -147,6 +165,13 @@ class FileHandleCache {
   void ReleaseFileHandle(std::string* fname, CachedHdfsFileHandle* fh,
       bool destroy_handle);
 
+  /// Asynchronously opens a file handle for the specified filename (fname) and last
+  /// modification time (mtime) and adds it to the cache as an unused handle. Does
+  /// nothing if prefetching is disabled, if the cache already contains a handle for the
+  /// file with this mtime or one is being prefetched, or if the prefetch queue is full.
+  /// Failures to open the handle are ignored, since GetFileHandle() will try again.
+  void PrefetchFileHandle(const hdfsFS& fs, const std::string& fname, int64_t mtime);
+
  private:
   struct FileHandleEntry;
   typedef std::multimap<std::string, FileHandleEntry> MapType;
@@ -171,6 +196,17 @@ class FileHandleCache {
     /// valid location when in_use is true. For error-checking, this is set to
     /// lru_list.end() when in_use is false.
     typename LruListType::iterator lru_entry;
+
+    /// True for a file handle that was opened by PrefetchFileHandle() and has not been
+    /// checked out yet.
+    bool prefetched = false;
+  };
+
+  /// A file handle to open on 'prefetch_pool_'.
+  struct PrefetchRequest {
+    hdfsFS fs;
+    std::string fname;
+    int64_t mtime;
   };
 
   /// Each partition operates independently, and thus has its own cache, LRU list,
@@ -195,8 +231,31 @@ class FileHandleCache {
 
     /// Current number of file handles in the cache
     size_t size;
+
+    /// Names of the files whose handles are being opened by the prefetch threads.
+    std::unordered_set<std::string> prefetching;
+
+    /// Number of calls to GetFileHandle() that found an unused handle, that had to open
+    /// a new handle, and number of handles evicted from the partition.
+    IntCounter* hits = nullptr;
+    IntCounter* misses = nullptr;
+    IntCounter* evictions = nullptr;
   };
 
+  /// Returns the partition of the file handles of 'fname'.
+  FileHandleCachePartition& GetPartition(const std::string& fname);
+
+  /// Opens the file handle of 'request' and adds it to the cache. Only executed by the
+  /// threads of 'prefetch_pool_'.
+  void PrefetchFileHandleWork(int thread_id, const PrefetchRequest& request);
+
+  /// Opens 'fh' and records the latency of the open.
+  Status OpenFileHandle(CachedHdfsFileHandle* fh);
+
+  /// Maximum number of prefetch requests that may wait for a prefetch thread. Further
+  /// requests are dropped.
+  static const int PREFETCH_QUEUE_SIZE = 1024;
+
   /// Periodic check to evict unused file handles. Only executed by eviction_thread_.
   void EvictHandlesLoop();
   static const int64_t EVICT_HANDLES_PERIOD_MS = 1000;
@@ -218,6 +277,22 @@ class FileHandleCache {
 
   /// Thread pool used to implement timeouts for HDFS operations
   HdfsMonitor* hdfs_monitor_;
+
+  /// Threads that open prefetched file handles. Only created if 'num_prefetch_threads_'
+  /// is positive.
+  const int num_prefetch_threads_;
+  std::unique_ptr<ThreadPool<PrefetchRequest>> prefetch_pool_;
+
+  /// Latency of opening file handles, both in GetFileHandle() and by the prefetch
+  /// threads.
+  HistogramMetric* open_latency_ = nullptr;
+
+  /// Number of file handles opened by the prefetch threads, number of those that were
+  /// later checked out by GetFileHandle(), and number of prefetch requests dropped
+  /// because the prefetch queue was full.
+  IntCounter* num_prefetched_ = nullptr;
+  IntCounter* num_prefetch_hits_ = nullptr;
+  IntCounter* num_prefetches_dropped_ = nullptr;
 };
 }
 }
@@ -17,11 +17,14 @@
 
 #include <tuple>
 
+#include "gutil/strings/substitute.h"
 #include "runtime/io/handle-cache.h"
 #include "runtime/io/hdfs-monitored-ops.h"
 #include "util/hash-util.h"
+#include "util/histogram-metric.h"
 #include "util/impalad-metrics.h"
 #include "util/metrics.h"
+#include "util/test-info.h"
 #include "util/time.h"
 
 #ifndef IMPALA_RUNTIME_DISK_IO_MGR_HANDLE_CACHE_INLINE_H
@@ -58,11 +61,43 @@ CachedHdfsFileHandle::~CachedHdfsFileHandle() {
   ImpaladMetrics::IO_MGR_NUM_CACHED_FILE_HANDLES->Increment(-1L);
 }
 
+static const char* FILE_HANDLE_CACHE_PARTITION_HITS_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.file-handle-cache.partition-$0.hits";
+static const char* FILE_HANDLE_CACHE_PARTITION_MISSES_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.file-handle-cache.partition-$0.misses";
+static const char* FILE_HANDLE_CACHE_PARTITION_EVICTIONS_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.file-handle-cache.partition-$0.evictions";
+static const char* FILE_HANDLE_OPEN_LATENCY_METRIC_KEY =
+    "impala-server.io-mgr.file-handle-open-latency";
+static const char* FILE_HANDLE_PREFETCHES_METRIC_KEY =
+    "impala-server.io-mgr.file-handle-prefetches";
+static const char* FILE_HANDLE_PREFETCH_HITS_METRIC_KEY =
+    "impala-server.io-mgr.file-handle-prefetch-hits";
+static const char* FILE_HANDLE_PREFETCHES_DROPPED_METRIC_KEY =
+    "impala-server.io-mgr.file-handle-prefetches-dropped";
+
+/// Registers a metric of type M with the key 'key_template' and the argument 'arg' in
+/// the I/O manager's metric group, constructed with 'args' after its definition. Tests
+/// create many caches, which share the metric that the first one registered.
+template <typename M, typename... Args>
+static M* RegisterFileHandleCacheMetric(
+    const string& key_template, const string& arg, Args... args) {
+  if (TestInfo::is_test()) {
+    M* metric = ImpaladMetrics::IO_MGR_METRICS->FindMetricForTesting<M>(
+        strings::Substitute(key_template, arg));
+    if (metric != nullptr) return metric;
+  }
+  return ImpaladMetrics::IO_MGR_METRICS->RegisterMetric(
+      new M(MetricDefs::Get(key_template, arg), args...));
+}
+
 FileHandleCache::FileHandleCache(size_t capacity,
-    size_t num_partitions, uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor)
+    size_t num_partitions, uint64_t unused_handle_timeout_secs, HdfsMonitor* hdfs_monitor,
+    int num_prefetch_threads)
   : cache_partitions_(num_partitions),
   unused_handle_timeout_secs_(unused_handle_timeout_secs),
-  hdfs_monitor_(hdfs_monitor) {
+  hdfs_monitor_(hdfs_monitor),
+  num_prefetch_threads_(num_prefetch_threads) {
   DCHECK_GT(num_partitions, 0);
   size_t remainder = capacity % num_partitions;
   size_t base_capacity = capacity / num_partitions;
@@ -78,22 +113,65 @@ FileHandleCache::LruListEntry::LruListEntry(
      : map_entry(map_entry_in), timestamp_seconds(MonotonicSeconds()) {}
 
 FileHandleCache::~FileHandleCache() {
+  if (prefetch_pool_ != nullptr) {
+    prefetch_pool_->Shutdown();
+    prefetch_pool_->Join();
+  }
   shut_down_promise_.Set(true);
   if (eviction_thread_ != nullptr) eviction_thread_->Join();
 }
 
 Status FileHandleCache::Init() {
+  for (int i = 0; i < cache_partitions_.size(); ++i) {
+    FileHandleCachePartition& p = cache_partitions_[i];
+    string i_string = std::to_string(i);
+    p.hits = RegisterFileHandleCacheMetric<IntCounter>(
+        FILE_HANDLE_CACHE_PARTITION_HITS_METRIC_KEY_TEMPLATE, i_string, 0);
+    p.misses = RegisterFileHandleCacheMetric<IntCounter>(
+        FILE_HANDLE_CACHE_PARTITION_MISSES_METRIC_KEY_TEMPLATE, i_string, 0);
+    p.evictions = RegisterFileHandleCacheMetric<IntCounter>(
+        FILE_HANDLE_CACHE_PARTITION_EVICTIONS_METRIC_KEY_TEMPLATE, i_string, 0);
+  }
+  int64_t ONE_HOUR_IN_NS = 60L * 60L * NANOS_PER_SEC;
+  open_latency_ = RegisterFileHandleCacheMetric<HistogramMetric>(
+      FILE_HANDLE_OPEN_LATENCY_METRIC_KEY, "", ONE_HOUR_IN_NS, 3);
+  num_prefetched_ = RegisterFileHandleCacheMetric<IntCounter>(
+      FILE_HANDLE_PREFETCHES_METRIC_KEY, "", 0);
+  num_prefetch_hits_ = RegisterFileHandleCacheMetric<IntCounter>(
+      FILE_HANDLE_PREFETCH_HITS_METRIC_KEY, "", 0);
+  num_prefetches_dropped_ = RegisterFileHandleCacheMetric<IntCounter>(
+      FILE_HANDLE_PREFETCHES_DROPPED_METRIC_KEY, "", 0);
+
+  if (num_prefetch_threads_ > 0) {
+    prefetch_pool_.reset(new ThreadPool<PrefetchRequest>("disk-io-mgr-handle-cache",
+        "File Handle Prefetch", num_prefetch_threads_, PREFETCH_QUEUE_SIZE,
+        [this](int thread_id, const PrefetchRequest& request) {
+          PrefetchFileHandleWork(thread_id, request);
+        }));
+    RETURN_IF_ERROR(prefetch_pool_->Init());
+  }
   return Thread::Create("disk-io-mgr-handle-cache", "File Handle Timeout",
       &FileHandleCache::EvictHandlesLoop, this, &eviction_thread_);
 }
 
+FileHandleCache::FileHandleCachePartition& FileHandleCache::GetPartition(
+    const std::string& fname) {
+  int index = HashUtil::Hash(fname.data(), fname.size(), 0) % cache_partitions_.size();
+  return cache_partitions_[index];
+}
+
+Status FileHandleCache::OpenFileHandle(CachedHdfsFileHandle* fh) {
+  int64_t start_time = MonotonicNanos();
+  Status status = fh->Init(hdfs_monitor_);
+  open_latency_->Update(MonotonicNanos() - start_time);
+  return status;
+}
+
 Status FileHandleCache::GetFileHandle(
     const hdfsFS& fs, std::string* fname, int64_t mtime, bool require_new_handle,
     CachedHdfsFileHandle** handle_out, bool* cache_hit) {
   DCHECK_GT(mtime, 0);
-  // Hash the key and get appropriate partition
-  int index = HashUtil::Hash(fname->data(), fname->size(), 0) % cache_partitions_.size();
-  FileHandleCachePartition& p = cache_partitions_[index];
+  FileHandleCachePartition& p = GetPartition(*fname);
 
   // If this requires a new handle, skip to the creation codepath. Otherwise,
   // find an unused entry with the same mtime
@@ -120,6 +198,11 @@ Status FileHandleCache::GetFileHandle(
         elem->lru_entry = p.lru_list.end();
         *cache_hit = true;
         elem->in_use = true;
+        if (elem->prefetched) {
+          elem->prefetched = false;
+          num_prefetch_hits_->Increment(1);
+        }
+        p.hits->Increment(1);
         *handle_out = elem->fh.get();
         return Status::OK();
       }
@@ -131,10 +214,11 @@ Status FileHandleCache::GetFileHandle(
   // Opening a file handle requires talking to the NameNode, so construct
   // the file handle without holding the lock to reduce contention.
   *cache_hit = false;
+  p.misses->Increment(1);
   // Create a new file handle
   std::unique_ptr<CachedHdfsFileHandle> new_fh;
   new_fh.reset(new CachedHdfsFileHandle(fs, fname, mtime));
-  RETURN_IF_ERROR(new_fh->Init(hdfs_monitor_));
+  RETURN_IF_ERROR(OpenFileHandle(new_fh.get()));
 
   // Get the lock and create/move the new entry into the map
   // This entry is new and will be immediately used. Place it as the first entry
@@ -159,9 +243,7 @@ Status FileHandleCache::GetFileHandle(
 void FileHandleCache::ReleaseFileHandle(std::string* fname,
     CachedHdfsFileHandle* fh, bool destroy_handle) {
   DCHECK(fh != nullptr);
-  // Hash the key and get appropriate partition
-  int index = HashUtil::Hash(fname->data(), fname->size(), 0) % cache_partitions_.size();
-  FileHandleCachePartition& p = cache_partitions_[index];
+  FileHandleCachePartition& p = GetPartition(*fname);
   std::lock_guard<SpinLock> g(p.lock);
   pair<typename MapType::iterator, typename MapType::iterator> range =
     p.cache.equal_range(*fname);
@@ -208,6 +290,53 @@ void FileHandleCache::ReleaseFileHandle(std::string* fname,
   }
 }
 
+void FileHandleCache::PrefetchFileHandle(
+    const hdfsFS& fs, const std::string& fname, int64_t mtime) {
+  if (prefetch_pool_ == nullptr) return;
+  DCHECK_GT(mtime, 0);
+  FileHandleCachePartition& p = GetPartition(fname);
+  {
+    std::lock_guard<SpinLock> g(p.lock);
+    pair<typename MapType::iterator, typename MapType::iterator> range =
+        p.cache.equal_range(fname);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.fh->mtime() == mtime) return;
+    }
+    if (!p.prefetching.insert(fname).second) return;
+  }
+  if (!prefetch_pool_->Offer(PrefetchRequest{fs, fname, mtime}, 0)) {
+    num_prefetches_dropped_->Increment(1);
+    std::lock_guard<SpinLock> g(p.lock);
+    p.prefetching.erase(fname);
+  }
+}
+
+void FileHandleCache::PrefetchFileHandleWork(
+    int thread_id, const PrefetchRequest& request) {
+  FileHandleCachePartition& p = GetPartition(request.fname);
+  std::unique_ptr<CachedHdfsFileHandle> new_fh(
+      new CachedHdfsFileHandle(request.fs, &request.fname, request.mtime));
+  Status status = OpenFileHandle(new_fh.get());
+  std::lock_guard<SpinLock> g(p.lock);
+  p.prefetching.erase(request.fname);
+  if (!status.ok()) {
+    VLOG_FILE << "Could not prefetch file handle for " << request.fname << ": "
+              << status.GetDetail();
+    return;
+  }
+  // Add the handle as the most recently used unused handle of the partition. It goes
+  // after the existing entries for the file, which are picked first.
+  pair<typename MapType::iterator, typename MapType::iterator> range =
+      p.cache.equal_range(request.fname);
+  typename MapType::iterator new_it = p.cache.emplace_hint(range.second,
+      request.fname, FileHandleEntry(std::move(new_fh), p.lru_list));
+  new_it->second.prefetched = true;
+  new_it->second.lru_entry = p.lru_list.emplace(p.lru_list.end(), new_it);
+  ++p.size;
+  num_prefetched_->Increment(1);
+  if (p.size > p.capacity) EvictHandles(p);
+}
+
 void FileHandleCache::EvictHandlesLoop() {
   while (true) {
     for (FileHandleCachePartition& p : cache_partitions_) {
@@ -245,6 +374,7 @@ void FileHandleCache::EvictHandles(
     p.cache.erase(oldest_entry_map_it);
     p.lru_list.pop_front();
     --p.size;
+    p.evictions->Increment(1);
   }
 }
 }
@@ -117,7 +117,57 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
 #endif
   unique_lock<SpinLock> hdfs_lock(lock_);
   RETURN_IF_ERROR(scan_range_->cancel_status_);
+  // Parallel reads of a range each borrow their own handle from the file handle cache,
+  // so nothing that Close() tears down is used below. They must not serialize on
+  // 'lock_'. Cancellation waits for them through the range's count of reads in flight.
+  if (scan_range_->max_parallel_reads_ > 1) {
+    DCHECK(exclusive_hdfs_fh_ == nullptr);
+    hdfs_lock.unlock();
+  }
+
+  CachedHdfsFileHandle* borrowed_hdfs_fh = nullptr;
+  // Make sure to release any borrowed file handle.
+  auto release_borrowed_hdfs_fh = MakeScopeExitTrigger([this, &borrowed_hdfs_fh]() {
+    if (borrowed_hdfs_fh != nullptr) {
+      scan_range_->io_mgr_->ReleaseCachedHdfsFileHandle(
+          scan_range_->file_string(), borrowed_hdfs_fh);
+    }
+  });
+  return ReadFromPosWithHandle(queue, file_offset, buffer, bytes_to_read,
+      &borrowed_hdfs_fh, bytes_read, eof);
+}
+
+Status HdfsFileReader::ReadVectored(DiskQueue* queue, vector<ReadRange>* ranges) {
+  DCHECK(scan_range_->read_in_flight());
+  unique_lock<SpinLock> hdfs_lock(lock_);
+  RETURN_IF_ERROR(scan_range_->cancel_status_);
+  // See ReadFromPos().
+  if (scan_range_->max_parallel_reads_ > 1) {
+    DCHECK(exclusive_hdfs_fh_ == nullptr);
+    hdfs_lock.unlock();
+  }
+  SortReadRanges(ranges);
+  // Borrow at most one file handle for all the ranges.
+  CachedHdfsFileHandle* borrowed_hdfs_fh = nullptr;
+  auto release_borrowed_hdfs_fh = MakeScopeExitTrigger([this, &borrowed_hdfs_fh]() {
+    if (borrowed_hdfs_fh != nullptr) {
+      scan_range_->io_mgr_->ReleaseCachedHdfsFileHandle(
+          scan_range_->file_string(), borrowed_hdfs_fh);
+    }
+  });
+  for (const ReadRange& range : *ranges) {
+    int64_t bytes_read;
+    bool eof;
+    RETURN_IF_ERROR(ReadFromPosWithHandle(queue, range.offset, range.buffer, range.len,
+        &borrowed_hdfs_fh, &bytes_read, &eof));
+    if (bytes_read != range.len) return IncompleteReadError(range, bytes_read);
+  }
+  return Status::OK();
+}
 
+Status HdfsFileReader::ReadFromPosWithHandle(DiskQueue* queue, int64_t file_offset,
+    uint8_t* buffer, int64_t bytes_to_read, CachedHdfsFileHandle** borrowed_hdfs_fh,
+    int64_t* bytes_read, bool* eof) {
   auto io_mgr = scan_range_->io_mgr_;
   auto request_context = scan_range_->reader_;
   *eof = false;
@@ -147,25 +197,19 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
     // If we get here, the next bytes are not available in data cache, so we need to get
     // file handle in order to read the rest of data from file.
     // If the reader has an exclusive file handle, use it. Otherwise, borrow
-    // a file handle from the cache.
+    // a file handle from the cache, unless the caller already borrowed one.
     req_context_read_timer.Stop();
-    CachedHdfsFileHandle* borrowed_hdfs_fh = nullptr;
     hdfsFile hdfs_file;
     if (exclusive_hdfs_fh_ != nullptr) {
       hdfs_file = exclusive_hdfs_fh_->file();
     } else {
-      RETURN_IF_ERROR(
-          io_mgr->GetCachedHdfsFileHandle(hdfs_fs_, scan_range_->file_string(),
-              scan_range_->mtime(), request_context, &borrowed_hdfs_fh));
-      hdfs_file = borrowed_hdfs_fh->file();
-    }
-    // Make sure to release any borrowed file handle.
-    auto release_borrowed_hdfs_fh = MakeScopeExitTrigger([this, &borrowed_hdfs_fh]() {
-      if (borrowed_hdfs_fh != nullptr) {
-        scan_range_->io_mgr_->ReleaseCachedHdfsFileHandle(
-            scan_range_->file_string(), borrowed_hdfs_fh);
+      if (*borrowed_hdfs_fh == nullptr) {
+        RETURN_IF_ERROR(
+            io_mgr->GetCachedHdfsFileHandle(hdfs_fs_, scan_range_->file_string(),
+                scan_range_->mtime(), request_context, borrowed_hdfs_fh));
       }
-    });
+      hdfs_file = (*borrowed_hdfs_fh)->file();
+    }
     req_context_read_timer.Start();
 
     while (*bytes_read < bytes_to_read) {
@@ -186,14 +230,14 @@ Status HdfsFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_
       // - first read was not successful
       // and
       // - used a borrowed file handle
-      if (!status.ok() && borrowed_hdfs_fh != nullptr) {
+      if (!status.ok() && *borrowed_hdfs_fh != nullptr) {
         // The error may be due to a bad file handle. Reopen the file handle and retry.
         // Exclude this time from the read timers.
         req_context_read_timer.Stop();
         RETURN_IF_ERROR(
             io_mgr->ReopenCachedHdfsFileHandle(hdfs_fs_, scan_range_->file_string(),
-                scan_range_->mtime(), request_context, &borrowed_hdfs_fh));
-        hdfs_file = borrowed_hdfs_fh->file();
+                scan_range_->mtime(), request_context, borrowed_hdfs_fh));
+        hdfs_file = (*borrowed_hdfs_fh)->file();
         VLOG_FILE << "Reopening file " << scan_range_->file_string() << " with mtime "
                   << scan_range_->mtime() << " offset " << file_offset;
         req_context_read_timer.Start();
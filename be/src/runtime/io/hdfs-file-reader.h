@@ -23,6 +23,7 @@
 namespace impala {
 namespace io {
 
+class CachedHdfsFileHandle;
 class DataCache;
 
 /// File reader class for HDFS.
@@ -37,6 +38,9 @@ public:
   virtual Status Open(bool use_file_handle_cache) override;
   virtual Status ReadFromPos(DiskQueue* queue, int64_t file_offset, uint8_t* buffer,
       int64_t bytes_to_read, int64_t* bytes_read, bool* eof) override;
+  /// Reads the ranges one after the other through a single file handle, instead of
+  /// borrowing one from the file handle cache for each range.
+  virtual Status ReadVectored(DiskQueue* queue, std::vector<ReadRange>* ranges) override;
   virtual void Close() override;
   virtual void ResetState() override;
   virtual std::string DebugString() const override;
@@ -66,6 +70,14 @@ private:
   void WriteDataCache(DataCache* remote_data_cache, int64_t file_offset,
       const uint8_t* buffer, int64_t buffer_len, int64_t cached_bytes_missed);
 
+  /// Implements ReadFromPos() after the caller checked for cancellation. If the reader
+  /// does not have an exclusive file handle, reads through '*borrowed_hdfs_fh', which
+  /// may be replaced by a reopened handle. If it is NULL, borrows a handle from the
+  /// file handle cache first and stores it there. The caller must release it.
+  Status ReadFromPosWithHandle(DiskQueue* queue, int64_t file_offset, uint8_t* buffer,
+      int64_t bytes_to_read, CachedHdfsFileHandle** borrowed_hdfs_fh,
+      int64_t* bytes_read, bool* eof);
+
   /// Read [position_in_file, position_in_file + bytes_to_read) from 'hdfs_file'
   /// into 'buffer'. Update 'bytes_read' on success. Returns error status on
   /// failure. When not using HDFS pread, this function will always implicitly
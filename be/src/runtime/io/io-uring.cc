@@ -0,0 +1,195 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/io/io-uring.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/logging.h"
+#include "gutil/strings/substitute.h"
+#include "util/error-util.h"
+
+#include "common/names.h"
+
+#ifdef IMPALA_HAVE_IO_URING
+namespace impala {
+namespace io {
+
+IoUring::~IoUring() {
+  DCHECK_EQ(num_pending_, 0);
+  if (sqes_ != nullptr) munmap(sqes_, sqes_size_);
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) munmap(cq_ring_, cq_ring_size_);
+  if (sq_ring_ != nullptr) munmap(sq_ring_, sq_ring_size_);
+  if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+Status IoUring::Init(int queue_depth) {
+  DCHECK_EQ(ring_fd_, -1);
+  DCHECK_GT(queue_depth, 0);
+#ifdef __NR_io_uring_setup
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd_ < 0) {
+    return Status(Substitute("io_uring_setup() failed: $0", GetStrErrMsg()));
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) sq_ring_size_ = max(sq_ring_size_, cq_ring_size_);
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return Status(Substitute("Could not map io_uring submission ring: $0",
+        GetStrErrMsg()));
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return Status(Substitute("Could not map io_uring completion ring: $0",
+          GetStrErrMsg()));
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return Status(Substitute("Could not map io_uring submission queue entries: $0",
+        GetStrErrMsg()));
+  }
+  sqes_ = reinterpret_cast<io_uring_sqe*>(sqes);
+
+  uint8_t* sq_ring = reinterpret_cast<uint8_t*>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32_t*>(sq_ring + params.sq_off.array);
+  uint8_t* cq_ring = reinterpret_cast<uint8_t*>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32_t*>(cq_ring + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32_t*>(cq_ring + params.cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32_t*>(cq_ring + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes);
+
+  // The kernel may round the number of entries up to a power of two.
+  queue_depth_ = min<int>(queue_depth, params.sq_entries);
+  iovecs_.resize(params.sq_entries);
+  return Status::OK();
+#else
+  return Status("io_uring is not supported by this build.");
+#endif
+}
+
+bool IoUring::PrepareRead(int fd, uint8_t* buffer, int64_t len, int64_t offset,
+    uint64_t user_data) {
+  return PrepareRw(IORING_OP_READV, fd, buffer, len, offset, user_data);
+}
+
+bool IoUring::PrepareWrite(int fd, const uint8_t* buffer, int64_t len, int64_t offset,
+    uint64_t user_data) {
+  return PrepareRw(IORING_OP_WRITEV, fd, buffer, len, offset, user_data);
+}
+
+bool IoUring::PrepareRw(uint8_t opcode, int fd, const uint8_t* buffer, int64_t len,
+    int64_t offset, uint64_t user_data) {
+  DCHECK_GE(ring_fd_, 0);
+  if (num_pending_ >= queue_depth_) return false;
+  // Only this thread writes the tail, while the kernel advances the head.
+  const uint32_t tail = *sq_tail_;
+  DCHECK_LT(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE), iovecs_.size());
+  const uint32_t index = tail & sq_mask_;
+  iovec* iov = &iovecs_[index];
+  iov->iov_base = const_cast<uint8_t*>(buffer);
+  iov->iov_len = len;
+  io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->off = offset;
+  sqe->addr = reinterpret_cast<uint64_t>(iov);
+  sqe->len = 1;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  // Publish the entry to the kernel.
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  ++num_pending_;
+  ++num_unsubmitted_;
+  return true;
+}
+
+Status IoUring::Submit(int min_complete) {
+  DCHECK_GE(ring_fd_, 0);
+  DCHECK_LE(min_complete, num_pending_);
+#ifdef __NR_io_uring_enter
+  while (true) {
+    int ret = syscall(__NR_io_uring_enter, ring_fd_, num_unsubmitted_, min_complete,
+        min_complete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+    if (ret >= 0) {
+      DCHECK_LE(ret, num_unsubmitted_);
+      num_unsubmitted_ -= ret;
+      // All entries are consumed unless the kernel ran out of memory. Retry until all
+      // entries are submitted to make sure that 'min_complete' requests complete.
+      if (num_unsubmitted_ == 0) return Status::OK();
+      continue;
+    }
+    // EAGAIN is transient, e.g. if the kernel is short of memory.
+    if (errno == EINTR || errno == EAGAIN) continue;
+    return Status(Substitute("io_uring_enter() failed: $0", GetStrErrMsg()));
+  }
+#else
+  return Status("io_uring is not supported by this build.");
+#endif
+}
+
+void IoUring::DiscardUnsubmitted(vector<uint64_t>* user_data) {
+  DCHECK_LE(num_unsubmitted_, num_pending_);
+  // The kernel did not consume the entries, so they are still the last ones before the
+  // tail and the tail can be moved back.
+  uint32_t tail = *sq_tail_;
+  for (; num_unsubmitted_ > 0; --num_unsubmitted_) {
+    --tail;
+    user_data->push_back(sqes_[tail & sq_mask_].user_data);
+    --num_pending_;
+  }
+  DCHECK_EQ(tail, __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+}
+
+bool IoUring::PopCompletion(uint64_t* user_data, int* result) {
+  const uint32_t head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return false;
+  const io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+  *user_data = cqe->user_data;
+  *result = cqe->res;
+  // Hand the entry back to the kernel.
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  DCHECK_GT(num_pending_, 0);
+  --num_pending_;
+  return true;
+}
+}
+}
+#endif
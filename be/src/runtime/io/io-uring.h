@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <sys/uio.h>
+
+// Older distributions, e.g. RHEL 7 and Ubuntu 16.04, do not ship the io_uring header.
+// Without it, the disk threads always use the blocking file readers.
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define IMPALA_HAVE_IO_URING
+#endif
+#endif
+
+#include "common/status.h"
+
+#ifdef IMPALA_HAVE_IO_URING
+namespace impala {
+namespace io {
+
+/// Minimal wrapper around a Linux io_uring instance, which lets a single thread keep
+/// several reads and writes in flight. It uses the io_uring system calls directly, so
+/// it does not depend on liburing. Only the vectored read and write operations are
+/// used, which are available since Linux 5.1. Not thread-safe: each ring is owned by
+/// a single thread.
+class IoUring {
+ public:
+  IoUring() {}
+  ~IoUring();
+
+  /// Sets up the ring with room for 'queue_depth' requests in flight. Returns an error
+  /// if the kernel does not support io_uring, e.g. because it is too old or io_uring is
+  /// disabled.
+  Status Init(int queue_depth) WARN_UNUSED_RESULT;
+
+  /// Number of requests that can be queued or in flight at the same time.
+  int queue_depth() const { return queue_depth_; }
+
+  /// Number of requests that were queued but did not complete yet.
+  int num_pending() const { return num_pending_; }
+
+  /// Queues a read of 'len' bytes at 'offset' of 'fd' into 'buffer'. 'user_data' is
+  /// returned with the completion. The read is only issued by Submit(). Returns false
+  /// if 'queue_depth()' requests are already pending.
+  bool PrepareRead(int fd, uint8_t* buffer, int64_t len, int64_t offset,
+      uint64_t user_data);
+
+  /// Same as PrepareRead() but writes 'len' bytes of 'buffer' at 'offset' of 'fd'.
+  bool PrepareWrite(int fd, const uint8_t* buffer, int64_t len, int64_t offset,
+      uint64_t user_data);
+
+  /// Issues the queued requests and waits until at least 'min_complete' requests
+  /// completed. Interrupted and transiently failing system calls are retried. If an
+  /// error is returned, the requests that were queued since the last Submit() were not
+  /// issued and must be removed with DiscardUnsubmitted().
+  Status Submit(int min_complete) WARN_UNUSED_RESULT;
+
+  /// Removes the requests that were queued but not issued and appends their
+  /// 'user_data' to 'user_data'. Requests that were issued before stay in flight.
+  void DiscardUnsubmitted(std::vector<uint64_t>* user_data);
+
+  /// Pops a completed request. Sets 'user_data' to the value passed when the request
+  /// was queued and 'result' to the number of bytes transferred or a negated errno.
+  /// Returns false if no request completed.
+  bool PopCompletion(uint64_t* user_data, int* result);
+
+ private:
+  bool PrepareRw(uint8_t opcode, int fd, const uint8_t* buffer, int64_t len,
+      int64_t offset, uint64_t user_data);
+
+  int ring_fd_ = -1;
+  int queue_depth_ = 0;
+  int num_pending_ = 0;
+  /// Number of requests queued since the last Submit().
+  int num_unsubmitted_ = 0;
+
+  /// The mapped submission and completion rings and submission queue entries. If the
+  /// kernel supports IORING_FEAT_SINGLE_MMAP, both rings share 'sq_ring_'.
+  void* sq_ring_ = nullptr;
+  size_t sq_ring_size_ = 0;
+  void* cq_ring_ = nullptr;
+  size_t cq_ring_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_size_ = 0;
+
+  /// Pointers into the rings.
+  uint32_t* sq_head_ = nullptr;
+  uint32_t* sq_tail_ = nullptr;
+  uint32_t sq_mask_ = 0;
+  uint32_t* sq_array_ = nullptr;
+  uint32_t* cq_head_ = nullptr;
+  uint32_t* cq_tail_ = nullptr;
+  uint32_t cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  /// The iovec of each submission queue entry. It must stay valid until the request is
+  /// submitted.
+  std::vector<iovec> iovecs_;
+};
+}
+}
+#endif
@@ -16,7 +16,11 @@
 // under the License.
 
 #include <algorithm>
+#include <climits>
+#include <fcntl.h>
 #include <stdio.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
 #include "runtime/io/disk-io-mgr-internal.h"
 #include "runtime/io/local-file-reader.h"
@@ -27,6 +31,8 @@
 
 #include "common/names.h"
 
+DECLARE_bool(scratch_direct_io);
+
 #ifndef NDEBUG
 DECLARE_int32(stress_disk_read_delay_ms);
 #endif
@@ -47,6 +53,11 @@ Status LocalFileReader::Open(bool use_file_handle_cache) {
         Substitute("Could not open file: $0: $1", *scan_range_->file_string(),
             GetStrErrMsg()));
   }
+  if (FLAGS_scratch_direct_io && scan_range_->disk_file() != nullptr) {
+    // The filesystem may not support O_DIRECT, e.g. tmpfs. All reads then go through
+    // 'file_'.
+    direct_fd_ = open(scan_range_->file(), O_RDONLY | O_DIRECT);
+  }
   ImpaladMetrics::IO_MGR_NUM_OPEN_FILES->Increment(1L);
   return Status::OK();
 }
@@ -68,9 +79,56 @@ Status LocalFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset,
   *bytes_read = 0;
 
   DCHECK(file_ != nullptr);
+  if (scan_range_->max_parallel_reads_ > 1) {
+    // Parallel reads only happen in tests, see ScanRange::MaxParallelReads(). Like
+    // HdfsFileReader, they must not serialize on 'lock_' and cannot share the position
+    // of 'file_'. A duplicate descriptor keeps the file open even if the range is
+    // cancelled and closes 'file_' during the read.
+    const int fd = dup(fileno(file_));
+    if (fd < 0) {
+      return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+          Substitute("Could not duplicate descriptor of file: $0: $1",
+              *scan_range_->file_string(), GetStrErrMsg()));
+    }
+    fs_lock.unlock();
+    {
+      ScopedHistogramTimer read_timer(queue->read_latency());
+      *bytes_read = pread(fd, buffer, bytes_to_read, file_offset);
+    }
+    close(fd);
+    if (*bytes_read < 0) {
+      *bytes_read = 0;
+      return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+          Substitute("Error reading from $0 at byte offset: $1: $2",
+              *scan_range_->file_string(), file_offset, GetStrErrMsg()));
+    }
+    queue->read_size()->Update(*bytes_read);
+    *eof = *bytes_read < bytes_to_read;
+    return Status::OK();
+  }
+  if (direct_fd_ >= 0
+      && LocalFileSystem::IsDirectIoAligned(buffer, bytes_to_read, file_offset)) {
+    {
+      ScopedHistogramTimer read_timer(queue->read_latency());
+      *bytes_read = pread(direct_fd_, buffer, bytes_to_read, file_offset);
+    }
+    if (*bytes_read < 0) {
+      *bytes_read = 0;
+      return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+          Substitute("Error reading from $0 at byte offset: $1: $2",
+              *scan_range_->file_string(), file_offset, GetStrErrMsg()));
+    }
+    queue->read_size()->Update(*bytes_read);
+    *eof = *bytes_read < bytes_to_read;
+    return Status::OK();
+  }
   if (fseek(file_, file_offset, SEEK_SET) == -1) {
     fclose(file_);
     file_ = nullptr;
+    if (direct_fd_ >= 0) {
+      close(direct_fd_);
+      direct_fd_ = -1;
+    }
     return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
         Substitute("Could not seek to $0 for file: $1: $2",
             scan_range_->offset(), *scan_range_->file_string(), GetStrErrMsg()));
@@ -96,6 +154,83 @@ Status LocalFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset,
   return Status::OK();
 }
 
+Status LocalFileReader::ReadVectored(DiskQueue* queue, vector<ReadRange>* ranges) {
+  DCHECK(scan_range_->read_in_flight());
+  unique_lock<SpinLock> fs_lock(lock_);
+  RETURN_IF_ERROR(scan_range_->cancel_status_);
+  DCHECK(file_ != nullptr);
+  if (direct_fd_ >= 0) {
+    // Read through ReadFromPos() to use the O_DIRECT descriptor where possible.
+    fs_lock.unlock();
+    return FileReader::ReadVectored(queue, ranges);
+  }
+  SortReadRanges(ranges);
+  const int fd = fileno(file_);
+  // The bytes in the gaps between merged ranges are all read into this buffer. It is
+  // only allocated if there are gaps.
+  unique_ptr<uint8_t[]> gap_buffer;
+  vector<iovec> iovecs;
+  int i = 0;
+  while (i < ranges->size()) {
+    // Merge the ranges starting at 'i' that are at most MAX_VECTORED_READ_GAP bytes
+    // apart into one preadv() call.
+    const int64_t start = (*ranges)[i].offset;
+    int64_t end = start;
+    int next = i;
+    iovecs.clear();
+    for (; next < ranges->size() && iovecs.size() + 2 <= IOV_MAX; ++next) {
+      const ReadRange& range = (*ranges)[next];
+      const int64_t gap = range.offset - end;
+      DCHECK_GE(gap, 0);
+      if (gap > MAX_VECTORED_READ_GAP) break;
+      if (gap > 0) {
+        if (gap_buffer == nullptr) gap_buffer.reset(new uint8_t[MAX_VECTORED_READ_GAP]);
+        iovecs.push_back({gap_buffer.get(), static_cast<size_t>(gap)});
+      }
+      iovecs.push_back({range.buffer, static_cast<size_t>(range.len)});
+      end = range.offset + range.len;
+    }
+    ssize_t bytes_read;
+    {
+      ScopedHistogramTimer read_timer(queue->read_latency());
+      bytes_read = preadv(fd, iovecs.data(), iovecs.size(), start);
+    }
+    if (bytes_read < 0) {
+      return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+          Substitute("Error reading from $0 at byte offset: $1: $2",
+              *scan_range_->file_string(), start, GetStrErrMsg()));
+    }
+    queue->read_size()->Update(bytes_read);
+    if (bytes_read < end - start) {
+      // On Linux, we should only get partial reads from regular files at eof. Report
+      // the first range that was not read completely.
+      for (; i < next; ++i) {
+        const ReadRange& range = (*ranges)[i];
+        if (range.offset + range.len > start + bytes_read) {
+          return IncompleteReadError(
+              range, max<int64_t>(0, start + bytes_read - range.offset));
+        }
+      }
+      DCHECK(false) << "Short read did not cut off any range";
+    }
+    i = next;
+  }
+  return Status::OK();
+}
+
+Status LocalFileReader::DuplicateFd(int* fd) {
+  unique_lock<SpinLock> fs_lock(lock_);
+  RETURN_IF_ERROR(scan_range_->cancel_status_);
+  DCHECK(file_ != nullptr);
+  *fd = dup(fileno(file_));
+  if (*fd < 0) {
+    return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+        Substitute("Could not duplicate descriptor of file: $0: $1",
+            *scan_range_->file_string(), GetStrErrMsg()));
+  }
+  return Status::OK();
+}
+
 void LocalFileReader::CachedFile(uint8_t** data, int64_t* length) {
   *data = nullptr;
   *length = 0;
@@ -106,6 +241,10 @@ void LocalFileReader::Close() {
   if (file_ == nullptr) return;
   fclose(file_);
   file_ = nullptr;
+  if (direct_fd_ >= 0) {
+    close(direct_fd_);
+    direct_fd_ = -1;
+  }
   ImpaladMetrics::IO_MGR_NUM_OPEN_FILES->Increment(-1L);
   return;
 }
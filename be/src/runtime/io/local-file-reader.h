@@ -23,7 +23,8 @@ namespace impala {
 namespace io {
 
 /// File reader class for the local file system.
-/// It uses the standard C APIs from stdio.h
+/// It uses the standard C APIs from stdio.h. If --scratch_direct_io is true, reads of
+/// scratch files that meet the alignment requirements of O_DIRECT bypass the page cache.
 class LocalFileReader : public FileReader {
  public:
   LocalFileReader(ScanRange* scan_range) : FileReader(scan_range) {}
@@ -32,13 +33,24 @@ class LocalFileReader : public FileReader {
   virtual Status Open(bool use_file_handle_cache) override;
   virtual Status ReadFromPos(DiskQueue* disk_queue, int64_t file_offset, uint8_t* buffer,
       int64_t bytes_to_read, int64_t* bytes_read, bool* eof) override;
+  /// Merges ranges that are close to each other into a single preadv() call. Reads
+  /// through ReadFromPos() instead if the file is opened with O_DIRECT.
+  virtual Status ReadVectored(DiskQueue* queue, std::vector<ReadRange>* ranges) override;
   /// We don't cache files of the local file system.
   virtual void CachedFile(uint8_t** data, int64_t* length) override;
   virtual void Close() override;
 
+  /// Sets 'fd' to a duplicate of the descriptor of the file opened by Open(), which the
+  /// caller must close. Returns an error if the range was cancelled.
+  Status DuplicateFd(int* fd);
+
  private:
   /// Points to a C FILE object between calls to Open() and Close(), otherwise nullptr.
   FILE* file_ = nullptr;
+
+  /// A descriptor of the same file opened with O_DIRECT, for the aligned reads of
+  /// scratch files. -1 if direct I/O is not used or not supported by the filesystem.
+  int direct_fd_ = -1;
 };
 
 }
@@ -121,6 +121,17 @@ int LocalFileSystem::FcloseAux(FILE* file_handle) {
   return fclose(file_handle);
 }
 
+Status LocalFileSystem::Pwrite(int file_desc, const WriteRange* range) {
+  DCHECK(range != nullptr);
+  int64_t bytes_written = pwrite(file_desc, range->data(), range->len(), range->offset());
+  if (bytes_written < range->len()) {
+    return ErrorConverter::GetErrorStatusFromErrno("pwrite()", range->file(), errno,
+        {{"offset", SimpleItoa(range->offset())},
+            {"range_length", SimpleItoa(range->len())}});
+  }
+  return Status::OK();
+}
+
 Status LocalFileSystem::Write(int file_desc, const WriteRange* range) {
   DCHECK(range != nullptr);
   int64_t bytes_written = write(file_desc, range->data(), range->len());
@@ -18,6 +18,8 @@
 #ifndef IMPALA_RUNTIME_IO_LOCAL_FILE_SYSTEM_H
 #define IMPALA_RUNTIME_IO_LOCAL_FILE_SYSTEM_H
 
+#include <cstdint>
+
 #include "common/status.h"
 
 namespace impala {
@@ -46,6 +48,20 @@ public:
  // Wrapper function to use write() to write the bytes.
  Status Write(int file_desc, const WriteRange* range);
 
+ // Wrapper function to use pwrite() to write the bytes at the offset of the range.
+ Status Pwrite(int file_desc, const WriteRange* range);
+
+ // The alignment of the buffers, lengths and file offsets of reads and writes on files
+ // opened with O_DIRECT. The logical block size of most devices is at most this large.
+ static constexpr int64_t DIRECT_IO_ALIGNMENT = 4096;
+
+ // Returns true if a read or write of 'len' bytes at file offset 'offset' of 'buffer'
+ // can be done on a file opened with O_DIRECT.
+ static bool IsDirectIoAligned(const void* buffer, int64_t len, int64_t offset) {
+   return reinterpret_cast<uintptr_t>(buffer) % DIRECT_IO_ALIGNMENT == 0
+       && len % DIRECT_IO_ALIGNMENT == 0 && offset % DIRECT_IO_ALIGNMENT == 0;
+ }
+
 protected:
   // Wrapper functions around open(), fdopen(), fseek(), fwrite() and fclose().
   // Introduced so that fault injection can be implemented through inheritance.
@@ -15,6 +15,7 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <algorithm>
 
@@ -27,6 +28,8 @@
 
 #include "common/names.h"
 
+DECLARE_bool(scratch_direct_io);
+
 namespace impala {
 namespace io {
 
@@ -72,13 +75,25 @@ Status LocalFileWriter::WriteOne(WriteRange* write_range) {
   Status close_status = Status::OK();
   DiskQueue* queue = io_mgr_->disk_queues_[write_range->disk_id()];
 
+  // Bypass the page cache if the range meets the alignment requirements of O_DIRECT.
+  // Unaligned ranges, e.g. compressed pages, are written through the page cache.
+  bool direct_io = FLAGS_scratch_direct_io
+      && LocalFileSystem::IsDirectIoAligned(
+          write_range->data(), write_range->len(), write_range->offset());
+
   {
     ScopedHistogramTimer write_timer(queue->write_latency());
-    ret_status = io_mgr_->local_file_system_->OpenForWrite(
-        write_range->file(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR, &file_handle);
+    ret_status = io_mgr_->local_file_system_->OpenForWrite(write_range->file(),
+        O_RDWR | O_CREAT | (direct_io ? O_DIRECT : 0), S_IRUSR | S_IWUSR, &file_handle);
+    if (!ret_status.ok() && direct_io) {
+      // The filesystem may not support O_DIRECT, e.g. tmpfs.
+      direct_io = false;
+      ret_status = io_mgr_->local_file_system_->OpenForWrite(
+          write_range->file(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR, &file_handle);
+    }
     if (!ret_status.ok()) goto end;
 
-    ret_status = io_mgr_->WriteRangeHelper(file_handle, write_range);
+    ret_status = io_mgr_->WriteRangeHelper(file_handle, write_range, direct_io);
 
     close_status = io_mgr_->local_file_system_->Fclose(file_handle, write_range->file());
     if (ret_status.ok() && !close_status.ok()) ret_status = close_status;
@@ -18,6 +18,7 @@
 #include "runtime/io/disk-io-mgr-internal.h"
 
 #include "runtime/exec-env.h"
+#include "util/histogram-metric.h"
 
 #include "common/names.h"
 #include "common/thread-debug-info.h"
@@ -50,6 +51,17 @@ class RequestContext::PerDiskState {
 
   bool is_on_queue() const { return is_on_queue_.Load() != 0; }
 
+  int64_t io_deficit() const { return io_deficit_.Load(); }
+  void AddIoDeficit(int64_t bytes) { io_deficit_.Add(bytes); }
+
+  /// Called when the context has no work left for this disk. Like a flow in deficit
+  /// round robin whose queue became empty, it gives up a positive deficit. A negative
+  /// deficit is kept, so that contexts can't avoid paying for large requests.
+  void ResetIoDeficit() {
+    int64_t deficit = io_deficit_.Load();
+    if (deficit > 0) io_deficit_.CompareAndSwap(deficit, 0);
+  }
+
   int num_threads_in_op() const { return num_threads_in_op_.Load(); }
 
   const InternalQueue<ScanRange>* unstarted_scan_ranges() const {
@@ -152,6 +164,11 @@ class RequestContext::PerDiskState {
   /// TODO: this could be combined with 'num_threads_in_op_' to be a single refcount.
   AtomicInt32 is_on_queue_{0};
 
+  /// The deficit round robin deficit of this context on the disk queue, in bytes. See
+  /// DiskQueue. Charged in GetNextRequestRange() while holding the context lock and
+  /// topped up by the disk queue while holding the disk queue lock, so it is atomic.
+  AtomicInt64 io_deficit_{0};
+
   /// For each disks, the number of request ranges that have not been fully read.
   /// In the non-cancellation path, this will hit 0, and done will be set to true
   /// by the disk thread. This is undefined in the cancellation path (the various
@@ -209,7 +226,9 @@ void RequestContext::ReadDone(int disk_id, ReadOutcome outcome, ScanRange* range
   RequestContext::PerDiskState* disk_state = &disk_states_[disk_id];
   DCHECK_GT(disk_state->num_threads_in_op(), 0);
   if (outcome == ReadOutcome::SUCCESS_EOSR) {
-    // No more reads to do.
+    // No more reads to do. A range with parallel reads may have been scheduled again by
+    // one of its other reads.
+    if (range->in_queue()) disk_state->in_flight_ranges()->Remove(range);
     --disk_state->num_remaining_ranges();
   } else if (outcome == ReadOutcome::SUCCESS_NO_EOSR) {
     // Schedule the next read.
@@ -218,9 +237,12 @@ void RequestContext::ReadDone(int disk_id, ReadOutcome outcome, ScanRange* range
     }
   } else if (outcome == ReadOutcome::BLOCKED_ON_BUFFER) {
     // Do nothing - the caller must add a buffer to the range or cancel it.
+  } else if (outcome == ReadOutcome::OTHER_READS_IN_FLIGHT) {
+    // Do nothing - another read of the range reports its outcome.
   } else {
     DCHECK(outcome == ReadOutcome::CANCELLED) << static_cast<int>(outcome);
     // No more reads - clean up the scan range.
+    if (range->in_queue()) disk_state->in_flight_ranges()->Remove(range);
     --disk_state->num_remaining_ranges();
     RemoveActiveScanRangeLocked(lock, range);
   }
@@ -423,6 +445,8 @@ Status RequestContext::AddScanRanges(
     RETURN_IF_ERROR(parent_->ValidateScanRange(ranges[i]));
     ranges[i]->InitInternal(parent_, this);
   }
+  // Start opening the file handles before the disk threads get to the ranges.
+  for (ScanRange* range : ranges) parent_->PrefetchFileHandle(range);
 
   unique_lock<mutex> lock(lock_);
   DCHECK(Validate()) << endl << DebugString();
@@ -523,6 +547,12 @@ Status RequestContext::StartScanRange(ScanRange* range, bool* needs_buffers) {
     if (cached_read_succeeded) return Status::OK();
     // Cached read failed, fall back to normal read path.
   }
+  if (range->preloaded_) {
+    // Nothing to read. Like a cached read, the range is not added to a disk queue.
+    range->EnqueuePreloadedBuffer();
+    *needs_buffers = false;
+    return Status::OK();
+  }
   // If we don't have a buffer yet, the caller must allocate buffers for the range.
   *needs_buffers =
       range->external_buffer_tag() == ScanRange::ExternalBufferTag::NO_BUFFER;
@@ -613,6 +643,7 @@ RequestRange* RequestContext::GetNextRequestRange(int disk_id) {
 
   // Check if reader has been cancelled
   if (state_ == RequestContext::Cancelled) {
+    request_disk_state->ResetIoDeficit();
     request_disk_state->DecrementDiskThread(request_lock, this);
     return nullptr;
   }
@@ -661,6 +692,7 @@ RequestRange* RequestContext::GetNextRequestRange(int disk_id) {
   // are eligible since the disk threads do not start new ranges on their own.
   if (request_disk_state->in_flight_ranges()->empty()) {
     // There are no inflight ranges, nothing to do.
+    request_disk_state->ResetIoDeficit();
     request_disk_state->DecrementDiskThread(request_lock, this);
     return nullptr;
   }
@@ -668,6 +700,11 @@ RequestRange* RequestContext::GetNextRequestRange(int disk_id) {
   RequestRange* range = request_disk_state->in_flight_ranges()->Dequeue();
   DCHECK(range != nullptr);
 
+  // Charge the context for the request before it goes back on the queue, so that the
+  // queue decides whether its turn is over. A read issues at most one max-sized buffer
+  // of the range.
+  request_disk_state->AddIoDeficit(-min(range->len(), parent_->max_buffer_size()));
+
   // Now that we've picked a request range, put the context back on the queue so
   // another thread can pick up another request range for this context.
   request_disk_state->ScheduleContext(request_lock, this, disk_id);
@@ -828,6 +865,20 @@ void RequestContext::PerDiskState::ScheduleContext(const unique_lock<mutex>& con
   }
 }
 
+int64_t RequestContext::io_deficit(int disk_id) const {
+  return disk_states_[disk_id].io_deficit();
+}
+
+void RequestContext::AddIoDeficit(int disk_id, int64_t bytes) {
+  disk_states_[disk_id].AddIoDeficit(bytes);
+}
+
+void RequestContext::UpdateQueueStats(int64_t queue_wait, int64_t queue_depth) {
+  if (queue_delay_metric_ != nullptr) queue_delay_metric_->Update(queue_wait);
+  if (queue_wait_counter_ != nullptr) queue_wait_counter_->UpdateCounter(queue_wait);
+  if (queue_depth_counter_ != nullptr) queue_depth_counter_->UpdateCounter(queue_depth);
+}
+
 void RequestContext::IncrementDiskThreadAfterDequeue(int disk_id) {
   disk_states_[disk_id].IncrementDiskThreadAfterDequeue();
 }
@@ -846,6 +897,12 @@ void RequestContext::ScheduleScanRange(
   DCHECK(lock.mutex() == &lock_ && lock.owns_lock());
   DCHECK_EQ(state_, Active);
   DCHECK(range != nullptr);
+  if (range->max_parallel_reads_ > 1) {
+    // A range with parallel reads may already have been scheduled by another of its
+    // reads, or other threads may have started or finished all its reads since the
+    // caller decided to schedule it.
+    if (range->in_queue() || !range->CanStartParallelRead()) return;
+  }
   RequestContext::PerDiskState& state = disk_states_[range->disk_id()];
   state.in_flight_ranges()->Enqueue(range);
   state.ScheduleContext(lock, this, range->disk_id());
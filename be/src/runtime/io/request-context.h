@@ -25,6 +25,8 @@
 
 namespace impala {
 
+class HistogramMetric;
+
 /// Location at which a new ScanRange would be enqueued.
 enum class EnqueueLocation { HEAD, TAIL };
 
@@ -208,6 +210,18 @@ class RequestContext {
     data_cache_miss_bytes_counter_ = counter;
   }
 
+  void set_read_ahead_depth_counter(RuntimeProfile::SummaryStatsCounter* counter) {
+    read_ahead_depth_counter_ = counter;
+  }
+
+  void set_queue_wait_counter(RuntimeProfile::SummaryStatsCounter* counter) {
+    queue_wait_counter_ = counter;
+  }
+
+  void set_queue_depth_counter(RuntimeProfile::SummaryStatsCounter* counter) {
+    queue_depth_counter_ = counter;
+  }
+
   TUniqueId instance_id() const { return instance_id_; }
   void set_instance_id(const TUniqueId& instance_id) {
     instance_id_ = instance_id;
@@ -218,6 +232,24 @@ class RequestContext {
     query_id_ = query_id;
   }
 
+  /// The weight of this context when the disk queues share their bandwidth between
+  /// contexts. See DiskQueue. Must be set before any ranges are added.
+  int io_weight() const { return io_weight_; }
+  void set_io_weight(int io_weight) {
+    DCHECK_GE(io_weight, 1);
+    io_weight_ = io_weight;
+  }
+
+  /// Histogram of the time this context waits on the disk queues before a disk thread
+  /// picks it up. Not owned and may be NULL. Must be set before any ranges are added.
+  HistogramMetric* queue_delay_metric() const { return queue_delay_metric_; }
+  void set_queue_delay_metric(HistogramMetric* metric) { queue_delay_metric_ = metric; }
+
+  /// Called by a disk thread that dequeued this context after it waited 'queue_wait' ns
+  /// on a disk queue with 'queue_depth' contexts, including this one. Updates
+  /// 'queue_delay_metric_' and the queue counters of the profile.
+  void UpdateQueueStats(int64_t queue_wait, int64_t queue_depth);
+
  private:
   DISALLOW_COPY_AND_ASSIGN(RequestContext);
   class PerDiskState;
@@ -253,6 +285,14 @@ class RequestContext {
   /// RequestContext from being destroyed underneath them.
   void IncrementDiskThreadAfterDequeue(int disk_id);
 
+  /// Returns the deficit round robin deficit of this context on the queue of 'disk_id',
+  /// i.e. the number of bytes it may still read or write in its current turn. May be
+  /// negative if the last request was larger than the deficit.
+  int64_t io_deficit(int disk_id) const;
+
+  /// Adds 'bytes' to the deficit of this context on the queue of 'disk_id'.
+  void AddIoDeficit(int disk_id, int64_t bytes);
+
   /// Called when the disk queue for disk 'disk_id' shuts down. Only used in backend
   /// tests - disk queues are not shut down for the singleton DiskIoMgr in a daemon.
   void UnregisterDiskQueue(int disk_id);
@@ -359,6 +399,14 @@ class RequestContext {
   RuntimeProfile::Counter* data_cache_hit_bytes_counter_ = nullptr;
   RuntimeProfile::Counter* data_cache_miss_bytes_counter_ = nullptr;
 
+  /// Read-ahead depths chosen by scan ranges with adaptive read-ahead.
+  RuntimeProfile::SummaryStatsCounter* read_ahead_depth_counter_ = nullptr;
+
+  /// Time waited on the disk queues and the depth of the queues when this context was
+  /// dequeued, see UpdateQueueStats().
+  RuntimeProfile::SummaryStatsCounter* queue_wait_counter_ = nullptr;
+  RuntimeProfile::SummaryStatsCounter* queue_depth_counter_ = nullptr;
+
   /// Total number of bytes read locally, updated at end of each range scan
   AtomicInt64 bytes_read_local_{0};
 
@@ -443,6 +491,12 @@ class RequestContext {
 
   TUniqueId instance_id_;
   TUniqueId query_id_;
+
+  /// See io_weight().
+  int io_weight_ = 1;
+
+  /// See queue_delay_metric().
+  HistogramMetric* queue_delay_metric_ = nullptr;
 };
 }
 }
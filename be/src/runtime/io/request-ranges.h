@@ -20,6 +20,8 @@
 #include <cstdint>
 #include <deque>
 #include <functional>
+#include <limits>
+#include <map>
 #include <mutex>
 
 #include <boost/thread/shared_mutex.hpp>
@@ -101,6 +103,9 @@ class BufferDescriptor {
   /// true if the current scan range is complete
   bool eosr_ = false;
 
+  /// Offset in the file of the read into this buffer. Set when the read is started.
+  int64_t file_offset_ = 0;
+
   // Handle to an allocated buffer and the client used to allocate it buffer. Only used
   // for non-external buffers.
   BufferPool::ClientHandle* bp_client_ = nullptr;
@@ -127,6 +132,10 @@ enum class ReadOutcome {
   SUCCESS_NO_EOSR,
   // The scan range is blocked waiting for the next buffer.
   BLOCKED_ON_BUFFER,
+  // Other reads of the scan range are in flight on other disk threads and one of them
+  // will report the outcome for the range, or it was already reported. Only returned
+  // for ranges with parallel reads.
+  OTHER_READS_IN_FLIGHT,
   // The scan range is cancelled (either by caller or because of an error). No more
   // reads will be scheduled.
   CANCELLED
@@ -215,6 +224,16 @@ struct BufferOpts {
     return BufferOpts(cache_options, client_buffer, client_buffer_len);
   }
 
+  /// Set options for a scan range whose data the client already read into
+  /// 'client_buffer', e.g. as part of a larger read that covered several ranges. The
+  /// range is not read from the file: starting it makes the buffer available to the
+  /// reader right away. 'client_buffer_len' must fit the entire scan range.
+  static BufferOpts Preloaded(uint8_t* client_buffer, int64_t client_buffer_len) {
+    BufferOpts opts(NO_CACHING, client_buffer, client_buffer_len);
+    opts.preloaded_ = true;
+    return opts;
+  }
+
   /// Use only when you don't want to to read the entire scan range, but only sub-ranges
   /// in it. In this case you can copy the relevant parts from the HDFS cache into the
   /// client buffer. The length of the buffer, 'client_buffer_len' must fit the
@@ -241,6 +260,9 @@ struct BufferOpts {
   /// A destination buffer provided by the client, nullptr and -1 if no buffer.
   uint8_t* const client_buffer_;
   const int64_t client_buffer_len_;
+
+  /// True if 'client_buffer_' already holds the data of the range.
+  bool preloaded_ = false;
 };
 
 /// ScanRange description. The caller must call Reset() to initialize the fields
@@ -298,7 +320,7 @@ class ScanRange : public RequestRange {
   int cache_options() const { return cache_options_; }
   bool UseHdfsCache() const { return (cache_options_ & BufferOpts::USE_HDFS_CACHE) != 0; }
   bool UseDataCache() const { return (cache_options_ & BufferOpts::USE_DATA_CACHE) != 0; }
-  bool read_in_flight() const { return read_in_flight_; }
+  bool read_in_flight() const { return num_reads_in_flight_ > 0; }
   bool expected_local() const { return expected_local_; }
   int64_t bytes_to_read() const { return bytes_to_read_; }
   bool use_local_buffer() const { return use_local_buffer_; }
@@ -362,6 +384,10 @@ class ScanRange : public RequestRange {
   Status ReadFromCache(const std::unique_lock<std::mutex>& reader_lock,
       bool* read_succeeded) WARN_UNUSED_RESULT;
 
+  /// Enqueues the client buffer, which already holds the data of the range, as the
+  /// only ready buffer. Used instead of reading the range if 'preloaded_' is true.
+  void EnqueuePreloadedBuffer();
+
   /// Add buffers for the range to read data into and schedule the range if blocked.
   /// If 'returned' is true, the buffers returned from GetNext() that are being recycled
   /// via ReturnBuffer(). Otherwise the buffers are newly allocated buffers to be added.
@@ -379,6 +405,87 @@ class ScanRange : public RequestRange {
   /// buffer reader.
   ReadOutcome DoReadInternal(DiskQueue* queue, int disk_id, bool use_local_buffer);
 
+  /// Takes the buffer for the next read, increments 'num_reads_in_flight_' and returns
+  /// the reader to read with in 'file_reader' and the number of bytes to read into the
+  /// buffer in 'bytes_to_read'. Returns false and sets 'outcome' if the range is
+  /// cancelled, no buffer is available or all reads were started already. If the range
+  /// has parallel reads and another one can be started, schedules the range again so
+  /// that another disk thread starts it. Caller must not hold 'lock_'.
+  bool StartRead(bool use_local_buffer, std::unique_ptr<BufferDescriptor>* buffer_desc,
+      FileReader** file_reader, int64_t* bytes_to_read, ReadOutcome* outcome);
+
+  /// Returns the maximum number of reads of this range that may be in flight at the same
+  /// time. Ranges of S3 and ABFS files which are read through the file handle cache into
+  /// I/O manager buffers can be read in parallel if they are at least
+  /// 'min_parallel_remote_read_range_bytes' long. Each read then borrows its own file
+  /// handle. All other ranges are read with one read at a time, except for ranges of
+  /// local files if --parallel_local_reads_for_testing is set.
+  int MaxParallelReads() const;
+
+  /// Returns true if the file handle cache should be used to open the file.
+  bool UseFileHandleCache() const;
+
+  /// Completes a read started by StartRead() into 'buffer_desc' with 'read_status'.
+  /// Enqueues the buffer if the read succeeded, otherwise cancels the range.
+  ReadOutcome FinishRead(const Status& read_status, bool eof, FileReader* file_reader,
+      std::unique_ptr<BufferDescriptor> buffer_desc);
+
+  /// Same as FinishRead() for a successful read of a range with parallel reads. Reads
+  /// may finish in any order, so 'buffer_desc' is held back in 'out_of_order_buffers_'
+  /// until the buffers before it are enqueued.
+  ReadOutcome FinishParallelRead(
+      FileReader* file_reader, std::unique_ptr<BufferDescriptor> buffer_desc);
+
+  /// Returns true if a range with parallel reads can start another read, i.e. it is not
+  /// cancelled, reads were not started for all its bytes yet and the read-ahead depth
+  /// allows another read. Caller must not hold 'lock_'.
+  bool CanStartParallelRead();
+
+  /// Returns true if fewer than 'read_ahead_depth_' buffers are being read or waiting to
+  /// be returned by GetNext(). The caller must hold 'lock_' via 'scan_range_lock'.
+  bool ReadAheadAllowed(const std::unique_lock<std::mutex>& scan_range_lock) const;
+
+  /// Called from GetNext() before it removes a buffer from 'ready_buffers_' to adapt
+  /// 'read_ahead_depth_' to the consumer. 'consumer_waited' is true if GetNext() had to
+  /// wait for the buffer. The caller must hold 'lock_' via 'scan_range_lock'.
+  void AdaptReadAheadDepth(
+      const std::unique_lock<std::mutex>& scan_range_lock, bool consumer_waited);
+
+  /// Returns the outcome for a disk thread that found the range with parallel reads
+  /// cancelled. Only the thread that finds no other reads in flight reports CANCELLED,
+  /// and only once, so that the range is cleaned up exactly once. The caller must hold
+  /// 'lock_' via 'scan_range_lock'.
+  ReadOutcome ParallelReadCancelled(const std::unique_lock<std::mutex>& scan_range_lock);
+
+  /// State of a read that DiskQueue::IoUringThreadLoop() issues through an IoUring.
+  struct AsyncRead {
+    std::unique_ptr<BufferDescriptor> buffer_desc;
+    FileReader* file_reader = nullptr;
+    /// A duplicate of the descriptor of the opened file, so that closing the file when
+    /// the range is cancelled cannot affect the read. Closed by FinishAsyncRead().
+    int fd = -1;
+    int64_t offset = 0;
+    int64_t len = 0;
+    /// Bytes read so far. A short read does not mean that the end of the file was
+    /// reached, so the rest of the read is issued again until it returns 0 bytes.
+    int64_t bytes_read = 0;
+  };
+
+  /// Returns true if the next read can be done with StartAsyncRead() and
+  /// FinishAsyncRead() instead of DoRead(), i.e. the range reads a local file without
+  /// sub-ranges.
+  bool CanReadAsync() const;
+
+  /// Prepares the next read like DoRead(), but instead of reading fills in 'read' with
+  /// the buffer, file descriptor, offset and length to read. Returns false and sets
+  /// 'outcome' if the read will not be issued, e.g. because the range is blocked on a
+  /// buffer or the file could not be opened.
+  bool StartAsyncRead(int disk_id, AsyncRead* read, ReadOutcome* outcome);
+
+  /// Finishes a read started by StartAsyncRead() after 'read->bytes_read' bytes were
+  /// read. If 'status' is an error, the read failed and the range is cancelled.
+  ReadOutcome FinishAsyncRead(DiskQueue* queue, AsyncRead* read, const Status& status);
+
   /// Cleans up a buffer that was not returned to the client.
   /// Either ReturnBuffer() or CleanUpBuffer() is called for every BufferDescriptor.
   /// The caller must hold 'lock_' via 'scan_range_lock'.
@@ -396,7 +503,7 @@ class ScanRange : public RequestRange {
   /// invoked by RequestContext::Cancel(), which removes the range itself to avoid
   /// invalidating its active_scan_ranges_ iterator. It is also invoked by disk IO
   /// threads to propagate a read error for a range that is in flight (i.e. when
-  /// read_error is true), so 'read_in_flight_' is set to false and threads in
+  /// read_error is true), so 'num_reads_in_flight_' is decremented and threads in
   /// WaitForInFlightRead() are woken up. Note that this is tearing down the FileReader,
   /// so it may block waiting for other threads that are performing IO.
   void CancelInternal(const Status& status, bool read_error);
@@ -464,8 +571,9 @@ class ScanRange : public RequestRange {
 
   /// Read the sub-ranges into buffer and track the current position in 'sub_range_pos_'.
   /// If cached data is available, then memcpy() from it instead of actually reading the
-  /// files. 'queue' is updated with the latencies and sizes of reads from the underlying
-  /// filesystem.
+  /// files. Otherwise, the parts of the sub-ranges that fit into the buffer are read
+  /// with one FileReader::ReadVectored() call. 'queue' is updated with the latencies and
+  /// sizes of reads from the underlying filesystem.
   Status ReadSubRanges(
       DiskQueue* queue, BufferDescriptor* buffer, bool* eof, FileReader* file_reader);
 
@@ -506,6 +614,10 @@ class ScanRange : public RequestRange {
   /// externally from DiskIoMgr that is associated with the scan range.
   ExternalBufferTag external_buffer_tag_;
 
+  /// True if the client buffer already holds the data of the range, see
+  /// BufferOpts::Preloaded().
+  bool preloaded_ = false;
+
   /// Valid if the 'external_buffer_tag_' is CLIENT_BUFFER.
   struct {
     /// Client-provided buffer to read the whole scan range into.
@@ -547,10 +659,40 @@ class ScanRange : public RequestRange {
   /// the scan range.
   int64_t iomgr_buffer_cumulative_bytes_used_ = 0;
 
-  /// True if a disk thread is currently doing a read for this scan range. Set to true in
-  /// DoRead() and set to false in EnqueueReadyBuffer() or CancelInternal() when the
-  /// read completes and any buffer used for the read is either enqueued or freed.
-  bool read_in_flight_ = false;
+  /// The number of reads that disk threads are currently doing for this scan range. At
+  /// most one unless the range has parallel reads. Incremented in StartRead() and
+  /// decremented in EnqueueReadyBuffer(), FinishParallelRead() or CancelInternal() when
+  /// the read completes and any buffer used for the read is either enqueued, held back
+  /// or freed.
+  int num_reads_in_flight_ = 0;
+
+  /// The maximum number of reads in flight, see MaxParallelReads(). Set in
+  /// InitInternal().
+  int max_parallel_reads_ = 1;
+
+  /// Number of bytes of the range that reads were started for. Equal to 'bytes_read_'
+  /// when no read is in flight.
+  int64_t bytes_started_ = 0;
+
+  /// Buffers of a range with parallel reads that were read before the buffers which
+  /// precede them in the file, keyed by their file offset. Always empty if
+  /// 'cancel_status_' is not OK.
+  std::map<int64_t, std::unique_ptr<BufferDescriptor>> out_of_order_buffers_;
+
+  /// True if CANCELLED was reported for a range with parallel reads, see
+  /// ParallelReadCancelled().
+  bool parallel_cancel_reported_ = false;
+
+  /// The maximum number of buffers of this range that are being read or waiting to be
+  /// returned by GetNext(). Unlimited unless --adaptive_scan_range_read_ahead is true.
+  /// Then it grows when the consumer waits for reads and shrinks when the buffers pile
+  /// up unconsumed, see AdaptReadAheadDepth(). Only used for ranges with NO_BUFFER.
+  int read_ahead_depth_ = std::numeric_limits<int>::max();
+
+  /// If true, the range is not scheduled because 'read_ahead_depth_' buffers are being
+  /// read or waiting to be returned. GetNext() schedules it again when the consumer
+  /// catches up.
+  bool read_ahead_blocked_ = false;
 
   /// If true, the last buffer for this scan range has been queued.
   /// If this is true and 'ready_buffers_' is empty, then no more buffers will be
@@ -574,7 +716,8 @@ class ScanRange : public RequestRange {
   /// cancelled.
   ConditionVariable buffer_ready_cv_;
 
-  /// Number of bytes read by this scan range.
+  /// Number of bytes read by this scan range. For ranges with parallel reads, only bytes
+  /// of buffers that were enqueued in 'ready_buffers_' are counted.
   int64_t bytes_read_ = 0;
 
   /// Polymorphic object that is responsible for doing file operations.
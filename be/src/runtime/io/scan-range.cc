@@ -21,7 +21,12 @@
 #include "runtime/io/hdfs-file-reader.h"
 #include "runtime/io/local-file-reader.h"
 #include "util/error-util.h"
+#include "util/event-tracer.h"
 #include "util/hdfs-util.h"
+#include "util/impalad-metrics.h"
+#include "util/metrics.h"
+#include "util/runtime-profile-counters.h"
+#include "util/time.h"
 
 #include "common/names.h"
 
@@ -34,12 +39,19 @@ using std::unique_lock;
 DECLARE_bool(cache_remote_file_handles);
 DECLARE_bool(cache_s3_file_handles);
 DECLARE_bool(cache_abfs_file_handles);
+DECLARE_int32(max_parallel_remote_reads_per_range);
+DECLARE_int64(min_parallel_remote_read_range_bytes);
+DECLARE_bool(parallel_local_reads_for_testing);
+DECLARE_bool(adaptive_scan_range_read_ahead);
+DECLARE_int32(stress_disk_read_delay_ms);
 
 // Implementation of the ScanRange functionality. Each ScanRange contains a queue
 // of ready buffers. For each ScanRange, there is only a single producer and
 // consumer thread, i.e. only one disk thread will push to a scan range at
 // any time and only one thread will remove from the queue. This is to guarantee
-// that buffers are queued and read in file order.
+// that buffers are queued and read in file order. Ranges with parallel reads are the
+// exception: several disk threads read into different buffers at a time, and
+// FinishParallelRead() queues the buffers in file order.
 bool ScanRange::EnqueueReadyBuffer(unique_ptr<BufferDescriptor> buffer) {
   DCHECK(buffer->buffer_ != nullptr) << "Cannot enqueue freed buffer";
   {
@@ -49,8 +61,8 @@ bool ScanRange::EnqueueReadyBuffer(unique_ptr<BufferDescriptor> buffer) {
     if (!buffer->is_cached()) {
       // All non-cached buffers are enqueued by disk threads. Indicate that the read
       // finished.
-      DCHECK(read_in_flight_);
-      read_in_flight_ = false;
+      DCHECK_EQ(num_reads_in_flight_, 1);
+      num_reads_in_flight_ = 0;
     }
     if (!cancel_status_.ok()) {
       // This range has been cancelled, no need to enqueue the buffer.
@@ -71,28 +83,49 @@ bool ScanRange::EnqueueReadyBuffer(unique_ptr<BufferDescriptor> buffer) {
 }
 
 Status ScanRange::GetNext(unique_ptr<BufferDescriptor>* buffer) {
+  SCOPED_TRACE_EVENT("ScanRange::GetNext");
   DCHECK(*buffer == nullptr);
   bool eosr;
+  bool schedule_next_read = false;
   {
     unique_lock<mutex> scan_range_lock(lock_);
     DCHECK(Validate()) << DebugString();
-    while (!all_buffers_returned(scan_range_lock) && ready_buffers_.empty()) {
-      buffer_ready_cv_.Wait(scan_range_lock);
+    const bool consumer_waited =
+        !all_buffers_returned(scan_range_lock) && ready_buffers_.empty();
+    if (consumer_waited) {
+      ScopedGaugeIncrement waiting_threads(
+          ImpaladMetrics::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO);
+      while (!all_buffers_returned(scan_range_lock) && ready_buffers_.empty()) {
+        buffer_ready_cv_.Wait(scan_range_lock);
+      }
     }
     // No more buffers to return - return the cancel status or OK if not cancelled.
     if (all_buffers_returned(scan_range_lock)) {
       // Wait until read finishes to ensure buffers are freed.
-      while (read_in_flight_) buffer_ready_cv_.Wait(scan_range_lock);
+      while (num_reads_in_flight_ > 0) buffer_ready_cv_.Wait(scan_range_lock);
       DCHECK_EQ(0, ready_buffers_.size());
       return cancel_status_;
     }
 
     // Remove the first ready buffer from the queue and return it
     DCHECK(!ready_buffers_.empty());
+    AdaptReadAheadDepth(scan_range_lock, consumer_waited);
     *buffer = move(ready_buffers_.front());
     ready_buffers_.pop_front();
     eosr = (*buffer)->eosr();
     DCHECK(!eosr || unused_iomgr_buffers_.empty()) << DebugString();
+    if (read_ahead_blocked_ && ReadAheadAllowed(scan_range_lock)) {
+      read_ahead_blocked_ = false;
+      schedule_next_read = !eosr_queued_;
+    }
+  }
+  if (schedule_next_read) {
+    // Must drop the ScanRange lock before acquiring the RequestContext lock.
+    unique_lock<mutex> reader_lock(reader_->lock_);
+    // Reader may have been cancelled after we dropped 'scan_range_lock' above.
+    if (reader_->state_ != RequestContext::Cancelled) {
+      reader_->ScheduleScanRange(reader_lock, this);
+    }
   }
 
   // Update tracking counters. The buffer has now moved from the IoMgr to the caller.
@@ -163,81 +196,119 @@ unique_ptr<BufferDescriptor> ScanRange::GetUnusedBuffer(
   return result;
 }
 
-ReadOutcome ScanRange::DoReadInternal(
-    DiskQueue* queue, int disk_id, bool use_local_buff) {
-  int64_t bytes_remaining = bytes_to_read_ - bytes_read_;
-  DCHECK_GT(bytes_remaining, 0);
-
-  unique_ptr<BufferDescriptor> buffer_desc;
-  FileReader* file_reader = nullptr;
-  {
-    unique_lock<mutex> lock(lock_);
-    DCHECK(!read_in_flight_);
-    if (!cancel_status_.ok()) return ReadOutcome::CANCELLED;
+bool ScanRange::StartRead(bool use_local_buff,
+    unique_ptr<BufferDescriptor>* buffer_desc, FileReader** file_reader,
+    int64_t* bytes_to_read, ReadOutcome* outcome) {
+  unique_lock<mutex> lock(lock_);
+  DCHECK(max_parallel_reads_ > 1 || num_reads_in_flight_ == 0);
+  if (!cancel_status_.ok()) {
+    *outcome = max_parallel_reads_ > 1 ? ParallelReadCancelled(lock) :
+                                         ReadOutcome::CANCELLED;
+    return false;
+  }
+  if (bytes_started_ == bytes_to_read_) {
+    // The range was scheduled again by a read that finished while other threads started
+    // the remaining reads.
+    DCHECK_GT(max_parallel_reads_, 1);
+    *outcome = ReadOutcome::OTHER_READS_IN_FLIGHT;
+    return false;
+  }
+  if (num_reads_in_flight_ >= max_parallel_reads_) {
+    // The next read is started once one of the reads in flight finishes.
+    *outcome = ReadOutcome::OTHER_READS_IN_FLIGHT;
+    return false;
+  }
 
-    if (external_buffer_tag_ == ScanRange::ExternalBufferTag::CLIENT_BUFFER) {
-      buffer_desc = unique_ptr<BufferDescriptor>(new BufferDescriptor(
-          this, client_buffer_.data, client_buffer_.len));
-    } else {
-      DCHECK(external_buffer_tag_ == ScanRange::ExternalBufferTag::NO_BUFFER)
-          << "This code path does not handle other buffer types, i.e. HDFS cache. "
-          << "external_buffer_tag_=" << static_cast<int>(external_buffer_tag_);
-      buffer_desc = GetUnusedBuffer(lock);
-      if (buffer_desc == nullptr) {
-        // No buffer available - the range will be rescheduled when a buffer is added.
-        blocked_on_buffer_ = true;
-        return ReadOutcome::BLOCKED_ON_BUFFER;
-      }
-      iomgr_buffer_cumulative_bytes_used_ += buffer_desc->buffer_len();
+  if (external_buffer_tag_ == ScanRange::ExternalBufferTag::CLIENT_BUFFER) {
+    *buffer_desc = unique_ptr<BufferDescriptor>(new BufferDescriptor(
+        this, client_buffer_.data, client_buffer_.len));
+  } else {
+    DCHECK(external_buffer_tag_ == ScanRange::ExternalBufferTag::NO_BUFFER)
+        << "This code path does not handle other buffer types, i.e. HDFS cache. "
+        << "external_buffer_tag_=" << static_cast<int>(external_buffer_tag_);
+    if (!ReadAheadAllowed(lock)) {
+      // GetNext() schedules the range again once the consumer catches up.
+      read_ahead_blocked_ = true;
+      *outcome = num_reads_in_flight_ > 0 ? ReadOutcome::OTHER_READS_IN_FLIGHT :
+                                            ReadOutcome::BLOCKED_ON_BUFFER;
+      return false;
     }
-    read_in_flight_ = true;
-    if (use_local_buff) {
-      file_reader = local_buffer_reader_.get();
-      file_ = disk_buffer_file_->path();
-    } else {
-      file_reader = file_reader_.get();
+    *buffer_desc = GetUnusedBuffer(lock);
+    if (*buffer_desc == nullptr) {
+      // No buffer available - the range will be rescheduled when a buffer is added.
+      blocked_on_buffer_ = true;
+      *outcome = ReadOutcome::BLOCKED_ON_BUFFER;
+      return false;
     }
-    use_local_buffer_ = use_local_buff;
+    iomgr_buffer_cumulative_bytes_used_ += (*buffer_desc)->buffer_len();
+  }
+  ++num_reads_in_flight_;
+  (*buffer_desc)->file_offset_ = offset_ + bytes_started_;
+  *bytes_to_read = min(bytes_to_read_ - bytes_started_, (*buffer_desc)->buffer_len());
+  bytes_started_ += *bytes_to_read;
+  if (use_local_buff) {
+    *file_reader = local_buffer_reader_.get();
+    file_ = disk_buffer_file_->path();
+  } else {
+    *file_reader = file_reader_.get();
   }
-  DCHECK(file_reader != nullptr);
+  use_local_buffer_ = use_local_buff;
+  DCHECK(*file_reader != nullptr);
+  const bool schedule_next_read = num_reads_in_flight_ < max_parallel_reads_
+      && bytes_started_ < bytes_to_read_ && !unused_iomgr_buffers_.empty()
+      && ReadAheadAllowed(lock);
+  lock.unlock();
+  if (schedule_next_read) {
+    // Let another disk thread start the next read while this thread does this one.
+    // Must drop the ScanRange lock before acquiring the RequestContext lock.
+    unique_lock<mutex> reader_lock(reader_->lock_);
+    // Reader may have been cancelled after we dropped 'lock' above.
+    if (reader_->state_ != RequestContext::Cancelled) {
+      reader_->ScheduleScanRange(reader_lock, this);
+    }
+  }
+  return true;
+}
 
-  // No locks in this section.  Only working on local vars.  We don't want to hold a
-  // lock across the read call.
+int ScanRange::MaxParallelReads() const {
+  if (FLAGS_max_parallel_remote_reads_per_range <= 1) return 1;
+  if (disk_file_ != nullptr || !sub_ranges_.empty()
+      || external_buffer_tag_ != ExternalBufferTag::NO_BUFFER
+      || len_ < FLAGS_min_parallel_remote_read_range_bytes) {
+    return 1;
+  }
+  // Tests read local files in parallel to exercise the parallel read path without S3.
+  if (fs_ == nullptr) {
+    return FLAGS_parallel_local_reads_for_testing ?
+        FLAGS_max_parallel_remote_reads_per_range : 1;
+  }
+  // Exclusive file handles cannot be shared by concurrent reads.
+  if (disk_id_ != io_mgr_->RemoteS3DiskId() && disk_id_ != io_mgr_->RemoteAbfsDiskId()) {
+    return 1;
+  }
+  if (!UseFileHandleCache()) return 1;
+  return FLAGS_max_parallel_remote_reads_per_range;
+}
+
+bool ScanRange::UseFileHandleCache() const {
   // To use the file handle cache:
   // 1. It must be enabled at the daemon level.
   // 2. The file is a local HDFS file (expected_local_) OR it is a remote HDFS file and
   //    'cache_remote_file_handles' is true
-  bool use_file_handle_cache = false;
-  if (is_file_handle_caching_enabled() &&
+  return is_file_handle_caching_enabled() &&
       (expected_local_ ||
        (FLAGS_cache_remote_file_handles && disk_id_ == io_mgr_->RemoteDfsDiskId()) ||
        (FLAGS_cache_s3_file_handles && disk_id_ == io_mgr_->RemoteS3DiskId()) ||
-       (FLAGS_cache_abfs_file_handles && disk_id_ == io_mgr_->RemoteAbfsDiskId()))) {
-    use_file_handle_cache = true;
-  }
-  Status read_status = file_reader->Open(use_file_handle_cache);
-  bool eof = false;
-  if (read_status.ok()) {
-    COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, 1L);
-    COUNTER_BITOR_IF_NOT_NULL(reader_->disks_accessed_bitmap_, 1LL << disk_id);
-
-    if (sub_ranges_.empty()) {
-      DCHECK(cache_.data == nullptr);
-      read_status =
-          file_reader->ReadFromPos(queue, offset_ + bytes_read_, buffer_desc->buffer_,
-              min(bytes_to_read() - bytes_read_, buffer_desc->buffer_len_),
-              &buffer_desc->len_, &eof);
-    } else {
-      read_status = ReadSubRanges(queue, buffer_desc.get(), &eof, file_reader);
-    }
-
-    COUNTER_ADD_IF_NOT_NULL(reader_->bytes_read_counter_, buffer_desc->len_);
-    COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, -1L);
-  }
+       (FLAGS_cache_abfs_file_handles && disk_id_ == io_mgr_->RemoteAbfsDiskId()));
+}
 
+ReadOutcome ScanRange::FinishRead(const Status& read_status, bool eof,
+    FileReader* file_reader, unique_ptr<BufferDescriptor> buffer_desc) {
   DCHECK(buffer_desc->buffer_ != nullptr);
   DCHECK(!buffer_desc->is_cached())
       << "Pure HDFS cache reads don't go through this code path.";
+  // 'max_parallel_reads_' does not change while reads are in flight.
+  const bool parallel_reads = max_parallel_reads_ > 1;
   if (!read_status.ok()) {
     // Free buffer to release resources before we cancel the range so that all buffers
     // are freed at cancellation.
@@ -247,10 +318,17 @@ ReadOutcome ScanRange::DoReadInternal(
     // Propagate 'read_status' to the scan range. This will also wake up any waiting
     // threads.
     CancelInternal(read_status, true);
+    if (parallel_reads) {
+      // The range and its RequestContext stay valid until this thread reports its
+      // outcome, since the context waits for all disk threads before it is unregistered.
+      unique_lock<mutex> lock(lock_);
+      return ParallelReadCancelled(lock);
+    }
     // At this point we cannot touch the state of this range because the client
     // may notice cancellation, then reuse the scan range.
     return ReadOutcome::CANCELLED;
   }
+  if (parallel_reads) return FinishParallelRead(file_reader, move(buffer_desc));
 
   {
     unique_lock<mutex> lock(lock_);
@@ -273,7 +351,209 @@ ReadOutcome ScanRange::DoReadInternal(
   return eosr ? ReadOutcome::SUCCESS_EOSR : ReadOutcome::SUCCESS_NO_EOSR;
 }
 
+ReadOutcome ScanRange::FinishParallelRead(
+    FileReader* file_reader, unique_ptr<BufferDescriptor> buffer_desc) {
+  bool enqueued = false;
+  bool eosr;
+  bool can_start_read;
+  {
+    unique_lock<mutex> lock(lock_);
+    DCHECK(Validate()) << DebugString();
+    DCHECK_GT(num_reads_in_flight_, 0);
+    --num_reads_in_flight_;
+    if (!cancel_status_.ok()) {
+      CleanUpBuffer(lock, move(buffer_desc));
+      // Wake up threads in WaitForInFlightRead().
+      buffer_ready_cv_.NotifyAll();
+      return ParallelReadCancelled(lock);
+    }
+    DCHECK(!eosr_queued_);
+    const int64_t file_offset = buffer_desc->file_offset_;
+    out_of_order_buffers_.emplace(file_offset, move(buffer_desc));
+    // Enqueue the buffers that directly follow the bytes that were enqueued already.
+    while (!out_of_order_buffers_.empty()
+        && out_of_order_buffers_.begin()->first == offset_ + bytes_read_) {
+      unique_ptr<BufferDescriptor> next = move(out_of_order_buffers_.begin()->second);
+      out_of_order_buffers_.erase(out_of_order_buffers_.begin());
+      bytes_read_ += next->len();
+      DCHECK_LE(bytes_read_, bytes_to_read_);
+      next->eosr_ = bytes_read_ == bytes_to_read_;
+      if (next->eosr_) {
+        DCHECK_EQ(num_reads_in_flight_, 0);
+        CleanUpUnusedBuffers(lock);
+        // No more reads for this scan range - we can close it before the client sees
+        // the last buffer.
+        file_reader->Close();
+        eosr_queued_ = true;
+      }
+      ready_buffers_.emplace_back(move(next));
+      enqueued = true;
+    }
+    eosr = eosr_queued_;
+    can_start_read = !eosr && bytes_started_ < bytes_to_read_;
+  }
+  if (enqueued) buffer_ready_cv_.NotifyOne();
+  // At this point, if eosr=true, then we cannot touch the state of this scan range
+  // because the client may notice eos, then reuse the scan range.
+  if (eosr) return ReadOutcome::SUCCESS_EOSR;
+  // If all reads were started, the read of the next buffer to enqueue is in flight.
+  return can_start_read ? ReadOutcome::SUCCESS_NO_EOSR :
+                          ReadOutcome::OTHER_READS_IN_FLIGHT;
+}
+
+bool ScanRange::CanStartParallelRead() {
+  DCHECK_GT(max_parallel_reads_, 1);
+  unique_lock<mutex> lock(lock_);
+  if (!cancel_status_.ok() || bytes_started_ == bytes_to_read_) return false;
+  if (!ReadAheadAllowed(lock)) {
+    read_ahead_blocked_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool ScanRange::ReadAheadAllowed(const unique_lock<mutex>& scan_range_lock) const {
+  DCHECK(scan_range_lock.mutex() == &lock_ && scan_range_lock.owns_lock());
+  const int64_t num_buffers_ahead =
+      num_reads_in_flight_ + ready_buffers_.size() + out_of_order_buffers_.size();
+  return num_buffers_ahead < read_ahead_depth_;
+}
+
+void ScanRange::AdaptReadAheadDepth(
+    const unique_lock<mutex>& scan_range_lock, bool consumer_waited) {
+  DCHECK(scan_range_lock.mutex() == &lock_ && scan_range_lock.owns_lock());
+  // The depth is fixed if the range was initialized without adaptive read-ahead.
+  if (read_ahead_depth_ == std::numeric_limits<int>::max()
+      || external_buffer_tag_ != ExternalBufferTag::NO_BUFFER) {
+    return;
+  }
+  // Parallel reads need a buffer each.
+  const int min_depth = max_parallel_reads_;
+  int new_depth = read_ahead_depth_;
+  if (consumer_waited) {
+    // Grow quickly, since the consumer is waiting on I/O. There is no point in a depth
+    // beyond the buffers that the range owns.
+    const int num_buffers = unused_iomgr_buffers_.size() + ready_buffers_.size()
+        + out_of_order_buffers_.size() + num_reads_in_flight_
+        + num_buffers_in_reader_.Load();
+    new_depth = max(min_depth, min(2 * read_ahead_depth_, num_buffers));
+  } else if (static_cast<int64_t>(ready_buffers_.size()) >= read_ahead_depth_) {
+    // All the buffers read ahead were waiting for the consumer.
+    new_depth = max(min_depth, read_ahead_depth_ - 1);
+  }
+  if (new_depth == read_ahead_depth_) return;
+  read_ahead_depth_ = new_depth;
+  if (reader_->read_ahead_depth_counter_ != nullptr) {
+    reader_->read_ahead_depth_counter_->UpdateCounter(read_ahead_depth_);
+  }
+}
+
+ReadOutcome ScanRange::ParallelReadCancelled(const unique_lock<mutex>& scan_range_lock) {
+  DCHECK(scan_range_lock.mutex() == &lock_ && scan_range_lock.owns_lock());
+  DCHECK(!cancel_status_.ok());
+  if (num_reads_in_flight_ > 0 || parallel_cancel_reported_) {
+    return ReadOutcome::OTHER_READS_IN_FLIGHT;
+  }
+  parallel_cancel_reported_ = true;
+  return ReadOutcome::CANCELLED;
+}
+
+ReadOutcome ScanRange::DoReadInternal(
+    DiskQueue* queue, int disk_id, bool use_local_buff) {
+  unique_ptr<BufferDescriptor> buffer_desc;
+  FileReader* file_reader = nullptr;
+  int64_t bytes_to_read_now;
+  ReadOutcome outcome;
+  if (!StartRead(use_local_buff, &buffer_desc, &file_reader, &bytes_to_read_now,
+          &outcome)) {
+    return outcome;
+  }
+  DCHECK_GT(bytes_to_read_now, 0);
+
+  // No locks in this section.  Only working on local vars.  We don't want to hold a
+  // lock across the read call.
+  Status read_status = file_reader->Open(UseFileHandleCache());
+  bool eof = false;
+  if (read_status.ok()) {
+    COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, 1L);
+    COUNTER_BITOR_IF_NOT_NULL(reader_->disks_accessed_bitmap_, 1LL << disk_id);
+
+    if (sub_ranges_.empty()) {
+      DCHECK(cache_.data == nullptr);
+      read_status = file_reader->ReadFromPos(queue, buffer_desc->file_offset_,
+          buffer_desc->buffer_, bytes_to_read_now, &buffer_desc->len_, &eof);
+      // Parallel reads of the range are enqueued in file order, which requires each of
+      // them to read all its bytes.
+      if (read_status.ok() && max_parallel_reads_ > 1
+          && buffer_desc->len_ != bytes_to_read_now) {
+        read_status = Status(TErrorCode::SCANNER_INCOMPLETE_READ, bytes_to_read_now,
+            buffer_desc->len_, file(), buffer_desc->file_offset_);
+      }
+    } else {
+      read_status = ReadSubRanges(queue, buffer_desc.get(), &eof, file_reader);
+    }
+
+    COUNTER_ADD_IF_NOT_NULL(reader_->bytes_read_counter_, buffer_desc->len_);
+    COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, -1L);
+  }
+  return FinishRead(read_status, eof, file_reader, move(buffer_desc));
+}
+
+bool ScanRange::CanReadAsync() const {
+  return fs_ == nullptr && disk_file_ == nullptr && sub_ranges_.empty()
+      && max_parallel_reads_ == 1;
+}
+
+bool ScanRange::StartAsyncRead(int disk_id, AsyncRead* read, ReadOutcome* outcome) {
+  DCHECK(CanReadAsync());
+  if (!StartRead(false, &read->buffer_desc, &read->file_reader, &read->len, outcome)) {
+    return false;
+  }
+  read->fd = -1;
+  Status status = read->file_reader->Open(UseFileHandleCache());
+  if (status.ok()) {
+    LocalFileReader* local_reader = static_cast<LocalFileReader*>(read->file_reader);
+    status = local_reader->DuplicateFd(&read->fd);
+  }
+  if (!status.ok()) {
+    *outcome = FinishRead(status, false, read->file_reader, move(read->buffer_desc));
+    return false;
+  }
+  read->offset = read->buffer_desc->file_offset_;
+  read->bytes_read = 0;
+  COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, 1L);
+  COUNTER_BITOR_IF_NOT_NULL(reader_->disks_accessed_bitmap_, 1LL << disk_id);
+  return true;
+}
+
+ReadOutcome ScanRange::FinishAsyncRead(
+    DiskQueue* queue, AsyncRead* read, const Status& status) {
+  DCHECK_GE(read->fd, 0);
+  close(read->fd);
+  read->fd = -1;
+  COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, -1L);
+#ifndef NDEBUG
+  // Like LocalFileReader::ReadFromPos(), to allow triggering races with cancellation.
+  if (FLAGS_stress_disk_read_delay_ms > 0) {
+    SleepForMs(FLAGS_stress_disk_read_delay_ms);
+  }
+#endif
+  bool eof = false;
+  if (!status.ok()) {
+    read->buffer_desc->len_ = 0;
+  } else {
+    DCHECK_LE(read->bytes_read, read->len);
+    read->buffer_desc->len_ = read->bytes_read;
+    // Short reads are re-issued, so fewer bytes are only read at the end of the file.
+    eof = read->bytes_read < read->len;
+    queue->read_size()->Update(read->bytes_read);
+    COUNTER_ADD_IF_NOT_NULL(reader_->bytes_read_counter_, read->bytes_read);
+  }
+  return FinishRead(status, eof, read->file_reader, move(read->buffer_desc));
+}
+
 ReadOutcome ScanRange::DoRead(DiskQueue* queue, int disk_id) {
+  SCOPED_TRACE_EVENT("DiskIoMgr::Read");
   bool use_local_buffer = false;
   if (disk_file_ != nullptr && disk_file_->disk_type() != DiskFileType::LOCAL) {
     // The sequence for acquiring the locks should always be from the local to
@@ -306,6 +586,9 @@ ReadOutcome ScanRange::DoRead(DiskQueue* queue, int disk_id) {
 Status ScanRange::ReadSubRanges(
     DiskQueue* queue, BufferDescriptor* buffer_desc, bool* eof, FileReader* file_reader) {
   buffer_desc->len_ = 0;
+  // The pieces of the sub-ranges that fit into the buffer. They are read with a single
+  // FileReader::ReadVectored() call.
+  vector<FileReader::ReadRange> reads;
   while (buffer_desc->len() < buffer_desc->buffer_len()
       && sub_range_pos_.index < sub_ranges_.size()) {
     SubRange& sub_range = sub_ranges_[sub_range_pos_.index];
@@ -317,17 +600,7 @@ Status ScanRange::ReadSubRanges(
       memcpy(buffer_desc->buffer_ + buffer_desc->len(),
           cache_.data + offset, bytes_to_read);
     } else {
-      int64_t current_bytes_read;
-      Status read_status = file_reader->ReadFromPos(queue, offset,
-          buffer_desc->buffer_ + buffer_desc->len(), bytes_to_read, &current_bytes_read,
-          eof);
-      if (!read_status.ok()) return read_status;
-      if (current_bytes_read != bytes_to_read) {
-        DCHECK(*eof);
-        DCHECK_LT(current_bytes_read, bytes_to_read);
-        return Status(TErrorCode::SCANNER_INCOMPLETE_READ, bytes_to_read,
-            current_bytes_read, file(), offset);
-      }
+      reads.push_back({offset, bytes_to_read, buffer_desc->buffer_ + buffer_desc->len()});
     }
 
     buffer_desc->len_ += bytes_to_read;
@@ -337,7 +610,8 @@ Status ScanRange::ReadSubRanges(
       sub_range_pos_.bytes_read = 0;
     }
   }
-  return Status::OK();
+  if (reads.empty()) return Status::OK();
+  return file_reader->ReadVectored(queue, &reads);
 }
 
 void ScanRange::SetBlockedOnBuffer() {
@@ -398,8 +672,8 @@ void ScanRange::CancelInternal(const Status& status, bool read_error) {
       unique_lock<SpinLock> fs_lock(file_reader->lock());
       DCHECK(Validate()) << DebugString();
       // If already cancelled, preserve the original reason for cancellation. Most of the
-      // cleanup is not required if already cancelled, but we need to set
-      // 'read_in_flight_' to false.
+      // cleanup is not required if already cancelled, but we need to decrement
+      // 'num_reads_in_flight_'.
       if (cancel_status_.ok()) cancel_status_ = status;
     }
 
@@ -409,12 +683,16 @@ void ScanRange::CancelInternal(const Status& status, bool read_error) {
       CleanUpBuffer(scan_range_lock, move(ready_buffers_.front()));
       ready_buffers_.pop_front();
     }
+    for (auto& entry : out_of_order_buffers_) {
+      CleanUpBuffer(scan_range_lock, move(entry.second));
+    }
+    out_of_order_buffers_.clear();
 
     /// Clean up buffers that we don't need any more because we won't read any more data.
     CleanUpUnusedBuffers(scan_range_lock);
     if (read_error) {
-      DCHECK(read_in_flight_);
-      read_in_flight_ = false;
+      DCHECK_GT(num_reads_in_flight_, 0);
+      --num_reads_in_flight_;
     }
   }
   buffer_ready_cv_.NotifyAll();
@@ -432,7 +710,7 @@ void ScanRange::CancelInternal(const Status& status, bool read_error) {
 
 void ScanRange::WaitForInFlightRead() {
   unique_lock<mutex> scan_range_lock(lock_);
-  while (read_in_flight_) buffer_ready_cv_.Wait(scan_range_lock);
+  while (num_reads_in_flight_ > 0) buffer_ready_cv_.Wait(scan_range_lock);
 }
 
 string ScanRange::DebugString() const {
@@ -441,10 +719,15 @@ string ScanRange::DebugString() const {
   if (file_reader_) ss << " " << file_reader_->DebugString();
   ss << " cancel_status=" << cancel_status_.GetDetail()
      << " buffer_queue=" << ready_buffers_.size()
+     << " out_of_order_buffers=" << out_of_order_buffers_.size()
+     << " num_reads_in_flight=" << num_reads_in_flight_
+     << " max_parallel_reads=" << max_parallel_reads_
      << " num_buffers_in_readers=" << num_buffers_in_reader_.Load()
      << " unused_iomgr_buffers=" << unused_iomgr_buffers_.size()
      << " unused_iomgr_buffer_bytes=" << unused_iomgr_buffer_bytes_
-     << " blocked_on_buffer=" << blocked_on_buffer_;
+     << " blocked_on_buffer=" << blocked_on_buffer_
+     << " read_ahead_depth=" << read_ahead_depth_
+     << " read_ahead_blocked=" << read_ahead_blocked_;
   return ss.str();
 }
 
@@ -459,6 +742,16 @@ bool ScanRange::Validate() {
     LOG(ERROR) << "Cancelled range should not have queued buffers " << DebugString();
     return false;
   }
+  if (!cancel_status_.ok() && !out_of_order_buffers_.empty()) {
+    LOG(ERROR) << "Cancelled range should not hold back buffers " << DebugString();
+    return false;
+  }
+  if (bytes_started_ < bytes_read_ || bytes_started_ > bytes_to_read_) {
+    LOG(ERROR) << "Bytes started tracking is wrong. bytes_started_=" << bytes_started_
+               << " bytes_read_=" << bytes_read_
+               << " bytes_to_read_=" << bytes_to_read_;
+    return false;
+  }
   int64_t unused_iomgr_buffer_bytes = 0;
   for (auto& buffer : unused_iomgr_buffers_)
     unused_iomgr_buffer_bytes += buffer->buffer_len();
@@ -476,7 +769,8 @@ bool ScanRange::Validate() {
                << " eosr_queued: " << eosr_queued_;
     return false;
   }
-  if (!is_finished && blocked_on_buffer_ && !unused_iomgr_buffers_.empty()) {
+  if (!is_finished && blocked_on_buffer_ && !read_ahead_blocked_
+      && !unused_iomgr_buffers_.empty()) {
     LOG(ERROR) << "Blocked despite having buffers: " << DebugString();
     return false;
   }
@@ -488,8 +782,9 @@ ScanRange::ScanRange()
     external_buffer_tag_(ExternalBufferTag::NO_BUFFER) {}
 
 ScanRange::~ScanRange() {
-  DCHECK(!read_in_flight_);
+  DCHECK_EQ(0, num_reads_in_flight_);
   DCHECK_EQ(0, ready_buffers_.size());
+  DCHECK_EQ(0, out_of_order_buffers_.size());
   DCHECK_EQ(0, num_buffers_in_reader_.Load());
 }
 
@@ -519,7 +814,7 @@ void ScanRange::Reset(hdfsFS fs, const char* file, int64_t len, int64_t offset,
     vector<SubRange>&& sub_ranges, void* meta_data, DiskFile* disk_file,
     DiskFile* disk_buffer_file) {
   DCHECK(ready_buffers_.empty());
-  DCHECK(!read_in_flight_);
+  DCHECK_EQ(0, num_reads_in_flight_);
   DCHECK(file != nullptr);
   DCHECK_GE(len, 0);
   DCHECK_GE(offset, 0);
@@ -545,6 +840,8 @@ void ScanRange::Reset(hdfsFS fs, const char* file, int64_t len, int64_t offset,
   if (fs_) DCHECK_GT(mtime, 0);
   mtime_ = mtime;
   meta_data_ = meta_data;
+  preloaded_ = buffer_opts.preloaded_;
+  DCHECK(!preloaded_ || buffer_opts.client_buffer_ != nullptr);
   if (buffer_opts.client_buffer_ != nullptr) {
     external_buffer_tag_ = ExternalBufferTag::CLIENT_BUFFER;
     client_buffer_.data = buffer_opts.client_buffer_;
@@ -611,7 +908,8 @@ void ScanRange::MergeSubRanges() {
 }
 
 void ScanRange::InitInternal(DiskIoMgr* io_mgr, RequestContext* reader) {
-  DCHECK(!read_in_flight_);
+  DCHECK_EQ(0, num_reads_in_flight_);
+  DCHECK(out_of_order_buffers_.empty());
   io_mgr_ = io_mgr;
   reader_ = reader;
   unused_iomgr_buffer_bytes_ = 0;
@@ -620,6 +918,12 @@ void ScanRange::InitInternal(DiskIoMgr* io_mgr, RequestContext* reader) {
   eosr_queued_ = false;
   blocked_on_buffer_ = false;
   bytes_read_ = 0;
+  bytes_started_ = 0;
+  parallel_cancel_reported_ = false;
+  max_parallel_reads_ = MaxParallelReads();
+  read_ahead_depth_ = FLAGS_adaptive_scan_range_read_ahead ?
+      max(2, max_parallel_reads_) : std::numeric_limits<int>::max();
+  read_ahead_blocked_ = false;
   sub_range_pos_ = {};
   file_reader_->ResetState();
   if (local_buffer_reader_ != nullptr) local_buffer_reader_->ResetState();
@@ -673,6 +977,7 @@ Status ScanRange::ReadFromCache(
   DCHECK(external_buffer_tag_ != ExternalBufferTag::CLIENT_BUFFER);
   external_buffer_tag_ = ExternalBufferTag::CACHED_BUFFER;
   bytes_read_ = cache_.len;
+  bytes_started_ = cache_.len;
 
   // Create a single buffer desc for the entire scan range and enqueue that.
   // The memory is owned by the HDFS java client, not the Impala backend.
@@ -685,6 +990,25 @@ Status ScanRange::ReadFromCache(
   return Status::OK();
 }
 
+void ScanRange::EnqueuePreloadedBuffer() {
+  DCHECK(preloaded_);
+  DCHECK(external_buffer_tag_ == ExternalBufferTag::CLIENT_BUFFER);
+  DCHECK(sub_ranges_.empty());
+  DCHECK_EQ(bytes_read_, 0);
+  {
+    // EnqueueReadyBuffer() expects a read to be in flight for client buffers.
+    unique_lock<mutex> lock(lock_);
+    num_reads_in_flight_ = 1;
+    bytes_read_ = bytes_to_read_;
+    bytes_started_ = bytes_to_read_;
+  }
+  unique_ptr<BufferDescriptor> desc = unique_ptr<BufferDescriptor>(new BufferDescriptor(
+      this, client_buffer_.data, client_buffer_.len));
+  desc->len_ = bytes_to_read_;
+  desc->eosr_ = true;
+  EnqueueReadyBuffer(move(desc));
+}
+
 BufferDescriptor::BufferDescriptor(ScanRange* scan_range,
     uint8_t* buffer, int64_t buffer_len)
   : scan_range_(scan_range),
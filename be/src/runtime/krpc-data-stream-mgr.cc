@@ -28,6 +28,7 @@
 #include "exec/kudu-util.h"
 #include "runtime/exec-env.h"
 #include "runtime/krpc-data-stream-recvr.h"
+#include "runtime/krpc-data-stream-relay.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.inline.h"
 #include "runtime/row-batch.h"
@@ -63,6 +64,9 @@ DEFINE_int32(datastream_service_num_deserialization_threads, 16,
 DEFINE_int32(datastream_service_deserialization_queue_size, 10000,
     "Number of deferred RPC requests that can be enqueued before being processed by a "
     "deserialization thread.");
+DEFINE_int32(datastream_service_num_relay_threads, 4,
+    "Number of threads for passing TransmitData() RPCs on to their receivers after their "
+    "row batches have been relayed to other receivers of a broadcast exchange.");
 using std::mutex;
 
 namespace impala {
@@ -71,7 +75,10 @@ KrpcDataStreamMgr::KrpcDataStreamMgr(MetricGroup* metrics)
   : deserialize_pool_("data-stream-mgr", "deserialize",
       FLAGS_datastream_service_num_deserialization_threads,
       FLAGS_datastream_service_deserialization_queue_size,
-      boost::bind(&KrpcDataStreamMgr::DeserializeThreadFn, this, _1, _2)) {
+      boost::bind(&KrpcDataStreamMgr::DeserializeThreadFn, this, _1, _2)),
+    relay_pool_("data-stream-mgr", "relay", FLAGS_datastream_service_num_relay_threads,
+      FLAGS_datastream_service_deserialization_queue_size,
+      boost::bind(&KrpcDataStreamMgr::RelayThreadFn, this, _1, _2)) {
   MetricGroup* dsm_metrics = metrics->GetOrCreateChildGroup("datastream-manager");
   num_senders_waiting_ =
       dsm_metrics->AddGauge("senders-blocked-on-recvr-creation", 0L);
@@ -90,6 +97,7 @@ Status KrpcDataStreamMgr::Init(MemTracker* service_mem_tracker) {
   RETURN_IF_ERROR(Thread::Create("krpc-data-stream-mgr", "maintenance",
       [this](){ this->Maintenance(); }, &maintenance_thread_));
   RETURN_IF_ERROR(deserialize_pool_.Init());
+  RETURN_IF_ERROR(relay_pool_.Init());
   return Status::OK();
 }
 
@@ -205,6 +213,44 @@ void KrpcDataStreamMgr::AddEarlyClosedSender(const TUniqueId& finst_id,
 
 void KrpcDataStreamMgr::AddData(const TransmitDataRequestPB* request,
     TransmitDataResponsePB* response, kudu::rpc::RpcContext* rpc_context) {
+  if (request->relay_destinations_size() > 0) {
+    RelayData(request, response, rpc_context);
+  } else {
+    DeliverData(request, response, rpc_context);
+  }
+}
+
+void KrpcDataStreamMgr::RelayData(const TransmitDataRequestPB* request,
+    TransmitDataResponsePB* response, kudu::rpc::RpcContext* rpc_context) {
+  VLOG_ROW << "RelayData(): node_id=" << request->dest_node_id()
+           << " #destinations=" << request->relay_destinations_size()
+           << " sender_id=" << request->sender_id();
+  unique_ptr<KrpcDataStreamRelay> relay(new KrpcDataStreamRelay(
+      this, service_mem_tracker_, request, response, rpc_context));
+  Status status = relay->Start();
+  if (UNLIKELY(!status.ok())) {
+    DataStreamService::RespondAndReleaseRpc(status, response, rpc_context,
+        service_mem_tracker_);
+    return;
+  }
+  // Owned by the relay thread pool once all its RPCs completed.
+  relay.release();
+}
+
+void KrpcDataStreamMgr::EnqueueRelay(KrpcDataStreamRelay* relay) {
+  if (UNLIKELY(!relay_pool_.Offer(RelayTask{relay}))) {
+    // The pool is shut down, so the process is exiting. Finish in this thread.
+    RelayThreadFn(-1, RelayTask{relay});
+  }
+}
+
+void KrpcDataStreamMgr::RelayThreadFn(int thread_id, const RelayTask& task) {
+  unique_ptr<KrpcDataStreamRelay> relay(task.relay);
+  relay->Finish();
+}
+
+void KrpcDataStreamMgr::DeliverData(const TransmitDataRequestPB* request,
+    TransmitDataResponsePB* response, kudu::rpc::RpcContext* rpc_context) {
   TUniqueId finst_id;
   finst_id.__set_lo(request->dest_fragment_instance_id().lo());
   finst_id.__set_hi(request->dest_fragment_instance_id().hi());
@@ -248,6 +294,30 @@ void KrpcDataStreamMgr::AddData(const TransmitDataRequestPB* request,
   service_mem_tracker_->Release(transfer_size);
 }
 
+Status KrpcDataStreamMgr::AddDataLocal(const TUniqueId& finst_id,
+    PlanNodeId dest_node_id, int sender_id, const OutboundRowBatch& outbound_batch,
+    const RuntimeState* sender_state, bool* delivered) {
+  VLOG_ROW << "AddDataLocal(): fragment_instance_id=" << PrintId(finst_id)
+           << " node_id=" << dest_node_id
+           << " #rows=" << outbound_batch.header()->num_rows()
+           << " sender_id=" << sender_id;
+  bool already_unregistered = false;
+  shared_ptr<KrpcDataStreamRecvr> recvr;
+  {
+    lock_guard<mutex> l(lock_);
+    recvr = FindRecvr(finst_id, dest_node_id, &already_unregistered);
+  }
+  if (already_unregistered) {
+    *delivered = true;
+    return Status::Expected(
+        TErrorCode::DATASTREAM_RECVR_CLOSED, PrintId(finst_id), dest_node_id);
+  }
+  // Early senders are handled by the RPC path, which also times them out.
+  *delivered = recvr != nullptr;
+  if (recvr == nullptr) return Status::OK();
+  return recvr->AddBatchLocal(sender_id, outbound_batch, sender_state);
+}
+
 void KrpcDataStreamMgr::EnqueueDeserializeTask(const TUniqueId& finst_id,
     PlanNodeId dest_node_id, int sender_id, int num_requests) {
   for (int i = 0; i < num_requests; ++i) {
@@ -438,10 +508,13 @@ void KrpcDataStreamMgr::Maintenance() {
 KrpcDataStreamMgr::~KrpcDataStreamMgr() {
   shutdown_promise_.Set(true);
   deserialize_pool_.Shutdown();
+  relay_pool_.Shutdown();
   LOG(INFO) << "Waiting for data-stream-mgr maintenance thread...";
   if (maintenance_thread_.get() != nullptr) maintenance_thread_->Join();
   LOG(INFO) << "Waiting for deserialization thread pool...";
   deserialize_pool_.Join();
+  LOG(INFO) << "Waiting for relay thread pool...";
+  relay_pool_.Join();
 }
 
 } // namespace impala
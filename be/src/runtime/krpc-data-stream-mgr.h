@@ -49,6 +49,7 @@ class DescriptorTbl;
 class EndDataStreamRequestPB;
 class EndDataStreamResponsePB;
 class KrpcDataStreamRecvr;
+class KrpcDataStreamRelay;
 class RuntimeState;
 class TransmitDataRequestPB;
 class TransmitDataResponsePB;
@@ -110,6 +111,18 @@ class TransmitDataResponsePB;
 /// the stream's contents has been delivered. After EndDataStream() is received, no more
 /// TransmitData() RPCs should be expected from this sender.
 ///
+/// Relaying broadcast row batches
+/// ------------------------------
+///
+/// A broadcast sender may send each row batch to only a few of its receivers and list
+/// the others in the 'relay_destinations' of the TransmitData() RPCs (see the
+/// BROADCAST_RELAY_FANOUT query option). The data stream manager of such a receiver
+/// forwards the serialized row batch to those destinations in a tree before it passes
+/// the RPC on to the receiver (see KrpcDataStreamRelay), and the RPC is only replied to
+/// once the whole subtree has accepted the batch. Since a sender waits for the replies
+/// to all its TransmitData() RPCs before sending EndDataStream() RPCs, which go to each
+/// receiver directly, the end of stream still arrives after all row batches.
+///
 /// Exceptional conditions: cancellation, timeouts, failure
 /// -------------------------------------------------------
 ///
@@ -177,6 +190,10 @@ struct TransmitDataCtx {
   /// has been responded to. Not owned.
   kudu::rpc::RpcContext* rpc_context;
 
+  /// The monotonic time in nanoseconds when the receiver deferred this RPC. Set by the
+  /// sender queue that it is deferred in.
+  int64_t deferred_time_ns = 0;
+
   TransmitDataCtx(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
       kudu::rpc::RpcContext* rpc_context)
     : request(request), response(response), rpc_context(rpc_context) { }
@@ -266,11 +283,26 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   /// The RPC may not be responded to by the time this function returns if the processing
   /// is deferred.
   ///
+  /// If 'request' has relay destinations, the row batch is relayed to them first. See
+  /// "Relaying broadcast row batches" above.
+  ///
   /// TODO: enforce per-sender quotas (something like 200% of buffer_size/#senders),
   /// so that a single sender can't flood the buffer and stall everybody else.
   void AddData(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
       kudu::rpc::RpcContext* rpc_context);
 
+  /// Adds the serialized row batch 'outbound_batch' from the sender 'sender_id' in this
+  /// process to the receiver identified by 'finst_id' and 'dest_node_id', without a
+  /// TransmitData() RPC. Waits in the calling thread while the receiver's buffer is
+  /// full, as described in KrpcDataStreamRecvr::AddBatchLocal(). Sets 'delivered' to
+  /// false if the receiver is not registered yet, in which case the caller must send
+  /// the batch in a TransmitData() RPC instead. Returns DATASTREAM_RECVR_CLOSED if the
+  /// receiver was already closed or cancelled. 'sender_state' is the runtime state of
+  /// the sender, which stops waiting if it is cancelled.
+  Status AddDataLocal(const TUniqueId& finst_id, PlanNodeId dest_node_id, int sender_id,
+      const OutboundRowBatch& outbound_batch, const RuntimeState* sender_state,
+      bool* delivered);
+
   /// Handler for EndDataStream() RPC.
   ///
   /// Notifies the receiver associated with the fragment/dest_node id that the specified
@@ -290,6 +322,7 @@ class KrpcDataStreamMgr : public CacheLineAligned {
 
  private:
   friend class KrpcDataStreamRecvr;
+  friend class KrpcDataStreamRelay;
   friend class DataStreamTest;
 
   /// MemTracker for memory used for early transmit data RPCs which arrive before the
@@ -322,6 +355,17 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   /// full or if the receiver was not yet prepared.
   ThreadPool<DeserializeTask> deserialize_pool_;
 
+  /// A relay of a TransmitData() RPC whose outbound RPCs have all completed. Owned by
+  /// the task.
+  struct RelayTask {
+    KrpcDataStreamRelay* relay;
+  };
+
+  /// Set of threads which pass relayed TransmitData() RPCs on to their receivers. This
+  /// keeps the deserialization of their row batches off the reactor threads, which run
+  /// the completion callbacks of the outbound RPCs.
+  ThreadPool<RelayTask> relay_pool_;
+
   /// Periodically, respond to all senders that have waited for too long for their
   /// receivers to show up.
   std::unique_ptr<Thread> maintenance_thread_;
@@ -458,6 +502,23 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   /// Called from the deserialization thread.
   void DeserializeThreadFn(int thread_id, const DeserializeTask& task);
 
+  /// Starts relaying the row batch of a TransmitData() RPC with relay destinations. The
+  /// RPC is passed to DeliverData() once it has been relayed.
+  void RelayData(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
+      kudu::rpc::RpcContext* rpc_context);
+
+  /// Adds the row batch of a TransmitData() RPC to its receiver. Implements AddData()
+  /// after any relaying.
+  void DeliverData(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
+      kudu::rpc::RpcContext* rpc_context);
+
+  /// Takes ownership of 'relay', all of whose outbound RPCs completed, and enqueues it
+  /// to the relay thread pool. Called from reactor threads.
+  void EnqueueRelay(KrpcDataStreamRelay* relay);
+
+  /// Worker function for finishing a relay. Called from the relay threads.
+  void RelayThreadFn(int thread_id, const RelayTask& task);
+
   /// Return a shared_ptr to the receiver for given fragment_instance_id/dest_node_id, or
   /// an empty shared_ptr if not found. Must be called with lock_ already held. If the
   /// stream was recently closed, sets *already_unregistered to true to indicate to caller
@@ -17,7 +17,10 @@
 
 #include "runtime/krpc-data-stream-recvr.h"
 
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <queue>
 
@@ -30,11 +33,18 @@
 #include "runtime/krpc-data-stream-mgr.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/row-batch.h"
+#include "runtime/runtime-state.h"
 #include "runtime/sorted-run-merger.h"
+#include "runtime/spillable-row-batch-queue.h"
 #include "service/data-stream-service.h"
 #include "util/debug-util.h"
+#include "util/impalad-metrics.h"
+#include "util/lock-contention.h"
+#include "util/metrics.h"
+#include "util/event-tracer.h"
 #include "util/runtime-profile-counters.h"
 #include "util/periodic-counter-updater.h"
+#include "util/pretty-printer.h"
 #include "util/test-info.h"
 #include "util/time.h"
 
@@ -49,6 +59,15 @@ using kudu::MonoTime;
 using kudu::rpc::RpcContext;
 using std::condition_variable_any;
 
+// Adds a message to the trace of 'rpc_context', which is null for row batches from
+// senders in this process.
+#define TRACE_TO_RPC(rpc_context, ...)                \
+  do {                                                \
+    if ((rpc_context) != nullptr) {                   \
+      TRACE_TO((rpc_context)->trace(), __VA_ARGS__);  \
+    }                                                 \
+  } while (false)
+
 namespace impala {
 
 // Implements a FIFO queue of row batches from one or more senders. One queue is
@@ -63,6 +82,26 @@ namespace impala {
 // Senders in that state will not be replied to until their row batches are deserialized
 // or the receiver is cancelled. This ensures that only one batch per sender is buffered
 // in the deferred batches queue.
+//
+// If spilling is enabled, batches that would otherwise be deferred are deserialized and
+// added to a SpillableRowBatchQueue, which keeps them in buffer pool pages and
+// unpins them to scratch as needed, and their senders are replied to right away. RPCs
+// are only deferred once that queue is full as well. GetBatch() returns batches from
+// 'batch_queue_' before those from the spill queue. While the spill queue has rows, no
+// batch is added to 'batch_queue_', so the rows of each sender keep their order. Only
+// non-merging receivers spill.
+//
+// Senders in the same process may add batches via AddBatchLocal() instead, which waits
+// in the sender's thread under the same conditions under which an RPC is deferred.
+//
+// Batches are deserialized before they are added to 'batch_queue_', by the RPC service
+// thread or, for deferred RPCs, by the KrpcDataStreamMgr's deserialization threads, so
+// GetBatch() never deserializes. An empty queue always admits a batch regardless of the
+// limit (see CanEnqueue()), and GetBatch() hands the next deferred RPC to the
+// deserialization threads as soon as it removes a batch. For merging receivers, this
+// keeps one deserialized batch ready per sender while the merger works on the current
+// one. The time GetBatch() still waits for a deferred batch to be deserialized is
+// reported as DeserializeWaitTime.
 class KrpcDataStreamRecvr::SenderQueue {
  public:
   SenderQueue(KrpcDataStreamRecvr* parent_recvr, int num_senders);
@@ -107,24 +146,34 @@ class KrpcDataStreamRecvr::SenderQueue {
   // Returns the current batch from this queue being processed by a consumer.
   RowBatch* current_batch() const { return current_batch_.get(); }
 
+  // Sets the queue that batches are spilled to.
+  // See KrpcDataStreamRecvr::EnableSpilling().
+  void EnableSpilling(SpillableRowBatchQueue* spill_queue);
+
+  // Adds the serialized row batch 'outbound_batch' from the sender 'sender_id' in this
+  // process. See KrpcDataStreamRecvr::AddBatchLocal().
+  Status AddBatchLocal(int sender_id, const OutboundRowBatch& outbound_batch,
+      const RuntimeState* sender_state);
+
  private:
-  // Returns true if either (1) 'batch_queue' is empty and there is no pending insertion
-  // or (2) inserting a row batch of 'batch_size' into 'batch_queue' will not cause the
-  // soft limit of the receiver to be exceeded. Expected to be called with 'lock_' held.
-  bool CanEnqueue(int64_t batch_size, const unique_lock<SpinLock>& lock) const;
+  // Returns false if there are rows in 'spill_queue_'. Otherwise, returns true if either
+  // (1) 'batch_queue' is empty and there is no pending insertion or (2) inserting a row
+  // batch of 'batch_size' into 'batch_queue' will not cause the soft limit of the
+  // receiver to be exceeded. Expected to be called with 'lock_' held.
+  bool CanEnqueue(int64_t batch_size, const unique_lock<TrackedSpinLock>& lock) const;
 
   // Helper function for inserting 'payload' into 'deferred_rpcs_'. Also does some
   // accounting for various counters. 'lock_' must be held when calling this function.
   void EnqueueDeferredRpc(unique_ptr<TransmitDataCtx> payload,
-      const unique_lock<SpinLock>& lock);
+      const unique_lock<TrackedSpinLock>& lock);
 
   // Helper function for removing the first item from 'deferred_rpcs_'. Also does some
   // accounting for various counters. 'lock_' must be held when calling this function.
-  void DequeueDeferredRpc(const unique_lock<SpinLock>& lock);
+  void DequeueDeferredRpc(const unique_lock<TrackedSpinLock>& lock);
 
   // Mark an error 'status' into the overall status. 'lock_' must be held when calling
   // this function. Will notify all threads waiting on 'data_arrival_cv_'.
-  void MarkErrorStatus(const Status& status, const unique_lock<SpinLock>& lock);
+  void MarkErrorStatus(const Status& status, const unique_lock<TrackedSpinLock>& lock);
 
   // Unpacks a serialized row batch from 'request' and 'rpc_context' and populates
   // 'tuple_offsets' and 'tuple_data'. On success, the deserialized row batch sizes is
@@ -150,13 +199,30 @@ class KrpcDataStreamRecvr::SenderQueue {
   // failed. Returns OK otherwise.
   Status AddBatchWork(int64_t batch_size, const RowBatchHeaderPB& header,
       const kudu::Slice& tuple_offsets, const kudu::Slice& tuple_data,
-      unique_lock<SpinLock>* lock, RpcContext* rpc_context) WARN_UNUSED_RESULT;
+      unique_lock<TrackedSpinLock>* lock, RpcContext* rpc_context) WARN_UNUSED_RESULT;
+
+  // Returns true if a batch that cannot be enqueued into 'batch_queue_' can be spilled
+  // instead. Expected to be called with 'lock_' held.
+  bool CanSpill(const unique_lock<TrackedSpinLock>& lock) const;
+
+  // Like AddBatchWork(), but adds the row batch to 'spill_queue_'. Same as
+  // AddBatchWork(), the lock is dropped while the row batch is deserialized and spilled.
+  // The caller is expected to have called CanSpill(). If the spill queue filled up in
+  // the meantime, the batch is added to 'batch_queue_' even if this exceeds the soft
+  // limit of the receiver.
+  Status SpillBatchWork(int64_t batch_size, const RowBatchHeaderPB& header,
+      const kudu::Slice& tuple_offsets, const kudu::Slice& tuple_data,
+      unique_lock<TrackedSpinLock>* lock, RpcContext* rpc_context) WARN_UNUSED_RESULT;
+
+  // Reads the next batch from 'spill_queue_' into 'current_batch_'. Called from
+  // GetBatch() without holding 'lock_'.
+  Status GetSpilledBatch();
 
   // Receiver of which this queue is a member.
   KrpcDataStreamRecvr* recvr_;
 
   // Protects all subsequent fields.
-  SpinLock lock_;
+  TrackedSpinLock lock_{LockContention::DATA_STREAM_RECVR};
 
   // Record any error status within KrpcDataStreamRecvr when inserting row batch.
   Status status_;
@@ -192,6 +258,12 @@ class KrpcDataStreamRecvr::SenderQueue {
   // Signal the arrival of new batch or the eos/cancelled condition.
   condition_variable_any data_arrival_cv_;
 
+  // Signaled when a batch is removed from 'batch_queue_' or 'spill_queue_', when
+  // 'deferred_rpcs_' becomes empty and on cancellation, while there are
+  // 'num_local_senders_waiting_' AddBatchLocal() calls waiting for space.
+  condition_variable_any local_sender_cv_;
+  int num_local_senders_waiting_ = 0;
+
   // Queue of (batch length, batch) pairs. The SenderQueue owns the memory to these
   // batches until they are handed off to the callers of GetBatch().
   typedef list<pair<int, std::unique_ptr<RowBatch>>> RowBatchQueue;
@@ -214,6 +286,23 @@ class KrpcDataStreamRecvr::SenderQueue {
   // non-empty. Set to 0 when 'deferred_rpcs_' becomes empty again. Used for computing
   // 'total_has_deferred_rpcs_timer_'.
   int64_t has_deferred_rpcs_start_time_ns_ = 0;
+
+  // The queue that batches are spilled to if spilling is enabled, otherwise null. Not
+  // owned. Only set from the fragment instance execution thread, which is also the only
+  // thread reading from it, so it can read this field without holding 'lock_'.
+  SpillableRowBatchQueue* spill_queue_ = nullptr;
+
+  // True if 'spill_queue_' was full when it was last accessed.
+  bool spill_queue_full_ = false;
+
+  // Number of rows that were added to 'spill_queue_' and not read yet. Rows are counted
+  // before 'spill_lock_' is released after adding them, so this never becomes negative.
+  int64_t num_spilled_rows_ = 0;
+
+  // Serializes accesses to 'spill_queue_', which is not thread-safe. It may be held
+  // for a long time while pages are written or read, so it must not be acquired while
+  // holding 'lock_'. 'lock_' may be acquired while holding it.
+  std::mutex spill_lock_;
 };
 
 KrpcDataStreamRecvr::SenderQueue::SenderQueue(
@@ -221,21 +310,24 @@ KrpcDataStreamRecvr::SenderQueue::SenderQueue(
   : recvr_(parent_recvr), num_remaining_senders_(num_senders) { }
 
 Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
+  SCOPED_TRACE_EVENT("DataStreamRecvr::GetBatch");
   SCOPED_TIMER(recvr_->queue_get_batch_timer_);
   DCHECK(TestInfo::is_test() || FragmentInstanceState::IsFragmentExecThread());
   DCHECK(!recvr_->closed_);
   int num_to_dequeue = 0;
   // The sender id is set below when we decide to dequeue entries from 'deferred_rpcs_'.
   int sender_id = -1;
+  // Set below if the next batch is to be read from 'spill_queue_'.
+  bool read_spilled = false;
   {
-    unique_lock<SpinLock> l(lock_);
+    unique_lock<TrackedSpinLock> l(lock_);
     // current_batch_ must be replaced with the returned batch.
     current_batch_.reset();
     *next_batch = nullptr;
 
     // Wait until something shows up or we know we're done
-    while (batch_queue_.empty() && status_.ok() && !is_cancelled_ &&
-        num_remaining_senders_ > 0) {
+    while (batch_queue_.empty() && num_spilled_rows_ == 0 && status_.ok()
+        && !is_cancelled_ && num_remaining_senders_ > 0) {
       // Verify before waiting on 'data_arrival_cv_' that if there are any deferred
       // batches, either there is outstanding deserialization request queued or there
       // is pending insertion so this thread is guaranteed to wake up at some point.
@@ -248,7 +340,14 @@ Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
       CANCEL_SAFE_SCOPED_TIMER3(recvr_->data_wait_timer_, recvr_->inactive_timer_,
           received_first_batch_ ? nullptr : recvr_->first_batch_wait_total_timer_,
           &is_cancelled_);
+      const bool has_deferred_rpcs = !deferred_rpcs_.empty();
+      const int64_t wait_start_ns = has_deferred_rpcs ? MonotonicNanos() : 0;
+      ScopedGaugeIncrement waiting_threads(
+          ImpaladMetrics::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE);
       data_arrival_cv_.wait(l);
+      if (has_deferred_rpcs) {
+        COUNTER_ADD(recvr_->deserialize_wait_timer_, MonotonicNanos() - wait_start_ns);
+      }
     }
 
     // Return early if there is any error when inserting row batches.
@@ -262,7 +361,7 @@ Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
     }
 
     // All senders have sent their row batches. Nothing to do.
-    if (num_remaining_senders_ == 0 && batch_queue_.empty()) {
+    if (num_remaining_senders_ == 0 && batch_queue_.empty() && num_spilled_rows_ == 0) {
       // Note that it's an invariant that a sender cannot send the EOS RPC until all
       // outstanding TransmitData() RPCs have been replied to. Therefore, it should be
       // impossible for num_remaining_senders_ to reach 0 before all RPCs in
@@ -284,17 +383,35 @@ Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
       sender_id = deferred_rpcs_.front()->request->sender_id();
     }
 
-    DCHECK(!batch_queue_.empty());
     received_first_batch_ = true;
-    RowBatch* result = batch_queue_.front().second.release();
-    int64_t batch_size = batch_queue_.front().first;
-    COUNTER_ADD(recvr_->bytes_dequeued_counter_, batch_size);
-    recvr_->num_buffered_bytes_.Add(-batch_size);
-    batch_queue_.pop_front();
-    VLOG_ROW << "fetched #rows=" << result->num_rows();
-    current_batch_.reset(result);
+    if (batch_queue_.empty()) {
+      DCHECK_GT(num_spilled_rows_, 0);
+      read_spilled = true;
+    } else {
+      RowBatch* result = batch_queue_.front().second.release();
+      int64_t batch_size = batch_queue_.front().first;
+      COUNTER_ADD(recvr_->bytes_dequeued_counter_, batch_size);
+      recvr_->num_buffered_bytes_.Add(-batch_size);
+      batch_queue_.pop_front();
+      VLOG_ROW << "fetched #rows=" << result->num_rows();
+      current_batch_.reset(result);
+      *next_batch = current_batch_.get();
+    }
+  }
+  if (read_spilled) {
+    // Reading may have to wait for pages to be read back from scratch, so it is done
+    // without holding 'lock_'. Reading makes room in 'spill_queue_', which lets the
+    // deferred RPCs below be spilled.
+    Status status = GetSpilledBatch();
+    if (UNLIKELY(!status.ok())) {
+      unique_lock<TrackedSpinLock> l(lock_);
+      MarkErrorStatus(status, l);
+      num_deserialize_tasks_pending_ -= num_to_dequeue;
+      return status;
+    }
     *next_batch = current_batch_.get();
   }
+  if (num_local_senders_waiting_ > 0) local_sender_cv_.notify_all();
   // Don't hold lock when calling EnqueueDeserializeTask() as it may block.
   // It's important that the dequeuing of 'deferred_rpcs_' is done after the entry
   // has been removed from 'batch_queue_' or the deserialization threads may fail to
@@ -307,30 +424,60 @@ Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
   return Status::OK();
 }
 
+Status KrpcDataStreamRecvr::SenderQueue::GetSpilledBatch() {
+  DCHECK(spill_queue_ != nullptr);
+  unique_ptr<RowBatch> batch = make_unique<RowBatch>(recvr_->row_desc(),
+      recvr_->runtime_state_.batch_size(), recvr_->parent_tracker());
+  bool full;
+  {
+    lock_guard<mutex> l(spill_lock_);
+    RETURN_IF_ERROR(spill_queue_->GetBatch(batch.get()));
+    full = spill_queue_->IsFull();
+  }
+  unique_lock<TrackedSpinLock> l(lock_);
+  num_spilled_rows_ -= batch->num_rows();
+  DCHECK_GE(num_spilled_rows_, 0);
+  spill_queue_full_ = full;
+  VLOG_ROW << "fetched spilled #rows=" << batch->num_rows();
+  current_batch_ = move(batch);
+  return Status::OK();
+}
+
+inline bool KrpcDataStreamRecvr::SenderQueue::CanSpill(
+    const unique_lock<TrackedSpinLock>& lock) const {
+  DCHECK(lock.owns_lock());
+  return spill_queue_ != nullptr && !spill_queue_full_;
+}
+
 inline bool KrpcDataStreamRecvr::SenderQueue::CanEnqueue(int64_t batch_size,
-    const unique_lock<SpinLock>& lock) const {
+    const unique_lock<TrackedSpinLock>& lock) const {
   DCHECK(lock.owns_lock());
   // The queue is truly empty iff there is no pending insert. It's important that we
   // enqueue the new batch regardless of buffer limit if the queue is currently empty.
   // In the case of a merging receiver, batches are received from a specific queue
   // based on data order, and the pipeline will stall if the merger is waiting for data
   // from an empty queue that cannot be filled because the limit has been reached.
+  // Batches must not overtake the rows in 'spill_queue_', so that the rows of each
+  // sender are returned in the order they were sent.
+  if (num_spilled_rows_ > 0) return false;
   bool queue_empty = batch_queue_.empty() && num_pending_enqueue_ == 0;
   return queue_empty || !recvr_->ExceedsLimit(batch_size);
 }
 
 void KrpcDataStreamRecvr::SenderQueue::EnqueueDeferredRpc(
-    unique_ptr<TransmitDataCtx> payload, const unique_lock<SpinLock>& lock) {
+    unique_ptr<TransmitDataCtx> payload, const unique_lock<TrackedSpinLock>& lock) {
   DCHECK(lock.owns_lock());
   TRACE_TO(payload->rpc_context->trace(), "Enqueuing deferred RPC");
-  if (deferred_rpcs_.empty()) has_deferred_rpcs_start_time_ns_ = MonotonicNanos();
+  const int64_t now = MonotonicNanos();
+  payload->deferred_time_ns = now;
+  if (deferred_rpcs_.empty()) has_deferred_rpcs_start_time_ns_ = now;
   deferred_rpcs_.push(move(payload));
   recvr_->num_deferred_rpcs_.Add(1);
   COUNTER_ADD(recvr_->total_deferred_rpcs_counter_, 1);
 }
 
 void KrpcDataStreamRecvr::SenderQueue::DequeueDeferredRpc(
-    const unique_lock<SpinLock>& lock) {
+    const unique_lock<TrackedSpinLock>& lock) {
   DCHECK(lock.owns_lock());
   deferred_rpcs_.pop();
   if (deferred_rpcs_.empty()) {
@@ -343,7 +490,7 @@ void KrpcDataStreamRecvr::SenderQueue::DequeueDeferredRpc(
 }
 
 inline void KrpcDataStreamRecvr::SenderQueue::MarkErrorStatus(const Status& status,
-    const unique_lock<SpinLock>& lock) {
+    const unique_lock<TrackedSpinLock>& lock) {
   DCHECK(lock.owns_lock());
   DCHECK(!status.ok());
   status_.MergeStatus(status);
@@ -379,7 +526,7 @@ Status KrpcDataStreamRecvr::SenderQueue::UnpackRequest(
 
 Status KrpcDataStreamRecvr::SenderQueue::AddBatchWork(int64_t batch_size,
     const RowBatchHeaderPB& header, const kudu::Slice& tuple_offsets,
-    const kudu::Slice& tuple_data, unique_lock<SpinLock>* lock,
+    const kudu::Slice& tuple_data, unique_lock<TrackedSpinLock>* lock,
     RpcContext* rpc_context) {
   DCHECK(lock != nullptr);
   DCHECK(lock->owns_lock());
@@ -394,7 +541,7 @@ Status KrpcDataStreamRecvr::SenderQueue::AddBatchWork(int64_t batch_size,
   // Deserialization may take some time due to compression and memory allocation.
   // Drop the lock so we can deserialize multiple batches in parallel.
   lock->unlock();
-  TRACE_TO(rpc_context->trace(), "Deserializing batch");
+  TRACE_TO_RPC(rpc_context, "Deserializing batch");
   unique_ptr<RowBatch> batch;
   Status status;
   {
@@ -416,18 +563,86 @@ Status KrpcDataStreamRecvr::SenderQueue::AddBatchWork(int64_t batch_size,
     recvr_->num_buffered_bytes_.Add(-batch_size);
     VLOG_QUERY << "Failed to deserialize batch for "
                << PrintId(recvr_->fragment_instance_id());
-    TRACE_TO(rpc_context->trace(), "Failed to deserialize batch: $0", status.GetDetail());
+    TRACE_TO_RPC(rpc_context, "Failed to deserialize batch: $0", status.GetDetail());
     MarkErrorStatus(status, *lock);
     return status;
   }
   VLOG_ROW << "added #rows=" << batch->num_rows() << " batch_size=" << batch_size;
-  TRACE_TO(rpc_context->trace(), "Enqueuing deserialized batch");
+  TRACE_TO_RPC(rpc_context, "Enqueuing deserialized batch");
   COUNTER_ADD(recvr_->total_enqueued_batches_counter_, 1);
   batch_queue_.emplace_back(batch_size, move(batch));
   data_arrival_cv_.notify_one();
   return Status::OK();
 }
 
+Status KrpcDataStreamRecvr::SenderQueue::SpillBatchWork(int64_t batch_size,
+    const RowBatchHeaderPB& header, const kudu::Slice& tuple_offsets,
+    const kudu::Slice& tuple_data, unique_lock<TrackedSpinLock>* lock,
+    RpcContext* rpc_context) {
+  DCHECK(lock != nullptr);
+  DCHECK(lock->owns_lock());
+  DCHECK(!is_cancelled_);
+  DCHECK(CanSpill(*lock));
+  // Close() waits for pending insertions before it clears 'spill_queue_'.
+  DCHECK_GE(num_pending_enqueue_, 0);
+  ++num_pending_enqueue_;
+  SpillableRowBatchQueue* spill_queue = spill_queue_;
+
+  lock->unlock();
+  TRACE_TO_RPC(rpc_context, "Deserializing batch to spill");
+  unique_ptr<RowBatch> batch;
+  Status status;
+  {
+    SCOPED_TIMER(recvr_->deserialize_row_batch_timer_);
+    status = RowBatch::FromProtobuf(recvr_->row_desc(), header, tuple_offsets,
+        tuple_data, recvr_->parent_tracker(), recvr_->buffer_pool_client(), &batch);
+  }
+  bool spilled = false;
+  bool full = false;
+  if (LIKELY(status.ok())) {
+    SCOPED_TIMER(recvr_->spill_batch_timer_);
+    lock_guard<mutex> l(spill_lock_);
+    // A batch without rows is enqueued below instead, so that it is not left behind in
+    // 'spill_queue_' once all spilled rows have been read.
+    if (batch->num_rows() > 0 && !spill_queue->IsFull()) {
+      status = spill_queue->AddBatch(batch.get());
+      spilled = status.ok();
+    }
+    if (LIKELY(status.ok())) full = spill_queue->IsFull();
+    // Count the spilled rows before 'spill_lock_' is released, so that GetSpilledBatch()
+    // cannot read them before they are counted.
+    lock->lock();
+    if (spilled) num_spilled_rows_ += batch->num_rows();
+  } else {
+    lock->lock();
+  }
+  const int num_rows = batch == nullptr ? 0 : batch->num_rows();
+  // The spill queue made a copy of the batch.
+  if (spilled) batch.reset();
+
+  DCHECK_GT(num_pending_enqueue_, 0);
+  --num_pending_enqueue_;
+  if (UNLIKELY(!status.ok())) {
+    VLOG_QUERY << "Failed to spill batch for "
+               << PrintId(recvr_->fragment_instance_id());
+    TRACE_TO_RPC(rpc_context, "Failed to spill batch: $0", status.GetDetail());
+    MarkErrorStatus(status, *lock);
+    return status;
+  }
+  spill_queue_full_ = full;
+  if (spilled) {
+    VLOG_ROW << "spilled #rows=" << num_rows;
+    COUNTER_ADD(recvr_->total_spilled_batches_counter_, 1);
+  } else {
+    TRACE_TO_RPC(rpc_context, "Enqueuing deserialized batch");
+    COUNTER_ADD(recvr_->total_enqueued_batches_counter_, 1);
+    recvr_->num_buffered_bytes_.Add(batch_size);
+    batch_queue_.emplace_back(batch_size, move(batch));
+  }
+  data_arrival_cv_.notify_one();
+  return Status::OK();
+}
+
 void KrpcDataStreamRecvr::SenderQueue::AddBatch(const TransmitDataRequestPB* request,
     TransmitDataResponsePB* response, RpcContext* rpc_context) {
   // TODO: Add timers for time spent in this function and queue time in 'batch_queue_'.
@@ -439,7 +654,7 @@ void KrpcDataStreamRecvr::SenderQueue::AddBatch(const TransmitDataRequestPB* req
       &batch_size);
   if (UNLIKELY(!status.ok())) {
     {
-      unique_lock<SpinLock> l(lock_);
+      unique_lock<TrackedSpinLock> l(lock_);
       MarkErrorStatus(status, l);
     }
     TRACE_TO(rpc_context->trace(), "Error unpacking request: $0", status.GetDetail());
@@ -451,7 +666,7 @@ void KrpcDataStreamRecvr::SenderQueue::AddBatch(const TransmitDataRequestPB* req
   COUNTER_ADD(recvr_->bytes_received_counter_, tuple_data.size() + tuple_offsets.size());
 
   {
-    unique_lock<SpinLock> l(lock_);
+    unique_lock<TrackedSpinLock> l(lock_);
     // There should be one or more senders left when this function is called. The reason
     // is that EndDataStream RPC is not sent until all outstanding TransmitData() RPC has
     // been replied to. There is at least one TransmitData() RPC which hasn't yet been
@@ -472,26 +687,68 @@ void KrpcDataStreamRecvr::SenderQueue::AddBatch(const TransmitDataRequestPB* req
     // batch needs to line up after the deferred RPCs to avoid starvation of senders
     // in the non-merging case.
     if (UNLIKELY(!deferred_rpcs_.empty() || !CanEnqueue(batch_size, l))) {
-      recvr_->deferred_rpc_tracker()->Consume(rpc_context->GetTransferSize());
-      auto payload = make_unique<TransmitDataCtx>(request, response, rpc_context);
-      EnqueueDeferredRpc(move(payload), l);
-      return;
+      if (CanSpill(l)) {
+        // Spill the row batch so that the sender can go on.
+        status = SpillBatchWork(
+            batch_size, header, tuple_offsets, tuple_data, &l, rpc_context);
+      } else {
+        recvr_->deferred_rpc_tracker()->Consume(rpc_context->GetTransferSize());
+        auto payload = make_unique<TransmitDataCtx>(request, response, rpc_context);
+        EnqueueDeferredRpc(move(payload), l);
+        return;
+      }
+    } else {
+      // At this point, we are committed to inserting the row batch into 'batch_queue_'.
+      status =
+          AddBatchWork(batch_size, header, tuple_offsets, tuple_data, &l, rpc_context);
     }
-
-    // At this point, we are committed to inserting the row batch into 'batch_queue_'.
-    status = AddBatchWork(batch_size, header, tuple_offsets, tuple_data, &l, rpc_context);
   }
 
   // Respond to the sender to ack the insertion of the row batches.
   DataStreamService::RespondRpc(status, response, rpc_context);
 }
 
+Status KrpcDataStreamRecvr::SenderQueue::AddBatchLocal(int sender_id,
+    const OutboundRowBatch& outbound_batch, const RuntimeState* sender_state) {
+  const RowBatchHeaderPB& header = *outbound_batch.header();
+  const kudu::Slice tuple_offsets = outbound_batch.TupleOffsetsAsSlice();
+  const kudu::Slice tuple_data = outbound_batch.TupleDataAsSlice();
+  const int64_t batch_size = RowBatch::GetDeserializedSize(header, tuple_offsets);
+  COUNTER_ADD(recvr_->total_received_batches_counter_, 1);
+  COUNTER_ADD(recvr_->total_local_batches_counter_, 1);
+  COUNTER_ADD(recvr_->bytes_received_counter_, tuple_data.size() + tuple_offsets.size());
+
+  unique_lock<TrackedSpinLock> l(lock_);
+  DCHECK_GT(num_remaining_senders_, 0);
+  // Like AddBatch(), line up behind the deferred RPCs, so that remote senders are not
+  // starved, and spill rather than wait if possible.
+  const int64_t start_time_ns = MonotonicNanos();
+  bool waited = false;
+  while (!is_cancelled_ && (!deferred_rpcs_.empty() || !CanEnqueue(batch_size, l))) {
+    if (CanSpill(l)) break;
+    if (UNLIKELY(sender_state->is_cancelled())) return Status::CANCELLED;
+    waited = true;
+    ++num_local_senders_waiting_;
+    local_sender_cv_.wait_for(l, std::chrono::milliseconds(50));
+    --num_local_senders_waiting_;
+  }
+  if (waited) recvr_->AddSenderQueueWait(sender_id, MonotonicNanos() - start_time_ns);
+  if (!is_cancelled_ && (!deferred_rpcs_.empty() || !CanEnqueue(batch_size, l))) {
+    return SpillBatchWork(batch_size, header, tuple_offsets, tuple_data, &l, nullptr);
+  }
+  if (UNLIKELY(is_cancelled_)) {
+    return Status::Expected(TErrorCode::DATASTREAM_RECVR_CLOSED,
+        PrintId(recvr_->fragment_instance_id()), recvr_->dest_node_id());
+  }
+  return AddBatchWork(batch_size, header, tuple_offsets, tuple_data, &l, nullptr);
+}
+
 void KrpcDataStreamRecvr::SenderQueue::ProcessDeferredRpc() {
   // Owns the first entry of 'deferred_rpcs_' if it ends up being popped.
   std::unique_ptr<TransmitDataCtx> ctx;
   Status status;
   {
-    unique_lock<SpinLock> l(lock_);
+    unique_lock<TrackedSpinLock> l(lock_);
     DCHECK_GT(num_deserialize_tasks_pending_, 0);
     --num_deserialize_tasks_pending_;
 
@@ -518,21 +775,32 @@ void KrpcDataStreamRecvr::SenderQueue::ProcessDeferredRpc() {
       return;
     }
 
-    // Stops if inserting the batch causes us to go over the limit.
-    // Put 'ctx' back on the queue.
-    if (!CanEnqueue(batch_size, l)) {
+    // Stops if inserting the batch causes us to go over the limit and it cannot be
+    // spilled. Put 'ctx' back on the queue.
+    const bool can_enqueue = CanEnqueue(batch_size, l);
+    if (!can_enqueue && !CanSpill(l)) {
       TRACE_TO(ctx->rpc_context->trace(), "Batch queue is full");
       ctx.swap(deferred_rpcs_.front());
       DCHECK(deferred_rpcs_.front().get() != nullptr);
       return;
     }
 
-    // Dequeues the deferred batch and adds it to 'batch_queue_'.
+    // Dequeues the deferred batch and adds it to 'batch_queue_' or spills it.
     DequeueDeferredRpc(l);
+    recvr_->AddSenderQueueWait(
+        ctx->request->sender_id(), MonotonicNanos() - ctx->deferred_time_ns);
+    if (deferred_rpcs_.empty() && num_local_senders_waiting_ > 0) {
+      local_sender_cv_.notify_all();
+    }
     const RowBatchHeaderPB& header = ctx->request->row_batch_header();
-    status = AddBatchWork(
-        batch_size, header, tuple_offsets, tuple_data, &l, ctx->rpc_context);
-    DCHECK(!status.ok() || !batch_queue_.empty());
+    if (can_enqueue) {
+      status = AddBatchWork(
+          batch_size, header, tuple_offsets, tuple_data, &l, ctx->rpc_context);
+      DCHECK(!status.ok() || !batch_queue_.empty());
+    } else {
+      status = SpillBatchWork(
+          batch_size, header, tuple_offsets, tuple_data, &l, ctx->rpc_context);
+    }
 
     // Release to MemTracker while still holding the lock to prevent race with Close().
     recvr_->deferred_rpc_tracker()->Release(ctx->rpc_context->GetTransferSize());
@@ -568,7 +836,7 @@ void KrpcDataStreamRecvr::SenderQueue::TakeOverEarlySender(
       GetSerializedBatchSize(ctx->request, ctx->rpc_context));
   int sender_id = ctx->request->sender_id();
   {
-    unique_lock<SpinLock> l(lock_);
+    unique_lock<TrackedSpinLock> l(lock_);
     if (UNLIKELY(is_cancelled_)) {
       TRACE_TO(ctx->rpc_context->trace(), "Recvr closed");
       Status cancel_status = Status::Expected(TErrorCode::DATASTREAM_RECVR_CLOSED,
@@ -586,7 +854,7 @@ void KrpcDataStreamRecvr::SenderQueue::TakeOverEarlySender(
 }
 
 void KrpcDataStreamRecvr::SenderQueue::DecrementSenders() {
-  lock_guard<SpinLock> l(lock_);
+  lock_guard<TrackedSpinLock> l(lock_);
   DCHECK_GT(num_remaining_senders_, 0);
   num_remaining_senders_ = max(0, num_remaining_senders_ - 1);
   VLOG_FILE << "decremented senders: fragment_instance_id="
@@ -598,7 +866,7 @@ void KrpcDataStreamRecvr::SenderQueue::DecrementSenders() {
 
 void KrpcDataStreamRecvr::SenderQueue::Cancel() {
   {
-    unique_lock<SpinLock> l(lock_);
+    unique_lock<TrackedSpinLock> l(lock_);
     if (is_cancelled_) return;
     is_cancelled_ = true;
 
@@ -618,12 +886,13 @@ void KrpcDataStreamRecvr::SenderQueue::Cancel() {
   // Wake up all threads waiting to produce/consume batches. They will all
   // notice that the stream is cancelled and handle it.
   data_arrival_cv_.notify_all();
+  local_sender_cv_.notify_all();
   PeriodicCounterUpdater::StopTimeSeriesCounter(
       recvr_->bytes_received_time_series_counter_);
 }
 
 void KrpcDataStreamRecvr::SenderQueue::Close() {
-  unique_lock<SpinLock> l(lock_);
+  unique_lock<TrackedSpinLock> l(lock_);
   // Note that the queue must be cancelled first before it can be closed or we may
   // risk running into a race which can leak row batches. Please see IMPALA-3034.
   DCHECK(is_cancelled_);
@@ -637,16 +906,31 @@ void KrpcDataStreamRecvr::SenderQueue::Close() {
   // Delete any batches queued in batch_queue_
   batch_queue_.clear();
   current_batch_.reset();
+  // The owner of 'spill_queue_' closes it after this receiver.
+  spill_queue_ = nullptr;
+  num_spilled_rows_ = 0;
 }
 
-Status KrpcDataStreamRecvr::CreateMerger(const TupleRowComparator& less_than) {
+void KrpcDataStreamRecvr::SenderQueue::EnableSpilling(
+    SpillableRowBatchQueue* spill_queue) {
+  DCHECK(TestInfo::is_test() || FragmentInstanceState::IsFragmentExecThread());
+  DCHECK(spill_queue->IsOpen());
+  unique_lock<TrackedSpinLock> l(lock_);
+  DCHECK(spill_queue_ == nullptr);
+  if (is_cancelled_) return;
+  spill_queue_ = spill_queue;
+}
+
+Status KrpcDataStreamRecvr::CreateMerger(
+    const TupleRowComparator& less_than, bool use_key_prefixes) {
   DCHECK(is_merging_);
   DCHECK(TestInfo::is_test() || FragmentInstanceState::IsFragmentExecThread());
   vector<SortedRunMerger::RunBatchSupplierFn> input_batch_suppliers;
   input_batch_suppliers.reserve(sender_queues_.size());
 
   // Create the merger that will a single stream of sorted rows.
-  merger_.reset(new SortedRunMerger(less_than, row_desc_, profile_, false));
+  merger_.reset(
+      new SortedRunMerger(less_than, row_desc_, profile_, false, use_key_prefixes));
 
   for (SenderQueue* queue: sender_queues_) {
     input_batch_suppliers.push_back(
@@ -688,7 +972,8 @@ KrpcDataStreamRecvr::KrpcDataStreamRecvr(KrpcDataStreamMgr* stream_mgr,
     buffer_pool_client_(client),
     profile_(profile),
     dequeue_profile_(RuntimeProfile::Create(&pool_, "Dequeue")),
-    enqueue_profile_(RuntimeProfile::Create(&pool_, "Enqueue")) {
+    enqueue_profile_(RuntimeProfile::Create(&pool_, "Enqueue")),
+    sender_queue_wait_ns_(num_senders) {
   // Create one queue per sender if is_merging is true.
   int num_queues = is_merging ? num_senders : 1;
   sender_queues_.reserve(num_queues);
@@ -714,6 +999,8 @@ KrpcDataStreamRecvr::KrpcDataStreamRecvr(KrpcDataStreamMgr* stream_mgr,
   inactive_timer_ = profile_->inactive_timer();
   first_batch_wait_total_timer_ =
       ADD_TIMER(dequeue_profile_, "FirstBatchWaitTime");
+  deserialize_wait_timer_ =
+      ADD_CHILD_TIMER(dequeue_profile_, "DeserializeWaitTime", "DataWaitTime");
 
   // Initialize various counters for measuring enqueuing into queues.
   bytes_received_counter_ =
@@ -737,8 +1024,15 @@ KrpcDataStreamRecvr::KrpcDataStreamRecvr(KrpcDataStreamMgr* stream_mgr,
       bind<int64_t>(mem_fn(&KrpcDataStreamRecvr::num_deferred_rpcs), this));
   total_has_deferred_rpcs_timer_ =
       ADD_TIMER(enqueue_profile_, "TotalHasDeferredRPCsTime");
+  total_spilled_batches_counter_ =
+      ADD_COUNTER(enqueue_profile_, "TotalBatchesSpilled", TUnit::UNIT);
+  spill_batch_timer_ = ADD_TIMER(enqueue_profile_, "SpillRowBatchTime");
+  total_local_batches_counter_ =
+      ADD_COUNTER(enqueue_profile_, "TotalLocalBatchesReceived", TUnit::UNIT);
   dispatch_timer_ =
       ADD_SUMMARY_STATS_TIMER(enqueue_profile_, "DispatchTime");
+  sender_queue_wait_stats_ =
+      ADD_SUMMARY_STATS_TIMER(enqueue_profile_, "SenderQueueWaitTime");
 }
 
 Status KrpcDataStreamRecvr::GetNext(RowBatch* output_batch, bool* eos) {
@@ -757,6 +1051,14 @@ void KrpcDataStreamRecvr::AddBatch(const TransmitDataRequestPB* request,
   sender_queues_[use_sender_id]->AddBatch(request, response, rpc_context);
 }
 
+Status KrpcDataStreamRecvr::AddBatchLocal(int sender_id,
+    const OutboundRowBatch& outbound_batch, const RuntimeState* sender_state) {
+  int use_sender_id = is_merging_ ? sender_id : 0;
+  // Add all batches to the same queue if is_merging_ is false.
+  return sender_queues_[use_sender_id]->AddBatchLocal(
+      sender_id, outbound_batch, sender_state);
+}
+
 void KrpcDataStreamRecvr::ProcessDeferredRpc(int sender_id) {
   int use_sender_id = is_merging_ ? sender_id : 0;
   // Add all batches to the same queue if is_merging_ is false.
@@ -780,6 +1082,12 @@ void KrpcDataStreamRecvr::CancelStream() {
   for (auto& queue: sender_queues_) queue->Cancel();
 }
 
+void KrpcDataStreamRecvr::EnableSpilling(SpillableRowBatchQueue* spill_queue) {
+  DCHECK(!is_merging_);
+  DCHECK_EQ(sender_queues_.size(), 1);
+  sender_queues_[0]->EnableSpilling(spill_queue);
+}
+
 void KrpcDataStreamRecvr::Close() {
   DCHECK(TestInfo::is_test() || FragmentInstanceState::IsFragmentExecThread());
   DCHECK(!closed_);
@@ -792,6 +1100,7 @@ void KrpcDataStreamRecvr::Close() {
   }
   for (auto& queue: sender_queues_) queue->Close();
   merger_.reset();
+  ReportSenderQueueWait();
 
   // Given all queues have been cancelled and closed already at this point, it's safe to
   // call Close() on 'deferred_rpc_tracker_' without holding any lock here.
@@ -807,6 +1116,31 @@ void KrpcDataStreamRecvr::Close() {
   profile_ = nullptr;
 }
 
+void KrpcDataStreamRecvr::AddSenderQueueWait(int sender_id, int64_t wait_ns) {
+  if (sender_id < 0 || sender_id >= sender_queue_wait_ns_.size()) return;
+  sender_queue_wait_ns_[sender_id].Add(wait_ns);
+}
+
+void KrpcDataStreamRecvr::ReportSenderQueueWait() {
+  vector<pair<int64_t, int>> waits;
+  for (int i = 0; i < sender_queue_wait_ns_.size(); ++i) {
+    const int64_t wait_ns = sender_queue_wait_ns_[i].Load();
+    sender_queue_wait_stats_->UpdateCounter(wait_ns);
+    if (wait_ns > 0) waits.emplace_back(wait_ns, i);
+  }
+  if (waits.empty()) return;
+  const int num_reported = min<int>(waits.size(), NUM_REPORTED_SENDERS);
+  std::partial_sort(waits.begin(), waits.begin() + num_reported, waits.end(),
+      std::greater<pair<int64_t, int>>());
+  stringstream ss;
+  for (int i = 0; i < num_reported; ++i) {
+    if (i > 0) ss << ", ";
+    ss << "sender=" << waits[i].second << ": "
+       << PrettyPrinter::Print(waits[i].first, TUnit::TIME_NS);
+  }
+  enqueue_profile_->AddInfoString("SlowestSenders", ss.str());
+}
+
 KrpcDataStreamRecvr::~KrpcDataStreamRecvr() {
   DCHECK(mgr_ == nullptr) << "Must call Close()";
 }
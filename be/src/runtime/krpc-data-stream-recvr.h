@@ -38,9 +38,11 @@ namespace impala {
 
 class KrpcDataStreamMgr;
 class MemTracker;
+class OutboundRowBatch;
 class RowBatch;
 class RuntimeProfile;
 class SortedRunMerger;
+class SpillableRowBatchQueue;
 struct TransmitDataCtx;
 class TransmitDataRequestPB;
 class TransmitDataResponsePB;
@@ -102,8 +104,10 @@ class KrpcDataStreamRecvr {
   /// Create a SortedRunMerger instance to merge rows from multiple sender according to
   /// the specified row comparator. Fetches the first batches from the individual sender
   /// queues. The exprs used in less_than must have already been prepared and opened.
+  /// If 'use_key_prefixes' is true, the merger compares cached key prefixes of the rows
+  /// before comparing them with 'less_than' (see SortedRunMerger).
   /// Called from fragment instance execution threads only.
-  Status CreateMerger(const TupleRowComparator& less_than);
+  Status CreateMerger(const TupleRowComparator& less_than, bool use_key_prefixes = false);
 
   /// Fill output_batch with the next batch of rows obtained by merging the per-sender
   /// input streams. Must only be called if is_merging_ is true. Called from fragment
@@ -118,6 +122,15 @@ class KrpcDataStreamRecvr {
   /// the cancellation.
   void CancelStream();
 
+  /// Lets the receiver add the row batches that would exceed its buffer limit to
+  /// 'spill_queue' instead of deferring the RPCs that deliver them, so that the senders
+  /// are not blocked by a slow consumer until 'spill_queue' is full. While there are
+  /// rows in 'spill_queue', new batches are spilled or deferred too, so the rows of each
+  /// sender are still returned in the order they were sent. Must only be called if
+  /// is_merging_ is false. 'spill_queue' must be open and remain open until after
+  /// Close(). Called from fragment instance execution threads only.
+  void EnableSpilling(SpillableRowBatchQueue* spill_queue);
+
   const TUniqueId& fragment_instance_id() const { return fragment_instance_id_; }
   PlanNodeId dest_node_id() const { return dest_node_id_; }
   const RowDescriptor* row_desc() const { return row_desc_; }
@@ -143,6 +156,15 @@ class KrpcDataStreamRecvr {
   void AddBatch(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
       kudu::rpc::RpcContext* context);
 
+  /// Adds the serialized row batch 'outbound_batch' from the sender 'sender_id' in this
+  /// process to the appropriate sender queue, without a TransmitData() RPC. If the batch
+  /// can't be added without exceeding the buffer limit, waits in the calling thread
+  /// until it can, the receiver is cancelled, or 'sender_state' is cancelled. Returns
+  /// DATASTREAM_RECVR_CLOSED if the receiver is cancelled and CANCELLED if the sender is.
+  /// The batch is deserialized before this returns, so the caller may reuse it.
+  Status AddBatchLocal(int sender_id, const OutboundRowBatch& outbound_batch,
+      const RuntimeState* sender_state);
+
   /// Tries adding the first entry of 'deferred_rpcs_' queue for the sender queue
   /// identified by 'sender_id'. If is_merging_ is false, it always defaults to
   /// queue 0; If is_merging_ is true, the sender queue is identified by 'sender_id_'.
@@ -165,6 +187,14 @@ class KrpcDataStreamRecvr {
     return num_buffered_bytes_.Load() + batch_size > total_buffer_limit_;
   }
 
+  /// Adds 'wait_ns' to the time that the batches of the sender 'sender_id' waited for
+  /// room in the queues. Called with the lock of the sender's queue held.
+  void AddSenderQueueWait(int sender_id, int64_t wait_ns);
+
+  /// Updates 'sender_queue_wait_stats_' and adds the senders whose batches waited
+  /// longest to the profile. Called from Close().
+  void ReportSenderQueueWait();
+
   /// Return the current number of deferred RPCs.
   int64_t num_deferred_rpcs() const { return num_deferred_rpcs_.Load(); }
 
@@ -260,6 +290,10 @@ class KrpcDataStreamRecvr {
   /// Wall-clock time spent waiting for the first batch arrival across all queues.
   RuntimeProfile::Counter* first_batch_wait_total_timer_;
 
+  /// Part of 'data_wait_timer_' in which the queue that was waited on had deferred RPCs,
+  /// i.e. the next batch had arrived but was not deserialized yet.
+  RuntimeProfile::Counter* deserialize_wait_timer_;
+
   /// ------------------------------------------------------------------------------------
   /// Following counters belong to 'enqueue_profile_'.
 
@@ -288,6 +322,14 @@ class KrpcDataStreamRecvr {
   /// full row batch queue.
   RuntimeProfile::Counter* total_deferred_rpcs_counter_;
 
+  /// Total number of row batches added by senders in this process via AddBatchLocal().
+  RuntimeProfile::Counter* total_local_batches_counter_;
+
+  /// Total number of deserialized row batches added to the spill queue instead of
+  /// 'batch_queue_', and the wall-clock time spent adding them.
+  RuntimeProfile::Counter* total_spilled_batches_counter_;
+  RuntimeProfile::Counter* spill_batch_timer_;
+
   /// Time series of number of deferred row batches, samples 'num_deferred_rpcs_'.
   RuntimeProfile::TimeSeriesCounter* deferred_rpcs_time_series_counter_;
 
@@ -297,6 +339,15 @@ class KrpcDataStreamRecvr {
   /// Summary stats of time which RPCs spent in KRPC service queue before
   /// being dispatched to the RPC handlers.
   RuntimeProfile::SummaryStatsCounter* dispatch_timer_;
+
+  /// The number of senders that are reported in the "SlowestSenders" info string.
+  static const int NUM_REPORTED_SENDERS = 5;
+
+  /// The time that the row batches of each sender, by sender id, were deferred or
+  /// waited in AddBatchLocal() before they were added to the queues, and its summary
+  /// stats over the senders, which are updated in Close().
+  std::vector<AtomicInt64> sender_queue_wait_ns_;
+  RuntimeProfile::SummaryStatsCounter* sender_queue_wait_stats_;
 };
 
 } // namespace impala
@@ -0,0 +1,180 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/krpc-data-stream-relay.h"
+
+#include <boost/bind.hpp>
+
+#include "kudu/rpc/rpc_context.h"
+#include "kudu/rpc/rpc_sidecar.h"
+#include "kudu/util/monotime.h"
+#include "rpc/rpc-mgr.h"
+#include "runtime/exec-env.h"
+#include "runtime/krpc-data-stream-mgr.h"
+#include "service/data-stream-service.h"
+#include "util/kudu-status-util.h"
+#include "util/network-util.h"
+
+#include "gen-cpp/data_stream_service.proxy.h"
+
+#include "common/names.h"
+
+DECLARE_int32(rpc_retry_interval_ms);
+
+using kudu::MonoDelta;
+using kudu::rpc::RpcContext;
+using kudu::rpc::RpcSidecar;
+
+namespace impala {
+
+KrpcDataStreamRelay::KrpcDataStreamRelay(KrpcDataStreamMgr* stream_mgr,
+    MemTracker* service_mem_tracker, const TransmitDataRequestPB* request,
+    TransmitDataResponsePB* response, RpcContext* rpc_context)
+  : stream_mgr_(stream_mgr),
+    service_mem_tracker_(service_mem_tracker),
+    request_(request),
+    response_(response),
+    rpc_context_(rpc_context) {}
+
+KrpcDataStreamRelay::~KrpcDataStreamRelay() {
+  DCHECK_EQ(num_pending_rpcs_, 0);
+}
+
+void KrpcDataStreamRelay::SplitIntoGroups(
+    int num_destinations, int fanout, vector<pair<int, int>>* groups) {
+  DCHECK_GT(fanout, 0);
+  groups->clear();
+  const int num_groups = min(num_destinations, fanout);
+  for (int i = 0; i < num_groups; ++i) {
+    groups->emplace_back(static_cast<int64_t>(i) * num_destinations / num_groups,
+        static_cast<int64_t>(i + 1) * num_destinations / num_groups);
+  }
+}
+
+Status KrpcDataStreamRelay::Start() {
+  DCHECK_GT(request_->relay_destinations_size(), 0);
+  DCHECK(rpcs_.empty());
+  KUDU_RETURN_IF_ERROR(rpc_context_->GetInboundSidecar(
+      request_->tuple_offsets_sidecar_idx(), &tuple_offsets_),
+      "Failed to get the tuple offsets sidecar");
+  KUDU_RETURN_IF_ERROR(rpc_context_->GetInboundSidecar(
+      request_->tuple_data_sidecar_idx(), &tuple_data_),
+      "Failed to get the tuple data sidecar");
+  vector<pair<int, int>> groups;
+  SplitIntoGroups(request_->relay_destinations_size(),
+      max(1, request_->relay_fanout()), &groups);
+  for (const pair<int, int>& group : groups) {
+    rpcs_.emplace_back(new OutboundRpc());
+    RETURN_IF_ERROR(InitRpc(group.first, group.second, rpcs_.back().get()));
+  }
+  // Count all RPCs before sending any, as they may complete right away.
+  num_pending_rpcs_ = rpcs_.size();
+  for (unique_ptr<OutboundRpc>& rpc : rpcs_) {
+    Status status = DoRpc(rpc.get());
+    if (UNLIKELY(!status.ok())) RpcDone(status);
+  }
+  return Status::OK();
+}
+
+Status KrpcDataStreamRelay::InitRpc(int begin, int end, OutboundRpc* rpc) {
+  DCHECK_LT(begin, end);
+  const RelayDestinationPB& dest = request_->relay_destinations(begin);
+  rpc->destination = NetworkAddressPBToString(dest.address());
+  RETURN_IF_ERROR(DataStreamService::GetProxy(
+      FromNetworkAddressPB(dest.address()), dest.hostname(), &rpc->proxy));
+  TransmitDataRequestPB* req = &rpc->request;
+  *req->mutable_dest_fragment_instance_id() = dest.fragment_instance_id();
+  req->set_sender_id(request_->sender_id());
+  req->set_dest_node_id(request_->dest_node_id());
+  *req->mutable_row_batch_header() = request_->row_batch_header();
+  if (end - begin > 1) {
+    for (int i = begin + 1; i < end; ++i) {
+      *req->add_relay_destinations() = request_->relay_destinations(i);
+    }
+    req->set_relay_fanout(request_->relay_fanout());
+  }
+  return Status::OK();
+}
+
+Status KrpcDataStreamRelay::DoRpc(OutboundRpc* rpc) {
+  rpc->controller.Reset();
+  int sidecar_idx;
+  KUDU_RETURN_IF_ERROR(rpc->controller.AddOutboundSidecar(
+      RpcSidecar::FromSlice(tuple_offsets_), &sidecar_idx),
+      "Unable to add tuple offsets to sidecar");
+  rpc->request.set_tuple_offsets_sidecar_idx(sidecar_idx);
+  KUDU_RETURN_IF_ERROR(rpc->controller.AddOutboundSidecar(
+      RpcSidecar::FromSlice(tuple_data_), &sidecar_idx),
+      "Unable to add tuple data to sidecar");
+  rpc->request.set_tuple_data_sidecar_idx(sidecar_idx);
+  rpc->response.Clear();
+  rpc->proxy->TransmitDataAsync(rpc->request, &rpc->response, &rpc->controller,
+      boost::bind(&KrpcDataStreamRelay::RpcCompleteCb, this, rpc));
+  return Status::OK();
+}
+
+void KrpcDataStreamRelay::RpcCompleteCb(OutboundRpc* rpc) {
+  const kudu::Status& controller_status = rpc->controller.status();
+  if (UNLIKELY(!controller_status.ok())) {
+    if (RpcMgr::IsServerTooBusy(rpc->controller)) {
+      ExecEnv::GetInstance()->rpc_mgr()->messenger()->ScheduleOnReactor(
+          boost::bind(&KrpcDataStreamRelay::RetryCb, this, rpc, _1),
+          MonoDelta::FromMilliseconds(FLAGS_rpc_retry_interval_ms));
+      return;
+    }
+    RpcDone(FromKuduStatus(controller_status,
+        Substitute("Relaying TransmitData() to $0 failed", rpc->destination)));
+    return;
+  }
+  // A closed receiver does not stop the relay: the rest of its group still got the
+  // batch, and this backend's own receiver may still want it.
+  Status status(rpc->response.status());
+  if (status.code() == TErrorCode::DATASTREAM_RECVR_CLOSED) status = Status::OK();
+  RpcDone(status);
+}
+
+void KrpcDataStreamRelay::RetryCb(OutboundRpc* rpc, const kudu::Status& cb_status) {
+  // Aborted by KRPC layer as reactor thread was being shut down.
+  if (UNLIKELY(!cb_status.ok())) {
+    RpcDone(FromKuduStatus(cb_status, "KRPC retry failed"));
+    return;
+  }
+  Status status = DoRpc(rpc);
+  if (UNLIKELY(!status.ok())) RpcDone(status);
+}
+
+void KrpcDataStreamRelay::RpcDone(const Status& status) {
+  {
+    lock_guard<SpinLock> l(lock_);
+    if (!status.ok() && status_.ok()) status_ = status;
+    DCHECK_GT(num_pending_rpcs_, 0);
+    if (--num_pending_rpcs_ > 0) return;
+  }
+  stream_mgr_->EnqueueRelay(this);
+}
+
+void KrpcDataStreamRelay::Finish() {
+  DCHECK_EQ(num_pending_rpcs_, 0);
+  if (UNLIKELY(!status_.ok())) {
+    DataStreamService::RespondAndReleaseRpc(
+        status_, response_, rpc_context_, service_mem_tracker_);
+    return;
+  }
+  stream_mgr_->DeliverData(request_, response_, rpc_context_);
+}
+
+} // namespace impala
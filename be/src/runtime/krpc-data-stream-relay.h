@@ -0,0 +1,141 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "common/status.h"
+#include "gutil/macros.h"
+#include "kudu/rpc/rpc_controller.h"
+#include "kudu/util/slice.h"
+#include "util/spinlock.h"
+
+#include "gen-cpp/data_stream_service.pb.h"
+
+namespace kudu {
+namespace rpc {
+class RpcContext;
+} // namespace rpc
+} // namespace kudu
+
+namespace impala {
+
+class DataStreamServiceProxy;
+class KrpcDataStreamMgr;
+class MemTracker;
+
+/// Relays the row batch of a TransmitData() RPC to the receivers listed in its
+/// 'relay_destinations', so that a broadcast sender only has to send each row batch to a
+/// few receivers, which forward it to the rest in a tree. See "Relaying broadcast row
+/// batches" in krpc-data-stream-mgr.h.
+///
+/// The destinations are split into groups by SplitIntoGroups(). The row batch is sent to
+/// the first destination of each group, with the rest of the group as the relay
+/// destinations of that RPC. The serialized row batch is not deserialized: the outbound
+/// RPCs send the sidecars of the inbound RPC, which must therefore not be responded to
+/// until all outbound RPCs have completed. Once they all succeeded, the inbound RPC is
+/// handed to KrpcDataStreamMgr::DeliverData() like any other TransmitData() RPC.
+/// Otherwise, it is responded to with the error.
+///
+/// The outbound RPCs are retried if the remote service is too busy, like the RPCs of
+/// KrpcDataStreamSender. Their completion callbacks run in reactor threads, so the
+/// inbound RPC is handed to DeliverData() in one of the stream manager's relay threads.
+class KrpcDataStreamRelay {
+ public:
+  /// 'service_mem_tracker' tracks the payload of the inbound RPC until it is handed to
+  /// DeliverData() or responded to.
+  KrpcDataStreamRelay(KrpcDataStreamMgr* stream_mgr, MemTracker* service_mem_tracker,
+      const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
+      kudu::rpc::RpcContext* rpc_context);
+
+  ~KrpcDataStreamRelay();
+
+  /// Sends the row batch to the relay destinations. Once all RPCs completed, passes this
+  /// relay to KrpcDataStreamMgr::EnqueueRelay(). Returns an error if the RPCs could not
+  /// be set up, in which case none was sent and the caller must respond to the inbound
+  /// RPC. Must be called once.
+  Status Start();
+
+  /// Hands the inbound RPC to KrpcDataStreamMgr::DeliverData() or responds to it with
+  /// the error of an outbound RPC. Called once all outbound RPCs completed.
+  void Finish();
+
+  /// Splits 'num_destinations' destinations, in order, into at most 'fanout' contiguous
+  /// non-empty groups whose sizes differ by at most one. Sets 'groups' to the
+  /// [begin, end) index ranges of the groups. Used by both senders and relays, so that
+  /// the shape of the tree only depends on the list of destinations.
+  static void SplitIntoGroups(
+      int num_destinations, int fanout, std::vector<std::pair<int, int>>* groups);
+
+ private:
+  /// The TransmitData() RPC to the first destination of one group.
+  struct OutboundRpc {
+    std::unique_ptr<DataStreamServiceProxy> proxy;
+    kudu::rpc::RpcController controller;
+    TransmitDataRequestPB request;
+    TransmitDataResponsePB response;
+    /// The destination of the RPC, for error messages.
+    std::string destination;
+  };
+
+  /// Initializes 'rpc' to send the row batch to the destinations in the [begin, end)
+  /// range of the inbound request's relay destinations.
+  Status InitRpc(int begin, int end, OutboundRpc* rpc);
+
+  /// Adds the sidecars to the controller of 'rpc' and sends it.
+  Status DoRpc(OutboundRpc* rpc);
+
+  /// Completion callback of 'rpc', called in a reactor thread.
+  void RpcCompleteCb(OutboundRpc* rpc);
+
+  /// Called in a reactor thread to retry 'rpc' after the remote service was too busy.
+  void RetryCb(OutboundRpc* rpc, const kudu::Status& cb_status);
+
+  /// Records that 'rpc' completed with 'status'. Passes this relay to the stream manager
+  /// once all RPCs completed.
+  void RpcDone(const Status& status);
+
+  KrpcDataStreamMgr* const stream_mgr_;
+  MemTracker* const service_mem_tracker_;
+
+  /// The inbound RPC. Responded to in Finish().
+  const TransmitDataRequestPB* const request_;
+  TransmitDataResponsePB* const response_;
+  kudu::rpc::RpcContext* const rpc_context_;
+
+  /// The sidecars of the inbound RPC, which the outbound RPCs send.
+  kudu::Slice tuple_offsets_;
+  kudu::Slice tuple_data_;
+
+  std::vector<std::unique_ptr<OutboundRpc>> rpcs_;
+
+  /// Protects the following fields, which are updated by the RPC callbacks.
+  SpinLock lock_;
+
+  /// The number of outbound RPCs that have not completed yet.
+  int num_pending_rpcs_ = 0;
+
+  /// The first error of an outbound RPC.
+  Status status_;
+
+  DISALLOW_COPY_AND_ASSIGN(KrpcDataStreamRelay);
+};
+
+} // namespace impala
@@ -19,6 +19,7 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 #include <iostream>
@@ -39,6 +40,8 @@
 #include "runtime/descriptors.h"
 #include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
+#include "runtime/krpc-data-stream-mgr.h"
+#include "runtime/krpc-data-stream-relay.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.inline.h"
 #include "runtime/row-batch.h"
@@ -47,8 +50,11 @@
 #include "service/data-stream-service.h"
 #include "util/aligned-new.h"
 #include "util/debug-util.h"
+#include "util/event-tracer.h"
+#include "util/hdr-histogram.h"
 #include "util/network-util.h"
 #include "util/pretty-printer.h"
+#include "util/uid-util.h"
 
 #include "gen-cpp/data_stream_service.pb.h"
 #include "gen-cpp/data_stream_service.proxy.h"
@@ -59,6 +65,10 @@
 DEFINE_int64(data_stream_sender_buffer_size, 16 * 1024,
     "(Advanced) Max size in bytes which a row batch in a data stream sender's channel "
     "can accumulate before the row batch is sent over the wire.");
+DEFINE_int64(data_stream_sender_shared_buffer_size, 1024 * 1024,
+    "(Advanced) Max size in bytes which the row batch that a hash partitioning data "
+    "stream sender shares between all its channels can accumulate before the rows are "
+    "sent over the wire. Only used if the SHARED_EXCHANGE_BUFFER query option is set.");
 
 using std::condition_variable_any;
 using namespace apache::thrift;
@@ -71,6 +81,28 @@ DECLARE_int32(rpc_retry_interval_ms);
 
 namespace impala {
 
+/// The highest RPC latency in microseconds that the histograms of DestinationStats
+/// track, and the number of destinations that are reported in the profile.
+static const int64_t MAX_TRACKED_RPC_LATENCY_US = 3600LL * MICROS_PER_SEC;
+static const int NUM_REPORTED_DESTINATIONS = 5;
+
+// The latency and backpressure of the RPCs of the channels to one backend. The latency
+// histogram has one significant digit, which keeps it at a few KB per backend.
+struct KrpcDataStreamSender::DestinationStats {
+  explicit DestinationStats(const NetworkAddressPB& address)
+    : address(address), rpc_latency_us(MAX_TRACKED_RPC_LATENCY_US, 1) {}
+
+  const NetworkAddressPB address;
+
+  // Total time of the TransmitData() RPCs, from sending them to the callback. Updated
+  // by the RPC callbacks.
+  HdrHistogram rpc_latency_us;
+
+  // Time that the channels waited for their previous RPC to complete. Only updated by
+  // the fragment instance thread.
+  int64_t backpressure_ns = 0;
+};
+
 const char* KrpcDataStreamSender::HASH_ROW_SYMBOL =
     "KrpcDataStreamSender7HashRowEPNS_8TupleRowE";
 const char* KrpcDataStreamSender::LLVM_CLASS_NAME = "class.impala::KrpcDataStreamSender";
@@ -173,6 +205,8 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // preceding RPC is still in-flight. This is expected to be called from the fragment
   // instance execution thread. Return error status if initialization of the RPC request
   // parameters failed or if the preceding RPC failed. Returns OK otherwise.
+  // If the receiver is in this process, the batch is handed to it directly, which may
+  // block until the receiver has room for it. See TransmitDataLocal().
   Status TransmitData(const OutboundRowBatch* outbound_batch);
 
   // Copies a single row into this channel's row batch and flushes the row batch once
@@ -203,6 +237,13 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // Returns OK otherwise. This should be only called from a fragment executor thread.
   Status WaitForRpc();
 
+  // Returns the destination of this channel as a relay destination of other channels.
+  RelayDestinationPB relay_destination() const;
+
+  // Makes the TransmitData() RPCs of this channel relay the row batches to the
+  // destinations of 'channels'. Called from Prepare() before any RPC is sent.
+  void SetRelayDestinations(const std::vector<Channel*>& channels);
+
   // The type for a RPC worker function.
   typedef boost::function<Status()> DoRpcFn;
 
@@ -271,6 +312,9 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // The monotonic time in nanoseconds of when current RPC started.
   int64_t rpc_start_time_ns_ = 0;
 
+  // The statistics of the channels to 'address_'. Owned by the parent. Set in Init().
+  DestinationStats* dest_stats_ = nullptr;
+
   // True if there is an in-flight RPC.
   bool rpc_in_flight_ = false;
 
@@ -282,10 +326,33 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // TODO: Fix IMPALA-3990
   bool remote_recvr_closed_ = false;
 
+  // True if the parent's 'local_exchange_' is set and the receiver is in this process.
+  // Then the batches are handed to the receiver directly and serialized without
+  // compression. Set in Init().
+  bool is_local_ = false;
+
+  // The destinations that the remote receiver's backend relays the row batches sent by
+  // this channel to. Empty unless this channel is one of the parent's 'relay_roots_'.
+  // Since those destinations still need the row batches, 'remote_recvr_closed_' is never
+  // set if this is not empty.
+  google::protobuf::RepeatedPtrField<RelayDestinationPB> relay_destinations_;
+
   // Returns true if the channel should terminate because the parent sender
   // has been closed or cancelled.
   bool ShouldTerminate() const { return shutdown_ || parent_->state_->is_cancelled(); }
 
+  // Chooses the codec for the batches that this channel sends. Used only when the
+  // partitioning strategy is not UNPARTITIONED.
+  ExchangeCodecSelector codec_selector_;
+
+  // Returns the codec selector that the batches sent by this channel are serialized
+  // with: the parent's if it serializes one batch for all channels.
+  ExchangeCodecSelector* codec_selector() {
+    return parent_->partition_type_ == TPartitionType::UNPARTITIONED ?
+        &parent_->codec_selector_ :
+        &codec_selector_;
+  }
+
   // Send the rows accumulated in the internal row batch. This will serialize the
   // internal row batch before sending them to the destination. This may block if
   // the preceding RPC is still in progress. Returns error status if serialization
@@ -326,6 +393,12 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // rescheduled if it's due to remote server being too busy.
   void TransmitDataCompleteCb();
 
+  // Adds 'outbound_batch' to the receiver in this process through the data stream
+  // manager. Sets 'delivered' to false if the receiver is not registered yet, in which
+  // case the batch must be sent in an RPC. Returns the error of the receiver or
+  // CANCELLED if the parent sender is cancelled. Called without holding 'lock_'.
+  Status TransmitDataLocal(const OutboundRowBatch* outbound_batch, bool* delivered);
+
   // Initializes the parameters for TransmitData() RPC and invokes the async RPC call.
   // It will add 'tuple_offsets_' and 'tuple_data_' in 'rpc_in_flight_batch_' as sidecars
   // to the RpcController and store the sidecars' indices to TransmitDataRequestPB sent as
@@ -368,13 +441,20 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
 
 Status KrpcDataStreamSender::Channel::Init(RuntimeState* state) {
   // TODO: take into account of var-len data at runtime.
-  int capacity =
-      max(1, parent_->per_channel_buffer_size_ / max(row_desc_->GetRowSize(), 1));
-  batch_.reset(new RowBatch(row_desc_, capacity, parent_->mem_tracker()));
+  // Rows are accumulated in the parent's shared batch if it has one.
+  if (parent_->shared_batch_ == nullptr) {
+    int capacity =
+        max(1, parent_->per_channel_buffer_size_ / max(row_desc_->GetRowSize(), 1));
+    batch_.reset(new RowBatch(row_desc_, capacity, parent_->mem_tracker()));
+  }
 
-  // Create a DataStreamService proxy to the destination.
-  RETURN_IF_ERROR(
-      DataStreamService::GetProxy(FromNetworkAddressPB(address_), hostname_, &proxy_));
+  // Create a DataStreamService proxy to the destination. It is also used by local
+  // channels for the batches sent before the receiver is registered and for EOS.
+  const TNetworkAddress address = FromNetworkAddressPB(address_);
+  RETURN_IF_ERROR(DataStreamService::GetProxy(address, hostname_, &proxy_));
+  is_local_ =
+      parent_->local_exchange_ && address == ExecEnv::GetInstance()->krpc_address();
+  dest_stats_ = parent_->GetDestinationStats(address_);
   return Status::OK();
 }
 
@@ -407,12 +487,32 @@ void KrpcDataStreamSender::Channel::LogSlowFailedRpc(
             << "Error: " << err.ToString();
 }
 
+RelayDestinationPB KrpcDataStreamSender::Channel::relay_destination() const {
+  RelayDestinationPB dest;
+  *dest.mutable_fragment_instance_id() = fragment_instance_id_;
+  *dest.mutable_address() = address_;
+  dest.set_hostname(hostname_);
+  return dest;
+}
+
+void KrpcDataStreamSender::Channel::SetRelayDestinations(
+    const std::vector<Channel*>& channels) {
+  DCHECK(!rpc_in_flight_);
+  // The receiver's backend must get the batches in an RPC to relay them.
+  is_local_ = false;
+  relay_destinations_.Clear();
+  for (const Channel* channel : channels) {
+    *relay_destinations_.Add() = channel->relay_destination();
+  }
+}
+
 Status KrpcDataStreamSender::Channel::WaitForRpc() {
   std::unique_lock<SpinLock> l(lock_);
   return WaitForRpcLocked(&l);
 }
 
 Status KrpcDataStreamSender::Channel::WaitForRpcLocked(std::unique_lock<SpinLock>* lock) {
+  SCOPED_TRACE_EVENT("DataStreamSender::WaitForRpc");
   DCHECK(lock != nullptr);
   DCHECK(lock->owns_lock());
 
@@ -420,10 +520,12 @@ Status KrpcDataStreamSender::Channel::WaitForRpcLocked(std::unique_lock<SpinLock
       parent_->state_->total_network_send_timer());
 
   // Wait for in-flight RPCs to complete unless the parent sender is closed or cancelled.
+  const bool waited = rpc_in_flight_;
   while(rpc_in_flight_ && !ShouldTerminate()) {
     rpc_done_cv_.wait_for(*lock, std::chrono::milliseconds(50));
   }
   int64_t elapsed_time_ns = timer.ElapsedTime();
+  if (waited && dest_stats_ != nullptr) dest_stats_->backpressure_ns += elapsed_time_ns;
   if (IsSlowRpc(elapsed_time_ns)) {
     LOG(INFO) << "Long delay waiting for RPC to " << address_
               << " (fragment_instance_id=" << PrintId(fragment_instance_id_) << "): "
@@ -509,13 +611,18 @@ void KrpcDataStreamSender::Channel::TransmitDataCompleteCb() {
       int64_t network_throughput = row_batch_size * NANOS_PER_SEC / network_time;
       parent_->network_throughput_counter_->UpdateCounter(network_throughput);
       parent_->network_time_stats_->UpdateCounter(network_time);
+      if (parent_->adaptive_compression_) {
+        codec_selector()->RecordTransmit(row_batch_size, network_time);
+      }
     }
     parent_->recvr_time_stats_->UpdateCounter(resp_.receiver_latency_ns());
+    dest_stats_->rpc_latency_us.Increment(
+        min<int64_t>(total_time / NANOS_PER_MICRO, MAX_TRACKED_RPC_LATENCY_US));
     if (IsSlowRpc(total_time)) LogSlowRpc("TransmitData", total_time, resp_);
     Status rpc_status = Status::OK();
     int32_t status_code = resp_.status().status_code();
     if (status_code == TErrorCode::DATASTREAM_RECVR_CLOSED) {
-      remote_recvr_closed_ = true;
+      remote_recvr_closed_ = relay_destinations_.empty();
     } else {
       rpc_status = Status(resp_.status());
     }
@@ -561,6 +668,11 @@ Status KrpcDataStreamSender::Channel::DoTransmitDataRpc() {
       "Unable to add tuple data to sidecar");
   req.set_tuple_data_sidecar_idx(sidecar_idx);
 
+  if (!relay_destinations_.empty()) {
+    *req.mutable_relay_destinations() = relay_destinations_;
+    req.set_relay_fanout(parent_->relay_fanout_);
+  }
+
   resp_.Clear();
   proxy_->TransmitDataAsync(req, &resp_, &rpc_controller_,
       boost::bind(&KrpcDataStreamSender::Channel::TransmitDataCompleteCb, this));
@@ -582,21 +694,60 @@ Status KrpcDataStreamSender::Channel::TransmitData(
   // If the remote receiver is closed already, there is no point in sending anything.
   // TODO: Needs better solution for IMPALA-3990 in the long run.
   if (UNLIKELY(remote_recvr_closed_)) return Status::OK();
+  if (is_local_) {
+    // No RPC is in flight, so 'lock_' is only needed again to send one.
+    l.unlock();
+    bool delivered;
+    RETURN_IF_ERROR(TransmitDataLocal(outbound_batch, &delivered));
+    if (delivered) return Status::OK();
+    l.lock();
+  }
   rpc_in_flight_ = true;
   rpc_in_flight_batch_ = outbound_batch;
   RETURN_IF_ERROR(DoTransmitDataRpc());
   return Status::OK();
 }
 
+Status KrpcDataStreamSender::Channel::TransmitDataLocal(
+    const OutboundRowBatch* outbound_batch, bool* delivered) {
+  SCOPED_TIMER(parent_->local_transmit_timer_);
+  TUniqueId finst_id;
+  UniqueIdPBToTUniqueId(fragment_instance_id_, &finst_id);
+  Status status = ExecEnv::GetInstance()->stream_mgr()->AddDataLocal(finst_id,
+      dest_node_id_, parent_->sender_id_, *outbound_batch, parent_->state_, delivered);
+  if (status.code() == TErrorCode::DATASTREAM_RECVR_CLOSED) {
+    std::unique_lock<SpinLock> l(lock_);
+    remote_recvr_closed_ = true;
+    return Status::OK();
+  }
+  RETURN_IF_ERROR(status);
+  if (*delivered) {
+    COUNTER_ADD(parent_->local_batches_sent_counter_, 1);
+    COUNTER_ADD(
+        parent_->bytes_sent_counter_, RowBatch::GetSerializedSize(*outbound_batch));
+  }
+  return Status::OK();
+}
+
 Status KrpcDataStreamSender::Channel::SerializeAndSendBatch(RowBatch* batch) {
   OutboundRowBatch* outbound_batch = &outbound_batches_[next_batch_idx_];
   // Reads 'rpc_in_flight_batch_' without acquiring 'lock_', so reads can be racey.
   ANNOTATE_IGNORE_READS_BEGIN();
   DCHECK(outbound_batch != rpc_in_flight_batch_);
   ANNOTATE_IGNORE_READS_END();
-  RETURN_IF_ERROR(parent_->SerializeBatch(batch, outbound_batch));
+  // The batches for a receiver in this process are not compressed.
+  RETURN_IF_ERROR(parent_->SerializeBatch(
+      batch, outbound_batch, is_local_ ? nullptr : codec_selector()));
   RETURN_IF_ERROR(TransmitData(outbound_batch));
   next_batch_idx_ = (next_batch_idx_ + 1) % NUM_OUTBOUND_BATCHES;
+  // TransmitData() waited for the preceding RPC, so only 'outbound_batch' may still be
+  // in flight. With a shared batch, free the others so that the memory of a channel
+  // is not held between the channel's infrequent sends.
+  if (parent_->shared_batch_ != nullptr) {
+    for (int i = 0; i < NUM_OUTBOUND_BATCHES; ++i) {
+      if (&outbound_batches_[i] != outbound_batch) outbound_batches_[i].FreeBuffers();
+    }
+  }
   return Status::OK();
 }
 
@@ -666,6 +817,8 @@ Status KrpcDataStreamSender::Channel::DoEndDataStreamRpc() {
 }
 
 Status KrpcDataStreamSender::Channel::FlushBatches() {
+  // Without 'batch_', the rows are flushed by the parent's SendSharedBatch().
+  if (batch_ == nullptr) return Status::OK();
   VLOG_RPC << "Channel::FlushBatches() fragment_instance_id="
            << PrintId(fragment_instance_id_) << " dest_node=" << dest_node_id_
            << " #rows= " << batch_->num_rows();
@@ -679,9 +832,8 @@ Status KrpcDataStreamSender::Channel::FlushBatches() {
 
 Status KrpcDataStreamSender::Channel::SendEosAsync() {
   VLOG_RPC << "Channel::SendEosAsync() fragment_instance_id="
-           << PrintId(fragment_instance_id_) << " dest_node=" << dest_node_id_
-           << " #rows= " << batch_->num_rows();
-  DCHECK_EQ(0, batch_->num_rows()) << "Batches must be flushed";
+           << PrintId(fragment_instance_id_) << " dest_node=" << dest_node_id_;
+  DCHECK(batch_ == nullptr || batch_->num_rows() == 0) << "Batches must be flushed";
   {
     std::unique_lock<SpinLock> l(lock_);
     DCHECK(!rpc_in_flight_);
@@ -772,12 +924,62 @@ Status KrpcDataStreamSender::Prepare(
   recvr_time_stats_ =
       ADD_SUMMARY_STATS_COUNTER(profile(), "RpcRecvrTime", TUnit::TIME_NS);
   eos_sent_counter_ = ADD_COUNTER(profile(), "EosSent", TUnit::UNIT);
+  destination_backpressure_stats_ =
+      ADD_SUMMARY_STATS_TIMER(profile(), "DestinationBackpressureTime");
+  local_batches_sent_counter_ =
+      ADD_COUNTER(profile(), "LocalRowBatchesSent", TUnit::UNIT);
+  local_transmit_timer_ = ADD_TIMER(profile(), "LocalTransmitTime");
   uncompressed_bytes_counter_ =
       ADD_COUNTER(profile(), "UncompressedRowBatchSize", TUnit::BYTES);
+  compression_bytes_saved_counter_ =
+      ADD_COUNTER(profile(), "CompressionBytesSaved", TUnit::BYTES);
+  uncompressed_batches_counter_ =
+      ADD_COUNTER(profile(), "UncompressedRowBatches", TUnit::UNIT);
+  lz4_batches_counter_ = ADD_COUNTER(profile(), "Lz4RowBatches", TUnit::UNIT);
+  zstd_batches_counter_ = ADD_COUNTER(profile(), "ZstdRowBatches", TUnit::UNIT);
   total_sent_rows_counter_= ADD_COUNTER(profile(), "RowsSent", TUnit::UNIT);
+  skew_sample_interval_ = state->query_options().exchange_skew_sample_interval;
+  if (partition_type_ == TPartitionType::HASH_PARTITIONED && channels_.size() > 1
+      && skew_sample_interval_ > 0) {
+    skew_sketch_.reset(new SpaceSavingSketch(SKEW_SKETCH_CAPACITY));
+    skew_sampled_rows_counter_ = ADD_COUNTER(profile(), "SkewSampledRows", TUnit::UNIT);
+  }
+  adaptive_compression_ = state->query_options().adaptive_exchange_compression;
+  columnar_batches_ = state->query_options().exchange_columnar_batches;
+  if (columnar_batches_) {
+    columnar_batches_counter_ = ADD_COUNTER(profile(), "ColumnarRowBatches", TUnit::UNIT);
+  }
+  local_exchange_ = state->query_options().local_exchange_shortcut;
+  if (partition_type_ == TPartitionType::HASH_PARTITIONED && channels_.size() > 1
+      && state->query_options().shared_exchange_buffer) {
+    // TODO: take into account of var-len data at runtime.
+    int capacity = max<int64_t>(1,
+        FLAGS_data_stream_sender_shared_buffer_size / max(row_desc_->GetRowSize(), 1));
+    shared_batch_.reset(new RowBatch(row_desc_, capacity, mem_tracker()));
+    shared_partition_batch_.reset(new RowBatch(row_desc_, capacity, mem_tracker()));
+    shared_batch_rows_.resize(channels_.size());
+  }
   for (int i = 0; i < channels_.size(); ++i) {
     RETURN_IF_ERROR(channels_[i]->Init(state));
   }
+  relay_fanout_ = state->query_options().broadcast_relay_fanout;
+  if (partition_type_ == TPartitionType::UNPARTITIONED && relay_fanout_ > 0
+      && channels_.size() > relay_fanout_) {
+    // The channels were shuffled in the constructor, so each sender relays through a
+    // different tree. The relay of each root splits its group the same way.
+    vector<pair<int, int>> groups;
+    KrpcDataStreamRelay::SplitIntoGroups(channels_.size(), relay_fanout_, &groups);
+    for (const pair<int, int>& group : groups) {
+      Channel* root = channels_[group.first].get();
+      vector<Channel*> relayed;
+      for (int i = group.first + 1; i < group.second; ++i) {
+        relayed.push_back(channels_[i].get());
+      }
+      root->SetRelayDestinations(relayed);
+      relay_roots_.push_back(root);
+    }
+    profile()->AddInfoString("BroadcastRelayFanout", std::to_string(relay_fanout_));
+  }
   return Status::OK();
 }
 
@@ -968,9 +1170,53 @@ void KrpcDataStreamSenderConfig::Codegen(FragmentState* state) {
 }
 
 Status KrpcDataStreamSender::AddRowToChannel(const int channel_id, TupleRow* row) {
+  if (shared_batch_ != nullptr) return AddRowToSharedBatch(channel_id, row);
   return channels_[channel_id]->AddRow(row);
 }
 
+Status KrpcDataStreamSender::AddRowToSharedBatch(const int channel_id, TupleRow* row) {
+  if (shared_batch_->AtCapacity()
+      || shared_batch_->tuple_data_pool()->total_allocated_bytes()
+          >= FLAGS_data_stream_sender_shared_buffer_size) {
+    RETURN_IF_ERROR(SendSharedBatch());
+  }
+  int row_idx = shared_batch_->AddRow();
+  TupleRow* dest = shared_batch_->GetRow(row_idx);
+  const vector<TupleDescriptor*>& descs = row_desc_->tuple_descriptors();
+  for (int i = 0; i < descs.size(); ++i) {
+    if (UNLIKELY(row->GetTuple(i) == nullptr)) {
+      dest->SetTuple(i, nullptr);
+    } else {
+      dest->SetTuple(i,
+          row->GetTuple(i)->DeepCopy(*descs[i], shared_batch_->tuple_data_pool()));
+    }
+  }
+  shared_batch_->CommitLastRow();
+  shared_batch_rows_[channel_id].push_back(row_idx);
+  return Status::OK();
+}
+
+Status KrpcDataStreamSender::SendSharedBatch() {
+  const int num_tuples = row_desc_->tuple_descriptors().size();
+  for (int channel_id = 0; channel_id < channels_.size(); ++channel_id) {
+    vector<int>& rows = shared_batch_rows_[channel_id];
+    if (rows.empty()) continue;
+    for (int row_idx : rows) {
+      TupleRow* src = shared_batch_->GetRow(row_idx);
+      TupleRow* dest = shared_partition_batch_->GetRow(shared_partition_batch_->AddRow());
+      for (int i = 0; i < num_tuples; ++i) dest->SetTuple(i, src->GetTuple(i));
+      shared_partition_batch_->CommitLastRow();
+    }
+    rows.clear();
+    Status status = channels_[channel_id]->SerializeAndSendBatch(
+        shared_partition_batch_.get());
+    shared_partition_batch_->Reset();
+    RETURN_IF_ERROR(status);
+  }
+  shared_batch_->Reset();
+  return Status::OK();
+}
+
 uint64_t KrpcDataStreamSender::HashRow(TupleRow* row) {
   uint64_t hash_val = exchange_hash_seed_;
   for (ScalarExprEvaluator* eval : partition_expr_evals_) {
@@ -985,6 +1231,7 @@ uint64_t KrpcDataStreamSender::HashRow(TupleRow* row) {
 }
 
 Status KrpcDataStreamSender::Send(RuntimeState* state, RowBatch* batch) {
+  SCOPED_TRACE_EVENT("DataStreamSender::Send");
   SCOPED_TIMER(profile()->total_time_counter());
   DCHECK(!closed_);
   DCHECK(!flushed_);
@@ -992,11 +1239,19 @@ Status KrpcDataStreamSender::Send(RuntimeState* state, RowBatch* batch) {
   if (batch->num_rows() == 0) return Status::OK();
   if (partition_type_ == TPartitionType::UNPARTITIONED) {
     OutboundRowBatch* outbound_batch = &outbound_batches_[next_batch_idx_];
-    RETURN_IF_ERROR(SerializeBatch(batch, outbound_batch, channels_.size()));
+    RETURN_IF_ERROR(
+        SerializeBatch(batch, outbound_batch, &codec_selector_, channels_.size()));
     // TransmitData() will block if there are still in-flight rpcs (and those will
-    // reference the previously written serialized batch).
-    for (int i = 0; i < channels_.size(); ++i) {
-      RETURN_IF_ERROR(channels_[i]->TransmitData(outbound_batch));
+    // reference the previously written serialized batch). If the batch is relayed, the
+    // RPCs to the roots only complete once all other channels' receivers got it.
+    if (relay_roots_.empty()) {
+      for (int i = 0; i < channels_.size(); ++i) {
+        RETURN_IF_ERROR(channels_[i]->TransmitData(outbound_batch));
+      }
+    } else {
+      for (Channel* root : relay_roots_) {
+        RETURN_IF_ERROR(root->TransmitData(outbound_batch));
+      }
     }
     next_batch_idx_ = (next_batch_idx_ + 1) % NUM_OUTBOUND_BATCHES;
   } else if (partition_type_ == TPartitionType::RANDOM || channels_.size() == 1) {
@@ -1041,6 +1296,7 @@ Status KrpcDataStreamSender::Send(RuntimeState* state, RowBatch* batch) {
     } else {
       RETURN_IF_ERROR(HashAndAddRows(batch));
     }
+    if (skew_sketch_ != nullptr) SampleRowHashes(batch);
   }
   COUNTER_ADD(total_sent_rows_counter_, batch->num_rows());
   expr_results_pool_->Clear();
@@ -1054,6 +1310,7 @@ Status KrpcDataStreamSender::FlushFinal(RuntimeState* state) {
   DCHECK(!closed_);
   flushed_ = true;
 
+  if (shared_batch_ != nullptr) RETURN_IF_ERROR(SendSharedBatch());
   // Send out the final row batches and EOS signals on all channels in parallel.
   // If we hit an error here, we can return without closing the remaining channels as
   // the error is propagated back to the coordinator, which in turn cancels the query,
@@ -1064,34 +1321,135 @@ Status KrpcDataStreamSender::FlushFinal(RuntimeState* state) {
   for (unique_ptr<Channel>& channel : channels_) {
     RETURN_IF_ERROR(channel->WaitForRpc());
   }
+  if (skew_sketch_ != nullptr) ReportSkew();
   for (unique_ptr<Channel>& channel : channels_) {
     RETURN_IF_ERROR(channel->SendEosAsync());
   }
   for (unique_ptr<Channel>& channel : channels_) {
     RETURN_IF_ERROR(channel->WaitForRpc());
   }
+  ReportDestinationStats();
   return Status::OK();
 }
 
+KrpcDataStreamSender::DestinationStats* KrpcDataStreamSender::GetDestinationStats(
+    const NetworkAddressPB& address) {
+  unique_ptr<DestinationStats>& stats =
+      destination_stats_[NetworkAddressPBToString(address)];
+  if (stats == nullptr) stats.reset(new DestinationStats(address));
+  return stats.get();
+}
+
+void KrpcDataStreamSender::ReportDestinationStats() {
+  vector<const DestinationStats*> slowest;
+  for (const auto& entry : destination_stats_) {
+    const DestinationStats* stats = entry.second.get();
+    destination_backpressure_stats_->UpdateCounter(stats->backpressure_ns);
+    if (stats->rpc_latency_us.TotalCount() > 0) slowest.push_back(stats);
+  }
+  if (slowest.empty()) return;
+  // Sort by the 99th percentile latency, which the slow backends stand out in.
+  const int num_reported = min<int>(slowest.size(), NUM_REPORTED_DESTINATIONS);
+  std::partial_sort(slowest.begin(), slowest.begin() + num_reported, slowest.end(),
+      [](const DestinationStats* a, const DestinationStats* b) {
+        return a->rpc_latency_us.ValueAtPercentile(99)
+            > b->rpc_latency_us.ValueAtPercentile(99);
+      });
+  stringstream ss;
+  for (int i = 0; i < num_reported; ++i) {
+    const DestinationStats* stats = slowest[i];
+    const HdrHistogram& latency = stats->rpc_latency_us;
+    if (i > 0) ss << "; ";
+    ss << stats->address << ": rpcs=" << latency.TotalCount() << " p50="
+       << PrettyPrinter::Print(latency.ValueAtPercentile(50), TUnit::TIME_US)
+       << " p99=" << PrettyPrinter::Print(latency.ValueAtPercentile(99), TUnit::TIME_US)
+       << " max=" << PrettyPrinter::Print(latency.MaxValue(), TUnit::TIME_US)
+       << " backpressure="
+       << PrettyPrinter::Print(stats->backpressure_ns, TUnit::TIME_NS);
+  }
+  profile()->AddInfoString("SlowestDestinations", ss.str());
+}
+
+void KrpcDataStreamSender::SampleRowHashes(RowBatch* batch) {
+  const int num_rows = batch->num_rows();
+  int row_idx = skew_sample_offset_;
+  for (; row_idx < num_rows; row_idx += skew_sample_interval_) {
+    skew_sketch_->Add(HashRow(batch->GetRow(row_idx)));
+    COUNTER_ADD(skew_sampled_rows_counter_, 1);
+  }
+  skew_sample_offset_ = row_idx - num_rows;
+}
+
+void KrpcDataStreamSender::ReportSkew() {
+  const int64_t total = skew_sketch_->total();
+  if (total == 0) return;
+  vector<SpaceSavingSketch::Entry> top;
+  skew_sketch_->GetTopEntries(SKEW_REPORTED_HEAVY_HITTERS, &top);
+  // Only report keys that are guaranteed to get more rows than an even share.
+  const int num_channels = channels_.size();
+  stringstream ss;
+  for (const SpaceSavingSketch::Entry& entry : top) {
+    const int64_t min_count = entry.count - entry.error;
+    if (min_count * num_channels <= total) continue;
+    if (ss.tellp() > 0) ss << ", ";
+    ss << "hash=" << entry.key << " channel=" << entry.key % num_channels << " share="
+       << PrettyPrinter::Print(static_cast<double>(min_count) / total * 100,
+              TUnit::DOUBLE_VALUE) << "%";
+  }
+  if (ss.tellp() > 0) profile()->AddInfoString("SkewHeavyHitters", ss.str());
+}
+
 void KrpcDataStreamSender::Close(RuntimeState* state) {
   SCOPED_TIMER(profile()->total_time_counter());
   if (closed_) return;
   for (int i = 0; i < channels_.size(); ++i) {
     channels_[i]->Teardown(state);
   }
+  shared_batch_.reset();
+  shared_partition_batch_.reset();
   ScalarExprEvaluator::Close(partition_expr_evals_, state);
   profile()->StopPeriodicCounters();
   DataSink::Close(state);
 }
 
-Status KrpcDataStreamSender::SerializeBatch(
-    RowBatch* src, OutboundRowBatch* dest, int num_receivers) {
+Status KrpcDataStreamSender::SerializeBatch(RowBatch* src, OutboundRowBatch* dest,
+    ExchangeCodecSelector* codec_selector, int num_receivers) {
   VLOG_ROW << "serializing " << src->num_rows() << " rows";
   {
     SCOPED_TIMER(serialize_batch_timer_);
-    RETURN_IF_ERROR(src->Serialize(dest));
+    CompressionTypePB::type codec = CompressionTypePB::NONE;
+    if (codec_selector != nullptr) {
+      codec = adaptive_compression_ ? codec_selector->NextCodec(num_receivers) :
+                                      CompressionTypePB::LZ4;
+    }
+    MonotonicStopWatch serialize_timer;
+    serialize_timer.Start();
+    RETURN_IF_ERROR(src->Serialize(dest, codec, columnar_batches_));
+    int64_t serialize_ns = serialize_timer.ElapsedTime();
     int64_t uncompressed_bytes = RowBatch::GetDeserializedSize(*dest);
     COUNTER_ADD(uncompressed_bytes_counter_, uncompressed_bytes * num_receivers);
+    // The size that the serialized batch would have without compression.
+    int64_t unsaved_bytes =
+        dest->header()->uncompressed_size() + dest->TupleOffsetsAsSlice().size();
+    int64_t serialized_bytes = RowBatch::GetSerializedSize(*dest);
+    COUNTER_ADD(compression_bytes_saved_counter_,
+        (unsaved_bytes - serialized_bytes) * num_receivers);
+    if (adaptive_compression_ && codec_selector != nullptr) {
+      codec_selector->RecordSerialize(
+          codec, unsaved_bytes, serialized_bytes, serialize_ns);
+    }
+    switch (dest->header()->compression_type()) {
+      case CompressionTypePB::LZ4:
+        COUNTER_ADD(lz4_batches_counter_, 1);
+        break;
+      case CompressionTypePB::ZSTD:
+        COUNTER_ADD(zstd_batches_counter_, 1);
+        break;
+      default:
+        COUNTER_ADD(uncompressed_batches_counter_, 1);
+        break;
+    }
+    if (dest->header()->columnar()) COUNTER_ADD(columnar_batches_counter_, 1);
   }
   return Status::OK();
 }
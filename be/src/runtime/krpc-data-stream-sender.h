@@ -19,6 +19,8 @@
 #ifndef IMPALA_RUNTIME_KRPC_DATA_STREAM_SENDER_H
 #define IMPALA_RUNTIME_KRPC_DATA_STREAM_SENDER_H
 
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -28,8 +30,10 @@
 #include "common/object-pool.h"
 #include "common/status.h"
 #include "exprs/scalar-expr.h"
+#include "runtime/exchange-codec-selector.h"
 #include "runtime/row-batch.h"
 #include "util/runtime-profile.h"
+#include "util/space-saving-sketch.h"
 
 namespace impala {
 
@@ -156,12 +160,16 @@ class KrpcDataStreamSender : public DataSink {
 
  private:
   class Channel;
+  struct DestinationStats;
 
   /// Serializes the src batch into the serialized row batch 'dest' and updates
-  /// various stat counters.
-  /// 'num_receivers' is the number of receivers this batch will be sent to. Used for
-  /// updating the stat counters.
-  Status SerializeBatch(RowBatch* src, OutboundRowBatch* dest, int num_receivers = 1);
+  /// various stat counters. If the ADAPTIVE_EXCHANGE_COMPRESSION query option is set,
+  /// the codec is chosen by 'codec_selector', which is updated with the measured cost.
+  /// Otherwise, the batch is LZ4 compressed. If 'codec_selector' is null, the batch is
+  /// not compressed. 'num_receivers' is the number of receivers this batch will be sent
+  /// to. Used for choosing the codec and updating the stat counters.
+  Status SerializeBatch(RowBatch* src, OutboundRowBatch* dest,
+      ExchangeCodecSelector* codec_selector, int num_receivers = 1);
 
   /// Returns 'partition_expr_evals_[i]'. Used by the codegen'd HashRow() IR function.
   ScalarExprEvaluator* GetPartitionExprEvaluator(int i);
@@ -180,9 +188,32 @@ class KrpcDataStreamSender : public DataSink {
   /// insertion into the channel fails. Returns OK status otherwise.
   Status HashAndAddRows(RowBatch* batch);
 
-  /// Adds the given row to 'channels_[channel_id]'.
+  /// Returns the entry of 'destination_stats_' for 'address', creating it if needed.
+  DestinationStats* GetDestinationStats(const NetworkAddressPB& address);
+
+  /// Adds the RPC latency and backpressure of the slowest destinations to the profile.
+  void ReportDestinationStats();
+
+  /// Adds the partition hashes of the sampled rows of 'batch' to 'skew_sketch_'.
+  void SampleRowHashes(RowBatch* batch);
+
+  /// Adds the heavy hitters of 'skew_sketch_' to the profile.
+  void ReportSkew();
+
+  /// Adds the given row to 'channels_[channel_id]', or to 'shared_batch_' if it is
+  /// used.
   Status AddRowToChannel(const int channel_id, TupleRow* row);
 
+  /// Copies the given row into 'shared_batch_' and records it in
+  /// 'shared_batch_rows_[channel_id]'. Sends the rows of 'shared_batch_' first if it is
+  /// full.
+  Status AddRowToSharedBatch(const int channel_id, TupleRow* row);
+
+  /// Serializes and sends the rows of 'shared_batch_' to their channels, one batch per
+  /// channel with rows, and resets it. May block if a channel's preceding RPC is still
+  /// in progress.
+  Status SendSharedBatch();
+
   /// Sender instance id, unique within a fragment.
   const int sender_id_;
 
@@ -208,6 +239,33 @@ class KrpcDataStreamSender : public DataSink {
   static const int NUM_OUTBOUND_BATCHES = 2;
   OutboundRowBatch outbound_batches_[NUM_OUTBOUND_BATCHES];
 
+  /// Chooses the codec for 'outbound_batches_'. Used only when the partitioning strategy
+  /// is UNPARTITIONED; otherwise each channel has its own.
+  ExchangeCodecSelector codec_selector_;
+
+  /// True if the ADAPTIVE_EXCHANGE_COMPRESSION query option is set. Set in Prepare().
+  bool adaptive_compression_ = false;
+
+  /// True if the EXCHANGE_COLUMNAR_BATCHES query option is set. Set in Prepare().
+  bool columnar_batches_ = false;
+
+  /// True if the LOCAL_EXCHANGE_SHORTCUT query option is set. Then channels to receivers
+  /// in this process hand the row batches to them directly. Set in Prepare().
+  bool local_exchange_ = false;
+
+  /// If the SHARED_EXCHANGE_BUFFER query option is set and rows are hash partitioned
+  /// between more than one channel, the rows for all channels are copied into this
+  /// batch instead of one batch per channel, so that the buffered rows take at most
+  /// FLAGS_data_stream_sender_shared_buffer_size bytes regardless of the number of
+  /// channels. 'shared_batch_rows_' holds the indices of each channel's rows in it.
+  /// When the batch is full, each channel's rows are gathered into
+  /// 'shared_partition_batch_', which only references the tuples, and serialized from
+  /// there. The channels then also free the buffers of serialized batches that are no
+  /// longer in flight. Null if not used. Created in Prepare().
+  boost::scoped_ptr<RowBatch> shared_batch_;
+  boost::scoped_ptr<RowBatch> shared_partition_batch_;
+  std::vector<std::vector<int>> shared_batch_rows_;
+
   /// If true, this sender has called FlushFinal() successfully.
   /// Not valid to call Send() anymore.
   bool flushed_ = false;
@@ -215,6 +273,31 @@ class KrpcDataStreamSender : public DataSink {
   /// List of all channels. One for each destination.
   std::vector<std::unique_ptr<Channel>> channels_;
 
+  /// The value of the BROADCAST_RELAY_FANOUT query option. Set in Prepare().
+  int relay_fanout_ = 0;
+
+  /// If the partitioning strategy is UNPARTITIONED and there are more channels than a
+  /// positive 'relay_fanout_', the channels that row batches are sent to. Each of them
+  /// relays the row batches to a group of the other channels' destinations. Populated in
+  /// Prepare(). Empty if all channels are sent to directly.
+  std::vector<Channel*> relay_roots_;
+
+  /// The RPC latency and backpressure of the channels to each backend, by the backend's
+  /// address. Populated by the channels' Init().
+  std::map<std::string, std::unique_ptr<DestinationStats>> destination_stats_;
+
+  /// If the partitioning strategy is HASH_PARTITIONED and the
+  /// EXCHANGE_SKEW_SAMPLE_INTERVAL query option is positive, the partition hashes of
+  /// every 'skew_sample_interval_'-th row, to find the heavy hitters that are reported
+  /// in the profile in FlushFinal(), at most SKEW_REPORTED_HEAVY_HITTERS of them.
+  /// 'skew_sample_offset_' is the index in the next batch of its first sampled row.
+  /// Null if not sampling. Created in Prepare().
+  static const int SKEW_SKETCH_CAPACITY = 64;
+  static const int SKEW_REPORTED_HEAVY_HITTERS = 8;
+  boost::scoped_ptr<SpaceSavingSketch> skew_sketch_;
+  int skew_sample_interval_ = 0;
+  int skew_sample_offset_ = 0;
+
   /// Expressions of partition keys. It's used to compute the
   /// per-row partition values for shuffling exchange;
   const std::vector<ScalarExpr*>& partition_exprs_;
@@ -229,7 +312,8 @@ class KrpcDataStreamSender : public DataSink {
   /// Total number of times RPC fails or the remote responds with a non-retryable error.
   RuntimeProfile::Counter* rpc_failure_counter_ = nullptr;
 
-  /// Total number of bytes sent. Updated on RPC completion.
+  /// Total number of bytes sent. Updated on RPC completion and when a batch is handed
+  /// to a receiver in this process.
   RuntimeProfile::Counter* bytes_sent_counter_ = nullptr;
 
   /// Time series of number of bytes sent, samples bytes_sent_counter_.
@@ -238,9 +322,35 @@ class KrpcDataStreamSender : public DataSink {
   /// Total number of EOS sent.
   RuntimeProfile::Counter* eos_sent_counter_ = nullptr;
 
+  /// Number of row batches handed to receivers in this process without an RPC, and the
+  /// time spent doing so, including the time waiting for the receivers to have room.
+  RuntimeProfile::Counter* local_batches_sent_counter_ = nullptr;
+  RuntimeProfile::Counter* local_transmit_timer_ = nullptr;
+
   /// Total number of bytes of row batches before compression.
   RuntimeProfile::Counter* uncompressed_bytes_counter_ = nullptr;
 
+  /// Total number of bytes that compression removed from the row batches, i.e. the
+  /// uncompressed minus the serialized size. The time spent on it is part of
+  /// 'serialize_batch_timer_'.
+  RuntimeProfile::Counter* compression_bytes_saved_counter_ = nullptr;
+
+  /// Number of row batches serialized without compression, with LZ4 and with ZSTD.
+  RuntimeProfile::Counter* uncompressed_batches_counter_ = nullptr;
+  RuntimeProfile::Counter* lz4_batches_counter_ = nullptr;
+  RuntimeProfile::Counter* zstd_batches_counter_ = nullptr;
+
+  /// Number of row batches serialized in the columnar layout. Only created if
+  /// 'columnar_batches_' is true.
+  RuntimeProfile::Counter* columnar_batches_counter_ = nullptr;
+
+  /// Summary stats of the time that the channels to each backend waited for their
+  /// previous RPC to complete. Updated in FlushFinal().
+  RuntimeProfile::SummaryStatsCounter* destination_backpressure_stats_ = nullptr;
+
+  /// Number of rows whose partition hashes were added to 'skew_sketch_'.
+  RuntimeProfile::Counter* skew_sampled_rows_counter_ = nullptr;
+
   /// Total number of rows sent.
   RuntimeProfile::Counter* total_sent_rows_counter_ = nullptr;
 
@@ -17,29 +17,53 @@
 
 #include "runtime/lib-cache.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iterator>
 #include <mutex>
 
 #include <boost/filesystem.hpp>
+#include <gflags/gflags.h>
 
 #include "codegen/llvm-codegen.h"
+#include "gutil/strings/substitute.h"
 #include "runtime/hdfs-fs-cache.h"
 #include "runtime/runtime-state.h"
 #include "util/dynamic-util.h"
+#include "util/error-util.h"
+#include "util/filesystem-util.h"
 #include "util/hash-util.h"
 #include "util/hdfs-util.h"
 #include "util/path-builder.h"
+#include "util/string-parser.h"
 #include "util/test-info.h"
+#include "util/thread.h"
 
 #include "common/names.h"
 
 namespace filesystem = boost::filesystem;
 
+DEFINE_bool(lib_cache_persistent, false, "If true, the local copies of UDF libraries "
+    "are kept in the impala-lib-cache sub-directory of --local_library_dir when the "
+    "process exits, and later processes use them instead of copying the libraries "
+    "again as long as the libraries in the file system have the same modification "
+    "time.");
+DEFINE_int32(lib_cache_prefetch_max_libs, 100, "If --lib_cache_persistent is true, the "
+    "maximum number of libraries that are loaded in the background at startup, chosen "
+    "by how often previous processes used them. 0 disables the prefetch.");
+
 DECLARE_string(local_library_dir);
 
 namespace impala {
 
 scoped_ptr<LibCache> LibCache::instance_;
 
+/// Name of the sub-directory of --local_library_dir with the persisted local copies.
+static const string PERSISTENT_DIR_NAME = "impala-lib-cache";
+/// Name of the usage index in the persistent directory. Every line has the type, the
+/// number of uses and the HDFS path of a library, separated by tabs.
+static const string USAGE_INDEX_FILE_NAME = "usage-index";
+
 struct LibCacheEntry {
   // Lock protecting all fields in this entry
   std::mutex lock;
@@ -62,6 +86,9 @@ struct LibCacheEntry {
   // The path on the local file system for this library.
   std::string local_path;
 
+  // If true, 'local_path' is a persisted copy that is kept when the entry is deleted.
+  bool persistent;
+
   // Status returned from copying this file from HDFS.
   Status copy_file_status;
 
@@ -82,6 +109,10 @@ struct LibCacheEntry {
   // not trivial to walk an .so for the symbol table.
   boost::unordered_set<std::string> symbols;
 
+  // The bitcode of the module. Populated once on load and read only. Only used if it is
+  // a llvm module.
+  std::string ir_bitcode;
+
   // Set if an error occurs loading the cache entry before the cache entry
   // can be evicted. This allows other threads that attempt to use the entry
   // before it is removed to return the same error.
@@ -91,6 +122,7 @@ struct LibCacheEntry {
     : use_count(0),
       should_remove(false),
       check_needs_refresh(false),
+      persistent(false),
       shared_object_handle(nullptr) {}
   ~LibCacheEntry();
 };
@@ -98,6 +130,9 @@ struct LibCacheEntry {
 LibCache::LibCache() : current_process_handle_(nullptr) {}
 
 LibCache::~LibCache() {
+  stop_prefetch_.Store(true);
+  if (prefetch_thread_ != nullptr) prefetch_thread_->Join();
+  if (!persistent_dir_.empty()) WriteUsageIndex();
   DropCache();
   if (current_process_handle_ != nullptr) DynamicClose(current_process_handle_);
 }
@@ -123,16 +158,117 @@ Status LibCache::InitInternal(bool external_fe) {
   }
   DCHECK(current_process_handle_ != nullptr)
       << "We should always be able to get current process handle.";
+
+  if (FLAGS_lib_cache_persistent) {
+    persistent_dir_ = Substitute("$0/$1", FLAGS_local_library_dir, PERSISTENT_DIR_NAME);
+    boost::system::error_code ec;
+    filesystem::create_directories(persistent_dir_, ec);
+    if (ec) {
+      return Status(Substitute(
+          "Could not create directory $0: $1", persistent_dir_, ec.message()));
+    }
+    ReadUsageIndex();
+    LOG(INFO) << "Library cache persists local copies in " << persistent_dir_;
+  }
   return Status::OK();
 }
 
+Status LibCache::StartPrefetch() {
+  if (persistent_dir_.empty() || FLAGS_lib_cache_prefetch_max_libs <= 0) {
+    return Status::OK();
+  }
+  {
+    lock_guard<mutex> l(usage_lock_);
+    if (lib_usage_.empty()) return Status::OK();
+  }
+  return Thread::Create(
+      "lib-cache", "lib-cache-prefetch", [this]() { PrefetchLibs(); }, &prefetch_thread_);
+}
+
+void LibCache::PrefetchLibs() {
+  vector<pair<string, LibUsage>> libs;
+  {
+    lock_guard<mutex> l(usage_lock_);
+    libs.assign(lib_usage_.begin(), lib_usage_.end());
+  }
+  sort(libs.begin(), libs.end(),
+      [](const pair<string, LibUsage>& a, const pair<string, LibUsage>& b) {
+        return a.second.num_uses > b.second.num_uses;
+      });
+  const size_t max_libs = FLAGS_lib_cache_prefetch_max_libs;
+  if (libs.size() > max_libs) libs.resize(max_libs);
+  int num_loaded = 0;
+  for (const pair<string, LibUsage>& lib : libs) {
+    if (stop_prefetch_.Load()) break;
+    unique_lock<mutex> entry_lock;
+    LibCacheEntry* entry = nullptr;
+    Status status =
+        GetCacheEntry(lib.first, lib.second.type, -1, &entry_lock, &entry, false);
+    if (!status.ok()) {
+      LOG(INFO) << "Could not prefetch library " << lib.first << ": "
+                << status.GetDetail();
+      continue;
+    }
+    ++num_loaded;
+  }
+  LOG(INFO) << "Prefetched " << num_loaded << " of " << libs.size() << " libraries";
+}
+
+void LibCache::ReadUsageIndex() {
+  const string path = Substitute("$0/$1", persistent_dir_, USAGE_INDEX_FILE_NAME);
+  ifstream index(path, ios::in);
+  string line;
+  lock_guard<mutex> l(usage_lock_);
+  while (getline(index, line)) {
+    size_t type_end = line.find('\t');
+    size_t uses_end =
+        type_end == string::npos ? string::npos : line.find('\t', type_end + 1);
+    if (uses_end == string::npos || uses_end + 1 == line.size()) continue;
+    StringParser::ParseResult type_result, uses_result;
+    int type = StringParser::StringToInt<int>(line.c_str(), type_end, &type_result);
+    int64_t num_uses = StringParser::StringToInt<int64_t>(
+        line.c_str() + type_end + 1, uses_end - type_end - 1, &uses_result);
+    if (type_result != StringParser::PARSE_SUCCESS
+        || uses_result != StringParser::PARSE_SUCCESS || type < TYPE_SO
+        || type > TYPE_JAR) {
+      LOG(WARNING) << "Ignoring invalid line in " << path << ": " << line;
+      continue;
+    }
+    lib_usage_[line.substr(uses_end + 1)] = {static_cast<LibType>(type), num_uses};
+  }
+}
+
+void LibCache::WriteUsageIndex() {
+  vector<pair<string, LibUsage>> libs;
+  {
+    lock_guard<mutex> l(usage_lock_);
+    libs.assign(lib_usage_.begin(), lib_usage_.end());
+  }
+  const string path = Substitute("$0/$1", persistent_dir_, USAGE_INDEX_FILE_NAME);
+  // Write a temporary file and rename it, so that processes that share the directory
+  // never read a partial index.
+  const string tmp_path = Substitute("$0.$1.tmp", path, getpid());
+  lock_guard<mutex> l(usage_index_lock_);
+  ofstream index(tmp_path, ios::out | ios::trunc);
+  for (const pair<string, LibUsage>& lib : libs) {
+    index << lib.second.type << '\t' << lib.second.num_uses << '\t' << lib.first
+          << '\n';
+  }
+  index.close();
+  if (index.fail() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Could not write library usage index " << path << ": "
+                 << GetStrErrMsg();
+    unlink(tmp_path.c_str());
+  }
+}
+
 LibCacheEntry::~LibCacheEntry() {
   if (shared_object_handle != nullptr) {
     DCHECK_EQ(use_count, 0);
     DCHECK(should_remove);
     DynamicClose(shared_object_handle);
   }
-  unlink(local_path.c_str());
+  if (!persistent) unlink(local_path.c_str());
 }
 
 LibCacheEntryHandle::~LibCacheEntryHandle() {
@@ -202,6 +338,15 @@ Status LibCache::GetLocalPath(const std::string& hdfs_lib_file, LibType type,
   return Status::OK();
 }
 
+Status LibCache::GetIrBitcode(const string& hdfs_lib_file, time_t exp_mtime,
+    LibCacheEntryHandle* handle, string* path, const string** bitcode) {
+  RETURN_IF_ERROR(GetLocalPath(hdfs_lib_file, TYPE_IR, exp_mtime, handle, path));
+  // The bitcode is not modified after the entry is loaded, so it can be read without
+  // holding the entry lock.
+  *bitcode = &handle->entry()->ir_bitcode;
+  return Status::OK();
+}
+
 Status LibCache::CheckSymbolExists(const string& hdfs_lib_file, LibType type,
     const string& symbol, bool quiet, time_t* mtime) {
   if (type == TYPE_SO) {
@@ -255,6 +400,11 @@ void LibCache::SetNeedsRefresh(const string& hdfs_lib_file) {
 }
 
 void LibCache::RemoveEntry(const string& hdfs_lib_file) {
+  if (!persistent_dir_.empty()) {
+    // Do not prefetch libraries that were dropped or could not be loaded.
+    lock_guard<mutex> l(usage_lock_);
+    lib_usage_.erase(hdfs_lib_file);
+  }
   unique_lock<mutex> lib_cache_lock(lock_);
   LibMap::iterator it = lib_cache_.find(hdfs_lib_file);
   if (it == lib_cache_.end()) return;
@@ -302,7 +452,14 @@ void LibCache::DropCache() {
 }
 
 Status LibCache::GetCacheEntry(const string& hdfs_lib_file, LibType type,
-    time_t exp_mtime, unique_lock<mutex>* entry_lock, LibCacheEntry** entry) {
+    time_t exp_mtime, unique_lock<mutex>* entry_lock, LibCacheEntry** entry,
+    bool record_use) {
+  if (record_use && !persistent_dir_.empty()) {
+    lock_guard<mutex> l(usage_lock_);
+    LibUsage& usage = lib_usage_[hdfs_lib_file];
+    usage.type = type;
+    ++usage.num_uses;
+  }
   Status status;
   {
     // If an error occurs, local_entry_lock is released before calling RemoveEntry()
@@ -349,6 +506,9 @@ Status LibCache::GetCacheEntryInternal(const string& hdfs_lib_file, LibType type
   // other threads avoids blocking other threads with an expensive operation.
   unique_ptr<LibCacheEntry> new_entry = make_unique<LibCacheEntry>();
   RETURN_IF_ERROR(LoadCacheEntry(hdfs_lib_file, exp_mtime, type, new_entry.get()));
+  // Persist the usage when a library is added, so that the next process can prefetch
+  // it even if this one does not exit cleanly.
+  if (!persistent_dir_.empty()) WriteUsageIndex();
 
   // Entry is now loaded. Check that another thread did not already load and add an entry
   // for the same key. If so, refresh it if needed. If the existing entry is valid, then
@@ -438,16 +598,69 @@ Status LibCache::RefreshCacheEntry(const string& hdfs_lib_file, LibType type,
   return Status::OK();
 }
 
+/// Copies 'hdfs_lib_file' to the persisted copy at 'local_path', unless it exists
+/// already. The library is copied to 'tmp_path' first and then renamed, so that other
+/// processes that share the directory never use a partial copy. Removes the persisted
+/// copies of other versions of the library, whose paths start with 'prefix'.
+static Status CopyToPersistentDir(const hdfsFS& hdfs_conn, const string& hdfs_lib_file,
+    const hdfsFS& local_conn, const string& local_path, const string& tmp_path,
+    const string& prefix) {
+  bool exists;
+  RETURN_IF_ERROR(FileSystemUtil::PathExists(local_path, &exists));
+  if (exists) {
+    VLOG(1) << "Using persisted copy " << local_path << " of " << hdfs_lib_file;
+    return Status::OK();
+  }
+  VLOG(1) << "Adding lib cache entry: " << hdfs_lib_file
+          << ", local path: " << local_path;
+  RETURN_IF_ERROR(CopyHdfsFile(hdfs_conn, hdfs_lib_file, local_conn, tmp_path));
+  if (rename(tmp_path.c_str(), local_path.c_str()) != 0) {
+    string error_msg = GetStrErrMsg();
+    unlink(tmp_path.c_str());
+    return Status(
+        Substitute("Could not rename $0 to $1: $2", tmp_path, local_path, error_msg));
+  }
+
+  filesystem::path prefix_path(prefix);
+  const string dir = prefix_path.parent_path().string();
+  const string name_prefix = prefix_path.filename().string();
+  const string name = filesystem::path(local_path).filename().string();
+  vector<string> names;
+  Status status = FileSystemUtil::Directory::GetEntryNames(
+      dir, &names, 0, FileSystemUtil::Directory::DIR_ENTRY_REG);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not list " << dir << ": " << status.GetDetail();
+    return Status::OK();
+  }
+  for (const string& other_name : names) {
+    // Temporary files belong to copies that are in progress.
+    if (other_name == name || other_name.compare(0, name_prefix.size(), name_prefix) != 0
+        || filesystem::path(other_name).extension() == ".tmp") {
+      continue;
+    }
+    const string other_path = Substitute("$0/$1", dir, other_name);
+    VLOG(1) << "Removing persisted copy of other version " << other_path;
+    unlink(other_path.c_str());
+  }
+  return Status::OK();
+}
+
+/// Reads the contents of the local file at 'path' into 'contents'.
+static Status ReadLocalFile(const string& path, string* contents) {
+  ifstream file(path, ios::in | ios::binary);
+  if (!file.is_open()) {
+    return Status(Substitute("Could not open $0: $1", path, GetStrErrMsg()));
+  }
+  contents->assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  if (file.bad()) return Status(Substitute("Error reading $0: $1", path, GetStrErrMsg()));
+  return Status::OK();
+}
+
 Status LibCache::LoadCacheEntry(const std::string& hdfs_lib_file, time_t exp_mtime,
     LibType type, LibCacheEntry* entry) {
   DCHECK(entry != nullptr);
   entry->type = type;
 
-  // Copy the file
-  entry->local_path = MakeLocalPath(hdfs_lib_file, FLAGS_local_library_dir);
-  VLOG(1) << "Adding lib cache entry: " << hdfs_lib_file
-          << ", local path: " << entry->local_path;
-
   hdfsFS hdfs_conn, local_conn;
   RETURN_IF_ERROR(HdfsFsCache::instance()->GetConnection(hdfs_lib_file, &hdfs_conn));
   RETURN_IF_ERROR(HdfsFsCache::instance()->GetLocalConnection(&local_conn));
@@ -465,23 +678,41 @@ Status LibCache::LoadCacheEntry(const std::string& hdfs_lib_file, time_t exp_mti
         TErrorCode::LIB_VERSION_MISMATCH, hdfs_lib_file, entry->last_mod_time, exp_mtime);
   }
 
-  entry->copy_file_status =
-      CopyHdfsFile(hdfs_conn, hdfs_lib_file, local_conn, entry->local_path);
+  // Copy the file
+  if (persistent_dir_.empty()) {
+    entry->local_path = MakeLocalPath(hdfs_lib_file, FLAGS_local_library_dir);
+    VLOG(1) << "Adding lib cache entry: " << hdfs_lib_file
+            << ", local path: " << entry->local_path;
+    entry->copy_file_status =
+        CopyHdfsFile(hdfs_conn, hdfs_lib_file, local_conn, entry->local_path);
+  } else {
+    entry->local_path = MakePersistentLocalPath(hdfs_lib_file, entry->last_mod_time);
+    entry->persistent = true;
+    entry->copy_file_status = CopyToPersistentDir(hdfs_conn, hdfs_lib_file, local_conn,
+        entry->local_path,
+        Substitute("$0.$1.$2.tmp", entry->local_path, getpid(), num_libs_copied_.Add(1)),
+        PersistentLocalPathPrefix(hdfs_lib_file));
+  }
   RETURN_IF_ERROR(entry->copy_file_status);
 
+  Status status;
   if (type == TYPE_SO) {
     // dlopen the local library
-    RETURN_IF_ERROR(DynamicOpen(entry->local_path.c_str(), &entry->shared_object_handle));
+    status = DynamicOpen(entry->local_path.c_str(), &entry->shared_object_handle);
   } else if (type == TYPE_IR) {
-    // Load the module temporarily and populate all symbols.
+    // Keep the bitcode and load the module temporarily to populate all symbols.
     const string file = entry->local_path;
     const string module_id = filesystem::path(file).stem().string();
-    RETURN_IF_ERROR(LlvmCodeGen::GetSymbols(file, module_id, &entry->symbols));
+    status = ReadLocalFile(file, &entry->ir_bitcode);
+    if (status.ok()) status = LlvmCodeGen::GetSymbols(file, module_id, &entry->symbols);
   } else {
     DCHECK_EQ(type, TYPE_JAR);
     // Nothing to do.
   }
-  return Status::OK();
+  // A persisted copy that cannot be loaded is removed with the entry, so that the next
+  // attempt copies the library again.
+  if (!status.ok()) entry->persistent = false;
+  return status;
 }
 
 string LibCache::MakeLocalPath(const string& hdfs_path, const string& local_dir) {
@@ -493,4 +724,18 @@ string LibCache::MakeLocalPath(const string& hdfs_path, const string& local_dir)
   return dst.str();
 }
 
+string LibCache::PersistentLocalPathPrefix(const string& hdfs_path) {
+  // The hash of the full path distinguishes libraries with the same file name.
+  filesystem::path src(hdfs_path);
+  uint64_t hash = HashUtil::MurmurHash2_64(
+      hdfs_path.data(), hdfs_path.size(), HashUtil::MURMUR_DEFAULT_SEED);
+  return Substitute("$0/$1.$2.", persistent_dir_, src.stem().native(), hash);
+}
+
+string LibCache::MakePersistentLocalPath(const string& hdfs_path, time_t mtime) {
+  filesystem::path src(hdfs_path);
+  return Substitute("$0$1$2", PersistentLocalPathPrefix(hdfs_path), mtime,
+      src.extension().native());
+}
+
 }
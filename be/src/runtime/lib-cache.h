@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <boost/scoped_ptr.hpp>
@@ -29,6 +31,7 @@
 namespace impala {
 
 class RuntimeState;
+class Thread;
 
 /// Process-wide cache of dynamically-linked libraries loaded from HDFS.
 /// These libraries can either be shared objects, llvm modules or jars. For
@@ -51,6 +54,17 @@ class RuntimeState;
 /// api for accessing a path, GetLocalPath(), that uses the handle's scope to manage the
 /// reference count.
 //
+/// Persistence: If --lib_cache_persistent is true, the local copies are stored in a
+/// sub-directory of --local_library_dir under a name that is derived from the HDFS path
+/// and the last modification time of the library. They are kept when the process exits
+/// and the next process uses an existing copy instead of copying the library again if
+/// the library in HDFS still has the same modification time. The number of uses of
+/// every library is recorded in an index file in the same directory, and
+/// StartPrefetch() loads the libraries that were used most often in the background.
+//
+/// The bitcode of IR modules is kept in memory, so that linking a module into the
+/// codegen module of a fragment does not read the local file again.
+//
 /// TODO:
 /// - refresh libraries
 /// - better cached module management
@@ -74,6 +88,12 @@ class LibCache {
   /// Initializes the libcache. Must be called before any other APIs.
   static Status Init(bool external_fe);
 
+  /// Starts a thread that loads the libraries that were used most often according to
+  /// the index of persisted libraries, up to --lib_cache_prefetch_max_libs of them.
+  /// No-op if --lib_cache_persistent is false. Must be called after the file systems
+  /// can be accessed.
+  Status StartPrefetch();
+
   /// Gets the local 'path' used to cache the file stored at the global 'hdfs_lib_file'. If
   /// this file is not already on the local fs, or if the cached entry's last modified
   /// is older than expected mtime, 'exp_mtime', it copies it and caches the result.
@@ -88,6 +108,11 @@ class LibCache {
   Status GetLocalPath(const std::string& hdfs_lib_file, LibType type, time_t exp_mtime,
       LibCacheEntryHandle* handle, string* path);
 
+  /// Same as GetLocalPath() for an IR module, but also returns the bitcode of the module
+  /// in 'bitcode'. '*bitcode' is valid while 'handle' is in scope.
+  Status GetIrBitcode(const std::string& hdfs_lib_file, time_t exp_mtime,
+      LibCacheEntryHandle* handle, string* path, const std::string** bitcode);
+
   /// Returns status.ok() if the symbol exists in 'hdfs_lib_file', non-ok otherwise.
   /// If status.ok() is true, 'mtime' is set to the cache entry's last modified time.
   /// If an mtime is not applicable, for example, if lookup is for a builtin, then
@@ -152,6 +177,30 @@ class LibCache {
   typedef boost::unordered_map<std::string, LibCacheEntry*> LibMap;
   LibMap lib_cache_;
 
+  /// Type and number of uses of a library, including the uses by previous processes.
+  struct LibUsage {
+    LibType type;
+    int64_t num_uses;
+  };
+
+  /// Protects lib_usage_. No other lock may be taken while holding it.
+  std::mutex usage_lock_;
+
+  /// Maps HDFS library path => usage, for all libraries that were used by this or a
+  /// previous process. Only maintained if --lib_cache_persistent is true.
+  std::map<std::string, LibUsage> lib_usage_;
+
+  /// Directory of the persisted local copies and the usage index. Empty if
+  /// --lib_cache_persistent is false.
+  std::string persistent_dir_;
+
+  /// Serializes writing the usage index file.
+  std::mutex usage_index_lock_;
+
+  /// Thread started by StartPrefetch(). Set to stop it in the d'tor.
+  std::unique_ptr<Thread> prefetch_thread_;
+  AtomicBool stop_prefetch_;
+
   LibCache();
   LibCache(LibCache const& l); // disable copy ctor
   LibCache& operator=(LibCache const& l); // disable assignment
@@ -167,8 +216,10 @@ class LibCache {
   /// No locks should be taken before calling this. On return the entry's lock is
   /// taken and returned in *entry_lock.
   /// If an error is returned, there will be no entry in lib_cache_ and *entry is NULL.
+  /// If 'record_use' is true, the use of the library is counted in 'lib_usage_'.
   Status GetCacheEntry(const std::string& hdfs_lib_file, LibType type, time_t exp_mtime,
-      std::unique_lock<std::mutex>* entry_lock, LibCacheEntry** entry);
+      std::unique_lock<std::mutex>* entry_lock, LibCacheEntry** entry,
+      bool record_use = true);
 
   /// Implementation to get the cache entry for 'hdfs_lib_file'. Errors are returned
   /// without evicting the cache entry if the status is not OK and *entry is not NULL.
@@ -205,6 +256,22 @@ class LibCache {
   /// 'local_dir' is the local directory prefix of the returned path.
   std::string MakeLocalPath(const std::string& hdfs_path, const std::string& local_dir);
 
+  /// Returns the path of the persisted local copy of version 'mtime' of 'hdfs_path' in
+  /// 'persistent_dir_'. The file name starts with the prefix returned by
+  /// PersistentLocalPathPrefix(), which is the same for all versions.
+  std::string MakePersistentLocalPath(const std::string& hdfs_path, time_t mtime);
+  std::string PersistentLocalPathPrefix(const std::string& hdfs_path);
+
+  /// Reads the usage index in 'persistent_dir_' into 'lib_usage_'. A missing or invalid
+  /// index is ignored.
+  void ReadUsageIndex();
+
+  /// Writes 'lib_usage_' to the usage index in 'persistent_dir_'.
+  void WriteUsageIndex();
+
+  /// Loads the most used libraries in 'lib_usage_'. Run by 'prefetch_thread_'.
+  void PrefetchLibs();
+
   /// Implementation to remove an entry from the cache.
   /// lock_ must be held. The entry's lock should not be held.
   void RemoveEntryInternal(
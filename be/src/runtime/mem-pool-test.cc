@@ -27,6 +27,8 @@
 // Maximum allocation size which exceeds 32-bit.
 #define LARGE_ALLOC_SIZE (1LL << 32)
 
+DECLARE_int64(mem_pool_chunk_cache_bytes);
+
 namespace impala {
 
 // Utility class to call private functions on MemPool.
@@ -455,6 +457,52 @@ TEST(MemPoolTest, ReturnAllocationThenTransfer) {
   dst.FreeAll();
 }
 
+/// Test that a buffer acquired by a pool is tracked, used before the free chunks and
+/// transferred and freed like the pool's own allocations.
+TEST(MemPoolTest, AcquireBuffer) {
+  MemTracker tracker;
+  MemPool src(&tracker);
+  MemPool dst(&tracker);
+
+  uint8_t* mem = src.Allocate(100);
+  ASSERT_TRUE(mem != NULL);
+  const int64_t buffer_size = 64 * 1024;
+  uint8_t* buffer = reinterpret_cast<uint8_t*>(malloc(buffer_size));
+  ASSERT_TRUE(buffer != NULL);
+  tracker.Consume(buffer_size);
+  src.AcquireBuffer(buffer, buffer_size);
+  ASSERT_TRUE(MemPoolTest::CheckIntegrity(&src, false));
+  EXPECT_EQ(100 + buffer_size, src.total_allocated_bytes());
+
+  // The next allocation does not fit in the acquired buffer.
+  mem = src.Allocate(100);
+  ASSERT_TRUE(mem != NULL);
+  EXPECT_TRUE(mem < buffer || mem >= buffer + buffer_size);
+  ASSERT_TRUE(MemPoolTest::CheckIntegrity(&src, false));
+
+  // Acquiring a buffer into an empty pool and then after returning all allocations.
+  uint8_t* buffer2 = reinterpret_cast<uint8_t*>(malloc(buffer_size));
+  ASSERT_TRUE(buffer2 != NULL);
+  tracker.Consume(buffer_size);
+  dst.AcquireBuffer(buffer2, buffer_size);
+  ASSERT_TRUE(MemPoolTest::CheckIntegrity(&dst, false));
+  mem = dst.Allocate(100);
+  dst.ReturnPartialAllocation(100);
+  uint8_t* buffer3 = reinterpret_cast<uint8_t*>(malloc(buffer_size));
+  ASSERT_TRUE(buffer3 != NULL);
+  tracker.Consume(buffer_size);
+  dst.AcquireBuffer(buffer3, buffer_size);
+  ASSERT_TRUE(MemPoolTest::CheckIntegrity(&dst, false));
+
+  dst.AcquireData(&src, false);
+  ASSERT_TRUE(MemPoolTest::CheckIntegrity(&dst, false));
+  EXPECT_EQ(200 + 3 * buffer_size, dst.total_allocated_bytes());
+  EXPECT_EQ(0, src.total_allocated_bytes());
+  dst.FreeAll();
+  src.FreeAll();
+  EXPECT_EQ(0, tracker.consumption());
+}
+
 /// Test that making a large allocation that doesn't fit in the current chunk after
 /// returning a full allocation works correctly.
 TEST(MemPoolTest, ReturnAllocationThenLargeAllocation) {
@@ -519,5 +567,48 @@ TEST(MemPoolTest, TryAllocateAligned) {
 
   pool.FreeAll();
 }
+
+#ifndef ADDRESS_SANITIZER
+// Chunks freed by one pool are reused by the next pool on the same thread and are not
+// counted against a MemTracker while they are cached.
+TEST(MemPoolTest, ChunkCache) {
+  google::FlagSaver saver;
+  // Earlier tests may have filled the cache of this thread, so make room for more.
+  FLAGS_mem_pool_chunk_cache_bytes = 1L << 30;
+  MemTracker tracker(-1);
+  MemPool p1(&tracker);
+  ASSERT_TRUE(p1.Allocate(100) != nullptr);
+  p1.FreeAll();
+  EXPECT_EQ(0, tracker.consumption());
+  int64_t hits = MemPool::chunk_cache_hits();
+  int64_t retained_bytes = MemPool::chunk_cache_retained_bytes();
+  EXPECT_GE(retained_bytes, MemPoolTest::INITIAL_CHUNK_SIZE);
+
+  MemPool p2(&tracker);
+  ASSERT_TRUE(p2.Allocate(100) != nullptr);
+  EXPECT_EQ(hits + 1, MemPool::chunk_cache_hits());
+  EXPECT_EQ(retained_bytes - MemPoolTest::INITIAL_CHUNK_SIZE,
+      MemPool::chunk_cache_retained_bytes());
+  EXPECT_EQ(MemPoolTest::INITIAL_CHUNK_SIZE, tracker.consumption());
+  p2.FreeAll();
+  EXPECT_EQ(retained_bytes, MemPool::chunk_cache_retained_bytes());
+  EXPECT_EQ(0, tracker.consumption());
+
+  // Chunks that are larger than the largest cached size are not cached.
+  MemPool p3(&tracker);
+  ASSERT_TRUE(p3.Allocate(MemPoolTest::MAX_CHUNK_SIZE + 1) != nullptr);
+  p3.FreeAll();
+  EXPECT_EQ(retained_bytes, MemPool::chunk_cache_retained_bytes());
+
+  // Without a cache, chunks are allocated and freed each time.
+  FLAGS_mem_pool_chunk_cache_bytes = 0;
+  MemPool p4(&tracker);
+  ASSERT_TRUE(p4.Allocate(100) != nullptr);
+  p4.FreeAll();
+  EXPECT_EQ(hits + 1, MemPool::chunk_cache_hits());
+  EXPECT_EQ(retained_bytes, MemPool::chunk_cache_retained_bytes());
+  EXPECT_EQ(0, tracker.consumption());
+}
+#endif
 }
 
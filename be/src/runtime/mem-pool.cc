@@ -23,12 +23,104 @@
 #include <stdio.h>
 #include <sstream>
 
+#include <gflags/gflags.h>
+
+#include "common/atomic.h"
+
 #include "common/names.h"
 
 using namespace impala;
 
+DEFINE_int64(mem_pool_chunk_cache_bytes, 1024 * 1024, "(Advanced) Maximum bytes of "
+    "free MemPool chunks that each thread keeps for reuse by later MemPools instead of "
+    "freeing them. The cached chunks are not counted against any MemTracker. Setting "
+    "this to 0 disables the cache.");
+
 #define MEM_POOL_POISON (0x66aa77bb)
 
+namespace {
+AtomicInt64 num_chunk_cache_hits;
+AtomicInt64 num_chunk_cache_misses;
+AtomicInt64 num_chunk_cache_retained_bytes;
+}
+
+/// Per-thread lists of free chunks, one for each power-of-two chunk size between
+/// INITIAL_CHUNK_SIZE and MAX_CHUNK_SIZE, which are the sizes MemPool allocates unless
+/// an allocation needs a larger chunk. The lists are linked through the first bytes of
+/// the free chunks. At most FLAGS_mem_pool_chunk_cache_bytes are kept, chunks beyond
+/// that are freed. Not used with ASAN, so that it can still detect accesses to freed
+/// chunks.
+class MemPool::ChunkCache {
+ public:
+  ~ChunkCache() {
+    for (uint8_t*& head : free_chunks_) {
+      while (head != nullptr) {
+        uint8_t* next = *reinterpret_cast<uint8_t**>(head);
+        free(head);
+        head = next;
+      }
+    }
+    num_chunk_cache_retained_bytes.Add(-retained_bytes_);
+  }
+
+  /// Returns a free chunk of 'size' bytes or nullptr if there is none.
+  uint8_t* Take(int64_t size) {
+    int idx = SizeClassIndex(size);
+    if (idx < 0) return nullptr;
+    uint8_t* chunk = free_chunks_[idx];
+    if (chunk == nullptr) {
+      num_chunk_cache_misses.Add(1);
+      return nullptr;
+    }
+    free_chunks_[idx] = *reinterpret_cast<uint8_t**>(chunk);
+    retained_bytes_ -= size;
+    num_chunk_cache_retained_bytes.Add(-size);
+    num_chunk_cache_hits.Add(1);
+    return chunk;
+  }
+
+  /// Adds 'chunk' of 'size' bytes to the cache. Returns false if it does not fit, in
+  /// which case the caller must free it.
+  bool Put(uint8_t* chunk, int64_t size) {
+    int idx = SizeClassIndex(size);
+    if (idx < 0 || retained_bytes_ + size > FLAGS_mem_pool_chunk_cache_bytes) {
+      return false;
+    }
+    *reinterpret_cast<uint8_t**>(chunk) = free_chunks_[idx];
+    free_chunks_[idx] = chunk;
+    retained_bytes_ += size;
+    num_chunk_cache_retained_bytes.Add(size);
+    return true;
+  }
+
+ private:
+  static const int LOG_INITIAL_CHUNK_SIZE = 12;
+  static const int NUM_SIZE_CLASSES = 8;
+  static_assert(INITIAL_CHUNK_SIZE == 1 << LOG_INITIAL_CHUNK_SIZE,
+      "LOG_INITIAL_CHUNK_SIZE must match INITIAL_CHUNK_SIZE");
+  static_assert(MAX_CHUNK_SIZE == INITIAL_CHUNK_SIZE << (NUM_SIZE_CLASSES - 1),
+      "NUM_SIZE_CLASSES must cover INITIAL_CHUNK_SIZE to MAX_CHUNK_SIZE");
+
+  /// Returns the index of the list for chunks of 'size' bytes or -1 if chunks of that
+  /// size are not cached.
+  static int SizeClassIndex(int64_t size) {
+#ifdef ADDRESS_SANITIZER
+    return -1;
+#else
+    if (FLAGS_mem_pool_chunk_cache_bytes <= 0 || size < INITIAL_CHUNK_SIZE
+        || size > MAX_CHUNK_SIZE || !BitUtil::IsPowerOf2(size)) {
+      return -1;
+    }
+    return BitUtil::Log2Floor64(size) - LOG_INITIAL_CHUNK_SIZE;
+#endif
+  }
+
+  uint8_t* free_chunks_[NUM_SIZE_CLASSES] = {};
+  int64_t retained_bytes_ = 0;
+};
+
+thread_local MemPool::ChunkCache MemPool::chunk_cache_;
+
 const int MemPool::INITIAL_CHUNK_SIZE;
 const int MemPool::MAX_CHUNK_SIZE;
 
@@ -80,7 +172,7 @@ void MemPool::FreeAll() {
   int64_t total_bytes_released = 0;
   for (auto& chunk: chunks_) {
     total_bytes_released += chunk.size;
-    free(chunk.data);
+    if (!chunk_cache_.Put(chunk.data, chunk.size)) free(chunk.data);
   }
   chunks_.clear();
   next_chunk_size_ = INITIAL_CHUNK_SIZE;
@@ -128,8 +220,10 @@ bool MemPool::FindChunk(int64_t min_size, bool check_limits) noexcept {
     mem_tracker_->Consume(chunk_size);
   }
 
-  // Allocate a new chunk. Return early if malloc fails.
-  uint8_t* buf = reinterpret_cast<uint8_t*>(malloc(chunk_size));
+  // Reuse a chunk that another pool on this thread freed or allocate a new one. Return
+  // early if malloc fails.
+  uint8_t* buf = chunk_cache_.Take(chunk_size);
+  if (buf == nullptr) buf = reinterpret_cast<uint8_t*>(malloc(chunk_size));
   if (UNLIKELY(buf == NULL)) {
     mem_tracker_->Release(chunk_size);
     return false;
@@ -153,6 +247,38 @@ bool MemPool::FindChunk(int64_t min_size, bool check_limits) noexcept {
   return true;
 }
 
+int64_t MemPool::chunk_cache_hits() {
+  return num_chunk_cache_hits.Load();
+}
+
+int64_t MemPool::chunk_cache_misses() {
+  return num_chunk_cache_misses.Load();
+}
+
+int64_t MemPool::chunk_cache_retained_bytes() {
+  return num_chunk_cache_retained_bytes.Load();
+}
+
+void MemPool::AcquireBuffer(uint8_t* buf, int64_t size) {
+  DFAKE_SCOPED_LOCK(mutex_);
+  DCHECK(buf != nullptr);
+  DCHECK_GT(size, 0);
+  // Insert the chunk before the free chunks and make it the current one. It has no
+  // room left, so the next allocation moves on to a free or a new chunk.
+  int first_free_idx = 0;
+  if (current_chunk_idx_ != -1) {
+    first_free_idx =
+        current_chunk_idx_ + (chunks_[current_chunk_idx_].allocated_bytes > 0);
+  }
+  ChunkInfo chunk(size, buf);
+  chunk.allocated_bytes = size;
+  chunks_.insert(chunks_.begin() + first_free_idx, chunk);
+  current_chunk_idx_ = first_free_idx;
+  total_reserved_bytes_ += size;
+  total_allocated_bytes_ += size;
+  DCHECK(CheckIntegrity(false));
+}
+
 void MemPool::AcquireData(MemPool* src, bool keep_current) {
   DFAKE_SCOPED_LOCK(mutex_);
   DCHECK(src->CheckIntegrity(false));
@@ -44,6 +44,13 @@ class MemTracker;
 /// against that tracker and all of its ancestors. If chunks get moved between pools
 /// during AcquireData() calls, the respective MemTrackers are updated accordingly.
 /// Chunks freed up in the d'tor are subtracted from the registered trackers.
+///
+/// FreeAll() returns chunks of the sizes that pools allocate most often to a bounded
+/// cache of the calling thread, from which later pools on that thread take their new
+/// chunks before falling back to malloc(). This avoids a round trip through the
+/// allocator for each batch of rows that is built up in a pool and freed again. Cached
+/// chunks are released from the MemTrackers when they enter the cache and consumed again
+/// when a pool takes them.
 //
 /// An Allocate() call will attempt to allocate memory from the chunk that was most
 /// recently added; if that chunk doesn't have enough memory to
@@ -169,6 +176,12 @@ class MemPool {
   /// All offsets handed out by calls to GetCurrentOffset() for 'src' become invalid.
   void AcquireData(MemPool* src, bool keep_current);
 
+  /// Takes ownership of the 'size' bytes at 'buf' and adds them to the pool as a fully
+  /// allocated chunk, so that they are freed or transferred like the pool's other
+  /// allocations. 'buf' must have been allocated with malloc() and 'size' must already
+  /// be consumed from this pool's MemTracker.
+  void AcquireBuffer(uint8_t* buf, int64_t size);
+
   /// Change the MemTracker, updating consumption on the current and new tracker.
   void SetMemTracker(MemTracker* new_tracker);
 
@@ -181,6 +194,13 @@ class MemPool {
   /// Return sum of chunk_sizes_.
   int64_t GetTotalChunkSizes() const;
 
+  /// Process-wide statistics of the thread-local chunk caches: the number of new chunks
+  /// that were taken from a cache or had to be allocated with malloc() and the bytes of
+  /// free chunks that the caches of all threads hold.
+  static int64_t chunk_cache_hits();
+  static int64_t chunk_cache_misses();
+  static int64_t chunk_cache_retained_bytes();
+
   /// TODO: make a macro for doing this
   /// For C++/IR interop, we need to be able to look up types by name.
   static const char* LLVM_CLASS_NAME;
@@ -196,6 +216,11 @@ class MemPool {
   /// a freelist in TCMalloc's central cache.
   static const int MAX_CHUNK_SIZE = 512 * 1024;
 
+  /// Free chunks of one thread, which FreeAll() returns chunks to. Defined in
+  /// mem-pool.cc.
+  class ChunkCache;
+  static thread_local ChunkCache chunk_cache_;
+
   struct ChunkInfo {
     uint8_t* data; // Owned by the ChunkInfo.
     int64_t size;  // in bytes
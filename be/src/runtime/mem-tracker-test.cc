@@ -24,6 +24,8 @@
 
 #include "common/names.h"
 
+DECLARE_bool(mem_tracker_allocation_stats);
+
 namespace impala {
 
 TEST(MemTestTest, SingleTrackerNoLimit) {
@@ -397,5 +399,38 @@ TEST(MemTestTest, TopN) {
   }
   root.Release(10);
 }
-}
 
+TEST(MemTestTest, AllocationSizes) {
+  MemTracker root;
+  EXPECT_EQ(nullptr, root.allocation_sizes());
+  EXPECT_EQ("", root.LogTopAllocators(10));
+
+  gflags::FlagSaver saver;
+  FLAGS_mem_tracker_allocation_stats = true;
+  MemTracker small(-1, "Small", &root);
+  MemTracker large(-1, "Large", &root);
+  ASSERT_TRUE(small.allocation_sizes() != nullptr);
+  for (int i = 0; i < 10; ++i) small.Consume(24);
+  EXPECT_TRUE(small.TryConsume(100));
+  large.Consume(1L << 20);
+  large.Consume((1L << 21) - 1);
+
+  const AllocationSizeHistogram* sizes = small.allocation_sizes();
+  EXPECT_EQ(11, sizes->num_allocations());
+  EXPECT_EQ(340, sizes->total_bytes());
+  EXPECT_EQ(10, sizes->bucket(4));
+  EXPECT_EQ(1, sizes->bucket(6));
+  EXPECT_EQ("16.00 B: 10, 64.00 B: 1", sizes->ToString());
+  EXPECT_EQ(2, large.allocation_sizes()->bucket(20));
+
+  const string top_allocators = root.LogTopAllocators(1);
+  EXPECT_STR_CONTAINS(top_allocators, "Small: Allocations=11");
+  EXPECT_EQ(string::npos, top_allocators.find("Large"));
+  EXPECT_STR_CONTAINS(root.LogUsage(MemTracker::UNLIMITED_DEPTH), "Allocations=2");
+
+  small.Release(340);
+  large.Release((1L << 20) + (1L << 21) - 1);
+  small.Close();
+  large.Close();
+}
+}
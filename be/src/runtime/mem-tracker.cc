@@ -42,10 +42,15 @@ using namespace strings;
 
 DEFINE_double_hidden(soft_mem_limit_frac, 0.9, "(Advanced) Soft memory limit as a "
     "fraction of hard memory limit.");
+DEFINE_bool(mem_tracker_allocation_stats, false, "If true, memory trackers keep "
+    "histograms of the sizes of their allocations, which are shown on the /memz page "
+    "and in query profiles, and the memory trackers of the operators of a query sample "
+    "their consumption into a time series of the query profile.");
 
 namespace impala {
 
 const string MemTracker::COUNTER_NAME = "PeakMemoryUsage";
+const string MemTracker::CONSUMPTION_TIME_SERIES_NAME = "MemoryConsumption";
 
 // Name for request pool MemTrackers. '$0' is replaced with the pool name.
 const string REQUEST_POOL_MEM_TRACKER_LABEL_FORMAT = "RequestPool=$0";
@@ -57,6 +62,23 @@ static int64_t CalcSoftLimit(int64_t limit) {
   return static_cast<int64_t>(limit * frac);
 }
 
+int64_t AllocationSizeHistogram::num_allocations() const {
+  int64_t num_allocations = 0;
+  for (const AtomicInt64& bucket : buckets_) num_allocations += bucket.Load();
+  return num_allocations;
+}
+
+string AllocationSizeHistogram::ToString() const {
+  vector<string> buckets;
+  for (int i = 0; i < NUM_BUCKETS; ++i) {
+    int64_t count = buckets_[i].Load();
+    if (count == 0) continue;
+    buckets.push_back(Substitute(
+        "$0: $1", PrettyPrinter::Print(1L << i, TUnit::BYTES), count));
+  }
+  return join(buckets, ", ");
+}
+
 MemTracker::MemTracker(int64_t byte_limit, const string& label, MemTracker* parent,
     bool log_usage_if_zero, bool is_query_mem_tracker, const TUniqueId& query_id)
   : is_query_mem_tracker_(is_query_mem_tracker),
@@ -90,6 +112,7 @@ MemTracker::MemTracker(RuntimeProfile* profile, int64_t byte_limit,
     bytes_freed_by_last_gc_metric_(NULL),
     bytes_over_limit_metric_(NULL),
     limit_metric_(NULL) {
+  profile_ = profile;
   Init();
 }
 
@@ -123,6 +146,16 @@ void MemTracker::Init() {
   }
   DCHECK_GT(all_trackers_.size(), 0);
   DCHECK_EQ(all_trackers_[0], this);
+  if (FLAGS_mem_tracker_allocation_stats && consumption_metric_ == nullptr) {
+    allocation_sizes_.reset(new AllocationSizeHistogram());
+    if (profile_ != nullptr) {
+      // Samples the counter, which is owned by the profile, so that the samples can be
+      // collected until the periodic counters of the profile are stopped.
+      RuntimeProfile::HighWaterMarkCounter* consumption = consumption_;
+      profile_->AddChunkedTimeSeriesCounter(CONSUMPTION_TIME_SERIES_NAME, TUnit::BYTES,
+          [consumption]() { return consumption->current_value(); });
+    }
+  }
 }
 
 void MemTracker::AddChildTracker(MemTracker* tracker) {
@@ -137,6 +170,14 @@ void MemTracker::Close() {
                                                 << GetStackTrace() << "\n"
                                                 << LogUsage(UNLIMITED_DEPTH);
   }
+  if (profile_ != nullptr && allocation_sizes_ != nullptr) {
+    // The tracker closes after the other users of the profile are done with its
+    // periodic counters, which must be stopped before the profile is destroyed.
+    profile_->StopPeriodicCounters();
+    profile_->AddInfoString("AllocationSizes", allocation_sizes_->ToString());
+    profile_->AddInfoString("NumAllocations",
+        std::to_string(allocation_sizes_->num_allocations()));
+  }
   closed_ = true;
 }
 
@@ -332,6 +373,13 @@ string MemTracker::LogUsage(int max_recursive_depth, const string& prefix,
   if (consumption_metric_ == nullptr || parent_ == nullptr) {
     ss << " Peak=" << PrettyPrinter::Print(peak_consumption, TUnit::BYTES);
   }
+  if (allocation_sizes_ != nullptr) {
+    int64_t num_allocations = allocation_sizes_->num_allocations();
+    if (num_allocations > 0) {
+      ss << " Allocations=" << num_allocations << " AllocationSizes=("
+         << allocation_sizes_->ToString() << ")";
+    }
+  }
 
   // This call does not need the children, so return early.
   if (max_recursive_depth == 0) return ss.str();
@@ -405,6 +453,45 @@ void MemTracker::GetTopNQueries(
   }
 }
 
+string MemTracker::LogTopAllocators(int limit) {
+  if (limit == 0 || !FLAGS_mem_tracker_allocation_stats) return "";
+  priority_queue<pair<int64_t, string>, vector<pair<int64_t, string>>,
+      std::greater<pair<int64_t, string>>>
+      min_pq;
+  GetTopAllocators(min_pq, limit);
+  vector<string> usage_strings;
+  while (!min_pq.empty()) {
+    usage_strings.push_back(min_pq.top().second);
+    min_pq.pop();
+  }
+  std::reverse(usage_strings.begin(), usage_strings.end());
+  return join(usage_strings, "\n");
+}
+
+void MemTracker::GetTopAllocators(
+    priority_queue<pair<int64_t, string>, vector<pair<int64_t, string>>,
+        greater<pair<int64_t, string>>>& min_pq,
+    int limit) {
+  lock_guard<SpinLock> l(child_trackers_lock_);
+  for (MemTracker* tracker : child_trackers_) {
+    tracker->GetTopAllocators(min_pq, limit);
+    if (tracker->allocation_sizes_ == nullptr) continue;
+    int64_t num_allocations = tracker->allocation_sizes_->num_allocations();
+    if (num_allocations == 0) continue;
+    // Labels of trackers below the query level are only unique within their query.
+    MemTracker* query_tracker = tracker->GetQueryMemTracker();
+    string label = query_tracker == nullptr || query_tracker == tracker ?
+        tracker->label_ :
+        Substitute("$0/$1", query_tracker->label_, tracker->label_);
+    min_pq.push(make_pair(num_allocations,
+        Substitute("$0: Allocations=$1 Total=$2 AllocationSizes=($3)", label,
+            num_allocations,
+            PrettyPrinter::Print(tracker->allocation_sizes_->total_bytes(), TUnit::BYTES),
+            tracker->allocation_sizes_->ToString())));
+    if (min_pq.size() > limit) min_pq.pop();
+  }
+}
+
 // Update the memory consumption related fields in pool_stats.
 void MemTracker::UpdatePoolStatsForMemoryConsumed(
     int64_t mem_consumed, TPoolStats& pool_stats) {
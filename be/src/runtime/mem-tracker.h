@@ -35,6 +35,7 @@
 #include "common/logging.h"
 #include "common/status.h"
 #include "runtime/mem-tracker-types.h"
+#include "util/bit-util.h"
 #include "util/metrics-fwd.h"
 #include "util/runtime-profile-counters.h"
 #include "util/spinlock.h"
@@ -50,6 +51,33 @@ class ObjectPool;
 struct ReservationTrackerCounters;
 class RuntimeState;
 
+/// Histogram of the sizes of the allocations that are consumed against a MemTracker,
+/// with a bucket per power of two. Thread-safe.
+class AllocationSizeHistogram {
+ public:
+  /// Bucket i counts the allocations of [2^i, 2^(i+1)) bytes. The last bucket also
+  /// counts all larger allocations.
+  static const int NUM_BUCKETS = 40;
+
+  void Add(int64_t bytes) {
+    DCHECK_GT(bytes, 0);
+    buckets_[std::min(BitUtil::Log2FloorNonZero64(bytes), NUM_BUCKETS - 1)].Add(1);
+    total_bytes_.Add(bytes);
+  }
+
+  int64_t num_allocations() const;
+  int64_t total_bytes() const { return total_bytes_.Load(); }
+  int64_t bucket(int i) const { return buckets_[i].Load(); }
+
+  /// Returns the counts of the non-empty buckets by their lower bound, e.g.
+  /// "64.00 B: 12, 8.00 KB: 3".
+  std::string ToString() const;
+
+ private:
+  AtomicInt64 buckets_[NUM_BUCKETS];
+  AtomicInt64 total_bytes_;
+};
+
 /// A MemTracker tracks memory consumption; it contains an optional limit
 /// and can be arranged into a tree structure such that the consumption tracked
 /// by a MemTracker is also tracked by its ancestors.
@@ -83,6 +111,12 @@ class RuntimeState;
 /// called in the order they are added, so expensive functions should be added last.
 /// GcFunctions are called with a global lock held, so should be non-blocking and not
 /// call back into MemTrackers, except to release memory.
+///
+/// If --mem_tracker_allocation_stats is true, every MemTracker without a consumption
+/// metric keeps a histogram of the sizes of the allocations consumed against it (but
+/// not against its descendants), which is included in LogUsage() and, for trackers
+/// created as part of a profile, added to the profile on Close(). Those trackers also
+/// sample their consumption into a time series counter of the profile.
 //
 /// This class is thread-safe.
 class MemTracker {
@@ -143,6 +177,7 @@ class MemTracker {
       RefreshConsumptionFromMetric();
       return;
     }
+    if (UNLIKELY(allocation_sizes_ != nullptr)) allocation_sizes_->Add(bytes);
     for (MemTracker* tracker : all_trackers_) {
       tracker->consumption_->Add(bytes);
       if (tracker->consumption_metric_ == nullptr) {
@@ -215,6 +250,7 @@ class MemTracker {
     }
     // Everyone succeeded, return.
     DCHECK_EQ(i, -1);
+    if (UNLIKELY(allocation_sizes_ != nullptr)) allocation_sizes_->Add(bytes);
     return true;
   }
 
@@ -347,6 +383,17 @@ class MemTracker {
   /// consumption.
   std::string LogTopNQueries(int limit);
 
+  /// Logs the allocation size histograms of the 'limit' descendants of this tracker
+  /// with the most allocations. Returns an empty string if
+  /// --mem_tracker_allocation_stats is false.
+  std::string LogTopAllocators(int limit);
+
+  /// Returns the histogram of the sizes of the allocations consumed against this
+  /// tracker, or nullptr if --mem_tracker_allocation_stats is false.
+  const AllocationSizeHistogram* allocation_sizes() const {
+    return allocation_sizes_.get();
+  }
+
   /// Update the following data members in pool_stats for all queries tracked through
   /// query memory trackers:
   ///   heavy_memory_queries: the query Ids of top 'limit' queries in memory consumption
@@ -378,6 +425,10 @@ class MemTracker {
 
   static const std::string COUNTER_NAME;
 
+  /// Name of the time series counter of the consumption of trackers created as part of
+  /// a profile.
+  static const std::string CONSUMPTION_TIME_SERIES_NAME;
+
  private:
   friend class PoolMemTrackerRegistry;
 
@@ -416,6 +467,13 @@ class MemTracker {
           std::greater<pair<int64_t, string>>>& min_pq,
       int limit);
 
+  /// Helper function for LogTopAllocators() that adds the descendants of this tracker to
+  /// 'min_pq', keeping the 'limit' trackers with the most allocations.
+  void GetTopAllocators(
+      std::priority_queue<pair<int64_t, string>, vector<pair<int64_t, string>>,
+          std::greater<pair<int64_t, string>>>& min_pq,
+      int limit);
+
   /// If an ancestor of this tracker is a query MemTracker, return that tracker.
   /// Otherwise return NULL.
   MemTracker* GetQueryMemTracker();
@@ -495,6 +553,13 @@ class MemTracker {
   /// holds consumption_ counter if not tied to a profile
   RuntimeProfile::HighWaterMarkCounter local_counter_;
 
+  /// The profile that owns consumption_, if any. Not owned.
+  RuntimeProfile* profile_ = nullptr;
+
+  /// If non-NULL, the sizes of the allocations consumed against this tracker. Only
+  /// created if --mem_tracker_allocation_stats is true.
+  std::unique_ptr<AllocationSizeHistogram> allocation_sizes_;
+
   /// If non-NULL, used to measure consumption (in bytes) rather than the values provided
   /// to Consume()/Release(). Only used for the process tracker, thus parent_ should be
   /// NULL if consumption_metric_ is set.
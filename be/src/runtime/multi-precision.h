@@ -131,6 +131,55 @@ inline uint64_t LowBits(int128_t x) {
 // Doubles the width of integer types (e.g. int32_t -> int64_t).
 // Currently only works with a few signed types.
 // Feel free to extend it to other types as well.
+/// Stores the 256-bit product of 'x' and 'y' in 'product' as four 64-bit limbs, least
+/// significant first. Much cheaper than multiplying int256_t values.
+inline void MultiplyUint128(__uint128_t x, __uint128_t y, uint64_t product[4]) {
+  const uint64_t x_lo = static_cast<uint64_t>(x);
+  const uint64_t x_hi = static_cast<uint64_t>(x >> 64);
+  const uint64_t y_lo = static_cast<uint64_t>(y);
+  const uint64_t y_hi = static_cast<uint64_t>(y >> 64);
+  const __uint128_t lo_lo = static_cast<__uint128_t>(x_lo) * y_lo;
+  const __uint128_t lo_hi = static_cast<__uint128_t>(x_lo) * y_hi;
+  const __uint128_t hi_lo = static_cast<__uint128_t>(x_hi) * y_lo;
+  const __uint128_t hi_hi = static_cast<__uint128_t>(x_hi) * y_hi;
+  // Sums of three 64-bit values cannot overflow 128 bits.
+  const __uint128_t middle = (lo_lo >> 64) + static_cast<uint64_t>(lo_hi)
+      + static_cast<uint64_t>(hi_lo);
+  const __uint128_t high = hi_hi + (lo_hi >> 64) + (hi_lo >> 64) + (middle >> 64);
+  product[0] = static_cast<uint64_t>(lo_lo);
+  product[1] = static_cast<uint64_t>(middle);
+  product[2] = static_cast<uint64_t>(high);
+  product[3] = static_cast<uint64_t>(high >> 64);
+}
+
+/// Divides the 128-bit value with the 64-bit halves 'hi' and 'lo' by 'divisor', which
+/// must be greater than 'hi' so that the quotient fits in 64 bits. Returns the quotient
+/// and stores the remainder in 'remainder'.
+inline uint64_t DivideUint128By64(uint64_t hi, uint64_t lo, uint64_t divisor,
+    uint64_t* remainder) {
+#ifdef __x86_64__
+  // A single divide instruction, instead of the call to __udivti3 that the compiler
+  // emits for a 128-bit division.
+  uint64_t quotient;
+  __asm__("divq %4" : "=a"(quotient), "=d"(*remainder) : "a"(lo), "d"(hi), "rm"(divisor));
+  return quotient;
+#else
+  const __uint128_t dividend = (static_cast<__uint128_t>(hi) << 64) | lo;
+  *remainder = static_cast<uint64_t>(dividend % divisor);
+  return static_cast<uint64_t>(dividend / divisor);
+#endif
+}
+
+/// Divides the 256-bit value with the limbs 'value', least significant first, by
+/// 'divisor' in place and returns the remainder.
+inline uint64_t DivideUint256By64(uint64_t value[4], uint64_t divisor) {
+  uint64_t remainder = 0;
+  for (int i = 3; i >= 0; --i) {
+    value[i] = DivideUint128By64(remainder, value[i], divisor, &remainder);
+  }
+  return remainder;
+}
+
 template <typename T>
 struct DoubleWidth {};
 
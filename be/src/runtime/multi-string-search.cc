@@ -0,0 +1,137 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/multi-string-search.h"
+
+#include <cstring>
+
+#include "common/logging.h"
+#include "util/bit-util.h"
+#include "util/cpu-info.h"
+#include "util/sse-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+MultiStringSearch::MultiStringSearch(const vector<string>& patterns) {
+  memset(byte_class_, 0, sizeof(byte_class_));
+  memset(is_first_byte_, 0, sizeof(is_first_byte_));
+  for (const string& pattern : patterns) {
+    for (char c : pattern) {
+      uint16_t* byte_class = &byte_class_[static_cast<uint8_t>(c)];
+      if (*byte_class == 0) *byte_class = num_classes_++;
+    }
+  }
+
+  // Build the trie of the patterns. Missing transitions are -1 until they are filled in
+  // below.
+  transitions_.assign(num_classes_, -1);
+  is_match_.assign(1, 0);
+  for (const string& pattern : patterns) {
+    int state = 0;
+    for (char c : pattern) {
+      const int idx = state * num_classes_ + byte_class_[static_cast<uint8_t>(c)];
+      if (transitions_[idx] == -1) {
+        transitions_[idx] = is_match_.size();
+        transitions_.resize(transitions_.size() + num_classes_, -1);
+        is_match_.push_back(0);
+      }
+      state = transitions_[idx];
+    }
+    is_match_[state] = 1;
+    if (!pattern.empty()) is_first_byte_[static_cast<uint8_t>(pattern[0])] = true;
+  }
+
+  // Turn the trie into a DFA by following the failure links in breadth-first order. The
+  // failure link of a state is the state of its longest proper suffix in the trie, which
+  // is always shallower, so its transitions are complete when they are copied.
+  vector<int32_t> failure(is_match_.size(), 0);
+  vector<int32_t> queue;
+  queue.reserve(is_match_.size());
+  for (int c = 0; c < num_classes_; ++c) {
+    int32_t* next = &transitions_[c];
+    if (*next == -1) {
+      *next = 0;
+    } else {
+      queue.push_back(*next);
+    }
+  }
+  for (int i = 0; i < queue.size(); ++i) {
+    const int state = queue[i];
+    const int fail_state = failure[state];
+    is_match_[state] |= is_match_[fail_state];
+    for (int c = 0; c < num_classes_; ++c) {
+      int32_t* next = &transitions_[state * num_classes_ + c];
+      const int32_t fail_next = transitions_[fail_state * num_classes_ + c];
+      if (*next == -1) {
+        *next = fail_next;
+      } else {
+        failure[*next] = fail_next;
+        queue.push_back(*next);
+      }
+    }
+  }
+
+  for (int b = 0; b < 256; ++b) {
+    if (!is_first_byte_[b]) continue;
+    if (num_first_bytes_ == sizeof(first_bytes_)) {
+      num_first_bytes_ = 0;
+      break;
+    }
+    first_bytes_[num_first_bytes_++] = b;
+  }
+  use_sse_ = num_first_bytes_ > 0 && CpuInfo::IsSupported(CpuInfo::SSE4_2);
+}
+
+int MultiStringSearch::NextCandidate(const uint8_t* str, int pos, int len) const {
+  if (use_sse_) {
+    const __m128i needles =
+        _mm_load_si128(reinterpret_cast<const __m128i*>(first_bytes_));
+    while (pos + SSEUtil::CHARS_PER_128_BIT_REGISTER <= len) {
+      const __m128i haystack =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + pos));
+      const __m128i mask = SSE4_cmpestrm<SSEUtil::STRCHR_MODE>(needles,
+          num_first_bytes_, haystack, SSEUtil::CHARS_PER_128_BIT_REGISTER);
+      const uint32_t bits = _mm_extract_epi16(mask, 0);
+      if (bits != 0) return pos + BitUtil::CountTrailingZeros(bits);
+      pos += SSEUtil::CHARS_PER_128_BIT_REGISTER;
+    }
+  }
+  while (pos < len && !is_first_byte_[str[pos]]) ++pos;
+  return pos;
+}
+
+bool MultiStringSearch::ContainsAny(const StringValue& str) const {
+  if (is_match_[0]) return true;
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(str.ptr);
+  const int len = str.len;
+  int state = 0;
+  for (int i = 0; i < len; ++i) {
+    if (state == 0) {
+      // No pattern has been partially matched. Skip to the next byte that starts one.
+      i = NextCandidate(data, i, len);
+      if (i == len) return false;
+    }
+    state = transitions_[state * num_classes_ + byte_class_[data[i]]];
+    if (is_match_[state]) return true;
+  }
+  return false;
+}
+
+} // namespace impala
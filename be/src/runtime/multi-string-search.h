@@ -0,0 +1,75 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "runtime/string-value.h"
+
+namespace impala {
+
+/// Searches strings for any of a set of patterns in a single pass, with an Aho-Corasick
+/// automaton. The automaton is a DFA over byte classes: all bytes that do not occur in
+/// any pattern share one class, so the transition table has one row per trie node and
+/// one column per distinct pattern byte.
+///
+/// While the automaton is in its start state, which is the case for most of the input
+/// if the patterns are rare, the bytes that cannot start a pattern are skipped. If the
+/// patterns start with at most 16 distinct bytes, a SSE4.2 PCMPESTRM compares 16 bytes of
+/// the input at a time against all of them. Otherwise the bytes are looked up in a table
+/// one at a time.
+class MultiStringSearch {
+ public:
+  /// Builds the automaton for 'patterns'. An empty pattern is contained in any string.
+  explicit MultiStringSearch(const std::vector<std::string>& patterns);
+
+  /// Returns true if any of the patterns occurs in 'str'.
+  bool ContainsAny(const StringValue& str) const;
+
+  int num_states() const { return is_match_.size(); }
+
+ private:
+  /// Returns the first position in ['pos', 'len') of 'str' with a byte that starts a
+  /// pattern, or 'len' if there is none.
+  int NextCandidate(const uint8_t* str, int pos, int len) const;
+
+  /// The class of each byte. Bytes that do not occur in any pattern are of class 0.
+  uint16_t byte_class_[256];
+  int num_classes_ = 1;
+
+  /// The next state of state s for a byte of class c is
+  /// transitions_[s * num_classes_ + c]. State 0 is the start state.
+  std::vector<int32_t> transitions_;
+
+  /// Non-zero for the states in which a pattern was found.
+  std::vector<uint8_t> is_match_;
+
+  /// True for the first bytes of the patterns.
+  bool is_first_byte_[256];
+
+  /// The distinct first bytes of the patterns for the SSE4.2 prefilter. Only used if
+  /// 'use_sse_' is true.
+  alignas(16) uint8_t first_bytes_[16];
+  int num_first_bytes_ = 0;
+  bool use_sse_ = false;
+};
+
+} // namespace impala
@@ -0,0 +1,55 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/pool-cgroup-mgr.h"
+#include "testutil/gtest-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+TEST(PoolCGroupMgrTest, ParsePoolValues) {
+  map<string, string> values;
+  ASSERT_OK(PoolCGroupMgr::ParsePoolValues("", &values));
+  EXPECT_TRUE(values.empty());
+  ASSERT_OK(PoolCGroupMgr::ParsePoolValues(
+      "root.default:100, root.etl : 400,,root.a:b:2.5", &values));
+  ASSERT_EQ(3, values.size());
+  EXPECT_EQ("100", values["root.default"]);
+  EXPECT_EQ("400", values["root.etl"]);
+  // The value follows the last ':'.
+  EXPECT_EQ("2.5", values["root.a:b"]);
+  EXPECT_FALSE(PoolCGroupMgr::ParsePoolValues("root.default", &values).ok());
+  EXPECT_FALSE(PoolCGroupMgr::ParsePoolValues("root.default:", &values).ok());
+  EXPECT_FALSE(PoolCGroupMgr::ParsePoolValues(":100", &values).ok());
+}
+
+TEST(PoolCGroupMgrTest, CGroupName) {
+  EXPECT_EQ("impala-pool-root.default", PoolCGroupMgr::CGroupName("root.default"));
+  EXPECT_EQ("impala-pool-root.a_b_c", PoolCGroupMgr::CGroupName("root.a/b c"));
+}
+
+TEST(PoolCGroupMgrTest, InvalidConfig) {
+  MetricGroup metrics("test");
+  PoolCGroupMgr bad_weight("root.default:0", "");
+  EXPECT_FALSE(bad_weight.Init(&metrics).ok());
+  PoolCGroupMgr bad_max("", "root.default:-1");
+  EXPECT_FALSE(bad_max.Init(&metrics).ok());
+}
+
+}
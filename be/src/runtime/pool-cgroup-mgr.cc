@@ -0,0 +1,286 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/pool-cgroup-mgr.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include "common/logging.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/exec-env.h"
+#include "util/cgroup-util.h"
+#include "util/error-util.h"
+#include "util/filesystem-util.h"
+#include "util/metrics.h"
+#include "util/string-parser.h"
+
+#include "common/names.h"
+
+using boost::algorithm::is_any_of;
+using boost::algorithm::split;
+using boost::algorithm::trim;
+
+namespace impala {
+
+const string PoolCGroupMgr::CGROUP_PREFIX = "impala-pool-";
+
+/// Period of cpu.max. The kernel's default of 100ms.
+static const int64_t CPU_MAX_PERIOD_US = 100000;
+/// Smallest quota that the kernel accepts in cpu.max.
+static const int64_t CPU_MAX_MIN_QUOTA_US = 1000;
+
+/// Writes 'value' to the cgroup interface file at 'path'. Uses a single write(), since
+/// the kernel reports invalid values as an error of the write.
+static Status WriteCGroupFile(const string& path, const string& value) {
+  int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd < 0) return Status(Substitute("Could not open $0: $1", path, GetStrErrMsg()));
+  ssize_t bytes_written = write(fd, value.data(), value.size());
+  int err = errno;
+  close(fd);
+  if (bytes_written != static_cast<ssize_t>(value.size())) {
+    return Status(Substitute(
+        "Could not write '$0' to $1: $2", value, path, GetStrErrMsg(err)));
+  }
+  return Status::OK();
+}
+
+static Status ReadCGroupFile(const string& path, string* contents) {
+  ifstream file(path, ios::in);
+  stringstream ss;
+  ss << file.rdbuf();
+  if (file.fail() || file.bad()) {
+    return Status(Substitute("Error reading $0: $1", path, GetStrErrMsg()));
+  }
+  *contents = ss.str();
+  return Status::OK();
+}
+
+/// Cumulative CPU time of the threads of a pool in microseconds, read from the
+/// "usage_usec" field of the cpu.stat file of its sub-group.
+class PoolCGroupMgr::CpuUsageMetric : public IntCounter {
+ public:
+  CpuUsageMetric(const TMetricDef& def, const string& cpu_stat_path)
+    : IntCounter(def, 0), cpu_stat_path_(cpu_stat_path) {}
+
+  virtual int64_t GetValue() override {
+    ifstream cpu_stat(cpu_stat_path_, ios::in);
+    string key;
+    int64_t value;
+    while (cpu_stat >> key >> value) {
+      if (key != "usage_usec") continue;
+      last_value_.store(value);
+      break;
+    }
+    // Keep reporting the last value if the file cannot be read.
+    return last_value_.load();
+  }
+
+ private:
+  const string cpu_stat_path_;
+  std::atomic<int64_t> last_value_{0};
+};
+
+PoolCGroupMgr::PoolCGroupMgr(const string& cpu_weights, const string& cpu_max)
+  : cpu_weights_spec_(cpu_weights), cpu_max_spec_(cpu_max) {}
+
+PoolCGroupMgr::~PoolCGroupMgr() {
+  lock_guard<mutex> l(lock_);
+  for (const auto& entry : groups_) {
+    // Only succeeds if no thread is in the sub-group anymore.
+    if (rmdir(entry.second->path.c_str()) != 0) {
+      VLOG(1) << "Could not remove " << entry.second->path << ": " << GetStrErrMsg();
+    }
+  }
+}
+
+Status PoolCGroupMgr::ParsePoolValues(const string& spec, map<string, string>* values) {
+  values->clear();
+  vector<string> entries;
+  split(entries, spec, is_any_of(","));
+  for (string& entry : entries) {
+    trim(entry);
+    if (entry.empty()) continue;
+    // Pool names may contain ':', so the value starts after the last one.
+    size_t pos = entry.rfind(':');
+    string key = entry.substr(0, pos == string::npos ? 0 : pos);
+    string value = pos == string::npos ? "" : entry.substr(pos + 1);
+    trim(key);
+    trim(value);
+    if (key.empty() || value.empty()) {
+      return Status(Substitute("Invalid entry '$0', expected '<pool>:<value>'", entry));
+    }
+    (*values)[key] = value;
+  }
+  return Status::OK();
+}
+
+string PoolCGroupMgr::CGroupName(const string& pool) {
+  string name = CGROUP_PREFIX + pool;
+  for (char& c : name) {
+    if (!isalnum(c) && c != '.' && c != '-' && c != '_') c = '_';
+  }
+  return name;
+}
+
+Status PoolCGroupMgr::Init(MetricGroup* metrics) {
+  RETURN_IF_ERROR(ParsePoolValues(cpu_weights_spec_, &cpu_weights_));
+  for (const auto& entry : cpu_weights_) {
+    StringParser::ParseResult result;
+    int64_t weight = StringParser::StringToInt<int64_t>(
+        entry.second.c_str(), entry.second.size(), &result);
+    if (result != StringParser::PARSE_SUCCESS || weight < 1 || weight > 10000) {
+      return Status(Substitute("Invalid CPU weight '$0' of pool $1, must be between 1 "
+          "and 10000", entry.second, entry.first));
+    }
+  }
+  map<string, string> cpu_max_cores;
+  RETURN_IF_ERROR(ParsePoolValues(cpu_max_spec_, &cpu_max_cores));
+  for (const auto& entry : cpu_max_cores) {
+    StringParser::ParseResult result;
+    double cores = StringParser::StringToFloat<double>(
+        entry.second.c_str(), entry.second.size(), &result);
+    if (result != StringParser::PARSE_SUCCESS || cores <= 0) {
+      return Status(Substitute("Invalid CPU maximum '$0' of pool $1, must be a positive "
+          "number of cores", entry.second, entry.first));
+    }
+    int64_t quota_us = max(CPU_MAX_MIN_QUOTA_US,
+        static_cast<int64_t>(cores * CPU_MAX_PERIOD_US));
+    cpu_max_[entry.first] = Substitute("$0 $1", quota_us, CPU_MAX_PERIOD_US);
+  }
+
+  RETURN_IF_ERROR(CGroupUtil::FindCGroupV2Path(&root_path_));
+  string controllers;
+  RETURN_IF_ERROR(ReadCGroupFile(root_path_ + "/cgroup.controllers", &controllers));
+  vector<string> controller_names;
+  split(controller_names, controllers, is_any_of(" \n"));
+  if (find(controller_names.begin(), controller_names.end(), "cpu")
+      == controller_names.end()) {
+    return Status(Substitute("The cpu controller is not available in cgroup $0. It must "
+        "be enabled in the parent cgroup and the cgroup delegated to impalad.",
+        root_path_));
+  }
+
+  // Remove the sub-groups of a previous process. They are empty since their threads
+  // ended with that process.
+  vector<string> names;
+  RETURN_IF_ERROR(FileSystemUtil::Directory::GetEntryNames(
+      root_path_, &names, 0, FileSystemUtil::Directory::DIR_ENTRY_DIR));
+  for (const string& name : names) {
+    if (name.compare(0, CGROUP_PREFIX.size(), CGROUP_PREFIX) != 0) continue;
+    string path = Substitute("$0/$1", root_path_, name);
+    if (rmdir(path.c_str()) != 0) {
+      LOG(WARNING) << "Could not remove stale cgroup " << path << ": " << GetStrErrMsg();
+    }
+  }
+  metrics_ = metrics->GetOrCreateChildGroup("pool-cgroup");
+  LOG(INFO) << "Isolating the CPU usage of pools in sub-groups of cgroup " << root_path_;
+  return Status::OK();
+}
+
+Status PoolCGroupMgr::CreatePoolCGroup(
+    const string& pool, unique_ptr<PoolCGroup>* group) {
+  string path = Substitute("$0/$1", root_path_, CGroupName(pool));
+  // Two pools may share a sub-group if their names only differ in replaced characters.
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    return Status(Substitute("Could not create cgroup $0: $1", path, GetStrErrMsg()));
+  }
+  RETURN_IF_ERROR(WriteCGroupFile(path + "/cgroup.type", "threaded"));
+  if (!cpu_controller_enabled_) {
+    RETURN_IF_ERROR(WriteCGroupFile(root_path_ + "/cgroup.subtree_control", "+cpu"));
+    cpu_controller_enabled_ = true;
+  }
+  auto weight_it = cpu_weights_.find(pool);
+  if (weight_it != cpu_weights_.end()) {
+    RETURN_IF_ERROR(WriteCGroupFile(path + "/cpu.weight", weight_it->second));
+  }
+  auto max_it = cpu_max_.find(pool);
+  if (max_it != cpu_max_.end()) {
+    RETURN_IF_ERROR(WriteCGroupFile(path + "/cpu.max", max_it->second));
+  }
+  group->reset(new PoolCGroup());
+  (*group)->path = path;
+  (*group)->num_threads = metrics_->AddGauge("pool-cgroup.num-threads.$0", 0, pool);
+  metrics_->RegisterMetric(new CpuUsageMetric(
+      MetricDefs::Get("pool-cgroup.cpu-usage-us.$0", pool), path + "/cpu.stat"));
+  VLOG(1) << "Created cgroup " << path << " for pool " << pool;
+  return Status::OK();
+}
+
+Status PoolCGroupMgr::MoveThread(const string& path) {
+  return WriteCGroupFile(path + "/cgroup.threads", to_string(syscall(SYS_gettid)));
+}
+
+Status PoolCGroupMgr::EnterPool(const string& pool) {
+  PoolCGroup* group;
+  {
+    lock_guard<mutex> l(lock_);
+    auto it = groups_.find(pool);
+    if (it == groups_.end()) {
+      unique_ptr<PoolCGroup> new_group;
+      RETURN_IF_ERROR(CreatePoolCGroup(pool, &new_group));
+      it = groups_.emplace(pool, move(new_group)).first;
+    }
+    group = it->second.get();
+  }
+  RETURN_IF_ERROR(MoveThread(group->path));
+  group->num_threads->Increment(1);
+  return Status::OK();
+}
+
+void PoolCGroupMgr::LeavePool(const string& pool) {
+  PoolCGroup* group;
+  {
+    lock_guard<mutex> l(lock_);
+    auto it = groups_.find(pool);
+    DCHECK(it != groups_.end()) << pool;
+    group = it->second.get();
+  }
+  Status status = MoveThread(root_path_);
+  if (!status.ok()) LOG(WARNING) << status.GetDetail();
+  group->num_threads->Increment(-1);
+}
+
+ScopedPoolCGroup::ScopedPoolCGroup(const string& pool) : pool_(pool) {
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  PoolCGroupMgr* mgr = exec_env == nullptr ? nullptr : exec_env->pool_cgroup_mgr();
+  if (mgr == nullptr || pool.empty()) return;
+  Status status = mgr->EnterPool(pool);
+  if (!status.ok()) {
+    LOG_EVERY_N(WARNING, 100) << "Could not move thread into the cgroup of pool "
+                              << pool << ": " << status.GetDetail();
+    return;
+  }
+  mgr_ = mgr;
+}
+
+ScopedPoolCGroup::~ScopedPoolCGroup() {
+  if (mgr_ != nullptr) mgr_->LeavePool(pool_);
+}
+
+}
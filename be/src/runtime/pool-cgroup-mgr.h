@@ -0,0 +1,149 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/status.h"
+#include "gutil/macros.h"
+#include "util/metrics-fwd.h"
+
+namespace impala {
+
+class MetricGroup;
+
+/// Isolates the CPU usage of the admission control pools from each other with cgroup v2.
+/// Every pool gets a sub-group of the cgroup of impalad, named "impala-pool-<pool>",
+/// and the threads that execute fragment instances of the pool's queries are moved into
+/// it while they work on the query (see ScopedPoolCGroup). The cpu controller then
+/// shares the CPUs between the pools by their configured cpu.weight and caps a pool at
+/// its configured cpu.max, so that a CPU-heavy pool cannot starve the queries of the
+/// other pools on the same executor.
+///
+/// The sub-groups are threaded cgroups, because the threads of one process are spread
+/// over them. This requires that the cgroup of impalad is delegated to the impala user
+/// with the cpu controller enabled in its parent, e.g. with systemd's "Delegate=cpu",
+/// and that it has no other children than the ones created here. The sub-groups are
+/// created when a pool first runs a thread. Init() removes the sub-groups that a
+/// previous process left behind, and the destructor removes the ones of this process.
+///
+/// The CPU usage of every pool is exported as a metric, read from its cpu.stat.
+///
+/// All functions are thread-safe.
+class PoolCGroupMgr {
+ public:
+  /// 'cpu_weights' is a comma-separated list of "<pool>:<weight>" entries, where the
+  /// weight is between 1 and 10000 and defaults to 100 for pools that are not listed.
+  /// 'cpu_max' is a comma-separated list of "<pool>:<cores>" entries that cap the CPU
+  /// usage of a pool at a possibly fractional number of cores.
+  PoolCGroupMgr(const std::string& cpu_weights, const std::string& cpu_max);
+
+  ~PoolCGroupMgr();
+
+  /// Finds the cgroup of impalad, checks that the cpu controller is available for its
+  /// sub-groups and removes the sub-groups left behind by a previous process. Registers
+  /// the metrics in 'metrics'.
+  Status Init(MetricGroup* metrics) WARN_UNUSED_RESULT;
+
+  /// Moves the calling thread into the sub-group of 'pool', creating the sub-group if
+  /// this is the first thread of the pool.
+  Status EnterPool(const std::string& pool) WARN_UNUSED_RESULT;
+
+  /// Moves the calling thread, which must have entered 'pool', back to the cgroup of
+  /// impalad.
+  void LeavePool(const std::string& pool);
+
+  /// Parses a comma-separated list of "<key>:<value>" entries into 'values'. Leading
+  /// and trailing whitespace of keys and values is ignored.
+  static Status ParsePoolValues(const std::string& spec,
+      std::map<std::string, std::string>* values) WARN_UNUSED_RESULT;
+
+  /// Returns the name of the sub-group of 'pool'. Characters that may not appear in
+  /// the name of a cgroup are replaced with '_'.
+  static std::string CGroupName(const std::string& pool);
+
+  /// Prefix of the names of the sub-groups.
+  static const std::string CGROUP_PREFIX;
+
+ private:
+  class CpuUsageMetric;
+
+  struct PoolCGroup {
+    /// Absolute path of the sub-group.
+    std::string path;
+
+    /// Number of threads in the sub-group.
+    IntGauge* num_threads = nullptr;
+  };
+
+  /// Creates the sub-group of 'pool' and its metrics. 'lock_' must be held.
+  Status CreatePoolCGroup(const std::string& pool, std::unique_ptr<PoolCGroup>* group);
+
+  /// Moves the calling thread into the cgroup at 'path'.
+  static Status MoveThread(const std::string& path) WARN_UNUSED_RESULT;
+
+  /// The unparsed 'cpu_weights' and 'cpu_max' from the c'tor.
+  const std::string cpu_weights_spec_;
+  const std::string cpu_max_spec_;
+
+  /// cpu.weight and cpu.max of the pools that have them configured, in the format that
+  /// is written to the files. Set in Init().
+  std::map<std::string, std::string> cpu_weights_;
+  std::map<std::string, std::string> cpu_max_;
+
+  /// Absolute path of the cgroup of impalad. Set in Init().
+  std::string root_path_;
+
+  MetricGroup* metrics_ = nullptr;
+
+  /// Protects the members below.
+  std::mutex lock_;
+
+  /// Whether the cpu controller was enabled for the sub-groups of 'root_path_'. This is
+  /// done when the first sub-group is created, because the kernel only allows it once
+  /// impalad's cgroup has a threaded sub-group.
+  bool cpu_controller_enabled_ = false;
+
+  /// The sub-groups created by this process, by pool name.
+  std::unordered_map<std::string, std::unique_ptr<PoolCGroup>> groups_;
+
+  DISALLOW_COPY_AND_ASSIGN(PoolCGroupMgr);
+};
+
+/// Moves the current thread into the sub-group of 'pool' for the lifetime of the
+/// object, if cgroup CPU isolation is enabled. Failures are logged and leave the thread
+/// in the cgroup of impalad.
+class ScopedPoolCGroup {
+ public:
+  explicit ScopedPoolCGroup(const std::string& pool);
+  ~ScopedPoolCGroup();
+
+ private:
+  /// The manager whose sub-group the thread entered, or nullptr if it did not.
+  PoolCGroupMgr* mgr_ = nullptr;
+  const std::string pool_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedPoolCGroup);
+};
+
+}
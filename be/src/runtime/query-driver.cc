@@ -19,9 +19,11 @@
 
 #include "runtime/exec-env.h"
 #include "runtime/query-driver.h"
+#include "scheduling/cluster-membership-mgr.h"
 #include "service/client-request-state.h"
 #include "service/frontend.h"
 #include "service/impala-server.h"
+#include "service/plan-cache.h"
 #include "util/debug-util.h"
 #include "util/network-util.h"
 #include "util/runtime-profile-counters.h"
@@ -35,6 +37,9 @@ namespace impala {
 // A 0 unique id, which indicates that one has not been set.
 const TUniqueId ZERO_UNIQUE_ID;
 
+// Key of the info string in the summary profile about the use of the plan cache.
+static const string PLAN_CACHE_KEY = "Plan Cache";
+
 QueryDriver::QueryDriver(ImpalaServer* parent_server) : parent_server_(parent_server) {}
 
 QueryDriver::~QueryDriver() {
@@ -62,9 +67,31 @@ Status QueryDriver::RunFrontendPlanner(const TQueryCtx& query_ctx) {
   DCHECK(exec_request_ != nullptr);
   RETURN_IF_ERROR(
       DebugAction(query_ctx.client_request.query_options, "FRONTEND_PLANNER"));
+  ExecEnv* exec_env = ExecEnv::GetInstance();
+  PlanCache* plan_cache = parent_server_->plan_cache();
+  RuntimeProfile* summary_profile = client_request_state_->summary_profile();
+  string plan_cache_key;
+  int64_t plan_cache_generation = -1;
+  if (plan_cache != nullptr && query_ctx.client_request.query_options.use_plan_cache) {
+    // The planner takes the executors of the cluster into account.
+    ClusterMembershipMgr* membership_mgr = exec_env->cluster_membership_mgr();
+    int64_t membership_version =
+        membership_mgr == nullptr ? 0 : membership_mgr->GetSnapshot()->version;
+    if (PlanCache::GetKey(query_ctx, membership_version, &plan_cache_key)) {
+      if (plan_cache->Lookup(plan_cache_key, query_ctx, exec_request_.get())) {
+        summary_profile->AddInfoString(PLAN_CACHE_KEY, "Hit");
+        return Status::OK();
+      }
+      summary_profile->AddInfoString(PLAN_CACHE_KEY, "Miss");
+      plan_cache_generation = plan_cache->generation();
+    }
+  }
   RETURN_IF_ERROR(client_request_state_->UpdateQueryStatus(
-      ExecEnv::GetInstance()->frontend()->GetExecRequest(
-          query_ctx, exec_request_.get())));
+      exec_env->frontend()->GetExecRequest(query_ctx, exec_request_.get())));
+  if (plan_cache_generation >= 0 && PlanCache::IsCacheable(*exec_request_)
+      && plan_cache->Insert(plan_cache_key, plan_cache_generation, *exec_request_)) {
+    summary_profile->AddInfoString(PLAN_CACHE_KEY, "Miss, stored");
+  }
   return Status::OK();
 }
 
@@ -123,7 +150,7 @@ void QueryDriver::TryQueryRetry(
   const TUniqueId& query_id = client_request_state->query_id();
   DCHECK(client_request_state->schedule() != nullptr);
 
-  if (exec_request_->query_options.retry_failed_queries) {
+  if (exec_request_->query_options.retry_failed_queries || NeedsReplanning(*error)) {
     lock_guard<mutex> l(*client_request_state->lock());
 
     // Queries can only be retried if no rows for the query have been fetched
@@ -237,7 +264,13 @@ void QueryDriver::RetryQueryFromThread(
   }
 
   unique_ptr<ClientRequestState> retry_request_state = nullptr;
-  CreateRetriedClientRequestState(request_state, &retry_request_state, &session);
+  status = CreateRetriedClientRequestState(
+      error, request_state, &retry_request_state, &session);
+  if (!status.ok()) {
+    status.AddDetail(Substitute("Failed to plan retry of query $0", PrintId(query_id)));
+    discard_result(request_state->UpdateQueryStatus(status));
+    return;
+  }
   DCHECK(retry_request_state != nullptr);
 
   const TUniqueId& retry_query_id = retry_request_state->query_id();
@@ -358,16 +391,15 @@ void QueryDriver::RetryQueryFromThread(
   parent_server_->MarkSessionInactive(session);
 }
 
-void QueryDriver::CreateRetriedClientRequestState(ClientRequestState* request_state,
+bool QueryDriver::NeedsReplanning(const Status& error) {
+  return error.code() == TErrorCode::RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED;
+}
+
+Status QueryDriver::CreateRetriedClientRequestState(const Status& error,
+    ClientRequestState* request_state,
     unique_ptr<ClientRequestState>* retry_request_state,
     shared_ptr<ImpalaServer::SessionState>* session) {
-  // Make a copy of the exec_request_ rather than re-using it. The copy is necessary
-  // because the exec_request_ might still be used by the Coordinator even after the
-  // query has been retried. Making a copy avoids any race conditions on the
-  // exec_request_ since the retry_exec_request_ needs to set a new query id on the
-  // TExecRequest object.
-  retry_exec_request_ = make_unique<TExecRequest>(*exec_request_);
-  TQueryCtx query_ctx = retry_exec_request_->query_exec_request.query_ctx;
+  TQueryCtx query_ctx = exec_request_->query_exec_request.query_ctx;
   if (query_ctx.client_request.query_options.spool_all_results_for_retries) {
     // Reset this flag in the retry query since we won't retry again, so results can be
     // returned immediately.
@@ -375,11 +407,36 @@ void QueryDriver::CreateRetriedClientRequestState(ClientRequestState* request_st
     VLOG_QUERY << "Unset SPOOL_ALL_RESULTS_FOR_RETRIES when retrying query "
         << PrintId(client_request_state_->query_id());
   }
+  bool replan = NeedsReplanning(error);
+  if (replan) {
+    // With a broadcast bytes limit of one byte and the shuffle default, the planner
+    // picks a partitioned join for every join that it would choose a broadcast for.
+    // Joins that must be broadcast or have a hint are not affected.
+    TQueryOptions& query_options = query_ctx.client_request.query_options;
+    query_options.__set_broadcast_bytes_limit(1);
+    query_options.__set_default_join_distribution_mode(TJoinDistributionMode::SHUFFLE);
+    query_options.__set_runtime_broadcast_bytes_limit(0);
+    VLOG_QUERY << "Planning retry of query " << PrintId(client_request_state_->query_id())
+        << " with partitioned joins";
+  }
   parent_server_->PrepareQueryContext(&query_ctx);
-  retry_exec_request_->query_exec_request.__set_query_ctx(query_ctx);
 
   ScopedThreadContext tdi_context(GetThreadDebugInfo(), query_ctx.query_id);
 
+  if (replan) {
+    retry_exec_request_ = make_unique<TExecRequest>();
+    RETURN_IF_ERROR(ExecEnv::GetInstance()->frontend()->GetExecRequest(
+        query_ctx, retry_exec_request_.get()));
+  } else {
+    // Make a copy of the exec_request_ rather than re-using it. The copy is necessary
+    // because the exec_request_ might still be used by the Coordinator even after the
+    // query has been retried. Making a copy avoids any race conditions on the
+    // exec_request_ since the retry_exec_request_ needs to set a new query id on the
+    // TExecRequest object.
+    retry_exec_request_ = make_unique<TExecRequest>(*exec_request_);
+    retry_exec_request_->query_exec_request.__set_query_ctx(query_ctx);
+  }
+
   // Create the ClientRequestState for the new query.
   ExecEnv* exec_env = ExecEnv::GetInstance();
   *retry_request_state =
@@ -393,6 +450,7 @@ void QueryDriver::CreateRetriedClientRequestState(ClientRequestState* request_st
     (*retry_request_state)
         ->set_result_metadata((*retry_request_state)->exec_request().result_set_metadata);
   }
+  return Status::OK();
 }
 
 void QueryDriver::HandleRetryFailure(Status* status, string* error_msg,
@@ -146,7 +146,9 @@ class QueryDriver {
   /// specifically, the Frontend#createExecRequest(PlanCtx) method. When creating the
   /// TExecRequest, the Frontend runs the parser, analyzer, authorization code, planner,
   /// optimizer, etc. The TQueryCtx is created by the ImpalaServer and contains the full
-  /// query string (TQueryCtx::TClientRequest::stmt).
+  /// query string (TQueryCtx::TClientRequest::stmt). If the query sets USE_PLAN_CACHE,
+  /// the TExecRequest is taken from the server's PlanCache on a hit, and added to it
+  /// after planning otherwise.
   Status RunFrontendPlanner(const TQueryCtx& query_ctx) WARN_UNUSED_RESULT;
 
   /// Similar to RunFrontendPlanner but takes TExecRequest from and external planner
@@ -166,7 +168,9 @@ class QueryDriver {
   /// query attempt should be run), and (3) the max number of retries has not been
   /// exceeded (currently the limit is just one retry). Queries should only be retried if
   /// there has been a cluster membership change. So either a node is blacklisted or a
-  /// statestore update removes a node from the cluster membership. The retry is done
+  /// statestore update removes a node from the cluster membership. Queries that failed
+  /// with RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED are retried even if query retries are
+  /// disabled, and are planned again with partitioned joins. The retry is done
   /// asynchronously by a dedicated thread. 'error' is the reason why the query failed. If
   /// the attempt to retry the query failed, additional details might be added to the
   /// status. If 'was_retried' is not nullptr it is set to true if the query was actually
@@ -219,11 +223,19 @@ class QueryDriver {
 
   /// Helper method for RetryQueryFromThread. Creates the retry client request state (the
   /// new attempt of the query) based on the original request state. Uses the TExecRequest
-  /// from the original request state to create the retry request state. Creates a new
-  /// query id for the retry request state.
-  void CreateRetriedClientRequestState(ClientRequestState* request_state,
+  /// from the original request state to create the retry request state, unless 'error'
+  /// requires the query to be planned again (see NeedsReplanning()). Creates a new query
+  /// id for the retry request state. Returns an error if planning the query failed.
+  Status CreateRetriedClientRequestState(const Status& error,
+      ClientRequestState* request_state,
       std::unique_ptr<ClientRequestState>* retry_request_state,
-      std::shared_ptr<ImpalaServer::SessionState>* session);
+      std::shared_ptr<ImpalaServer::SessionState>* session) WARN_UNUSED_RESULT;
+
+  /// Returns true if a query that failed with 'error' must be planned again for the
+  /// retry. This is the case if a broadcast join build exceeded the
+  /// RUNTIME_BROADCAST_BYTES_LIMIT: the retry is planned with partitioned joins instead
+  /// of the broadcast joins the planner chose.
+  static bool NeedsReplanning(const Status& error);
 
   /// Helper method for handling failures when retrying a query. 'status' is the reason
   /// why the retry failed and is expected to be in the error state. Additional details
@@ -33,6 +33,8 @@
 #include "gen-cpp/Types_types.h"
 #include "gen-cpp/control_service.pb.h"
 #include "runtime/exec-env.h"
+#include "runtime/fragment-exec-thread-pool.h"
+#include "runtime/fragment-instance-state.h"
 #include "runtime/query-state.h"
 #include "util/container-util.h"
 #include "util/debug-util.h"
@@ -53,6 +55,12 @@ DEFINE_int32(query_exec_mgr_cancellation_thread_pool_size, 1,
     "(Advanced) Size of the QueryExecMgr thread-pool processing cancellations due to "
     "coordinator failure");
 
+DEFINE_int32(fragment_exec_thread_pool_size, 0, "(Advanced) Number of threads that "
+    "are started up front to execute fragment instances. A fragment instance runs on an "
+    "idle thread of this pool if there is one and on a new thread otherwise, so this "
+    "only needs to cover the number of instances that typically run concurrently. 0 "
+    "starts a new thread for every fragment instance.");
+
 const uint32_t QUERY_EXEC_MGR_MAX_CANCELLATION_QUEUE_SIZE = 65536;
 
 QueryExecMgr::QueryExecMgr() {
@@ -65,10 +73,30 @@ QueryExecMgr::QueryExecMgr() {
       QUERY_EXEC_MGR_MAX_CANCELLATION_QUEUE_SIZE,
       bind<void>(&QueryExecMgr::CancelFromThreadPool, this, _2)));
   ABORT_IF_ERROR(cancellation_thread_pool_->Init());
+  if (FLAGS_fragment_exec_thread_pool_size > 0) {
+    finst_thread_pool_.reset(
+        new FragmentExecThreadPool(FragmentInstanceState::FINST_THREAD_GROUP_NAME,
+            FragmentInstanceState::FINST_THREAD_NAME_PREFIX + "-worker",
+            FLAGS_fragment_exec_thread_pool_size));
+    ABORT_IF_ERROR(finst_thread_pool_->Init());
+  }
 }
 
 QueryExecMgr::~QueryExecMgr() {}
 
+Status QueryExecMgr::StartFInstanceThread(
+    const string& thread_name, std::function<void()> fn) {
+  if (finst_thread_pool_ != nullptr && finst_thread_pool_->TryOffer(thread_name, fn)) {
+    ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL->Increment(1);
+    return Status::OK();
+  }
+  unique_ptr<Thread> t;
+  RETURN_IF_ERROR(Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME,
+      thread_name, fn, &t, true));
+  t->Detach();
+  return Status::OK();
+}
+
 Status QueryExecMgr::StartQuery(const ExecQueryFInstancesRequestPB* request,
     const TQueryCtx& query_ctx, const TExecPlanFragmentInfo& fragment_info) {
   TUniqueId query_id = query_ctx.query_id;
@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <string>
+
 #include "common/global-types.h"
 #include "common/status.h"
 #include "util/aligned-new.h"
@@ -26,6 +30,7 @@
 namespace impala {
 
 class ExecQueryFInstancesRequestPB;
+class FragmentExecThreadPool;
 class QueryState;
 class TExecPlanFragmentInfo;
 class TQueryCtx;
@@ -67,6 +72,11 @@ class QueryExecMgr : public CacheLineAligned {
   /// Decrements the refcount for the given QueryState.
   void ReleaseQueryState(QueryState* qs);
 
+  /// Runs 'fn', which executes (part of) a fragment instance, on an idle thread of the
+  /// fragment execution thread pool if there is one, otherwise on a new detached thread
+  /// named 'thread_name'. Returns an error if the thread could not be created.
+  Status StartFInstanceThread(const std::string& thread_name, std::function<void()> fn);
+
   /// Takes a set of backend ids of active backends and cancels all the running
   /// fragments of the queries which are scheduled by failed coordinators (that
   /// is, ids not in the active set).
@@ -98,6 +108,10 @@ class QueryExecMgr : public CacheLineAligned {
   /// Set thread pool size as 1 by default since the tasks are local function calls.
   std::unique_ptr<ThreadPool<QueryCancellationTask>> cancellation_thread_pool_;
 
+  /// Pre-spawned threads to execute fragment instances. Only created if
+  /// --fragment_exec_thread_pool_size is greater than 0.
+  std::unique_ptr<FragmentExecThreadPool> finst_thread_pool_;
+
   /// Gets the existing QueryState or creates a new one if not present.
   /// 'created' is set to true if it was created, false otherwise.
   /// Increments the refcount.
@@ -181,6 +181,20 @@ Status QueryState::Init(const ExecQueryFInstancesRequestPB* exec_rpc_params,
 
   ExecEnv* exec_env = ExecEnv::GetInstance();
 
+  RuntimeProfile* lock_contention_profile =
+      RuntimeProfile::Create(&obj_pool_, "LockContention");
+  host_profile_->AddChild(lock_contention_profile);
+  for (int i = 0; i < LockContention::NUM_LOCK_IDS; ++i) {
+    const char* name =
+        LockContention::ProfileName(static_cast<LockContention::LockId>(i));
+    AtomicInt64* wait_time_ns = &lock_contention_counters_.wait_time_ns[i];
+    lock_contention_profile->AddDerivedCounter(Substitute("$0WaitTime", name),
+        TUnit::TIME_NS, [wait_time_ns]() { return wait_time_ns->Load(); });
+    AtomicInt64* num_waits = &lock_contention_counters_.num_waits[i];
+    lock_contention_profile->AddDerivedCounter(Substitute("$0Waits", name), TUnit::UNIT,
+        [num_waits]() { return num_waits->Load(); });
+  }
+
   RuntimeProfile* jvm_host_profile = RuntimeProfile::Create(&obj_pool_, "JVM");
   host_profile_->AddChild(jvm_host_profile);
 
@@ -385,9 +399,11 @@ Status QueryState::InitFilterBank() {
       for (const TRuntimeFilterDesc& filter : plan_node.runtime_filters) {
         // Add filter if not already present.
         auto it = filters.emplace(filter.filter_id, FilterRegistration(filter)).first;
-        // Currently hash joins are the only filter sources. Otherwise it must be a filter
-        // consumer. 'num_producers' is computed later, so don't update that here.
-        if (!plan_node.__isset.join_node) it->second.has_consumer = true;
+        // Hash joins and top-n nodes are the only filter sources. Otherwise it must be a
+        // filter consumer. 'num_producers' is computed later, so don't update that here.
+        if (!plan_node.__isset.join_node && !plan_node.__isset.sort_node) {
+          it->second.has_consumer = true;
+        }
       }
     }
     if (fragment.output_sink.__isset.join_build_sink) {
@@ -421,7 +437,16 @@ Status QueryState::InitFilterBank() {
     for (const TRuntimeFilterSource& produced_filter : instance_ctx.filters_produced) {
       auto it = filters.find(produced_filter.filter_id);
       DCHECK(it != filters.end());
-      ++it->second.num_producers;
+      FilterRegistration& registration = it->second;
+      ++registration.num_producers;
+      // All instances of the backend have the same intermediate aggregation settings.
+      if (produced_filter.__isset.num_aggregated_updates) {
+        registration.num_aggregated_updates = produced_filter.num_aggregated_updates;
+      }
+      if (produced_filter.__isset.aggregator_krpc_address) {
+        registration.aggregator_krpc_address = produced_filter.aggregator_krpc_address;
+        registration.aggregator_hostname = produced_filter.aggregator_hostname;
+      }
     }
   }
   filter_bank_.reset(
@@ -714,7 +739,7 @@ bool QueryState::ReportExecStatus() {
     const TUniqueId& id = ProtoToQueryId(instance_exec_status.fragment_instance_id());
     FragmentInstanceState* fis = fis_map_[id];
     if (rpc_status.ok()) {
-      fis->ReportSuccessful(instance_exec_status);
+      fis->ReportSuccessful(instance_exec_status, profile_buf != nullptr);
     } else {
       fis->ReportFailed(instance_exec_status);
     }
@@ -849,25 +874,23 @@ bool QueryState::StartFInstances() {
       string thread_name =
           Substitute("$0 (finst:$1)", FragmentInstanceState::FINST_THREAD_NAME_PREFIX,
               PrintId(instance_ctx->fragment_instance_id));
-      unique_ptr<Thread> t;
 
       // Inject thread creation failures through debug actions if enabled.
       Status debug_action_status =
           DebugAction(query_options(), "FIS_FAIL_THREAD_CREATION");
       start_finstances_status = !debug_action_status.ok() ?
           debug_action_status :
-          Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME, thread_name,
-              [this, fis]() { this->ExecFInstance(fis); }, &t, true);
+          ExecEnv::GetInstance()->query_exec_mgr()->StartFInstanceThread(
+              thread_name, [this, fis]() { this->ExecFInstance(fis); });
       if (!start_finstances_status.ok()) {
         fis_map_.erase(fis->instance_id());
-        // Undo refcnt increments done immediately prior to Thread::Create(). The
+        // Undo refcnt increments done immediately prior to starting the thread. The
         // reference counts were both greater than zero before the increments, so
         // neither of these decrements will free any structures.
         ReleaseBackendResourceRefcount();
         ExecEnv::GetInstance()->query_exec_mgr()->ReleaseQueryState(this);
         goto error;
       }
-      t->Detach();
       --num_unstarted_instances;
     }
   }
@@ -942,6 +965,7 @@ void QueryState::ReleaseBackendResourceRefcount() {
 
 void QueryState::ExecFInstance(FragmentInstanceState* fis) {
   ScopedThreadContext debugctx(GetThreadDebugInfo(), fis->query_id(), fis->instance_id());
+  ScopedLockContentionCounters lock_contention(&lock_contention_counters_);
 
   ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT->Increment(1L);
   ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS->Increment(1L);
@@ -992,6 +1016,12 @@ void QueryState::PublishFilter(const PublishFilterParamsPB& params, RpcContext*
   filter_bank_->PublishGlobalFilter(params, context);
 }
 
+void QueryState::UpdateFilterFromRemote(
+    const UpdateFilterParamsPB& params, RpcContext* context) {
+  if (!WaitForPrepare().ok()) return;
+  filter_bank_->UpdateFilterFromRemote(params, context);
+}
+
 Status QueryState::StartSpilling(RuntimeState* runtime_state, MemTracker* mem_tracker) {
   // Return an error message with the root cause of why spilling is disabled.
   if (query_options().scratch_limit == 0) {
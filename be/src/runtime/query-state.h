@@ -33,6 +33,7 @@
 #include "gutil/macros.h"
 #include "gutil/threading/thread_collision_warner.h" // for DFAKE_*
 #include "util/counting-barrier.h"
+#include "util/lock-contention.h"
 #include "util/spinlock.h"
 #include "util/unique-id-hash.h"
 
@@ -54,6 +55,7 @@ class LlvmCodeGen;
 class MemTracker;
 class PlanNode;
 class PublishFilterParamsPB;
+class UpdateFilterParamsPB;
 class ReservationTracker;
 class RuntimeFilterBank;
 class RuntimeProfile;
@@ -152,6 +154,9 @@ class QueryState {
   }
   MemTracker* query_mem_tracker() const { return query_mem_tracker_; }
   RuntimeProfile* host_profile() const { return host_profile_; }
+  LockContentionCounters* lock_contention_counters() {
+    return &lock_contention_counters_;
+  }
   UniqueIdPB GetCoordinatorBackendId() const;
 
   /// The following getters are only valid after Init().
@@ -215,6 +220,12 @@ class QueryState {
   /// Blocks until all fragment instances have finished their Prepare phase.
   void PublishFilter(const PublishFilterParamsPB& params, kudu::rpc::RpcContext* context);
 
+  /// Blocks until all fragment instances have finished their Prepare phase. Merges the
+  /// filter update of another backend for which this backend is the intermediate
+  /// aggregator.
+  void UpdateFilterFromRemote(
+      const UpdateFilterParamsPB& params, kudu::rpc::RpcContext* context);
+
   /// Cancels all actively executing fragment instances. Blocks until all fragment
   /// instances have finished their Prepare phase. Idempotent.
   /// For uninitialized QueryState, just set is_cancelled_ and don't need to cancel
@@ -447,6 +458,10 @@ class QueryState {
   /// Tracks host resource usage of this backend. Owned by 'obj_pool_', created in c'tor.
   RuntimeProfile* const host_profile_;
 
+  /// Contention of the tracked locks of the threads of this query. Threads add to it
+  /// while they are in the scope of a ScopedLockContentionCounters for it.
+  LockContentionCounters lock_contention_counters_;
+
   /// The number of failed intermediate reports since the last successfully sent report.
   int64_t num_failed_reports_ = 0;
 
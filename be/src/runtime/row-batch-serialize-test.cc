@@ -19,8 +19,10 @@
 
 #include "common/init.h"
 #include "testutil/gtest-util.h"
+#include "runtime/bufferpool/buffer-pool.h"
 #include "runtime/collection-value.h"
 #include "runtime/collection-value-builder.h"
+#include "runtime/exec-env.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.h"
 #include "runtime/raw-value.inline.h"
@@ -105,6 +107,40 @@ class RowBatchSerializeTest : public testing::Test {
     EXPECT_OK(TestRowBatchInternal(row_desc, batch, print_batches, full_dedup));
   }
 
+  // Serializes 'batch' into an OutboundRowBatch in the columnar layout with 'codec' and
+  // deserializes it with FromProtobuf(), then checks that the deserialized batch has
+  // the same contents as 'batch'. 'expect_columnar' is whether the columnar layout
+  // applies to 'batch'.
+  void TestColumnarRowBatch(const RowDescriptor& row_desc, RowBatch* batch,
+      CompressionTypePB::type codec, bool expect_columnar) {
+    OutboundRowBatch outbound_batch;
+    ASSERT_OK(batch->Serialize(&outbound_batch, codec, /* columnar */ true));
+    EXPECT_EQ(expect_columnar, outbound_batch.header()->columnar());
+
+    BufferPool* buffer_pool = test_env_->exec_env()->buffer_pool();
+    BufferPool::ClientHandle client;
+    ASSERT_OK(buffer_pool->RegisterClient("RowBatchSerializeTest", nullptr,
+        test_env_->exec_env()->buffer_reservation(), tracker_.get(),
+        numeric_limits<int64_t>::max(), runtime_state_->runtime_profile(), &client));
+    {
+      unique_ptr<RowBatch> deserialized_batch;
+      ASSERT_OK(RowBatch::FromProtobuf(&row_desc, *outbound_batch.header(),
+          outbound_batch.TupleOffsetsAsSlice(), outbound_batch.TupleDataAsSlice(),
+          tracker_.get(), &client, &deserialized_batch));
+      EXPECT_EQ(batch->num_rows(), deserialized_batch->num_rows());
+      for (int row_idx = 0; row_idx < batch->num_rows(); ++row_idx) {
+        TupleRow* row = batch->GetRow(row_idx);
+        TupleRow* deserialized_row = deserialized_batch->GetRow(row_idx);
+        for (int tuple_idx = 0; tuple_idx < row_desc.tuple_descriptors().size();
+             ++tuple_idx) {
+          TestTuplesEqual(*row_desc.tuple_descriptors()[tuple_idx],
+              row->GetTuple(tuple_idx), deserialized_row->GetTuple(tuple_idx));
+        }
+      }
+    }
+    buffer_pool->DeregisterClient(&client);
+  }
+
   // Construct a RowBatch with the specified size by creating a single row with
   // multiple strings, then test whether this RowBatch can be serialized and
   // deserialized successfully. If there is an error during serialization,
@@ -648,6 +684,49 @@ void RowBatchSerializeTest::TestConsecutiveNulls(bool full_dedup) {
   TestRowBatch(row_desc, batch, false, full_dedup);
 }
 
+// Test that the columnar layout round-trips tuples with NULL slots, NULL tuples and
+// adjacent duplicates, with and without compression.
+TEST_F(RowBatchSerializeTest, Columnar) {
+  // tuple: (int, string, string)
+  DescriptorTblBuilder builder(frontend(), &pool_);
+  builder.DeclareTuple() << TYPE_INT << TYPE_STRING << TYPE_STRING;
+  DescriptorTbl* desc_tbl = builder.Build();
+  vector<bool> nullable_tuples(1, true);
+  vector<TTupleId> tuple_id(1, (TTupleId) 0);
+  RowDescriptor row_desc(*desc_tbl, tuple_id, nullable_tuples);
+
+  int num_rows = 1000;
+  int num_distinct_tuples = 200;
+  int repeats = 3;
+  RowBatch* batch = pool_.Add(new RowBatch(&row_desc, num_rows, tracker_.get()));
+  vector<Tuple*> tuples;
+  CreateTuples(*row_desc.tuple_descriptors()[0], batch->tuple_data_pool(),
+      num_distinct_tuples, 10, 10, &tuples);
+  AddTuplesToRowBatch(num_rows, tuples, repeats, batch);
+  for (CompressionTypePB::type codec :
+      {CompressionTypePB::NONE, CompressionTypePB::LZ4, CompressionTypePB::ZSTD}) {
+    TestColumnarRowBatch(row_desc, batch, codec, true);
+  }
+}
+
+// Test that batches that the columnar layout does not apply to fall back to the
+// row-major layout.
+TEST_F(RowBatchSerializeTest, ColumnarFallback) {
+  // tuples: (int), (string)
+  DescriptorTblBuilder builder(frontend(), &pool_);
+  builder.DeclareTuple() << TYPE_INT;
+  builder.DeclareTuple() << TYPE_STRING;
+  DescriptorTbl* desc_tbl = builder.Build();
+  vector<bool> nullable_tuples(2, false);
+  vector<TTupleId> tuple_id;
+  tuple_id.push_back((TTupleId) 0);
+  tuple_id.push_back((TTupleId) 1);
+  RowDescriptor row_desc(*desc_tbl, tuple_id, nullable_tuples);
+
+  RowBatch* batch = CreateRowBatch(row_desc);
+  TestColumnarRowBatch(row_desc, batch, CompressionTypePB::LZ4, false);
+}
+
 TEST_F(RowBatchSerializeTest, ZeroLengthTuples) {
   TestZeroLengthTuple(false);
 }
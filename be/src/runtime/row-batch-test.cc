@@ -21,6 +21,7 @@
 #include "testutil/gtest-util.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/row-batch.h"
+#include "runtime/tuple-row.h"
 #include "service/fe-support.h"
 #include "service/frontend.h"
 #include "testutil/desc-tbl-builder.h"
@@ -70,6 +71,57 @@ TEST(RowBatchTest, AcquireStateWithMarkFlushResources) {
   }
 }
 
+TEST(RowBatchTest, CompactSelection) {
+  ObjectPool pool;
+  DescriptorTblBuilder builder(fe.get(), &pool);
+  builder.DeclareTuple() << TYPE_INT;
+  DescriptorTbl* desc_tbl = builder.Build();
+
+  vector<bool> nullable_tuples = {false};
+  vector<TTupleId> tuple_id = {static_cast<TupleId>(0)};
+  RowDescriptor row_desc(*desc_tbl, tuple_id, nullable_tuples);
+  MemTracker tracker;
+  RowBatch batch(&row_desc, 16, &tracker);
+  // The tuples are never dereferenced, so the row index serves as the tuple pointer.
+  const int num_rows = 8;
+  for (int i = 0; i < num_rows; ++i) {
+    batch.GetRow(batch.AddRow())->SetTuple(0, reinterpret_cast<Tuple*>(i + 1));
+    batch.CommitLastRow();
+  }
+  EXPECT_FALSE(batch.has_selection());
+  EXPECT_EQ(num_rows, batch.num_selected());
+
+  const int selection[] = {0, 1, 4, 7};
+  batch.SetSelection(selection, 4);
+  EXPECT_TRUE(batch.has_selection());
+  EXPECT_EQ(4, batch.num_selected());
+  EXPECT_EQ(4, batch.selected_row_idx(2));
+  EXPECT_EQ(num_rows, batch.num_rows());
+  batch.CompactSelection();
+  EXPECT_FALSE(batch.has_selection());
+  ASSERT_EQ(4, batch.num_rows());
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_EQ(reinterpret_cast<Tuple*>(selection[i] + 1), batch.GetRow(i)->GetTuple(0));
+  }
+
+  // A batch that must be flushed stays at capacity.
+  batch.MarkFlushResources();
+  const int flush_selection[] = {3};
+  batch.SetSelection(flush_selection, 1);
+  batch.CompactSelection();
+  ASSERT_EQ(1, batch.num_rows());
+  EXPECT_TRUE(batch.AtCapacity());
+  EXPECT_EQ(reinterpret_cast<Tuple*>(8), batch.GetRow(0)->GetTuple(0));
+
+  // Reset() drops the selection.
+  batch.Reset();
+  batch.GetRow(batch.AddRow())->SetTuple(0, reinterpret_cast<Tuple*>(1));
+  batch.CommitLastRow();
+  batch.SetSelection(selection, 0);
+  batch.Reset();
+  EXPECT_FALSE(batch.has_selection());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
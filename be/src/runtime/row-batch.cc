@@ -41,6 +41,10 @@ namespace impala {
 const int RowBatch::AT_CAPACITY_MEM_USAGE;
 const int RowBatch::FIXED_LEN_BUFFER_LIMIT;
 
+/// ZSTD compression level for serialized row batches. Batches are compressed on the
+/// critical path of the sender, so this favours speed over ratio.
+static const int ZSTD_CLEVEL = 1;
+
 RowBatch::RowBatch(const RowDescriptor* row_desc, int capacity, MemTracker* mem_tracker)
   : num_rows_(0),
     capacity_(capacity),
@@ -101,7 +105,9 @@ RowBatch::RowBatch(
   DCHECK(tuple_data != nullptr) << "Failed to allocate tuple data";
 
   Deserialize(input_tuple_offsets, input_tuple_data, uncompressed_size,
-      compression_type == THdfsCompression::LZ4, tuple_data);
+      compression_type == THdfsCompression::LZ4 ? CompressionTypePB::LZ4 :
+                                                  CompressionTypePB::NONE,
+      tuple_data);
 }
 
 RowBatch::RowBatch(const RowDescriptor* row_desc, const RowBatchHeaderPB& header,
@@ -123,30 +129,64 @@ RowBatch::RowBatch(const RowDescriptor* row_desc, const RowBatchHeaderPB& header
 
 void RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
     const kudu::Slice& input_tuple_data, int64_t uncompressed_size,
-    bool is_compressed, uint8_t* tuple_data) {
+    CompressionTypePB::type compression_type, uint8_t* tuple_data) {
   DCHECK(tuple_ptrs_ != nullptr);
   DCHECK(tuple_data != nullptr);
-  if (is_compressed) {
+  DecompressTupleData(input_tuple_data, uncompressed_size, compression_type, tuple_data);
+  SetTuplePtrs(input_tuple_offsets, tuple_data);
+
+  // Check whether we have slots that require offset-to-pointer conversion.
+  if (!row_desc_->HasVarlenSlots()) return;
+
+  // For every unique tuple, convert string offsets contained in tuple data into
+  // pointers. Tuples were serialized in the order we are deserializing them in,
+  // so the first occurrence of a tuple will always have a higher offset than any
+  // tuple we already converted.
+  Tuple* last_converted = nullptr;
+  for (int i = 0; i < num_rows_; ++i) {
+    for (int j = 0; j < num_tuples_per_row_; ++j) {
+      const TupleDescriptor* desc = row_desc_->tuple_descriptors()[j];
+      if (!desc->HasVarlenSlots()) continue;
+      Tuple* tuple = GetRow(i)->GetTuple(j);
+      // Handle NULL or already converted tuples with one check.
+      if (tuple <= last_converted) continue;
+      last_converted = tuple;
+      tuple->ConvertOffsetsToPointers(*desc, tuple_data);
+    }
+  }
+}
+
+void RowBatch::DecompressTupleData(const kudu::Slice& input, int64_t uncompressed_size,
+    CompressionTypePB::type compression_type, uint8_t* output) {
+  if (compression_type != CompressionTypePB::NONE) {
     // Decompress tuple data into data pool
-    const uint8_t* compressed_data = input_tuple_data.data();
-    size_t compressed_size = input_tuple_data.size();
+    const uint8_t* compressed_data = input.data();
+    size_t compressed_size = input.size();
 
-    Lz4Decompressor decompressor(nullptr, false);
-    Status status = decompressor.Init();
+    unique_ptr<Codec> decompressor;
+    if (compression_type == CompressionTypePB::ZSTD) {
+      decompressor.reset(new ZstandardDecompressor(nullptr, false));
+    } else {
+      DCHECK_EQ(compression_type, CompressionTypePB::LZ4);
+      decompressor.reset(new Lz4Decompressor(nullptr, false));
+    }
+    Status status = decompressor->Init();
     DCHECK(status.ok()) << status.GetDetail();
     auto compressor_cleanup =
-        MakeScopeExitTrigger([&decompressor]() { decompressor.Close(); });
+        MakeScopeExitTrigger([&decompressor]() { decompressor->Close(); });
 
-    status = decompressor.ProcessBlock(
-        true, compressed_size, compressed_data, &uncompressed_size, &tuple_data);
+    status = decompressor->ProcessBlock(
+        true, compressed_size, compressed_data, &uncompressed_size, &output);
     DCHECK_NE(uncompressed_size, -1) << "RowBatch decompression failed";
     DCHECK(status.ok()) << "RowBatch decompression failed.";
   } else {
     // Tuple data uncompressed, copy directly into data pool
-    DCHECK_EQ(uncompressed_size, input_tuple_data.size());
-    memcpy(tuple_data, input_tuple_data.data(), input_tuple_data.size());
+    DCHECK_EQ(uncompressed_size, input.size());
+    memcpy(output, input.data(), input.size());
   }
+}
 
+void RowBatch::SetTuplePtrs(const kudu::Slice& input_tuple_offsets, uint8_t* tuple_data) {
   // Convert input_batch.tuple_offsets into pointers
   const int32_t* tuple_offsets =
       reinterpret_cast<const int32_t*>(input_tuple_offsets.data());
@@ -160,24 +200,61 @@ void RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
       tuple_ptrs_[tuple_idx] = reinterpret_cast<Tuple*>(tuple_data + offset);
     }
   }
+}
 
-  // Check whether we have slots that require offset-to-pointer conversion.
-  if (!row_desc_->HasVarlenSlots()) return;
-
-  // For every unique tuple, convert string offsets contained in tuple data into
-  // pointers. Tuples were serialized in the order we are deserializing them in,
-  // so the first occurrence of a tuple will always have a higher offset than any
-  // tuple we already converted.
-  Tuple* last_converted = nullptr;
+void RowBatch::DeserializeColumnar(const kudu::Slice& input_tuple_offsets,
+    const uint8_t* columnar_data, uint8_t* tuple_data) {
+  DCHECK(tuple_ptrs_ != nullptr);
+  DCHECK(tuple_data != nullptr);
+  DCHECK_EQ(num_tuples_per_row_, 1);
+  SetTuplePtrs(input_tuple_offsets, tuple_data);
+
+  // The distinct tuples are stored one after the other from the start of 'tuple_data',
+  // so the tuple with the highest offset is the last one.
+  const TupleDescriptor& desc = *row_desc_->tuple_descriptors()[0];
+  const int tuple_size = desc.byte_size();
+  DCHECK_GT(tuple_size, 0);
+  int64_t num_tuples = 0;
   for (int i = 0; i < num_rows_; ++i) {
-    for (int j = 0; j < num_tuples_per_row_; ++j) {
-      const TupleDescriptor* desc = row_desc_->tuple_descriptors()[j];
-      if (!desc->HasVarlenSlots()) continue;
-      Tuple* tuple = GetRow(i)->GetTuple(j);
-      // Handle NULL or already converted tuples with one check.
-      if (tuple <= last_converted) continue;
-      last_converted = tuple;
-      tuple->ConvertOffsetsToPointers(*desc, tuple_data);
+    Tuple* tuple = GetRow(i)->GetTuple(0);
+    if (tuple == nullptr) continue;
+    num_tuples = max<int64_t>(num_tuples,
+        (reinterpret_cast<uint8_t*>(tuple) - tuple_data) / tuple_size + 1);
+  }
+  // Clear the padding between the slots, which the columns do not hold.
+  memset(tuple_data, 0, num_tuples * tuple_size);
+
+  const uint8_t* in = columnar_data;
+  for (int b = 0; b < desc.num_null_bytes(); ++b) {
+    uint8_t* out = tuple_data + desc.null_bytes_offset() + b;
+    for (int64_t i = 0; i < num_tuples; ++i, out += tuple_size) *out = *in++;
+  }
+  // The string data follows the columns of all slots.
+  const uint8_t* in_strings = in;
+  for (const SlotDescriptor* slot : desc.slots()) {
+    in_strings += num_tuples *
+        (slot->type().IsVarLenStringType() ? sizeof(int32_t) : slot->slot_size());
+  }
+  uint8_t* out_strings = tuple_data + num_tuples * tuple_size;
+  for (const SlotDescriptor* slot : desc.slots()) {
+    uint8_t* out = tuple_data + slot->tuple_offset();
+    if (slot->type().IsVarLenStringType()) {
+      for (int64_t i = 0; i < num_tuples; ++i, out += tuple_size) {
+        int32_t len;
+        memcpy(&len, in, sizeof(len));
+        in += sizeof(len);
+        memcpy(out_strings, in_strings, len);
+        *reinterpret_cast<StringValue*>(out) =
+            StringValue(reinterpret_cast<char*>(out_strings), len);
+        in_strings += len;
+        out_strings += len;
+      }
+    } else {
+      const int slot_size = slot->slot_size();
+      for (int64_t i = 0; i < num_tuples; ++i, out += tuple_size) {
+        memcpy(out, in, slot_size);
+        in += slot_size;
+      }
     }
   }
 }
@@ -207,10 +284,31 @@ Status RowBatch::FromProtobuf(const RowDescriptor* row_desc,
   row_batch->capacity_ = header.num_rows();
   const CompressionTypePB& compression_type = header.compression_type();
   DCHECK(compression_type == CompressionTypePB::NONE ||
-      compression_type == CompressionTypePB::LZ4)
+      compression_type == CompressionTypePB::LZ4 ||
+      compression_type == CompressionTypePB::ZSTD)
       << "Unexpected compression type: " << compression_type;
-  row_batch->Deserialize(input_tuple_offsets, input_tuple_data, uncompressed_size,
-      compression_type == CompressionTypePB::LZ4, tuple_data);
+  if (header.columnar()) {
+    // Decompress the columns into a temporary buffer and rebuild the tuples from there.
+    const uint8_t* columnar_data = input_tuple_data.data();
+    BufferPool::BufferHandle columnar_buffer;
+    if (compression_type != CompressionTypePB::NONE) {
+      RETURN_IF_ERROR(row_batch->AllocateBuffer(
+          client, header.columnar_size(), &columnar_buffer));
+      DecompressTupleData(input_tuple_data, header.columnar_size(), compression_type,
+          columnar_buffer.data());
+      columnar_data = columnar_buffer.data();
+    } else {
+      DCHECK_EQ(header.columnar_size(), input_tuple_data.size());
+    }
+    row_batch->DeserializeColumnar(input_tuple_offsets, columnar_data, tuple_data);
+    if (columnar_buffer.is_open()) {
+      ExecEnv::GetInstance()->buffer_pool()->FreeBuffer(client, &columnar_buffer);
+    }
+  } else {
+    row_batch->Deserialize(
+        input_tuple_offsets, input_tuple_data, uncompressed_size, compression_type,
+        tuple_data);
+  }
   *row_batch_ptr = std::move(row_batch);
   return Status::OK();
 }
@@ -234,30 +332,45 @@ Status RowBatch::Serialize(TRowBatch* output_batch) {
 }
 
 Status RowBatch::Serialize(TRowBatch* output_batch, bool full_dedup) {
+  if (has_selection()) CompactSelection();
   // why does Thrift not generate a Clear() function?
   output_batch->row_tuples.clear();
   output_batch->tuple_offsets.clear();
   int64_t uncompressed_size;
-  bool is_compressed;
-  RETURN_IF_ERROR(Serialize(full_dedup, &output_batch->tuple_offsets,
-      &output_batch->tuple_data, &uncompressed_size, &is_compressed));
+  CompressionTypePB::type compression_type;
+  RETURN_IF_ERROR(Serialize(full_dedup, CompressionTypePB::LZ4,
+      &output_batch->tuple_offsets, &output_batch->tuple_data, &uncompressed_size,
+      &compression_type));
   // TODO: max_size() is much larger than the amount of memory we could feasibly
   // allocate. Need better way to detect problem.
   DCHECK_LE(uncompressed_size, output_batch->tuple_data.max_size());
   output_batch->__set_num_rows(num_rows_);
   output_batch->__set_uncompressed_size(uncompressed_size);
   output_batch->__set_compression_type(
-      is_compressed ? THdfsCompression::LZ4 : THdfsCompression::NONE);
+      compression_type == CompressionTypePB::LZ4 ? THdfsCompression::LZ4 :
+                                                   THdfsCompression::NONE);
   row_desc_->ToThrift(&output_batch->row_tuples);
   return Status::OK();
 }
 
-Status RowBatch::Serialize(OutboundRowBatch* output_batch) {
+Status RowBatch::Serialize(
+    OutboundRowBatch* output_batch, CompressionTypePB::type codec, bool columnar) {
+  if (has_selection()) CompactSelection();
   int64_t uncompressed_size;
-  bool is_compressed;
+  CompressionTypePB::type compression_type;
   output_batch->tuple_offsets_.clear();
-  RETURN_IF_ERROR(Serialize(UseFullDedup(), &output_batch->tuple_offsets_,
-      &output_batch->tuple_data_, &uncompressed_size, &is_compressed));
+  columnar = columnar && CanSerializeColumnar();
+  int64_t columnar_size = 0;
+  if (columnar) {
+    RETURN_IF_ERROR(SerializeColumnar(&output_batch->tuple_offsets_,
+        &output_batch->tuple_data_, &uncompressed_size));
+    columnar_size = output_batch->tuple_data_.size();
+    RETURN_IF_ERROR(
+        CompressTupleData(codec, &output_batch->tuple_data_, &compression_type));
+  } else {
+    RETURN_IF_ERROR(Serialize(UseFullDedup(), codec, &output_batch->tuple_offsets_,
+        &output_batch->tuple_data_, &uncompressed_size, &compression_type));
+  }
 
   // Initialize the RowBatchHeaderPB
   RowBatchHeaderPB* header = &output_batch->header_;
@@ -265,13 +378,17 @@ Status RowBatch::Serialize(OutboundRowBatch* output_batch) {
   header->set_num_rows(num_rows_);
   header->set_num_tuples_per_row(row_desc_->tuple_descriptors().size());
   header->set_uncompressed_size(uncompressed_size);
-  header->set_compression_type(
-      is_compressed ? CompressionTypePB::LZ4 : CompressionTypePB::NONE);
+  header->set_compression_type(compression_type);
+  if (columnar) {
+    header->set_columnar(true);
+    header->set_columnar_size(columnar_size);
+  }
   return Status::OK();
 }
 
-Status RowBatch::Serialize(bool full_dedup, vector<int32_t>* tuple_offsets,
-    string* tuple_data, int64_t* uncompressed_size, bool* is_compressed) {
+Status RowBatch::Serialize(bool full_dedup, CompressionTypePB::type codec,
+    vector<int32_t>* tuple_offsets, string* tuple_data, int64_t* uncompressed_size,
+    CompressionTypePB::type* compression_type) {
   // As part of the serialization process we deduplicate tuples to avoid serializing a
   // Tuple multiple times for the RowBatch. By default we only detect duplicate tuples
   // in adjacent rows only. If full deduplication is enabled, we will build a
@@ -290,18 +407,28 @@ Status RowBatch::Serialize(bool full_dedup, vector<int32_t>* tuple_offsets,
     RETURN_IF_ERROR(SerializeInternal(size, nullptr, tuple_offsets, tuple_data));
   }
   *uncompressed_size = size;
-  *is_compressed = false;
+  return CompressTupleData(codec, tuple_data, compression_type);
+}
 
-  if (size > 0) {
-    // Try compressing tuple_data to compression_scratch_, swap if compressed data is
-    // smaller
-    Lz4Compressor compressor(nullptr, false);
-    RETURN_IF_ERROR(compressor.Init());
+Status RowBatch::CompressTupleData(CompressionTypePB::type codec, string* data,
+    CompressionTypePB::type* compression_type) {
+  const int64_t size = data->size();
+  *compression_type = CompressionTypePB::NONE;
+  if (size > 0 && codec != CompressionTypePB::NONE) {
+    // Try compressing data to compression_scratch_, swap if compressed data is smaller
+    unique_ptr<Codec> compressor;
+    if (codec == CompressionTypePB::ZSTD) {
+      compressor.reset(new ZstandardCompressor(nullptr, false, ZSTD_CLEVEL));
+    } else {
+      DCHECK_EQ(codec, CompressionTypePB::LZ4);
+      compressor.reset(new Lz4Compressor(nullptr, false));
+    }
+    RETURN_IF_ERROR(compressor->Init());
     auto compressor_cleanup =
-        MakeScopeExitTrigger([&compressor]() { compressor.Close(); });
+        MakeScopeExitTrigger([&compressor]() { compressor->Close(); });
 
     // If the input size is too large for LZ4 to compress, MaxOutputLen() will return 0.
-    int64_t compressed_size = compressor.MaxOutputLen(size);
+    int64_t compressed_size = compressor->MaxOutputLen(size);
     if (compressed_size == 0) {
       return Status(TErrorCode::LZ4_COMPRESSION_INPUT_TOO_LARGE, size);
     }
@@ -310,21 +437,115 @@ Status RowBatch::Serialize(bool full_dedup, vector<int32_t>* tuple_offsets,
       compression_scratch_.resize(compressed_size);
     }
     uint8_t* input =
-        const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(tuple_data->c_str()));
+        const_cast<uint8_t*>(reinterpret_cast<const uint8_t*>(data->c_str()));
     uint8_t* compressed_output = const_cast<uint8_t*>(
         reinterpret_cast<const uint8_t*>(compression_scratch_.c_str()));
-    RETURN_IF_ERROR(
-        compressor.ProcessBlock(true, size, input, &compressed_size, &compressed_output));
+    RETURN_IF_ERROR(compressor->ProcessBlock(
+        true, size, input, &compressed_size, &compressed_output));
     if (LIKELY(compressed_size < size)) {
       compression_scratch_.resize(compressed_size);
-      tuple_data->swap(compression_scratch_);
-      *is_compressed = true;
+      data->swap(compression_scratch_);
+      *compression_type = codec;
     }
     VLOG_ROW << "uncompressed size: " << size << ", compressed size: " << compressed_size;
   }
   return Status::OK();
 }
 
+bool RowBatch::CanSerializeColumnar() const {
+  if (num_tuples_per_row_ != 1) return false;
+  const TupleDescriptor* desc = row_desc_->tuple_descriptors()[0];
+  return desc->byte_size() > 0 && desc->collection_slots().empty();
+}
+
+Status RowBatch::SerializeColumnar(vector<int32_t>* tuple_offsets,
+    string* columnar_data, int64_t* uncompressed_size) {
+  DCHECK(CanSerializeColumnar());
+  const TupleDescriptor& desc = *row_desc_->tuple_descriptors()[0];
+  const int tuple_size = desc.byte_size();
+  // NULL tuples and tuples that repeat the tuple of the previous row are not written
+  // again, as in SerializeInternal().
+  auto is_distinct = [this](int row_idx) {
+    Tuple* tuple = GetRow(row_idx)->GetTuple(0);
+    return tuple != nullptr
+        && (row_idx == 0 || GetRow(row_idx - 1)->GetTuple(0) != tuple);
+  };
+  int64_t num_tuples = 0;
+  int64_t string_bytes = 0;
+  for (int i = 0; i < num_rows_; ++i) {
+    if (!is_distinct(i)) continue;
+    ++num_tuples;
+    Tuple* tuple = GetRow(i)->GetTuple(0);
+    for (const SlotDescriptor* slot : desc.string_slots()) {
+      if (tuple->IsNull(slot->null_indicator_offset())) continue;
+      string_bytes += tuple->GetStringSlot(slot->tuple_offset())->len;
+    }
+  }
+  // The tuple offsets are int32s, as for the row-major layout.
+  const int64_t size = num_tuples * tuple_size + string_bytes;
+  if (size > numeric_limits<int32_t>::max()) {
+    return Status(TErrorCode::ROW_BATCH_TOO_LARGE, size, numeric_limits<int32_t>::max());
+  }
+  *uncompressed_size = size;
+
+  tuple_offsets->reserve(num_rows_);
+  int32_t next_offset = 0;
+  for (int i = 0; i < num_rows_; ++i) {
+    if (GetRow(i)->GetTuple(0) == nullptr) {
+      tuple_offsets->push_back(-1);
+    } else if (!is_distinct(i)) {
+      tuple_offsets->push_back(tuple_offsets->back());
+    } else {
+      tuple_offsets->push_back(next_offset);
+      next_offset += tuple_size;
+    }
+  }
+
+  int64_t columnar_size = num_tuples * desc.num_null_bytes() + string_bytes;
+  for (const SlotDescriptor* slot : desc.slots()) {
+    columnar_size += num_tuples *
+        (slot->type().IsVarLenStringType() ? sizeof(int32_t) : slot->slot_size());
+  }
+  columnar_data->resize(columnar_size);
+  uint8_t* out = reinterpret_cast<uint8_t*>(const_cast<char*>(columnar_data->data()));
+  for (int b = 0; b < desc.num_null_bytes(); ++b) {
+    const int byte_offset = desc.null_bytes_offset() + b;
+    for (int i = 0; i < num_rows_; ++i) {
+      if (!is_distinct(i)) continue;
+      *out++ = reinterpret_cast<uint8_t*>(GetRow(i)->GetTuple(0))[byte_offset];
+    }
+  }
+  for (const SlotDescriptor* slot : desc.slots()) {
+    const bool is_string = slot->type().IsVarLenStringType();
+    const int slot_size = slot->slot_size();
+    for (int i = 0; i < num_rows_; ++i) {
+      if (!is_distinct(i)) continue;
+      Tuple* tuple = GetRow(i)->GetTuple(0);
+      if (is_string) {
+        int32_t len = tuple->IsNull(slot->null_indicator_offset()) ?
+            0 : tuple->GetStringSlot(slot->tuple_offset())->len;
+        memcpy(out, &len, sizeof(len));
+        out += sizeof(len);
+      } else {
+        memcpy(out, tuple->GetSlot(slot->tuple_offset()), slot_size);
+        out += slot_size;
+      }
+    }
+  }
+  for (const SlotDescriptor* slot : desc.string_slots()) {
+    for (int i = 0; i < num_rows_; ++i) {
+      if (!is_distinct(i)) continue;
+      Tuple* tuple = GetRow(i)->GetTuple(0);
+      if (tuple->IsNull(slot->null_indicator_offset())) continue;
+      const StringValue* string_val = tuple->GetStringSlot(slot->tuple_offset());
+      memcpy(out, string_val->ptr, string_val->len);
+      out += string_val->len;
+    }
+  }
+  DCHECK_EQ(out - reinterpret_cast<const uint8_t*>(columnar_data->data()), columnar_size);
+  return Status::OK();
+}
+
 bool RowBatch::UseFullDedup() {
   // Switch to using full deduplication in cases where severe size blow-ups are known to
   // be common: when a row contains tuples with collections and where there are three or
@@ -429,8 +650,26 @@ void RowBatch::FreeBuffers() {
   buffers_.clear();
 }
 
+void RowBatch::CompactSelection() {
+  DCHECK(has_selection());
+  for (int i = 0; i < num_selected_; ++i) {
+    const int row_idx = selection_[i];
+    DCHECK_GE(row_idx, i);
+    DCHECK_LT(row_idx, num_rows_);
+    DCHECK(i == 0 || row_idx > selection_[i - 1]);
+    if (row_idx != i) CopyRow(GetRow(row_idx), GetRow(i));
+  }
+  num_rows_ = num_selected_;
+  // Keep the invariant that batches that must be flushed are at capacity.
+  if (flush_mode_ == FlushMode::FLUSH_RESOURCES) capacity_ = num_rows_;
+  selection_ = nullptr;
+  num_selected_ = 0;
+}
+
 void RowBatch::Reset() {
   num_rows_ = 0;
+  selection_ = nullptr;
+  num_selected_ = 0;
   capacity_ = tuple_ptrs_size_ / (num_tuples_per_row_ * sizeof(Tuple*));
   tuple_data_pool_.FreeAll();
   FreeBuffers();
@@ -493,6 +732,7 @@ void RowBatch::AcquireState(RowBatch* src) {
   DCHECK_EQ(tuple_ptrs_size_, src->tuple_ptrs_size_);
 
   // The destination row batch should be empty.
+  DCHECK(!src->has_selection());
   DCHECK(!needs_deep_copy_);
   DCHECK_EQ(num_rows_, 0);
   DCHECK_EQ(attached_buffer_bytes_, 0);
@@ -506,6 +746,7 @@ void RowBatch::AcquireState(RowBatch* src) {
 }
 
 void RowBatch::DeepCopyTo(RowBatch* dst) {
+  DCHECK(!has_selection());
   DCHECK(dst->row_desc_->Equals(*row_desc_));
   DCHECK_EQ(dst->num_rows_, 0);
   DCHECK_GE(dst->capacity_, num_rows_);
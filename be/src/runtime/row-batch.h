@@ -68,6 +68,14 @@ class OutboundRowBatch {
         tuple_data_.length());
   }
 
+  /// Frees the buffers of the serialized tuple offsets and data. The batch must be
+  /// serialized again before it is sent.
+  void FreeBuffers() {
+    header_.Clear();
+    vector<int32_t>().swap(tuple_offsets_);
+    std::string().swap(tuple_data_);
+  }
+
   /// Returns true if the header has been intialized and ready to be sent.
   /// This entails setting some fields initialized in RowBatch::Serialize().
   bool IsInitialized() const {
@@ -170,6 +178,7 @@ class RowBatch {
   /// CommitRows() call between them have the same effect as a single call.
   int ALWAYS_INLINE AddRows(int n) {
     DCHECK_LE(num_rows_ + n, capacity_);
+    DCHECK(!has_selection());
     return num_rows_;
   }
 
@@ -346,6 +355,40 @@ class RowBatch {
         num_rows * num_tuples_per_row_ * sizeof(Tuple*));
   }
 
+  /// Sets the selection vector of the batch to the 'num_selected' ascending row indices
+  /// in 'selection'. Only the selected rows are active. This lets a filter drop rows
+  /// without copying the remaining ones into another batch, and further filters can be
+  /// evaluated over the selected rows only. 'selection' is not owned and must stay valid
+  /// until CompactSelection() or Reset() is called. Batches with a selection must not
+  /// be returned from GetNext() or have rows added to them. Serialize() compacts the
+  /// selection first.
+  void SetSelection(const int* selection, int num_selected) {
+    DCHECK(selection != nullptr);
+    DCHECK_GE(num_selected, 0);
+    DCHECK_LE(num_selected, num_rows_);
+    selection_ = selection;
+    num_selected_ = num_selected;
+  }
+
+  bool has_selection() const { return selection_ != nullptr; }
+
+  /// The number of active rows: the number of selected rows if the batch has a
+  /// selection, otherwise all rows.
+  int num_selected() const { return has_selection() ? num_selected_ : num_rows_; }
+
+  /// Returns the index of the i-th active row.
+  int selected_row_idx(int i) const {
+    DCHECK_GE(i, 0);
+    DCHECK_LT(i, num_selected());
+    return has_selection() ? selection_[i] : i;
+  }
+
+  /// Moves the selected rows to the front of the batch in place and removes the
+  /// selection, making the batch dense again. Rows that are selected and already at
+  /// their position are not copied, so selecting all rows costs nothing. A batch marked
+  /// with MarkFlushResources() stays at capacity.
+  void CompactSelection();
+
   void ClearTuplePointers() {
     memset(tuple_ptrs_, 0, capacity_ * num_tuples_per_row_ * sizeof(Tuple*));
   }
@@ -371,11 +414,15 @@ class RowBatch {
   /// Create a serialized version of this row batch in output_batch, attaching all of the
   /// data it references to output_batch.tuple_data. This function attempts to detect
   /// duplicate tuples in the row batch to reduce the serialized size.
-  /// output_batch.tuple_data will be LZ4-compressed unless the compressed data is larger
-  /// larger than the uncompressed data. Use output_batch.compression_type to determine
-  /// whether tuple_data is compressed. If an in-flight row is present in this row batch,
-  /// it is ignored. This function does not Reset().
-  Status Serialize(OutboundRowBatch* output_batch);
+  /// output_batch.tuple_data will be compressed with 'codec' (NONE, LZ4 or ZSTD) unless
+  /// the compressed data is larger than the uncompressed data. Use
+  /// output_batch.compression_type to determine whether tuple_data is compressed. If an
+  /// in-flight row is present in this row batch, it is ignored. This function does not
+  /// Reset(). The TRowBatch version always uses LZ4.
+  /// If 'columnar' is true and CanSerializeColumnar() holds, the tuples are written in
+  /// the columnar layout of SerializeColumnar() instead, which usually compresses better.
+  Status Serialize(OutboundRowBatch* output_batch,
+      CompressionTypePB::type codec = CompressionTypePB::LZ4, bool columnar = false);
   Status Serialize(TRowBatch* output_batch);
 
   /// Utility function: returns total byte size of a batch in either serialized or
@@ -452,6 +499,10 @@ class RowBatch {
   /// Free all BufferInfo and the associated buffers in 'buffers_'.
   void FreeBuffers();
 
+  /// Returns true if this batch can be serialized in the columnar layout: it has a single
+  /// non-empty tuple per row without collection slots.
+  bool CanSerializeColumnar() const;
+
   /// Decide whether to do full tuple deduplication based on row composition. Full
   /// deduplication is enabled only when there is risk of the serialized size being
   /// much larger than in-memory size due to non-adjacent duplicate tuples.
@@ -463,18 +514,21 @@ class RowBatch {
   /// Shared implementation between thrift and protobuf to serialize this row batch.
   ///
   /// 'full_dedup': true if full deduplication is used.
+  /// 'codec': the codec to compress 'tuple_data' with, or NONE to not compress it.
   /// 'tuple_offsets': Updated to contain offsets of all tuples into 'tuple_data' upon
   ///                  return. There are a total of num_rows * num_tuples_per_row offsets.
   ///                  An offset of -1 records a NULL.
-  /// 'tuple_data': Updated to hold the serialized tuples' data. If 'is_compressed'
-  ///               is true, this is LZ4 compressed.
+  /// 'tuple_data': Updated to hold the serialized tuples' data, compressed with
+  ///               'compression_type'.
   /// 'uncompressed_size': Updated with the uncompressed size of 'tuple_data'.
-  /// 'is_compressed': true if compression is applied on 'tuple_data'.
+  /// 'compression_type': 'codec' if compression is applied on 'tuple_data', NONE if
+  ///                     not, e.g. because it did not make the data smaller.
   ///
   /// Returns error status if serialization failed. Returns OK otherwise.
   /// TODO: clean this up once the thrift RPC implementation is removed.
-  Status Serialize(bool full_dedup, vector<int32_t>* tuple_offsets, string* tuple_data,
-      int64_t* uncompressed_size, bool* is_compressed);
+  Status Serialize(bool full_dedup, CompressionTypePB::type codec,
+      vector<int32_t>* tuple_offsets, string* tuple_data, int64_t* uncompressed_size,
+      CompressionTypePB::type* compression_type);
 
   /// Shared implementation between thrift and protobuf to deserialize a row batch.
   ///
@@ -482,18 +536,53 @@ class RowBatch {
   /// Used for populating the tuples in the row batch with actual pointers.
   ///
   /// 'input_tuple_data': contains pointer and size of tuples' data buffer.
-  /// If 'is_compressed' is true, the data is compressed.
+  /// The data is compressed unless 'compression_type' is NONE.
   ///
   /// 'uncompressed_size': the uncompressed size of 'input_tuple_data' if it's compressed.
   ///
-  /// 'is_compressed': True if 'input_tuple_data' is compressed.
+  /// 'compression_type': the codec that 'input_tuple_data' is compressed with.
   ///
   /// 'tuple_data': buffer of 'uncompressed_size' bytes for holding tuple data.
   ///
   /// TODO: clean this up once the thrift RPC implementation is removed.
   void Deserialize(const kudu::Slice& input_tuple_offsets,
-      const kudu::Slice& input_tuple_data, int64_t uncompressed_size, bool is_compressed,
-      uint8_t* tuple_data);
+      const kudu::Slice& input_tuple_data, int64_t uncompressed_size,
+      CompressionTypePB::type compression_type, uint8_t* tuple_data);
+
+  /// Serializes the tuples of this batch column by column into 'columnar_data'. Only
+  /// the adjacent duplicates of tuples are removed. The layout for the T distinct
+  /// tuples of the batch is:
+  ///   - for each null indicator byte of the tuple, the T values of that byte,
+  ///   - for each slot in slot order, the T values of the slot. For var-len string slots
+  ///     these are the int32_t lengths of the strings, 0 if a string is NULL,
+  ///   - the data of the non-NULL strings, in the order of the length columns.
+  /// 'tuple_offsets' is set to the offsets of the tuples in the tuple data that
+  /// DeserializeColumnar() rebuilds, where the distinct tuples are stored one after the
+  /// other, followed by the string data. 'uncompressed_size' is set to the size of that
+  /// tuple data. Does not compress 'columnar_data'.
+  Status SerializeColumnar(vector<int32_t>* tuple_offsets, string* columnar_data,
+      int64_t* uncompressed_size);
+
+  /// Rebuilds the tuples of a batch serialized by SerializeColumnar() into
+  /// 'tuple_data', which must hold the 'uncompressed_size' bytes of the header.
+  /// 'columnar_data' is the uncompressed output of SerializeColumnar(). Sets the tuple
+  /// pointers from 'input_tuple_offsets' as Deserialize() does.
+  void DeserializeColumnar(const kudu::Slice& input_tuple_offsets,
+      const uint8_t* columnar_data, uint8_t* tuple_data);
+
+  /// Compresses 'data' with 'codec' if that makes it smaller. Sets 'compression_type'
+  /// to 'codec' if 'data' was replaced by its compressed version and to NONE otherwise.
+  Status CompressTupleData(CompressionTypePB::type codec, string* data,
+      CompressionTypePB::type* compression_type);
+
+  /// Decompresses 'input', compressed with 'compression_type', into the
+  /// 'uncompressed_size' bytes at 'output'. Copies 'input' if it is not compressed.
+  static void DecompressTupleData(const kudu::Slice& input, int64_t uncompressed_size,
+      CompressionTypePB::type compression_type, uint8_t* output);
+
+  /// Sets the tuple pointers of the batch to the tuples at 'input_tuple_offsets' in
+  /// 'tuple_data'. An offset of -1 sets a NULL tuple.
+  void SetTuplePtrs(const kudu::Slice& input_tuple_offsets, uint8_t* tuple_data);
 
   typedef FixedSizeHashTable<Tuple*, int> DedupMap;
 
@@ -537,6 +626,11 @@ class RowBatch {
   const int tuple_ptrs_size_;
   Tuple** tuple_ptrs_ = nullptr;
 
+  /// The selection vector set by SetSelection(), or nullptr if all rows are active.
+  /// Not owned.
+  const int* selection_ = nullptr;
+  int num_selected_ = 0;
+
   /// Total bytes of BufferPool buffers attached to this batch.
   int64_t attached_buffer_bytes_;
 
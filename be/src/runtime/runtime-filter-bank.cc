@@ -40,6 +40,7 @@
 #include "util/bit-util.h"
 #include "util/bloom-filter.h"
 #include "util/debug-util.h"
+#include "util/in-list-filter.h"
 #include "util/min-max-filter.h"
 #include "util/pretty-printer.h"
 #include "util/uid-util.h"
@@ -56,6 +57,32 @@ DEFINE_double(max_filter_error_rate, 0.75, "(Advanced) The target false positive
     "probability used to determine the ideal size for each bloom filter size. This value "
     "can be overriden by the RUNTIME_FILTER_ERROR_RATE query option.");
 
+namespace {
+
+/// Sets 'protobuf' to the representation of 'filter' without its directory, which is
+/// returned in 'directory' if the filter is neither always true nor always false.
+void BloomFilterToProtobuf(
+    BloomFilter* filter, BloomFilterPB* protobuf, kudu::Slice* directory) {
+  if (filter == BloomFilter::ALWAYS_TRUE_FILTER) {
+    protobuf->set_always_true(true);
+    return;
+  }
+  protobuf->set_log_bufferpool_space(filter->GetBlockBloomFilter()->log_space_bytes());
+  if (filter->AlwaysFalse()) {
+    protobuf->set_always_false(true);
+  } else {
+    *directory = filter->GetBlockBloomFilter()->directory();
+  }
+}
+
+/// Returns true if 'update' lets all rows pass.
+bool IsAlwaysTrue(const UpdateFilterParamsPB& update) {
+  return update.bloom_filter().always_true() || update.min_max_filter().always_true()
+      || update.in_list_filter().always_true();
+}
+
+} // anonymous namespace
+
 const int64_t RuntimeFilterBank::MIN_BLOOM_FILTER_SIZE;
 const int64_t RuntimeFilterBank::MAX_BLOOM_FILTER_SIZE;
 
@@ -89,8 +116,8 @@ RuntimeFilterBank::BuildFilterMap(
       result_filter =
           obj_pool->Add(new RuntimeFilter(reg.desc, reg.desc.filter_size_bytes));
     }
-    result.emplace(entry.first,
-        make_unique<PerFilterState>(reg.num_producers, result_filter, consumed_filter));
+    result.emplace(
+        entry.first, make_unique<PerFilterState>(reg, result_filter, consumed_filter));
   }
   return result;
 }
@@ -157,8 +184,9 @@ void RuntimeFilterBank::UpdateFilterCompleteCb(
   krpcs_done_cv_.notify_one();
 }
 
-void RuntimeFilterBank::UpdateFilterFromLocal(
-    int32_t filter_id, BloomFilter* bloom_filter, MinMaxFilter* min_max_filter) {
+void RuntimeFilterBank::UpdateFilterFromLocal(int32_t filter_id,
+    BloomFilter* bloom_filter, MinMaxFilter* min_max_filter,
+    InListFilter* in_list_filter) {
   DCHECK_NE(query_state_->query_options().runtime_filter_mode, TRuntimeFilterMode::OFF)
       << "Should not be calling UpdateFilterFromLocal() if filtering is disabled";
   // This function is only called from ExecNode::Open() or more specifically
@@ -187,7 +215,7 @@ void RuntimeFilterBank::UpdateFilterFromLocal(
         return;
       }
       VLOG(3) << "Setting broadcast filter " << filter_id;
-      result_filter->SetFilter(bloom_filter, min_max_filter);
+      result_filter->SetFilter(bloom_filter, min_max_filter, in_list_filter);
       complete_filter = result_filter;
     } else {
       // Merge partitioned join filters in parallel - each thread setting the filter will
@@ -195,7 +223,7 @@ void RuntimeFilterBank::UpdateFilterFromLocal(
       // it has produced the final filter or it runs out of other filters to merge.
       unique_ptr<RuntimeFilter> tmp_filter = make_unique<RuntimeFilter>(
           result_filter->filter_desc(), result_filter->filter_size());
-      tmp_filter->SetFilter(bloom_filter, min_max_filter);
+      tmp_filter->SetFilter(bloom_filter, min_max_filter, in_list_filter);
       while (produced_filter.pending_merge_filter != nullptr) {
         unique_ptr<RuntimeFilter> pending_merge =
             std::move(produced_filter.pending_merge_filter);
@@ -254,46 +282,213 @@ void RuntimeFilterBank::UpdateFilterFromLocal(
 
   if (complete_filter != nullptr && has_remote_target &&
       query_state_->query_options().runtime_filter_mode == TRuntimeFilterMode::GLOBAL) {
+    const ProducedFilter& produced_filter = fs->produced_filter;
+    bool is_aggregator = produced_filter.num_aggregated_updates > 0;
     UpdateFilterParamsPB params;
-    // The memory associated with the following 2 objects needs to live until
-    // the asynchronous KRPC call proxy->UpdateFilterAsync() is completed.
-    // Hence, we allocate these 2 objects in 'obj_pool_'.
-    UpdateFilterResultPB* res = obj_pool_.Add(new UpdateFilterResultPB);
-    RpcController* controller = obj_pool_.Add(new RpcController);
-
-    TUniqueIdToUniqueIdPB(query_state_->query_id(), params.mutable_query_id());
-    params.set_filter_id(filter_id);
+    // The memory associated with 'controller' needs to live until the asynchronous KRPC
+    // call proxy->UpdateFilterAsync() is completed. Hence, it is allocated in
+    // 'obj_pool_'. An aggregator sends its update later with the aggregated one.
+    RpcController* controller =
+        is_aggregator ? nullptr : obj_pool_.Add(new RpcController);
+    kudu::Slice bloom_directory;
     TRuntimeFilterType::type type = complete_filter->filter_desc().type;
     if (type == TRuntimeFilterType::BLOOM) {
-      BloomFilter::ToProtobuf(bloom_filter, controller, params.mutable_bloom_filter());
-    } else {
-      DCHECK_EQ(type, TRuntimeFilterType::MIN_MAX);
+      if (is_aggregator) {
+        // The directory is merged into the aggregated update instead of being sent.
+        BloomFilterToProtobuf(
+            bloom_filter, params.mutable_bloom_filter(), &bloom_directory);
+      } else {
+        BloomFilter::ToProtobuf(bloom_filter, controller, params.mutable_bloom_filter());
+      }
+    } else if (type == TRuntimeFilterType::MIN_MAX) {
       min_max_filter->ToProtobuf(params.mutable_min_max_filter());
+    } else {
+      DCHECK_EQ(type, TRuntimeFilterType::IN_LIST);
+      if (in_list_filter == nullptr) {
+        params.mutable_in_list_filter()->set_always_true(true);
+      } else {
+        in_list_filter->ToProtobuf(params.mutable_in_list_filter());
+      }
     }
-    const TNetworkAddress& krpc_address = query_state_->query_ctx().coord_ip_address;
-    const std::string& hostname = query_state_->query_ctx().coord_hostname;
-
-    // Use 'proxy' to send the filter to the coordinator.
-    unique_ptr<DataStreamServiceProxy> proxy;
-    Status get_proxy_status = DataStreamService::GetProxy(krpc_address, hostname, &proxy);
-    if (!get_proxy_status.ok()) {
-      // Failing to send a filter is not a query-wide error - the remote fragment will
-      // continue regardless.
-      LOG(INFO) << Substitute("Failed to get proxy to coordinator $0: $1", hostname,
-          get_proxy_status.msg().msg());
+
+    if (is_aggregator) {
+      bool send_aggregated_update;
+      {
+        lock_guard<SpinLock> l(fs->lock);
+        if (closed_) return;
+        MergeAggregatedUpdate(params, bloom_directory, fs);
+        fs->produced_filter.local_update_merged = true;
+        send_aggregated_update = TakeCompleteAggregatedUpdate(fs);
+      }
+      if (send_aggregated_update) SendAggregatedUpdate(filter_id, fs);
       return;
     }
-    // Increment 'num_inflight_rpcs_' to make sure that the filter will not be deallocated
-    // in Close() until all in-flight RPCs complete.
-    {
-      unique_lock<SpinLock> l(num_inflight_rpcs_lock_);
-      DCHECK_GE(num_inflight_rpcs_, 0);
-      ++num_inflight_rpcs_;
+
+    TUniqueIdToUniqueIdPB(query_state_->query_id(), params.mutable_query_id());
+    params.set_filter_id(filter_id);
+    if (!produced_filter.aggregator_hostname.empty()) {
+      params.set_to_aggregator(true);
+      SendFilterUpdate(params, controller, produced_filter.aggregator_krpc_address,
+          produced_filter.aggregator_hostname);
+    } else {
+      SendFilterUpdate(params, controller, query_state_->query_ctx().coord_ip_address,
+          query_state_->query_ctx().coord_hostname);
     }
+  }
+}
 
-    proxy->UpdateFilterAsync(params, res, controller,
-        boost::bind(&RuntimeFilterBank::UpdateFilterCompleteCb, this, controller, res));
+void RuntimeFilterBank::UpdateFilterFromRemote(
+    const UpdateFilterParamsPB& params, RpcContext* context) {
+  VLOG(3) << "UpdateFilterFromRemote(filter_id=" << params.filter_id() << ")";
+  auto it = filters_.find(params.filter_id());
+  DCHECK(it != filters_.end()) << "Filter ID " << params.filter_id() << " not registered";
+  PerFilterState* fs = it->second.get();
+  const UpdateFilterParamsPB* update = &params;
+  UpdateFilterParamsPB always_true_update;
+  kudu::Slice bloom_directory;
+  if (params.has_bloom_filter() && params.bloom_filter().has_directory_sidecar_idx()) {
+    kudu::Status status = context->GetInboundSidecar(
+        params.bloom_filter().directory_sidecar_idx(), &bloom_directory);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to get Bloom filter sidecar: " << status.message().ToString();
+      // Without this update the aggregated filter would be incorrect, so it has to let
+      // all rows pass.
+      always_true_update.mutable_bloom_filter()->set_always_true(true);
+      update = &always_true_update;
+    }
+  }
+  bool send_aggregated_update;
+  {
+    lock_guard<SpinLock> l(fs->lock);
+    if (closed_) return;
+    ProducedFilter& produced_filter = fs->produced_filter;
+    DCHECK_GT(produced_filter.pending_aggregated_updates, 0)
+        << "Unexpected update of filter " << params.filter_id();
+    --produced_filter.pending_aggregated_updates;
+    MergeAggregatedUpdate(*update, bloom_directory, fs);
+    send_aggregated_update = TakeCompleteAggregatedUpdate(fs);
   }
+  if (send_aggregated_update) SendAggregatedUpdate(params.filter_id(), fs);
+}
+
+void RuntimeFilterBank::MergeAggregatedUpdate(const UpdateFilterParamsPB& update,
+    const kudu::Slice& bloom_directory, PerFilterState* fs) {
+  ProducedFilter* produced_filter = &fs->produced_filter;
+  // The aggregated update was already sent because it was always true.
+  if (produced_filter->aggregated_update_sent) return;
+  bool first_update = !produced_filter->has_aggregated_update;
+  produced_filter->has_aggregated_update = true;
+  UpdateFilterParamsPB* aggregated = &produced_filter->aggregated_update;
+  if (update.has_bloom_filter()) {
+    const BloomFilterPB& in = update.bloom_filter();
+    BloomFilterPB* out = aggregated->mutable_bloom_filter();
+    string* out_directory = &produced_filter->aggregated_bloom_directory;
+    if (out->always_true()) return;
+    if (in.always_true()) {
+      out->Clear();
+      out->set_always_true(true);
+      filter_mem_tracker_->Release(out_directory->size());
+      string().swap(*out_directory);
+    } else if (in.always_false()) {
+      if (first_update) *out = in;
+    } else if (first_update || out->always_false()) {
+      if (!filter_mem_tracker_->TryConsume(bloom_directory.size())) {
+        VLOG_QUERY << "Not enough memory to aggregate filter: "
+                   << PrettyPrinter::Print(bloom_directory.size(), TUnit::BYTES)
+                   << " (query_id=" << PrintId(query_state_->query_id()) << ")";
+        out->Clear();
+        out->set_always_true(true);
+      } else {
+        *out = in;
+        out->clear_directory_sidecar_idx();
+        out_directory->assign(reinterpret_cast<const char*>(bloom_directory.data()),
+            bloom_directory.size());
+      }
+    } else {
+      DCHECK_EQ(out_directory->size(), bloom_directory.size());
+      BloomFilter::Or(in, bloom_directory.data(), out,
+          reinterpret_cast<uint8_t*>(&(*out_directory)[0]), bloom_directory.size());
+    }
+  } else if (update.has_min_max_filter()) {
+    const MinMaxFilterPB& in = update.min_max_filter();
+    MinMaxFilterPB* out = aggregated->mutable_min_max_filter();
+    if (out->always_true()) return;
+    if (in.always_true()) {
+      out->Clear();
+      out->set_always_true(true);
+    } else if (first_update || (out->always_false() && !in.always_false())) {
+      MinMaxFilter::Copy(in, out);
+    } else if (!in.always_false()) {
+      MinMaxFilter::Or(in, out, produced_filter->result_filter->type());
+    }
+  } else {
+    DCHECK(update.has_in_list_filter());
+    InListFilterPB* out = aggregated->mutable_in_list_filter();
+    if (first_update) {
+      InListFilter::Copy(update.in_list_filter(), out);
+    } else {
+      InListFilter::Or(update.in_list_filter(), out,
+          query_state_->query_options().runtime_in_list_filter_entry_limit);
+    }
+  }
+}
+
+bool RuntimeFilterBank::TakeCompleteAggregatedUpdate(PerFilterState* fs) {
+  ProducedFilter* produced_filter = &fs->produced_filter;
+  if (produced_filter->aggregated_update_sent) return false;
+  // An always true update does not change anymore, so it is sent right away.
+  if (!IsAlwaysTrue(produced_filter->aggregated_update)
+      && (!produced_filter->local_update_merged
+          || produced_filter->pending_aggregated_updates > 0)) {
+    return false;
+  }
+  produced_filter->aggregated_update_sent = true;
+  return true;
+}
+
+void RuntimeFilterBank::SendAggregatedUpdate(int32_t filter_id, PerFilterState* fs) {
+  // 'aggregated_update' is not modified after it was marked as sent, so the lock is not
+  // needed to read it.
+  const ProducedFilter& produced_filter = fs->produced_filter;
+  UpdateFilterParamsPB params = produced_filter.aggregated_update;
+  RpcController* controller = obj_pool_.Add(new RpcController);
+  TUniqueIdToUniqueIdPB(query_state_->query_id(), params.mutable_query_id());
+  params.set_filter_id(filter_id);
+  if (params.has_bloom_filter() && !params.bloom_filter().always_true()
+      && !params.bloom_filter().always_false()) {
+    BloomFilter::AddDirectorySidecar(params.mutable_bloom_filter(), controller,
+        produced_filter.aggregated_bloom_directory);
+  }
+  VLOG(3) << "Sending aggregated update of filter " << filter_id;
+  SendFilterUpdate(params, controller, query_state_->query_ctx().coord_ip_address,
+      query_state_->query_ctx().coord_hostname);
+}
+
+void RuntimeFilterBank::SendFilterUpdate(const UpdateFilterParamsPB& params,
+    RpcController* controller, const TNetworkAddress& krpc_address,
+    const string& hostname) {
+  // The memory associated with 'res' needs to live until the asynchronous KRPC call
+  // proxy->UpdateFilterAsync() is completed. Hence, it is allocated in 'obj_pool_'.
+  UpdateFilterResultPB* res = obj_pool_.Add(new UpdateFilterResultPB);
+  unique_ptr<DataStreamServiceProxy> proxy;
+  Status get_proxy_status = DataStreamService::GetProxy(krpc_address, hostname, &proxy);
+  if (!get_proxy_status.ok()) {
+    // Failing to send a filter is not a query-wide error - the remote fragment will
+    // continue regardless.
+    LOG(INFO) << Substitute("Failed to get proxy to $0: $1", hostname,
+        get_proxy_status.msg().msg());
+    return;
+  }
+  // Increment 'num_inflight_rpcs_' to make sure that the filter will not be deallocated
+  // in Close() until all in-flight RPCs complete.
+  {
+    unique_lock<SpinLock> l(num_inflight_rpcs_lock_);
+    DCHECK_GE(num_inflight_rpcs_, 0);
+    ++num_inflight_rpcs_;
+  }
+
+  proxy->UpdateFilterAsync(params, res, controller,
+      boost::bind(&RuntimeFilterBank::UpdateFilterCompleteCb, this, controller, res));
 }
 
 void RuntimeFilterBank::PublishGlobalFilter(
@@ -315,6 +510,7 @@ void RuntimeFilterBank::PublishGlobalFilter(
   }
   BloomFilter* bloom_filter = nullptr;
   MinMaxFilter* min_max_filter = nullptr;
+  InListFilter* in_list_filter = nullptr;
   if (fs->consumed_filter->is_bloom_filter()) {
     DCHECK(params.has_bloom_filter());
     if (params.bloom_filter().always_true()) {
@@ -354,14 +550,19 @@ void RuntimeFilterBank::PublishGlobalFilter(
         }
       }
     }
-  } else {
-    DCHECK(fs->consumed_filter->is_min_max_filter());
+  } else if (fs->consumed_filter->is_min_max_filter()) {
     DCHECK(params.has_min_max_filter());
     min_max_filter = MinMaxFilter::Create(params.min_max_filter(),
         fs->consumed_filter->type(), &obj_pool_, filter_mem_tracker_);
     fs->min_max_filters.push_back(min_max_filter);
+  } else {
+    DCHECK(fs->consumed_filter->is_in_list_filter());
+    DCHECK(params.has_in_list_filter());
+    in_list_filter = InListFilter::Create(params.in_list_filter(),
+        fs->consumed_filter->type(),
+        query_state_->query_options().runtime_in_list_filter_entry_limit, &obj_pool_);
   }
-  fs->consumed_filter->SetFilter(bloom_filter, min_max_filter);
+  fs->consumed_filter->SetFilter(bloom_filter, min_max_filter, in_list_filter);
   query_state_->host_profile()->AddInfoString(
       Substitute("Filter $0 arrival", params.filter_id()),
       PrettyPrinter::Print(fs->consumed_filter->arrival_delay_ms(), TUnit::TIME_MS));
@@ -407,6 +608,16 @@ MinMaxFilter* RuntimeFilterBank::AllocateScratchMinMaxFilter(
   return min_max_filter;
 }
 
+InListFilter* RuntimeFilterBank::AllocateScratchInListFilter(
+    int32_t filter_id, ColumnType type, int entry_limit) {
+  auto it = filters_.find(filter_id);
+  DCHECK(it != filters_.end()) << "Filter ID " << filter_id << " not registered";
+  PerFilterState* fs = it->second.get();
+  lock_guard<SpinLock> l(fs->lock);
+  if (closed_) return nullptr;
+  return InListFilter::Create(type, entry_limit, &obj_pool_);
+}
+
 vector<unique_lock<SpinLock>> RuntimeFilterBank::LockAllFilters() {
   vector<unique_lock<SpinLock>> locks;
   for (auto& entry : filters_) locks.emplace_back(entry.second->lock);
@@ -449,6 +660,10 @@ void RuntimeFilterBank::Close() {
   for (auto& entry : filters_) {
     for (BloomFilter* filter : entry.second->bloom_filters) filter->Close();
     for (MinMaxFilter* filter : entry.second->min_max_filters) filter->Close();
+    string* aggregated_bloom_directory =
+        &entry.second->produced_filter.aggregated_bloom_directory;
+    filter_mem_tracker_->Release(aggregated_bloom_directory->size());
+    string().swap(*aggregated_bloom_directory);
   }
   obj_pool_.Clear();
   if (buffer_pool_client_.is_registered()) {
@@ -463,9 +678,14 @@ void RuntimeFilterBank::Close() {
 }
 
 RuntimeFilterBank::ProducedFilter::ProducedFilter(
-    int pending_producers, RuntimeFilter* result_filter)
-  : result_filter(result_filter), pending_producers(pending_producers) {}
-
-RuntimeFilterBank::PerFilterState::PerFilterState(
-    int pending_producers, RuntimeFilter* result_filter, RuntimeFilter* consumed_filter)
-  : produced_filter(pending_producers, result_filter), consumed_filter(consumed_filter) {}
+    const FilterRegistration& registration, RuntimeFilter* result_filter)
+  : result_filter(result_filter),
+    pending_producers(registration.num_producers),
+    aggregator_krpc_address(registration.aggregator_krpc_address),
+    aggregator_hostname(registration.aggregator_hostname),
+    num_aggregated_updates(registration.num_aggregated_updates),
+    pending_aggregated_updates(registration.num_aggregated_updates) {}
+
+RuntimeFilterBank::PerFilterState::PerFilterState(const FilterRegistration& registration,
+    RuntimeFilter* result_filter, RuntimeFilter* consumed_filter)
+  : produced_filter(registration, result_filter), consumed_filter(consumed_filter) {}
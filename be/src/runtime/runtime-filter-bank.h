@@ -23,6 +23,7 @@
 
 #include "codegen/impala-ir.h"
 #include "common/object-pool.h"
+#include "gen-cpp/Types_types.h"
 #include "gen-cpp/data_stream_service.pb.h"
 #include "gutil/port.h"
 #include "runtime/bufferpool/buffer-pool.h"
@@ -35,6 +36,7 @@
 #include <boost/scoped_ptr.hpp>
 
 namespace kudu {
+class Slice;
 namespace rpc {
 class RpcContext;
 class RpcController;
@@ -44,6 +46,7 @@ class RpcController;
 namespace impala {
 
 class BloomFilter;
+class InListFilter;
 class MemTracker;
 class MinMaxFilter;
 class RuntimeFilter;
@@ -64,6 +67,15 @@ struct FilterRegistration {
 
   // The number of producers of this filter executing on the backend.
   int num_producers = 0;
+
+  // The number of other backends whose updates of the filter this backend merges as an
+  // intermediate aggregator. See TRuntimeFilterSource.
+  int num_aggregated_updates = 0;
+
+  // The intermediate aggregator to send the update of the filter to instead of the
+  // coordinator. Unset if 'aggregator_hostname' is empty.
+  TNetworkAddress aggregator_krpc_address;
+  std::string aggregator_hostname;
 };
 
 /// RuntimeFilters are produced and consumed by plan nodes at run time to propagate
@@ -73,8 +85,8 @@ struct FilterRegistration {
 ///
 /// All producers and consumers of filters must register via RegisterProducer() and
 /// RegisterConsumer(). Local plan fragments update the filters by calling
-/// UpdateFilterFromLocal(), with either a bloom filter or a min-max filter, depending
-/// on the filter's type. The 'bloom_filter' or 'min_max_filter' that is passed into
+/// UpdateFilterFromLocal(), with either a bloom filter, a min-max filter or an in-list
+/// filter, depending on the filter's type. The filter that is passed into
 /// UpdateFilterFromLocal() must have been allocated by AllocateScratch*Filter(); this
 /// allows RuntimeFilterBank to manage all memory associated with filters.
 ///
@@ -83,11 +95,18 @@ struct FilterRegistration {
 /// called. The expected number of filters to be produced locally must be specified ahead
 /// of time so that RuntimeFilterBank knows when the filter is complete.
 ///
+/// The coordinator may pick a backend as the intermediate aggregator of a partitioned
+/// join filter for a group of backends. The other backends of the group send their
+/// locally aggregated filter to it instead of the coordinator. The aggregator merges
+/// these updates, which arrive through UpdateFilterFromRemote(), with its own filter and
+/// sends a single update for the group to the coordinator.
+///
 /// After PublishGlobalFilter() has been called (at most once per filter_id), the
-/// RuntimeFilter object associated with filter_id will have a valid bloom_filter or
-/// min_max_filter, and may be used for filter evaluation. This operation occurs
-/// without synchronisation, and neither the thread that calls PublishGlobalFilter()
-/// nor the thread that may call RuntimeFilter::Eval() need to coordinate in any way.
+/// RuntimeFilter object associated with filter_id will have a valid bloom_filter,
+/// min_max_filter or in_list_filter, and may be used for filter evaluation. This
+/// operation occurs without synchronisation, and neither the thread that calls
+/// PublishGlobalFilter() nor the thread that may call RuntimeFilter::Eval() need to
+/// coordinate in any way.
 class RuntimeFilterBank {
  public:
   /// 'filters': contains an entry for every filter produced or consumed on this backend.
@@ -118,12 +137,19 @@ class RuntimeFilterBank {
   /// to check for the filter's arrival.
   RuntimeFilter* RegisterConsumer(const TRuntimeFilterDesc& filter_desc);
 
-  /// Updates a filter's 'bloom_filter' or 'min_max_filter' which has been produced by
-  /// some operator in a local fragment instance. At most one of 'bloom_filter' and
-  /// 'min_max_filter' may be non-NULL, depending on the filter's type. They may both be
-  /// NULL, representing a filter that allows all rows to pass.
-  void UpdateFilterFromLocal(
-      int32_t filter_id, BloomFilter* bloom_filter, MinMaxFilter* min_max_filter);
+  /// Updates a filter's 'bloom_filter', 'min_max_filter' or 'in_list_filter' which has
+  /// been produced by some operator in a local fragment instance. At most one of them
+  /// may be non-NULL, depending on the filter's type. They may all be NULL, representing
+  /// a filter that allows all rows to pass.
+  void UpdateFilterFromLocal(int32_t filter_id, BloomFilter* bloom_filter,
+      MinMaxFilter* min_max_filter, InListFilter* in_list_filter);
+
+  /// Merges the update of a filter from another backend for which this backend is the
+  /// intermediate aggregator. Sends the aggregated update to the coordinator once this
+  /// backend's producers and all the other backends of its group have updated the
+  /// filter.
+  void UpdateFilterFromRemote(
+      const UpdateFilterParamsPB& params, kudu::rpc::RpcContext* context);
 
   /// Makes a bloom_filter (aggregated globally from all producer fragments) available for
   /// consumption by operators that wish to use it for filtering.
@@ -142,6 +168,11 @@ class RuntimeFilterBank {
   /// Returns a new MinMaxFilter. Handles memory the same as AllocateScratchBloomFilter().
   MinMaxFilter* AllocateScratchMinMaxFilter(int32_t filter_id, ColumnType type);
 
+  /// Returns a new InListFilter that holds at most 'entry_limit' values. Handles memory
+  /// the same as AllocateScratchBloomFilter().
+  InListFilter* AllocateScratchInListFilter(
+      int32_t filter_id, ColumnType type, int entry_limit);
+
   /// Default hash seed to use when computing hashed values to insert into filters.
   static int32_t IR_ALWAYS_INLINE DefaultHashSeed() { return 1234; }
 
@@ -168,9 +199,30 @@ class RuntimeFilterBank {
   /// Implementation of Cancel(). All filter locks must be held by caller.
   void CancelLocked();
 
+  /// Merges 'update' into the aggregated update of 'fs', whose lock must be held by the
+  /// caller. 'bloom_directory' is the directory of the bloom filter of 'update', if it is
+  /// neither always true nor always false.
+  void MergeAggregatedUpdate(const UpdateFilterParamsPB& update,
+      const kudu::Slice& bloom_directory, PerFilterState* fs);
+
+  /// Returns true if the aggregated update of 'fs' is complete and was not sent yet, and
+  /// marks it as sent. Sending it is up to the caller. The lock of 'fs' must be held by
+  /// the caller.
+  bool TakeCompleteAggregatedUpdate(PerFilterState* fs);
+
+  /// Sends the aggregated update of 'fs' to the coordinator.
+  void SendAggregatedUpdate(int32_t filter_id, PerFilterState* fs);
+
+  /// Sends 'params' asynchronously to the backend at 'krpc_address'. 'controller' is
+  /// used for the RPC and holds the directory sidecar of a bloom filter in 'params'. It
+  /// must be owned by 'obj_pool_'.
+  void SendFilterUpdate(const UpdateFilterParamsPB& params,
+      kudu::rpc::RpcController* controller, const TNetworkAddress& krpc_address,
+      const std::string& hostname);
+
   /// Data tracked for each produced filter in the filter bank.
   struct ProducedFilter {
-    ProducedFilter(int pending_producers, RuntimeFilter* result_filter);
+    ProducedFilter(const FilterRegistration& registration, RuntimeFilter* result_filter);
 
     /// The initial filter returned from RegisterProducer() metadata about the filter.
     /// Not modified by producers. Owned by 'obj_pool_'.
@@ -184,6 +236,32 @@ class RuntimeFilterBank {
     // UpdateFilterFromLocal() for details on the algorithm for merging.
     // Only used for partitioned join filters.
     std::unique_ptr<RuntimeFilter> pending_merge_filter;
+
+    // The intermediate aggregator to send the filter to instead of the coordinator, if
+    // 'aggregator_hostname' is not empty.
+    const TNetworkAddress aggregator_krpc_address;
+    const std::string aggregator_hostname;
+
+    // The number of other backends whose updates this backend merges as the
+    // intermediate aggregator of the filter. 0 if this backend is not an aggregator.
+    const int num_aggregated_updates;
+
+    // The number of updates from other backends that are yet to arrive.
+    int pending_aggregated_updates;
+
+    // The merged updates of this backend and the other backends if this backend is an
+    // intermediate aggregator. Merged the same way as in the coordinator. The directory
+    // of a bloom filter is stored in 'aggregated_bloom_directory', whose memory is
+    // tracked by 'filter_mem_tracker_'.
+    bool has_aggregated_update = false;
+    UpdateFilterParamsPB aggregated_update;
+    std::string aggregated_bloom_directory;
+
+    // True once this backend's own filter was merged into 'aggregated_update'.
+    bool local_update_merged = false;
+
+    // True once 'aggregated_update' was sent to the coordinator.
+    bool aggregated_update_sent = false;
   };
 
   /// All state tracked for a particular filter in this filter bank. PerFilterStates are
@@ -191,12 +269,13 @@ class RuntimeFilterBank {
   /// separately to help with scalability. Aligned so that each lock is on a separate
   /// cache line.
   struct PerFilterState {
-    /// pending_producers: the number of producers that will call UpdateFilterFromLocal().
+    /// registration: the producers and intermediate aggregation of the filter on this
+    ///   backend.
     /// result_filter: the initial filter that will be returned to producers. Non-NULL if
     ///   there are any producers. Must be owned by 'obj_pool_'.
     /// consumed_filter: the filter that will be returned to consumers. Non-NULL if there
     ///   are any consumers. Must be owned by 'obj_pool_'.
-    PerFilterState(int pending_producers, RuntimeFilter* result_filter,
+    PerFilterState(const FilterRegistration& registration, RuntimeFilter* result_filter,
         RuntimeFilter* consumed_filter);
 
     /// Lock protecting the structures in this PerFilterState. If multiple locks are
@@ -16,6 +16,7 @@
 // under the License.
 
 #include "runtime/runtime-filter.h"
+#include "util/in-list-filter.h"
 #include "util/min-max-filter.h"
 
 using namespace impala;
@@ -27,6 +28,9 @@ bool IR_ALWAYS_INLINE RuntimeFilter::Eval(
     uint32_t h = RawValue::GetHashValueFastHash32(
         val, col_type, RuntimeFilterBank::DefaultHashSeed());
     return bloom_filter_.Load()->Find(h);
+  } else if (is_in_list_filter()) {
+    InListFilter* filter = get_in_list_filter();
+    if (LIKELY(filter)) return filter->Find(val);
   } else {
     DCHECK(is_min_max_filter());
     // Min/max overlap does not deal with nulls (val==nullptr).
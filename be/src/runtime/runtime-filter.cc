@@ -24,18 +24,23 @@
 using namespace impala;
 
 const char* RuntimeFilter::LLVM_CLASS_NAME = "class.impala::RuntimeFilter";
+constexpr int RuntimeFilter::EVAL_BATCH_SIZE;
 
-void RuntimeFilter::SetFilter(BloomFilter* bloom_filter, MinMaxFilter* min_max_filter) {
+void RuntimeFilter::SetFilter(BloomFilter* bloom_filter, MinMaxFilter* min_max_filter,
+    InListFilter* in_list_filter) {
   {
     unique_lock<mutex> l(arrival_mutex_);
     DCHECK(!HasFilter()) << "SetFilter() should not be called multiple times.";
-    DCHECK(bloom_filter_.Load() == nullptr && min_max_filter_.Load() == nullptr);
+    DCHECK(bloom_filter_.Load() == nullptr && min_max_filter_.Load() == nullptr
+        && in_list_filter_.Load() == nullptr);
     if (arrival_time_.Load() != 0) return; // The filter may already have been cancelled.
     if (is_bloom_filter()) {
       bloom_filter_.Store(bloom_filter);
-    } else {
-      DCHECK(is_min_max_filter());
+    } else if (is_min_max_filter()) {
       min_max_filter_.Store(min_max_filter);
+    } else {
+      DCHECK(is_in_list_filter());
+      in_list_filter_.Store(in_list_filter);
     }
     arrival_time_.Store(MonotonicMillis());
     has_filter_.Store(true);
@@ -46,7 +51,24 @@ void RuntimeFilter::SetFilter(BloomFilter* bloom_filter, MinMaxFilter* min_max_f
 void RuntimeFilter::SetFilter(RuntimeFilter* other) {
   DCHECK_EQ(id(), other->id());
   SetFilter(is_bloom_filter() ? other->bloom_filter_.Load() : nullptr,
-      is_min_max_filter() ? other->min_max_filter_.Load() : nullptr);
+      is_min_max_filter() ? other->min_max_filter_.Load() : nullptr,
+      is_in_list_filter() ? other->in_list_filter_.Load() : nullptr);
+}
+
+void RuntimeFilter::EvalBatch(void* const* vals, int num_values,
+    const ColumnType& col_type, bool* passed) const noexcept {
+  DCHECK_LE(num_values, EVAL_BATCH_SIZE);
+  const BloomFilter* bloom_filter = is_bloom_filter() ? bloom_filter_.Load() : nullptr;
+  if (bloom_filter == BloomFilter::ALWAYS_TRUE_FILTER) {
+    for (int i = 0; i < num_values; ++i) passed[i] = Eval(vals[i], col_type);
+    return;
+  }
+  uint32_t hashes[EVAL_BATCH_SIZE];
+  for (int i = 0; i < num_values; ++i) {
+    hashes[i] = RawValue::GetHashValueFastHash32(
+        vals[i], col_type, RuntimeFilterBank::DefaultHashSeed());
+  }
+  bloom_filter->FindBatch(hashes, num_values, passed);
 }
 
 void RuntimeFilter::Or(RuntimeFilter* other) {
@@ -60,9 +82,17 @@ void RuntimeFilter::Or(RuntimeFilter* other) {
     } else {
       bloom_filter_.Load()->Or(*bloom_filter);
     }
-  } else {
-    DCHECK(is_min_max_filter());
+  } else if (is_min_max_filter()) {
     min_max_filter_.Load()->Or(*other->get_min_max());
+  } else {
+    DCHECK(is_in_list_filter());
+    DCHECK(in_list_filter_.Load() != nullptr);
+    InListFilter* in_list_filter = other->in_list_filter_.Load();
+    if (in_list_filter == nullptr) {
+      in_list_filter_.Load()->SetAlwaysTrue();
+    } else {
+      in_list_filter_.Load()->Or(*in_list_filter);
+    }
   }
 }
 
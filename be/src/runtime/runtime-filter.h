@@ -28,6 +28,7 @@
 namespace impala {
 
 class BloomFilter;
+class InListFilter;
 class RuntimeFilterTest;
 
 /// RuntimeFilters represent set-membership predicates that are computed during query
@@ -39,15 +40,15 @@ class RuntimeFilterTest;
 /// early on in the plan tree (e.g. the scan that feeds the probe side of that join node
 /// could eliminate rows from consideration for join matching).
 ///
-/// A RuntimeFilter may compute its set-membership predicate as a bloom filters or a
-/// min-max filter, depending on its filter description.
+/// A RuntimeFilter may compute its set-membership predicate as a bloom filters, a
+/// min-max filter or an in-list filter, depending on its filter description.
 class RuntimeFilter {
  public:
   RuntimeFilter(const TRuntimeFilterDesc& filter, int64_t filter_size)
-      : bloom_filter_(nullptr), min_max_filter_(nullptr), filter_desc_(filter),
-        registration_time_(MonotonicMillis()), arrival_time_(0L),
+      : bloom_filter_(nullptr), min_max_filter_(nullptr), in_list_filter_(nullptr),
+        filter_desc_(filter), registration_time_(MonotonicMillis()), arrival_time_(0L),
         filter_size_(filter_size) {
-    DCHECK(filter_desc_.type == TRuntimeFilterType::MIN_MAX || filter_size_ > 0);
+    DCHECK(filter_desc_.type != TRuntimeFilterType::BLOOM || filter_size_ > 0);
   }
 
   /// Returns true if SetFilter() has been called.
@@ -63,23 +64,29 @@ class RuntimeFilter {
   bool is_min_max_filter() const {
     return filter_desc().type == TRuntimeFilterType::MIN_MAX;
   }
+  bool is_in_list_filter() const {
+    return filter_desc().type == TRuntimeFilterType::IN_LIST;
+  }
 
   BloomFilter* get_bloom_filter() const { return bloom_filter_.Load(); }
   MinMaxFilter* get_min_max() const { return min_max_filter_.Load(); }
+  InListFilter* get_in_list_filter() const { return in_list_filter_.Load(); }
 
-  /// Sets the internal filter bloom_filter to 'bloom_filter' or 'min_max_filter'
+  /// Sets the internal filter to 'bloom_filter', 'min_max_filter' or 'in_list_filter'
   /// depending on the type of this RuntimeFilter. Can only legally be called
   /// once per filter. Does not acquire the memory associated with 'bloom_filter'.
-  void SetFilter(BloomFilter* bloom_filter, MinMaxFilter* min_max_filter);
+  void SetFilter(BloomFilter* bloom_filter, MinMaxFilter* min_max_filter,
+      InListFilter* in_list_filter);
 
-  /// Set the internal bloom or min-max filter to the equivalent filter from 'other'.
+  /// Set the internal bloom, min-max or in-list filter to the equivalent filter from
+  /// 'other'.
   /// The parameters of 'other' must be compatible and the filters must have the same
   /// ID. Can only legally be called once per filter. Does not acquire the memory from
   /// the other filter.
   void SetFilter(RuntimeFilter* other);
 
-  /// Merge 'bloom_filter' or 'min_max_filter' into this filter. The caller must provide
-  /// the appropriate kind of filter for this RuntimeFilter instance.
+  /// Merge the bloom, min-max or in-list filter of 'other' into this filter. The caller
+  /// must provide the appropriate kind of filter for this RuntimeFilter instance.
   /// Not thread-safe.
   void Or(RuntimeFilter* other);
 
@@ -94,6 +101,15 @@ class RuntimeFilter {
   /// Inlined in IR so that the constant 'col_type' can be propagated.
   bool IR_ALWAYS_INLINE Eval(void* val, const ColumnType& col_type) const noexcept;
 
+  /// Maximum number of values that EvalBatch() evaluates at a time.
+  static constexpr int EVAL_BATCH_SIZE = 256;
+
+  /// Evaluates the filter against the 'num_values' <= EVAL_BATCH_SIZE values in 'vals'
+  /// and sets passed[i] to Eval(vals[i], col_type). Bloom filters probe all values with
+  /// one call to BloomFilter::FindBatch(), which is faster than probing them one by one.
+  void EvalBatch(void* const* vals, int num_values, const ColumnType& col_type,
+      bool* passed) const noexcept;
+
   /// Returns the amount of time in milliseconds elapsed between the registration of the
   /// filter and its arrival. If the filter has not yet arrived, it returns the time
   /// elapsed since registration.
@@ -130,6 +146,10 @@ class RuntimeFilter {
   /// May be NULL even after arrival_time_ is set if filter_desc_.min_max_filter is false.
   AtomicPtr<MinMaxFilter> min_max_filter_;
 
+  /// May be NULL even after arrival_time_ is set, meaning that it does not filter any
+  /// rows.
+  AtomicPtr<InListFilter> in_list_filter_;
+
   /// Reference to the filter's thrift descriptor in the thrift Plan tree.
   const TRuntimeFilterDesc& filter_desc_;
 
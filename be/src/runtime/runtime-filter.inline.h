@@ -23,6 +23,7 @@
 
 #include "runtime/raw-value.inline.h"
 #include "util/bloom-filter.h"
+#include "util/in-list-filter.h"
 #include "util/min-max-filter.h"
 #include "util/time.h"
 
@@ -31,9 +32,12 @@ namespace impala {
 inline bool RuntimeFilter::AlwaysTrue() const {
   if (is_bloom_filter()) {
     return HasFilter() && bloom_filter_.Load() == BloomFilter::ALWAYS_TRUE_FILTER;
-  } else {
-    DCHECK(is_min_max_filter());
+  } else if (is_min_max_filter()) {
     return HasFilter() && min_max_filter_.Load()->AlwaysTrue();
+  } else {
+    DCHECK(is_in_list_filter());
+    return HasFilter()
+        && (in_list_filter_.Load() == nullptr || in_list_filter_.Load()->AlwaysTrue());
   }
 }
 
@@ -41,9 +45,11 @@ inline bool RuntimeFilter::AlwaysFalse() const {
   if (is_bloom_filter()) {
     return bloom_filter_.Load() != BloomFilter::ALWAYS_TRUE_FILTER
         && bloom_filter_.Load()->AlwaysFalse();
-  } else {
-    DCHECK(is_min_max_filter());
+  } else if (is_min_max_filter()) {
     return min_max_filter_.Load() != nullptr && min_max_filter_.Load()->AlwaysFalse();
+  } else {
+    DCHECK(is_in_list_filter());
+    return in_list_filter_.Load() != nullptr && in_list_filter_.Load()->AlwaysFalse();
   }
 }
 
@@ -46,6 +46,7 @@
 #include "util/auth-util.h" // for GetEffectiveUser()
 #include "util/bitmap.h"
 #include "util/cpu-info.h"
+#include "util/cpu-sampler.h"
 #include "util/cyclic-barrier.h"
 #include "util/debug-util.h"
 #include "util/disk-info.h"
@@ -85,6 +86,9 @@ RuntimeState::RuntimeState(QueryState* query_state, const TPlanFragment& fragmen
         obj_pool(), "Fragment " + PrintId(instance_ctx.fragment_instance_id))),
     instance_buffer_reservation_(obj_pool()->Add(new ReservationTracker)) {
   Init();
+  if (query_options().cpu_profile_sampling_hz > 0) {
+    cpu_samples_.reset(new CpuSampleCollector(query_options().cpu_profile_sampling_hz));
+  }
 }
 
 // Constructor for standalone RuntimeState for test execution and fe-support.cc.
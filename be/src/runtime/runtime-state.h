@@ -58,6 +58,7 @@ class TPlanFragment;
 class TPlanFragmentInstanceCtx;
 class QueryState;
 class ConditionVariable;
+class CpuSampleCollector;
 class CyclicBarrier;
 
 namespace io {
@@ -153,6 +154,10 @@ class RuntimeState {
   /// Returns runtime state profile
   RuntimeProfile* runtime_profile() { return profile_; }
 
+  /// Returns the collector of the CPU samples of the threads working on this fragment
+  /// instance, or nullptr if CPU_PROFILE_SAMPLING_HZ is 0.
+  CpuSampleCollector* cpu_samples() const { return cpu_samples_.get(); }
+
   const std::string& GetEffectiveUser() const;
 
   inline Status GetQueryStatus() {
@@ -358,6 +363,9 @@ class RuntimeState {
 
   RuntimeProfile* const profile_;
 
+  /// Only created by the fragment instance c'tor if CPU_PROFILE_SAMPLING_HZ is set.
+  std::unique_ptr<CpuSampleCollector> cpu_samples_;
+
   /// Total time waiting in storage (across all threads)
   RuntimeProfile::Counter* total_storage_wait_timer_;
 
@@ -25,7 +25,7 @@
 namespace impala {
 
 /// SortedRunWrapper returns individual rows in a batch obtained from a sorted input run
-/// (a RunBatchSupplierFn). Used as the heap element in the min heap maintained by the
+/// (a RunBatchSupplierFn). Used as the leaves of the loser tree maintained by the
 /// merger.
 /// Advance() advances the row supplier to the next row in the input batch and retrieves
 /// the next batch from the input if the current input batch is exhausted. Transfers
@@ -101,64 +101,79 @@ class SortedRunMerger::SortedRunWrapper {
 
   /// The parent merger instance.
   SortedRunMerger* parent_;
+
+  /// True once all rows of the run have been returned.
+  bool eos_ = false;
+
+  /// The key prefix of current_row() if the merger uses key prefixes.
+  uint64_t key_prefix_ = 0;
 };
 
-void SortedRunMerger::Heapify(int parent_index) {
-  int left_index = 2 * parent_index + 1;
-  int right_index = left_index + 1;
-  if (left_index >= min_heap_.size()) return;
-  int least_child;
-  // Find the least child of parent.
-  if (right_index >= min_heap_.size() ||
-      comparator_.Less(
-          min_heap_[left_index]->current_row(), min_heap_[right_index]->current_row())) {
-    least_child = left_index;
-  } else {
-    least_child = right_index;
+bool SortedRunMerger::Less(int lhs, int rhs) const {
+  const SortedRunWrapper* lhs_run = runs_[lhs];
+  const SortedRunWrapper* rhs_run = runs_[rhs];
+  if (lhs_run->eos_) return false;
+  if (rhs_run->eos_) return true;
+  if (prefix_comparator_ != nullptr && lhs_run->key_prefix_ != rhs_run->key_prefix_) {
+    return lhs_run->key_prefix_ < rhs_run->key_prefix_;
   }
+  return comparator_.Less(lhs_run->current_row(), rhs_run->current_row());
+}
 
-  // If the parent is out of place, swap it with the least child and invoke
-  // Heapify recursively.
-  if (comparator_.Less(min_heap_[least_child]->current_row(),
-          min_heap_[parent_index]->current_row())) {
-    iter_swap(min_heap_.begin() + least_child, min_heap_.begin() + parent_index);
-    Heapify(least_child);
-  }
+int SortedRunMerger::BuildLoserTree(int node) {
+  const int num_runs = runs_.size();
+  if (node >= num_runs) return node - num_runs;
+  int winner = BuildLoserTree(2 * node);
+  int loser = BuildLoserTree(2 * node + 1);
+  if (Less(loser, winner)) std::swap(winner, loser);
+  loser_tree_[node] = loser;
+  return winner;
 }
 
 SortedRunMerger::SortedRunMerger(const TupleRowComparator& comparator,
-    const RowDescriptor* row_desc, RuntimeProfile* profile, bool deep_copy_input)
+    const RowDescriptor* row_desc, RuntimeProfile* profile, bool deep_copy_input,
+    bool use_key_prefixes)
   : comparator_(comparator),
     input_row_desc_(row_desc),
     deep_copy_input_(deep_copy_input) {
+  if (use_key_prefixes) {
+    prefix_comparator_ = dynamic_cast<const TupleRowLexicalComparator*>(&comparator);
+    if (prefix_comparator_ != nullptr && !prefix_comparator_->SupportsKeyPrefix()) {
+      prefix_comparator_ = nullptr;
+    }
+  }
   get_next_timer_ = ADD_TIMER(profile, "MergeGetNext");
   get_next_batch_timer_ = ADD_TIMER(profile, "MergeGetNextBatch");
 }
 
 Status SortedRunMerger::Prepare(const vector<RunBatchSupplierFn>& input_runs) {
-  DCHECK_EQ(min_heap_.size(), 0);
-  min_heap_.reserve(input_runs.size());
+  DCHECK_EQ(runs_.size(), 0);
+  runs_.reserve(input_runs.size());
   for (const RunBatchSupplierFn& input_run: input_runs) {
     SortedRunWrapper* new_elem = pool_.Add(new SortedRunWrapper(this, input_run));
     DCHECK(new_elem != NULL);
     bool empty;
     RETURN_IF_ERROR(new_elem->Init(&empty));
-    if (!empty) min_heap_.push_back(new_elem);
+    if (empty) continue;
+    if (prefix_comparator_ != nullptr) {
+      new_elem->key_prefix_ = prefix_comparator_->KeyPrefix(new_elem->current_row());
+    }
+    runs_.push_back(new_elem);
   }
+  num_active_runs_ = runs_.size();
+  if (runs_.empty()) return Status::OK();
 
-  // Construct the min heap from the sorted runs.
-  const int last_parent = (min_heap_.size() / 2) - 1;
-  for (int i = last_parent; i >= 0; --i) {
-    Heapify(i);
-  }
+  // Play the initial tournament of the sorted runs.
+  loser_tree_.resize(runs_.size());
+  loser_tree_[0] = BuildLoserTree(1);
   return Status::OK();
 }
 
 Status SortedRunMerger::GetNext(RowBatch* output_batch, bool* eos) {
   ScopedTimer<MonotonicStopWatch> timer(get_next_timer_);
 
-  while (!output_batch->AtCapacity() && !min_heap_.empty()) {
-    SortedRunWrapper* min = min_heap_[0];
+  while (!output_batch->AtCapacity() && num_active_runs_ > 0) {
+    SortedRunWrapper* min = runs_[loser_tree_[0]];
     int output_row_index = output_batch->AddRow();
     TupleRow* output_row = output_batch->GetRow(output_row_index);
     if (deep_copy_input_) {
@@ -173,23 +188,30 @@ Status SortedRunMerger::GetNext(RowBatch* output_batch, bool* eos) {
     output_batch->CommitLastRow();
     RETURN_IF_ERROR(AdvanceMinRow(output_batch));
   }
-  *eos = min_heap_.empty();
+  *eos = num_active_runs_ == 0;
   return Status::OK();
 }
 
 Status SortedRunMerger::AdvanceMinRow(RowBatch* transfer_batch) {
-  SortedRunWrapper* min = min_heap_[0];
+  int winner = loser_tree_[0];
+  SortedRunWrapper* min = runs_[winner];
   bool min_run_complete;
   // Advance to the next element in min. output_batch is supplied to transfer
   // resource ownership if the input batch in min is exhausted.
   RETURN_IF_ERROR(min->Advance(deep_copy_input_ ? NULL : transfer_batch,
       &min_run_complete));
   if (min_run_complete) {
-    // Remove the element from the heap.
-    iter_swap(min_heap_.begin(), min_heap_.end() - 1);
-    min_heap_.pop_back();
+    min->eos_ = true;
+    if (--num_active_runs_ == 0) return Status::OK();
+  } else if (prefix_comparator_ != nullptr) {
+    min->key_prefix_ = prefix_comparator_->KeyPrefix(min->current_row());
+  }
+  // Replay the matches from the leaf of the run to the root. The new winner of each
+  // match moves up and the loser stays at the node.
+  for (int node = (winner + runs_.size()) / 2; node > 0; node /= 2) {
+    if (Less(loser_tree_[node], winner)) std::swap(loser_tree_[node], winner);
   }
-  if (!min_heap_.empty()) Heapify(0);
+  loser_tree_[0] = winner;
   return Status::OK();
 }
 
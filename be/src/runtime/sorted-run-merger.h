@@ -28,11 +28,20 @@ namespace impala {
 class RowBatch;
 class RowDescriptor;
 class TupleRowComparator;
+class TupleRowLexicalComparator;
 
 /// SortedRunMerger is used to merge multiple sorted runs of tuples. A run is a sorted
 /// sequence of row batches, which are fetched from a RunBatchSupplierFn function object.
-/// Merging is implemented using a binary min-heap that maintains the run with the next
-/// tuple in sorted order at the top of the heap.
+/// Merging is implemented using a loser tree (tournament tree), whose internal nodes
+/// hold the runs that lost the comparison at that node and whose root holds the run
+/// with the next tuple in sorted order. Replacing the row of the winning run only
+/// replays the comparisons on the path from its leaf to the root, which is one
+/// comparison per level rather than the two of a binary heap.
+///
+/// If 'use_key_prefixes' is set and the comparator supports key prefixes (see
+/// TupleRowLexicalComparator::KeyPrefix()), the merger caches the key prefix of the
+/// current row of each run and only compares the rows with the comparator if their
+/// prefixes are equal.
 ///
 /// Merged batches of rows are retrieved from SortedRunMerger via calls to GetNext().
 /// The merger is constructed with a boolean flag deep_copy_input.
@@ -55,10 +64,10 @@ class SortedRunMerger {
   typedef boost::function<Status (RowBatch**)> RunBatchSupplierFn;
 
   SortedRunMerger(const TupleRowComparator& comparator, const RowDescriptor* row_desc,
-      RuntimeProfile* profile, bool deep_copy_input);
+      RuntimeProfile* profile, bool deep_copy_input, bool use_key_prefixes = false);
 
   /// Prepare this merger to merge and return rows from the sorted runs in 'input_runs'.
-  /// Retrieves the first batch from each run and sets up the binary heap implementing
+  /// Retrieves the first batch from each run and sets up the loser tree implementing
   /// the priority queue.
   Status Prepare(const std::vector<RunBatchSupplierFn>& input_runs);
 
@@ -73,26 +82,39 @@ class SortedRunMerger {
   /// attach resources to.
   ///
   /// When AdvanceMinRow returns, the previous min is advanced to the next row and the
-  /// heap is reordered accordingly. The RunBatchSupplierFn is removed from the heap if
-  /// this was its last row. Any completed resources are transferred to the batch.
+  /// loser tree is replayed accordingly. The run loses against all others once this was
+  /// its last row. Any completed resources are transferred to the batch.
   Status AdvanceMinRow(RowBatch* transfer_batch);
 
-  /// Assuming the element at parent_index is the only out of place element in the heap,
-  /// restore the heap property (i.e. swap elements so parent <= children).
-  void Heapify(int parent_index);
+  /// Returns true if the current row of the run at 'lhs' in 'runs_' is less than that of
+  /// the run at 'rhs'. Runs without rows are greater than all others.
+  bool Less(int lhs, int rhs) const;
+
+  /// Plays the tournament of the runs below the node at 'node' of 'loser_tree_', storing
+  /// the loser at each internal node. Returns the index of the winning run.
+  int BuildLoserTree(int node);
 
-  /// The binary min-heap used to merge rows from the sorted input runs. Since the heap is
-  /// stored in a 0-indexed array, the 0-th element is the minimum element in the heap,
-  /// and the children of the element at index i are 2*i+1 and 2*i+2. The heap property is
-  /// that row of the parent element is <= the rows of the child elements according to the
-  /// comparator comparator_.
-  /// The SortedRunWrapper objects used in the min_heap_ are owned by this
+  /// The non-empty input runs. The SortedRunWrapper objects are owned by this
   /// SortedRunMerger instance.
-  std::vector<SortedRunWrapper*> min_heap_;
+  std::vector<SortedRunWrapper*> runs_;
+
+  /// The loser tree over 'runs_', stored in an array of runs_.size() indexes into
+  /// 'runs_'. Element 0 is the winner, i.e. the run with the least current row. The
+  /// internal nodes are the elements 1 to runs_.size() - 1, where the children of node
+  /// 'i' are the nodes 2 * i and 2 * i + 1. The leaf of the run at index 'r' is node
+  /// runs_.size() + r, and is not stored.
+  std::vector<int> loser_tree_;
+
+  /// Number of runs in 'runs_' that still have rows.
+  int num_active_runs_ = 0;
 
   /// Row comparator. Returns true if lhs < rhs.
   const TupleRowComparator& comparator_;
 
+  /// The comparator to compute the key prefixes of the rows with, or NULL if they are
+  /// not used. Same object as 'comparator_' if not NULL.
+  const TupleRowLexicalComparator* prefix_comparator_ = nullptr;
+
   /// Descriptor for the rows provided by the input runs. Owned by the exec-node through
   /// which this merger was created.
   const RowDescriptor* input_row_desc_;
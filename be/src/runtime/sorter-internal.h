@@ -131,6 +131,10 @@ class Sorter::Page {
 /// * Once reading is done, CloseAllPages() should be called to free resources.
 class Sorter::Run {
  public:
+  /// Maximum number of pages of each page sequence that an unpinned run pins ahead of
+  /// the page that is being read.
+  static const int MAX_READ_AHEAD_PAGES = 2;
+
   Run(Sorter* parent, TupleDescriptor* sort_tuple_desc, bool initial_run);
 
   ~Run();
@@ -180,7 +184,8 @@ class Sorter::Run {
   /// attached pages. If this run was unpinned, one page (two if there are var-len
   /// slots) is pinned while rows are filled into output_batch. The page is unpinned
   /// before the next page is pinned, so at most one (two if there are var-len slots)
-  /// page(s) will be pinned at once. If the run was pinned, the pages are not unpinned
+  /// page(s) will be pinned at once, plus the pages pinned ahead with the sorter's
+  /// read-ahead budget, if any. If the run was pinned, the pages are not unpinned
   /// and each page is attached to 'output_batch' once all rows referencing data in the
   /// page have been returned, either in the current batch or previous batches. In both
   /// pinned and unpinned cases, all rows in output_batch will reference at most one
@@ -248,9 +253,16 @@ class Sorter::Run {
 
   /// Advance to the next read page. If the run is pinned, has no effect. If the run
   /// is unpinned, the pin at 'page_index' was already attached to an output batch and
-  /// this function will pin the page at 'page_index' + 1 in 'pages'.
+  /// this function will pin the page at 'page_index' + 1 in 'pages', unless it was
+  /// already pinned by ReadAhead().
   Status PinNextReadPage(vector<Page>* pages, int page_index);
 
+  /// Pins up to MAX_READ_AHEAD_PAGES pages after the page at 'page_index' in 'pages' of
+  /// an unpinned run, so that the buffer pool reads them from disk while the current
+  /// page is merged. Each page is pinned with reservation from the sorter's read-ahead
+  /// budget, and stops when the budget is used up.
+  Status ReadAhead(vector<Page>* pages, int page_index);
+
   /// Copy the StringValues in 'var_values' to 'dest' in order and update the StringValue
   /// ptrs in 'dest' to point to the copied data.
   void CopyVarLenData(const vector<StringValue*>& var_values, uint8_t* dest);
@@ -349,6 +361,10 @@ class Sorter::Run {
 
   /// Offset into the current fixed length data page being processed.
   int fixed_len_page_offset_;
+
+  /// Number of pages pinned by ReadAhead() with reservation from the sorter's
+  /// read-ahead budget. Returned to the budget when the pages are read or closed.
+  int num_read_ahead_pages_ = 0;
 };
 
 /// Helper class used to iterate over tuples in a run during sorting.
@@ -424,9 +440,35 @@ class Sorter::TupleIterator {
 /// Quick sort is used for sequences of tuples larger that 16 elements, and insertion
 /// sort is used for smaller sequences. The TupleSorter is initialized with a
 /// RuntimeState instance to check for cancellation during an in-memory sort.
+///
+/// If a 'prefix_comparator' is given, the sorter computes the key prefix of every tuple
+/// in the run before sorting it and keeps the prefixes in an array parallel to the
+/// tuples. Tuples are then ordered by their prefixes and only compared with
+/// 'comparator' if the prefixes are equal, which avoids evaluating the ordering exprs
+/// for most comparisons if the first ordering key has many distinct values.
+///
+/// If the parent Sorter has 'range_sorters_', large runs are sorted by several threads.
+/// The sorter partitions the run around pivots into as many ranges as there are
+/// threads, each containing only tuples that are >= those of the ranges before it.
+/// It then sorts one range itself and hands the others to the TupleSorters of
+/// 'range_sorters_' on ExecEnv::sort_pool(). Since the ranges are ordered with respect
+/// to each other, the run is sorted once all ranges are, and no merge is needed.
+///
+/// If a 'radix_comparator' is given, runs are instead sorted with a least significant
+/// digit radix sort. The sorter encodes the exact key of every tuple with
+/// TupleRowLexicalComparator::RadixKey() into an entry together with the index of the
+/// tuple, sorts the entries by one byte of the keys at a time, skipping bytes that are
+/// the same for all tuples, and then moves the tuples to their sorted positions. The
+/// NULL flag of each ordering expr is sorted as a separate digit, so NULLs end up in
+/// their own partition before or after the other values of the expr. Runs are sorted
+/// with the quicksort if the memory for the entries cannot be obtained.
 class Sorter::TupleSorter {
  public:
+  /// 'expr_results_pool' is the pool that holds the results of the ordering exprs of
+  /// 'comparator', which is cleared periodically while sorting.
   TupleSorter(Sorter* parent, const TupleRowComparator& comparator,
+        const TupleRowLexicalComparator* prefix_comparator,
+        const TupleRowLexicalComparator* radix_comparator, MemPool* expr_results_pool,
         int tuple_size, RuntimeState* state);
 
   ~TupleSorter();
@@ -437,6 +479,13 @@ class Sorter::TupleSorter {
   /// query is cancelled.
   Status Sort(Run* run);
 
+  /// Sorts the tuples in the range [begin, end) of 'run', given the key prefixes of the
+  /// run in 'key_prefixes', which may be NULL. Used to sort the ranges of a run that is
+  /// partitioned by another TupleSorter. Returns an error status if any error is
+  /// encountered or if the query is cancelled.
+  Status SortRange(Run* run, uint64_t* key_prefixes, const TupleIterator& begin,
+      const TupleIterator& end);
+
   /// Makes an attempt to codegen for method SortHelper(). Stores the resulting
   /// function in codegend_fn and returns Status::OK() if codegen was successful.
   /// Otherwise, a Status("Sorter::TupleSorter::Codegen(): failed to finalize function")
@@ -455,6 +504,37 @@ class Sorter::TupleSorter {
  private:
   static const int INSERTION_THRESHOLD = 16;
 
+  /// Runs with fewer tuples are sorted by a single thread, as are ranges with fewer
+  /// tuples not partitioned any further.
+  static const int64_t MIN_PARALLEL_SORT_TUPLES = 64 * 1024;
+
+  /// Runs with fewer tuples are sorted with the quicksort even with a radix comparator.
+  static const int64_t MIN_RADIX_SORT_TUPLES = 256;
+
+  /// The encoded key of a tuple and its index in the run, sorted by RadixSort(). The
+  /// key words are followed by the index of the tuple at RADIX_INDEX_WORD. The NULL
+  /// flags of the key are in the most significant bits of that word, starting with
+  /// the flag of the first ordering expr at bit RADIX_NULL_FLAGS_SHIFT.
+  static const int RADIX_INDEX_WORD = TupleRowLexicalComparator::MAX_RADIX_KEY_WORDS;
+  static const int RADIX_NULL_FLAGS_SHIFT =
+      64 - TupleRowLexicalComparator::MAX_RADIX_KEYS;
+  static const uint64_t RADIX_INDEX_MASK = (1ULL << RADIX_NULL_FLAGS_SHIFT) - 1;
+  struct RadixEntry {
+    uint64_t words[RADIX_INDEX_WORD + 1];
+  };
+
+  /// A digit of the keys of RadixEntry: the bits 'mask' of the word at 'word' after
+  /// shifting them right by 'shift'.
+  struct RadixDigit {
+    int word;
+    int shift;
+    uint64_t mask;
+
+    uint64_t Get(const RadixEntry& entry) const {
+      return (entry.words[word] >> shift) & mask;
+    }
+  };
+
   Sorter* const parent_;
 
   /// Size of the tuples in memory.
@@ -463,8 +543,30 @@ class Sorter::TupleSorter {
   /// Tuple comparator with method Less() that returns true if lhs < rhs.
   const TupleRowComparator& comparator_;
 
+  /// Comparator to compute the key prefixes of the tuples with, or NULL if the key
+  /// prefixes are not used. Same object as 'comparator_' if not NULL.
+  const TupleRowLexicalComparator* const prefix_comparator_;
+
+  /// Comparator to encode the keys of the tuples for RadixSort() with, or NULL if the
+  /// runs are sorted with the quicksort. Same object as 'comparator_' if not NULL.
+  const TupleRowLexicalComparator* const radix_comparator_;
+
+  /// The key prefixes of the tuples of 'run_', indexed by the position of the tuple in
+  /// the run, or NULL if they are not used for the current run. The prefixes are moved
+  /// along with the tuples while sorting. Points to 'key_prefixes_buffer_', or to the
+  /// prefixes of the TupleSorter that partitioned the run if this sorts a range of it.
+  uint64_t* key_prefixes_ = nullptr;
+
+  /// The prefixes computed by ComputeKeyPrefixes(). Its memory is counted against the
+  /// sorter's MemTracker.
+  std::unique_ptr<uint64_t[]> key_prefixes_buffer_;
+  int64_t key_prefixes_bytes_ = 0;
+
+  /// Holds the results of evaluating the ordering exprs of 'comparator_'. Not owned.
+  MemPool* const expr_results_pool_;
+
   /// Number of times comparator_.Less() can be invoked again before
-  /// comparator_. expr_results_pool_.Clear() needs to be called.
+  /// expr_results_pool_->Clear() needs to be called.
   int num_comparisons_till_free_;
 
   /// Runtime state instance to check for cancellation. Not owned.
@@ -483,11 +585,44 @@ class Sorter::TupleSorter {
   /// high: Mersenne Twister should be more than adequate.
   std::mt19937_64 rng_;
 
-  /// Wrapper around comparator_.Less(). Also call expr_results_pool_.Clear()
+  /// Wrapper around comparator_.Less(). Also call expr_results_pool_->Clear()
   /// on every 'state_->batch_size()' invocations of comparator_.Less(). Returns true
   /// if 'lhs' is less than 'rhs'.
   bool IR_ALWAYS_INLINE Less(const TupleRow* lhs, const TupleRow* rhs);
 
+  /// Returns true if 'lhs' is less than 'rhs', given that their key prefixes are
+  /// 'lhs_prefix' and 'rhs_prefix'. Only calls Less() if the prefixes are equal.
+  bool IR_ALWAYS_INLINE Less(uint64_t lhs_prefix, const TupleRow* lhs,
+      uint64_t rhs_prefix, const TupleRow* rhs);
+
+  /// Returns the key prefix of the tuple at 'index' in 'run_', or 0 if the key prefixes
+  /// are not used.
+  uint64_t IR_ALWAYS_INLINE KeyPrefix(int64_t index) const {
+    return key_prefixes_ == nullptr ? 0 : key_prefixes_[index];
+  }
+
+  /// Computes the key prefixes of all tuples of 'run_' into 'key_prefixes_'. Leaves
+  /// 'key_prefixes_' NULL if the memory for them cannot be obtained.
+  void ComputeKeyPrefixes();
+
+  /// Frees 'key_prefixes_' and releases its memory.
+  void FreeKeyPrefixes();
+
+  /// Sorts [begin, end) of 'run_' with the codegen'd SortHelper() if there is one.
+  Status SortRange(const TupleIterator& begin, const TupleIterator& end);
+
+  /// Sorts 'run_' with a radix sort. Sets 'sorted' to false, without changing 'run_', if
+  /// the memory for the entries cannot be obtained.
+  Status RadixSort(bool* sorted);
+
+  /// Sorts 'entries' of all tuples of 'run_' by their keys, using 'scratch' as a second
+  /// array of the same size, and moves the tuples into the order of the sorted entries.
+  Status RadixSort(RadixEntry* entries, RadixEntry* scratch);
+
+  /// Partitions 'run_' into ranges for this sorter and the parent's 'range_sorters_'
+  /// and sorts them in parallel. Waits for all ranges to be sorted before returning.
+  Status SortParallel();
+
   /// Perform an insertion sort for rows in the range [begin, end) in a run.
   /// Only valid to call for ranges of size at least 1.
   Status IR_ALWAYS_INLINE InsertionSort(
@@ -518,4 +653,16 @@ class Sorter::TupleSorter {
       Tuple* RESTRICT swap_tuple, int tuple_size);
 };
 
+/// The state that a thread of ExecEnv::sort_pool() uses to sort a range of a run. The
+/// expr evaluators of a comparator are not thread-safe, so each range sorter has its
+/// own comparator and the pools for its evaluators.
+struct Sorter::RangeSorter {
+  RangeSorter(const TupleRowComparatorConfig& config, MemTracker* mem_tracker);
+
+  MemPool expr_perm_pool;
+  MemPool expr_results_pool;
+  boost::scoped_ptr<TupleRowComparator> comparator;
+  boost::scoped_ptr<TupleSorter> tuple_sorter;
+};
+
 } // namespace impala
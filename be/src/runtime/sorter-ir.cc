@@ -70,12 +70,18 @@ bool IR_ALWAYS_INLINE Sorter::TupleSorter::Less(
   --num_comparisons_till_free_;
   DCHECK_GE(num_comparisons_till_free_, 0);
   if (UNLIKELY(num_comparisons_till_free_ == 0)) {
-    parent_->expr_results_pool_.Clear();
+    expr_results_pool_->Clear();
     num_comparisons_till_free_ = state_->batch_size();
   }
   return comparator_.Less(lhs, rhs);
 }
 
+bool IR_ALWAYS_INLINE Sorter::TupleSorter::Less(uint64_t lhs_prefix,
+    const TupleRow* lhs, uint64_t rhs_prefix, const TupleRow* rhs) {
+  if (lhs_prefix != rhs_prefix) return lhs_prefix < rhs_prefix;
+  return Less(lhs, rhs);
+}
+
 Status IR_ALWAYS_INLINE Sorter::TupleSorter::Partition(TupleIterator begin,
     TupleIterator end, const Tuple* pivot, TupleIterator* cut) {
   // Hoist member variable lookups out of loop to avoid extra loads inside loop.
@@ -88,22 +94,29 @@ Status IR_ALWAYS_INLINE Sorter::TupleSorter::Partition(TupleIterator begin,
   DCHECK(temp_tuple != nullptr);
   DCHECK(pivot != nullptr);
   memcpy(temp_tuple, pivot, tuple_size);
+  TupleRow* temp_row = reinterpret_cast<TupleRow*>(&temp_tuple);
+  uint64_t* key_prefixes = key_prefixes_;
+  const uint64_t pivot_prefix =
+      key_prefixes == nullptr ? 0 : prefix_comparator_->KeyPrefix(temp_row);
 
   TupleIterator left = begin;
   TupleIterator right = end;
   right.Prev(run, tuple_size); // Set 'right' to the last tuple in range.
   while (true) {
     // Search for the first and last out-of-place elements, and swap them.
-    while (Less(left.row(), reinterpret_cast<TupleRow*>(&temp_tuple))) {
+    while (Less(KeyPrefix(left.index()), left.row(), pivot_prefix, temp_row)) {
       left.Next(run, tuple_size);
     }
-    while (Less(reinterpret_cast<TupleRow*>(&temp_tuple), right.row())) {
+    while (Less(pivot_prefix, temp_row, KeyPrefix(right.index()), right.row())) {
       right.Prev(run, tuple_size);
     }
 
     if (left.index() >= right.index()) break;
     // Swap first and last tuples.
     Swap(left.tuple(), right.tuple(), swap_tuple, tuple_size);
+    if (key_prefixes != nullptr) {
+      std::swap(key_prefixes[left.index()], key_prefixes[right.index()]);
+    }
 
     left.Next(run, tuple_size);
     right.Prev(run, tuple_size);
@@ -128,6 +141,7 @@ Status IR_ALWAYS_INLINE Sorter::TupleSorter::InsertionSort(const TupleIterator&
   Run* run = run_;
   int tuple_size = tuple_size_;
   uint8_t* temp_tuple_buffer = temp_tuple_buffer_;
+  uint64_t* key_prefixes = key_prefixes_;
 
   TupleIterator insert_iter = begin;
   insert_iter.Next(run, tuple_size);
@@ -136,6 +150,7 @@ Status IR_ALWAYS_INLINE Sorter::TupleSorter::InsertionSort(const TupleIterator&
     // be inserted into the sorted sequence. Copy to temp_tuple_buffer_ since it may be
     // overwritten by the one at position 'insert_iter - 1'
     memcpy(temp_tuple_buffer, insert_iter.tuple(), tuple_size);
+    const uint64_t temp_prefix = KeyPrefix(insert_iter.index());
 
     // 'iter' points to the tuple that temp_tuple_buffer will be compared to.
     // 'copy_to' is the where iter should be copied to if it is >= temp_tuple_buffer.
@@ -143,9 +158,15 @@ Status IR_ALWAYS_INLINE Sorter::TupleSorter::InsertionSort(const TupleIterator&
     TupleIterator iter = insert_iter;
     iter.Prev(run, tuple_size);
     Tuple* copy_to = insert_iter.tuple();
-    while (Less(reinterpret_cast<TupleRow*>(&temp_tuple_buffer), iter.row())) {
+    int64_t copy_to_index = insert_iter.index();
+    while (Less(temp_prefix, reinterpret_cast<TupleRow*>(&temp_tuple_buffer),
+        KeyPrefix(iter.index()), iter.row())) {
       memcpy(copy_to, iter.tuple(), tuple_size);
+      if (key_prefixes != nullptr) {
+        key_prefixes[copy_to_index] = key_prefixes[iter.index()];
+      }
       copy_to = iter.tuple();
+      copy_to_index = iter.index();
       // Break if 'iter' has reached the first row, meaning that the temp row
       // will be inserted in position 'begin'
       if (iter.index() <= begin.index()) break;
@@ -153,6 +174,7 @@ Status IR_ALWAYS_INLINE Sorter::TupleSorter::InsertionSort(const TupleIterator&
     }
 
     memcpy(copy_to, temp_tuple_buffer, tuple_size);
+    if (key_prefixes != nullptr) key_prefixes[copy_to_index] = temp_prefix;
   }
   RETURN_IF_CANCELLED(state_);
   RETURN_IF_ERROR(state_->GetQueryStatus());
@@ -17,6 +17,9 @@
 
 #include "runtime/sorter-internal.h"
 
+#include <algorithm>
+#include <array>
+
 #include <boost/bind.hpp>
 #include <gutil/strings/substitute.h>
 
@@ -31,6 +34,8 @@
 #include "runtime/runtime-state.h"
 #include "runtime/sorted-run-merger.h"
 #include "util/pretty-printer.h"
+#include "util/promise.h"
+#include "util/thread-pool.h"
 #include "util/ubsan.h"
 
 #include "common/names.h"
@@ -287,6 +292,8 @@ Status Sorter::Run::FinalizePages(vector<Page>* pages) {
 void Sorter::Run::CloseAllPages() {
   DeleteAndClearPages(&fixed_len_pages_);
   DeleteAndClearPages(&var_len_pages_);
+  sorter_->merge_read_ahead_budget_ += num_read_ahead_pages_;
+  num_read_ahead_pages_ = 0;
   if (var_len_copy_page_.is_open()) {
     var_len_copy_page_.Close(sorter_->buffer_pool_client_);
   }
@@ -451,17 +458,30 @@ Status Sorter::Run::GetNext(RowBatch* output_batch, bool* eos) {
     end_of_var_len_page_ = false;
   }
 
+  // Start reading the next pages of an unpinned run before waiting for the current
+  // ones, so that the reads overlap with the merge of the current pages.
+  if (!is_pinned_) {
+    RETURN_IF_ERROR(ReadAhead(&fixed_len_pages_, fixed_len_pages_index_));
+    if (HasVarLenPages()) {
+      RETURN_IF_ERROR(ReadAhead(&var_len_pages_, var_len_pages_index_));
+    }
+  }
+
   // Fills rows into the output batch until a page boundary is reached.
   Page* fixed_len_page = &fixed_len_pages_[fixed_len_pages_index_];
   DCHECK(fixed_len_page != nullptr);
 
-  // Ensure we have a reference to the fixed-length page's buffer.
-  RETURN_IF_ERROR(fixed_len_page->WaitForBuffer());
-
-  // If we're converting offsets into unpinned var-len pages, make sure the
-  // current var-len page is in memory.
-  if (CONVERT_OFFSET_TO_PTR && HasVarLenPages()) {
-    RETURN_IF_ERROR(var_len_pages_[var_len_pages_index_].WaitForBuffer());
+  {
+    // Time spent here for unpinned runs is time the merge waits for disk reads.
+    SCOPED_TIMER(is_pinned_ ? nullptr : sorter_->merge_stall_timer_);
+    // Ensure we have a reference to the fixed-length page's buffer.
+    RETURN_IF_ERROR(fixed_len_page->WaitForBuffer());
+
+    // If we're converting offsets into unpinned var-len pages, make sure the
+    // current var-len page is in memory.
+    if (CONVERT_OFFSET_TO_PTR && HasVarLenPages()) {
+      RETURN_IF_ERROR(var_len_pages_[var_len_pages_index_].WaitForBuffer());
+    }
   }
 
   while (!output_batch->AtCapacity()
@@ -523,15 +543,40 @@ Status Sorter::Run::PinNextReadPage(vector<Page>* pages, int page_index) {
   DCHECK_LT(page_index, pages->size() - 1);
   Page* curr_page = &(*pages)[page_index];
   Page* next_page = &(*pages)[page_index + 1];
-  DCHECK_EQ(is_pinned_, next_page->is_pinned());
+  DCHECK(!is_pinned_ || next_page->is_pinned());
   // The current page was attached to a batch.
   DCHECK(!curr_page->is_open());
   // 'next_page' is already pinned if the whole stream is pinned.
   if (is_pinned_) return Status::OK();
+  if (next_page->is_pinned()) {
+    // 'next_page' was pinned by ReadAhead(). It takes the place of the current page, so
+    // the reservation of the current page goes back to the read-ahead budget.
+    DCHECK_GT(num_read_ahead_pages_, 0);
+    --num_read_ahead_pages_;
+    ++sorter_->merge_read_ahead_budget_;
+    return Status::OK();
+  }
+  SCOPED_TIMER(sorter_->merge_stall_timer_);
   RETURN_IF_ERROR(next_page->Pin(sorter_->buffer_pool_client_));
   return Status::OK();
 }
 
+Status Sorter::Run::ReadAhead(vector<Page>* pages, int page_index) {
+  DCHECK(!is_pinned_);
+  int last_page_index =
+      min<int>(page_index + MAX_READ_AHEAD_PAGES, static_cast<int>(pages->size()) - 1);
+  for (int i = page_index + 1; i <= last_page_index; ++i) {
+    Page* page = &(*pages)[i];
+    if (page->is_pinned()) continue;
+    if (sorter_->merge_read_ahead_budget_ <= 0) break;
+    RETURN_IF_ERROR(page->Pin(sorter_->buffer_pool_client_));
+    --sorter_->merge_read_ahead_budget_;
+    ++num_read_ahead_pages_;
+    sorter_->merge_read_ahead_pages_counter_->Add(1);
+  }
+  return Status::OK();
+}
+
 void Sorter::Run::CollectNonNullVarSlots(Tuple* src,
     vector<StringValue*>* string_values, int* total_var_len) {
   string_values->clear();
@@ -733,11 +778,29 @@ Sorter::TupleIterator::TupleIterator(Sorter::Run* run, int64_t index)
   tuple_ = run->fixed_len_pages_[page_index_].data() + page_offset;
 }
 
+/// Returns a new comparator of the sorting order of 'config'.
+static TupleRowComparator* CreateComparator(const TupleRowComparatorConfig& config) {
+  switch (config.sorting_order_) {
+    case TSortingOrder::LEXICAL:
+      return new TupleRowLexicalComparator(config);
+    case TSortingOrder::ZORDER:
+      return new TupleRowZOrderComparator(config);
+    default:
+      DCHECK(false);
+      return nullptr;
+  }
+}
+
 Sorter::TupleSorter::TupleSorter(Sorter* parent, const TupleRowComparator& comp,
+    const TupleRowLexicalComparator* prefix_comparator,
+    const TupleRowLexicalComparator* radix_comparator, MemPool* expr_results_pool,
     int tuple_size, RuntimeState* state)
   : parent_(parent),
     tuple_size_(tuple_size),
     comparator_(comp),
+    prefix_comparator_(prefix_comparator),
+    radix_comparator_(radix_comparator),
+    expr_results_pool_(expr_results_pool),
     num_comparisons_till_free_(state->batch_size()),
     state_(state) {
   temp_tuple_buffer_ = new uint8_t[tuple_size];
@@ -745,25 +808,235 @@ Sorter::TupleSorter::TupleSorter(Sorter* parent, const TupleRowComparator& comp,
 }
 
 Sorter::TupleSorter::~TupleSorter() {
+  DCHECK(key_prefixes_buffer_ == nullptr);
   delete[] temp_tuple_buffer_;
   delete[] swap_buffer_;
 }
 
+void Sorter::TupleSorter::ComputeKeyPrefixes() {
+  DCHECK(prefix_comparator_ != nullptr);
+  DCHECK(key_prefixes_ == nullptr);
+  const int64_t num_tuples = run_->num_tuples();
+  const int64_t bytes = num_tuples * sizeof(uint64_t);
+  // The prefixes only speed up the sort, so sort without them if they do not fit.
+  if (!parent_->mem_tracker_->TryConsume(bytes)) return;
+  key_prefixes_buffer_.reset(new uint64_t[num_tuples]);
+  key_prefixes_ = key_prefixes_buffer_.get();
+  key_prefixes_bytes_ = bytes;
+  TupleIterator iter = TupleIterator::Begin(run_);
+  for (int64_t i = 0; i < num_tuples; ++i) {
+    key_prefixes_[i] = prefix_comparator_->KeyPrefix(iter.row());
+    iter.Next(run_, tuple_size_);
+    if (UNLIKELY(--num_comparisons_till_free_ == 0)) {
+      expr_results_pool_->Clear();
+      num_comparisons_till_free_ = state_->batch_size();
+    }
+  }
+}
+
+void Sorter::TupleSorter::FreeKeyPrefixes() {
+  key_prefixes_ = nullptr;
+  if (key_prefixes_buffer_ == nullptr) return;
+  key_prefixes_buffer_.reset();
+  parent_->mem_tracker_->Release(key_prefixes_bytes_);
+  key_prefixes_bytes_ = 0;
+}
+
 Status Sorter::TupleSorter::Sort(Run* run) {
   DCHECK(run->is_finalized());
   DCHECK(!run->is_sorted());
   run_ = run;
-  const SortHelperFn sort_helper_fn = parent_->codegend_sort_helper_fn_.load();
-  if (sort_helper_fn != nullptr) {
-    RETURN_IF_ERROR(
-        sort_helper_fn(this, TupleIterator::Begin(run_), TupleIterator::End(run_)));
+  if (radix_comparator_ != nullptr && run_->num_tuples() >= MIN_RADIX_SORT_TUPLES) {
+    bool sorted;
+    RETURN_IF_ERROR(RadixSort(&sorted));
+    if (sorted) {
+      run_->set_sorted();
+      return Status::OK();
+    }
+  }
+  if (prefix_comparator_ != nullptr) ComputeKeyPrefixes();
+  Status status;
+  if (!parent_->range_sorters_.empty()
+      && run_->num_tuples() >= MIN_PARALLEL_SORT_TUPLES) {
+    status = SortParallel();
   } else {
-    RETURN_IF_ERROR(SortHelper(TupleIterator::Begin(run_), TupleIterator::End(run_)));
+    status = SortRange(TupleIterator::Begin(run_), TupleIterator::End(run_));
   }
+  FreeKeyPrefixes();
+  RETURN_IF_ERROR(status);
   run_->set_sorted();
   return Status::OK();
 }
 
+Status Sorter::TupleSorter::SortRange(Run* run, uint64_t* key_prefixes,
+    const TupleIterator& begin, const TupleIterator& end) {
+  run_ = run;
+  key_prefixes_ = key_prefixes;
+  Status status = SortRange(begin, end);
+  key_prefixes_ = nullptr;
+  return status;
+}
+
+Status Sorter::TupleSorter::SortRange(
+    const TupleIterator& begin, const TupleIterator& end) {
+  const SortHelperFn sort_helper_fn = parent_->codegend_sort_helper_fn_.load();
+  if (sort_helper_fn != nullptr) return sort_helper_fn(this, begin, end);
+  return SortHelper(begin, end);
+}
+
+Status Sorter::TupleSorter::RadixSort(bool* sorted) {
+  *sorted = false;
+  const int64_t num_tuples = run_->num_tuples();
+  DCHECK_LE(num_tuples, static_cast<int64_t>(RADIX_INDEX_MASK));
+  const int64_t bytes = 2 * num_tuples * sizeof(RadixEntry);
+  // The radix sort only speeds up the sort, so use the quicksort if this does not fit.
+  if (!parent_->mem_tracker_->TryConsume(bytes)) return Status::OK();
+  unique_ptr<RadixEntry[]> entries(new RadixEntry[num_tuples]);
+  unique_ptr<RadixEntry[]> scratch(new RadixEntry[num_tuples]);
+  Status status = RadixSort(entries.get(), scratch.get());
+  entries.reset();
+  scratch.reset();
+  parent_->mem_tracker_->Release(bytes);
+  RETURN_IF_ERROR(status);
+  *sorted = true;
+  return Status::OK();
+}
+
+Status Sorter::TupleSorter::RadixSort(RadixEntry* entries, RadixEntry* scratch) {
+  const int64_t num_tuples = run_->num_tuples();
+  TupleIterator iter = TupleIterator::Begin(run_);
+  for (int64_t i = 0; i < num_tuples; ++i) {
+    RadixEntry* entry = &entries[i];
+    memset(entry->words, 0, sizeof(entry->words));
+    const uint64_t null_flags = radix_comparator_->RadixKey(iter.row(), entry->words);
+    entry->words[RADIX_INDEX_WORD] = i | (null_flags << RADIX_NULL_FLAGS_SHIFT);
+    iter.Next(run_, tuple_size_);
+    if (UNLIKELY(--num_comparisons_till_free_ == 0)) {
+      expr_results_pool_->Clear();
+      num_comparisons_till_free_ = state_->batch_size();
+    }
+  }
+  RETURN_IF_CANCELLED(state_);
+
+  // The digits from the least to the most significant one: the bytes of the words of
+  // the last ordering expr, its NULL flag, then those of the expr before it, etc.
+  vector<RadixDigit> digits;
+  int end_word = 0;
+  for (int i = 0; i < radix_comparator_->num_keys(); ++i) {
+    end_word += radix_comparator_->NumRadixKeyWords(i);
+  }
+  for (int i = radix_comparator_->num_keys() - 1; i >= 0; --i) {
+    const int begin_word = end_word - radix_comparator_->NumRadixKeyWords(i);
+    for (int word = end_word - 1; word >= begin_word; --word) {
+      for (int shift = 0; shift < 64; shift += 8) digits.push_back({word, shift, 0xFF});
+    }
+    digits.push_back({RADIX_INDEX_WORD, RADIX_NULL_FLAGS_SHIFT + i, 1});
+    end_word = begin_word;
+  }
+
+  // Count the entries of each value of each digit in a single pass. Digits that have
+  // the same value in all entries do not change the order and are skipped.
+  vector<array<int64_t, 256>> counts(digits.size());
+  for (array<int64_t, 256>& digit_counts : counts) digit_counts.fill(0);
+  for (int64_t i = 0; i < num_tuples; ++i) {
+    for (int d = 0; d < digits.size(); ++d) ++counts[d][digits[d].Get(entries[i])];
+  }
+  for (int d = 0; d < digits.size(); ++d) {
+    const RadixDigit& digit = digits[d];
+    array<int64_t, 256>& offsets = counts[d];
+    if (offsets[digit.Get(entries[0])] == num_tuples) continue;
+    int64_t offset = 0;
+    for (int64_t& count : offsets) {
+      const int64_t digit_count = count;
+      count = offset;
+      offset += digit_count;
+    }
+    // A stable scatter, so that the order of the less significant digits is kept.
+    for (int64_t i = 0; i < num_tuples; ++i) {
+      scratch[offsets[digit.Get(entries[i])]++] = entries[i];
+    }
+    std::swap(entries, scratch);
+    RETURN_IF_CANCELLED(state_);
+  }
+
+  // Move the tuple of entries[i] to index i by following the cycles of the
+  // permutation. An entry is set to its own index once its tuple is in place.
+  Tuple* temp_tuple = reinterpret_cast<Tuple*>(temp_tuple_buffer_);
+  for (int64_t i = 0; i < num_tuples; ++i) {
+    int64_t src = entries[i].words[RADIX_INDEX_WORD] & RADIX_INDEX_MASK;
+    if (src == i) continue;
+    memcpy(temp_tuple, TupleIterator(run_, i).tuple(), tuple_size_);
+    int64_t dst = i;
+    while (src != i) {
+      memcpy(TupleIterator(run_, dst).tuple(), TupleIterator(run_, src).tuple(),
+          tuple_size_);
+      entries[dst].words[RADIX_INDEX_WORD] = dst;
+      dst = src;
+      src = entries[dst].words[RADIX_INDEX_WORD] & RADIX_INDEX_MASK;
+    }
+    memcpy(TupleIterator(run_, dst).tuple(), temp_tuple, tuple_size_);
+    entries[dst].words[RADIX_INDEX_WORD] = dst;
+  }
+  RETURN_IF_CANCELLED(state_);
+  RETURN_IF_ERROR(state_->GetQueryStatus());
+  return Status::OK();
+}
+
+Status Sorter::TupleSorter::SortParallel() {
+  typedef pair<TupleIterator, TupleIterator> Range;
+  const int max_ranges = parent_->range_sorters_.size() + 1;
+  // Split the largest range until there is one for each thread. Partition() may leave
+  // one side empty for a bad pivot, so the number of attempts is limited.
+  vector<Range> ranges{{TupleIterator::Begin(run_), TupleIterator::End(run_)}};
+  for (int i = 0; ranges.size() < max_ranges && i < 2 * max_ranges; ++i) {
+    auto largest = std::max_element(ranges.begin(), ranges.end(),
+        [](const Range& lhs, const Range& rhs) {
+          return lhs.second.index() - lhs.first.index()
+              < rhs.second.index() - rhs.first.index();
+        });
+    const TupleIterator begin = largest->first;
+    const TupleIterator end = largest->second;
+    if (end.index() - begin.index() < MIN_PARALLEL_SORT_TUPLES) break;
+    TupleIterator cut;
+    RETURN_IF_ERROR(Partition(begin, end, SelectPivot(begin, end), &cut));
+    if (cut.index() == begin.index() || cut.index() == end.index()) continue;
+    largest->second = cut;
+    ranges.emplace_back(cut, end);
+  }
+  if (ranges.size() > 1) COUNTER_ADD(parent_->parallel_sorted_runs_counter_, 1);
+
+  CallableThreadPool* pool = ExecEnv::GetInstance()->sort_pool();
+  DCHECK(pool != nullptr);
+  vector<unique_ptr<Promise<Status>>> range_statuses;
+  for (int i = 1; i < ranges.size(); ++i) {
+    TupleSorter* range_sorter = parent_->range_sorters_[i - 1]->tuple_sorter.get();
+    Promise<Status>* range_status = new Promise<Status>();
+    range_statuses.emplace_back(range_status);
+    const Range range = ranges[i];
+    Run* run = run_;
+    uint64_t* key_prefixes = key_prefixes_;
+    boost::function<void()> fn = [range_sorter, range_status, range, run,
+        key_prefixes]() {
+      range_status->Set(
+          range_sorter->SortRange(run, key_prefixes, range.first, range.second));
+    };
+    if (!pool->Offer(fn)) fn();
+  }
+  Status status = SortRange(ranges[0].first, ranges[0].second);
+  // The other ranges must be done with the run before returning, even on errors.
+  for (const unique_ptr<Promise<Status>>& range_status : range_statuses) {
+    const Status& s = range_status->Get();
+    if (status.ok() && !s.ok()) status = s;
+  }
+  return status;
+}
+
+Sorter::RangeSorter::RangeSorter(
+    const TupleRowComparatorConfig& config, MemTracker* mem_tracker)
+  : expr_perm_pool(mem_tracker),
+    expr_results_pool(mem_tracker),
+    comparator(CreateComparator(config)) {}
+
 Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     const vector<ScalarExpr*>& sort_tuple_exprs, RowDescriptor* output_row_desc,
     MemTracker* mem_tracker, BufferPool::ClientHandle* buffer_pool_client,
@@ -773,6 +1046,7 @@ Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     int64_t estimated_input_size)
   : node_label_(node_label),
     state_(state),
+    tuple_row_comparator_config_(tuple_row_comparator_config),
     expr_perm_pool_(mem_tracker),
     expr_results_pool_(mem_tracker),
     compare_less_than_(nullptr),
@@ -793,18 +1067,7 @@ Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     in_mem_sort_timer_(nullptr),
     sorted_data_size_(nullptr),
     run_sizes_(nullptr) {
-  switch (tuple_row_comparator_config.sorting_order_) {
-    case TSortingOrder::LEXICAL:
-      compare_less_than_.reset(
-          new TupleRowLexicalComparator(tuple_row_comparator_config));
-      break;
-    case TSortingOrder::ZORDER:
-      compare_less_than_.reset(new TupleRowZOrderComparator(tuple_row_comparator_config));
-      break;
-    default:
-      DCHECK(false);
-  }
-
+  compare_less_than_.reset(CreateComparator(tuple_row_comparator_config));
   if (estimated_input_size > 0) ComputeSpillEstimate(estimated_input_size);
 }
 
@@ -848,13 +1111,52 @@ Status Sorter::Prepare(ObjectPool* obj_pool) {
         PrettyPrinter::Print(state_->query_options().max_row_size, TUnit::BYTES));
   }
   has_var_len_slots_ = sort_tuple_desc->HasVarlenSlots();
-  in_mem_tuple_sorter_.reset(
-      new TupleSorter(this, *compare_less_than_, sort_tuple_desc->byte_size(), state_));
+  const TupleRowLexicalComparator* prefix_comparator = nullptr;
+  if (state_->query_options().sort_key_prefix) {
+    prefix_comparator =
+        dynamic_cast<const TupleRowLexicalComparator*>(compare_less_than_.get());
+    if (prefix_comparator != nullptr && !prefix_comparator->SupportsKeyPrefix()) {
+      prefix_comparator = nullptr;
+    }
+  }
+  if (prefix_comparator != nullptr) profile_->AddInfoString("SortKeyPrefix", "true");
+  const TupleRowLexicalComparator* radix_comparator = nullptr;
+  if (state_->query_options().sort_radix) {
+    radix_comparator =
+        dynamic_cast<const TupleRowLexicalComparator*>(compare_less_than_.get());
+    if (radix_comparator != nullptr && !radix_comparator->SupportsRadixKey()) {
+      radix_comparator = nullptr;
+    }
+  }
+  if (radix_comparator != nullptr) profile_->AddInfoString("SortRadix", "true");
+  in_mem_tuple_sorter_.reset(new TupleSorter(this, *compare_less_than_,
+      prefix_comparator, radix_comparator, &expr_results_pool_,
+      sort_tuple_desc->byte_size(), state_));
+  const int sort_run_threads = state_->query_options().sort_run_threads;
+  if (sort_run_threads > 1 && ExecEnv::GetInstance()->sort_pool() != nullptr) {
+    for (int i = 1; i < sort_run_threads; ++i) {
+      RangeSorter* range_sorter =
+          new RangeSorter(tuple_row_comparator_config_, mem_tracker_);
+      range_sorters_.emplace_back(range_sorter);
+      // The comparator is of the same class as 'compare_less_than_'.
+      const TupleRowLexicalComparator* range_prefix_comparator = prefix_comparator ==
+          nullptr ? nullptr : static_cast<const TupleRowLexicalComparator*>(
+              range_sorter->comparator.get());
+      range_sorter->tuple_sorter.reset(new TupleSorter(this, *range_sorter->comparator,
+          range_prefix_comparator, nullptr, &range_sorter->expr_results_pool,
+          sort_tuple_desc->byte_size(), state_));
+    }
+    parallel_sorted_runs_counter_ =
+        ADD_COUNTER(profile_, "RunsSortedInParallel", TUnit::UNIT);
+  }
 
   if (enable_spilling_) {
     initial_runs_counter_ = ADD_COUNTER(profile_, "InitialRunsCreated", TUnit::UNIT);
     spilled_runs_counter_ = ADD_COUNTER(profile_, "SpilledRuns", TUnit::UNIT);
     num_merges_counter_ = ADD_COUNTER(profile_, "TotalMergesPerformed", TUnit::UNIT);
+    merge_stall_timer_ = ADD_TIMER(profile_, "MergeStallTime");
+    merge_read_ahead_pages_counter_ =
+        ADD_COUNTER(profile_, "MergeReadAheadPages", TUnit::UNIT);
   } else {
     initial_runs_counter_ = ADD_COUNTER(profile_, "RunsCreated", TUnit::UNIT);
   }
@@ -870,8 +1172,17 @@ Status Sorter::Prepare(ObjectPool* obj_pool) {
 Status Sorter::Open() {
   DCHECK(in_mem_tuple_sorter_ != nullptr) << "Not prepared";
   DCHECK(unsorted_run_ == nullptr) << "Already open";
+  if (enable_spilling_) {
+    buffer_pool_client_->UseSortSpillCompression();
+    // Spilled runs are only read back when they are merged.
+    buffer_pool_client_->MarkSpilledPagesCold();
+  }
   RETURN_IF_ERROR(compare_less_than_->Open(&obj_pool_, state_, &expr_perm_pool_,
       &expr_results_pool_));
+  for (const unique_ptr<RangeSorter>& range_sorter : range_sorters_) {
+    RETURN_IF_ERROR(range_sorter->comparator->Open(&obj_pool_, state_,
+        &range_sorter->expr_perm_pool, &range_sorter->expr_results_pool));
+  }
   TupleDescriptor* sort_tuple_desc = output_row_desc_->tuple_descriptors()[0];
   unsorted_run_ = run_pool_.Add(new Run(this, sort_tuple_desc, true));
   RETURN_IF_ERROR(unsorted_run_->Init());
@@ -1014,11 +1325,19 @@ void Sorter::Reset() {
   // Free resources from the current runs.
   CleanupAllRuns();
   compare_less_than_->Close(state_);
+  for (const unique_ptr<RangeSorter>& range_sorter : range_sorters_) {
+    range_sorter->comparator->Close(state_);
+  }
 }
 
 void Sorter::Close(RuntimeState* state) {
   CleanupAllRuns();
   compare_less_than_->Close(state);
+  for (const unique_ptr<RangeSorter>& range_sorter : range_sorters_) {
+    range_sorter->comparator->Close(state);
+    range_sorter->expr_perm_pool.FreeAll();
+    range_sorter->expr_results_pool.FreeAll();
+  }
   ScalarExprEvaluator::Close(sort_tuple_expr_evals_, state);
   expr_perm_pool_.FreeAll();
   expr_results_pool_.FreeAll();
@@ -1154,8 +1473,8 @@ Status Sorter::CreateMerger(int num_runs) {
   // TODO: 'deep_copy_input' is set to true, which forces the merger to copy all rows
   // from the runs being merged. This is unnecessary overhead that is not required if we
   // correctly transfer resources.
-  merger_.reset(
-      new SortedRunMerger(*compare_less_than_, output_row_desc_, profile_, true));
+  merger_.reset(new SortedRunMerger(*compare_less_than_, output_row_desc_, profile_,
+      true, state_->query_options().sort_key_prefix));
 
   vector<function<Status (RowBatch**)>> merge_runs;
   merge_runs.reserve(num_runs);
@@ -1171,6 +1490,16 @@ Status Sorter::CreateMerger(int num_runs) {
   }
   RETURN_IF_ERROR(merger_->Prepare(merge_runs));
 
+  // The runs pin their pages ahead with the reservation that is left after the first
+  // pages of the runs are pinned, except for the pages that the output run of an
+  // intermediate merge needs.
+  int output_run_pages = 0;
+  if (!sorted_runs_.empty()) {
+    output_run_pages = output_row_desc_->tuple_descriptors()[0]->HasVarlenSlots() ? 2 : 1;
+  }
+  merge_read_ahead_budget_ = max<int>(0,
+      buffer_pool_client_->GetUnusedReservation() / page_len_ - output_run_pages);
+
   num_merges_counter_->Add(1);
   return Status::OK();
 }
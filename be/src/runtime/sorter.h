@@ -19,6 +19,8 @@
 #define IMPALA_RUNTIME_SORTER_H_
 
 #include <deque>
+#include <memory>
+#include <vector>
 
 #include "runtime/bufferpool/buffer-pool.h"
 #include "util/runtime-profile.h"
@@ -166,6 +168,7 @@ class Sorter {
  private:
   class Page;
   class Run;
+  struct RangeSorter;
 
   /// Minimum value for sot_run_bytes_limit query option.
   static const int64_t MIN_SORT_RUN_BYTES_LIMIT = 32 << 20; // 32 MB
@@ -243,6 +246,9 @@ class Sorter {
   /// Runtime state instance used to check for cancellation. Not owned.
   RuntimeState* const state_;
 
+  /// Used to create the comparators of 'range_sorters_'. Owned by the plan node.
+  const TupleRowComparatorConfig& tuple_row_comparator_config_;
+
   /// MemPool for allocating data structures used by expression evaluators in the sorter.
   MemPool expr_perm_pool_;
 
@@ -254,6 +260,11 @@ class Sorter {
   boost::scoped_ptr<TupleRowComparator> compare_less_than_;
   boost::scoped_ptr<TupleSorter> in_mem_tuple_sorter_;
 
+  /// The sorters that the threads of ExecEnv::sort_pool() use to sort ranges of a run
+  /// in parallel with 'in_mem_tuple_sorter_'. One less than the sort_run_threads query
+  /// option, or empty if the runs are sorted by a single thread.
+  std::vector<std::unique_ptr<RangeSorter>> range_sorters_;
+
   /// A reference to the codegened version of TupleSorter::SortHelper() that is stored
   /// inside SortPlanNode and PartialSortPlanNode.
   const CodegenFnPtr<SortHelperFn>& codegend_sort_helper_fn_;
@@ -308,6 +319,11 @@ class Sorter {
   /// in Sorter::Close() in case of errors.
   Run* merge_output_run_;
 
+  /// Number of pages of reservation that the runs of the current merge may use to pin
+  /// pages ahead of the pages they read. Computed in CreateMerger() from the
+  /// reservation that is left after the merge has pinned the pages it needs.
+  int merge_read_ahead_budget_ = 0;
+
   /// Pool of owned Run objects. Maintains Runs objects across non-freeing Reset() calls.
   ObjectPool run_pool_;
 
@@ -333,6 +349,16 @@ class Sorter {
   /// Time spent sorting initial runs in memory.
   RuntimeProfile::Counter* in_mem_sort_timer_;
 
+  /// Number of initial runs that were sorted by more than one thread. Only set if
+  /// 'range_sorters_' is not empty.
+  RuntimeProfile::Counter* parallel_sorted_runs_counter_ = nullptr;
+
+  /// Time spent by merges waiting for pages of spilled runs to be read from disk.
+  RuntimeProfile::Counter* merge_stall_timer_ = nullptr;
+
+  /// Number of pages of spilled runs that merges pinned ahead of reading them.
+  RuntimeProfile::Counter* merge_read_ahead_pages_counter_ = nullptr;
+
   /// Total size of the initial runs in bytes.
   RuntimeProfile::Counter* sorted_data_size_;
 
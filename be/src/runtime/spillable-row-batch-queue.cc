@@ -29,7 +29,8 @@ namespace impala {
 SpillableRowBatchQueue::SpillableRowBatchQueue(const string& name,
     int64_t max_unpinned_bytes, RuntimeState* state, MemTracker* mem_tracker,
     RuntimeProfile* profile, const RowDescriptor* row_desc,
-    const TBackendResourceProfile& resource_profile, const TDebugOptions& debug_options)
+    const TBackendResourceProfile& resource_profile, const TDebugOptions& debug_options,
+    bool compress_batches)
   : name_(name),
     state_(state),
     mem_tracker_(mem_tracker),
@@ -37,7 +38,12 @@ SpillableRowBatchQueue::SpillableRowBatchQueue(const string& name,
     row_desc_(row_desc),
     resource_profile_(resource_profile),
     debug_options_(debug_options),
-    max_unpinned_bytes_(max_unpinned_bytes) {
+    max_unpinned_bytes_(max_unpinned_bytes),
+    compress_batches_(compress_batches),
+    max_compressed_bytes_(compress_batches ?
+            max<int64_t>(resource_profile.max_reservation
+                - resource_profile.min_reservation, 0) :
+            0) {
   DCHECK_GT(max_unpinned_bytes_, 0);
   DCHECK_GT(resource_profile_.spillable_buffer_size, 0);
 }
@@ -60,15 +66,71 @@ Status SpillableRowBatchQueue::Open() {
   RETURN_IF_ERROR(batch_queue_->Init(name_, true));
   bool got_reservation = false;
   RETURN_IF_ERROR(batch_queue_->PrepareForReadWrite(true, &got_reservation));
-  DCHECK(got_reservation) << "SpillableRowBatchQueue failed to get reservation using "
-                          << "buffer pool client: "
-                          << reservation_manager_.buffer_pool_client()->DebugString();
+  // The planner includes the read and write buffers in the minimum reservation, unless
+  // the queue is used by a node that it did not reserve memory for.
+  DCHECK(got_reservation || resource_profile_.min_reservation == 0)
+      << "SpillableRowBatchQueue failed to get reservation using buffer pool client: "
+      << reservation_manager_.buffer_pool_client()->DebugString();
+  if (!got_reservation) {
+    return Status(Substitute("$0 failed to get reservation for its read and write "
+        "buffers using buffer pool client: $1", name_,
+        reservation_manager_.buffer_pool_client()->DebugString()));
+  }
+  if (compress_batches_) {
+    rows_compressed_counter_ =
+        ADD_COUNTER(profile_, "SpooledRowsCompressed", TUnit::UNIT);
+    uncompressed_bytes_counter_ =
+        ADD_COUNTER(profile_, "SpooledBytesBeforeCompression", TUnit::BYTES);
+    compressed_bytes_counter_ =
+        ADD_COUNTER(profile_, "SpooledBytesAfterCompression", TUnit::BYTES);
+  }
   return Status::OK();
 }
 
 Status SpillableRowBatchQueue::AddBatch(RowBatch* batch) {
   DCHECK(!IsFull()) << "Cannot AddBatch on a full SpillableRowBatchQueue";
   DCHECK(!closed_) << "Cannot AddBatch on a closed SpillableRowBatchQueue";
+  if (compress_batches_) {
+    // Only compress the batch if no rows are waiting in the stream, so that the rows
+    // are returned in the order they were added. Batches with more rows than the
+    // batches returned by GetBatch() go to the stream, which splits them.
+    if (batch_queue_->num_rows() == batch_queue_->rows_returned()
+        && batch->num_rows() <= state_->batch_size()) {
+      bool added;
+      RETURN_IF_ERROR(AddCompressedBatch(batch, &added));
+      if (added) return Status::OK();
+    }
+    // The compressed batches use up the memory of the queue, so spill the uncompressed
+    // rows right away rather than pinning more pages of the stream.
+    if (!compressed_batches_.empty() && batch_queue_->is_pinned()) {
+      RETURN_IF_ERROR(state_->StartSpilling(mem_tracker_));
+      RETURN_IF_ERROR(
+          batch_queue_->UnpinStream(BufferedTupleStream::UNPIN_ALL_EXCEPT_CURRENT));
+      profile_->AppendExecOption("Spilled");
+    }
+  }
+  return AddBatchToStream(batch);
+}
+
+Status SpillableRowBatchQueue::AddCompressedBatch(RowBatch* batch, bool* added) {
+  DCHECK_EQ(batch_queue_->num_rows(), batch_queue_->rows_returned());
+  *added = false;
+  TRowBatch compressed_batch;
+  RETURN_IF_ERROR(batch->Serialize(&compressed_batch));
+  const int64_t bytes = compressed_batch.tuple_data.size()
+      + compressed_batch.tuple_offsets.size() * sizeof(int32_t);
+  if (compressed_bytes_ + bytes > max_compressed_bytes_) return Status::OK();
+  if (!mem_tracker_->TryConsume(bytes)) return Status::OK();
+  compressed_bytes_ += bytes;
+  COUNTER_ADD(rows_compressed_counter_, batch->num_rows());
+  COUNTER_ADD(uncompressed_bytes_counter_, compressed_batch.uncompressed_size);
+  COUNTER_ADD(compressed_bytes_counter_, compressed_batch.tuple_data.size());
+  compressed_batches_.push_back(move(compressed_batch));
+  *added = true;
+  return Status::OK();
+}
+
+Status SpillableRowBatchQueue::AddBatchToStream(RowBatch* batch) {
   Status status;
   FOREACH_ROW(batch, 0, batch_itr) {
     // AddRow should only return false if there was not enough unused reservation to
@@ -112,6 +174,30 @@ Status SpillableRowBatchQueue::AddBatch(RowBatch* batch) {
 Status SpillableRowBatchQueue::GetBatch(RowBatch* batch) {
   DCHECK(!IsEmpty()) << "Cannot GetBatch on an empty SpillableRowBatchQueue";
   DCHECK(!closed_) << "Cannot GetBatch on a closed SpillableRowBatchQueue";
+  // The compressed batches precede the rows in the stream.
+  if (!compressed_batches_.empty()) {
+    const TRowBatch& compressed_batch = compressed_batches_.front();
+    const int64_t bytes = compressed_batch.tuple_data.size()
+        + compressed_batch.tuple_offsets.size() * sizeof(int32_t);
+    {
+      // Decompress the batch and hand its rows and memory over to 'batch'.
+      RowBatch decompressed_batch(row_desc_, compressed_batch, mem_tracker_);
+      DCHECK_EQ(batch->num_rows(), 0);
+      const int num_rows = decompressed_batch.num_rows();
+      // AddBatch() only compresses batches that fit into 'batch'.
+      DCHECK_LE(num_rows, batch->capacity());
+      const int dest_idx = batch->AddRows(num_rows);
+      for (int i = 0; i < num_rows; ++i) {
+        batch->CopyRow(decompressed_batch.GetRow(i), batch->GetRow(dest_idx + i));
+      }
+      batch->CommitRows(num_rows);
+      decompressed_batch.TransferResourceOwnership(batch);
+    }
+    compressed_batches_.pop_front();
+    compressed_bytes_ -= bytes;
+    mem_tracker_->Release(bytes);
+    return Status::OK();
+  }
   bool eos = false;
   RETURN_IF_ERROR(batch_queue_->GetNext(batch, &eos));
   // Validate that the value of eos is consistent with IsEmpty().
@@ -134,7 +220,8 @@ bool SpillableRowBatchQueue::IsEmpty() const {
   // whether those rows have already been removed) and how many rows have been read from
   // the stream. If these values are equal, the queue is considered empty.
   DCHECK(!closed_);
-  return batch_queue_->num_rows() == batch_queue_->rows_returned();
+  return compressed_batches_.empty()
+      && batch_queue_->num_rows() == batch_queue_->rows_returned();
 }
 
 bool SpillableRowBatchQueue::IsOpen() const {
@@ -143,6 +230,9 @@ bool SpillableRowBatchQueue::IsOpen() const {
 
 void SpillableRowBatchQueue::Close() {
   if (closed_) return;
+  compressed_batches_.clear();
+  mem_tracker_->Release(compressed_bytes_);
+  compressed_bytes_ = 0;
   if (batch_queue_ != nullptr) {
     batch_queue_->Close(nullptr, RowBatch::FlushMode::NO_FLUSH_RESOURCES);
   }
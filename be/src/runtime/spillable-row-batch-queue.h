@@ -17,11 +17,14 @@
 
 #pragma once
 
+#include <deque>
 #include <queue>
 
+#include "gen-cpp/Results_types.h"
 #include "runtime/buffered-tuple-stream.h"
 #include "runtime/reservation-manager.h"
 #include "runtime/row-batch.h"
+#include "util/runtime-profile.h"
 
 namespace impala {
 
@@ -50,6 +53,16 @@ class RowBatch;
 /// amount of reserved memory the BufferedTupleStream can use as well as the size of the
 /// default and max page length used by the stream.
 ///
+/// If 'compress_batches' is true, batches are serialized and compressed with LZ4 and
+/// kept in memory in that form, at most resource_profile.max_reservation -
+/// resource_profile.min_reservation bytes of them, i.e. the memory that the stream would
+/// otherwise use for pinned pages. The compressed batches are tracked by 'mem_tracker',
+/// outside of the reservation. Batches that do not fit are added to the
+/// BufferedTupleStream, which is unpinned while there are compressed batches, so that
+/// the queue needs no more memory than without compression. Batches are only
+/// compressed while the stream is empty, so that all compressed batches precede the
+/// rows in the stream, and only if they have at most RuntimeState::batch_size() rows.
+///
 /// The remaining parameters are used to initialize the ReservationManager and
 /// BufferedTupleStream.
 class SpillableRowBatchQueue {
@@ -57,7 +70,7 @@ class SpillableRowBatchQueue {
   SpillableRowBatchQueue(const std::string& name, int64_t max_unpinned_bytes,
       RuntimeState* state, MemTracker* mem_tracker, RuntimeProfile* profile,
       const RowDescriptor* row_desc, const TBackendResourceProfile& resource_profile,
-      const TDebugOptions& debug_options);
+      const TDebugOptions& debug_options, bool compress_batches = false);
   ~SpillableRowBatchQueue();
 
   /// Creates and initializes the ReservationManager and BufferedTupleStream. Returns an
@@ -80,6 +93,8 @@ class SpillableRowBatchQueue {
   /// Returns and removes the RowBatch at the head of the queue. Returns Status::OK() if
   /// the batch was successfully read from the queue. It is not valid to call this method
   /// if the queue is empty or has already been closed.
+  /// If 'compress_batches' is true, 'batch' must be empty and have a capacity of at
+  /// least RuntimeState::batch_size().
   Status GetBatch(RowBatch* batch);
 
   /// Returns true if the queue limit has been reached, false otherwise. It is not valid
@@ -97,9 +112,24 @@ class SpillableRowBatchQueue {
   void Close();
 
  private:
-  /// BufferedTupleStream that stores all RowBatches.
+  /// Adds the rows of 'batch' to 'batch_queue_', unpinning it if it runs out of
+  /// reservation.
+  Status AddBatchToStream(RowBatch* batch);
+
+  /// Tries to compress 'batch' and add it to 'compressed_batches_'. Sets 'added' to
+  /// false if the compressed batch does not fit into the memory of the queue.
+  Status AddCompressedBatch(RowBatch* batch, bool* added);
+
+  /// BufferedTupleStream that stores all RowBatches that are not compressed.
   std::unique_ptr<BufferedTupleStream> batch_queue_;
 
+  /// The compressed RowBatches if 'compress_batches_' is true, in the order they were
+  /// added. They precede all rows in 'batch_queue_'.
+  std::deque<TRowBatch> compressed_batches_;
+
+  /// The number of bytes of 'compressed_batches_', consumed from 'mem_tracker_'.
+  int64_t compressed_bytes_ = 0;
+
   /// ReservationManager that manages the reserved memory and BufferPool::ClientHandle
   /// used by the BufferedTupleStream.
   ReservationManager reservation_manager_;
@@ -133,6 +163,18 @@ class SpillableRowBatchQueue {
   /// query option MAX_SPILLED_RESULT_SPOOLING_MEM.
   const int64_t max_unpinned_bytes_;
 
+  /// True if batches are kept compressed in memory.
+  const bool compress_batches_;
+
+  /// The max number of bytes of 'compressed_batches_'.
+  const int64_t max_compressed_bytes_;
+
+  /// The number of rows and the uncompressed and compressed bytes of the batches that
+  /// were added to 'compressed_batches_'. Only set if 'compress_batches_' is true.
+  RuntimeProfile::Counter* rows_compressed_counter_ = nullptr;
+  RuntimeProfile::Counter* uncompressed_bytes_counter_ = nullptr;
+  RuntimeProfile::Counter* compressed_bytes_counter_ = nullptr;
+
   /// True if the queue has been closed, false otherwise.
   bool closed_ = false;
 };
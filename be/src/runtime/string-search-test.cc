@@ -17,6 +17,7 @@
 
 #include <gtest/gtest.h>
 
+#include "runtime/multi-string-search.h"
 #include "runtime/string-search.h"
 
 namespace impala {
@@ -127,4 +128,49 @@ TEST(StringSearchTest, ReverseSearch) {
   // the same as the first one.
   EXPECT_EQ(0, TestRSearch("cacacbaba", "cacacba"));
 }
+// Returns whether any of 'needles' occurs in the first 'haystack_len' bytes of
+// 'haystack'. If the length is -1, use the full string length.
+bool TestMultiSearch(const char* haystack, const std::vector<std::string>& needles,
+    int haystack_len = -1) {
+  StringValue haystack_str_val = StrValFromCString(haystack, haystack_len);
+  MultiStringSearch search(needles);
+  return search.ContainsAny(haystack_str_val);
+}
+
+TEST(StringSearchTest, MultiSearch) {
+  EXPECT_TRUE(TestMultiSearch("connection timeout", {"timeout", "refused"}));
+  EXPECT_TRUE(TestMultiSearch("connection refused", {"timeout", "refused"}));
+  EXPECT_FALSE(TestMultiSearch("connection reset", {"timeout", "refused"}));
+  EXPECT_FALSE(TestMultiSearch("", {"a", "b"}));
+
+  // The empty needle is contained in any string.
+  EXPECT_TRUE(TestMultiSearch("", {"a", ""}));
+  EXPECT_TRUE(TestMultiSearch("xyz", {""}));
+
+  // Needles that are suffixes or prefixes of each other, which are found through the
+  // failure links of the automaton.
+  EXPECT_TRUE(TestMultiSearch("abcd", {"xabcde", "bc"}));
+  EXPECT_TRUE(TestMultiSearch("aaab", {"aab"}));
+  EXPECT_TRUE(TestMultiSearch("abababc", {"ababc", "bababa"}));
+  EXPECT_FALSE(TestMultiSearch("abababd", {"ababc", "bababb"}));
+
+  // Matches that start in the last bytes or cross 16 byte blocks of the prefiltered
+  // input.
+  EXPECT_TRUE(TestMultiSearch("0123456789abcdefghij", {"fgh", "zz"}));
+  EXPECT_TRUE(TestMultiSearch("0123456789abcdefghij", {"ij", "zz"}));
+  EXPECT_TRUE(TestMultiSearch("0123456789abcdefghij", {"ghij", "zz"}));
+  EXPECT_FALSE(TestMultiSearch("0123456789abcdefghij", {"ghij", "zz"}, 19));
+  EXPECT_FALSE(TestMultiSearch("0123456789abcdefghij", {"fgh", "zz"}, 17));
+
+  // Needles with more than 16 distinct first bytes are not prefiltered with SSE.
+  std::vector<std::string> needles;
+  for (char c = 'a'; c <= 'z'; ++c) needles.push_back(std::string(1, c) + "!");
+  EXPECT_TRUE(TestMultiSearch("0123456789ABCDEFGHIJ q!", needles));
+  EXPECT_FALSE(TestMultiSearch("0123456789ABCDEFGHIJ q?", needles));
+  EXPECT_FALSE(TestMultiSearch("0123456789ABCDEFGHIJ q!", needles, 22));
+
+  // Bytes with the high bit set.
+  EXPECT_TRUE(TestMultiSearch("caf\xc3\xa9 latte", {"\xc3\xa9", "tea"}));
+  EXPECT_FALSE(TestMultiSearch("cafe latte", {"\xc3\xa9", "tea"}));
+}
 }
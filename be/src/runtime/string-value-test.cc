@@ -119,6 +119,21 @@ TEST(StringValueTest, TestCompare) {
   EXPECT_EQ(chars[3].ptr[3], '4');
 }
 
+// Eq() compares strings of up to 16 bytes without memcmp(). Check that a difference in
+// any byte is detected for all lengths around the thresholds.
+TEST(StringValueTest, TestEq) {
+  for (int len = 0; len <= 40; ++len) {
+    string str1(len, 'a');
+    string str2(len, 'a');
+    EXPECT_TRUE(FromStdString(str1).Eq(FromStdString(str2))) << len;
+    for (int i = 0; i < len; ++i) {
+      str2[i] = 'b';
+      EXPECT_FALSE(FromStdString(str1).Eq(FromStdString(str2))) << len << " " << i;
+      str2[i] = 'a';
+    }
+  }
+}
+
 TEST(StringValueTest, TestConvertToUInt64) {
   // Test converting StringValues to uint64_t which utilizes up to first 8 bytes.
   EXPECT_EQ(StringValue("").ToUInt64(), 0);
@@ -57,9 +57,36 @@ inline int StringValue::Compare(const StringValue& other) const {
   return StringCompare(this->ptr, this->len, other.ptr, other.len, l);
 }
 
+/// Returns true if the 'len' bytes at 's1' and 's2' are equal. Strings of up to 16 bytes,
+/// e.g. the short codes that are common as grouping and join keys, are compared with two
+/// overlapping loads of each string instead of a call to memcmp(). The loads never read
+/// beyond the 'len' bytes.
+static inline bool StringEq(const char* s1, const char* s2, int len) {
+  if (len > 16) return memcmp(s1, s2, len) == 0;
+  if (len >= 8) {
+    uint64_t a0, a1, b0, b1;
+    memcpy(&a0, s1, 8);
+    memcpy(&b0, s2, 8);
+    memcpy(&a1, s1 + len - 8, 8);
+    memcpy(&b1, s2 + len - 8, 8);
+    return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+  }
+  if (len >= 4) {
+    uint32_t a0, a1, b0, b1;
+    memcpy(&a0, s1, 4);
+    memcpy(&b0, s2, 4);
+    memcpy(&a1, s1 + len - 4, 4);
+    memcpy(&b1, s2 + len - 4, 4);
+    return ((a0 ^ b0) | (a1 ^ b1)) == 0;
+  }
+  if (len == 0) return true;
+  // The first, middle and last bytes cover strings of 1 to 3 bytes.
+  return s1[0] == s2[0] && s1[len >> 1] == s2[len >> 1] && s1[len - 1] == s2[len - 1];
+}
+
 inline bool StringValue::Eq(const StringValue& other) const {
   if (this->len != other.len) return false;
-  return StringCompare(this->ptr, this->len, other.ptr, other.len, this->len) == 0;
+  return StringEq(this->ptr, other.ptr, this->len);
 }
 
 inline bool StringValue::operator==(const StringValue& other) const {
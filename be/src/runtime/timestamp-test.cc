@@ -27,6 +27,7 @@
 #include "runtime/raw-value.inline.h"
 #include "runtime/timestamp-value.h"
 #include "runtime/timestamp-value.inline.h"
+#include "runtime/timezone-offset-cache.h"
 #include "testutil/gtest-util.h"
 #include "util/string-parser.h"
 
@@ -1058,4 +1059,71 @@ TEST(TimestampTest, TimezoneConversions) {
     EXPECT_FALSE(tmp.HasDate());
   }
 }
+
+// Check that conversions through a TimezoneOffsetCache match the ones that look up the
+// offset in the time zone, around offset changes and over long jumps in time.
+TEST(TimestampTest, TimezoneOffsetCache) {
+  const string& path = Substitute("$0/testdata/tzdb_tiny", getenv("IMPALA_HOME"));
+  Status status = TimezoneDatabase::LoadZoneInfoBeTestOnly(path);
+  ASSERT_TRUE(status.ok());
+
+  for (const char* tz_name : {"CET", "America/New_York", "UTC"}) {
+    const Timezone* tz = TimezoneDatabase::FindTimezone(tz_name);
+    ASSERT_NE(tz, nullptr);
+    TimezoneOffsetCache cache(tz);
+    // Steps of 17 minutes and 1 nanosecond from 2016 to 2019 cross every offset change
+    // in both directions.
+    const boost::posix_time::time_duration step =
+        boost::posix_time::minutes(17) + boost::posix_time::nanoseconds(1);
+    for (TimestampValue ts = StrToTs("2016-01-01 00:00:00");
+         ts < StrToTs("2019-01-01 00:00:00"); ts = ts.Add(step)) {
+      TimestampValue expected = ts;
+      TimestampValue actual = ts;
+      expected.UtcToLocal(*tz);
+      actual.UtcToLocal(&cache);
+      EXPECT_EQ(expected, actual) << tz_name << " " << ts;
+      expected = ts;
+      actual = ts;
+      expected.LocalToUtc(*tz);
+      actual.LocalToUtc(&cache);
+      EXPECT_EQ(expected.HasDate(), actual.HasDate()) << tz_name << " " << ts;
+      if (expected.HasDate()) EXPECT_EQ(expected, actual) << tz_name << " " << ts;
+    }
+    // Jumps between times far apart, and to the limits of the supported range.
+    for (const char* str : {"1400-01-01 00:00:00", "2017-10-29 02:30:00",
+             "9999-12-31 23:59:59.999999999", "2017-03-26 02:30:00",
+             "1970-01-01 00:00:00", "2017-10-29 01:30:00", "1400-01-01 12:00:00",
+             "2017-07-01 12:00:00", "9999-12-31 00:00:00"}) {
+      const TimestampValue ts = StrToTs(str);
+      TimestampValue expected = ts;
+      TimestampValue actual = ts;
+      expected.UtcToLocal(*tz);
+      actual.UtcToLocal(&cache);
+      EXPECT_EQ(expected.HasDate(), actual.HasDate()) << tz_name << " " << str;
+      if (expected.HasDate()) EXPECT_EQ(expected, actual) << tz_name << " " << str;
+      expected = ts;
+      actual = ts;
+      expected.LocalToUtc(*tz);
+      actual.LocalToUtc(&cache);
+      EXPECT_EQ(expected.HasDate(), actual.HasDate()) << tz_name << " " << str;
+      if (expected.HasDate()) EXPECT_EQ(expected, actual) << tz_name << " " << str;
+    }
+  }
+
+  // The batched conversion gives the same local times as one by one conversion.
+  const Timezone* tz = TimezoneDatabase::FindTimezone("CET");
+  ASSERT_NE(tz, nullptr);
+  TimezoneOffsetCache batch_cache(tz);
+  TimezoneOffsetCache cache(tz);
+  vector<int64_t> unix_times;
+  // 2017-01-01 00:00:00 UTC in steps of 3 hours, with a jump back every 1000 values.
+  for (int i = 0; i < 10000; ++i) {
+    unix_times.push_back(1483228800 + (i % 1000 == 999 ? -i : i) * 3 * 3600);
+  }
+  vector<int64_t> local_times(unix_times.size());
+  batch_cache.UtcToLocal(unix_times.data(), unix_times.size(), local_times.data());
+  for (int i = 0; i < static_cast<int>(unix_times.size()); ++i) {
+    EXPECT_EQ(cache.UtcToLocal(unix_times[i]), local_times[i]) << unix_times[i];
+  }
+}
 }
@@ -41,6 +41,8 @@ namespace datetime_parse_util {
 struct DateTimeFormatContext;
 }
 
+class TimezoneOffsetCache;
+
 /// Represents either a (1) date and time, (2) a date with an undefined time, or (3)
 /// a time with an undefined date. In all cases, times have up to nanosecond resolution
 /// and the minimum and maximum dates are 1400-01-01 and 9999-12-31.
@@ -274,6 +276,12 @@ class TimestampValue {
   /// TimestampValue this function is called upon has both a valid date and time.
   void LocalToUtc(const Timezone& local_tz);
 
+  /// Same as UtcToLocal() and LocalToUtc() above, but looks up the UTC offset in
+  /// 'cache', which is cheaper when consecutive calls are for timestamps that are not
+  /// separated by an offset change of the time zone of 'cache'.
+  void UtcToLocal(TimezoneOffsetCache* cache);
+  void LocalToUtc(TimezoneOffsetCache* cache);
+
   void set_date(const boost::gregorian::date d) { date_ = d; Validate(); }
   void set_time(const boost::posix_time::time_duration t) { time_ = t; Validate(); }
   const boost::gregorian::date& date() const { return date_; }
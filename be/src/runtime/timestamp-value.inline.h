@@ -28,6 +28,7 @@
 #include "exprs/timezone_db.h"
 #include "kudu/util/int128.h"
 #include "gutil/walltime.h"
+#include "runtime/timezone-offset-cache.h"
 #include "util/arithmetic-util.h"
 
 namespace impala {
@@ -170,6 +171,34 @@ inline bool TimestampValue::UtcToUnixTimeLimitedRangeNanos(
   return true;
 }
 
+inline void TimestampValue::UtcToLocal(TimezoneOffsetCache* cache) {
+  DCHECK(HasDateAndTime());
+  time_t unix_time;
+  if (UNLIKELY(!UtcToUnixTime(&unix_time))) {
+    SetToInvalidDateTime();
+    return;
+  }
+  const int64_t nanos = time_.fractional_seconds();
+  *this = UtcFromUnixTimeTicks<1>(cache->UtcToLocal(unix_time));
+  // Time-zone conversion rules don't affect fractional seconds, leave them intact.
+  if (LIKELY(HasDate())) time_ += boost::posix_time::nanoseconds(nanos);
+}
+
+inline void TimestampValue::LocalToUtc(TimezoneOffsetCache* cache) {
+  DCHECK(HasDateAndTime());
+  // The local time counted as if it was UTC.
+  time_t local_time;
+  int64_t unix_time;
+  if (UNLIKELY(!UtcToUnixTime(&local_time))
+      || UNLIKELY(!cache->LocalToUtc(local_time, &unix_time))) {
+    SetToInvalidDateTime();
+    return;
+  }
+  const int64_t nanos = time_.fractional_seconds();
+  *this = UtcFromUnixTimeTicks<1>(unix_time);
+  if (LIKELY(HasDate())) time_ += boost::posix_time::nanoseconds(nanos);
+}
+
 /// Converts to Unix time (seconds since the Unix epoch) representation.
 /// Returns false if the conversion failed (unix_time will be undefined), otherwise
 /// true.
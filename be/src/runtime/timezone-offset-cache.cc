@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "runtime/timezone-offset-cache.h"
+
+#include <chrono>
+#include <limits>
+
+#include "cctz/civil_time.h"
+#include "cctz/time_zone.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+namespace {
+const cctz::civil_second UNIX_EPOCH_CIVIL(1970, 1, 1, 0, 0, 0);
+
+inline cctz::time_point<cctz::sys_seconds> UnixTimeToTimePoint(int64_t t) {
+  static const cctz::time_point<cctz::sys_seconds> epoch =
+      std::chrono::time_point_cast<cctz::sys_seconds>(
+          std::chrono::system_clock::from_time_t(0));
+  return epoch + cctz::sys_seconds(t);
+}
+
+inline int64_t TimePointToUnixTime(const cctz::time_point<cctz::sys_seconds>& tp) {
+  static const cctz::time_point<cctz::sys_seconds> epoch =
+      std::chrono::time_point_cast<cctz::sys_seconds>(
+          std::chrono::system_clock::from_time_t(0));
+  return (tp - epoch).count();
+}
+}
+
+void TimezoneOffsetCache::Reset(const Timezone* tz) {
+  tz_ = tz;
+  begin_ = end_ = offset_ = 0;
+  unique_begin_ = unique_end_ = 0;
+}
+
+void TimezoneOffsetCache::UtcToLocal(const int64_t* unix_times, int64_t num_values,
+    int64_t* local_times) {
+  DCHECK(tz_ != nullptr);
+  int64_t i = 0;
+  while (i < num_values) {
+    if (UNLIKELY(unix_times[i] < begin_ || unix_times[i] >= end_)) Refresh(unix_times[i]);
+    // Convert the run of values in the current interval without further lookups.
+    const int64_t begin = begin_;
+    const int64_t end = end_;
+    const int64_t offset = offset_;
+    for (; i < num_values && unix_times[i] >= begin && unix_times[i] < end; ++i) {
+      local_times[i] = unix_times[i] + offset;
+    }
+  }
+}
+
+void TimezoneOffsetCache::Refresh(int64_t unix_time) {
+  DCHECK(tz_ != nullptr);
+  const int64_t MIN_TIME = std::numeric_limits<int64_t>::min();
+  const int64_t MAX_TIME = std::numeric_limits<int64_t>::max();
+  const cctz::time_point<cctz::sys_seconds> tp = UnixTimeToTimePoint(unix_time);
+  offset_ = tz_->lookup(tp).offset;
+  // Offset changes are reported as the local times before ('from') and after ('to')
+  // the change, so the interval starts at 'to' of the last change at or before
+  // 'unix_time' and ends at 'from' of the next one, both in the offset of the interval.
+  cctz::time_zone::civil_transition trans;
+  begin_ = tz_->prev_transition(tp + cctz::sys_seconds(1), &trans) ?
+      (trans.to - UNIX_EPOCH_CIVIL) - offset_ : MIN_TIME;
+  end_ = tz_->next_transition(tp, &trans) ?
+      (trans.from - UNIX_EPOCH_CIVIL) - offset_ : MAX_TIME;
+  if (UNLIKELY(begin_ > unix_time || end_ <= unix_time)) {
+    // Should not happen, but an interval of a single second is always correct.
+    begin_ = unix_time;
+    end_ = unix_time + 1;
+  }
+  unique_begin_ = begin_ == MIN_TIME ? MIN_TIME : begin_ + MAX_OFFSET_CHANGE;
+  unique_end_ = end_ == MAX_TIME ? MAX_TIME : end_ - MAX_OFFSET_CHANGE;
+}
+
+bool TimezoneOffsetCache::LocalToUtcSlow(int64_t local_time, int64_t* unix_time) {
+  const cctz::time_zone::civil_lookup cl = tz_->lookup(UNIX_EPOCH_CIVIL + local_time);
+  if (cl.kind != cctz::time_zone::civil_lookup::UNIQUE) return false;
+  *unix_time = TimePointToUnixTime(cl.pre);
+  Refresh(*unix_time);
+  return true;
+}
+
+} // namespace impala
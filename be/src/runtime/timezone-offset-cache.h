@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+#include "common/compiler-util.h"
+#include "common/global-types.h"
+#include "common/logging.h"
+
+namespace impala {
+
+/// Caches the UTC offset of a time zone between two of its offset changes, so that
+/// converting runs of timestamps that are close to each other, which is the common
+/// case when scanning a table or evaluating an expression over a batch of rows, costs
+/// an addition instead of a search in the transitions of the time zone per timestamp.
+/// The cached interval moves when a timestamp outside of it is converted.
+///
+/// Times are in seconds since the Unix epoch. Local times are counted from 1970-01-01
+/// 00:00:00 in local time, i.e. as if the local time was a UTC time.
+///
+/// Not thread-safe. Each thread that converts timestamps needs its own cache, e.g. as
+/// thread-local UDF state or as a member of a column reader.
+class TimezoneOffsetCache {
+ public:
+  explicit TimezoneOffsetCache(const Timezone* tz = nullptr) : tz_(tz) {}
+
+  /// Switches the cache to 'tz' and drops the cached interval.
+  void Reset(const Timezone* tz);
+
+  const Timezone* timezone() const { return tz_; }
+
+  /// Returns the local time of the UTC time 'unix_time'.
+  int64_t UtcToLocal(int64_t unix_time) {
+    DCHECK(tz_ != nullptr);
+    if (UNLIKELY(unix_time < begin_ || unix_time >= end_)) Refresh(unix_time);
+    return unix_time + offset_;
+  }
+
+  /// Batched version of UtcToLocal() that converts the 'num_values' UTC times at
+  /// 'unix_times' and writes the local times to 'local_times'. The two may be the same.
+  void UtcToLocal(const int64_t* unix_times, int64_t num_values, int64_t* local_times);
+
+  /// Sets 'unix_time' to the UTC time of the local time 'local_time' and returns true.
+  /// Returns false if 'local_time' is skipped or repeated by an offset change, i.e. if
+  /// the local time does not correspond to exactly one UTC time.
+  bool LocalToUtc(int64_t local_time, int64_t* unix_time) {
+    DCHECK(tz_ != nullptr);
+    const int64_t candidate = local_time - offset_;
+    if (LIKELY(candidate >= unique_begin_ && candidate < unique_end_)) {
+      *unix_time = candidate;
+      return true;
+    }
+    return LocalToUtcSlow(local_time, unix_time);
+  }
+
+ private:
+  /// An upper bound of the change of the UTC offset at a transition. The largest
+  /// change in the tz database is a day, when Samoa moved across the date line.
+  static constexpr int64_t MAX_OFFSET_CHANGE = 2 * 24 * 60 * 60;
+
+  /// Looks up the interval between offset changes that contains 'unix_time'.
+  void Refresh(int64_t unix_time);
+
+  /// Converts 'local_time' with a lookup in the time zone and moves the cached interval
+  /// to its result.
+  bool LocalToUtcSlow(int64_t local_time, int64_t* unix_time);
+
+  const Timezone* tz_;
+
+  /// The UTC times [begin_, end_) have the UTC offset 'offset_'. Starts out empty.
+  int64_t begin_ = 0;
+  int64_t end_ = 0;
+  int64_t offset_ = 0;
+
+  /// The UTC times in [unique_begin_, unique_end_) are far enough from an offset change
+  /// that no time of another interval has the same local time.
+  int64_t unique_begin_ = 0;
+  int64_t unique_end_ = 0;
+};
+
+} // namespace impala
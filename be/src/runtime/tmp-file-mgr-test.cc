@@ -20,6 +20,7 @@
 #include <limits>
 #include <mutex>
 #include <numeric>
+#include <random>
 
 #include <boost/filesystem.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -48,6 +49,9 @@ using boost::filesystem::path;
 DECLARE_bool(disk_spill_encryption);
 DECLARE_int64(disk_spill_compression_buffer_limit_bytes);
 DECLARE_string(disk_spill_compression_codec);
+DECLARE_string(disk_spill_compression_codec_sort);
+DECLARE_bool(remote_tmp_cold_pages_first);
+DECLARE_int32(disk_spill_compression_probe_interval);
 DECLARE_bool(disk_spill_punch_holes);
 #ifndef NDEBUG
 DECLARE_int32(stress_scratch_write_delay_ms);
@@ -76,6 +80,7 @@ class TmpFileMgrTest : public ::testing::Test {
     // Reset query options that are modified by tests.
     FLAGS_disk_spill_encryption = false;
     FLAGS_disk_spill_compression_codec = "";
+    FLAGS_disk_spill_compression_codec_sort = "";
     FLAGS_disk_spill_punch_holes = false;
 #ifndef NDEBUG
     FLAGS_stress_scratch_write_delay_ms = 0;
@@ -179,8 +184,8 @@ class TmpFileMgrTest : public ::testing::Test {
 
   /// Helper to call the private FileGroup::AllocateSpace() method.
   static Status GroupAllocateSpace(TmpFileGroup* group, int64_t num_bytes,
-      TmpFile** file, int64_t* offset) {
-    return group->AllocateSpace(num_bytes, file, offset);
+      TmpFile** file, int64_t* offset, bool cold = false) {
+    return group->AllocateSpace(num_bytes, file, offset, cold);
   }
 
   /// Helper to set FileGroup::next_allocation_index_.
@@ -913,6 +918,73 @@ TEST_F(TmpFileMgrTest, TestDirectoryLimitsExhausted) {
   file_group_2.Close();
 }
 
+// Test that a client stops compressing after a page that does not compress, probes
+// again after --disk_spill_compression_probe_interval pages and can use the codec for
+// sort runs.
+TEST_F(TmpFileMgrTest, TestAdaptiveCompression) {
+  google::FlagSaver saver;
+  FLAGS_disk_spill_compression_buffer_limit_bytes = 1 * MEGABYTE;
+  FLAGS_disk_spill_compression_codec_sort = "zstd";
+  FLAGS_disk_spill_compression_probe_interval = 2;
+  TmpFileMgr tmp_file_mgr;
+  ASSERT_OK(tmp_file_mgr.InitCustom(
+      vector<string>{"/tmp/tmp-file-mgr-test.1"}, true, "lz4", true, metrics_.get()));
+  EXPECT_EQ(THdfsCompression::LZ4, tmp_file_mgr.compression_codec());
+  EXPECT_EQ(THdfsCompression::ZSTD, tmp_file_mgr.sort_compression_codec());
+  TmpFileGroup file_group(&tmp_file_mgr, io_mgr(), profile_, TUniqueId());
+
+  const int64_t PAGE_LEN = 4 * KILOBYTE;
+  vector<uint8_t> random_data(PAGE_LEN);
+  mt19937 rng(1234);
+  for (uint8_t& b : random_data) b = rng();
+  const vector<uint8_t> compressible_data(PAGE_LEN, 'a');
+
+  SpillCompressionState compression;
+  vector<unique_ptr<TmpWriteHandle>> handles;
+  vector<const vector<uint8_t>*> written_data;
+  WriteRange::WriteDoneCallback callback =
+      bind(mem_fn(&TmpFileMgrTest::SignalCallback), this, _1);
+  auto write = [&](const vector<uint8_t>& data) {
+    handles.emplace_back();
+    written_data.push_back(&data);
+    MemRange mem_range(const_cast<uint8_t*>(data.data()), data.size());
+    ASSERT_OK(
+        file_group.Write(mem_range, callback, &handles.back(), nullptr, &compression));
+    WaitForWrite(handles.back().get());
+  };
+
+  // Random data does not get smaller, so it is written uncompressed, and the next two
+  // pages bypass compression.
+  write(random_data);
+  EXPECT_FALSE(handles.back()->is_compressed());
+  EXPECT_EQ(2, compression.pages_to_bypass);
+  for (int i = 0; i < 2; ++i) {
+    write(compressible_data);
+    EXPECT_FALSE(handles.back()->is_compressed());
+  }
+  EXPECT_EQ(0, compression.pages_to_bypass);
+  // The next page probes again.
+  write(compressible_data);
+  EXPECT_TRUE(handles.back()->is_compressed());
+  EXPECT_EQ(THdfsCompression::LZ4, handles.back()->compression_codec_);
+  EXPECT_EQ(0, compression.pages_to_bypass);
+
+  compression.use_sort_codec = true;
+  write(compressible_data);
+  EXPECT_TRUE(handles.back()->is_compressed());
+  EXPECT_EQ(THdfsCompression::ZSTD, handles.back()->compression_codec_);
+  WaitForCallbacks(handles.size());
+
+  // All pages read back correctly, whichever way they were written.
+  for (int i = 0; i < handles.size(); ++i) {
+    vector<uint8_t> tmp(PAGE_LEN);
+    ASSERT_OK(file_group.Read(handles[i].get(), MemRange(tmp.data(), tmp.size())));
+    EXPECT_EQ(*written_data[i], tmp) << i;
+    file_group.DestroyWriteHandle(move(handles[i]));
+  }
+  file_group.Close();
+}
+
 // Test the directory parsing logic, including the various error cases.
 TEST_F(TmpFileMgrTest, TestDirectoryLimitParsing) {
   RemoveAndCreateDirs({"/tmp/tmp-file-mgr-test1", "/tmp/tmp-file-mgr-test2",
@@ -1621,6 +1693,55 @@ TEST_F(TmpFileMgrTest, TestMixDirectoryLimits) {
   EXPECT_EQ(0, local_buff_usage->GetValue());
 }
 
+/// Cold pages are allocated from the remote directory first, other pages from the local
+/// directory.
+TEST_F(TmpFileMgrTest, TestMixDirectoryColdPages) {
+  google::FlagSaver saver;
+  FLAGS_remote_tmp_cold_pages_first = true;
+  vector<string> tmp_create_dirs{{LOCAL_BUFFER_PATH, "/tmp/tmp-file-mgr-test-local"}};
+  vector<string> tmp_dirs{{LOCAL_BUFFER_PATH, "/tmp/tmp-file-mgr-test-local:2048"}};
+  TmpFileMgr tmp_file_mgr;
+  RemoveAndCreateDirs(tmp_create_dirs);
+  tmp_dirs.push_back(REMOTE_URL);
+  int64_t alloc_size = 1024;
+  int64_t file_size = 1024;
+  FLAGS_remote_tmp_file_size = "1K";
+
+  ASSERT_OK(tmp_file_mgr.InitCustom(tmp_dirs, false, "", false, metrics_.get()));
+  TUniqueId id;
+  TmpFileGroup file_group(&tmp_file_mgr, io_mgr(), profile_, id);
+
+  IntGauge* dir_usage_local = metrics_->FindMetricForTesting<IntGauge>(
+      "tmp-file-mgr.scratch-space-bytes-used.dir-0");
+  IntGauge* dir_usage_remote = metrics_->FindMetricForTesting<IntGauge>(
+      "tmp-file-mgr.scratch-space-bytes-used.dir-1");
+  ASSERT_TRUE(dir_usage_remote != nullptr);
+  ASSERT_TRUE(dir_usage_local != nullptr);
+
+  int64_t offset;
+  TmpFile* alloc_file;
+  ASSERT_OK(GroupAllocateSpace(&file_group, alloc_size, &alloc_file, &offset, true));
+  EXPECT_FALSE(alloc_file->is_local());
+  EXPECT_EQ(0, dir_usage_local->GetValue());
+  EXPECT_EQ(file_size, dir_usage_remote->GetValue());
+
+  ASSERT_OK(GroupAllocateSpace(&file_group, alloc_size, &alloc_file, &offset));
+  EXPECT_TRUE(alloc_file->is_local());
+  EXPECT_EQ(file_size, dir_usage_local->GetValue());
+  EXPECT_EQ(file_size, dir_usage_remote->GetValue());
+
+  // Without the flag, cold pages are allocated locally as long as there is room.
+  FLAGS_remote_tmp_cold_pages_first = false;
+  ASSERT_OK(GroupAllocateSpace(&file_group, alloc_size, &alloc_file, &offset, true));
+  EXPECT_TRUE(alloc_file->is_local());
+  EXPECT_EQ(2 * file_size, dir_usage_local->GetValue());
+  EXPECT_EQ(file_size, dir_usage_remote->GetValue());
+
+  file_group.Close();
+  EXPECT_EQ(0, dir_usage_local->GetValue());
+  EXPECT_EQ(0, dir_usage_remote->GetValue());
+}
+
 /// Config a value bigger than the max remote file size allowed, should be
 /// adjusted to the max size.
 TEST_F(TmpFileMgrTest, TestMixTmpFileLimits) {
@@ -68,6 +68,19 @@ DEFINE_string(disk_spill_compression_codec, "",
     "cost of requiring more CPU and memory resources to compress the data. Uses the same "
     "syntax as the COMPRESSION_CODEC query option, e.g. 'lz4', 'zstd', 'zstd:6'. If "
     "this is set, then --disk_spill_punch_holes must be enabled.");
+DEFINE_string(disk_spill_compression_codec_sort, "",
+    "(Advanced) If set, sort runs are compressed with this codec instead of "
+    "--disk_spill_compression_codec before spilling to disk, e.g. a stronger codec, "
+    "since sort runs are spilled once and read back sequentially. Uses the same syntax "
+    "as --disk_spill_compression_codec and only has an effect if that is set.");
+DEFINE_double(disk_spill_compression_min_ratio, 1.1,
+    "(Advanced) If a spilled page compresses by a smaller ratio than this, the client "
+    "that spilled it writes its next --disk_spill_compression_probe_interval pages "
+    "without compression, which saves the CPU time for data that does not compress, "
+    "e.g. already compressed strings or hashes. 0 always compresses pages.");
+DEFINE_int32(disk_spill_compression_probe_interval, 16,
+    "(Advanced) The number of pages that a client spills without compression after a "
+    "page did not compress well, see --disk_spill_compression_min_ratio.");
 DEFINE_int64(disk_spill_compression_buffer_limit_bytes, 512L * 1024L * 1024L,
     "(Advanced) Limit on the total bytes of compression buffers that will be used for "
     "spill-to-disk compression across all queries. If this limit is exceeded, some data "
@@ -78,6 +91,13 @@ DEFINE_bool(disk_spill_punch_holes, false,
     "the amount of scratch space used by queries, particularly in conjunction with "
     "disk spill compression. This option requires the filesystems of the directories "
     "in --scratch_dirs to support hole punching.");
+DEFINE_bool(scratch_direct_io, false,
+    "(Advanced) If true, spilled pages are written to and read from the files in "
+    "--scratch_dirs with O_DIRECT, which bypasses the page cache, so that spilling does "
+    "not evict other data from it or cause writeback stalls. Only pages whose buffer, "
+    "length and file offset are multiples of 4KB can use O_DIRECT, which excludes "
+    "compressed pages. Falls back to buffered I/O if the filesystem does not support "
+    "O_DIRECT.");
 DEFINE_string(scratch_dirs, "/tmp",
     "Writable scratch directories. "
     "This is a comma-separated list of directories. Each directory is "
@@ -109,6 +129,11 @@ DEFINE_bool(remote_tmp_files_avail_pool_lifo, false,
 DEFINE_bool(allow_spill_to_hdfs, false,
     "Spill to HDFS is a test-only feature, only when set true, the user can configure "
     "a HDFS scratch path.");
+DEFINE_bool(remote_tmp_cold_pages_first, false, "(Advanced) If true and remote scratch "
+    "space is configured, the pages that buffer pool clients mark as cold, i.e. sorted "
+    "runs and spilled hash join partitions, are written to the remote scratch space "
+    "first. The local scratch directories are then left to the other spilled pages. Cold "
+    "pages are written locally if the remote scratch space is at its limit.");
 DEFINE_int32(wait_for_spill_buffer_timeout_s, 60,
     "Specify the timeout duration waiting for the buffer to write (second). If a spilling"
     "opertion fails to get a buffer from the pool within the duration, the operation"
@@ -211,6 +236,18 @@ Status TmpFileMgr::InitCustom(const vector<string>& tmp_dir_specifiers,
           Substitute("Could not parse --disk_spill_compression_codec value '$0': $1",
               compression_codec, codec_parse_status.GetDetail()));
     }
+    sort_compression_codec_ = compression_codec_;
+    sort_compression_level_ = compression_level_;
+    if (compression_enabled() && !FLAGS_disk_spill_compression_codec_sort.empty()) {
+      codec_parse_status = ParseUtil::ParseCompressionCodec(
+          FLAGS_disk_spill_compression_codec_sort, &sort_compression_codec_,
+          &sort_compression_level_);
+      if (!codec_parse_status.ok()) {
+        return Status(Substitute(
+            "Could not parse --disk_spill_compression_codec_sort value '$0': $1",
+            FLAGS_disk_spill_compression_codec_sort, codec_parse_status.GetDetail()));
+      }
+    }
     if (compression_enabled()) {
       compressed_buffer_tracker_.reset(
           new MemTracker(FLAGS_disk_spill_compression_buffer_limit_bytes,
@@ -1130,7 +1167,7 @@ Status TmpFileGroup::AllocateLocalSpace(int64_t num_bytes, TmpFile** tmp_file,
 }
 
 Status TmpFileGroup::AllocateSpace(
-    int64_t num_bytes, TmpFile** tmp_file, int64_t* file_offset) {
+    int64_t num_bytes, TmpFile** tmp_file, int64_t* file_offset, bool cold) {
   // Since in eviction, it probably waits for the async upload task if it
   // reaches bytes limit, so it can be slow here.
   lock_guard<SpinLock> lock(lock_);
@@ -1140,6 +1177,17 @@ Status TmpFileGroup::AllocateSpace(
   // that some disks were at capacity.
   vector<int> at_capacity_dirs;
 
+  // Cold pages go to remote scratch space first, if it is configured.
+  bool tried_remote = false;
+  Status remote_status;
+  if (cold && FLAGS_remote_tmp_cold_pages_first
+      && tmp_file_mgr_->tmp_dirs_remote_ != nullptr) {
+    remote_status =
+        AllocateRemoteSpace(num_bytes, tmp_file, file_offset, &at_capacity_dirs);
+    if (remote_status.ok()) return remote_status;
+    tried_remote = true;
+  }
+
   if (!tmp_file_mgr_->tmp_dirs_.empty()) {
     // If alloc_full is set true, meaning all of the local directories are at capacity.
     bool alloc_full = false;
@@ -1152,8 +1200,10 @@ Status TmpFileGroup::AllocateSpace(
 
   // If can't find any space locally, allocate from remote scratch space.
   if (tmp_file_mgr_->tmp_dirs_remote_ != nullptr) {
-    Status remote_status =
-        AllocateRemoteSpace(num_bytes, tmp_file, file_offset, &at_capacity_dirs);
+    if (!tried_remote) {
+      remote_status =
+          AllocateRemoteSpace(num_bytes, tmp_file, file_offset, &at_capacity_dirs);
+    }
     if (remote_status.ok() || at_capacity_dirs.empty()) return remote_status;
   }
 
@@ -1188,16 +1238,19 @@ void TmpFileGroup::RecycleFileRange(unique_ptr<TmpWriteHandle> handle) {
 }
 
 Status TmpFileGroup::Write(MemRange buffer, WriteDoneCallback cb,
-    unique_ptr<TmpWriteHandle>* handle, const BufferPoolClientCounters* counters) {
+    unique_ptr<TmpWriteHandle>* handle, const BufferPoolClientCounters* counters,
+    SpillCompressionState* compression, bool cold) {
   DCHECK_GE(buffer.len(), 0);
 
   unique_ptr<TmpWriteHandle> tmp_handle(new TmpWriteHandle(this, cb));
+  tmp_handle->cold_ = cold;
   TmpWriteHandle* tmp_handle_ptr = tmp_handle.get(); // Pass ptr by value into lambda.
   WriteRange::WriteDoneCallback callback = [this, tmp_handle_ptr](
                                                const Status& write_status) {
     WriteComplete(tmp_handle_ptr, write_status);
   };
-  RETURN_IF_ERROR(tmp_handle->Write(io_ctx_.get(), buffer, callback, counters));
+  RETURN_IF_ERROR(
+      tmp_handle->Write(io_ctx_.get(), buffer, callback, counters, compression));
   *handle = move(tmp_handle);
   return Status::OK();
 }
@@ -1302,7 +1355,7 @@ Status TmpFileGroup::WaitForAsyncRead(
         compression_timer_, counters == nullptr ? nullptr : counters->compression_time);
     scoped_ptr<Codec> decompressor;
     status = Codec::CreateDecompressor(
-        nullptr, false, tmp_file_mgr_->compression_codec(), &decompressor);
+        nullptr, false, handle->compression_codec_, &decompressor);
     if (status.ok()) {
       int64_t decompressed_len = buffer.len();
       uint8_t* decompressed_buffer = buffer.data();
@@ -1414,7 +1467,8 @@ Status TmpFileGroup::RecoverWriteError(
   // Discard the scratch file range - we will not reuse ranges from a bad file.
   // Choose another file to try. Blacklisting ensures we don't retry the same file.
   // If this fails, the status will include all the errors in 'scratch_errors_'.
-  RETURN_IF_ERROR(AllocateSpace(handle->on_disk_len(), &tmp_file, &file_offset));
+  RETURN_IF_ERROR(
+      AllocateSpace(handle->on_disk_len(), &tmp_file, &file_offset, handle->cold_));
   return handle->RetryWrite(io_ctx_.get(), tmp_file, file_offset);
 }
 
@@ -1500,11 +1554,18 @@ int64_t TmpWriteHandle::on_disk_len() const {
 }
 
 Status TmpWriteHandle::Write(RequestContext* io_ctx, MemRange buffer,
-    WriteRange::WriteDoneCallback callback, const BufferPoolClientCounters* counters) {
+    WriteRange::WriteDoneCallback callback, const BufferPoolClientCounters* counters,
+    SpillCompressionState* compression) {
   DCHECK(!write_in_flight_);
   MemRange buffer_to_write = buffer;
-  if (parent_->tmp_file_mgr_->compression_enabled() && TryCompress(buffer, counters)) {
-    buffer_to_write = MemRange(compressed_.buffer(), compressed_len_);
+  if (parent_->tmp_file_mgr_->compression_enabled()) {
+    if (compression != nullptr && compression->pages_to_bypass > 0) {
+      // Recent pages of the client did not compress well.
+      --compression->pages_to_bypass;
+      if (counters != nullptr) COUNTER_ADD(counters->compression_bypassed_pages, 1);
+    } else if (TryCompress(buffer, compression, counters)) {
+      buffer_to_write = MemRange(compressed_.buffer(), compressed_len_);
+    }
   }
   // Ensure that the compressed buffer is freed on all the code paths where we did not
   // start the write successfully.
@@ -1520,7 +1581,8 @@ Status TmpWriteHandle::Write(RequestContext* io_ctx, MemRange buffer,
 
   // For the second unpin of a page, it will be written to a new file since the
   // content should be changed
-  RETURN_IF_ERROR(parent_->AllocateSpace(buffer_to_write.len(), &tmp_file, &file_offset));
+  RETURN_IF_ERROR(
+      parent_->AllocateSpace(buffer_to_write.len(), &tmp_file, &file_offset, cold_));
 
   if (FLAGS_disk_spill_encryption) {
     RETURN_IF_ERROR(EncryptAndHash(buffer_to_write, counters));
@@ -1561,18 +1623,22 @@ Status TmpWriteHandle::Write(RequestContext* io_ctx, MemRange buffer,
   return Status::OK();
 }
 
-bool TmpWriteHandle::TryCompress(
-    MemRange buffer, const BufferPoolClientCounters* counters) {
-  DCHECK(parent_->tmp_file_mgr_->compression_enabled());
+bool TmpWriteHandle::TryCompress(MemRange buffer, SpillCompressionState* compression,
+    const BufferPoolClientCounters* counters) {
+  TmpFileMgr* tmp_file_mgr = parent_->tmp_file_mgr_;
+  DCHECK(tmp_file_mgr->compression_enabled());
   SCOPED_TIMER2(parent_->compression_timer_,
       counters == nullptr ? nullptr : counters->compression_time);
   DCHECK_LT(compressed_len_, 0);
   DCHECK(compressed_.buffer() == nullptr);
+  const bool use_sort_codec = compression != nullptr && compression->use_sort_codec;
+  const THdfsCompression::type codec = use_sort_codec ?
+      tmp_file_mgr->sort_compression_codec() : tmp_file_mgr->compression_codec();
+  const int level = use_sort_codec ?
+      tmp_file_mgr->sort_compression_level() : tmp_file_mgr->compression_level();
   scoped_ptr<Codec> compressor;
-  Status status = Codec::CreateCompressor(nullptr, false,
-      Codec::CodecInfo(parent_->tmp_file_mgr_->compression_codec(),
-          parent_->tmp_file_mgr_->compression_level()),
-      &compressor);
+  Status status = Codec::CreateCompressor(
+      nullptr, false, Codec::CodecInfo(codec, level), &compressor);
   if (!status.ok()) {
     LOG(WARNING) << "Failed to compress, couldn't create compressor: "
                  << status.GetDetail();
@@ -1592,8 +1658,22 @@ bool TmpWriteHandle::TryCompress(
     compressed_.Release();
     return false;
   }
-  compressed_len_ = compressed_len;
   VLOG(3) << "Buffer size: " << buffer.len() << " compressed size: " << compressed_len;
+  if (counters != nullptr) {
+    COUNTER_ADD(counters->compression_input_bytes, buffer.len());
+    COUNTER_ADD(counters->compression_output_bytes, min(compressed_len, buffer.len()));
+  }
+  if (compression != nullptr && FLAGS_disk_spill_compression_min_ratio > 0
+      && compressed_len * FLAGS_disk_spill_compression_min_ratio > buffer.len()) {
+    compression->pages_to_bypass = FLAGS_disk_spill_compression_probe_interval;
+  }
+  if (compressed_len >= buffer.len()) {
+    // Writing the data uncompressed avoids decompressing it when it is read back.
+    compressed_.Release();
+    return false;
+  }
+  compressed_len_ = compressed_len;
+  compression_codec_ = codec;
   return true;
 }
 
@@ -60,6 +60,21 @@ class TmpFileBufferPool;
 class TmpFileGroup;
 class TmpWriteHandle;
 
+/// The adaptive spill-to-disk compression state of one client of a TmpFileGroup, e.g.
+/// a buffer pool client. The client passes it to each TmpFileGroup::Write() call and
+/// must not use it for concurrent calls. If a page that the client writes compresses
+/// by less than --disk_spill_compression_min_ratio, the client's next
+/// --disk_spill_compression_probe_interval pages are written without compression. The
+/// page after them probes whether the data compresses well again.
+struct SpillCompressionState {
+  /// If true, pages are compressed with the codec for sort runs,
+  /// --disk_spill_compression_codec_sort, instead of --disk_spill_compression_codec.
+  bool use_sort_codec = false;
+
+  /// The number of pages to write without compression before trying again.
+  int pages_to_bypass = 0;
+};
+
 /// TmpFileMgr provides an abstraction for management of temporary (a.k.a. scratch) files
 /// on the filesystem and I/O to and from them. TmpFileMgr manages multiple scratch
 /// directories across multiple devices, configured via the --scratch_dirs option.
@@ -314,6 +329,14 @@ class TmpFileMgr {
     return compression_codec_ != THdfsCompression::NONE;
   }
   int compression_level() const { return compression_level_; }
+
+  /// The codec and level for the sort runs that are spilled. The same as
+  /// compression_codec() and compression_level() unless
+  /// --disk_spill_compression_codec_sort is set.
+  THdfsCompression::type sort_compression_codec() const {
+    return sort_compression_codec_;
+  }
+  int sort_compression_level() const { return sort_compression_level_; }
   bool punch_holes() const { return punch_holes_; }
 
   /// The minimum size of hole that we will try to punch in a scratch file.
@@ -349,6 +372,10 @@ class TmpFileMgr {
   /// and ignored otherwise. -1 means not set/invalid.
   int compression_level_ = -1;
 
+  /// See sort_compression_codec().
+  THdfsCompression::type sort_compression_codec_ = THdfsCompression::NONE;
+  int sort_compression_level_ = -1;
+
   /// Whether hole punching is enabled.
   bool punch_holes_ = false;
 
@@ -420,10 +447,18 @@ class TmpFileGroup {
   /// cancelled. If non-null, the counters in 'counters' are updated with information
   /// about the write.
   ///
+  /// If spill-to-disk compression is enabled, 'compression' is the state of the calling
+  /// client, see SpillCompressionState. If it is NULL, every page is compressed with
+  /// --disk_spill_compression_codec.
+  ///
+  /// 'cold' marks data that is not expected to be read back soon. It is written to
+  /// remote scratch space first if --remote_tmp_cold_pages_first is set.
+  ///
   /// 'handle' must be destroyed by passing the DestroyWriteHandle() or RestoreData().
   Status Write(MemRange buffer, TmpFileMgr::WriteDoneCallback cb,
       std::unique_ptr<TmpWriteHandle>* handle,
-      const BufferPoolClientCounters* counters = nullptr);
+      const BufferPoolClientCounters* counters = nullptr,
+      SpillCompressionState* compression = nullptr, bool cold = false);
 
   /// Synchronously read the data referenced by 'handle' from the temporary file into
   /// 'buffer'. buffer.len() must be the same as handle->len(). Can only be called
@@ -502,9 +537,11 @@ class TmpFileGroup {
 
   /// Allocate 'num_bytes' bytes in a temporary file. Try multiple disks if error
   /// occurs. Returns an error only if no temporary files are usable or the scratch
-  /// limit is exceeded. Must be called without 'lock_' held.
-  Status AllocateSpace(
-      int64_t num_bytes, TmpFile** tmp_file, int64_t* file_offset) WARN_UNUSED_RESULT;
+  /// limit is exceeded. Local scratch space is used before remote scratch space, unless
+  /// 'cold' is true and --remote_tmp_cold_pages_first is set. Must be called without
+  /// 'lock_' held.
+  Status AllocateSpace(int64_t num_bytes, TmpFile** tmp_file, int64_t* file_offset,
+      bool cold = false) WARN_UNUSED_RESULT;
 
   /// Try to allocate 'num_bytes' bytes from local scratch space. Called by the
   /// AllocateSpace().
@@ -713,17 +750,22 @@ class TmpWriteHandle {
   /// 'compressed_len_' will be non-negative and 'compressed_' will be the temporary
   /// buffer used to hold the compressed data.
   /// If non-null, the counters in 'counters' are updated with information about the read.
+  /// 'compression' is the state of adaptive compression of the caller, if any.
   Status Write(io::RequestContext* io_ctx, MemRange buffer,
       TmpFileMgr::WriteDoneCallback callback,
-      const BufferPoolClientCounters* counters = nullptr);
+      const BufferPoolClientCounters* counters = nullptr,
+      SpillCompressionState* compression = nullptr);
 
   /// Try to compress 'buffer'. On success, returns true and 'compressed_' and
   /// 'compressed_len_' contain the buffer used (with the length reflecting the
   /// allocated size) and the length of the compressed data, respectively. On failure,
   /// returns false and 'compressed_' will be an empty buffer and 'compressed_len_'
-  /// will be -1. The reason for the failure to compress may be logged.
+  /// will be -1. The reason for the failure to compress may be logged. Also fails if
+  /// the data does not get smaller. Updates 'compression', if non-null, with how well
+  /// the data compressed.
   /// If non-null, the counters in 'counters' are updated with compression time.
-  bool TryCompress(MemRange buffer, const BufferPoolClientCounters* counters);
+  bool TryCompress(MemRange buffer, SpillCompressionState* compression,
+      const BufferPoolClientCounters* counters);
 
   /// Retry the write after the initial write failed with an error, instead writing to
   /// 'offset' of 'file'. 'write_in_flight_' must be true before calling.
@@ -769,6 +811,10 @@ class TmpWriteHandle {
   /// is in use, this is the uncompressed size. Set in Write().
   int64_t data_len_ = -1;
 
+  /// Whether the data is written to remote scratch space first, see
+  /// TmpFileGroup::Write().
+  bool cold_ = false;
+
   /// The DiskIoMgr write range for this write.
   boost::scoped_ptr<io::WriteRange> write_range_;
 
@@ -811,6 +857,10 @@ class TmpWriteHandle {
   /// amount of valid data in the buffer.
   int64_t compressed_len_ = -1;
 
+  /// The codec that the data in this range was compressed with. Only valid if
+  /// 'compressed_len_' is non-negative.
+  THdfsCompression::type compression_codec_ = THdfsCompression::NONE;
+
   /// Signalled when the write completes and 'write_in_flight_' becomes false, before
   /// 'cb_' is invoked.
   ConditionVariable write_complete_cv_;
@@ -31,6 +31,12 @@
 #include <regex>
 
 // Access the flags that are defined in RequestPoolService.
+DECLARE_bool(admission_mem_estimate_feedback);
+DECLARE_double(admission_mem_estimate_feedback_decay);
+DECLARE_double(admission_mem_estimate_feedback_margin);
+DECLARE_int32(admission_mem_estimate_feedback_capacity);
+DECLARE_bool(admission_queue_fair_share);
+DECLARE_string(admission_queue_user_weights);
 DECLARE_string(fair_scheduler_allocation_path);
 DECLARE_string(llama_site_path);
 
@@ -1172,4 +1178,118 @@ TEST_F(AdmissionControllerTest, TopNQueryCheck) {
 #endif
 }
 
+/// Test that the peak memory of completed queries is remembered per plan fingerprint
+/// and replaces the planner's estimate of later queries with the same plan.
+TEST_F(AdmissionControllerTest, MemEstimateFeedback) {
+  FLAGS_admission_mem_estimate_feedback = true;
+  FLAGS_admission_mem_estimate_feedback_margin = 1.5;
+  FLAGS_admission_mem_estimate_feedback_decay = 0.5;
+  FLAGS_admission_mem_estimate_feedback_capacity = 2;
+  AdmissionController* admission_controller = MakeAdmissionController();
+  RequestPoolService* request_pool_service = admission_controller->request_pool_service_;
+  TPoolConfig pool_config;
+  ASSERT_OK(request_pool_service->GetPoolConfig("default", &pool_config));
+
+  // Plans that only differ in their limits share a fingerprint.
+  TQueryExecRequest request;
+  request.plan_exec_info.emplace_back();
+  request.plan_exec_info.back().fragments.emplace_back();
+  TPlanFragment& fragment = request.plan_exec_info.back().fragments.back();
+  fragment.__isset.plan = true;
+  fragment.plan.nodes.emplace_back();
+  fragment.plan.nodes.back().node_type = TPlanNodeType::HDFS_SCAN_NODE;
+  fragment.plan.nodes.back().__set_label_detail("functional.alltypes");
+  fragment.plan.nodes.back().limit = 10;
+  const uint64_t fingerprint = AdmissionController::ComputePlanFingerprint(request);
+  fragment.plan.nodes.back().limit = 20;
+  ASSERT_EQ(fingerprint, AdmissionController::ComputePlanFingerprint(request));
+  fragment.plan.nodes.back().__set_label_detail("functional.alltypessmall");
+  const uint64_t other_fingerprint = AdmissionController::ComputePlanFingerprint(request);
+  ASSERT_NE(fingerprint, other_fingerprint);
+
+  lock_guard<mutex> lock(admission_controller->admission_ctrl_lock_);
+  ASSERT_EQ(-1, admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+  admission_controller->RecordMemFeedbackLocked(fingerprint, 100 * MEGABYTE);
+  ASSERT_EQ(
+      150 * MEGABYTE, admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+
+  // A lower peak is decayed towards, a higher one replaces the remembered peak.
+  admission_controller->RecordMemFeedbackLocked(fingerprint, 50 * MEGABYTE);
+  ASSERT_EQ(75 * MEGABYTE * 3 / 2,
+      admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+  admission_controller->RecordMemFeedbackLocked(fingerprint, 200 * MEGABYTE);
+  ASSERT_EQ(
+      300 * MEGABYTE, admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+
+  // The remembered estimate replaces the planner's estimate.
+  ScheduleState* schedule_state = MakeScheduleState(
+      "default", 0, pool_config, 2, 10 * MEGABYTE, 10 * MEGABYTE, false);
+  schedule_state->UpdateMemoryRequirements(
+      pool_config, admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+  ASSERT_EQ(300 * MEGABYTE, schedule_state->per_backend_mem_to_admit());
+  ASSERT_EQ(300 * MEGABYTE, schedule_state->coord_backend_mem_to_admit());
+
+  // The least recently updated plan is forgotten once the capacity is reached.
+  admission_controller->RecordMemFeedbackLocked(other_fingerprint, 10 * MEGABYTE);
+  admission_controller->RecordMemFeedbackLocked(fingerprint + 1, 10 * MEGABYTE);
+  ASSERT_EQ(-1, admission_controller->GetMemEstimateFeedbackLocked(fingerprint));
+  ASSERT_EQ(15 * MEGABYTE,
+      admission_controller->GetMemEstimateFeedbackLocked(other_fingerprint));
+}
+
+/// Test that queued queries are dequeued in weighted fair share order across users.
+TEST_F(AdmissionControllerTest, FairShareDequeue) {
+  FLAGS_admission_queue_fair_share = true;
+  AdmissionController* admission_controller = MakeAdmissionController();
+  // Init() fails on invalid weights before starting any threads.
+  FLAGS_admission_queue_user_weights = "bob:2,carol:0";
+  ASSERT_FALSE(admission_controller->Init().ok());
+  FLAGS_admission_queue_user_weights = "bob:2,carol";
+  ASSERT_FALSE(admission_controller->Init().ok());
+  admission_controller->user_weights_.clear();
+  admission_controller->user_weights_["bob"] = 2;
+  ASSERT_EQ(2, admission_controller->GetUserWeight("bob"));
+  ASSERT_EQ(1, admission_controller->GetUserWeight("alice"));
+
+  UniqueIdPB id;
+  TQueryExecRequest request;
+  TQueryOptions query_options;
+  std::unordered_set<NetworkAddressPB> blacklisted_executor_addresses;
+  AdmissionController::AdmissionRequest admission_request = {id, id, request,
+      query_options, nullptr, blacklisted_executor_addresses};
+  vector<unique_ptr<AdmissionController::QueueNode>> nodes;
+  AdmissionController::RequestQueue queue;
+  for (const string& user : {"alice", "alice", "bob", "carol"}) {
+    nodes.emplace_back(
+        new AdmissionController::QueueNode(admission_request, nullptr, nullptr));
+    nodes.back()->user = user;
+    queue.Enqueue(nodes.back().get());
+  }
+  AdmissionController::PoolStats stats(admission_controller, "test");
+  std::unordered_set<const AdmissionController::QueueNode*> skipped;
+  auto next = [&]() {
+    return admission_controller->GetNextToDequeue(queue, stats, skipped);
+  };
+
+  // Without running queries the earliest queued query is next.
+  ASSERT_EQ(nodes[0].get(), next());
+  // With one running query each, the weight of bob halves its share, so its query is
+  // next.
+  stats.UpdateUserNumRunning("alice", 1);
+  stats.UpdateUserNumRunning("bob", 1);
+  stats.UpdateUserNumRunning("carol", 1);
+  ASSERT_EQ(nodes[2].get(), next());
+  // Skipped queries are not returned. Ties go to the earliest queued query.
+  skipped.insert(nodes[2].get());
+  ASSERT_EQ(nodes[0].get(), next());
+  stats.UpdateUserNumRunning("bob", 1);
+  skipped.clear();
+  ASSERT_EQ(nodes[0].get(), next());
+
+  // Without fair share, the queue is first come, first served.
+  FLAGS_admission_queue_fair_share = false;
+  stats.UpdateUserNumRunning("alice", 5);
+  ASSERT_EQ(nodes[0].get(), next());
+}
+
 } // end namespace impala
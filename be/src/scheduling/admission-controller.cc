@@ -31,12 +31,15 @@
 #include "scheduling/schedule-state.h"
 #include "scheduling/scheduler.h"
 #include "service/impala-server.h"
+#include "util/auth-util.h"
 #include "util/bit-util.h"
 #include "util/debug-util.h"
+#include "util/hash-util.h"
 #include "util/metrics.h"
 #include "util/pretty-printer.h"
 #include "util/runtime-profile-counters.h"
 #include "util/scope-exit-trigger.h"
+#include "util/string-parser.h"
 #include "util/thread.h"
 #include "util/time.h"
 #include "util/uid-util.h"
@@ -60,6 +63,46 @@ DEFINE_int64_hidden(admission_control_stale_topic_threshold_ms, 5 * 1000,
     "capture most cases where the Impala daemon is disconnected from the statestore "
     "or topic updates are seriously delayed.");
 
+DEFINE_bool(admission_mem_estimate_feedback, false, "If true, the admission controller "
+    "remembers the peak memory consumption per backend of completed queries, keyed by "
+    "a fingerprint of their plan. Queries that have a matching fingerprint and no "
+    "MEM_LIMIT are admitted with the remembered peak, scaled by "
+    "--admission_mem_estimate_feedback_margin, instead of the planner's estimate.");
+DEFINE_double(admission_mem_estimate_feedback_margin, 1.25, "Factor by which the "
+    "remembered peak memory consumption of a query is scaled to compute the memory "
+    "to admit for later queries with the same plan. See "
+    "--admission_mem_estimate_feedback.");
+DEFINE_double(admission_mem_estimate_feedback_decay, 0.5, "Weight of the remembered "
+    "peak memory consumption of a plan when a later query with that plan consumes less "
+    "memory. 0 immediately forgets the old peak, 1 never lowers it. A higher peak "
+    "always replaces the remembered one. See --admission_mem_estimate_feedback.");
+DEFINE_int32(admission_mem_estimate_feedback_capacity, 10000, "Maximum number of "
+    "plans for which the peak memory consumption is remembered. The least recently "
+    "used plan is forgotten first. See --admission_mem_estimate_feedback.");
+DEFINE_int64(slow_executor_penalty_bytes, 1024L * 1024L * 1024L, "(Advanced) Bytes "
+    "that executors that are suspected to be degraded count as already assigned when "
+    "the scheduler assigns scan ranges. Suspected executors are only assigned scan "
+    "ranges once their peers received this many bytes more. 0 disables the penalty. "
+    "See --slow_executor_reports_to_suspect.");
+DEFINE_bool(admission_queue_backfill, false, "If true, queued queries that fit into the "
+    "available resources are admitted while an earlier query in the same pool's queue "
+    "cannot be admitted. Backfilling stops once the earliest blocked query has been "
+    "queued for --admission_queue_backfill_max_head_wait_ms, so that it is not delayed "
+    "indefinitely by smaller queries.");
+DEFINE_int64(admission_queue_backfill_max_head_wait_ms, 10 * 1000, "Time in ms that the "
+    "first query of a pool's queue that cannot be admitted may wait before later queries "
+    "are no longer admitted ahead of it. See --admission_queue_backfill.");
+DEFINE_bool(admission_queue_fair_share, false, "If true, queued queries of a pool are "
+    "admitted in weighted fair share order across users instead of first come, first "
+    "served: the next query to admit is the earliest queued query of the user with the "
+    "fewest running queries in the pool relative to the user's weight. Running queries "
+    "are only counted if they were admitted by this coordinator. See "
+    "--admission_queue_user_weights.");
+DEFINE_string(admission_queue_user_weights, "", "Comma-separated list of "
+    "<user>:<weight> pairs with the weights of users for "
+    "--admission_queue_fair_share. A user with twice the weight gets twice as many "
+    "running queries. Users that are not listed have weight 1.");
+
 namespace impala {
 
 const int64_t AdmissionController::PoolStats::HISTOGRAM_NUM_OF_BINS = 128;
@@ -104,6 +147,8 @@ const string TOTAL_RELEASED_METRIC_KEY_FORMAT =
   "admission-controller.total-released.$0";
 const string TIME_IN_QUEUE_METRIC_KEY_FORMAT =
   "admission-controller.time-in-queue-ms.$0";
+const string TOTAL_BACKFILLED_METRIC_KEY_FORMAT =
+  "admission-controller.total-backfilled.$0";
 const string AGG_NUM_RUNNING_METRIC_KEY_FORMAT =
   "admission-controller.agg-num-running.$0";
 const string AGG_NUM_QUEUED_METRIC_KEY_FORMAT =
@@ -154,6 +199,10 @@ const string AdmissionController::PROFILE_INFO_KEY_LAST_QUEUED_REASON =
 const string AdmissionController::PROFILE_INFO_KEY_ADMITTED_MEM =
     "Cluster Memory Admitted";
 const string AdmissionController::PROFILE_INFO_KEY_EXECUTOR_GROUP = "Executor Group";
+const string AdmissionController::PROFILE_INFO_KEY_MEM_ESTIMATE_FEEDBACK =
+    "Per-Host Memory Estimate From Previous Runs";
+const string AdmissionController::PROFILE_INFO_KEY_BACKFILLED =
+    "Admitted ahead of earlier queued queries";
 const string AdmissionController::PROFILE_INFO_KEY_STALENESS_WARNING =
     "Admission control state staleness";
 const string AdmissionController::PROFILE_TIME_SINCE_LAST_UPDATE_COUNTER_NAME =
@@ -641,6 +690,26 @@ AdmissionController::~AdmissionController() {
 }
 
 Status AdmissionController::Init() {
+  vector<string> user_weights;
+  if (!FLAGS_admission_queue_user_weights.empty()) {
+    boost::split(
+        user_weights, FLAGS_admission_queue_user_weights, boost::is_any_of(","));
+  }
+  for (const string& user_weight : user_weights) {
+    size_t pos = user_weight.rfind(':');
+    StringParser::ParseResult result = StringParser::PARSE_FAILURE;
+    double weight = 0;
+    if (pos != string::npos && pos > 0) {
+      const string weight_str = boost::trim_copy(user_weight.substr(pos + 1));
+      weight = StringParser::StringToFloat<double>(
+          weight_str.c_str(), weight_str.size(), &result);
+    }
+    if (result != StringParser::PARSE_SUCCESS || weight <= 0) {
+      return Status(Substitute("Invalid entry '$0' in --admission_queue_user_weights. "
+          "Expected <user>:<weight> with a positive weight.", user_weight));
+    }
+    user_weights_[boost::trim_copy(user_weight.substr(0, pos))] = weight;
+  }
   RETURN_IF_ERROR(Thread::Create("scheduling", "admission-thread",
       &AdmissionController::DequeueLoop, this, &dequeue_thread_));
   auto cb = [this](
@@ -711,6 +780,19 @@ void AdmissionController::PoolStats::Queue() {
   metrics_.total_queued->Increment(1L);
 }
 
+void AdmissionController::PoolStats::UpdateUserNumRunning(
+    const string& user, int64_t delta) {
+  int64_t& num_running = local_num_running_per_user_[user];
+  num_running += delta;
+  DCHECK_GE(num_running, 0);
+  if (num_running <= 0) local_num_running_per_user_.erase(user);
+}
+
+int64_t AdmissionController::PoolStats::GetUserNumRunning(const string& user) const {
+  auto it = local_num_running_per_user_.find(user);
+  return it == local_num_running_per_user_.end() ? 0 : it->second;
+}
+
 void AdmissionController::PoolStats::Dequeue(bool timed_out) {
   agg_num_queued_ -= 1;
   metrics_.agg_num_queued->Increment(-1L);
@@ -1173,6 +1255,10 @@ Status AdmissionController::SubmitForAdmission(const AdmissionRequest& request,
   RETURN_IF_ERROR(ResolvePoolAndGetConfig(
       request.request.query_ctx, &queue_node->pool_name, &queue_node->pool_cfg));
   request.summary_profile->AddInfoString("Request Pool", queue_node->pool_name);
+  if (FLAGS_admission_mem_estimate_feedback) {
+    queue_node->plan_fingerprint = ComputePlanFingerprint(request.request);
+  }
+  queue_node->user = GetEffectiveUser(request.request.query_ctx.session);
 
   {
     // Take lock to ensure the Dequeue thread does not modify the request queue.
@@ -1232,6 +1318,9 @@ Status AdmissionController::SubmitForAdmission(const AdmissionRequest& request,
       VLOG_RPC << "Top mem consuming queries: " << queue_node->not_admitted_details;
     }
     queue_node->initial_queue_reason = queue_node->not_admitted_reason;
+    // Set while holding 'admission_ctrl_lock_', the dequeue thread reads it to decide
+    // whether to backfill.
+    queue_node->wait_start_ms = MonotonicMillis();
     stats->Queue();
     queue->Enqueue(queue_node);
 
@@ -1248,7 +1337,6 @@ Status AdmissionController::SubmitForAdmission(const AdmissionRequest& request,
   request.summary_profile->AddInfoString(
       PROFILE_INFO_KEY_INITIAL_QUEUE_REASON, queue_node->initial_queue_reason);
 
-  queue_node->wait_start_ms = MonotonicMillis();
   *queued = true;
   return Status::OK();
 }
@@ -1391,6 +1479,10 @@ void AdmissionController::ReleaseQuery(const UniqueIdPB& query_id,
     num_released_backends_.erase(num_released_backends_.find(query_id));
     PoolStats* stats = GetPoolStats(running_query.request_pool);
     stats->ReleaseQuery(peak_mem_consumption);
+    stats->UpdateUserNumRunning(running_query.user, -1);
+    if (running_query.plan_fingerprint != 0 && peak_mem_consumption > 0) {
+      RecordMemFeedbackLocked(running_query.plan_fingerprint, peak_mem_consumption);
+    }
     // No need to update the Host Stats as they should have been updated in
     // ReleaseQueryBackends.
     pools_for_updates_.insert(running_query.request_pool);
@@ -1687,6 +1779,25 @@ void AdmissionController::UpdateClusterAggregates() {
   if (i > 0) VLOG_ROW << ss.str();
 }
 
+void AdmissionController::ComputeExecutorLoad(const ExecutorGroup& executor_group,
+    Scheduler::ExecutorLoadMap* executor_load) {
+  for (const BackendDescriptorPB& be_desc : executor_group.GetAllExecutorDescriptors()) {
+    auto it = host_stats_.find(NetworkAddressPBToString(be_desc.address()));
+    if (it == host_stats_.end()) continue;
+    const HostStats& host_stats = it->second;
+    double load = 0;
+    if (be_desc.admission_slots() > 0) {
+      load = static_cast<double>(host_stats.slots_in_use) / be_desc.admission_slots();
+    }
+    if (be_desc.admit_mem_limit() > 0) {
+      int64_t mem_reserved = max(host_stats.mem_reserved, host_stats.mem_admitted);
+      load = max(load, static_cast<double>(mem_reserved) / be_desc.admit_mem_limit());
+    }
+    double* host_load = &(*executor_load)[be_desc.ip_address()];
+    *host_load = max(*host_load, load);
+  }
+}
+
 Status AdmissionController::ComputeGroupScheduleStates(
     ClusterMembershipMgr::SnapshotPtr membership_snapshot, QueueNode* queue_node) {
   int64_t previous_membership_version = 0;
@@ -1734,6 +1845,11 @@ Status AdmissionController::ComputeGroupScheduleStates(
     return Status::OK();
   }
 
+  vector<BackendDescriptorPB> suspects;
+  if (FLAGS_slow_executor_penalty_bytes > 0) {
+    membership_snapshot->executor_blacklist.GetSuspects(&suspects);
+  }
+
   // We loop over the executor groups in a deterministic order. This means we will fill up
   // each executor group before considering an unused one. In particular, we will not try
   // to balance queries across executor groups equally.
@@ -1763,7 +1879,20 @@ Status AdmissionController::ComputeGroupScheduleStates(
     const string& group_name = executor_group->name();
     VLOG(3) << "Scheduling for executor group: " << group_name << " with "
             << executor_group->NumExecutors() << " executors";
-    const Scheduler::ExecutorConfig group_config = {*executor_group, coord_desc};
+    Scheduler::ExecutorLoadMap executor_load;
+    if (request.query_options.scheduler_load_penalty_bytes > 0) {
+      ComputeExecutorLoad(*executor_group, &executor_load);
+    }
+    // Executors that are suspected to be degraded count as fully loaded, so that scan
+    // ranges go to their peers unless those are loaded just as much.
+    int64_t min_load_penalty_bytes = 0;
+    for (const BackendDescriptorPB& suspect : suspects) {
+      if (executor_group->LookUpBackendDesc(suspect.address()) == nullptr) continue;
+      executor_load[suspect.ip_address()] = 1.0;
+      min_load_penalty_bytes = FLAGS_slow_executor_penalty_bytes;
+    }
+    const Scheduler::ExecutorConfig group_config = {
+        *executor_group, coord_desc, &executor_load, min_load_penalty_bytes};
     RETURN_IF_ERROR(scheduler_->Schedule(group_config, group_state.get()));
     DCHECK(!group_state->executor_group().empty());
     output_schedules->emplace_back(std::move(group_state), *orig_executor_group);
@@ -1806,7 +1935,8 @@ bool AdmissionController::FindGroupToAdmitOrReject(
   for (GroupScheduleState& group_state : queue_node->group_states) {
     const ExecutorGroup& executor_group = group_state.executor_group;
     ScheduleState* state = group_state.state.get();
-    state->UpdateMemoryRequirements(pool_config);
+    state->UpdateMemoryRequirements(
+        pool_config, GetMemEstimateFeedbackLocked(queue_node->plan_fingerprint));
 
     const string& group_name = executor_group.name();
     int64_t group_size = executor_group.NumExecutors();
@@ -1932,9 +2062,12 @@ void AdmissionController::DequeueLoop() {
                << " cluster_size=" << GetClusterSize(*membership_snapshot);
       if (max_to_dequeue == 0) continue; // to next pool.
 
-      while (max_to_dequeue > 0 && !queue.empty()) {
-        QueueNode* queue_node = queue.head();
-        DCHECK(queue_node != nullptr);
+      // Queries that could not be admitted in this iteration. Only non-empty if
+      // --admission_queue_backfill is true.
+      std::unordered_set<const QueueNode*> not_admitted;
+      while (max_to_dequeue > 0) {
+        QueueNode* queue_node = GetNextToDequeue(queue, *stats, not_admitted);
+        if (queue_node == nullptr) break;
         // Find a group that can admit the query
         bool is_cancelled = queue_node->admit_outcome->IsSet()
             && queue_node->admit_outcome->Get() == AdmissionOutcome::CANCELLED;
@@ -1947,9 +2080,8 @@ void AdmissionController::DequeueLoop() {
 
         if (!is_cancelled && !is_rejected
             && queue_node->admitted_schedule.get() == nullptr) {
-          // If no group was found, stop trying to dequeue.
-          // TODO(IMPALA-2968): Requests further in the queue may be blocked
-          // unnecessarily. Consider a better policy once we have better test scenarios.
+          // If no group was found, stop trying to dequeue unless later queries may be
+          // admitted ahead of the first query that cannot be admitted.
           LogDequeueFailed(queue_node, queue_node->not_admitted_reason);
           if (coordinator_resource_limited) {
             // Dequeue failed because of a resource issue that can't be solved by adding
@@ -1957,11 +2089,21 @@ void AdmissionController::DequeueLoop() {
             // limit on the coordinator.
             total_dequeue_failed_coordinator_limited_->Increment(1);
           }
-          break;
+          if (!FLAGS_admission_queue_backfill) break;
+          if (not_admitted.empty()
+              && MonotonicMillis() - queue_node->wait_start_ms
+                  >= FLAGS_admission_queue_backfill_max_head_wait_ms) {
+            VLOG_RPC << "Not backfilling pool " << pool_name << ", query "
+                     << PrintId(queue_node->admission_request.query_id)
+                     << " has been queued for too long";
+            break;
+          }
+          not_admitted.insert(queue_node);
+          continue;
         }
 
         // At this point we know that the query must be taken off the queue
-        queue.Dequeue();
+        queue.Remove(queue_node);
         --max_to_dequeue;
         VLOG(3) << "Dequeueing from stats for pool " << pool_name;
         stats->Dequeue(false);
@@ -2000,6 +2142,12 @@ void AdmissionController::DequeueLoop() {
         DCHECK(!is_cancelled);
         DCHECK(!is_rejected);
         DCHECK(queue_node->admitted_schedule != nullptr);
+        if (!not_admitted.empty()) {
+          VLOG_QUERY << "Backfilled query=" << PrintId(query_id) << " ahead of "
+                     << not_admitted.size() << " queries that cannot be admitted";
+          stats->metrics()->total_backfilled->Increment(1);
+          queue_node->profile->AddInfoString(PROFILE_INFO_KEY_BACKFILLED, "true");
+        }
         AdmitQuery(queue_node, true);
       }
       pools_for_updates_.insert(pool_name);
@@ -2044,6 +2192,33 @@ int64_t AdmissionController::GetMaxToDequeue(
   }
 }
 
+AdmissionController::QueueNode* AdmissionController::GetNextToDequeue(
+    RequestQueue& queue, const PoolStats& stats,
+    const std::unordered_set<const QueueNode*>& skipped) {
+  QueueNode* next = nullptr;
+  double next_share = 0;
+  queue.Iterate([&](QueueNode* node) {
+    if (skipped.find(node) != skipped.end()) return true;
+    if (!FLAGS_admission_queue_fair_share) {
+      next = node;
+      return false;
+    }
+    // Ties are resolved in favor of the query that was queued first.
+    double share = stats.GetUserNumRunning(node->user) / GetUserWeight(node->user);
+    if (next == nullptr || share < next_share) {
+      next = node;
+      next_share = share;
+    }
+    return true;
+  });
+  return next;
+}
+
+double AdmissionController::GetUserWeight(const string& user) const {
+  auto it = user_weights_.find(user);
+  return it == user_weights_.end() ? 1.0 : it->second;
+}
+
 void AdmissionController::LogDequeueFailed(QueueNode* node,
     const string& not_admitted_reason) {
   VLOG_QUERY << "Could not dequeue query id=" << PrintId(node->admission_request.query_id)
@@ -2093,6 +2268,11 @@ void AdmissionController::AdmitQuery(QueueNode* node, bool was_queued) {
       PROFILE_INFO_KEY_ADMISSION_RESULT, admission_result);
   state->summary_profile()->AddInfoString(
       PROFILE_INFO_KEY_ADMITTED_MEM, PrintBytes(state->GetClusterMemoryToAdmit()));
+  int64_t mem_estimate_feedback = GetMemEstimateFeedbackLocked(node->plan_fingerprint);
+  if (mem_estimate_feedback >= 0) {
+    state->summary_profile()->AddInfoString(
+        PROFILE_INFO_KEY_MEM_ESTIMATE_FEEDBACK, PrintBytes(mem_estimate_feedback));
+  }
   state->summary_profile()->AddInfoString(
       PROFILE_INFO_KEY_EXECUTOR_GROUP, state->executor_group());
   // We may have admitted based on stale information. Include a warning in the profile
@@ -2123,6 +2303,9 @@ void AdmissionController::AdmitQuery(QueueNode* node, bool was_queued) {
   RunningQuery& running_query = it->second[state->query_id()];
   running_query.request_pool = state->request_pool();
   running_query.executor_group = state->executor_group();
+  running_query.plan_fingerprint = node->plan_fingerprint;
+  running_query.user = node->user;
+  GetPoolStats(*state)->UpdateUserNumRunning(node->user, 1);
   for (const auto& entry : state->per_backend_schedule_states()) {
     BackendAllocation& allocation = running_query.per_backend_resources[entry.first];
     allocation.slots_to_use = entry.second.exec_params->slots_to_use();
@@ -2130,6 +2313,97 @@ void AdmissionController::AdmitQuery(QueueNode* node, bool was_queued) {
   }
 }
 
+uint64_t AdmissionController::ComputePlanFingerprint(const TQueryExecRequest& request) {
+  // Only the shape of the plan and the tables and expressions in the node labels are
+  // hashed, so that queries that only differ in their literals share a fingerprint.
+  uint64_t hash = HashUtil::MurmurHash2_64(
+      &request.stmt_type, sizeof(request.stmt_type), HashUtil::MURMUR_DEFAULT_SEED);
+  const int32_t mt_dop = request.query_ctx.client_request.query_options.mt_dop;
+  hash = HashUtil::MurmurHash2_64(&mt_dop, sizeof(mt_dop), hash);
+  for (const TPlanExecInfo& plan_exec_info : request.plan_exec_info) {
+    for (const TPlanFragment& fragment : plan_exec_info.fragments) {
+      if (!fragment.__isset.plan) continue;
+      for (const TPlanNode& node : fragment.plan.nodes) {
+        hash = HashUtil::MurmurHash2_64(&node.node_type, sizeof(node.node_type), hash);
+        hash =
+            HashUtil::MurmurHash2_64(&node.num_children, sizeof(node.num_children), hash);
+        hash = HashUtil::MurmurHash2_64(
+            node.label_detail.data(), node.label_detail.size(), hash);
+      }
+    }
+  }
+  // 0 is reserved for queries without a fingerprint.
+  return hash == 0 ? 1 : hash;
+}
+
+int64_t AdmissionController::GetMemEstimateFeedbackLocked(uint64_t plan_fingerprint) {
+  if (plan_fingerprint == 0) return -1;
+  auto it = mem_estimate_feedback_.find(plan_fingerprint);
+  if (it == mem_estimate_feedback_.end()) return -1;
+  return static_cast<int64_t>(
+      it->second.peak_mem * FLAGS_admission_mem_estimate_feedback_margin);
+}
+
+void AdmissionController::RecordMemFeedbackLocked(
+    uint64_t plan_fingerprint, int64_t peak_mem) {
+  DCHECK_NE(plan_fingerprint, 0);
+  DCHECK_GT(peak_mem, 0);
+  auto it = mem_estimate_feedback_.find(plan_fingerprint);
+  if (it == mem_estimate_feedback_.end()) {
+    while (!mem_estimate_feedback_lru_.empty()
+        && static_cast<int64_t>(mem_estimate_feedback_lru_.size())
+            >= FLAGS_admission_mem_estimate_feedback_capacity) {
+      mem_estimate_feedback_.erase(mem_estimate_feedback_lru_.back());
+      mem_estimate_feedback_lru_.pop_back();
+    }
+    if (FLAGS_admission_mem_estimate_feedback_capacity <= 0) return;
+    mem_estimate_feedback_lru_.push_front(plan_fingerprint);
+    MemEstimateFeedback& feedback = mem_estimate_feedback_[plan_fingerprint];
+    feedback.peak_mem = peak_mem;
+    feedback.num_queries = 1;
+    feedback.lru_pos = mem_estimate_feedback_lru_.begin();
+    return;
+  }
+  MemEstimateFeedback& feedback = it->second;
+  // Grow immediately to avoid running out of memory again, but only shrink gradually
+  // so that a single small run does not cause the next one to be under-admitted.
+  if (peak_mem >= feedback.peak_mem) {
+    feedback.peak_mem = peak_mem;
+  } else {
+    const double decay = FLAGS_admission_mem_estimate_feedback_decay;
+    feedback.peak_mem = decay * feedback.peak_mem + (1 - decay) * peak_mem;
+  }
+  ++feedback.num_queries;
+  mem_estimate_feedback_lru_.splice(
+      mem_estimate_feedback_lru_.begin(), mem_estimate_feedback_lru_, feedback.lru_pos);
+}
+
+void AdmissionController::MemEstimateFeedbackToJson(rapidjson::Document* document) {
+  // Only the most recently used plans are shown to keep the page small.
+  const int MAX_PLANS_TO_SHOW = 100;
+  rapidjson::Value plans(rapidjson::kArrayType);
+  lock_guard<mutex> lock(admission_ctrl_lock_);
+  for (uint64_t plan_fingerprint : mem_estimate_feedback_lru_) {
+    if (plans.Size() >= MAX_PLANS_TO_SHOW) break;
+    const MemEstimateFeedback& feedback = mem_estimate_feedback_.at(plan_fingerprint);
+    rapidjson::Value plan(rapidjson::kObjectType);
+    stringstream fingerprint_ss;
+    fingerprint_ss << std::hex << plan_fingerprint;
+    rapidjson::Value fingerprint(fingerprint_ss.str().c_str(), document->GetAllocator());
+    plan.AddMember("plan_fingerprint", fingerprint, document->GetAllocator());
+    plan.AddMember("peak_mem", feedback.peak_mem, document->GetAllocator());
+    plan.AddMember("mem_estimate", GetMemEstimateFeedbackLocked(plan_fingerprint),
+        document->GetAllocator());
+    plan.AddMember("num_queries", feedback.num_queries, document->GetAllocator());
+    plans.PushBack(plan, document->GetAllocator());
+  }
+  document->AddMember("mem_estimate_feedback_enabled",
+      FLAGS_admission_mem_estimate_feedback, document->GetAllocator());
+  document->AddMember("num_mem_estimate_feedback_plans",
+      static_cast<uint64_t>(mem_estimate_feedback_.size()), document->GetAllocator());
+  document->AddMember("mem_estimate_feedback", plans, document->GetAllocator());
+}
+
 string AdmissionController::GetStalenessDetail(const string& prefix,
     int64_t* ms_since_last_update) {
   lock_guard<mutex> lock(admission_ctrl_lock_);
@@ -2164,9 +2438,14 @@ void AdmissionController::PoolToJsonLocked(const string& pool_name,
 
   // Get the queued queries
   Value queued_queries(kArrayType);
-  queue.Iterate([&queued_queries, document](QueueNode* node) {
+  const int64_t now_ms = MonotonicMillis();
+  queue.Iterate([&queued_queries, document, now_ms](QueueNode* node) {
+    Value query_info(kObjectType);
+    Value user(node->user.c_str(), document->GetAllocator());
+    query_info.AddMember("user", user, document->GetAllocator());
+    query_info.AddMember(
+        "wait_time_ms", now_ms - node->wait_start_ms, document->GetAllocator());
     if (node->group_states.empty()) {
-      Value query_info(kObjectType);
       query_info.AddMember("query_id", "N/A", document->GetAllocator());
       query_info.AddMember("mem_limit", 0, document->GetAllocator());
       query_info.AddMember("mem_limit_to_admit", 0, document->GetAllocator());
@@ -2175,7 +2454,6 @@ void AdmissionController::PoolToJsonLocked(const string& pool_name,
       return true;
     }
     ScheduleState* state = node->group_states.begin()->state.get();
-    Value query_info(kObjectType);
     Value query_id(PrintId(state->query_id()).c_str(), document->GetAllocator());
     query_info.AddMember("query_id", query_id, document->GetAllocator());
     query_info.AddMember(
@@ -2251,6 +2529,10 @@ void AdmissionController::PoolStats::ToJson(
       "total_rejected", metrics_.total_rejected->GetValue(), document->GetAllocator());
   pool->AddMember(
       "total_timed_out", metrics_.total_timed_out->GetValue(), document->GetAllocator());
+  pool->AddMember("total_backfilled", metrics_.total_backfilled->GetValue(),
+      document->GetAllocator());
+  pool->AddMember("time_in_queue_ms", metrics_.time_in_queue_ms->GetValue(),
+      document->GetAllocator());
   pool->AddMember("pool_max_mem_resources", metrics_.pool_max_mem_resources->GetValue(),
       document->GetAllocator());
   pool->AddMember("pool_max_requests", metrics_.pool_max_requests->GetValue(),
@@ -2299,6 +2581,7 @@ void AdmissionController::PoolStats::ResetInformationalStats() {
   metrics()->total_timed_out->SetValue(0);
   metrics()->total_released->SetValue(0);
   metrics()->time_in_queue_ms->SetValue(0);
+  metrics()->total_backfilled->SetValue(0);
 }
 
 void AdmissionController::PoolStats::InitMetrics() {
@@ -2316,6 +2599,8 @@ void AdmissionController::PoolStats::InitMetrics() {
       TOTAL_RELEASED_METRIC_KEY_FORMAT, 0, name_);
   metrics_.time_in_queue_ms = parent_->metrics_group_->AddCounter(
       TIME_IN_QUEUE_METRIC_KEY_FORMAT, 0, name_);
+  metrics_.total_backfilled = parent_->metrics_group_->AddCounter(
+      TOTAL_BACKFILLED_METRIC_KEY_FORMAT, 0, name_);
 
   metrics_.agg_num_running = parent_->metrics_group_->AddGauge(
       AGG_NUM_RUNNING_METRIC_KEY_FORMAT, 0, name_);
@@ -338,6 +338,8 @@ class AdmissionController {
   static const std::string PROFILE_INFO_KEY_LAST_QUEUED_REASON;
   static const std::string PROFILE_INFO_KEY_ADMITTED_MEM;
   static const std::string PROFILE_INFO_KEY_EXECUTOR_GROUP;
+  static const std::string PROFILE_INFO_KEY_MEM_ESTIMATE_FEEDBACK;
+  static const std::string PROFILE_INFO_KEY_BACKFILLED;
   static const std::string PROFILE_INFO_KEY_STALENESS_WARNING;
   static const std::string PROFILE_TIME_SINCE_LAST_UPDATE_COUNTER_NAME;
 
@@ -431,6 +433,11 @@ class AdmissionController {
   /// to JSON by adding members to 'resource_pools'.
   void AllPoolsToJson(rapidjson::Value* resource_pools, rapidjson::Document* document);
 
+  /// Serializes the remembered peak memory consumption of the most recently completed
+  /// plans (see --admission_mem_estimate_feedback) to JSON by adding members to
+  /// 'document'.
+  void MemEstimateFeedbackToJson(rapidjson::Document* document);
+
   /// Calls ResetInformationalStats on the pool identified by 'pool_name'.
   void ResetPoolInformationalStats(const std::string& pool_name);
 
@@ -528,6 +535,9 @@ class AdmissionController {
       IntCounter* total_timed_out;
       IntCounter* total_released;
       IntCounter* time_in_queue_ms;
+      /// Queries admitted from the queue ahead of an earlier query that could not be
+      /// admitted. See --admission_queue_backfill.
+      IntCounter* total_backfilled;
 
       /// The following mirror the current values in PoolStats.
       /// TODO: Avoid duplication: replace the int64_t fields on PoolStats with these.
@@ -577,6 +587,11 @@ class AdmissionController {
     void Queue();
     /// Updates the pool stats when the request represented by 'state is dequeued.
     void Dequeue(bool timed_out);
+    /// Updates the number of running queries of 'user' admitted by this controller by
+    /// 'delta'.
+    void UpdateUserNumRunning(const std::string& user, int64_t delta);
+    /// Returns the number of running queries of 'user' admitted by this controller.
+    int64_t GetUserNumRunning(const std::string& user) const;
 
     // STATESTORE CALLBACK METHODS
     /// Updates the local_stats_.backend_mem_reserved with the pool mem tracker. Called
@@ -676,6 +691,11 @@ class AdmissionController {
     /// Per-pool metrics, created by InitMetrics().
     PoolMetrics metrics_;
 
+    /// Map from effective user to the number of running queries of that user admitted by
+    /// this controller. Users without running queries are removed. Used to dequeue in
+    /// fair share order, see --admission_queue_fair_share.
+    boost::unordered_map<std::string, int64_t> local_num_running_per_user_;
+
     /// A histogram of the peak memory used by a query among all hosts. Its a vector of
     /// size 'HISTOGRAM_NUM_OF_BINS' and every i-th element represents the number of
     /// queries that had recorded a peak memory between (i, i+1] * HISTOGRAM_BIN_SIZE
@@ -778,6 +798,13 @@ class AdmissionController {
     string pool_name;
     TPoolConfig pool_cfg;
 
+    /// Fingerprint of the plan of the query, or 0 if --admission_mem_estimate_feedback
+    /// is false. See ComputePlanFingerprint().
+    uint64_t plan_fingerprint = 0;
+
+    /// Effective user of the query.
+    std::string user;
+
     /// END: Members that are valid for new objects after initialization
     /////////////////////////////////////////
 
@@ -834,7 +861,9 @@ class AdmissionController {
 
   /// Queue for the queries waiting to be admitted for execution. Once the
   /// maximum number of concurrently executing queries has been reached,
-  /// incoming queries are queued and admitted first come, first served.
+  /// incoming queries are queued and admitted first come, first served, unless
+  /// --admission_queue_backfill or --admission_queue_fair_share change the order. See
+  /// GetNextToDequeue().
   typedef InternalQueue<QueueNode> RequestQueue;
 
   /// Map of pool names to request queues.
@@ -863,6 +892,13 @@ class AdmissionController {
     /// Map from backend addresses to the resouces this query was allocated on them. When
     /// backends are released, they are removed from this map.
     std::unordered_map<NetworkAddressPB, BackendAllocation> per_backend_resources;
+
+    /// Fingerprint of the plan of this query, or 0 if it has none. See
+    /// ComputePlanFingerprint().
+    uint64_t plan_fingerprint = 0;
+
+    /// Effective user of this query.
+    std::string user;
   };
 
   /// Map from host id to a map from query id of currently running queries to information
@@ -878,6 +914,33 @@ class AdmissionController {
   typedef boost::unordered_map<std::string, TPoolConfig> PoolConfigMap;
   PoolConfigMap pool_config_map_;
 
+  /// Peak memory consumption of the completed queries with a given plan fingerprint.
+  struct MemEstimateFeedback {
+    /// Peak memory consumption per backend. Raised to the peak of a later query if that
+    /// is higher and decayed towards it otherwise.
+    int64_t peak_mem = 0;
+
+    /// Number of completed queries that contributed to 'peak_mem'.
+    int64_t num_queries = 0;
+
+    /// Position of the plan fingerprint in 'mem_estimate_feedback_lru_'.
+    std::list<uint64_t>::iterator lru_pos;
+  };
+
+  /// Map from plan fingerprint to the memory consumption of the completed queries with
+  /// that plan. Only used if --admission_mem_estimate_feedback is true. At most
+  /// --admission_mem_estimate_feedback_capacity entries are kept.
+  /// Protected by admission_ctrl_lock_.
+  std::unordered_map<uint64_t, MemEstimateFeedback> mem_estimate_feedback_;
+
+  /// Plan fingerprints in 'mem_estimate_feedback_', most recently updated first.
+  /// Protected by admission_ctrl_lock_.
+  std::list<uint64_t> mem_estimate_feedback_lru_;
+
+  /// Weights of users for fair share dequeuing, parsed from
+  /// --admission_queue_user_weights in Init(). Users not in the map have weight 1.
+  boost::unordered_map<std::string, double> user_weights_;
+
   /// Indicates whether a change in pool stats warrants an attempt by the dequeuing
   /// thread to dequeue.
   bool pending_dequeue_ = true;
@@ -923,6 +986,15 @@ class AdmissionController {
   /// Must hold admission_ctrl_lock_.
   void UpdateClusterAggregates();
 
+  /// Populates 'executor_load' with the load of the hosts of 'executor_group' for
+  /// load-aware scan range assignment. The load of an executor is the larger of the
+  /// fractions of its admission slots in use and of its admission memory limit that is
+  /// reserved or admitted, the quantities that admission checks against. A host with
+  /// several executors gets the load of its most loaded one.
+  /// Must hold admission_ctrl_lock_.
+  void ComputeExecutorLoad(const ExecutorGroup& executor_group,
+      Scheduler::ExecutorLoadMap* executor_load);
+
   /// Computes schedules for all executor groups that can run the query in 'queue_node'.
   /// For subsequent calls schedules are only re-computed if the membership version inside
   /// 'membership_snapshot' has changed. Will return any errors that occur during
@@ -997,6 +1069,20 @@ class AdmissionController {
   /// the 'state' is admitted.
   void UpdateStatsOnAdmission(const ScheduleState& state);
 
+  /// Returns a fingerprint of the plan of 'request' that does not depend on the literals
+  /// of the query, so that repeated runs of the same query with different parameters
+  /// map to the same fingerprint. Never returns 0.
+  static uint64_t ComputePlanFingerprint(const TQueryExecRequest& request);
+
+  /// Returns the per-backend memory to admit for queries with 'plan_fingerprint' based
+  /// on the previous queries with that plan, or -1 if there were none. Must hold
+  /// admission_ctrl_lock_.
+  int64_t GetMemEstimateFeedbackLocked(uint64_t plan_fingerprint);
+
+  /// Records that a query with 'plan_fingerprint' completed with a peak memory
+  /// consumption of 'peak_mem' on its busiest backend. Must hold admission_ctrl_lock_.
+  void RecordMemFeedbackLocked(uint64_t plan_fingerprint, int64_t peak_mem);
+
   /// Updates the memory admitted and the num of queries running for each backend in
   /// 'state' which have been release/completed. The list of completed backends is
   /// specified in 'host_addrs'. Also updates the stats related to the admitted memory of
@@ -1098,6 +1184,17 @@ class AdmissionController {
   int64_t GetMaxToDequeue(
       RequestQueue& queue, PoolStats* stats, const TPoolConfig& pool_config);
 
+  /// Returns the next query in 'queue' to try to admit, skipping the queries in
+  /// 'skipped', or nullptr if there is none. This is the first query in the queue unless
+  /// --admission_queue_fair_share is true, in which case it is the first query of the
+  /// user with the fewest running queries in the pool relative to the user's weight.
+  /// Must hold admission_ctrl_lock_.
+  QueueNode* GetNextToDequeue(RequestQueue& queue, const PoolStats& stats,
+      const std::unordered_set<const QueueNode*>& skipped);
+
+  /// Returns the weight of 'user' for fair share dequeuing.
+  double GetUserWeight(const std::string& user) const;
+
   /// Returns true if the pool has been disabled through configuration.
   static bool PoolDisabled(const TPoolConfig& pool_config);
 
@@ -1186,6 +1283,8 @@ class AdmissionController {
   FRIEND_TEST(AdmissionControllerTest, DedicatedCoordScheduleState);
   FRIEND_TEST(AdmissionControllerTest, DedicatedCoordAdmissionChecks);
   FRIEND_TEST(AdmissionControllerTest, TopNQueryCheck);
+  FRIEND_TEST(AdmissionControllerTest, MemEstimateFeedback);
+  FRIEND_TEST(AdmissionControllerTest, FairShareDequeue);
   friend class AdmissionControllerTest;
 };
 
@@ -36,6 +36,8 @@ using namespace impala::test;
 
 DECLARE_int32(statestore_max_missed_heartbeats);
 DECLARE_int32(statestore_heartbeat_frequency_ms);
+DECLARE_int32(slow_executor_reports_to_suspect);
+DECLARE_int32(slow_executor_reports_to_blacklist);
 
 namespace impala {
 
@@ -423,6 +425,49 @@ TEST_F(ClusterMembershipMgrTest, ExecutorBlacklist) {
   EXPECT_EQ(NUM_BACKENDS - 2, GetDefaultGroupSize(*backends_[0]->cmm));
 }
 
+// Tests that executors reported as slow are first suspected and eventually blacklisted.
+TEST_F(ClusterMembershipMgrTest, SlowExecutorReports) {
+  gflags::FlagSaver saver;
+  FLAGS_slow_executor_reports_to_suspect = 2;
+  FLAGS_slow_executor_reports_to_blacklist = 3;
+
+  const int NUM_BACKENDS = 3;
+  for (int i = 0; i < NUM_BACKENDS; ++i) CreateBackend();
+  while (!offline_.empty()) CreateCMM(offline_.front());
+  while (!starting_.empty()) StartBackend(starting_.front());
+  EXPECT_EQ(NUM_BACKENDS, running_.size());
+  ClusterMembershipMgr* cmm = backends_[0]->cmm.get();
+  const BackendDescriptorPB& slow_be_desc = *backends_[1]->desc;
+
+  // Reporting the local BE has no effect.
+  for (int i = 0; i < FLAGS_slow_executor_reports_to_blacklist; ++i) {
+    cmm->ReportSlowExecutor(backends_[0]->desc->backend_id(), "slow");
+  }
+  EXPECT_FALSE(cmm->GetSnapshot()->executor_blacklist.IsSuspected(*backends_[0]->desc));
+  EXPECT_EQ(NUM_BACKENDS, GetDefaultGroupSize(*cmm));
+
+  // The first report does not make the BE a suspect yet, the second one does.
+  cmm->ReportSlowExecutor(slow_be_desc.backend_id(), "slow");
+  EXPECT_FALSE(cmm->GetSnapshot()->executor_blacklist.IsSuspected(slow_be_desc));
+  cmm->ReportSlowExecutor(slow_be_desc.backend_id(), "slow");
+  EXPECT_TRUE(cmm->GetSnapshot()->executor_blacklist.IsSuspected(slow_be_desc));
+  vector<BackendDescriptorPB> suspects;
+  cmm->GetSnapshot()->executor_blacklist.GetSuspects(&suspects);
+  ASSERT_EQ(1, suspects.size());
+  EXPECT_EQ(slow_be_desc.address(), suspects[0].address());
+  // Suspected BEs can still be scheduled on.
+  EXPECT_EQ(NUM_BACKENDS, GetDefaultGroupSize(*cmm));
+
+  // The third report blacklists the BE.
+  cmm->ReportSlowExecutor(slow_be_desc.backend_id(), "slow");
+  const ExecutorBlacklist& blacklist = cmm->GetSnapshot()->executor_blacklist;
+  int64_t time_remaining_ms;
+  EXPECT_TRUE(blacklist.IsBlacklisted(slow_be_desc, nullptr, &time_remaining_ms));
+  EXPECT_FALSE(blacklist.IsSuspected(slow_be_desc));
+  EXPECT_EQ(NUM_BACKENDS, cmm->GetSnapshot()->current_backends.size());
+  EXPECT_EQ(NUM_BACKENDS - 1, GetDefaultGroupSize(*cmm));
+}
+
 // This test runs a group of 20 backends through their full lifecycle, validating that
 // their state is correctly propagated through the cluster after every change.
 TEST_F(ClusterMembershipMgrTest, FullLifecycleMultipleBackends) {
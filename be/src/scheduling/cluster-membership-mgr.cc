@@ -44,6 +44,8 @@ ExecutorGroup* FindOrInsertExecutorGroup(const ExecutorGroupDescPB& group,
 }
 }
 
+DECLARE_int32(slow_executor_reports_to_blacklist);
+
 namespace impala {
 
 static const string EMPTY_GROUP_NAME("empty group (using coordinator only)");
@@ -52,6 +54,9 @@ static const string LIVE_EXEC_GROUP_KEY("cluster-membership.executor-groups.tota
 static const string HEALTHY_EXEC_GROUP_KEY(
     "cluster-membership.executor-groups.total-healthy");
 static const string TOTAL_BACKENDS_KEY("cluster-membership.backends.total");
+static const string SUSPECTED_EXECUTORS_KEY("cluster-membership.executors.suspected");
+static const string SLOW_EXECUTOR_REPORTS_KEY(
+    "cluster-membership.executors.slow-reports.total");
 
 ClusterMembershipMgr::ClusterMembershipMgr(
     string local_backend_id, StatestoreSubscriber* subscriber, MetricGroup* metrics)
@@ -64,6 +69,8 @@ ClusterMembershipMgr::ClusterMembershipMgr(
   total_live_executor_groups_ = metric_grp->AddCounter(LIVE_EXEC_GROUP_KEY, 0);
   total_healthy_executor_groups_ = metric_grp->AddCounter(HEALTHY_EXEC_GROUP_KEY, 0);
   total_backends_ = metric_grp->AddCounter(TOTAL_BACKENDS_KEY, 0);
+  suspected_executors_ = metric_grp->AddGauge(SUSPECTED_EXECUTORS_KEY, 0);
+  total_slow_executor_reports_ = metric_grp->AddCounter(SLOW_EXECUTOR_REPORTS_KEY, 0);
   // Register the metric update function as a callback.
   RegisterUpdateCallbackFn([this](
       ClusterMembershipMgr::SnapshotPtr snapshot) { this->UpdateMetrics(snapshot); });
@@ -177,7 +184,8 @@ void ClusterMembershipMgr::UpdateMembership(
       new_state = recovering_membership_;
     } else {
       // Make a copy of the current membership. This is the only function calling SetState
-      // and thus no lock is needed for read access.
+      // and thus no lock is needed for read access. The executor groups of the copy share
+      // their executors with the current membership until they are changed below.
       new_state = std::make_shared<Snapshot>(*current_membership_);
     }
   }
@@ -471,6 +479,55 @@ void ClusterMembershipMgr::NotifyListeners(SnapshotPtr snapshot) {
   for (auto fn : update_callback_fns_) fn(snapshot);
 }
 
+void ClusterMembershipMgr::ReportSlowExecutor(
+    const UniqueIdPB& backend_id, const string& detail) {
+  bool blacklist = false;
+  {
+    lock_guard<mutex> l(update_membership_lock_);
+    auto it = current_membership_->current_backends.find(PrintId(backend_id));
+    if (it == current_membership_->current_backends.end()) return;
+    const BackendDescriptorPB& be_desc = it->second;
+    // Like in BlacklistExecutor(), the local executor is never penalized.
+    if (be_desc.ip_address() == current_membership_->local_be_desc->ip_address()
+        && be_desc.address().port()
+            == current_membership_->local_be_desc->address().port()) {
+      return;
+    }
+    bool recovering = recovering_membership_.get() != nullptr;
+    const Snapshot* base_snapshot =
+        recovering ? recovering_membership_.get() : current_membership_.get();
+    int64_t time_remaining_ms;
+    if (base_snapshot->executor_blacklist.IsBlacklisted(
+            be_desc, nullptr, &time_remaining_ms)) {
+      return;
+    }
+    total_slow_executor_reports_->Increment(1);
+
+    std::shared_ptr<Snapshot> new_state;
+    if (recovering) {
+      new_state = recovering_membership_;
+    } else {
+      new_state = std::make_shared<Snapshot>(*current_membership_);
+    }
+    int32_t num_reports = new_state->executor_blacklist.ReportSlow(be_desc);
+    LOG(INFO) << "Executor " << be_desc.address() << " was reported slow (" << detail
+              << "), " << num_reports << " recent reports";
+    blacklist = FLAGS_slow_executor_reports_to_blacklist > 0
+        && num_reports >= FLAGS_slow_executor_reports_to_blacklist;
+    if (!recovering) {
+      // As in BlacklistExecutor(), external listeners are not notified. The scheduler
+      // picks up suspected executors from the snapshot.
+      SetState(new_state);
+      UpdateMetrics(new_state);
+    }
+  }
+  if (blacklist) {
+    BlacklistExecutor(backend_id,
+        Status(Substitute("Executor was much slower than its peers in $0 recent queries",
+            FLAGS_slow_executor_reports_to_blacklist)));
+  }
+}
+
 void ClusterMembershipMgr::SetState(const SnapshotPtr& new_state) {
   lock_guard<mutex> l(current_membership_lock_);
   DCHECK(new_state.get() != nullptr);
@@ -556,6 +613,9 @@ void ClusterMembershipMgr::UpdateMetrics(const SnapshotPtr& new_state){
   total_live_executor_groups_->SetValue(total_live_executor_groups);
   total_healthy_executor_groups_->SetValue(healthy_executor_groups);
   total_backends_->SetValue(new_state->current_backends.size());
+  vector<BackendDescriptorPB> suspects;
+  new_state->executor_blacklist.GetSuspects(&suspects);
+  suspected_executors_->SetValue(suspects.size());
 }
 
 bool ClusterMembershipMgr::IsBackendInExecutorGroups(
@@ -166,6 +166,12 @@ class ClusterMembershipMgr {
   /// 'cause' is an error status representing the reason the node was blacklisted.
   void BlacklistExecutor(const UniqueIdPB& backend_id, const Status& cause);
 
+  /// Records that the given backend was much slower than its peers in a query, as
+  /// described in 'detail'. Suspected executors stay schedulable but are deprioritized
+  /// by the scheduler. Once an executor collected --slow_executor_reports_to_blacklist
+  /// reports within the report window it is blacklisted like in BlacklistExecutor().
+  void ReportSlowExecutor(const UniqueIdPB& backend_id, const std::string& detail);
+
   /// Returns a pointer to the static empty group reserved for scheduling coord only
   /// queries.
   const ExecutorGroup* GetEmptyExecutorGroup() { return &empty_exec_group_; }
@@ -222,6 +228,8 @@ class ClusterMembershipMgr {
   IntCounter* total_live_executor_groups_ = nullptr;
   IntCounter* total_healthy_executor_groups_ = nullptr;
   IntCounter* total_backends_ = nullptr;
+  IntGauge* suspected_executors_ = nullptr;
+  IntCounter* total_slow_executor_reports_ = nullptr;
 
   /// The snapshot of the current cluster membership. When receiving changes to the
   /// executors configuration from the statestore we will make a copy of the stored
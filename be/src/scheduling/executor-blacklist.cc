@@ -26,6 +26,17 @@ DEFINE_bool(blacklisting_enabled, true,
     "(Advanced) If false, disables local blacklisting of executors by coordinators, "
     "which temporarily removes executors that appear to be problematic from scheduling "
     "decisions.");
+DEFINE_int32(slow_executor_reports_to_suspect, 3, "(Advanced) Number of queries that "
+    "must report an executor as much slower than its peers (see "
+    "--slow_executor_rate_ratio) before the executor is suspected to be degraded. The "
+    "scheduler gives suspected executors lower priority. Reports that are further "
+    "apart than --slow_executor_report_window_ms do not add up.");
+DEFINE_int32(slow_executor_reports_to_blacklist, 10, "(Advanced) Number of queries "
+    "that must report an executor as much slower than its peers before the executor "
+    "is blacklisted. 0 disables blacklisting of slow executors.");
+DEFINE_int64(slow_executor_report_window_ms, 10 * 60 * 1000, "(Advanced) Time in ms "
+    "after the last slow report of an executor when its earlier slow reports are "
+    "forgotten and it is no longer suspected.");
 
 namespace impala {
 
@@ -69,12 +80,16 @@ void ExecutorBlacklist::Blacklist(
     executor_list_.insert(
         make_pair(be_desc.backend_id(), Entry(be_desc, MonotonicMillis(), cause)));
   }
+  // An executor that comes back from the blacklist has to be found slow again before it
+  // is suspected.
+  slow_executors_.erase(be_desc.backend_id());
   VLOG(2) << "Blacklisted " << be_desc.address() << ", current blacklist: "
           << DebugString();
 }
 
 ExecutorBlacklist::State ExecutorBlacklist::FindAndRemove(
     const BackendDescriptorPB& be_desc) {
+  slow_executors_.erase(be_desc.backend_id());
   auto remove_it = executor_list_.find(be_desc.backend_id());
   if (remove_it == executor_list_.end()) {
     // Executor wasn't on the blacklist.
@@ -147,6 +162,40 @@ bool ExecutorBlacklist::IsBlacklisted(
   return false;
 }
 
+int32_t ExecutorBlacklist::ReportSlow(const BackendDescriptorPB& be_desc) {
+  DCHECK(be_desc.has_backend_id());
+  int64_t now = MonotonicMillis();
+  auto it = slow_executors_.find(be_desc.backend_id());
+  if (it == slow_executors_.end()) {
+    it = slow_executors_.emplace(be_desc.backend_id(), SlowEntry(be_desc)).first;
+  }
+  SlowEntry& entry = it->second;
+  if (now - entry.last_report_time_ms > FLAGS_slow_executor_report_window_ms) {
+    entry.num_reports = 0;
+  }
+  entry.be_desc = be_desc;
+  entry.last_report_time_ms = now;
+  ++entry.num_reports;
+  return entry.num_reports;
+}
+
+bool ExecutorBlacklist::IsSuspected(const BackendDescriptorPB& be_desc) const {
+  auto it = slow_executors_.find(be_desc.backend_id());
+  return it != slow_executors_.end() && IsSuspected(it->second, MonotonicMillis());
+}
+
+void ExecutorBlacklist::GetSuspects(std::vector<BackendDescriptorPB>* suspects) const {
+  int64_t now = MonotonicMillis();
+  for (const auto& entry : slow_executors_) {
+    if (IsSuspected(entry.second, now)) suspects->push_back(entry.second.be_desc);
+  }
+}
+
+bool ExecutorBlacklist::IsSuspected(const SlowEntry& entry, int64_t now) {
+  return entry.num_reports >= FLAGS_slow_executor_reports_to_suspect
+      && now - entry.last_report_time_ms <= FLAGS_slow_executor_report_window_ms;
+}
+
 std::string ExecutorBlacklist::BlacklistToString() const {
   std::stringstream ss;
   for (auto entry_it : executor_list_) {
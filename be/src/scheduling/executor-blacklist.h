@@ -53,6 +53,12 @@ namespace impala {
 /// the cluster membership is updated by the statestore to fully remove an executor that
 /// is no longer part of the cluster membership.
 ///
+/// Separately from the blacklist, coordinators can report executors that ran much slower
+/// than their peers in a query with ReportSlow(). Executors that are reported repeatedly
+/// are 'suspected' of being degraded, e.g. by a failing disk or NIC. Suspected executors
+/// stay available for scheduling, but with lower priority, and may be blacklisted by the
+/// caller once they have been reported often enough.
+///
 /// This class is not thread-safe.
 class ExecutorBlacklist {
  public:
@@ -94,6 +100,19 @@ class ExecutorBlacklist {
   bool IsBlacklisted(const BackendDescriptorPB& be_desc, Status* cause = nullptr,
       int64_t* time_remaining_ms = nullptr) const;
 
+  /// Records that 'be_desc' ran much slower than its peers in a query. Returns the number
+  /// of such reports for the executor, including this one. Reports that are more than
+  /// --slow_executor_report_window_ms apart do not add up.
+  int32_t ReportSlow(const BackendDescriptorPB& be_desc);
+
+  /// Returns true if 'be_desc' was reported slow at least
+  /// --slow_executor_reports_to_suspect times and the last report is no older than
+  /// --slow_executor_report_window_ms.
+  bool IsSuspected(const BackendDescriptorPB& be_desc) const;
+
+  /// Appends the descriptors of all suspected executors to 'suspects'.
+  void GetSuspects(std::vector<BackendDescriptorPB>* suspects) const;
+
   /// Returns a space-separated string of the addresses of executors that are currently
   /// blacklisted.
   std::string BlacklistToString() const;
@@ -128,6 +147,22 @@ class ExecutorBlacklist {
     Status cause;
   };
 
+  /// Info about an executor that was reported slow.
+  struct SlowEntry {
+    explicit SlowEntry(const BackendDescriptorPB& be_desc) : be_desc(be_desc) {}
+
+    BackendDescriptorPB be_desc;
+
+    /// The MonotonicMillis() of the last slow report.
+    int64_t last_report_time_ms = 0;
+
+    /// Number of slow reports that were at most --slow_executor_report_window_ms apart.
+    int32_t num_reports = 0;
+  };
+
+  /// Returns true if the executor of 'entry' is suspected at time 'now'.
+  static bool IsSuspected(const SlowEntry& entry, int64_t now);
+
   /// Returns the base blacklist timeout in ms. This should be multiplied by
   /// 'num_consecutive_blacklistings' for a particular executor when checking if it has
   /// passed the timeout.
@@ -138,6 +173,10 @@ class ExecutorBlacklist {
   /// on probation.
   std::unordered_map<UniqueIdPB, Entry> executor_list_;
 
+  /// Map from executor backend_id to the slow reports of the executor. Executors are
+  /// removed when they are blacklisted or removed with FindAndRemove().
+  std::unordered_map<UniqueIdPB, SlowEntry> slow_executors_;
+
   /// The amount to multiply the blacklist timeout by for the probation timeout.
   static const int32_t PROBATION_TIMEOUT_MULTIPLIER;
 
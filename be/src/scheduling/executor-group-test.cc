@@ -88,6 +88,30 @@ TEST(ExecutorGroupTest, HealthCheck) {
   ASSERT_FALSE(group1.IsHealthy());
 }
 
+/// Tests that copies of a group share their executors until one of them is changed.
+TEST(ExecutorGroupTest, CopyOnWrite) {
+  ExecutorGroup group1("group1");
+  group1.AddExecutor(MakeBackendDescriptor(1, group1));
+  group1.AddExecutor(MakeBackendDescriptor(2, group1));
+  ExecutorGroup group2(group1);
+  EXPECT_EQ(group1.GetHashRing(), group2.GetHashRing());
+
+  group2.RemoveExecutor(MakeBackendDescriptor(2, group1));
+  group2.AddExecutor(MakeBackendDescriptor(3, group1));
+  EXPECT_NE(group1.GetHashRing(), group2.GetHashRing());
+  ASSERT_EQ(2, group1.NumExecutors());
+  EXPECT_TRUE(group1.LookUpExecutorIp("host_2", nullptr));
+  EXPECT_FALSE(group1.LookUpExecutorIp("host_3", nullptr));
+  ASSERT_EQ(2, group2.NumExecutors());
+  EXPECT_FALSE(group2.LookUpExecutorIp("host_2", nullptr));
+  EXPECT_TRUE(group2.LookUpExecutorIp("host_3", nullptr));
+
+  // A group that is no longer shared is changed in place.
+  const HashRing* hash_ring = group2.GetHashRing();
+  group2.AddExecutor(MakeBackendDescriptor(4, group1));
+  EXPECT_EQ(hash_ring, group2.GetHashRing());
+}
+
 /// Tests that adding an inconsistent backend to a group fails.
 TEST(ExecutorGroupTest, TestAddInconsistent) {
   ExecutorGroup group1("group1", 2);
@@ -29,7 +29,9 @@ static const uint32_t NUM_HASH_RING_REPLICAS = 25;
 ExecutorGroup::ExecutorGroup(string name) : ExecutorGroup(name, 1) {}
 
 ExecutorGroup::ExecutorGroup(string name, int64_t min_size)
-  : name_(name), min_size_(min_size), executor_ip_hash_ring_(NUM_HASH_RING_REPLICAS) {
+  : name_(name),
+    min_size_(min_size),
+    executors_(std::make_shared<ExecutorState>(NUM_HASH_RING_REPLICAS)) {
   DCHECK_GT(min_size_, 0);
 }
 
@@ -48,23 +50,33 @@ ExecutorGroup* ExecutorGroup::GetFilteredExecutorGroup(const ExecutorGroup* grou
   return filtered_group;
 }
 
+ExecutorGroup::ExecutorState* ExecutorGroup::MutableExecutors() {
+  // If this group is the only owner, no other thread can obtain a new reference to the
+  // state, since that requires copying this group. Other owners only ever read the state,
+  // so it is safe to modify it in place once they have released it.
+  if (executors_.use_count() > 1) {
+    executors_ = std::make_shared<ExecutorState>(*executors_);
+  }
+  return executors_.get();
+}
+
 const ExecutorGroup::Executors& ExecutorGroup::GetExecutorsForHost(
     const IpAddr& ip) const {
-  ExecutorMap::const_iterator it = executor_map_.find(ip);
-  DCHECK(it != executor_map_.end());
+  ExecutorMap::const_iterator it = executors_->executor_map.find(ip);
+  DCHECK(it != executors_->executor_map.end());
   return it->second;
 }
 
 ExecutorGroup::IpAddrs ExecutorGroup::GetAllExecutorIps() const {
   IpAddrs ips;
   ips.reserve(NumHosts());
-  for (auto& it: executor_map_) ips.push_back(it.first);
+  for (auto& it: executors_->executor_map) ips.push_back(it.first);
   return ips;
 }
 
 ExecutorGroup::Executors ExecutorGroup::GetAllExecutorDescriptors() const {
   Executors executors;
-  for (const auto& executor_list: executor_map_) {
+  for (const auto& executor_list: executors_->executor_map) {
     executors.insert(executors.end(), executor_list.second.begin(),
         executor_list.second.end());
   }
@@ -75,13 +87,15 @@ void ExecutorGroup::AddExecutor(const BackendDescriptorPB& be_desc) {
   // be_desc.is_executor can be false for the local backend when scheduling queries to run
   // on the coordinator host.
   DCHECK(!be_desc.ip_address().empty());
-  Executors& be_descs = executor_map_[be_desc.ip_address()];
   auto eq = [&be_desc](const BackendDescriptorPB& existing) {
     // The IP addresses must already match, so it is sufficient to check the port.
     DCHECK_EQ(existing.ip_address(), be_desc.ip_address());
     return existing.address().port() == be_desc.address().port();
   };
-  if (find_if(be_descs.begin(), be_descs.end(), eq) != be_descs.end()) {
+  auto existing_it = executors_->executor_map.find(be_desc.ip_address());
+  if (existing_it != executors_->executor_map.end()
+      && find_if(existing_it->second.begin(), existing_it->second.end(), eq)
+          != existing_it->second.end()) {
     LOG(DFATAL) << "Tried to add existing backend to executor group: "
                 << be_desc.krpc_address();
     return;
@@ -91,16 +105,18 @@ void ExecutorGroup::AddExecutor(const BackendDescriptorPB& be_desc) {
                  << be_desc.krpc_address();
     return;
   }
+  ExecutorState* executors = MutableExecutors();
+  Executors& be_descs = executors->executor_map[be_desc.ip_address()];
   if (be_descs.empty()) {
-    executor_ip_hash_ring_.AddNode(be_desc.ip_address());
+    executors->executor_ip_hash_ring.AddNode(be_desc.ip_address());
   }
   be_descs.push_back(be_desc);
-  executor_ip_map_[be_desc.address().hostname()] = be_desc.ip_address();
+  executors->executor_ip_map[be_desc.address().hostname()] = be_desc.ip_address();
 }
 
 void ExecutorGroup::RemoveExecutor(const BackendDescriptorPB& be_desc) {
-  auto be_descs_it = executor_map_.find(be_desc.ip_address());
-  if (be_descs_it == executor_map_.end()) {
+  if (executors_->executor_map.find(be_desc.ip_address())
+      == executors_->executor_map.end()) {
     LOG(DFATAL) << "Tried to remove a backend from non-existing host: "
                 << be_desc.krpc_address();
     return;
@@ -111,29 +127,31 @@ void ExecutorGroup::RemoveExecutor(const BackendDescriptorPB& be_desc) {
     return existing.address().port() == be_desc.address().port();
   };
 
-  Executors& be_descs = be_descs_it->second;
-  auto remove_it = find_if(be_descs.begin(), be_descs.end(), eq);
-  if (remove_it == be_descs.end()) {
+  const Executors& existing_descs = GetExecutorsForHost(be_desc.ip_address());
+  if (find_if(existing_descs.begin(), existing_descs.end(), eq) == existing_descs.end()) {
     LOG(DFATAL) << "Tried to remove non-existing backend from per-host list: "
                 << be_desc.krpc_address();
     return;
   }
-  be_descs.erase(remove_it);
+  ExecutorState* executors = MutableExecutors();
+  auto be_descs_it = executors->executor_map.find(be_desc.ip_address());
+  Executors& be_descs = be_descs_it->second;
+  be_descs.erase(find_if(be_descs.begin(), be_descs.end(), eq));
   if (be_descs.empty()) {
-    executor_map_.erase(be_descs_it);
-    executor_ip_map_.erase(be_desc.address().hostname());
-    executor_ip_hash_ring_.RemoveNode(be_desc.ip_address());
+    executors->executor_map.erase(be_descs_it);
+    executors->executor_ip_map.erase(be_desc.address().hostname());
+    executors->executor_ip_hash_ring.RemoveNode(be_desc.ip_address());
   }
 }
 
 bool ExecutorGroup::LookUpExecutorIp(const Hostname& hostname, IpAddr* ip) const {
   // Check if hostname is already a valid IP address.
-  if (executor_map_.find(hostname) != executor_map_.end()) {
+  if (executors_->executor_map.find(hostname) != executors_->executor_map.end()) {
     if (ip != nullptr) *ip = hostname;
     return true;
   }
-  auto it = executor_ip_map_.find(hostname);
-  if (it != executor_ip_map_.end()) {
+  auto it = executors_->executor_ip_map.find(hostname);
+  if (it != executors_->executor_ip_map.end()) {
     if (ip != nullptr) *ip = it->second;
     return true;
   }
@@ -154,7 +172,9 @@ const BackendDescriptorPB* ExecutorGroup::LookUpBackendDesc(
 
 int ExecutorGroup::NumExecutors() const {
   int count = 0;
-  for (const auto& executor_list : executor_map_) count += executor_list.second.size();
+  for (const auto& executor_list : executors_->executor_map) {
+    count += executor_list.second.size();
+  }
   return count;
 }
 
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -43,6 +44,10 @@ namespace impala {
 ///
 /// Note that only during tests objects of this class will store more than one backend per
 /// host/IP address.
+///
+/// Copies of a group share their executors until one of them is changed, which then
+/// copies them. This makes copying a cluster membership snapshot cheap, since only the
+/// groups that an update changes are copied.
 class ExecutorGroup {
  public:
   explicit ExecutorGroup(std::string name);
@@ -60,7 +65,7 @@ class ExecutorGroup {
   typedef std::vector<IpAddr> IpAddrs;
 
   /// Returns the list of executors on a particular host. The caller must make sure that
-  /// the host is actually contained in executor_map_.
+  /// the host is actually contained in the group.
   const Executors& GetExecutorsForHost(const IpAddr& ip) const;
 
   /// Returns all executor IP addresses in the executor group.
@@ -84,7 +89,7 @@ class ExecutorGroup {
 
   /// Look up the IP address of 'hostname' in the internal executor maps and return
   /// whether the lookup was successful. If 'hostname' itself is a valid IP address and is
-  /// contained in executor_map_, then it is copied to 'ip' and true is returned. 'ip' can
+  /// contained in the group, then it is copied to 'ip' and true is returned. 'ip' can
   /// be nullptr if the caller only wants to check whether the lookup succeeds. Use this
   /// method to resolve datanode hostnames to IP addresses during scheduling, to prevent
   /// blocking on the OS.
@@ -98,11 +103,11 @@ class ExecutorGroup {
 
   /// Returns the hash ring associated with this executor group. It's owned by the group
   /// and the caller must not hold a reference beyond the groups lifetime.
-  const HashRing* GetHashRing() const { return &executor_ip_hash_ring_; }
+  const HashRing* GetHashRing() const { return &executors_->executor_ip_hash_ring; }
 
   /// Returns the number of executor hosts in this group. During tests, hosts can run
   /// multiple executor backend descriptors, but will only be counted here once.
-  int NumHosts() const { return executor_map_.size(); }
+  int NumHosts() const { return executors_->executor_map.size(); }
 
   /// Returns the number of executors (backend descriptors) in this group. Multiple
   /// executors running on the same host (e.g. during tests) are counted individually.
@@ -129,17 +134,34 @@ class ExecutorGroup {
 
   /// Map from a host's IP address to a list of executors running on that node.
   typedef std::unordered_map<IpAddr, Executors> ExecutorMap;
-  ExecutorMap executor_map_;
 
-  /// Map from a hostname to its IP address to support hostname based executor lookup. It
-  /// contains entries for all executors in executor_map_ and needs to be updated whenever
-  /// executor_map_ changes.
+  /// Map from a hostname to its IP address to support hostname based executor lookup.
   typedef std::unordered_map<Hostname, IpAddr> ExecutorIpAddressMap;
-  ExecutorIpAddressMap executor_ip_map_;
 
-  /// All executors are kept in a hash ring to allow a consistent mapping from filenames
-  /// to executors.
-  HashRing executor_ip_hash_ring_;
+  /// The executors of a group. Shared between copies of the group and never modified
+  /// while shared.
+  struct ExecutorState {
+    explicit ExecutorState(uint32_t num_hash_ring_replicas)
+      : executor_ip_hash_ring(num_hash_ring_replicas) {}
+    ExecutorState(const ExecutorState& other) = default;
+
+    ExecutorMap executor_map;
+
+    /// Contains entries for all executors in 'executor_map' and needs to be updated
+    /// whenever 'executor_map' changes.
+    ExecutorIpAddressMap executor_ip_map;
+
+    /// All executors are kept in a hash ring to allow a consistent mapping from
+    /// filenames to executors.
+    HashRing executor_ip_hash_ring;
+  };
+
+  /// Returns 'executors_' for modification, after copying it if it is shared with other
+  /// groups.
+  ExecutorState* MutableExecutors();
+
+  /// Never nullptr.
+  std::shared_ptr<ExecutorState> executors_;
 };
 
 }  // end ns impala
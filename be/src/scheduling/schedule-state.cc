@@ -251,7 +251,8 @@ bool ScheduleState::UseDedicatedCoordEstimates() const {
   return false;
 }
 
-void ScheduleState::UpdateMemoryRequirements(const TPoolConfig& pool_cfg) {
+void ScheduleState::UpdateMemoryRequirements(
+    const TPoolConfig& pool_cfg, int64_t mem_estimate_override) {
   // If the min_query_mem_limit and max_query_mem_limit are not set in the pool config
   // then it falls back to traditional(old) behavior, which means that, it sets the
   // mem_limit if it is set in the query options, else sets it to -1 (no limit).
@@ -269,10 +270,12 @@ void ScheduleState::UpdateMemoryRequirements(const TPoolConfig& pool_cfg) {
   }
 
   if (!is_mem_limit_set) {
-    per_backend_mem_to_admit = GetPerExecutorMemoryEstimate();
+    per_backend_mem_to_admit = mem_estimate_override >= 0 ?
+        mem_estimate_override :
+        GetPerExecutorMemoryEstimate();
     coord_backend_mem_to_admit = use_dedicated_coord_estimates ?
         GetDedicatedCoordMemoryEstimate() :
-        GetPerExecutorMemoryEstimate();
+        per_backend_mem_to_admit;
     VLOG(3) << "use_dedicated_coord_estimates=" << use_dedicated_coord_estimates
             << " coord_backend_mem_to_admit=" << coord_backend_mem_to_admit
             << " per_backend_mem_to_admit=" << per_backend_mem_to_admit;
@@ -284,8 +284,11 @@ class ScheduleState {
   /// Populates or updates the per host query memory limit and the amount of memory to be
   /// admitted based on the pool configuration passed to it. Must be called at least once
   /// before making any calls to per_backend_mem_to_admit(), per_backend_mem_limit() and
-  /// GetClusterMemoryToAdmit().
-  void UpdateMemoryRequirements(const TPoolConfig& pool_cfg);
+  /// GetClusterMemoryToAdmit(). If 'mem_estimate_override' is not negative, it is used
+  /// instead of the planner's per-executor memory estimate, and also for the
+  /// coordinator unless dedicated coordinator estimates are used.
+  void UpdateMemoryRequirements(
+      const TPoolConfig& pool_cfg, int64_t mem_estimate_override = -1);
 
   const std::string& executor_group() const { return executor_group_; }
 
@@ -247,6 +247,15 @@ void Schema::AddMultiBlockTable(const TableName& table_name, int num_blocks,
   tables_[table_name] = table;
 }
 
+void Schema::AddMultiBlockTable(const TableName& table_name,
+    const vector<int64_t>& block_lengths, ReplicaPlacement replica_placement,
+    int num_replicas, BlockNamingPolicy naming_policy) {
+  AddMultiBlockTable(table_name, block_lengths.size(), replica_placement, num_replicas,
+      0, naming_policy);
+  vector<Block>& blocks = tables_[table_name].blocks;
+  for (int i = 0; i < block_lengths.size(); ++i) blocks[i].length = block_lengths[i];
+}
+
 void Schema::AddFileSplitGeneratorSpecs(
     const TableName& table_name, const std::vector<FileSplitGeneratorSpec>& specs) {
   Table* table = &tables_[table_name];
@@ -272,6 +281,10 @@ void Plan::SetNumRemoteExecutorCandidates(int32_t num) {
   query_options_.num_remote_executor_candidates = num;
 }
 
+void Plan::SetRemoteExecutorMaxLoadRatio(double ratio) {
+  query_options_.remote_executor_max_load_ratio = ratio;
+}
+
 const vector<TNetworkAddress>& Plan::referenced_datanodes() const {
   return referenced_datanodes_;
 }
@@ -648,7 +661,8 @@ Status SchedulerWrapper::Compute(bool exec_at_coord, Result* result) {
   ExecutorGroup empty_group("empty-group");
   DCHECK(membership_snapshot->local_be_desc.get() != nullptr);
   Scheduler::ExecutorConfig executor_config =
-      {no_executor_group ? empty_group : it->second, *membership_snapshot->local_be_desc};
+      {no_executor_group ? empty_group : it->second, *membership_snapshot->local_be_desc,
+          &executor_load_};
   std::mt19937 rng(rand());
   return scheduler_->ComputeScanRangeAssignment(executor_config, 0, nullptr, false,
       *locations, plan_.referenced_datanodes(), exec_at_coord, plan_.query_options(),
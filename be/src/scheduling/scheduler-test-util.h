@@ -264,6 +264,14 @@ class Schema {
       ReplicaPlacement replica_placement, int num_replicas, int num_cached_replicas,
       BlockNamingPolicy naming_policy);
 
+  /// Add a table with a block of length 'block_lengths[i]' for every i to the schema,
+  /// selecting replica hosts according to the given replica placement preference. All
+  /// replicas will be non-cached. The table uses the specified 'naming_policy' for its
+  /// blocks.
+  void AddMultiBlockTable(const TableName& table_name,
+      const std::vector<int64_t>& block_lengths, ReplicaPlacement replica_placement,
+      int num_replicas, BlockNamingPolicy naming_policy);
+
   /// Adds FileSplitGeneratorSpecs to table named 'table_name'. If the table does not
   /// exist, creates a new table. Otherwise, adds the 'specs' to an existing table.
   void AddFileSplitGeneratorSpecs(
@@ -298,6 +306,10 @@ class Plan {
 
   void SetRandomReplica(bool b) { query_options_.schedule_random_replica = b; }
   void SetNumRemoteExecutorCandidates(int32_t num);
+  void SetRemoteExecutorMaxLoadRatio(double ratio);
+  void SetSchedulerLoadPenaltyBytes(int64_t bytes) {
+    query_options_.scheduler_load_penalty_bytes = bytes;
+  }
   const Cluster& cluster() const { return schema_.cluster(); }
 
   const std::vector<TNetworkAddress>& referenced_datanodes() const;
@@ -380,7 +392,7 @@ class Result {
   int NumTotalAssignments() const { return CountAssignmentsIf(Any()); }
 
   /// Return the total number of assigned bytes.
-  int NumTotalAssignedBytes() const { return CountAssignedBytesIf(Any()); }
+  int64_t NumTotalAssignedBytes() const { return CountAssignedBytesIf(Any()); }
 
   /// Return the number of scheduled assignments for a single host.
   int NumTotalAssignments(int host_idx) const;
@@ -392,7 +404,7 @@ class Result {
   int NumCachedAssignments() const { return CountAssignmentsIf(IsCached(Any())); }
 
   /// Return the total number of assigned bytes for cached reads.
-  int NumCachedAssignedBytes() const { return CountAssignedBytesIf(IsCached(Any())); }
+  int64_t NumCachedAssignedBytes() const { return CountAssignedBytesIf(IsCached(Any())); }
 
   /// Return the total number of assigned cached reads for a single host.
   int NumCachedAssignments(int host_idx) const;
@@ -404,7 +416,7 @@ class Result {
   int NumDiskAssignments() const { return CountAssignmentsIf(IsDisk(Any())); }
 
   /// Return the total number of assigned bytes for non-cached reads.
-  int NumDiskAssignedBytes() const { return CountAssignedBytesIf(IsDisk(Any())); }
+  int64_t NumDiskAssignedBytes() const { return CountAssignedBytesIf(IsDisk(Any())); }
 
   /// Return the total number of assigned non-cached reads for a single host.
   int NumDiskAssignments(int host_idx) const;
@@ -416,7 +428,7 @@ class Result {
   int NumRemoteAssignments() const { return CountAssignmentsIf(IsRemote(Any())); }
 
   /// Return the total number of assigned bytes for remote reads.
-  int NumRemoteAssignedBytes() const { return CountAssignedBytesIf(IsRemote(Any())); }
+  int64_t NumRemoteAssignedBytes() const { return CountAssignedBytesIf(IsRemote(Any())); }
 
   /// Return the total number of assigned remote reads for a single host.
   int NumRemoteAssignments(int host_idx) const;
@@ -529,11 +541,17 @@ class SchedulerWrapper {
   /// Send an empty update message to the scheduler.
   void SendEmptyUpdate();
 
+  /// Set the load of the executor hosts that is passed to the scheduler.
+  void SetExecutorLoad(const Scheduler::ExecutorLoadMap& executor_load) {
+    executor_load_ = executor_load;
+  }
+
  private:
   const Plan& plan_;
   boost::scoped_ptr<ClusterMembershipMgr> cluster_membership_mgr_;
   boost::scoped_ptr<Scheduler> scheduler_;
   MetricGroup metrics_;
+  Scheduler::ExecutorLoadMap executor_load_;
 
   /// Initialize the internal scheduler object. The method uses the 'real' constructor
   /// used in the rest of the codebase, in contrast to the one that takes a list of
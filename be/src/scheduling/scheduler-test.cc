@@ -26,6 +26,8 @@
 #include "testutil/gtest-util.h"
 #include "testutil/rand-util.h"
 
+DECLARE_int32(num_scan_range_assignment_threads);
+
 using namespace impala;
 using namespace impala::test;
 
@@ -280,6 +282,30 @@ TEST_F(SchedulerTest, RemoteExecutorCandidates) {
   }
 }
 
+/// Tests that remote_executor_max_load_ratio bounds the bytes that consistent remote
+/// placement assigns to a single executor. Each executor may get at most 1.25 times
+/// its share of the 200 blocks, i.e. 25 blocks.
+TEST_F(SchedulerTest, RemoteExecutorMaxLoadRatio) {
+  Cluster cluster = Cluster::CreateRemoteCluster(10, 3);
+
+  Schema schema(cluster);
+  schema.AddMultiBlockTable("T1", 200, ReplicaPlacement::REMOTE_ONLY, 3);
+
+  Plan plan(schema);
+  plan.AddTableScan("T1");
+  plan.SetNumRemoteExecutorCandidates(3);
+  plan.SetRemoteExecutorMaxLoadRatio(1.25);
+
+  Result result(plan);
+  SchedulerWrapper scheduler(plan);
+  ASSERT_OK(scheduler.Compute(&result));
+
+  EXPECT_EQ(200, result.NumTotalAssignments());
+  // Without the bound, consistent placement uses some executors much more than others.
+  EXPECT_GE(result.NumDistinctBackends(), 8);
+  EXPECT_LE(result.MaxNumAssignedBytesPerHost(), 25 * Block::DEFAULT_BLOCK_SIZE);
+}
+
 /// Helper function to verify that two things are treated as distinct for consistent
 /// remote placement. The input 'schema' should be created with a Cluster initialized
 /// by Cluster::CreateRemoteCluster() with 50 impalads and 3 data nodes. It should
@@ -491,6 +517,63 @@ TEST_F(SchedulerTest, DisjointClusterWithRemoteReads) {
   for (int i = 10; i < 20; ++i) EXPECT_EQ(0, result.NumTotalAssignments(i));
 }
 
+/// Verify that load-aware assignment moves remote reads away from loaded executors.
+TEST_F(SchedulerTest, LoadAwareRemoteReads) {
+  Cluster cluster;
+  for (int i = 0; i < 20; ++i) cluster.AddHost(i < 10, i >= 10);
+
+  Schema schema(cluster);
+  schema.AddMultiBlockTable("T1", 20, ReplicaPlacement::REMOTE_ONLY, 3);
+
+  Plan plan(schema);
+  plan.AddTableScan("T1");
+  plan.SetNumRemoteExecutorCandidates(0);
+  plan.SetSchedulerLoadPenaltyBytes(100 * Block::DEFAULT_BLOCK_SIZE);
+
+  // The first five executors are fully loaded.
+  Scheduler::ExecutorLoadMap executor_load;
+  for (int i = 0; i < 5; ++i) executor_load[cluster.hosts()[i].ip] = 1.0;
+
+  Result result(plan);
+  SchedulerWrapper scheduler(plan);
+  scheduler.SetExecutorLoad(executor_load);
+  ASSERT_OK(scheduler.Compute(&result));
+
+  EXPECT_EQ(20, result.NumTotalAssignments());
+  for (int i = 0; i < 5; ++i) EXPECT_EQ(0, result.NumTotalAssignments(i));
+  for (int i = 5; i < 10; ++i) EXPECT_EQ(4, result.NumTotalAssignments(i));
+
+  // Without a penalty the load is ignored and all executors get the same share.
+  Result unloaded_result(plan);
+  plan.SetSchedulerLoadPenaltyBytes(0);
+  ASSERT_OK(scheduler.Compute(&unloaded_result));
+  for (int i = 0; i < 10; ++i) EXPECT_EQ(2, unloaded_result.NumTotalAssignments(i));
+}
+
+/// Verify that the scan ranges of a large table are balanced across executors when they
+/// are assigned in parallel shards.
+TEST_F(SchedulerTest, ParallelAssignment) {
+  gflags::FlagSaver saver;
+  FLAGS_num_scan_range_assignment_threads = 4;
+  const int num_blocks = 4 * 64 * 1024;
+  Cluster cluster;
+  for (int i = 0; i < 16; ++i) cluster.AddHost(i < 8, i >= 8);
+
+  Schema schema(cluster);
+  schema.AddMultiBlockTable("T1", num_blocks, ReplicaPlacement::REMOTE_ONLY, 3);
+
+  Plan plan(schema);
+  plan.AddTableScan("T1");
+  plan.SetNumRemoteExecutorCandidates(0);
+
+  Result result(plan);
+  SchedulerWrapper scheduler(plan);
+  ASSERT_OK(scheduler.Compute(&result));
+
+  EXPECT_EQ(num_blocks, result.NumTotalAssignments());
+  for (int i = 0; i < 8; ++i) EXPECT_EQ(num_blocks / 8, result.NumTotalAssignments(i));
+}
+
 /// Verify that cached replicas take precedence.
 TEST_F(SchedulerTest, TestCachedReadPreferred) {
   Cluster cluster;
@@ -19,6 +19,8 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <limits>
 #include <random>
 #include <unordered_map>
@@ -37,6 +39,7 @@
 #include "scheduling/executor-group.h"
 #include "scheduling/hash-ring.h"
 #include "thirdparty/pcg-cpp-0.98/include/pcg_random.hpp"
+#include "util/bit-util.h"
 #include "util/compression-util.h"
 #include "util/debug-util.h"
 #include "util/flat_buffer.h"
@@ -44,7 +47,9 @@
 #include "util/metrics.h"
 #include "util/network-util.h"
 #include "util/pretty-printer.h"
+#include "util/promise.h"
 #include "util/runtime-profile-counters.h"
+#include "util/thread-pool.h"
 #include "util/uid-util.h"
 
 #include "common/names.h"
@@ -55,6 +60,12 @@ using namespace apache::thrift;
 using namespace org::apache::impala::fb;
 using namespace strings;
 
+DEFINE_int32(num_scan_range_assignment_threads, 0, "(Advanced) Number of threads that "
+    "assign the scan ranges of a plan node to executors. Plan nodes with many scan "
+    "ranges are split into contiguous shards that are assigned in parallel and merged "
+    "deterministically. 0 or 1 assigns all scan ranges on the thread that computes the "
+    "schedule.");
+
 namespace impala {
 
 static const string LOCAL_ASSIGNMENTS_KEY("simple-scheduler.local-assignments.total");
@@ -75,6 +86,27 @@ static const vector<TPlanNodeType::type> SCAN_NODE_TYPES{TPlanNodeType::HDFS_SCA
 // candidates. See GetRemoteExecutorCandidates() for a deeper description.
 static const int MAX_ITERATIONS_PER_EXECUTOR_CANDIDATE = 8;
 
+// With bounded load consistent hashing (see REMOTE_EXECUTOR_MAX_LOAD_RATIO), the number
+// of executor candidates after the first 'num_remote_executor_candidates' that a remote
+// scan range can fall through to if all of those are at the bound. They are the next
+// distinct executors that the hashes of the scan range pick from the hash ring, so the
+// choice stays consistent and only scan ranges of overloaded executors move.
+static const int NUM_BOUNDED_LOAD_FALLBACK_CANDIDATES = 8;
+
+// Minimum number of scan ranges of a plan node per shard when assigning them in
+// parallel. Smaller shards do not make up for the cost of handing them to the thread
+// pool and of merging their assignments.
+static const int64_t MIN_SCAN_RANGES_PER_ASSIGNMENT_SHARD = 64 * 1024;
+
+/// Returns the number of bytes that assigning 'scan_range' adds to an executor.
+static int64_t GetScanRangeLength(const TScanRange& scan_range) {
+  if (scan_range.__isset.hdfs_file_split) return scan_range.hdfs_file_split.length;
+  // Hack so that kudu ranges are well distributed.
+  // TODO: KUDU-1133 Use the tablet size instead.
+  if (scan_range.__isset.kudu_scan_token) return 1000;
+  return 0;
+}
+
 Scheduler::Scheduler(MetricGroup* metrics, RequestPoolService* request_pool_service)
   : metrics_(metrics->GetOrCreateChildGroup("scheduler")),
     request_pool_service_(request_pool_service) {
@@ -84,8 +116,22 @@ Scheduler::Scheduler(MetricGroup* metrics, RequestPoolService* request_pool_serv
     total_local_assignments_ = metrics_->AddCounter(LOCAL_ASSIGNMENTS_KEY, 0);
     initialized_ = metrics_->AddProperty(SCHEDULER_INIT_KEY, true);
   }
+  if (FLAGS_num_scan_range_assignment_threads > 1) {
+    // The thread that computes the schedule assigns one of the shards itself.
+    const int num_threads = FLAGS_num_scan_range_assignment_threads - 1;
+    assignment_pool_.reset(new CallableThreadPool(
+        "scheduler", "scan-range-assignment", num_threads, num_threads));
+    Status status = assignment_pool_->Init();
+    if (!status.ok()) {
+      LOG(WARNING) << "Could not start scan range assignment threads, assigning scan "
+                   << "ranges serially: " << status.GetDetail();
+      assignment_pool_.reset();
+    }
+  }
 }
 
+Scheduler::~Scheduler() {}
+
 const BackendDescriptorPB& Scheduler::LookUpBackendDesc(
     const ExecutorConfig& executor_config, const NetworkAddressPB& host) {
   const BackendDescriptorPB* desc = executor_config.group.LookUpBackendDesc(host);
@@ -595,6 +641,67 @@ Status Scheduler::ComputeScanRangeAssignment(const ExecutorConfig& executor_conf
     const vector<TNetworkAddress>& host_list, bool exec_at_coord,
     const TQueryOptions& query_options, RuntimeProfile::Counter* timer, std::mt19937* rng,
     FragmentScanRangeAssignment* assignment) {
+  const int64_t num_locations = locations.size();
+  int64_t num_shards = 1;
+  if (assignment_pool_ != nullptr) {
+    num_shards = min<int64_t>(FLAGS_num_scan_range_assignment_threads,
+        num_locations / MIN_SCAN_RANGES_PER_ASSIGNMENT_SHARD);
+  }
+  if (num_shards <= 1) {
+    return ComputeScanRangeAssignment(executor_config, node_id, node_replica_preference,
+        node_random_replica, locations.data(), num_locations, host_list, exec_at_coord,
+        query_options, timer, rng, assignment);
+  }
+
+  SCOPED_TIMER(timer);
+  // Each shard is a contiguous run of 'locations' that is assigned independently with
+  // its own random number generator. The generators are seeded and the results are
+  // merged in shard order, so that the assignment only depends on the state of 'rng'
+  // and not on the order in which the shards finish.
+  const int64_t shard_size = BitUtil::Ceil(num_locations, num_shards);
+  vector<std::mt19937> shard_rngs;
+  for (int64_t i = 0; i < num_shards; ++i) shard_rngs.emplace_back((*rng)());
+  vector<FragmentScanRangeAssignment> shard_assignments(num_shards);
+  vector<unique_ptr<Promise<Status>>> shard_statuses;
+  for (int64_t i = 0; i < num_shards; ++i) {
+    const int64_t begin = i * shard_size;
+    const int64_t end = min(num_locations, begin + shard_size);
+    shard_statuses.emplace_back(new Promise<Status>());
+    Promise<Status>* shard_status = shard_statuses.back().get();
+    boost::function<void()> assign_shard = [&, i, begin, end, shard_status]() {
+      shard_status->Set(ComputeScanRangeAssignment(executor_config, node_id,
+          node_replica_preference, node_random_replica, locations.data() + begin,
+          end - begin, host_list, exec_at_coord, query_options, nullptr, &shard_rngs[i],
+          &shard_assignments[i]));
+    };
+    // Assign the shard on this thread if the pool cannot take it.
+    if (i == num_shards - 1 || !assignment_pool_->Offer(assign_shard)) assign_shard();
+  }
+  Status status;
+  for (unique_ptr<Promise<Status>>& shard_status : shard_statuses) {
+    Status shard_result = shard_status->Get();
+    if (status.ok() && !shard_result.ok()) status = shard_result;
+  }
+  RETURN_IF_ERROR(status);
+  for (FragmentScanRangeAssignment& shard_assignment : shard_assignments) {
+    for (auto& host_entry : shard_assignment) {
+      PerNodeScanRanges* per_node_ranges = &(*assignment)[host_entry.first];
+      for (auto& node_entry : host_entry.second) {
+        vector<ScanRangeParamsPB>* ranges = &(*per_node_ranges)[node_entry.first];
+        ranges->insert(ranges->end(), std::make_move_iterator(node_entry.second.begin()),
+            std::make_move_iterator(node_entry.second.end()));
+      }
+    }
+  }
+  return Status::OK();
+}
+
+Status Scheduler::ComputeScanRangeAssignment(const ExecutorConfig& executor_config,
+    PlanNodeId node_id, const TReplicaPreference::type* node_replica_preference,
+    bool node_random_replica, const TScanRangeLocationList* locations,
+    int64_t num_locations, const vector<TNetworkAddress>& host_list, bool exec_at_coord,
+    const TQueryOptions& query_options, RuntimeProfile::Counter* timer, std::mt19937* rng,
+    FragmentScanRangeAssignment* assignment) {
   const ExecutorGroup& executor_group = executor_config.group;
   if (executor_group.NumExecutors() == 0 && !exec_at_coord) {
     return Status(TErrorCode::NO_REGISTERED_BACKENDS);
@@ -627,14 +734,17 @@ Status Scheduler::ComputeScanRangeAssignment(const ExecutorConfig& executor_conf
   coord_only_executor_group.AddExecutor(coord_desc);
   VLOG_ROW << "Exec at coord is " << (exec_at_coord ? "true" : "false");
   AssignmentCtx assignment_ctx(exec_at_coord ? coord_only_executor_group : executor_group,
-      total_assignments_, total_local_assignments_, rng);
+      total_assignments_, total_local_assignments_, rng, executor_config.executor_load,
+      max(query_options.scheduler_load_penalty_bytes,
+          executor_config.min_load_penalty_bytes));
 
   // Holds scan ranges that must be assigned for remote reads.
   vector<const TScanRangeLocationList*> remote_scan_range_locations;
 
   // Loop over all scan ranges, select an executor for those with local impalads and
   // collect all others for later processing.
-  for (const TScanRangeLocationList& scan_range_locations : locations) {
+  for (int64_t i = 0; i < num_locations; ++i) {
+    const TScanRangeLocationList& scan_range_locations = locations[i];
     TReplicaPreference::type min_distance = TReplicaPreference::REMOTE;
 
     // Select executor for the current scan range.
@@ -713,6 +823,26 @@ Status Scheduler::ComputeScanRangeAssignment(const ExecutorConfig& executor_conf
   // Assign remote scans to executors.
   int num_remote_executor_candidates =
       min(query_options.num_remote_executor_candidates, executor_group.NumExecutors());
+  // With bounded load consistent hashing, no executor host gets more than
+  // 'max_load_ratio' times the average bytes per host, counting the bytes assigned so far
+  // and those of the remote scan ranges.
+  const double max_load_ratio = query_options.remote_executor_max_load_ratio;
+  const bool bounded_load = max_load_ratio >= 1.0 && num_remote_executor_candidates > 0
+      && !remote_scan_range_locations.empty();
+  int64_t max_assigned_bytes = 0;
+  int num_bounded_load_candidates = 0;
+  if (bounded_load) {
+    int64_t total_bytes = assignment_ctx.GetTotalAssignedBytes();
+    for (const TScanRangeLocationList* scan_range_locations :
+        remote_scan_range_locations) {
+      total_bytes += GetScanRangeLength(scan_range_locations->scan_range);
+    }
+    max_assigned_bytes = static_cast<int64_t>(
+        ceil(max_load_ratio * total_bytes / executor_group.NumHosts()));
+    num_bounded_load_candidates = min(
+        num_remote_executor_candidates + NUM_BOUNDED_LOAD_FALLBACK_CANDIDATES,
+        executor_group.NumExecutors());
+  }
   for (const TScanRangeLocationList* scan_range_locations : remote_scan_range_locations) {
     DCHECK(!exec_at_coord);
     const IpAddr* executor_ip;
@@ -725,12 +855,23 @@ Status Scheduler::ComputeScanRangeAssignment(const ExecutorConfig& executor_conf
     // ranges, which allows for execution on any backend.
     if (scan_range_locations->scan_range.__isset.hdfs_file_split &&
         num_remote_executor_candidates > 0) {
-      assignment_ctx.GetRemoteExecutorCandidates(
-          &scan_range_locations->scan_range.hdfs_file_split,
-          num_remote_executor_candidates, &remote_executor_candidates);
-      // Like the local case, schedule_random_replica determines how to break ties.
-      executor_ip = assignment_ctx.SelectExecutorFromCandidates(
-          remote_executor_candidates, random_replica);
+      if (bounded_load) {
+        // The first candidates are the same as without the bound.
+        assignment_ctx.GetRemoteExecutorCandidates(
+            &scan_range_locations->scan_range.hdfs_file_split,
+            num_bounded_load_candidates, &remote_executor_candidates);
+        executor_ip = assignment_ctx.SelectExecutorWithBoundedLoad(
+            remote_executor_candidates, num_remote_executor_candidates,
+            GetScanRangeLength(scan_range_locations->scan_range), max_assigned_bytes,
+            random_replica);
+      } else {
+        assignment_ctx.GetRemoteExecutorCandidates(
+            &scan_range_locations->scan_range.hdfs_file_split,
+            num_remote_executor_candidates, &remote_executor_candidates);
+        // Like the local case, schedule_random_replica determines how to break ties.
+        executor_ip = assignment_ctx.SelectExecutorFromCandidates(
+            remote_executor_candidates, random_replica);
+      }
     } else {
       executor_ip = assignment_ctx.SelectRemoteExecutor();
     }
@@ -931,7 +1072,8 @@ void Scheduler::ComputeBackendExecParams(
 }
 
 Scheduler::AssignmentCtx::AssignmentCtx(const ExecutorGroup& executor_group,
-    IntCounter* total_assignments, IntCounter* total_local_assignments, std::mt19937* rng)
+    IntCounter* total_assignments, IntCounter* total_local_assignments, std::mt19937* rng,
+    const ExecutorLoadMap* executor_load, int64_t load_penalty_bytes)
   : executor_group_(executor_group),
     first_unused_executor_idx_(0),
     total_assignments_(total_assignments),
@@ -939,9 +1081,44 @@ Scheduler::AssignmentCtx::AssignmentCtx(const ExecutorGroup& executor_group,
   DCHECK_GT(executor_group.NumExecutors(), 0);
   random_executor_order_ = executor_group.GetAllExecutorIps();
   std::shuffle(random_executor_order_.begin(), random_executor_order_.end(), *rng);
+  num_unused_candidates_ = random_executor_order_.size();
+  // Maps loaded executors to the bytes that they count as already assigned.
+  boost::unordered_map<IpAddr, int64_t> load_penalties;
+  if (executor_load != nullptr && load_penalty_bytes > 0) {
+    for (const IpAddr& ip : random_executor_order_) {
+      auto it = executor_load->find(ip);
+      if (it == executor_load->end()) continue;
+      int64_t penalty = static_cast<int64_t>(min(it->second, 1.0) * load_penalty_bytes);
+      if (penalty > 0) load_penalties[ip] = penalty;
+    }
+    // Move the loaded executors behind the idle ones, keeping the random order within
+    // both.
+    auto first_loaded = std::stable_partition(random_executor_order_.begin(),
+        random_executor_order_.end(),
+        [&load_penalties](const IpAddr& ip) { return load_penalties.count(ip) == 0; });
+    num_unused_candidates_ = first_loaded - random_executor_order_.begin();
+  }
   // Initialize inverted map for executor rank lookups
   int i = 0;
   for (const IpAddr& ip : random_executor_order_) random_executor_rank_[ip] = i++;
+  for (const auto& entry : load_penalties) {
+    assignment_heap_.InsertOrUpdate(
+        entry.first, entry.second, GetExecutorRank(entry.first));
+  }
+}
+
+int64_t Scheduler::AssignmentCtx::GetAssignedBytes(const IpAddr& ip) const {
+  auto handle_it = assignment_heap_.find(ip);
+  if (handle_it == assignment_heap_.end()) return 0;
+  return (*handle_it->second).assigned_bytes;
+}
+
+int64_t Scheduler::AssignmentCtx::GetTotalAssignedBytes() const {
+  int64_t total_bytes = 0;
+  for (const ExecutorAssignmentInfo& info : assignment_heap_.executor_heap()) {
+    total_bytes += info.assigned_bytes;
+  }
+  return total_bytes;
 }
 
 const IpAddr* Scheduler::AssignmentCtx::SelectExecutorFromCandidates(
@@ -952,12 +1129,7 @@ const IpAddr* Scheduler::AssignmentCtx::SelectExecutorFromCandidates(
   // Find locations with minimum number of assigned bytes.
   int64_t min_assigned_bytes = numeric_limits<int64_t>::max();
   for (int i = 0; i < data_locations.size(); ++i) {
-    const IpAddr& executor_ip = data_locations[i];
-    int64_t assigned_bytes = 0;
-    auto handle_it = assignment_heap_.find(executor_ip);
-    if (handle_it != assignment_heap_.end()) {
-      assigned_bytes = (*handle_it->second).assigned_bytes;
-    }
+    int64_t assigned_bytes = GetAssignedBytes(data_locations[i]);
     if (assigned_bytes < min_assigned_bytes) {
       candidates_idxs.clear();
       min_assigned_bytes = assigned_bytes;
@@ -976,6 +1148,27 @@ const IpAddr* Scheduler::AssignmentCtx::SelectExecutorFromCandidates(
   return &data_locations[*min_rank_idx];
 }
 
+const IpAddr* Scheduler::AssignmentCtx::SelectExecutorWithBoundedLoad(
+    const std::vector<IpAddr>& candidates, int num_preferred, int64_t scan_range_length,
+    int64_t max_assigned_bytes, bool break_ties_by_rank) {
+  DCHECK(!candidates.empty());
+  DCHECK_GT(num_preferred, 0);
+  const int num_candidates = candidates.size();
+  const auto preferred_end = candidates.begin() + min(num_preferred, num_candidates);
+  const vector<IpAddr> preferred(candidates.begin(), preferred_end);
+  // Return a pointer into 'candidates', since 'preferred' goes away.
+  const IpAddr* executor_ip = &*find(candidates.begin(), preferred_end,
+      *SelectExecutorFromCandidates(preferred, break_ties_by_rank));
+  if (GetAssignedBytes(*executor_ip) + scan_range_length <= max_assigned_bytes) {
+    return executor_ip;
+  }
+  for (auto it = preferred_end; it != candidates.end(); ++it) {
+    if (GetAssignedBytes(*it) + scan_range_length <= max_assigned_bytes) return &*it;
+  }
+  // All candidates are at the bound, so the scan range goes to the least loaded one.
+  return SelectExecutorFromCandidates(candidates, break_ties_by_rank);
+}
+
 void Scheduler::AssignmentCtx::GetRemoteExecutorCandidates(
     const THdfsFileSplit* hdfs_file_split, int num_candidates,
     vector<IpAddr>* remote_executor_candidates) {
@@ -1054,7 +1247,7 @@ const IpAddr* Scheduler::AssignmentCtx::SelectRemoteExecutor() {
 }
 
 bool Scheduler::AssignmentCtx::HasUnusedExecutors() const {
-  return first_unused_executor_idx_ < random_executor_order_.size();
+  return first_unused_executor_idx_ < num_unused_candidates_;
 }
 
 const IpAddr* Scheduler::AssignmentCtx::GetNextUnusedExecutorAndIncrement() {
@@ -1127,14 +1320,7 @@ void Scheduler::AssignmentCtx::RecordScanRangeAssignment(
     const vector<TNetworkAddress>& host_list,
     const TScanRangeLocationList& scan_range_locations,
     FragmentScanRangeAssignment* assignment) {
-  int64_t scan_range_length = 0;
-  if (scan_range_locations.scan_range.__isset.hdfs_file_split) {
-    scan_range_length = scan_range_locations.scan_range.hdfs_file_split.length;
-  } else if (scan_range_locations.scan_range.__isset.kudu_scan_token) {
-    // Hack so that kudu ranges are well distributed.
-    // TODO: KUDU-1133 Use the tablet size instead.
-    scan_range_length = 1000;
-  }
+  int64_t scan_range_length = GetScanRangeLength(scan_range_locations.scan_range);
 
   IpAddr executor_ip;
   bool ret =
@@ -21,6 +21,7 @@
 #include <string>
 #include <vector>
 #include <boost/heap/binomial_heap.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/unordered_map.hpp>
 #include <gtest/gtest_prod.h> // for FRIEND_TEST
 
@@ -37,6 +38,7 @@
 namespace impala {
 
 class BackendDescriptorPB;
+class CallableThreadPool;
 class MetricGroup;
 class RequestPoolService;
 class TPlanExecInfo;
@@ -61,11 +63,23 @@ class SchedulerWrapper;
 class Scheduler {
  public:
   Scheduler(MetricGroup* metrics, RequestPoolService* request_pool_service);
+  ~Scheduler();
+
+  /// Load of executor hosts as a fraction of their capacity, keyed by host IP. 0 is
+  /// idle and 1 is fully loaded.
+  typedef boost::unordered_map<IpAddr, double> ExecutorLoadMap;
 
   /// Current snapshot of executors to be used for scheduling a scan.
   struct ExecutorConfig {
     const ExecutorGroup& group;
     const BackendDescriptorPB& coord_desc;
+    /// Load of the hosts of 'group', or nullptr if it is unknown. Used for scan range
+    /// assignment if the SCHEDULER_LOAD_PENALTY_BYTES query option is set. Hosts that
+    /// are missing from the map are treated as idle.
+    const ExecutorLoadMap* executor_load = nullptr;
+    /// Lower bound for the SCHEDULER_LOAD_PENALTY_BYTES query option. Set by admission
+    /// control to deprioritize executors that are suspected to be degraded.
+    int64_t min_load_penalty_bytes = 0;
   };
 
   /// Populates given query schedule and assigns fragments to hosts based on scan
@@ -151,8 +165,12 @@ class Scheduler {
   /// ComputeScanRangeAssignment() and thus don't need to be thread safe.
   class AssignmentCtx {
    public:
+    /// If 'executor_load' is non-null and 'load_penalty_bytes' is greater than 0, every
+    /// loaded executor host starts with its load times 'load_penalty_bytes' as assigned
+    /// bytes. Only idle hosts are then treated as unused.
     AssignmentCtx(const ExecutorGroup& executor_group, IntCounter* total_assignments,
-        IntCounter* total_local_assignments, std::mt19937* rng);
+        IntCounter* total_local_assignments, std::mt19937* rng,
+        const ExecutorLoadMap* executor_load = nullptr, int64_t load_penalty_bytes = 0);
 
     /// Among hosts in 'data_locations', select the one with the minimum number of
     /// assigned bytes. If executors have been assigned equal amounts of work and
@@ -172,6 +190,26 @@ class Scheduler {
     void GetRemoteExecutorCandidates(const THdfsFileSplit* hdfs_file_split,
         int num_remote_replicas, vector<IpAddr>* remote_executor_candidates);
 
+    /// Select an executor for a remote read of 'scan_range_length' bytes with bounded
+    /// load consistent hashing. 'candidates' are in the consistent order returned by
+    /// GetRemoteExecutorCandidates(). Among the first 'num_preferred'
+    /// candidates the one with the minimum number of assigned bytes is picked, like in
+    /// SelectExecutorFromCandidates(), if the scan range keeps it within
+    /// 'max_assigned_bytes'. Otherwise the first of the remaining candidates that stays
+    /// within 'max_assigned_bytes' is picked. If no candidate has room, the one with the
+    /// minimum number of assigned bytes is picked.
+    const IpAddr* SelectExecutorWithBoundedLoad(const std::vector<IpAddr>& candidates,
+        int num_preferred, int64_t scan_range_length, int64_t max_assigned_bytes,
+        bool break_ties_by_rank);
+
+    /// Returns the number of bytes assigned to the executor host 'ip', including its
+    /// load penalty.
+    int64_t GetAssignedBytes(const IpAddr& ip) const;
+
+    /// Returns the number of bytes assigned to all executor hosts, including their load
+    /// penalties.
+    int64_t GetTotalAssignedBytes() const;
+
     /// Select an executor for a remote read. If there are unused executor hosts, then
     /// those will be preferred. Otherwise the one with the lowest number of assigned
     /// bytes is picked. If executors have been assigned equal amounts of work, then the
@@ -213,7 +251,8 @@ class Scheduler {
     const ExecutorGroup& executor_group_;
 
     // Addressable heap to select remote executors from. Elements are ordered by the
-    // number of already assigned bytes (and a random rank to break ties).
+    // number of already assigned bytes, including load penalties (and a random rank to
+    // break ties).
     AddressableAssignmentHeap assignment_heap_;
 
     /// Store a random rank per executor host to break ties between otherwise equivalent
@@ -224,7 +263,13 @@ class Scheduler {
     /// used to select unused executors and inserting them into the assignment_heap_.
     int first_unused_executor_idx_;
 
-    /// Store a random permutation of executor hosts to select executors from.
+    /// Number of executors at the start of random_executor_order_ that can be selected
+    /// as unused. The loaded executors after them are inserted into assignment_heap_
+    /// with their load penalty up front.
+    int num_unused_candidates_;
+
+    /// Store a random permutation of executor hosts to select executors from. With
+    /// load-aware assignment, the idle executors come first.
     std::vector<IpAddr> random_executor_order_;
 
     /// Track round robin information per executor host.
@@ -263,6 +308,10 @@ class Scheduler {
   /// us.
   RequestPoolService* request_pool_service_;
 
+  /// Threads that assign shards of the scan ranges of a plan node in parallel. Shared by
+  /// all queries. nullptr if --num_scan_range_assignment_threads is 0 or 1.
+  boost::scoped_ptr<CallableThreadPool> assignment_pool_;
+
   /// Returns the backend descriptor corresponding to 'host' which could be a remote
   /// backend or the local host itself. The returned descriptor should not be retained
   /// beyond the lifetime of 'executor_config'.
@@ -347,6 +396,11 @@ class Scheduler {
   /// timer:                   Tracks execution time of ComputeScanRangeAssignment.
   /// rng:                     Random number generated used for any random decisions
   /// assignment:              Output parameter, to which new assignments will be added.
+  ///
+  /// If 'assignment_pool_' is set, 'locations' with at least twice
+  /// MIN_SCAN_RANGES_PER_ASSIGNMENT_SHARD scan ranges are split into contiguous shards
+  /// that are assigned in parallel, each of them balanced across the executors on its
+  /// own. The result is deterministic for a given state of 'rng'.
   Status ComputeScanRangeAssignment(const ExecutorConfig& executor_config,
       PlanNodeId node_id, const TReplicaPreference::type* node_replica_preference,
       bool node_random_replica, const std::vector<TScanRangeLocationList>& locations,
@@ -354,6 +408,16 @@ class Scheduler {
       const TQueryOptions& query_options, RuntimeProfile::Counter* timer,
       std::mt19937* rng, FragmentScanRangeAssignment* assignment);
 
+  /// Same as above, but assigns the 'num_locations' scan ranges starting at 'locations'
+  /// on the calling thread.
+  Status ComputeScanRangeAssignment(const ExecutorConfig& executor_config,
+      PlanNodeId node_id, const TReplicaPreference::type* node_replica_preference,
+      bool node_random_replica, const TScanRangeLocationList* locations,
+      int64_t num_locations, const std::vector<TNetworkAddress>& host_list,
+      bool exec_at_coord, const TQueryOptions& query_options,
+      RuntimeProfile::Counter* timer, std::mt19937* rng,
+      FragmentScanRangeAssignment* assignment);
+
   /// Computes execution parameters for all backends assigned in the query and always one
   /// for the coordinator backend since it participates in execution regardless. Must be
   /// called after ComputeFragmentExecParams().
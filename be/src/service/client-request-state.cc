@@ -20,6 +20,7 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/replace.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <limits>
 #include <gutil/strings/substitute.h>
 #include <rapidjson/rapidjson.h>
@@ -33,6 +34,7 @@
 #include "exprs/timezone_db.h"
 #include "kudu/rpc/rpc_controller.h"
 #include "rpc/rpc-mgr.inline.h"
+#include "rpc/thrift-util.h"
 #include "runtime/coordinator.h"
 #include "runtime/exec-env.h"
 #include "runtime/mem-tracker.h"
@@ -54,6 +56,7 @@
 #include "util/metrics.h"
 #include "util/pretty-printer.h"
 #include "util/promise.h"
+#include "util/query-cache-util.h"
 #include "util/redactor.h"
 #include "util/runtime-profile-counters.h"
 #include "util/time.h"
@@ -72,6 +75,7 @@
 using boost::algorithm::iequals;
 using boost::algorithm::join;
 using boost::algorithm::replace_all_copy;
+using boost::algorithm::trim_copy;
 using kudu::rpc::RpcController;
 using namespace apache::hive::service::cli::thrift;
 using namespace apache::thrift;
@@ -97,6 +101,7 @@ static const string TABLES_WITH_MISSING_DISK_IDS_KEY = "Tables With Missing Disk
 
 static const string QUERY_STATUS_KEY = "Query Status";
 static const string RETRY_STATUS_KEY = "Retry Status";
+static const string QUERY_RESULT_CACHE_KEY = "Query Result Cache";
 
 ClientRequestState::ClientRequestState(const TQueryCtx& query_ctx, Frontend* frontend,
     ImpalaServer* server, shared_ptr<ImpalaServer::SessionState> session,
@@ -172,6 +177,11 @@ ClientRequestState::ClientRequestState(const TQueryCtx& query_ctx, Frontend* fro
 
   summary_profile_->AddChild(frontend_profile_);
 
+  QueryResultCache* query_result_cache = parent_server_->query_result_cache();
+  if (query_result_cache != nullptr && query_options().use_query_result_cache) {
+    query_result_cache_generation_ = query_result_cache->generation();
+  }
+
   AdmissionControlClient::Create(query_ctx_, &admission_control_client_);
 }
 
@@ -239,6 +249,7 @@ Status ClientRequestState::Exec() {
     case TStmtType::QUERY:
     case TStmtType::DML:
       DCHECK(exec_request_->__isset.query_exec_request);
+      if (LookupQueryResultCache()) break;
       RETURN_IF_ERROR(ExecAsyncQueryOrDmlRequest(exec_request_->query_exec_request));
       break;
     case TStmtType::EXPLAIN: {
@@ -331,6 +342,67 @@ Status ClientRequestState::Exec() {
   return Status::OK();
 }
 
+bool ClientRequestState::IsQueryResultCacheable() const {
+  if (query_result_cache_generation_ < 0 || stmt_type() != TStmtType::QUERY) {
+    return false;
+  }
+  return AreQueryResultsReusable(exec_request_->query_exec_request);
+}
+
+bool ClientRequestState::LookupQueryResultCache() {
+  if (!IsQueryResultCacheable()) return false;
+  // The results also depend on the query options and the result format of the client.
+  string options;
+  ThriftSerializer serializer(/* compact */ true);
+  Status status = serializer.SerializeToString(&query_options(), &options);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not serialize the query options, not using the query result "
+                 << "cache: " << status.GetDetail();
+    return false;
+  }
+  query_result_cache_key_ = Substitute("$0\n$1\n$2\n$3\n$4\n$5",
+      PrintThriftEnum(session_type()), session_->hs2_version, effective_user(),
+      default_db(), options, trim_copy(query_ctx_.client_request.stmt));
+  cached_result_ =
+      parent_server_->query_result_cache()->Lookup(query_result_cache_key_);
+  if (cached_result_ == nullptr) {
+    summary_profile_->AddInfoString(QUERY_RESULT_CACHE_KEY, "Miss");
+    pending_cache_entry_.reset(new QueryResultCache::Entry());
+    pending_cache_entry_->metadata = result_metadata_;
+    return false;
+  }
+  summary_profile_->AddInfoString(QUERY_RESULT_CACHE_KEY, "Hit");
+  query_events_->MarkEvent("Served from query result cache");
+  return true;
+}
+
+void ClientRequestState::UpdatePendingCacheEntry(
+    QueryResultSet* fetched_rows, int start_idx, int num_rows) {
+  DCHECK(pending_cache_entry_ != nullptr);
+  QueryResultCache* query_result_cache = parent_server_->query_result_cache();
+  if (num_rows > 0) {
+    pending_cache_entry_bytes_ += fetched_rows->ByteSize(start_idx, num_rows);
+    if (pending_cache_entry_bytes_ > query_result_cache->max_entry_bytes()) {
+      summary_profile_->AddInfoString(QUERY_RESULT_CACHE_KEY, "Miss, results too large");
+      pending_cache_entry_.reset();
+      return;
+    }
+    if (pending_cache_entry_->rows == nullptr) {
+      pending_cache_entry_->rows.reset(
+          fetched_rows->CreateEmpty(pending_cache_entry_->metadata));
+    }
+    pending_cache_entry_->rows->AddRows(fetched_rows, start_idx, num_rows);
+  }
+  if (!eos_.Load()) return;
+  if (pending_cache_entry_->rows == nullptr) {
+    pending_cache_entry_->rows.reset(
+        fetched_rows->CreateEmpty(pending_cache_entry_->metadata));
+  }
+  bool inserted = query_result_cache->Insert(query_result_cache_key_,
+      query_result_cache_generation_, move(pending_cache_entry_));
+  if (inserted) summary_profile_->AddInfoString(QUERY_RESULT_CACHE_KEY, "Miss, stored");
+}
+
 void ClientRequestState::PopulateResultForSet(bool is_set_all) {
   map<string, string> config;
   TQueryOptionsToMap(query_options(), &config);
@@ -1097,6 +1169,16 @@ Status ClientRequestState::FetchRowsInternal(const int32_t max_rows,
     return Status::OK();
   }
 
+  if (cached_result_ != nullptr) {
+    QueryResultSet* cached_rows = cached_result_->rows.get();
+    const int num_rows = fetched_rows->AddRows(cached_rows, num_rows_fetched_,
+        max_rows <= 0 ? cached_rows->size() : max_rows);
+    num_rows_fetched_ += num_rows;
+    COUNTER_ADD(num_rows_fetched_from_cache_counter_, num_rows);
+    eos_.Store(num_rows_fetched_ == cached_rows->size());
+    return Status::OK();
+  }
+
   Coordinator* coordinator = GetCoordinator();
   if (coordinator == nullptr) {
     return Status("Client tried to fetch rows on a query that produces no results.");
@@ -1147,6 +1229,9 @@ Status ClientRequestState::FetchRowsInternal(const int32_t max_rows,
       eos_.Store(true);
       return query_status_;
     }
+    if (pending_cache_entry_ != nullptr) {
+      UpdatePendingCacheEntry(fetched_rows, before, num_fetched);
+    }
   }
 
   // Update the result cache if necessary.
@@ -23,6 +23,7 @@
 #include "exec/catalog-op-executor.h"
 #include "service/child-query.h"
 #include "service/impala-server.h"
+#include "service/query-result-cache.h"
 #include "service/query-result-set.h"
 #include "util/condition-variable.h"
 #include "util/runtime-profile.h"
@@ -529,6 +530,27 @@ class ClientRequestState {
   /// Max size of the result_cache_ in number of rows. A value <= 0 means no caching.
   int64_t result_cache_max_size_ = -1;
 
+  /// The generation of the server's QueryResultCache before this query was planned, or
+  /// -1 if the cache is disabled. Passed to QueryResultCache::Insert() so that results
+  /// computed from a catalog that changed meanwhile are not cached.
+  int64_t query_result_cache_generation_ = -1;
+
+  /// Key of this query in the QueryResultCache. Only set if the query is cacheable.
+  std::string query_result_cache_key_;
+
+  /// The cached results this query is answered with, if the lookup in the
+  /// QueryResultCache was a hit. The query is not executed in that case and
+  /// FetchRowsInternal() serves the rows from this entry.
+  std::shared_ptr<const QueryResultCache::Entry> cached_result_;
+
+  /// Collects the rows fetched from the coordinator if the lookup in the
+  /// QueryResultCache was a miss. Added to the cache once all rows are fetched. Reset if
+  /// the rows exceed the maximum size of an entry.
+  std::unique_ptr<QueryResultCache::Entry> pending_cache_entry_;
+
+  /// Estimated memory used by the rows in 'pending_cache_entry_'.
+  int64_t pending_cache_entry_bytes_ = 0;
+
   ObjectPool profile_pool_;
 
   /// The ClientRequestState builds three separate profiles.
@@ -672,6 +694,22 @@ class ClientRequestState {
   /// actively processed. Takes expiration_data_lock_.
   void MarkActive();
 
+  /// Returns true if this QUERY can be answered from and added to the QueryResultCache.
+  /// Queries are not cacheable if their results may differ between identical executions
+  /// on an unchanged catalog, e.g. because they read tables whose data is not versioned
+  /// by the catalog or call non-deterministic functions.
+  bool IsQueryResultCacheable() const;
+
+  /// Looks up this query in the QueryResultCache if it is cacheable. Returns true on a
+  /// hit, in which case the query must not be executed. On a miss, prepares adding the
+  /// results to the cache.
+  bool LookupQueryResultCache();
+
+  /// Appends the 'num_rows' rows starting at 'start_idx' of 'fetched_rows' to
+  /// 'pending_cache_entry_' and adds the entry to the cache at the end of the results.
+  /// Called with the rows fetched from the coordinator.
+  void UpdatePendingCacheEntry(QueryResultSet* fetched_rows, int start_idx, int num_rows);
+
   /// Sets up profile and pre-execution counters, creates the query schedule, and spawns
   /// a thread that calls FinishExecQueryOrDmlRequest() which contains the core logic of
   /// executing a QUERY or DML execution request.
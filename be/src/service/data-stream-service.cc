@@ -116,8 +116,21 @@ void DataStreamService::UpdateFilter(
   DebugActionNoFail(FLAGS_debug_actions, "UPDATE_FILTER_DELAY");
   DCHECK(req->has_filter_id());
   DCHECK(req->has_query_id());
-  DCHECK(req->has_bloom_filter() || req->has_min_max_filter());
-  ExecEnv::GetInstance()->impala_server()->UpdateFilter(resp, *req, context);
+  DCHECK(req->has_bloom_filter() || req->has_min_max_filter()
+      || req->has_in_list_filter());
+  if (req->to_aggregator()) {
+    QueryState::ScopedRef qs(ProtoToQueryId(req->query_id()));
+    if (qs.get() != nullptr) {
+      qs->UpdateFilterFromRemote(*req, context);
+    } else {
+      // Like updates for a query that the coordinator no longer runs, the update is
+      // dropped and the filter will not be published.
+      LOG(INFO) << "Query State not found for filter update of query_id="
+                << PrintId(ProtoToQueryId(req->query_id()));
+    }
+  } else {
+    ExecEnv::GetInstance()->impala_server()->UpdateFilter(resp, *req, context);
+  }
   RespondAndReleaseRpc(Status::OK(), resp, context, mem_tracker_.get());
 }
 
@@ -127,7 +140,8 @@ void DataStreamService::PublishFilter(
   DebugActionNoFail(FLAGS_debug_actions, "PUBLISH_FILTER_DELAY");
   DCHECK(req->has_filter_id());
   DCHECK(req->has_dst_query_id());
-  DCHECK(req->has_bloom_filter() || req->has_min_max_filter());
+  DCHECK(req->has_bloom_filter() || req->has_min_max_filter()
+      || req->has_in_list_filter());
   QueryState::ScopedRef qs(ProtoToQueryId(req->dst_query_id()));
 
   if (qs.get() != nullptr) {
@@ -103,6 +103,26 @@ namespace impala {
 
 const string IMPALA_RESULT_CACHING_OPT = "impala.resultset.cache.size";
 
+/// Creates the result set for the results of 'query_handle' for a client with protocol
+/// 'version'. The rows are added into 'rowset', if not nullptr. Returns the rows in the
+/// Arrow IPC format if ARROW_RESULT_FORMAT is set, except for child queries, whose rows
+/// are consumed by their parent query.
+static Status CreateFetchResultSet(const QueryHandle& query_handle,
+    TProtocolVersion::type version, TRowSet* rowset, QueryResultSet** result_set) {
+  const TResultSetMetadata& metadata = *query_handle->result_metadata();
+  bool is_child_query = query_handle->parent_query_id() != TUniqueId();
+  if (!query_handle->query_options().arrow_result_format || is_child_query) {
+    *result_set = QueryResultSet::CreateHS2ResultSet(version, metadata, rowset,
+        query_handle->query_options().result_conversion_threads);
+    return Status::OK();
+  }
+  if (version < TProtocolVersion::HIVE_CLI_SERVICE_PROTOCOL_V6) {
+    return Status("ARROW_RESULT_FORMAT requires HiveServer2 protocol version V6 or "
+        "higher");
+  }
+  return QueryResultSet::CreateArrowResultSet(metadata, rowset, result_set);
+}
+
 void ImpalaServer::ExecuteMetadataOp(const THandleIdentifier& session_handle,
     TMetadataOpRequest* request, TOperationHandle* handle, thrift::TStatus* status) {
   TUniqueId session_id;
@@ -218,10 +238,13 @@ Status ImpalaServer::FetchInternal(TUniqueId query_id, SessionState* session,
   bool is_child_query = query_handle->parent_query_id() != TUniqueId();
   TProtocolVersion::type version = is_child_query ?
       TProtocolVersion::HIVE_CLI_SERVICE_PROTOCOL_V1 : session->hs2_version;
-  scoped_ptr<QueryResultSet> result_set(QueryResultSet::CreateHS2ResultSet(
-      version, *(query_handle->result_metadata()), &(fetch_results->results)));
+  QueryResultSet* result_set_ptr;
+  RETURN_IF_ERROR(CreateFetchResultSet(
+      query_handle, version, &(fetch_results->results), &result_set_ptr));
+  scoped_ptr<QueryResultSet> result_set(result_set_ptr);
   RETURN_IF_ERROR(
       query_handle->FetchRows(fetch_size, result_set.get(), block_on_wait_time_us));
+  RETURN_IF_ERROR(result_set->FinalizeRowSet());
   *num_results = result_set->size();
   fetch_results->__isset.results = true;
   fetch_results->__set_hasMoreRows(!query_handle->eos());
@@ -539,9 +562,9 @@ Status ImpalaServer::SetupResultsCacheing(const QueryHandle& query_handle,
     shared_ptr<SessionState> session, int64_t cache_num_rows) {
   // Optionally enable result caching on the ClientRequestState.
   if (cache_num_rows > 0) {
-    const TResultSetMetadata* result_set_md = query_handle->result_metadata();
-    QueryResultSet* result_set =
-        QueryResultSet::CreateHS2ResultSet(session->hs2_version, *result_set_md, nullptr);
+    QueryResultSet* result_set;
+    RETURN_IF_ERROR(
+        CreateFetchResultSet(query_handle, session->hs2_version, nullptr, &result_set));
     RETURN_IF_ERROR(query_handle->SetResultCache(result_set, cache_num_rows));
   }
   return Status::OK();
@@ -18,12 +18,14 @@
 #include "service/impala-http-handler.h"
 
 #include <algorithm>
+#include <limits>
 #include <mutex>
 #include <sstream>
 #include <boost/lexical_cast.hpp>
 #include <boost/unordered_set.hpp>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
 
 #include "catalog/catalog-util.h"
 #include "gen-cpp/beeswax_types.h"
@@ -46,9 +48,11 @@
 #include "thrift/protocol/TDebugProtocol.h"
 #include "util/coding-util.h"
 #include "util/debug-util.h"
+#include "util/event-tracer.h"
 #include "util/logging-support.h"
 #include "util/pretty-printer.h"
 #include "util/redactor.h"
+#include "util/string-parser.h"
 #include "util/summary-util.h"
 #include "util/time.h"
 #include "util/uid-util.h"
@@ -68,6 +72,10 @@ DECLARE_int32(query_stmt_size);
 DECLARE_bool(use_local_catalog);
 DECLARE_string(admission_service_host);
 
+DEFINE_int32(webserver_query_list_page_size, 100, "Maximum number of completed queries "
+    "that /queries and /completed_queries list by default. Pages of the list can be "
+    "selected with the offset and limit arguments of these pages.");
+
 namespace {
 
 // Helper method to turn a class + a method to invoke into a UrlCallback
@@ -92,6 +100,30 @@ static Status ParseIdFromRequest(const Webserver::WebRequest& req, TUniqueId* id
   }
 }
 
+// Returns the value of the non-negative integer argument 'arg' of 'req' or
+// 'default_value' if the argument is missing or invalid.
+static int64_t ParseIntArg(const Webserver::WebRequest& req, const string& arg,
+    int64_t default_value) {
+  const auto& args = req.parsed_args;
+  Webserver::ArgumentMap::const_iterator it = args.find(arg);
+  if (it == args.end()) return default_value;
+  StringParser::ParseResult result;
+  int64_t value = StringParser::StringToInt<int64_t>(
+      it->second.c_str(), it->second.size(), &result);
+  if (result != StringParser::PARSE_SUCCESS || value < 0) return default_value;
+  return value;
+}
+
+// Sets 'offset' and 'limit' of the page of a query list from the arguments 'offset_arg'
+// and 'limit_arg' of 'req'. Both are capped so that their sum does not overflow.
+static void ParsePageArgs(const Webserver::WebRequest& req, const string& offset_arg,
+    const string& limit_arg, int64_t* offset, int64_t* limit) {
+  const int64_t max_value = std::numeric_limits<int32_t>::max();
+  *offset = min(ParseIntArg(req, offset_arg, 0), max_value);
+  *limit = min(ParseIntArg(req, limit_arg,
+      max(FLAGS_webserver_query_list_page_size, 0)), max_value);
+}
+
 }
 
 ImpalaHttpHandler::ImpalaHttpHandler(ImpalaServer* server,
@@ -136,6 +168,11 @@ void ImpalaHttpHandler::RegisterHandlers(Webserver* webserver, bool metrics_only
   webserver->RegisterUrlCallback("/queries", "queries.tmpl",
       MakeCallback(this, &ImpalaHttpHandler::QueryStateHandler), true);
 
+  webserver->RegisterStreamingUrlCallback("/completed_queries", JSON,
+      [this](const auto& req, auto* response) {
+        this->CompletedQueriesHandler(req, response);
+      });
+
   webserver->RegisterUrlCallback("/sessions", "sessions.tmpl",
       MakeCallback(this, &ImpalaHttpHandler::SessionsHandler), true);
 
@@ -179,6 +216,11 @@ void ImpalaHttpHandler::RegisterHandlers(Webserver* webserver, bool metrics_only
   webserver->RegisterUrlCallback("/inflight_query_ids", "raw_text.tmpl",
       MakeCallback(this, &ImpalaHttpHandler::InflightQueryIdsHandler), false);
 
+  webserver->RegisterStreamingUrlCallback("/query_trace", JSON,
+      [this](const auto& req, auto* response) {
+        this->QueryTraceHandler(req, response);
+      });
+
   webserver->RegisterUrlCallback("/query_summary", "query_summary.tmpl",
       [this](const auto& req, auto* doc) {
         this->QuerySummaryHandler(false, true, req, doc); }, false);
@@ -523,21 +565,43 @@ void ImpalaHttpHandler::QueryStateHandler(const Webserver::WebRequest& req,
       "free the resources they are using, they must be closed.",
       document->GetAllocator());
 
+  // Only the requested page of the completed queries is rendered.
+  int64_t offset;
+  int64_t limit;
+  ParsePageArgs(req, "completed_offset", "completed_limit", &offset, &limit);
   Value completed_queries(kArrayType);
-  {
-    lock_guard<mutex> l(server_->query_log_lock_);
-    for (const unique_ptr<ImpalaServer::QueryStateRecord>& log_entry :
-        server_->query_log_) {
-      // Don't show duplicated entries between in-flight and completed queries.
-      if (in_flight_query_ids.find(log_entry->id) != in_flight_query_ids.end()) continue;
-      Value record_json(kObjectType);
-      QueryStateToJson(*log_entry, &record_json, document);
-      completed_queries.PushBack(record_json, document->GetAllocator());
-    }
+  vector<ImpalaServer::QueryRecordPtr> query_log;
+  server_->query_log_->GetAll(&query_log);
+  int64_t num_completed_queries = 0;
+  for (const ImpalaServer::QueryRecordPtr& log_entry : query_log) {
+    // Don't show duplicated entries between in-flight and completed queries.
+    if (in_flight_query_ids.find(log_entry->id) != in_flight_query_ids.end()) continue;
+    const int64_t pos = num_completed_queries++;
+    if (pos < offset || pos - offset >= limit) continue;
+    Value record_json(kObjectType);
+    QueryStateToJson(*log_entry, &record_json, document);
+    completed_queries.PushBack(record_json, document->GetAllocator());
   }
   document->AddMember("completed_queries", completed_queries, document->GetAllocator());
   document->AddMember("completed_log_size", FLAGS_query_log_size,
       document->GetAllocator());
+  document->AddMember("num_completed_queries", num_completed_queries,
+      document->GetAllocator());
+  document->AddMember("completed_first", min(offset + 1, num_completed_queries),
+      document->GetAllocator());
+  document->AddMember("completed_last", min(offset + limit, num_completed_queries),
+      document->GetAllocator());
+  document->AddMember("completed_limit", limit, document->GetAllocator());
+  if (offset > 0) {
+    document->AddMember("completed_has_prev", true, document->GetAllocator());
+    document->AddMember("completed_prev_offset", max<int64_t>(offset - limit, 0),
+        document->GetAllocator());
+  }
+  if (offset + limit < num_completed_queries) {
+    document->AddMember("completed_has_next", true, document->GetAllocator());
+    document->AddMember("completed_next_offset", offset + limit,
+        document->GetAllocator());
+  }
 
   Value query_locations(kArrayType);
   {
@@ -559,6 +623,57 @@ void ImpalaHttpHandler::QueryStateHandler(const Webserver::WebRequest& req,
   document->AddMember("query_locations", query_locations, document->GetAllocator());
 }
 
+void ImpalaHttpHandler::CompletedQueriesHandler(const Webserver::WebRequest& req,
+    StreamingResponse* response) {
+  int64_t offset;
+  int64_t limit;
+  ParsePageArgs(req, "offset", "limit", &offset, &limit);
+  vector<ImpalaServer::QueryRecordPtr> query_log;
+  server_->query_log_->GetAll(&query_log);
+  const int64_t end = min<int64_t>(query_log.size(), offset + limit);
+
+  stringstream* out = response->stream();
+  *out << "{\"num_completed_queries\": " << query_log.size() << ",\n"
+       << "\"offset\": " << offset << ",\n"
+       << "\"completed_queries\": [";
+  for (int64_t i = offset; i < end && !response->failed(); ++i) {
+    // Every record is rendered with its own document, so that only one record is kept
+    // in memory at a time.
+    Document document(kObjectType);
+    Value record_json(kObjectType);
+    QueryStateToJson(*query_log[i], &record_json, &document);
+    StringBuffer buffer;
+    Writer<StringBuffer> writer(buffer);
+    record_json.Accept(writer);
+    if (i > offset) *out << ",";
+    *out << "\n" << buffer.GetString();
+    response->Flush();
+  }
+  *out << "\n]}\n";
+}
+
+void ImpalaHttpHandler::QueryTraceHandler(const Webserver::WebRequest& req,
+    StreamingResponse* response) {
+  Status status;
+  TUniqueId query_id;
+  if (!EventTracer::enabled()) {
+    status = Status("Event tracing is disabled, see --event_trace_records_per_thread.");
+  } else if (req.parsed_args.find("query_id") != req.parsed_args.end()) {
+    status = ParseIdFromRequest(req, &query_id, "query_id");
+  }
+  if (!status.ok()) {
+    Document document(kObjectType);
+    Value error(status.GetDetail().c_str(), document.GetAllocator());
+    document.AddMember("error", error, document.GetAllocator());
+    StringBuffer buffer;
+    Writer<StringBuffer> writer(buffer);
+    document.Accept(writer);
+    *response->stream() << buffer.GetString() << "\n";
+    return;
+  }
+  EventTracer::WriteChromeTrace(query_id, response);
+}
+
 void ImpalaHttpHandler::SessionsHandler(const Webserver::WebRequest& req,
     Document* document) {
   lock_guard<mutex> l(server_->session_state_map_lock_);
@@ -930,23 +1045,21 @@ void ImpalaHttpHandler::QuerySummaryHandler(bool include_json_plan, bool include
   }
 
   if (!found) {
-    lock_guard<mutex> l(server_->query_log_lock_);
-    ImpalaServer::QueryLogIndex::const_iterator query_record =
-        server_->query_log_index_.find(query_id);
-    if (query_record == server_->query_log_index_.end()) {
+    ImpalaServer::QueryRecordPtr query_record = server_->query_log_->Get(query_id);
+    if (query_record == nullptr) {
       const string& err = Substitute("Unknown query id: $0", PrintId(query_id));
       Value json_error(err.c_str(), document->GetAllocator());
       document->AddMember("error", json_error, document->GetAllocator());
       return;
     }
     if (include_json_plan || include_summary) {
-      summary = query_record->second->exec_summary;
+      summary = query_record->exec_summary;
     }
-    stmt = query_record->second->stmt;
-    plan = query_record->second->plan;
-    query_status = query_record->second->query_status;
+    stmt = query_record->stmt;
+    plan = query_record->plan;
+    query_status = query_record->query_status;
     if (include_json_plan) {
-      fragments = query_record->second->fragments;
+      fragments = query_record->fragments;
     }
   }
 
@@ -1014,6 +1127,9 @@ void ImpalaHttpHandler::BackendsHandler(const Webserver::WebRequest& req,
     backend_obj.AddMember("is_blacklisted", is_blacklisted, document->GetAllocator());
     backend_obj.AddMember("is_active", !is_blacklisted && !backend.is_quiescing(),
         document->GetAllocator());
+    backend_obj.AddMember("is_suspected",
+        membership_snapshot->executor_blacklist.IsSuspected(backend),
+        document->GetAllocator());
     if (backend.is_quiescing()) {
       // Backends cannot be both blacklisted and quiescing.
       DCHECK(!is_blacklisted);
@@ -1084,6 +1200,7 @@ void ImpalaHttpHandler::AdmissionStateHandler(
   } else {
     admission_controller_->PoolToJson(pool_name_arg->second, &resource_pools, document);
   }
+  admission_controller_->MemEstimateFeedbackToJson(document);
 
   // Now get running queries from CRS map.
   struct QueryInfo {
@@ -76,7 +76,9 @@ class ImpalaHttpHandler {
       rapidjson::Document* document);
 
   /// Returns two sorted lists of queries, one in-flight and one completed, as well as a
-  /// list of active backends and their plan-fragment count.
+  /// list of active backends and their plan-fragment count. Only one page of the
+  /// completed queries is listed, which is selected by the 'completed_offset' and
+  /// 'completed_limit' arguments.
   //
   /// "in_flight_queries": [],
   /// "num_in_flight_queries": 0,
@@ -104,6 +106,22 @@ class ImpalaHttpHandler {
   void QueryStateHandler(const Webserver::WebRequest& req,
       rapidjson::Document* document);
 
+  /// Streaming callback for /completed_queries, which lists the queries in the query log
+  /// as JSON, the most recent first. The 'offset' and 'limit' arguments select a page of
+  /// the list, by default the first --webserver_query_list_page_size queries. Example:
+  /// { "num_completed_queries": 2,
+  ///   "offset": 0,
+  ///   "completed_queries": [ { "query_id": ..., <fields of QueryStateToJson()> }, ... ]
+  /// }
+  void CompletedQueriesHandler(const Webserver::WebRequest& req,
+      StreamingResponse* response);
+
+  /// Streaming callback for /query_trace, which returns the events that this daemon
+  /// traced for the query with the 'query_id' argument, or for all queries without the
+  /// argument, in the Chrome trace event format. See EventTracer. Returns
+  /// { "error": ... } if the argument is invalid or tracing is disabled.
+  void QueryTraceHandler(const Webserver::WebRequest& req, StreamingResponse* response);
+
   /// Json callback for /query_profile. Expects query_id as an argument. If a json
   /// profile is requested, the JSON profile is returned in 'document' under
   /// "contents". Otherwise 'document' has 'profile' set to the profile string,
@@ -69,6 +69,8 @@
 #include "runtime/client-cache.h"
 #include "runtime/coordinator.h"
 #include "runtime/exec-env.h"
+#include "runtime/io/data-cache.h"
+#include "runtime/io/disk-io-mgr.h"
 #include "runtime/lib-cache.h"
 #include "runtime/query-driver.h"
 #include "runtime/timestamp-value.h"
@@ -80,6 +82,9 @@
 #include "service/client-request-state.h"
 #include "service/frontend.h"
 #include "service/impala-http-handler.h"
+#include "service/query-profile-store.h"
+#include "service/plan-cache.h"
+#include "service/query-result-cache.h"
 #include "util/auth-util.h"
 #include "util/bit-util.h"
 #include "util/coding-util.h"
@@ -87,6 +92,7 @@
 #include "util/error-util.h"
 #include "util/histogram-metric.h"
 #include "util/impalad-metrics.h"
+#include "util/mem-info.h"
 #include "util/metrics.h"
 #include "util/network-util.h"
 #include "util/openssl-util.h"
@@ -95,6 +101,7 @@
 #include "util/redactor.h"
 #include "util/runtime-profile-counters.h"
 #include "util/runtime-profile.h"
+#include "util/scope-exit-trigger.h"
 #include "util/simple-logger.h"
 #include "util/string-parser.h"
 #include "util/summary-util.h"
@@ -164,6 +171,22 @@ DEFINE_string(default_query_options, "", "key=value pair of default query option
     " impalad, separated by ','");
 DEFINE_int32(query_log_size, 100, "Number of queries to retain in the query log. If -1, "
     "the query log has unbounded size.");
+DEFINE_string(query_log_max_bytes, "", "Maximum estimated memory consumption of the "
+    "query log, e.g. 1GB, or a percentage of the physical memory. Once the query log "
+    "exceeds either this or --query_log_size, the oldest queries are evicted. There is "
+    "no limit in bytes if this is empty, 0 or -1.");
+DEFINE_string(query_log_profile_dir, "", "(Advanced) Local directory in which the "
+    "profiles of queries that were evicted from the query log are stored, so that they "
+    "can still be fetched by query id. The profiles are kept in a subdirectory that is "
+    "cleared on startup. Profiles are not stored if this is empty.");
+DEFINE_string(query_log_profile_dir_capacity, "1GB", "(Advanced) Maximum size on disk "
+    "of the profiles in --query_log_profile_dir, e.g. 1GB. Once it is exceeded, the "
+    "oldest profiles are deleted.");
+DEFINE_bool(query_log_compact_profiles, true, "If true, the profiles of the queries in "
+    "the query log are kept in memory in a compact columnar encoding with interned "
+    "counter names instead of as compressed Thrift. Profiles that are logged to file "
+    "(--log_query_to_file) or fetched in the BASE64 format always use compressed "
+    "Thrift.");
 DEFINE_int32(query_stmt_size, 250, "length of the statements in the query log. If <=0, "
     "the full statement is displayed in the query log without trimming.");
 DEFINE_bool(log_query_to_file, true, "if true, logs completed query profiles to file.");
@@ -173,6 +196,23 @@ DEFINE_int64(max_result_cache_size, 100000L, "Maximum number of query results a
     "option guards against unreasonably large result caches requested by clients. "
     "Requests exceeding this maximum will be rejected.");
 
+DEFINE_string(query_result_cache_capacity, "0", "(Advanced) Memory limit of the "
+    "coordinator's cache of the results of SELECT statements that set the query option "
+    "USE_QUERY_RESULT_CACHE, e.g. 256MB, or a percentage of the physical memory. The "
+    "cache is disabled if this is 0.");
+DEFINE_string(query_result_cache_max_entry_size, "16MB", "(Advanced) Maximum memory "
+    "used by the results of a single statement in the query result cache. Statements "
+    "with larger results are not cached.");
+
+DEFINE_string(plan_cache_capacity, "0", "(Advanced) Memory limit of the coordinator's "
+    "cache of the plans of SELECT statements that set the query option USE_PLAN_CACHE, "
+    "e.g. 64MB, or a percentage of the physical memory. The cache is disabled if this "
+    "is 0.");
+DEFINE_int32(plan_cache_entry_ttl_s, 60, "(Advanced) Maximum time in seconds that a plan "
+    "is reused from the plan cache. Since the cache is only invalidated by catalog "
+    "changes, this bounds how long authorization policy changes that are not part of the "
+    "catalog take to apply to cached plans.");
+
 DEFINE_int32(max_audit_event_log_file_size, 5000, "The maximum size (in queries) of the "
     "audit event log file before a new one is created (if event logging is enabled)");
 DEFINE_string(audit_event_log_dir, "", "The directory in which audit event log files are "
@@ -270,6 +310,11 @@ DEFINE_int32(status_report_cancellation_padding, 20, "(Advanced) The coordinator
     "wait --status_report_max_retry_s * (1 + --status_report_cancellation_padding / 100) "
     "without receiving a status report before deciding that a backend is unresponsive "
     "and the query should be cancelled. This must be > 0.");
+DEFINE_int32(status_report_full_profile_interval, 10, "(Advanced) Every this many "
+    "status reports, and in the final report, a fragment instance sends its full "
+    "runtime profile to the coordinator. The reports in between only contain the "
+    "counters, info strings and events that changed since the last report that the "
+    "coordinator received. If set to <= 1, every report contains the full profile.");
 
 DEFINE_bool(is_coordinator, true, "If true, this Impala daemon can accept and coordinate "
     "queries from clients. If false, it will refuse client connections.");
@@ -481,6 +526,64 @@ ImpalaServer::ImpalaServer(ExecEnv* exec_env)
 
   ABORT_IF_ERROR(ExternalDataSourceExecutor::InitJNI(exec_env_->metrics()));
 
+  if (FLAGS_is_coordinator) {
+    bool is_percent;
+    int64_t result_cache_capacity = ParseUtil::ParseMemSpec(
+        FLAGS_query_result_cache_capacity, &is_percent, MemInfo::physical_mem());
+    int64_t result_cache_max_entry_size = ParseUtil::ParseMemSpec(
+        FLAGS_query_result_cache_max_entry_size, &is_percent, MemInfo::physical_mem());
+    if (result_cache_capacity < 0 || result_cache_max_entry_size < 0) {
+      CLEAN_EXIT_WITH_ERROR(Substitute("Invalid --query_result_cache_capacity or "
+          "--query_result_cache_max_entry_size value, must be a bytes value or a "
+          "percentage: $0, $1", FLAGS_query_result_cache_capacity,
+          FLAGS_query_result_cache_max_entry_size));
+    }
+    if (result_cache_capacity > 0) {
+      query_result_cache_.reset(new QueryResultCache(result_cache_capacity,
+          result_cache_max_entry_size, exec_env_->process_mem_tracker()));
+      query_result_cache_->InitMetrics(exec_env_->metrics());
+      LOG(INFO) << "Query result cache capacity: "
+                << PrettyPrinter::Print(result_cache_capacity, TUnit::BYTES);
+    }
+    int64_t plan_cache_capacity = ParseUtil::ParseMemSpec(
+        FLAGS_plan_cache_capacity, &is_percent, MemInfo::physical_mem());
+    if (plan_cache_capacity < 0) {
+      CLEAN_EXIT_WITH_ERROR(Substitute("Invalid --plan_cache_capacity value, must be a "
+          "bytes value or a percentage: $0", FLAGS_plan_cache_capacity));
+    }
+    if (plan_cache_capacity > 0) {
+      plan_cache_.reset(new PlanCache(plan_cache_capacity,
+          max(FLAGS_plan_cache_entry_ttl_s, 0) * 1000L,
+          exec_env_->process_mem_tracker()));
+      plan_cache_->InitMetrics(exec_env_->metrics());
+      LOG(INFO) << "Plan cache capacity: "
+                << PrettyPrinter::Print(plan_cache_capacity, TUnit::BYTES);
+    }
+  }
+
+  bool is_percent;
+  int64_t query_log_max_bytes = ParseUtil::ParseMemSpec(
+      FLAGS_query_log_max_bytes, &is_percent, MemInfo::physical_mem());
+  if (query_log_max_bytes < 0) {
+    CLEAN_EXIT_WITH_ERROR(Substitute("Invalid --query_log_max_bytes value, must be a "
+        "bytes value or a percentage: $0", FLAGS_query_log_max_bytes));
+  }
+  query_log_.reset(new QueryLog(FLAGS_query_log_size,
+      query_log_max_bytes == 0 ? -1 : query_log_max_bytes));
+  if (FLAGS_is_coordinator && !FLAGS_query_log_profile_dir.empty()) {
+    int64_t store_capacity = ParseUtil::ParseMemSpec(
+        FLAGS_query_log_profile_dir_capacity, &is_percent, 0);
+    if (store_capacity <= 0) {
+      CLEAN_EXIT_WITH_ERROR(Substitute("Invalid --query_log_profile_dir_capacity value, "
+          "must be a positive bytes value: $0", FLAGS_query_log_profile_dir_capacity));
+    }
+    query_profile_store_.reset(
+        new QueryProfileStore(FLAGS_query_log_profile_dir, store_capacity));
+    ABORT_IF_ERROR(query_profile_store_->Init());
+    LOG(INFO) << "Storing profiles evicted from the query log in "
+              << FLAGS_query_log_profile_dir;
+  }
+
   // Register the catalog update callback if running in a real cluster as a coordinator.
   if (!TestInfo::is_test() && FLAGS_is_coordinator) {
     auto catalog_cb = [this] (const StatestoreSubscriber::TopicDeltaMap& state,
@@ -698,10 +801,9 @@ Status ImpalaServer::GetRuntimeProfileOutput(const string& user,
 }
 
 Status ImpalaServer::GetQueryRecord(
-    const TUniqueId& query_id, QueryLogIndex::const_iterator* query_record) {
-  lock_guard<mutex> l(query_log_lock_);
-  *query_record = query_log_index_.find(query_id);
-  if (*query_record == query_log_index_.end()) {
+    const TUniqueId& query_id, QueryRecordPtr* query_record) {
+  *query_record = query_log_->Get(query_id);
+  if (*query_record == nullptr) {
     // Common error, so logging explicitly and eliding Status's stack trace.
     string err =
         strings::Substitute(LEGACY_INVALID_QUERY_HANDLE_TEMPLATE, PrintId(query_id));
@@ -752,35 +854,43 @@ Status ImpalaServer::GetRuntimeProfileOutput(const TUniqueId& query_id,
   // The query was not found in the active query map, search the query log.
   {
     // Set the profile for the original query.
-    QueryLogIndex::const_iterator query_record;
-    RETURN_IF_ERROR(GetQueryRecord(query_id, &query_record));
-    RETURN_IF_ERROR(CheckProfileAccess(user, query_record->second->effective_user,
-        query_record->second->user_has_profile_access));
-    RETURN_IF_ERROR(DecompressToProfile(format, query_record, original_profile));
+    QueryRecordPtr query_record;
+    Status status = GetQueryRecord(query_id, &query_record);
+    if (!status.ok()) {
+      // Profiles from the store are returned without the profile of a retried query.
+      if (GetStoredProfileOutput(query_id, user, format, original_profile).ok()) {
+        return Status::OK();
+      }
+      return status;
+    }
+    RETURN_IF_ERROR(CheckProfileAccess(user, query_record->effective_user,
+        query_record->user_has_profile_access));
+    RETURN_IF_ERROR(
+        DecompressToProfile(format, query_record->compressed_profile, original_profile));
 
     // Set the profile for the retried query.
-    if (query_record->second->was_retried) {
+    if (query_record->was_retried) {
       *was_retried = true;
-      DCHECK(query_record->second->retried_query_id != nullptr);
-      QueryLogIndex::const_iterator retried_query_record;
+      DCHECK(query_record->retried_query_id != nullptr);
+      QueryRecordPtr retried_query_record;
 
       // The profile of the retried profile should always be earlier in the query log
       // compared to the original profile. Since the query log is a FIFO queue, this
       // means that if the original profile is in the log, then the retried profile
       // must be in the log as well.
-      Status status =
-          GetQueryRecord(*query_record->second->retried_query_id, &retried_query_record);
+      status = GetQueryRecord(*query_record->retried_query_id, &retried_query_record);
       DCHECK(status.ok());
       RETURN_IF_ERROR(status);
 
       // If the original profile was accessible by the user, then the retried profile
       // must be accessible by the user as well.
-      status = CheckProfileAccess(user, retried_query_record->second->effective_user,
-          retried_query_record->second->user_has_profile_access);
+      status = CheckProfileAccess(user, retried_query_record->effective_user,
+          retried_query_record->user_has_profile_access);
       DCHECK(status.ok());
       RETURN_IF_ERROR(status);
 
-      RETURN_IF_ERROR(DecompressToProfile(format, retried_query_record, retried_profile));
+      RETURN_IF_ERROR(DecompressToProfile(
+          format, retried_query_record->compressed_profile, retried_profile));
     }
   }
   return Status::OK();
@@ -805,34 +915,68 @@ Status ImpalaServer::GetRuntimeProfileOutput(const TUniqueId& query_id,
 
   // The query was not found the active query map, search the query log.
   {
-    QueryLogIndex::const_iterator query_record = query_log_index_.find(query_id);
-    RETURN_IF_ERROR(GetQueryRecord(query_id, &query_record));
-    RETURN_IF_ERROR(CheckProfileAccess(user, query_record->second->effective_user,
-        query_record->second->user_has_profile_access));
-    RETURN_IF_ERROR(DecompressToProfile(format, query_record, profile));
+    QueryRecordPtr query_record;
+    Status status = GetQueryRecord(query_id, &query_record);
+    if (!status.ok()) {
+      if (GetStoredProfileOutput(query_id, user, format, profile).ok()) {
+        return Status::OK();
+      }
+      return status;
+    }
+    RETURN_IF_ERROR(CheckProfileAccess(user, query_record->effective_user,
+        query_record->user_has_profile_access));
+    RETURN_IF_ERROR(
+        DecompressToProfile(format, query_record->compressed_profile, profile));
   }
   return Status::OK();
 }
 
+Status ImpalaServer::GetStoredProfileOutput(const TUniqueId& query_id,
+    const string& user, TRuntimeProfileFormat::type format,
+    RuntimeProfileOutput* profile) {
+  QueryProfileStore::Entry entry;
+  if (query_profile_store_ == nullptr
+      || !query_profile_store_->Lookup(query_id, &entry)) {
+    return Status::Expected(
+        strings::Substitute(LEGACY_INVALID_QUERY_HANDLE_TEMPLATE, PrintId(query_id)));
+  }
+  RETURN_IF_ERROR(
+      CheckProfileAccess(user, entry.effective_user, entry.user_has_profile_access));
+  vector<uint8_t> compressed_profile;
+  RETURN_IF_ERROR(query_profile_store_->ReadProfile(entry, &compressed_profile));
+  return DecompressToProfile(format, compressed_profile, profile);
+}
+
 Status ImpalaServer::DecompressToProfile(TRuntimeProfileFormat::type format,
-    QueryLogIndex::const_iterator query_record, RuntimeProfileOutput* profile) {
+    const vector<uint8_t>& compressed_profile, RuntimeProfileOutput* profile) {
   if (format == TRuntimeProfileFormat::BASE64) {
-    Base64Encode(query_record->second->compressed_profile, profile->string_output);
+    if (!RuntimeProfile::IsCompressedCompact(compressed_profile)) {
+      Base64Encode(compressed_profile, profile->string_output);
+      return Status::OK();
+    }
+    // Readers of the BASE64 format expect compressed Thrift.
+    TRuntimeProfileTree thrift_profile;
+    RETURN_IF_ERROR(RuntimeProfile::DecompressToThrift(compressed_profile,
+        &thrift_profile));
+    vector<uint8_t> thrift_compressed_profile;
+    RETURN_IF_ERROR(
+        RuntimeProfile::CompressThrift(thrift_profile, &thrift_compressed_profile));
+    Base64Encode(thrift_compressed_profile, profile->string_output);
   } else if (format == TRuntimeProfileFormat::THRIFT) {
-    RETURN_IF_ERROR(RuntimeProfile::DecompressToThrift(
-        query_record->second->compressed_profile, profile->thrift_output));
+    RETURN_IF_ERROR(
+        RuntimeProfile::DecompressToThrift(compressed_profile, profile->thrift_output));
   } else if (format == TRuntimeProfileFormat::JSON) {
     ObjectPool tmp_pool;
     RuntimeProfile* tmp_profile;
-    RETURN_IF_ERROR(RuntimeProfile::DecompressToProfile(
-        query_record->second->compressed_profile, &tmp_pool, &tmp_profile));
+    RETURN_IF_ERROR(
+        RuntimeProfile::DecompressToProfile(compressed_profile, &tmp_pool, &tmp_profile));
     tmp_profile->ToJson(profile->json_output);
   } else {
     DCHECK_EQ(format, TRuntimeProfileFormat::STRING);
     ObjectPool tmp_pool;
     RuntimeProfile* tmp_profile;
-    RETURN_IF_ERROR(RuntimeProfile::DecompressToProfile(
-        query_record->second->compressed_profile, &tmp_pool, &tmp_profile));
+    RETURN_IF_ERROR(
+        RuntimeProfile::DecompressToProfile(compressed_profile, &tmp_pool, &tmp_profile));
     tmp_profile->PrettyPrint(profile->string_output);
   }
   return Status::OK();
@@ -902,7 +1046,6 @@ Status ImpalaServer::GetExecSummary(const TUniqueId& query_id, const string& use
   }
 
   // Look for the query in completed query log.
-  // IMPALA-5275: Don't create Status while holding query_log_lock_
   {
     string effective_user;
     bool user_has_profile_access = false;
@@ -910,22 +1053,23 @@ Status ImpalaServer::GetExecSummary(const TUniqueId& query_id, const string& use
     TExecSummary exec_summary;
     TExecSummary retried_exec_summary;
     {
-      lock_guard<mutex> l(query_log_lock_);
-      QueryLogIndex::const_iterator query_record = query_log_index_.find(query_id);
-      is_query_missing = query_record == query_log_index_.end();
+      QueryRecordPtr query_record = query_log_->Get(query_id);
+      is_query_missing = query_record == nullptr;
       if (!is_query_missing) {
-        effective_user = query_record->second->effective_user;
-        user_has_profile_access = query_record->second->user_has_profile_access;
-        exec_summary = query_record->second->exec_summary;
-        if (query_record->second->was_retried) {
+        effective_user = query_record->effective_user;
+        user_has_profile_access = query_record->user_has_profile_access;
+        exec_summary = query_record->exec_summary;
+        if (query_record->was_retried) {
           if (was_retried != nullptr) *was_retried = true;
-          DCHECK(query_record->second->retried_query_id != nullptr);
-          QueryLogIndex::const_iterator retried_query_record =
-              query_log_index_.find(*query_record->second->retried_query_id);
+          DCHECK(query_record->retried_query_id != nullptr);
+          QueryRecordPtr retried_query_record =
+              query_log_->Get(*query_record->retried_query_id);
           // The retried query ran later than the original query. We should be able to
           // find it in the query log since we have found the original query.
-          DCHECK(retried_query_record != query_log_index_.end());
-          retried_exec_summary = retried_query_record->second->exec_summary;
+          DCHECK(retried_query_record != nullptr);
+          if (retried_query_record != nullptr) {
+            retried_exec_summary = retried_query_record->exec_summary;
+          }
         }
       }
     }
@@ -988,8 +1132,10 @@ Status ImpalaServer::GetExecSummary(const TUniqueId& query_id, const string& use
 }
 
 void ImpalaServer::ArchiveQuery(const QueryHandle& query_handle) {
+  TRuntimeProfileTree thrift_profile;
+  query_handle->profile()->ToThrift(&thrift_profile);
   vector<uint8_t> compressed_profile;
-  Status status = query_handle->profile()->Compress(&compressed_profile);
+  Status status = RuntimeProfile::CompressThrift(thrift_profile, &compressed_profile);
   if (!status.ok()) {
     // Didn't serialize the string. Continue with empty string.
     LOG_EVERY_N(WARNING, 1000) << "Could not serialize profile to archive string "
@@ -1014,6 +1160,14 @@ void ImpalaServer::ArchiveQuery(const QueryHandle& query_handle) {
   }
 
   if (FLAGS_query_log_size == 0) return;
+  if (FLAGS_query_log_compact_profiles) {
+    status = RuntimeProfile::CompressCompact(&thrift_profile, &compressed_profile);
+    if (!status.ok()) {
+      LOG_EVERY_N(WARNING, 1000) << "Could not serialize compact profile "
+                                 << status.GetDetail();
+      return;
+    }
+  }
   // 'fetch_rows_lock()' protects several fields in ClientReqestState that are read
   // during QueryStateRecord creation. There should be no contention on this lock because
   // the query has already been closed (e.g. no more results can be fetched).
@@ -1025,16 +1179,16 @@ void ImpalaServer::ArchiveQuery(const QueryHandle& query_handle) {
   if (query_handle->GetCoordinator() != nullptr) {
     query_handle->GetCoordinator()->GetTExecSummary(&record->exec_summary);
   }
-  {
-    lock_guard<mutex> l(query_log_lock_);
-    // Add record to the beginning of the log, and to the lookup index.
-    query_log_index_[query_handle->query_id()] = record.get();
-    query_log_.insert(query_log_.begin(), move(record));
-
-    if (FLAGS_query_log_size > -1 && FLAGS_query_log_size < query_log_.size()) {
-      DCHECK_EQ(query_log_.size() - FLAGS_query_log_size, 1);
-      query_log_index_.erase(query_log_.back()->id);
-      query_log_.pop_back();
+  const int64_t record_bytes = record->EstimatedBytes();
+  vector<QueryRecordPtr> evicted;
+  query_log_->Add(query_handle->query_id(), move(record), record_bytes, &evicted);
+  if (query_profile_store_ == nullptr) return;
+  for (const QueryRecordPtr& evicted_record : evicted) {
+    status = query_profile_store_->Add(evicted_record->id, evicted_record->effective_user,
+        evicted_record->user_has_profile_access, evicted_record->compressed_profile);
+    if (!status.ok()) {
+      LOG_EVERY_N(WARNING, 1000) << "Could not store evicted profile "
+                                 << status.GetDetail();
     }
   }
 }
@@ -2023,6 +2177,10 @@ void ImpalaServer::CatalogUpdateCallback(
             resp.new_catalog_version << " new min catalog object version: " <<
             resp.catalog_object_version_lower_bound;
       }
+      if (catalog_update_info_.catalog_version != resp.new_catalog_version) {
+        if (query_result_cache_ != nullptr) query_result_cache_->Invalidate();
+        if (plan_cache_ != nullptr) plan_cache_->Invalidate();
+      }
       catalog_update_info_.catalog_version = resp.new_catalog_version;
       catalog_update_info_.catalog_topic_version = delta.to_version;
       catalog_update_info_.catalog_service_id = resp.catalog_service_id;
@@ -2109,6 +2267,13 @@ void ImpalaServer::WaitForMinCatalogUpdate(const int64_t min_req_catalog_object_
 Status ImpalaServer::ProcessCatalogUpdateResult(
     const TCatalogUpdateResult& catalog_update_result, bool wait_for_all_subscribers) {
   const TUniqueId& catalog_service_id = catalog_update_result.catalog_service_id;
+  // The operation may have changed the data of tables, e.g. an INSERT. Invalidate the
+  // query result cache and the plan cache once the local catalog cache reflects the
+  // change, so that queries planned before that cannot add stale results or plans.
+  const auto invalidate_caches = MakeScopeExitTrigger([this]() {
+    if (query_result_cache_ != nullptr) query_result_cache_->Invalidate();
+    if (plan_cache_ != nullptr) plan_cache_->Invalidate();
+  });
   if (!catalog_update_result.__isset.updated_catalog_objects &&
       !catalog_update_result.__isset.removed_catalog_objects) {
     // Operation with no result set. Use the version specified in
@@ -2271,7 +2436,7 @@ void ImpalaServer::BuildLocalBackendDescriptorInternal(BackendDescriptorPB* be_d
 
 ImpalaServer::QueryStateRecord::QueryStateRecord(
     const ClientRequestState& query_handle, vector<uint8_t>&& compressed_profile)
-  : compressed_profile(compressed_profile) {
+  : compressed_profile(move(compressed_profile)) {
   Init(query_handle);
 }
 
@@ -2280,6 +2445,29 @@ ImpalaServer::QueryStateRecord::QueryStateRecord(const ClientRequestState& query
   Init(query_handle);
 }
 
+/// Returns the size of 'obj' serialized with the Thrift compact protocol, which is used
+/// as an estimate of its memory consumption.
+template <typename T>
+static int64_t EstimateThriftBytes(ThriftSerializer* serializer, const T& obj) {
+  uint32_t len = 0;
+  uint8_t* buffer;
+  if (!serializer->SerializeToBuffer(&obj, &len, &buffer).ok()) return 0;
+  return len;
+}
+
+int64_t ImpalaServer::QueryStateRecord::EstimatedBytes() const {
+  ThriftSerializer serializer(true);
+  int64_t bytes = sizeof(*this) + compressed_profile.capacity() + effective_user.size()
+      + default_db.size() + stmt.size() + plan.size() + query_state.size()
+      + resource_pool.size()
+      + EstimateThriftBytes(&serializer, exec_summary)
+      + EstimateThriftBytes(&serializer, event_sequence);
+  for (const TPlanFragment& fragment : fragments) {
+    bytes += EstimateThriftBytes(&serializer, fragment);
+  }
+  return bytes;
+}
+
 void ImpalaServer::QueryStateRecord::Init(const ClientRequestState& query_handle) {
   id = query_handle.query_id();
   const TExecRequest& request = query_handle.exec_request();
@@ -3155,6 +3343,9 @@ Status ImpalaServer::StartShutdown(
     }
   }
   LOG(INFO) << "Shutdown complete, going down.";
+  // Persist the data cache index so that the cached data can be reused after a restart.
+  io::DataCache* data_cache = ExecEnv::GetInstance()->disk_io_mgr()->remote_data_cache();
+  if (data_cache != nullptr) data_cache->Checkpoint();
   // Use _exit here instead since exit() does cleanup which interferes with the shutdown
   // signal handler thread causing a data race.
   ShutdownLogging();
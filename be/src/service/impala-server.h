@@ -42,6 +42,7 @@
 #include "util/condition-variable.h"
 #include "util/container-util.h"
 #include "util/runtime-profile.h"
+#include "util/sharded-query-log.h"
 #include "util/sharded-query-map-util.h"
 #include "util/simple-logger.h"
 #include "util/thread-pool.h"
@@ -74,6 +75,9 @@ class TGetExecSummaryResp;
 class TGetExecSummaryReq;
 class ClientRequestState;
 class QueryDriver;
+class QueryProfileStore;
+class PlanCache;
+class QueryResultCache;
 struct QueryHandle;
 class SimpleLogger;
 class UpdateFilterParamsPB;
@@ -184,7 +188,7 @@ class TQueryExecRequest;
 /// 7. Coordinator::exec_summary_lock
 ///
 /// The following locks are not held in conjunction with other locks:
-/// * query_log_lock_
+/// * the shard locks of query_log_
 /// * session_timeout_lock_
 /// * query_locations_lock_
 /// * uuid_lock_
@@ -460,6 +464,10 @@ class ImpalaServer : public ImpalaServiceIf,
   /// Returns whether this backend is healthy, i.e. able to accept queries.
   bool IsHealthy();
 
+  /// Returns the cache of query results, or nullptr if it is disabled.
+  QueryResultCache* query_result_cache() { return query_result_cache_.get(); }
+  PlanCache* plan_cache() { return plan_cache_.get(); }
+
   /// Returns the port that the Beeswax server is listening on. Valid to call after
   /// the server has started successfully.
   int GetBeeswaxPort();
@@ -981,6 +989,9 @@ class ImpalaServer : public ImpalaServiceIf,
     QueryStateRecord(
         const ClientRequestState& exec_state, std::vector<uint8_t>&& compressed_profile);
 
+    /// Returns the estimated memory consumption of the record in bytes.
+    int64_t EstimatedBytes() const;
+
     /// Initialize from 'exec_state' of a running query
     QueryStateRecord(const ClientRequestState& exec_state);
 
@@ -1187,30 +1198,32 @@ class ImpalaServer : public ImpalaServiceIf,
   /// Random number generator for use in this class, thread safe.
   static ThreadSafeRandom rng_;
 
-  /// Guards query_log_ and query_log_index_
-  std::mutex query_log_lock_;
-
-  /// FIFO list of query records, which are written after the query finishes executing.
-  /// Queries may briefly have entries in 'query_log_' and 'query_driver_map_'
-  /// while the query is being unregistered.
-  typedef std::list<std::unique_ptr<QueryStateRecord>> QueryLog;
-  QueryLog query_log_;
-
-  /// Index that allows lookup via TUniqueId into the query log. The QueryStateRecord
-  /// value is owned by 'query_log_' so the entry in this index must be removed when
-  /// it is removed from 'query_log_'.
-  typedef boost::unordered_map<TUniqueId, QueryStateRecord*> QueryLogIndex;
-  QueryLogIndex query_log_index_;
-
-  /// Sets the given QueryLogIndex for the given query_id. Returns an error Status if the
-  /// given query_id cannot be found in the QueryLogIndex.
-  Status GetQueryRecord(
-      const TUniqueId& query_id, QueryLogIndex::const_iterator* query_record);
+  /// Log of query records, which are written after the query finishes executing.
+  /// Bounded by --query_log_size records and --query_log_max_bytes bytes. Queries may
+  /// briefly have entries in 'query_log_' and 'query_driver_map_' while the query is
+  /// being unregistered.
+  typedef ShardedQueryLog<QueryStateRecord> QueryLog;
+  typedef QueryLog::RecordPtr QueryRecordPtr;
+  boost::scoped_ptr<QueryLog> query_log_;
+
+  /// Store for the profiles of records evicted from 'query_log_', if
+  /// --query_log_profile_dir is set.
+  boost::scoped_ptr<QueryProfileStore> query_profile_store_;
+
+  /// Sets 'query_record' to the record of 'query_id' in the query log. Returns an error
+  /// Status if the given query_id cannot be found in the query log.
+  Status GetQueryRecord(const TUniqueId& query_id, QueryRecordPtr* query_record);
+
+  /// Looks up the profile of 'query_id' in 'query_profile_store_', checks that 'user'
+  /// may access it and decompresses it into the specified format. Returns an error if
+  /// there is no store or it does not have the profile.
+  Status GetStoredProfileOutput(const TUniqueId& query_id, const std::string& user,
+      TRuntimeProfileFormat::type format, RuntimeProfileOutput* profile);
 
-  /// Decompresses the profile in the given QueryStateRecord into the specified format.
+  /// Decompresses 'compressed_profile' of a QueryStateRecord into the specified format.
   /// The decompressed profile is added to the given RuntimeProfileOutput.
   Status DecompressToProfile(TRuntimeProfileFormat::type format,
-      QueryLogIndex::const_iterator query_record, RuntimeProfileOutput* profile);
+      const std::vector<uint8_t>& compressed_profile, RuntimeProfileOutput* profile);
 
   /// Logger for writing encoded query profiles, one per line with the following format:
   /// <ms-since-epoch> <query-id> <thrift query profile URL encoded and gzipped>
@@ -1236,6 +1249,15 @@ class ImpalaServer : public ImpalaServiceIf,
   /// global, per-server state
   ExecEnv* exec_env_;  // not owned
 
+  /// Cache of the results of SELECT statements, see QueryResultCache. Only set on
+  /// coordinators with --query_result_cache_capacity > 0. Invalidated by every catalog
+  /// update.
+  std::unique_ptr<QueryResultCache> query_result_cache_;
+
+  /// Cache of the plans of SELECT statements, see PlanCache. Only set on coordinators
+  /// with --plan_cache_capacity > 0. Invalidated by every catalog update.
+  std::unique_ptr<PlanCache> plan_cache_;
+
   /// Thread pool to process cancellation requests that come from failed Impala demons to
   /// avoid blocking the statestore callback.
   boost::scoped_ptr<ThreadPool<CancellationWork>> cancellation_thread_pool_;
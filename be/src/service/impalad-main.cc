@@ -44,6 +44,7 @@
 #include "util/jni-util.h"
 #include "util/metrics.h"
 #include "util/network-util.h"
+#include "util/stopwatch.h"
 #include "util/thread.h"
 
 #include "common/names.h"
@@ -58,8 +59,21 @@ DECLARE_bool(is_coordinator);
 
 int ImpaladMain(int argc, char** argv) {
   InitCommonRuntime(argc, argv, true);
+  MonotonicStopWatch total_timer;
+  total_timer.Start();
+
+  // Initializing LLVM and loading its IR module is independent of the JVM and the
+  // ExecEnv, so do it in the background while those initialize.
+  MonotonicStopWatch llvm_timer;
+  llvm_timer.Start();
+  Status llvm_status;
+  unique_ptr<Thread> llvm_init_thread;
+  ABORT_IF_ERROR(Thread::Create("impala-server", "llvm-init",
+      [&llvm_status, &llvm_timer]() {
+        llvm_status = LlvmCodeGen::InitializeLlvm();
+        llvm_timer.Stop();
+      }, &llvm_init_thread));
 
-  ABORT_IF_ERROR(LlvmCodeGen::InitializeLlvm());
   JniUtil::InitLibhdfs();
   ABORT_IF_ERROR(HBaseTableScanner::Init());
   ABORT_IF_ERROR(HBaseTable::InitJNI());
@@ -69,7 +83,10 @@ int ImpaladMain(int argc, char** argv) {
   InitFeSupport();
 
   ExecEnv exec_env;
+  MonotonicStopWatch exec_env_timer;
+  exec_env_timer.Start();
   ABORT_IF_ERROR(exec_env.Init());
+  exec_env.RecordStartupPhase("exec-env", exec_env_timer.ElapsedTime());
   CommonMetrics::InitCommonMetrics(exec_env.metrics());
 
   ABORT_IF_ERROR(TimezoneDatabase::Initialize());
@@ -83,6 +100,13 @@ int ImpaladMain(int argc, char** argv) {
       StartThreadInstrumentation(exec_env.metrics(), exec_env.webserver(), true));
   InitRpcEventTracing(exec_env.webserver(), exec_env.rpc_mgr());
 
+  // Fragments may be codegen'd as soon as the server starts.
+  llvm_init_thread->Join();
+  ABORT_IF_ERROR(llvm_status);
+  exec_env.RecordStartupPhase("llvm", llvm_timer.ElapsedTime());
+
+  MonotonicStopWatch impala_server_timer;
+  impala_server_timer.Start();
   std::shared_ptr<ImpalaServer> impala_server(new ImpalaServer(&exec_env));
   Status status = impala_server->Start(FLAGS_beeswax_port, FLAGS_hs2_port,
       FLAGS_hs2_http_port, FLAGS_external_fe_port);
@@ -92,6 +116,8 @@ int ImpaladMain(int argc, char** argv) {
     ShutdownLogging();
     exit(1);
   }
+  exec_env.RecordStartupPhase("impala-server", impala_server_timer.ElapsedTime());
+  exec_env.RecordStartupPhase("total", total_timer.ElapsedTime());
   ABORT_IF_ERROR(StartImpalaShutdownSignalHandlerThread());
   impala_server->Join();
 
@@ -0,0 +1,148 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <string>
+
+#include <gutil/strings/substitute.h>
+
+#include "runtime/mem-tracker.h"
+#include "service/plan-cache.h"
+#include "testutil/gtest-util.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static TQueryCtx MakeQueryCtx(const string& stmt, int64_t query_id) {
+  TQueryCtx query_ctx;
+  query_ctx.client_request.__set_stmt(stmt);
+  query_ctx.session.__set_connected_user("alice");
+  query_ctx.session.__set_database("default");
+  query_ctx.query_id.__set_hi(query_id);
+  query_ctx.query_id.__set_lo(query_id);
+  query_ctx.__set_now_string(Substitute("2026-01-01 00:00:0$0", query_id));
+  return query_ctx;
+}
+
+/// Returns a request for a query with a single HDFS scan planned for 'query_ctx'.
+static TExecRequest MakeExecRequest(const TQueryCtx& query_ctx) {
+  TExecRequest exec_request;
+  exec_request.__set_stmt_type(TStmtType::QUERY);
+  exec_request.__isset.query_exec_request = true;
+  exec_request.query_exec_request.__set_query_ctx(query_ctx);
+  exec_request.query_exec_request.query_ctx.__set_request_pool("pool");
+  exec_request.query_exec_request.plan_exec_info.emplace_back();
+  exec_request.query_exec_request.plan_exec_info.back().fragments.emplace_back();
+  TPlanFragment& fragment =
+      exec_request.query_exec_request.plan_exec_info.back().fragments.back();
+  fragment.__isset.plan = true;
+  fragment.plan.nodes.emplace_back();
+  fragment.plan.nodes.back().__set_node_type(TPlanNodeType::HDFS_SCAN_NODE);
+  exec_request.timeline.labels.push_back("Planning finished");
+  exec_request.timeline.timestamps.push_back(1);
+  return exec_request;
+}
+
+TEST(PlanCacheTest, GetKey) {
+  string key1;
+  EXPECT_TRUE(PlanCache::GetKey(MakeQueryCtx("select 1", 1), 1, &key1));
+  // The key does not depend on fields that change between executions.
+  string key2;
+  EXPECT_TRUE(PlanCache::GetKey(MakeQueryCtx(" select 1 ", 2), 1, &key2));
+  EXPECT_EQ(key1, key2);
+  // The key depends on the cluster membership, the user and the query options.
+  EXPECT_TRUE(PlanCache::GetKey(MakeQueryCtx("select 1", 1), 2, &key2));
+  EXPECT_NE(key1, key2);
+  TQueryCtx query_ctx = MakeQueryCtx("select 1", 1);
+  query_ctx.session.__set_delegated_user("bob");
+  EXPECT_TRUE(PlanCache::GetKey(query_ctx, 1, &key2));
+  EXPECT_NE(key1, key2);
+  query_ctx = MakeQueryCtx("select 1", 1);
+  query_ctx.client_request.query_options.__set_mt_dop(4);
+  EXPECT_TRUE(PlanCache::GetKey(query_ctx, 1, &key2));
+  EXPECT_NE(key1, key2);
+
+  // Child queries are planned by their parent.
+  query_ctx = MakeQueryCtx("select 1", 1);
+  query_ctx.__set_parent_query_id(query_ctx.query_id);
+  EXPECT_FALSE(PlanCache::GetKey(query_ctx, 1, &key2));
+}
+
+TEST(PlanCacheTest, IsCacheable) {
+  TQueryCtx query_ctx = MakeQueryCtx("select 1", 1);
+  TExecRequest exec_request = MakeExecRequest(query_ctx);
+  EXPECT_TRUE(PlanCache::IsCacheable(exec_request));
+  exec_request.query_exec_request.plan_exec_info[0].fragments[0].plan.nodes[0]
+      .__set_node_type(TPlanNodeType::KUDU_SCAN_NODE);
+  EXPECT_FALSE(PlanCache::IsCacheable(exec_request));
+  exec_request = MakeExecRequest(query_ctx);
+  exec_request.query_exec_request.query_ctx.__set_transaction_id(1);
+  EXPECT_FALSE(PlanCache::IsCacheable(exec_request));
+  // Plans into which the planner folded the time of planning are not cached.
+  exec_request = MakeExecRequest(query_ctx);
+  exec_request.query_exec_request.query_ctx.__set_plan_is_query_specific(true);
+  EXPECT_FALSE(PlanCache::IsCacheable(exec_request));
+  // Non-deterministic results do not prevent reusing the plan.
+  exec_request = MakeExecRequest(query_ctx);
+  exec_request.query_exec_request.query_ctx.__set_results_are_nondeterministic(true);
+  EXPECT_TRUE(PlanCache::IsCacheable(exec_request));
+  exec_request = MakeExecRequest(query_ctx);
+  exec_request.__set_stmt_type(TStmtType::DML);
+  EXPECT_FALSE(PlanCache::IsCacheable(exec_request));
+}
+
+TEST(PlanCacheTest, LookupAndInvalidate) {
+  MemTracker parent;
+  PlanCache cache(1024 * 1024, 60 * 1000, &parent);
+  const TQueryCtx query_ctx1 = MakeQueryCtx("select 1", 1);
+  const TQueryCtx query_ctx2 = MakeQueryCtx("select 1", 2);
+  TExecRequest exec_request;
+  EXPECT_FALSE(cache.Lookup("q1", query_ctx2, &exec_request));
+  EXPECT_TRUE(cache.Insert("q1", cache.generation(), MakeExecRequest(query_ctx1)));
+  EXPECT_GT(parent.consumption(), 0);
+
+  // A hit returns the request with the fields of the new execution and keeps the fields
+  // set by the planner.
+  ASSERT_TRUE(cache.Lookup("q1", query_ctx2, &exec_request));
+  const TQueryCtx& cached_ctx = exec_request.query_exec_request.query_ctx;
+  EXPECT_EQ(query_ctx2.query_id, cached_ctx.query_id);
+  EXPECT_EQ(query_ctx2.now_string, cached_ctx.now_string);
+  EXPECT_EQ("pool", cached_ctx.request_pool);
+  EXPECT_TRUE(exec_request.timeline.labels.empty());
+
+  // Plans of queries planned before an invalidation are not added.
+  int64_t generation = cache.generation();
+  cache.Invalidate();
+  EXPECT_FALSE(cache.Lookup("q1", query_ctx2, &exec_request));
+  EXPECT_EQ(0, parent.consumption());
+  EXPECT_FALSE(cache.Insert("q1", generation, MakeExecRequest(query_ctx1)));
+  EXPECT_FALSE(cache.Lookup("q1", query_ctx2, &exec_request));
+}
+
+TEST(PlanCacheTest, Expiry) {
+  MemTracker parent;
+  PlanCache cache(1024 * 1024, 0, &parent);
+  const TQueryCtx query_ctx = MakeQueryCtx("select 1", 1);
+  EXPECT_TRUE(cache.Insert("q1", cache.generation(), MakeExecRequest(query_ctx)));
+  SleepForMs(2);
+  TExecRequest exec_request;
+  EXPECT_FALSE(cache.Lookup("q1", query_ctx, &exec_request));
+  EXPECT_EQ(0, parent.consumption());
+}
+
+}
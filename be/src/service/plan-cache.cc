@@ -0,0 +1,202 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "service/plan-cache.h"
+
+#include <boost/algorithm/string/trim.hpp>
+#include <gutil/strings/substitute.h>
+
+#include "rpc/thrift-util.h"
+#include "runtime/mem-tracker.h"
+#include "util/metrics.h"
+#include "util/query-cache-util.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+using boost::algorithm::trim_copy;
+
+namespace impala {
+
+// Replaces the fields of 'cached_ctx' that are set for every execution of a statement,
+// mostly by ImpalaServer::PrepareQueryContext(), with those of 'query_ctx'. The other
+// fields are the same for all executions or were set by the planner.
+static void UpdateQueryCtx(const TQueryCtx& query_ctx, TQueryCtx* cached_ctx) {
+  cached_ctx->__set_query_id(query_ctx.query_id);
+  cached_ctx->__set_session(query_ctx.session);
+  cached_ctx->__set_now_string(query_ctx.now_string);
+  cached_ctx->__set_utc_timestamp_string(query_ctx.utc_timestamp_string);
+  cached_ctx->__set_start_unix_millis(query_ctx.start_unix_millis);
+  cached_ctx->__set_pid(query_ctx.pid);
+  cached_ctx->__set_coord_hostname(query_ctx.coord_hostname);
+  cached_ctx->__set_coord_ip_address(query_ctx.coord_ip_address);
+  cached_ctx->__set_coord_backend_id(query_ctx.coord_backend_id);
+  cached_ctx->__set_status_report_interval_ms(query_ctx.status_report_interval_ms);
+  cached_ctx->__set_status_report_max_retry_s(query_ctx.status_report_max_retry_s);
+  cached_ctx->__set_gen_aggregated_profile(query_ctx.gen_aggregated_profile);
+  cached_ctx->__set_trace_resource_usage(query_ctx.trace_resource_usage);
+}
+
+PlanCache::PlanCache(int64_t capacity, int64_t ttl_ms, MemTracker* parent_mem_tracker)
+  : capacity_(capacity),
+    ttl_ms_(ttl_ms),
+    mem_tracker_(new MemTracker(-1, "Plan Cache", parent_mem_tracker)) {
+  DCHECK_GT(capacity, 0);
+}
+
+PlanCache::~PlanCache() {
+  {
+    lock_guard<mutex> l(lock_);
+    while (!entries_.empty()) Erase(entries_.begin());
+  }
+  mem_tracker_->Close();
+}
+
+void PlanCache::InitMetrics(MetricGroup* metrics) {
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("plan-cache");
+  hits_ = cache_metrics->AddCounter("plan-cache.hit-count", 0);
+  misses_ = cache_metrics->AddCounter("plan-cache.miss-count", 0);
+  evictions_ = cache_metrics->AddCounter("plan-cache.eviction-count", 0);
+  invalidations_ = cache_metrics->AddCounter("plan-cache.invalidation-count", 0);
+  total_bytes_ = cache_metrics->AddGauge("plan-cache.total-bytes", 0);
+  num_entries_ = cache_metrics->AddGauge("plan-cache.num-entries", 0);
+}
+
+bool PlanCache::GetKey(const TQueryCtx& query_ctx, int64_t membership_version,
+    string* key) {
+  // Child queries, e.g. of COMPUTE STATS, are planned by their parent.
+  if (query_ctx.__isset.parent_query_id) return false;
+  string options;
+  ThriftSerializer serializer(/* compact */ true);
+  Status status =
+      serializer.SerializeToString(&query_ctx.client_request.query_options, &options);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not serialize the query options, not using the plan cache: "
+                 << status.GetDetail();
+    return false;
+  }
+  const TSessionState& session = query_ctx.session;
+  *key = Substitute("$0\n$1\n$2\n$3\n$4\n$5\n$6",
+      static_cast<int>(session.session_type), session.connected_user,
+      session.delegated_user, session.database, membership_version, options,
+      trim_copy(query_ctx.client_request.stmt));
+  return true;
+}
+
+bool PlanCache::IsCacheable(const TExecRequest& exec_request) {
+  if (exec_request.stmt_type != TStmtType::QUERY
+      || !exec_request.__isset.query_exec_request) {
+    return false;
+  }
+  return IsQueryPlanReusable(exec_request.query_exec_request);
+}
+
+bool PlanCache::Lookup(const string& key, const TQueryCtx& query_ctx,
+    TExecRequest* exec_request) {
+  shared_ptr<const string> serialized_request;
+  {
+    lock_guard<mutex> l(lock_);
+    auto it = entries_.find(key);
+    if (it != entries_.end() && MonotonicMillis() - it->second.insert_time_ms > ttl_ms_) {
+      Erase(it);
+      it = entries_.end();
+    }
+    if (it == entries_.end()) {
+      if (misses_ != nullptr) misses_->Increment(1);
+      return false;
+    }
+    lru_list_.splice(lru_list_.end(), lru_list_, it->second.lru_it);
+    serialized_request = it->second.serialized_request;
+  }
+  uint32_t len = serialized_request->size();
+  Status status = DeserializeThriftMsg(
+      reinterpret_cast<const uint8_t*>(serialized_request->data()), &len,
+      /* compact */ true, exec_request);
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not deserialize a cached plan: " << status.GetDetail();
+    if (misses_ != nullptr) misses_->Increment(1);
+    return false;
+  }
+  UpdateQueryCtx(query_ctx, &exec_request->query_exec_request.query_ctx);
+  // The planner did not run for this query.
+  exec_request->timeline.labels.clear();
+  exec_request->timeline.timestamps.clear();
+  if (hits_ != nullptr) hits_->Increment(1);
+  return true;
+}
+
+bool PlanCache::Insert(
+    const string& key, int64_t generation, const TExecRequest& exec_request) {
+  auto serialized_request = make_shared<string>();
+  ThriftSerializer serializer(/* compact */ true);
+  Status status = serializer.SerializeToString(&exec_request, serialized_request.get());
+  if (!status.ok()) {
+    LOG(WARNING) << "Could not serialize a plan for the plan cache: "
+                 << status.GetDetail();
+    return false;
+  }
+  // The key is stored twice, in 'entries_' and 'lru_list_'.
+  const int64_t charge =
+      serialized_request->size() + 2 * key.size() + sizeof(CacheValue);
+  if (charge > capacity_) return false;
+  lock_guard<mutex> l(lock_);
+  if (generation != generation_) return false;
+  auto existing = entries_.find(key);
+  if (existing != entries_.end()) Erase(existing);
+  while (total_charge_ + charge > capacity_) {
+    DCHECK(!lru_list_.empty());
+    Erase(entries_.find(lru_list_.front()));
+    if (evictions_ != nullptr) evictions_->Increment(1);
+  }
+  lru_list_.push_back(key);
+  entries_.emplace(key, CacheValue{move(serialized_request), MonotonicMillis(), charge,
+      std::prev(lru_list_.end())});
+  total_charge_ += charge;
+  mem_tracker_->Consume(charge);
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(charge);
+    num_entries_->Increment(1);
+  }
+  return true;
+}
+
+void PlanCache::Invalidate() {
+  lock_guard<mutex> l(lock_);
+  ++generation_;
+  if (invalidations_ != nullptr) invalidations_->Increment(1);
+  while (!entries_.empty()) Erase(entries_.begin());
+}
+
+int64_t PlanCache::generation() {
+  lock_guard<mutex> l(lock_);
+  return generation_;
+}
+
+void PlanCache::Erase(std::unordered_map<string, CacheValue>::iterator it) {
+  DCHECK(it != entries_.end());
+  const int64_t charge = it->second.charge;
+  lru_list_.erase(it->second.lru_it);
+  entries_.erase(it);
+  total_charge_ -= charge;
+  mem_tracker_->Release(charge);
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(-charge);
+    num_entries_->Increment(-1);
+  }
+}
+
+}
@@ -0,0 +1,147 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/status.h"
+#include "util/metrics-fwd.h"
+
+#include "gen-cpp/Frontend_types.h"
+#include "gen-cpp/Query_types.h"
+
+namespace impala {
+
+class MemTracker;
+class MetricGroup;
+
+/// Coordinator-wide cache of the TExecRequests of SELECT statements, so that a repeated
+/// identical statement skips the frontend planner. Queries opt in with the
+/// USE_PLAN_CACHE query option. The key, computed by GetKey(), covers the statement,
+/// the session database and user, the query options and the version of the cluster
+/// membership. Since the user is part of the key, the privileges checked during
+/// planning and the audit events of the cached request remain valid for the user.
+///
+/// Like the QueryResultCache, the cache does not track which tables a statement read.
+/// Every change of the catalog invalidates all entries by calling Invalidate(), so the
+/// scan ranges of a cached request always match the current table metadata. Insert()
+/// takes the generation() read before the statement was planned and drops the entry if
+/// the cache was invalidated since. Entries expire after the TTL given to the
+/// constructor, which bounds how long changes of authorization policies that are not
+/// part of the catalog take to apply.
+///
+/// Requests are stored serialized in the compact Thrift protocol. The cache is bounded
+/// by the capacity given to the constructor and evicts in LRU order. The memory of the
+/// entries is tracked by the cache's own MemTracker, a child of the process MemTracker.
+///
+/// All functions are thread-safe.
+class PlanCache {
+ public:
+  /// 'capacity' is the maximum memory in bytes used by the entries. Entries older than
+  /// 'ttl_ms' are not returned by Lookup().
+  PlanCache(int64_t capacity, int64_t ttl_ms, MemTracker* parent_mem_tracker);
+  ~PlanCache();
+
+  /// Registers the metrics of the cache in 'metrics'.
+  void InitMetrics(MetricGroup* metrics);
+
+  /// Computes the key of the statement of 'query_ctx' in 'key'. 'membership_version' is
+  /// the version of the cluster membership that the statement is planned for. Returns
+  /// false for child queries, which are planned by their parent.
+  static bool GetKey(const TQueryCtx& query_ctx, int64_t membership_version,
+      std::string* key);
+
+  /// Returns true if 'exec_request', which the frontend created for a statement with a
+  /// key, can be cached. Decided by IsQueryPlanReusable(), which relies on the planner
+  /// to flag plans that are specific to one execution, also through views.
+  static bool IsCacheable(const TExecRequest& exec_request);
+
+  /// Looks up the request for 'key'. On a hit, deserializes the request into
+  /// 'exec_request', replaces the fields of its query context that differ between
+  /// executions with those of 'query_ctx' and returns true.
+  bool Lookup(const std::string& key, const TQueryCtx& query_ctx,
+      TExecRequest* exec_request);
+
+  /// Adds 'exec_request' under 'key', replacing any existing entry, unless the cache was
+  /// invalidated since 'generation' was returned by generation(), or the request is
+  /// larger than the capacity. Returns true if the request was added.
+  bool Insert(const std::string& key, int64_t generation,
+      const TExecRequest& exec_request);
+
+  /// Removes all entries and makes pending insertions fail.
+  void Invalidate();
+
+  /// Returns the current generation of the cache, which changes with every
+  /// Invalidate().
+  int64_t generation();
+
+ private:
+  typedef std::list<std::string> LruList;
+
+  struct CacheValue {
+    /// The serialized TExecRequest. Shared, so that it can be deserialized without
+    /// holding 'lock_'.
+    std::shared_ptr<const std::string> serialized_request;
+
+    /// Time of the insertion, in milliseconds since an arbitrary point.
+    int64_t insert_time_ms;
+
+    /// Memory charged to the entry.
+    int64_t charge;
+
+    /// Position of the key in 'lru_list_'.
+    LruList::iterator lru_it;
+  };
+
+  /// Removes the entry pointed to by 'it' and releases its memory. 'lock_' must be held.
+  void Erase(std::unordered_map<std::string, CacheValue>::iterator it);
+
+  const int64_t capacity_;
+  const int64_t ttl_ms_;
+  std::unique_ptr<MemTracker> mem_tracker_;
+
+  /// Protects all members below.
+  std::mutex lock_;
+
+  /// All entries, keyed by GetKey().
+  std::unordered_map<std::string, CacheValue> entries_;
+
+  /// Keys of all entries, with the least recently used at the front.
+  LruList lru_list_;
+
+  /// Memory charged to all entries.
+  int64_t total_charge_ = 0;
+
+  /// Incremented by Invalidate().
+  int64_t generation_ = 0;
+
+  /// Metrics of the cache, registered in InitMetrics().
+  IntCounter* hits_ = nullptr;
+  IntCounter* misses_ = nullptr;
+  IntCounter* evictions_ = nullptr;
+  IntCounter* invalidations_ = nullptr;
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+}
@@ -158,6 +158,7 @@ TEST(QueryOptions, SetByteOptions) {
       {MAKE_OPTIONDEF(scratch_limit), {-1, I64_MAX}},
       {MAKE_OPTIONDEF(max_result_spooling_mem), {-1, I64_MAX}},
       {MAKE_OPTIONDEF(max_spilled_result_spooling_mem), {-1, I64_MAX}},
+      {MAKE_OPTIONDEF(runtime_broadcast_bytes_limit), {-1, I64_MAX}},
   };
   vector<pair<OptionDef<int32_t>, Range<int32_t>>> case_set_i32{
       {MAKE_OPTIONDEF(runtime_filter_min_size),
@@ -216,7 +217,8 @@ TEST(QueryOptions, SetEnumOptions) {
     MAKE_OPTIONDEF(key), {ENTRIES(enumtype, BOOST_PP_TUPLE_TO_SEQ(enums))}}
 
   TQueryOptions options;
-  TestEnumCase(options, CASE(prefetch_mode, TPrefetchMode, (NONE, HT_BUCKET)), true);
+  TestEnumCase(options,
+      CASE(prefetch_mode, TPrefetchMode, (NONE, HT_BUCKET, HT_BUCKET_PIPELINED)), true);
   TestEnumCase(options, CASE(default_join_distribution_mode, TJoinDistributionMode,
       (BROADCAST, SHUFFLE)), true);
   TestEnumCase(options, CASE(explain_level, TExplainLevel,
@@ -263,6 +265,17 @@ TEST(QueryOptions, SetIntOptions) {
       {MAKE_OPTIONDEF(max_cnf_exprs),                  {-1, I32_MAX}},
       {MAKE_OPTIONDEF(max_fs_writers),                 {0, I32_MAX}},
       {MAKE_OPTIONDEF(default_ndv_scale),              {1, 10}},
+      {MAKE_OPTIONDEF(parquet_late_materialization_threshold), {-1, I32_MAX}},
+      {MAKE_OPTIONDEF(parquet_decompress_ahead_pages), {0, 16}},
+      {MAKE_OPTIONDEF(io_scheduling_weight), {1, 100}},
+      {MAKE_OPTIONDEF(runtime_in_list_filter_entry_limit), {0, 100000}},
+      {MAKE_OPTIONDEF(max_num_filters_aggregated_per_host), {0, I32_MAX}},
+      {MAKE_OPTIONDEF(agg_spill_sort_level), {-1, I32_MAX}},
+      {MAKE_OPTIONDEF(sort_run_threads), {1, 64}},
+      {MAKE_OPTIONDEF(broadcast_relay_fanout), {0, I32_MAX}},
+      {MAKE_OPTIONDEF(exchange_skew_sample_interval), {0, I32_MAX}},
+      {MAKE_OPTIONDEF(result_conversion_threads), {1, 64}},
+      {MAKE_OPTIONDEF(cpu_profile_sampling_hz), {0, 1000}},
   };
   for (const auto& test_case : case_set) {
     const OptionDef<int32_t>& option_def = test_case.first;
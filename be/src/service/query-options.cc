@@ -1084,6 +1084,330 @@ Status impala::SetQueryOption(const string& key, const string& value,
         query_options->__set_kudu_replica_selection(enum_type);
         break;
       }
+      case TImpalaQueryOptions::PARQUET_LATE_MATERIALIZATION_THRESHOLD: {
+        StringParser::ParseResult result;
+        const int32_t threshold =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || threshold < -1) {
+          return Status(Substitute("Invalid parquet late materialization threshold: "
+              "'$0'. Only non-negative numbers and -1 are allowed.", value));
+        }
+        query_options->__set_parquet_late_materialization_threshold(threshold);
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_DECOMPRESS_AHEAD_PAGES: {
+        StringParser::ParseResult result;
+        const int32_t num_pages =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || num_pages < 0 || num_pages > 16) {
+          return Status(Substitute("Invalid number of Parquet decompress ahead pages: "
+              "'$0'. Only values from 0 to 16 are allowed.", value));
+        }
+        query_options->__set_parquet_decompress_ahead_pages(num_pages);
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_BLOOM_FILTERING: {
+        query_options->__set_parquet_bloom_filtering(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_PARALLEL_ENCODING: {
+        query_options->__set_parquet_parallel_encoding(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_DICTIONARY_CODE_FILTERING: {
+        query_options->__set_parquet_dictionary_code_filtering(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_FALLBACK_ENCODINGS: {
+        query_options->__set_parquet_fallback_encodings(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_EARLY_RUNTIME_FILTERING: {
+        query_options->__set_parquet_early_runtime_filtering(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ORC_READ_STATISTICS: {
+        query_options->__set_orc_read_statistics(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ORC_ASYNC_READ: {
+        query_options->__set_orc_async_read(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::TEXT_PARALLEL_DECOMPRESSION: {
+        query_options->__set_text_parallel_decompression(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::TEXT_BATCHED_CONVERSION: {
+        query_options->__set_text_batched_conversion(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::AVRO_PARALLEL_DECODING: {
+        query_options->__set_avro_parallel_decoding(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::KUDU_COLUMNAR_SCAN: {
+        query_options->__set_kudu_columnar_scan(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::PARQUET_COALESCE_GAP_SIZE: {
+        int64_t gap_size;
+        RETURN_IF_ERROR(ParseMemValue(value, "parquet coalesce gap size", &gap_size));
+        if (gap_size < 0) {
+          return Status(Substitute("Invalid parquet coalesce gap size: '$0'. Must be "
+              "greater than or equal to 0.", value));
+        }
+        query_options->__set_parquet_coalesce_gap_size(gap_size);
+        break;
+      }
+      case TImpalaQueryOptions::IO_SCHEDULING_WEIGHT: {
+        StringParser::ParseResult result;
+        const int32_t weight =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || weight < 1 || weight > 100) {
+          return Status(Substitute("Invalid I/O scheduling weight: '$0'. "
+              "Only integer values in [1, 100] are allowed.", value));
+        }
+        query_options->__set_io_scheduling_weight(weight);
+        break;
+      }
+      case TImpalaQueryOptions::RUNTIME_IN_LIST_FILTER_ENTRY_LIMIT: {
+        StringParser::ParseResult result;
+        const int32_t limit =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || limit < 0 || limit > 100000) {
+          return Status(Substitute("Invalid IN-list runtime filter entry limit: '$0'. "
+              "Only integer values in [0, 100000] are allowed.", value));
+        }
+        query_options->__set_runtime_in_list_filter_entry_limit(limit);
+        break;
+      }
+      case TImpalaQueryOptions::MAX_NUM_FILTERS_AGGREGATED_PER_HOST: {
+        StringParser::ParseResult result;
+        const int32_t num_filters =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || num_filters < 0) {
+          return Status(Substitute("Invalid max number of filters aggregated per host: "
+              "'$0'. Only non-negative integer values are allowed.", value));
+        }
+        query_options->__set_max_num_filters_aggregated_per_host(num_filters);
+        break;
+      }
+      case TImpalaQueryOptions::RUNTIME_BROADCAST_BYTES_LIMIT: {
+        int64_t runtime_broadcast_bytes_limit;
+        RETURN_IF_ERROR(ParseMemValue(value, "runtime broadcast bytes limit for joins",
+            &runtime_broadcast_bytes_limit));
+        query_options->__set_runtime_broadcast_bytes_limit(runtime_broadcast_bytes_limit);
+        break;
+      }
+      case TImpalaQueryOptions::PREAGG_FIRST_LEVEL_TABLE: {
+        query_options->__set_preagg_first_level_table(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::AGG_SPILL_SORT_LEVEL: {
+        StringParser::ParseResult result;
+        const int32_t level =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || level < -1) {
+          return Status(Substitute("Invalid aggregation spill sort level: '$0'. Only "
+              "non-negative numbers and -1 are allowed.", value));
+        }
+        query_options->__set_agg_spill_sort_level(level);
+        break;
+      }
+      case TImpalaQueryOptions::TOPN_RUNTIME_FILTER: {
+        query_options->__set_topn_runtime_filter(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::SORT_KEY_PREFIX: {
+        query_options->__set_sort_key_prefix(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::SORT_RUN_THREADS: {
+        StringParser::ParseResult result;
+        const int32_t num_threads =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || num_threads < 1
+            || num_threads > 64) {
+          return Status(Substitute("Invalid sort run threads: '$0'. Only integer values "
+              "in [1, 64] are allowed.", value));
+        }
+        query_options->__set_sort_run_threads(num_threads);
+        break;
+      }
+      case TImpalaQueryOptions::SORT_RADIX: {
+        query_options->__set_sort_radix(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::BATCH_CONJUNCT_EVALUATION: {
+        query_options->__set_batch_conjunct_evaluation(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::FUSE_LIKE_DISJUNCTS: {
+        query_options->__set_fuse_like_disjuncts(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ASYNC_CODEGEN_FAST_TIER: {
+        query_options->__set_async_codegen_fast_tier(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ADAPTIVE_CODEGEN: {
+        query_options->__set_adaptive_codegen(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ADAPTIVE_EXCHANGE_COMPRESSION: {
+        query_options->__set_adaptive_exchange_compression(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::SHARED_EXCHANGE_BUFFER: {
+        query_options->__set_shared_exchange_buffer(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::EXCHANGE_MAX_SPILLED_MEM: {
+        int64_t exchange_max_spilled_mem;
+        RETURN_IF_ERROR(ParseMemValue(value, "exchange max spilled memory",
+            &exchange_max_spilled_mem));
+        query_options->__set_exchange_max_spilled_mem(exchange_max_spilled_mem);
+        break;
+      }
+      case TImpalaQueryOptions::BROADCAST_RELAY_FANOUT: {
+        StringParser::ParseResult result;
+        const int32_t fanout =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || fanout < 0) {
+          return Status(Substitute("Invalid broadcast relay fanout: '$0'. "
+              "Only non-negative numbers are allowed.", value));
+        }
+        query_options->__set_broadcast_relay_fanout(fanout);
+        break;
+      }
+      case TImpalaQueryOptions::LOCAL_EXCHANGE_SHORTCUT: {
+        query_options->__set_local_exchange_shortcut(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::EXCHANGE_SKEW_SAMPLE_INTERVAL: {
+        StringParser::ParseResult result;
+        const int32_t interval =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || interval < 0) {
+          return Status(Substitute("Invalid exchange skew sample interval: '$0'. "
+              "Only non-negative numbers are allowed.", value));
+        }
+        query_options->__set_exchange_skew_sample_interval(interval);
+        break;
+      }
+      case TImpalaQueryOptions::EXCHANGE_COLUMNAR_BATCHES: {
+        query_options->__set_exchange_columnar_batches(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::SCHEDULER_LOAD_PENALTY_BYTES: {
+        int64_t penalty_bytes = 0;
+        RETURN_IF_ERROR(ParseMemValue(value, "scheduler load penalty", &penalty_bytes));
+        query_options->__set_scheduler_load_penalty_bytes(penalty_bytes);
+        break;
+      }
+      case TImpalaQueryOptions::STRAGGLER_RETRY_FACTOR: {
+        StringParser::ParseResult result;
+        const double val =
+            StringParser::StringToFloat<double>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || (val != 0 && val < 1)) {
+          return Status(Substitute("Invalid straggler retry factor: '$0'. "
+                                   "Only 0 or values of at least 1 are allowed.",
+              value));
+        }
+        query_options->__set_straggler_retry_factor(val);
+        break;
+      }
+      case TImpalaQueryOptions::USE_QUERY_RESULT_CACHE: {
+        query_options->__set_use_query_result_cache(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ENABLE_FRAGMENT_RESULT_CACHE: {
+        query_options->__set_enable_fragment_result_cache(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ARROW_RESULT_FORMAT: {
+        query_options->__set_arrow_result_format(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::SPOOL_QUERY_RESULTS_COMPRESSION: {
+        query_options->__set_spool_query_results_compression(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::USE_PLAN_CACHE: {
+        query_options->__set_use_plan_cache(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::RESULT_CONVERSION_THREADS: {
+        StringParser::ParseResult result;
+        const int32_t num_threads =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || num_threads < 1
+            || num_threads > 64) {
+          return Status(Substitute("Invalid result conversion threads: '$0'. Only "
+              "integer values in [1, 64] are allowed.", value));
+        }
+        query_options->__set_result_conversion_threads(num_threads);
+        break;
+      }
+      case TImpalaQueryOptions::START_LOCAL_FRAGMENTS_DIRECTLY: {
+        query_options->__set_start_local_fragments_directly(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::CPU_PROFILE_SAMPLING_HZ: {
+        StringParser::ParseResult result;
+        const int32_t hz =
+            StringParser::StringToInt<int32_t>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || hz < 0 || hz > 1000) {
+          return Status(Substitute("Invalid CPU profile sampling frequency: '$0'. Only "
+              "integer values in [0, 1000] are allowed.", value));
+        }
+        query_options->__set_cpu_profile_sampling_hz(hz);
+        break;
+      }
+      case TImpalaQueryOptions::BATCHED_SUBPLAN_UNNEST: {
+        query_options->__set_batched_subplan_unnest(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::DYNAMIC_SCANNER_THREADS: {
+        query_options->__set_dynamic_scanner_threads(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ACCESS_AWARE_TUPLE_LAYOUT: {
+        query_options->__set_access_aware_tuple_layout(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::REMOTE_EXECUTOR_MAX_LOAD_RATIO: {
+        StringParser::ParseResult result;
+        const double val =
+            StringParser::StringToFloat<double>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || (val != 0 && val < 1.0)
+            || val > 1000) {
+          return Status(Substitute("Invalid remote executor max load ratio '$0'. Only 0 "
+              "and values from 1.0 to 1000 are allowed.", value));
+        }
+        query_options->__set_remote_executor_max_load_ratio(val);
+        break;
+      }
+      case TImpalaQueryOptions::KUDU_SCAN_PREFETCH: {
+        query_options->__set_kudu_scan_prefetch(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::RUNTIME_FILTER_MAX_FPP: {
+        StringParser::ParseResult result;
+        const double val =
+            StringParser::StringToFloat<double>(value.c_str(), value.length(), &result);
+        if (result != StringParser::PARSE_SUCCESS || val < 0 || val > 1) {
+          return Status(Substitute("Invalid runtime filter max FPP: '$0'. Only values "
+              "from 0 to 1 are allowed.", value));
+        }
+        query_options->__set_runtime_filter_max_fpp(val);
+        break;
+      }
+      case TImpalaQueryOptions::TABLESAMPLE_WITHIN_FILES: {
+        query_options->__set_tablesample_within_files(IsTrue(value));
+        break;
+      }
       default:
         if (IsRemovedQueryOption(key)) {
           LOG(WARNING) << "Ignoring attempt to set removed query option '" << key << "'";
@@ -47,7 +47,7 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
 // time we add or remove a query option to/from the enum TImpalaQueryOptions.
 #define QUERY_OPTS_TABLE\
   DCHECK_EQ(_TImpalaQueryOptions_VALUES_TO_NAMES.size(),\
-      TImpalaQueryOptions::KUDU_REPLICA_SELECTION + 1);\
+      TImpalaQueryOptions::TABLESAMPLE_WITHIN_FILES + 1);\
   REMOVED_QUERY_OPT_FN(abort_on_default_limit_exceeded, ABORT_ON_DEFAULT_LIMIT_EXCEEDED)\
   QUERY_OPT_FN(abort_on_error, ABORT_ON_ERROR, TQueryOptionLevel::REGULAR)\
   REMOVED_QUERY_OPT_FN(allow_unsupported_formats, ALLOW_UNSUPPORTED_FORMATS)\
@@ -244,6 +244,96 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
       TQueryOptionLevel::ADVANCED)\
   QUERY_OPT_FN(default_ndv_scale, DEFAULT_NDV_SCALE, TQueryOptionLevel::ADVANCED)\
   QUERY_OPT_FN(kudu_replica_selection, KUDU_REPLICA_SELECTION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_late_materialization_threshold,\
+      PARQUET_LATE_MATERIALIZATION_THRESHOLD, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_decompress_ahead_pages, PARQUET_DECOMPRESS_AHEAD_PAGES,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_bloom_filtering, PARQUET_BLOOM_FILTERING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_parallel_encoding, PARQUET_PARALLEL_ENCODING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_dictionary_code_filtering, PARQUET_DICTIONARY_CODE_FILTERING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_fallback_encodings, PARQUET_FALLBACK_ENCODINGS,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_early_runtime_filtering, PARQUET_EARLY_RUNTIME_FILTERING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(orc_read_statistics, ORC_READ_STATISTICS, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(orc_async_read, ORC_ASYNC_READ, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(text_parallel_decompression, TEXT_PARALLEL_DECOMPRESSION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(text_batched_conversion, TEXT_BATCHED_CONVERSION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(avro_parallel_decoding, AVRO_PARALLEL_DECODING,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(kudu_columnar_scan, KUDU_COLUMNAR_SCAN, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(parquet_coalesce_gap_size, PARQUET_COALESCE_GAP_SIZE,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(io_scheduling_weight, IO_SCHEDULING_WEIGHT, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(runtime_in_list_filter_entry_limit, RUNTIME_IN_LIST_FILTER_ENTRY_LIMIT,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(max_num_filters_aggregated_per_host, MAX_NUM_FILTERS_AGGREGATED_PER_HOST,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(runtime_broadcast_bytes_limit, RUNTIME_BROADCAST_BYTES_LIMIT,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(preagg_first_level_table, PREAGG_FIRST_LEVEL_TABLE,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(agg_spill_sort_level, AGG_SPILL_SORT_LEVEL, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(topn_runtime_filter, TOPN_RUNTIME_FILTER, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(sort_key_prefix, SORT_KEY_PREFIX, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(sort_run_threads, SORT_RUN_THREADS, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(sort_radix, SORT_RADIX, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(batch_conjunct_evaluation, BATCH_CONJUNCT_EVALUATION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(fuse_like_disjuncts, FUSE_LIKE_DISJUNCTS, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(async_codegen_fast_tier, ASYNC_CODEGEN_FAST_TIER,\
+      TQueryOptionLevel::DEVELOPMENT)\
+  QUERY_OPT_FN(adaptive_codegen, ADAPTIVE_CODEGEN, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(adaptive_exchange_compression, ADAPTIVE_EXCHANGE_COMPRESSION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(shared_exchange_buffer, SHARED_EXCHANGE_BUFFER,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(exchange_max_spilled_mem, EXCHANGE_MAX_SPILLED_MEM,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(broadcast_relay_fanout, BROADCAST_RELAY_FANOUT,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(local_exchange_shortcut, LOCAL_EXCHANGE_SHORTCUT,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(exchange_skew_sample_interval, EXCHANGE_SKEW_SAMPLE_INTERVAL,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(exchange_columnar_batches, EXCHANGE_COLUMNAR_BATCHES,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(scheduler_load_penalty_bytes, SCHEDULER_LOAD_PENALTY_BYTES,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(straggler_retry_factor, STRAGGLER_RETRY_FACTOR,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(use_query_result_cache, USE_QUERY_RESULT_CACHE,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(enable_fragment_result_cache, ENABLE_FRAGMENT_RESULT_CACHE,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(arrow_result_format, ARROW_RESULT_FORMAT, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(spool_query_results_compression, SPOOL_QUERY_RESULTS_COMPRESSION,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(use_plan_cache, USE_PLAN_CACHE, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(result_conversion_threads, RESULT_CONVERSION_THREADS,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(start_local_fragments_directly, START_LOCAL_FRAGMENTS_DIRECTLY,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(cpu_profile_sampling_hz, CPU_PROFILE_SAMPLING_HZ,\
+      TQueryOptionLevel::DEVELOPMENT)\
+  QUERY_OPT_FN(batched_subplan_unnest, BATCHED_SUBPLAN_UNNEST,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(dynamic_scanner_threads, DYNAMIC_SCANNER_THREADS,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(access_aware_tuple_layout, ACCESS_AWARE_TUPLE_LAYOUT,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(remote_executor_max_load_ratio, REMOTE_EXECUTOR_MAX_LOAD_RATIO,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(kudu_scan_prefetch, KUDU_SCAN_PREFETCH, TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(runtime_filter_max_fpp, RUNTIME_FILTER_MAX_FPP,\
+      TQueryOptionLevel::ADVANCED)\
+  QUERY_OPT_FN(tablesample_within_files, TABLESAMPLE_WITHIN_FILES,\
       TQueryOptionLevel::ADVANCED)
 ;
 
@@ -0,0 +1,106 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <unistd.h>
+
+#include <gutil/strings/substitute.h>
+
+#include "service/query-profile-store.h"
+#include "testutil/gtest-util.h"
+#include "util/filesystem-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+class QueryProfileStoreTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    dir_ = Substitute("/tmp/query-profile-store-test-$0", getpid());
+    ASSERT_OK(FileSystemUtil::RemoveAndCreateDirectory(dir_));
+  }
+
+  virtual void TearDown() {
+    ASSERT_OK(FileSystemUtil::RemovePaths({dir_}));
+  }
+
+  static TUniqueId QueryId(int64_t lo) {
+    TUniqueId query_id;
+    query_id.__set_hi(0);
+    query_id.__set_lo(lo);
+    return query_id;
+  }
+
+  /// Returns the profile of 'query_id' in 'store', or an empty vector if it is not in the
+  /// store.
+  static vector<uint8_t> Read(QueryProfileStore* store, const TUniqueId& query_id) {
+    QueryProfileStore::Entry entry;
+    vector<uint8_t> profile;
+    if (!store->Lookup(query_id, &entry)) return profile;
+    EXPECT_OK(store->ReadProfile(entry, &profile));
+    return profile;
+  }
+
+  string dir_;
+};
+
+TEST_F(QueryProfileStoreTest, AddAndLookup) {
+  QueryProfileStore store(dir_, 1024 * 1024);
+  ASSERT_OK(store.Init());
+  EXPECT_TRUE(Read(&store, QueryId(1)).empty());
+
+  ASSERT_OK(store.Add(QueryId(1), "alice", true, {1, 2, 3}));
+  ASSERT_OK(store.Add(QueryId(2), "bob", false, {4, 5}));
+  EXPECT_EQ((vector<uint8_t>{1, 2, 3}), Read(&store, QueryId(1)));
+  EXPECT_EQ((vector<uint8_t>{4, 5}), Read(&store, QueryId(2)));
+  QueryProfileStore::Entry entry;
+  ASSERT_TRUE(store.Lookup(QueryId(2), &entry));
+  EXPECT_EQ("bob", entry.effective_user);
+  EXPECT_FALSE(entry.user_has_profile_access);
+
+  // A new profile replaces the existing one.
+  ASSERT_OK(store.Add(QueryId(1), "alice", true, {6}));
+  EXPECT_EQ(vector<uint8_t>{6}, Read(&store, QueryId(1)));
+}
+
+TEST_F(QueryProfileStoreTest, Eviction) {
+  // Every segment has room for two profiles of 100 bytes.
+  QueryProfileStore store(dir_, 8 * 200);
+  ASSERT_OK(store.Init());
+  for (int i = 0; i < 16; ++i) {
+    ASSERT_OK(store.Add(QueryId(i), "user", true, vector<uint8_t>(100, i)));
+  }
+  EXPECT_EQ(vector<uint8_t>(100, 0), Read(&store, QueryId(0)));
+
+  // Starting another segment deletes the oldest segment with its two profiles.
+  QueryProfileStore::Entry deleted_entry;
+  ASSERT_TRUE(store.Lookup(QueryId(1), &deleted_entry));
+  ASSERT_OK(store.Add(QueryId(16), "user", true, vector<uint8_t>(100, 16)));
+  ASSERT_OK(store.Add(QueryId(17), "user", true, vector<uint8_t>(100, 17)));
+  QueryProfileStore::Entry entry;
+  EXPECT_FALSE(store.Lookup(QueryId(0), &entry));
+  EXPECT_FALSE(store.Lookup(QueryId(1), &entry));
+  vector<uint8_t> profile;
+  EXPECT_FALSE(store.ReadProfile(deleted_entry, &profile).ok());
+  EXPECT_EQ(vector<uint8_t>(100, 2), Read(&store, QueryId(2)));
+  EXPECT_EQ(vector<uint8_t>(100, 17), Read(&store, QueryId(17)));
+
+  // Profiles that are larger than a segment are rejected.
+  EXPECT_FALSE(store.Add(QueryId(18), "user", true, vector<uint8_t>(201, 0)).ok());
+}
+
+}
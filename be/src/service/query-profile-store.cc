@@ -0,0 +1,134 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "service/query-profile-store.h"
+
+#include <cstdio>
+
+#include <gutil/strings/substitute.h>
+
+#include "util/debug-util.h"
+#include "util/filesystem-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Name of the subdirectory of the configured directory with the segment files.
+static const string STORE_SUBDIR = "impala-query-profiles";
+
+/// Number of segments that the capacity is split into. Deleting the oldest segment
+/// frees roughly this fraction of the capacity.
+static const int NUM_SEGMENTS = 8;
+
+QueryProfileStore::QueryProfileStore(const string& dir, int64_t capacity)
+  : dir_(Substitute("$0/$1", dir, STORE_SUBDIR)),
+    capacity_(capacity),
+    segment_capacity_(max<int64_t>(capacity / NUM_SEGMENTS, 1)) {
+  DCHECK_GT(capacity, 0);
+}
+
+QueryProfileStore::~QueryProfileStore() {
+  lock_guard<mutex> l(lock_);
+  current_file_.close();
+  while (!segments_.empty()) DeleteOldestSegment();
+}
+
+Status QueryProfileStore::Init() {
+  return FileSystemUtil::RemoveAndCreateDirectory(dir_);
+}
+
+string QueryProfileStore::SegmentPath(int64_t segment_id) const {
+  return Substitute("$0/segment-$1", dir_, segment_id);
+}
+
+Status QueryProfileStore::Add(const TUniqueId& query_id, const string& effective_user,
+    bool user_has_profile_access, const vector<uint8_t>& compressed_profile) {
+  const int64_t len = compressed_profile.size();
+  if (len > segment_capacity_) {
+    return Status(Substitute("Profile of query $0 is too large for the profile store: "
+        "$1 bytes", PrintId(query_id), len));
+  }
+  lock_guard<mutex> l(lock_);
+  if (segments_.empty() || !current_file_.is_open()
+      || segments_.back().bytes + len > segment_capacity_) {
+    current_file_.close();
+    const int64_t segment_id = next_segment_id_++;
+    current_file_.open(SegmentPath(segment_id), std::ios::binary | std::ios::trunc);
+    segments_.push_back(Segment{segment_id, 0, {}});
+    if (!current_file_.is_open()) {
+      return Status(Substitute("Could not create profile store file $0",
+          SegmentPath(segment_id)));
+    }
+  }
+  Segment* segment = &segments_.back();
+  current_file_.write(reinterpret_cast<const char*>(compressed_profile.data()), len);
+  current_file_.flush();
+  if (!current_file_) {
+    // Start a new segment with the next profile.
+    current_file_.close();
+    return Status(Substitute("Could not write profile store file $0",
+        SegmentPath(segment->id)));
+  }
+  entries_[query_id] = Entry{effective_user, user_has_profile_access, segment->id,
+      segment->bytes, len};
+  segment->query_ids.push_back(query_id);
+  segment->bytes += len;
+  total_bytes_ += len;
+  while (total_bytes_ > capacity_ && segments_.size() > 1) DeleteOldestSegment();
+  return Status::OK();
+}
+
+bool QueryProfileStore::Lookup(const TUniqueId& query_id, Entry* entry) {
+  lock_guard<mutex> l(lock_);
+  auto it = entries_.find(query_id);
+  if (it == entries_.end()) return false;
+  *entry = it->second;
+  return true;
+}
+
+Status QueryProfileStore::ReadProfile(
+    const Entry& entry, vector<uint8_t>* compressed_profile) {
+  const string path = SegmentPath(entry.segment_id);
+  std::ifstream file(path, std::ios::binary);
+  compressed_profile->resize(entry.len);
+  file.seekg(entry.offset);
+  file.read(reinterpret_cast<char*>(compressed_profile->data()), entry.len);
+  if (!file) {
+    return Status(Substitute("Could not read profile from profile store file $0. The "
+        "profile may have been removed from the store.", path));
+  }
+  return Status::OK();
+}
+
+void QueryProfileStore::DeleteOldestSegment() {
+  DCHECK(!segments_.empty());
+  const Segment& segment = segments_.front();
+  const string path = SegmentPath(segment.id);
+  if (remove(path.c_str()) != 0) {
+    LOG(WARNING) << "Could not delete profile store file " << path;
+  }
+  for (const TUniqueId& query_id : segment.query_ids) {
+    auto it = entries_.find(query_id);
+    // The profile may have been replaced by a profile in a later segment.
+    if (it != entries_.end() && it->second.segment_id == segment.id) entries_.erase(it);
+  }
+  total_bytes_ -= segment.bytes;
+  segments_.pop_front();
+}
+
+}
@@ -0,0 +1,123 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/status.h"
+#include "gen-cpp/Types_types.h"
+#include "util/unique-id-hash.h"
+
+namespace impala {
+
+/// Local, log-structured store of the compressed profiles of queries that were evicted
+/// from the in-memory query log, so that their profiles can still be fetched. Profiles
+/// are appended to segment files in a directory and only read when they are looked up.
+/// The store only keeps the location of every profile and the information needed to
+/// check access to it in memory. Once the files exceed the capacity, the oldest segment
+/// is deleted together with all its profiles. Profiles do not survive a restart: Init()
+/// removes the files of a previous process.
+///
+/// All functions are thread-safe.
+class QueryProfileStore {
+ public:
+  /// Location of a profile and the information needed to check access to it.
+  struct Entry {
+    /// The user that the query ran as, see QueryStateRecord::effective_user.
+    std::string effective_user;
+    bool user_has_profile_access;
+
+    /// Segment file and byte range of the profile.
+    int64_t segment_id;
+    int64_t offset;
+    int64_t len;
+  };
+
+  /// Stores the segment files in a subdirectory of 'dir'. 'capacity' is the maximum size
+  /// in bytes of all segment files.
+  QueryProfileStore(const std::string& dir, int64_t capacity);
+  ~QueryProfileStore();
+
+  /// Creates the directory of the store, removing the files of a previous process.
+  Status Init() WARN_UNUSED_RESULT;
+
+  /// Appends 'compressed_profile' of 'query_id' to the current segment, replacing an
+  /// existing profile of 'query_id'. Returns an error if the profile could not be
+  /// written or is larger than a segment.
+  Status Add(const TUniqueId& query_id, const std::string& effective_user,
+      bool user_has_profile_access, const std::vector<uint8_t>& compressed_profile)
+      WARN_UNUSED_RESULT;
+
+  /// Returns the entry of 'query_id' in 'entry', or false if the store does not have a
+  /// profile of 'query_id'.
+  bool Lookup(const TUniqueId& query_id, Entry* entry);
+
+  /// Reads the profile of 'entry', which was returned by Lookup(). Returns an error if
+  /// the segment of the profile was deleted in the meantime.
+  Status ReadProfile(const Entry& entry, std::vector<uint8_t>* compressed_profile)
+      WARN_UNUSED_RESULT;
+
+ private:
+  struct Segment {
+    int64_t id;
+
+    /// Size of the segment file.
+    int64_t bytes;
+
+    /// The queries with profiles in the segment.
+    std::vector<TUniqueId> query_ids;
+  };
+
+  std::string SegmentPath(int64_t segment_id) const;
+
+  /// Deletes the oldest segment and the entries of its profiles. 'lock_' must be held.
+  void DeleteOldestSegment();
+
+  /// Directory of the segment files.
+  const std::string dir_;
+  const int64_t capacity_;
+
+  /// A new segment is started once the current segment reaches this size.
+  const int64_t segment_capacity_;
+
+  /// Protects all members below.
+  std::mutex lock_;
+
+  /// All profiles in the store.
+  std::unordered_map<TUniqueId, Entry> entries_;
+
+  /// All segments, the oldest first. The last segment is the current one.
+  std::deque<Segment> segments_;
+
+  /// The file of the current segment.
+  std::ofstream current_file_;
+
+  /// Size of all segment files.
+  int64_t total_bytes_ = 0;
+
+  /// Id of the next segment.
+  int64_t next_segment_id_ = 0;
+};
+
+}
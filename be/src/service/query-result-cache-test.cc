@@ -0,0 +1,85 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <memory>
+#include <string>
+
+#include "runtime/mem-tracker.h"
+#include "service/query-result-cache.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Returns an entry with a single string column and 'num_rows' rows of 'value'.
+static unique_ptr<QueryResultCache::Entry> MakeEntry(int num_rows, const string& value) {
+  unique_ptr<QueryResultCache::Entry> entry(new QueryResultCache::Entry());
+  entry->metadata.columns.emplace_back();
+  entry->rows.reset(QueryResultSet::CreateAsciiQueryResultSet(entry->metadata, nullptr));
+  TResultRow row;
+  row.colVals.emplace_back();
+  row.colVals.back().__set_string_val(value);
+  for (int i = 0; i < num_rows; ++i) EXPECT_OK(entry->rows->AddOneRow(row));
+  return entry;
+}
+
+TEST(QueryResultCacheTest, LookupAndInvalidate) {
+  MemTracker parent;
+  QueryResultCache cache(1024 * 1024, 1024 * 1024, &parent);
+  EXPECT_EQ(nullptr, cache.Lookup("q1"));
+  EXPECT_TRUE(cache.Insert("q1", cache.generation(), MakeEntry(10, "a")));
+  shared_ptr<const QueryResultCache::Entry> entry = cache.Lookup("q1");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(10ul, entry->rows->size());
+  EXPECT_EQ(entry->charge, parent.consumption());
+
+  // Results of queries planned before an invalidation are not added.
+  int64_t generation = cache.generation();
+  cache.Invalidate();
+  EXPECT_EQ(nullptr, cache.Lookup("q1"));
+  EXPECT_EQ(0, parent.consumption());
+  EXPECT_FALSE(cache.Insert("q1", generation, MakeEntry(10, "a")));
+  EXPECT_EQ(nullptr, cache.Lookup("q1"));
+
+  // Entries that were looked up before being removed remain valid.
+  EXPECT_EQ(10ul, entry->rows->size());
+}
+
+TEST(QueryResultCacheTest, Eviction) {
+  MemTracker parent;
+  unique_ptr<QueryResultCache::Entry> entry = MakeEntry(100, string(100, 'x'));
+  const int64_t entry_bytes = entry->rows->ByteSize();
+  // Room for two entries, but not three.
+  QueryResultCache cache(entry_bytes * 5 / 2, entry_bytes * 2, &parent);
+  EXPECT_TRUE(cache.Insert("q1", cache.generation(), move(entry)));
+  EXPECT_TRUE(cache.Insert("q2", cache.generation(), MakeEntry(100, string(100, 'x'))));
+  // Use "q1", so that "q2" is the least recently used entry.
+  EXPECT_NE(nullptr, cache.Lookup("q1"));
+  EXPECT_TRUE(cache.Insert("q3", cache.generation(), MakeEntry(100, string(100, 'x'))));
+  EXPECT_NE(nullptr, cache.Lookup("q1"));
+  EXPECT_EQ(nullptr, cache.Lookup("q2"));
+  EXPECT_NE(nullptr, cache.Lookup("q3"));
+  EXPECT_LE(parent.consumption(), entry_bytes * 5 / 2);
+
+  // Entries that are larger than the maximum entry size are not cached.
+  EXPECT_FALSE(cache.Insert("q4", cache.generation(), MakeEntry(300, string(100, 'x'))));
+  EXPECT_EQ(nullptr, cache.Lookup("q4"));
+  EXPECT_NE(nullptr, cache.Lookup("q3"));
+}
+
+} // namespace impala
@@ -0,0 +1,120 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "service/query-result-cache.h"
+
+#include "runtime/mem-tracker.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+QueryResultCache::QueryResultCache(int64_t capacity, int64_t max_entry_bytes,
+    MemTracker* parent_mem_tracker)
+  : capacity_(capacity),
+    max_entry_bytes_(min(max_entry_bytes, capacity)),
+    mem_tracker_(new MemTracker(-1, "Query Result Cache", parent_mem_tracker)) {
+  DCHECK_GT(capacity, 0);
+}
+
+QueryResultCache::~QueryResultCache() {
+  {
+    lock_guard<mutex> l(lock_);
+    while (!entries_.empty()) Erase(entries_.begin());
+  }
+  mem_tracker_->Close();
+}
+
+void QueryResultCache::InitMetrics(MetricGroup* metrics) {
+  MetricGroup* cache_metrics = metrics->GetOrCreateChildGroup("query-result-cache");
+  hits_ = cache_metrics->AddCounter("query-result-cache.hit-count", 0);
+  misses_ = cache_metrics->AddCounter("query-result-cache.miss-count", 0);
+  evictions_ = cache_metrics->AddCounter("query-result-cache.eviction-count", 0);
+  invalidations_ = cache_metrics->AddCounter("query-result-cache.invalidation-count", 0);
+  total_bytes_ = cache_metrics->AddGauge("query-result-cache.total-bytes", 0);
+  num_entries_ = cache_metrics->AddGauge("query-result-cache.num-entries", 0);
+}
+
+shared_ptr<const QueryResultCache::Entry> QueryResultCache::Lookup(const string& key) {
+  lock_guard<mutex> l(lock_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    if (misses_ != nullptr) misses_->Increment(1);
+    return nullptr;
+  }
+  lru_list_.splice(lru_list_.end(), lru_list_, it->second.lru_it);
+  if (hits_ != nullptr) hits_->Increment(1);
+  return it->second.entry;
+}
+
+bool QueryResultCache::Insert(
+    const string& key, int64_t generation, unique_ptr<Entry> entry) {
+  DCHECK(entry != nullptr);
+  DCHECK(entry->rows != nullptr);
+  // The key is stored twice, in 'entries_' and 'lru_list_'.
+  entry->charge = entry->rows->ByteSize() + 2 * key.size() + sizeof(Entry);
+  if (entry->charge > max_entry_bytes_) return false;
+  lock_guard<mutex> l(lock_);
+  if (generation != generation_) return false;
+  auto existing = entries_.find(key);
+  if (existing != entries_.end()) Erase(existing);
+  while (total_charge_ + entry->charge > capacity_) {
+    DCHECK(!lru_list_.empty());
+    Erase(entries_.find(lru_list_.front()));
+    if (evictions_ != nullptr) evictions_->Increment(1);
+  }
+  const int64_t charge = entry->charge;
+  lru_list_.push_back(key);
+  entries_.emplace(key, CacheValue{move(entry), std::prev(lru_list_.end())});
+  total_charge_ += charge;
+  mem_tracker_->Consume(charge);
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(charge);
+    num_entries_->Increment(1);
+  }
+  return true;
+}
+
+void QueryResultCache::Invalidate() {
+  lock_guard<mutex> l(lock_);
+  ++generation_;
+  if (invalidations_ != nullptr) invalidations_->Increment(1);
+  while (!entries_.empty()) Erase(entries_.begin());
+}
+
+int64_t QueryResultCache::generation() {
+  lock_guard<mutex> l(lock_);
+  return generation_;
+}
+
+void QueryResultCache::Erase(std::unordered_map<string, CacheValue>::iterator it) {
+  DCHECK(it != entries_.end());
+  // Queries that are serving the entry keep it alive, but its memory is not charged to
+  // the cache anymore.
+  const int64_t charge = it->second.entry->charge;
+  lru_list_.erase(it->second.lru_it);
+  entries_.erase(it);
+  total_charge_ -= charge;
+  mem_tracker_->Release(charge);
+  if (total_bytes_ != nullptr) {
+    total_bytes_->Increment(-charge);
+    num_entries_->Increment(-1);
+  }
+}
+
+}
@@ -0,0 +1,138 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "common/status.h"
+#include "service/query-result-set.h"
+#include "util/metrics-fwd.h"
+
+#include "gen-cpp/Results_types.h"
+
+namespace impala {
+
+class MemTracker;
+class MetricGroup;
+
+/// Coordinator-wide cache of the complete result sets of SELECT statements, so that a
+/// repeated identical query can be answered without admission or execution. Queries opt
+/// in with the USE_QUERY_RESULT_CACHE query option. The caller computes the key, which
+/// must cover everything the results depend on apart from the catalog (statement,
+/// session database, user, query options and client result format). Results are
+/// stored in the client's result set format and copied to the fetched rows on a hit.
+///
+/// The cache does not track which tables a query read. Instead, every change of the
+/// catalog invalidates all entries by calling Invalidate(). To avoid caching results
+/// computed from a catalog that was invalidated while the query ran, Insert() takes the
+/// generation() read before the query was planned and drops the entry if the cache was
+/// invalidated since.
+///
+/// The cache is bounded by the capacity given to the constructor and evicts in LRU
+/// order. The memory of the entries is tracked by the cache's own MemTracker, a child of
+/// the process MemTracker.
+///
+/// All functions are thread-safe.
+class QueryResultCache {
+ public:
+  /// A cached result set. Immutable once inserted.
+  struct Entry {
+    /// Metadata of 'rows'. Referenced by 'rows', so it must outlive it.
+    TResultSetMetadata metadata;
+
+    /// All rows of the query, in the client result format they were fetched in.
+    std::unique_ptr<QueryResultSet> rows;
+
+    /// Memory charged to the entry.
+    int64_t charge = 0;
+  };
+
+  /// 'capacity' is the maximum memory in bytes used by the entries. Result sets larger
+  /// than 'max_entry_bytes' are not cached.
+  QueryResultCache(int64_t capacity, int64_t max_entry_bytes,
+      MemTracker* parent_mem_tracker);
+  ~QueryResultCache();
+
+  /// Registers the metrics of the cache in 'metrics'.
+  void InitMetrics(MetricGroup* metrics);
+
+  /// Returns the entry for 'key' or nullptr on a miss. The returned entry remains valid
+  /// after it was evicted.
+  std::shared_ptr<const Entry> Lookup(const std::string& key);
+
+  /// Adds 'entry' under 'key', replacing any existing entry, unless the cache was
+  /// invalidated since 'generation' was returned by generation() or the entry is too
+  /// large. Returns true if the entry was added.
+  bool Insert(const std::string& key, int64_t generation, std::unique_ptr<Entry> entry);
+
+  /// Removes all entries and makes pending insertions fail.
+  void Invalidate();
+
+  /// Returns the current generation of the cache, which changes with every
+  /// Invalidate().
+  int64_t generation();
+
+  int64_t max_entry_bytes() const { return max_entry_bytes_; }
+
+ private:
+  typedef std::list<std::string> LruList;
+
+  struct CacheValue {
+    std::shared_ptr<const Entry> entry;
+
+    /// Position of the key in 'lru_list_'.
+    LruList::iterator lru_it;
+  };
+
+  /// Removes the entry pointed to by 'it' and releases its memory. 'lock_' must be held.
+  void Erase(std::unordered_map<std::string, CacheValue>::iterator it);
+
+  const int64_t capacity_;
+  const int64_t max_entry_bytes_;
+  std::unique_ptr<MemTracker> mem_tracker_;
+
+  /// Protects all members below.
+  std::mutex lock_;
+
+  /// All entries, keyed by the caller's key.
+  std::unordered_map<std::string, CacheValue> entries_;
+
+  /// Keys of all entries, with the least recently used at the front.
+  LruList lru_list_;
+
+  /// Memory charged to all entries.
+  int64_t total_charge_ = 0;
+
+  /// Incremented by Invalidate().
+  int64_t generation_ = 0;
+
+  /// Metrics of the cache, registered in InitMetrics().
+  IntCounter* hits_ = nullptr;
+  IntCounter* misses_ = nullptr;
+  IntCounter* evictions_ = nullptr;
+  IntCounter* invalidations_ = nullptr;
+  IntGauge* total_bytes_ = nullptr;
+  IntGauge* num_entries_ = nullptr;
+};
+
+}
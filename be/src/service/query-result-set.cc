@@ -19,14 +19,21 @@
 
 #include <sstream>
 #include <boost/scoped_ptr.hpp>
+#include <gutil/strings/substitute.h>
 
 #include "exprs/scalar-expr-evaluator.h"
 #include "rpc/thrift-util.h"
+#include "runtime/date-value.h"
+#include "runtime/exec-env.h"
 #include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
+#include "runtime/timestamp-value.inline.h"
 #include "runtime/types.h"
 #include "service/hs2-util.h"
+#include "util/arrow-ipc.h"
 #include "util/bit-util.h"
+#include "util/promise.h"
+#include "util/thread-pool.h"
 
 #include "common/names.h"
 
@@ -40,6 +47,10 @@ namespace {
 
 /// Ascii output precision for double/float
 constexpr int ASCII_PRECISION = 16;
+
+/// Minimum number of rows added at once for HS2ColumnarResultSet to convert the columns
+/// in parallel.
+constexpr int MIN_PARALLEL_CONVERSION_ROWS = 1024;
 }
 
 namespace impala {
@@ -50,7 +61,12 @@ class AsciiQueryResultSet : public QueryResultSet {
  public:
   /// Rows are added into 'rowset'.
   AsciiQueryResultSet(const TResultSetMetadata& metadata, vector<string>* rowset)
-    : metadata_(metadata), result_set_(rowset) {}
+    : metadata_(metadata), result_set_(rowset) {
+    if (rowset == nullptr) {
+      owned_result_set_.reset(new vector<string>());
+      result_set_ = owned_result_set_.get();
+    }
+  }
 
   virtual ~AsciiQueryResultSet() {}
 
@@ -68,24 +84,38 @@ class AsciiQueryResultSet : public QueryResultSet {
   virtual int64_t ByteSize(int start_idx, int num_rows) override;
   virtual size_t size() override { return result_set_->size(); }
 
+  virtual QueryResultSet* CreateEmpty(const TResultSetMetadata& metadata) const override {
+    return new AsciiQueryResultSet(metadata, nullptr);
+  }
+
  private:
   /// Metadata of the result set
   const TResultSetMetadata& metadata_;
 
-  /// Points to the result set to be filled. Not owned by this object.
+  /// Points to the result set to be filled. The result set this points to may be owned
+  /// by this object, in which case owned_result_set_ is set.
   vector<string>* result_set_;
+
+  /// Set to result_set_ if result_set_ is owned.
+  unique_ptr<vector<string>> owned_result_set_;
 };
 
 /// Result set container for Hive protocol versions >= V6, where results are returned in
 /// column-orientation.
 class HS2ColumnarResultSet : public QueryResultSet {
  public:
-  HS2ColumnarResultSet(const TResultSetMetadata& metadata, TRowSet* rowset);
+  /// AddRows() converts the columns with up to 'num_conversion_threads' threads.
+  HS2ColumnarResultSet(const TResultSetMetadata& metadata, TRowSet* rowset,
+      int num_conversion_threads = 1);
 
   virtual ~HS2ColumnarResultSet() {}
 
   /// Evaluate 'expr_evals' over rows in 'batch' and convert to the HS2 columnar
-  /// representation.
+  /// representation. Groups of columns are converted in parallel on the result
+  /// conversion pool if this result set has more than one conversion thread, at least
+  /// MIN_PARALLEL_CONVERSION_ROWS rows are added and all 'expr_evals' are column
+  /// references or constants. Evaluating other expressions may allocate from memory
+  /// pools that the evaluators share, so they are always evaluated by this thread.
   virtual Status AddRows(const vector<ScalarExprEvaluator*>& expr_evals, RowBatch* batch,
       int start_idx, int num_rows) override;
 
@@ -99,6 +129,10 @@ class HS2ColumnarResultSet : public QueryResultSet {
   virtual int64_t ByteSize(int start_idx, int num_rows) override;
   virtual size_t size() override { return num_rows_; }
 
+  virtual QueryResultSet* CreateEmpty(const TResultSetMetadata& metadata) const override {
+    return new HS2ColumnarResultSet(metadata, nullptr);
+  }
+
  private:
   /// Metadata of the result set
   const TResultSetMetadata& metadata_;
@@ -113,7 +147,19 @@ class HS2ColumnarResultSet : public QueryResultSet {
 
   int64_t num_rows_;
 
+  /// Maximum number of threads that convert the columns in AddRows().
+  const int num_conversion_threads_;
+
   void InitColumns();
+
+  /// Returns the number of groups of columns that AddRows() converts in parallel, or 1
+  /// if it converts all columns on the calling thread.
+  int NumConversionGroups(
+      const vector<ScalarExprEvaluator*>& expr_evals, int num_rows) const;
+
+  /// Converts the columns in the range ['first_col', 'end_col') of the rows in 'batch'.
+  void AddColumns(const vector<ScalarExprEvaluator*>& expr_evals, RowBatch* batch,
+      int start_idx, int num_rows, int first_col, int end_col);
 };
 
 /// Row oriented result set for HiveServer2, used to serve HS2 requests with protocol
@@ -137,6 +183,10 @@ class HS2RowOrientedResultSet : public QueryResultSet {
   virtual int64_t ByteSize(int start_idx, int num_rows) override;
   virtual size_t size() override { return result_set_->rows.size(); }
 
+  virtual QueryResultSet* CreateEmpty(const TResultSetMetadata& metadata) const override {
+    return new HS2RowOrientedResultSet(metadata, nullptr);
+  }
+
  private:
   /// Metadata of the result set
   const TResultSetMetadata& metadata_;
@@ -150,18 +200,103 @@ class HS2RowOrientedResultSet : public QueryResultSet {
   scoped_ptr<TRowSet> owned_result_set_;
 };
 
+/// Result set for HiveServer2 clients that requested results in the Arrow IPC stream
+/// format with ARROW_RESULT_FORMAT. The rows of a fetch are buffered in Arrow columns
+/// and FinalizeRowSet() returns them as a single Arrow IPC stream, consisting of the
+/// schema and one record batch, stored as the only value of the only column of the
+/// TRowSet. Clients read it with any Arrow IPC stream reader instead of converting the
+/// HS2 columns value by value. Only scalar types are supported: CHAR, VARCHAR and
+/// STRING map to LargeUtf8, DECIMAL to Decimal128, DATE to Date32 and TIMESTAMP to a
+/// microsecond timestamp without time zone.
+class ArrowResultSet : public QueryResultSet {
+ public:
+  /// Rows are added into 'rowset'. 'arrow_types' contains the Arrow type of each column
+  /// of 'metadata'.
+  ArrowResultSet(const TResultSetMetadata& metadata,
+      const vector<ArrowColumn::Type>& arrow_types, TRowSet* rowset);
+
+  virtual ~ArrowResultSet() {}
+
+  virtual Status AddRows(const vector<ScalarExprEvaluator*>& expr_evals, RowBatch* batch,
+      int start_idx, int num_rows) override;
+  virtual Status AddOneRow(const TResultRow& row) override;
+  virtual int AddRows(const QueryResultSet* other, int start_idx, int num_rows) override;
+  virtual int64_t ByteSize(int start_idx, int num_rows) override;
+  virtual size_t size() override { return columns_.empty() ? 0 : columns_[0].num_rows(); }
+  virtual Status FinalizeRowSet() override;
+
+  virtual QueryResultSet* CreateEmpty(const TResultSetMetadata& metadata) const override {
+    return new ArrowResultSet(metadata, arrow_types_, nullptr);
+  }
+
+ private:
+  /// Appends the value of 'expr_eval' for all rows in the range to 'column'.
+  static void AddExprValues(ScalarExprEvaluator* expr_eval, const ColumnType& type,
+      RowBatch* batch, int start_idx, int num_rows, ArrowColumn* column);
+
+  /// Metadata of the result set
+  const TResultSetMetadata& metadata_;
+
+  /// The Arrow type of each column.
+  const vector<ArrowColumn::Type> arrow_types_;
+
+  /// The type of each column.
+  vector<ColumnType> types_;
+
+  /// The rows that were added, one entry per column.
+  vector<ArrowColumn> columns_;
+
+  /// Points to the TRowSet to be filled. The row set this points to may be owned by
+  /// this object, in which case owned_result_set_ is set.
+  TRowSet* result_set_;
+
+  /// Set to result_set_ if result_set_ is owned.
+  scoped_ptr<TRowSet> owned_result_set_;
+};
+
 QueryResultSet* QueryResultSet::CreateAsciiQueryResultSet(
     const TResultSetMetadata& metadata, vector<string>* rowset) {
   return new AsciiQueryResultSet(metadata, rowset);
 }
 
-QueryResultSet* QueryResultSet::CreateHS2ResultSet(
-    TProtocolVersion::type version, const TResultSetMetadata& metadata, TRowSet* rowset) {
+QueryResultSet* QueryResultSet::CreateHS2ResultSet(TProtocolVersion::type version,
+    const TResultSetMetadata& metadata, TRowSet* rowset, int num_conversion_threads) {
   if (version < TProtocolVersion::HIVE_CLI_SERVICE_PROTOCOL_V6) {
     return new HS2RowOrientedResultSet(metadata, rowset);
   } else {
-    return new HS2ColumnarResultSet(metadata, rowset);
+    return new HS2ColumnarResultSet(metadata, rowset, num_conversion_threads);
+  }
+}
+
+Status QueryResultSet::CreateArrowResultSet(const TResultSetMetadata& metadata,
+    TRowSet* rowset, QueryResultSet** result_set) {
+  vector<ArrowColumn::Type> arrow_types;
+  for (const TColumn& column : metadata.columns) {
+    const ColumnType type = ColumnType::FromThrift(column.columnType);
+    switch (type.type) {
+      case TYPE_NULL:
+      case TYPE_BOOLEAN: arrow_types.push_back(ArrowColumn::BOOL); break;
+      case TYPE_TINYINT: arrow_types.push_back(ArrowColumn::INT8); break;
+      case TYPE_SMALLINT: arrow_types.push_back(ArrowColumn::INT16); break;
+      case TYPE_INT: arrow_types.push_back(ArrowColumn::INT32); break;
+      case TYPE_BIGINT: arrow_types.push_back(ArrowColumn::INT64); break;
+      case TYPE_FLOAT: arrow_types.push_back(ArrowColumn::FLOAT); break;
+      case TYPE_DOUBLE: arrow_types.push_back(ArrowColumn::DOUBLE); break;
+      case TYPE_DECIMAL: arrow_types.push_back(ArrowColumn::DECIMAL128); break;
+      case TYPE_DATE: arrow_types.push_back(ArrowColumn::DATE32); break;
+      case TYPE_TIMESTAMP: arrow_types.push_back(ArrowColumn::TIMESTAMP_MICROS); break;
+      case TYPE_STRING:
+      case TYPE_VARCHAR:
+      case TYPE_CHAR:
+        arrow_types.push_back(ArrowColumn::UTF8);
+        break;
+      default:
+        return Status(Substitute("Column '$0' of type $1 is not supported with "
+            "ARROW_RESULT_FORMAT", column.columnName, type.DebugString()));
+    }
   }
+  *result_set = new ArrowResultSet(metadata, arrow_types, rowset);
+  return Status::OK();
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -226,7 +361,7 @@ int64_t AsciiQueryResultSet::ByteSize(int start_idx, int num_rows) {
   int64_t bytes = 0;
   const int end = min(static_cast<size_t>(num_rows), result_set_->size() - start_idx);
   for (int i = start_idx; i < start_idx + end; ++i) {
-    bytes += sizeof(result_set_[i]) + result_set_[i].size();
+    bytes += sizeof((*result_set_)[i]) + (*result_set_)[i].size();
   }
   return bytes;
 }
@@ -276,8 +411,11 @@ uint32_t TColumnByteSize(const ThriftTColumn& col, uint32_t start_idx, uint32_t
 // Result set container for Hive protocol versions >= V6, where results are returned in
 // column-orientation.
 HS2ColumnarResultSet::HS2ColumnarResultSet(
-    const TResultSetMetadata& metadata, TRowSet* rowset)
-  : metadata_(metadata), result_set_(rowset), num_rows_(0) {
+    const TResultSetMetadata& metadata, TRowSet* rowset, int num_conversion_threads)
+  : metadata_(metadata),
+    result_set_(rowset),
+    num_rows_(0),
+    num_conversion_threads_(num_conversion_threads) {
   if (rowset == NULL) {
     owned_result_set_.reset(new TRowSet());
     result_set_ = owned_result_set_.get();
@@ -290,14 +428,53 @@ Status HS2ColumnarResultSet::AddRows(const vector<ScalarExprEvaluator*>& expr_ev
   DCHECK_GE(batch->num_rows(), start_idx + num_rows);
   int num_col = expr_evals.size();
   DCHECK_EQ(num_col, metadata_.columns.size());
-  for (int i = 0; i < num_col; ++i) {
+  const int num_groups = NumConversionGroups(expr_evals, num_rows);
+  if (num_groups == 1) {
+    AddColumns(expr_evals, batch, start_idx, num_rows, 0, num_col);
+  } else {
+    // Convert all groups but the first on the pool, and the first on this thread. The
+    // groups write to disjoint columns.
+    CallableThreadPool* pool = ExecEnv::GetInstance()->result_conversion_pool();
+    vector<unique_ptr<Promise<bool>>> groups_done;
+    for (int i = 1; i < num_groups; ++i) {
+      const int first_col = i * num_col / num_groups;
+      const int end_col = (i + 1) * num_col / num_groups;
+      Promise<bool>* group_done = new Promise<bool>();
+      groups_done.emplace_back(group_done);
+      boost::function<void()> fn = [=, &expr_evals]() {
+        AddColumns(expr_evals, batch, start_idx, num_rows, first_col, end_col);
+        group_done->Set(true);
+      };
+      if (!pool->Offer(fn)) fn();
+    }
+    AddColumns(expr_evals, batch, start_idx, num_rows, 0, num_col / num_groups);
+    for (const unique_ptr<Promise<bool>>& group_done : groups_done) group_done->Get();
+  }
+  num_rows_ += num_rows;
+  return Status::OK();
+}
+
+int HS2ColumnarResultSet::NumConversionGroups(
+    const vector<ScalarExprEvaluator*>& expr_evals, int num_rows) const {
+  if (num_conversion_threads_ <= 1 || num_rows < MIN_PARALLEL_CONVERSION_ROWS
+      || expr_evals.size() < 2) {
+    return 1;
+  }
+  if (ExecEnv::GetInstance()->result_conversion_pool() == nullptr) return 1;
+  for (const ScalarExprEvaluator* expr_eval : expr_evals) {
+    if (!expr_eval->root().IsSlotRef() && !expr_eval->root().IsLiteral()) return 1;
+  }
+  return min<int>(num_conversion_threads_, expr_evals.size());
+}
+
+void HS2ColumnarResultSet::AddColumns(const vector<ScalarExprEvaluator*>& expr_evals,
+    RowBatch* batch, int start_idx, int num_rows, int first_col, int end_col) {
+  for (int i = first_col; i < end_col; ++i) {
     const TColumnType& type = metadata_.columns[i].columnType;
     ScalarExprEvaluator* expr_eval = expr_evals[i];
     ExprValuesToHS2TColumn(expr_eval, type, batch, start_idx, num_rows, num_rows_,
         &(result_set_->columns[i]));
   }
-  num_rows_ += num_rows;
-  return Status::OK();
 }
 
 // Add a row from a TResultRow
@@ -506,4 +683,193 @@ int64_t HS2RowOrientedResultSet::ByteSize(int start_idx, int num_rows) {
   }
   return bytes;
 }
+//////////////////////////////////////////////////////////////////////////////////////////
+
+ArrowResultSet::ArrowResultSet(const TResultSetMetadata& metadata,
+    const vector<ArrowColumn::Type>& arrow_types, TRowSet* rowset)
+  : metadata_(metadata), arrow_types_(arrow_types), result_set_(rowset) {
+  if (rowset == nullptr) {
+    owned_result_set_.reset(new TRowSet());
+    result_set_ = owned_result_set_.get();
+  }
+  DCHECK_EQ(arrow_types_.size(), metadata_.columns.size());
+  for (int i = 0; i < metadata_.columns.size(); ++i) {
+    const TColumn& column = metadata_.columns[i];
+    types_.push_back(ColumnType::FromThrift(column.columnType));
+    columns_.emplace_back(column.columnName, arrow_types_[i], types_.back().precision,
+        types_.back().scale);
+  }
+}
+
+void ArrowResultSet::AddExprValues(ScalarExprEvaluator* expr_eval,
+    const ColumnType& type, RowBatch* batch, int start_idx, int num_rows,
+    ArrowColumn* column) {
+  // Branch on the type once per batch rather than once per value.
+  switch (type.type) {
+    case TYPE_NULL:
+    case TYPE_BOOLEAN:
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) {
+        BooleanVal val = expr_eval->GetBooleanVal(it.Get());
+        if (val.is_null) {
+          column->AppendNull();
+        } else {
+          column->AppendBool(val.val);
+        }
+      }
+      return;
+#define ADD_FIXED_VALUES(IMPALA_TYPE, GET_FN, CPP_TYPE) \
+    case IMPALA_TYPE: \
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) { \
+        auto val = expr_eval->GET_FN(it.Get()); \
+        if (val.is_null) { \
+          column->AppendNull(); \
+        } else { \
+          column->AppendFixed<CPP_TYPE>(val.val); \
+        } \
+      } \
+      return;
+    ADD_FIXED_VALUES(TYPE_TINYINT, GetTinyIntVal, int8_t)
+    ADD_FIXED_VALUES(TYPE_SMALLINT, GetSmallIntVal, int16_t)
+    ADD_FIXED_VALUES(TYPE_INT, GetIntVal, int32_t)
+    ADD_FIXED_VALUES(TYPE_BIGINT, GetBigIntVal, int64_t)
+    ADD_FIXED_VALUES(TYPE_FLOAT, GetFloatVal, float)
+    ADD_FIXED_VALUES(TYPE_DOUBLE, GetDoubleVal, double)
+#undef ADD_FIXED_VALUES
+    case TYPE_DECIMAL: {
+      // Arrow decimals are always 128 bits wide, sign-extend the narrower ones.
+      const int byte_size = type.GetByteSize();
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) {
+        DecimalVal val = expr_eval->GetDecimalVal(it.Get());
+        if (val.is_null) {
+          column->AppendNull();
+        } else if (byte_size == 4) {
+          column->AppendFixed<__int128>(val.val4);
+        } else if (byte_size == 8) {
+          column->AppendFixed<__int128>(val.val8);
+        } else {
+          column->AppendFixed<__int128>(val.val16);
+        }
+      }
+      return;
+    }
+    case TYPE_DATE:
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) {
+        DateVal val = expr_eval->GetDateVal(it.Get());
+        int32_t days;
+        if (val.is_null || !DateValue::FromDateVal(val).ToDaysSinceEpoch(&days)) {
+          column->AppendNull();
+        } else {
+          column->AppendFixed<int32_t>(days);
+        }
+      }
+      return;
+    case TYPE_TIMESTAMP:
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) {
+        TimestampVal val = expr_eval->GetTimestampVal(it.Get());
+        int64_t micros;
+        // Impala timestamps have no time zone, so they are converted as if they were in
+        // UTC. Timestamps outside of the range of Arrow timestamps are returned as NULL.
+        if (val.is_null
+            || !TimestampValue::FromTimestampVal(val).UtcToUnixTimeMicros(&micros)) {
+          column->AppendNull();
+        } else {
+          column->AppendFixed<int64_t>(micros);
+        }
+      }
+      return;
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+    case TYPE_CHAR:
+      FOREACH_ROW_LIMIT(batch, start_idx, num_rows, it) {
+        StringVal val = expr_eval->GetStringVal(it.Get());
+        if (val.is_null) {
+          column->AppendNull();
+        } else {
+          column->AppendString(reinterpret_cast<const char*>(val.ptr),
+              type.type == TYPE_CHAR ? type.len : val.len);
+        }
+      }
+      return;
+    default:
+      DCHECK(false) << "Unhandled type: " << type;
+  }
+}
+
+Status ArrowResultSet::AddRows(const vector<ScalarExprEvaluator*>& expr_evals,
+    RowBatch* batch, int start_idx, int num_rows) {
+  DCHECK_GE(batch->num_rows(), start_idx + num_rows);
+  DCHECK_EQ(expr_evals.size(), columns_.size());
+  for (int i = 0; i < columns_.size(); ++i) {
+    AddExprValues(expr_evals[i], types_[i], batch, start_idx, num_rows, &columns_[i]);
+  }
+  return Status::OK();
+}
+
+Status ArrowResultSet::AddOneRow(const TResultRow& row) {
+  DCHECK_EQ(row.colVals.size(), columns_.size());
+  // Rows of DDL and metadata operations only contain values of a few types.
+  for (int i = 0; i < columns_.size(); ++i) {
+    const TColumnValue& val = row.colVals[i];
+    ArrowColumn* column = &columns_[i];
+    if (column->type() == ArrowColumn::BOOL && val.__isset.bool_val) {
+      column->AppendBool(val.bool_val);
+    } else if (column->type() == ArrowColumn::INT8 && val.__isset.byte_val) {
+      column->AppendFixed<int8_t>(val.byte_val);
+    } else if (column->type() == ArrowColumn::INT16 && val.__isset.short_val) {
+      column->AppendFixed<int16_t>(val.short_val);
+    } else if (column->type() == ArrowColumn::INT32 && val.__isset.int_val) {
+      column->AppendFixed<int32_t>(val.int_val);
+    } else if (column->type() == ArrowColumn::INT64 && val.__isset.long_val) {
+      column->AppendFixed<int64_t>(val.long_val);
+    } else if (column->type() == ArrowColumn::DOUBLE && val.__isset.double_val) {
+      column->AppendFixed<double>(val.double_val);
+    } else if (column->type() == ArrowColumn::UTF8 && val.__isset.string_val) {
+      column->AppendString(val.string_val.data(), val.string_val.size());
+    } else if (column->type() == ArrowColumn::UTF8 && val.__isset.binary_val) {
+      column->AppendString(val.binary_val.data(), val.binary_val.size());
+    } else if (!val.__isset.bool_val && !val.__isset.byte_val && !val.__isset.short_val
+        && !val.__isset.int_val && !val.__isset.long_val && !val.__isset.double_val
+        && !val.__isset.string_val && !val.__isset.binary_val
+        && !val.__isset.timestamp_val && !val.__isset.decimal_val
+        && !val.__isset.date_val) {
+      column->AppendNull();
+    } else {
+      return Status(Substitute("Value of column '$0' of type $1 is not supported with "
+          "ARROW_RESULT_FORMAT", column->name(), types_[i].DebugString()));
+    }
+  }
+  return Status::OK();
+}
+
+int ArrowResultSet::AddRows(const QueryResultSet* other, int start_idx, int num_rows) {
+  const ArrowResultSet* o = static_cast<const ArrowResultSet*>(other);
+  DCHECK_EQ(columns_.size(), o->columns_.size());
+  if (start_idx >= o->columns_[0].num_rows()) return 0;
+  const int rows_added = min<int64_t>(num_rows, o->columns_[0].num_rows() - start_idx);
+  for (int i = 0; i < columns_.size(); ++i) {
+    columns_[i].AppendRows(o->columns_[i], start_idx, rows_added);
+  }
+  return rows_added;
+}
+
+int64_t ArrowResultSet::ByteSize(int start_idx, int num_rows) {
+  int64_t bytes = 0;
+  for (const ArrowColumn& column : columns_) {
+    bytes += column.ByteSize(start_idx, num_rows);
+  }
+  return bytes;
+}
+
+Status ArrowResultSet::FinalizeRowSet() {
+  ThriftTColumn column;
+  column.__isset.binaryVal = true;
+  column.binaryVal.values.emplace_back();
+  WriteArrowIpcStream(columns_, &column.binaryVal.values.back());
+  result_set_->rows.clear();
+  result_set_->columns.clear();
+  result_set_->columns.push_back(move(column));
+  result_set_->__isset.columns = true;
+  for (ArrowColumn& column : columns_) column.Clear();
+  return Status::OK();
+}
 }
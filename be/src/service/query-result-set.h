@@ -63,16 +63,37 @@ class QueryResultSet {
   /// Returns the size of this result set in number of rows.
   virtual size_t size() = 0;
 
-  /// Returns a result set suitable for Beeswax-based clients.
+  /// Called after all rows of a fetch were added, before the result set is returned to
+  /// the client. Result sets that encode all rows at once do that here.
+  virtual Status FinalizeRowSet() { return Status::OK(); }
+
+  /// Returns a new, empty result set of the same client format as this one that manages
+  /// its own rows. Rows of this result set can be copied into it with
+  /// AddRows(const QueryResultSet*, int, int) and back. 'metadata' must outlive the
+  /// returned result set.
+  virtual QueryResultSet* CreateEmpty(const TResultSetMetadata& metadata) const = 0;
+
+  /// Returns a result set suitable for Beeswax-based clients. If 'rowset' is nullptr, the
+  /// returned object will allocate and manage its own rowset.
   static QueryResultSet* CreateAsciiQueryResultSet(
       const TResultSetMetadata& metadata, std::vector<std::string>* rowset);
 
   /// Returns a result set suitable for HS2-based clients. If 'rowset' is nullptr, the
-  /// returned object will allocate and manage its own rowset.
+  /// returned object will allocate and manage its own rowset. A columnar result set
+  /// converts the added rows with up to 'num_conversion_threads' threads.
   static QueryResultSet* CreateHS2ResultSet(
       apache::hive::service::cli::thrift::TProtocolVersion::type version,
       const TResultSetMetadata& metadata,
-      apache::hive::service::cli::thrift::TRowSet* rowset);
+      apache::hive::service::cli::thrift::TRowSet* rowset,
+      int num_conversion_threads = 1);
+
+  /// Creates a result set for HS2 clients that returns the rows as an Arrow IPC stream
+  /// in a single binary column of 'rowset' (see ArrowResultSet). If 'rowset' is
+  /// nullptr, the returned object will allocate and manage its own rowset. Returns an
+  /// error if a column type cannot be represented in Arrow.
+  static Status CreateArrowResultSet(const TResultSetMetadata& metadata,
+      apache::hive::service::cli::thrift::TRowSet* rowset,
+      QueryResultSet** result_set) WARN_UNUSED_RESULT;
 };
 }
 
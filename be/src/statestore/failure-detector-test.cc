@@ -0,0 +1,130 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "statestore/failure-detector.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static const string PEER = "peer";
+
+/// Sends heartbeats for 'peer' to 'detector' at the times in 'times_ms'.
+static void SendHeartbeats(PhiAccrualFailureDetector* detector, const string& peer,
+    const vector<int64_t>& times_ms) {
+  for (int64_t time_ms : times_ms) {
+    EXPECT_EQ(FailureDetector::OK, detector->UpdateHeartbeat(peer, true, time_ms));
+  }
+}
+
+/// Returns the times of 'num_heartbeats' heartbeats every 'interval_ms', starting at 0.
+static vector<int64_t> RegularHeartbeats(int num_heartbeats, int64_t interval_ms) {
+  vector<int64_t> times_ms;
+  for (int i = 0; i < num_heartbeats; ++i) times_ms.push_back(i * interval_ms);
+  return times_ms;
+}
+
+TEST(PhiAccrualFailureDetectorTest, UnknownPeer) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0);
+  EXPECT_EQ(FailureDetector::UNKNOWN, detector.GetPeerState(PEER, 0));
+  EXPECT_EQ(0, detector.GetPhi(PEER, 0));
+}
+
+TEST(PhiAccrualFailureDetectorTest, RegularHeartbeats) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0);
+  SendHeartbeats(&detector, PEER, RegularHeartbeats(20, 1000));
+  // The last heartbeat was at 19000ms. The intervals have a mean of 1000ms and a
+  // standard deviation of 0, which is raised to 100ms.
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(PEER, 20000));
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(PEER, 20100));
+  EXPECT_EQ(FailureDetector::SUSPECTED, detector.GetPeerState(PEER, 20500));
+  EXPECT_EQ(FailureDetector::FAILED, detector.GetPeerState(PEER, 21000));
+  // The suspicion level only grows until the next heartbeat.
+  EXPECT_LT(detector.GetPhi(PEER, 20000), detector.GetPhi(PEER, 20300));
+  EXPECT_LT(detector.GetPhi(PEER, 20300), detector.GetPhi(PEER, 20500));
+  EXPECT_EQ(FailureDetector::OK, detector.UpdateHeartbeat(PEER, true, 21000));
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(PEER, 22000));
+}
+
+TEST(PhiAccrualFailureDetectorTest, IrregularHeartbeatsTolerateLongerDelays) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0);
+  const string irregular_peer = "irregular_peer";
+  SendHeartbeats(&detector, PEER, RegularHeartbeats(21, 1000));
+  // Alternating intervals of 500ms and 1500ms, with the same mean as the regular
+  // heartbeats but a standard deviation of about 500ms.
+  vector<int64_t> times_ms;
+  for (int i = 0; i <= 20; ++i) times_ms.push_back(i * 1000 + (i % 2 == 1 ? -500 : 0));
+  SendHeartbeats(&detector, irregular_peer, times_ms);
+  // Both peers sent their last heartbeat at 20000ms.
+  EXPECT_LT(detector.GetPhi(irregular_peer, 21800), detector.GetPhi(PEER, 21800));
+  EXPECT_EQ(FailureDetector::FAILED, detector.GetPeerState(PEER, 21800));
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(irregular_peer, 21800));
+}
+
+TEST(PhiAccrualFailureDetectorTest, AcceptablePause) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 5000);
+  SendHeartbeats(&detector, PEER, RegularHeartbeats(20, 1000));
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(PEER, 25000));
+  EXPECT_EQ(FailureDetector::FAILED, detector.GetPeerState(PEER, 26000));
+}
+
+TEST(PhiAccrualFailureDetectorTest, MissedHeartbeats) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0);
+  // A peer that never sends a successful heartbeat is eventually considered failed.
+  EXPECT_EQ(FailureDetector::OK, detector.UpdateHeartbeat(PEER, false, 0));
+  EXPECT_EQ(FailureDetector::OK, detector.UpdateHeartbeat(PEER, false, 1000));
+  EXPECT_EQ(FailureDetector::FAILED, detector.UpdateHeartbeat(PEER, false, 2000));
+  EXPECT_EQ(FailureDetector::OK, detector.UpdateHeartbeat(PEER, true, 3000));
+  // Missed heartbeats do not restart the clock.
+  double phi = detector.GetPhi(PEER, 3500);
+  EXPECT_EQ(FailureDetector::OK, detector.UpdateHeartbeat(PEER, false, 3500));
+  EXPECT_EQ(phi, detector.GetPhi(PEER, 3500));
+}
+
+TEST(PhiAccrualFailureDetectorTest, Window) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0, 5);
+  vector<int64_t> times_ms = RegularHeartbeats(20, 1000);
+  // The window only contains the last five intervals of 3000ms.
+  for (int i = 1; i <= 5; ++i) times_ms.push_back(19000 + i * 3000);
+  SendHeartbeats(&detector, PEER, times_ms);
+  EXPECT_EQ(FailureDetector::OK, detector.GetPeerState(PEER, 37000));
+  EXPECT_EQ(FailureDetector::FAILED, detector.GetPeerState(PEER, 38000));
+}
+
+TEST(PhiAccrualFailureDetectorTest, EvictPeer) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 0);
+  SendHeartbeats(&detector, PEER, RegularHeartbeats(5, 1000));
+  detector.EvictPeer(PEER);
+  EXPECT_EQ(FailureDetector::UNKNOWN, detector.GetPeerState(PEER, 100000));
+}
+
+TEST(PhiAccrualFailureDetectorTest, DetectionTime) {
+  PhiAccrualFailureDetector detector(3, 8, 1000, 100, 2000);
+  SendHeartbeats(&detector, PEER, RegularHeartbeats(20, 1000));
+  int64_t detection_time_ms = PhiAccrualFailureDetector::DetectionTimeMs(8, 1000, 100,
+      2000);
+  EXPECT_GT(detection_time_ms, 3000);
+  EXPECT_EQ(FailureDetector::FAILED,
+      detector.GetPeerState(PEER, 19000 + detection_time_ms));
+  EXPECT_NE(FailureDetector::FAILED,
+      detector.GetPeerState(PEER, 19000 + detection_time_ms - 1));
+}
+
+}
+
+IMPALA_TEST_MAIN();
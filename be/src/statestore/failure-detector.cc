@@ -17,11 +17,14 @@
 
 #include "statestore/failure-detector.h"
 
+#include <algorithm>
+#include <cmath>
 #include <mutex>
 
 #include <boost/assign.hpp>
 
 #include "common/logging.h"
+#include "util/time.h"
 
 #include "common/names.h"
 
@@ -118,3 +121,137 @@ void MissedHeartbeatFailureDetector::EvictPeer(const string& peer) {
   lock_guard<mutex> l(lock_);
   missed_heartbeat_counts_.erase(peer);
 }
+
+/// Returns -log10 of the probability that a normally distributed value with 'mean' and
+/// 'stddev' is larger than 'value'.
+static double Phi(double value, double mean, double stddev) {
+  // Logistic approximation of the CDF of the normal distribution (Bowling et al.,
+  // 2009), with a maximum error of 0.00014. The CDF is 1 / (1 + e).
+  double y = (value - mean) / stddev;
+  double e = exp(-y * (1.5976 + 0.070566 * y * y));
+  if (y > 0) return -log10(e / (1.0 + e));
+  return -log10(1.0 - 1.0 / (1.0 + e));
+}
+
+PhiAccrualFailureDetector::PhiAccrualFailureDetector(double suspect_phi,
+    double failure_phi, int64_t expected_interval_ms, int64_t min_stddev_ms,
+    int64_t acceptable_pause_ms, int window_size)
+  : suspect_phi_(suspect_phi),
+    failure_phi_(failure_phi),
+    expected_interval_ms_(expected_interval_ms),
+    min_stddev_ms_(min_stddev_ms),
+    acceptable_pause_ms_(acceptable_pause_ms),
+    window_size_(window_size) {
+  DCHECK_GT(suspect_phi_, 0);
+  DCHECK_GE(failure_phi_, suspect_phi_);
+  DCHECK_GT(expected_interval_ms_, 0);
+  DCHECK_GT(min_stddev_ms_, 0);
+  DCHECK_GE(acceptable_pause_ms_, 0);
+  DCHECK_GT(window_size_, 0);
+}
+
+FailureDetector::PeerState PhiAccrualFailureDetector::UpdateHeartbeat(
+    const string& peer, bool seen) {
+  return UpdateHeartbeat(peer, seen, MonotonicMillis());
+}
+
+FailureDetector::PeerState PhiAccrualFailureDetector::GetPeerState(const string& peer) {
+  return GetPeerState(peer, MonotonicMillis());
+}
+
+void PhiAccrualFailureDetector::EvictPeer(const string& peer) {
+  lock_guard<mutex> l(lock_);
+  peer_records_.erase(peer);
+}
+
+FailureDetector::PeerState PhiAccrualFailureDetector::UpdateHeartbeat(
+    const string& peer, bool seen, int64_t now_ms) {
+  lock_guard<mutex> l(lock_);
+  auto it = peer_records_.find(peer);
+  if (it == peer_records_.end()) {
+    // Start the clock at the first update, so that a peer that never succeeds to
+    // heartbeat is eventually considered failed.
+    it = peer_records_.emplace(peer, PeerRecord()).first;
+    it->second.last_heartbeat_ms = now_ms;
+    AddInterval(expected_interval_ms_, &it->second);
+  } else if (seen) {
+    AddInterval(max<int64_t>(0, now_ms - it->second.last_heartbeat_ms), &it->second);
+    it->second.last_heartbeat_ms = now_ms;
+  }
+  PeerRecord* record = &it->second;
+  double phi = ComputePhi(*record, now_ms);
+  PeerState state = ComputePeerState(phi);
+  if (state != record->last_state && record->last_state != UNKNOWN) {
+    LOG(INFO) << "State of '" << peer << "' changed from "
+              << PeerStateToString(record->last_state) << " to "
+              << PeerStateToString(state) << " (phi: " << phi << ", "
+              << (now_ms - record->last_heartbeat_ms) << "ms since the last heartbeat)";
+  }
+  record->last_state = state;
+  return state;
+}
+
+FailureDetector::PeerState PhiAccrualFailureDetector::GetPeerState(
+    const string& peer, int64_t now_ms) {
+  lock_guard<mutex> l(lock_);
+  auto it = peer_records_.find(peer);
+  if (it == peer_records_.end()) return UNKNOWN;
+  return ComputePeerState(ComputePhi(it->second, now_ms));
+}
+
+double PhiAccrualFailureDetector::GetPhi(const string& peer, int64_t now_ms) {
+  lock_guard<mutex> l(lock_);
+  auto it = peer_records_.find(peer);
+  if (it == peer_records_.end()) return 0;
+  return ComputePhi(it->second, now_ms);
+}
+
+void PhiAccrualFailureDetector::AddInterval(int64_t interval_ms, PeerRecord* record) {
+  record->intervals_ms.push_back(interval_ms);
+  record->interval_sum += interval_ms;
+  record->interval_sum_squares += static_cast<double>(interval_ms) * interval_ms;
+  if (record->intervals_ms.size() > static_cast<size_t>(window_size_)) {
+    int64_t evicted_ms = record->intervals_ms.front();
+    record->intervals_ms.pop_front();
+    record->interval_sum -= evicted_ms;
+    record->interval_sum_squares -= static_cast<double>(evicted_ms) * evicted_ms;
+  }
+}
+
+double PhiAccrualFailureDetector::ComputePhi(
+    const PeerRecord& record, int64_t now_ms) const {
+  DCHECK(!record.intervals_ms.empty());
+  double num_intervals = record.intervals_ms.size();
+  double mean = record.interval_sum / num_intervals;
+  double variance = record.interval_sum_squares / num_intervals - mean * mean;
+  double stddev = max<double>(min_stddev_ms_, sqrt(max(0.0, variance)));
+  return Phi(now_ms - record.last_heartbeat_ms, mean + acceptable_pause_ms_, stddev);
+}
+
+FailureDetector::PeerState PhiAccrualFailureDetector::ComputePeerState(
+    double phi) const {
+  if (phi >= failure_phi_) {
+    return FAILED;
+  } else if (phi >= suspect_phi_) {
+    return SUSPECTED;
+  }
+  return OK;
+}
+
+int64_t PhiAccrualFailureDetector::DetectionTimeMs(double failure_phi,
+    int64_t interval_ms, int64_t min_stddev_ms, int64_t acceptable_pause_ms) {
+  // Phi grows monotonically with the elapsed time, so the time at which it reaches
+  // 'failure_phi' can be found by bisection.
+  double mean = interval_ms + acceptable_pause_ms;
+  int64_t lower = 0;
+  int64_t upper = mean + 100 * min_stddev_ms;
+  while (lower < upper) {
+    int64_t middle = lower + (upper - lower) / 2;
+    if (Phi(middle, mean, min_stddev_ms) >= failure_phi) {
+      upper = middle;
+    } else {
+      lower = middle + 1;
+    }
+  }
+  return lower;
+}
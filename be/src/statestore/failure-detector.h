@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <deque>
+#include <map>
 #include <mutex>
 #include <string>
 #include <boost/date_time/posix_time/posix_time_types.hpp>
@@ -141,4 +143,95 @@ class MissedHeartbeatFailureDetector : public FailureDetector {
   /// Number of consecutive heartbeats missed by peer.
   std::map<std::string, int32_t> missed_heartbeat_counts_;
 };
+
+/// A phi-accrual failure detector (Hayashibara et al., "The phi accrual failure
+/// detector", 2004). Instead of a fixed threshold, it keeps a window of the intervals
+/// between the recent successful heartbeats of every peer and models them as a normal
+/// distribution. The suspicion level phi of a peer is -log10 of the probability that a
+/// heartbeat arrives later than the time that has passed since its last successful
+/// heartbeat. A phi of 1 means a 10% chance that the peer is still alive, a phi of 2 a
+/// 1% chance and so on. Peers with a phi of at least 'failure_phi' are considered
+/// failed, and those with a phi of at least 'suspect_phi' suspected.
+///
+/// Peers whose heartbeats arrive irregularly, e.g. because of GC pauses or network
+/// jitter, get a wider distribution and thus more time before they are suspected,
+/// while peers with regular heartbeats are detected quickly when they stop.
+///
+/// Clients may call UpdateHeartbeat(..., false) for a missed heartbeat, but do not have
+/// to: the suspicion level only depends on the time since the last successful one.
+/// Thread safe.
+class PhiAccrualFailureDetector : public FailureDetector {
+ public:
+  /// 'expected_interval_ms' is the expected time between heartbeats, which is used
+  /// until a peer has sent two heartbeats. 'min_stddev_ms' is a lower bound of the
+  /// standard deviation of the intervals, so that a peer with very regular heartbeats
+  /// is not suspected after a small delay. 'acceptable_pause_ms' is added to the mean
+  /// interval and is the time by which a heartbeat may be late without raising
+  /// suspicion. 'window_size' is the number of intervals kept per peer.
+  PhiAccrualFailureDetector(double suspect_phi, double failure_phi,
+      int64_t expected_interval_ms, int64_t min_stddev_ms, int64_t acceptable_pause_ms,
+      int window_size = DEFAULT_WINDOW_SIZE);
+
+  virtual PeerState UpdateHeartbeat(const std::string& peer, bool seen) override;
+
+  virtual PeerState GetPeerState(const std::string& peer) override;
+
+  virtual void EvictPeer(const std::string& peer) override;
+
+  /// Same as the functions above, but with 'now_ms' as the current monotonic time.
+  /// Exposed for testing.
+  PeerState UpdateHeartbeat(const std::string& peer, bool seen, int64_t now_ms);
+  PeerState GetPeerState(const std::string& peer, int64_t now_ms);
+
+  /// Returns the suspicion level of 'peer' at 'now_ms', or 0 if nothing has been heard
+  /// about the peer.
+  double GetPhi(const std::string& peer, int64_t now_ms);
+
+  /// Returns the time since its last heartbeat after which a peer is considered failed
+  /// if its heartbeats arrived exactly every 'interval_ms' and 'failure_phi',
+  /// 'min_stddev_ms' and 'acceptable_pause_ms' are the parameters of the detector.
+  static int64_t DetectionTimeMs(double failure_phi, int64_t interval_ms,
+      int64_t min_stddev_ms, int64_t acceptable_pause_ms);
+
+  static const int DEFAULT_WINDOW_SIZE = 100;
+
+ private:
+  struct PeerRecord {
+    /// Time of the last successful heartbeat, or of the first update if there was no
+    /// successful heartbeat yet.
+    int64_t last_heartbeat_ms = 0;
+
+    /// Intervals between the most recent successful heartbeats, the oldest first.
+    std::deque<int64_t> intervals_ms;
+
+    /// Sum and sum of squares of 'intervals_ms'.
+    double interval_sum = 0;
+    double interval_sum_squares = 0;
+
+    /// State that was returned by the last call to UpdateHeartbeat().
+    PeerState last_state = UNKNOWN;
+  };
+
+  /// Adds 'interval_ms' to the window of 'record', evicting the oldest interval if the
+  /// window is full.
+  void AddInterval(int64_t interval_ms, PeerRecord* record);
+
+  /// Computes the suspicion level of 'record' at 'now_ms'.
+  double ComputePhi(const PeerRecord& record, int64_t now_ms) const;
+
+  /// Computes the PeerState from the suspicion level.
+  PeerState ComputePeerState(double phi) const;
+
+  const double suspect_phi_;
+  const double failure_phi_;
+  const int64_t expected_interval_ms_;
+  const int64_t min_stddev_ms_;
+  const int64_t acceptable_pause_ms_;
+  const int window_size_;
+
+  /// Protects all members below.
+  std::mutex lock_;
+
+  std::map<std::string, PeerRecord> peer_records_;
+};
 }
@@ -61,6 +61,34 @@ DEFINE_int32(statestore_max_missed_heartbeats, 10, "Maximum number of consecutiv
     "heartbeat messages an impalad can miss before being declared failed by the "
     "statestore.");
 
+DEFINE_string(statestore_failure_detector, "missed_heartbeats", "(Advanced) The failure "
+    "detector with which the statestore decides that a subscriber failed. With "
+    "'missed_heartbeats', a subscriber fails after "
+    "--statestore_max_missed_heartbeats consecutive failed heartbeats. With "
+    "'phi_accrual', the statestore learns the distribution of the intervals between the "
+    "successful heartbeats of every subscriber and computes a suspicion level phi from "
+    "the time since the last one (see --statestore_phi_failure_threshold).");
+DEFINE_validator(statestore_failure_detector, [](const char* name, const string& val) {
+  if (val == "missed_heartbeats" || val == "phi_accrual") return true;
+  LOG(ERROR) << "Invalid value for --" << name << ": must be one of "
+      << "'missed_heartbeats' or 'phi_accrual'";
+  return false;
+});
+
+DEFINE_double(statestore_phi_suspect_threshold, 3.0, "(Advanced) The suspicion level "
+    "phi from which the 'phi_accrual' failure detector suspects a subscriber to have "
+    "failed. A phi of 1 means a 10% chance that the subscriber is alive, 2 a 1% chance "
+    "and so on.");
+DEFINE_double(statestore_phi_failure_threshold, 8.0, "(Advanced) The suspicion level "
+    "phi from which the 'phi_accrual' failure detector considers a subscriber failed.");
+DEFINE_int32(statestore_phi_min_stddev_ms, 500, "(Advanced) Lower bound of the standard "
+    "deviation of the heartbeat intervals used by the 'phi_accrual' failure detector, "
+    "so that a short delay of a subscriber with very regular heartbeats does not raise "
+    "its suspicion level too quickly.");
+DEFINE_int32(statestore_phi_acceptable_pause_ms, 5000, "(Advanced) Time by which a "
+    "heartbeat may be later than the mean interval before the 'phi_accrual' failure "
+    "detector's suspicion level of the subscriber rises.");
+
 DEFINE_int32(statestore_num_update_threads, 10, "(Advanced) Number of threads used to "
     " send topic updates in parallel to all registered subscribers.");
 DEFINE_int32(statestore_update_frequency_ms, 2000, "(Advanced) Frequency (in ms) with"
@@ -433,9 +461,7 @@ Statestore::Statestore(MetricGroup* metrics)
         FLAGS_statestore_heartbeat_tcp_timeout_seconds * 1000, "",
         IsInternalTlsConfigured())),
     thrift_iface_(new StatestoreThriftIf(this)),
-    failure_detector_(new MissedHeartbeatFailureDetector(
-        FLAGS_statestore_max_missed_heartbeats,
-        FLAGS_statestore_max_missed_heartbeats / 2)) {
+    failure_detector_(CreateFailureDetector()) {
   DCHECK(metrics != NULL);
   metrics_ = metrics;
   num_subscribers_metric_ = metrics->AddGauge(STATESTORE_LIVE_SUBSCRIBERS, 0);
@@ -1081,7 +1107,22 @@ void Statestore::ShutdownForTesting() {
   subscriber_heartbeat_threadpool_.Join();
 }
 
+FailureDetector* Statestore::CreateFailureDetector() {
+  if (FLAGS_statestore_failure_detector == "phi_accrual") {
+    return new PhiAccrualFailureDetector(FLAGS_statestore_phi_suspect_threshold,
+        FLAGS_statestore_phi_failure_threshold, FLAGS_statestore_heartbeat_frequency_ms,
+        FLAGS_statestore_phi_min_stddev_ms, FLAGS_statestore_phi_acceptable_pause_ms);
+  }
+  return new MissedHeartbeatFailureDetector(FLAGS_statestore_max_missed_heartbeats,
+      FLAGS_statestore_max_missed_heartbeats / 2);
+}
+
 int64_t Statestore::FailedExecutorDetectionTimeMs() {
+  if (FLAGS_statestore_failure_detector == "phi_accrual") {
+    return PhiAccrualFailureDetector::DetectionTimeMs(
+        FLAGS_statestore_phi_failure_threshold, FLAGS_statestore_heartbeat_frequency_ms,
+        FLAGS_statestore_phi_min_stddev_ms, FLAGS_statestore_phi_acceptable_pause_ms);
+  }
   return FLAGS_statestore_max_missed_heartbeats * FLAGS_statestore_heartbeat_frequency_ms;
 }
 
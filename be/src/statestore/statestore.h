@@ -186,6 +186,9 @@ class Statestore : public CacheLineAligned {
   static int64_t FailedExecutorDetectionTimeMs();
 
  private:
+  /// Creates the failure detector selected by --statestore_failure_detector.
+  static FailureDetector* CreateFailureDetector();
+
   /// A TopicEntry is a single entry in a topic, and logically is a <string, byte string>
   /// pair.
   class TopicEntry {
@@ -588,14 +591,14 @@ class Statestore : public CacheLineAligned {
   /// Thrift API implementation which proxies requests onto this Statestore
   std::shared_ptr<StatestoreServiceIf> thrift_iface_;
 
-  /// Failure detector for subscribers. If a subscriber misses a configurable number of
-  /// consecutive heartbeat messages, it is considered failed and a) its transient topic
-  /// entries are removed and b) its entry in the subscriber map is erased. The
-  /// subscriber ID is used to identify peers for failure detection purposes. Subscriber
-  /// state is evicted from the failure detector when the subscriber is unregistered,
-  /// so old subscribers do not occupy memory and the failure detection state does not
-  /// carry over to any new registrations of the previous subscriber.
-  boost::scoped_ptr<MissedHeartbeatFailureDetector> failure_detector_;
+  /// Failure detector for subscribers, see --statestore_failure_detector. If it
+  /// considers a subscriber failed, a) its transient topic entries are removed and b) its
+  /// entry in the subscriber map is erased. The subscriber ID is used to identify peers
+  /// for failure detection purposes. Subscriber state is evicted from the failure
+  /// detector when the subscriber is unregistered, so old subscribers do not occupy
+  /// memory and the failure detection state does not carry over to any new
+  /// registrations of the previous subscriber.
+  boost::scoped_ptr<FailureDetector> failure_detector_;
 
   /// Metric that track the registered, non-failed subscribers.
   IntGauge* num_subscribers_metric_;
@@ -406,3 +406,57 @@ IntVal AggCharIntermediateFinalize(FunctionContext* context, const StringVal& sr
   return IntVal(*reinterpret_cast<int*>(src.ptr));
 }
 
+// BatchSum(int): sum of the non-NULL inputs that registers a batch update function. Its
+// update function fails, so that tests can check that Impala calls the batch update
+// function. Only usable without GROUP BY, since grouping aggregations call Update().
+IMPALA_UDF_EXPORT
+void BatchSumBatchUpdate(
+    FunctionContext* context, int num_rows, const BatchVal* args, AnyVal* dst) {
+  BigIntVal* sum = reinterpret_cast<BigIntVal*>(dst);
+  const int32_t* vals = args[0].Values<int32_t>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (!args[0].IsNull(i)) sum->val += vals[i];
+  }
+}
+IMPALA_UDF_EXPORT
+void BatchSumInit(FunctionContext* context, BigIntVal* sum) {
+  *sum = BigIntVal(0);
+  context->SetBatchUpdateFunction(BatchSumBatchUpdate);
+}
+IMPALA_UDF_EXPORT
+void BatchSumUpdate(FunctionContext* context, const IntVal& val, BigIntVal* sum) {
+  context->SetError("BatchSumUpdate() was called instead of the batch update function");
+}
+IMPALA_UDF_EXPORT
+void BatchSumMerge(FunctionContext* context, const BigIntVal& src, BigIntVal* dst) {
+  dst->val += src.val;
+}
+
+// SumProduct(int, int): sum of a * b over the rows where neither is NULL, with a batch
+// update function that must give the same result as its update function.
+IMPALA_UDF_EXPORT
+void SumProductBatchUpdate(
+    FunctionContext* context, int num_rows, const BatchVal* args, AnyVal* dst) {
+  BigIntVal* sum = reinterpret_cast<BigIntVal*>(dst);
+  const int32_t* a = args[0].Values<int32_t>();
+  const int32_t* b = args[1].Values<int32_t>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (args[0].IsNull(i) || args[1].IsNull(i)) continue;
+    sum->val += static_cast<int64_t>(a[i]) * b[i];
+  }
+}
+IMPALA_UDF_EXPORT
+void SumProductInit(FunctionContext* context, BigIntVal* sum) {
+  *sum = BigIntVal(0);
+  context->SetBatchUpdateFunction(SumProductBatchUpdate);
+}
+IMPALA_UDF_EXPORT
+void SumProductUpdate(
+    FunctionContext* context, const IntVal& a, const IntVal& b, BigIntVal* sum) {
+  if (a.is_null || b.is_null) return;
+  sum->val += static_cast<int64_t>(a.val) * b.val;
+}
+IMPALA_UDF_EXPORT
+void SumProductMerge(FunctionContext* context, const BigIntVal& src, BigIntVal* dst) {
+  dst->val += src.val;
+}
@@ -325,6 +325,57 @@ void CountClose(FunctionContext* context, FunctionContext::FunctionStateScope sc
   }
 }
 
+// IsMultiple UDF: returns whether the first argument is a multiple of the second one.
+// Registers a batch entry point that Impala calls for conjuncts with
+// BATCH_CONJUNCT_EVALUATION.
+IMPALA_UDF_EXPORT
+BooleanVal IsMultiple(FunctionContext* context, const IntVal& val, const IntVal& div) {
+  if (val.is_null || div.is_null || div.val == 0) return BooleanVal::null();
+  return BooleanVal(val.val % div.val == 0);
+}
+
+IMPALA_UDF_EXPORT
+void IsMultipleBatch(FunctionContext* context, int num_rows, const BatchVal* args,
+    BatchVal* result) {
+  const int32_t* vals = args[0].Values<int32_t>();
+  const int32_t* divs = args[1].Values<int32_t>();
+  bool* results = result->Values<bool>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (args[0].IsNull(i) || args[1].IsNull(i) || divs[i] == 0) {
+      result->SetNull(i);
+    } else {
+      results[i] = vals[i] % divs[i] == 0;
+    }
+  }
+}
+
+IMPALA_UDF_EXPORT
+void IsMultiplePrepare(
+    FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+  if (scope == FunctionContext::THREAD_LOCAL) context->SetBatchFunction(IsMultipleBatch);
+}
+
+// BatchOnly UDF: returns whether the argument is not NULL, but fails if it is called
+// row-at-a-time, so that tests can check that Impala calls its batch entry point.
+IMPALA_UDF_EXPORT
+BooleanVal BatchOnly(FunctionContext* context, const IntVal& val) {
+  context->SetError("BatchOnly() was called row-at-a-time");
+  return BooleanVal::null();
+}
+
+IMPALA_UDF_EXPORT
+void BatchOnlyBatch(FunctionContext* context, int num_rows, const BatchVal* args,
+    BatchVal* result) {
+  bool* results = result->Values<bool>();
+  for (int i = 0; i < num_rows; ++i) results[i] = !args[0].IsNull(i);
+}
+
+IMPALA_UDF_EXPORT
+void BatchOnlyPrepare(
+    FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+  if (scope == FunctionContext::THREAD_LOCAL) context->SetBatchFunction(BatchOnlyBatch);
+}
+
 // ConstantArg UDF: returns the first argument if it's constant, otherwise returns NULL.
 IMPALA_UDF_EXPORT
 void ConstantArgPrepare(
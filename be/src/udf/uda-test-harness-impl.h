@@ -173,9 +173,7 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteSingleNode(
   init_fn_(context->get(), &intermediate);
   if (!CheckContext(context->get())) return RESULT::null();
 
-  for (int i = 0; i < num_input_values_; ++i) {
-    Update(i, context->get(), &intermediate);
-  }
+  UpdateRows(0, 1, context->get(), &intermediate);
   if (!CheckContext(context->get())) return RESULT::null();
 
   // Single node doesn't need merge or serialize
@@ -211,9 +209,8 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteOneLevel(int num_nodes,
   if (!CheckContext(result_context->get())) return RESULT::null();
 
   // Process all the values in the single level num_nodes contexts
-  for (int i = 0; i < num_input_values_; ++i) {
-    int target = i % num_nodes;
-    Update(i, contexts[target].get()->get(), &intermediates[target]);
+  for (int i = 0; i < num_nodes; ++i) {
+    UpdateRows(i, num_nodes, contexts[i].get()->get(), &intermediates[i]);
   }
 
   // Merge them all into the final
@@ -280,9 +277,8 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteTwoLevel(
   if (!CheckContext(result_context->get())) return RESULT::null();
 
   // Assign all the input values to level 1 updates
-  for (int i = 0; i < num_input_values_; ++i) {
-    int target = i % num1;
-    Update(i, level1_contexts[target].get()->get(), &level1_intermediates[target]);
+  for (int i = 0; i < num1; ++i) {
+    UpdateRows(i, num1, level1_contexts[i].get()->get(), &level1_intermediates[i]);
   }
 
   // Serialize the level 1 intermediates and merge them with a level 2 intermediate
@@ -333,6 +329,19 @@ RESULT UdaTestHarnessBase<RESULT, INTERMEDIATE>::ExecuteTwoLevel(
   return result;
 }
 
+template<typename RESULT, typename INTERMEDIATE>
+void UdaTestHarnessBase<RESULT, INTERMEDIATE>::UpdateRows(
+    int first, int stride, FunctionContext* context, INTERMEDIATE* dst) {
+  UdaBatchUpdate batch_update_fn = UdfTestHarness::GetBatchUpdateFunction(context);
+  if (batch_update_fn == NULL) {
+    for (int i = first; i < num_input_values_; i += stride) Update(i, context, dst);
+    return;
+  }
+  std::vector<int> rows;
+  for (int i = first; i < num_input_values_; i += stride) rows.push_back(i);
+  if (!rows.empty()) UpdateBatch(rows, batch_update_fn, context, dst);
+}
+
 template<typename RESULT, typename INTERMEDIATE, typename INPUT>
 bool UdaTestHarness<RESULT, INTERMEDIATE, INPUT>::Execute(
     const std::vector<INPUT>& values, const RESULT& expected,
@@ -351,6 +360,18 @@ void UdaTestHarness<RESULT, INTERMEDIATE, INPUT>::Update(
   update_fn_(context, *input_[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT>
+void UdaTestHarness<RESULT, INTERMEDIATE, INPUT>::UpdateBatch(
+    const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+    FunctionContext* context, INTERMEDIATE* dst) {
+  std::vector<INPUT> values;
+  values.reserve(rows.size());
+  for (int i = 0; i < rows.size(); ++i) values.push_back(*input_[rows[i]]);
+  UdfTestHarness::BatchColumn<INPUT> col(values);
+  BatchVal args[] = { col.val() };
+  batch_update_fn(context, rows.size(), args, reinterpret_cast<AnyVal*>(dst));
+}
+
 /// Runs the UDA in all the modes, validating the result is 'expected' each time.
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2>
 bool UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::Execute(
@@ -374,6 +395,16 @@ void UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::Update(
   update_fn_(context, (*input1_)[idx], (*input2_)[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2>
+void UdaTestHarness2<RESULT, INTERMEDIATE, INPUT1, INPUT2>::UpdateBatch(
+    const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+    FunctionContext* context, INTERMEDIATE* dst) {
+  UdfTestHarness::BatchColumn<INPUT1> col1(BaseClass::GatherRows(*input1_, rows));
+  UdfTestHarness::BatchColumn<INPUT2> col2(BaseClass::GatherRows(*input2_, rows));
+  BatchVal args[] = { col1.val(), col2.val() };
+  batch_update_fn(context, rows.size(), args, reinterpret_cast<AnyVal*>(dst));
+}
+
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
     typename INPUT3>
 bool UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::Execute(
@@ -398,6 +429,18 @@ void UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::Update(
   update_fn_(context, (*input1_)[idx], (*input2_)[idx], (*input3_)[idx], dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
+    typename INPUT3>
+void UdaTestHarness3<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3>::UpdateBatch(
+    const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+    FunctionContext* context, INTERMEDIATE* dst) {
+  UdfTestHarness::BatchColumn<INPUT1> col1(BaseClass::GatherRows(*input1_, rows));
+  UdfTestHarness::BatchColumn<INPUT2> col2(BaseClass::GatherRows(*input2_, rows));
+  UdfTestHarness::BatchColumn<INPUT3> col3(BaseClass::GatherRows(*input3_, rows));
+  BatchVal args[] = { col1.val(), col2.val(), col3.val() };
+  batch_update_fn(context, rows.size(), args, reinterpret_cast<AnyVal*>(dst));
+}
+
 template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
     typename INPUT3, typename INPUT4>
 bool UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::Execute(
@@ -426,6 +469,19 @@ void UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::Upda
       dst);
 }
 
+template<typename RESULT, typename INTERMEDIATE, typename INPUT1, typename INPUT2,
+    typename INPUT3, typename INPUT4>
+void UdaTestHarness4<RESULT, INTERMEDIATE, INPUT1, INPUT2, INPUT3, INPUT4>::UpdateBatch(
+    const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+    FunctionContext* context, INTERMEDIATE* dst) {
+  UdfTestHarness::BatchColumn<INPUT1> col1(BaseClass::GatherRows(*input1_, rows));
+  UdfTestHarness::BatchColumn<INPUT2> col2(BaseClass::GatherRows(*input2_, rows));
+  UdfTestHarness::BatchColumn<INPUT3> col3(BaseClass::GatherRows(*input3_, rows));
+  UdfTestHarness::BatchColumn<INPUT4> col4(BaseClass::GatherRows(*input4_, rows));
+  BatchVal args[] = { col1.val(), col2.val(), col3.val(), col4.val() };
+  batch_update_fn(context, rows.size(), args, reinterpret_cast<AnyVal*>(dst));
+}
+
 }
 
 #endif
@@ -120,8 +120,27 @@ class UdaTestHarnessBase {
   /// num2 in the second. The values are processed in num1 + num2 contexts.
   RESULT ExecuteTwoLevel(int num1, int num2, ScopedFunctionContext* result_context);
 
+  /// Updates 'dst' with the input values with indices 'first', 'first' + 'stride', ...
+  /// If the UDA registered a batch update function in 'context', they are passed to it
+  /// with a single call of UpdateBatch(). Otherwise Update() is called for each of them.
+  void UpdateRows(int first, int stride, FunctionContext* context, INTERMEDIATE* dst);
+
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst) = 0;
 
+  /// Calls 'batch_update_fn' with the input values with indices 'rows'.
+  virtual void UpdateBatch(const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+      FunctionContext* context, INTERMEDIATE* dst) = 0;
+
+  /// Returns the values of 'values' with indices 'rows'.
+  template<typename T>
+  static std::vector<T> GatherRows(const std::vector<T>& values,
+      const std::vector<int>& rows) {
+    std::vector<T> result;
+    result.reserve(rows.size());
+    for (int i = 0; i < rows.size(); ++i) result.push_back(values[rows[i]]);
+    return result;
+  }
+
   /// UDA functions
   InitFn init_fn_;
   MergeFn merge_fn_;
@@ -180,6 +199,8 @@ class UdaTestHarness : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+      FunctionContext* context, INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -211,6 +232,8 @@ class UdaTestHarness2 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+      FunctionContext* context, INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -244,6 +267,8 @@ class UdaTestHarness3 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+      FunctionContext* context, INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
@@ -279,6 +304,8 @@ class UdaTestHarness4 : public UdaTestHarnessBase<RESULT, INTERMEDIATE> {
 
  protected:
   virtual void Update(int idx, FunctionContext* context, INTERMEDIATE* dst);
+  virtual void UpdateBatch(const std::vector<int>& rows, UdaBatchUpdate batch_update_fn,
+      FunctionContext* context, INTERMEDIATE* dst);
 
  private:
   UpdateFn update_fn_;
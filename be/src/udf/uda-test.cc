@@ -51,6 +51,43 @@ BigIntVal CountFinalize(FunctionContext* context, const BigIntVal& val) {
   return val;
 }
 
+//-------------------------------- Count (batch) ---------------------------------
+// Count(int_col) with a batch update function, which the harness calls instead of
+// CountUpdate() for all the rows that go to one context.
+void CountBatchUpdate(FunctionContext* context, int num_rows, const BatchVal* args,
+    AnyVal* val) {
+  BigIntVal* count = reinterpret_cast<BigIntVal*>(val);
+  for (int i = 0; i < num_rows; ++i) count->val += !args[0].IsNull(i);
+}
+
+void CountBatchInit(FunctionContext* context, BigIntVal* val) {
+  CountInit(context, val);
+  context->SetBatchUpdateFunction(CountBatchUpdate);
+}
+
+// Sum(a * b) of two int columns, with a batch update function.
+void SumProductUpdate(FunctionContext* context, const IntVal& a, const IntVal& b,
+    BigIntVal* val) {
+  if (a.is_null || b.is_null) return;
+  val->val += static_cast<int64_t>(a.val) * b.val;
+}
+
+void SumProductBatchUpdate(FunctionContext* context, int num_rows,
+    const BatchVal* args, AnyVal* val) {
+  BigIntVal* sum = reinterpret_cast<BigIntVal*>(val);
+  const int32_t* a = args[0].Values<int32_t>();
+  const int32_t* b = args[1].Values<int32_t>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (args[0].IsNull(i) || args[1].IsNull(i)) continue;
+    sum->val += static_cast<int64_t>(a[i]) * b[i];
+  }
+}
+
+void SumProductBatchInit(FunctionContext* context, BigIntVal* val) {
+  CountInit(context, val);
+  context->SetBatchUpdateFunction(SumProductBatchUpdate);
+}
+
 //-------------------------------- Count(...) ------------------------------------
 // Example of implementing Count(...)
 // The input type is: multiple ints
@@ -246,6 +283,32 @@ TEST(CountMultiArgTest, Basic) {
   EXPECT_TRUE(test4.Execute(no_nulls, no_nulls, no_nulls, no_nulls, BigIntVal(4 * num)));
 }
 
+TEST(CountTest, BatchUpdate) {
+  // The update function is never called if there is a batch update function.
+  UdaTestHarness<BigIntVal, BigIntVal, IntVal> test(
+      CountBatchInit, NULL, CountMerge, NULL, CountFinalize);
+  vector<IntVal> values;
+  int num_non_null = 0;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(i % 3 == 0 ? IntVal::null() : IntVal(i));
+    num_non_null += !values.back().is_null;
+  }
+  EXPECT_TRUE(test.Execute(values, BigIntVal(num_non_null))) << test.GetErrorMsg();
+  EXPECT_FALSE(test.Execute(values, BigIntVal(values.size()))) << test.GetErrorMsg();
+
+  vector<IntVal> a;
+  vector<IntVal> b;
+  BigIntVal expected(0);
+  for (int i = 0; i < 1000; ++i) {
+    a.push_back(i % 7 == 0 ? IntVal::null() : IntVal(i));
+    b.push_back(i % 11 == 0 ? IntVal::null() : IntVal(1000 - i));
+    SumProductUpdate(nullptr, a.back(), b.back(), &expected);
+  }
+  UdaTestHarness2<BigIntVal, BigIntVal, IntVal, IntVal> test2(
+      SumProductBatchInit, NULL, CountMerge, NULL, CountFinalize);
+  EXPECT_TRUE(test2.Execute(a, b, expected)) << test2.GetErrorMsg();
+}
+
 bool FuzzyCompare(const BigIntVal& r1, const BigIntVal& r2) {
   if (r1.is_null && r2.is_null) return true;
   if (r1.is_null || r2.is_null) return false;
@@ -139,6 +139,10 @@ class FunctionContextImpl {
 
   RuntimeState* state() { return state_; }
 
+  /// The batch entry points registered by the UDF or UDA. Null if there is none.
+  impala_udf::UdfBatchFn batch_fn() const { return batch_fn_; }
+  impala_udf::UdaBatchUpdate batch_update_fn() const { return batch_update_fn_; }
+
   /// Various static attributes of the UDF/UDA that can be injected as constants
   /// by codegen. Note that the argument types refer to those in the UDF/UDA signature,
   /// not the arguments of the C++ functions implementing the UDF/UDA. Any change to
@@ -252,6 +256,10 @@ class FunctionContextImpl {
   void* thread_local_fn_state_;
   void* fragment_local_fn_state_;
 
+  /// Set via FunctionContext::SetBatchFunction()/SetBatchUpdateFunction().
+  impala_udf::UdfBatchFn batch_fn_;
+  impala_udf::UdaBatchUpdate batch_update_fn_;
+
   /// The number of bytes allocated externally by the user function. In some cases,
   /// it is too inconvenient to use the Allocate()/Free() APIs in the FunctionContext,
   /// particularly for existing codebases (e.g. they use std::vector). Instead, they'll
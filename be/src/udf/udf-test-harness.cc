@@ -46,3 +46,11 @@ void UdfTestHarness::SetConstantArgs(
 void UdfTestHarness::CloseContext(FunctionContext* context) {
   context->impl()->Close();
 }
+
+UdfBatchFn UdfTestHarness::GetBatchFunction(FunctionContext* context) {
+  return context->impl()->batch_fn();
+}
+
+UdaBatchUpdate UdfTestHarness::GetBatchUpdateFunction(FunctionContext* context) {
+  return context->impl()->batch_update_fn();
+}
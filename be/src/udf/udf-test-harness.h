@@ -61,6 +61,109 @@ class UdfTestHarness {
   /// the error to be set on context.
   static void CloseContext(FunctionContext* context);
 
+  /// Returns the batch entry points that were registered in 'context' with
+  /// FunctionContext::SetBatchFunction() and SetBatchUpdateFunction(), or NULL.
+  static UdfBatchFn GetBatchFunction(FunctionContext* context);
+  static UdaBatchUpdate GetBatchUpdateFunction(FunctionContext* context);
+
+  /// The values of a vector of *Vals in the layout of a BatchVal (see udf.h).
+  template<typename T>
+  class BatchColumn {
+   public:
+    explicit BatchColumn(const std::vector<T>& vals)
+      : values_(vals.size()), nulls_((vals.size() + 7) / 8, 0) {
+      // A *Val is at least as large as its value, so 'values_' has room for the values
+      // in the layout of a BatchVal.
+      val_.values = values_.empty() ? NULL : &values_[0];
+      val_.nulls = nulls_.empty() ? NULL : &nulls_[0];
+      for (int i = 0; i < vals.size(); ++i) {
+        if (vals[i].is_null) {
+          val_.SetNull(i);
+        } else {
+          SetBatchValue(vals[i], i, val_.values);
+        }
+      }
+    }
+
+    const BatchVal& val() const { return val_; }
+    BatchVal* mutable_val() { return &val_; }
+
+    /// Returns the value of row 'i'.
+    T Get(int i) const {
+      if (val_.IsNull(i)) return T::null();
+      T v;
+      GetBatchValue(val_.values, i, &v);
+      return v;
+    }
+
+   private:
+    std::vector<T> values_;
+    std::vector<uint8_t> nulls_;
+    BatchVal val_;
+  };
+
+  /// Store 'v' as the value of row 'i' of the values of a BatchVal, or read it from
+  /// there. Used by BatchColumn.
+  static void SetBatchValue(const BooleanVal& v, int i, void* values) {
+    static_cast<bool*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const TinyIntVal& v, int i, void* values) {
+    static_cast<int8_t*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const SmallIntVal& v, int i, void* values) {
+    static_cast<int16_t*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const IntVal& v, int i, void* values) {
+    static_cast<int32_t*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const BigIntVal& v, int i, void* values) {
+    static_cast<int64_t*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const FloatVal& v, int i, void* values) {
+    static_cast<float*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const DoubleVal& v, int i, void* values) {
+    static_cast<double*>(values)[i] = v.val;
+  }
+  static void SetBatchValue(const DateVal& v, int i, void* values) {
+    static_cast<int32_t*>(values)[i] = v.val;
+  }
+  template<typename T>
+  static void SetBatchValue(const T& v, int i, void* values) {
+    // StringVal, TimestampVal and DecimalVal are stored as they are.
+    static_cast<T*>(values)[i] = v;
+  }
+
+  static void GetBatchValue(const void* values, int i, BooleanVal* v) {
+    *v = BooleanVal(static_cast<const bool*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, TinyIntVal* v) {
+    *v = TinyIntVal(static_cast<const int8_t*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, SmallIntVal* v) {
+    *v = SmallIntVal(static_cast<const int16_t*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, IntVal* v) {
+    *v = IntVal(static_cast<const int32_t*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, BigIntVal* v) {
+    *v = BigIntVal(static_cast<const int64_t*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, FloatVal* v) {
+    *v = FloatVal(static_cast<const float*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, DoubleVal* v) {
+    *v = DoubleVal(static_cast<const double*>(values)[i]);
+  }
+  static void GetBatchValue(const void* values, int i, DateVal* v) {
+    *v = DateVal(static_cast<const int32_t*>(values)[i]);
+  }
+  template<typename T>
+  static void GetBatchValue(const void* values, int i, T* v) {
+    *v = static_cast<const T*>(values)[i];
+    v->is_null = false;
+  }
+
   /// Template function to execute a UDF and validate the result. They should be
   /// used like:
   /// ValidateUdf(udf_fn, arg1, arg2, ..., expected_result);
@@ -286,6 +389,40 @@ class UdfTestHarness {
     return Validate(context.get(), expected, ret);
   }
 
+  /// Template functions to execute the batch entry point of a UDF and validate the
+  /// results. The batch entry point must be registered by 'prepare_fn'. The UDF is run
+  /// on one batch with a row for each value of 'expected', where the arguments of row i
+  /// are a1[i], a2[i], ... They should be used like:
+  /// ValidateBatchUdf(arg1_values, arg2_values, expected_results, prepare_fn);
+  template<typename RET, typename A1>
+  static bool ValidateBatchUdf(const std::vector<A1>& a1,
+      const std::vector<RET>& expected, UdfPrepare prepare_fn, UdfClose close_fn = NULL,
+      const std::vector<AnyVal*>& constant_args = std::vector<AnyVal*>()) {
+    FunctionContext::TypeDesc return_type; // TODO
+    std::vector<FunctionContext::TypeDesc> arg_types; // TODO
+    boost::scoped_ptr<FunctionContext> context(CreateTestContext(return_type, arg_types));
+    SetConstantArgs(context.get(), constant_args);
+    if (!RunPrepareFn(prepare_fn, context.get())) return false;
+    BatchColumn<A1> col1(a1);
+    BatchVal args[] = { col1.val() };
+    return RunBatchFn(context.get(), close_fn, args, expected);
+  }
+
+  template<typename RET, typename A1, typename A2>
+  static bool ValidateBatchUdf(const std::vector<A1>& a1, const std::vector<A2>& a2,
+      const std::vector<RET>& expected, UdfPrepare prepare_fn, UdfClose close_fn = NULL,
+      const std::vector<AnyVal*>& constant_args = std::vector<AnyVal*>()) {
+    FunctionContext::TypeDesc return_type; // TODO
+    std::vector<FunctionContext::TypeDesc> arg_types; // TODO
+    boost::scoped_ptr<FunctionContext> context(CreateTestContext(return_type, arg_types));
+    SetConstantArgs(context.get(), constant_args);
+    if (!RunPrepareFn(prepare_fn, context.get())) return false;
+    BatchColumn<A1> col1(a1);
+    BatchColumn<A2> col2(a2);
+    BatchVal args[] = { col1.val(), col2.val() };
+    return RunBatchFn(context.get(), close_fn, args, expected);
+  }
+
  private:
   static bool ValidateError(FunctionContext* context) {
     if (context->has_error()) {
@@ -309,6 +446,36 @@ class UdfTestHarness {
     return valid;
   }
 
+  /// Calls the batch entry point of 'context' with 'args' and validates the results
+  /// against 'expected'.
+  template<typename RET>
+  static bool RunBatchFn(FunctionContext* context, UdfClose close_fn,
+      const BatchVal* args, const std::vector<RET>& expected) {
+    UdfBatchFn batch_fn = GetBatchFunction(context);
+    bool valid = true;
+    if (batch_fn == NULL) {
+      std::cerr << "UDF did not register a batch function" << std::endl;
+      valid = false;
+    } else {
+      BatchColumn<RET> result((std::vector<RET>(expected.size())));
+      batch_fn(context, expected.size(), args, result.mutable_val());
+      for (int i = 0; i < expected.size(); ++i) {
+        RET actual = result.Get(i);
+        if (!context->has_error() && actual != expected[i]) {
+          std::cerr << "UDF did not return the correct result for row " << i << ":"
+                    << std::endl
+                    << "  Expected: " << DebugString(expected[i]) << std::endl
+                    << "  Actual: " << DebugString(actual) << std::endl;
+          valid = false;
+        }
+      }
+    }
+    RunCloseFn(close_fn, context);
+    CloseContext(context);
+    if (!ValidateError(context)) valid = false;
+    return valid;
+  }
+
   static bool RunPrepareFn(UdfPrepare prepare_fn, FunctionContext* context) {
     if (prepare_fn != NULL) {
       // TODO: FRAGMENT_LOCAL
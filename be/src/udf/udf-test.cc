@@ -186,6 +186,47 @@ void ValidateSharedStateClose(
   }
 }
 
+BigIntVal AddUdf(FunctionContext* context, const BigIntVal& a, const IntVal& b) {
+  if (a.is_null || b.is_null) return BigIntVal::null();
+  return BigIntVal(a.val + b.val);
+}
+
+void AddBatchUdf(FunctionContext* context, int num_rows, const BatchVal* args,
+    BatchVal* result) {
+  const int64_t* a = args[0].Values<int64_t>();
+  const int32_t* b = args[1].Values<int32_t>();
+  int64_t* sums = result->Values<int64_t>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (args[0].IsNull(i) || args[1].IsNull(i)) {
+      result->SetNull(i);
+    } else {
+      sums[i] = a[i] + b[i];
+    }
+  }
+}
+
+void AddBatchUdfPrepare(
+    FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+  if (scope == FunctionContext::THREAD_LOCAL) context->SetBatchFunction(AddBatchUdf);
+}
+
+void LengthBatchUdf(FunctionContext* context, int num_rows, const BatchVal* args,
+    BatchVal* result) {
+  const StringVal* strs = args[0].Values<StringVal>();
+  for (int i = 0; i < num_rows; ++i) {
+    if (args[0].IsNull(i)) {
+      result->SetNull(i);
+    } else {
+      result->Values<int32_t>()[i] = strs[i].len;
+    }
+  }
+}
+
+void LengthBatchUdfPrepare(
+    FunctionContext* context, FunctionContext::FunctionStateScope scope) {
+  if (scope == FunctionContext::THREAD_LOCAL) context->SetBatchFunction(LengthBatchUdf);
+}
+
 TEST(UdfTest, TestFunctionContext) {
   EXPECT_TRUE(UdfTestHarness::ValidateUdf<IntVal>(ValidateUdf, IntVal::null()));
   EXPECT_FALSE(UdfTestHarness::ValidateUdf<IntVal>(ValidateFail, IntVal::null()));
@@ -217,6 +258,38 @@ TEST(UdfTest, TestValidate) {
       Min3, FloatVal::null(), FloatVal::null(), FloatVal::null(), FloatVal::null())));
 }
 
+TEST(UdfTest, TestBatchUdf) {
+  vector<BigIntVal> a;
+  vector<IntVal> b;
+  vector<BigIntVal> expected;
+  for (int i = 0; i < 20; ++i) {
+    a.push_back(i % 7 == 0 ? BigIntVal::null() : BigIntVal(i * 1000000000000LL));
+    b.push_back(i % 5 == 0 ? IntVal::null() : IntVal(-i));
+    expected.push_back(AddUdf(nullptr, a.back(), b.back()));
+  }
+  EXPECT_TRUE((UdfTestHarness::ValidateBatchUdf<BigIntVal, BigIntVal, IntVal>(
+      a, b, expected, AddBatchUdfPrepare)));
+  expected[3] = BigIntVal(1);
+  EXPECT_FALSE((UdfTestHarness::ValidateBatchUdf<BigIntVal, BigIntVal, IntVal>(
+      a, b, expected, AddBatchUdfPrepare)));
+  // Fails if the prepare function does not register a batch entry point.
+  EXPECT_FALSE((UdfTestHarness::ValidateBatchUdf<BigIntVal, BigIntVal, IntVal>(
+      a, b, expected, NULL)));
+
+  vector<StringVal> strs;
+  strs.push_back(StringVal("abc"));
+  strs.push_back(StringVal::null());
+  strs.push_back(StringVal(""));
+  strs.push_back(StringVal("hello world"));
+  vector<IntVal> lengths;
+  lengths.push_back(IntVal(3));
+  lengths.push_back(IntVal::null());
+  lengths.push_back(IntVal(0));
+  lengths.push_back(IntVal(11));
+  EXPECT_TRUE((UdfTestHarness::ValidateBatchUdf<IntVal, StringVal>(
+      strs, lengths, LengthBatchUdfPrepare)));
+}
+
 TEST(UdfTest, TestTimestampVal) {
   date d(2003, 3, 15);
   TimestampVal t1(*(int32_t*)&d);
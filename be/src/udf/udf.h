@@ -61,6 +61,7 @@ struct BigIntVal;
 struct StringVal;
 struct TimestampVal;
 struct DateVal;
+struct BatchVal;
 
 /// A FunctionContext is passed to every UDF/UDA and is the interface for the UDF to the
 /// rest of the system. It contains APIs to examine the system state, report errors and
@@ -203,6 +204,19 @@ class FunctionContext {
   void SetFunctionState(FunctionStateScope scope, void* ptr);
   void* GetFunctionState(FunctionStateScope scope) const;
 
+  /// Registers the optional batch entry point of a UDF, see UdfBatchFn below. Must be
+  /// called from the UDF's prepare function with THREAD_LOCAL scope. Impala may then
+  /// evaluate the UDF with 'fn' instead of the row-at-a-time function.
+  void SetBatchFunction(
+      void (*fn)(FunctionContext*, int, const BatchVal*, BatchVal*));
+
+  /// Registers the optional batch entry point of a UDA's update function, see
+  /// UdaBatchUpdate below. Must be called from the UDA's init function. Impala may then
+  /// pass several input rows to 'fn' at once instead of calling the update function for
+  /// each of them.
+  void SetBatchUpdateFunction(
+      void (*fn)(FunctionContext*, int, const BatchVal*, AnyVal*));
+
   /// Returns the return type information of this function. For UDAs, this is the final
   /// return type of the UDA (e.g., the type returned by the finalize function).
   const TypeDesc& GetReturnType() const;
@@ -337,6 +351,19 @@ typedef void (*UdfPrepare)(FunctionContext* context,
 typedef void (*UdfClose)(FunctionContext* context,
                          FunctionContext::FunctionStateScope scope);
 
+/// ------ Batch Entry Points -------
+/// ---------------------------------
+/// The UDF can optionally register a batch entry point from its prepare function with
+/// FunctionContext::SetBatchFunction(). It evaluates the UDF for 'num_rows' rows at
+/// once: 'args' holds one BatchVal per argument and the function writes the results
+/// to 'result', which has room for 'num_rows' values. The null bitmap of 'result' is
+/// cleared by the caller, so the function only has to mark the NULL results. The
+/// values of the arguments and results have the same lifetime as for the row-at-a-time
+/// function, which must still be implemented and must return the same results. Variadic
+/// UDFs cannot have batch entry points.
+typedef void (*UdfBatchFn)(FunctionContext* context, int num_rows,
+    const BatchVal* args, BatchVal* result);
+
 //----------------------------------------------------------------------------
 //------------------------------- UDAs ---------------------------------------
 //----------------------------------------------------------------------------
@@ -394,6 +421,13 @@ typedef void (*UdaUpdate)(FunctionContext* context, const InputType& input,
 typedef void (*UdaUpdate2)(FunctionContext* context, const InputType& input,
     const InputType2& input2, IntermediateType* result);
 
+/// The batch version of the update function, which the UDA can register from its init
+/// function with FunctionContext::SetBatchUpdateFunction(). It must have the same
+/// effect as calling the update function for each of the 'num_rows' rows of 'args',
+/// which holds one BatchVal per input argument.
+typedef void (*UdaBatchUpdate)(FunctionContext* context, int num_rows,
+    const BatchVal* args, IntermediateType* result);
+
 /// Merge an intermediate result 'src' into 'dst'.
 typedef void (*UdaMerge)(FunctionContext* context, const IntermediateType& src,
     IntermediateType* dst);
@@ -737,6 +771,29 @@ struct DecimalVal : public impala_udf::AnyVal {
   }
 };
 
+/// A column of values that is passed to or returned from the batch entry points of
+/// UDFs and UDAs. 'values' points to an array with one value per row and 'nulls' to a
+/// bitmap in which bit (i % 8) of byte (i / 8) is set if the value of row i is NULL.
+/// The value of a NULL row is undefined. The values are stored as:
+///   BOOLEAN: bool, TINYINT: int8_t, SMALLINT: int16_t, INT: int32_t,
+///   BIGINT: int64_t, FLOAT: float, DOUBLE: double,
+///   DATE: int32_t (days since the epoch, as in DateVal),
+///   STRING, VARCHAR, CHAR: StringVal, TIMESTAMP: TimestampVal, DECIMAL: DecimalVal.
+/// The 'is_null' field of StringVal, TimestampVal and DecimalVal values is not used;
+/// only the bitmap tells whether a value is NULL.
+struct BatchVal {
+  void* values;
+  uint8_t* nulls;
+
+  BatchVal() : values(NULL), nulls(NULL) {}
+
+  template <typename T>
+  T* Values() const { return reinterpret_cast<T*>(values); }
+
+  bool IsNull(int i) const { return (nulls[i >> 3] >> (i & 7)) & 1; }
+  void SetNull(int i) { nulls[i >> 3] |= 1 << (i & 7); }
+};
+
 typedef uint8_t* BufferVal;
 
 }
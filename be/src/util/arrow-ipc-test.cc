@@ -0,0 +1,131 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstring>
+
+#include "gen-cpp/ArrowIpc_generated.h"
+#include "testutil/gtest-util.h"
+#include "util/arrow-ipc.h"
+
+#include "common/names.h"
+
+namespace fb = org::apache::impala::fb::arrow;
+
+namespace impala {
+
+TEST(ArrowIpc, Column) {
+  ArrowColumn ints("i", ArrowColumn::INT32);
+  ints.AppendFixed<int32_t>(1);
+  ints.AppendNull();
+  ints.AppendFixed<int32_t>(3);
+  EXPECT_EQ(3, ints.num_rows());
+  EXPECT_EQ(1, ints.null_count());
+  EXPECT_EQ(string("\x05", 1), ints.validity());
+  EXPECT_EQ(12, ints.values().size());
+  EXPECT_EQ(1 + 12, ints.ByteSize(0, 3));
+
+  ArrowColumn strings("s", ArrowColumn::UTF8);
+  strings.AppendString("ab", 2);
+  strings.AppendNull();
+  strings.AppendString("cde", 3);
+  EXPECT_EQ((vector<int64_t>{0, 2, 2, 5}), strings.offsets());
+  EXPECT_EQ("abcde", strings.values());
+
+  ArrowColumn copy("s", ArrowColumn::UTF8);
+  copy.AppendRows(strings, 1, 2);
+  EXPECT_EQ((vector<int64_t>{0, 0, 3}), copy.offsets());
+  EXPECT_EQ("cde", copy.values());
+  EXPECT_EQ(1, copy.null_count());
+  EXPECT_EQ(string("\x02", 1), copy.validity());
+
+  ArrowColumn bools("b", ArrowColumn::BOOL);
+  for (int i = 0; i < 10; ++i) bools.AppendBool(i % 3 == 0);
+  EXPECT_EQ(string("\x49\x02", 2), bools.values());
+  bools.Clear();
+  EXPECT_EQ(0, bools.num_rows());
+  EXPECT_TRUE(bools.values().empty());
+}
+
+/// Returns the message at 'offset' in 'stream' and sets 'offset' to the next message.
+static const fb::Message* ReadMessage(const string& stream, int64_t* offset) {
+  uint32_t marker;
+  int32_t metadata_len;
+  memcpy(&marker, stream.data() + *offset, sizeof(marker));
+  memcpy(&metadata_len, stream.data() + *offset + 4, sizeof(metadata_len));
+  EXPECT_EQ(0xFFFFFFFF, marker);
+  EXPECT_EQ(0, (8 + metadata_len) % 8);
+  const uint8_t* metadata = reinterpret_cast<const uint8_t*>(stream.data() + *offset + 8);
+  flatbuffers::Verifier verifier(metadata, metadata_len);
+  EXPECT_TRUE(fb::VerifyMessageBuffer(verifier));
+  const fb::Message* message = fb::GetMessage(metadata);
+  *offset += 8 + metadata_len + message->bodyLength();
+  return message;
+}
+
+TEST(ArrowIpc, Stream) {
+  vector<ArrowColumn> columns;
+  columns.emplace_back("i", ArrowColumn::INT64);
+  columns.emplace_back("s", ArrowColumn::UTF8);
+  columns.emplace_back("d", ArrowColumn::DECIMAL128, 10, 2);
+  for (int i = 0; i < 5; ++i) {
+    columns[0].AppendFixed<int64_t>(i);
+    columns[1].AppendString("x", i % 2);
+    columns[2].AppendFixed<__int128>(i * 100);
+  }
+  string stream;
+  WriteArrowIpcStream(columns, &stream);
+  EXPECT_EQ(0, stream.size() % 8);
+
+  int64_t offset = 0;
+  const fb::Message* schema_msg = ReadMessage(stream, &offset);
+  ASSERT_EQ(fb::MessageHeader_Schema, schema_msg->header_type());
+  const fb::Schema* schema = schema_msg->header_as_Schema();
+  ASSERT_EQ(3, schema->fields()->size());
+  EXPECT_EQ("s", schema->fields()->Get(1)->name()->str());
+  EXPECT_EQ(fb::Type_LargeUtf8, schema->fields()->Get(1)->type_type());
+  const fb::Decimal* decimal = schema->fields()->Get(2)->type_as_Decimal();
+  ASSERT_NE(nullptr, decimal);
+  EXPECT_EQ(10, decimal->precision());
+  EXPECT_EQ(2, decimal->scale());
+
+  const int64_t batch_offset = offset;
+  const fb::Message* batch_msg = ReadMessage(stream, &offset);
+  ASSERT_EQ(fb::MessageHeader_RecordBatch, batch_msg->header_type());
+  const fb::RecordBatch* batch = batch_msg->header_as_RecordBatch();
+  EXPECT_EQ(5, batch->length());
+  EXPECT_EQ(3, batch->nodes()->size());
+  // Validity and values for the fixed-width columns, validity, offsets and values for
+  // the string column.
+  ASSERT_EQ(7, batch->buffers()->size());
+  for (const fb::Buffer* buffer : *batch->buffers()) {
+    EXPECT_EQ(0, buffer->offset() % 8);
+    EXPECT_LE(buffer->offset() + buffer->length(), batch_msg->bodyLength());
+  }
+  // The values of the integer column follow its validity buffer in the body.
+  const int64_t body_offset = offset - batch_msg->bodyLength();
+  EXPECT_GT(body_offset, batch_offset);
+  int64_t value;
+  memcpy(&value, stream.data() + body_offset + batch->buffers()->Get(1)->offset() + 24,
+      sizeof(value));
+  EXPECT_EQ(3, value);
+
+  // The end-of-stream marker.
+  ASSERT_EQ(offset + 8, stream.size());
+  EXPECT_EQ(string("\xFF\xFF\xFF\xFF\0\0\0\0", 8), stream.substr(offset));
+}
+
+}
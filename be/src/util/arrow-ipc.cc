@@ -0,0 +1,268 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/arrow-ipc.h"
+
+#include <cstring>
+
+#include "common/logging.h"
+#include "gen-cpp/ArrowIpc_generated.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace fb = org::apache::impala::fb::arrow;
+
+namespace impala {
+
+/// Arrow requires buffers and messages to be padded to a multiple of 8 bytes.
+static const int ARROW_ALIGNMENT = 8;
+
+/// Marks the start of a message and, followed by a zero length, the end of a stream.
+static const uint32_t CONTINUATION_MARKER = 0xFFFFFFFF;
+
+static int GetFixedWidth(ArrowColumn::Type type) {
+  switch (type) {
+    case ArrowColumn::INT8: return 1;
+    case ArrowColumn::INT16: return 2;
+    case ArrowColumn::INT32:
+    case ArrowColumn::FLOAT:
+    case ArrowColumn::DATE32:
+      return 4;
+    case ArrowColumn::INT64:
+    case ArrowColumn::DOUBLE:
+    case ArrowColumn::TIMESTAMP_MICROS:
+      return 8;
+    case ArrowColumn::DECIMAL128: return 16;
+    default: return 0;
+  }
+}
+
+static inline bool GetBit(const string& bitmap, int64_t idx) {
+  return (bitmap[idx / 8] >> (idx % 8)) & 1;
+}
+
+/// Appends bit 'idx' with 'value' to 'bitmap', which must have exactly 'idx' bits.
+static inline void AppendBit(int64_t idx, bool value, string* bitmap) {
+  if (idx % 8 == 0) bitmap->push_back(0);
+  if (value) bitmap->back() |= 1 << (idx % 8);
+}
+
+ArrowColumn::ArrowColumn(string name, Type type, int precision, int scale)
+  : name_(move(name)), type_(type), precision_(precision), scale_(scale),
+    fixed_width_(GetFixedWidth(type)) {
+  if (is_variable_width()) offsets_.push_back(0);
+}
+
+void ArrowColumn::AppendValidity(bool is_valid) {
+  AppendBit(num_rows_, is_valid, &validity_);
+  if (!is_valid) ++null_count_;
+}
+
+void ArrowColumn::AppendNull() {
+  if (type_ == BOOL) {
+    AppendBit(num_rows_, false, &values_);
+  } else if (is_variable_width()) {
+    offsets_.push_back(values_.size());
+  } else {
+    values_.append(fixed_width_, '\0');
+  }
+  AppendValidity(false);
+  ++num_rows_;
+}
+
+void ArrowColumn::AppendBool(bool value) {
+  DCHECK_EQ(type_, BOOL);
+  AppendBit(num_rows_, value, &values_);
+  AppendValidity(true);
+  ++num_rows_;
+}
+
+void ArrowColumn::AppendFixedBytes(const void* value, int len) {
+  DCHECK_EQ(len, fixed_width_);
+  values_.append(reinterpret_cast<const char*>(value), len);
+  AppendValidity(true);
+  ++num_rows_;
+}
+
+void ArrowColumn::AppendString(const char* ptr, int64_t len) {
+  DCHECK(is_variable_width());
+  values_.append(ptr, len);
+  offsets_.push_back(values_.size());
+  AppendValidity(true);
+  ++num_rows_;
+}
+
+void ArrowColumn::AppendRows(const ArrowColumn& other, int64_t start_idx,
+    int64_t num_rows) {
+  DCHECK_EQ(type_, other.type_);
+  DCHECK_LE(start_idx + num_rows, other.num_rows_);
+  for (int64_t i = start_idx; i < start_idx + num_rows; ++i) {
+    if (!GetBit(other.validity_, i)) {
+      AppendNull();
+    } else if (type_ == BOOL) {
+      AppendBool(GetBit(other.values_, i));
+    } else if (is_variable_width()) {
+      AppendString(other.values_.data() + other.offsets_[i],
+          other.offsets_[i + 1] - other.offsets_[i]);
+    } else {
+      AppendFixedBytes(other.values_.data() + i * fixed_width_, fixed_width_);
+    }
+  }
+}
+
+int64_t ArrowColumn::ByteSize(int64_t start_idx, int64_t num_rows) const {
+  DCHECK_LE(start_idx + num_rows, num_rows_);
+  // One validity bit per row.
+  int64_t bytes = BitUtil::Ceil(num_rows, 8);
+  if (type_ == BOOL) {
+    bytes += BitUtil::Ceil(num_rows, 8);
+  } else if (is_variable_width()) {
+    bytes += num_rows * sizeof(int64_t)
+        + offsets_[start_idx + num_rows] - offsets_[start_idx];
+  } else {
+    bytes += num_rows * fixed_width_;
+  }
+  return bytes;
+}
+
+void ArrowColumn::Clear() {
+  num_rows_ = 0;
+  null_count_ = 0;
+  validity_.clear();
+  values_.clear();
+  offsets_.clear();
+  if (is_variable_width()) offsets_.push_back(0);
+}
+
+/// Returns the Arrow type of 'column' in 'type' and its type table.
+static flatbuffers::Offset<void> CreateFbType(const ArrowColumn& column,
+    flatbuffers::FlatBufferBuilder* fbb, fb::Type* type) {
+  switch (column.type()) {
+    case ArrowColumn::BOOL:
+      *type = fb::Type_Bool;
+      return fb::CreateBool(*fbb).Union();
+    case ArrowColumn::INT8:
+    case ArrowColumn::INT16:
+    case ArrowColumn::INT32:
+    case ArrowColumn::INT64:
+      *type = fb::Type_Int;
+      return fb::CreateInt(*fbb, column.fixed_width() * 8, /* is_signed */ true).Union();
+    case ArrowColumn::FLOAT:
+      *type = fb::Type_FloatingPoint;
+      return fb::CreateFloatingPoint(*fbb, fb::Precision_SINGLE).Union();
+    case ArrowColumn::DOUBLE:
+      *type = fb::Type_FloatingPoint;
+      return fb::CreateFloatingPoint(*fbb, fb::Precision_DOUBLE).Union();
+    case ArrowColumn::DECIMAL128:
+      *type = fb::Type_Decimal;
+      return fb::CreateDecimal(*fbb, column.precision(), column.scale(), 128).Union();
+    case ArrowColumn::DATE32:
+      *type = fb::Type_Date;
+      return fb::CreateDate(*fbb, fb::DateUnit_DAY).Union();
+    case ArrowColumn::TIMESTAMP_MICROS:
+      *type = fb::Type_Timestamp;
+      return fb::CreateTimestamp(*fbb, fb::TimeUnit_MICROSECOND).Union();
+    case ArrowColumn::UTF8:
+      *type = fb::Type_LargeUtf8;
+      return fb::CreateLargeUtf8(*fbb).Union();
+    case ArrowColumn::BINARY:
+      *type = fb::Type_LargeBinary;
+      return fb::CreateLargeBinary(*fbb).Union();
+  }
+  DCHECK(false) << "Unknown type " << column.type();
+  return flatbuffers::Offset<void>();
+}
+
+/// Appends a message with the metadata in 'fbb' and 'body' to 'out'. The metadata is
+/// padded, so that the body starts at a multiple of 8 bytes.
+static void AppendMessage(const flatbuffers::FlatBufferBuilder& fbb, const string& body,
+    string* out) {
+  const int64_t prefix_len = sizeof(CONTINUATION_MARKER) + sizeof(int32_t);
+  const int32_t metadata_len =
+      BitUtil::RoundUp(prefix_len + fbb.GetSize(), ARROW_ALIGNMENT) - prefix_len;
+  out->append(reinterpret_cast<const char*>(&CONTINUATION_MARKER), sizeof(uint32_t));
+  out->append(reinterpret_cast<const char*>(&metadata_len), sizeof(metadata_len));
+  out->append(reinterpret_cast<const char*>(fbb.GetBufferPointer()), fbb.GetSize());
+  out->append(metadata_len - fbb.GetSize(), '\0');
+  DCHECK_EQ(body.size() % ARROW_ALIGNMENT, 0);
+  out->append(body);
+}
+
+/// Appends 'buffer' to 'body', padded to a multiple of 8 bytes, and its location in
+/// 'body' to 'buffers'.
+static void AppendBuffer(const char* buffer, int64_t len, string* body,
+    vector<fb::Buffer>* buffers) {
+  buffers->emplace_back(body->size(), len);
+  body->append(buffer, len);
+  body->append(BitUtil::RoundUp(len, ARROW_ALIGNMENT) - len, '\0');
+}
+
+void WriteArrowIpcStream(const vector<ArrowColumn>& columns, string* out) {
+  DCHECK(!columns.empty());
+  const int64_t num_rows = columns[0].num_rows();
+
+  // The schema.
+  {
+    flatbuffers::FlatBufferBuilder fbb;
+    vector<flatbuffers::Offset<fb::Field>> fields;
+    for (const ArrowColumn& column : columns) {
+      auto name = fbb.CreateString(column.name());
+      fb::Type type_type;
+      auto type = CreateFbType(column, &fbb, &type_type);
+      // Readers require the children of primitive fields to be set.
+      auto children = fbb.CreateVector(vector<flatbuffers::Offset<fb::Field>>());
+      fields.push_back(fb::CreateField(fbb, name, /* nullable */ true, type_type, type,
+          /* dictionary */ 0, children));
+    }
+    auto schema =
+        fb::CreateSchema(fbb, fb::Endianness_Little, fbb.CreateVector(fields));
+    fbb.Finish(fb::CreateMessage(fbb, fb::MetadataVersion_V5, fb::MessageHeader_Schema,
+        schema.Union(), /* bodyLength */ 0));
+    AppendMessage(fbb, "", out);
+  }
+
+  // The record batch. Every column has a validity buffer, followed by the offsets for
+  // variable-width types, followed by the values.
+  {
+    string body;
+    vector<fb::FieldNode> nodes;
+    vector<fb::Buffer> buffers;
+    for (const ArrowColumn& column : columns) {
+      DCHECK_EQ(column.num_rows(), num_rows);
+      nodes.emplace_back(num_rows, column.null_count());
+      AppendBuffer(column.validity().data(), column.validity().size(), &body, &buffers);
+      if (column.is_variable_width()) {
+        AppendBuffer(reinterpret_cast<const char*>(column.offsets().data()),
+            column.offsets().size() * sizeof(int64_t), &body, &buffers);
+      }
+      AppendBuffer(column.values().data(), column.values().size(), &body, &buffers);
+    }
+    flatbuffers::FlatBufferBuilder fbb;
+    auto record_batch = fb::CreateRecordBatch(fbb, num_rows,
+        fbb.CreateVectorOfStructs(nodes), fbb.CreateVectorOfStructs(buffers));
+    fbb.Finish(fb::CreateMessage(fbb, fb::MetadataVersion_V5,
+        fb::MessageHeader_RecordBatch, record_batch.Union(), body.size()));
+    AppendMessage(fbb, body, out);
+  }
+
+  // The end of the stream.
+  const uint32_t eos[] = {CONTINUATION_MARKER, 0};
+  out->append(reinterpret_cast<const char*>(eos), sizeof(eos));
+}
+
+}
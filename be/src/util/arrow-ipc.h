@@ -0,0 +1,125 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace impala {
+
+/// A nullable column of an Arrow record batch that values are appended to. Values are
+/// stored in the Arrow columnar layout, so that a record batch can be written without
+/// further conversion.
+/// https://arrow.apache.org/docs/format/Columnar.html
+class ArrowColumn {
+ public:
+  /// The supported Arrow types. Variable-width types use 64-bit offsets, i.e. they are
+  /// Arrow's LargeUtf8 and LargeBinary.
+  enum Type {
+    BOOL,
+    INT8,
+    INT16,
+    INT32,
+    INT64,
+    FLOAT,
+    DOUBLE,
+    /// 128-bit decimal with the given precision and scale.
+    DECIMAL128,
+    /// Days since the epoch.
+    DATE32,
+    /// Microseconds since the epoch, without time zone.
+    TIMESTAMP_MICROS,
+    UTF8,
+    BINARY,
+  };
+
+  ArrowColumn(std::string name, Type type, int precision = 0, int scale = 0);
+
+  void AppendNull();
+  void AppendBool(bool value);
+
+  /// Appends a value of a fixed-width type. The size of 'T' must match the width of the
+  /// type, e.g. int32_t for INT32 and DATE32 and __int128 for DECIMAL128.
+  template <typename T>
+  void AppendFixed(T value) {
+    AppendFixedBytes(&value, sizeof(value));
+  }
+
+  /// Appends a value of a variable-width type.
+  void AppendString(const char* ptr, int64_t len);
+
+  /// Appends the values of rows [start_idx, start_idx + num_rows) of 'other', which must
+  /// have the same type.
+  void AppendRows(const ArrowColumn& other, int64_t start_idx, int64_t num_rows);
+
+  /// Returns the number of bytes of the values of rows [start_idx, start_idx + num_rows).
+  int64_t ByteSize(int64_t start_idx, int64_t num_rows) const;
+
+  /// Discards all values.
+  void Clear();
+
+  const std::string& name() const { return name_; }
+  Type type() const { return type_; }
+  int precision() const { return precision_; }
+  int scale() const { return scale_; }
+  int64_t num_rows() const { return num_rows_; }
+  int64_t null_count() const { return null_count_; }
+
+  /// Returns the width of the values in bytes, or 0 for BOOL and variable-width types.
+  int fixed_width() const { return fixed_width_; }
+  bool is_variable_width() const { return type_ == UTF8 || type_ == BINARY; }
+
+  /// The Arrow buffers of the column. 'offsets' is only used for variable-width types
+  /// and contains num_rows() + 1 entries.
+  const std::string& validity() const { return validity_; }
+  const std::vector<int64_t>& offsets() const { return offsets_; }
+  const std::string& values() const { return values_; }
+
+ private:
+  void AppendFixedBytes(const void* value, int len);
+
+  /// Appends the validity bit of a new row.
+  void AppendValidity(bool is_valid);
+
+  const std::string name_;
+  const Type type_;
+  const int precision_;
+  const int scale_;
+  const int fixed_width_;
+  int64_t num_rows_ = 0;
+  int64_t null_count_ = 0;
+
+  /// Bitmap with one bit per row, least significant bit first, set for non-null values.
+  std::string validity_;
+
+  /// Offsets of the values of variable-width types into 'values_'.
+  std::vector<int64_t> offsets_;
+
+  /// The values. A bitmap like 'validity_' for BOOL.
+  std::string values_;
+};
+
+/// Serializes 'columns' as an Arrow IPC stream, consisting of the schema, a single
+/// record batch with all rows of the columns and the end-of-stream marker, and appends
+/// it to 'out'. All columns must have the same number of rows. The result can be read
+/// with any Arrow IPC stream reader, e.g. pyarrow.ipc.open_stream().
+/// https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format
+void WriteArrowIpcStream(const std::vector<ArrowColumn>& columns, std::string* out);
+
+}
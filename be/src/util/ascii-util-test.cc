@@ -0,0 +1,95 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include <cctype>
+#include <string>
+
+#include "testutil/gtest-util.h"
+#include "util/ascii-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Strings with lengths around the 16 and 32 byte blocks of the kernels.
+static vector<string> TestStrings() {
+  vector<string> strings;
+  const string chars[] = {"a", "Z", " ", "@", "[", "`", "{", "\xc3\xa9", "\x80"};
+  for (int len = 0; len < 70; ++len) {
+    for (int seed = 0; seed < 20; ++seed) {
+      string str;
+      unsigned state = len * 31 + seed;
+      while (static_cast<int>(str.size()) < len) {
+        state = state * 1103515245 + 12345;
+        // Seeds 0 to 4 give ASCII strings, 5 and 6 only spaces and the rest UTF-8.
+        const int num_chars = seed < 5 ? 7 : (seed < 7 ? 1 : 9);
+        str += seed < 5 || seed >= 7 ? chars[(state >> 16) % num_chars] : " ";
+      }
+      strings.push_back(str);
+    }
+  }
+  return strings;
+}
+
+TEST(AsciiUtil, IsAscii) {
+  for (const string& str : TestStrings()) {
+    bool is_ascii = true;
+    for (char c : str) is_ascii &= static_cast<uint8_t>(c) < 0x80;
+    EXPECT_EQ(is_ascii, AsciiUtil::IsAscii(
+        reinterpret_cast<const uint8_t*>(str.data()), str.size())) << str;
+  }
+}
+
+TEST(AsciiUtil, ChangeCase) {
+  for (const string& str : TestStrings()) {
+    string upper = str;
+    string lower = str;
+    for (char& c : upper) c = toupper(static_cast<uint8_t>(c));
+    for (char& c : lower) c = tolower(static_cast<uint8_t>(c));
+    string result(str.size(), '\0');
+    AsciiUtil::ToUpper(reinterpret_cast<const uint8_t*>(str.data()), str.size(),
+        reinterpret_cast<uint8_t*>(&result[0]));
+    EXPECT_EQ(upper, result);
+    AsciiUtil::ToLower(reinterpret_cast<const uint8_t*>(str.data()), str.size(),
+        reinterpret_cast<uint8_t*>(&result[0]));
+    EXPECT_EQ(lower, result);
+  }
+}
+
+TEST(AsciiUtil, CountUtf8Chars) {
+  for (const string& str : TestStrings()) {
+    int64_t expected = 0;
+    for (char c : str) expected += BitUtil::IsUtf8StartByte(c);
+    EXPECT_EQ(expected, AsciiUtil::CountUtf8Chars(
+        reinterpret_cast<const uint8_t*>(str.data()), str.size())) << str;
+  }
+}
+
+TEST(AsciiUtil, CountLeadingTrailing) {
+  for (const string& str : TestStrings()) {
+    const size_t first = str.find_first_not_of(' ');
+    const size_t last = str.find_last_not_of(' ');
+    const uint8_t* ptr = reinterpret_cast<const uint8_t*>(str.data());
+    EXPECT_EQ(first == string::npos ? str.size() : first,
+        AsciiUtil::CountLeading(ptr, str.size(), ' ')) << str;
+    EXPECT_EQ(last == string::npos ? str.size() : str.size() - last - 1,
+        AsciiUtil::CountTrailing(ptr, str.size(), ' ')) << str;
+  }
+}
+
+} // namespace impala
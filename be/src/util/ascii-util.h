@@ -0,0 +1,124 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#pragma once
+
+#include <cstdint>
+
+#include "util/bit-util.h"
+#include "util/sse-util.h"
+
+namespace impala {
+
+/// Kernels for ASCII and UTF-8 strings that process 16 bytes at a time with SSE2, which
+/// is translated to NEON on aarch64, and the remaining bytes one at a time.
+class AsciiUtil {
+ public:
+  /// Returns true if all 'len' bytes at 'ptr' are ASCII, i.e. have the high bit unset.
+  static inline bool IsAscii(const uint8_t* ptr, int64_t len) {
+    int64_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+      const __m128i v = _mm_or_si128(Load(ptr + i), Load(ptr + i + 16));
+      if (_mm_movemask_epi8(v) != 0) return false;
+    }
+    uint8_t tail = 0;
+    for (; i < len; ++i) tail |= ptr[i];
+    return tail < 0x80;
+  }
+
+  /// Writes the 'len' bytes at 'src' to 'dst' with 'a' to 'z' mapped to 'A' to 'Z' and
+  /// all other bytes unchanged, like ::toupper() in the C locale. 'dst' may be 'src'.
+  static inline void ToUpper(const uint8_t* src, int64_t len, uint8_t* dst) {
+    FlipCase<'a', 'z'>(src, len, dst);
+  }
+
+  /// Same as ToUpper(), but maps 'A' to 'Z' to 'a' to 'z'.
+  static inline void ToLower(const uint8_t* src, int64_t len, uint8_t* dst) {
+    FlipCase<'A', 'Z'>(src, len, dst);
+  }
+
+  /// Returns the number of UTF-8 characters in the 'len' bytes at 'ptr', i.e. the number
+  /// of bytes that are not continuation bytes.
+  static inline int64_t CountUtf8Chars(const uint8_t* ptr, int64_t len) {
+    // Continuation bytes are 0x80 to 0xBF, the signed bytes up to -65.
+    const __m128i max_continuation = _mm_set1_epi8(static_cast<char>(0xBF));
+    int64_t count = 0;
+    int64_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+      const int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(Load(ptr + i), max_continuation));
+      count += BitUtil::Popcount(static_cast<uint64_t>(mask));
+    }
+    for (; i < len; ++i) count += BitUtil::IsUtf8StartByte(ptr[i]);
+    return count;
+  }
+
+  /// Returns the number of bytes equal to 'c' at the start of the 'len' bytes at 'ptr'.
+  static inline int64_t CountLeading(const uint8_t* ptr, int64_t len, uint8_t c) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(c));
+    int64_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+      const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(Load(ptr + i), needle));
+      if (mask != 0xFFFF) return i + BitUtil::CountTrailingZeros(~mask & 0xFFFFu);
+    }
+    while (i < len && ptr[i] == c) ++i;
+    return i;
+  }
+
+  /// Returns the number of bytes equal to 'c' at the end of the 'len' bytes at 'ptr'.
+  static inline int64_t CountTrailing(const uint8_t* ptr, int64_t len, uint8_t c) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(c));
+    int64_t n = 0;
+    for (; n + 16 <= len; n += 16) {
+      const int mask =
+          _mm_movemask_epi8(_mm_cmpeq_epi8(Load(ptr + len - n - 16), needle));
+      // Bit 15 is the last byte, so the leading ones of the mask are the matches.
+      if (mask != 0xFFFF) return n + __builtin_clz((~mask & 0xFFFFu) << 16);
+    }
+    while (n < len && ptr[len - 1 - n] == c) ++n;
+    return n;
+  }
+
+ private:
+  static inline __m128i Load(const uint8_t* ptr) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+  }
+
+  /// Writes the 'len' bytes at 'src' to 'dst' with the case of the bytes from FIRST to
+  /// LAST flipped.
+  template <char FIRST, char LAST>
+  static inline void FlipCase(const uint8_t* src, int64_t len, uint8_t* dst) {
+    // Bytes of 0x80 and above are negative and so never in the range.
+    const __m128i below = _mm_set1_epi8(FIRST - 1);
+    const __m128i above = _mm_set1_epi8(LAST + 1);
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    int64_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+      const __m128i v = Load(src + i);
+      const __m128i in_range =
+          _mm_and_si128(_mm_cmpgt_epi8(v, below), _mm_cmplt_epi8(v, above));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+          _mm_xor_si128(v, _mm_and_si128(in_range, case_bit)));
+    }
+    for (; i < len; ++i) {
+      const uint8_t c = src[i];
+      dst[i] = c >= FIRST && c <= LAST ? c ^ 0x20 : c;
+    }
+  }
+};
+
+} // namespace impala
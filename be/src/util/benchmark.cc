@@ -15,24 +15,126 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <unistd.h>
 
+#include <gflags/gflags.h>
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/debug-util.h"
+#include "util/error-util.h"
 #include "util/stopwatch.h"
 
 #include "common/names.h"
 
+DEFINE_int32(benchmark_repetitions, 60, "Number of times that every benchmark is "
+    "measured. The 10th, 50th and 90th percentile of the measured rates are reported.");
+DEFINE_bool(benchmark_perf_counters, false, "If true, the benchmarks also count CPU "
+    "cycles, instructions, cache misses and branch misses with perf_event_open(). This "
+    "requires a kernel.perf_event_paranoid setting of at most 2.");
+DEFINE_string(benchmark_json_output, "", "If not empty, the results of every benchmark "
+    "suite are appended to this file as a line of JSON.");
+
 namespace impala {
 
+namespace {
+
+// Counts hardware events in user space of the calling thread with perf_event_open().
+// The events are opened as one group, so they are always counted over the same
+// intervals.
+class HardwareCounters {
+ public:
+  enum Event { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, NUM_EVENTS };
+
+  HardwareCounters() {
+    static const uint64_t CONFIGS[NUM_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < NUM_EVENTS; ++i) {
+      struct perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = CONFIGS[i];
+      // The members of the group are enabled and disabled with the leader.
+      attr.disabled = i == 0;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_GROUP;
+      const int group_fd = i == 0 ? -1 : fds_[0];
+      fds_[i] = syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+      if (fds_[i] < 0) {
+        LOG_FIRST_N(WARNING, 1) << "Could not count hardware events: "
+                                << GetStrErrMsg();
+        Close();
+        return;
+      }
+    }
+  }
+
+  ~HardwareCounters() { Close(); }
+
+  bool ok() const { return fds_[0] >= 0; }
+
+  void Start() {
+    if (!ok()) return;
+    ioctl(fds_[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds_[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+
+  // Stops counting and returns the counts since Start() in 'values'. Returns false if
+  // the counts could not be read.
+  bool Stop(int64_t* values) {
+    if (!ok()) return false;
+    ioctl(fds_[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // With PERF_FORMAT_GROUP, the leader returns the number of events followed by the
+    // count of every event.
+    uint64_t buffer[NUM_EVENTS + 1];
+    const ssize_t len = read(fds_[0], buffer, sizeof(buffer));
+    if (len != static_cast<ssize_t>(sizeof(buffer))) return false;
+    DCHECK_EQ(buffer[0], static_cast<uint64_t>(NUM_EVENTS));
+    for (int i = 0; i < NUM_EVENTS; ++i) values[i] = buffer[i + 1];
+    return true;
+  }
+
+ private:
+  void Close() {
+    for (int& fd : fds_) {
+      if (fd >= 0) close(fd);
+      fd = -1;
+    }
+  }
+
+  int fds_[NUM_EVENTS] = {-1, -1, -1, -1};
+};
+
+const char* EVENT_NAMES[HardwareCounters::NUM_EVENTS] = {
+    "cycles", "instructions", "cache-misses", "branch-misses"};
+
+// Returns the index of the 'percent' percentile of 'num_values' sorted values.
+size_t PercentileIdx(int percent, size_t num_values) {
+  return max(0.0, floor(((percent / 100.0) * static_cast<double>(num_values)) - 0.5));
+}
+
+}
+
 // Private measurement function.  This function is a bit unusual in that it
 // throws exceptions; the intention is to abort the measurement when an unreliable
 // result is detected, but to also provide some useful context as to which benchmark
@@ -40,8 +142,24 @@ namespace impala {
 // is detecting context switches using getrusage().  Pass micro_heuristics=false to
 // the class constructor if you do not want this behavior.
 double Benchmark::Measure(BenchmarkFunction function, void* args,
-    int max_time, int batch_size, bool micro_heuristics) {
+    int max_time, int batch_size, bool micro_heuristics, EventCounts* events) {
   int64_t target_cycles = CpuInfo::cycles_per_ms() * max_time;
+  unique_ptr<HardwareCounters> counters;
+  if (events != nullptr) {
+    counters.reset(new HardwareCounters());
+    if (!counters->ok()) counters.reset();
+  }
+  // Adds the events counted for a batch of 'iters' invocations to 'events'.
+  auto count_events = [&](int64_t iters) {
+    int64_t values[HardwareCounters::NUM_EVENTS];
+    if (counters == nullptr || !counters->Stop(values)) return;
+    if (iters == 0) return;
+    events->counts.resize(HardwareCounters::NUM_EVENTS);
+    for (int i = 0; i < HardwareCounters::NUM_EVENTS; ++i) {
+      events->counts[i] += values[i];
+    }
+    events->iters += iters;
+  };
   int64_t iters = 0;
   struct rusage ru_start;
   struct rusage ru_stop;
@@ -53,11 +171,14 @@ double Benchmark::Measure(BenchmarkFunction function, void* args,
   for (;;) {
     int64 begin_time = sw.ElapsedTime();
     if (micro_heuristics) getrusage(RUSAGE_THREAD, &ru_start);
+    if (counters != nullptr) counters->Start();
     sw.Start();
     function(batch_size, args);
     sw.Stop();
     if (micro_heuristics) getrusage(RUSAGE_THREAD, &ru_stop);
-    if (!micro_heuristics || ru_stop.ru_nivcsw == ru_start.ru_nivcsw) {
+    const bool switched = micro_heuristics && ru_stop.ru_nivcsw != ru_start.ru_nivcsw;
+    count_events(switched ? 0 : batch_size);
+    if (!switched) {
       iters = batch_size;
       break;
     }
@@ -86,11 +207,14 @@ double Benchmark::Measure(BenchmarkFunction function, void* args,
   while (sw.ElapsedTime() < target_cycles) {
     int64 begin_time = sw.ElapsedTime();
     if (micro_heuristics) getrusage(RUSAGE_THREAD, &ru_start);
+    if (counters != nullptr) counters->Start();
     sw.Start();
     function(batch_size, args);
     sw.Stop();
     if (micro_heuristics) getrusage(RUSAGE_THREAD, &ru_stop);
-    if (!micro_heuristics || ru_stop.ru_nivcsw == ru_start.ru_nivcsw) {
+    const bool switched = micro_heuristics && ru_stop.ru_nivcsw != ru_start.ru_nivcsw;
+    count_events(switched ? 0 : batch_size);
+    if (!switched) {
       iters += batch_size;
     } else {
       // We could have a vastly different estimate for batch size now and might have
@@ -143,18 +267,15 @@ string Benchmark::Measure(int max_time, int initial_batch_size) {
   benchmarks_[0].fn(10, benchmarks_[0].args);
 
   // The number of times a benchmark is repeated
-  const int NUM_REPS = 60;
+  const int NUM_REPS = max(1, FLAGS_benchmark_repetitions);
   // Which percentiles of the benchmark to report. Reports the LO_PERCENT, MID_PERCENT,
   // and HI_PERCENT percentile result.
   const int LO_PERCENT = 10;
   const int MID_PERCENT = 50;
   const int HI_PERCENT = 100 - LO_PERCENT;
-  const size_t LO_IDX =
-      floor(((LO_PERCENT / 100.0) * static_cast<double>(NUM_REPS)) - 0.5);
-  const size_t MID_IDX =
-      floor(((MID_PERCENT / 100.0) * static_cast<double>(NUM_REPS)) - 0.5);
-  const size_t HI_IDX =
-      floor(((HI_PERCENT / 100.0) * static_cast<double>(NUM_REPS)) - 0.5);
+  const size_t LO_IDX = PercentileIdx(LO_PERCENT, NUM_REPS);
+  const size_t MID_IDX = PercentileIdx(MID_PERCENT, NUM_REPS);
+  const size_t HI_IDX = PercentileIdx(HI_PERCENT, NUM_REPS);
 
   const int function_out_width = 35;
   const int rate_out_width = 10;
@@ -170,7 +291,8 @@ string Benchmark::Measure(int max_time, int initial_batch_size) {
       for (int i = 0; i < benchmarks_.size(); ++i) {
         benchmarks_[i].rates.push_back(
             Measure(benchmarks_[i].fn, benchmarks_[i].args, max_time, initial_batch_size,
-              micro_heuristics_));
+              micro_heuristics_,
+              FLAGS_benchmark_perf_counters ? &benchmarks_[i].events : nullptr));
       }
     }
   } catch (std::exception& e) {
@@ -220,10 +342,107 @@ string Benchmark::Measure(int max_time, int initial_batch_size) {
        << (benchmarks_[i].rates[HI_IDX] / base_line_hi) << "X" << endl;
     previous_baseline_idx = benchmarks_[i].baseline_idx;
   }
+  if (FLAGS_benchmark_perf_counters) ss << endl << EventsToString();
+  if (!FLAGS_benchmark_json_output.empty()) WriteJson();
 
   return ss.str();
 }
 
+string Benchmark::EventsToString() const {
+  const int function_out_width = 35;
+  const int event_out_width = 14;
+  stringstream ss;
+  ss << name_ << ":" << setw(function_out_width - name_.size() - 1) << "Function";
+  for (const char* event_name : EVENT_NAMES) ss << setw(event_out_width) << event_name;
+  ss << setw(event_out_width) << "IPC" << endl;
+  ss << setw(function_out_width + HardwareCounters::NUM_EVENTS * event_out_width)
+     << "(per invocation)" << endl;
+  for (int i = 0; i < function_out_width + 5 * event_out_width; ++i) ss << '-';
+  ss << endl;
+  for (const BenchmarkResult& benchmark : benchmarks_) {
+    ss << setw(function_out_width) << benchmark.name;
+    const EventCounts& events = benchmark.events;
+    if (events.counts.empty()) {
+      ss << setw(event_out_width) << "n/a" << endl;
+      continue;
+    }
+    for (int64_t count : events.counts) {
+      ss << setw(event_out_width) << setprecision(4)
+         << static_cast<double>(count) / events.iters;
+    }
+    const int64_t cycles = events.counts[HardwareCounters::CYCLES];
+    ss << setw(event_out_width) << setprecision(3)
+       << (cycles == 0 ? 0.0 :
+           static_cast<double>(events.counts[HardwareCounters::INSTRUCTIONS]) / cycles)
+       << endl;
+  }
+  return ss.str();
+}
+
+void Benchmark::WriteJson() const {
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  writer.StartObject();
+  writer.String("suite");
+  writer.String(name_.c_str());
+  writer.String("machine");
+  writer.String(CpuInfo::model_name().c_str());
+  writer.String("benchmarks");
+  writer.StartArray();
+  for (const BenchmarkResult& benchmark : benchmarks_) {
+    const vector<double>& rates = benchmark.rates;
+    DCHECK(is_sorted(rates.begin(), rates.end()));
+    const vector<double>& baseline_rates = benchmarks_[benchmark.baseline_idx].rates;
+    double mean = 0;
+    for (double rate : rates) mean += rate;
+    mean /= rates.size();
+    double variance = 0;
+    for (double rate : rates) variance += (rate - mean) * (rate - mean);
+    variance /= rates.size();
+    writer.StartObject();
+    writer.String("name");
+    writer.String(benchmark.name.c_str());
+    writer.String("baseline");
+    writer.String(benchmarks_[benchmark.baseline_idx].name.c_str());
+    writer.String("repetitions");
+    writer.Int64(rates.size());
+    // Rates in invocations per ms.
+    writer.String("min");
+    writer.Double(rates.front());
+    for (int percent : {10, 50, 90}) {
+      writer.String(Substitute("p$0", percent).c_str());
+      writer.Double(rates[PercentileIdx(percent, rates.size())]);
+    }
+    writer.String("max");
+    writer.Double(rates.back());
+    writer.String("mean");
+    writer.Double(mean);
+    writer.String("stddev");
+    writer.Double(sqrt(variance));
+    writer.String("relative_p50");
+    writer.Double(rates[PercentileIdx(50, rates.size())]
+        / baseline_rates[PercentileIdx(50, baseline_rates.size())]);
+    if (!benchmark.events.counts.empty()) {
+      // Hardware events per invocation.
+      for (int i = 0; i < HardwareCounters::NUM_EVENTS; ++i) {
+        writer.String(EVENT_NAMES[i]);
+        writer.Double(
+            static_cast<double>(benchmark.events.counts[i]) / benchmark.events.iters);
+      }
+    }
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  ofstream out(FLAGS_benchmark_json_output, ios::app);
+  out << buffer.GetString() << endl;
+  if (!out.good()) {
+    LOG(WARNING) << "Could not write the results of " << name_ << " to "
+                 << FLAGS_benchmark_json_output;
+  }
+}
+
 // TODO: maybe add other things like amount of RAM, etc
 string Benchmark::GetMachineInfo() {
   stringstream ss;
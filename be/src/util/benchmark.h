@@ -19,6 +19,7 @@
 #ifndef IMPALA_UTIL_BENCHMARK_H
 #define IMPALA_UTIL_BENCHMARK_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,13 @@ namespace impala {
 ///  suite.AddBenchmark("Implementation #2", Implementation2Fn, data);
 ///  ...
 ///  string result = suite.Measure();
+///
+/// Every benchmark is measured --benchmark_repetitions times. With
+/// --benchmark_perf_counters, the harness also counts CPU cycles, instructions, cache
+/// misses and branch misses of the measured invocations with perf_event_open() and
+/// reports them per invocation after the rates. With --benchmark_json_output, the
+/// results of every suite, including the mean and standard deviation of the rates, are
+/// also appended to a file as a line of JSON, for tracking regressions across builds.
 class Benchmark {
  public:
   /// Name of the microbenchmark.  This is outputted in the result.
@@ -53,7 +61,8 @@ class Benchmark {
   int AddBenchmark(const std::string& name, BenchmarkFunction fn, void* args,
       int baseline_idx = 0);
 
-  /// Runs all the benchmarks and returns the result in a formatted string.
+  /// Runs all the benchmarks and returns the result in a formatted string. Also writes
+  /// the results to --benchmark_json_output, if set.
   /// max_time is the total time to benchmark the function, in ms.
   /// initial_batch_size is the initial batch size to the run the function.  The
   /// harness function will automatically ramp up the batch_size.  The benchmark
@@ -66,10 +75,22 @@ class Benchmark {
  private:
   friend class BenchmarkTest;
 
+  /// Hardware events counted while running a benchmark function.
+  struct EventCounts {
+    /// Number of invocations of the function while the events were counted.
+    int64_t iters = 0;
+
+    /// Total count of every event, in the order of HardwareCounters::Event. Empty if the
+    /// events could not be counted.
+    std::vector<int64_t> counts;
+  };
+
   /// Benchmarks the 'function' returning the result as invocations per ms.
   /// args is an opaque argument passed as the second argument to the function.
+  /// If 'events' is not nullptr, the hardware events of the invocations that are part of
+  /// the result are added to it.
   static double Measure(BenchmarkFunction function, void* args, int max_time,
-      int initial_batch_size, bool micro);
+      int initial_batch_size, bool micro, EventCounts* events = nullptr);
 
   struct BenchmarkResult {
     std::string name;
@@ -77,8 +98,16 @@ class Benchmark {
     void* args;
     std::vector<double> rates;
     int baseline_idx;
+    EventCounts events;
   };
 
+  /// Returns the hardware events of 'events' per invocation, formatted as a table.
+  std::string EventsToString() const;
+
+  /// Appends the results of the suite to --benchmark_json_output as a line of JSON.
+  /// The rates of all benchmarks must be sorted.
+  void WriteJson() const;
+
   std::string name_;
   std::vector<BenchmarkResult> benchmarks_;
   bool micro_heuristics_;
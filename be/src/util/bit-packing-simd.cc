@@ -0,0 +1,376 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/bit-packing-simd.h"
+
+#ifndef __aarch64__
+  #include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+
+#include <boost/preprocessor/repetition/repeat_from_to.hpp>
+
+#include "common/compiler-util.h"
+#include "common/logging.h"
+
+namespace impala {
+
+#ifndef __aarch64__
+
+namespace {
+
+constexpr int MAX_SIMD_BITWIDTH = 32;
+
+/// Control vectors for the AVX2 kernel of one bit width. A vector holds 8 values, 4 per
+/// 128-bit lane. Each lane is loaded separately so that it starts at the byte containing
+/// the first bit of its first value.
+struct Avx2UnpackMasks {
+  /// In-lane byte shuffle moving the 4 bytes starting with the first bit of each value
+  /// into the value's 32-bit lane.
+  alignas(32) int8_t bytes_lo[32];
+  /// In-lane byte shuffle moving the 5th byte of each value into the low byte of the
+  /// value's 32-bit lane. Only needed for bit widths >= 26.
+  alignas(32) int8_t bytes_hi[32];
+  /// Right shift that aligns each value with bit 0 of its lane.
+  alignas(32) int32_t shift_lo[8];
+  /// Left shift that moves the 5th byte above the bits provided by 'bytes_lo'.
+  alignas(32) int32_t shift_hi[8];
+};
+
+/// Control vectors for the AVX-512 kernel of one bit width. A vector holds 16 values,
+/// which are always contained in the first 2 * bit width bytes of the vector.
+struct Avx512UnpackMasks {
+  alignas(64) int8_t bytes_lo[64];
+  alignas(64) int8_t bytes_hi[64];
+  alignas(64) int32_t shift_lo[16];
+  alignas(64) int32_t shift_hi[16];
+};
+
+struct UnpackMaskTables {
+  Avx2UnpackMasks avx2[MAX_SIMD_BITWIDTH + 1];
+  Avx512UnpackMasks avx512[MAX_SIMD_BITWIDTH + 1];
+
+  UnpackMaskTables() {
+    // Index that makes _mm256_shuffle_epi8() write a zero byte.
+    constexpr int8_t ZERO_BYTE = -128;
+    for (int bit_width = 1; bit_width <= MAX_SIMD_BITWIDTH; ++bit_width) {
+      Avx2UnpackMasks* m2 = &avx2[bit_width];
+      for (int lane = 0; lane < 2; ++lane) {
+        const int lane_first_byte = (4 * lane * bit_width) / CHAR_BIT;
+        for (int k = 0; k < 4; ++k) {
+          const int value_idx = 4 * lane + k;
+          const int first_bit = value_idx * bit_width;
+          const int first_byte = first_bit / CHAR_BIT - lane_first_byte;
+          // Bytes that are not part of the value may be garbage but must not be
+          // taken from outside the lane.
+          for (int b = 0; b < 4; ++b) {
+            const int src = first_byte + b;
+            m2->bytes_lo[16 * lane + 4 * k + b] = src < 16 ? src : ZERO_BYTE;
+            m2->bytes_hi[16 * lane + 4 * k + b] = ZERO_BYTE;
+          }
+          const int hi_src = first_byte + 4;
+          m2->bytes_hi[16 * lane + 4 * k] = hi_src < 16 ? hi_src : ZERO_BYTE;
+          m2->shift_lo[value_idx] = first_bit % CHAR_BIT;
+          m2->shift_hi[value_idx] = 32 - first_bit % CHAR_BIT;
+        }
+      }
+
+      Avx512UnpackMasks* m5 = &avx512[bit_width];
+      for (int value_idx = 0; value_idx < 16; ++value_idx) {
+        const int first_bit = value_idx * bit_width;
+        const int first_byte = first_bit / CHAR_BIT;
+        for (int b = 0; b < 4; ++b) {
+          m5->bytes_lo[4 * value_idx + b] = std::min(first_byte + b, 63);
+          m5->bytes_hi[4 * value_idx + b] = 0;
+        }
+        m5->bytes_hi[4 * value_idx] = std::min(first_byte + 4, 63);
+        m5->shift_lo[value_idx] = first_bit % CHAR_BIT;
+        m5->shift_hi[value_idx] = 32 - first_bit % CHAR_BIT;
+      }
+    }
+  }
+};
+
+const UnpackMaskTables unpack_masks;
+
+__attribute__((target("avx2")))
+inline __m256i Load256(const void* p) {
+  return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline __m128i LoadUnaligned128(const uint8_t* p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+/// Stores 32 values held in 4 vectors of 8 32-bit values to 'out'.
+__attribute__((target("avx2")))
+inline void StoreBatchAVX2(const __m256i* v, uint32_t* out) {
+  for (int i = 0; i < 4; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * i), v[i]);
+  }
+}
+
+__attribute__((target("avx2")))
+inline void StoreBatchAVX2(const __m256i* v, uint64_t* out) {
+  for (int i = 0; i < 4; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * i),
+        _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v[i])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 8 * i + 4),
+        _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v[i], 1)));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void StoreBatchAVX2(const __m256i* v, uint16_t* out) {
+  // The packs operate within 128-bit lanes, so the 64-bit groups of 4 values end up in
+  // the order 0, 2, 1, 3 and have to be permuted back.
+  for (int i = 0; i < 2; ++i) {
+    __m256i packed = _mm256_packus_epi32(v[2 * i], v[2 * i + 1]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16 * i),
+        _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void StoreBatchAVX2(const __m256i* v, uint8_t* out) {
+  // After packing, each 128-bit lane holds groups of 4 values from every input vector.
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  __m256i packed = _mm256_packus_epi16(
+      _mm256_packus_epi32(v[0], v[1]), _mm256_packus_epi32(v[2], v[3]));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+      _mm256_permutevar8x32_epi32(packed, order));
+}
+
+template <typename OutType, int BIT_WIDTH>
+__attribute__((target("avx2")))
+int64_t UnpackBatchesAVX2(const uint8_t* __restrict__ in, int64_t in_bytes,
+    int64_t num_batches, OutType* __restrict__ out) {
+  static_assert(BIT_WIDTH >= 1 && BIT_WIDTH <= MAX_SIMD_BITWIDTH, "Invalid BIT_WIDTH");
+  // 8 values take exactly BIT_WIDTH bytes.
+  constexpr int BATCH_BYTES = 32 * BIT_WIDTH / CHAR_BIT;
+  constexpr int HIGH_LANE_OFFSET = 4 * BIT_WIDTH / CHAR_BIT;
+  constexpr bool NEEDS_HI_BYTE = BIT_WIDTH + CHAR_BIT - 1 > 32;
+  constexpr uint32_t VALUE_MASK = 0xFFFFFFFFU >> (32 - BIT_WIDTH);
+
+  if (in_bytes < SimdBitPacking::SIMD_PADDING) return 0;
+  num_batches = std::min(num_batches,
+      (in_bytes - SimdBitPacking::SIMD_PADDING) / BATCH_BYTES);
+
+  const Avx2UnpackMasks& m = unpack_masks.avx2[BIT_WIDTH];
+  const __m256i bytes_lo = Load256(m.bytes_lo);
+  const __m256i bytes_hi = Load256(m.bytes_hi);
+  const __m256i shift_lo = Load256(m.shift_lo);
+  const __m256i shift_hi = Load256(m.shift_hi);
+  const __m256i value_mask = _mm256_set1_epi32(static_cast<int32_t>(VALUE_MASK));
+
+  for (int64_t i = 0; i < num_batches; ++i) {
+    __m256i v[4];
+    for (int j = 0; j < 4; ++j) {
+      const uint8_t* group = in + j * BIT_WIDTH;
+      const __m256i bytes = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(LoadUnaligned128(group)),
+          LoadUnaligned128(group + HIGH_LANE_OFFSET), 1);
+      __m256i val = _mm256_srlv_epi32(_mm256_shuffle_epi8(bytes, bytes_lo), shift_lo);
+      if (NEEDS_HI_BYTE) {
+        val = _mm256_or_si256(val,
+            _mm256_sllv_epi32(_mm256_shuffle_epi8(bytes, bytes_hi), shift_hi));
+      }
+      v[j] = _mm256_and_si256(val, value_mask);
+    }
+    StoreBatchAVX2(v, out);
+    in += BATCH_BYTES;
+    out += 32;
+  }
+  _mm256_zeroupper();
+  return num_batches;
+}
+
+/// Stores 32 values held in 2 vectors of 16 32-bit values to 'out'.
+__attribute__((target("avx512f")))
+inline void StoreBatchAVX512(const __m512i* v, uint32_t* out) {
+  _mm512_storeu_si512(out, v[0]);
+  _mm512_storeu_si512(out + 16, v[1]);
+}
+
+__attribute__((target("avx512f")))
+inline void StoreBatchAVX512(const __m512i* v, uint64_t* out) {
+  for (int i = 0; i < 2; ++i) {
+    _mm512_storeu_si512(out + 16 * i,
+        _mm512_cvtepu32_epi64(_mm512_castsi512_si256(v[i])));
+    _mm512_storeu_si512(out + 16 * i + 8,
+        _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(v[i], 1)));
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void StoreBatchAVX512(const __m512i* v, uint16_t* out) {
+  for (int i = 0; i < 2; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 16 * i),
+        _mm512_cvtepi32_epi16(v[i]));
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void StoreBatchAVX512(const __m512i* v, uint8_t* out) {
+  for (int i = 0; i < 2; ++i) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16 * i),
+        _mm512_cvtepi32_epi8(v[i]));
+  }
+}
+
+template <typename OutType, int BIT_WIDTH>
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+int64_t UnpackBatchesAVX512(const uint8_t* __restrict__ in, int64_t in_bytes,
+    int64_t num_batches, OutType* __restrict__ out) {
+  static_assert(BIT_WIDTH >= 1 && BIT_WIDTH <= MAX_SIMD_BITWIDTH, "Invalid BIT_WIDTH");
+  // 16 values take exactly 2 * BIT_WIDTH bytes.
+  constexpr int GROUP_BYTES = 16 * BIT_WIDTH / CHAR_BIT;
+  constexpr int BATCH_BYTES = 2 * GROUP_BYTES;
+  constexpr __mmask64 LOAD_MASK = ~0ULL >> (64 - GROUP_BYTES);
+  // Selects the low byte of each 32-bit lane.
+  constexpr __mmask64 LOW_BYTE_MASK = 0x1111111111111111ULL;
+  constexpr bool NEEDS_HI_BYTE = BIT_WIDTH + CHAR_BIT - 1 > 32;
+  constexpr uint32_t VALUE_MASK = 0xFFFFFFFFU >> (32 - BIT_WIDTH);
+
+  num_batches = std::min(num_batches, in_bytes / BATCH_BYTES);
+
+  const Avx512UnpackMasks& m = unpack_masks.avx512[BIT_WIDTH];
+  const __m512i bytes_lo = _mm512_load_si512(m.bytes_lo);
+  const __m512i bytes_hi = _mm512_load_si512(m.bytes_hi);
+  const __m512i shift_lo = _mm512_load_si512(m.shift_lo);
+  const __m512i shift_hi = _mm512_load_si512(m.shift_hi);
+  const __m512i value_mask = _mm512_set1_epi32(static_cast<int32_t>(VALUE_MASK));
+
+  for (int64_t i = 0; i < num_batches; ++i) {
+    __m512i v[2];
+    for (int j = 0; j < 2; ++j) {
+      // The masked load does not touch any byte past the group.
+      const __m512i bytes = _mm512_maskz_loadu_epi8(LOAD_MASK, in + j * GROUP_BYTES);
+      __m512i val = _mm512_srlv_epi32(_mm512_permutexvar_epi8(bytes_lo, bytes), shift_lo);
+      if (NEEDS_HI_BYTE) {
+        val = _mm512_or_si512(val, _mm512_sllv_epi32(
+            _mm512_maskz_permutexvar_epi8(LOW_BYTE_MASK, bytes_hi, bytes), shift_hi));
+      }
+      v[j] = _mm512_and_si512(val, value_mask);
+    }
+    StoreBatchAVX512(v, out);
+    in += BATCH_BYTES;
+    out += 32;
+  }
+  _mm256_zeroupper();
+  return num_batches;
+}
+
+inline bool HasAvx512Vbmi() {
+  return CpuInfo::IsSupported(CpuInfo::AVX512F)
+      && CpuInfo::IsSupported(CpuInfo::AVX512BW)
+      && CpuInfo::IsSupported(CpuInfo::AVX512VBMI);
+}
+
+__attribute__((target("avx2")))
+inline __m256i Broadcast(uint8_t value) { return _mm256_set1_epi8(value); }
+__attribute__((target("avx2")))
+inline __m256i Broadcast(uint16_t value) { return _mm256_set1_epi16(value); }
+__attribute__((target("avx2")))
+inline __m256i Broadcast(uint32_t value) { return _mm256_set1_epi32(value); }
+__attribute__((target("avx2")))
+inline __m256i Broadcast(uint64_t value) { return _mm256_set1_epi64x(value); }
+
+template <typename T>
+__attribute__((target("avx2")))
+void FillAVX2(T value, int64_t num_values, T* __restrict__ out) {
+  constexpr int VALUES_PER_VECTOR = sizeof(__m256i) / sizeof(T);
+  const __m256i v = Broadcast(value);
+  int64_t i = 0;
+  for (; i + 4 * VALUES_PER_VECTOR <= num_values; i += 4 * VALUES_PER_VECTOR) {
+    __m256i* dst = reinterpret_cast<__m256i*>(out + i);
+    _mm256_storeu_si256(dst, v);
+    _mm256_storeu_si256(dst + 1, v);
+    _mm256_storeu_si256(dst + 2, v);
+    _mm256_storeu_si256(dst + 3, v);
+  }
+  for (; i + VALUES_PER_VECTOR <= num_values; i += VALUES_PER_VECTOR) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+  }
+  _mm256_zeroupper();
+  for (; i < num_values; ++i) out[i] = value;
+}
+
+} // anonymous namespace
+
+template <typename OutType>
+int64_t SimdBitPacking::UnpackBatches(int bit_width, const uint8_t* __restrict__ in,
+    int64_t in_bytes, int64_t num_batches, OutType* __restrict__ out) {
+  DCHECK(IsUnpackSupported(bit_width));
+  DCHECK_LE(bit_width, sizeof(OutType) * CHAR_BIT);
+#pragma push_macro("UNPACK_BATCHES_CASE")
+#define UNPACK_BATCHES_CASE(ignore1, i, ignore2) \
+  case i:                                        \
+    return use_avx512 ?                          \
+        UnpackBatchesAVX512<OutType, i>(in, in_bytes, num_batches, out) : \
+        UnpackBatchesAVX2<OutType, i>(in, in_bytes, num_batches, out);
+
+  const bool use_avx512 = HasAvx512Vbmi();
+  switch (bit_width) {
+    // Expand cases from 1 to 32.
+    BOOST_PP_REPEAT_FROM_TO(1, 33, UNPACK_BATCHES_CASE, ignore);
+    default:
+      DCHECK(false);
+      return 0;
+  }
+#pragma pop_macro("UNPACK_BATCHES_CASE")
+}
+
+template <typename T>
+void SimdBitPacking::Fill(T value, int64_t num_values, T* __restrict__ out) {
+  if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    FillAVX2(value, num_values, out);
+  } else {
+    std::fill_n(out, num_values, value);
+  }
+}
+
+#else
+
+template <typename OutType>
+int64_t SimdBitPacking::UnpackBatches(int bit_width, const uint8_t* __restrict__ in,
+    int64_t in_bytes, int64_t num_batches, OutType* __restrict__ out) {
+  DCHECK(false) << "Not supported on this platform";
+  return 0;
+}
+
+template <typename T>
+void SimdBitPacking::Fill(T value, int64_t num_values, T* __restrict__ out) {
+  std::fill_n(out, num_values, value);
+}
+
+#endif
+
+#define INSTANTIATE_SIMD_BIT_PACKING(T)                                               \
+  template int64_t SimdBitPacking::UnpackBatches<T>(int bit_width,                    \
+      const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_batches,          \
+      T* __restrict__ out);                                                           \
+  template void SimdBitPacking::Fill<T>(T value, int64_t num_values, T* __restrict__ out);
+
+INSTANTIATE_SIMD_BIT_PACKING(uint8_t);
+INSTANTIATE_SIMD_BIT_PACKING(uint16_t);
+INSTANTIATE_SIMD_BIT_PACKING(uint32_t);
+INSTANTIATE_SIMD_BIT_PACKING(uint64_t);
+
+} // namespace impala
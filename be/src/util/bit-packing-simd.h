@@ -0,0 +1,75 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "util/cpu-info.h"
+
+namespace impala {
+
+/// SIMD kernels for bit unpacking and for filling runs of repeated values. These are
+/// used by BitPacking and RleBatchDecoder when the CPU supports them.
+///
+/// Unpacking is done with a byte shuffle that moves the bytes containing each value into
+/// its own 32-bit lane, followed by a per-lane variable shift and a mask. Values that
+/// straddle five bytes (bit widths >= 26) are completed with a second shuffle and shift.
+/// Two implementations are chosen from at runtime:
+/// * AVX-512 VBMI: 16 values per vector. The input is read with a masked load, so no
+///   bytes past the end of the packed data are accessed.
+/// * AVX2: 8 values per vector. Each 128-bit lane is loaded with a 16 byte unaligned
+///   load, so up to SIMD_PADDING bytes past the current batch may be read. Batches that
+///   are not followed by that many bytes of input are left to the caller.
+class SimdBitPacking {
+ public:
+  /// Number of bytes past the end of a batch that the AVX2 kernels may read. The bytes
+  /// are never used.
+  static constexpr int SIMD_PADDING = 16;
+
+  /// Returns true if a SIMD unpacking kernel can be used on this CPU for values of
+  /// 'bit_width' bits. The kernels support bit widths from 1 to 32.
+  static bool IsUnpackSupported(int bit_width) {
+#ifndef __aarch64__
+    return bit_width >= 1 && bit_width <= 32 && CpuInfo::IsSupported(CpuInfo::AVX2);
+#else
+    return false;
+#endif
+  }
+
+  /// Unpacks up to 'num_batches' batches of 32 values of 'bit_width' from 'in' to 'out'.
+  /// 'in' points to 'in_bytes' of addressable memory. Stops early before a batch that
+  /// cannot be unpacked without reading past 'in' + 'in_bytes'. Returns the number of
+  /// batches unpacked, which may be 0. Must only be called if
+  /// IsUnpackSupported(bit_width) is true, and 'bit_width' must not be greater than the
+  /// number of bits in OutType. Instantiated for uint8_t, uint16_t, uint32_t and
+  /// uint64_t.
+  template <typename OutType>
+  static int64_t UnpackBatches(int bit_width, const uint8_t* __restrict__ in,
+      int64_t in_bytes, int64_t num_batches, OutType* __restrict__ out);
+
+  /// Minimum number of values for which Fill() is worth calling instead of a loop.
+  static constexpr int MIN_FILL_VALUES = 32;
+
+  /// Sets 'num_values' values starting at 'out' to 'value' using vector stores. Falls
+  /// back to a scalar loop if AVX2 is not supported. Instantiated for uint8_t, uint16_t,
+  /// uint32_t and uint64_t.
+  template <typename T>
+  static void Fill(T value, int64_t num_values, T* __restrict__ out);
+};
+
+} // namespace impala
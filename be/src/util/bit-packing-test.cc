@@ -26,6 +26,7 @@
 #include "testutil/mem-util.h"
 #include "util/bit-packing.h"
 #include "util/bit-stream-utils.inline.h"
+#include "util/cpu-info.h"
 
 #include "common/names.h"
 
@@ -201,6 +202,25 @@ TEST(BitPackingTest, RandomUnpack64) {
   RandomUnpackTest<uint64_t>();
 }
 
+// The tests above use the fastest unpacking kernel of the machine. Also test the AVX2
+// and the scalar implementations.
+TEST(BitPackingTest, RandomUnpackNoAvx512) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512F);
+  RandomUnpackTest<uint8_t>();
+  RandomUnpackTest<uint16_t>();
+  RandomUnpackTest<uint32_t>();
+  RandomUnpackTest<uint64_t>();
+}
+
+TEST(BitPackingTest, RandomUnpackNoSimd) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512F);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RandomUnpackTest<uint8_t>();
+  RandomUnpackTest<uint16_t>();
+  RandomUnpackTest<uint32_t>();
+  RandomUnpackTest<uint64_t>();
+}
+
 // This is not the full dictionary encoding, only a big bit-packed literal run, no RLE is
 // used.
 template <typename T>
@@ -319,4 +339,48 @@ TEST(BitPackingTest, RandomUnpackAndDecode64) {
   RandomUnpackAndDecodeTest<uint64_t>();
 }
 
+// Test the dictionary decoding of 4 and 8 byte values with each of the SIMD gather
+// implementations disabled, so that the AVX2 and the scalar paths are covered on
+// machines that support AVX-512.
+TEST(BitPackingTest, RandomUnpackAndDecodeNoAvx512) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512F);
+  RandomUnpackAndDecodeTest<uint32_t>();
+  RandomUnpackAndDecodeTest<uint64_t>();
+}
+
+TEST(BitPackingTest, RandomUnpackAndDecodeNoSimd) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512F);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RandomUnpackAndDecodeTest<uint32_t>();
+  RandomUnpackAndDecodeTest<uint64_t>();
+}
+
+// Test that an index that is out of the dictionary's range is detected in a full batch
+// of 32 values, whichever decoding path is used.
+template <typename UINT_T>
+void OutOfRangeDictIndexTest() {
+  constexpr int BIT_WIDTH = 8;
+  constexpr int NUM_VALUES = 64;
+  const std::vector<UINT_T> dict = {10, 20, 30};
+  for (int bad_idx_pos : {0, 31, 32, 63}) {
+    std::vector<uint8_t> data(NUM_VALUES * BIT_WIDTH / CHAR_BIT);
+    for (int i = 0; i < NUM_VALUES; ++i) data[i] = i % dict.size();
+    data[bad_idx_pos] = dict.size();
+    std::vector<UINT_T> out(NUM_VALUES);
+    bool decode_error = false;
+    BitPacking::UnpackAndDecodeValues<UINT_T>(BIT_WIDTH, data.data(), data.size(),
+        const_cast<UINT_T*>(dict.data()), dict.size(), NUM_VALUES, out.data(),
+        sizeof(UINT_T), &decode_error);
+    EXPECT_TRUE(decode_error) << bad_idx_pos;
+  }
+}
+
+TEST(BitPackingTest, OutOfRangeDictIndex) {
+  OutOfRangeDictIndexTest<uint32_t>();
+  OutOfRangeDictIndexTest<uint64_t>();
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512F);
+  OutOfRangeDictIndexTest<uint32_t>();
+  OutOfRangeDictIndexTest<uint64_t>();
+}
+
 }
@@ -128,6 +128,15 @@ class BitPacking {
       OutType* __restrict__ out, int64_t stride, bool* __restrict__ decode_error);
 
  private:
+  /// Unpacks 32 dictionary indices of BIT_WIDTH from 'in' and resolves them with
+  /// DictGather, writing the values to 'out' with a stride of 'stride' bytes. Returns
+  /// the new input position, or nullptr without advancing if one of the indices was
+  /// out of range, in which case the contents of 'out' are untouched.
+  template <typename OutType, int BIT_WIDTH>
+  static const uint8_t* UnpackAndGather32Values(const uint8_t* __restrict__ in,
+      int64_t in_bytes, const OutType* __restrict__ dict, int64_t dict_len,
+      uint8_t* __restrict__ out, int64_t stride);
+
   /// Compute the number of values with the given bit width that can be unpacked from
   /// an input buffer of 'in_bytes' into an output buffer with space for 'num_values'.
   static int64_t NumValuesToUnpack(int bit_width, int64_t in_bytes, int64_t num_values);
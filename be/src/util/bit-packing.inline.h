@@ -31,7 +31,9 @@
 
 #include "common/compiler-util.h"
 #include "common/logging.h"
+#include "util/bit-packing-simd.h"
 #include "util/bit-util.h"
+#include "util/dict-gather.h"
 
 namespace impala {
 
@@ -91,9 +93,19 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues(
   const int64_t remainder_values = values_to_read % BATCH_SIZE;
   const uint8_t* in_pos = in;
   OutType* out_pos = out;
-
-  // First unpack as many full batches as possible.
-  for (int64_t i = 0; i < batches_to_read; ++i) {
+  int64_t first_scalar_batch = 0;
+
+  // First unpack as many full batches as possible, using the SIMD kernels if the CPU
+  // supports them. They may leave the last few batches to the scalar loop.
+  if (BIT_WIDTH <= sizeof(OutType) * CHAR_BIT
+      && SimdBitPacking::IsUnpackSupported(BIT_WIDTH) && batches_to_read > 0) {
+    first_scalar_batch = SimdBitPacking::UnpackBatches<OutType>(
+        BIT_WIDTH, in_pos, in_bytes, batches_to_read, out_pos);
+    in_pos += first_scalar_batch * (BATCH_SIZE * BIT_WIDTH) / CHAR_BIT;
+    out_pos += first_scalar_batch * BATCH_SIZE;
+    in_bytes -= first_scalar_batch * (BATCH_SIZE * BIT_WIDTH) / CHAR_BIT;
+  }
+  for (int64_t i = first_scalar_batch; i < batches_to_read; ++i) {
     in_pos = Unpack32Values<OutType, BIT_WIDTH>(in_pos, in_bytes, out_pos);
     out_pos += BATCH_SIZE;
     in_bytes -= (BATCH_SIZE * BIT_WIDTH) / CHAR_BIT;
@@ -138,11 +150,24 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(
   const int64_t remainder_values = values_to_read % BATCH_SIZE;
   const uint8_t* in_pos = in;
   uint8_t* out_pos = reinterpret_cast<uint8_t*>(out);
+  // Resolve the dictionary indices with SIMD gathers if the CPU supports it. A batch
+  // with an out-of-range index is redone with the scalar path, which sets
+  // 'decode_error'.
+  const bool use_gather = DictGather::IsSupported(sizeof(OutType));
   // First unpack as many full batches as possible.
   for (int64_t i = 0; i < batches_to_read; ++i) {
-    in_pos = UnpackAndDecode32Values<OutType, BIT_WIDTH>(
-        in_pos, in_bytes, dict, dict_len, reinterpret_cast<OutType*>(out_pos), stride,
-        decode_error);
+    const uint8_t* next_in_pos = nullptr;
+    if (use_gather) {
+      next_in_pos = UnpackAndGather32Values<OutType, BIT_WIDTH>(
+          in_pos, in_bytes, dict, dict_len, out_pos, stride);
+    }
+    if (next_in_pos != nullptr) {
+      in_pos = next_in_pos;
+    } else {
+      in_pos = UnpackAndDecode32Values<OutType, BIT_WIDTH>(
+          in_pos, in_bytes, dict, dict_len, reinterpret_cast<OutType*>(out_pos), stride,
+          decode_error);
+    }
     out_pos += stride * BATCH_SIZE;
     in_bytes -= (BATCH_SIZE * BIT_WIDTH) / CHAR_BIT;
   }
@@ -302,6 +327,21 @@ const uint8_t* BitPacking::UnpackAndDecode32Values(const uint8_t* __restrict__ i
 #pragma pop_macro("DECODE_VALUE_CALL")
 }
 
+template <typename OutType, int BIT_WIDTH>
+const uint8_t* BitPacking::UnpackAndGather32Values(const uint8_t* __restrict__ in,
+    int64_t in_bytes, const OutType* __restrict__ dict, int64_t dict_len,
+    uint8_t* __restrict__ out, int64_t stride) {
+  static_assert(BIT_WIDTH <= MAX_DICT_BITWIDTH,
+      "Too high bit width for dictionary index.");
+  uint32_t indices[DictGather::BATCH_SIZE];
+  const uint8_t* next_in = Unpack32Values<uint32_t, BIT_WIDTH>(in, in_bytes, indices);
+  if (UNLIKELY(!DictGather::Gather32<sizeof(OutType)>(
+          dict, dict_len, indices, out, stride))) {
+    return nullptr;
+  }
+  return next_in;
+}
+
 template <typename OutType, int BIT_WIDTH>
 const uint8_t* BitPacking::UnpackUpTo31Values(const uint8_t* __restrict__ in,
     int64_t in_bytes, int num_values, OutType* __restrict__ out) {
@@ -302,6 +302,67 @@ TEST_F(BloomFilterTest, CumulativeFind) {
   }
 }
 
+// FindBatch() returns the same results as Find(), with and without AVX instructions and
+// for batches that are not a multiple of the group size of the prefetching.
+TEST_F(BloomFilterTest, FindBatch) {
+  srand(0);
+  for (int log_space = 5; log_space < 20; log_space += 7) {
+    BloomFilter* bf = CreateBloomFilter(log_space);
+    vector<uint32_t> hashes;
+    for (int k = 0; k < 1000; ++k) {
+      hashes.push_back(MakeRand());
+      // Not inserting any hashes checks the always false filter.
+      if (k % 2 == 0 && log_space > 5) BfInsert(*bf, hashes.back());
+    }
+    for (bool disable_avx2 : {false, true}) {
+      FLAGS_disable_blockbloomfilter_avx2 = disable_avx2;
+      for (int num_hashes : {0, 1, 31, 33, 1000}) {
+        unique_ptr<bool[]> found(new bool[num_hashes]);
+        bf->FindBatch(hashes.data(), num_hashes, found.get());
+        for (int k = 0; k < num_hashes; ++k) {
+          EXPECT_EQ(found[k], BfFind(*bf, hashes[k])) << k;
+          if (k % 2 == 0 && log_space > 5) EXPECT_TRUE(found[k]) << k;
+        }
+      }
+    }
+  }
+}
+
+// EstimateNdv() is close to the number of distinct hashes inserted until the filter is
+// almost full.
+TEST_F(BloomFilterTest, EstimateNdv) {
+  srand(0);
+  BloomFilter* bf = CreateBloomFilter(14);
+  EXPECT_EQ(0, bf->EstimateNdv());
+  int num_inserted = 0;
+  for (int ndv : {10, 100, 1000, 5000}) {
+    for (; num_inserted < ndv; ++num_inserted) BfInsert(*bf, MakeRand());
+    EXPECT_NEAR(ndv, bf->EstimateNdv(), 0.1 * ndv);
+  }
+}
+
+// After Fold()ing a Bloom filter, everything inserted before is still found.
+TEST_F(BloomFilterTest, Fold) {
+  srand(0);
+  BloomFilter* bf = CreateBloomFilter(16);
+  vector<uint32_t> inserted;
+  for (int k = 0; k < 1000; ++k) {
+    inserted.push_back(MakeRand());
+    BfInsert(*bf, inserted.back());
+  }
+  int64_t ndv = bf->EstimateNdv();
+  EXPECT_FALSE(bf->Fold(17).ok());
+  EXPECT_FALSE(bf->Fold(4).ok());
+  for (int log_space : {16, 13, 10}) {
+    ASSERT_OK(bf->Fold(log_space));
+    EXPECT_EQ(log_space, bf->GetBlockBloomFilter()->log_space_bytes());
+    for (uint32_t hash : inserted) ASSERT_TRUE(BfFind(*bf, hash)) << hash;
+    EXPECT_NEAR(ndv, bf->EstimateNdv(), 0.1 * ndv);
+  }
+  BfInsert(*bf, 1);
+  EXPECT_TRUE(BfFind(*bf, 1));
+}
+
 // The empirical false positives we find when looking for random items is with a constant
 // factor of the false positive probability the Bloom filter was constructed for.
 TEST_F(BloomFilterTest, FindInvalid) {
@@ -36,6 +36,7 @@
 #include "kudu/util/slice.h"
 #include "kudu/util/status.h"
 #include "runtime/exec-env.h"
+#include "util/bit-util.h"
 #include "util/kudu-status-util.h"
 
 using namespace std;
@@ -136,6 +137,31 @@ void BloomFilter::ToProtobuf(const BloomFilter* filter,
   filter->ToProtobuf(protobuf, controller);
 }
 
+int64_t BloomFilter::EstimateNdv() const {
+  if (AlwaysFalse()) return 0;
+  const kudu::Slice directory = block_bloom_filter_.directory();
+  DCHECK_EQ(directory.size() % sizeof(uint64_t), 0);
+  const uint64_t* words = reinterpret_cast<const uint64_t*>(directory.data());
+  int64_t num_set_bits = 0;
+  for (int64_t i = 0; i < directory.size() / sizeof(uint64_t); ++i) {
+    num_set_bits += BitUtil::Popcount(words[i]);
+  }
+  const int64_t num_bits = directory.size() * 8;
+  if (num_set_bits == num_bits) return numeric_limits<int64_t>::max();
+  // Every insert sets one bit in each of the 32-bit words of one 32-byte bucket, so the
+  // expected fraction of set bits after n inserts into B buckets is
+  // 1 - (1 - 1/32)^(n/B).
+  const int64_t num_buckets = directory.size() / 32;
+  const double fraction_unset = 1.0 - static_cast<double>(num_set_bits) / num_bits;
+  return llround(num_buckets * log(fraction_unset) / log(1.0 - 1.0 / 32));
+}
+
+Status BloomFilter::Fold(int log_bufferpool_space) {
+  KUDU_RETURN_IF_ERROR(block_bloom_filter_.Fold(log_bufferpool_space),
+      "Failed to fold Bloom filter");
+  return Status::OK();
+}
+
 int64_t BloomFilter::GetBufferPoolSpaceUsed() {
   return buffer_allocator_.IsAllocated() ? block_bloom_filter_.GetSpaceUsed() : -1;
 }
@@ -153,6 +153,11 @@ class BloomFilter {
   /// high probabilty) if it is not.
   bool Find(const uint32_t hash) const noexcept;
 
+  /// Finds the 'num_hashes' elements in 'hashes' in the BloomFilter and sets found[i] to
+  /// Find(hashes[i]). Faster than calling Find() for every element, because the cache
+  /// misses of the probes overlap.
+  void FindBatch(const uint32_t* hashes, int num_hashes, bool* found) const noexcept;
+
   /// Computes the logical OR of this filter with 'other' and stores the result in this
   /// filter.
   void Or(const BloomFilter& other);
@@ -165,6 +170,15 @@ class BloomFilter {
   static void Or(const BloomFilterPB& in, const uint8_t* directory_in, BloomFilterPB* out,
       uint8_t* directory_out, size_t directory_size);
 
+  /// Returns an estimate of the number of distinct elements inserted into the filter,
+  /// computed from the fraction of set bits. Reads the whole directory, so it should
+  /// only be called once a filter is complete.
+  int64_t EstimateNdv() const;
+
+  /// Shrinks the filter to (1 << log_bufferpool_space) bytes, see
+  /// kudu::BlockBloomFilter::Fold(). The buffer pool space of the filter does not change.
+  Status Fold(int log_bufferpool_space);
+
   /// As more distinct items are inserted into a BloomFilter, the false positive rate
   /// rises. MaxNdv() returns the NDV (number of distinct values) at which a BloomFilter
   /// constructed with (1 << log_bufferpool_space) bytes of heap space hits false positive
@@ -249,4 +263,9 @@ inline bool ALWAYS_INLINE BloomFilter::Find(const uint32_t hash) const noexcept
   return block_bloom_filter_.Find(hash);
 }
 
+inline void BloomFilter::FindBatch(
+    const uint32_t* hashes, int num_hashes, bool* found) const noexcept {
+  block_bloom_filter_.FindBatch(hashes, num_hashes, found);
+}
+
 } // namespace impala
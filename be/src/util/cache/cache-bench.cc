@@ -34,6 +34,8 @@
 #include "kudu/gutil/macros.h"
 #include "kudu/gutil/stringprintf.h"
 #include "kudu/gutil/strings/human_readable.h"
+#include "kudu/gutil/strings/numbers.h"
+#include "kudu/gutil/strings/split.h"
 #include "kudu/util/monotime.h"
 #include "kudu/util/random.h"
 #include "kudu/util/random_util.h"
@@ -43,7 +45,14 @@
 
 DEFINE_int32(num_threads, 16, "The number of threads to access the cache concurrently.");
 DEFINE_int32(run_seconds, 1, "The number of seconds to run the benchmark");
-DEFINE_string(eviction_policy, "LRU", "The eviction policy to use for the cache.");
+DEFINE_string(eviction_policy, "LRU",
+    "The eviction policy to use for the cache: LRU, LIRS, FIFO, TINYLFU or CLOCK.");
+DEFINE_string(scaling_eviction_policies, "LRU,LIRS,CLOCK",
+    "Comma separated list of the eviction policies whose lookup throughput is compared "
+    "by the LookupScaling benchmark.");
+DEFINE_string(scaling_num_threads, "1,2,4,8,16,32",
+    "Comma separated list of the numbers of threads the LookupScaling benchmark runs "
+    "with.");
 
 using std::atomic;
 using std::pair;
@@ -66,7 +75,11 @@ struct BenchSetup {
     // vast majority of lookups.
     ZIPFIAN,
     // Every item is equally likely to be looked up.
-    UNIFORM
+    UNIFORM,
+    // Zipfian lookups, each followed by a lookup of a key which is never looked up
+    // again, like the data of a large scan. A scan resistant eviction policy keeps the
+    // hit rate of the Zipfian lookups close to the one without scans.
+    ZIPFIAN_WITH_SCAN
   };
   Pattern pattern;
 
@@ -81,6 +94,7 @@ struct BenchSetup {
     switch (pattern) {
       case Pattern::ZIPFIAN: ret += "ZIPFIAN"; break;
       case Pattern::UNIFORM: ret += "UNIFORM"; break;
+      case Pattern::ZIPFIAN_WITH_SCAN: ret += "ZIPFIAN_WITH_SCAN"; break;
     }
     ret += StringPrintf(" ratio=%.2fx n_unique=%d", dataset_cache_ratio, max_key());
     return ret;
@@ -96,14 +110,22 @@ class CacheBench : public testing::Test,
                    public testing::WithParamInterface<BenchSetup>{
  public:
   void SetUp() override {
-    cache_.reset(NewCache(Cache::ParseEvictionPolicy(FLAGS_eviction_policy),
-        kCacheCapacity, "test-cache"));
+    ResetCache(FLAGS_eviction_policy);
+  }
+
+  // Replaces the cache with an empty one with the eviction policy 'policy'.
+  void ResetCache(const string& policy) {
+    // Free the entries of the old cache before filling the new one.
+    cache_.reset();
+    cache_.reset(NewCache(Cache::ParseEvictionPolicy(policy), kCacheCapacity,
+        "test-cache"));
     Status status = cache_->Init();
     ASSERT_OK(status);
   }
 
   // Run queries against the cache until '*done' becomes true.
-  // Returns a pair of the number of cache hits and lookups.
+  // Returns a pair of the number of cache hits and lookups. Lookups of scanned keys are
+  // not counted.
   pair<int64_t, int64_t> DoQueries(const atomic<bool>* done) {
     const BenchSetup& setup = GetParam();
     kudu::Random r(kudu::GetRandomSeed32());
@@ -114,27 +136,34 @@ class CacheBench : public testing::Test,
     if (max_key == 0) return {0, 0};
     while (!*done) {
       uint32_t int_key;
-      if (setup.pattern == BenchSetup::Pattern::ZIPFIAN) {
-        int_key = r.Skewed(Bits::Log2Floor(max_key));
-      } else {
+      if (setup.pattern == BenchSetup::Pattern::UNIFORM) {
         int_key = r.Uniform(max_key);
-      }
-      char key_buf[sizeof(int_key)];
-      memcpy(key_buf, &int_key, sizeof(int_key));
-      Slice key_slice(key_buf, arraysize(key_buf));
-      auto h(cache_->Lookup(key_slice));
-      if (h) {
-        ++hits;
       } else {
-        auto ph(cache_->Allocate(
-            key_slice, /* val_len=*/kEntrySize, /* charge=*/kEntrySize));
-        cache_->Insert(std::move(ph), nullptr);
+        int_key = r.Skewed(Bits::Log2Floor(max_key));
       }
+      if (LookupOrInsert(int_key)) ++hits;
       ++lookups;
+      if (setup.pattern == BenchSetup::Pattern::ZIPFIAN_WITH_SCAN) {
+        // Scanned keys are above all keys of the Zipfian lookups.
+        LookupOrInsert(max_key + next_scan_key_.fetch_add(1));
+      }
     }
     return {hits, lookups};
   }
 
+  // Looks up 'int_key' and inserts it on a miss. Returns true on a hit.
+  bool LookupOrInsert(uint32_t int_key) {
+    char key_buf[sizeof(int_key)];
+    memcpy(key_buf, &int_key, sizeof(int_key));
+    Slice key_slice(key_buf, arraysize(key_buf));
+    auto h(cache_->Lookup(key_slice));
+    if (h) return true;
+    auto ph(cache_->Allocate(
+        key_slice, /* val_len=*/kEntrySize, /* charge=*/kEntrySize));
+    cache_->Insert(std::move(ph), nullptr);
+    return false;
+  }
+
   // Starts the given number of threads to concurrently call DoQueries.
   // Returns the aggregated number of cache hits and lookups.
   pair<int64_t, int64_t> RunQueryThreads(int n_threads, int n_seconds) {
@@ -159,6 +188,10 @@ class CacheBench : public testing::Test,
 
  protected:
   unique_ptr<Cache> cache_;
+
+  // The next key to look up for ZIPFIAN_WITH_SCAN, relative to the largest key of the
+  // Zipfian lookups.
+  atomic<uint32_t> next_scan_key_{0};
 };
 
 // Test both distributions, and for each, test both the case where the data
@@ -169,8 +202,43 @@ INSTANTIATE_TEST_CASE_P(Patterns, CacheBench, testing::ValuesIn(std::vector<Benc
       {BenchSetup::Pattern::UNIFORM, 1.0},
       {BenchSetup::Pattern::UNIFORM, 3.0},
       {BenchSetup::Pattern::UNIFORM, 500.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCAN, 1.0},
+      {BenchSetup::Pattern::ZIPFIAN_WITH_SCAN, 3.0},
     }));
 
+// Compares the lookup throughput of the eviction policies for an increasing number of
+// threads. The dataset fits in the cache and the lookups are skewed, so almost all of
+// them are hits of a few hot entries, which is where the locking of the hit path limits
+// the throughput.
+class CacheScalingBench : public CacheBench {};
+
+INSTANTIATE_TEST_CASE_P(Patterns, CacheScalingBench,
+    testing::ValuesIn(std::vector<BenchSetup>{{BenchSetup::Pattern::ZIPFIAN, 1.0}}));
+
+TEST_P(CacheScalingBench, LookupScaling) {
+  vector<int> thread_counts;
+  for (const string& str : strings::Split(FLAGS_scaling_num_threads, ",",
+           strings::SkipWhitespace())) {
+    int n_threads;
+    ASSERT_TRUE(safe_strto32(str, &n_threads) && n_threads > 0) << str;
+    thread_counts.push_back(n_threads);
+  }
+  for (const string& policy : strings::Split(FLAGS_scaling_eviction_policies, ",",
+           strings::SkipWhitespace())) {
+    ResetCache(policy);
+    RunQueryThreads(thread_counts.back(), 1);
+    for (int n_threads : thread_counts) {
+      pair<int64_t, int64_t> hits_lookups =
+          RunQueryThreads(n_threads, FLAGS_run_seconds);
+      int64_t l_per_sec = hits_lookups.second / FLAGS_run_seconds;
+      LOG(INFO) << StringPrintf("%-8s %3d threads: ", policy.c_str(), n_threads)
+                << HumanReadableNum::ToString(l_per_sec) << " lookups/sec, "
+                << StringPrintf("%.1f", hits_lookups.first * 100.0 / hits_lookups.second)
+                << "% hit rate";
+    }
+  }
+}
+
 TEST_P(CacheBench, RunBench) {
   const BenchSetup& setup = GetParam();
 
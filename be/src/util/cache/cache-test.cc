@@ -50,6 +50,15 @@ void CacheBaseTest::SetupWithParameters(Cache::EvictionPolicy eviction_policy,
       cache_.reset(NewCache(Cache::EvictionPolicy::LIRS, cache_size(), "cache_test"));
       kudu::MemTracker::FindTracker("cache_test-sharded_lirs_cache", &mem_tracker_);
       break;
+    case Cache::EvictionPolicy::TINYLFU:
+      cache_.reset(
+          NewCache(Cache::EvictionPolicy::TINYLFU, cache_size(), "cache_test"));
+      kudu::MemTracker::FindTracker("cache_test-sharded_tinylfu_cache", &mem_tracker_);
+      break;
+    case Cache::EvictionPolicy::CLOCK:
+      cache_.reset(NewCache(Cache::EvictionPolicy::CLOCK, cache_size(), "cache_test"));
+      kudu::MemTracker::FindTracker("cache_test-sharded_clock_cache", &mem_tracker_);
+      break;
     default:
       FAIL() << "unrecognized cache eviction policy";
   }
@@ -85,6 +94,14 @@ INSTANTIATE_TEST_CASE_P(
         make_tuple(Cache::EvictionPolicy::LRU,
                    ShardingPolicy::SingleShard),
         make_tuple(Cache::EvictionPolicy::LIRS,
+                   ShardingPolicy::SingleShard),
+        make_tuple(Cache::EvictionPolicy::TINYLFU,
+                   ShardingPolicy::MultiShard),
+        make_tuple(Cache::EvictionPolicy::TINYLFU,
+                   ShardingPolicy::SingleShard),
+        make_tuple(Cache::EvictionPolicy::CLOCK,
+                   ShardingPolicy::MultiShard),
+        make_tuple(Cache::EvictionPolicy::CLOCK,
                    ShardingPolicy::SingleShard)));
 
 TEST_P(CacheTest, TrackMemory) {
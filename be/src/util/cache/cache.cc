@@ -75,6 +75,10 @@ string ToString(Cache::EvictionPolicy p) {
       return "lru";
     case Cache::EvictionPolicy::LIRS:
       return "lirs";
+    case Cache::EvictionPolicy::TINYLFU:
+      return "tinylfu";
+    case Cache::EvictionPolicy::CLOCK:
+      return "clock";
     default:
       LOG(FATAL) << "unexpected cache eviction policy: " << static_cast<int>(p);
   }
@@ -90,6 +94,10 @@ CacheShard* NewCacheShard(Cache::EvictionPolicy policy, kudu::MemTracker* mem_tr
       return NewCacheShardInt<Cache::EvictionPolicy::LRU>(mem_tracker, capacity);
     case Cache::EvictionPolicy::LIRS:
       return NewCacheShardInt<Cache::EvictionPolicy::LIRS>(mem_tracker, capacity);
+    case Cache::EvictionPolicy::TINYLFU:
+      return NewCacheShardInt<Cache::EvictionPolicy::TINYLFU>(mem_tracker, capacity);
+    case Cache::EvictionPolicy::CLOCK:
+      return NewCacheShardInt<Cache::EvictionPolicy::CLOCK>(mem_tracker, capacity);
     default:
       LOG(FATAL) << "unexpected cache eviction policy: " << static_cast<int>(policy);
   }
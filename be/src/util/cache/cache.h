@@ -48,6 +48,15 @@ class Cache {
 
     // LIRS (Low Inter-reference Recency Set)
     LIRS,
+
+    // W-TinyLFU: new items are only admitted if they are accessed more frequently than
+    // the items they would evict.
+    TINYLFU,
+
+    // CLOCK: an approximation of LRU. Lookups only set a reference bit of the entry and
+    // do not take the shard's lock exclusively, which scales better with the number of
+    // threads that look up hot entries.
+    CLOCK,
   };
 
   static EvictionPolicy ParseEvictionPolicy(const std::string& policy_string) {
@@ -58,6 +67,10 @@ class Cache {
       return Cache::EvictionPolicy::LIRS;
     } else if (upper_policy == "FIFO") {
       return Cache::EvictionPolicy::FIFO;
+    } else if (upper_policy == "TINYLFU") {
+      return Cache::EvictionPolicy::TINYLFU;
+    } else if (upper_policy == "CLOCK") {
+      return Cache::EvictionPolicy::CLOCK;
     }
     LOG(FATAL) << "Unsupported eviction policy: " << policy_string;
     return Cache::EvictionPolicy::LRU;
@@ -0,0 +1,156 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cache/cache.h"
+#include "util/cache/cache-test.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/slice.h"
+
+namespace impala {
+
+class ClockCacheTest : public CacheBaseTest {
+ public:
+  ClockCacheTest()
+    : CacheBaseTest(10) {
+  }
+
+  void SetUp() override {
+    SetupWithParameters(Cache::EvictionPolicy::CLOCK, ShardingPolicy::SingleShard);
+  }
+
+ protected:
+  // Returns whether 'key' is in the cache without setting its reference bit.
+  bool IsResident(int key) { return Lookup(key, Cache::NO_UPDATE) != -1; }
+
+  // Fills the cache with 10 elements (0-9) and verifies that there were no evictions.
+  void FillCache() {
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_TRUE(Insert(i, i));
+    }
+    ASSERT_EQ(evicted_keys_.size(), 0);
+  }
+};
+
+TEST_F(ClockCacheTest, ReferencedEntriesGetSecondChance) {
+  FillCache();
+  for (int i = 0; i < 5; ++i) ASSERT_EQ(i, Lookup(i));
+  // The hand clears the bits of 0-4 and evicts 5, then 6.
+  ASSERT_TRUE(Insert(10, 10));
+  ASSERT_TRUE(Insert(11, 11));
+  ASSERT_EQ(evicted_keys_.size(), 2);
+  ASSERT_EQ(evicted_keys_[0], 5);
+  ASSERT_EQ(evicted_keys_[1], 6);
+  for (int i = 0; i < 5; ++i) ASSERT_TRUE(IsResident(i));
+  ASSERT_TRUE(IsResident(10));
+  ASSERT_TRUE(IsResident(11));
+
+  // The hand is at 7 now. A hit before the hand gets to an entry saves it too.
+  ASSERT_EQ(7, Lookup(7));
+  ASSERT_TRUE(Insert(12, 12));
+  ASSERT_EQ(evicted_keys_.size(), 3);
+  ASSERT_EQ(evicted_keys_[2], 8);
+}
+
+TEST_F(ClockCacheTest, NoUpdateLookupDoesNotSetBit) {
+  FillCache();
+  ASSERT_TRUE(IsResident(0));
+  ASSERT_TRUE(Insert(10, 10));
+  ASSERT_EQ(evicted_keys_.size(), 1);
+  ASSERT_EQ(evicted_keys_[0], 0);
+}
+
+TEST_F(ClockCacheTest, NewEntryEvictedIfAllEntriesReferenced) {
+  FillCache();
+  for (int i = 0; i < 10; ++i) ASSERT_EQ(i, Lookup(i));
+  // The new entry is the last one the hand visits. It was not hit, unlike all other
+  // entries, whose bits the hand clears before it gets to the new entry.
+  ASSERT_TRUE(Insert(10, 10));
+  ASSERT_EQ(evicted_keys_.size(), 1);
+  ASSERT_EQ(evicted_keys_[0], 10);
+  // The next insert evicts the entry the hand points to now.
+  ASSERT_TRUE(Insert(11, 11));
+  ASSERT_EQ(evicted_keys_.size(), 2);
+  ASSERT_EQ(evicted_keys_[1], 0);
+}
+
+TEST_F(ClockCacheTest, InvalidateInHandOrder) {
+  FillCache();
+  ASSERT_EQ(0, Lookup(0));
+  // Evicts 1 and leaves the hand at 2.
+  ASSERT_TRUE(Insert(10, 10));
+  ASSERT_EQ(evicted_keys_.size(), 1);
+  ASSERT_EQ(evicted_keys_[0], 1);
+
+  const Cache::InvalidationControl ctl = {
+    Cache::kInvalidateAllEntriesFunc,
+    [](size_t /* valid_entries_count */, size_t invalid_entries_count) {
+      return invalid_entries_count < 3;
+    }
+  };
+  ASSERT_EQ(3, cache_->Invalidate(ctl));
+  ASSERT_EQ(evicted_keys_.size(), 4);
+  ASSERT_EQ(evicted_keys_[1], 2);
+  ASSERT_EQ(evicted_keys_[2], 3);
+  ASSERT_EQ(evicted_keys_[3], 4);
+
+  // Invalidating all entries visits every entry once.
+  ASSERT_EQ(7, cache_->Invalidate({}));
+  ASSERT_EQ(evicted_keys_.size(), 11);
+  ASSERT_EQ(0, cache_->Invalidate({}));
+}
+
+TEST_F(ClockCacheTest, ConcurrentLookups) {
+  constexpr int kNumKeys = 100;
+  constexpr int kNumLookupThreads = 8;
+  // The entries are inserted without an eviction callback, since the callback of the
+  // test is not thread-safe and lookup threads may release the last reference.
+  auto insert = [this](int key) {
+    std::string key_str = EncodeInt(key);
+    auto handle(cache_->Allocate(key_str, sizeof(int), 1));
+    ASSERT_TRUE(handle != nullptr);
+    memcpy(cache_->MutableValue(&handle), &key, sizeof(int));
+    cache_->Insert(std::move(handle), nullptr);
+  };
+  std::atomic<bool> done{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumLookupThreads; ++t) {
+    threads.emplace_back([this, &done, t]() {
+      for (int i = t; !done.load(); ++i) {
+        auto handle(cache_->Lookup(EncodeInt(i % kNumKeys)));
+        if (handle) {
+          int value;
+          memcpy(&value, cache_->Value(handle).data(), sizeof(int));
+          ASSERT_EQ(i % kNumKeys, value);
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 10000; ++i) insert(i % kNumKeys);
+  done.store(true);
+  for (std::thread& thread : threads) thread.join();
+}
+
+} // namespace impala
@@ -0,0 +1,380 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cache/cache.h"
+#include "util/cache/cache-internal.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "common/status.h"
+#include "gutil/mathlimits.h"
+#include "gutil/strings/substitute.h"
+#include "kudu/util/alignment.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/malloc.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/slice.h"
+
+DECLARE_double(cache_memtracker_approximation_ratio);
+
+using std::atomic;
+
+using kudu::Slice;
+
+using strings::Substitute;
+
+namespace impala {
+
+namespace {
+
+// This implements the CLOCK policy, an approximation of LRU whose hits do not modify any
+// shared state of the cache.
+//
+// LRU moves an entry to the head of its recency list on every hit, so all lookups of a
+// shard serialize on the shard's lock, even if they hit the same few hot entries. CLOCK
+// instead keeps the entries in a ring in insertion order and only sets the entry's
+// reference bit on a hit. Lookups therefore take the shard's lock in shared mode, which
+// is a per-CPU reader-writer lock, so that concurrent lookups do not contend on a cache
+// line of the shard.
+//
+// Inserts and eviction take the lock in exclusive mode. To evict an entry, the clock
+// hand sweeps the ring: entries with the reference bit set get a second chance, i.e.
+// their bit is cleared and the hand moves on, and the first entry without the bit is
+// evicted. New entries are added right behind the hand, so they are the last entries
+// the hand visits, and start without the bit, so an entry that is never hit after its
+// insertion is evicted on the first visit of the hand. Entries that are hit between two
+// visits of the hand stay in the cache.
+class ClockHandle : public HandleBase {
+ public:
+  ClockHandle(uint8_t* kv_ptr, const Slice& key, int32_t hash, int val_len, int charge)
+    : HandleBase(kv_ptr, key, hash, val_len, charge) {
+    refs.store(0);
+    referenced.store(false);
+  }
+
+  Cache::EvictionCallback* eviction_callback = nullptr;
+  ClockHandle* next = nullptr;
+  ClockHandle* prev = nullptr;
+  std::atomic<int32_t> refs;
+  // Set by lookups, cleared by the clock hand.
+  std::atomic<bool> referenced;
+};
+
+class ClockCacheShard : public CacheShard {
+ public:
+  ClockCacheShard(kudu::MemTracker* tracker, size_t capacity);
+  ~ClockCacheShard();
+
+  Status Init() override;
+  HandleBase* Allocate(Slice key, uint32_t hash, int val_len, int charge) override;
+  void Free(HandleBase* handle) override;
+  HandleBase* Insert(HandleBase* handle,
+      Cache::EvictionCallback* eviction_callback) override;
+  HandleBase* Lookup(const Slice& key, uint32_t hash, bool no_updates) override;
+  void Release(HandleBase* handle) override;
+  void Erase(const Slice& key, uint32_t hash) override;
+  size_t Invalidate(const Cache::InvalidationControl& ctl) override;
+
+ private:
+  // Adds 'e' to the ring right behind the hand. 'mutex_' must be held exclusively.
+  void RingAppend(ClockHandle* e);
+  // Removes 'e' from the ring, advancing the hand if it points to 'e'. 'mutex_' must be
+  // held exclusively.
+  void RingRemove(ClockHandle* e);
+  // Removes 'e' from the ring and the table and adds it to 'to_remove_head' if this was
+  // the last reference. 'mutex_' must be held exclusively.
+  void Evict(ClockHandle* e, ClockHandle** to_remove_head);
+  // Just reduce the reference count by 1. Return true if last reference.
+  bool Unref(ClockHandle* e);
+  // Call the user's eviction callback, if it exists, and free the entry.
+  void FreeEntry(ClockHandle* e);
+  // Update the memtracker's consumption by the given amount. See RLCacheShard.
+  void UpdateMemTracker(int64_t delta);
+
+  bool initialized_ = false;
+
+  const size_t capacity_;
+
+  // Protects the state below. Lookups hold it in shared mode, all other operations in
+  // exclusive mode.
+  kudu::percpu_rwlock mutex_;
+  size_t usage_ = 0;
+
+  // The entry the hand points to, i.e. the next candidate for eviction, or nullptr if
+  // the ring is empty. The entries form a circular doubly linked list.
+  ClockHandle* hand_ = nullptr;
+
+  HandleTable table_;
+
+  kudu::MemTracker* mem_tracker_;
+  atomic<int64_t> deferred_consumption_ { 0 };
+  int64_t max_deferred_consumption_ = 0;
+};
+
+ClockCacheShard::ClockCacheShard(kudu::MemTracker* tracker, size_t capacity)
+  : capacity_(capacity),
+    mem_tracker_(tracker) {
+}
+
+ClockCacheShard::~ClockCacheShard() {
+  while (hand_ != nullptr) {
+    ClockHandle* e = hand_;
+    DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
+        << "caller has an unreleased handle";
+    RingRemove(e);
+    table_.Remove(e->key(), e->hash());
+    if (Unref(e)) FreeEntry(e);
+  }
+  mem_tracker_->Consume(deferred_consumption_);
+}
+
+Status ClockCacheShard::Init() {
+  if (!MathLimits<double>::IsFinite(FLAGS_cache_memtracker_approximation_ratio) ||
+      FLAGS_cache_memtracker_approximation_ratio < 0.0 ||
+      FLAGS_cache_memtracker_approximation_ratio > 1.0) {
+    return Status(Substitute("Misconfigured --cache_memtracker_approximation_ratio: $0. "
+        "Must be between 0 and 1.", FLAGS_cache_memtracker_approximation_ratio));
+  }
+  max_deferred_consumption_ = capacity_ * FLAGS_cache_memtracker_approximation_ratio;
+  initialized_ = true;
+  return Status::OK();
+}
+
+void ClockCacheShard::RingAppend(ClockHandle* e) {
+  DCHECK(e->next == nullptr && e->prev == nullptr);
+  if (hand_ == nullptr) {
+    e->next = e;
+    e->prev = e;
+    hand_ = e;
+  } else {
+    e->next = hand_;
+    e->prev = hand_->prev;
+    e->prev->next = e;
+    e->next->prev = e;
+  }
+  usage_ += e->charge();
+}
+
+void ClockCacheShard::RingRemove(ClockHandle* e) {
+  if (e->next == e) {
+    DCHECK_EQ(hand_, e);
+    hand_ = nullptr;
+  } else {
+    if (hand_ == e) hand_ = e->next;
+    e->next->prev = e->prev;
+    e->prev->next = e->next;
+  }
+  e->next = nullptr;
+  e->prev = nullptr;
+  DCHECK_GE(usage_, e->charge());
+  usage_ -= e->charge();
+}
+
+void ClockCacheShard::Evict(ClockHandle* e, ClockHandle** to_remove_head) {
+  RingRemove(e);
+  table_.Remove(e->key(), e->hash());
+  if (Unref(e)) {
+    e->next = *to_remove_head;
+    *to_remove_head = e;
+  }
+}
+
+bool ClockCacheShard::Unref(ClockHandle* e) {
+  DCHECK_GT(e->refs.load(std::memory_order_relaxed), 0);
+  return e->refs.fetch_sub(1) == 1;
+}
+
+void ClockCacheShard::FreeEntry(ClockHandle* e) {
+  DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 0);
+  if (e->eviction_callback) {
+    e->eviction_callback->EvictedEntry(e->key(), e->value());
+  }
+  UpdateMemTracker(-static_cast<int64_t>(e->charge()));
+  Free(e);
+}
+
+void ClockCacheShard::UpdateMemTracker(int64_t delta) {
+  int64_t old_deferred = deferred_consumption_.fetch_add(delta);
+  int64_t new_deferred = old_deferred + delta;
+
+  if (new_deferred > max_deferred_consumption_ ||
+      new_deferred < -max_deferred_consumption_) {
+    int64_t to_propagate = deferred_consumption_.exchange(0, std::memory_order_relaxed);
+    mem_tracker_->Consume(to_propagate);
+  }
+}
+
+HandleBase* ClockCacheShard::Allocate(Slice key, uint32_t hash, int val_len,
+    int charge) {
+  DCHECK(initialized_);
+  int key_len = key.size();
+  DCHECK_GE(key_len, 0);
+  DCHECK_GE(val_len, 0);
+  int key_len_padded = KUDU_ALIGN_UP(key_len, sizeof(void*));
+  uint8_t* buf = new uint8_t[sizeof(ClockHandle)
+                             + key_len_padded + val_len]; // the kv_data VLA data
+  int calc_charge =
+    (charge == Cache::kAutomaticCharge) ? kudu::kudu_malloc_usable_size(buf) : charge;
+  uint8_t* kv_ptr = buf + sizeof(ClockHandle);
+  return new (buf) ClockHandle(kv_ptr, key, hash, val_len, calc_charge);
+}
+
+void ClockCacheShard::Free(HandleBase* handle) {
+  DCHECK(initialized_);
+  // We allocate the handle as a uint8_t array, then we call a placement new,
+  // which calls the constructor. For symmetry, we call the destructor and then
+  // delete on the uint8_t array.
+  ClockHandle* h = static_cast<ClockHandle*>(handle);
+  h->~ClockHandle();
+  uint8_t* data = reinterpret_cast<uint8_t*>(handle);
+  delete [] data;
+}
+
+HandleBase* ClockCacheShard::Lookup(const Slice& key, uint32_t hash,
+    bool no_updates) {
+  DCHECK(initialized_);
+  // Entries are only removed from the table with the lock held exclusively, so the
+  // reference of the cache keeps 'e' alive until the new reference is added.
+  kudu::shared_lock<kudu::rw_spinlock> l(mutex_.get_lock());
+  ClockHandle* e = static_cast<ClockHandle*>(table_.Lookup(key, hash));
+  if (e == nullptr) return nullptr;
+  e->refs.fetch_add(1, std::memory_order_relaxed);
+  // Only write the bit if it changes, so that hits of hot entries do not dirty the
+  // cache line more than necessary.
+  if (!no_updates && !e->referenced.load(std::memory_order_relaxed)) {
+    e->referenced.store(true, std::memory_order_relaxed);
+  }
+  return e;
+}
+
+void ClockCacheShard::Release(HandleBase* handle) {
+  DCHECK(initialized_);
+  ClockHandle* e = static_cast<ClockHandle*>(handle);
+  if (Unref(e)) FreeEntry(e);
+}
+
+HandleBase* ClockCacheShard::Insert(HandleBase* handle_in,
+    Cache::EvictionCallback* eviction_callback) {
+  DCHECK(initialized_);
+  ClockHandle* handle = static_cast<ClockHandle*>(handle_in);
+  handle->eviction_callback = eviction_callback;
+  // Two refs for the handle: one from ClockCacheShard, one for the returned handle.
+  handle->refs.store(2, std::memory_order_relaxed);
+  UpdateMemTracker(handle->charge());
+
+  ClockHandle* to_remove_head = nullptr;
+  {
+    std::lock_guard<kudu::percpu_rwlock> l(mutex_);
+    ClockHandle* old = static_cast<ClockHandle*>(table_.Insert(handle));
+    if (old != nullptr) {
+      RingRemove(old);
+      if (Unref(old)) {
+        old->next = to_remove_head;
+        to_remove_head = old;
+      }
+    }
+    RingAppend(handle);
+
+    // Every visit of an entry either evicts it or clears its bit, so the hand evicts an
+    // entry at the latest after one full turn.
+    while (usage_ > capacity_ && hand_ != nullptr) {
+      ClockHandle* e = hand_;
+      if (e->referenced.load(std::memory_order_relaxed)) {
+        e->referenced.store(false, std::memory_order_relaxed);
+        hand_ = e->next;
+        continue;
+      }
+      Evict(e, &to_remove_head);
+    }
+  }
+
+  // We free the entries here outside of mutex for performance reasons.
+  while (to_remove_head != nullptr) {
+    ClockHandle* next = to_remove_head->next;
+    FreeEntry(to_remove_head);
+    to_remove_head = next;
+  }
+  return handle;
+}
+
+void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
+  DCHECK(initialized_);
+  ClockHandle* e;
+  bool last_reference = false;
+  {
+    std::lock_guard<kudu::percpu_rwlock> l(mutex_);
+    e = static_cast<ClockHandle*>(table_.Remove(key, hash));
+    if (e != nullptr) {
+      RingRemove(e);
+      last_reference = Unref(e);
+    }
+  }
+  // last_reference will only be true if e != NULL
+  if (last_reference) FreeEntry(e);
+}
+
+size_t ClockCacheShard::Invalidate(const Cache::InvalidationControl& ctl) {
+  DCHECK(initialized_);
+  size_t invalid_entry_count = 0;
+  size_t valid_entry_count = 0;
+  ClockHandle* to_remove_head = nullptr;
+  {
+    std::lock_guard<kudu::percpu_rwlock> l(mutex_);
+    // Visit the entries in the order in which the hand would visit them, starting with
+    // the best candidate for eviction. Each entry is visited once.
+    ClockHandle* h = hand_;
+    ClockHandle* end = hand_ == nullptr ? nullptr : hand_->prev;
+    bool done = h == nullptr;
+    while (!done && ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
+      ClockHandle* next = h->next;
+      done = h == end;
+      if (ctl.validity_func(h->key(), h->value())) {
+        ++valid_entry_count;
+      } else {
+        Evict(h, &to_remove_head);
+        ++invalid_entry_count;
+      }
+      h = next;
+    }
+  }
+  // Once removed from the lookup table and the ring, the entries with no references
+  // left must be deallocated because Cache::Release() wont be called for them from
+  // elsewhere.
+  while (to_remove_head != nullptr) {
+    ClockHandle* next = to_remove_head->next;
+    FreeEntry(to_remove_head);
+    to_remove_head = next;
+  }
+  return invalid_entry_count;
+}
+
+}  // end anonymous namespace
+
+template<>
+CacheShard* NewCacheShardInt<Cache::EvictionPolicy::CLOCK>(
+    kudu::MemTracker* mem_tracker, size_t capacity) {
+  return new ClockCacheShard(mem_tracker, capacity);
+}
+
+}  // namespace impala
@@ -0,0 +1,163 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cache/cache.h"
+#include "util/cache/cache-test.h"
+
+#include <memory>
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include "kudu/util/slice.h"
+
+DECLARE_double(tinylfu_window_percentage);
+DECLARE_double(tinylfu_protected_percentage);
+
+namespace impala {
+
+class TinyLFUCacheTest : public CacheBaseTest {
+ public:
+  TinyLFUCacheTest()
+    : CacheBaseTest(100) {
+    FLAGS_tinylfu_window_percentage = 1.0;
+    FLAGS_tinylfu_protected_percentage = 80.0;
+  }
+
+  void SetUp() override {
+    SetupWithParameters(Cache::EvictionPolicy::TINYLFU, ShardingPolicy::SingleShard);
+  }
+
+ protected:
+  // Returns whether 'key' is in the cache without recording an access to it.
+  bool IsResident(int key) { return Lookup(key, Cache::NO_UPDATE) != -1; }
+
+  // Fills the cache with 100 elements (0-99) and verifies that there were no evictions.
+  // Entries 0-98 are admitted to the main area right away, since it is not full yet.
+  // Entry 99 stays in the window, which has room for one entry.
+  void FillCache() {
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(Insert(i, i));
+    }
+    ASSERT_EQ(evicted_keys_.size(), 0);
+    ASSERT_EQ(evicted_values_.size(), 0);
+  }
+};
+
+TEST_F(TinyLFUCacheTest, NewEntryCompetesWithMainArea) {
+  FillCache();
+  // 100 entered the window, pushing 99 out. Both were accessed once, as was the victim
+  // from the main area, 0. Ties favor the victim, so 99 is evicted.
+  ASSERT_TRUE(Insert(100, 100));
+  ASSERT_EQ(evicted_keys_.size(), 1);
+  ASSERT_EQ(evicted_keys_[0], 99);
+  ASSERT_TRUE(IsResident(0));
+  ASSERT_TRUE(IsResident(100));
+
+  // Accesses to 100 make it win against 0 when 101 pushes it out of the window.
+  for (int i = 0; i < 3; ++i) ASSERT_EQ(100, Lookup(100));
+  ASSERT_TRUE(Insert(101, 101));
+  ASSERT_EQ(evicted_keys_.size(), 2);
+  ASSERT_EQ(evicted_keys_[1], 0);
+  ASSERT_EQ(100, Lookup(100));
+  ASSERT_EQ(101, Lookup(101));
+}
+
+TEST_F(TinyLFUCacheTest, MissesCountTowardsAdmission) {
+  FillCache();
+  // Misses on a key which is not in the cache increase its frequency too, e.g. if it was
+  // evicted before.
+  for (int i = 0; i < 3; ++i) ASSERT_EQ(-1, Lookup(200));
+  ASSERT_TRUE(Insert(200, 200));
+  ASSERT_TRUE(Insert(201, 201));
+  ASSERT_TRUE(IsResident(200));
+  ASSERT_FALSE(IsResident(0));
+}
+
+TEST_F(TinyLFUCacheTest, RejectWithoutWindow) {
+  // Without a window, new entries compete for admission when they are inserted. An
+  // insert which loses returns a null handle and the entry is evicted right away.
+  FLAGS_tinylfu_window_percentage = 0.0;
+  SetupWithParameters(Cache::EvictionPolicy::TINYLFU, ShardingPolicy::SingleShard);
+  FillCache();
+  ASSERT_EQ(99, Lookup(99));
+  ASSERT_FALSE(Insert(100, 100));
+  ASSERT_EQ(evicted_keys_.size(), 1);
+  ASSERT_EQ(evicted_keys_[0], 100);
+  ASSERT_FALSE(IsResident(100));
+  for (int i = 0; i < 100; ++i) ASSERT_TRUE(IsResident(i));
+}
+
+TEST_F(TinyLFUCacheTest, ProtectedEntries) {
+  FillCache();
+  // Hits in the main area protect entries. The protected segment has room for 79
+  // entries, so the least recently hit ones are demoted to the probation segment again.
+  for (int i = 0; i < 99; ++i) ASSERT_EQ(i, Lookup(i));
+  // 0-19 are on probation now. Hitting them again protects them and demotes 20-39.
+  for (int i = 0; i < 20; ++i) ASSERT_EQ(i, Lookup(i));
+  // New entries, which were accessed less often, do not displace any of them. 99 is
+  // pushed out of the window and loses against 20.
+  for (int i = 0; i < 20; ++i) ASSERT_TRUE(Insert(1000 + i, 1000 + i));
+  for (int i = 0; i < 99; ++i) ASSERT_TRUE(IsResident(i));
+  ASSERT_FALSE(IsResident(99));
+}
+
+TEST_F(TinyLFUCacheTest, ScanResistance) {
+  // Build up the frequency of a working set which fills the cache.
+  FillCache();
+  for (int i = 0; i < 3; ++i) {
+    for (int key = 0; key < 100; ++key) Lookup(key);
+  }
+  // Scan over three times as many keys as the cache holds. Each is accessed once, like
+  // the data of an ad-hoc full table scan.
+  for (int key = 1000; key < 1300; ++key) {
+    if (Lookup(key) == -1) Insert(key, key);
+  }
+  // Most of the working set is still cached. With LRU, none of it would be.
+  int num_resident = 0;
+  for (int key = 0; key < 100; ++key) num_resident += IsResident(key);
+  ASSERT_GE(num_resident, 90);
+  int num_scan_resident = 0;
+  for (int key = 1000; key < 1300; ++key) num_scan_resident += IsResident(key);
+  ASSERT_LE(num_scan_resident, 10);
+}
+
+TEST_F(TinyLFUCacheTest, Erase) {
+  FillCache();
+  // Erase an entry from the window and one from the main area.
+  Erase(99);
+  Erase(0);
+  ASSERT_EQ(evicted_keys_.size(), 2);
+  ASSERT_FALSE(IsResident(99));
+  ASSERT_FALSE(IsResident(0));
+  // There is room for two new entries now.
+  ASSERT_TRUE(Insert(100, 100));
+  ASSERT_TRUE(Insert(101, 101));
+  ASSERT_EQ(evicted_keys_.size(), 2);
+  ASSERT_TRUE(IsResident(100));
+  ASSERT_TRUE(IsResident(101));
+}
+
+TEST_F(TinyLFUCacheTest, InvalidFlags) {
+  google::FlagSaver saver;
+  FLAGS_tinylfu_window_percentage = 60.0;
+  std::unique_ptr<Cache> cache(
+      NewCache(Cache::EvictionPolicy::TINYLFU, cache_size(), "tinylfu_invalid_test"));
+  ASSERT_FALSE(cache->Init().ok());
+}
+
+} // namespace impala
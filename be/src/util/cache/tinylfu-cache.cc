@@ -0,0 +1,605 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cache/cache.h"
+#include "util/cache/cache-internal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "common/status.h"
+#include "gutil/mathlimits.h"
+#include "gutil/strings/substitute.h"
+#include "kudu/util/alignment.h"
+#include "kudu/util/locks.h"
+#include "kudu/util/malloc.h"
+#include "kudu/util/mem_tracker.h"
+#include "kudu/util/slice.h"
+
+DECLARE_double(cache_memtracker_approximation_ratio);
+DEFINE_double_hidden(tinylfu_window_percentage, 1.00,
+    "Percentage of the TinyLFU cache used for the admission window, which holds new "
+    "entries before they compete for a place in the main area of the cache. This must "
+    "be between 0.0 and 50.0. With 0.0, new entries compete for admission right away.");
+DEFINE_double_hidden(tinylfu_protected_percentage, 80.00,
+    "Percentage of the main area of the TinyLFU cache used for protected entries, i.e. "
+    "entries which were hit since they were admitted. This must be between 0.0 and "
+    "100.0.");
+
+using std::atomic;
+using std::vector;
+
+using kudu::Slice;
+
+using strings::Substitute;
+
+namespace impala {
+
+namespace {
+
+// This implements the W-TinyLFU policy described in "TinyLFU: A Highly Efficient Cache
+// Admission Policy" Gil Einziger, Roy Friedman and Ben Manes 2017.
+//
+// Recency-based policies admit every new entry, so a single scan over more data than
+// the cache holds evicts the whole working set, even though the scanned entries are
+// never accessed again. TinyLFU instead only admits a new entry if it is accessed more
+// frequently than the entry it would evict. The access frequencies of all keys, whether
+// they are in the cache or not, are estimated with a FrequencySketch. The sketch is
+// aged periodically, so that keys which were popular a long time ago do not stay in the
+// cache forever.
+//
+// The cache is split into three segments, each of which is an LRU list:
+// 1. The window holds new entries. It is a small percentage of the cache (see
+//    --tinylfu_window_percentage), which gives new entries a chance to build up
+//    frequency, so that bursts of accesses to new keys still hit.
+// 2. The probation segment holds entries which were admitted from the window.
+// 3. The protected segment holds entries which were hit in the probation segment. When
+//    it is full (see --tinylfu_protected_percentage), its least recently used entries
+//    are demoted to the probation segment.
+// The probation and protected segments form the main area. When an entry is evicted
+// from the window, it becomes a candidate for the main area. If the main area is full,
+// the candidate is compared to the least recently used entry of the main area, the
+// victim. The victim is evicted if the candidate was accessed more frequently,
+// otherwise the candidate is evicted. One-hit-wonders such as the entries of a scan
+// therefore only ever displace other entries of the window.
+
+// Count-min sketch with 4-bit counters. Each key increments one counter in each of the
+// DEPTH rows. The estimated frequency of a key is the minimum of its counters, which
+// overestimates the frequency if the counters are shared with other keys. Each row has
+// COUNTERS_PER_ENTRY counters per cache entry to keep such collisions rare. Once the
+// number of increments reaches SAMPLE_FACTOR times the number of cache entries, all
+// counters are halved. The counters saturate at MAX_COUNT, which is enough to tell
+// frequently accessed keys from rarely accessed ones.
+class FrequencySketch {
+ public:
+  FrequencySketch() : width_(MIN_WIDTH) {
+    for (vector<uint64_t>& row : rows_) row.assign(MIN_WIDTH / COUNTERS_PER_WORD, 0);
+  }
+
+  // Makes the sketch large enough for 'num_entries' entries.
+  void EnsureCapacity(int64_t num_entries) {
+    const int64_t min_width = num_entries * COUNTERS_PER_ENTRY;
+    if (min_width <= width_ || width_ >= MAX_WIDTH) return;
+    int64_t width = width_;
+    while (width < min_width && width < MAX_WIDTH) width *= 2;
+    Resize(width);
+  }
+
+  // Records an access to the key with 'hash'.
+  void Increment(uint32_t hash) {
+    bool incremented = false;
+    for (int row = 0; row < DEPTH; ++row) {
+      const int64_t idx = Index(hash, row);
+      uint64_t& word = rows_[row][idx / COUNTERS_PER_WORD];
+      const int shift = (idx % COUNTERS_PER_WORD) * COUNTER_BITS;
+      if (((word >> shift) & MAX_COUNT) == MAX_COUNT) continue;
+      word += 1ULL << shift;
+      incremented = true;
+    }
+    if (incremented && ++additions_ >= SAMPLE_FACTOR * width_ / COUNTERS_PER_ENTRY) {
+      Age();
+    }
+  }
+
+  // Returns the estimated number of accesses to the key with 'hash'.
+  int Frequency(uint32_t hash) const {
+    int frequency = MAX_COUNT;
+    for (int row = 0; row < DEPTH; ++row) {
+      const int64_t idx = Index(hash, row);
+      const uint64_t word = rows_[row][idx / COUNTERS_PER_WORD];
+      const int shift = (idx % COUNTERS_PER_WORD) * COUNTER_BITS;
+      frequency = std::min(frequency, static_cast<int>((word >> shift) & MAX_COUNT));
+    }
+    return frequency;
+  }
+
+ private:
+  static constexpr int DEPTH = 4;
+  static constexpr int COUNTER_BITS = 4;
+  static constexpr int COUNTERS_PER_WORD = 64 / COUNTER_BITS;
+  static constexpr uint64_t MAX_COUNT = (1ULL << COUNTER_BITS) - 1;
+  static constexpr int64_t COUNTERS_PER_ENTRY = 4;
+  static constexpr int64_t SAMPLE_FACTOR = 10;
+  static constexpr int64_t MIN_WIDTH = 256;
+  static constexpr int64_t MAX_WIDTH = 1LL << 24;
+  // Seeds of the hash functions of the rows.
+  static constexpr uint64_t SEEDS[DEPTH] = {0x97cb3127f6a9ef4bULL,
+      0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL};
+
+  int64_t Index(uint32_t hash, int row) const {
+    // The cache's hash also picks the shard, so mix all of its bits.
+    uint64_t h = hash ^ SEEDS[row];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h & (width_ - 1);
+  }
+
+  // Grows each row to 'width' counters. A key's counter at index i of the grown row was
+  // at index i % width_ before, so copying that counter keeps the frequencies of all keys
+  // overestimated rather than losing them.
+  void Resize(int64_t width) {
+    DCHECK_EQ(width & (width - 1), 0);
+    DCHECK_GT(width, width_);
+    const int64_t old_words = width_ / COUNTERS_PER_WORD;
+    for (vector<uint64_t>& row : rows_) {
+      row.resize(width / COUNTERS_PER_WORD);
+      for (int64_t i = old_words; i < row.size(); ++i) row[i] = row[i % old_words];
+    }
+    width_ = width;
+  }
+
+  // Halves all counters.
+  void Age() {
+    for (vector<uint64_t>& row : rows_) {
+      for (uint64_t& word : row) word = (word >> 1) & 0x7777777777777777ULL;
+    }
+    additions_ /= 2;
+  }
+
+  // Number of counters in each row. Always a power of two.
+  int64_t width_;
+  vector<uint64_t> rows_[DEPTH];
+  // Number of increments since the counters were last halved.
+  int64_t additions_ = 0;
+};
+
+constexpr uint64_t FrequencySketch::SEEDS[];
+
+enum class Segment : uint8_t { NONE, WINDOW, PROBATION, PROTECTED };
+
+class TinyLFUHandle : public HandleBase {
+ public:
+  TinyLFUHandle(uint8_t* kv_ptr, const Slice& key, int32_t hash, int val_len,
+      int charge)
+    : HandleBase(kv_ptr, key, hash, val_len, charge) {
+    refs.store(0);
+  }
+
+  TinyLFUHandle() : HandleBase(nullptr, Slice(), 0, 0, 0) {}
+
+  Cache::EvictionCallback* eviction_callback = nullptr;
+  TinyLFUHandle* next = nullptr;
+  TinyLFUHandle* prev = nullptr;
+  Segment segment = Segment::NONE;
+  std::atomic<int32_t> refs;
+};
+
+// An LRU list of entries of one segment. The dummy head's 'next' is the least recently
+// used entry and its 'prev' the most recently used one.
+struct SegmentList {
+  SegmentList() {
+    head.next = &head;
+    head.prev = &head;
+  }
+
+  bool empty() const { return head.next == &head; }
+
+  TinyLFUHandle head;
+  size_t usage = 0;
+};
+
+class TinyLFUCacheShard : public CacheShard {
+ public:
+  TinyLFUCacheShard(kudu::MemTracker* tracker, size_t capacity);
+  ~TinyLFUCacheShard();
+
+  Status Init() override;
+  HandleBase* Allocate(Slice key, uint32_t hash, int val_len, int charge) override;
+  void Free(HandleBase* handle) override;
+  HandleBase* Insert(HandleBase* handle,
+      Cache::EvictionCallback* eviction_callback) override;
+  HandleBase* Lookup(const Slice& key, uint32_t hash, bool no_updates) override;
+  void Release(HandleBase* handle) override;
+  void Erase(const Slice& key, uint32_t hash) override;
+  size_t Invalidate(const Cache::InvalidationControl& ctl) override;
+
+ private:
+  SegmentList* GetList(Segment segment);
+  // Appends 'e' as the most recently used entry of 'segment'.
+  void Append(TinyLFUHandle* e, Segment segment);
+  // Removes 'e' from the list of its segment.
+  void Remove(TinyLFUHandle* e);
+  // Removes 'e', which is not in any segment, from the table and adds it to
+  // 'to_remove_head' if this was the last reference.
+  void Drop(TinyLFUHandle* e, TinyLFUHandle** to_remove_head);
+  // Removes 'e' from its segment and drops it.
+  void Evict(TinyLFUHandle* e, TinyLFUHandle** to_remove_head);
+  // Demotes protected entries to the probation segment until the protected segment is
+  // within its capacity.
+  void DemoteProtected();
+  // Moves entries from the window to the main area, or evicts them, until the window is
+  // within its capacity.
+  void EvictFromWindow(TinyLFUHandle** to_remove_head);
+  // Just reduce the reference count by 1. Return true if last reference.
+  bool Unref(TinyLFUHandle* e);
+  // Call the user's eviction callback, if it exists, and free the entry.
+  void FreeEntry(TinyLFUHandle* e);
+  // Update the memtracker's consumption by the given amount. See RLCacheShard.
+  void UpdateMemTracker(int64_t delta);
+
+  size_t main_usage() const { return probation_.usage + protected_.usage; }
+
+  bool initialized_ = false;
+
+  const size_t capacity_;
+  size_t window_capacity_ = 0;
+  size_t main_capacity_ = 0;
+  size_t protected_capacity_ = 0;
+
+  // mutex_ protects the following state.
+  kudu::simple_spinlock mutex_;
+  SegmentList window_;
+  SegmentList probation_;
+  SegmentList protected_;
+  int64_t num_entries_ = 0;
+  FrequencySketch sketch_;
+  HandleTable table_;
+
+  kudu::MemTracker* mem_tracker_;
+  atomic<int64_t> deferred_consumption_ { 0 };
+  int64_t max_deferred_consumption_ = 0;
+};
+
+TinyLFUCacheShard::TinyLFUCacheShard(kudu::MemTracker* tracker, size_t capacity)
+  : capacity_(capacity),
+    mem_tracker_(tracker) {
+}
+
+TinyLFUCacheShard::~TinyLFUCacheShard() {
+  for (SegmentList* list : {&window_, &probation_, &protected_}) {
+    for (TinyLFUHandle* e = list->head.next; e != &list->head; ) {
+      TinyLFUHandle* next = e->next;
+      DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 1)
+          << "caller has an unreleased handle";
+      table_.Remove(e->key(), e->hash());
+      e->next = nullptr;
+      e->prev = nullptr;
+      e->segment = Segment::NONE;
+      if (Unref(e)) FreeEntry(e);
+      e = next;
+    }
+  }
+  mem_tracker_->Consume(deferred_consumption_);
+}
+
+Status TinyLFUCacheShard::Init() {
+  if (!MathLimits<double>::IsFinite(FLAGS_cache_memtracker_approximation_ratio) ||
+      FLAGS_cache_memtracker_approximation_ratio < 0.0 ||
+      FLAGS_cache_memtracker_approximation_ratio > 1.0) {
+    return Status(Substitute("Misconfigured --cache_memtracker_approximation_ratio: $0. "
+        "Must be between 0 and 1.", FLAGS_cache_memtracker_approximation_ratio));
+  }
+  if (!MathLimits<double>::IsFinite(FLAGS_tinylfu_window_percentage) ||
+      FLAGS_tinylfu_window_percentage < 0.0 ||
+      FLAGS_tinylfu_window_percentage > 50.0) {
+    return Status(Substitute("Misconfigured --tinylfu_window_percentage: $0. "
+        "Must be between 0 and 50.", FLAGS_tinylfu_window_percentage));
+  }
+  if (!MathLimits<double>::IsFinite(FLAGS_tinylfu_protected_percentage) ||
+      FLAGS_tinylfu_protected_percentage < 0.0 ||
+      FLAGS_tinylfu_protected_percentage > 100.0) {
+    return Status(Substitute("Misconfigured --tinylfu_protected_percentage: $0. "
+        "Must be between 0 and 100.", FLAGS_tinylfu_protected_percentage));
+  }
+  window_capacity_ = capacity_ * (FLAGS_tinylfu_window_percentage / 100.0);
+  main_capacity_ = capacity_ - window_capacity_;
+  protected_capacity_ = main_capacity_ * (FLAGS_tinylfu_protected_percentage / 100.0);
+  max_deferred_consumption_ = capacity_ * FLAGS_cache_memtracker_approximation_ratio;
+  initialized_ = true;
+  return Status::OK();
+}
+
+SegmentList* TinyLFUCacheShard::GetList(Segment segment) {
+  switch (segment) {
+    case Segment::WINDOW: return &window_;
+    case Segment::PROBATION: return &probation_;
+    case Segment::PROTECTED: return &protected_;
+    default:
+      DCHECK(false) << "entry is not in the cache";
+      return nullptr;
+  }
+}
+
+void TinyLFUCacheShard::Append(TinyLFUHandle* e, Segment segment) {
+  DCHECK(e->segment == Segment::NONE);
+  SegmentList* list = GetList(segment);
+  e->next = &list->head;
+  e->prev = list->head.prev;
+  e->prev->next = e;
+  e->next->prev = e;
+  e->segment = segment;
+  list->usage += e->charge();
+}
+
+void TinyLFUCacheShard::Remove(TinyLFUHandle* e) {
+  SegmentList* list = GetList(e->segment);
+  e->next->prev = e->prev;
+  e->prev->next = e->next;
+  e->next = nullptr;
+  e->prev = nullptr;
+  e->segment = Segment::NONE;
+  DCHECK_GE(list->usage, e->charge());
+  list->usage -= e->charge();
+}
+
+void TinyLFUCacheShard::Drop(TinyLFUHandle* e, TinyLFUHandle** to_remove_head) {
+  DCHECK(e->segment == Segment::NONE);
+  table_.Remove(e->key(), e->hash());
+  --num_entries_;
+  if (Unref(e)) {
+    e->next = *to_remove_head;
+    *to_remove_head = e;
+  }
+}
+
+void TinyLFUCacheShard::Evict(TinyLFUHandle* e, TinyLFUHandle** to_remove_head) {
+  Remove(e);
+  Drop(e, to_remove_head);
+}
+
+void TinyLFUCacheShard::DemoteProtected() {
+  while (protected_.usage > protected_capacity_) {
+    TinyLFUHandle* e = protected_.head.next;
+    Remove(e);
+    Append(e, Segment::PROBATION);
+  }
+}
+
+void TinyLFUCacheShard::EvictFromWindow(TinyLFUHandle** to_remove_head) {
+  while (window_.usage > window_capacity_) {
+    TinyLFUHandle* candidate = window_.head.next;
+    Remove(candidate);
+    if (candidate->charge() > main_capacity_) {
+      Drop(candidate, to_remove_head);
+      continue;
+    }
+    // Evict victims from the main area as long as the candidate is accessed more
+    // frequently. Ties favor the victim, which has proven itself already.
+    const int candidate_frequency = sketch_.Frequency(candidate->hash());
+    bool admit = true;
+    while (main_usage() + candidate->charge() > main_capacity_) {
+      TinyLFUHandle* victim =
+          probation_.empty() ? protected_.head.next : probation_.head.next;
+      if (candidate_frequency <= sketch_.Frequency(victim->hash())) {
+        admit = false;
+        break;
+      }
+      Evict(victim, to_remove_head);
+    }
+    if (admit) {
+      Append(candidate, Segment::PROBATION);
+    } else {
+      Drop(candidate, to_remove_head);
+    }
+  }
+}
+
+bool TinyLFUCacheShard::Unref(TinyLFUHandle* e) {
+  DCHECK_GT(e->refs.load(std::memory_order_relaxed), 0);
+  return e->refs.fetch_sub(1) == 1;
+}
+
+void TinyLFUCacheShard::FreeEntry(TinyLFUHandle* e) {
+  DCHECK_EQ(e->refs.load(std::memory_order_relaxed), 0);
+  if (e->eviction_callback) {
+    e->eviction_callback->EvictedEntry(e->key(), e->value());
+  }
+  UpdateMemTracker(-static_cast<int64_t>(e->charge()));
+  Free(e);
+}
+
+void TinyLFUCacheShard::UpdateMemTracker(int64_t delta) {
+  int64_t old_deferred = deferred_consumption_.fetch_add(delta);
+  int64_t new_deferred = old_deferred + delta;
+
+  if (new_deferred > max_deferred_consumption_ ||
+      new_deferred < -max_deferred_consumption_) {
+    int64_t to_propagate = deferred_consumption_.exchange(0, std::memory_order_relaxed);
+    mem_tracker_->Consume(to_propagate);
+  }
+}
+
+HandleBase* TinyLFUCacheShard::Allocate(Slice key, uint32_t hash, int val_len,
+    int charge) {
+  DCHECK(initialized_);
+  int key_len = key.size();
+  DCHECK_GE(key_len, 0);
+  DCHECK_GE(val_len, 0);
+  int key_len_padded = KUDU_ALIGN_UP(key_len, sizeof(void*));
+  uint8_t* buf = new uint8_t[sizeof(TinyLFUHandle)
+                             + key_len_padded + val_len]; // the kv_data VLA data
+  int calc_charge =
+    (charge == Cache::kAutomaticCharge) ? kudu::kudu_malloc_usable_size(buf) : charge;
+  uint8_t* kv_ptr = buf + sizeof(TinyLFUHandle);
+  return new (buf) TinyLFUHandle(kv_ptr, key, hash, val_len, calc_charge);
+}
+
+void TinyLFUCacheShard::Free(HandleBase* handle) {
+  DCHECK(initialized_);
+  // We allocate the handle as a uint8_t array, then we call a placement new,
+  // which calls the constructor. For symmetry, we call the destructor and then
+  // delete on the uint8_t array.
+  TinyLFUHandle* h = static_cast<TinyLFUHandle*>(handle);
+  h->~TinyLFUHandle();
+  uint8_t* data = reinterpret_cast<uint8_t*>(handle);
+  delete [] data;
+}
+
+HandleBase* TinyLFUCacheShard::Lookup(const Slice& key, uint32_t hash,
+    bool no_updates) {
+  DCHECK(initialized_);
+  std::lock_guard<decltype(mutex_)> l(mutex_);
+  TinyLFUHandle* e = static_cast<TinyLFUHandle*>(table_.Lookup(key, hash));
+  // Misses count towards the frequency too, since the key is usually inserted next.
+  if (!no_updates) sketch_.Increment(hash);
+  if (e == nullptr) return nullptr;
+  e->refs.fetch_add(1, std::memory_order_relaxed);
+  if (no_updates) return e;
+  const Segment segment = e->segment;
+  Remove(e);
+  if (segment == Segment::WINDOW) {
+    Append(e, Segment::WINDOW);
+  } else {
+    // Entries hit in the main area are protected.
+    Append(e, Segment::PROTECTED);
+    DemoteProtected();
+  }
+  return e;
+}
+
+void TinyLFUCacheShard::Release(HandleBase* handle) {
+  DCHECK(initialized_);
+  TinyLFUHandle* e = static_cast<TinyLFUHandle*>(handle);
+  if (Unref(e)) FreeEntry(e);
+}
+
+HandleBase* TinyLFUCacheShard::Insert(HandleBase* handle_in,
+    Cache::EvictionCallback* eviction_callback) {
+  DCHECK(initialized_);
+  TinyLFUHandle* handle = static_cast<TinyLFUHandle*>(handle_in);
+  handle->eviction_callback = eviction_callback;
+  // Two refs for the handle: one from TinyLFUCacheShard, one for the returned handle.
+  handle->refs.store(2, std::memory_order_relaxed);
+  UpdateMemTracker(handle->charge());
+
+  TinyLFUHandle* to_remove_head = nullptr;
+  bool rejected;
+  {
+    std::lock_guard<decltype(mutex_)> l(mutex_);
+    sketch_.Increment(handle->hash());
+    TinyLFUHandle* old = static_cast<TinyLFUHandle*>(table_.Insert(handle));
+    if (old != nullptr) {
+      Remove(old);
+      if (Unref(old)) {
+        old->next = to_remove_head;
+        to_remove_head = old;
+      }
+    } else {
+      ++num_entries_;
+      sketch_.EnsureCapacity(num_entries_);
+    }
+    Append(handle, Segment::WINDOW);
+    EvictFromWindow(&to_remove_head);
+    rejected = handle->segment == Segment::NONE;
+  }
+
+  // We free the entries here outside of mutex for performance reasons.
+  while (to_remove_head != nullptr) {
+    TinyLFUHandle* next = to_remove_head->next;
+    FreeEntry(to_remove_head);
+    to_remove_head = next;
+  }
+  // The new entry lost against the main area. Drop the reference of the caller too.
+  if (rejected) {
+    if (Unref(handle)) FreeEntry(handle);
+    return nullptr;
+  }
+  return handle;
+}
+
+void TinyLFUCacheShard::Erase(const Slice& key, uint32_t hash) {
+  DCHECK(initialized_);
+  TinyLFUHandle* e;
+  bool last_reference = false;
+  {
+    std::lock_guard<decltype(mutex_)> l(mutex_);
+    e = static_cast<TinyLFUHandle*>(table_.Remove(key, hash));
+    if (e != nullptr) {
+      Remove(e);
+      --num_entries_;
+      last_reference = Unref(e);
+    }
+  }
+  // last_reference will only be true if e != NULL
+  if (last_reference) FreeEntry(e);
+}
+
+size_t TinyLFUCacheShard::Invalidate(const Cache::InvalidationControl& ctl) {
+  DCHECK(initialized_);
+  size_t invalid_entry_count = 0;
+  size_t valid_entry_count = 0;
+  TinyLFUHandle* to_remove_head = nullptr;
+  {
+    std::lock_guard<decltype(mutex_)> l(mutex_);
+    // Iterate over the window, then the main area from the probation to the protected
+    // entries, each from the least to the most recently used entry.
+    for (SegmentList* list : {&window_, &probation_, &protected_}) {
+      TinyLFUHandle* h = list->head.next;
+      while (h != &list->head &&
+             ctl.iteration_func(valid_entry_count, invalid_entry_count)) {
+        TinyLFUHandle* next = h->next;
+        if (ctl.validity_func(h->key(), h->value())) {
+          ++valid_entry_count;
+        } else {
+          Evict(h, &to_remove_head);
+          ++invalid_entry_count;
+        }
+        h = next;
+      }
+    }
+  }
+  // Once removed from the lookup table and the segments, the entries with no references
+  // left must be deallocated because Cache::Release() wont be called for them from
+  // elsewhere.
+  while (to_remove_head != nullptr) {
+    TinyLFUHandle* next = to_remove_head->next;
+    FreeEntry(to_remove_head);
+    to_remove_head = next;
+  }
+  return invalid_entry_count;
+}
+
+}  // end anonymous namespace
+
+template<>
+CacheShard* NewCacheShardInt<Cache::EvictionPolicy::TINYLFU>(
+    kudu::MemTracker* mem_tracker, size_t capacity) {
+  return new TinyLFUCacheShard(mem_tracker, capacity);
+}
+
+}  // namespace impala
@@ -55,6 +55,7 @@ Status CGroupUtil::FindGlobalCGroup(const string& subsystem, string* path) {
     // The line format looks like this:
     // 4:memory:/user.slice
     // 9:cpu,cpuacct:/user.slice
+    // 0::/user.slice (cgroup v2, which has no subsystem list)
     getline(proc_cgroups, line);
     if (!proc_cgroups.good()) continue;
     vector<string> fields;
@@ -67,6 +68,11 @@ Status CGroupUtil::FindGlobalCGroup(const string& subsystem, string* path) {
           "Could not parse line from /proc/self/cgroup - had $0 > 3 tokens: '$1'",
           fields.size(), line));
     }
+    if (subsystem.empty()) {
+      if (fields[0] != "0" || !fields[1].empty()) continue;
+      *path = move(fields[2]);
+      return Status::OK();
+    }
     vector<string> subsystems;
     split(subsystems, fields[1], is_any_of(","));
     auto it = std::find(subsystems.begin(), subsystems.end(), subsystem);
@@ -110,12 +116,17 @@ Status CGroupUtil::FindCGroupMounts(
     split(fields, line, is_any_of(" "), token_compress_on);
     DCHECK_GE(fields.size(), 7);
 
-    if (fields[fields.size() - 3] != "cgroup") continue;
-    // This is a cgroup mount. Check if it's the mount we're looking for.
-    vector<string> cgroup_opts;
-    split(cgroup_opts, fields[fields.size() - 1], is_any_of(","), token_compress_on);
-    auto it = std::find(cgroup_opts.begin(), cgroup_opts.end(), subsystem);
-    if (it == cgroup_opts.end()) continue;
+    if (subsystem.empty()) {
+      // The cgroup v2 hierarchy is a single mount that covers all controllers.
+      if (fields[fields.size() - 3] != "cgroup2") continue;
+    } else {
+      if (fields[fields.size() - 3] != "cgroup") continue;
+      // This is a cgroup mount. Check if it's the mount we're looking for.
+      vector<string> cgroup_opts;
+      split(cgroup_opts, fields[fields.size() - 1], is_any_of(","), token_compress_on);
+      auto it = std::find(cgroup_opts.begin(), cgroup_opts.end(), subsystem);
+      if (it == cgroup_opts.end()) continue;
+    }
     // This is the right mount.
     string mount_path, system_path;
     RETURN_IF_ERROR(UnescapePath(fields[4], &mount_path));
@@ -142,6 +153,10 @@ Status CGroupUtil::FindAbsCGroupPath(const string& subsystem, string* path) {
   return Status::OK();
 }
 
+Status CGroupUtil::FindCGroupV2Path(string* path) {
+  return FindAbsCGroupPath("", path);
+}
+
 Status CGroupUtil::FindCGroupMemLimit(int64_t* bytes) {
   string cgroup_path;
   RETURN_IF_ERROR(FindAbsCGroupPath("memory", &cgroup_path));
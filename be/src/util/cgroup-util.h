@@ -33,6 +33,10 @@ class CGroupUtil {
   /// set on any ancestor CGroups.
   static Status FindCGroupMemLimit(int64_t* bytes);
 
+  /// Returns the absolute path to the cgroup v2 (unified hierarchy) cgroup of the
+  /// current process, e.g. "/sys/fs/cgroup/system.slice/impalad.service".
+  static Status FindCGroupV2Path(std::string* path);
+
   /// Returns a human-readable string with information about CGroups.
   static std::string DebugString();
 
@@ -41,7 +45,7 @@ class CGroupUtil {
   /// Finds the path of the cgroup of 'subsystem' for the current process.
   /// E.g. FindGlobalCGroup("memory") will return the memory cgroup
   /// that this process belongs to. This is a path relative to the system-wide root
-  /// cgroup for 'subsystem'.
+  /// cgroup for 'subsystem'. An empty 'subsystem' stands for the cgroup v2 hierarchy.
   static Status FindGlobalCGroup(const std::string& subsystem, std::string* path);
 
   /// Returns the absolute path to the CGroup from inside the container.
@@ -55,7 +59,8 @@ class CGroupUtil {
   /// the full path relative to the system-wide cgroups outside of the container.
   /// E.g. /sys/fs/cgroup/memory/kubepods/burstable/pod-<long unique id> may be mounted at
   /// /sys/fs/cgroup/memory inside the container. In that case this function would return
-  /// ("/sys/fs/cgroup/memory", "kubepods/burstable/pod-<long unique id>").
+  /// ("/sys/fs/cgroup/memory", "kubepods/burstable/pod-<long unique id>"). An empty
+  /// 'subsystem' stands for the cgroup v2 hierarchy, which is mounted as "cgroup2".
   static Status FindCGroupMounts(
       const std::string& subsystem, std::pair<std::string, std::string>* result);
 };
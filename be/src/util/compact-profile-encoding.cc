@@ -0,0 +1,356 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/compact-profile-encoding.h"
+
+#include <unordered_map>
+
+#include "common/logging.h"
+#include "gen-cpp/RuntimeProfile_types.h"
+#include "rpc/thrift-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// The encoding consists of the following streams, each prefixed by its length:
+// THRIFT:    the profile without counters, aggregated counters and child counter maps.
+// STRINGS:   the number of strings, followed by the length and bytes of every string.
+// STRUCTURE: for every node, the number of counters and the name of every counter,
+//            the number of aggregated counters plus one (or 0 if the node has none)
+//            and the name and number of values of every aggregated counter, and the
+//            number of child counter map entries and for every entry the name of the
+//            parent, the number of children and the name of every child.
+// UNITS:     the unit of every counter and aggregated counter.
+// VALUES:    the delta encoded values of all counters and aggregated counters.
+// HAS_VALUE: a bitmap of the 'has_value' flags of all aggregated counters.
+// All integers, apart from the units and the bitmap, are varints.
+enum Stream { THRIFT, STRINGS, STRUCTURE, UNITS, VALUES, HAS_VALUE, NUM_STREAMS };
+
+static inline void PutVarint(uint64_t v, vector<uint8_t>* out) {
+  while (v >= 0x80) {
+    out->push_back(static_cast<uint8_t>(v) | 0x80);
+    v >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(v));
+}
+
+static inline void PutZigZag(int64_t v, vector<uint8_t>* out) {
+  PutVarint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63), out);
+}
+
+static inline void PutStream(const vector<uint8_t>& stream, vector<uint8_t>* out) {
+  PutVarint(stream.size(), out);
+  out->insert(out->end(), stream.begin(), stream.end());
+}
+
+/// Returns the difference of 'value' and 'prev' with wrap-around on overflow.
+static inline int64_t Delta(int64_t value, int64_t prev) {
+  return static_cast<int64_t>(static_cast<uint64_t>(value) - static_cast<uint64_t>(prev));
+}
+
+static inline int64_t ApplyDelta(int64_t prev, int64_t delta) {
+  return static_cast<int64_t>(static_cast<uint64_t>(prev) + static_cast<uint64_t>(delta));
+}
+
+namespace {
+
+/// Interns strings and tracks the previous value of the counters with each name.
+class StringTable {
+ public:
+  int64_t Intern(const string& s) {
+    auto it = ids_.emplace(s, strings_.size());
+    if (it.second) {
+      strings_.push_back(&it.first->first);
+      prev_values_.push_back(0);
+    }
+    return it.first->second;
+  }
+
+  /// Returns the delta of 'value' for the counter with 'id' and records 'value'.
+  int64_t NextDelta(int64_t id, int64_t value) {
+    int64_t delta = Delta(value, prev_values_[id]);
+    prev_values_[id] = value;
+    return delta;
+  }
+
+  void Serialize(vector<uint8_t>* out) const {
+    PutVarint(strings_.size(), out);
+    for (const string* s : strings_) {
+      PutVarint(s->size(), out);
+      out->insert(out->end(), s->begin(), s->end());
+    }
+  }
+
+ private:
+  std::unordered_map<string, int64_t> ids_;
+  /// The keys of 'ids_' in the order of their ids.
+  vector<const string*> strings_;
+  vector<int64_t> prev_values_;
+};
+
+/// Reads varints from a stream and fails on the first read past its end.
+class StreamReader {
+ public:
+  StreamReader() = default;
+  StreamReader(const uint8_t* buf, int64_t len) : pos_(buf), end_(buf + len) {}
+
+  const uint8_t* pos() const { return pos_; }
+  int64_t remaining() const { return end_ - pos_; }
+
+  bool GetVarint(uint64_t* v) {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (UNLIKELY(pos_ == end_)) return false;
+      uint8_t byte = *pos_++;
+      result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) {
+        *v = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// Reads a count or an index, which must be less than or equal to 'max'.
+  bool GetCount(uint64_t max, int64_t* v) {
+    uint64_t result;
+    if (UNLIKELY(!GetVarint(&result) || result > max)) return false;
+    *v = static_cast<int64_t>(result);
+    return true;
+  }
+
+  bool GetZigZag(int64_t* v) {
+    uint64_t result;
+    if (UNLIKELY(!GetVarint(&result))) return false;
+    *v = static_cast<int64_t>((result >> 1) ^ -(result & 1));
+    return true;
+  }
+
+  bool GetByte(uint8_t* v) {
+    if (UNLIKELY(pos_ == end_)) return false;
+    *v = *pos_++;
+    return true;
+  }
+
+  /// Skips 'len' bytes, which must not exceed remaining().
+  void Skip(int64_t len) {
+    DCHECK_LE(len, remaining());
+    pos_ += len;
+  }
+
+  /// Reads the next length-prefixed stream into 'stream'.
+  bool GetStream(StreamReader* stream) {
+    int64_t len;
+    if (!GetCount(remaining(), &len)) return false;
+    *stream = StreamReader(pos_, len);
+    Skip(len);
+    return true;
+  }
+
+  /// Returns the next bit of a bitmap, least significant bit first.
+  bool GetBit(bool* v) {
+    if (bit_idx_ == 0 && !GetByte(&bits_)) return false;
+    *v = (bits_ >> bit_idx_) & 1;
+    bit_idx_ = (bit_idx_ + 1) % 8;
+    return true;
+  }
+
+ private:
+  const uint8_t* pos_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  uint8_t bits_ = 0;
+  int bit_idx_ = 0;
+};
+
+/// Appends bits to a bitmap, least significant bit first.
+class BitmapWriter {
+ public:
+  void Put(bool v) {
+    if (num_bits_ % 8 == 0) bitmap_.push_back(0);
+    if (v) bitmap_.back() |= 1 << (num_bits_ % 8);
+    ++num_bits_;
+  }
+
+  const vector<uint8_t>& bitmap() const { return bitmap_; }
+
+ private:
+  vector<uint8_t> bitmap_;
+  int64_t num_bits_ = 0;
+};
+
+}
+
+Status CompactProfileEncoding::Encode(
+    TRuntimeProfileTree* profile, vector<uint8_t>* out) {
+  StringTable strings;
+  vector<uint8_t> streams[NUM_STREAMS];
+  vector<uint8_t>* structure = &streams[STRUCTURE];
+  vector<uint8_t>* units = &streams[UNITS];
+  vector<uint8_t>* values = &streams[VALUES];
+  BitmapWriter has_value;
+  for (TRuntimeProfileNode& node : profile->nodes) {
+    PutVarint(node.counters.size(), structure);
+    for (const TCounter& counter : node.counters) {
+      int64_t id = strings.Intern(counter.name);
+      PutVarint(id, structure);
+      units->push_back(static_cast<uint8_t>(counter.unit));
+      PutZigZag(strings.NextDelta(id, counter.value), values);
+    }
+    node.counters.clear();
+
+    if (node.__isset.aggregated && node.aggregated.__isset.counters) {
+      vector<TAggCounter>& agg_counters = node.aggregated.counters;
+      PutVarint(agg_counters.size() + 1, structure);
+      for (const TAggCounter& counter : agg_counters) {
+        DCHECK_EQ(counter.has_value.size(), counter.values.size());
+        int64_t id = strings.Intern(counter.name);
+        PutVarint(id, structure);
+        PutVarint(counter.values.size(), structure);
+        units->push_back(static_cast<uint8_t>(counter.unit));
+        for (int i = 0; i < counter.values.size(); ++i) {
+          has_value.Put(i < counter.has_value.size() && counter.has_value[i]);
+          PutZigZag(strings.NextDelta(id, counter.values[i]), values);
+        }
+      }
+      agg_counters.clear();
+    } else {
+      PutVarint(0, structure);
+    }
+
+    PutVarint(node.child_counters_map.size(), structure);
+    for (const auto& entry : node.child_counters_map) {
+      PutVarint(strings.Intern(entry.first), structure);
+      PutVarint(entry.second.size(), structure);
+      for (const string& child : entry.second) {
+        PutVarint(strings.Intern(child), structure);
+      }
+    }
+    node.child_counters_map.clear();
+  }
+
+  ThriftSerializer serializer(true);
+  RETURN_IF_ERROR(serializer.SerializeToVector(profile, &streams[THRIFT]));
+  strings.Serialize(&streams[STRINGS]);
+  streams[HAS_VALUE] = has_value.bitmap();
+  for (const vector<uint8_t>& stream : streams) PutStream(stream, out);
+  return Status::OK();
+}
+
+/// Decodes the string table in 'stream' into 'strings'. Every string takes at least one
+/// byte for its length, which bounds the number of strings.
+static bool DecodeStrings(StreamReader* stream, vector<string>* strings) {
+  int64_t num_strings;
+  if (!stream->GetCount(stream->remaining(), &num_strings)) return false;
+  strings->resize(num_strings);
+  for (string& s : *strings) {
+    int64_t len;
+    if (!stream->GetCount(stream->remaining(), &len)) return false;
+    s.assign(reinterpret_cast<const char*>(stream->pos()), len);
+    stream->Skip(len);
+  }
+  return true;
+}
+
+/// Restores the counters, aggregated counters and child counter maps of the nodes in
+/// 'profile' from 'streams'.
+static bool DecodeCounters(const vector<string>& strings, StreamReader* streams,
+    TRuntimeProfileTree* profile) {
+  StreamReader* structure = &streams[STRUCTURE];
+  StreamReader* units = &streams[UNITS];
+  StreamReader* values = &streams[VALUES];
+  StreamReader* has_value = &streams[HAS_VALUE];
+  const uint64_t max_id = strings.empty() ? 0 : strings.size() - 1;
+  vector<int64_t> prev_values(strings.size(), 0);
+  int64_t id;
+  int64_t delta;
+  uint8_t unit;
+  for (TRuntimeProfileNode& node : profile->nodes) {
+    int64_t num_counters;
+    if (!structure->GetCount(units->remaining(), &num_counters)) return false;
+    node.counters.resize(num_counters);
+    for (TCounter& counter : node.counters) {
+      if (strings.empty() || !structure->GetCount(max_id, &id)) return false;
+      if (!units->GetByte(&unit) || !values->GetZigZag(&delta)) return false;
+      counter.name = strings[id];
+      counter.unit = static_cast<TUnit::type>(unit);
+      counter.value = prev_values[id] = ApplyDelta(prev_values[id], delta);
+    }
+
+    int64_t num_agg_counters;
+    if (!structure->GetCount(units->remaining() + 1, &num_agg_counters)) return false;
+    if (num_agg_counters > 0) {
+      if (!node.__isset.aggregated) return false;
+      vector<TAggCounter>& agg_counters = node.aggregated.counters;
+      agg_counters.resize(num_agg_counters - 1);
+      node.aggregated.__isset.counters = true;
+      for (TAggCounter& counter : agg_counters) {
+        int64_t num_values;
+        if (strings.empty() || !structure->GetCount(max_id, &id)) return false;
+        if (!structure->GetCount(values->remaining(), &num_values)) return false;
+        if (!units->GetByte(&unit)) return false;
+        counter.name = strings[id];
+        counter.unit = static_cast<TUnit::type>(unit);
+        counter.has_value.resize(num_values);
+        counter.values.resize(num_values);
+        for (int64_t i = 0; i < num_values; ++i) {
+          bool bit;
+          if (!has_value->GetBit(&bit) || !values->GetZigZag(&delta)) return false;
+          counter.has_value[i] = bit;
+          counter.values[i] = prev_values[id] = ApplyDelta(prev_values[id], delta);
+        }
+      }
+    }
+
+    int64_t num_entries;
+    if (!structure->GetCount(structure->remaining(), &num_entries)) return false;
+    for (int64_t i = 0; i < num_entries; ++i) {
+      int64_t num_children;
+      if (strings.empty() || !structure->GetCount(max_id, &id)) return false;
+      if (!structure->GetCount(structure->remaining(), &num_children)) return false;
+      set<string>& children = node.child_counters_map.emplace_hint(
+          node.child_counters_map.end(), strings[id], set<string>())->second;
+      for (int64_t j = 0; j < num_children; ++j) {
+        if (!structure->GetCount(max_id, &id)) return false;
+        children.insert(children.end(), strings[id]);
+      }
+    }
+  }
+  return structure->remaining() == 0 && units->remaining() == 0
+      && values->remaining() == 0;
+}
+
+static Status CorruptError() {
+  return Status("Invalid compact runtime profile encoding");
+}
+
+Status CompactProfileEncoding::Decode(
+    const uint8_t* buf, int64_t len, TRuntimeProfileTree* out) {
+  StreamReader payload(buf, len);
+  StreamReader streams[NUM_STREAMS];
+  for (StreamReader& stream : streams) {
+    if (!payload.GetStream(&stream)) return CorruptError();
+  }
+  uint32_t thrift_len = streams[THRIFT].remaining();
+  RETURN_IF_ERROR(DeserializeThriftMsg(streams[THRIFT].pos(), &thrift_len, true, out));
+  vector<string> strings;
+  if (!DecodeStrings(&streams[STRINGS], &strings)) return CorruptError();
+  if (!DecodeCounters(strings, streams, out)) return CorruptError();
+  return Status::OK();
+}
+
+}
@@ -0,0 +1,57 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/status.h"
+
+namespace impala {
+
+class TRuntimeProfileTree;
+
+/// Compact binary encoding of a TRuntimeProfileTree, used to keep the profiles of
+/// archived queries in memory.
+///
+/// Counters make up most of a profile and the Thrift encoding repeats the name of every
+/// counter in every node, and for aggregated counters stores one value per instance.
+/// This encoding stores the counters, aggregated counters and child counter maps of all
+/// nodes in separate columns instead:
+/// - names are interned in a string table and referenced by their index,
+/// - units are stored in one byte each,
+/// - values are zig-zag varints, delta encoded against the previous value of a counter
+///   with the same name, i.e. the same counter in a sibling node or the previous
+///   instance of an aggregated counter,
+/// - the 'has_value' flags of aggregated counters are packed into a bitmap.
+/// The remaining fields of the nodes are encoded with the Thrift compact protocol.
+///
+/// The encoding is not compressed and not meant to be persisted, since it may change
+/// between versions. See RuntimeProfile::CompressCompact().
+class CompactProfileEncoding {
+ public:
+  /// Appends the encoding of 'profile' to 'out'. The counters, aggregated counters and
+  /// child counter maps are moved out of 'profile', the rest of it is left unchanged.
+  static Status Encode(TRuntimeProfileTree* profile, std::vector<uint8_t>* out);
+
+  /// Decodes the 'len' bytes at 'buf', which were encoded by Encode(), into 'out'.
+  /// Returns an error if the encoding is invalid.
+  static Status Decode(const uint8_t* buf, int64_t len, TRuntimeProfileTree* out);
+};
+
+}
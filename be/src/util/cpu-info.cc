@@ -74,6 +74,9 @@ const int64_t CpuInfo::POPCNT;
 const int64_t CpuInfo::AVX;
 const int64_t CpuInfo::AVX2;
 const int64_t CpuInfo::PCLMULQDQ;
+const int64_t CpuInfo::AVX512F;
+const int64_t CpuInfo::AVX512BW;
+const int64_t CpuInfo::AVX512VBMI;
 
 bool CpuInfo::initialized_ = false;
 int64_t CpuInfo::hardware_flags_ = 0;
@@ -98,7 +101,10 @@ static struct {
   { "popcnt",    CpuInfo::POPCNT },
   { "avx",       CpuInfo::AVX },
   { "avx2",      CpuInfo::AVX2 },
-  { "pclmulqdq", CpuInfo::PCLMULQDQ }
+  { "pclmulqdq", CpuInfo::PCLMULQDQ },
+  { "avx512f",   CpuInfo::AVX512F },
+  { "avx512bw",  CpuInfo::AVX512BW },
+  { "avx512vbmi", CpuInfo::AVX512VBMI }
 };
 static const long num_flags = sizeof(flag_mappings) / sizeof(flag_mappings[0]);
 
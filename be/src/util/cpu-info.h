@@ -40,6 +40,9 @@ class CpuInfo {
   static const int64_t AVX       = (1 << 5);
   static const int64_t AVX2      = (1 << 6);
   static const int64_t PCLMULQDQ = (1 << 7);
+  static const int64_t AVX512F   = (1 << 8);
+  static const int64_t AVX512BW  = (1 << 9);
+  static const int64_t AVX512VBMI = (1 << 10);
 
   /// Cache enums for L1 (data), L2 and L3
   enum CacheLevel {
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <algorithm>
+#include <time.h>
+#include <boost/thread/thread.hpp>
+
+#include "testutil/gtest-util.h"
+#include "util/cpu-sampler.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+static int64_t ThreadCpuTimeNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000L * 1000L * 1000L + ts.tv_nsec;
+}
+
+// Uses 'ms' milliseconds of CPU time of the calling thread.
+int64_t __attribute__((noinline)) SpinForCpuMs(int64_t ms) {
+  const int64_t end_ns = ThreadCpuTimeNs() + ms * 1000L * 1000L;
+  volatile int64_t sum = 0;
+  while (ThreadCpuTimeNs() < end_ns) {
+    for (int i = 0; i < 1000; ++i) sum += i;
+  }
+  return sum;
+}
+
+TEST(CpuSamplerTest, Basic) {
+  CpuSampleCollector collector(100);
+  {
+    ScopedCpuSampler sampler(&collector);
+    // The thread is only sampled once.
+    ScopedCpuSampler nested_sampler(&collector);
+    SpinForCpuMs(500);
+  }
+  // The samples of a thread are added when its sampling stops.
+  EXPECT_GT(collector.num_samples(), 10);
+  EXPECT_EQ(0, collector.num_dropped());
+  const string folded_stacks = collector.ToFoldedStacks(100);
+  EXPECT_STR_CONTAINS(folded_stacks, "SpinForCpuMs");
+
+  // Threads are only sampled while they use CPU.
+  const int64_t num_samples = collector.num_samples();
+  {
+    ScopedCpuSampler sampler(&collector);
+    SleepForMs(200);
+  }
+  EXPECT_LE(collector.num_samples(), num_samples + 1);
+  const string top_stack = collector.ToFoldedStacks(1);
+  EXPECT_EQ(1, count(top_stack.begin(), top_stack.end(), '\n'));
+}
+
+TEST(CpuSamplerTest, MultipleThreads) {
+  CpuSampleCollector collector(100);
+  thread_group threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.add_thread(new thread([&collector]() {
+      ScopedCpuSampler sampler(&collector);
+      SpinForCpuMs(200);
+    }));
+  }
+  threads.join_all();
+  EXPECT_GT(collector.num_samples(), 4 * 5);
+  // A null collector disables sampling.
+  ScopedCpuSampler sampler(nullptr);
+  sampler.Stop();
+}
+
+}
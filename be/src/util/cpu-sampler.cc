@@ -0,0 +1,262 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/cpu-sampler.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <unordered_map>
+
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/logging.h"
+#include "util/error-util.h"
+#include "util/symbols-util.h"
+
+#include "common/names.h"
+
+// Older versions of glibc do not define the name of the thread id of a sigevent.
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+/// WARNING this uses a private API of GLog: Symbolize().
+namespace google {
+extern bool Symbolize(void* pc, char* out, int out_size);
+}
+
+namespace impala {
+
+/// Samples of one thread, aggregated by stack in an open-addressing hash table, so that
+/// the signal handler does not allocate memory.
+struct CpuSampleTable {
+  /// Maximum number of frames of a sample.
+  static const int MAX_DEPTH = 32;
+
+  /// Number of distinct stacks that the table can hold.
+  static const int NUM_ENTRIES = 1024;
+
+  struct Entry {
+    int64_t count;
+    uint64_t hash;
+    int depth;
+    void* frames[MAX_DEPTH];
+  };
+
+  /// Entries with a 'count' of 0 are empty.
+  Entry entries[NUM_ENTRIES];
+
+  /// Number of samples that did not fit into 'entries'.
+  int64_t num_dropped;
+
+  /// Adds a sample of the stack 'frames'. Async-signal-safe.
+  void Add(void* const* frames, int depth) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < depth; ++i) {
+      hash = (hash ^ reinterpret_cast<uintptr_t>(frames[i])) * 1099511628211ULL;
+    }
+    for (int probe = 0; probe < NUM_ENTRIES; ++probe) {
+      Entry* entry = &entries[(hash + probe) % NUM_ENTRIES];
+      if (entry->count == 0) {
+        entry->hash = hash;
+        entry->depth = depth;
+        memcpy(entry->frames, frames, depth * sizeof(void*));
+        entry->count = 1;
+        return;
+      }
+      if (entry->hash == hash && entry->depth == depth
+          && memcmp(entry->frames, frames, depth * sizeof(void*)) == 0) {
+        ++entry->count;
+        return;
+      }
+    }
+    ++num_dropped;
+  }
+};
+
+// Signal that the timers of the sampled threads send. Real-time signals are not used by
+// the JVM or by the profilers of pprof-path-handlers, which use SIGPROF.
+static const int SAMPLING_SIGNAL_OFFSET = 2;
+
+// Number of frames of the signal handler and the signal trampoline in a sample.
+static const int NUM_HANDLER_FRAMES = 2;
+
+// The table of the calling thread, if it is sampled.
+static thread_local CpuSampleTable* thread_samples = nullptr;
+
+static void HandleSamplingSignal(int signal, siginfo_t* info, void* context) {
+  const int saved_errno = errno;
+  CpuSampleTable* table = thread_samples;
+  if (table != nullptr) {
+    void* frames[CpuSampleTable::MAX_DEPTH + NUM_HANDLER_FRAMES];
+    const int depth = backtrace(frames, CpuSampleTable::MAX_DEPTH + NUM_HANDLER_FRAMES);
+    if (depth > NUM_HANDLER_FRAMES) {
+      table->Add(frames + NUM_HANDLER_FRAMES, depth - NUM_HANDLER_FRAMES);
+    }
+  }
+  errno = saved_errno;
+}
+
+// Installs the signal handler on the first call. Returns false if it failed.
+static bool InstallSamplingSignalHandler() {
+  static once_flag once;
+  static bool installed = false;
+  call_once(once, []() {
+    // The first call of backtrace() may load libgcc, which is not safe in a signal
+    // handler.
+    void* frame;
+    backtrace(&frame, 1);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    action.sa_sigaction = &HandleSamplingSignal;
+    if (sigaction(SIGRTMIN + SAMPLING_SIGNAL_OFFSET, &action, nullptr) == -1) {
+      LOG(WARNING) << "Failed to register the handler of the CPU sampling signal: "
+                   << GetStrErrMsg();
+      return;
+    }
+    installed = true;
+  });
+  return installed;
+}
+
+// Returns the function name of the code at 'pc', or its address if it is unknown.
+static string SymbolizeFrame(void* pc) {
+  char name[1024];
+  // Return addresses point to the instruction after the call.
+  if (google::Symbolize(reinterpret_cast<char*>(pc) - 1, name, sizeof(name))) {
+    return SymbolsUtil::DemangleNoArgs(name);
+  }
+  stringstream ss;
+  ss << pc;
+  return ss.str();
+}
+
+CpuSampleCollector::CpuSampleCollector(int sampling_hz) : sampling_hz_(sampling_hz) {
+  DCHECK_GT(sampling_hz, 0);
+}
+
+void CpuSampleCollector::Merge(const CpuSampleTable& table) {
+  lock_guard<mutex> l(lock_);
+  for (const CpuSampleTable::Entry& entry : table.entries) {
+    if (entry.count == 0) continue;
+    stacks_[vector<void*>(entry.frames, entry.frames + entry.depth)] += entry.count;
+    num_samples_ += entry.count;
+  }
+  num_samples_ += table.num_dropped;
+  num_dropped_ += table.num_dropped;
+}
+
+int64_t CpuSampleCollector::num_samples() const {
+  lock_guard<mutex> l(lock_);
+  return num_samples_;
+}
+
+int64_t CpuSampleCollector::num_dropped() const {
+  lock_guard<mutex> l(lock_);
+  return num_dropped_;
+}
+
+string CpuSampleCollector::ToFoldedStacks(int max_stacks) const {
+  // Stacks of different return addresses in the same functions are folded together.
+  map<string, int64_t> folded_stacks;
+  {
+    unordered_map<void*, string> symbols;
+    lock_guard<mutex> l(lock_);
+    for (const auto& stack : stacks_) {
+      string folded;
+      for (auto it = stack.first.rbegin(); it != stack.first.rend(); ++it) {
+        auto symbol = symbols.find(*it);
+        if (symbol == symbols.end()) {
+          symbol = symbols.emplace(*it, SymbolizeFrame(*it)).first;
+        }
+        if (!folded.empty()) folded += ';';
+        folded += symbol->second;
+      }
+      folded_stacks[folded] += stack.second;
+    }
+  }
+  vector<pair<int64_t, const string*>> sorted_stacks;
+  for (const auto& stack : folded_stacks) {
+    sorted_stacks.emplace_back(stack.second, &stack.first);
+  }
+  sort(sorted_stacks.begin(), sorted_stacks.end(),
+      [](const pair<int64_t, const string*>& a, const pair<int64_t, const string*>& b) {
+        return a.first > b.first;
+      });
+  if (sorted_stacks.size() > static_cast<size_t>(max_stacks)) {
+    sorted_stacks.resize(max_stacks);
+  }
+  stringstream ss;
+  for (const auto& stack : sorted_stacks) {
+    ss << *stack.second << " " << stack.first << "\n";
+  }
+  return ss.str();
+}
+
+ScopedCpuSampler::ScopedCpuSampler(CpuSampleCollector* collector) {
+  if (collector == nullptr || thread_samples != nullptr) return;
+  if (!InstallSamplingSignalHandler()) return;
+  struct sigevent event;
+  memset(&event, 0, sizeof(event));
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGRTMIN + SAMPLING_SIGNAL_OFFSET;
+  event.sigev_notify_thread_id = syscall(SYS_gettid);
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer_) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "Failed to create the CPU sampling timer: "
+                            << GetStrErrMsg();
+    return;
+  }
+  table_.reset(new CpuSampleTable());
+  thread_samples = table_.get();
+  const int64_t period_ns = 1000L * 1000L * 1000L / collector->sampling_hz();
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = period_ns / (1000L * 1000L * 1000L);
+  spec.it_interval.tv_nsec = period_ns % (1000L * 1000L * 1000L);
+  spec.it_value = spec.it_interval;
+  if (timer_settime(timer_, 0, &spec, nullptr) != 0) {
+    LOG_FIRST_N(WARNING, 1) << "Failed to start the CPU sampling timer: "
+                            << GetStrErrMsg();
+    timer_delete(timer_);
+    thread_samples = nullptr;
+    table_.reset();
+    return;
+  }
+  collector_ = collector;
+}
+
+ScopedCpuSampler::~ScopedCpuSampler() {
+  Stop();
+}
+
+void ScopedCpuSampler::Stop() {
+  if (collector_ == nullptr) return;
+  timer_delete(timer_);
+  // A signal that is still pending is ignored by the handler.
+  thread_samples = nullptr;
+  collector_->Merge(*table_);
+  table_.reset();
+  collector_ = nullptr;
+}
+
+}
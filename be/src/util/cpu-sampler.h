@@ -0,0 +1,101 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+struct CpuSampleTable;
+
+/// Collects stack samples of the threads that work on behalf of one fragment instance,
+/// for a CPU profile of a single query. Threads are sampled while they are in the scope
+/// of a ScopedCpuSampler for the collector.
+///
+/// Thread-safe.
+class CpuSampleCollector {
+ public:
+  /// 'sampling_hz' is the number of samples taken per second of CPU time of a thread.
+  explicit CpuSampleCollector(int sampling_hz);
+
+  int sampling_hz() const { return sampling_hz_; }
+
+  /// Returns the samples collected so far as folded stacks: one line per distinct stack
+  /// of function names, root first and separated by ';', followed by a space and the
+  /// number of samples. Returns at most 'max_stacks' stacks, with the most samples.
+  std::string ToFoldedStacks(int max_stacks) const;
+
+  /// Number of samples collected so far.
+  int64_t num_samples() const;
+
+  /// Number of samples that were dropped because a thread sampled too many distinct
+  /// stacks.
+  int64_t num_dropped() const;
+
+ private:
+  friend class ScopedCpuSampler;
+
+  /// Adds the samples of 'table' to the collector.
+  void Merge(const CpuSampleTable& table);
+
+  const int sampling_hz_;
+
+  /// Protects the members below.
+  mutable std::mutex lock_;
+
+  /// Number of samples of every distinct stack of return addresses, innermost first.
+  std::map<std::vector<void*>, int64_t> stacks_;
+
+  int64_t num_samples_ = 0;
+  int64_t num_dropped_ = 0;
+};
+
+/// Samples the stack of the calling thread into a CpuSampleCollector while in scope.
+/// A timer on the CPU time of the thread sends it a signal, whose handler records the
+/// stack in a buffer of the thread. The buffer is merged into the collector when the
+/// sampling stops, so the collector only contains the samples of threads that stopped.
+/// Samples of the same stack are aggregated in the buffer, which has room for a fixed
+/// number of distinct stacks. Does nothing if the thread is already sampled or the
+/// timer cannot be created.
+class ScopedCpuSampler {
+ public:
+  /// Starts sampling the calling thread into 'collector', unless it is nullptr.
+  explicit ScopedCpuSampler(CpuSampleCollector* collector);
+  ~ScopedCpuSampler();
+
+  /// Stops sampling and merges the samples into the collector. Idempotent.
+  void Stop();
+
+ private:
+  CpuSampleCollector* collector_ = nullptr;
+  std::unique_ptr<CpuSampleTable> table_;
+  timer_t timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedCpuSampler);
+};
+
+}
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <zlib.h>
 #include <zstd.h>
 #include <iostream>
 
@@ -29,6 +30,8 @@
 #include "testutil/rand-util.h"
 #include "util/decompress.h"
 #include "util/compress.h"
+#include "util/parallel-decompress.h"
+#include "util/thread-pool.h"
 #include "util/ubsan.h"
 
 #include "common/names.h"
@@ -417,6 +420,39 @@ TEST_F(DecompressorTest, Deflate) {
   RunTestMultiStreamDecompressing(THdfsCompression::DEFLATE);
 }
 
+// Tests that GzipDecompressor grows its output buffer when it decompresses data that
+// compresses far better than its guess of the output size. Only GZIP has a trailer with
+// the size of the output.
+TEST_F(DecompressorTest, GzipGrowOutputBuffer) {
+  const int64_t input_len = 1024 * 1024;
+  vector<uint8_t> input(input_len);
+  for (int64_t i = 0; i < input_len; ++i) input[i] = i % 4096 == 0 ? i / 4096 : 'a';
+  for (THdfsCompression::type format : {THdfsCompression::GZIP,
+      THdfsCompression::DEFAULT, THdfsCompression::DEFLATE}) {
+    scoped_ptr<Codec> compressor;
+    scoped_ptr<Codec> decompressor;
+    EXPECT_OK(Codec::CreateCompressor(
+        &mem_pool_, true, Codec::CodecInfo(format), &compressor));
+    EXPECT_OK(Codec::CreateDecompressor(&mem_pool_, true, format, &decompressor));
+    uint8_t* compressed;
+    int64_t compressed_len;
+    EXPECT_OK(compressor->ProcessBlock(
+        false, input_len, input.data(), &compressed_len, &compressed));
+    EXPECT_LT(compressed_len * 100, input_len);
+    // Decompress twice to reuse the output buffer.
+    for (int i = 0; i < 2; ++i) {
+      uint8_t* output;
+      int64_t output_len;
+      EXPECT_OK(decompressor->ProcessBlock(
+          false, compressed_len, compressed, &output_len, &output));
+      ASSERT_EQ(output_len, input_len);
+      EXPECT_EQ(Ubsan::MemCmp(input.data(), output, input_len), 0);
+    }
+    compressor->Close();
+    decompressor->Close();
+  }
+}
+
 TEST_F(DecompressorTest, Bzip) {
   RunTest(THdfsCompression::BZIP2);
   RunTestStreaming(THdfsCompression::BZIP2);
@@ -593,6 +629,146 @@ TEST_F(DecompressorTest, LZ4HadoopCompat) {
 TEST_F(DecompressorTest, LZ4Blocked) {
   RunTest(THdfsCompression::LZ4_BLOCKED);
 }
+
+// Appends a ZSTD frame of 'data' to 'out'. The frame header only records the content
+// size if 'with_content_size' is true.
+static void AppendZstdFrame(
+    const uint8_t* data, int64_t len, bool with_content_size, string* out) {
+  string frame(ZSTD_compressBound(len), '\0');
+  size_t frame_len;
+  if (with_content_size) {
+    frame_len = ZSTD_compress(&frame[0], frame.size(), data, len, ZSTD_CLEVEL_DEFAULT);
+  } else {
+    ZSTD_CStream* stream = ZSTD_createCStream();
+    ZSTD_initCStream(stream, ZSTD_CLEVEL_DEFAULT);
+    ZSTD_inBuffer in = {data, static_cast<size_t>(len), 0};
+    ZSTD_outBuffer zstd_out = {&frame[0], frame.size(), 0};
+    ASSERT_FALSE(ZSTD_isError(ZSTD_compressStream(stream, &zstd_out, &in)));
+    ASSERT_EQ(ZSTD_endStream(stream, &zstd_out), 0);
+    ZSTD_freeCStream(stream);
+    frame_len = zstd_out.pos;
+  }
+  ASSERT_FALSE(ZSTD_isError(frame_len));
+  out->append(frame.data(), frame_len);
+}
+
+// Appends a gzip member of 'data' to 'out', like bgzip does. The member has the 'BC'
+// extra subfield with its size if 'bgzf' is true.
+static void AppendGzipMember(const uint8_t* data, int64_t len, bool bgzf, string* out) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  ASSERT_EQ(deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+      Z_DEFAULT_STRATEGY), Z_OK);
+  string deflated(deflateBound(&stream, len), '\0');
+  stream.next_in = const_cast<uint8_t*>(data);
+  stream.avail_in = len;
+  stream.next_out = reinterpret_cast<uint8_t*>(&deflated[0]);
+  stream.avail_out = deflated.size();
+  ASSERT_EQ(deflate(&stream, Z_FINISH), Z_STREAM_END);
+  deflated.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  const int header_len = bgzf ? 18 : 10;
+  const int64_t member_len = header_len + deflated.size() + 8;
+  uint8_t header[18] = {31, 139, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 255,
+      6, 0, 'B', 'C', 2, 0, 0, 0};
+  if (bgzf) {
+    header[3] = 4;
+    header[16] = (member_len - 1) & 0xff;
+    header[17] = (member_len - 1) >> 8;
+  }
+  out->append(reinterpret_cast<char*>(header), header_len);
+  out->append(deflated);
+  uint32_t trailer[2] = {
+      static_cast<uint32_t>(crc32(0, data, len)), static_cast<uint32_t>(len)};
+  out->append(reinterpret_cast<char*>(trailer), sizeof(trailer));
+}
+
+// Compresses 'input' as several frames of 'format' with AppendZstdFrame() or
+// AppendGzipMember() and checks that ParallelDecompressor splits and decompresses it.
+static void RunParallelTest(THdfsCompression::type format, const uint8_t* input,
+    int64_t input_len, CallableThreadPool* pool) {
+  const int num_frames = 4;
+  const int64_t frame_len = input_len / num_frames;
+  string compressed;
+  for (int i = 0; i < num_frames; ++i) {
+    const int64_t len = i == num_frames - 1 ? input_len - i * frame_len : frame_len;
+    if (format == THdfsCompression::ZSTD) {
+      AppendZstdFrame(input + i * frame_len, len, true, &compressed);
+    } else {
+      AppendGzipMember(input + i * frame_len, len, true, &compressed);
+    }
+  }
+  const uint8_t* compressed_ptr = reinterpret_cast<const uint8_t*>(compressed.data());
+
+  vector<ParallelDecompressor::Frame> frames;
+  ASSERT_TRUE(ParallelDecompressor::FindFrames(
+      format, compressed_ptr, compressed.size(), 100, input_len, &frames));
+  ASSERT_EQ(frames.size(), num_frames);
+  EXPECT_EQ(frames.back().offset + frames.back().compressed_len, compressed.size());
+  vector<uint8_t> output(input_len);
+  EXPECT_OK(ParallelDecompressor::DecompressFrames(
+      format, compressed_ptr, frames, pool, output.data()));
+  EXPECT_EQ(memcmp(input, output.data(), input_len), 0);
+
+  // The frame count and decompressed size limits are respected.
+  frames.clear();
+  ASSERT_TRUE(ParallelDecompressor::FindFrames(
+      format, compressed_ptr, compressed.size(), 2, input_len, &frames));
+  EXPECT_EQ(frames.size(), 2);
+  frames.clear();
+  ASSERT_TRUE(ParallelDecompressor::FindFrames(
+      format, compressed_ptr, compressed.size(), 100, frame_len * 3 - 1, &frames));
+  EXPECT_EQ(frames.size(), 2);
+
+  // An incomplete last frame is not returned.
+  frames.clear();
+  ASSERT_TRUE(ParallelDecompressor::FindFrames(
+      format, compressed_ptr, compressed.size() - 1, 100, input_len, &frames));
+  EXPECT_EQ(frames.size(), num_frames - 1);
+
+  // Frames that do not decompress to their recorded size are reported.
+  frames.clear();
+  ASSERT_TRUE(ParallelDecompressor::FindFrames(
+      format, compressed_ptr, compressed.size(), 100, input_len, &frames));
+  --frames[2].decompressed_len;
+  EXPECT_FALSE(ParallelDecompressor::DecompressFrames(
+      format, compressed_ptr, frames, pool, output.data()).ok());
+}
+
+TEST_F(DecompressorTest, ParallelZstd) {
+  RunParallelTest(THdfsCompression::ZSTD, input_, sizeof(input_), nullptr);
+  CallableThreadPool pool("decompress-test", "worker", 2, 10);
+  ASSERT_OK(pool.Init());
+  RunParallelTest(THdfsCompression::ZSTD, input_, sizeof(input_), &pool);
+  pool.Shutdown();
+  pool.Join();
+
+  // Frames without the content size must be decompressed with a streaming decompressor.
+  string compressed;
+  AppendZstdFrame(input_, sizeof(input_), false, &compressed);
+  vector<ParallelDecompressor::Frame> frames;
+  EXPECT_FALSE(ParallelDecompressor::FindFrames(THdfsCompression::ZSTD,
+      reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size(), 100,
+      sizeof(input_), &frames));
+}
+
+TEST_F(DecompressorTest, ParallelBgzf) {
+  RunParallelTest(THdfsCompression::GZIP, input_, sizeof(input_), nullptr);
+  CallableThreadPool pool("decompress-test", "worker", 2, 10);
+  ASSERT_OK(pool.Init());
+  RunParallelTest(THdfsCompression::GZIP, input_, sizeof(input_), &pool);
+  pool.Shutdown();
+  pool.Join();
+
+  // Plain gzip members do not record their compressed size.
+  string compressed;
+  AppendGzipMember(input_, sizeof(input_), false, &compressed);
+  vector<ParallelDecompressor::Frame> frames;
+  EXPECT_FALSE(ParallelDecompressor::FindFrames(THdfsCompression::GZIP,
+      reinterpret_cast<const uint8_t*>(compressed.data()), compressed.size(), 100,
+      sizeof(input_), &frames));
+}
 }
 
 int main(int argc, char **argv) {
@@ -46,6 +46,33 @@ using namespace strings;
 const string DECOMPRESSOR_MEM_LIMIT_EXCEEDED =
     "$0Decompressor failed to allocate $1 bytes.";
 
+namespace {
+
+/// Deflate compresses by at most about 1032:1, which bounds the decompressed size that
+/// the trailer of a gzip member can plausibly record.
+constexpr int64_t MAX_DEFLATE_RATIO = 1032;
+/// A gzip member has a 10 byte header, at least a 2 byte deflate block and an 8 byte
+/// trailer.
+constexpr int64_t GZIP_MIN_MEMBER_LEN = 20;
+
+/// Returns the decompressed size that the trailer of the gzip member in the 'len' bytes
+/// at 'input' records, or -1 if 'input' does not start with a gzip header or the size is
+/// implausible. The trailer records the size modulo 2^32, so the result may be too
+/// small.
+int64_t GzipDecompressedLengthHint(const uint8_t* input, int64_t len) {
+  if (len < GZIP_MIN_MEMBER_LEN || input[0] != 31 || input[1] != 139
+      || input[2] != Z_DEFLATED) {
+    return -1;
+  }
+  const uint8_t* isize = input + len - 4;
+  const int64_t result = isize[0] | (isize[1] << 8) | (isize[2] << 16)
+      | (static_cast<int64_t>(isize[3]) << 24);
+  if (result == 0 || result > len * MAX_DEFLATE_RATIO) return -1;
+  return result;
+}
+
+}
+
 GzipDecompressor::GzipDecompressor(MemPool* mem_pool, bool reuse_buffer, bool is_deflate)
   : Codec(mem_pool, reuse_buffer, true),
     is_deflate_(is_deflate) {
@@ -160,9 +187,12 @@ Status GzipDecompressor::ProcessBlock(bool output_preallocated, int64_t input_le
 
   bool use_temp = false;
   if (!output_preallocated) {
-    if (!reuse_buffer_ || out_buffer_ == nullptr) {
-      // guess that we will need 2x the input length.
-      buffer_length_ = input_length * 2;
+    // Size the buffer by the trailer of a gzip member, or guess that we will need 2x the
+    // input length if there is none.
+    const int64_t length_hint = GzipDecompressedLengthHint(input, input_length);
+    if (!reuse_buffer_ || out_buffer_ == nullptr || buffer_length_ < length_hint) {
+      buffer_length_ = length_hint != -1 ? length_hint : input_length * 2;
+      temp_memory_pool_->Clear();
       out_buffer_ = temp_memory_pool_->TryAllocate(buffer_length_);
       if (UNLIKELY(out_buffer_ == nullptr)) {
         string details = Substitute(DECOMPRESSOR_MEM_LIMIT_EXCEEDED, "Gzip",
@@ -184,17 +214,16 @@ Status GzipDecompressor::ProcessBlock(bool output_preallocated, int64_t input_le
   }
 
   // We only support the non-streaming use case where we present it the entire
-  // compressed input and a buffer big enough to contain the entire decompressed
-  // output.  In the case where we don't know the output, we just make a bigger
-  // buffer and try the non-streaming mode from the beginning again.
+  // compressed input. In the case where we don't know the output size and the buffer
+  // fills up, we continue into a buffer twice as large that starts with the output so
+  // far.
   // TODO: IMPALA-3073 Verify if compressed block could be multistream. If yes, we need
   // to support it and shouldn't stop decompressing while ret == Z_STREAM_END.
-  while (ret != Z_STREAM_END) {
-    stream_.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input));
-    stream_.avail_in = input_length;
-    stream_.next_out = reinterpret_cast<Bytef*>(*output);
-    stream_.avail_out = output_length_local;
-
+  stream_.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input));
+  stream_.avail_in = input_length;
+  stream_.next_out = reinterpret_cast<Bytef*>(*output);
+  stream_.avail_out = output_length_local;
+  while (true) {
     if (use_temp) {
       // We don't know the output size, so this might fail.
       ret = inflate(&stream_, Z_PARTIAL_FLUSH);
@@ -203,7 +232,9 @@ Status GzipDecompressor::ProcessBlock(bool output_preallocated, int64_t input_le
       // which is more efficient.
       ret = inflate(&stream_, Z_FINISH);
     }
-    if (ret == Z_STREAM_END || ret != Z_OK) break;
+    if (ret != Z_OK) break;
+    // Out of input. The next inflate() returns Z_BUF_ERROR.
+    if (stream_.avail_out > 0) continue;
 
     // Not enough output space.
     if (!use_temp) {
@@ -213,19 +244,22 @@ Status GzipDecompressor::ProcessBlock(bool output_preallocated, int64_t input_le
       return Status(ss.str());
     }
 
-    // User didn't supply the buffer, double the buffer and try again.
-    temp_memory_pool_->Clear();
-    buffer_length_ *= 2;
-    out_buffer_ = temp_memory_pool_->TryAllocate(buffer_length_);
-    if (UNLIKELY(out_buffer_ == nullptr)) {
-      string details = Substitute(DECOMPRESSOR_MEM_LIMIT_EXCEEDED, "Gzip",
-          buffer_length_);
+    // User didn't supply the buffer, double the buffer and continue. The smaller
+    // buffers are freed along with the rest of 'temp_memory_pool_'.
+    const int64_t new_length = buffer_length_ * 2;
+    uint8_t* new_buffer = temp_memory_pool_->TryAllocate(new_length);
+    if (UNLIKELY(new_buffer == nullptr)) {
+      string details = Substitute(DECOMPRESSOR_MEM_LIMIT_EXCEEDED, "Gzip", new_length);
       return temp_memory_pool_->mem_tracker()->MemLimitExceeded(
-          nullptr, details, buffer_length_);
+          nullptr, details, new_length);
     }
+    memcpy(new_buffer, out_buffer_, buffer_length_);
+    stream_.next_out = reinterpret_cast<Bytef*>(new_buffer + buffer_length_);
+    stream_.avail_out = new_length - buffer_length_;
+    out_buffer_ = new_buffer;
+    buffer_length_ = new_length;
     *output = out_buffer_;
     output_length_local = buffer_length_;
-    ret = inflateReset(&stream_);
   }
 
   if (ret == Z_DATA_ERROR) {
@@ -363,6 +363,18 @@ class DictDecoder : public DictDecoderBase {
   /// be successfully read. 'stride' is the stride in bytes between each subsequent value.
   bool GetNextValues(T* first_value, int64_t stride, int count) WARN_UNUSED_RESULT;
 
+  /// Reads the next 'count' dictionary indices into 'indices' without looking up the
+  /// values. Returns false if the data is invalid or an index is out of range. Can be
+  /// mixed with SkipValues() but not with GetNextValue() or GetNextValues() on the same
+  /// data page, since those buffer decoded values.
+  bool GetNextIndices(int count, uint32_t* indices) WARN_UNUSED_RESULT;
+
+  /// Returns the dictionary value at 'index', which must be valid.
+  const T& ValueAt(uint32_t index) const {
+    DCHECK_LT(index, dict_.size());
+    return dict_[index];
+  }
+
   /// This function returns the size in bytes of the dictionary vector.
   /// It is used by dict-test.cc for validation of bytes consumed against
   /// memory tracked.
@@ -542,6 +554,17 @@ ALWAYS_INLINE inline bool DictDecoder<T>::GetNextValues(
   return true;
 }
 
+template <typename T>
+inline bool DictDecoder<T>::GetNextIndices(int count, uint32_t* indices) {
+  DCHECK_GE(count, 0);
+  DCHECK_EQ(num_repeats_, 0);
+  DCHECK_GE(next_literal_idx_, num_literal_values_);
+  if (UNLIKELY(data_decoder_.GetValues(count, indices) != count)) return false;
+  IndexType max_index = 0;
+  for (int i = 0; i < count; ++i) max_index = std::max(max_index, indices[i]);
+  return count == 0 || max_index < dict_.size();
+}
+
 template <typename T>
 ALWAYS_INLINE inline bool DictDecoder<T>::SkipValues(int64_t num_values) {
   int64_t num_remaining = num_values;
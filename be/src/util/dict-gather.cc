@@ -0,0 +1,198 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/dict-gather.h"
+
+#ifndef __aarch64__
+  #include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "common/compiler-util.h"
+#include "common/logging.h"
+
+namespace impala {
+
+#ifndef __aarch64__
+
+namespace {
+
+/// Returns the largest valid index of a dictionary with 'dict_len' entries, clamped to
+/// the range of uint32_t. Must only be called with 'dict_len' > 0.
+inline uint32_t MaxIndex(int64_t dict_len) {
+  DCHECK_GT(dict_len, 0);
+  return static_cast<uint32_t>(std::min<int64_t>(
+      dict_len - 1, std::numeric_limits<uint32_t>::max()));
+}
+
+/// Returns true if all 32 'indices' are <= 'max_idx'.
+__attribute__((target("avx2")))
+inline bool IndicesInRangeAVX2(const uint32_t* indices, uint32_t max_idx) {
+  const __m256i* in = reinterpret_cast<const __m256i*>(indices);
+  __m256i max = _mm256_max_epu32(
+      _mm256_max_epu32(_mm256_loadu_si256(in), _mm256_loadu_si256(in + 1)),
+      _mm256_max_epu32(_mm256_loadu_si256(in + 2), _mm256_loadu_si256(in + 3)));
+  const __m256i limit = _mm256_set1_epi32(static_cast<int32_t>(max_idx));
+  // max(x, limit) == limit iff x <= limit (unsigned).
+  return _mm256_movemask_epi8(
+      _mm256_cmpeq_epi32(_mm256_max_epu32(max, limit), limit)) == -1;
+}
+
+/// Returns true if all 32 'indices' are <= 'max_idx'.
+__attribute__((target("avx512f")))
+inline bool IndicesInRangeAVX512(const uint32_t* indices, uint32_t max_idx) {
+  const __m512i limit = _mm512_set1_epi32(static_cast<int32_t>(max_idx));
+  __m512i max = _mm512_max_epu32(_mm512_loadu_si512(indices),
+      _mm512_loadu_si512(indices + 16));
+  return _mm512_cmpgt_epu32_mask(max, limit) == 0;
+}
+
+/// Returns true if the byte offsets of 32 values that are 'stride' bytes apart fit in
+/// the signed 32-bit offsets used by the AVX-512 scatter instructions.
+inline bool StrideFitsScatter(int64_t stride) {
+  return stride > 0
+      && stride <= std::numeric_limits<int32_t>::max() / DictGather::BATCH_SIZE;
+}
+
+} // anonymous namespace
+
+__attribute__((target("avx2")))
+bool DictGather::Gather32Int32AVX2(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (UNLIKELY(dict_len <= 0)) return false;
+  if (UNLIKELY(!IndicesInRangeAVX2(indices, MaxIndex(dict_len)))) return false;
+  const int* base = reinterpret_cast<const int*>(dict);
+  const __m256i* in = reinterpret_cast<const __m256i*>(indices);
+  for (int i = 0; i < BATCH_SIZE / 8; ++i) {
+    __m256i values = _mm256_i32gather_epi32(base, _mm256_loadu_si256(in + i), 4);
+    if (stride == sizeof(int32_t)) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 8 * stride), values);
+    } else {
+      int32_t tmp[8];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp), values);
+      for (int j = 0; j < 8; ++j) {
+        memcpy(out + (i * 8 + j) * stride, &tmp[j], sizeof(int32_t));
+      }
+    }
+  }
+  _mm256_zeroupper();
+  return true;
+}
+
+__attribute__((target("avx2")))
+bool DictGather::Gather32Int64AVX2(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (UNLIKELY(dict_len <= 0)) return false;
+  if (UNLIKELY(!IndicesInRangeAVX2(indices, MaxIndex(dict_len)))) return false;
+  const long long* base = reinterpret_cast<const long long*>(dict);
+  const __m128i* in = reinterpret_cast<const __m128i*>(indices);
+  for (int i = 0; i < BATCH_SIZE / 4; ++i) {
+    __m256i values = _mm256_i32gather_epi64(base, _mm_loadu_si128(in + i), 8);
+    if (stride == sizeof(int64_t)) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i * 4 * stride), values);
+    } else {
+      int64_t tmp[4];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp), values);
+      for (int j = 0; j < 4; ++j) {
+        memcpy(out + (i * 4 + j) * stride, &tmp[j], sizeof(int64_t));
+      }
+    }
+  }
+  _mm256_zeroupper();
+  return true;
+}
+
+__attribute__((target("avx512f")))
+bool DictGather::Gather32Int32AVX512(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (!StrideFitsScatter(stride)) {
+    return Gather32Int32AVX2(dict, dict_len, indices, out, stride);
+  }
+  if (UNLIKELY(dict_len <= 0)) return false;
+  if (UNLIKELY(!IndicesInRangeAVX512(indices, MaxIndex(dict_len)))) return false;
+  const int32_t s = static_cast<int32_t>(stride);
+  const __m512i offsets = _mm512_mullo_epi32(_mm512_set1_epi32(s),
+      _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  for (int i = 0; i < BATCH_SIZE / 16; ++i) {
+    __m512i values =
+        _mm512_i32gather_epi32(_mm512_loadu_si512(indices + i * 16), dict, 4);
+    uint8_t* dst = out + i * 16 * stride;
+    if (stride == sizeof(int32_t)) {
+      _mm512_storeu_si512(dst, values);
+    } else {
+      _mm512_i32scatter_epi32(dst, offsets, values, 1);
+    }
+  }
+  return true;
+}
+
+__attribute__((target("avx512f")))
+bool DictGather::Gather32Int64AVX512(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (!StrideFitsScatter(stride)) {
+    return Gather32Int64AVX2(dict, dict_len, indices, out, stride);
+  }
+  if (UNLIKELY(dict_len <= 0)) return false;
+  if (UNLIKELY(!IndicesInRangeAVX512(indices, MaxIndex(dict_len)))) return false;
+  const int32_t s = static_cast<int32_t>(stride);
+  const __m256i offsets = _mm256_set_epi32(
+      7 * s, 6 * s, 5 * s, 4 * s, 3 * s, 2 * s, s, 0);
+  const __m256i* in = reinterpret_cast<const __m256i*>(indices);
+  for (int i = 0; i < BATCH_SIZE / 8; ++i) {
+    __m512i values = _mm512_i32gather_epi64(_mm256_loadu_si256(in + i), dict, 8);
+    uint8_t* dst = out + i * 8 * stride;
+    if (stride == sizeof(int64_t)) {
+      _mm512_storeu_si512(dst, values);
+    } else {
+      _mm512_i32scatter_epi64(dst, offsets, values, 1);
+    }
+  }
+  return true;
+}
+
+#else
+
+bool DictGather::Gather32Int32AVX2(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  DCHECK(false) << "Not supported on this platform";
+  return false;
+}
+
+bool DictGather::Gather32Int64AVX2(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  DCHECK(false) << "Not supported on this platform";
+  return false;
+}
+
+bool DictGather::Gather32Int32AVX512(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  DCHECK(false) << "Not supported on this platform";
+  return false;
+}
+
+bool DictGather::Gather32Int64AVX512(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  DCHECK(false) << "Not supported on this platform";
+  return false;
+}
+
+#endif
+
+} // namespace impala
@@ -0,0 +1,88 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "util/cpu-info.h"
+
+namespace impala {
+
+/// Resolves batches of 32 dictionary indices to dictionary values using SIMD gather
+/// instructions. Only dictionaries with 4 or 8 byte values are supported, e.g. INT,
+/// BIGINT, FLOAT, DOUBLE, DATE and DECIMAL with precision <= 18. The implementation is
+/// chosen at runtime based on the CPU features reported by CpuInfo: AVX-512F (gather,
+/// plus scatter for strided output) or AVX2 (gather). The caller is expected to fall
+/// back to the scalar lookup if IsSupported() returns false.
+///
+/// All indices of a batch are validated against the dictionary length before any value
+/// is gathered, so that a corrupt index never leads to an out-of-bounds read.
+class DictGather {
+ public:
+  static constexpr int BATCH_SIZE = 32;
+
+  /// Returns true if a SIMD implementation is available for values of 'value_size'
+  /// bytes on this CPU.
+  static bool IsSupported(int value_size) {
+#ifndef __aarch64__
+    return (value_size == 4 || value_size == 8) && CpuInfo::IsSupported(CpuInfo::AVX2);
+#else
+    return false;
+#endif
+  }
+
+  /// Writes dict[indices[i]] to 'out' + i * 'stride' bytes for 0 <= i < 32. 'dict' points
+  /// to 'dict_len' values of 'VALUE_SIZE' bytes each. Returns false without writing any
+  /// output if any of the indices is >= 'dict_len'. Must only be called if
+  /// IsSupported(VALUE_SIZE) is true. Unsupported value sizes always return false.
+  template <int VALUE_SIZE>
+  static bool Gather32(const void* dict, int64_t dict_len,
+      const uint32_t* indices, uint8_t* out, int64_t stride) {
+    return false;
+  }
+
+ private:
+  static bool Gather32Int32AVX2(const void* dict, int64_t dict_len,
+      const uint32_t* indices, uint8_t* out, int64_t stride);
+  static bool Gather32Int64AVX2(const void* dict, int64_t dict_len,
+      const uint32_t* indices, uint8_t* out, int64_t stride);
+  static bool Gather32Int32AVX512(const void* dict, int64_t dict_len,
+      const uint32_t* indices, uint8_t* out, int64_t stride);
+  static bool Gather32Int64AVX512(const void* dict, int64_t dict_len,
+      const uint32_t* indices, uint8_t* out, int64_t stride);
+};
+
+template <>
+inline bool DictGather::Gather32<4>(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (CpuInfo::IsSupported(CpuInfo::AVX512F)) {
+    return Gather32Int32AVX512(dict, dict_len, indices, out, stride);
+  }
+  return Gather32Int32AVX2(dict, dict_len, indices, out, stride);
+}
+
+template <>
+inline bool DictGather::Gather32<8>(const void* dict, int64_t dict_len,
+    const uint32_t* indices, uint8_t* out, int64_t stride) {
+  if (CpuInfo::IsSupported(CpuInfo::AVX512F)) {
+    return Gather32Int64AVX512(dict, dict_len, indices, out, stride);
+  }
+  return Gather32Int64AVX2(dict, dict_len, indices, out, stride);
+}
+
+} // namespace impala
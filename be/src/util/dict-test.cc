@@ -359,6 +359,73 @@ TEST(DictTest, DecodeErrors) {
   }
 }
 
+TEST(DictTest, TestGetNextIndices) {
+  MemTracker tracker;
+  MemTracker track_encoder;
+  MemTracker track_decoder;
+  MemPool pool(&tracker);
+  DictEncoder<int32_t> encoder(&pool, sizeof(int32_t), &track_encoder);
+  encoder.UsedbyTest();
+
+  // Mix literal runs and repeated runs.
+  vector<int32_t> values;
+  for (int i = 0; i < 100; ++i) values.push_back(i % 7);
+  values.insert(values.end(), 150, 3);
+  for (int i = 0; i < 77; ++i) values.push_back(i % 11);
+  for (int32_t val : values) encoder.Put(val);
+
+  vector<uint8_t> dict_buffer(encoder.dict_encoded_size());
+  encoder.WriteDict(dict_buffer.data());
+  vector<uint8_t> data_buffer(encoder.EstimatedDataEncodedSize() * 2);
+  int data_len = encoder.WriteData(data_buffer.data(), data_buffer.size());
+  ASSERT_GT(data_len, 0);
+  encoder.ClearIndices();
+
+  DictDecoder<int32_t> decoder(&track_decoder);
+  ASSERT_TRUE(decoder.template Reset<parquet::Type::INT32>(
+      dict_buffer.data(), dict_buffer.size(), sizeof(int32_t)));
+  ASSERT_OK(decoder.SetData(data_buffer.data(), data_len));
+
+  // Read the indices in batches of varying sizes, skipping some values in between.
+  uint32_t indices[128];
+  int pos = 0;
+  int batch_size = 1;
+  while (pos < values.size()) {
+    int count = min<int>(batch_size, values.size() - pos);
+    ASSERT_TRUE(decoder.GetNextIndices(count, indices));
+    for (int i = 0; i < count; ++i) {
+      EXPECT_EQ(values[pos + i], decoder.ValueAt(indices[i])) << pos + i;
+    }
+    pos += count;
+    int num_to_skip = min<int>(batch_size % 5, values.size() - pos);
+    ASSERT_TRUE(decoder.SkipValues(num_to_skip));
+    pos += num_to_skip;
+    batch_size = batch_size % 64 + 7;
+  }
+  // The data is exhausted.
+  EXPECT_FALSE(decoder.GetNextIndices(1, indices));
+
+  // Indices that are out of range of a smaller dictionary are detected.
+  DictEncoder<int32_t> small_encoder(&pool, sizeof(int32_t), &track_encoder);
+  small_encoder.UsedbyTest();
+  for (int32_t val : {0, 1}) small_encoder.Put(val);
+  vector<uint8_t> small_dict_buffer(small_encoder.dict_encoded_size());
+  small_encoder.WriteDict(small_dict_buffer.data());
+  small_encoder.ClearIndices();
+  DictDecoder<int32_t> small_decoder(&track_decoder);
+  ASSERT_TRUE(small_decoder.template Reset<parquet::Type::INT32>(
+      small_dict_buffer.data(), small_dict_buffer.size(), sizeof(int32_t)));
+  ASSERT_OK(small_decoder.SetData(data_buffer.data(), data_len));
+  vector<uint32_t> all_indices(values.size());
+  EXPECT_FALSE(small_decoder.GetNextIndices(values.size(), all_indices.data()));
+
+  small_encoder.Close();
+  encoder.Close();
+  decoder.Close();
+  small_decoder.Close();
+  pool.FreeAll();
+}
+
 TEST(DictTest, TestGetNextValuesAndSkippingFuzzy) {
   const int values_size = 8192;
   const int rounds = 100;
@@ -0,0 +1,242 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/event-tracer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "common/atomic.h"
+#include "common/logging.h"
+#include "common/thread-debug-info.h"
+#include "util/debug-util.h"
+#include "util/webserver.h"
+
+#include "common/names.h"
+
+DEFINE_int32(event_trace_records_per_thread, 0, "If greater than 0, enables the tracing "
+    "of events like disk reads, exchanges and buffer pool operations, whose timeline is "
+    "served per query by the /query_trace page of the debug webserver. Every thread "
+    "keeps its most recent events, up to this number. Every event takes 48 bytes.");
+
+namespace impala {
+
+bool EventTracer::enabled_ = false;
+
+namespace {
+
+// Ring buffer of the events of one thread. Only the thread that owns the buffer writes
+// to it. Readers copy the records without synchronizing with the writer and discard
+// the records that the writer may have overwritten while they copied them.
+struct ThreadBuffer {
+  explicit ThreadBuffer(int64_t capacity)
+    : capacity(capacity), records(new EventTracer::Record[capacity]) {}
+
+  const int64_t capacity;
+  const unique_ptr<EventTracer::Record[]> records;
+
+  // Number of records written to the buffer since it was created.
+  AtomicInt64 num_written{0};
+};
+
+// The buffers of all threads that recorded events.
+class BufferRegistry {
+ public:
+  // Returns a buffer for the thread 'tid', reusing the buffer of a thread that exited if
+  // possible.
+  ThreadBuffer* Acquire(int32_t tid, const char* thread_name) {
+    lock_guard<mutex> l(lock_);
+    thread_names_[tid] = thread_name;
+    if (!free_buffers_.empty()) {
+      ThreadBuffer* buffer = free_buffers_.back();
+      free_buffers_.pop_back();
+      return buffer;
+    }
+    buffers_.emplace_back(new ThreadBuffer(FLAGS_event_trace_records_per_thread));
+    return buffers_.back().get();
+  }
+
+  // Makes the buffer of a thread that exits available for reuse. Its records are kept
+  // until they are overwritten.
+  void Release(ThreadBuffer* buffer) {
+    lock_guard<mutex> l(lock_);
+    free_buffers_.push_back(buffer);
+  }
+
+  // Adds the records of all threads for 'query_id', or of all queries if it is the zero
+  // id, to 'records' and the names of their threads to 'thread_names'.
+  void GetRecords(const TUniqueId& query_id, vector<EventTracer::Record>* records,
+      map<int32_t, string>* thread_names) {
+    const bool all_queries = query_id == ThreadDebugInfo::ZERO_THREAD_ID;
+    vector<EventTracer::Record> copy;
+    lock_guard<mutex> l(lock_);
+    for (const unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      const int64_t end = buffer->num_written.Load();
+      const int64_t begin = max<int64_t>(0, end - buffer->capacity);
+      copy.clear();
+      for (int64_t i = begin; i < end; ++i) {
+        copy.push_back(buffer->records[i % buffer->capacity]);
+      }
+      // Records that the writer overwrote while they were copied are discarded.
+      atomic_thread_fence(memory_order_acquire);
+      const int64_t first_valid =
+          max<int64_t>(begin, buffer->num_written.Load() - buffer->capacity);
+      for (int64_t i = first_valid; i < end; ++i) {
+        const EventTracer::Record& record = copy[i - begin];
+        if (!all_queries && record.query_id != query_id) continue;
+        records->push_back(record);
+        auto name = thread_names_.find(record.tid);
+        if (name != thread_names_.end()) thread_names->insert(*name);
+      }
+    }
+  }
+
+ private:
+  mutex lock_;
+  vector<unique_ptr<ThreadBuffer>> buffers_;
+  vector<ThreadBuffer*> free_buffers_;
+
+  // Names of the threads that acquired a buffer, by thread id.
+  map<int32_t, string> thread_names_;
+};
+
+BufferRegistry* GetBufferRegistry() {
+  static BufferRegistry* registry = new BufferRegistry();
+  return registry;
+}
+
+// The buffer of the calling thread, which is released when the thread exits.
+struct ThreadBufferRef {
+  ~ThreadBufferRef() {
+    if (buffer != nullptr) GetBufferRegistry()->Release(buffer);
+  }
+
+  ThreadBuffer* buffer = nullptr;
+  int32_t tid = 0;
+};
+
+thread_local ThreadBufferRef thread_buffer;
+
+}
+
+void EventTracer::Init() {
+  enabled_ = FLAGS_event_trace_records_per_thread > 0;
+}
+
+void EventTracer::AddEvent(const char* name, int64_t start_ns, int64_t end_ns) {
+  DCHECK(enabled_);
+  const ThreadDebugInfo* tdi = GetThreadDebugInfo();
+  ThreadBufferRef* ref = &thread_buffer;
+  if (UNLIKELY(ref->buffer == nullptr)) {
+    ref->tid = syscall(SYS_gettid);
+    ref->buffer = GetBufferRegistry()->Acquire(
+        ref->tid, tdi != nullptr ? tdi->GetThreadName() : "");
+  }
+  ThreadBuffer* buffer = ref->buffer;
+  const int64_t i = buffer->num_written.Load();
+  Record* record = &buffer->records[i % buffer->capacity];
+  record->start_ns = start_ns;
+  record->duration_ns = end_ns - start_ns;
+  record->name = name;
+  record->query_id = tdi != nullptr ? tdi->GetQueryId() : ThreadDebugInfo::ZERO_THREAD_ID;
+  record->tid = ref->tid;
+  // Publishes the record to readers.
+  buffer->num_written.Store(i + 1);
+}
+
+void EventTracer::WriteChromeTrace(
+    const TUniqueId& query_id, StreamingResponse* response) {
+  vector<Record> records;
+  map<int32_t, string> thread_names;
+  GetBufferRegistry()->GetRecords(query_id, &records, &thread_names);
+  sort(records.begin(), records.end(),
+      [](const Record& a, const Record& b) { return a.start_ns < b.start_ns; });
+
+  // Every event is written with its own writer, so that the output can be flushed
+  // between events.
+  stringstream* out = response->stream();
+  *out << "{\"displayTimeUnit\": \"ns\",\n\"traceEvents\": [";
+  bool first = true;
+  auto write_event = [&](const rapidjson::StringBuffer& buffer) {
+    if (!first) *out << ",";
+    first = false;
+    *out << "\n" << buffer.GetString();
+  };
+  for (const auto& thread_name : thread_names) {
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.String("name");
+    writer.String("thread_name");
+    writer.String("ph");
+    writer.String("M");
+    writer.String("pid");
+    writer.Int(0);
+    writer.String("tid");
+    writer.Int(thread_name.first);
+    writer.String("args");
+    writer.StartObject();
+    writer.String("name");
+    writer.String(thread_name.second.c_str());
+    writer.EndObject();
+    writer.EndObject();
+    write_event(buffer);
+  }
+  response->Flush();
+  for (size_t i = 0; i < records.size() && !response->failed(); ++i) {
+    const Record& record = records[i];
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.String("name");
+    writer.String(record.name);
+    writer.String("ph");
+    writer.String("X");
+    writer.String("pid");
+    writer.Int(0);
+    writer.String("tid");
+    writer.Int(record.tid);
+    // Timestamps and durations of the trace event format are in microseconds.
+    writer.String("ts");
+    writer.Double(record.start_ns / 1000.0);
+    writer.String("dur");
+    writer.Double(record.duration_ns / 1000.0);
+    if (record.query_id != ThreadDebugInfo::ZERO_THREAD_ID) {
+      writer.String("args");
+      writer.StartObject();
+      writer.String("query_id");
+      writer.String(PrintId(record.query_id).c_str());
+      writer.EndObject();
+    }
+    writer.EndObject();
+    write_event(buffer);
+    if (i % 1000 == 999) response->Flush();
+  }
+  *out << "\n]}\n";
+}
+
+}
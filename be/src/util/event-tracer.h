@@ -0,0 +1,97 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "gen-cpp/Types_types.h"
+#include "gutil/macros.h"
+#include "util/time.h"
+
+namespace impala {
+
+class StreamingResponse;
+
+/// Process-wide tracer of timed events, e.g. the reads of the DiskIoMgr or the waits
+/// for row batches of an exchange, for a timeline of the execution of a query that
+/// shows where its threads stall. Enabled with --event_trace_records_per_thread.
+///
+/// Every thread that records events writes them to a ring buffer of its own that holds
+/// its most recent --event_trace_records_per_thread events, so recording never takes
+/// a lock. Every event is attributed to the query of the ThreadDebugInfo of its thread.
+/// The buffers of threads that exit are reused by new threads, so the memory of the
+/// tracer is bounded by the maximum number of threads that record events at the same
+/// time. WriteChromeTrace() returns the events of a query in the Chrome trace event
+/// format, which can be opened in chrome://tracing or Perfetto.
+///
+/// Events are recorded with SCOPED_TRACE_EVENT(name), where 'name' must be a string
+/// literal. When tracing is disabled, a traced scope only costs a load and a branch.
+class EventTracer {
+ public:
+  /// A traced event: a span of time of a thread.
+  struct Record {
+    /// Start of the event, in MonotonicNanos().
+    int64_t start_ns;
+    int64_t duration_ns;
+    const char* name;
+    TUniqueId query_id;
+    /// Id of the thread in the operating system.
+    int32_t tid;
+  };
+
+  /// Enables tracing if --event_trace_records_per_thread is greater than 0. Must be
+  /// called before any events are recorded.
+  static void Init();
+
+  static bool enabled() { return enabled_; }
+
+  /// Records an event called 'name' of the calling thread.
+  static void AddEvent(const char* name, int64_t start_ns, int64_t end_ns);
+
+  /// Writes the recorded events of 'query_id' to 'response' as a JSON object in the
+  /// Chrome trace event format. Writes the events of all queries and of threads
+  /// without query if 'query_id' is the zero id.
+  static void WriteChromeTrace(const TUniqueId& query_id, StreamingResponse* response);
+
+ private:
+  static bool enabled_;
+};
+
+/// Records an event for its scope if tracing is enabled.
+class ScopedTraceEvent {
+ public:
+  explicit ScopedTraceEvent(const char* name)
+    : name_(EventTracer::enabled() ? name : nullptr) {
+    if (name_ != nullptr) start_ns_ = MonotonicNanos();
+  }
+
+  ~ScopedTraceEvent() {
+    if (name_ != nullptr) EventTracer::AddEvent(name_, start_ns_, MonotonicNanos());
+  }
+
+ private:
+  const char* const name_;
+  int64_t start_ns_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedTraceEvent);
+};
+
+#define SCOPED_TRACE_EVENT(name) \
+  ScopedTraceEvent VARNAME_LINENUM(trace_event)(name)
+
+}
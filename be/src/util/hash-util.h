@@ -19,6 +19,8 @@
 #ifndef IMPALA_UTIL_HASH_UTIL_H
 #define IMPALA_UTIL_HASH_UTIL_H
 
+#include <cstring>
+
 #include "common/logging.h"
 #include "common/compiler-util.h"
 #include "gutil/sysinfo.h"
@@ -274,6 +276,90 @@ class HashUtil {
 
     return FastHashMix(h);
   }
+
+  // The XxHash64 implementation follows the XXH64 specification in
+  // https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md
+  // It is the hash function of Parquet split block Bloom filters.
+  static const uint64_t XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+  static const uint64_t XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+  static const uint64_t XXH_PRIME64_3 = 0x165667B19E3779F9ULL;
+  static const uint64_t XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+  static const uint64_t XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+  static inline uint64_t XxHashRotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static inline uint64_t XxHashRound(uint64_t acc, uint64_t input) {
+    acc += input * XXH_PRIME64_2;
+    acc = XxHashRotl64(acc, 31);
+    return acc * XXH_PRIME64_1;
+  }
+
+  static inline uint64_t XxHashMergeRound(uint64_t acc, uint64_t val) {
+    acc ^= XxHashRound(0, val);
+    return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+  }
+
+  static uint64_t XxHash64(const void* data, int64_t len, uint64_t seed) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t* end = p + len;
+    uint64_t h;
+    if (len >= 32) {
+      const uint8_t* limit = end - 32;
+      uint64_t v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+      uint64_t v2 = seed + XXH_PRIME64_2;
+      uint64_t v3 = seed;
+      uint64_t v4 = seed - XXH_PRIME64_1;
+      do {
+        v1 = XxHashRound(v1, UnalignedLoad<uint64_t>(p));
+        v2 = XxHashRound(v2, UnalignedLoad<uint64_t>(p + 8));
+        v3 = XxHashRound(v3, UnalignedLoad<uint64_t>(p + 16));
+        v4 = XxHashRound(v4, UnalignedLoad<uint64_t>(p + 24));
+        p += 32;
+      } while (p <= limit);
+      h = XxHashRotl64(v1, 1) + XxHashRotl64(v2, 7) + XxHashRotl64(v3, 12)
+          + XxHashRotl64(v4, 18);
+      h = XxHashMergeRound(h, v1);
+      h = XxHashMergeRound(h, v2);
+      h = XxHashMergeRound(h, v3);
+      h = XxHashMergeRound(h, v4);
+    } else {
+      h = seed + XXH_PRIME64_5;
+    }
+    h += static_cast<uint64_t>(len);
+
+    while (p + 8 <= end) {
+      h ^= XxHashRound(0, UnalignedLoad<uint64_t>(p));
+      h = XxHashRotl64(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+      p += 8;
+    }
+    if (p + 4 <= end) {
+      h ^= static_cast<uint64_t>(UnalignedLoad<uint32_t>(p)) * XXH_PRIME64_1;
+      h = XxHashRotl64(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+      p += 4;
+    }
+    while (p < end) {
+      h ^= static_cast<uint64_t>(*p) * XXH_PRIME64_5;
+      h = XxHashRotl64(h, 11) * XXH_PRIME64_1;
+      ++p;
+    }
+
+    h ^= h >> 33;
+    h *= XXH_PRIME64_2;
+    h ^= h >> 29;
+    h *= XXH_PRIME64_3;
+    h ^= h >> 32;
+    return h;
+  }
+
+ private:
+  template <typename T>
+  static inline T UnalignedLoad(const uint8_t* p) {
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+  }
 };
 
 }
@@ -0,0 +1,68 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "testutil/gtest-util.h"
+#include "util/hll-simd.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Returns 'len' random registers with the distribution of an HLL intermediate, including
+// some zero registers.
+static vector<uint8_t> RandomRegisters(std::mt19937* rng, int len) {
+  std::geometric_distribution<int> dist(0.5);
+  vector<uint8_t> registers(len);
+  for (uint8_t& r : registers) r = std::min(dist(*rng), 30);
+  return registers;
+}
+
+TEST(HllSimd, Merge) {
+  if (!HllSimd::IsSupported()) return;
+  std::mt19937 rng(1234);
+  for (int len : {512, 1024, 1 << 18}) {
+    vector<uint8_t> dst = RandomRegisters(&rng, len);
+    vector<uint8_t> src = RandomRegisters(&rng, len);
+    vector<uint8_t> expected(len);
+    for (int i = 0; i < len; ++i) expected[i] = max(dst[i], src[i]);
+    HllSimd::MergeAVX2(dst.data(), src.data(), len);
+    EXPECT_EQ(expected, dst);
+  }
+}
+
+TEST(HllSimd, Sum) {
+  if (!HllSimd::IsSupported()) return;
+  std::mt19937 rng(1234);
+  for (int len : {512, 1024, 1 << 18}) {
+    vector<uint8_t> registers = RandomRegisters(&rng, len);
+    double expected_sum = 0;
+    int expected_zero = 0;
+    for (uint8_t r : registers) {
+      expected_sum += ldexp(1.0, -r);
+      if (r == 0) ++expected_zero;
+    }
+    int num_zero = -1;
+    EXPECT_EQ(expected_sum, HllSimd::SumAVX2(registers.data(), len, &num_zero));
+    EXPECT_EQ(expected_zero, num_zero);
+  }
+}
+
+}
@@ -0,0 +1,93 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/hll-simd.h"
+
+#ifndef __aarch64__
+  #include <immintrin.h>
+#endif
+
+#include <cstring>
+
+#include "common/logging.h"
+#include "util/bit-util.h"
+
+namespace impala {
+
+#ifndef __aarch64__
+
+__attribute__((target("avx2")))
+void HllSimd::MergeAVX2(uint8_t* dst, const uint8_t* src, int len) {
+  DCHECK_EQ(len % BATCH_SIZE, 0);
+  for (int i = 0; i < len; i += BATCH_SIZE) {
+    __m256i* out = reinterpret_cast<__m256i*>(dst + i);
+    __m256i merged = _mm256_max_epu8(_mm256_loadu_si256(out),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)));
+    _mm256_storeu_si256(out, merged);
+  }
+  _mm256_zeroupper();
+}
+
+/// Returns 2^-r for the four registers 'r' as doubles, by building the exponent bits
+/// directly.
+__attribute__((target("avx2")))
+static inline __m256d PowersOfHalf(const uint8_t* r) {
+  int32_t four_registers;
+  memcpy(&four_registers, r, sizeof(four_registers));
+  __m256i registers = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(four_registers));
+  __m256i exponent = _mm256_sub_epi64(_mm256_set1_epi64x(1023), registers);
+  return _mm256_castsi256_pd(_mm256_slli_epi64(exponent, 52));
+}
+
+__attribute__((target("avx2")))
+double HllSimd::SumAVX2(const uint8_t* registers, int len, int* num_zero) {
+  DCHECK_EQ(len % BATCH_SIZE, 0);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256d sum1 = _mm256_setzero_pd();
+  __m256d sum2 = _mm256_setzero_pd();
+  int zeros = 0;
+  for (int i = 0; i < len; i += BATCH_SIZE) {
+    const uint8_t* batch = registers + i;
+    __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(batch));
+    zeros += BitUtil::Popcount(static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(values, zero))));
+    for (int j = 0; j < BATCH_SIZE; j += 8) {
+      sum1 = _mm256_add_pd(sum1, PowersOfHalf(batch + j));
+      sum2 = _mm256_add_pd(sum2, PowersOfHalf(batch + j + 4));
+    }
+  }
+  double lanes[4];
+  _mm256_storeu_pd(lanes, _mm256_add_pd(sum1, sum2));
+  _mm256_zeroupper();
+  *num_zero = zeros;
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+#else
+
+void HllSimd::MergeAVX2(uint8_t* dst, const uint8_t* src, int len) {
+  DCHECK(false) << "Not supported on this platform";
+}
+
+double HllSimd::SumAVX2(const uint8_t* registers, int len, int* num_zero) {
+  DCHECK(false) << "Not supported on this platform";
+  return 0;
+}
+
+#endif
+
+} // namespace impala
@@ -0,0 +1,55 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "util/cpu-info.h"
+
+namespace impala {
+
+/// AVX2 kernels for the registers of the HyperLogLog intermediates of NDV(), which are
+/// arrays of one byte registers whose length is a power of two >= 512. The caller is
+/// expected to fall back to the scalar loops if IsSupported() returns false.
+class HllSimd {
+ public:
+  /// The register array lengths must be a multiple of this.
+  static constexpr int BATCH_SIZE = 32;
+
+  /// Returns true if the SIMD kernels are available on this CPU.
+  static bool IsSupported() {
+#ifndef __aarch64__
+    return CpuInfo::IsSupported(CpuInfo::AVX2);
+#else
+    return false;
+#endif
+  }
+
+  /// Sets dst[i] to max(dst[i], src[i]) for 0 <= i < 'len'. 'len' must be a multiple of
+  /// BATCH_SIZE.
+  static void MergeAVX2(uint8_t* dst, const uint8_t* src, int len);
+
+  /// Returns the sum of 2^-registers[i] for 0 <= i < 'len' and sets 'num_zero' to the
+  /// number of registers that are zero. 'len' must be a multiple of BATCH_SIZE. The
+  /// terms are added in a different order than in a scalar loop, but the sum of powers
+  /// of two is exact as long as the registers are below 53 - log2(len), which holds for
+  /// any realistic cardinality, so the result is the same.
+  static double SumAVX2(const uint8_t* registers, int len, int* num_zero);
+};
+
+} // namespace impala
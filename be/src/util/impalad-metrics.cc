@@ -45,6 +45,12 @@ const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS =
     "impala-server.num-fragments";
 const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT =
     "impala-server.num-fragments-in-flight";
+const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL =
+    "impala-server.num-fragments-on-thread-pool";
+const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE =
+    "impala-server.num-threads-waiting-for-exchange";
+const char* ImpaladMetricKeys::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO =
+    "impala-server.num-threads-waiting-for-scan-io";
 const char* ImpaladMetricKeys::TOTAL_SCAN_RANGES_PROCESSED =
     "impala-server.scan-ranges.total";
 const char* ImpaladMetricKeys::NUM_SCAN_RANGES_MISSING_VOLUME_ID =
@@ -63,6 +69,12 @@ const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES =
     "impala-server.io-mgr.remote-data-cache-hit-bytes";
 const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT =
     "impala-server.io-mgr.remote-data-cache-hit-count";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES =
+    "impala-server.io-mgr.remote-data-cache-memory-tier-hit-bytes";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT =
+    "impala-server.io-mgr.remote-data-cache-memory-tier-hit-count";
+const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES =
+    "impala-server.io-mgr.remote-data-cache-memory-tier-total-bytes";
 const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES =
     "impala-server.io-mgr.remote-data-cache-miss-bytes";
 const char* ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MISS_COUNT =
@@ -158,6 +170,9 @@ IntGauge* ImpaladMetrics::BACKEND_NUM_QUERIES_EXECUTING = nullptr;
 IntCounter* ImpaladMetrics::IMPALA_SERVER_NUM_QUERIES = nullptr;
 IntCounter* ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS = nullptr;
 IntGauge* ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT = nullptr;
+IntCounter* ImpaladMetrics::IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL = nullptr;
+IntGauge* ImpaladMetrics::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE = nullptr;
+IntGauge* ImpaladMetrics::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO = nullptr;
 IntCounter* ImpaladMetrics::NUM_QUERIES_EXPIRED = nullptr;
 IntCounter* ImpaladMetrics::NUM_QUERIES_SPILLED = nullptr;
 IntCounter* ImpaladMetrics::NUM_RANGES_MISSING_VOLUME_ID = nullptr;
@@ -169,6 +184,8 @@ IntCounter* ImpaladMetrics::IO_MGR_SHORT_CIRCUIT_BYTES_READ = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_CACHED_BYTES_READ = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES = nullptr;
+IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MISS_COUNT = nullptr;
 IntCounter* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_WRITES = nullptr;
@@ -207,6 +224,7 @@ IntGauge* ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_HIT_COUNT = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES = nullptr;
 IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES = nullptr;
+IntGauge* ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES = nullptr;
 IntGauge* ImpaladMetrics::NUM_FILES_OPEN_FOR_INSERT = nullptr;
 IntGauge* ImpaladMetrics::NUM_QUERIES_REGISTERED = nullptr;
 IntGauge* ImpaladMetrics::RESULTSET_CACHE_TOTAL_NUM_ROWS = nullptr;
@@ -297,6 +315,12 @@ void ImpaladMetrics::CreateMetrics(MetricGroup* m) {
       ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS, 0);
   IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT = m->AddGauge(
       ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT, 0);
+  IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL = m->AddCounter(
+      ImpaladMetricKeys::IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL, 0);
+  IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE = m->AddGauge(
+      ImpaladMetricKeys::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE, 0);
+  IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO = m->AddGauge(
+      ImpaladMetricKeys::IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO, 0);
   IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS = m->AddGauge(
       ImpaladMetricKeys::IMPALA_SERVER_NUM_OPEN_HS2_SESSIONS, 0);
   IMPALA_SERVER_NUM_OPEN_BEESWAX_SESSIONS = m->AddGauge(
@@ -350,6 +374,12 @@ void ImpaladMetrics::CreateMetrics(MetricGroup* m) {
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES, 0);
   IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT = IO_MGR_METRICS->AddCounter(
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT = IO_MGR_METRICS->AddCounter(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT, 0);
+  IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES = IO_MGR_METRICS->AddGauge(
+      ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES, 0);
   IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES = IO_MGR_METRICS->AddCounter(
       ImpaladMetricKeys::IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES, 0);
   IO_MGR_REMOTE_DATA_CACHE_MISS_COUNT = IO_MGR_METRICS->AddCounter(
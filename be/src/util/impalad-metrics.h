@@ -43,6 +43,16 @@ class ImpaladMetricKeys {
   /// Number of fragments currently running on this server.
   static const char* IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT;
 
+  /// Number of fragment instances that ran on a pre-spawned thread of the fragment
+  /// execution thread pool instead of a new thread.
+  static const char* IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL;
+
+  /// Number of threads that currently wait for the row batches of an exchange.
+  static const char* IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE;
+
+  /// Number of threads that currently wait for the I/O of a scan range.
+  static const char* IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO;
+
   /// Number of queries that started executing on this backend.
   static const char* BACKEND_NUM_QUERIES_EXECUTED;
 
@@ -82,6 +92,17 @@ class ImpaladMetricKeys {
   /// Total number of cache hits for the remote data cache.
   static const char* IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT;
 
+  /// Total number of bytes read from the memory tier of the remote data cache. Also
+  /// counted in IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES;
+
+  /// Total number of cache hits in the memory tier of the remote data cache. Also
+  /// counted in IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT;
+
+  /// Current byte size of the memory tier of the remote data cache.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES;
+
   /// Total number of bytes missing from the remote data cache.
   static const char* IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES;
 
@@ -249,6 +270,9 @@ class ImpaladMetrics {
   static IntGauge* BACKEND_NUM_QUERIES_EXECUTING;
   static IntCounter* IMPALA_SERVER_NUM_FRAGMENTS;
   static IntGauge* IMPALA_SERVER_NUM_FRAGMENTS_IN_FLIGHT;
+  static IntCounter* IMPALA_SERVER_NUM_FRAGMENTS_ON_THREAD_POOL;
+  static IntGauge* IMPALA_SERVER_NUM_THREADS_WAITING_FOR_EXCHANGE;
+  static IntGauge* IMPALA_SERVER_NUM_THREADS_WAITING_FOR_SCAN_IO;
   static IntCounter* IMPALA_SERVER_NUM_QUERIES;
   static IntCounter* NUM_QUERIES_EXPIRED;
   static IntCounter* NUM_QUERIES_SPILLED;
@@ -260,6 +284,8 @@ class ImpaladMetrics {
   static IntCounter* IO_MGR_CACHED_BYTES_READ;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_BYTES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_HIT_COUNT;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MISS_BYTES;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_MISS_COUNT;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_NUM_WRITES;
@@ -303,6 +329,7 @@ class ImpaladMetrics {
   static IntGauge* IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES;
+  static IntGauge* IO_MGR_REMOTE_DATA_CACHE_MEMORY_TIER_TOTAL_BYTES;
   static IntGauge* NUM_FILES_OPEN_FOR_INSERT;
   static IntGauge* NUM_QUERIES_REGISTERED;
   static IntGauge* RESULTSET_CACHE_TOTAL_NUM_ROWS;
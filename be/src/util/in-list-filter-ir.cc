@@ -0,0 +1,70 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/in-list-filter.h"
+
+#include "runtime/date-value.h"
+#include "runtime/string-value.inline.h"
+
+using namespace impala;
+
+int64_t InListFilter::IntValue(const void* val) const {
+  switch (type_) {
+    case TYPE_TINYINT:
+      return *reinterpret_cast<const int8_t*>(val);
+    case TYPE_SMALLINT:
+      return *reinterpret_cast<const int16_t*>(val);
+    case TYPE_INT:
+      return *reinterpret_cast<const int32_t*>(val);
+    case TYPE_BIGINT:
+      return *reinterpret_cast<const int64_t*>(val);
+    case TYPE_DATE:
+      return reinterpret_cast<const DateValue*>(val)->Value();
+    default:
+      DCHECK(false) << "Not an integer type: " << type_;
+      return 0;
+  }
+}
+
+void InListFilter::Insert(const void* val) {
+  if (UNLIKELY(always_true_)) return;
+  if (UNLIKELY(val == nullptr)) {
+    contains_null_ = true;
+    return;
+  }
+  if (type_ == TYPE_STRING || type_ == TYPE_VARCHAR) {
+    const StringValue* value = reinterpret_cast<const StringValue*>(val);
+    if (str_values_.find(*value) != str_values_.end()) return;
+    str_buffer_.emplace_back(value->ptr, value->len);
+    str_values_.insert(
+        StringValue(const_cast<char*>(str_buffer_.back().data()), value->len));
+  } else {
+    values_.insert(IntValue(val));
+  }
+  if (UNLIKELY(NumValues() > entry_limit_)) SetAlwaysTrue();
+}
+
+bool InListFilter::Find(const void* val) const noexcept {
+  if (always_true_) return true;
+  if (val == nullptr) return contains_null_;
+  if (type_ == TYPE_STRING || type_ == TYPE_VARCHAR) {
+    const StringValue* value = reinterpret_cast<const StringValue*>(val);
+    return str_values_.find(*value) != str_values_.end();
+  }
+  return values_.find(IntValue(val)) != values_.end();
+}
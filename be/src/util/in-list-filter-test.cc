@@ -0,0 +1,182 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "testutil/gtest-util.h"
+#include "util/in-list-filter.h"
+
+#include "common/object-pool.h"
+#include "runtime/date-value.h"
+#include "runtime/string-value.inline.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+// Tests that an integer InListFilter only finds inserted values, and that it turns
+// into an always true filter when it gets more values than its entry limit.
+TEST(InListFilterTest, TestIntInListFilter) {
+  ObjectPool obj_pool;
+  ColumnType int_type(PrimitiveType::TYPE_INT);
+  InListFilter* filter = InListFilter::Create(int_type, 3, &obj_pool);
+  EXPECT_TRUE(filter->AlwaysFalse());
+  EXPECT_FALSE(filter->AlwaysTrue());
+
+  int32_t values[] = {10, -5, 10, 1000};
+  filter->Insert(&values[0]);
+  filter->Insert(&values[1]);
+  filter->Insert(&values[2]);
+  EXPECT_FALSE(filter->AlwaysFalse());
+  EXPECT_EQ(filter->NumValues(), 2);
+  EXPECT_TRUE(filter->Find(&values[0]));
+  EXPECT_TRUE(filter->Find(&values[1]));
+  EXPECT_FALSE(filter->Find(&values[3]));
+  EXPECT_FALSE(filter->Find(nullptr));
+
+  filter->Insert(nullptr);
+  EXPECT_TRUE(filter->Find(nullptr));
+
+  filter->Insert(&values[3]);
+  EXPECT_EQ(filter->NumValues(), 3);
+  EXPECT_FALSE(filter->AlwaysTrue());
+  int32_t other = 7;
+  EXPECT_FALSE(filter->Find(&other));
+  filter->Insert(&other);
+  EXPECT_TRUE(filter->AlwaysTrue());
+  EXPECT_EQ(filter->NumValues(), 0);
+  int32_t unseen = 8;
+  EXPECT_TRUE(filter->Find(&unseen));
+}
+
+// Tests that string values are copied into the filter when they are inserted.
+TEST(InListFilterTest, TestStringInListFilter) {
+  ObjectPool obj_pool;
+  ColumnType string_type(PrimitiveType::TYPE_STRING);
+  InListFilter* filter = InListFilter::Create(string_type, 10, &obj_pool);
+
+  string buffer = "abc";
+  StringValue sv(buffer);
+  filter->Insert(&sv);
+  buffer[0] = 'x';
+  StringValue abc("abc");
+  StringValue xbc("xbc");
+  EXPECT_TRUE(filter->Find(&abc));
+  EXPECT_FALSE(filter->Find(&xbc));
+  filter->Insert(&sv);
+  EXPECT_EQ(filter->NumValues(), 2);
+  EXPECT_TRUE(filter->Find(&xbc));
+}
+
+// Tests that HasValueInRange() only accepts ranges that contain a value of the filter.
+TEST(InListFilterTest, TestHasValueInRange) {
+  ObjectPool obj_pool;
+  ColumnType bigint_type(PrimitiveType::TYPE_BIGINT);
+  InListFilter* filter = InListFilter::Create(bigint_type, 2, &obj_pool);
+  int64_t values[] = {5, 20};
+  filter->Insert(&values[0]);
+  filter->Insert(&values[1]);
+  int64_t bounds[] = {0, 4, 5, 19, 21, 30};
+  EXPECT_FALSE(filter->HasValueInRange(&bounds[0], &bounds[1]));
+  EXPECT_TRUE(filter->HasValueInRange(&bounds[0], &bounds[2]));
+  EXPECT_FALSE(filter->HasValueInRange(&bounds[5], &bounds[0]));
+  EXPECT_FALSE(filter->HasValueInRange(&bounds[4], &bounds[5]));
+  EXPECT_TRUE(filter->HasValueInRange(&bounds[3], &bounds[4]));
+
+  ColumnType string_type(PrimitiveType::TYPE_STRING);
+  InListFilter* str_filter = InListFilter::Create(string_type, 2, &obj_pool);
+  StringValue abc("abc");
+  str_filter->Insert(&abc);
+  StringValue aaa("aaa");
+  StringValue abb("abb");
+  StringValue abd("abd");
+  EXPECT_FALSE(str_filter->HasValueInRange(&aaa, &abb));
+  EXPECT_TRUE(str_filter->HasValueInRange(&abb, &abd));
+  EXPECT_FALSE(str_filter->HasValueInRange(&abd, &abd));
+
+  int64_t value = 100;
+  filter->Insert(&value);
+  EXPECT_TRUE(filter->AlwaysTrue());
+  EXPECT_TRUE(filter->HasValueInRange(&bounds[0], &bounds[1]));
+}
+
+// Tests the round trip through the protobuf representation and Or() of protobufs.
+TEST(InListFilterTest, TestProtobuf) {
+  ObjectPool obj_pool;
+  ColumnType date_type(PrimitiveType::TYPE_DATE);
+  InListFilter* filter = InListFilter::Create(date_type, 4, &obj_pool);
+  DateValue d1(100);
+  DateValue d2(200);
+  DateValue d3(300);
+  filter->Insert(&d1);
+  filter->Insert(&d2);
+
+  InListFilterPB pb1;
+  filter->ToProtobuf(&pb1);
+  EXPECT_FALSE(InListFilter::AlwaysFalse(pb1));
+  InListFilter* copy = InListFilter::Create(pb1, date_type, 4, &obj_pool);
+  EXPECT_EQ(copy->NumValues(), 2);
+  EXPECT_TRUE(copy->Find(&d1));
+  EXPECT_TRUE(copy->Find(&d2));
+  EXPECT_FALSE(copy->Find(&d3));
+
+  InListFilterPB out;
+  EXPECT_TRUE(InListFilter::AlwaysFalse(out));
+  InListFilter::Or(pb1, &out, 4);
+  InListFilter::Or(pb1, &out, 4);
+  EXPECT_EQ(out.value_size(), 2);
+
+  InListFilter* filter2 = InListFilter::Create(date_type, 4, &obj_pool);
+  filter2->Insert(&d3);
+  filter2->Insert(nullptr);
+  InListFilterPB pb2;
+  filter2->ToProtobuf(&pb2);
+  InListFilter::Or(pb2, &out, 4);
+  EXPECT_EQ(out.value_size(), 3);
+  EXPECT_TRUE(out.contains_null());
+  InListFilter* merged = InListFilter::Create(out, date_type, 4, &obj_pool);
+  EXPECT_TRUE(merged->Find(&d1));
+  EXPECT_TRUE(merged->Find(&d3));
+  EXPECT_TRUE(merged->Find(nullptr));
+
+  // Exceeding the entry limit makes the result always true.
+  InListFilter::Or(pb1, &out, 2);
+  EXPECT_TRUE(out.always_true());
+  EXPECT_EQ(out.value_size(), 0);
+  InListFilter* always_true = InListFilter::Create(out, date_type, 4, &obj_pool);
+  EXPECT_TRUE(always_true->AlwaysTrue());
+}
+
+// Tests Or() of two filters.
+TEST(InListFilterTest, TestOr) {
+  ObjectPool obj_pool;
+  ColumnType bigint_type(PrimitiveType::TYPE_BIGINT);
+  InListFilter* f1 = InListFilter::Create(bigint_type, 3, &obj_pool);
+  InListFilter* f2 = InListFilter::Create(bigint_type, 3, &obj_pool);
+  int64_t v1 = 1, v2 = 2, v3 = 3, v4 = 4;
+  f1->Insert(&v1);
+  f1->Insert(&v2);
+  f2->Insert(&v2);
+  f2->Insert(&v3);
+  f1->Or(*f2);
+  EXPECT_EQ(f1->NumValues(), 3);
+  EXPECT_TRUE(f1->Find(&v3));
+  EXPECT_FALSE(f1->Find(&v4));
+
+  f2->Insert(&v4);
+  f1->Or(*f2);
+  EXPECT_TRUE(f1->AlwaysTrue());
+}
@@ -0,0 +1,186 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#include "util/in-list-filter.h"
+
+#include <sstream>
+
+#include "common/object-pool.h"
+#include "runtime/string-value.inline.h"
+
+#include "common/names.h"
+
+using namespace impala;
+
+const char* InListFilter::LLVM_CLASS_NAME = "class.impala::InListFilter";
+
+InListFilter::InListFilter(const ColumnType& type, int entry_limit)
+  : type_(type.type), entry_limit_(entry_limit) {
+  DCHECK(SupportsType(type)) << type;
+  DCHECK_GE(entry_limit_, 0);
+}
+
+bool InListFilter::SupportsType(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_DATE:
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+InListFilter* InListFilter::Create(
+    const ColumnType& type, int entry_limit, ObjectPool* pool) {
+  return pool->Add(new InListFilter(type, entry_limit));
+}
+
+InListFilter* InListFilter::Create(const InListFilterPB& protobuf,
+    const ColumnType& type, int entry_limit, ObjectPool* pool) {
+  InListFilter* filter = Create(type, entry_limit, pool);
+  if (protobuf.always_true()) {
+    filter->SetAlwaysTrue();
+    return filter;
+  }
+  filter->contains_null_ = protobuf.contains_null();
+  bool is_string = type.type == TYPE_STRING || type.type == TYPE_VARCHAR;
+  for (const ColumnValuePB& value : protobuf.value()) {
+    if (is_string) {
+      DCHECK(value.has_string_val());
+      StringValue sv(value.string_val());
+      filter->Insert(&sv);
+    } else {
+      DCHECK(value.has_long_val());
+      filter->values_.insert(value.long_val());
+    }
+  }
+  // The coordinator turns filters with too many values into always true filters, so
+  // this only happens if 'entry_limit' is lower than the limit of the producers.
+  if (filter->NumValues() > entry_limit) filter->SetAlwaysTrue();
+  return filter;
+}
+
+void InListFilter::SetAlwaysTrue() {
+  always_true_ = true;
+  contains_null_ = false;
+  values_.clear();
+  str_values_.clear();
+  str_buffer_.clear();
+}
+
+bool InListFilter::HasValueInRange(const void* min, const void* max) const {
+  if (always_true_) return true;
+  if (type_ == TYPE_STRING || type_ == TYPE_VARCHAR) {
+    const StringValue* min_value = reinterpret_cast<const StringValue*>(min);
+    const StringValue* max_value = reinterpret_cast<const StringValue*>(max);
+    for (const StringValue& value : str_values_) {
+      if (value.Compare(*min_value) >= 0 && value.Compare(*max_value) <= 0) return true;
+    }
+    return false;
+  }
+  int64_t min_value = IntValue(min);
+  int64_t max_value = IntValue(max);
+  for (int64_t value : values_) {
+    if (value >= min_value && value <= max_value) return true;
+  }
+  return false;
+}
+
+void InListFilter::Or(const InListFilter& other) {
+  DCHECK_EQ(type_, other.type_);
+  if (always_true_) return;
+  if (other.always_true_) {
+    SetAlwaysTrue();
+    return;
+  }
+  contains_null_ |= other.contains_null_;
+  for (int64_t value : other.values_) values_.insert(value);
+  for (const StringValue& value : other.str_values_) {
+    Insert(&value);
+    if (always_true_) return;
+  }
+  if (NumValues() > entry_limit_) SetAlwaysTrue();
+}
+
+void InListFilter::ToProtobuf(InListFilterPB* protobuf) const {
+  protobuf->set_always_true(always_true_);
+  if (always_true_) return;
+  protobuf->set_contains_null(contains_null_);
+  for (int64_t value : values_) protobuf->add_value()->set_long_val(value);
+  for (const StringValue& value : str_values_) {
+    protobuf->add_value()->set_string_val(value.ptr, value.len);
+  }
+}
+
+void InListFilter::Or(const InListFilterPB& in, InListFilterPB* out, int entry_limit) {
+  if (out->always_true()) return;
+  if (in.always_true()) {
+    out->Clear();
+    out->set_always_true(true);
+    return;
+  }
+  if (in.contains_null()) out->set_contains_null(true);
+  boost::unordered_set<int64_t> long_vals;
+  boost::unordered_set<string> string_vals;
+  for (const ColumnValuePB& value : out->value()) {
+    if (value.has_string_val()) {
+      string_vals.insert(value.string_val());
+    } else {
+      long_vals.insert(value.long_val());
+    }
+  }
+  for (const ColumnValuePB& value : in.value()) {
+    bool is_new = value.has_string_val() ?
+        string_vals.insert(value.string_val()).second :
+        long_vals.insert(value.long_val()).second;
+    if (is_new) *out->add_value() = value;
+  }
+  if (out->value_size() > entry_limit) {
+    out->Clear();
+    out->set_always_true(true);
+  }
+}
+
+void InListFilter::Copy(const InListFilterPB& in, InListFilterPB* out) {
+  out->CopyFrom(in);
+}
+
+bool InListFilter::AlwaysFalse(const InListFilterPB& protobuf) {
+  return !protobuf.always_true() && !protobuf.contains_null()
+      && protobuf.value_size() == 0;
+}
+
+string InListFilter::DebugString() const {
+  stringstream out;
+  out << "InListFilter(always_true=" << always_true_
+      << ", contains_null=" << contains_null_ << ", num_values=" << NumValues() << ")";
+  return out.str();
+}
+
+string InListFilter::DebugString(const InListFilterPB& protobuf) {
+  stringstream out;
+  out << "InListFilterPB(always_true=" << protobuf.always_true()
+      << ", contains_null=" << protobuf.contains_null()
+      << ", num_values=" << protobuf.value_size() << ")";
+  return out.str();
+}
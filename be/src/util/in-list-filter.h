@@ -0,0 +1,146 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+
+#ifndef IMPALA_UTIL_IN_LIST_FILTER_H
+#define IMPALA_UTIL_IN_LIST_FILTER_H
+
+#include <deque>
+#include <string>
+
+#include <boost/unordered_set.hpp>
+
+#include "gen-cpp/data_stream_service.pb.h"
+#include "runtime/string-value.h"
+#include "runtime/types.h"
+
+namespace impala {
+
+class ObjectPool;
+
+/// An InListFilter holds the exact set of distinct values seen in a data set for use in
+/// runtime filters. Unlike a bloom filter, it has no false positives, and unlike a
+/// min-max filter, it rejects the values between the ones that were seen. Its values can
+/// also be pushed to storage engines as an IN-list predicate. It is meant for small join
+/// builds, e.g. dimension tables with a few hundred keys.
+///
+/// A filter holds at most 'entry_limit' values. Inserting more distinct values than that
+/// turns it into an always true filter, which lets all rows pass, so the memory used by
+/// a filter is bounded. Only integer, DATE, STRING and VARCHAR values are supported, see
+/// SupportsType(). Integer and DATE values are held as int64_t. Strings are copied into
+/// memory owned by the filter when they are inserted.
+///
+/// Unlike MinMaxFilters, InListFilters track whether a NULL was inserted, so they are
+/// also correct for 'is not distinct from' join predicates.
+class InListFilter {
+ public:
+  InListFilter(const ColumnType& type, int entry_limit);
+
+  /// Returns true if values of 'type' can be held by an InListFilter.
+  static bool SupportsType(const ColumnType& type);
+
+  /// Returns a new InListFilter of 'type' allocated from 'pool'.
+  static InListFilter* Create(const ColumnType& type, int entry_limit, ObjectPool* pool);
+
+  /// Returns a new InListFilter created from the protobuf representation, allocated
+  /// from 'pool'.
+  static InListFilter* Create(const InListFilterPB& protobuf, const ColumnType& type,
+      int entry_limit, ObjectPool* pool);
+
+  /// Adds 'val', which is in the tuple slot representation of the filter's type, or
+  /// NULL. Turns the filter into an always true filter if it gets more than
+  /// 'entry_limit_' values.
+  void Insert(const void* val);
+
+  /// Returns true if 'val' was inserted into this filter or if the filter is always
+  /// true. 'val' is in the tuple slot representation of the filter's type, or NULL.
+  bool Find(const void* val) const noexcept;
+
+  /// Returns true if a value of the filter lies in ['min', 'max'] or if the filter is
+  /// always true. 'min' and 'max' are in the tuple slot representation of the filter's
+  /// type. Used to skip data whose column min/max statistics rule out every value.
+  bool HasValueInRange(const void* min, const void* max) const;
+
+  /// If true, this filter allows all rows to pass.
+  bool AlwaysTrue() const { return always_true_; }
+
+  /// If true, this filter doesn't allow any rows to pass.
+  bool AlwaysFalse() const {
+    return !always_true_ && !contains_null_ && NumValues() == 0;
+  }
+
+  /// Turns this filter into an always true filter and frees its values.
+  void SetAlwaysTrue();
+
+  bool contains_null() const { return contains_null_; }
+  PrimitiveType type() const { return type_; }
+  int NumValues() const { return values_.size() + str_values_.size(); }
+
+  /// The values of an integer or DATE filter. DATE values are days since the epoch.
+  const boost::unordered_set<int64_t>& values() const { return values_; }
+
+  /// The values of a STRING or VARCHAR filter.
+  const boost::unordered_set<StringValue>& str_values() const { return str_values_; }
+
+  /// Updates this filter with the logical OR of this filter and 'other'.
+  void Or(const InListFilter& other);
+
+  /// Converts this filter to a protobuf representation.
+  void ToProtobuf(InListFilterPB* protobuf) const;
+
+  /// Computes the logical OR of 'in' with 'out' and stores the result in 'out'. 'out'
+  /// becomes always true if the result has more than 'entry_limit' values.
+  static void Or(const InListFilterPB& in, InListFilterPB* out, int entry_limit);
+
+  /// Copies the contents of 'in' into 'out'.
+  static void Copy(const InListFilterPB& in, InListFilterPB* out);
+
+  /// Returns true if 'protobuf' doesn't allow any rows to pass.
+  static bool AlwaysFalse(const InListFilterPB& protobuf);
+
+  std::string DebugString() const;
+  static std::string DebugString(const InListFilterPB& protobuf);
+
+  /// Class name in LLVM IR.
+  static const char* LLVM_CLASS_NAME;
+
+ private:
+  /// Returns the integer or DATE value 'val' as int64_t.
+  int64_t IntValue(const void* val) const;
+
+  const PrimitiveType type_;
+
+  /// The maximum number of values of this filter.
+  const int entry_limit_;
+
+  bool always_true_ = false;
+  bool contains_null_ = false;
+
+  /// The values of an integer or DATE filter.
+  boost::unordered_set<int64_t> values_;
+
+  /// The values of a STRING or VARCHAR filter. Point into 'str_buffer_'.
+  boost::unordered_set<StringValue> str_values_;
+
+  /// Memory of the strings in 'str_values_'. A deque, so that the strings don't move
+  /// when new ones are added.
+  std::deque<std::string> str_buffer_;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <mutex>
+#include <boost/thread/thread.hpp>
+
+#include "common/thread-debug-info.h"
+#include "testutil/gtest-util.h"
+#include "util/lock-contention.h"
+#include "util/metrics.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+TEST(LockContentionTest, Basic) {
+  // The metrics are only registered once per process.
+  static MetricGroup metrics("test");
+  LockContention::InitMetrics(&metrics);
+  IntCounter* num_waits_metric = metrics.FindMetricForTesting<IntCounter>(
+      "lock-contention.reservation-tracker.num-waits");
+  ASSERT_TRUE(num_waits_metric != nullptr);
+
+  TrackedSpinLock lock(LockContention::RESERVATION_TRACKER);
+  LockContentionCounters counters;
+  // Uncontended acquisitions are not recorded.
+  {
+    lock_guard<TrackedSpinLock> l(lock);
+  }
+
+  unique_lock<TrackedSpinLock> l(lock);
+  thread waiter([&lock, &counters]() {
+    ThreadDebugInfo tdi;
+    ScopedLockContentionCounters scoped_counters(&counters);
+    lock_guard<TrackedSpinLock> l(lock);
+  });
+  SleepForMs(100);
+  l.unlock();
+  waiter.join();
+
+  const int i = LockContention::RESERVATION_TRACKER;
+  EXPECT_EQ(1, counters.num_waits[i].Load());
+  EXPECT_GE(counters.wait_time_ns[i].Load(), 50L * 1000L * 1000L);
+  EXPECT_EQ(1, num_waits_metric->GetValue());
+  EXPECT_EQ(0, counters.num_waits[LockContention::DISK_QUEUE].Load());
+
+  // Threads without counters only add to the metrics.
+  std::mutex mutex;
+  std::unique_lock<std::mutex> mutex_lock(mutex);
+  thread other_waiter([&mutex]() {
+    std::unique_lock<std::mutex> l(mutex, std::defer_lock);
+    LockContention::Lock(&l, LockContention::DISK_QUEUE);
+  });
+  SleepForMs(100);
+  mutex_lock.unlock();
+  other_waiter.join();
+  EXPECT_EQ(0, counters.num_waits[LockContention::DISK_QUEUE].Load());
+  EXPECT_EQ(1, metrics.FindMetricForTesting<IntCounter>(
+      "lock-contention.disk-queue.num-waits")->GetValue());
+}
+
+}
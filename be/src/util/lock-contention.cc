@@ -0,0 +1,94 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/lock-contention.h"
+
+#include "common/logging.h"
+#include "common/thread-debug-info.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+namespace {
+
+struct LockInfo {
+  // Name of the lock in profiles.
+  const char* profile_name;
+  // Name of the lock in the keys of metrics.
+  const char* metric_name;
+};
+
+const LockInfo LOCK_INFOS[LockContention::NUM_LOCK_IDS] = {
+    {"ReservationTracker", "reservation-tracker"},
+    {"DiskQueue", "disk-queue"},
+    {"DataStreamRecvr", "data-stream-recvr"},
+};
+
+// Process-wide metrics, by LockId. Set by the first call of InitMetrics().
+IntCounter* wait_time_metrics[LockContention::NUM_LOCK_IDS] = {};
+IntCounter* num_waits_metrics[LockContention::NUM_LOCK_IDS] = {};
+
+}
+
+const char* LockContention::ProfileName(LockId id) {
+  DCHECK_GE(id, 0);
+  DCHECK_LT(id, NUM_LOCK_IDS);
+  return LOCK_INFOS[id].profile_name;
+}
+
+void LockContention::InitMetrics(MetricGroup* metrics) {
+  // Tests may start several daemons in one process, of which only the first one gets
+  // the metrics.
+  if (wait_time_metrics[0] != nullptr) return;
+  MetricGroup* group = metrics->GetOrCreateChildGroup("lock-contention");
+  for (int i = 0; i < NUM_LOCK_IDS; ++i) {
+    wait_time_metrics[i] = group->AddCounter(
+        "lock-contention.$0.wait-time-ns", 0, LOCK_INFOS[i].metric_name);
+    num_waits_metrics[i] = group->AddCounter(
+        "lock-contention.$0.num-waits", 0, LOCK_INFOS[i].metric_name);
+  }
+}
+
+void LockContention::RecordWait(LockId id, int64_t wait_ns) {
+  if (wait_time_metrics[id] != nullptr) {
+    wait_time_metrics[id]->Increment(wait_ns);
+    num_waits_metrics[id]->Increment(1);
+  }
+  const ThreadDebugInfo* tdi = GetThreadDebugInfo();
+  if (tdi == nullptr) return;
+  LockContentionCounters* counters = tdi->GetLockContentionCounters();
+  if (counters == nullptr) return;
+  counters->wait_time_ns[id].Add(wait_ns);
+  counters->num_waits[id].Add(1);
+}
+
+ScopedLockContentionCounters::ScopedLockContentionCounters(
+    LockContentionCounters* counters)
+  : thread_debug_info_(GetThreadDebugInfo()) {
+  if (thread_debug_info_ == nullptr) return;
+  prev_counters_ = thread_debug_info_->GetLockContentionCounters();
+  thread_debug_info_->SetLockContentionCounters(counters);
+}
+
+ScopedLockContentionCounters::~ScopedLockContentionCounters() {
+  if (thread_debug_info_ == nullptr) return;
+  thread_debug_info_->SetLockContentionCounters(prev_counters_);
+}
+
+}
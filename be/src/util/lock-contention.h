@@ -0,0 +1,121 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/atomic.h"
+#include "common/compiler-util.h"
+#include "gutil/macros.h"
+#include "util/spinlock.h"
+#include "util/time.h"
+
+namespace impala {
+
+class MetricGroup;
+class ThreadDebugInfo;
+
+/// Tracks the contention of the major named locks in the execution path, which are
+/// not covered by the process-wide spinlock profiling of kudu/util. The time that
+/// threads wait for a tracked lock and the number of waits are added to process-wide
+/// metrics and to the LockContentionCounters of the query of the waiting thread, which
+/// are taken from its ThreadDebugInfo.
+///
+/// Acquiring an uncontended tracked lock only costs a try_lock() more than acquiring
+/// the lock directly.
+class LockContention {
+ public:
+  enum LockId {
+    /// The lock of a ReservationTracker.
+    RESERVATION_TRACKER = 0,
+    /// The lock of the queue of the requests to a disk of the DiskIoMgr.
+    DISK_QUEUE,
+    /// The lock of a sender queue of a KrpcDataStreamRecvr.
+    DATA_STREAM_RECVR,
+    NUM_LOCK_IDS
+  };
+
+  /// Returns the name of 'id' in profiles, e.g. "ReservationTracker".
+  static const char* ProfileName(LockId id);
+
+  /// Registers the process-wide metrics of the tracked locks in 'metrics', unless they
+  /// were registered before. Waits before the metrics are registered are only added to
+  /// the counters of queries.
+  static void InitMetrics(MetricGroup* metrics);
+
+  /// Acquires 'lock', which is a tracked lock 'id', and records the time it waited for
+  /// the lock if it was held by another thread. 'lock' can be any lockable, e.g. a
+  /// std::unique_lock that does not own its mutex yet.
+  template <typename LockType>
+  static void Lock(LockType* lock, LockId id) {
+    if (LIKELY(lock->try_lock())) return;
+    const int64_t start_ns = MonotonicNanos();
+    lock->lock();
+    RecordWait(id, MonotonicNanos() - start_ns);
+  }
+
+ private:
+  /// Adds a wait of 'wait_ns' for 'id' to the metrics and the counters of the query of
+  /// the calling thread.
+  static void RecordWait(LockId id, int64_t wait_ns);
+};
+
+/// Wait times and numbers of waits of the tracked locks, by LockId. Thread-safe.
+struct LockContentionCounters {
+  AtomicInt64 wait_time_ns[LockContention::NUM_LOCK_IDS];
+  AtomicInt64 num_waits[LockContention::NUM_LOCK_IDS];
+};
+
+/// Attributes the lock contention of the calling thread to 'counters' while in scope.
+/// 'counters' may be nullptr.
+class ScopedLockContentionCounters {
+ public:
+  explicit ScopedLockContentionCounters(LockContentionCounters* counters);
+  ~ScopedLockContentionCounters();
+
+ private:
+  ThreadDebugInfo* const thread_debug_info_;
+  LockContentionCounters* prev_counters_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedLockContentionCounters);
+};
+
+/// A lockable that tracks the contention of a lock of type 'LockType' as 'id'. Can be
+/// used with std::lock_guard, std::unique_lock and std::condition_variable_any.
+template <typename LockType>
+class ContentionTrackedLock {
+ public:
+  explicit ContentionTrackedLock(LockContention::LockId id) : id_(id) {}
+
+  void lock() { LockContention::Lock(&lock_, id_); }
+  void unlock() { lock_.unlock(); }
+  bool try_lock() { return lock_.try_lock(); }
+
+  /// Verify that the lock is held. Only available if 'LockType' supports it.
+  void DCheckLocked() { lock_.DCheckLocked(); }
+
+ private:
+  const LockContention::LockId id_;
+  LockType lock_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContentionTrackedLock);
+};
+
+typedef ContentionTrackedLock<SpinLock> TrackedSpinLock;
+
+}
@@ -0,0 +1,186 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "testutil/gtest-util.h"
+#include "util/lock-free-blocking-queue.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Functor that returns the size of T.
+template <typename T>
+struct SizeofFn {
+  int64_t operator()(const T& item) {
+    return sizeof(T);
+  }
+};
+
+TEST(LockFreeBlockingQueueTest, TestBasic) {
+  int32_t i;
+  LockFreeBlockingQueue<int32_t> test_queue(5);
+  ASSERT_TRUE(test_queue.BlockingPut(1));
+  ASSERT_TRUE(test_queue.BlockingPut(2));
+  ASSERT_TRUE(test_queue.BlockingPut(3));
+  EXPECT_EQ(3, test_queue.Size());
+  ASSERT_TRUE(test_queue.BlockingGet(&i));
+  ASSERT_EQ(1, i);
+  ASSERT_TRUE(test_queue.BlockingGet(&i));
+  ASSERT_EQ(2, i);
+  ASSERT_TRUE(test_queue.BlockingGet(&i));
+  ASSERT_EQ(3, i);
+  EXPECT_EQ(0, test_queue.Size());
+}
+
+TEST(LockFreeBlockingQueueTest, TestSingleElement) {
+  int32_t i;
+  LockFreeBlockingQueue<int32_t> test_queue(1);
+  for (int n = 0; n < 3; ++n) {
+    ASSERT_TRUE(test_queue.BlockingPut(n));
+    EXPECT_TRUE(test_queue.AtCapacity());
+    ASSERT_FALSE(test_queue.BlockingPutWithTimeout(n, 1000));
+    ASSERT_TRUE(test_queue.BlockingGet(&i));
+    ASSERT_EQ(n, i);
+  }
+}
+
+TEST(LockFreeBlockingQueueTest, TestGetFromShutdownQueue) {
+  int64_t i;
+  LockFreeBlockingQueue<int64_t> test_queue(2);
+  ASSERT_TRUE(test_queue.BlockingPut(123));
+  test_queue.Shutdown();
+  ASSERT_FALSE(test_queue.BlockingPut(456));
+  ASSERT_TRUE(test_queue.BlockingGet(&i));
+  ASSERT_EQ(123, i);
+  ASSERT_FALSE(test_queue.BlockingGet(&i));
+}
+
+TEST(LockFreeBlockingQueueTest, TestPutWithTimeout) {
+  int64_t i;
+  // The capacity is not a power of two, which the queue's ring buffer size is.
+  LockFreeBlockingQueue<int64_t> test_queue(3);
+  int64_t timeout_micros = 100 * 1000L; // 100 msecs
+  ASSERT_TRUE(test_queue.BlockingPutWithTimeout(1, timeout_micros));
+  ASSERT_TRUE(test_queue.BlockingPutWithTimeout(2, timeout_micros));
+  ASSERT_TRUE(test_queue.BlockingPutWithTimeout(3, timeout_micros));
+  EXPECT_TRUE(test_queue.AtCapacity());
+  int64_t start_ms = MonotonicMillis();
+  ASSERT_FALSE(test_queue.BlockingPutWithTimeout(4, timeout_micros));
+  EXPECT_GE(MonotonicMillis() - start_ms, timeout_micros / 1000);
+  ASSERT_TRUE(test_queue.BlockingGet(&i));
+  EXPECT_EQ(1, i);
+  ASSERT_TRUE(test_queue.BlockingPutWithTimeout(4, timeout_micros));
+}
+
+TEST(LockFreeBlockingQueueTest, TestBytesLimit) {
+  // 10 bytes => limit of 2 elements
+  LockFreeBlockingQueue<int32_t, SizeofFn<int32_t>> test_queue(1000, 10);
+  int64_t SHORT_TIMEOUT_MICROS = 1 * 1000L; // 1ms
+  int64_t LONG_TIMEOUT_MICROS = 1000L * 1000L * 60L; // 1m
+
+  // First two should succeed.
+  ASSERT_TRUE(test_queue.BlockingPut(1));
+  ASSERT_TRUE(test_queue.BlockingPutWithTimeout(2, SHORT_TIMEOUT_MICROS));
+  EXPECT_EQ(2, test_queue.Size());
+
+  // Put should timeout - no capacity.
+  ASSERT_FALSE(test_queue.BlockingPutWithTimeout(3, SHORT_TIMEOUT_MICROS));
+  EXPECT_EQ(2, test_queue.Size());
+
+  // Test that puts of both types get blocked then unblocked when bytes are
+  // removed from queue.
+  std::thread put_thread([&] () { test_queue.BlockingPut(4); });
+  std::thread put_with_timeout_thread([&] () {
+    test_queue.BlockingPutWithTimeout(4, LONG_TIMEOUT_MICROS);
+  });
+  int32_t v;
+  EXPECT_TRUE(test_queue.BlockingGet(&v));
+  EXPECT_EQ(1, v);
+  EXPECT_TRUE(test_queue.BlockingGet(&v));
+  EXPECT_EQ(2, v);
+  EXPECT_TRUE(test_queue.BlockingGet(&v));
+  EXPECT_EQ(4, v);
+  EXPECT_TRUE(test_queue.BlockingGet(&v));
+  EXPECT_EQ(4, v);
+
+  put_thread.join();
+  put_with_timeout_thread.join();
+}
+
+TEST(LockFreeBlockingQueueTest, TestDestroyNonEmpty) {
+  // Elements that are left in the queue are destroyed with it.
+  std::shared_ptr<int> elem = std::make_shared<int>(1);
+  {
+    LockFreeBlockingQueue<std::shared_ptr<int>> test_queue(4);
+    ASSERT_TRUE(test_queue.BlockingPut(elem));
+    ASSERT_TRUE(test_queue.BlockingPut(elem));
+    EXPECT_EQ(3, elem.use_count());
+  }
+  EXPECT_EQ(1, elem.use_count());
+}
+
+/// Runs many producers and consumers on one queue. Every consumer makes one more
+/// BlockingGet() call than there are elements for it, so some of them return false once
+/// the last producer shut down the queue.
+template <typename ElemBytesFn>
+static void RunMultipleThreads(int64_t bytes_limit) {
+  const int iterations = 10000;
+  const int nthreads = 5;
+  LockFreeBlockingQueue<int32_t, ElemBytesFn> queue(
+      iterations * nthreads / 10, bytes_limit);
+  mutex lock;
+  map<int32_t, int> gotten;
+  int num_inserters = nthreads;
+  vector<std::thread> threads;
+  auto remover = [&]() {
+    for (int i = 0; i < iterations; ++i) {
+      int32_t arg;
+      if (!queue.BlockingGet(&arg)) arg = -1;
+      lock_guard<mutex> guard(lock);
+      ++gotten[arg];
+    }
+  };
+  for (int t = 0; t < nthreads; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < iterations; ++i) queue.BlockingPut(t);
+      lock_guard<mutex> guard(lock);
+      if (--num_inserters == 0) queue.Shutdown();
+    });
+    threads.emplace_back(remover);
+  }
+  threads.emplace_back(remover);
+  for (std::thread& t : threads) t.join();
+  for (int t = 0; t < nthreads; ++t) EXPECT_EQ(iterations, gotten[t]);
+  EXPECT_EQ(iterations, gotten[-1]);
+}
+
+TEST(LockFreeBlockingQueueTest, TestMultipleThreads) {
+  RunMultipleThreads<ByteLimitDisabledFn<int32_t>>(-1);
+}
+
+TEST(LockFreeBlockingQueueTest, TestMultipleThreadsWithBytesLimit) {
+  RunMultipleThreads<SizeofFn<int32_t>>(100);
+}
+
+}
@@ -0,0 +1,354 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "common/atomic.h"
+#include "common/compiler-util.h"
+#include "gutil/macros.h"
+#include "gutil/port.h"
+#include "util/aligned-new.h"
+#include "util/bit-util.h"
+#include "util/blocking-queue.h"
+#include "util/condition-variable.h"
+#include "util/runtime-profile.h"
+#include "util/stopwatch.h"
+#include "util/time.h"
+
+namespace impala {
+
+/// Fixed capacity FIFO queue with the same interface and semantics as BlockingQueue,
+/// including the optional soft limit on the bytes enqueued with 'ElemBytesFn', that can
+/// be used instead of it where many producers feed the queue, e.g. the scanner threads
+/// of a scan node. BlockingQueue serializes all producers on 'put_lock_' and wakes up
+/// the other side through a condition variable on every operation, which becomes a
+/// bottleneck with many producers. This queue is a bounded lock-free ring buffer
+/// (Dmitry Vyukov's MPMC queue): producers and consumers claim slots with a CAS on
+/// their position, and every slot has a sequence number that tells whether it holds an
+/// element. Neither side takes a lock as long as the queue is neither empty nor full.
+///
+/// A thread that cannot make progress spins for a short while, since the other side
+/// usually catches up quickly, and then parks on a condition variable. The other side
+/// only takes the lock and notifies if a thread is parked, which it sees from
+/// 'get_waiters_' and 'put_waiters_'.
+///
+/// Like BlockingQueue, the order of elements is FIFO among the elements of one
+/// producer. The hard limit of 'max_elements' elements is never exceeded.
+template <typename T, typename ElemBytesFn = ByteLimitDisabledFn<T>>
+class LockFreeBlockingQueue : public CacheLineAligned {
+ public:
+  LockFreeBlockingQueue(size_t max_elements, int64_t max_bytes = -1,
+      RuntimeProfile::Counter* get_wait_timer = nullptr,
+      RuntimeProfile::Counter* put_wait_timer = nullptr)
+    : max_elements_(max_elements),
+      capacity_(std::max<int64_t>(2, BitUtil::RoundUpToPowerOfTwo(max_elements))),
+      slots_(new Slot[capacity_]),
+      max_bytes_(max_bytes),
+      get_wait_timer_(get_wait_timer),
+      put_wait_timer_(put_wait_timer) {
+    DCHECK(max_bytes == -1 || max_bytes > 0) << max_bytes;
+    DCHECK_GT(max_elements_, 0);
+    for (int64_t i = 0; i < capacity_; ++i) slots_[i].seq.store(i);
+  }
+
+  ~LockFreeBlockingQueue() {
+    // All claimed slots hold an element when no thread uses the queue anymore.
+    for (int64_t pos = dequeue_pos_.load(); pos < enqueue_pos_.load(); ++pos) {
+      slots_[pos & (capacity_ - 1)].elem()->~T();
+    }
+  }
+
+  /// Gets an element from the queue, waiting indefinitely for one to become available.
+  /// Returns false if we were shut down prior to getting the element, and there
+  /// are no more elements available.
+  bool BlockingGet(T* out) {
+    if (LIKELY(TryGet(out))) return true;
+    MonotonicStopWatch timer;
+    if (get_wait_timer_ != nullptr) timer.Start();
+    bool got = false;
+    for (int i = 0; !got; ++i) {
+      if (UNLIKELY(shutdown_.load())) {
+        got = GetAfterShutdown(out);
+        break;
+      }
+      if (i < NUM_SPINS) {
+        AtomicUtil::CpuWait();
+      } else {
+        Park(&get_waiters_, &get_cv_, [this]() { return CanGet() || shutdown_.load(); });
+      }
+      got = TryGet(out);
+    }
+    if (get_wait_timer_ != nullptr) get_wait_timer_->Add(timer.ElapsedTime());
+    return got;
+  }
+
+  /// Puts an element into the queue, waiting indefinitely until there is space. Rvalues
+  /// are moved into the queue, lvalues are copied. If the queue is shut down, returns
+  /// false. V is a type that is compatible with T; that is, objects of type V can be
+  /// inserted into the queue.
+  template <typename V>
+  bool BlockingPut(V&& val) {
+    return BlockingPutInternal(std::forward<V>(val), nullptr);
+  }
+
+  /// Puts an element into the queue, waiting until 'timeout_micros' elapses, if there is
+  /// no space. If the queue is shut down, or if the timeout elapsed without being able to
+  /// put the element, returns false. Rvalues are moved into the queue, lvalues are
+  /// copied. V is a type that is compatible with T; that is, objects of type V can be
+  /// inserted into the queue.
+  template <typename V>
+  bool BlockingPutWithTimeout(V&& val, int64_t timeout_micros) {
+    timespec abs_time;
+    TimeFromNowMicros(timeout_micros, &abs_time);
+    return BlockingPutInternal(std::forward<V>(val), &abs_time);
+  }
+
+  /// Shut down the queue. Wakes up all threads waiting on BlockingGet or BlockingPut.
+  void Shutdown() {
+    shutdown_.store(true);
+    // Notify with 'park_lock_' held, so that a thread that is about to park either sees
+    // 'shutdown_' or is woken up.
+    std::lock_guard<std::mutex> l(park_lock_);
+    get_cv_.NotifyAll();
+    put_cv_.NotifyAll();
+  }
+
+  /// Returns the number of elements in the queue. Elements that are being added or
+  /// removed concurrently may or may not be included.
+  uint32_t Size() const {
+    int64_t size = enqueue_pos_.load() - dequeue_pos_.load();
+    return size < 0 ? 0 : size;
+  }
+
+  bool AtCapacity() const { return Size() >= max_elements_; }
+
+ private:
+  /// Number of times that a thread that cannot make progress checks again before it
+  /// parks.
+  static constexpr int NUM_SPINS = 100;
+
+  /// A slot of the ring buffer. The element in 'storage' is only constructed while 'seq'
+  /// shows that the slot is full. The slots are padded to a cache line, so that
+  /// producers and consumers that work on neighbouring slots do not share cache lines.
+  struct Slot : public CacheLineAligned {
+    /// pos if the slot is free for the producer at position 'pos', pos + 1 if it holds
+    /// the element added at position 'pos'.
+    std::atomic<int64_t> seq;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+    T* elem() { return reinterpret_cast<T*>(&storage); }
+  };
+
+  template <typename V>
+  bool BlockingPutInternal(V&& val, const timespec* abs_time) {
+    int64_t val_bytes = ElemBytesFn()(val);
+    DCHECK_GE(val_bytes, 0);
+    if (UNLIKELY(shutdown_.load())) return false;
+    if (LIKELY(TryPut(std::forward<V>(val), val_bytes))) return true;
+    MonotonicStopWatch timer;
+    if (put_wait_timer_ != nullptr) timer.Start();
+    bool put = false;
+    bool notified = true;
+    for (int i = 0; !put && !shutdown_.load(); ++i) {
+      if (i < NUM_SPINS) {
+        AtomicUtil::CpuWait();
+      } else if (abs_time == nullptr) {
+        Park(&put_waiters_, &put_cv_,
+            [this, val_bytes]() { return CanPut(val_bytes) || shutdown_.load(); });
+      } else if (!notified) {
+        // Timed out. The wait may have consumed a notification that was meant for
+        // another producer, so pass it on.
+        Notify(&put_waiters_, &put_cv_);
+        break;
+      } else {
+        notified = Park(&put_waiters_, &put_cv_,
+            [this, val_bytes]() { return CanPut(val_bytes) || shutdown_.load(); },
+            abs_time);
+      }
+      put = TryPut(std::forward<V>(val), val_bytes);
+    }
+    if (put_wait_timer_ != nullptr) put_wait_timer_->Add(timer.ElapsedTime());
+    return put;
+  }
+
+  /// Adds 'val' if the queue has capacity for it. 'val' is only moved from if it was
+  /// added.
+  template <typename V>
+  bool TryPut(V&& val, int64_t val_bytes) {
+    int64_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      if (!HasCapacity(pos, val_bytes)) return false;
+      slot = &slots_[pos & (capacity_ - 1)];
+      int64_t diff = slot->seq.load(std::memory_order_acquire) - pos;
+      if (diff == 0) {
+        // The slot is free. Claim it, unless another producer did first.
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1)) break;
+      } else if (diff < 0) {
+        // A consumer has not freed the slot yet.
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    new (slot->elem()) T(std::forward<V>(val));
+    bytes_enqueued_.fetch_add(val_bytes);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    Notify(&get_waiters_, &get_cv_);
+    return true;
+  }
+
+  bool TryGet(T* out) {
+    int64_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+      slot = &slots_[pos & (capacity_ - 1)];
+      int64_t diff = slot->seq.load(std::memory_order_acquire) - (pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1)) break;
+      } else if (diff < 0) {
+        // The queue is empty or the producer of the slot has not finished adding to it.
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T* elem = slot->elem();
+    *out = std::move(*elem);
+    elem->~T();
+    slot->seq.store(pos + capacity_, std::memory_order_release);
+    int64_t val_bytes = ElemBytesFn()(*out);
+    DCHECK_GE(val_bytes, 0);
+    bytes_enqueued_.fetch_sub(val_bytes);
+    Notify(&put_waiters_, &put_cv_);
+    return true;
+  }
+
+  /// Elements that were added before the shutdown are still handed out, including the
+  /// ones whose producers claimed their slot but have not finished adding them yet.
+  bool GetAfterShutdown(T* out) {
+    while (true) {
+      if (TryGet(out)) return true;
+      if (dequeue_pos_.load() >= enqueue_pos_.load()) return false;
+      AtomicUtil::CpuWait();
+    }
+  }
+
+  /// Returns true if an element of 'val_bytes' can be added at position 'pos'. The
+  /// bytes limit is a soft limit, as in BlockingQueue: an element can always be added
+  /// to an empty queue.
+  bool HasCapacity(int64_t pos, int64_t val_bytes) const {
+    int64_t size = pos - dequeue_pos_.load();
+    if (size >= max_elements_) return false;
+    if (val_bytes == 0 || max_bytes_ == -1 || size <= 0) return true;
+    return bytes_enqueued_.load() + val_bytes <= max_bytes_;
+  }
+
+  bool CanPut(int64_t val_bytes) const {
+    int64_t pos = enqueue_pos_.load();
+    return HasCapacity(pos, val_bytes)
+        && slots_[pos & (capacity_ - 1)].seq.load() == pos;
+  }
+
+  bool CanGet() const {
+    int64_t pos = dequeue_pos_.load();
+    return slots_[pos & (capacity_ - 1)].seq.load() == pos + 1;
+  }
+
+  /// Waits on 'cv' until it is notified, unless 'ready' returns true, or until
+  /// 'abs_time' if it is not nullptr. Returns false if the wait timed out.
+  template <typename ReadyFn>
+  bool Park(std::atomic<int>* waiters, ConditionVariable* cv, const ReadyFn& ready,
+      const timespec* abs_time = nullptr) {
+    std::unique_lock<std::mutex> l(park_lock_);
+    // Announce the waiter before checking 'ready', while the other side first publishes
+    // its change and then checks for waiters. Either this thread sees the change or the
+    // other side sees the waiter and notifies it with 'park_lock_' held, which it can
+    // only do once this thread is waiting.
+    waiters->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool notified = true;
+    if (!ready()) {
+      if (abs_time == nullptr) {
+        cv->Wait(l);
+      } else {
+        notified = cv->WaitUntil(l, *abs_time);
+      }
+    }
+    waiters->fetch_sub(1);
+    return notified;
+  }
+
+  /// Wakes up a thread that is parked on 'cv', if there is one.
+  void Notify(std::atomic<int>* waiters, ConditionVariable* cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (LIKELY(waiters->load(std::memory_order_relaxed) == 0)) return;
+    std::lock_guard<std::mutex> l(park_lock_);
+    cv->NotifyOne();
+  }
+
+  /// Maximum number of elements in the queue.
+  const int64_t max_elements_;
+
+  /// Number of slots in 'slots_', a power of two that is at least 'max_elements_'. At
+  /// least two, since a free slot must have a different sequence number than a full one.
+  const int64_t capacity_;
+
+  const std::unique_ptr<Slot[]> slots_;
+
+  /// Soft limit on total bytes in queue. -1 if no limit.
+  const int64_t max_bytes_;
+
+  /// Total amount of time threads blocked in BlockingGet() and BlockingPut().
+  RuntimeProfile::Counter* const get_wait_timer_;
+  RuntimeProfile::Counter* const put_wait_timer_;
+
+  /// Position of the next element to be added. Only producers update it, so it has its
+  /// own cache line.
+  alignas(CACHELINE_SIZE) std::atomic<int64_t> enqueue_pos_{0};
+
+  /// Position of the next element to be removed. Only consumers update it.
+  alignas(CACHELINE_SIZE) std::atomic<int64_t> dequeue_pos_{0};
+
+  /// Bytes of the elements in the queue, according to 'ElemBytesFn'.
+  alignas(CACHELINE_SIZE) std::atomic<int64_t> bytes_enqueued_{0};
+
+  /// Number of threads parked in BlockingGet() and BlockingPut().
+  alignas(CACHELINE_SIZE) std::atomic<int> get_waiters_{0};
+  std::atomic<int> put_waiters_{0};
+
+  std::atomic<bool> shutdown_{false};
+
+  /// Protects parking on and notifying 'get_cv_' and 'put_cv_'.
+  std::mutex park_lock_;
+  ConditionVariable get_cv_;
+  ConditionVariable put_cv_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockFreeBlockingQueue);
+};
+
+template <typename T, typename ElemBytesFn>
+constexpr int LockFreeBlockingQueue<T, ElemBytesFn>::NUM_SPINS;
+}
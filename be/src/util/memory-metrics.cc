@@ -22,6 +22,7 @@
 
 #include "runtime/bufferpool/buffer-pool.h"
 #include "runtime/bufferpool/reservation-tracker.h"
+#include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
 #include "util/jni-util.h"
 #include "util/mem-info.h"
@@ -60,6 +61,10 @@ TcmallocMetric::PhysicalBytesMetric* TcmallocMetric::PHYSICAL_BYTES_RESERVED = n
 
 SanitizerMallocMetric* SanitizerMallocMetric::BYTES_ALLOCATED = nullptr;
 
+MemPoolChunkCacheMetric* MemPoolChunkCacheMetric::HITS = nullptr;
+MemPoolChunkCacheMetric* MemPoolChunkCacheMetric::MISSES = nullptr;
+MemPoolChunkCacheMetric* MemPoolChunkCacheMetric::RETAINED_BYTES = nullptr;
+
 bool JvmMemoryMetric::initialized_ = false;
 JvmMemoryMetric* JvmMemoryMetric::HEAP_MAX_USAGE = nullptr;
 JvmMemoryMetric* JvmMemoryMetric::NON_HEAP_COMMITTED = nullptr;
@@ -94,6 +99,9 @@ Status impala::RegisterMemoryMetrics(MetricGroup* metrics, bool register_jvm_met
         metrics->GetOrCreateChildGroup("buffer-pool"), global_reservations, buffer_pool));
   }
 
+  RETURN_IF_ERROR(MemPoolChunkCacheMetric::InitMetrics(
+      metrics->GetOrCreateChildGroup("mem-pool")));
+
   // Add compound metrics that track totals across malloc and the buffer pool.
   // total-used should track the total physical memory in use.
   vector<IntGauge*> used_metrics;
@@ -350,6 +358,32 @@ vector<string> JvmMetricCache::GetPoolNames() {
   return names;
 }
 
+Status MemPoolChunkCacheMetric::InitMetrics(MetricGroup* metrics) {
+  HITS = metrics->RegisterMetric(new MemPoolChunkCacheMetric(
+      MetricDefs::Get("mem-pool.chunk-cache.hits"), MemPoolChunkCacheMetricType::HITS));
+  MISSES = metrics->RegisterMetric(
+      new MemPoolChunkCacheMetric(MetricDefs::Get("mem-pool.chunk-cache.misses"),
+          MemPoolChunkCacheMetricType::MISSES));
+  RETAINED_BYTES = metrics->RegisterMetric(
+      new MemPoolChunkCacheMetric(MetricDefs::Get("mem-pool.chunk-cache.retained-bytes"),
+          MemPoolChunkCacheMetricType::RETAINED_BYTES));
+  return Status::OK();
+}
+
+int64_t MemPoolChunkCacheMetric::GetValue() {
+  switch (type_) {
+    case MemPoolChunkCacheMetricType::HITS:
+      return MemPool::chunk_cache_hits();
+    case MemPoolChunkCacheMetricType::MISSES:
+      return MemPool::chunk_cache_misses();
+    case MemPoolChunkCacheMetricType::RETAINED_BYTES:
+      return MemPool::chunk_cache_retained_bytes();
+    default:
+      DCHECK(false) << "Unknown MemPoolChunkCacheMetricType: " << static_cast<int>(type_);
+  }
+  return 0;
+}
+
 Status BufferPoolMetric::InitMetrics(MetricGroup* metrics,
     ReservationTracker* global_reservations, BufferPool* buffer_pool) {
   LIMIT = metrics->RegisterMetric(
@@ -161,6 +161,30 @@ class SanitizerMallocMetric : public IntGauge {
   }
 };
 
+/// Statistics of the thread-local caches of free MemPool chunks.
+class MemPoolChunkCacheMetric : public IntGauge {
+ public:
+  static Status InitMetrics(MetricGroup* metrics);
+
+  static MemPoolChunkCacheMetric* HITS;
+  static MemPoolChunkCacheMetric* MISSES;
+  static MemPoolChunkCacheMetric* RETAINED_BYTES;
+
+  virtual int64_t GetValue() override;
+
+ private:
+  enum class MemPoolChunkCacheMetricType {
+    HITS, // Chunks that MemPools took from a cache.
+    MISSES, // Chunks that MemPools allocated because the cache had none of the size.
+    RETAINED_BYTES, // Bytes of free chunks in the caches.
+  };
+
+  MemPoolChunkCacheMetric(const TMetricDef& def, MemPoolChunkCacheMetricType type)
+    : IntGauge(def, 0), type_(type) {}
+
+  const MemPoolChunkCacheMetricType type_;
+};
+
 // A singleton for caching the gathering of JVM Metrics for 1 second, to amortize
 // the cost of getting all the JVM metrics.
 //
@@ -30,6 +30,9 @@
 using namespace impala;
 using namespace rapidjson;
 
+/// Number of MemTrackers whose allocation size histograms are shown on /memz.
+static const int TOP_ALLOCATORS_LIMIT = 20;
+
 /// A MemTracker tracks memory consumption and limits which will be displayed. This method
 /// adds the mem_limit and the current memory consumption to the rapidjson document. Also,
 /// it dumps all the additional mem trackers to the rapidjson document.
@@ -48,6 +51,13 @@ void AddMemTracker(MemTracker* mem_tracker,
   Value detailed(mem_tracker->LogUsage(MemTracker::UNLIMITED_DEPTH).c_str(),
       document->GetAllocator());
   document->AddMember("detailed", detailed, document->GetAllocator());
+
+  // Dump the allocation size histograms of the trackers with the most allocations.
+  string top_allocators = mem_tracker->LogTopAllocators(TOP_ALLOCATORS_LIMIT);
+  if (!top_allocators.empty()) {
+    Value allocators(top_allocators.c_str(), document->GetAllocator());
+    document->AddMember("allocators", allocators, document->GetAllocator());
+  }
 }
 
 /// Adds the following malloc data structures to the rapidjson document.
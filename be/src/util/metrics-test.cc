@@ -106,6 +106,24 @@ TEST_F(MetricsTest, GaugeMetrics) {
   AssertValue(int_gauge_with_units, 10, "10s000ms");
 }
 
+TEST_F(MetricsTest, ScopedGaugeIncrement) {
+  MetricGroup metrics("ScopedGaugeIncrement");
+  AddMetricDef("gauge", TMetricKind::GAUGE, TUnit::NONE);
+  IntGauge* int_gauge = metrics.AddGauge("gauge", 0);
+  {
+    ScopedGaugeIncrement outer(int_gauge);
+    AssertValue(int_gauge, 1, "1");
+    {
+      ScopedGaugeIncrement inner(int_gauge);
+      AssertValue(int_gauge, 2, "2");
+    }
+    AssertValue(int_gauge, 1, "1");
+  }
+  AssertValue(int_gauge, 0, "0");
+  // A gauge that is not registered is ignored.
+  ScopedGaugeIncrement no_gauge(nullptr);
+}
+
 TEST_F(MetricsTest, AtomicHighWaterMarkGauge) {
   MetricGroup metrics("IntHWMGauge");
   AddMetricDef("gauge", TMetricKind::GAUGE, TUnit::NONE);
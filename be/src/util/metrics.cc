@@ -148,9 +148,10 @@ Status MetricGroup::RegisterHttpHandlers(Webserver* webserver) {
         bind<void>(mem_fn(&MetricGroup::TemplateCallback), this, _1, _2);
     webserver->RegisterUrlCallback("/metrics", "metrics.tmpl", json_callback, true);
 
-    Webserver::RawUrlCallback prometheus_callback =
-        bind<void>(mem_fn(&MetricGroup::PrometheusCallback), this, _1, _2, _3);
-    webserver->RegisterUrlCallback("/metrics_prometheus", prometheus_callback);
+    Webserver::StreamingUrlCallback prometheus_callback =
+        bind<void>(mem_fn(&MetricGroup::PrometheusCallback), this, _1, _2);
+    webserver->RegisterStreamingUrlCallback(
+        "/metrics_prometheus", PLAIN, prometheus_callback);
   }
 
   return Status::OK();
@@ -247,16 +248,27 @@ void MetricGroup::TemplateCallback(const Webserver::WebRequest& req,
 }
 
 void MetricGroup::PrometheusCallback(
-    const Webserver::WebRequest& req, stringstream* data, HttpStatusCode* response) {
+    const Webserver::WebRequest& req, StreamingResponse* response) {
   const auto& args = req.parsed_args;
-  Webserver::ArgumentMap::const_iterator metric_group = args.find("metric_group");
+  // Only this metric group and all its children can be rendered.
+  if (args.find("metric_group") != args.end()) return;
 
-  lock_guard<SpinLock> l(lock_);
-  // If no particular metric group is requested, render this metric group (and all its
-  // children).
-  if (metric_group == args.end()) {
-    Value container;
-    ToPrometheus(true, data);
+  // Render one metric group at a time and only hold its lock while writing it to the
+  // buffer of the response. Child groups are never removed, so the pointers stay valid
+  // after the lock of their parent is released.
+  stack<MetricGroup*> groups;
+  groups.push(this);
+  while (!groups.empty() && !response->failed()) {
+    MetricGroup* group = groups.top();
+    groups.pop();
+    {
+      lock_guard<SpinLock> l(group->lock_);
+      group->ToPrometheus(false, response->stream());
+      for (const ChildGroupMap::value_type& child : group->children_) {
+        groups.push(child.second);
+      }
+    }
+    response->Flush();
   }
 }
 
@@ -312,7 +324,6 @@ void MetricGroup::ToPrometheus(bool include_children, stringstream* out_val) {
   }
 
   if (include_children) {
-    Value child_groups(kArrayType);
     for (const ChildGroupMap::value_type& child : children_) {
       child.second->ToPrometheus(true, out_val);
     }
@@ -40,6 +40,7 @@ using kudu::HttpStatusCode;
 
 namespace impala {
 
+class StreamingResponse;
 class Webserver;
 
 /// Singleton that provides metric definitions. Metrics are defined in metrics.json
@@ -334,6 +335,24 @@ class NegatedGauge : public IntGauge {
   IntGauge* gauge_;
 };
 
+/// Increments 'gauge' by one while in scope, e.g. to count the threads that wait for
+/// something. 'gauge' may be nullptr, e.g. in tests that do not register it.
+class ScopedGaugeIncrement {
+ public:
+  explicit ScopedGaugeIncrement(IntGauge* gauge) : gauge_(gauge) {
+    if (gauge_ != nullptr) gauge_->Increment(1);
+  }
+
+  ~ScopedGaugeIncrement() {
+    if (gauge_ != nullptr) gauge_->Increment(-1);
+  }
+
+ private:
+  IntGauge* const gauge_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedGaugeIncrement);
+};
+
 /// Container for a set of metrics. A MetricGroup owns the memory for every metric
 /// contained within it (see Add*() to create commonly used metric
 /// types). Metrics are 'registered' with a MetricGroup and can be deleted/removed after
@@ -429,7 +448,8 @@ class MetricGroup {
   void ToJson(bool include_children, rapidjson::Document* document,
       rapidjson::Value* out_val);
 
-  /// Converts this metric group (and optionally all of its children recursively) to JSON.
+  /// Converts this metric group (and optionally all of its children recursively) to the
+  /// prometheus text format.
   void ToPrometheus(bool include_children, std::stringstream* out_val);
 
   /// Creates or returns an already existing child metric group.
@@ -473,12 +493,10 @@ class MetricGroup {
   /// returned.
   void TemplateCallback(const WebRequest& req, rapidjson::Document* document);
 
-  /// Webserver callback for /metricsPrometheus. Produces string in prometheus format,
-  /// each representing metric group, and each including a list of metrics, and a list
-  /// of immediate children.  If args contains a paramater 'metric', only the json for
-  /// that metric is returned.
-  void PrometheusCallback(const WebRequest& req, std::stringstream* data,
-      HttpStatusCode* response);
+  /// Webserver callback for /metrics_prometheus. Streams the metrics of this metric
+  /// group and all its children in prometheus format to the client, one metric group at
+  /// a time, without holding a lock while sending the output.
+  void PrometheusCallback(const WebRequest& req, StreamingResponse* response);
 
   /// Legacy webpage callback for CM 5.0 and earlier. Produces a flattened map of (key,
   /// value) pairs for all metrics in this hierarchy.
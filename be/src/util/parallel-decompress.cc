@@ -0,0 +1,198 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/parallel-decompress.h"
+
+#include <cstring>
+#include <memory>
+
+#include <zlib.h>
+#include <zstd.h>
+
+#include "common/logging.h"
+#include "util/promise.h"
+#include "util/thread-pool.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+namespace {
+
+enum class FrameResult { FOUND, INCOMPLETE, UNSUPPORTED };
+
+/// The fixed part of a gzip member header: ID1, ID2, CM, FLG, MTIME, XFL, OS and XLEN.
+constexpr int GZIP_HEADER_LEN = 12;
+/// The gzip trailer: CRC32 and ISIZE.
+constexpr int GZIP_TRAILER_LEN = 8;
+constexpr uint8_t GZIP_FLG_FEXTRA = 4;
+/// A ZSTD frame header has at most 18 bytes.
+constexpr int ZSTD_MAX_FRAME_HEADER_LEN = 18;
+
+inline uint32_t ReadLE16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+inline uint32_t ReadLE32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/// Finds the BGZF member at the start of the 'len' bytes at 'input'.
+FrameResult FindBgzfMember(const uint8_t* input, int64_t len,
+    ParallelDecompressor::Frame* frame) {
+  if (len < GZIP_HEADER_LEN) return FrameResult::INCOMPLETE;
+  if (input[0] != 31 || input[1] != 139 || input[2] != Z_DEFLATED
+      || (input[3] & GZIP_FLG_FEXTRA) == 0) {
+    return FrameResult::UNSUPPORTED;
+  }
+  const int64_t xlen = ReadLE16(input + 10);
+  if (len < GZIP_HEADER_LEN + xlen) return FrameResult::INCOMPLETE;
+  // Look for the 'BC' subfield with the member size.
+  int64_t member_len = -1;
+  const uint8_t* subfield = input + GZIP_HEADER_LEN;
+  const uint8_t* extra_end = subfield + xlen;
+  while (subfield + 4 <= extra_end) {
+    const int64_t subfield_len = ReadLE16(subfield + 2);
+    if (subfield + 4 + subfield_len > extra_end) break;
+    if (subfield[0] == 'B' && subfield[1] == 'C' && subfield_len == 2) {
+      member_len = ReadLE16(subfield + 4) + 1;
+      break;
+    }
+    subfield += 4 + subfield_len;
+  }
+  if (member_len < GZIP_HEADER_LEN + xlen + GZIP_TRAILER_LEN) {
+    return FrameResult::UNSUPPORTED;
+  }
+  if (len < member_len) return FrameResult::INCOMPLETE;
+  frame->compressed_len = member_len;
+  frame->decompressed_len = ReadLE32(input + member_len - 4);
+  return FrameResult::FOUND;
+}
+
+/// Finds the ZSTD frame at the start of the 'len' bytes at 'input'.
+FrameResult FindZstdFrame(const uint8_t* input, int64_t len,
+    ParallelDecompressor::Frame* frame) {
+  const unsigned long long content_size = ZSTD_getFrameContentSize(input, len);
+  if (content_size == ZSTD_CONTENTSIZE_UNKNOWN) return FrameResult::UNSUPPORTED;
+  if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+    return len < ZSTD_MAX_FRAME_HEADER_LEN ? FrameResult::INCOMPLETE :
+                                             FrameResult::UNSUPPORTED;
+  }
+  const size_t compressed_len = ZSTD_findFrameCompressedSize(input, len);
+  // The frame is either incomplete or corrupt. ZSTD_decompressStream() reports corrupt
+  // frames.
+  if (ZSTD_isError(compressed_len)) return FrameResult::INCOMPLETE;
+  frame->compressed_len = compressed_len;
+  frame->decompressed_len = content_size;
+  return FrameResult::FOUND;
+}
+
+Status DecompressBgzfMember(const uint8_t* input, int64_t input_len, uint8_t* output,
+    int64_t output_len) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // 16 + MAX_WBITS accepts a gzip header.
+  int ret = inflateInit2(&stream, 16 + MAX_WBITS);
+  if (ret != Z_OK) {
+    return Status(TErrorCode::COMPRESSED_FILE_DECOMPRESSOR_ERROR, "Gzip",
+        "inflateInit2()", ret);
+  }
+  stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input));
+  stream.avail_in = input_len;
+  stream.next_out = reinterpret_cast<Bytef*>(output);
+  stream.avail_out = output_len;
+  ret = inflate(&stream, Z_FINISH);
+  const bool valid = ret == Z_STREAM_END && stream.total_out == output_len
+      && stream.avail_in == 0;
+  inflateEnd(&stream);
+  if (!valid) return Status(TErrorCode::COMPRESSED_FILE_BLOCK_CORRUPTED, "Gzip");
+  return Status::OK();
+}
+
+}
+
+bool ParallelDecompressor::SupportsFormat(THdfsCompression::type format) {
+  return format == THdfsCompression::ZSTD || format == THdfsCompression::GZIP;
+}
+
+bool ParallelDecompressor::FindFrames(THdfsCompression::type format,
+    const uint8_t* input, int64_t len, int max_frames, int64_t max_decompressed_len,
+    vector<Frame>* frames) {
+  DCHECK(SupportsFormat(format));
+  int64_t offset = 0;
+  int64_t decompressed_len = 0;
+  for (int i = 0; i < max_frames && offset < len; ++i) {
+    Frame frame;
+    frame.offset = offset;
+    FrameResult result = format == THdfsCompression::ZSTD ?
+        FindZstdFrame(input + offset, len - offset, &frame) :
+        FindBgzfMember(input + offset, len - offset, &frame);
+    if (result == FrameResult::UNSUPPORTED) return false;
+    if (result == FrameResult::INCOMPLETE) break;
+    if (decompressed_len + frame.decompressed_len > max_decompressed_len) break;
+    frames->push_back(frame);
+    offset += frame.compressed_len;
+    decompressed_len += frame.decompressed_len;
+  }
+  return true;
+}
+
+Status ParallelDecompressor::DecompressFrame(THdfsCompression::type format,
+    const uint8_t* input, const Frame& frame, uint8_t* output) {
+  if (format != THdfsCompression::ZSTD) {
+    return DecompressBgzfMember(
+        input + frame.offset, frame.compressed_len, output, frame.decompressed_len);
+  }
+  size_t ret = ZSTD_decompress(
+      output, frame.decompressed_len, input + frame.offset, frame.compressed_len);
+  if (ZSTD_isError(ret)) {
+    return Status(TErrorCode::ZSTD_ERROR, "ZSTD_decompress",
+        ZSTD_getErrorString(ZSTD_getErrorCode(ret)));
+  }
+  if (ret != frame.decompressed_len) {
+    return Status(TErrorCode::COMPRESSED_FILE_BLOCK_CORRUPTED, "Zstd");
+  }
+  return Status::OK();
+}
+
+Status ParallelDecompressor::DecompressFrames(THdfsCompression::type format,
+    const uint8_t* input, const vector<Frame>& frames, CallableThreadPool* pool,
+    uint8_t* output) {
+  if (frames.empty()) return Status::OK();
+  vector<unique_ptr<Promise<Status>>> results;
+  results.reserve(frames.size() - 1);
+  int64_t output_offset = frames[0].decompressed_len;
+  for (int i = 1; i < frames.size(); ++i) {
+    Promise<Status>* result = new Promise<Status>();
+    results.emplace_back(result);
+    const Frame* frame = &frames[i];
+    uint8_t* frame_output = output + output_offset;
+    output_offset += frame->decompressed_len;
+    boost::function<void()> fn = [format, input, frame, frame_output, result]() {
+      result->Set(DecompressFrame(format, input, *frame, frame_output));
+    };
+    // If there is no pool or it was shut down, decompress on this thread.
+    if (pool == nullptr || !pool->Offer(fn)) fn();
+  }
+  Status status = DecompressFrame(format, input, frames[0], output);
+  // Wait for all frames, since the pool threads write to 'output'.
+  for (const unique_ptr<Promise<Status>>& result : results) {
+    Status frame_status = result->Get();
+    if (status.ok()) status = frame_status;
+  }
+  return status;
+}
+
+}
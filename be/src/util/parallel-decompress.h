@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/status.h"
+#include "gen-cpp/CatalogObjects_types.h"
+
+namespace impala {
+
+class CallableThreadPool;
+
+/// Decompresses data that consists of independently compressed frames with several
+/// threads. A frame can only be decompressed without the frames before it if its
+/// boundaries and decompressed size are known up front. The supported layouts are:
+///  * ZSTD: multi-frame files, e.g. written by pzstd, whose frame headers record the
+///    content size.
+///  * GZIP: BGZF files, e.g. written by bgzip, whose members record their compressed
+///    size in the 'BC' extra subfield and their decompressed size in the trailer.
+/// Any other data, e.g. a gzip file with a single member, must be decompressed with a
+/// streaming decompressor.
+class ParallelDecompressor {
+ public:
+  /// A compressed frame at 'offset' of the input.
+  struct Frame {
+    int64_t offset;
+    int64_t compressed_len;
+    int64_t decompressed_len;
+  };
+
+  /// Returns true if FindFrames() can split data of 'format'.
+  static bool SupportsFormat(THdfsCompression::type format);
+
+  /// Appends the complete frames at the start of the 'len' bytes at 'input' to 'frames',
+  /// until 'max_frames' frames are found or the next frame would exceed
+  /// 'max_decompressed_len' decompressed bytes in total. An incomplete frame at the end
+  /// is not returned. Returns false if a frame does not have the supported layout.
+  /// Frames found before it are still returned.
+  static bool FindFrames(THdfsCompression::type format, const uint8_t* input,
+      int64_t len, int max_frames, int64_t max_decompressed_len,
+      std::vector<Frame>* frames);
+
+  /// Decompresses 'frames' of 'input' to 'output', one after the other. 'output' must
+  /// have room for the decompressed bytes of all frames. All frames but the first are
+  /// decompressed on 'pool', while the first one is decompressed on the calling thread,
+  /// which then waits for the others. If 'pool' is NULL, all frames are decompressed on
+  /// the calling thread. Returns an error if a frame is corrupt.
+  static Status DecompressFrames(THdfsCompression::type format, const uint8_t* input,
+      const std::vector<Frame>& frames, CallableThreadPool* pool,
+      uint8_t* output) WARN_UNUSED_RESULT;
+
+  /// Decompresses 'frame' of 'input' to 'output'.
+  static Status DecompressFrame(THdfsCompression::type format, const uint8_t* input,
+      const Frame& frame, uint8_t* output) WARN_UNUSED_RESULT;
+};
+
+}
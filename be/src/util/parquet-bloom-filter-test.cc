@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/parquet-bloom-filter.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "testutil/gtest-util.h"
+#include "util/hash-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Reference values of the xxHash specification with seed 0.
+TEST(ParquetBloomFilterTest, XxHash64) {
+  vector<pair<string, uint64_t>> test_cases = {
+      {"", 0xEF46DB3751D8E999ULL},
+      {"a", 0xD24EC4F1A98C6E5BULL},
+      {"abc", 0x44BC2CF5AD770999ULL},
+      {"message digest", 0x066ED728FCEEB3BEULL},
+      {"abcdefghijklmnopqrstuvwxyz", 0xCFE1F278FA89835CULL},
+      {"Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL},
+      {"1234567890123456789012345678901234567890"
+       "1234567890123456789012345678901234567890", 0xE04A477F19EE145DULL}};
+  for (const auto& test_case : test_cases) {
+    EXPECT_EQ(test_case.second, HashUtil::XxHash64(
+        test_case.first.data(), test_case.first.size(), 0)) << test_case.first;
+  }
+}
+
+TEST(ParquetBloomFilterTest, InvalidSize) {
+  vector<uint8_t> directory(ParquetBloomFilter::BYTES_PER_BLOCK * 4);
+  ParquetBloomFilter filter;
+  EXPECT_FALSE(filter.Init(directory.data(), 0, true).ok());
+  EXPECT_FALSE(filter.Init(directory.data(), 33, true).ok());
+  EXPECT_FALSE(filter.Init(directory.data(), -32, true).ok());
+  EXPECT_OK(filter.Init(directory.data(), directory.size(), true));
+  EXPECT_EQ(directory.size(), filter.directory_size());
+}
+
+// Inserted values must always be found and the false positive rate must be reasonable
+// for the number of bits per value.
+TEST(ParquetBloomFilterTest, InsertFind) {
+  const int num_values = 10000;
+  // About 16 bits per value, which gives a false positive rate below 1%.
+  vector<uint8_t> directory(num_values * 2);
+  ParquetBloomFilter filter;
+  ASSERT_OK(filter.Init(directory.data(), directory.size(), true));
+  for (int64_t i = 0; i < num_values; ++i) {
+    EXPECT_FALSE(filter.Find(ParquetBloomFilter::Hash(&i, sizeof(i))));
+  }
+  for (int64_t i = 0; i < num_values; ++i) {
+    filter.Insert(ParquetBloomFilter::Hash(&i, sizeof(i)));
+  }
+  for (int64_t i = 0; i < num_values; ++i) {
+    EXPECT_TRUE(filter.Find(ParquetBloomFilter::Hash(&i, sizeof(i))));
+  }
+  int false_positives = 0;
+  for (int64_t i = num_values; i < 2 * num_values; ++i) {
+    if (filter.Find(ParquetBloomFilter::Hash(&i, sizeof(i)))) ++false_positives;
+  }
+  EXPECT_LT(false_positives, num_values / 100);
+}
+
+// A filter read from a file must not be modified by Init().
+TEST(ParquetBloomFilterTest, InitKeepsDirectory) {
+  vector<uint8_t> directory(ParquetBloomFilter::BYTES_PER_BLOCK * 8);
+  ParquetBloomFilter writer;
+  ASSERT_OK(writer.Init(directory.data(), directory.size(), true));
+  const string value = "impala";
+  writer.Insert(ParquetBloomFilter::Hash(value.data(), value.size()));
+
+  vector<uint8_t> copy = directory;
+  ParquetBloomFilter reader;
+  ASSERT_OK(reader.Init(copy.data(), copy.size(), false));
+  EXPECT_TRUE(reader.Find(ParquetBloomFilter::Hash(value.data(), value.size())));
+}
+
+}
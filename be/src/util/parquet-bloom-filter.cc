@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/parquet-bloom-filter.h"
+
+#include <cstring>
+
+#include "gutil/strings/substitute.h"
+#include "util/hash-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+const uint32_t ParquetBloomFilter::SALT[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU,
+    0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+Status ParquetBloomFilter::Init(uint8_t* directory, int size, bool always_false) {
+  if (size < MIN_BYTES || size > MAX_BYTES || size % BYTES_PER_BLOCK != 0) {
+    return Status(Substitute("Invalid Parquet Bloom filter size: $0 bytes.", size));
+  }
+  DCHECK(directory != nullptr);
+  directory_ = reinterpret_cast<uint32_t*>(directory);
+  num_blocks_ = size / BYTES_PER_BLOCK;
+  if (always_false) memset(directory, 0, size);
+  return Status::OK();
+}
+
+uint64_t ParquetBloomFilter::Hash(const void* data, int64_t len) {
+  return HashUtil::XxHash64(data, len, 0);
+}
+
+void ParquetBloomFilter::Insert(uint64_t hash) {
+  DCHECK(directory_ != nullptr);
+  uint32_t* block = Block(hash);
+  const uint32_t key = static_cast<uint32_t>(hash);
+  for (int i = 0; i < 8; ++i) block[i] |= 1U << ((key * SALT[i]) >> 27);
+}
+
+bool ParquetBloomFilter::Find(uint64_t hash) const {
+  DCHECK(directory_ != nullptr);
+  const uint32_t* block = Block(hash);
+  const uint32_t key = static_cast<uint32_t>(hash);
+  for (int i = 0; i < 8; ++i) {
+    if ((block[i] & (1U << ((key * SALT[i]) >> 27))) == 0) return false;
+  }
+  return true;
+}
+
+} // namespace impala
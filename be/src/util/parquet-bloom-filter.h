@@ -0,0 +1,77 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/status.h"
+
+namespace impala {
+
+/// A split block Bloom filter as defined by the Parquet format specification
+/// (https://github.com/apache/parquet-format/blob/master/BloomFilter.md).
+///
+/// The filter is a directory of 256-bit blocks, each made of eight 32-bit words. The
+/// upper 32 bits of the 64-bit xxHash of a value select the block, the lower 32 bits are
+/// multiplied with eight salt constants to set or test one bit in each word. Values are
+/// hashed in their PLAIN encoding, e.g. 4 little-endian bytes for INT32 and the raw bytes
+/// without the length prefix for BYTE_ARRAY.
+///
+/// This class does not own the directory memory. It is not thread-safe for insertion.
+class ParquetBloomFilter {
+ public:
+  /// Size of a block in bytes.
+  static constexpr int BYTES_PER_BLOCK = 32;
+
+  /// Smallest and largest directory sizes allowed by the specification.
+  static constexpr int MIN_BYTES = BYTES_PER_BLOCK;
+  static constexpr int MAX_BYTES = 128 * 1024 * 1024;
+
+  ParquetBloomFilter() {}
+
+  /// Points the filter at the 'size' bytes of 'directory'. Returns an error if 'size' is
+  /// not a multiple of BYTES_PER_BLOCK or is out of the allowed range. If 'always_false'
+  /// is true, the directory is cleared so that no value is found.
+  Status Init(uint8_t* directory, int size, bool always_false);
+
+  /// Returns the hash used to insert and find a value whose PLAIN encoding is 'len' bytes
+  /// at 'data'.
+  static uint64_t Hash(const void* data, int64_t len);
+
+  /// Adds a value with hash 'hash' to the filter.
+  void Insert(uint64_t hash);
+
+  /// Returns false if the value with hash 'hash' was definitely not inserted.
+  bool Find(uint64_t hash) const;
+
+  int directory_size() const { return num_blocks_ * BYTES_PER_BLOCK; }
+
+ private:
+  /// Salts of the bits set in each word of a block.
+  static const uint32_t SALT[8];
+
+  /// Returns the block that 'hash' maps to.
+  uint32_t* Block(uint64_t hash) const {
+    return directory_ + ((hash >> 32) * num_blocks_ >> 32) * 8;
+  }
+
+  uint32_t* directory_ = nullptr;
+  int64_t num_blocks_ = 0;
+};
+
+} // namespace impala
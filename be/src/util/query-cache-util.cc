@@ -0,0 +1,61 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/query-cache-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+bool HasDeterministicResults(const TQueryCtx& query_ctx) {
+  return !query_ctx.results_are_nondeterministic;
+}
+
+bool ScansUnversionedTables(const TQueryExecRequest& request) {
+  for (const TPlanExecInfo& plan_exec_info : request.plan_exec_info) {
+    for (const TPlanFragment& fragment : plan_exec_info.fragments) {
+      if (!fragment.__isset.plan) continue;
+      for (const TPlanNode& node : fragment.plan.nodes) {
+        if (node.node_type == TPlanNodeType::KUDU_SCAN_NODE
+            || node.node_type == TPlanNodeType::HBASE_SCAN_NODE
+            || node.node_type == TPlanNodeType::DATA_SOURCE_NODE) {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+bool AreQueryResultsReusable(const TQueryExecRequest& request) {
+  const TQueryCtx& query_ctx = request.query_ctx;
+  if (!HasDeterministicResults(query_ctx)) return false;
+  // The snapshot of the data that a transactional query reads is not part of the key of
+  // the caches.
+  if (query_ctx.__isset.transaction_id) return false;
+  return !ScansUnversionedTables(request);
+}
+
+bool IsQueryPlanReusable(const TQueryExecRequest& request) {
+  const TQueryCtx& query_ctx = request.query_ctx;
+  if (query_ctx.plan_is_query_specific) return false;
+  if (query_ctx.__isset.transaction_id) return false;
+  // The scan ranges of these tables may change without an invalidation.
+  return !ScansUnversionedTables(request);
+}
+
+}
@@ -0,0 +1,50 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include "gen-cpp/Frontend_types.h"
+#include "gen-cpp/Query_types.h"
+
+namespace impala {
+
+/// Functions that decide whether the caches of the coordinator and the executors may
+/// reuse the plan or the results of one query for a later query. They rely on the flags
+/// that the planner sets in the TQueryCtx, which cover calls of functions in the
+/// definitions of views and of user-defined functions.
+
+/// Returns true if the results of the query of 'query_ctx' only depend on the data that
+/// it reads.
+bool HasDeterministicResults(const TQueryCtx& query_ctx);
+
+/// Returns true if 'request' scans tables of which the catalog does not version the
+/// data, i.e. Kudu, HBase and external data source tables.
+bool ScansUnversionedTables(const TQueryExecRequest& request);
+
+/// Returns true if the results of the query planned in 'request' can be returned to a
+/// later execution of the same statement, as long as the catalog did not change since.
+/// Queries that run in a transaction are excluded.
+bool AreQueryResultsReusable(const TQueryExecRequest& request);
+
+/// Returns true if the plan in 'request' can be executed again for a later execution of
+/// the same statement, as long as the catalog and the cluster membership did not change
+/// since. Plans into which the planner folded values of this execution, e.g. the result
+/// of now() or a random seed of TABLESAMPLE, and plans of transactional queries, which
+/// open their transaction during planning, are excluded.
+bool IsQueryPlanReusable(const TQueryExecRequest& request);
+
+}
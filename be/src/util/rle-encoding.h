@@ -21,6 +21,7 @@
 #include <math.h>
 
 #include "common/compiler-util.h"
+#include "util/bit-packing-simd.h"
 #include "util/bit-stream-utils.inline.h"
 #include "util/bit-util.h"
 #include "util/mem-util.h"
@@ -752,8 +753,12 @@ inline int32_t RleBatchDecoder<T>::GetValues(int32_t num_values_to_consume, T* v
        int32_t num_repeats_to_set =
            std::min(num_repeats, num_values_to_consume - num_consumed);
        T repeated_value = GetRepeatedValue(num_repeats_to_set);
-       for (int i = 0; i < num_repeats_to_set; ++i) {
-         values[num_consumed + i] = repeated_value;
+       if (num_repeats_to_set >= SimdBitPacking::MIN_FILL_VALUES) {
+         SimdBitPacking::Fill(repeated_value, num_repeats_to_set, values + num_consumed);
+       } else {
+         for (int i = 0; i < num_repeats_to_set; ++i) {
+           values[num_consumed + i] = repeated_value;
+         }
        }
        num_consumed += num_repeats_to_set;
        continue;
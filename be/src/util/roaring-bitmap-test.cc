@@ -0,0 +1,149 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdlib>
+#include <limits>
+#include <set>
+
+#include "testutil/gtest-util.h"
+#include "util/roaring-bitmap.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// Serializes 'bitmap' and returns a new bitmap with the deserialized values in 'out'.
+static void RoundTrip(const RoaringBitmap& bitmap, RoaringBitmap* out) {
+  vector<uint8_t> buf(bitmap.SerializedSize());
+  bitmap.Serialize(buf.data());
+  ASSERT_TRUE(out->UnionSerialized(buf.data(), buf.size()));
+}
+
+TEST(RoaringBitmap, Empty) {
+  RoaringBitmap bitmap;
+  EXPECT_EQ(0, bitmap.Cardinality());
+  RoaringBitmap copy;
+  RoundTrip(bitmap, &copy);
+  EXPECT_EQ(0, copy.Cardinality());
+}
+
+// Adds sparse and dense values, with duplicates, and checks the cardinality against
+// std::set both directly and after serialization.
+TEST(RoaringBitmap, AddAndSerialize) {
+  RoaringBitmap bitmap;
+  set<uint64_t> expected;
+  // A dense container that is converted to a bitmap.
+  for (uint64_t i = 0; i < 3 * RoaringBitmap::ARRAY_MAX_CARDINALITY; ++i) {
+    bitmap.Add(i % 10000);
+    expected.insert(i % 10000);
+  }
+  // Sparse values spread over many containers, including the largest keys.
+  for (int i = 0; i < 5000; ++i) {
+    uint64_t v = (static_cast<uint64_t>(rand()) << 32) ^ rand();
+    bitmap.Add(v);
+    expected.insert(v);
+  }
+  bitmap.Add(numeric_limits<uint64_t>::max());
+  expected.insert(numeric_limits<uint64_t>::max());
+  EXPECT_EQ(expected.size(), bitmap.Cardinality());
+
+  RoaringBitmap copy;
+  RoundTrip(bitmap, &copy);
+  EXPECT_EQ(expected.size(), copy.Cardinality());
+  // Merging the same values again must not change the cardinality.
+  RoundTrip(bitmap, &copy);
+  EXPECT_EQ(expected.size(), copy.Cardinality());
+}
+
+// Unions overlapping bitmaps, covering array/array, array/bitmap and bitmap/bitmap
+// containers.
+TEST(RoaringBitmap, Union) {
+  RoaringBitmap a, b;
+  for (uint64_t i = 0; i < 3000; ++i) a.Add(i * 2);
+  for (uint64_t i = 0; i < 3000; ++i) b.Add(i * 3);
+  for (uint64_t i = 0; i < 20000; ++i) a.Add((1 << 16) + i);
+  for (uint64_t i = 0; i < 100; ++i) b.Add((1 << 16) + 30000 + i);
+  for (uint64_t i = 0; i < 10000; ++i) a.Add((2 << 16) + i);
+  for (uint64_t i = 5000; i < 15000; ++i) b.Add((2 << 16) + i);
+  set<uint64_t> expected;
+  for (uint64_t i = 0; i < 3000; ++i) {
+    expected.insert(i * 2);
+    expected.insert(i * 3);
+  }
+  int64_t expected_count = expected.size() + 20000 + 100 + 15000;
+
+  RoaringBitmap serialized_union;
+  RoundTrip(a, &serialized_union);
+  RoundTrip(b, &serialized_union);
+  EXPECT_EQ(expected_count, serialized_union.Cardinality());
+
+  a.Union(b);
+  EXPECT_EQ(expected_count, a.Cardinality());
+}
+
+// Checks GetRuns() against the runs of the values in std::set, for ranges that start and
+// end inside of runs and containers.
+TEST(RoaringBitmap, GetRuns) {
+  RoaringBitmap bitmap;
+  set<uint64_t> values;
+  // Short runs in an array container, a long run that crosses into a bitmap container
+  // and a single value in the next container.
+  for (uint64_t v : {3, 4, 5, 9, 11, 12}) values.insert(v);
+  for (uint64_t v = (1 << 16) - 10; v < (1 << 16) + 10000; ++v) values.insert(v);
+  values.insert((2 << 16) + 7);
+  for (uint64_t v : values) bitmap.Add(v);
+
+  auto expected_runs = [&values](uint64_t first, uint64_t last) {
+    vector<pair<uint64_t, uint64_t>> runs;
+    for (auto it = values.lower_bound(first); it != values.end() && *it <= last; ++it) {
+      if (!runs.empty() && runs.back().second + 1 == *it) {
+        runs.back().second = *it;
+      } else {
+        runs.emplace_back(*it, *it);
+      }
+    }
+    return runs;
+  };
+  const vector<pair<uint64_t, uint64_t>> ranges = {{0, 100}, {4, 11}, {6, 8},
+      {0, numeric_limits<uint64_t>::max()}, {(1 << 16) + 5, (1 << 16) + 5},
+      {(1 << 16) + 5000, (2 << 16) + 7}, {(2 << 16) + 8, (3 << 16)}};
+  for (const auto& range : ranges) {
+    vector<pair<uint64_t, uint64_t>> runs;
+    bitmap.GetRuns(range.first, range.second, &runs);
+    EXPECT_EQ(expected_runs(range.first, range.second), runs)
+        << range.first << "-" << range.second;
+  }
+}
+
+TEST(RoaringBitmap, InvalidSerialized) {
+  RoaringBitmap bitmap;
+  for (uint64_t i = 0; i < 100; ++i) bitmap.Add(i);
+  vector<uint8_t> buf(bitmap.SerializedSize());
+  bitmap.Serialize(buf.data());
+  RoaringBitmap out;
+  // Truncated and overlong inputs.
+  EXPECT_FALSE(out.UnionSerialized(buf.data(), 2));
+  EXPECT_FALSE(out.UnionSerialized(buf.data(), buf.size() - 1));
+  buf.push_back(0);
+  EXPECT_FALSE(out.UnionSerialized(buf.data(), buf.size()));
+  buf.pop_back();
+  // Unsorted values.
+  swap(buf[buf.size() - 2], buf[buf.size() - 4]);
+  EXPECT_FALSE(out.UnionSerialized(buf.data(), buf.size()));
+}
+
+}
@@ -0,0 +1,224 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/roaring-bitmap.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+
+#include "common/logging.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Bytes of the header of a serialized container: its key and its cardinality.
+static constexpr int CONTAINER_HEADER_LEN = sizeof(uint64_t) + sizeof(int32_t);
+
+void RoaringBitmap::Container::Add(uint16_t value) {
+  if (is_bitmap()) {
+    uint64_t* word = &bitmap[value >> 6];
+    const uint64_t bit = 1ULL << (value & 63);
+    cardinality += (*word & bit) == 0;
+    *word |= bit;
+    return;
+  }
+  auto it = std::lower_bound(values.begin(), values.end(), value);
+  if (it != values.end() && *it == value) return;
+  values.insert(it, value);
+  ++cardinality;
+  if (cardinality > ARRAY_MAX_CARDINALITY) ConvertToBitmap();
+}
+
+void RoaringBitmap::Container::AddSorted(const uint16_t* other_values, int num_values) {
+  if (is_bitmap()) {
+    for (int i = 0; i < num_values; ++i) Add(other_values[i]);
+    return;
+  }
+  vector<uint16_t> merged;
+  merged.reserve(values.size() + num_values);
+  std::set_union(values.begin(), values.end(), other_values, other_values + num_values,
+      std::back_inserter(merged));
+  values.swap(merged);
+  cardinality = values.size();
+  if (cardinality > ARRAY_MAX_CARDINALITY) ConvertToBitmap();
+}
+
+void RoaringBitmap::Container::AddWords(const uint64_t* words) {
+  if (!is_bitmap()) ConvertToBitmap();
+  int64_t new_cardinality = 0;
+  for (int i = 0; i < CONTAINER_WORDS; ++i) {
+    bitmap[i] |= words[i];
+    new_cardinality += BitUtil::Popcount(bitmap[i]);
+  }
+  cardinality = new_cardinality;
+}
+
+void RoaringBitmap::Container::ConvertToBitmap() {
+  DCHECK(!is_bitmap());
+  bitmap.resize(CONTAINER_WORDS);
+  for (uint16_t value : values) bitmap[value >> 6] |= 1ULL << (value & 63);
+  vector<uint16_t>().swap(values);
+}
+
+RoaringBitmap::Container* RoaringBitmap::GetContainer(uint64_t key) {
+  if (last_container_ != nullptr && last_key_ == key) return last_container_;
+  last_key_ = key;
+  last_container_ = &containers_[key];
+  return last_container_;
+}
+
+void RoaringBitmap::Add(uint64_t value) {
+  GetContainer(value >> 16)->Add(static_cast<uint16_t>(value));
+}
+
+void RoaringBitmap::Union(const RoaringBitmap& other) {
+  for (const auto& entry : other.containers_) {
+    const Container& src = entry.second;
+    Container* dst = GetContainer(entry.first);
+    if (src.is_bitmap()) {
+      dst->AddWords(src.bitmap.data());
+    } else {
+      dst->AddSorted(src.values.data(), src.values.size());
+    }
+  }
+}
+
+int64_t RoaringBitmap::Cardinality() const {
+  int64_t cardinality = 0;
+  for (const auto& entry : containers_) cardinality += entry.second.cardinality;
+  return cardinality;
+}
+
+void RoaringBitmap::GetRuns(
+    uint64_t first, uint64_t last, vector<pair<uint64_t, uint64_t>>* runs) const {
+  if (first > last) return;
+  // Runs of values of the previous containers can be extended by the next container.
+  const size_t first_new_run = runs->size();
+  auto add_value = [runs, first_new_run](uint64_t value) {
+    if (runs->size() > first_new_run && runs->back().second + 1 == value) {
+      runs->back().second = value;
+    } else {
+      runs->emplace_back(value, value);
+    }
+  };
+  for (auto it = containers_.lower_bound(first >> 16);
+       it != containers_.end() && it->first <= (last >> 16); ++it) {
+    const uint64_t base = it->first << 16;
+    const Container& container = it->second;
+    // Only the containers at the ends of the range have values outside of it.
+    const uint64_t low = base < first ? first - base : 0;
+    const uint64_t high = last - base < CONTAINER_BITS ? last - base : CONTAINER_BITS - 1;
+    if (container.is_bitmap()) {
+      for (uint64_t w = low >> 6; w <= (high >> 6); ++w) {
+        uint64_t word = container.bitmap[w];
+        while (word != 0) {
+          const uint64_t value = (w << 6) + __builtin_ctzll(word);
+          word &= word - 1;
+          if (value < low) continue;
+          if (value > high) break;
+          add_value(base + value);
+        }
+      }
+    } else {
+      for (auto v = std::lower_bound(container.values.begin(), container.values.end(),
+               static_cast<uint16_t>(low));
+           v != container.values.end() && *v <= high; ++v) {
+        add_value(base + *v);
+      }
+    }
+  }
+}
+
+int64_t RoaringBitmap::SerializedSize() const {
+  int64_t size = sizeof(int32_t);
+  for (const auto& entry : containers_) {
+    const Container& container = entry.second;
+    size += CONTAINER_HEADER_LEN;
+    size += container.is_bitmap() ? CONTAINER_WORDS * sizeof(uint64_t) :
+                                    container.cardinality * sizeof(uint16_t);
+  }
+  return size;
+}
+
+void RoaringBitmap::Serialize(uint8_t* out) const {
+  const int32_t num_containers = containers_.size();
+  memcpy(out, &num_containers, sizeof(num_containers));
+  out += sizeof(num_containers);
+  for (const auto& entry : containers_) {
+    const Container& container = entry.second;
+    memcpy(out, &entry.first, sizeof(entry.first));
+    out += sizeof(entry.first);
+    memcpy(out, &container.cardinality, sizeof(container.cardinality));
+    out += sizeof(container.cardinality);
+    if (container.is_bitmap()) {
+      memcpy(out, container.bitmap.data(), CONTAINER_WORDS * sizeof(uint64_t));
+      out += CONTAINER_WORDS * sizeof(uint64_t);
+    } else {
+      memcpy(out, container.values.data(), container.cardinality * sizeof(uint16_t));
+      out += container.cardinality * sizeof(uint16_t);
+    }
+  }
+}
+
+bool RoaringBitmap::UnionSerialized(const uint8_t* data, int64_t len) {
+  const uint8_t* end = data + len;
+  int32_t num_containers;
+  if (len < static_cast<int64_t>(sizeof(num_containers))) return false;
+  memcpy(&num_containers, data, sizeof(num_containers));
+  data += sizeof(num_containers);
+  if (num_containers < 0) return false;
+  // Reused for the values of array containers, which may be unaligned in 'data'.
+  vector<uint16_t> values;
+  vector<uint64_t> words;
+  for (int32_t i = 0; i < num_containers; ++i) {
+    if (end - data < CONTAINER_HEADER_LEN) return false;
+    uint64_t key;
+    int32_t cardinality;
+    memcpy(&key, data, sizeof(key));
+    data += sizeof(key);
+    memcpy(&cardinality, data, sizeof(cardinality));
+    data += sizeof(cardinality);
+    if (cardinality <= 0 || cardinality > CONTAINER_BITS) return false;
+    Container* dst = GetContainer(key);
+    if (cardinality > ARRAY_MAX_CARDINALITY) {
+      const int64_t bitmap_len = CONTAINER_WORDS * sizeof(uint64_t);
+      if (end - data < bitmap_len) return false;
+      words.resize(CONTAINER_WORDS);
+      memcpy(words.data(), data, bitmap_len);
+      data += bitmap_len;
+      dst->AddWords(words.data());
+    } else {
+      const int64_t values_len = cardinality * sizeof(uint16_t);
+      if (end - data < values_len) return false;
+      values.resize(cardinality);
+      memcpy(values.data(), data, values_len);
+      data += values_len;
+      if (std::adjacent_find(values.begin(), values.end(), std::greater_equal<uint16_t>())
+          != values.end()) {
+        return false;
+      }
+      dst->AddSorted(values.data(), cardinality);
+    }
+  }
+  return data == end;
+}
+
+} // namespace impala
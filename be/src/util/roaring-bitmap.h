@@ -0,0 +1,114 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+/// A compressed bitmap of 64-bit integers in the style of Roaring bitmaps. The values
+/// are split into containers by their upper 48 bits. A container holds the lower 16
+/// bits of its values in a sorted array while it has at most ARRAY_MAX_CARDINALITY
+/// values, and in a bitmap of 2^16 bits once it has more. Dense ranges of values, such
+/// as user ids, take a little over one bit per value, and sparse values two bytes plus
+/// a share of their container's header.
+///
+/// Serialized layout, with all integers in little-endian byte order:
+///  <- number of containers (4 bytes) -> <- container 0 -> ... <- container n ->
+/// where each container is its key (8 bytes), its cardinality (4 bytes), and then either
+/// the sorted 2 byte values or the 8192 bytes of the bitmap if the cardinality is
+/// greater than ARRAY_MAX_CARDINALITY. Containers are ordered by key.
+class RoaringBitmap {
+ public:
+  /// The most values that a container stores in an array.
+  static constexpr int ARRAY_MAX_CARDINALITY = 4096;
+
+  RoaringBitmap() = default;
+
+  /// Adds 'value' to the bitmap.
+  void Add(uint64_t value);
+
+  /// Adds all values of 'other' to this bitmap.
+  void Union(const RoaringBitmap& other);
+
+  /// Returns the number of distinct values in the bitmap.
+  int64_t Cardinality() const;
+
+  /// Appends the runs of consecutive values of the bitmap in [first, last] to 'runs' in
+  /// ascending order, as pairs of their first and last value. Runs that extend beyond
+  /// [first, last] are clipped to it.
+  void GetRuns(uint64_t first, uint64_t last,
+      std::vector<std::pair<uint64_t, uint64_t>>* runs) const;
+
+  /// Returns the bytes that Serialize() writes.
+  int64_t SerializedSize() const;
+
+  /// Writes SerializedSize() bytes to 'out'.
+  void Serialize(uint8_t* out) const;
+
+  /// Adds the values of the bitmap serialized in the 'len' bytes at 'data' to this
+  /// bitmap. Returns false if the data is not a valid serialized bitmap, in which case
+  /// only some of its values may have been added.
+  bool UnionSerialized(const uint8_t* data, int64_t len);
+
+ private:
+  /// Bits in the bitmap of a container, and the 64 bit words that hold them.
+  static constexpr int CONTAINER_BITS = 1 << 16;
+  static constexpr int CONTAINER_WORDS = CONTAINER_BITS / 64;
+
+  struct Container {
+    /// The sorted values while 'bitmap' is empty.
+    std::vector<uint16_t> values;
+    /// The values as bits, once there are more than ARRAY_MAX_CARDINALITY values.
+    std::vector<uint64_t> bitmap;
+    int32_t cardinality = 0;
+
+    bool is_bitmap() const { return !bitmap.empty(); }
+
+    void Add(uint16_t value);
+
+    /// Adds the 'num_values' sorted values at 'values' to this container.
+    void AddSorted(const uint16_t* values, int num_values);
+
+    /// Adds the bits of the 'CONTAINER_WORDS' words at 'words' to this container.
+    void AddWords(const uint64_t* words);
+
+    /// Converts the array of values to a bitmap.
+    void ConvertToBitmap();
+  };
+
+  /// Returns the container for the values with upper bits 'key', creating it if
+  /// needed.
+  Container* GetContainer(uint64_t key);
+
+  std::map<uint64_t, Container> containers_;
+
+  /// The container that Add() used last, to skip the map lookup for runs of values
+  /// with the same upper bits. Null if there is none.
+  uint64_t last_key_ = 0;
+  Container* last_container_ = nullptr;
+
+  DISALLOW_COPY_AND_ASSIGN(RoaringBitmap);
+};
+
+} // namespace impala
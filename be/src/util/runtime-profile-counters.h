@@ -29,6 +29,7 @@
 #include "common/atomic.h"
 #include "common/logging.h"
 #include "gutil/singleton.h"
+#include "kudu/util/striped64.h"
 #include "util/arithmetic-util.h"
 #include "util/stat-util.h"
 #include "util/runtime-profile.h"
@@ -102,6 +103,10 @@ namespace impala {
   ::impala::CounterPrototype PROFILE_##name( \
       #name, ::impala::ProfileEntryPrototype::Significance::significance, desc, unit)
 
+#define PROFILE_DEFINE_STRIPED_COUNTER(name, significance, unit, desc) \
+  ::impala::StripedCounterPrototype PROFILE_##name( \
+      #name, ::impala::ProfileEntryPrototype::Significance::significance, desc, unit)
+
 #define PROFILE_DEFINE_RATE_COUNTER(name, significance, unit, desc) \
   ::impala::RateCounterPrototype PROFILE_##name( \
       #name, ::impala::ProfileEntryPrototype::Significance::significance, desc, unit)
@@ -130,11 +135,17 @@ namespace impala {
   ::impala::CounterPrototype PROFILE_##name(#name, \
       ::impala::ProfileEntryPrototype::Significance::significance, desc, TUnit::TIME_NS)
 
+#define PROFILE_DEFINE_STRIPED_TIMER(name, significance, desc) \
+  ::impala::StripedCounterPrototype PROFILE_##name(#name, \
+      ::impala::ProfileEntryPrototype::Significance::significance, desc, TUnit::TIME_NS)
+
 #define PROFILE_DEFINE_SUMMARY_STATS_TIMER(name, significance, desc) \
   ::impala::SummaryStatsCounterPrototype PROFILE_##name(#name, \
   ::impala::ProfileEntryPrototype::Significance::significance, desc, TUnit::TIME_NS)
 
 #define PROFILE_DECLARE_COUNTER(name) extern ::impala::CounterPrototype PROFILE_##name
+#define PROFILE_DECLARE_STRIPED_COUNTER(name) \
+  extern ::impala::StripedCounterPrototype PROFILE_##name
 
 /// Prototype of a profile entry. All prototypes must be defined at compile time and must
 /// have a unique name. Subclasses then must provide a way to create new profile entries
@@ -232,6 +243,18 @@ class CounterPrototype : public ProfileEntryPrototype {
   }
 };
 
+class StripedCounterPrototype : public ProfileEntryPrototype {
+ public:
+  StripedCounterPrototype(
+      const char* name, Significance significance, const char* desc, TUnit::type unit)
+    : ProfileEntryPrototype(name, significance, desc, unit) {}
+
+  RuntimeProfile::StripedCounter* Instantiate(
+      RuntimeProfile* profile, const std::string& parent_counter_name = "") {
+    return profile->AddStripedCounter(name(), unit(), parent_counter_name);
+  }
+};
+
 class DerivedCounterPrototype : public ProfileEntryPrototype {
  public:
   DerivedCounterPrototype(const char* name, Significance significance, const char* desc,
@@ -388,6 +411,37 @@ class RuntimeProfile::DerivedCounter : public RuntimeProfileBase::Counter {
   SampleFunction counter_fn_;
 };
 
+/// A counter for values that many threads add to concurrently, e.g. the rows read by
+/// all scanner threads of a scan node. A regular counter is a single atomic, whose cache
+/// line moves between the cores on every update. This counter instead adds to one of a
+/// set of cache-line-padded cells that is picked by the updating thread, which spreads
+/// the updates over the cells once they contend. The cells are only allocated on the
+/// first contended update, so an uncontended counter costs the same as a regular one.
+/// Reading the value sums up the cells and is more expensive than for a regular counter,
+/// which is fine for counters that are mostly written and read when the profile is
+/// reported. BitOr() must not be used.
+class RuntimeProfile::StripedCounter : public RuntimeProfileBase::Counter {
+ public:
+  StripedCounter(TUnit::type unit) : Counter(unit) {}
+
+  void Add(int64_t delta) override { adder_.IncrementBy(delta); }
+
+  /// Not atomic with respect to concurrent Add() calls, which may be lost.
+  void Set(int64_t value) override {
+    adder_.Reset();
+    adder_.IncrementBy(value);
+  }
+
+  void Set(int value) override { Set(static_cast<int64_t>(value)); }
+
+  void Set(double value) override { DCHECK(false); }
+
+  int64_t value() const override { return adder_.Value(); }
+
+ private:
+  kudu::LongAdder adder_;
+};
+
 /// An AveragedCounter maintains a set of counters and its value is the
 /// average of the values in that set. The average is updated through calls
 /// to UpdateCounter(), which may add a new counter or update an existing counter.
@@ -21,6 +21,7 @@
 #include <random>
 
 #include <boost/bind.hpp>
+#include <gutil/strings/substitute.h>
 
 #include "common/object-pool.h"
 #include "testutil/gtest-util.h"
@@ -350,6 +351,129 @@ TEST(CountersTest, MergeAndUpdateChildOrder) {
   deserialized_profile->PrettyPrint(&dummy);
 }
 
+// Test that updating a profile with only the changes since the last update has the same
+// effect as updating it with the full profile.
+TEST(CountersTest, RemoveUnchangedFromThrift) {
+  ObjectPool pool;
+  RuntimeProfile* profile = RuntimeProfile::Create(&pool, "Parent");
+  RuntimeProfile* child = RuntimeProfile::Create(&pool, "Child");
+  profile->AddChild(child);
+  RuntimeProfile::Counter* changed = profile->AddCounter("Changed", TUnit::UNIT);
+  RuntimeProfile::Counter* unchanged = child->AddCounter("Unchanged", TUnit::UNIT);
+  RuntimeProfile::EventSequence* seq = profile->AddEventSequence("Events");
+  changed->Set(1);
+  unchanged->Set(2);
+  profile->AddInfoString("Unchanged info", "a");
+  child->AddInfoString("Changed info", "b");
+  seq->MarkEvent("first");
+  TRuntimeProfileTree baseline;
+  profile->ToThrift(&baseline);
+  RuntimeProfile* deserialized_profile = RuntimeProfile::Create(&pool, "Parent");
+  deserialized_profile->Update(baseline);
+
+  SleepForMs(1);
+  changed->Set(3);
+  child->AddInfoString("Changed info", "c");
+  child->AddInfoString("New info", "d");
+  RuntimeProfile::Counter* added = child->AddCounter("Added", TUnit::UNIT);
+  added->Set(4);
+  seq->MarkEvent("second");
+  TRuntimeProfileTree delta;
+  profile->ToThrift(&delta);
+  RuntimeProfile::RemoveUnchangedFromThrift(baseline, &delta);
+
+  // Both nodes are kept, but only with the changes.
+  ASSERT_EQ(2, delta.nodes.size());
+  const TRuntimeProfileNode& parent_node = delta.nodes[0];
+  const TRuntimeProfileNode& child_node = delta.nodes[1];
+  ASSERT_EQ(1, parent_node.counters.size());
+  EXPECT_EQ("Changed", parent_node.counters[0].name);
+  EXPECT_TRUE(parent_node.info_strings.empty());
+  ASSERT_EQ(1, parent_node.event_sequences.size());
+  EXPECT_EQ(vector<string>{"second"}, parent_node.event_sequences[0].labels);
+  ASSERT_EQ(1, child_node.counters.size());
+  EXPECT_EQ("Added", child_node.counters[0].name);
+  EXPECT_EQ((vector<string>{"Changed info", "New info"}),
+      child_node.info_strings_display_order);
+
+  deserialized_profile->Update(delta);
+  vector<RuntimeProfileBase*> children;
+  deserialized_profile->GetChildren(&children);
+  ASSERT_EQ(1, children.size());
+  RuntimeProfile* deserialized_child = static_cast<RuntimeProfile*>(children[0]);
+  ValidateCounter(deserialized_profile, "Changed", 3);
+  ValidateCounter(deserialized_child, "Unchanged", 2);
+  ValidateCounter(deserialized_child, "Added", 4);
+  EXPECT_EQ("a", *deserialized_profile->GetInfoString("Unchanged info"));
+  EXPECT_EQ("c", *deserialized_child->GetInfoString("Changed info"));
+  EXPECT_EQ("d", *deserialized_child->GetInfoString("New info"));
+  vector<RuntimeProfile::EventSequence::Event> events;
+  deserialized_profile->GetEventSequence("Events")->GetEvents(&events);
+  ASSERT_EQ(2, events.size());
+  EXPECT_EQ("first", events[0].first);
+  EXPECT_EQ("second", events[1].first);
+
+  // Nothing is left if the profile did not change.
+  TRuntimeProfileTree unchanged_profile;
+  profile->ToThrift(&unchanged_profile);
+  TRuntimeProfileTree full_profile = unchanged_profile;
+  RuntimeProfile::RemoveUnchangedFromThrift(full_profile, &unchanged_profile);
+  for (const TRuntimeProfileNode& node : unchanged_profile.nodes) {
+    EXPECT_TRUE(node.counters.empty());
+    EXPECT_TRUE(node.info_strings.empty());
+    EXPECT_TRUE(node.event_sequences.empty());
+  }
+}
+
+// Test that profiles survive a round trip through CompressCompact().
+TEST(CountersTest, CompressCompact) {
+  auto cert = ScopedFlagSetter<bool>::Make(&FLAGS_gen_experimental_profile, true);
+  ObjectPool pool;
+  const int NUM_INSTANCES = 3;
+  RuntimeProfile* instances[NUM_INSTANCES];
+  for (int i = 0; i < NUM_INSTANCES; ++i) {
+    instances[i] = RuntimeProfile::Create(&pool, "Instance");
+    RuntimeProfile* child = RuntimeProfile::Create(&pool, "Child");
+    instances[i]->AddChild(child);
+    instances[i]->AddCounter("Rows", TUnit::UNIT)->Set(1000L * i);
+    instances[i]->AddCounter("Delta", TUnit::BYTES)->Set(i % 2 == 0 ? -5L : 1L << 40);
+    instances[i]->AddCounter("ChildBytes", TUnit::BYTES, "Rows")->Set(i);
+    child->AddCounter("Rows", TUnit::UNIT)->Set(numeric_limits<int64_t>::min());
+    child->AddInfoString("Info", Substitute("value$0", i));
+  }
+  // Only update two of the instances, so that some values of the aggregated counters
+  // are missing.
+  AggregatedRuntimeProfile* aggregated =
+      AggregatedRuntimeProfile::Create(&pool, "Aggregated", NUM_INSTANCES, true);
+  aggregated->UpdateAggregatedFromInstance(instances[0], 0);
+  aggregated->UpdateAggregatedFromInstance(instances[2], 2);
+  RuntimeProfile* root = RuntimeProfile::Create(&pool, "Root");
+  root->AddChild(aggregated);
+  for (RuntimeProfile* instance : instances) root->AddChild(instance);
+
+  TRuntimeProfileTree expected;
+  root->ToThrift(&expected);
+  TRuntimeProfileTree encoded = expected;
+  vector<uint8_t> compressed;
+  ASSERT_OK(RuntimeProfile::CompressCompact(&encoded, &compressed));
+  EXPECT_TRUE(RuntimeProfile::IsCompressedCompact(compressed));
+  TRuntimeProfileTree decoded;
+  ASSERT_OK(RuntimeProfile::DecompressToThrift(compressed, &decoded));
+  EXPECT_EQ(expected, decoded);
+
+  // Compress() still produces compressed Thrift.
+  vector<uint8_t> thrift_compressed;
+  ASSERT_OK(root->Compress(&thrift_compressed));
+  EXPECT_FALSE(RuntimeProfile::IsCompressedCompact(thrift_compressed));
+  RuntimeProfile* deserialized;
+  ASSERT_OK(RuntimeProfile::DecompressToProfile(compressed, &pool, &deserialized));
+  EXPECT_EQ(root->name(), deserialized->name());
+
+  // Truncated profiles are rejected.
+  compressed.resize(compressed.size() / 2);
+  EXPECT_FALSE(RuntimeProfile::DecompressToThrift(compressed, &decoded).ok());
+}
+
 TEST(CountersTest, TotalTimeCounters) {
   ObjectPool pool;
 
@@ -479,6 +603,39 @@ TEST(CountersTest, HighWaterMarkCounters) {
   EXPECT_EQ(bytes_counter->value(), 28);
 }
 
+TEST(CountersTest, StripedCounters) {
+  ObjectPool pool;
+  RuntimeProfile* profile = RuntimeProfile::Create(&pool, "Profile");
+  RuntimeProfile::StripedCounter* rows_counter =
+      profile->AddStripedCounter("rows", TUnit::UNIT);
+  EXPECT_EQ(rows_counter, profile->AddStripedCounter("rows", TUnit::UNIT));
+  EXPECT_EQ(rows_counter, profile->GetCounter("rows"));
+  EXPECT_EQ(0, rows_counter->value());
+
+  // Concurrent updates are all counted.
+  const int NUM_THREADS = 8;
+  const int NUM_ADDS = 10000;
+  vector<unique_ptr<thread>> threads;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    threads.emplace_back(new thread([rows_counter]() {
+      for (int j = 0; j < NUM_ADDS; ++j) rows_counter->Add(2);
+    }));
+  }
+  for (auto& t : threads) t->join();
+  EXPECT_EQ(2 * NUM_THREADS * NUM_ADDS, rows_counter->value());
+
+  rows_counter->Set(5L);
+  EXPECT_EQ(5, rows_counter->value());
+  rows_counter->Add(-2);
+  EXPECT_EQ(3, rows_counter->value());
+
+  TRuntimeProfileTree tprofile;
+  profile->ToThrift(&tprofile);
+  RuntimeProfile* from_thrift = RuntimeProfile::CreateFromThrift(&pool, tprofile);
+  ASSERT_TRUE(from_thrift->GetCounter("rows") != nullptr);
+  EXPECT_EQ(3, from_thrift->GetCounter("rows")->value());
+}
+
 TEST(CountersTest, SummaryStatsCounters) {
   ObjectPool pool;
   RuntimeProfile* profile1 = RuntimeProfile::Create(&pool, "Profile 1");
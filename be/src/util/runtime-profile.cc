@@ -23,6 +23,7 @@
 #include <mutex>
 #include <numeric>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 
 #include <boost/algorithm/string/case_conv.hpp>
@@ -39,6 +40,7 @@
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
 #include "util/coding-util.h"
+#include "util/compact-profile-encoding.h"
 #include "util/compress.h"
 #include "util/container-util.h"
 #include "util/debug-util.h"
@@ -740,6 +742,103 @@ void RuntimeProfile::Update(const TRuntimeProfileTree& thrift_profile) {
   ComputeTimeInProfile();
 }
 
+/// Appends the path of each node of the pre-order list 'nodes', starting with node
+/// '*idx', to 'paths'. The path of a node consists of the names of its ancestors and
+/// its own name, which identifies it within the tree because sibling names are unique.
+static void GetThriftNodePaths(const vector<TRuntimeProfileNode>& nodes,
+    const string& parent_path, int* idx, vector<string>* paths) {
+  DCHECK_LT(*idx, nodes.size());
+  const TRuntimeProfileNode& node = nodes[*idx];
+  paths->push_back(parent_path + "/" + node.name);
+  const string& path = paths->back();
+  ++*idx;
+  for (int i = 0; i < node.num_children; ++i) {
+    GetThriftNodePaths(nodes, path, idx, paths);
+  }
+}
+
+/// Removes the elements of 'elems' for which 'unchanged' returns true.
+template <typename T, typename F>
+static void RemoveIf(vector<T>* elems, F unchanged) {
+  elems->erase(remove_if(elems->begin(), elems->end(), unchanged), elems->end());
+}
+
+/// Removes everything from 'node' that is unchanged from 'baseline', see
+/// RuntimeProfile::RemoveUnchangedFromThrift().
+static void RemoveUnchangedFromThriftNode(
+    const TRuntimeProfileNode& baseline, TRuntimeProfileNode* node) {
+  std::unordered_map<string, const TCounter*> baseline_counters;
+  for (const TCounter& c : baseline.counters) baseline_counters[c.name] = &c;
+  RemoveIf(&node->counters, [&baseline_counters](const TCounter& c) {
+    auto it = baseline_counters.find(c.name);
+    return it != baseline_counters.end() && *it->second == c;
+  });
+
+  vector<string> display_order;
+  for (const string& key : node->info_strings_display_order) {
+    auto it = baseline.info_strings.find(key);
+    if (it != baseline.info_strings.end() && it->second == node->info_strings[key]) {
+      node->info_strings.erase(key);
+    } else {
+      display_order.push_back(key);
+    }
+  }
+  node->info_strings_display_order = move(display_order);
+
+  auto it = node->child_counters_map.begin();
+  while (it != node->child_counters_map.end()) {
+    auto baseline_it = baseline.child_counters_map.find(it->first);
+    if (baseline_it != baseline.child_counters_map.end()
+        && baseline_it->second == it->second) {
+      it = node->child_counters_map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Events are only ever appended, so the events of the baseline are a prefix. Update()
+  // only adds events that are newer than the existing ones.
+  for (TEventSequence& seq : node->event_sequences) {
+    for (const TEventSequence& baseline_seq : baseline.event_sequences) {
+      if (baseline_seq.name != seq.name) continue;
+      const int num_old = min(baseline_seq.timestamps.size(), seq.timestamps.size());
+      seq.timestamps.erase(seq.timestamps.begin(), seq.timestamps.begin() + num_old);
+      seq.labels.erase(seq.labels.begin(), seq.labels.begin() + num_old);
+      break;
+    }
+  }
+  RemoveIf(&node->event_sequences,
+      [](const TEventSequence& seq) { return seq.timestamps.empty(); });
+
+  RemoveIf(&node->time_series_counters, [&baseline](const TTimeSeriesCounter& c) {
+    return find(baseline.time_series_counters.begin(),
+        baseline.time_series_counters.end(), c) != baseline.time_series_counters.end();
+  });
+  RemoveIf(&node->summary_stats_counters, [&baseline](const TSummaryStatsCounter& c) {
+    return find(baseline.summary_stats_counters.begin(),
+        baseline.summary_stats_counters.end(), c)
+        != baseline.summary_stats_counters.end();
+  });
+}
+
+void RuntimeProfile::RemoveUnchangedFromThrift(
+    const TRuntimeProfileTree& baseline, TRuntimeProfileTree* profile) {
+  if (baseline.nodes.empty() || profile->nodes.empty()) return;
+  vector<string> baseline_paths;
+  vector<string> paths;
+  int idx = 0;
+  GetThriftNodePaths(baseline.nodes, "", &idx, &baseline_paths);
+  idx = 0;
+  GetThriftNodePaths(profile->nodes, "", &idx, &paths);
+  std::unordered_map<string, int> baseline_idx;
+  for (int i = 0; i < baseline_paths.size(); ++i) baseline_idx[baseline_paths[i]] = i;
+  for (int i = 0; i < paths.size(); ++i) {
+    auto it = baseline_idx.find(paths[i]);
+    if (it == baseline_idx.end()) continue;
+    RemoveUnchangedFromThriftNode(baseline.nodes[it->second], &profile->nodes[i]);
+  }
+}
+
 void RuntimeProfile::Update(const vector<TRuntimeProfileNode>& nodes, int* idx) {
   if (UNLIKELY(nodes.size()) == 0) return;
   DCHECK_LT(*idx, nodes.size());
@@ -1133,6 +1232,7 @@ void RuntimeProfile::AddCodegenMsg(
 ADD_COUNTER_IMPL(AddCounter, Counter);
 ADD_COUNTER_IMPL(AddHighWaterMarkCounter, HighWaterMarkCounter);
 ADD_COUNTER_IMPL(AddConcurrentTimerCounter, ConcurrentTimerCounter);
+ADD_COUNTER_IMPL(AddStripedCounter, StripedCounter);
 
 RuntimeProfile::DerivedCounter* RuntimeProfile::AddDerivedCounter(
     const string& name, TUnit::type unit,
@@ -1554,33 +1654,62 @@ void RuntimeProfile::PrettyPrintSubclassCounters(
   }
 }
 
-Status RuntimeProfile::Compress(vector<uint8_t>* out) const {
-  Status status;
-  TRuntimeProfileTree thrift_object;
-  const_cast<RuntimeProfile*>(this)->ToThrift(&thrift_object);
-  ThriftSerializer serializer(true);
-  vector<uint8_t> serialized_buffer;
-  RETURN_IF_ERROR(serializer.SerializeToVector(&thrift_object, &serialized_buffer));
+/// Marks profiles serialized by CompressCompact(). The low bits of the first byte of a
+/// zlib stream are always 8, so the output of Compress() never starts with it.
+static const uint8_t COMPACT_PROFILE_MAGIC[] = {'I', 'C', 'P', 1};
 
-  // Compress the serialized thrift string.  This uses string keys and is very
-  // easy to compress.
+/// Appends the zlib compressed 'len' bytes at 'data' to 'out'.
+static Status ZlibCompress(const uint8_t* data, int64_t len, vector<uint8_t>* out) {
   scoped_ptr<Codec> compressor;
   Codec::CodecInfo codec_info(THdfsCompression::DEFAULT);
   RETURN_IF_ERROR(Codec::CreateCompressor(NULL, false, codec_info, &compressor));
   const auto close_compressor =
       MakeScopeExitTrigger([&compressor]() { compressor->Close(); });
 
-  int64_t max_compressed_size = compressor->MaxOutputLen(serialized_buffer.size());
+  int64_t max_compressed_size = compressor->MaxOutputLen(len);
   DCHECK_GT(max_compressed_size, 0);
-  out->resize(max_compressed_size);
-  int64_t result_len = out->size();
-  uint8_t* compressed_buffer_ptr = out->data();
-  RETURN_IF_ERROR(compressor->ProcessBlock(true, serialized_buffer.size(),
-      serialized_buffer.data(), &result_len, &compressed_buffer_ptr));
-  out->resize(result_len);
+  const int64_t offset = out->size();
+  out->resize(offset + max_compressed_size);
+  int64_t result_len = max_compressed_size;
+  uint8_t* compressed_buffer_ptr = out->data() + offset;
+  RETURN_IF_ERROR(
+      compressor->ProcessBlock(true, len, data, &result_len, &compressed_buffer_ptr));
+  out->resize(offset + result_len);
   return Status::OK();
 }
 
+Status RuntimeProfile::Compress(vector<uint8_t>* out) const {
+  TRuntimeProfileTree thrift_object;
+  const_cast<RuntimeProfile*>(this)->ToThrift(&thrift_object);
+  return CompressThrift(thrift_object, out);
+}
+
+Status RuntimeProfile::CompressThrift(
+    const TRuntimeProfileTree& profile, vector<uint8_t>* out) {
+  ThriftSerializer serializer(true);
+  vector<uint8_t> serialized_buffer;
+  RETURN_IF_ERROR(serializer.SerializeToVector(&profile, &serialized_buffer));
+
+  // Compress the serialized thrift string.  This uses string keys and is very
+  // easy to compress.
+  out->clear();
+  return ZlibCompress(serialized_buffer.data(), serialized_buffer.size(), out);
+}
+
+Status RuntimeProfile::CompressCompact(
+    TRuntimeProfileTree* profile, vector<uint8_t>* out) {
+  vector<uint8_t> encoded_buffer;
+  RETURN_IF_ERROR(CompactProfileEncoding::Encode(profile, &encoded_buffer));
+  out->assign(std::begin(COMPACT_PROFILE_MAGIC), std::end(COMPACT_PROFILE_MAGIC));
+  return ZlibCompress(encoded_buffer.data(), encoded_buffer.size(), out);
+}
+
+bool RuntimeProfile::IsCompressedCompact(const vector<uint8_t>& compressed_profile) {
+  return compressed_profile.size() >= sizeof(COMPACT_PROFILE_MAGIC)
+      && memcmp(compressed_profile.data(), COMPACT_PROFILE_MAGIC,
+             sizeof(COMPACT_PROFILE_MAGIC)) == 0;
+}
+
 Status RuntimeProfile::DecompressToThrift(
     const vector<uint8_t>& compressed_profile, TRuntimeProfileTree* out) {
   scoped_ptr<Codec> decompressor;
@@ -1595,10 +1724,15 @@ Status RuntimeProfile::DecompressToThrift(
   const auto close_decompressor =
       MakeScopeExitTrigger([&decompressor]() { decompressor->Close(); });
 
+  const bool compact = IsCompressedCompact(compressed_profile);
+  const int64_t offset = compact ? sizeof(COMPACT_PROFILE_MAGIC) : 0;
   int64_t result_len;
   uint8_t* decompressed_buffer;
-  RETURN_IF_ERROR(decompressor->ProcessBlock(false, compressed_profile.size(),
-      compressed_profile.data(), &result_len, &decompressed_buffer));
+  RETURN_IF_ERROR(decompressor->ProcessBlock(false, compressed_profile.size() - offset,
+      compressed_profile.data() + offset, &result_len, &decompressed_buffer));
+  if (compact) {
+    return CompactProfileEncoding::Decode(decompressed_buffer, result_len, out);
+  }
 
   uint32_t deserialized_len = static_cast<uint32_t>(result_len);
   RETURN_IF_ERROR(
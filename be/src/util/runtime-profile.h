@@ -426,6 +426,7 @@ class RuntimeProfile : public RuntimeProfileBase {
   class ConcurrentTimerCounter;
   class DerivedCounter;
   class HighWaterMarkCounter;
+  class StripedCounter;
   class EventSequence;
   class ThreadCounters;
   class TimeSeriesCounter;
@@ -481,6 +482,16 @@ class RuntimeProfile : public RuntimeProfileBase {
   /// the key has already been registered.
   void Update(const TRuntimeProfileTree& thrift_profile);
 
+  /// Removes everything from 'profile' that is unchanged from 'baseline', both the
+  /// ToThrift() output of the same profile: counters, info strings, child counter
+  /// entries, time series and summary stats counters with the same values, and the
+  /// events of event sequences that were already in 'baseline'. All nodes are kept, so
+  /// that Update() of a profile that was already updated with 'baseline' has the same
+  /// result with the reduced 'profile' as with the full one. Used to send only the
+  /// changes of instance profiles to the coordinator.
+  static void RemoveUnchangedFromThrift(
+      const TRuntimeProfileTree& baseline, TRuntimeProfileTree* profile);
+
   /// Add a counter with 'name'/'unit'.  Returns a counter object that the caller can
   /// update.  The counter is owned by the RuntimeProfile object.
   /// If parent_counter_name is a non-empty string, the counter is added as a child of
@@ -502,6 +513,11 @@ class RuntimeProfile : public RuntimeProfileBase {
   ConcurrentTimerCounter* AddConcurrentTimerCounter(const std::string& name,
       TUnit::type unit, const std::string& parent_counter_name = "");
 
+  /// Adds a counter that is cheaper to Add() to than a regular counter when many
+  /// threads update it concurrently. Otherwise, same behavior as AddCounter().
+  StripedCounter* AddStripedCounter(const std::string& name, TUnit::type unit,
+      const std::string& parent_counter_name = "");
+
   /// Add a derived counter with 'name'/'unit'. The counter is owned by the
   /// RuntimeProfile object.
   /// If parent_counter_name is a non-empty string, the counter is added as a child of
@@ -677,13 +693,28 @@ class RuntimeProfile : public RuntimeProfileBase {
   /// This is not a lightweight operation and should not be in the hot path.
   Status Compress(std::vector<uint8_t>* out) const;
 
+  /// Same as Compress(), but serializes 'profile' instead of this profile.
+  static Status CompressThrift(
+      const TRuntimeProfileTree& profile, std::vector<uint8_t>* out);
+
+  /// Serializes 'profile' with CompactProfileEncoding and zlib compresses it, which
+  /// takes considerably less space than Compress() for profiles with many nodes. Used
+  /// for profiles that are kept in memory. The output is not compatible with external
+  /// readers of Compress() and the encoding may change between versions, so it must
+  /// not be persisted. 'profile' is consumed, see CompactProfileEncoding::Encode().
+  static Status CompressCompact(TRuntimeProfileTree* profile, std::vector<uint8_t>* out);
+
+  /// Returns true if 'compressed_profile' was serialized by CompressCompact().
+  static bool IsCompressedCompact(const std::vector<uint8_t>& compressed_profile);
+
   /// Deserializes a compressed profile into a TRuntimeProfileTree. 'compressed_profile'
-  /// is expected to have been serialized by Compress().
+  /// is expected to have been serialized by Compress() or CompressCompact().
   static Status DecompressToThrift(
       const std::vector<uint8_t>& compressed_profile, TRuntimeProfileTree* out);
 
   /// Deserializes a compressed profile into a RuntimeProfile tree owned by 'pool'.
-  /// 'compressed_profile' is expected to have been serialized by Compress().
+  /// 'compressed_profile' is expected to have been serialized by Compress() or
+  /// CompressCompact().
   static Status DecompressToProfile(const std::vector<uint8_t>& compressed_profile,
       ObjectPool* pool, RuntimeProfile** out);
 
@@ -799,6 +830,8 @@ class RuntimeProfile : public RuntimeProfileBase {
       TUnit::type unit, const std::string& parent_counter_name, bool* created);
   ConcurrentTimerCounter* AddConcurrentTimerCounterLocked(const std::string& name,
       TUnit::type unit, const std::string& parent_counter_name, bool* created);
+  StripedCounter* AddStripedCounterLocked(const std::string& name,
+      TUnit::type unit, const std::string& parent_counter_name, bool* created);
 };
 
 /// An aggregated profile that results from combining one or more RuntimeProfiles.
@@ -0,0 +1,91 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "testutil/gtest-util.h"
+#include "util/sharded-query-log.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+typedef ShardedQueryLog<int> IntLog;
+
+static TUniqueId QueryId(int64_t hi) {
+  TUniqueId query_id;
+  query_id.__set_hi(hi);
+  query_id.__set_lo(0);
+  return query_id;
+}
+
+/// Returns the values of all records in 'log', the most recent first.
+static vector<int> GetValues(IntLog* log) {
+  vector<IntLog::RecordPtr> records;
+  log->GetAll(&records);
+  vector<int> values;
+  for (const IntLog::RecordPtr& record : records) values.push_back(*record);
+  return values;
+}
+
+TEST(ShardedQueryLog, RecordLimit) {
+  IntLog log(3, -1);
+  vector<IntLog::RecordPtr> evicted;
+  // Consecutive ids go to different shards, but records are evicted in FIFO order
+  // across all shards.
+  for (int i = 0; i < 5; ++i) {
+    log.Add(QueryId(i), make_shared<int>(i), 1, &evicted);
+  }
+  EXPECT_EQ(3, log.num_records());
+  EXPECT_EQ((vector<int>{4, 3, 2}), GetValues(&log));
+  ASSERT_EQ(2, evicted.size());
+  EXPECT_EQ(0, *evicted[0]);
+  EXPECT_EQ(1, *evicted[1]);
+  EXPECT_EQ(nullptr, log.Get(QueryId(1)));
+  ASSERT_NE(nullptr, log.Get(QueryId(2)));
+  EXPECT_EQ(2, *log.Get(QueryId(2)));
+}
+
+TEST(ShardedQueryLog, ByteLimit) {
+  IntLog log(-1, 100);
+  log.Add(QueryId(0), make_shared<int>(0), 60, nullptr);
+  log.Add(QueryId(4), make_shared<int>(1), 30, nullptr);
+  EXPECT_EQ(90, log.num_bytes());
+  // Evicts the first record, which is in the same shard.
+  log.Add(QueryId(8), make_shared<int>(2), 20, nullptr);
+  EXPECT_EQ(50, log.num_bytes());
+  EXPECT_EQ((vector<int>{2, 1}), GetValues(&log));
+
+  // A record that exceeds the limit on its own evicts all records, including itself.
+  vector<IntLog::RecordPtr> evicted;
+  log.Add(QueryId(1), make_shared<int>(3), 200, &evicted);
+  EXPECT_EQ(0, log.num_records());
+  EXPECT_EQ(0, log.num_bytes());
+  EXPECT_EQ(3, evicted.size());
+}
+
+TEST(ShardedQueryLog, ReplacedRecord) {
+  IntLog log(2, -1);
+  log.Add(QueryId(0), make_shared<int>(0), 1, nullptr);
+  log.Add(QueryId(0), make_shared<int>(1), 1, nullptr);
+  EXPECT_EQ(1, *log.Get(QueryId(0)));
+  // Evicting the replaced record keeps the newer record of the same query id.
+  log.Add(QueryId(1), make_shared<int>(2), 1, nullptr);
+  EXPECT_EQ((vector<int>{2, 1}), GetValues(&log));
+  ASSERT_NE(nullptr, log.Get(QueryId(0)));
+  EXPECT_EQ(1, *log.Get(QueryId(0)));
+}
+
+}
@@ -0,0 +1,181 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/logging.h"
+#include "gen-cpp/Types_types.h"
+#include "util/aligned-new.h"
+#include "util/spinlock.h"
+#include "util/unique-id-hash.h"
+
+namespace impala {
+
+/// A log of the immutable records of completed queries that can be looked up by query
+/// id. The log is bounded by the number of records and by their total size in bytes, as
+/// estimated by the caller. Once either limit is exceeded, the oldest records are
+/// evicted, i.e. the log is a FIFO queue across all shards.
+///
+/// Like ShardedQueryMap, the records are split into shards by query id with a SpinLock
+/// per shard, so that adding, looking up and listing records do not contend on a single
+/// lock. Records are handed out as shared pointers, so that callers can use them after
+/// the locks are released and after the records were evicted.
+///
+/// All functions are thread-safe.
+template <typename T>
+class ShardedQueryLog {
+ public:
+  typedef std::shared_ptr<const T> RecordPtr;
+
+  /// 'max_records' and 'max_bytes' are the limits of the log, -1 means unlimited.
+  ShardedQueryLog(int64_t max_records, int64_t max_bytes)
+    : max_records_(max_records), max_bytes_(max_bytes) {}
+
+  /// Adds 'record' of 'query_id' as the most recent record, replacing an existing
+  /// record of 'query_id' in lookups. 'bytes' is the estimated size of the record. Then
+  /// evicts the oldest records until the log is within its limits and appends them to
+  /// 'evicted', if not nullptr.
+  void Add(const TUniqueId& query_id, RecordPtr record, int64_t bytes,
+      std::vector<RecordPtr>* evicted) {
+    Shard* shard = GetShard(query_id);
+    {
+      std::lock_guard<SpinLock> l(shard->lock);
+      shard->index[query_id] = record;
+      shard->entries.push_back(Entry{next_seq_++, query_id, std::move(record), bytes});
+      num_records_ += 1;
+      num_bytes_ += bytes;
+    }
+    Evict(evicted);
+  }
+
+  /// Returns the record of 'query_id' or nullptr if it is not in the log.
+  RecordPtr Get(const TUniqueId& query_id) {
+    Shard* shard = GetShard(query_id);
+    std::lock_guard<SpinLock> l(shard->lock);
+    auto it = shard->index.find(query_id);
+    return it == shard->index.end() ? nullptr : it->second;
+  }
+
+  /// Returns all records in 'records', the most recent first.
+  void GetAll(std::vector<RecordPtr>* records) {
+    std::vector<std::pair<int64_t, RecordPtr>> entries;
+    for (Shard& shard : shards_) {
+      std::lock_guard<SpinLock> l(shard.lock);
+      for (const Entry& entry : shard.entries) {
+        entries.emplace_back(entry.seq, entry.record);
+      }
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](const std::pair<int64_t, RecordPtr>& a,
+            const std::pair<int64_t, RecordPtr>& b) { return a.first > b.first; });
+    records->clear();
+    records->reserve(entries.size());
+    for (auto& entry : entries) records->push_back(std::move(entry.second));
+  }
+
+  int64_t num_records() const { return num_records_.load(); }
+  int64_t num_bytes() const { return num_bytes_.load(); }
+
+ private:
+  /// Number of shards, same as for ShardedQueryMap.
+  static constexpr int NUM_SHARDS = 4;
+
+  struct Entry {
+    /// Position of the record in the log, increasing with every added record.
+    int64_t seq;
+    TUniqueId query_id;
+    RecordPtr record;
+    int64_t bytes;
+  };
+
+  struct Shard : public CacheLineAligned {
+    SpinLock lock;
+
+    /// Records of the shard, the oldest first.
+    std::deque<Entry> entries;
+
+    /// The most recent record of every query id in 'entries'.
+    std::unordered_map<TUniqueId, RecordPtr> index;
+  };
+
+  Shard* GetShard(const TUniqueId& query_id) {
+    return &shards_[static_cast<uint64_t>(query_id.hi) % NUM_SHARDS];
+  }
+
+  bool OverLimits() const {
+    return (max_records_ >= 0 && num_records_.load() > max_records_)
+        || (max_bytes_ >= 0 && num_bytes_.load() > max_bytes_);
+  }
+
+  /// Evicts the oldest records across all shards until the log is within its limits.
+  void Evict(std::vector<RecordPtr>* evicted) {
+    if (!OverLimits()) return;
+    // Only one thread evicts at a time, so that the oldest record that it finds cannot
+    // be removed by another thread and records are not evicted twice.
+    std::lock_guard<std::mutex> evict_lock(evict_lock_);
+    while (OverLimits()) {
+      Shard* oldest = nullptr;
+      int64_t oldest_seq = 0;
+      for (Shard& shard : shards_) {
+        std::lock_guard<SpinLock> l(shard.lock);
+        if (shard.entries.empty()) continue;
+        if (oldest == nullptr || shard.entries.front().seq < oldest_seq) {
+          oldest = &shard;
+          oldest_seq = shard.entries.front().seq;
+        }
+      }
+      if (oldest == nullptr) return;
+      std::lock_guard<SpinLock> l(oldest->lock);
+      DCHECK_EQ(oldest->entries.front().seq, oldest_seq);
+      Entry& entry = oldest->entries.front();
+      auto it = oldest->index.find(entry.query_id);
+      // Only remove the record from the index if it was not replaced by a newer one.
+      if (it != oldest->index.end() && it->second == entry.record) {
+        oldest->index.erase(it);
+      }
+      num_records_ -= 1;
+      num_bytes_ -= entry.bytes;
+      if (evicted != nullptr) evicted->push_back(std::move(entry.record));
+      oldest->entries.pop_front();
+    }
+  }
+
+  const int64_t max_records_;
+  const int64_t max_bytes_;
+
+  Shard shards_[NUM_SHARDS];
+
+  /// Serializes Evict().
+  std::mutex evict_lock_;
+
+  /// Next value of Entry::seq.
+  std::atomic<int64_t> next_seq_{0};
+
+  /// Number and total size of the records in all shards.
+  std::atomic<int64_t> num_records_{0};
+  std::atomic<int64_t> num_bytes_{0};
+};
+
+}
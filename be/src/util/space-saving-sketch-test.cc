@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cstdlib>
+#include <unordered_map>
+
+#include "testutil/gtest-util.h"
+#include "util/space-saving-sketch.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+TEST(SpaceSavingSketch, ExactBelowCapacity) {
+  SpaceSavingSketch sketch(4);
+  for (int i = 0; i < 10; ++i) sketch.Add(1);
+  for (int i = 0; i < 5; ++i) sketch.Add(2);
+  sketch.Add(3, 7);
+  vector<SpaceSavingSketch::Entry> top;
+  sketch.GetTopEntries(2, &top);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ(1, top[0].key);
+  EXPECT_EQ(10, top[0].count);
+  EXPECT_EQ(0, top[0].error);
+  EXPECT_EQ(3, top[1].key);
+  EXPECT_EQ(7, top[1].count);
+  EXPECT_EQ(22, sketch.total());
+}
+
+// Mixes a few heavy keys into many distinct keys and checks that the heavy keys are
+// found and that the counts bound their true counts.
+TEST(SpaceSavingSketch, FindsHeavyHitters) {
+  const int capacity = 16;
+  SpaceSavingSketch sketch(capacity);
+  unordered_map<uint64_t, int64_t> true_counts;
+  for (int i = 0; i < 100000; ++i) {
+    uint64_t key;
+    if (i % 5 == 0) {
+      key = 0;
+    } else if (i % 7 == 0) {
+      key = 42;
+    } else {
+      key = 1000 + rand() % 50000;
+    }
+    sketch.Add(key);
+    ++true_counts[key];
+  }
+  vector<SpaceSavingSketch::Entry> top;
+  sketch.GetTopEntries(capacity, &top);
+  ASSERT_EQ(capacity, top.size());
+  EXPECT_EQ(0, top[0].key);
+  EXPECT_EQ(42, top[1].key);
+  for (const SpaceSavingSketch::Entry& entry : top) {
+    EXPECT_GE(entry.count, true_counts[entry.key]);
+    EXPECT_LE(entry.count - entry.error, true_counts[entry.key]);
+    EXPECT_LE(entry.error, sketch.total() / capacity);
+  }
+}
+
+} // namespace impala
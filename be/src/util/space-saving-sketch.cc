@@ -0,0 +1,64 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/space-saving-sketch.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+SpaceSavingSketch::SpaceSavingSketch(int capacity) : capacity_(capacity) {
+  DCHECK_GT(capacity, 0);
+  entries_.reserve(capacity);
+  key_to_idx_.reserve(capacity);
+}
+
+void SpaceSavingSketch::Add(uint64_t key, int64_t weight) {
+  DCHECK_GT(weight, 0);
+  total_ += weight;
+  auto it = key_to_idx_.find(key);
+  if (it != key_to_idx_.end()) {
+    entries_[it->second].count += weight;
+    return;
+  }
+  if (entries_.size() < capacity_) {
+    key_to_idx_[key] = entries_.size();
+    entries_.push_back({key, weight, 0});
+    return;
+  }
+  int min_idx = 0;
+  for (int i = 1; i < entries_.size(); ++i) {
+    if (entries_[i].count < entries_[min_idx].count) min_idx = i;
+  }
+  Entry* victim = &entries_[min_idx];
+  key_to_idx_.erase(victim->key);
+  key_to_idx_[key] = min_idx;
+  *victim = {key, victim->count + weight, victim->count};
+}
+
+void SpaceSavingSketch::GetTopEntries(int n, vector<Entry>* entries) const {
+  *entries = entries_;
+  std::sort(entries->begin(), entries->end(),
+      [](const Entry& a, const Entry& b) { return a.count > b.count; });
+  if (entries->size() > n) entries->resize(n);
+}
+
+} // namespace impala
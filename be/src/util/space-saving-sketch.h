@@ -0,0 +1,72 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "gutil/macros.h"
+
+namespace impala {
+
+/// Finds the most frequent keys of a stream with the Space-Saving algorithm (Metwally
+/// et al., "Efficient Computation of Frequent and Top-k Elements in Data Streams"). The
+/// sketch monitors at most 'capacity' keys, each with a counter. A key that is not
+/// monitored takes over the counter with the smallest count once all counters are in
+/// use, and inherits its count as the overestimation error. Any key that occurs more
+/// than total() / capacity times is guaranteed to be monitored, and the count of a
+/// monitored key overestimates its true count by at most its error.
+///
+/// Replacing a counter scans all counters, so 'capacity' should be small. Not
+/// thread-safe.
+class SpaceSavingSketch {
+ public:
+  struct Entry {
+    uint64_t key;
+    /// An upper bound on the occurrences of 'key'.
+    int64_t count;
+    /// The most that 'count' overestimates the occurrences of 'key' by.
+    int64_t error;
+  };
+
+  explicit SpaceSavingSketch(int capacity);
+
+  /// Adds 'weight' occurrences of 'key'.
+  void Add(uint64_t key, int64_t weight = 1);
+
+  /// Sets 'entries' to the at most 'n' monitored keys with the highest counts, in
+  /// descending order of their counts.
+  void GetTopEntries(int n, std::vector<Entry>* entries) const;
+
+  /// Returns the total weight of all added keys.
+  int64_t total() const { return total_; }
+
+ private:
+  const int capacity_;
+
+  /// The counters of the monitored keys and the index of each key's counter.
+  std::vector<Entry> entries_;
+  std::unordered_map<uint64_t, int> key_to_idx_;
+
+  int64_t total_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(SpaceSavingSketch);
+};
+
+} // namespace impala
@@ -227,6 +227,25 @@ TEST(StringToInt, Overflow) {
       StringParser::PARSE_OVERFLOW);
 }
 
+// Strings with runs of eight or more digits, which are converted eight digits at once.
+TEST(StringToInt, LongDigits) {
+  TestIntValue<int32_t>("123456789", 123456789, StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("-87654321", -87654321, StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("000000000000000123", 123, StringParser::PARSE_SUCCESS);
+  TestIntValue<int32_t>("1234567a", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int64_t>("12345678901234567", 12345678901234567LL,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("1234567890123456789", 1234567890123456789LL,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("-1234567890123456789", -1234567890123456789LL,
+      StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("00000000000000000000042", 42, StringParser::PARSE_SUCCESS);
+  TestIntValue<int64_t>("99999999999999999999", numeric_limits<int64_t>::max(),
+      StringParser::PARSE_OVERFLOW);
+  TestIntValue<int64_t>("12345678x0123456789", 0, StringParser::PARSE_FAILURE);
+  TestIntValue<int64_t>("1234567890123456:89", 0, StringParser::PARSE_FAILURE);
+}
+
 TEST(StringToInt, Int8_Exhaustive) {
   char buffer[5];
   for (int i = -256; i <= 256; ++i) {
@@ -461,6 +480,21 @@ TEST(StringToFloat, Basic) {
   TestAllFloatVariants(s3, StringParser::PARSE_FAILURE);
 }
 
+// Plain decimal numbers with many digits, some of which are converted with a single
+// division of their digits.
+TEST(StringToFloat, LongDigits) {
+  TestAllFloatVariants("12345678", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("1234567.89012345", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("3.141592653589793", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("0.1", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants(".0000012345678901", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("9007199254740992", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("123.", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("12345678.12345678e3", StringParser::PARSE_SUCCESS);
+  TestAllFloatVariants("12345678.1234x678", StringParser::PARSE_FAILURE);
+  TestAllFloatVariants("1234.5678.9", StringParser::PARSE_FAILURE);
+}
+
 TEST(StringToFloat, InvalidLeadingTrailing) {
   // Test that trailing garbage is not allowed.
   TestFloatValue<double>("123xyz   ", StringParser::PARSE_FAILURE);
@@ -15,9 +15,14 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <array>
+#include <limits>
+
 #include <boost/scoped_ptr.hpp>
 
 #include "exprs/slot-ref.h"
+#include "runtime/date-value.h"
+#include "runtime/decimal-value.inline.h"
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/test-env.h"
@@ -808,5 +813,145 @@ TEST_F(TupleRowCompareTest, VarcharTest) {
   EXPECT_EQ(VarcharVarchar16ByteTest("zz", "ydz", "a", "caaa"), 1);
 }
 
-} //namespace impala
+// Checks that EncodeKeyPrefix() orders 'values', which must be sorted in ascending
+// order, like the sort orders with both directions and both NULL orders.
+template <typename T>
+static void TestKeyPrefixOrder(const ColumnType& type, const vector<T>& values) {
+  ASSERT_TRUE(TupleRowLexicalComparator::IsKeyPrefixType(type));
+  for (bool is_asc : {true, false}) {
+    for (bool nulls_first : {true, false}) {
+      uint64_t null_prefix = TupleRowLexicalComparator::EncodeKeyPrefix(
+          nullptr, type, is_asc, nulls_first);
+      for (int i = 0; i < values.size(); ++i) {
+        uint64_t prefix = TupleRowLexicalComparator::EncodeKeyPrefix(
+            &values[i], type, is_asc, nulls_first);
+        if (nulls_first) {
+          EXPECT_LE(null_prefix, prefix) << i;
+        } else {
+          EXPECT_GE(null_prefix, prefix) << i;
+        }
+        if (i == 0) continue;
+        uint64_t prev_prefix = TupleRowLexicalComparator::EncodeKeyPrefix(
+            &values[i - 1], type, is_asc, nulls_first);
+        if (is_asc) {
+          EXPECT_LE(prev_prefix, prefix) << i;
+        } else {
+          EXPECT_GE(prev_prefix, prefix) << i;
+        }
+      }
+    }
+  }
+}
+
+TEST(TupleRowKeyPrefixTest, IntegerTypes) {
+  TestKeyPrefixOrder<int8_t>(ColumnType(TYPE_TINYINT), {-128, -1, 0, 1, 127});
+  TestKeyPrefixOrder<int16_t>(ColumnType(TYPE_SMALLINT), {-32768, -300, 0, 300, 32767});
+  TestKeyPrefixOrder<int32_t>(
+      ColumnType(TYPE_INT), {std::numeric_limits<int32_t>::min(), -70000, -1, 0, 70000,
+      std::numeric_limits<int32_t>::max()});
+  TestKeyPrefixOrder<int64_t>(
+      ColumnType(TYPE_BIGINT), {std::numeric_limits<int64_t>::min(), -(1LL << 40), -1, 0,
+      1LL << 40, std::numeric_limits<int64_t>::max()});
+  // vector<bool> has no addressable elements.
+  bool bools[] = {false, true};
+  EXPECT_LT(TupleRowLexicalComparator::EncodeKeyPrefix(&bools[0],
+      ColumnType(TYPE_BOOLEAN), true, true), TupleRowLexicalComparator::EncodeKeyPrefix(
+      &bools[1], ColumnType(TYPE_BOOLEAN), true, true));
+  // Distinct integers have distinct prefixes.
+  int32_t a = -1;
+  int32_t b = 0;
+  EXPECT_LT(TupleRowLexicalComparator::EncodeKeyPrefix(&a, ColumnType(TYPE_INT), true,
+      true), TupleRowLexicalComparator::EncodeKeyPrefix(&b, ColumnType(TYPE_INT), true,
+      true));
+}
+
+TEST(TupleRowKeyPrefixTest, DateTimeTypes) {
+  TestKeyPrefixOrder<DateValue>(ColumnType(TYPE_DATE), {DateValue::MIN_DATE,
+      DateValue(1969, 12, 31), DateValue(1970, 1, 1), DateValue::MAX_DATE});
+  TestKeyPrefixOrder<TimestampValue>(ColumnType(TYPE_TIMESTAMP), {
+      TimestampValue::ParseSimpleDateFormat("1400-01-01 00:00:00"),
+      TimestampValue::ParseSimpleDateFormat("1969-12-31 23:59:59.999999999"),
+      TimestampValue::ParseSimpleDateFormat("1970-01-01 00:00:00"),
+      TimestampValue::ParseSimpleDateFormat("1970-01-01 00:00:01"),
+      TimestampValue::ParseSimpleDateFormat("9999-12-31 23:59:59.999999999")});
+}
+
+TEST(TupleRowKeyPrefixTest, DecimalTypes) {
+  TestKeyPrefixOrder<Decimal4Value>(ColumnType::CreateDecimalType(9, 2),
+      {Decimal4Value(-999999999), Decimal4Value(-1), Decimal4Value(0),
+      Decimal4Value(999999999)});
+  TestKeyPrefixOrder<Decimal8Value>(ColumnType::CreateDecimalType(18, 2),
+      {Decimal8Value(-(1LL << 50)), Decimal8Value(-1), Decimal8Value(0),
+      Decimal8Value(1LL << 50)});
+  __int128_t big = static_cast<__int128_t>(1) << 100;
+  TestKeyPrefixOrder<Decimal16Value>(ColumnType::CreateDecimalType(38, 2),
+      {Decimal16Value(-big), Decimal16Value(-1), Decimal16Value(0), Decimal16Value(1),
+      Decimal16Value(big)});
+}
+
+TEST(TupleRowKeyPrefixTest, StringTypes) {
+  vector<string> strings = {"", "\x01", "a", "a\x01", "ab", "abcdefgh", "abcdefghij",
+      "abcdefgi", "b", "\xff"};
+  vector<StringValue> values;
+  for (const string& str : strings) values.emplace_back(str);
+  TestKeyPrefixOrder<StringValue>(ColumnType(TYPE_STRING), values);
+  TestKeyPrefixOrder<StringValue>(ColumnType::CreateVarcharType(20), values);
+
+  // CHAR values are padded with spaces, which comparisons ignore.
+  ColumnType char_type = ColumnType::CreateCharType(4);
+  TestKeyPrefixOrder<std::array<char, 4>>(char_type,
+      {{{'a', ' ', ' ', ' '}}, {{'a', '\x01', ' ', ' '}}, {{'a', 'b', ' ', ' '}}});
+  // Floating point values are not supported.
+  EXPECT_FALSE(TupleRowLexicalComparator::IsKeyPrefixType(ColumnType(TYPE_DOUBLE)));
+}
 
+// Checks that EncodeRadixKey() orders 'values', which must be strictly increasing,
+// like the sort orders of both directions, and that no two values share an encoding.
+template <typename T>
+static void TestRadixKeyOrder(const ColumnType& type, const vector<T>& values) {
+  const int num_words = TupleRowLexicalComparator::RadixKeyWords(type);
+  ASSERT_GT(num_words, 0);
+  ASSERT_LE(num_words, TupleRowLexicalComparator::MAX_RADIX_KEY_WORDS);
+  for (bool is_asc : {true, false}) {
+    vector<vector<uint64_t>> keys;
+    for (const T& value : values) {
+      vector<uint64_t> words(num_words);
+      TupleRowLexicalComparator::EncodeRadixKey(&value, type, is_asc, words.data());
+      keys.push_back(move(words));
+    }
+    for (int i = 1; i < keys.size(); ++i) {
+      if (is_asc) {
+        EXPECT_LT(keys[i - 1], keys[i]) << i;
+      } else {
+        EXPECT_GT(keys[i - 1], keys[i]) << i;
+      }
+    }
+  }
+}
+
+TEST(TupleRowRadixKeyTest, Types) {
+  TestRadixKeyOrder<int8_t>(ColumnType(TYPE_TINYINT), {-128, -1, 0, 1, 127});
+  TestRadixKeyOrder<int32_t>(ColumnType(TYPE_INT),
+      {std::numeric_limits<int32_t>::min(), -1, 0, 1,
+      std::numeric_limits<int32_t>::max()});
+  TestRadixKeyOrder<int64_t>(ColumnType(TYPE_BIGINT),
+      {std::numeric_limits<int64_t>::min(), -1, 0, 1,
+      std::numeric_limits<int64_t>::max()});
+  TestRadixKeyOrder<DateValue>(ColumnType(TYPE_DATE), {DateValue::MIN_DATE,
+      DateValue(1969, 12, 31), DateValue(1970, 1, 1), DateValue::MAX_DATE});
+  // Timestamps differing only in their last nanoseconds have distinct keys.
+  TestRadixKeyOrder<TimestampValue>(ColumnType(TYPE_TIMESTAMP), {
+      TimestampValue::ParseSimpleDateFormat("1400-01-01 00:00:00"),
+      TimestampValue::ParseSimpleDateFormat("1970-01-01 00:00:00"),
+      TimestampValue::ParseSimpleDateFormat("1970-01-01 00:00:00.000000001"),
+      TimestampValue::ParseSimpleDateFormat("1970-01-01 23:59:59.999999999"),
+      TimestampValue::ParseSimpleDateFormat("9999-12-31 23:59:59.999999999")});
+  __int128_t big = static_cast<__int128_t>(1) << 100;
+  TestRadixKeyOrder<Decimal16Value>(ColumnType::CreateDecimalType(38, 2),
+      {Decimal16Value(-big), Decimal16Value(-big + 1), Decimal16Value(-1),
+      Decimal16Value(0), Decimal16Value(1), Decimal16Value(big)});
+  EXPECT_EQ(0, TupleRowLexicalComparator::RadixKeyWords(ColumnType(TYPE_STRING)));
+  EXPECT_EQ(0, TupleRowLexicalComparator::RadixKeyWords(ColumnType(TYPE_DOUBLE)));
+}
+
+} //namespace impala
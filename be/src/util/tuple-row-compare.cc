@@ -109,6 +109,227 @@ int TupleRowLexicalComparator::CompareInterpreted(
   return 0; // fully equivalent key
 }
 
+bool TupleRowLexicalComparator::IsKeyPrefixType(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_DATE:
+    case TYPE_TIMESTAMP:
+    case TYPE_DECIMAL:
+    case TYPE_STRING:
+    case TYPE_VARCHAR:
+    case TYPE_CHAR:
+      return true;
+    default:
+      // Floating point values are not supported because RawValue::Compare() treats
+      // -0.0 and 0.0 as equal and has its own order for NaN.
+      return false;
+  }
+}
+
+/// Returns the bits of the signed integer 'val' as an unsigned integer with the same
+/// order, in the most significant bits of the result.
+template <typename T>
+static inline uint64_t EncodeIntKeyPrefix(T val) {
+  constexpr int SHIFT = (sizeof(uint64_t) - sizeof(T)) * 8;
+  return (static_cast<uint64_t>(val) << SHIFT) ^ (1ULL << 63);
+}
+
+/// Returns the first eight bytes of the string at 'ptr' of length 'len' as a big-endian
+/// integer, padded with zero bytes.
+static inline uint64_t EncodeStringKeyPrefix(const char* ptr, int len) {
+  len = std::min<int>(len, sizeof(uint64_t));
+  if (len <= 0) return 0;
+  uint64_t dst = 0;
+  BitUtil::ByteSwap(&dst, ptr, len);
+  return dst << ((sizeof(uint64_t) - len) * 8);
+}
+
+uint64_t TupleRowLexicalComparator::EncodeKeyPrefix(
+    const void* value, const ColumnType& type, bool is_asc, bool nulls_first) {
+  // The order of NULLs is independent of 'is_asc'. Non-NULL values with the same
+  // encoding as NULL are told apart by Compare().
+  if (value == nullptr) return nulls_first ? 0 : std::numeric_limits<uint64_t>::max();
+  uint64_t result;
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+      result = *reinterpret_cast<const bool*>(value);
+      break;
+    case TYPE_TINYINT:
+      result = EncodeIntKeyPrefix(*reinterpret_cast<const int8_t*>(value));
+      break;
+    case TYPE_SMALLINT:
+      result = EncodeIntKeyPrefix(*reinterpret_cast<const int16_t*>(value));
+      break;
+    case TYPE_INT:
+      result = EncodeIntKeyPrefix(*reinterpret_cast<const int32_t*>(value));
+      break;
+    case TYPE_BIGINT:
+      result = EncodeIntKeyPrefix(*reinterpret_cast<const int64_t*>(value));
+      break;
+    case TYPE_DATE:
+      result = EncodeIntKeyPrefix(reinterpret_cast<const DateValue*>(value)->Value());
+      break;
+    case TYPE_TIMESTAMP: {
+      // The day numbers of valid dates fit in 23 bits and the nanoseconds of a day in 47
+      // bits, of which the 40 most significant ones are kept.
+      const TimestampValue* ts = reinterpret_cast<const TimestampValue*>(value);
+      const uint64_t days = ts->date().day_number();
+      const uint64_t nanos = ts->time().total_nanoseconds();
+      result = (days << 40) | (nanos >> 7);
+      break;
+    }
+    case TYPE_DECIMAL:
+      switch (type.GetByteSize()) {
+        case 4:
+          result = EncodeIntKeyPrefix(
+              reinterpret_cast<const Decimal4Value*>(value)->value());
+          break;
+        case 8:
+          result = EncodeIntKeyPrefix(
+              reinterpret_cast<const Decimal8Value*>(value)->value());
+          break;
+        case 16:
+          // The most significant 64 bits of the value order it like the whole value.
+          result = EncodeIntKeyPrefix(static_cast<int64_t>(
+              reinterpret_cast<const Decimal16Value*>(value)->value() >> 64));
+          break;
+        default:
+          DCHECK(false) << type;
+          return 0;
+      }
+      break;
+    case TYPE_STRING:
+    case TYPE_VARCHAR: {
+      const StringValue* string_value = reinterpret_cast<const StringValue*>(value);
+      result = EncodeStringKeyPrefix(string_value->ptr, string_value->len);
+      break;
+    }
+    case TYPE_CHAR: {
+      // Trailing spaces are ignored by comparisons of CHAR values.
+      const char* ptr = reinterpret_cast<const char*>(value);
+      result = EncodeStringKeyPrefix(ptr, StringValue::UnpaddedCharLength(ptr, type.len));
+      break;
+    }
+    default:
+      DCHECK(false) << "Unsupported key prefix type: " << type;
+      return 0;
+  }
+  return is_asc ? result : ~result;
+}
+
+bool TupleRowLexicalComparator::SupportsRadixKey() const {
+  if (ordering_exprs_.size() > MAX_RADIX_KEYS) return false;
+  int num_words = 0;
+  for (int i = 0; i < ordering_exprs_.size(); ++i) {
+    const int key_words = NumRadixKeyWords(i);
+    if (key_words == 0) return false;
+    num_words += key_words;
+  }
+  return num_words <= MAX_RADIX_KEY_WORDS;
+}
+
+uint64_t TupleRowLexicalComparator::RadixKey(
+    const TupleRow* row, uint64_t* words) const {
+  uint64_t null_flags = 0;
+  for (int i = 0; i < ordering_exprs_.size(); ++i) {
+    const ColumnType& type = ordering_exprs_[i]->type();
+    const void* value = ordering_expr_evals_lhs_[i]->GetValue(row);
+    const bool nulls_first = nulls_first_[i] < 0;
+    if ((value == nullptr) != nulls_first) null_flags |= 1ULL << i;
+    if (value == nullptr) {
+      memset(words, 0, RadixKeyWords(type) * sizeof(uint64_t));
+    } else {
+      EncodeRadixKey(value, type, is_asc_[i], words);
+    }
+    words += RadixKeyWords(type);
+  }
+  return null_flags;
+}
+
+int TupleRowLexicalComparator::RadixKeyWords(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+    case TYPE_SMALLINT:
+    case TYPE_INT:
+    case TYPE_BIGINT:
+    case TYPE_DATE:
+      return 1;
+    case TYPE_TIMESTAMP:
+      return 2;
+    case TYPE_DECIMAL:
+      return type.GetByteSize() == 16 ? 2 : 1;
+    default:
+      return 0;
+  }
+}
+
+/// Returns the signed integer 'val' as an unsigned integer with the same order.
+template <typename T>
+static inline uint64_t EncodeIntRadixKey(T val) {
+  return static_cast<uint64_t>(static_cast<int64_t>(val)) ^ (1ULL << 63);
+}
+
+void TupleRowLexicalComparator::EncodeRadixKey(
+    const void* value, const ColumnType& type, bool is_asc, uint64_t* words) {
+  DCHECK(value != nullptr);
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+      words[0] = *reinterpret_cast<const bool*>(value);
+      break;
+    case TYPE_TINYINT:
+      words[0] = EncodeIntRadixKey(*reinterpret_cast<const int8_t*>(value));
+      break;
+    case TYPE_SMALLINT:
+      words[0] = EncodeIntRadixKey(*reinterpret_cast<const int16_t*>(value));
+      break;
+    case TYPE_INT:
+      words[0] = EncodeIntRadixKey(*reinterpret_cast<const int32_t*>(value));
+      break;
+    case TYPE_BIGINT:
+      words[0] = EncodeIntRadixKey(*reinterpret_cast<const int64_t*>(value));
+      break;
+    case TYPE_DATE:
+      words[0] = EncodeIntRadixKey(reinterpret_cast<const DateValue*>(value)->Value());
+      break;
+    case TYPE_TIMESTAMP: {
+      const TimestampValue* ts = reinterpret_cast<const TimestampValue*>(value);
+      words[0] = ts->date().day_number();
+      words[1] = ts->time().total_nanoseconds();
+      break;
+    }
+    case TYPE_DECIMAL:
+      switch (type.GetByteSize()) {
+        case 4:
+          words[0] = EncodeIntRadixKey(
+              reinterpret_cast<const Decimal4Value*>(value)->value());
+          break;
+        case 8:
+          words[0] = EncodeIntRadixKey(
+              reinterpret_cast<const Decimal8Value*>(value)->value());
+          break;
+        case 16: {
+          const __int128_t val = reinterpret_cast<const Decimal16Value*>(value)->value();
+          words[0] = EncodeIntRadixKey(static_cast<int64_t>(val >> 64));
+          words[1] = static_cast<uint64_t>(val);
+          break;
+        }
+        default:
+          DCHECK(false) << type;
+      }
+      break;
+    default:
+      DCHECK(false) << "Unsupported radix key type: " << type;
+  }
+  if (!is_asc) {
+    for (int i = 0; i < RadixKeyWords(type); ++i) words[i] = ~words[i];
+  }
+}
+
 // Codegens an unrolled version of TupleRowLexicalComparator::Compare(). Uses codegen'd
 // key exprs and injects nulls_first_ and is_asc_ values.
 //
@@ -225,6 +225,65 @@ class TupleRowLexicalComparator : public TupleRowComparator {
     DCHECK_EQ(is_asc_.size(), ordering_exprs_.size());
   }
 
+  /// Returns true if KeyPrefix() supports the type of the first ordering expr.
+  bool SupportsKeyPrefix() const {
+    return IsKeyPrefixType(ordering_exprs_[0]->type());
+  }
+
+  /// Returns an order-preserving prefix of the first ordering key of 'row': if
+  /// KeyPrefix(a) < KeyPrefix(b), then Compare(a, b) < 0. Rows with equal prefixes must
+  /// be compared with Compare(). Only valid if SupportsKeyPrefix() and after Open().
+  uint64_t KeyPrefix(const TupleRow* row) const {
+    return EncodeKeyPrefix(ordering_expr_evals_lhs_[0]->GetValue(row),
+        ordering_exprs_[0]->type(), is_asc_[0], nulls_first_[0] < 0);
+  }
+
+  /// Returns true if EncodeKeyPrefix() supports values of 'type'.
+  static bool IsKeyPrefixType(const ColumnType& type);
+
+  /// Encodes 'value' of 'type', or NULL if 'value' is nullptr, into an unsigned integer
+  /// such that comparing the integers of two values orders them like the sort order
+  /// given by 'is_asc' and 'nulls_first'. Values of which the encodings are equal may
+  /// still differ, e.g. strings with the same first eight bytes.
+  static uint64_t EncodeKeyPrefix(
+      const void* value, const ColumnType& type, bool is_asc, bool nulls_first);
+
+  /// The most ordering exprs and 64-bit words that RadixKey() encodes.
+  static constexpr int MAX_RADIX_KEYS = 2;
+  static constexpr int MAX_RADIX_KEY_WORDS = 2;
+
+  /// Returns true if RadixKey() can encode the ordering exprs: there are at most
+  /// MAX_RADIX_KEYS of them, their types are supported by EncodeRadixKey() and together
+  /// they take at most MAX_RADIX_KEY_WORDS words.
+  bool SupportsRadixKey() const;
+
+  /// Returns the number of ordering exprs.
+  int num_keys() const { return ordering_exprs_.size(); }
+
+  /// Returns the number of words that RadixKey() encodes the 'i'th ordering expr in.
+  int NumRadixKeyWords(int i) const { return RadixKeyWords(ordering_exprs_[i]->type()); }
+
+  /// Encodes the ordering exprs of 'row' in 'words', each in NumRadixKeyWords() words
+  /// with the most significant word first. Returns the NULL flags of the exprs, with
+  /// bit 'i' set for the 'i'th expr if its rows sort after those of the other flag
+  /// value, i.e. if it is NULL and NULLs sort last or it is not NULL and NULLs sort
+  /// first. The words of NULL values are 0. Ordering rows by the flag and the words of
+  /// each expr in turn, comparing the words as unsigned integers, is the same order as
+  /// Compare(), and rows with equal flags and words compare as equal. Only valid if
+  /// SupportsRadixKey() and after Open().
+  uint64_t RadixKey(const TupleRow* row, uint64_t* words) const;
+
+  /// Returns the number of words that EncodeRadixKey() encodes values of 'type' in, or 0
+  /// if it does not support 'type'.
+  static int RadixKeyWords(const ColumnType& type);
+
+  /// Encodes the non-NULL 'value' of 'type' in RadixKeyWords(type) words at 'words',
+  /// most significant first, such that comparing the words of two values as unsigned
+  /// integers orders them like the sort order given by 'is_asc'. Unlike
+  /// EncodeKeyPrefix(), the encoding is exact: values with equal words are equal.
+  static void EncodeRadixKey(
+      const void* value, const ColumnType& type, bool is_asc, uint64_t* words);
+
  private:
   const std::vector<bool>& is_asc_;
   const std::vector<int8_t>& nulls_first_;
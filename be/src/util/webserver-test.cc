@@ -545,6 +545,45 @@ TEST(Webserver, Options) {
       == string::npos);
 }
 
+void StreamingCallback(int num_lines, const Webserver::WebRequest& req,
+    StreamingResponse* response) {
+  for (int i = 0; i < num_lines; ++i) {
+    (*response->stream()) << "line-" << i << "\n";
+    response->Flush();
+  }
+}
+
+TEST(Webserver, StreamingTest) {
+  const string SMALL_PATH = "/streaming-small";
+  const string LARGE_PATH = "/streaming-large";
+  MetricGroup metrics("webserver-test");
+  Webserver webserver("", FLAGS_webserver_port, &metrics);
+  webserver.RegisterStreamingUrlCallback(
+      SMALL_PATH, PLAIN, bind<void>(StreamingCallback, 10, _1, _2));
+  // About 200KB of output, which is sent in several chunks.
+  webserver.RegisterStreamingUrlCallback(
+      LARGE_PATH, PLAIN, bind<void>(StreamingCallback, 20000, _1, _2));
+  ASSERT_OK(webserver.Start());
+
+  // Output that fits into a single chunk is sent as a regular response.
+  stringstream small_contents;
+  ASSERT_OK(HttpGet("localhost", FLAGS_webserver_port, SMALL_PATH, &small_contents));
+  EXPECT_NE(string::npos, small_contents.str().find("Content-Length: "));
+  EXPECT_EQ(string::npos, small_contents.str().find("Transfer-Encoding: chunked"));
+  EXPECT_NE(string::npos, small_contents.str().find("line-9\n"));
+
+  stringstream large_contents;
+  ASSERT_OK(HttpGet("localhost", FLAGS_webserver_port, LARGE_PATH, &large_contents));
+  const string& large = large_contents.str();
+  EXPECT_EQ(string::npos, large.find("Content-Length: "));
+  EXPECT_NE(string::npos, large.find("Transfer-Encoding: chunked"));
+  // Chunks only end where the callback flushed the output, i.e. after a line.
+  EXPECT_NE(string::npos, large.find("\nline-0\n"));
+  EXPECT_NE(string::npos, large.find("\nline-19999\n"));
+  // The response ends with the empty last chunk.
+  EXPECT_EQ("\r\n0\r\n\r\n", large.substr(large.size() - 7));
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   InitCommonRuntime(argc, argv, false, TestInfo::BE_TEST);
@@ -19,6 +19,7 @@
 
 #include <signal.h>
 #include <stdio.h>
+#include <string.h>
 #include <fstream>
 #include <map>
 #include <string>
@@ -164,6 +165,9 @@ static const char* ERROR_KEY = "__error_msg__";
 
 static const char* CRLF = "\r\n";
 
+// Amount of output of a StreamingResponse that is buffered before it is sent as a chunk.
+static const int64_t STREAMING_CHUNK_SIZE = 64 * 1024;
+
 // Returns $IMPALA_HOME if set, otherwise /tmp/impala_www
 const char* GetDefaultDocumentRoot() {
   stringstream ss;
@@ -210,18 +214,25 @@ string HttpStatusCodeToString(HttpStatusCode code) {
   return "";
 }
 
+// Appends the status line and the headers of a response to 'out', up to and excluding
+// the empty line that ends the headers.
+void AppendResponseHeaders(const string& response_code_line, const string& content_type,
+    const vector<string>& header_lines, std::ostream* out) {
+  *out << "HTTP/1.1 " << response_code_line << CRLF;
+  for (const auto& h : header_lines) {
+    *out << h << CRLF;
+  }
+  *out << "X-Frame-Options: " << FLAGS_webserver_x_frame_options << CRLF;
+  *out << "Content-Type: " << content_type << CRLF;
+}
+
 void SendResponse(struct sq_connection* connection, const string& response_code_line,
     const string& content_type, const string& content,
     const vector<string>& header_lines) {
   // Buffer the output and send it in a single call to sq_write in order to avoid
   // triggering an interaction between Nagle's algorithm and TCP delayed acks.
   std::ostringstream oss;
-  oss << "HTTP/1.1 " << response_code_line << CRLF;
-  for (const auto& h : header_lines) {
-    oss << h << CRLF;
-  }
-  oss << "X-Frame-Options: " << FLAGS_webserver_x_frame_options << CRLF;
-  oss << "Content-Type: " << content_type << CRLF;
+  AppendResponseHeaders(response_code_line, content_type, header_lines, &oss);
   oss << "Content-Length: " << content.size() << CRLF;
   oss << CRLF;
   oss << content;
@@ -751,6 +762,19 @@ sq_callback_result_t Webserver::BeginRequestCallback(struct sq_connection* conne
     }
   }
 
+  if (url_handler->is_streaming()) {
+    // Chunked transfer encoding is not supported by HTTP/1.0 clients.
+    bool chunked = request_info->http_version != nullptr
+        && strcmp(request_info->http_version, "1.0") != 0;
+    StreamingResponse streaming_response(connection, chunked,
+        Webserver::GetMimeType(url_handler->content_type()), &response_headers);
+    url_handler->streaming_callback()(req, &streaming_response);
+    streaming_response.Finish();
+    VLOG(3) << "Streaming page " << request_info->uri << " took "
+            << PrettyPrinter::Print(sw.ElapsedTime(), TUnit::TIME_NS);
+    return SQ_HANDLED_OK;
+  }
+
   // The output of this page is accumulated into this stringstream.
   stringstream output;
   if (!url_handler->use_templates()) {
@@ -944,6 +968,58 @@ void Webserver::RegisterUrlCallback(const string& path, const RawUrlCallback& ca
   url_handlers_.insert(make_pair(path, UrlHandler(callback)));
 }
 
+void Webserver::RegisterStreamingUrlCallback(const string& path,
+    ContentType content_type, const StreamingUrlCallback& callback) {
+  upgrade_lock<shared_mutex> lock(url_handlers_lock_);
+  upgrade_to_unique_lock<shared_mutex> writer_lock(lock);
+  DCHECK(url_handlers_.find(path) == url_handlers_.end())
+      << "Duplicate Url handler for: " << path;
+
+  url_handlers_.insert(make_pair(path, UrlHandler(callback, content_type)));
+}
+
+void StreamingResponse::Flush() {
+  if (!chunked_ || buffer_.tellp() < STREAMING_CHUNK_SIZE) return;
+  SendChunk();
+}
+
+void StreamingResponse::Finish() {
+  if (!headers_sent_) {
+    // All output fits into one chunk, or the response is not chunked.
+    SendResponse(connection_, HttpStatusCodeToString(HttpStatusCode::Ok), mime_type_,
+        buffer_.str(), *header_lines_);
+    return;
+  }
+  SendChunk();
+  // The last chunk is empty.
+  Write(Substitute("0$0$0", CRLF));
+}
+
+void StreamingResponse::SendChunk() {
+  const string data = buffer_.str();
+  buffer_.str("");
+  if (data.empty()) return;
+  std::ostringstream oss;
+  if (!headers_sent_) {
+    AppendResponseHeaders(HttpStatusCodeToString(HttpStatusCode::Ok), mime_type_,
+        *header_lines_, &oss);
+    oss << "Transfer-Encoding: chunked" << CRLF;
+    oss << CRLF;
+    headers_sent_ = true;
+  }
+  // Send the chunk in a single call to sq_write, see SendResponse().
+  oss << std::hex << data.size() << CRLF << data << CRLF;
+  Write(oss.str());
+}
+
+void StreamingResponse::Write(const string& data) {
+  if (failed_) return;
+  if (sq_write(connection_, data.c_str(), data.length())
+      != static_cast<int64_t>(data.length())) {
+    failed_ = true;
+  }
+}
+
 const string Webserver::GetMimeType(const ContentType& content_type) {
   switch (content_type) {
     case HTML: return "text/html; charset=UTF-8";
@@ -18,7 +18,9 @@
 #pragma once
 
 #include <map>
+#include <sstream>
 #include <string>
+#include <vector>
 #include <boost/function.hpp>
 #include <boost/thread/pthread/shared_mutex.hpp>
 #include <rapidjson/fwd.h>
@@ -45,6 +47,59 @@ enum ContentType {
   JSON
 };
 
+/// Response of a Webserver::StreamingUrlCallback. The callback writes its output to
+/// stream() and calls Flush() regularly, e.g. after every item of a list. Once enough
+/// output is buffered, Flush() sends it to the client as a chunk of a response with
+/// chunked transfer encoding, so that a large response is never kept in memory as a
+/// whole. Output that fits into a single chunk is sent as a regular response.
+///
+/// Flush() may block on a slow client, so callbacks must not hold locks when calling it.
+/// Streamed responses always have the status code 200, so callbacks report errors as
+/// part of their output.
+class StreamingResponse {
+ public:
+  /// The stream that the callback writes its output to.
+  std::stringstream* stream() { return &buffer_; }
+
+  /// Sends the buffered output to the client if it exceeds the chunk size.
+  void Flush();
+
+  /// True if sending output to the client failed, e.g. because it closed the
+  /// connection. Further output is discarded, so callbacks may stop producing it.
+  bool failed() const { return failed_; }
+
+ private:
+  friend class Webserver;
+
+  /// If 'chunked' is false, e.g. for HTTP/1.0 clients, all output is buffered and sent
+  /// by Finish().
+  StreamingResponse(struct sq_connection* connection, bool chunked,
+      const std::string& mime_type, const std::vector<std::string>* header_lines)
+    : connection_(connection), chunked_(chunked), mime_type_(mime_type),
+      header_lines_(header_lines) {}
+
+  /// Sends the remaining output and ends the response.
+  void Finish();
+
+  /// Sends the buffered output as a chunk, preceded by the headers if they were not sent
+  /// yet.
+  void SendChunk();
+
+  /// Writes 'data' to the connection and sets 'failed_' if that fails.
+  void Write(const std::string& data);
+
+  struct sq_connection* const connection_;
+  const bool chunked_;
+  const std::string mime_type_;
+  const std::vector<std::string>* const header_lines_;
+
+  /// Output that was not sent yet.
+  std::stringstream buffer_;
+
+  bool headers_sent_ = false;
+  bool failed_ = false;
+};
+
 /// Wrapper class for the Squeasel web server library. Clients may register callback
 /// methods which produce Json documents which are rendered via a template file to either
 /// HTML or text.
@@ -72,6 +127,8 @@ class Webserver {
       UrlCallback;
   typedef boost::function<void (const WebRequest& req, std::stringstream* output,
       HttpStatusCode* response)> RawUrlCallback;
+  typedef boost::function<void (const WebRequest& req, StreamingResponse* response)>
+      StreamingUrlCallback;
 
   /// Any callback may add a member to their Json output with key ENABLE_RAW_HTML_KEY;
   /// this causes the result of the template rendering process to be sent to the browser
@@ -119,6 +176,12 @@ class Webserver {
   /// produce text should use UrlCallback.
   void RegisterUrlCallback(const std::string& path, const RawUrlCallback& callback);
 
+  /// Register a url callback that streams its output of type 'content_type' to the
+  /// client while producing it, see StreamingResponse. This should be used for URLs
+  /// whose output can be too large to be rendered in memory as a whole.
+  void RegisterStreamingUrlCallback(const std::string& path, ContentType content_type,
+      const StreamingUrlCallback& callback);
+
   /// True if serving all traffic over SSL, false otherwise
   bool IsSecure() const;
 
@@ -149,10 +212,17 @@ class Webserver {
         : is_on_nav_bar_(false), use_templates_(false),
           raw_callback_(cb) { }
 
+    UrlHandler(const StreamingUrlCallback& cb, ContentType content_type)
+        : is_on_nav_bar_(false), use_templates_(false), streaming_callback_(cb),
+          content_type_(content_type) { }
+
     bool is_on_nav_bar() const { return is_on_nav_bar_; }
     bool use_templates() const { return use_templates_; }
     const UrlCallback& callback() const { return template_callback_; }
     const RawUrlCallback& raw_callback() const { return raw_callback_; }
+    bool is_streaming() const { return !streaming_callback_.empty(); }
+    const StreamingUrlCallback& streaming_callback() const { return streaming_callback_; }
+    ContentType content_type() const { return content_type_; }
     const std::string& template_filename() const { return template_filename_; }
 
    private:
@@ -169,6 +239,12 @@ class Webserver {
     /// Callback to produce a raw bytestream.
     RawUrlCallback raw_callback_;
 
+    /// Callback to stream the output, if set. Used instead of 'raw_callback_'.
+    StreamingUrlCallback streaming_callback_;
+
+    /// Content type of the output of 'streaming_callback_'.
+    ContentType content_type_ = PLAIN;
+
     /// Path to the file that contains the template to render, relative to the webserver's
     /// document root.
     std::string template_filename_;
@@ -247,9 +247,13 @@ visible_functions = [
   [['now', 'current_timestamp'], 'TIMESTAMP', [], '_ZN6impala18TimestampFunctions3NowEPN10impala_udf15FunctionContextE'],
   [['utc_timestamp'], 'TIMESTAMP', [], '_ZN6impala18TimestampFunctions12UtcTimestampEPN10impala_udf15FunctionContextE'],
   [['from_utc_timestamp'], 'TIMESTAMP', ['TIMESTAMP', 'STRING'],
-   "impala::TimestampFunctions::FromUtc"],
+   '_ZN6impala18TimestampFunctions7FromUtcEPN10impala_udf15FunctionContextERKNS1_12TimestampValERKNS1_9StringValE',
+   '_ZN6impala18TimestampFunctions25TimezoneConversionPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
+   '_ZN6impala18TimestampFunctions23TimezoneConversionCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
   [['to_utc_timestamp'], 'TIMESTAMP', ['TIMESTAMP', 'STRING'],
-   "impala::TimestampFunctions::ToUtc"],
+   '_ZN6impala18TimestampFunctions5ToUtcEPN10impala_udf15FunctionContextERKNS1_12TimestampValERKNS1_9StringValE',
+   '_ZN6impala18TimestampFunctions25TimezoneConversionPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
+   '_ZN6impala18TimestampFunctions23TimezoneConversionCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
   [['timeofday'], 'STRING', [],"impala::TimestampFunctions::TimeOfDay"],
   [['timestamp_cmp'], 'INT', ['TIMESTAMP', 'TIMESTAMP'],
    "impala::TimestampFunctions::TimestampCmp"],
@@ -554,6 +558,14 @@ visible_functions = [
    'impala::StringFunctions::RegexpReplace',
    '_ZN6impala15StringFunctions13RegexpPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
    '_ZN6impala15StringFunctions11RegexpCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
+  [['like_any'], 'BOOLEAN', ['STRING', 'STRING', '...'],
+   'impala::LikePredicate::LikeAny',
+   '_ZN6impala13LikePredicate14LikeAnyPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
+   '_ZN6impala13LikePredicate9LikeCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
+  [['ilike_any'], 'BOOLEAN', ['STRING', 'STRING', '...'],
+   'impala::LikePredicate::LikeAny',
+   '_ZN6impala13LikePredicate15ILikeAnyPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
+   '_ZN6impala13LikePredicate9LikeCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
   [['regexp_like'], 'BOOLEAN', ['STRING', 'STRING'],
    'impala::LikePredicate::Regex',
    '_ZN6impala13LikePredicate12RegexPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
@@ -589,7 +601,9 @@ visible_functions = [
    '_ZN6impala15StringFunctions11TrimPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
    '_ZN6impala15StringFunctions9TrimCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
   [['get_json_object'], 'STRING', ['STRING', 'STRING'],
-   'impala::StringFunctions::GetJsonObject'],
+   'impala::StringFunctions::GetJsonObject',
+   '_ZN6impala15StringFunctions20GetJsonObjectPrepareEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE',
+   '_ZN6impala15StringFunctions18GetJsonObjectCloseEPN10impala_udf15FunctionContextENS2_18FunctionStateScopeE'],
   [['levenshtein', 'le_dst'], 'INT', ['STRING', 'STRING'],
    '_ZN6impala15StringFunctions11LevenshteinEPN10impala_udf15FunctionContextERKNS1_9StringValES6_'],
   [['damerau_levenshtein', 'dle_dst'], 'INT', ['STRING', 'STRING'],
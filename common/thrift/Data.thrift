@@ -53,4 +53,28 @@ struct TColumnData {
   7: optional list<double> double_vals;
   8: optional list<string> string_vals;
   9: optional list<binary> binary_vals;
+
+  // Alternatively, the column can be in the Arrow columnar layout, which the scan node
+  // copies without per-value dispatch. The column is in this layout if 'arrow_values' is
+  // set. Then the fields above are ignored, 'is_null' may be empty and
+  // TRowBatch.num_rows must be set. Either all or no columns of a row batch must be in
+  // this layout. Values are little-endian and there is a value for every row, including
+  // null rows. The values are:
+  // - BOOLEAN: a bitmap like 'arrow_validity'
+  // - TINYINT, SMALLINT, INT, BIGINT: 1, 2, 4 and 8 byte integers
+  // - FLOAT, DOUBLE: 4 and 8 byte floating point numbers
+  // - DATE: 4 byte number of days since the epoch
+  // - TIMESTAMP: 8 byte number of microseconds since the epoch
+  // - DECIMAL: 16 byte unscaled values
+  // - STRING: the concatenated bytes of the values, see 'arrow_offsets'
+  // https://arrow.apache.org/docs/format/Columnar.html
+  10: optional binary arrow_values;
+
+  // Bitmap with one bit per row, least significant bit first, that is set for non-null
+  // values. If not set, all values are non-null.
+  11: optional binary arrow_validity;
+
+  // For STRING columns, TRowBatch.num_rows + 1 4 byte offsets into 'arrow_values'. The
+  // value of row i is the bytes between offsets i and i + 1.
+  12: optional binary arrow_offsets;
 }
@@ -131,6 +131,12 @@ struct TJoinBuildSink {
   // If true, join build sharing is enabled and, if multiple instances of a join node are
   // scheduled on the same backend, they will share the join build on that backend.
   6: optional bool share_build
+
+  // Same as THashJoinNode.is_switchable_broadcast. Only set for hash join builds.
+  7: optional bool is_switchable_broadcast
+
+  // Same as THashJoinNode.dedup_build_keys. Only set for hash join builds.
+  8: optional bool dedup_build_keys
 }
 
 struct TPlanRootSink {
@@ -62,6 +62,21 @@ struct THiveUdfExecutorCtorParams {
   // NULL.
   6: required i64 output_null_ptr
   7: required i64 output_buffer_ptr
+
+  // Set if the BE evaluates the UDF over many rows with one call to evaluateBatch().
+  // The buffers have room for batch_capacity rows. The values of the i-th input are
+  // a column that starts at batch_input_buffer_ptr[input_byte_offsets[i] *
+  // batch_capacity] with input_byte_sizes[i] bytes per row, and its nulls are a column
+  // of one byte per row at batch_input_nulls_ptr[i * batch_capacity]. The result of
+  // row r is written to batch_output_buffer_ptr[r * output_byte_size] and its null
+  // indicator to batch_output_null_ptr[r].
+  8: optional i32 batch_capacity
+  9: optional list<i32> input_byte_sizes
+  10: optional i64 batch_input_nulls_ptr
+  11: optional i64 batch_input_buffer_ptr
+  12: optional i64 batch_output_null_ptr
+  13: optional i64 batch_output_buffer_ptr
+  14: optional i32 output_byte_size
 }
 
 // Arguments to getTableNames, which returns a list of tables that match an
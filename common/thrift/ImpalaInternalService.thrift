@@ -56,6 +56,18 @@ struct TDebugOptions {
 struct TRuntimeFilterSource {
   1: required Types.TPlanNodeId src_node_id
   2: required i32 filter_id
+
+  // If set, the backend sends its update of the filter to this intermediate aggregator
+  // instead of the coordinator. IP address + port of the KRPC service.
+  3: optional Types.TNetworkAddress aggregator_krpc_address
+
+  // Hostname of the intermediate aggregator. Set iff 'aggregator_krpc_address' is set.
+  4: optional string aggregator_hostname
+
+  // If set, the backend is an intermediate aggregator that merges the updates of the
+  // filter from this many other backends with its own update before it sends the result
+  // to the coordinator.
+  5: optional i32 num_aggregated_updates
 }
 
 // The Thrift portion of the execution parameters of a single fragment instance. Every
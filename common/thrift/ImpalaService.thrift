@@ -661,6 +661,355 @@ enum TImpalaQueryOptions {
   //     LEADER_ONLY     - Select the LEADER replica.
   //     CLOSEST_REPLICA - Select the closest replica to the client (default).
   KUDU_REPLICA_SELECTION = 127
+
+  // Minimum number of consecutive rows that must be filtered out by conjuncts and
+  // runtime filters before the Parquet scanner skips decoding the remaining
+  // (non-predicate) columns for those rows. Predicate columns are always decoded
+  // first. Set to -1 to disable late materialization.
+  PARQUET_LATE_MATERIALIZATION_THRESHOLD = 128
+
+  // Number of compressed data pages per column chunk that the Parquet scanner
+  // decompresses ahead of time on the parquet decompression thread pool, so that
+  // decompression overlaps with decoding. Set to 0 to decompress pages synchronously on
+  // the scanner thread. Valid values are 0 to 16.
+  PARQUET_DECOMPRESS_AHEAD_PAGES = 129
+
+  // Indicates whether to use the split block Bloom filters of Parquet column chunks
+  // to skip row groups that cannot match equality and IN predicates.
+  PARQUET_BLOOM_FILTERING = 130
+
+  // If true, the Parquet table writer compresses the data and dictionary pages of
+  // the columns on a shared pool of threads, while the sink thread keeps encoding rows
+  // and writing the pages in order. The written files are identical to the ones written
+  // without this option.
+  PARQUET_PARALLEL_ENCODING = 131
+
+  // If true, and parquet_dictionary_filtering is also enabled, the Parquet scanner
+  // evaluates the single-column conjuncts on every dictionary entry of row groups that
+  // could not be skipped. Rows whose dictionary index refers to a rejected entry are
+  // filtered before their value is materialized.
+  PARQUET_DICTIONARY_CODE_FILTERING = 132
+
+  // If true, data pages that the Parquet writer does not dictionary encode use
+  // DELTA_BINARY_PACKED for INT32 and INT64 columns, DELTA_BYTE_ARRAY for strings and
+  // BYTE_STREAM_SPLIT for FLOAT and DOUBLE columns instead of PLAIN, for pages where that
+  // is not larger. Older readers cannot read files written with this option.
+  PARQUET_FALLBACK_ENCODINGS = 133
+
+  // If true and late materialization is used, the Parquet scanner evaluates runtime
+  // filters on single integer key columns directly on the decoded values of those
+  // columns, before the other predicate columns are read. Those are then only read for
+  // the rows that pass the runtime filters.
+  PARQUET_EARLY_RUNTIME_FILTERING = 134
+
+  // If true, the ORC scanner uses the stripe statistics of ORC files to skip stripes
+  // that cannot contain rows passing the arrived min-max runtime filters. The planner
+  // only assigns min-max filters to ORC scans if this is true and
+  // MINMAX_FILTER_THRESHOLD is above 0.
+  ORC_READ_STATISTICS = 135
+
+  // If true, the ORC scanner issues asynchronous reads of all the selected streams of a
+  // stripe when it starts reading the stripe, and serves the reads of the ORC library from
+  // the prefetched buffers, which overlaps I/O with decoding.
+  ORC_ASYNC_READ = 136
+
+  // If true, the text scanner decompresses ZSTD files with multiple frames and BGZF gzip
+  // files several frames at a time on a shared pool of threads, instead of decompressing
+  // the file as a single stream on the scanner thread. Files with another layout are
+  // decompressed as before.
+  TEXT_PARALLEL_DECOMPRESSION = 137
+
+  // If true, the text scanner converts the fields of a batch of rows one column at a
+  // time with specialized kernels for integer, decimal and timestamp columns, instead of
+  // one row at a time with the codegen'd or interpreted WriteCompleteTuple().
+  TEXT_BATCHED_CONVERSION = 138
+
+  // If true, the Avro scanner reads several data blocks of a scan range ahead and
+  // decodes them in parallel on the avro decoding thread pool, so that a large file can
+  // use several cores.
+  AVRO_PARALLEL_DECODING = 139
+
+  // If true, Kudu scanners request batches in columnar layout from the tablet servers
+  // and copy whole column buffers into the tuples of the row batch, instead of converting
+  // the rows one at a time.
+  KUDU_COLUMNAR_SCAN = 140
+
+  // If greater than 0, the Parquet scanner reads the column chunks of a row group that
+  // are separated by gaps of at most this many bytes with a single request, which saves
+  // round trips on object stores for narrow projections. The bytes in the gaps are read
+  // and discarded. 0 disables coalescing. Accepts memory spec values, e.g. '64kb'.
+  PARQUET_COALESCE_GAP_SIZE = 141
+
+  // The share of disk and remote I/O bandwidth that the scans of this query get when
+  // other queries read from the same queue. The I/O threads of each queue serve
+  // queries in proportion to their weights, e.g. a query with weight 4 reads up to four
+  // times as many bytes per round as a query with weight 1. Admins can set it per
+  // resource pool through the pool's default query options. Valid values are in
+  // [1, 100].
+  IO_SCHEDULING_WEIGHT = 142
+
+  // The maximum number of distinct values of an IN-list runtime filter. If greater
+  // than 0, the planner also generates IN-list runtime filters, which hold the exact
+  // set of join keys, for joins whose build side is estimated to have at most this
+  // many rows. A filter that gets more values than this lets all rows pass. 0 disables
+  // IN-list runtime filters.
+  RUNTIME_IN_LIST_FILTER_ENTRY_LIMIT = 143
+
+  // If greater than 1, the updates of a partitioned join runtime filter from up to this
+  // many backends are merged by one of these backends, an intermediate aggregator,
+  // which sends a single update to the coordinator. This reduces the number of filter
+  // updates the coordinator receives from large clusters. 0 or 1 sends the update of
+  // every backend to the coordinator.
+  MAX_NUM_FILTERS_AGGREGATED_PER_HOST = 144
+
+  // If non-zero, the max number of bytes of the build input of a broadcast hash join
+  // whose distribution mode was chosen by the planner rather than a hint. If the build of
+  // such a join exceeds this limit at runtime, the query is cancelled and planned again
+  // with partitioned joins instead of broadcast joins, unless rows were already returned.
+  // This protects against broadcast joins chosen from underestimated build sizes. 0 or -1
+  // means this has no effect.
+  RUNTIME_BROADCAST_BYTES_LIMIT = 145
+
+  // If true, a streaming preaggregation that stops growing its hash tables aggregates
+  // the rows that do not fit into them in a small, fixed size first-level table that
+  // stays in the L2 cache, instead of passing each row through. A partial aggregate is
+  // passed through when another key evicts it from the table. Only used for grouping
+  // keys and aggregate results of fixed length.
+  PREAGG_FIRST_LEVEL_TABLE = 146
+
+  // A grouping aggregation sorts a spilled partition on the grouping keys and
+  // aggregates it in one streaming pass over the sorted rows, instead of repartitioning
+  // it again, if the partition does not fit in memory and was already repartitioned at
+  // least this many times. This bounds the memory and the number of times that the
+  // spilled rows are read and written for inputs that do not shrink when they are
+  // repartitioned, e.g. because of skew. -1 disables sorting, so spilled partitions are
+  // only repartitioned.
+  AGG_SPILL_SORT_LEVEL = 147
+
+  // If true, a top-n (ORDER BY with LIMIT) directly above a scan of a table produces a
+  // min-max runtime filter on its first ordering expression for that scan. The filter is
+  // published once the top-n holds LIMIT + OFFSET rows, with the bound of its worst row,
+  // so that the scan can skip row groups, pages and rows that cannot be in the result.
+  // Only applies if the first ordering expression is an integer, DATE or TIMESTAMP slot
+  // and NULLs sort last.
+  TOPN_RUNTIME_FILTER = 148
+
+  // If true, sorts compute an order-preserving 8 byte prefix of the first ordering
+  // expression of every row before sorting a run in memory, and only compare the full
+  // rows if their prefixes are equal. Applies to lexical sorts whose first ordering
+  // expression is an integer, boolean, decimal, date, timestamp or string. The merges
+  // of sorted runs and of merging exchanges also cache the prefix of the current row of
+  // each input.
+  SORT_KEY_PREFIX = 149
+
+  // The number of threads that sort each in-memory run of a sort. With the default of
+  // 1, the runs are sorted by the fragment instance thread. With a larger value, large
+  // runs are partitioned into that many ranges, which are sorted in parallel on the
+  // process-wide pool of --num_sort_threads threads. Valid values are 1 to 64.
+  SORT_RUN_THREADS = 150
+
+  // If true, sorts with one or two ordering expressions of integer, boolean, date,
+  // timestamp or decimal types sort their in-memory runs with a least significant digit
+  // radix sort of the encoded keys instead of a quicksort. NULLs are ordered as a
+  // separate digit of each key.
+  SORT_RADIX = 151
+
+  // If true, select nodes and the Parquet scanner evaluate their conjuncts over many
+  // rows at a time, one conjunct after the other. Comparisons of a slot with a constant
+  // and IS [NOT] NULL predicates on a slot are evaluated by loops over the slot values,
+  // other conjuncts one row at a time.
+  BATCH_CONJUNCT_EVALUATION = 152
+
+  // If true, disjunctions of LIKE or ILIKE predicates with constant patterns on the same
+  // string expression are rewritten to a single like_any() or ilike_any() call, which
+  // searches for all of the '%<literal>%' patterns in one pass over the value.
+  FUSE_LIKE_DISJUNCTS = 153
+
+  // If true and async_codegen is true, the codegen module is first compiled without
+  // optimization passes at a low code generation level, and its functions replace the
+  // interpreted code as soon as that finishes. The module is then optimized and compiled
+  // as usual, and the optimized functions replace the fast ones when they are ready.
+  ASYNC_CODEGEN_FAST_TIER = 154
+
+  // If true, a fragment whose expressions can all be interpreted skips optimizing and
+  // compiling its codegen module if the estimated compile time, based on the modules
+  // that the impalad compiled before, exceeds the estimated time that codegen saves on
+  // the rows that the planner expects the fragment to process.
+  ADAPTIVE_CODEGEN = 155
+
+  // If true, exchange senders choose per row batch whether to compress it with LZ4,
+  // with ZSTD or not at all, based on the measured compression ratio and time of each
+  // codec and the measured network throughput to the receivers. If false, row batches
+  // are always LZ4 compressed if that makes them smaller.
+  ADAPTIVE_EXCHANGE_COMPRESSION = 156
+
+  // If true, a hash partitioning exchange sender buffers the rows for all its
+  // destinations in one row batch of up to --data_stream_sender_shared_buffer_size bytes
+  // instead of one row batch per destination, and serializes each destination's rows when
+  // that batch is full. This bounds the memory of senders with many destinations, at the
+  // cost of sending smaller row batches.
+  SHARED_EXCHANGE_BUFFER = 157
+
+  // Maximum bytes of row batches that the receiver of a non-merging exchange spills to
+  // disk once its buffer limit is reached, instead of blocking its senders. The spilled
+  // batches are returned to the exchange after the buffered ones, so the order in which
+  // rows arrive from one sender is not preserved. Once this limit is reached, senders are
+  // blocked as before. 0 disables spilling.
+  EXCHANGE_MAX_SPILLED_MEM = 158
+
+  // If greater than 0, a broadcast exchange sender with more receivers than this sends
+  // each row batch to only this many receivers, which relay the serialized batch to the
+  // others in a tree with this fanout without deserializing it. This bounds the network
+  // traffic of each sender and relaying backend by the fanout instead of the number of
+  // receivers, at the cost of the latency of the tree's depth. 0 disables relaying.
+  BROADCAST_RELAY_FANOUT = 159
+
+  // If true, exchange senders hand row batches to receivers in the same impalad
+  // through the data stream manager instead of sending them in a loopback RPC. The
+  // batches for such receivers are not compressed, and the sender waits while the
+  // receiver's buffer is full, which is when the RPC would otherwise be deferred.
+  LOCAL_EXCHANGE_SHORTCUT = 160
+
+  // If greater than 0, a hash partitioning exchange sender samples the partition hash of
+  // every n-th row into a small heavy-hitter sketch and reports the hashes that make up
+  // the largest shares of its rows, with the receivers they are sent to, in its profile.
+  // This shows which keys make a receiver of a skewed exchange the critical path. 0
+  // disables sampling.
+  EXCHANGE_SKEW_SAMPLE_INTERVAL = 161
+
+  // If true, exchange senders serialize row batches with a single tuple per row and no
+  // collection slots column by column before compressing them, instead of tuple by
+  // tuple. The columnar layout usually compresses better, at the cost of rebuilding the
+  // tuples on the receiver.
+  EXCHANGE_COLUMNAR_BATCHES = 162
+
+  // If greater than 0, the scheduler takes the load of the executors into account when
+  // assigning scan ranges. A fully loaded executor host, as seen by admission control
+  // through its admission slots in use and memory reserved, is ranked as if this many
+  // bytes of scan ranges were already assigned to it. Less loaded hosts get a
+  // proportional share. Locality and the remote executor candidates from the hash ring
+  // are still respected. 0 disables load-aware assignment.
+  SCHEDULER_LOAD_PENALTY_BYTES = 163
+
+  // If greater than 0 and RETRY_FAILED_QUERIES is true, the coordinator retries a query
+  // whose scan fragment instance on some executor is still running after this many
+  // times the median completion time of the finished instances of the same fragment.
+  // The straggling executor is excluded from the retry, just like an executor that
+  // failed. Only applies while no rows have been fetched and at least half of the
+  // instances of the fragment have finished. 0 disables straggler retries.
+  STRAGGLER_RETRY_FACTOR = 164
+
+  // If true and the coordinator's result cache is enabled with
+  // --query_result_cache_capacity, the complete results of this SELECT statement are
+  // cached, and a later identical statement with the same session database, user and
+  // query options is answered from the cache without being executed. Any catalog
+  // change invalidates the cache. Statements that call non-deterministic, time or
+  // user-defined functions, also through views, that run in a transaction or that read
+  // Kudu, HBase or external data source tables are not cached.
+  USE_QUERY_RESULT_CACHE = 165
+
+  // If true and the executors have a fragment result cache (--fragment_result_cache_dir),
+  // fragment instances that only scan, filter and pre-aggregate HDFS tables cache their
+  // output on local disk, keyed by the plan of the fragment, the query options and the
+  // scanned files and their versions. A later instance with the same key replays the
+  // cached row batches instead of executing its plan. Fragments with runtime filters or
+  // limits, fragments with several instances per executor (mt_dop > 1) and queries that
+  // call non-deterministic, time or user-defined functions are not cached.
+  ENABLE_FRAGMENT_RESULT_CACHE = 166
+
+  // If true, HiveServer2 clients with protocol version V6 or higher receive the rows of
+  // each fetch as an Arrow IPC stream, stored as the only value of a single binary
+  // column of the TRowSet, instead of one HS2 column per result column. Only queries with
+  // scalar result types are supported.
+  ARROW_RESULT_FORMAT = 167
+
+  // If true and SPOOL_QUERY_RESULTS is true, spooled result batches are kept in memory
+  // compressed with LZ4 and decompressed when they are fetched. Compressed batches use at
+  // most MAX_RESULT_SPOOLING_MEM minus the minimum reservation of the spooling buffers;
+  // batches that do not fit are spooled uncompressed and spilled to disk as usual.
+  SPOOL_QUERY_RESULTS_COMPRESSION = 168
+
+  // If true and the coordinator's plan cache is enabled with --plan_cache_capacity, the
+  // plan of this SELECT statement is cached, and a later identical statement with the
+  // same session database, user and query options reuses it without calling the
+  // planner. Any catalog change or change of the cluster membership invalidates the
+  // plan. Statements that call functions of the current time, also through views, that
+  // sample tables without REPEATABLE, that run in a transaction or that read Kudu, HBase
+  // or external data source tables are not cached.
+  USE_PLAN_CACHE = 169
+
+  // Maximum number of threads that convert a row batch of query results into the
+  // columns of an HS2 fetch result. With a value N > 1, the result columns are split into
+  // up to N groups that are converted in parallel on the coordinator's result conversion
+  // pool (--num_result_conversion_threads). Only applies to results with HS2 protocol V6
+  // or higher whose output expressions are all column references or constants, e.g.
+  // SELECT * queries.
+  RESULT_CONVERSION_THREADS = 170
+
+  // If true, the coordinator starts the fragment instances that are scheduled on its own
+  // backend by calling the query execution manager directly, instead of sending an
+  // ExecQueryFInstances RPC to itself. This skips serializing, sending and deserializing
+  // the query context and the plan fragments, which dominates the startup of small
+  // single-node queries such as Kudu or HBase point lookups.
+  START_LOCAL_FRAGMENTS_DIRECTLY = 171
+
+  // If greater than 0, samples the stacks of the threads that execute the query's
+  // fragment instances, including scanner threads, this many times per second of CPU time
+  // they use. The samples of every fragment instance are added to its runtime profile as
+  // folded stacks, which can be rendered as a flame graph, e.g. with flamegraph.pl.
+  // Values in [0, 1000] are allowed; a low value such as 10 or 100 keeps the overhead
+  // small.
+  CPU_PROFILE_SAMPLING_HZ = 172
+
+  // If true, a subplan that only cross joins, inner joins or outer joins the rows of its
+  // input with the items of one of their collections, e.g. the subplan of
+  // 'SELECT ... FROM t, t.arr', unnests the collections of a whole input row batch in one
+  // pass instead of opening and resetting its subplan tree for every input row. Predicates
+  // on the collection items are evaluated in the same pass.
+  BATCHED_SUBPLAN_UNNEST = 173
+
+  // If true, the scan nodes that run scanner threads, e.g. HDFS scans with MT_DOP=0,
+  // measure the throughput of their scanner threads and only run as many of them as
+  // raise it. The thread tokens of the threads they stop are available to other
+  // queries. The target number of threads over time is in the profile of the scan.
+  // The number of threads is still limited by NUM_SCANNER_THREADS.
+  DYNAMIC_SCANNER_THREADS = 174
+
+  // If true, the slots of the tuples that are built by aggregations, sorts and the
+  // build sides of hash joins are laid out with the slots of the grouping, sort and join
+  // keys at the front of the tuple, so that hashing and comparing the keys touches as few
+  // cache lines as possible. The remaining slots follow after the keys.
+  ACCESS_AWARE_TUPLE_LAYOUT = 175
+
+  // Bounds the load of the executors of remote HDFS scan ranges when
+  // NUM_REMOTE_EXECUTOR_CANDIDATES is greater than 0. If set to a value of at least 1.0,
+  // no executor is assigned more than this ratio times the average bytes of the scan
+  // per executor, as long as one of its candidates has room. Scan ranges whose candidates
+  // are all at that bound fall through to the next executors of the consistent hash
+  // ring, so that popular or large files do not overload the executors they hash to,
+  // while most scan ranges keep their cache affinity. 0 (the default) disables the bound.
+  REMOTE_EXECUTOR_MAX_LOAD_RATIO = 176
+
+  // If true, every Kudu scanner fetches the next batch from the tablet server on a
+  // fetch thread while it converts the current batch into tuples, so that the round trip
+  // to the tablet server overlaps with decoding. This holds at most one more Kudu batch
+  // per scanner in memory.
+  KUDU_SCAN_PREFETCH = 177
+
+  // Bloom filters whose false positive probability, estimated from the distinct values
+  // of the join build side once it is complete, is above this value are disabled instead
+  // of being published, since they would let almost every row through. 0 disables the
+  // check. Broadcast join filters that are much larger than their distinct values need
+  // are also shrunk to the size of RUNTIME_FILTER_ERROR_RATE before they are published.
+  RUNTIME_FILTER_MAX_FPP = 178
+
+  // If true, a TABLESAMPLE scan of Parquet or ORC files also samples the row groups or
+  // stripes of the sampled files when the sampled files have more bytes than the
+  // requested percent. This keeps scans of tables with a few large files close to the
+  // requested sample size. The sample is repeatable with REPEATABLE. Not used by the
+  // child queries of COMPUTE STATS, which extrapolate from the bytes of the sampled
+  // files.
+  TABLESAMPLE_WITHIN_FILES = 179
 }
 
 // The summary of a DML statement.
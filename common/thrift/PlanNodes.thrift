@@ -125,6 +125,7 @@ struct TRuntimeFilterTargetDesc {
 enum TRuntimeFilterType {
   BLOOM = 0
   MIN_MAX = 1
+  IN_LIST = 2
 }
 
 // Enabled runtime filter types to be applied to scan nodes.
@@ -183,6 +184,11 @@ struct TRuntimeFilterDesc {
 
   // The ID of the plan node that produces this filter.
   12: optional Types.TPlanNodeId src_node_id
+
+  // True if the filter is built by a top-n node from the bound of its heap. The top-n
+  // only publishes the filter after it consumed some rows of the scan that applies it,
+  // so the scan must not wait for the filter to arrive.
+  13: optional bool is_topn_filter
 }
 
 // The information contained in subclasses of ScanNode captured in two separate
@@ -326,6 +332,22 @@ struct THdfsScanNode {
 
   // The overlap predicates
   13: optional list<TOverlapPredicateDesc> overlap_predicate_descs
+
+  // The row positions of the data files of an Iceberg table that its position delete
+  // files delete. Maps the absolute path of a data file to a bitmap of the positions of
+  // its deleted rows, serialized in the format of be/src/util/roaring-bitmap.h. The
+  // scanners skip the deleted rows. Only supported for Parquet data files.
+  14: optional map<string, binary> iceberg_position_deletes
+
+  // Fraction of the row groups of Parquet files and of the stripes of ORC files that
+  // the scanners read, in (0, 1]. Every row group or stripe is sampled independently,
+  // by a hash of its file, its index in the file and 'sample_seed', so scans with the
+  // same seed read the same sample. Set by the planner for TABLESAMPLE scans with
+  // TABLESAMPLE_WITHIN_FILES. Not set if all row groups and stripes are read.
+  15: optional double sample_rate
+
+  // Seed of the sample of 'sample_rate'.
+  16: optional i64 sample_seed
 }
 
 struct TDataSourceScanNode {
@@ -414,12 +436,38 @@ struct THashJoinNode {
   // Hash seed to use. Must be the same as the join builder's hash seed, if there is
   // a separate join build. Must be positive.
   3: optional i32 hash_seed
+
+  // True if this is a broadcast join whose distribution mode was chosen by the planner
+  // and not forced by a hint or the join type, so that the query can be planned again
+  // with a partitioned join if the build exceeds RUNTIME_BROADCAST_BYTES_LIMIT.
+  4: optional bool is_switchable_broadcast
+
+  // True if the join only needs to know whether a probe row has a match, i.e. a left
+  // semi or left anti join without other join conjuncts. The hash table then keeps a
+  // single build row per distinct key instead of chaining the duplicates.
+  5: optional bool dedup_build_keys
+}
+
+// A join conjunct 'range_build_expr <op> probe_expr' of a nested loop join, where
+// 'op' is one of LT, LE, GE and GT.
+struct TNestedLoopJoinRangeBound {
+  1: required ExternalDataSource.TComparisonOp op
+  2: required Exprs.TExpr probe_expr
 }
 
 struct TNestedLoopJoinNode {
   // Join conjuncts (both equi-join and non equi-join). All other conjuncts that are
   // evaluated at the join node are stored in TPlanNode.conjuncts.
   1: optional list<Exprs.TExpr> join_conjuncts
+
+  // If set, a slot ref on the build side that is compared to exprs over the probe side
+  // by some of the join conjuncts. The build rows are sorted on this slot, so that the
+  // build rows that can match a probe row are found with a binary search instead of
+  // evaluating the join conjuncts on all build rows.
+  2: optional Exprs.TExpr range_build_expr
+
+  // The join conjuncts that compare 'range_build_expr' to an expr over the probe side.
+  3: optional list<TNestedLoopJoinRangeBound> range_bounds
 }
 
 // Top-level struct for a join node. Elements that are shared between the different
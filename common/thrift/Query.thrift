@@ -502,6 +502,162 @@ struct TQueryOptions {
   // See comment in ImpalaService.thrift
   128: optional TKuduReplicaSelection kudu_replica_selection =
       TKuduReplicaSelection.CLOSEST_REPLICA;
+
+  // See comment in ImpalaService.thrift
+  129: optional i32 parquet_late_materialization_threshold = 20;
+
+  // See comment in ImpalaService.thrift
+  130: optional i32 parquet_decompress_ahead_pages = 0;
+
+  // See comment in ImpalaService.thrift
+  131: optional bool parquet_bloom_filtering = true;
+
+  // See comment in ImpalaService.thrift
+  132: optional bool parquet_parallel_encoding = false;
+
+  // See comment in ImpalaService.thrift
+  133: optional bool parquet_dictionary_code_filtering = true;
+
+  // See comment in ImpalaService.thrift
+  134: optional bool parquet_fallback_encodings = false;
+
+  // See comment in ImpalaService.thrift
+  135: optional bool parquet_early_runtime_filtering = true;
+
+  // See comment in ImpalaService.thrift
+  136: optional bool orc_read_statistics = true;
+
+  // See comment in ImpalaService.thrift
+  137: optional bool orc_async_read = true;
+
+  // See comment in ImpalaService.thrift
+  138: optional bool text_parallel_decompression = false;
+
+  // See comment in ImpalaService.thrift
+  139: optional bool text_batched_conversion = false;
+
+  // See comment in ImpalaService.thrift
+  140: optional bool avro_parallel_decoding = false;
+
+  // See comment in ImpalaService.thrift
+  141: optional bool kudu_columnar_scan = false;
+
+  // See comment in ImpalaService.thrift
+  142: optional i64 parquet_coalesce_gap_size = 0;
+
+  // See comment in ImpalaService.thrift
+  143: optional i32 io_scheduling_weight = 1;
+
+  // See comment in ImpalaService.thrift
+  144: optional i32 runtime_in_list_filter_entry_limit = 0;
+
+  // See comment in ImpalaService.thrift
+  145: optional i32 max_num_filters_aggregated_per_host = 0;
+
+  // See comment in ImpalaService.thrift
+  146: optional i64 runtime_broadcast_bytes_limit = 0;
+
+  // See comment in ImpalaService.thrift
+  147: optional bool preagg_first_level_table = false;
+
+  // See comment in ImpalaService.thrift
+  148: optional i32 agg_spill_sort_level = 2;
+
+  // See comment in ImpalaService.thrift
+  149: optional bool topn_runtime_filter = false;
+
+  // See comment in ImpalaService.thrift
+  150: optional bool sort_key_prefix = false;
+
+  // See comment in ImpalaService.thrift
+  151: optional i32 sort_run_threads = 1;
+
+  // See comment in ImpalaService.thrift
+  152: optional bool sort_radix = false;
+
+  // See comment in ImpalaService.thrift
+  153: optional bool batch_conjunct_evaluation = false;
+
+  // See comment in ImpalaService.thrift
+  154: optional bool fuse_like_disjuncts = false;
+
+  // See comment in ImpalaService.thrift
+  155: optional bool async_codegen_fast_tier = false;
+
+  // See comment in ImpalaService.thrift
+  156: optional bool adaptive_codegen = false;
+
+  // See comment in ImpalaService.thrift
+  157: optional bool adaptive_exchange_compression = false;
+
+  // See comment in ImpalaService.thrift
+  158: optional bool shared_exchange_buffer = false;
+
+  // See comment in ImpalaService.thrift
+  159: optional i64 exchange_max_spilled_mem = 0;
+
+  // See comment in ImpalaService.thrift
+  160: optional i32 broadcast_relay_fanout = 0;
+
+  // See comment in ImpalaService.thrift
+  161: optional bool local_exchange_shortcut = false;
+
+  // See comment in ImpalaService.thrift
+  162: optional i32 exchange_skew_sample_interval = 0;
+
+  // See comment in ImpalaService.thrift
+  163: optional bool exchange_columnar_batches = false;
+
+  // See comment in ImpalaService.thrift
+  164: optional i64 scheduler_load_penalty_bytes = 0;
+
+  // See comment in ImpalaService.thrift
+  165: optional double straggler_retry_factor = 0;
+
+  // See comment in ImpalaService.thrift
+  166: optional bool use_query_result_cache = false;
+
+  // See comment in ImpalaService.thrift
+  167: optional bool enable_fragment_result_cache = false;
+
+  // See comment in ImpalaService.thrift
+  168: optional bool arrow_result_format = false;
+
+  // See comment in ImpalaService.thrift
+  169: optional bool spool_query_results_compression = false;
+
+  // See comment in ImpalaService.thrift
+  170: optional bool use_plan_cache = false;
+
+  // See comment in ImpalaService.thrift
+  171: optional i32 result_conversion_threads = 1;
+
+  // See comment in ImpalaService.thrift
+  172: optional bool start_local_fragments_directly = false;
+
+  // See comment in ImpalaService.thrift
+  173: optional i32 cpu_profile_sampling_hz = 0;
+
+  // See comment in ImpalaService.thrift
+  174: optional bool batched_subplan_unnest = false;
+
+  // See comment in ImpalaService.thrift
+  175: optional bool dynamic_scanner_threads = false;
+
+  // See comment in ImpalaService.thrift
+  176: optional bool access_aware_tuple_layout = false;
+
+  // See comment in ImpalaService.thrift
+  177: optional double remote_executor_max_load_ratio = 0;
+
+  // See comment in ImpalaService.thrift
+  178: optional bool kudu_scan_prefetch = true;
+
+  // See comment in ImpalaService.thrift
+  179: optional double runtime_filter_max_fpp = 0.9;
+
+  // See comment in ImpalaService.thrift
+  180: optional bool tablesample_within_files = false;
 }
 
 // Impala currently has three types of sessions: Beeswax, HiveServer2 and external
@@ -672,6 +828,16 @@ struct TQueryCtx {
   // True if the new runtime profile format added by IMPALA-9382 should be generated
   // by this query.
   28: optional bool gen_aggregated_profile
+
+  // Set by the planner. True if the results of the query may differ between executions
+  // on the same data, e.g. because it calls rand(), now() or a user-defined function,
+  // directly or through a view. Such results must not be reused by another query.
+  29: optional bool results_are_nondeterministic = false
+
+  // Set by the planner. True if the plan is only valid for this execution, e.g.
+  // because calls of now() were folded into literals. Such plans must not be reused
+  // by another query.
+  30: optional bool plan_is_query_specific = false
 }
 
 
@@ -137,6 +137,10 @@ enum TPrefetchMode {
 
   // Prefetch the hash table buckets.
   HT_BUCKET = 1
+
+  // Prefetch the hash table buckets and, in hash join probes, keep several lookups in
+  // flight that prefetch the duplicate nodes and build rows they read next.
+  HT_BUCKET_PIPELINED = 2
 }
 
 // A TNetworkAddress is the standard host, port representation of a
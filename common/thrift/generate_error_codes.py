@@ -471,6 +471,14 @@ error_codes = (
 
   ("LOCAL_DISK_FAULTY", 152,
    "Query execution failure caused by local disk IO fatal error on backend: $0."),
+
+  ("PARQUET_CORRUPT_ENCODED_VALUES", 153, "File '$0' is corrupt: error decoding $1 "
+   "values of column '$2': $3"),
+
+  ("RUNTIME_BROADCAST_BYTES_LIMIT_EXCEEDED", 154,
+   "Build of broadcast join with id $0 exceeded the runtime broadcast bytes limit: "
+   "$1 > $2. Increase or unset RUNTIME_BROADCAST_BYTES_LIMIT to run the query with "
+   "a broadcast join."),
 )
 
 import sys
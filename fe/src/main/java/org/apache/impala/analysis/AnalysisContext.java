@@ -558,6 +558,11 @@ public class AnalysisContext {
     // re-analysis.
     ImmutableList<PrivilegeRequest> origPrivReqs =
         analysisResult_.analyzer_.getPrivilegeReqs();
+    // For the same reason the calls that make the statement specific to this query
+    // may not be found again.
+    boolean resultsAreNondeterministic =
+        analysisResult_.analyzer_.resultsAreNondeterministic();
+    boolean planIsQuerySpecific = analysisResult_.analyzer_.planIsQuerySpecific();
 
     // Re-analyze the stmt with a new analyzer.
     analysisResult_.analyzer_ = createAnalyzer(stmtTableCache, authzCtx);
@@ -585,6 +590,10 @@ public class AnalysisContext {
     for (PrivilegeRequest req : origPrivReqs) {
       analysisResult_.analyzer_.registerPrivReq(req);
     }
+    if (resultsAreNondeterministic) {
+      analysisResult_.analyzer_.setResultsAreNondeterministic();
+    }
+    if (planIsQuerySpecific) analysisResult_.analyzer_.setPlanIsQuerySpecific();
     if (isExplain) analysisResult_.stmt_.setIsExplain();
   }
 
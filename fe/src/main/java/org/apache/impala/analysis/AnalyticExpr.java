@@ -531,13 +531,14 @@ public class AnalyticExpr extends Expr {
 
     standardize(analyzer);
 
-    // min/max is not currently supported on sliding windows (i.e. start bound is not
-    // unbounded).
-    if (window_ != null && isMinMax(fn) &&
-        window_.getLeftBoundary().getType() != BoundaryType.UNBOUNDED_PRECEDING) {
+    // min/max cannot remove rows from their intermediate value, so the backend only
+    // evaluates them over sliding ROWS windows (i.e. the start bound is not unbounded).
+    if (window_ != null && isMinMax(fn)
+        && window_.getType() != AnalyticWindow.Type.ROWS
+        && window_.getLeftBoundary().getType() != BoundaryType.UNBOUNDED_PRECEDING) {
       throw new AnalysisException(
           "'" + getFnCall().toSql() + "' is only supported with an "
-            + "UNBOUNDED PRECEDING start bound.");
+            + "UNBOUNDED PRECEDING start bound for RANGE windows.");
     }
 
     setChildren();
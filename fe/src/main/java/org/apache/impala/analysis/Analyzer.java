@@ -75,6 +75,7 @@ import org.apache.impala.rewrite.ExprRewriter;
 import org.apache.impala.rewrite.ExtractCommonConjunctRule;
 import org.apache.impala.rewrite.ExtractCompoundVerticalBarExprRule;
 import org.apache.impala.rewrite.FoldConstantsRule;
+import org.apache.impala.rewrite.LikeDisjunctsToLikeAnyRule;
 import org.apache.impala.rewrite.NormalizeBinaryPredicatesRule;
 import org.apache.impala.rewrite.NormalizeCountStarRule;
 import org.apache.impala.rewrite.NormalizeExprsRule;
@@ -242,6 +243,15 @@ public class Analyzer {
     return globalState_.hasTopLevelAcidCollectionTableRef;
   }
 
+  public void setResultsAreNondeterministic() {
+    globalState_.resultsAreNondeterministic = true;
+  }
+  public boolean resultsAreNondeterministic() {
+    return globalState_.resultsAreNondeterministic;
+  }
+  public void setPlanIsQuerySpecific() { globalState_.planIsQuerySpecific = true; }
+  public boolean planIsQuerySpecific() { return globalState_.planIsQuerySpecific; }
+
   public boolean setHasPlanHints() { return globalState_.hasPlanHints = true; }
   public boolean hasPlanHints() { return globalState_.hasPlanHints; }
   public void setHasWithClause() { hasWithClause_ = true; }
@@ -381,6 +391,18 @@ public class Analyzer {
     // select item from complextypestbl.int_array;
     public boolean hasTopLevelAcidCollectionTableRef = false;
 
+    // True if the results of the statement may differ between executions on the same
+    // data, e.g. because it calls rand() or a user-defined function, possibly in the
+    // definition of a view. Kept across re-analysis after expr rewrites, which may have
+    // folded the calls.
+    public boolean resultsAreNondeterministic = false;
+
+    // True if the plan of the statement is only valid for this execution, because calls
+    // of functions of the query start time, e.g. now(), are folded into literals or
+    // tables are sampled with a random seed chosen during planning. Kept across
+    // re-analysis like 'resultsAreNondeterministic'.
+    public boolean planIsQuerySpecific = false;
+
     // all registered conjuncts (map from expr id to conjunct). We use a LinkedHashMap to
     // preserve the order in which conjuncts are added.
     public final Map<ExprId, Expr> conjuncts = new LinkedHashMap<>();
@@ -525,6 +547,7 @@ public class Analyzer {
         // Relies on FoldConstantsRule and NormalizeExprsRule.
         rules.add(SimplifyConditionalsRule.INSTANCE);
         rules.add(EqualityDisjunctsToInRule.INSTANCE);
+        rules.add(LikeDisjunctsToLikeAnyRule.INSTANCE);
         rules.add(NormalizeCountStarRule.INSTANCE);
         rules.add(SimplifyDistinctFromRule.INSTANCE);
         rules.add(SimplifyCastStringToTimestamp.INSTANCE);
@@ -320,6 +320,34 @@ public class FunctionCallExpr extends Expr {
         functionNameEqualsBuiltin(fnName_, "uuid");
   }
 
+  /**
+   * Returns true if function is a builtin function whose result depends on the start
+   * time of the query, e.g. now(). Calls of these functions are constant within a
+   * query and are usually folded into literals during planning.
+   */
+  public boolean isQueryTimeBuiltinFn() {
+    return functionNameEqualsBuiltin(fnName_, "now") ||
+        functionNameEqualsBuiltin(fnName_, "current_timestamp") ||
+        functionNameEqualsBuiltin(fnName_, "current_date") ||
+        functionNameEqualsBuiltin(fnName_, "utc_timestamp") ||
+        functionNameEqualsBuiltin(fnName_, "timeofday") ||
+        (functionNameEqualsBuiltin(fnName_, "unix_timestamp") && children_.isEmpty());
+  }
+
+  /**
+   * Returns true if two queries that call this function on the same data may get
+   * different results. In addition to the non-deterministic builtins this includes
+   * builtins that sample their input, builtins of the query time and all user defined
+   * functions, which may have arbitrary state.
+   */
+  public boolean isNondeterministicAcrossQueries() {
+    return !fnName_.isBuiltin() || isNondeterministicBuiltinFn() ||
+        isQueryTimeBuiltinFn() ||
+        functionNameEqualsBuiltin(fnName_, "sleep") ||
+        functionNameEqualsBuiltin(fnName_, "appx_median") ||
+        functionNameEqualsBuiltin(fnName_, "sample");
+  }
+
   /**
    * Returns true if function is a conditional builtin function
    */
@@ -538,6 +566,10 @@ public class FunctionCallExpr extends Expr {
         profile.appendInfoString(udfInfoStringKey, functionName);
       }
     }
+    // Let the caches that reuse plans and results across queries know about calls that
+    // make them specific to this query.
+    if (isNondeterministicAcrossQueries()) analyzer.setResultsAreNondeterministic();
+    if (isQueryTimeBuiltinFn()) analyzer.setPlanIsQuerySpecific();
 
     if (isMergeAggFn()) {
       // This is the function call expr after splitting up to a merge aggregation.
@@ -65,6 +65,11 @@ public class SlotDescriptor {
   // NULL value if the entire tuple is NULL, for example as the result of an outer join.
   private boolean isNullable_ = true;
 
+  // if true, this slot is accessed more often than the other slots of its tuple, e.g.
+  // because it is a grouping, sort or join key, and is placed at the front of the tuple
+  // by TupleDescriptor.computeMemLayout().
+  private boolean isHot_ = false;
+
   // physical layout parameters
   private int byteSize_;
   private int byteOffset_;  // within tuple
@@ -129,6 +134,8 @@ public class SlotDescriptor {
   }
   public boolean getIsNullable() { return isNullable_; }
   public void setIsNullable(boolean value) { isNullable_ = value; }
+  public boolean isHot() { return isHot_; }
+  public void setIsHot(boolean value) { isHot_ = value; }
   public int getByteSize() { return byteSize_; }
   public void setByteSize(int byteSize) { this.byteSize_ = byteSize; }
   public int getByteOffset() { return byteOffset_; }
@@ -232,6 +232,14 @@ public class SortInfo {
     // materialization decision above.
     substituteSortExprs(outputSmap_, analyzer);
     checkConsistency();
+
+    // The slots referenced by the sort exprs are read by every comparison of the sort,
+    // so they are placed first in the sort tuple.
+    if (analyzer.getQueryOptions().isAccess_aware_tuple_layout()) {
+      List<SlotRef> sortSlotRefs = new ArrayList<>();
+      TreeNode.collect(sortExprs_, Predicates.instanceOf(SlotRef.class), sortSlotRefs);
+      for (SlotRef slotRef: sortSlotRefs) slotRef.getDesc().setIsHot(true);
+    }
   }
 
   /**
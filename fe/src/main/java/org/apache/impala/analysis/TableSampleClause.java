@@ -50,6 +50,11 @@ public class TableSampleClause extends StmtNode {
           "Invalid percent of bytes value '%s'. " +
           "The percent of bytes to sample must be between 0 and 100.", percentBytes_));
     }
+    // Without REPEATABLE the planner picks a new seed for every query.
+    if (!hasRandomSeed()) {
+      analyzer.setResultsAreNondeterministic();
+      analyzer.setPlanIsQuerySpecific();
+    }
   }
 
   public long getPercentBytes() { return percentBytes_; }
@@ -66,6 +66,11 @@ import com.google.common.base.Preconditions;
  * scan slot, then all slots (even non-nullable ones) get a null flag. If there are no
  * nullable Kudu scan slots, then there are also no null flags.
  * There is no padding between tuples when stored back-to-back in a row batch.
+ * If some slots are marked as hot, e.g. the grouping slots of an aggregation tuple, the
+ * hot slots are placed first, each group in descending order by size, so that the keys
+ * share as few cache lines as possible. Cold slots are moved into the hot group when
+ * that is needed to keep the cold slots aligned. Kudu scan tuples keep the default
+ * layout.
  *
  * Example: select bool_col, int_col, string_col, smallint_col from functional.alltypes
  * Slots:   string_col|int_col|smallint_col|bool_col|null_byte
@@ -290,7 +295,7 @@ public class TupleDescriptor {
     for (SlotDescriptor d: slots_) {
       if (!d.isMaterialized()) continue;
       ColumnStats stats = d.getStats();
-      int slotSize = d.getType().getSlotSize();
+      int slotSize = getSlotSize(d);
 
       if (stats.hasAvgSize()) {
         avgSerializedSize_ += d.getStats().getAvgSerializedSize();
@@ -299,10 +304,7 @@ public class TupleDescriptor {
         avgSerializedSize_ += slotSize;
       }
       // Add padding for a KUDU string slot.
-      if (d.isKuduStringSlot()) {
-        slotSize += KUDU_STRING_PADDING;
-        avgSerializedSize_ += KUDU_STRING_PADDING;
-      }
+      if (d.isKuduStringSlot()) avgSerializedSize_ += KUDU_STRING_PADDING;
       if (!slotsBySize.containsKey(slotSize)) {
         slotsBySize.put(slotSize, new ArrayList<>());
       }
@@ -325,29 +327,32 @@ public class TupleDescriptor {
     // sort slots in descending order of size
     List<Integer> sortedSizes = new ArrayList<>(slotsBySize.keySet());
     Collections.sort(sortedSizes, Collections.reverseOrder());
-    for (int slotSize: sortedSizes) {
-      if (slotsBySize.get(slotSize).isEmpty()) continue;
-      for (SlotDescriptor d: slotsBySize.get(slotSize)) {
-        Preconditions.checkState(d.isMaterialized());
-        d.setByteSize(slotSize);
-        d.setByteOffset(slotOffset);
-        d.setSlotIdx(slotIdx++);
-        slotOffset += slotSize;
-
-        // assign null indicator
-        if (d.getIsNullable() || alwaysAddNullBit) {
-          d.setNullIndicatorByte(nullIndicatorByte);
-          d.setNullIndicatorBit(nullIndicatorBit);
-          nullIndicatorBit = (nullIndicatorBit + 1) % 8;
-          if (nullIndicatorBit == 0) ++nullIndicatorByte;
-        }
-        // non-nullable slots have 0 for the byte offset and -1 for the bit mask
-        // to make sure IS NULL always evaluates to false in the BE without having
-        // to check nullability explicitly
-        if (!d.getIsNullable()) {
-          d.setNullIndicatorBit(-1);
-          d.setNullIndicatorByte(0);
-        }
+    List<SlotDescriptor> sortedSlots = new ArrayList<>();
+    for (int slotSize: sortedSizes) sortedSlots.addAll(slotsBySize.get(slotSize));
+    if (!alwaysAddNullBit && !(getTable() instanceof FeKuduTable)) {
+      sortedSlots = orderHotSlotsFirst(sortedSlots);
+    }
+    for (SlotDescriptor d: sortedSlots) {
+      Preconditions.checkState(d.isMaterialized());
+      int slotSize = getSlotSize(d);
+      d.setByteSize(slotSize);
+      d.setByteOffset(slotOffset);
+      d.setSlotIdx(slotIdx++);
+      slotOffset += slotSize;
+
+      // assign null indicator
+      if (d.getIsNullable() || alwaysAddNullBit) {
+        d.setNullIndicatorByte(nullIndicatorByte);
+        d.setNullIndicatorBit(nullIndicatorBit);
+        nullIndicatorBit = (nullIndicatorBit + 1) % 8;
+        if (nullIndicatorBit == 0) ++nullIndicatorByte;
+      }
+      // non-nullable slots have 0 for the byte offset and -1 for the bit mask
+      // to make sure IS NULL always evaluates to false in the BE without having
+      // to check nullability explicitly
+      if (!d.getIsNullable()) {
+        d.setNullIndicatorBit(-1);
+        d.setNullIndicatorByte(0);
       }
     }
     Preconditions.checkState(slotOffset == totalSlotSize);
@@ -355,6 +360,89 @@ public class TupleDescriptor {
     byteSize_ = totalSlotSize + numNullBytes_;
   }
 
+  /**
+   * Returns the number of bytes of 'd' in the tuple, including the padding of Kudu
+   * string slots.
+   */
+  private static int getSlotSize(SlotDescriptor d) {
+    int slotSize = d.getType().getSlotSize();
+    if (d.isKuduStringSlot()) slotSize += KUDU_STRING_PADDING;
+    return slotSize;
+  }
+
+  /**
+   * Returns the alignment that 'd' needs to be accessed efficiently.
+   */
+  private static int getSlotAlignment(SlotDescriptor d) {
+    return Math.min(8, Integer.lowestOneBit(getSlotSize(d)));
+  }
+
+  /**
+   * Reorders 'sortedSlots', which are in descending order by size, so that the hot slots
+   * come first. Returns 'sortedSlots' if there is no hot slot. Both the hot and the cold
+   * slots stay in descending order by size. The smallest cold slots are moved to the
+   * hot slots until the size of the hot slots is a multiple of the alignment of the
+   * cold slots. Returns 'sortedSlots' if the reordering would still misalign a slot
+   * that is aligned in the default layout, e.g. because of the 12-byte string slots.
+   */
+  private static List<SlotDescriptor> orderHotSlotsFirst(
+      List<SlotDescriptor> sortedSlots) {
+    List<SlotDescriptor> hotSlots = new ArrayList<>();
+    List<SlotDescriptor> coldSlots = new ArrayList<>();
+    int hotSize = 0;
+    for (SlotDescriptor d: sortedSlots) {
+      if (d.isHot()) {
+        hotSlots.add(d);
+        hotSize += getSlotSize(d);
+      } else {
+        coldSlots.add(d);
+      }
+    }
+    if (hotSlots.isEmpty() || coldSlots.isEmpty()) return sortedSlots;
+    while (!coldSlots.isEmpty()) {
+      int coldAlignment = 1;
+      for (SlotDescriptor d: coldSlots) {
+        coldAlignment = Math.max(coldAlignment, getSlotAlignment(d));
+      }
+      if (hotSize % coldAlignment == 0) break;
+      SlotDescriptor d = coldSlots.remove(coldSlots.size() - 1);
+      hotSlots.add(d);
+      hotSize += getSlotSize(d);
+    }
+    // The sort is stable, so slots of the same size keep their order.
+    Collections.sort(hotSlots, new Comparator<SlotDescriptor>() {
+      @Override
+      public int compare(SlotDescriptor a, SlotDescriptor b) {
+        return Integer.compare(getSlotSize(b), getSlotSize(a));
+      }
+    });
+    List<SlotDescriptor> result = new ArrayList<>(hotSlots);
+    result.addAll(coldSlots);
+    Map<SlotDescriptor, Integer> defaultOffsets = getSlotOffsets(sortedSlots);
+    Map<SlotDescriptor, Integer> offsets = getSlotOffsets(result);
+    for (SlotDescriptor d: sortedSlots) {
+      int alignment = getSlotAlignment(d);
+      if (defaultOffsets.get(d) % alignment == 0 && offsets.get(d) % alignment != 0) {
+        return sortedSlots;
+      }
+    }
+    return result;
+  }
+
+  /**
+   * Returns the byte offset of each slot if 'slots' are placed back-to-back.
+   */
+  private static Map<SlotDescriptor, Integer> getSlotOffsets(
+      List<SlotDescriptor> slots) {
+    Map<SlotDescriptor, Integer> offsets = new HashMap<>();
+    int offset = 0;
+    for (SlotDescriptor d: slots) {
+      offsets.put(d, offset);
+      offset += getSlotSize(d);
+    }
+    return offsets;
+  }
+
   /**
    * In some cases (such as with an external frontend) there may be a need
    * to reset the mem layout such that it can be recomputed at a later time.
@@ -400,6 +400,14 @@ public class BuiltinsDb extends Db {
             "11DsHllUpdateIN10impala_udf9StringValEEEvPNS2_15FunctionContextERKT_PS3_")
         .build();
 
+  private static final Map<Type, String> BITMAP_UPDATE_SYMBOL =
+      ImmutableMap.<Type, String>builder()
+        .put(Type.INT,
+            "12BitmapUpdateIN10impala_udf6IntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+        .put(Type.BIGINT,
+            "12BitmapUpdateIN10impala_udf9BigIntValEEEvPNS2_15FunctionContextERKT_PNS2_9StringValE")
+        .build();
+
   private static final Map<Type, String> DS_CPC_UPDATE_SYMBOL =
       ImmutableMap.<Type, String>builder()
         .put(Type.TINYINT,
@@ -1117,6 +1125,27 @@ public class BuiltinsDb extends Db {
             Lists.newArrayList(t), Type.STRING, Type.STRING));
       }
 
+      // Exact distinct counts of integers with a bitmap
+      if (BITMAP_UPDATE_SYMBOL.containsKey(t)) {
+        db.addBuiltin(AggregateFunction.createBuiltin(db, "bitmap_count_distinct",
+            Lists.newArrayList(t), Type.BIGINT, Type.STRING,
+            prefix + "10BitmapInitEPN10impala_udf15FunctionContextEPNS1_9StringValE",
+            prefix + BITMAP_UPDATE_SYMBOL.get(t),
+            prefix + "11BitmapMergeEPN10impala_udf15FunctionContextERKNS1_9StringValEPS4_",
+            prefix + "15BitmapSerializeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
+            prefix + "14BitmapFinalizeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
+            true, false, true));
+
+        db.addBuiltin(AggregateFunction.createBuiltin(db, "bitmap_build",
+            Lists.newArrayList(t), Type.STRING, Type.STRING,
+            prefix + "10BitmapInitEPN10impala_udf15FunctionContextEPNS1_9StringValE",
+            prefix + BITMAP_UPDATE_SYMBOL.get(t),
+            prefix + "11BitmapMergeEPN10impala_udf15FunctionContextERKNS1_9StringValEPS4_",
+            prefix + "15BitmapSerializeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
+            prefix + "20BitmapFinalizeBitmapEPN10impala_udf15FunctionContextERKNS1_" +
+                "9StringValE", true, false, true));
+      }
+
       // DataSketches CPC
       if (DS_CPC_UPDATE_SYMBOL.containsKey(t)) {
         db.addBuiltin(AggregateFunction.createBuiltin(db, "ds_cpc_sketch_and_estimate",
@@ -1463,6 +1492,17 @@ public class BuiltinsDb extends Db {
             "18DsHllUnionFinalizeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
         true, false, true));
 
+    // Union of bitmaps from bitmap_build()
+    db.addBuiltin(AggregateFunction.createBuiltin(db, "bitmap_union_count",
+        Lists.<Type>newArrayList(Type.STRING), Type.BIGINT, Type.STRING,
+        prefix + "10BitmapInitEPN10impala_udf15FunctionContextEPNS1_9StringValE",
+        prefix +
+            "17BitmapUnionUpdateEPN10impala_udf15FunctionContextERKNS1_9StringValEPS4_",
+        prefix + "11BitmapMergeEPN10impala_udf15FunctionContextERKNS1_9StringValEPS4_",
+        prefix + "15BitmapSerializeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
+        prefix + "14BitmapFinalizeEPN10impala_udf15FunctionContextERKNS1_9StringValE",
+        true, false, true));
+
     // DataSketches CPC union
     db.addBuiltin(AggregateFunction.createBuiltin(db, "ds_cpc_union",
         Lists.<Type>newArrayList(Type.STRING), Type.STRING, Type.STRING,
@@ -102,6 +102,20 @@ public class UdfExecutor {
   // Size of outBufferStringPtr_.
   private int outBufferCapacity_;
 
+  // Columnar input and output buffers for evaluateBatch(), with room for
+  // batchCapacity_ rows. batchCapacity_ is 0 if the backend evaluates one row at a time.
+  // These buffers are allocated in the BE.
+  private final int batchCapacity_;
+  private final long batchInputBufferPtr_;
+  private final long batchInputNullsPtr_;
+  private final long batchOutputBufferPtr_;
+  private final long batchOutputNullPtr_;
+
+  // The bytes per row of the ith input column and of the output column of the batch
+  // buffers.
+  private final int[] inputByteSizes_;
+  private final int outputByteSize_;
+
   // Preconstructed input objects for the UDF. This minimizes object creation overhead
   // as these objects are reused across calls to evaluate().
   private Object[] inputObjects_;
@@ -219,6 +233,26 @@ public class UdfExecutor {
     for (int i = 0; i < request.input_byte_offsets.size(); ++i) {
       inputBufferOffsets_[i] = request.input_byte_offsets.get(i).intValue();
     }
+    if (request.isSetBatch_capacity()) {
+      batchCapacity_ = request.batch_capacity;
+      batchInputBufferPtr_ = request.batch_input_buffer_ptr;
+      batchInputNullsPtr_ = request.batch_input_nulls_ptr;
+      batchOutputBufferPtr_ = request.batch_output_buffer_ptr;
+      batchOutputNullPtr_ = request.batch_output_null_ptr;
+      inputByteSizes_ = new int[request.input_byte_sizes.size()];
+      for (int i = 0; i < request.input_byte_sizes.size(); ++i) {
+        inputByteSizes_[i] = request.input_byte_sizes.get(i).intValue();
+      }
+      outputByteSize_ = request.output_byte_size;
+    } else {
+      batchCapacity_ = 0;
+      batchInputBufferPtr_ = 0;
+      batchInputNullsPtr_ = 0;
+      batchOutputBufferPtr_ = 0;
+      batchOutputNullPtr_ = 0;
+      inputByteSizes_ = new int[0];
+      outputByteSize_ = 0;
+    }
 
     init(jarFile, className, retType, parameterTypes);
   }
@@ -311,6 +345,40 @@ public class UdfExecutor {
     }
   }
 
+  /**
+   * Batched evaluate function called by the backend. Evaluates the UDF over the first
+   * 'numRows' rows of the batch input buffers and writes the results to the batch
+   * output buffers, so that the backend crosses JNI once per batch instead of once per
+   * row. The results of the rows for which the UDF fails are NULL, and the first
+   * failure is thrown once all rows are evaluated.
+   */
+  public void evaluateBatch(int numRows) throws ImpalaRuntimeException {
+    Preconditions.checkState(numRows <= batchCapacity_);
+    ImpalaRuntimeException firstFailure = null;
+    for (int row = 0; row < numRows; ++row) {
+      // Move the arguments of the row to the input buffer that inputObjects_ read.
+      for (int i = 0; i < argTypes_.length; ++i) {
+        long column =
+            batchInputBufferPtr_ + (long) inputBufferOffsets_[i] * batchCapacity_;
+        UnsafeUtil.UNSAFE.copyMemory(column + (long) row * inputByteSizes_[i],
+            inputBufferPtr_ + inputBufferOffsets_[i], inputByteSizes_[i]);
+        UnsafeUtil.UNSAFE.putByte(inputNullsPtr_ + i, UnsafeUtil.UNSAFE.getByte(
+            batchInputNullsPtr_ + (long) i * batchCapacity_ + row));
+      }
+      try {
+        evaluate();
+      } catch (ImpalaRuntimeException e) {
+        if (firstFailure == null) firstFailure = e;
+        UnsafeUtil.UNSAFE.putByte(outputNullPtr_, (byte)1);
+      }
+      UnsafeUtil.UNSAFE.putByte(
+          batchOutputNullPtr_ + row, UnsafeUtil.UNSAFE.getByte(outputNullPtr_));
+      UnsafeUtil.UNSAFE.copyMemory(outputBufferPtr_,
+          batchOutputBufferPtr_ + (long) row * outputByteSize_, outputByteSize_);
+    }
+    if (firstFailure != null) throw firstFailure;
+  }
+
   /**
    * Evalutes the UDF with 'args' as the input to the UDF. This is exposed
    * for testing and not the version of evaluate() the backend uses.
@@ -189,8 +189,17 @@ public class AggregationNode extends PlanNode {
       conjuncts_ = orderConjunctsByCost(conjuncts_);
     }
 
-    // Compute the mem layout for both tuples here for simplicity.
+    // Compute the mem layout for both tuples here for simplicity. The grouping slots
+    // are hashed and compared for every input row, so they can be placed first.
+    boolean hotGroupingSlots = analyzer.getQueryOptions().isAccess_aware_tuple_layout();
     for (AggregateInfo aggInfo : aggInfos_) {
+      if (hotGroupingSlots) {
+        int numGroupingSlots = aggInfo.getGroupingExprs().size();
+        for (int i = 0; i < numGroupingSlots; ++i) {
+          aggInfo.getOutputTupleDesc().getSlots().get(i).setIsHot(true);
+          aggInfo.getIntermediateTupleDesc().getSlots().get(i).setIsHot(true);
+        }
+      }
       aggInfo.getOutputTupleDesc().computeMemLayout();
       aggInfo.getIntermediateTupleDesc().computeMemLayout();
     }
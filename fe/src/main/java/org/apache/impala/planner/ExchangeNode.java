@@ -199,7 +199,22 @@ public class ExchangeNode extends PlanNode {
     long estimatedMem = Math.max(
         checkedAdd(estimatedTotalQueueByteSize, estimatedDeferredRPCQueueSize),
         MIN_ESTIMATE_BYTES);
-    nodeResourceProfile_ = ResourceProfile.noReservation(estimatedMem);
+    if (isMergingExchange() || queryOptions.getExchange_max_spilled_mem() <= 0) {
+      nodeResourceProfile_ = ResourceProfile.noReservation(estimatedMem);
+      return;
+    }
+    // With EXCHANGE_MAX_SPILLED_MEM, the receiver of a non-merging exchange spills
+    // batches that exceed its buffer limit to a spillable row batch queue, which needs
+    // a read and a write buffer. The exchange still works without spilling if it does
+    // not get them, so there is no minimum reservation.
+    long bufferSize = queryOptions.getDefault_spillable_buffer_size();
+    long maxRowBufferSize =
+        computeMaxSpillableBufferSize(bufferSize, queryOptions.getMax_row_size());
+    nodeResourceProfile_ = new ResourceProfileBuilder()
+        .setMemEstimateBytes(estimatedMem)
+        .setMaxMemReservationBytes(2 * maxRowBufferSize)
+        .setSpillableBufferBytes(bufferSize)
+        .setMaxRowBufferBytes(maxRowBufferSize).build();
   }
 
   // Returns the estimated size of the deferred batch queue (in bytes) by
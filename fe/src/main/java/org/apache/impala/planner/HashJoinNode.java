@@ -18,13 +18,18 @@
 package org.apache.impala.planner;
 
 import java.util.ArrayList;
+import java.util.LinkedHashSet;
 import java.util.List;
+import java.util.Set;
 
 import org.apache.impala.analysis.Analyzer;
 import org.apache.impala.analysis.BinaryPredicate;
 import org.apache.impala.analysis.Expr;
 import org.apache.impala.analysis.ExprSubstitutionMap;
 import org.apache.impala.analysis.JoinOperator;
+import org.apache.impala.analysis.SlotDescriptor;
+import org.apache.impala.analysis.SlotRef;
+import org.apache.impala.analysis.TupleDescriptor;
 import org.apache.impala.catalog.Type;
 import org.apache.impala.common.AnalysisException;
 import org.apache.impala.common.ImpalaException;
@@ -113,9 +118,30 @@ public class HashJoinNode extends JoinNode {
     }
     eqJoinConjuncts_ = newEqJoinConjuncts;
     orderJoinConjunctsByCost();
+    if (analyzer.getQueryOptions().isAccess_aware_tuple_layout()) placeBuildKeysFirst();
     computeStats(analyzer);
   }
 
+  /**
+   * Marks the materialized slots that are referenced by the build side of the equi-join
+   * conjuncts as hot and recomputes the memory layout of their tuples, so that the keys
+   * are at the front of the build rows, which are hashed and compared for every probe.
+   */
+  private void placeBuildKeysFirst() {
+    List<SlotRef> buildSlotRefs = new ArrayList<>();
+    for (BinaryPredicate eqPred: eqJoinConjuncts_) {
+      eqPred.getChild(1).collect(SlotRef.class, buildSlotRefs);
+    }
+    Set<TupleDescriptor> buildTuples = new LinkedHashSet<>();
+    for (SlotRef slotRef: buildSlotRefs) {
+      SlotDescriptor slotDesc = slotRef.getDesc();
+      if (!slotDesc.isMaterialized() || slotDesc.isHot()) continue;
+      slotDesc.setIsHot(true);
+      buildTuples.add(slotDesc.getParent());
+    }
+    for (TupleDescriptor tuple: buildTuples) tuple.recomputeMemLayout();
+  }
+
   @Override
   protected String debugString() {
     return MoreObjects.toStringHelper(this)
@@ -142,6 +168,30 @@ public class HashJoinNode extends JoinNode {
       msg.join_node.hash_join_node.addToOther_join_conjuncts(e.treeToThrift());
     }
     msg.join_node.hash_join_node.setHash_seed(getFragment().getHashSeed());
+    msg.join_node.hash_join_node.setIs_switchable_broadcast(isSwitchableBroadcast());
+    msg.join_node.hash_join_node.setDedup_build_keys(canDedupBuildKeys());
+  }
+
+  /**
+   * Returns true if this is a broadcast join that the planner chose from the estimated
+   * costs or the default distribution mode, so that it is planned as a partitioned join
+   * if the query options rule out broadcasts, see
+   * DistributedPlanner.computeJoinDistributionMode().
+   */
+  public boolean isSwitchableBroadcast() {
+    return distrMode_ == DistributionMode.BROADCAST
+        && distrModeHint_ == DistributionMode.NONE
+        && joinOp_ != JoinOperator.NULL_AWARE_LEFT_ANTI_JOIN;
+  }
+
+  /**
+   * Returns true if the join only checks whether a probe row has a matching build row,
+   * so that the build only needs to keep one row per distinct join key.
+   */
+  public boolean canDedupBuildKeys() {
+    return (joinOp_ == JoinOperator.LEFT_SEMI_JOIN
+        || joinOp_ == JoinOperator.LEFT_ANTI_JOIN)
+        && otherJoinConjuncts_.isEmpty();
   }
 
   /**
@@ -210,6 +210,12 @@ public class HdfsScanNode extends ScanNode {
   // Parameters for table sampling. Null if not sampling.
   private final TableSampleClause sampleParams_;
 
+  // Fraction of the row groups and stripes of the sampled files that the scanners read,
+  // and the seed of that sample. Less than 1 if TABLESAMPLE_WITHIN_FILES is set and the
+  // sampled files have more bytes than the requested percent.
+  private double unitSampleRate_ = 1.0;
+  private long unitSampleSeed_ = 0;
+
   private final TReplicaPreference replicaPreference_;
   private final boolean randomReplica_;
 
@@ -717,6 +723,23 @@ public class HdfsScanNode extends ScanNode {
     return false;
   }
 
+  // Return true if the ORC scanner can skip stripes with the min/max filter 'filter'
+  // on 'targetExpr', by comparing the filter with the stripe statistics of the column.
+  // That needs all files to be ORC files and 'targetExpr' to be a column of the table
+  // of the same type as the source of the filter.
+  public boolean canSkipOrcStripes(
+      Analyzer analyzer, RuntimeFilter filter, Expr targetExpr) {
+    if (filter.getType() != TRuntimeFilterType.MIN_MAX) return false;
+    if (!analyzer.getQueryOptions().isOrc_read_statistics()) return false;
+    if (fileFormats_.size() != 1 || !fileFormats_.contains(HdfsFileFormat.ORC)) {
+      return false;
+    }
+    if (!(targetExpr instanceof SlotRef)) return false;
+    SlotDescriptor slotDesc = ((SlotRef) targetExpr).getDesc();
+    return slotDesc.getColumn() != null
+        && slotDesc.getType().equals(filter.getSrcExpr().getType());
+  }
+
   // Try to compute the overlap predicate for the filter. Return true if an overlap
   // predicate can be formed utilizing the min/max filter 'filter' against the
   // target expr 'targetExpr'. Return false otherwise.
@@ -934,6 +957,26 @@ public class HdfsScanNode extends ScanNode {
     private FileSystemUtil.FsType getPartitionFsType() { return partitionFsType; }
   }
 
+  /**
+   * Sets 'unitSampleRate_' so that the scanners read about 'percentBytes' percent of
+   * the bytes of 'partitions_' from 'sampledFiles', by sampling their row groups and
+   * stripes with 'randomSeed'.
+   */
+  private void computeUnitSampleRate(
+      Map<SampledPartitionMetadata, List<FileDescriptor>> sampledFiles,
+      long percentBytes, long randomSeed) {
+    long totalBytes = 0;
+    for (FeFsPartition partition: partitions_) totalBytes += partition.getSize();
+    long sampledBytes = 0;
+    for (List<FileDescriptor> fds: sampledFiles.values()) {
+      for (FileDescriptor fd: fds) sampledBytes += fd.getFileLength();
+    }
+    long targetBytes = Math.round(totalBytes * ((double) percentBytes / 100));
+    if (targetBytes <= 0 || sampledBytes <= targetBytes) return;
+    unitSampleRate_ = (double) targetBytes / sampledBytes;
+    unitSampleSeed_ = randomSeed;
+  }
+
   /**
    * Computes scan ranges (i.e. hdfs splits) plus their storage locations, including
    * volume ids, based on the given maximum number of bytes each scan range should scan.
@@ -959,6 +1002,12 @@ public class HdfsScanNode extends ScanNode {
       // the sampling percent is adjusted to reflect it.
       sampledFiles = FeFsTable.Utils.getFilesSample(tbl_, partitions_, percentBytes, 0,
           randomSeed);
+      // The child queries of COMPUTE STATS extrapolate from the bytes of the sampled
+      // files, so they must read all of them.
+      if (analyzer.getQueryOptions().isTablesample_within_files()
+          && !analyzer.getQueryCtx().isSetParent_query_id()) {
+        computeUnitSampleRate(sampledFiles, percentBytes, randomSeed);
+      }
     }
 
     long scanRangeBytesLimit = analyzer.getQueryCtx().client_request.getQuery_options()
@@ -1272,9 +1321,12 @@ public class HdfsScanNode extends ScanNode {
     long statsNumRows = getStatsNumRows(analyzer.getQueryOptions());
     if (extrapolatedNumRows_ != -1) {
       // The extrapolated row count is based on the 'totalBytesPerFs_' which already
-      // accounts for table sampling, so no additional adjustment for sampling is
-      // necessary.
+      // accounts for table sampling of files, so only the sampling within files needs
+      // to be applied.
       cardinality_ = extrapolatedNumRows_;
+      if (unitSampleRate_ < 1.0 && cardinality_ > 0) {
+        cardinality_ = Math.max(Math.round(cardinality_ * unitSampleRate_), 1);
+      }
     } else {
       // Set the cardinality based on table or partition stats.
       cardinality_ = statsNumRows;
@@ -1641,6 +1693,10 @@ public class HdfsScanNode extends ScanNode {
     }
     msg.hdfs_scan_node.setDictionary_filter_conjuncts(dictMap);
     msg.hdfs_scan_node.setIs_partition_key_scan(isPartitionKeyScan_);
+    if (unitSampleRate_ < 1.0) {
+      msg.hdfs_scan_node.setSample_rate(unitSampleRate_);
+      msg.hdfs_scan_node.setSample_seed(unitSampleSeed_);
+    }
 
     for (HdfsFileFormat format : fileFormats_) {
       msg.hdfs_scan_node.addToFile_formats(format.toThrift());
@@ -2162,18 +2218,22 @@ public class HdfsScanNode extends ScanNode {
   }
 
   /**
-   * Sort filters in runtimeFilters_: min/max first followed by bloom.
+   * Sort filters in runtimeFilters_: min/max first followed by IN-list and bloom.
    */
   public void arrangeRuntimefiltersForParquet() {
     if (allParquet_) {
       Collections.sort(runtimeFilters_, new Comparator<RuntimeFilter>() {
         @Override
         public int compare(RuntimeFilter a, RuntimeFilter b) {
-          if (a.getType() == b.getType()) return 0;
-          if (a.getType() == TRuntimeFilterType.MIN_MAX
-              && b.getType() == TRuntimeFilterType.BLOOM)
-            return -1;
-          return 1;
+          return Integer.compare(rank(a.getType()), rank(b.getType()));
+        }
+
+        private int rank(TRuntimeFilterType type) {
+          switch (type) {
+            case MIN_MAX: return 0;
+            case IN_LIST: return 1;
+            default: return 2;
+          }
         }
       });
     }
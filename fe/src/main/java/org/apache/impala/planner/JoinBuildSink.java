@@ -82,6 +82,9 @@ public class JoinBuildSink extends DataSink {
       tBuildSink.setEq_join_conjuncts(
           ((HashJoinNode)joinNode_).getThriftEquiJoinConjuncts());
       tBuildSink.setHash_seed(joinNode_.getFragment().getHashSeed());
+      tBuildSink.setIs_switchable_broadcast(
+          ((HashJoinNode)joinNode_).isSwitchableBroadcast());
+      tBuildSink.setDedup_build_keys(((HashJoinNode)joinNode_).canDedupBuildKeys());
     }
     for (RuntimeFilter filter : runtimeFilters_) {
       tBuildSink.addToRuntime_filters(filter.toThrift());
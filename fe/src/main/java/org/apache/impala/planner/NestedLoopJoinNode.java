@@ -17,6 +17,7 @@
 
 package org.apache.impala.planner;
 
+import java.util.ArrayList;
 import java.util.Collections;
 import java.util.List;
 
@@ -24,10 +25,14 @@ import org.apache.impala.analysis.Analyzer;
 import org.apache.impala.analysis.BinaryPredicate;
 import org.apache.impala.analysis.Expr;
 import org.apache.impala.analysis.JoinOperator;
+import org.apache.impala.analysis.SlotRef;
+import org.apache.impala.analysis.TupleId;
+import org.apache.impala.catalog.Type;
 import org.apache.impala.common.ImpalaException;
 import org.apache.impala.common.Pair;
 import org.apache.impala.thrift.TExplainLevel;
 import org.apache.impala.thrift.TNestedLoopJoinNode;
+import org.apache.impala.thrift.TNestedLoopJoinRangeBound;
 import org.apache.impala.thrift.TPlanNode;
 import org.apache.impala.thrift.TPlanNodeType;
 import org.apache.impala.thrift.TQueryOptions;
@@ -128,6 +133,60 @@ public class NestedLoopJoinNode extends JoinNode {
     for (Expr e : otherJoinConjuncts_) {
       msg.join_node.nested_loop_join_node.addToJoin_conjuncts(e.treeToThrift());
     }
+    addRangeBoundsToThrift(msg.join_node.nested_loop_join_node);
+  }
+
+  /**
+   * Looks for join conjuncts of the form '<build slot> <op> <probe expr>', or the
+   * converse, where 'op' is one of <, <=, >= and >. If there are any, the conjuncts on
+   * the build slot of the first one are added to 'msg', so that the backend can sort the
+   * build rows on that slot and only evaluate the join conjuncts on the build rows that
+   * fall into the range bounded by the probe exprs. This covers predicates like
+   * 'a.ts BETWEEN b.start_ts AND b.end_ts' and band predicates written as
+   * 'b.x > a.x - k AND b.x < a.x + k'. Only used for the join modes that evaluate the
+   * join conjuncts of a probe row on all build rows, and for slot types that compare
+   * with a total order.
+   */
+  private void addRangeBoundsToThrift(TNestedLoopJoinNode msg) {
+    if (joinOp_ != JoinOperator.INNER_JOIN && joinOp_ != JoinOperator.LEFT_OUTER_JOIN
+        && joinOp_ != JoinOperator.RIGHT_OUTER_JOIN
+        && joinOp_ != JoinOperator.FULL_OUTER_JOIN) {
+      return;
+    }
+    List<TupleId> probeTids = getChild(0).getTupleIds();
+    List<TupleId> buildTids = getChild(1).getTupleIds();
+    SlotRef buildSlot = null;
+    List<TNestedLoopJoinRangeBound> bounds = new ArrayList<>();
+    for (Expr e : otherJoinConjuncts_) {
+      if (!(e instanceof BinaryPredicate)) continue;
+      BinaryPredicate pred = (BinaryPredicate) e;
+      if (!BinaryPredicate.IS_RANGE_PREDICATE.apply(pred)) continue;
+      BinaryPredicate.Operator op = pred.getOp();
+      Expr buildExpr = pred.getChild(0);
+      Expr probeExpr = pred.getChild(1);
+      if (!(buildExpr instanceof SlotRef)) {
+        op = op.converse();
+        buildExpr = pred.getChild(1);
+        probeExpr = pred.getChild(0);
+      }
+      if (!(buildExpr instanceof SlotRef) || !buildExpr.isBoundByTupleIds(buildTids)
+          || !probeExpr.isBoundByTupleIds(probeTids)) {
+        continue;
+      }
+      Type type = buildExpr.getType();
+      if (!type.equals(probeExpr.getType())) continue;
+      if (!type.isIntegerType() && !type.isDateOrTimeType()) continue;
+      if (buildSlot == null) {
+        buildSlot = (SlotRef) buildExpr;
+      } else if (!buildSlot.getSlotId().equals(((SlotRef) buildExpr).getSlotId())) {
+        continue;
+      }
+      bounds.add(new TNestedLoopJoinRangeBound(op.getThriftOp(),
+          probeExpr.treeToThrift()));
+    }
+    if (buildSlot == null) return;
+    msg.setRange_build_expr(buildSlot.treeToThrift());
+    msg.setRange_bounds(bounds);
   }
 
   @Override
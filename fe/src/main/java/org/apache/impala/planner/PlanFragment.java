@@ -326,7 +326,8 @@ public class PlanFragment extends TreeNode<PlanFragment> {
     }
     for (PlanNode node : collectPlanNodes()) {
       node.computeNodeResourceProfile(analyzer.getQueryOptions());
-      boolean isFilterProducer = node instanceof JoinNode;
+      // Top-n nodes produce the filters for the scans below them.
+      boolean isFilterProducer = node instanceof JoinNode || node instanceof SortNode;
       for (RuntimeFilter filter : node.getRuntimeFilters()) {
         if (isFilterProducer) {
           producedFilters.put(filter.getFilterId(), filter);
@@ -41,12 +41,14 @@ import org.apache.impala.analysis.Predicate;
 import org.apache.impala.analysis.SlotDescriptor;
 import org.apache.impala.analysis.SlotId;
 import org.apache.impala.analysis.SlotRef;
+import org.apache.impala.analysis.SortInfo;
 import org.apache.impala.analysis.TupleDescriptor;
 import org.apache.impala.analysis.TupleId;
 import org.apache.impala.analysis.TupleIsNullPredicate;
 import org.apache.impala.catalog.FeTable;
 import org.apache.impala.catalog.Column;
 import org.apache.impala.catalog.KuduColumn;
+import org.apache.impala.catalog.PrimitiveType;
 import org.apache.impala.catalog.Type;
 import org.apache.impala.common.AnalysisException;
 import org.apache.impala.common.IdGenerator;
@@ -159,8 +161,19 @@ public final class RuntimeFilterGenerator {
   // Contains size limits for bloom filters.
   private FilterSizeLimits bloomFilterSizeLimits_;
 
+  // Maximum number of distinct build values of an IN-list filter. IN-list filters are
+  // only generated if the build side is estimated to have at most this many rows. Zero
+  // disables IN-list filters.
+  private final int inListFilterEntryLimit_;
+
+  // If true, unpartitioned top-n nodes build MIN_MAX filters from the bound of their
+  // heap for their scan child.
+  private final boolean topNRuntimeFilter_;
+
   private RuntimeFilterGenerator(TQueryOptions tQueryOptions) {
     bloomFilterSizeLimits_ = new FilterSizeLimits(tQueryOptions);
+    inListFilterEntryLimit_ = tQueryOptions.getRuntime_in_list_filter_entry_limit();
+    topNRuntimeFilter_ = tQueryOptions.isTopn_runtime_filter();
   };
 
   /**
@@ -175,8 +188,8 @@ public final class RuntimeFilterGenerator {
   public static class RuntimeFilter {
     // Identifier of the filter (unique within a query)
     private final RuntimeFilterId id_;
-    // Join node that builds the filter
-    private final JoinNode src_;
+    // Join node or top-n sort node that builds the filter
+    private final PlanNode src_;
     // Expr (rhs of join predicate) on which the filter is built
     private final Expr srcExpr_;
     // Expr (lhs of join predicate) from which the targetExprs_ are generated.
@@ -295,7 +308,7 @@ public final class RuntimeFilterGenerator {
       }
     }
 
-    private RuntimeFilter(RuntimeFilterId filterId, JoinNode filterSrcNode, Expr srcExpr,
+    private RuntimeFilter(RuntimeFilterId filterId, PlanNode filterSrcNode, Expr srcExpr,
         Expr origTargetExpr, Operator exprCmpOp, Map<TupleId, List<SlotId>> targetSlots,
         TRuntimeFilterType type, FilterSizeLimits filterSizeLimits,
         boolean isTimestampTruncation) {
@@ -346,6 +359,7 @@ public final class RuntimeFilterGenerator {
       tFilter.setApplied_on_partition_columns(appliedOnPartitionColumns);
       tFilter.setType(type_);
       tFilter.setFilter_size_bytes(filterSizeBytes_);
+      if (isTopNFilter()) tFilter.setIs_topn_filter(true);
       return tFilter;
     }
 
@@ -370,6 +384,11 @@ public final class RuntimeFilterGenerator {
           && !Predicate.isSqlEquivalencePredicate(joinPredicate)) {
         return null;
       }
+      if (type == TRuntimeFilterType.IN_LIST
+          && (isTimestampTruncation
+              || !Predicate.isEquivalencePredicate(joinPredicate))) {
+        return null;
+      }
       BinaryPredicate normalizedJoinConjunct = SingleNodePlanner.getNormalizedEqPred(
           joinPredicate, filterSrcNode.getChild(0).getTupleIds(),
           filterSrcNode.getChild(1).getTupleIds(), analyzer);
@@ -398,6 +417,9 @@ public final class RuntimeFilterGenerator {
         }
         srcExpr = toUnixTimeExpr;
       }
+      if (type == TRuntimeFilterType.IN_LIST && !isInListFilterType(srcExpr.getType())) {
+        return null;
+      }
 
       Map<TupleId, List<SlotId>> targetSlots = getTargetSlots(analyzer, targetExpr);
       Preconditions.checkNotNull(targetSlots);
@@ -443,6 +465,55 @@ public final class RuntimeFilterGenerator {
           isTimestampTruncation);
     }
 
+    /**
+     * Static function to create a MIN_MAX RuntimeFilter from the first ordering expr of
+     * the unpartitioned top-n node 'topNNode' for the scan node that is its child. The
+     * top-n publishes the filter once its heap is full, with the bound of the heap as
+     * one end of the range so that the scan skips rows that cannot make it into the
+     * heap. Returns null if no such filter can be generated for 'topNNode'.
+     */
+    public static RuntimeFilter createForTopN(IdGenerator<RuntimeFilterId> idGen,
+        SortNode topNNode, FilterSizeLimits filterSizeLimits) {
+      Preconditions.checkNotNull(idGen);
+      Preconditions.checkState(topNNode.isTypeTopN());
+      Preconditions.checkState(topNNode.getChild(0) instanceof ScanNode);
+      SortInfo sortInfo = topNNode.getSortInfo();
+      // Rows with NULLs in the ordering expr may be in the heap if NULLs sort first, but
+      // a MIN_MAX filter cannot keep them.
+      if (sortInfo.getNullsFirst().get(0)) return null;
+      Expr srcExpr = sortInfo.getSortExprs().get(0);
+      Type type = srcExpr.getType();
+      if (!type.isIntegerType() && !type.isDate() && !type.isTimestamp()) return null;
+      SlotRef srcSlotRef = srcExpr.unwrapSlotRef(false);
+      if (srcSlotRef == null) return null;
+
+      // Find the expr of the scan's rows that is materialized into the sorted slot.
+      List<SlotDescriptor> sortSlots = sortInfo.getSortTupleDescriptor().getSlots();
+      Expr targetExpr = null;
+      for (int i = 0; i < sortSlots.size(); ++i) {
+        if (sortSlots.get(i).getId().equals(srcSlotRef.getSlotId())) {
+          targetExpr = sortInfo.getMaterializedExprs().get(i);
+          break;
+        }
+      }
+      if (targetExpr == null || !targetExpr.getType().equals(type)) return null;
+      SlotRef targetSlotRef = targetExpr.unwrapSlotRef(false);
+      if (targetSlotRef == null) return null;
+      TupleId targetTid = targetSlotRef.getDesc().getParent().getId();
+      if (!topNNode.getChild(0).getTupleIds().contains(targetTid)) return null;
+
+      // Only the scan below the top-n may apply the filter, so the value transfers of
+      // the slot to other tuples are not considered.
+      Map<TupleId, List<SlotId>> targetSlots = new HashMap<>();
+      targetSlots.put(targetTid, Lists.newArrayList(targetSlotRef.getSlotId()));
+      if (LOG.isTraceEnabled()) {
+        LOG.trace("Generating runtime filter from top-n " + topNNode.getId());
+      }
+      return new RuntimeFilter(idGen.getNextId(), topNNode, srcExpr, targetExpr,
+          Operator.EQ, targetSlots, TRuntimeFilterType.MIN_MAX, filterSizeLimits,
+          /* isTimestampTruncation */ false);
+    }
+
     /**
      * Returns the ids of base table tuple slots on which a runtime filter expr can be
      * applied. Due to the existence of equivalence classes, a filter expr may be
@@ -580,7 +651,12 @@ public final class RuntimeFilterGenerator {
 
     public void setIsBroadcast(boolean isBroadcast) { isBroadcastJoin_ = isBroadcast; }
 
-    public void computeNdvEstimate() { ndvEstimate_ = src_.getChild(1).getCardinality(); }
+    public void computeNdvEstimate() {
+      // A top-n filter holds a single range, not the values of a build side.
+      ndvEstimate_ = isTopNFilter() ? -1 : src_.getChild(1).getCardinality();
+    }
+
+    public boolean isTopNFilter() { return src_ instanceof SortNode; }
 
     public void computeHasLocalTargets() {
       Preconditions.checkNotNull(src_.getFragment());
@@ -592,6 +668,14 @@ public final class RuntimeFilterGenerator {
       }
     }
 
+    /**
+     * Returns true if the backend implements IN-list filters on values of 'type'.
+     */
+    private static boolean isInListFilterType(Type type) {
+      return type.isIntegerType() || type.isDate() || type.isVarchar()
+          || type.isScalarType(PrimitiveType.STRING);
+    }
+
     /**
      * Sets the filter size (in bytes) required for a bloom filter to achieve the
      * configured maximum false-positive rate based on the expected NDV. Also bounds the
@@ -599,7 +683,7 @@ public final class RuntimeFilterGenerator {
      * 'filterSizeLimits'.
      */
     private void calculateFilterSize(FilterSizeLimits filterSizeLimits) {
-      if (type_ == TRuntimeFilterType.MIN_MAX) return;
+      if (type_ != TRuntimeFilterType.BLOOM) return;
       if (ndvEstimate_ == -1) {
         filterSizeBytes_ = filterSizeLimits.defaultVal;
         return;
@@ -666,8 +750,10 @@ public final class RuntimeFilterGenerator {
         if (numBloomFilters >= maxNumBloomFilters) continue;
         ++numBloomFilters;
       }
-      filter.setIsBroadcast(
-          filter.src_.getDistributionMode() == DistributionMode.BROADCAST);
+      // Every instance of a top-n publishes a filter that is valid for all of the rows,
+      // like the filters of a broadcast join.
+      filter.setIsBroadcast(filter.isTopNFilter() || ((JoinNode) filter.src_)
+          .getDistributionMode() == DistributionMode.BROADCAST);
       filter.computeHasLocalTargets();
       if (LOG.isTraceEnabled()) LOG.trace("Runtime filter: " + filter.debugString());
       filter.assignToPlanNodes();
@@ -706,6 +792,29 @@ public final class RuntimeFilterGenerator {
     return resultList;
   }
 
+  /**
+   * Returns true if the build side of 'joinNode' is estimated to have few enough rows to
+   * build IN-list filters from it.
+   */
+  private boolean isSmallBuild(JoinNode joinNode) {
+    long buildCardinality = joinNode.getChild(1).getCardinality();
+    return inListFilterEntryLimit_ > 0 && buildCardinality != -1
+        && buildCardinality <= inListFilterEntryLimit_;
+  }
+
+  /**
+   * Returns true if 'node' is an unpartitioned top-n that reads the rows of an HDFS scan
+   * directly, in the same fragment.
+   */
+  private static boolean isTopNOverScan(PlanNode node) {
+    if (!(node instanceof SortNode)) return false;
+    SortNode sortNode = (SortNode) node;
+    if (!sortNode.isTypeTopN() || sortNode.getSortLimit() <= 0) return false;
+    PlanNode child = sortNode.getChild(0);
+    return child instanceof HdfsScanNode
+        && child.getFragment().getId().equals(sortNode.getFragment().getId());
+  }
+
   /**
    * Generates the runtime filters for a query by recursively traversing the distributed
    * plan tree rooted at 'root'. In the top-down traversal of the plan tree, candidate
@@ -729,6 +838,9 @@ public final class RuntimeFilterGenerator {
 
       List<RuntimeFilter> filters = new ArrayList<>();
       for (TRuntimeFilterType filterType : TRuntimeFilterType.values()) {
+        if (filterType == TRuntimeFilterType.IN_LIST && !isSmallBuild(joinNode)) {
+          continue;
+        }
         for (Expr conjunct : joinConjuncts) {
           RuntimeFilter filter =
               RuntimeFilter.create(filterIdGenerator, ctx.getRootAnalyzer(), conjunct,
@@ -760,6 +872,12 @@ public final class RuntimeFilterGenerator {
       // join nodes in case we don't find a destination node in the left subtree.
       for (RuntimeFilter runtimeFilter: filters) finalizeRuntimeFilter(runtimeFilter);
       generateFilters(ctx, root.getChild(1));
+    } else if (topNRuntimeFilter_ && isTopNOverScan(root)) {
+      RuntimeFilter filter = RuntimeFilter.createForTopN(
+          filterIdGenerator, (SortNode) root, bloomFilterSizeLimits_);
+      if (filter != null) registerRuntimeFilter(filter);
+      generateFilters(ctx, root.getChild(0));
+      if (filter != null) finalizeRuntimeFilter(filter);
     } else if (root instanceof ScanNode) {
       assignRuntimeFilters(ctx, (ScanNode) root);
     } else {
@@ -829,6 +947,9 @@ public final class RuntimeFilterGenerator {
    *     b. If the target is a KuduScanNode, the filter could be type MIN_MAX, and/or
    *        BLOOM, the target must be a slot ref on a column, and the comp op cannot
    *        be 'not distinct'.
+   *     c. Filters of type IN_LIST are assigned to either kind of scan node only if
+   *        ENABLED_RUNTIME_FILTER_TYPES is ALL. Kudu requires the target to be a slot
+   *        ref on a column without casting, and the comp op cannot be 'not distinct'.
    * A scan node may be used as a destination node for multiple runtime filters. This
    * method is called once per scan node to process all filters accumulated for it
    * for the entire query, per top-down traversal nature of the calling method
@@ -863,7 +984,18 @@ public final class RuntimeFilterGenerator {
       if (runtimeFilterMode == TRuntimeFilterMode.LOCAL && !isLocalTarget) continue;
 
       // Check that the scan node supports applying filters of this type and targetExpr.
-      if (scanNode instanceof HdfsScanNode) {
+      if (filter.getType() == TRuntimeFilterType.IN_LIST) {
+        if (enabledRuntimeFilterTypes != TEnabledRuntimeFilterTypes.ALL) continue;
+        if (scanNode instanceof KuduScanNode) {
+          // Kudu evaluates IN-list filters as IN-list predicates on a single column,
+          // which cannot return nulls.
+          if (!(targetExpr instanceof SlotRef)
+              || ((SlotRef) targetExpr).getDesc().getColumn() == null
+              || filter.getExprCompOp() == Operator.NOT_DISTINCT) {
+            continue;
+          }
+        }
+      } else if (scanNode instanceof HdfsScanNode) {
         if (filter.isTimestampTruncation()) {
           continue;
         }
@@ -881,9 +1013,11 @@ public final class RuntimeFilterGenerator {
           if (!disable_overlap_filter) {
             // If the filter is not defined on partition columns, try to compute
             // an overlap predicate for it. This predicate will be used to filter
-            // out row groups or pages in Parquet data files.
-            if (!((HdfsScanNode) scanNode)
-                .tryToComputeOverlapPredicate(analyzer, filter, targetExpr)) {
+            // out row groups or pages in Parquet data files. ORC scans use the
+            // filter to skip stripes instead.
+            HdfsScanNode hdfsScanNode = (HdfsScanNode) scanNode;
+            if (!hdfsScanNode.tryToComputeOverlapPredicate(analyzer, filter, targetExpr)
+                && !hdfsScanNode.canSkipOrcStripes(analyzer, filter, targetExpr)) {
               continue;
             }
           } else {
@@ -418,6 +418,10 @@ public class SortNode extends PlanNode {
         output.append(detailPrefix + "source expr: " +
                 limitSrcPred_.toSql(ToSqlOptions.SHOW_IMPLICIT_CASTS) + "\n");
       }
+      if (!runtimeFilters_.isEmpty()) {
+        output.append(detailPrefix + "runtime filters: ");
+        output.append(getRuntimeFilterExplainString(true, detailLevel));
+      }
     }
 
     if (detailLevel.ordinal() >= TExplainLevel.EXTENDED.ordinal()) {
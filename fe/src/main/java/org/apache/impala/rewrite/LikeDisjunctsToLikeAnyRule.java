@@ -0,0 +1,96 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+package org.apache.impala.rewrite;
+
+import java.util.ArrayList;
+import java.util.List;
+
+import org.apache.impala.analysis.Analyzer;
+import org.apache.impala.analysis.Expr;
+import org.apache.impala.analysis.FunctionCallExpr;
+import org.apache.impala.analysis.LikePredicate;
+import org.apache.impala.analysis.StringLiteral;
+
+/**
+ * Coalesces disjunctive LIKE or ILIKE predicates with constant patterns on the same
+ * expression to a single like_any() or ilike_any() call, which the backend evaluates
+ * with a single multi-pattern search instead of one search per pattern. Only applied
+ * if the FUSE_LIKE_DISJUNCTS query option is set.
+ * Examples:
+ * (C LIKE '%a%') OR (C LIKE 'b%') -> like_any(C, '%a%', 'b%')
+ * like_any(C, '%a%', 'b%') OR (C LIKE '%c%') -> like_any(C, '%a%', 'b%', '%c%')
+ * (C ILIKE '%a%') OR (C ILIKE '%b%') -> ilike_any(C, '%a%', '%b%')
+ */
+public class LikeDisjunctsToLikeAnyRule implements ExprRewriteRule {
+
+  public static ExprRewriteRule INSTANCE = new LikeDisjunctsToLikeAnyRule();
+
+  private static final String LIKE_ANY = "like_any";
+  private static final String ILIKE_ANY = "ilike_any";
+
+  @Override
+  public Expr apply(Expr expr, Analyzer analyzer) {
+    if (!analyzer.getQueryCtx().client_request.query_options.fuse_like_disjuncts) {
+      return expr;
+    }
+    if (!Expr.IS_OR_PREDICATE.apply(expr)) return expr;
+
+    String fnName0 = getLikeAnyFnName(expr.getChild(0));
+    String fnName1 = getLikeAnyFnName(expr.getChild(1));
+    if (fnName0 == null || !fnName0.equals(fnName1)) return expr;
+    Expr child0 = expr.getChild(0);
+    Expr child1 = expr.getChild(1);
+    if (!child0.getChild(0).equals(child1.getChild(0))) return expr;
+    if (child0.getChildren().size() + child1.getChildren().size() - 1
+        > Expr.EXPR_CHILDREN_LIMIT) {
+      return expr;
+    }
+
+    List<Expr> params = new ArrayList<>(child0.getChildren());
+    params.addAll(child1.getChildren().subList(1, child1.getChildren().size()));
+    return new FunctionCallExpr(fnName0, params);
+  }
+
+  /**
+   * Returns the name of the like_any() function that 'expr' can be merged into, or null
+   * if it cannot be merged. 'expr' can be merged if it is a LIKE or ILIKE predicate or a
+   * like_any() or ilike_any() call whose patterns are all string literals.
+   */
+  private static String getLikeAnyFnName(Expr expr) {
+    String fnName;
+    if (expr instanceof LikePredicate) {
+      LikePredicate.Operator op = ((LikePredicate) expr).getOp();
+      if (op == LikePredicate.Operator.LIKE) {
+        fnName = LIKE_ANY;
+      } else if (op == LikePredicate.Operator.ILIKE) {
+        fnName = ILIKE_ANY;
+      } else {
+        return null;
+      }
+    } else if (expr instanceof FunctionCallExpr) {
+      fnName = ((FunctionCallExpr) expr).getFnName().getFunction();
+      if (!LIKE_ANY.equals(fnName) && !ILIKE_ANY.equals(fnName)) return null;
+    } else {
+      return null;
+    }
+    for (int i = 1; i < expr.getChildren().size(); ++i) {
+      if (!(expr.getChild(i) instanceof StringLiteral)) return null;
+    }
+    return fnName;
+  }
+}
@@ -54,6 +54,7 @@ import org.apache.iceberg.util.SnapshotUtil;
 import org.apache.impala.analysis.AlterDbStmt;
 import org.apache.impala.analysis.AnalysisContext;
 import org.apache.impala.analysis.AnalysisContext.AnalysisResult;
+import org.apache.impala.analysis.Analyzer;
 import org.apache.impala.analysis.CommentOnStmt;
 import org.apache.impala.analysis.CopyTestCaseStmt;
 import org.apache.impala.analysis.CreateDataSrcStmt;
@@ -1890,6 +1891,9 @@ public class Frontend {
       queryCtx.setDesc_tbl_testonly(
           planner.getAnalysisResult().getAnalyzer().getDescTbl().toThrift());
     }
+    Analyzer analyzer = planner.getAnalysisResult().getAnalyzer();
+    queryCtx.setResults_are_nondeterministic(analyzer.resultsAreNondeterministic());
+    queryCtx.setPlan_is_query_specific(analyzer.planIsQuerySpecific());
     queryExecRequest.setQuery_ctx(queryCtx);
     queryExecRequest.setHost_list(analysisResult.getAnalyzer().getHostIndex().getList());
     return queryExecRequest;
@@ -129,6 +129,9 @@ public class AnalyzerTest extends FrontendTestBase {
     testNonNullable();
     testMixedNullable();
     testNonMaterializedSlots();
+    testHotSlots();
+    testMisalignedHotSlots();
+    testNonMaterializedHotSlots();
   }
 
   private void testSelectStar() throws AnalysisException {
@@ -248,6 +251,107 @@ public class AnalyzerTest extends FrontendTestBase {
     checkLayoutParams("functional.date_tbl.date_part", 4, 0, 4, 0, analyzer);
   }
 
+  /**
+   * Tests that computeMemLayout() places the hot slots first. The small cold slots are
+   * moved to the hot slots, so that the 16-byte timestamp slot stays 8-byte aligned.
+   */
+  private void testHotSlots() throws AnalysisException {
+    SelectStmt stmt = (SelectStmt) AnalyzesOk("select * from functional.alltypes");
+    Analyzer analyzer = stmt.getAnalyzer();
+    DescriptorTable descTbl = analyzer.getDescTbl();
+    TupleDescriptor tupleDesc = descTbl.getTupleDesc(new TupleId(0));
+    tupleDesc.materializeSlots();
+    analyzer.getSlotDescriptor("functional.alltypes.bigint_col").setIsHot(true);
+    analyzer.getSlotDescriptor("functional.alltypes.int_col").setIsHot(true);
+    descTbl.computeMemLayout();
+
+    // The reordering changes neither the tuple size nor the null indicators, which
+    // are still assigned in slot order at the end of the tuple.
+    assertEquals(82, tupleDesc.getByteSize());
+    assertEquals(89.0f, tupleDesc.getAvgSerializedSize(), 0.0);
+    checkLayoutParams("functional.alltypes.bigint_col", 8, 0, 80, 0, analyzer);
+    checkLayoutParams("functional.alltypes.int_col", 4, 8, 80, 1, analyzer);
+    checkLayoutParams("functional.alltypes.smallint_col", 2, 12, 80, 2, analyzer);
+    checkLayoutParams("functional.alltypes.bool_col", 1, 14, 80, 3, analyzer);
+    checkLayoutParams("functional.alltypes.tinyint_col", 1, 15, 80, 4, analyzer);
+    checkLayoutParams("functional.alltypes.timestamp_col", 16, 16, 80, 5, analyzer);
+    checkLayoutParams("functional.alltypes.date_string_col", 12, 32, 80, 6, analyzer);
+    checkLayoutParams("functional.alltypes.string_col", 12, 44, 80, 7, analyzer);
+    checkLayoutParams("functional.alltypes.double_col", 8, 56, 81, 0, analyzer);
+    checkLayoutParams("functional.alltypes.id", 4, 64, 81, 1, analyzer);
+    checkLayoutParams("functional.alltypes.float_col", 4, 68, 81, 2, analyzer);
+    checkLayoutParams("functional.alltypes.year", 4, 72, 81, 3, analyzer);
+    checkLayoutParams("functional.alltypes.month", 4, 76, 81, 4, analyzer);
+  }
+
+  /**
+   * Tests that computeMemLayout() keeps the default layout if placing the hot slots
+   * first would misalign a fixed-length slot behind the variable-length string slots.
+   */
+  private void testMisalignedHotSlots() throws AnalysisException {
+    SelectStmt stmt = (SelectStmt) AnalyzesOk("select * from functional.alltypes");
+    Analyzer analyzer = stmt.getAnalyzer();
+    DescriptorTable descTbl = analyzer.getDescTbl();
+    TupleDescriptor tupleDesc = descTbl.getTupleDesc(new TupleId(0));
+    tupleDesc.materializeSlots();
+    // With string_col and int_col first, bigint_col would be at offset 44.
+    analyzer.getSlotDescriptor("functional.alltypes.string_col").setIsHot(true);
+    analyzer.getSlotDescriptor("functional.alltypes.int_col").setIsHot(true);
+    descTbl.computeMemLayout();
+
+    assertEquals(82, tupleDesc.getByteSize());
+    checkLayoutParams("functional.alltypes.timestamp_col", 16, 0, 80, 0, analyzer);
+    checkLayoutParams("functional.alltypes.date_string_col", 12, 16, 80, 1, analyzer);
+    checkLayoutParams("functional.alltypes.string_col", 12, 28, 80, 2, analyzer);
+    checkLayoutParams("functional.alltypes.bigint_col", 8, 40, 80, 3, analyzer);
+    checkLayoutParams("functional.alltypes.double_col", 8, 48, 80, 4, analyzer);
+    checkLayoutParams("functional.alltypes.id", 4, 56, 80, 5, analyzer);
+    checkLayoutParams("functional.alltypes.int_col", 4, 60, 80, 6, analyzer);
+    checkLayoutParams("functional.alltypes.float_col", 4, 64, 80, 7, analyzer);
+    checkLayoutParams("functional.alltypes.year", 4, 68, 81, 0, analyzer);
+    checkLayoutParams("functional.alltypes.month", 4, 72, 81, 1, analyzer);
+    checkLayoutParams("functional.alltypes.smallint_col", 2, 76, 81, 2, analyzer);
+    checkLayoutParams("functional.alltypes.bool_col", 1, 78, 81, 3, analyzer);
+    checkLayoutParams("functional.alltypes.tinyint_col", 1, 79, 81, 4, analyzer);
+  }
+
+  /**
+   * Tests that hot slots that are not materialized are ignored by computeMemLayout().
+   */
+  private void testNonMaterializedHotSlots() throws AnalysisException {
+    SelectStmt stmt = (SelectStmt) AnalyzesOk("select * from functional.alltypes");
+    Analyzer analyzer = stmt.getAnalyzer();
+    DescriptorTable descTbl = analyzer.getDescTbl();
+    TupleDescriptor tupleDesc = descTbl.getTupleDesc(new TupleId(0));
+    tupleDesc.materializeSlots();
+    // Mark slots 0 (id), 7 (double_col), 9 (string_col) as non-materialized.
+    List<SlotDescriptor> slots = tupleDesc.getSlots();
+    slots.get(0).setIsMaterialized(false);
+    slots.get(7).setIsMaterialized(false);
+    slots.get(9).setIsMaterialized(false);
+    slots.get(0).setIsHot(true);
+    analyzer.getSlotDescriptor("functional.alltypes.int_col").setIsHot(true);
+    descTbl.computeMemLayout();
+
+    assertEquals(58, tupleDesc.getByteSize());
+    assertEquals(64.0f, tupleDesc.getAvgSerializedSize(), 0.0);
+    // Check non-materialized slots.
+    checkLayoutParams("functional.alltypes.id", 0, -1, 0, 0, analyzer);
+    checkLayoutParams("functional.alltypes.double_col", 0, -1, 0, 0, analyzer);
+    checkLayoutParams("functional.alltypes.string_col", 0, -1, 0, 0, analyzer);
+    // Check materialized slots.
+    checkLayoutParams("functional.alltypes.int_col", 4, 0, 56, 0, analyzer);
+    checkLayoutParams("functional.alltypes.smallint_col", 2, 4, 56, 1, analyzer);
+    checkLayoutParams("functional.alltypes.bool_col", 1, 6, 56, 2, analyzer);
+    checkLayoutParams("functional.alltypes.tinyint_col", 1, 7, 56, 3, analyzer);
+    checkLayoutParams("functional.alltypes.timestamp_col", 16, 8, 56, 4, analyzer);
+    checkLayoutParams("functional.alltypes.date_string_col", 12, 24, 56, 5, analyzer);
+    checkLayoutParams("functional.alltypes.bigint_col", 8, 36, 56, 6, analyzer);
+    checkLayoutParams("functional.alltypes.float_col", 4, 44, 56, 7, analyzer);
+    checkLayoutParams("functional.alltypes.year", 4, 48, 57, 0, analyzer);
+    checkLayoutParams("functional.alltypes.month", 4, 52, 57, 1, analyzer);
+  }
+
   private void checkLayoutParams(SlotDescriptor d, int byteSize, int byteOffset,
       int nullIndicatorByte, int nullIndicatorBit) {
     assertEquals(byteSize, d.getByteSize());
@@ -923,4 +1027,48 @@ public class AnalyzerTest extends FrontendTestBase {
     AnalysisError("alter table functional.bucketed_table add columns(col3 int)",
         errorMsgBucketed);
   }
+
+  /**
+   * Checks that the analyzer records calls that make the results or the plan of a
+   * statement specific to one execution, also in the definitions of views and after
+   * expr rewrites folded the calls into literals.
+   */
+  @Test
+  public void TestQuerySpecificStmts() {
+    addTestView("create view functional.rand_view as " +
+        "select * from functional.alltypes where rand() < 0.5");
+    addTestView("create view functional.now_view as " +
+        "select now() n, * from functional.alltypes");
+    addTestFunction("TestFn", Type.INT, false);
+    checkQuerySpecific("select count(*) from functional.alltypes", false, false);
+    checkQuerySpecific("select abs(int_col) from functional.alltypes", false, false);
+    checkQuerySpecific(
+        "select * from functional.alltypes tablesample system(10) repeatable(1)",
+        false, false);
+    checkQuerySpecific("select rand(), rand(1), uuid()", true, false);
+    checkQuerySpecific("select appx_median(int_col) from functional.alltypes",
+        true, false);
+    checkQuerySpecific("select count(*) from functional.rand_view", true, false);
+    checkQuerySpecific("select default.TestFn(int_col) from functional.alltypes",
+        true, false);
+    checkQuerySpecific("select now()", true, true);
+    checkQuerySpecific("select unix_timestamp()", true, true);
+    checkQuerySpecific("select unix_timestamp(timestamp_col) from functional.alltypes",
+        false, false);
+    checkQuerySpecific("select * from functional.alltypes where timestamp_col < " +
+        "current_timestamp()", true, true);
+    checkQuerySpecific("select count(*) from functional.now_view", true, true);
+    checkQuerySpecific("select * from functional.alltypes tablesample system(10)",
+        true, true);
+  }
+
+  private void checkQuerySpecific(String stmt, boolean resultsAreNondeterministic,
+      boolean planIsQuerySpecific) {
+    AnalysisContext ctx = createAnalysisCtx();
+    AnalyzesOk(stmt, ctx);
+    Analyzer analyzer = ctx.getAnalyzer();
+    assertEquals(stmt, resultsAreNondeterministic,
+        analyzer.resultsAreNondeterministic());
+    assertEquals(stmt, planIsQuerySpecific, analyzer.planIsQuerySpecific());
+  }
 }
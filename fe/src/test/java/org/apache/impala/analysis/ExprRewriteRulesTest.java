@@ -39,6 +39,7 @@ import org.apache.impala.rewrite.ExprRewriter;
 import org.apache.impala.rewrite.ExtractCommonConjunctRule;
 import org.apache.impala.rewrite.ExtractCompoundVerticalBarExprRule;
 import org.apache.impala.rewrite.FoldConstantsRule;
+import org.apache.impala.rewrite.LikeDisjunctsToLikeAnyRule;
 import org.apache.impala.rewrite.NormalizeBinaryPredicatesRule;
 import org.apache.impala.rewrite.NormalizeCountStarRule;
 import org.apache.impala.rewrite.NormalizeExprsRule;
@@ -749,6 +750,40 @@ public class ExprRewriteRulesTest extends FrontendTestBase {
         edToInrule, null);
   }
 
+  @Test
+  public void testLikeDisjunctsToLikeAnyRule() throws ImpalaException {
+    ExprRewriteRule rule = LikeDisjunctsToLikeAnyRule.INSTANCE;
+
+    // The rule only applies with the query option.
+    RewritesOk("string_col like '%a%' or string_col like '%b%'", rule, null);
+
+    session.options().setFuse_like_disjuncts(true);
+    RewritesOk("string_col like '%a%' or string_col like '%b%'", rule,
+        "like_any(string_col, '%a%', '%b%')");
+    RewritesOk("string_col like '%a%' or string_col like 'b%' or string_col like '_c'",
+        rule, "like_any(string_col, '%a%', 'b%', '_c')");
+    RewritesOk("(string_col like '%a%' or string_col like '%b%') or "
+        + "(string_col like '%c%' or string_col like '%d%')", rule,
+        "like_any(string_col, '%a%', '%b%', '%c%', '%d%')");
+    RewritesOk("string_col ilike '%a%' or string_col ilike '%b%'", rule,
+        "ilike_any(string_col, '%a%', '%b%')");
+    RewritesOk("upper(string_col) like '%A%' or upper(string_col) like '%B%'", rule,
+        "like_any(upper(string_col), '%A%', '%B%')");
+
+    // cases where rewrite should happen partially
+    RewritesOk("string_col like '%a%' or string_col like '%b%' or int_col = 1", rule,
+        "like_any(string_col, '%a%', '%b%') OR int_col = 1");
+
+    // no rewrite
+    RewritesOk("string_col like '%a%' or string_col ilike '%b%'", rule, null);
+    RewritesOk("string_col like '%a%' or date_string_col like '%b%'", rule, null);
+    RewritesOk("string_col like '%a%' or string_col like date_string_col", rule, null);
+    RewritesOk("string_col like '%a%' or string_col regexp 'b'", rule, null);
+    RewritesOk("string_col like '%a%' or string_col not like '%b%'", rule, null);
+    RewritesOk("string_col like '%a%' and string_col like '%b%'", rule, null);
+    session.options().setFuse_like_disjuncts(false);
+  }
+
   @Test
   public void testNormalizeCountStarRule() throws ImpalaException {
     ExprRewriteRule rule = NormalizeCountStarRule.INSTANCE;
@@ -458,6 +458,44 @@ public class UdfExecutorTest {
     freeAllocations();
   }
 
+  @Test
+  // Tests that evaluateBatch() evaluates the UDF over every row of the batch buffers.
+  public void BatchTest() throws ImpalaException, TException {
+    int numRows = 3;
+    TFunction fn = ScalarFunction.createForTesting("default", "fn",
+        Lists.<Type>newArrayList(Type.INT), Type.INT, "", TestUdf.class.getName(),
+        null, null, TFunctionBinaryType.JAVA).toThrift();
+    THiveUdfExecutorCtorParams params = new THiveUdfExecutorCtorParams(fn, "",
+        Lists.newArrayList(0), allocate(1), allocate(8), allocate(1), allocate(4));
+    long inputNullsPtr = allocate(numRows);
+    long inputBufferPtr = allocate(8 * numRows);
+    long outputNullPtr = allocate(numRows);
+    long outputBufferPtr = allocate(4 * numRows);
+    params.setBatch_capacity(numRows);
+    params.setInput_byte_sizes(Lists.newArrayList(8));
+    params.setBatch_input_nulls_ptr(inputNullsPtr);
+    params.setBatch_input_buffer_ptr(inputBufferPtr);
+    params.setBatch_output_null_ptr(outputNullPtr);
+    params.setBatch_output_buffer_ptr(outputBufferPtr);
+    params.setOutput_byte_size(4);
+    TSerializer serializer = new TSerializer(PROTOCOL_FACTORY);
+    UdfExecutor e = new UdfExecutor(serializer.serialize(params));
+
+    // The second row is NULL.
+    for (int i = 0; i < numRows; ++i) {
+      UnsafeUtil.UNSAFE.putByte(inputNullsPtr + i, (byte)(i == 1 ? 1 : 0));
+      UnsafeUtil.UNSAFE.putInt(inputBufferPtr + 8 * i, 10 * i + 1);
+    }
+    e.evaluateBatch(numRows);
+    for (int i = 0; i < numRows; ++i) {
+      Assert.assertEquals(i == 1 ? 1 : 0, UnsafeUtil.UNSAFE.getByte(outputNullPtr + i));
+      if (i == 1) continue;
+      Assert.assertEquals(10 * i + 1, UnsafeUtil.UNSAFE.getInt(outputBufferPtr + 4 * i));
+    }
+    e.close();
+    freeAllocations();
+  }
+
   @Test
   // Test identity for all types
   public void BasicTest()
@@ -0,0 +1,224 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+package org.apache.impala.extdatasource.util;
+
+import java.math.BigDecimal;
+import java.math.BigInteger;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.sql.Timestamp;
+import java.util.ArrayList;
+
+import org.apache.impala.thrift.TColumnData;
+
+/**
+ * Builds a TColumnData in the Arrow columnar layout, which the impalad copies into its
+ * tuples without converting every value on its own. See TColumnData.arrow_values for
+ * the encoding of the column types. All columns of a row batch must be built with this
+ * class and TRowBatch.num_rows must be set to the number of rows of the columns.
+ *
+ * A builder is created with the factory method for the type of the column and values
+ * are appended with the append method that matches the type, e.g. appendInt() for INT
+ * and DATE columns and appendLong() for BIGINT columns.
+ */
+public class ArrowColumnBuilder {
+  private static final int INITIAL_CAPACITY = 1024;
+
+  private ByteBuffer values_ = allocate(INITIAL_CAPACITY);
+  private ByteBuffer validity_ = allocate(INITIAL_CAPACITY / 8);
+  private ByteBuffer offsets_;
+  private int numRows_ = 0;
+  private int numNulls_ = 0;
+  private final boolean isBoolean_;
+  // The width of the values of fixed-width types, 0 for BOOLEAN and STRING.
+  private final int width_;
+
+  private ArrowColumnBuilder(boolean isBoolean, boolean isString, int width) {
+    isBoolean_ = isBoolean;
+    width_ = width;
+    if (isString) {
+      offsets_ = allocate(INITIAL_CAPACITY);
+      offsets_.putInt(0);
+    }
+  }
+
+  public static ArrowColumnBuilder forBoolean() {
+    return new ArrowColumnBuilder(true, false, 0);
+  }
+
+  public static ArrowColumnBuilder forString() {
+    return new ArrowColumnBuilder(false, true, 0);
+  }
+
+  /**
+   * Returns a builder for a type with values of 'width' bytes, e.g. 4 for INT, FLOAT
+   * and DATE or 16 for DECIMAL.
+   */
+  public static ArrowColumnBuilder forFixedWidth(int width) {
+    return new ArrowColumnBuilder(false, false, width);
+  }
+
+  public int getNumRows() { return numRows_; }
+
+  public void appendNull() {
+    ++numNulls_;
+    if (offsets_ != null) {
+      offsets_ = ensureRemaining(offsets_, 4);
+      offsets_.putInt(values_.position());
+    } else if (!isBoolean_) {
+      // Fixed-width columns have a value for null rows too.
+      values_ = ensureRemaining(values_, width_);
+      for (int i = 0; i < width_; ++i) values_.put((byte) 0);
+    }
+    appendRow(false);
+  }
+
+  public void appendBoolean(boolean value) {
+    appendRow(true);
+    if (value) setBit(values_, numRows_ - 1);
+  }
+
+  public void appendByte(byte value) {
+    values_ = ensureRemaining(values_, 1);
+    values_.put(value);
+    appendRow(true);
+  }
+
+  public void appendShort(short value) {
+    values_ = ensureRemaining(values_, 2);
+    values_.putShort(value);
+    appendRow(true);
+  }
+
+  /**
+   * Appends an INT value or a DATE value as the number of days since the epoch.
+   */
+  public void appendInt(int value) {
+    values_ = ensureRemaining(values_, 4);
+    values_.putInt(value);
+    appendRow(true);
+  }
+
+  public void appendLong(long value) {
+    values_ = ensureRemaining(values_, 8);
+    values_.putLong(value);
+    appendRow(true);
+  }
+
+  public void appendFloat(float value) {
+    values_ = ensureRemaining(values_, 4);
+    values_.putFloat(value);
+    appendRow(true);
+  }
+
+  public void appendDouble(double value) {
+    values_ = ensureRemaining(values_, 8);
+    values_.putDouble(value);
+    appendRow(true);
+  }
+
+  /**
+   * Appends a TIMESTAMP value as the number of microseconds since the epoch.
+   */
+  public void appendTimestamp(Timestamp timestamp) {
+    long seconds = Math.floorDiv(timestamp.getTime(), 1000L);
+    appendLong(seconds * 1000000L + timestamp.getNanos() / 1000);
+  }
+
+  /**
+   * Appends a DECIMAL value, whose scale must be the scale of the column.
+   */
+  public void appendDecimal(BigDecimal decimal) {
+    BigInteger unscaled = decimal.unscaledValue();
+    if (unscaled.bitLength() > 127) {
+      throw new IllegalArgumentException("Decimal value does not fit into 16 bytes");
+    }
+    values_ = ensureRemaining(values_, 16);
+    values_.putLong(unscaled.longValue());
+    values_.putLong(unscaled.shiftRight(64).longValue());
+    appendRow(true);
+  }
+
+  public void appendString(byte[] value) {
+    values_ = ensureRemaining(values_, value.length);
+    values_.put(value);
+    offsets_ = ensureRemaining(offsets_, 4);
+    offsets_.putInt(values_.position());
+    appendRow(true);
+  }
+
+  /**
+   * Returns the column with all appended rows.
+   */
+  public TColumnData build() {
+    TColumnData col = new TColumnData().setIs_null(new ArrayList<Boolean>());
+    if (isBoolean_) {
+      values_.position(bitmapBytes(numRows_));
+    }
+    col.setArrow_values(flip(values_));
+    if (numNulls_ > 0) {
+      validity_.position(bitmapBytes(numRows_));
+      col.setArrow_validity(flip(validity_));
+    }
+    if (offsets_ != null) col.setArrow_offsets(flip(offsets_));
+    return col;
+  }
+
+  /**
+   * Adds a row with the given validity.
+   */
+  private void appendRow(boolean isValid) {
+    int bitmapBytes = bitmapBytes(numRows_ + 1);
+    validity_ = ensureCapacity(validity_, bitmapBytes);
+    if (isValid) setBit(validity_, numRows_);
+    if (isBoolean_) values_ = ensureCapacity(values_, bitmapBytes);
+    ++numRows_;
+  }
+
+  private static int bitmapBytes(int numBits) { return (numBits + 7) / 8; }
+
+  private static void setBit(ByteBuffer bitmap, int idx) {
+    bitmap.put(idx / 8, (byte) (bitmap.get(idx / 8) | (1 << (idx % 8))));
+  }
+
+  private static ByteBuffer allocate(int capacity) {
+    return ByteBuffer.allocate(capacity).order(ByteOrder.LITTLE_ENDIAN);
+  }
+
+  /**
+   * Returns 'buffer' or a copy of it with at least 'capacity' bytes.
+   */
+  private static ByteBuffer ensureCapacity(ByteBuffer buffer, int capacity) {
+    if (buffer.capacity() >= capacity) return buffer;
+    ByteBuffer result = allocate(Math.max(capacity, 2 * buffer.capacity()));
+    result.put(buffer.array(), 0, buffer.capacity());
+    result.position(buffer.position());
+    return result;
+  }
+
+  private static ByteBuffer ensureRemaining(ByteBuffer buffer, int bytes) {
+    return ensureCapacity(buffer, buffer.position() + bytes);
+  }
+
+  /**
+   * Returns a buffer with the bytes of 'buffer' up to its position.
+   */
+  private static ByteBuffer flip(ByteBuffer buffer) {
+    return ByteBuffer.wrap(buffer.array(), 0, buffer.position()).slice();
+  }
+}
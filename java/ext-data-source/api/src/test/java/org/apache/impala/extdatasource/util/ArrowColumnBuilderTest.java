@@ -0,0 +1,229 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+package org.apache.impala.extdatasource.util;
+
+import static org.junit.Assert.*;
+
+import java.math.BigDecimal;
+import java.math.BigInteger;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.charset.StandardCharsets;
+import java.sql.Timestamp;
+
+import org.apache.impala.thrift.TColumnData;
+import org.junit.Test;
+
+/**
+ * Unit tests for ArrowColumnBuilder. Checks the buffers of the built columns against
+ * the layout documented at TColumnData.arrow_values.
+ */
+public class ArrowColumnBuilderTest {
+
+  private static ByteBuffer values(TColumnData col) {
+    return ByteBuffer.wrap(col.getArrow_values()).order(ByteOrder.LITTLE_ENDIAN);
+  }
+
+  private static ByteBuffer offsets(TColumnData col) {
+    return ByteBuffer.wrap(col.getArrow_offsets()).order(ByteOrder.LITTLE_ENDIAN);
+  }
+
+  @Test
+  public void testFixedWidth() {
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forFixedWidth(4);
+    builder.appendInt(1);
+    builder.appendNull();
+    builder.appendInt(-2);
+    assertEquals(3, builder.getNumRows());
+    TColumnData col = builder.build();
+    assertTrue(col.getIs_null().isEmpty());
+    assertFalse(col.isSetArrow_offsets());
+    // Null rows have a zero value.
+    ByteBuffer values = values(col);
+    assertEquals(12, values.remaining());
+    assertEquals(1, values.getInt(0));
+    assertEquals(0, values.getInt(4));
+    assertEquals(-2, values.getInt(8));
+    assertArrayEquals(new byte[] {0x05}, col.getArrow_validity());
+  }
+
+  @Test
+  public void testNoNulls() {
+    // The validity bitmap is omitted if there are no nulls.
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forFixedWidth(8);
+    builder.appendLong(Long.MIN_VALUE);
+    builder.appendLong(Long.MAX_VALUE);
+    TColumnData col = builder.build();
+    assertFalse(col.isSetArrow_validity());
+    assertEquals(Long.MIN_VALUE, values(col).getLong(0));
+    assertEquals(Long.MAX_VALUE, values(col).getLong(8));
+  }
+
+  @Test
+  public void testAllFixedWidthTypes() {
+    ArrowColumnBuilder tinyints = ArrowColumnBuilder.forFixedWidth(1);
+    tinyints.appendByte((byte) -1);
+    tinyints.appendNull();
+    assertArrayEquals(new byte[] {-1, 0}, tinyints.build().getArrow_values());
+
+    ArrowColumnBuilder smallints = ArrowColumnBuilder.forFixedWidth(2);
+    smallints.appendShort((short) 0x1234);
+    assertArrayEquals(new byte[] {0x34, 0x12}, smallints.build().getArrow_values());
+
+    ArrowColumnBuilder floats = ArrowColumnBuilder.forFixedWidth(4);
+    floats.appendFloat(1.5f);
+    floats.appendNull();
+    floats.appendFloat(-0.25f);
+    TColumnData col = floats.build();
+    assertEquals(1.5f, values(col).getFloat(0), 0);
+    assertEquals(-0.25f, values(col).getFloat(8), 0);
+    assertArrayEquals(new byte[] {0x05}, col.getArrow_validity());
+
+    ArrowColumnBuilder doubles = ArrowColumnBuilder.forFixedWidth(8);
+    doubles.appendDouble(Double.MAX_VALUE);
+    assertEquals(Double.MAX_VALUE, values(doubles.build()).getDouble(0), 0);
+
+    // DATE values are days since the epoch.
+    ArrowColumnBuilder dates = ArrowColumnBuilder.forFixedWidth(4);
+    dates.appendInt(-719162);
+    assertEquals(-719162, values(dates.build()).getInt(0));
+  }
+
+  @Test
+  public void testBoolean() {
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forBoolean();
+    builder.appendBoolean(true);
+    builder.appendBoolean(false);
+    builder.appendNull();
+    builder.appendBoolean(true);
+    TColumnData col = builder.build();
+    // Values and validity are bitmaps, least significant bit first.
+    assertArrayEquals(new byte[] {0x09}, col.getArrow_values());
+    assertArrayEquals(new byte[] {0x0B}, col.getArrow_validity());
+    assertFalse(col.isSetArrow_offsets());
+  }
+
+  @Test
+  public void testString() {
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forString();
+    builder.appendString("ab".getBytes(StandardCharsets.UTF_8));
+    builder.appendNull();
+    builder.appendString(new byte[0]);
+    builder.appendString("cde".getBytes(StandardCharsets.UTF_8));
+    TColumnData col = builder.build();
+    assertArrayEquals("abcde".getBytes(StandardCharsets.UTF_8), col.getArrow_values());
+    // Null and empty values have equal start and end offsets.
+    ByteBuffer offsets = offsets(col);
+    assertEquals(5 * 4, offsets.remaining());
+    int[] expectedOffsets = {0, 2, 2, 2, 5};
+    for (int i = 0; i < expectedOffsets.length; ++i) {
+      assertEquals(expectedOffsets[i], offsets.getInt(4 * i));
+    }
+    assertArrayEquals(new byte[] {0x0D}, col.getArrow_validity());
+
+    // A column without rows has a single offset.
+    col = ArrowColumnBuilder.forString().build();
+    assertEquals(0, col.getArrow_values().length);
+    assertArrayEquals(new byte[4], col.getArrow_offsets());
+  }
+
+  @Test
+  public void testTimestamp() {
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forFixedWidth(8);
+    Timestamp withNanos = new Timestamp(1234L);
+    withNanos.setNanos(234567891);
+    builder.appendTimestamp(withNanos);
+    // Timestamps before the epoch round towards negative infinity.
+    builder.appendTimestamp(new Timestamp(-1L));
+    builder.appendNull();
+    TColumnData col = builder.build();
+    // Nanoseconds are truncated to microseconds.
+    assertEquals(1234567L, values(col).getLong(0));
+    assertEquals(-1000L, values(col).getLong(8));
+    assertEquals(0L, values(col).getLong(16));
+    assertArrayEquals(new byte[] {0x03}, col.getArrow_validity());
+  }
+
+  @Test
+  public void testDecimal() {
+    ArrowColumnBuilder builder = ArrowColumnBuilder.forFixedWidth(16);
+    builder.appendDecimal(new BigDecimal("-1.5"));
+    BigInteger large = BigInteger.ONE.shiftLeft(100).add(BigInteger.valueOf(7));
+    builder.appendDecimal(new BigDecimal(large, 2));
+    TColumnData col = builder.build();
+    // 16 byte two's complement of the unscaled value, low 8 bytes first.
+    ByteBuffer values = values(col);
+    assertEquals(32, values.remaining());
+    assertEquals(-15L, values.getLong(0));
+    assertEquals(-1L, values.getLong(8));
+    assertEquals(7L, values.getLong(16));
+    assertEquals(1L << 36, values.getLong(24));
+
+    try {
+      builder.appendDecimal(new BigDecimal(BigInteger.ONE.shiftLeft(127)));
+      fail("Expected IllegalArgumentException");
+    } catch (IllegalArgumentException e) {
+      assertTrue(e.getMessage().contains("does not fit"));
+    }
+    assertEquals(2, builder.getNumRows());
+  }
+
+  @Test
+  public void testGrowth() {
+    // Appends more rows than fit into the initial buffers.
+    final int numRows = 10000;
+    ArrowColumnBuilder ints = ArrowColumnBuilder.forFixedWidth(4);
+    ArrowColumnBuilder strings = ArrowColumnBuilder.forString();
+    ArrowColumnBuilder bools = ArrowColumnBuilder.forBoolean();
+    for (int i = 0; i < numRows; ++i) {
+      if (i % 3 == 0) {
+        ints.appendNull();
+        strings.appendNull();
+        bools.appendNull();
+      } else {
+        ints.appendInt(i);
+        strings.appendString(Integer.toString(i).getBytes(StandardCharsets.UTF_8));
+        bools.appendBoolean(i % 2 == 0);
+      }
+    }
+    TColumnData intCol = ints.build();
+    TColumnData stringCol = strings.build();
+    TColumnData boolCol = bools.build();
+    assertEquals(numRows * 4, intCol.getArrow_values().length);
+    assertEquals((numRows + 7) / 8, intCol.getArrow_validity().length);
+    assertEquals((numRows + 7) / 8, boolCol.getArrow_values().length);
+    assertEquals((numRows + 1) * 4, stringCol.getArrow_offsets().length);
+
+    ByteBuffer intValues = values(intCol);
+    byte[] stringValues = stringCol.getArrow_values();
+    ByteBuffer stringOffsets = offsets(stringCol);
+    for (int i = 0; i < numRows; ++i) {
+      boolean isValid = i % 3 != 0;
+      assertEquals(isValid, (intCol.getArrow_validity()[i / 8] & (1 << (i % 8))) != 0);
+      assertEquals(isValid,
+          (stringCol.getArrow_validity()[i / 8] & (1 << (i % 8))) != 0);
+      assertEquals(isValid ? i : 0, intValues.getInt(4 * i));
+      boolean boolValue = (boolCol.getArrow_values()[i / 8] & (1 << (i % 8))) != 0;
+      assertEquals(isValid && i % 2 == 0, boolValue);
+      int start = stringOffsets.getInt(4 * i);
+      int end = stringOffsets.getInt(4 * (i + 1));
+      String value = new String(stringValues, start, end - start, StandardCharsets.UTF_8);
+      assertEquals(isValid ? Integer.toString(i) : "", value);
+    }
+  }
+}
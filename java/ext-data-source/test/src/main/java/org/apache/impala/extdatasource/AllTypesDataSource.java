@@ -19,6 +19,7 @@ package org.apache.impala.extdatasource;
 
 import java.math.BigDecimal;
 import java.math.BigInteger;
+import java.nio.charset.StandardCharsets;
 import java.sql.Timestamp;
 import java.util.List;
 import java.util.UUID;
@@ -35,6 +36,7 @@ import org.apache.impala.extdatasource.thrift.TPrepareParams;
 import org.apache.impala.extdatasource.thrift.TPrepareResult;
 import org.apache.impala.extdatasource.thrift.TRowBatch;
 import org.apache.impala.extdatasource.thrift.TTableSchema;
+import org.apache.impala.extdatasource.util.ArrowColumnBuilder;
 import org.apache.impala.extdatasource.util.SerializationUtils;
 import org.apache.impala.extdatasource.v1.ExternalDataSource;
 import org.apache.impala.thrift.TColumnData;
@@ -54,6 +56,9 @@ import com.google.common.collect.Lists;
  *     not actually evaluated) and returns trivial data of all supported types for
  *     query tests.
  * (b) Validate the predicates offered by Impala.
+ * If the init string is COLUMNAR_INIT_STRING, the row batches are returned in the
+ * Arrow columnar layout built by ArrowColumnBuilder. The rows are the same, except that
+ * every 7th TIMESTAMP value is NULL, so that a fixed-width column with NULLs is tested.
  */
 public class AllTypesDataSource implements ExternalDataSource {
   // Total number of rows to return
@@ -63,6 +68,9 @@ public class AllTypesDataSource implements ExternalDataSource {
   private static final int INITIAL_BATCH_SIZE = 500;
   private static final int BATCH_SIZE_INCREMENT = 100;
 
+  // Init string that selects the Arrow columnar layout for the row batches.
+  private static final String COLUMNAR_INIT_STRING = "COLUMNAR";
+
   private static final TStatus STATUS_OK =
       new TStatus(TErrorCode.OK, Lists.<String>newArrayList());
 
@@ -73,6 +81,7 @@ public class AllTypesDataSource implements ExternalDataSource {
   private DataSourceState state_;
   private String scanHandle_;
   private String validatePredicatesResult_;
+  private boolean columnar_;
 
   // Enumerates the states of the data source.
   private enum DataSourceState {
@@ -176,6 +185,7 @@ public class AllTypesDataSource implements ExternalDataSource {
     state_ = DataSourceState.OPENED;
     batchSize_ = INITIAL_BATCH_SIZE;
     schema_ = params.getRow_schema();
+    columnar_ = COLUMNAR_INIT_STRING.equals(params.getInit_string());
     // Need to check validatePredicates again because the call in Prepare() was from
     // the frontend and used a different instance of this data source class.
     if (validatePredicates(params.getPredicates())) {
@@ -215,15 +225,29 @@ public class AllTypesDataSource implements ExternalDataSource {
     }
 
     List<TColumnData> cols = Lists.newArrayList();
-    for (int i = 0; i < schema_.getColsSize(); ++i) {
-      cols.add(new TColumnData().setIs_null(Lists.<Boolean>newArrayList()));
-    }
-
     int numAdded = 0;
-    while (currRow_ < NUM_ROWS_RETURNED && numAdded < batchSize_) {
-      addRow(cols);
-      ++numAdded;
-      ++currRow_;
+    if (columnar_) {
+      List<ArrowColumnBuilder> builders = Lists.newArrayList();
+      for (TColumnDesc colDesc : schema_.getCols()) {
+        builders.add(createColumnBuilder(getScalarType(colDesc)));
+      }
+      while (currRow_ < NUM_ROWS_RETURNED && numAdded < batchSize_) {
+        for (int i = 0; i < builders.size(); ++i) {
+          appendValue(getScalarType(schema_.getCols().get(i)), builders.get(i));
+        }
+        ++numAdded;
+        ++currRow_;
+      }
+      for (ArrowColumnBuilder builder : builders) cols.add(builder.build());
+    } else {
+      for (int i = 0; i < schema_.getColsSize(); ++i) {
+        cols.add(new TColumnData().setIs_null(Lists.<Boolean>newArrayList()));
+      }
+      while (currRow_ < NUM_ROWS_RETURNED && numAdded < batchSize_) {
+        addRow(cols);
+        ++numAdded;
+        ++currRow_;
+      }
     }
 
     batchSize_ += BATCH_SIZE_INCREMENT;
@@ -313,6 +337,98 @@ public class AllTypesDataSource implements ExternalDataSource {
     }
   }
 
+  /**
+   * Returns the scalar type of the column 'colDesc'. Throws if the type is not scalar.
+   */
+  private static TScalarType getScalarType(TColumnDesc colDesc) {
+    TColumnType type = colDesc.getType();
+    if (type.types.get(0).getType() != TTypeNodeType.SCALAR) {
+      throw new UnsupportedOperationException("Unsupported column type: " +
+          type.types.get(0).getType());
+    }
+    Preconditions.checkState(type.getTypesSize() == 1);
+    return type.types.get(0).scalar_type;
+  }
+
+  /**
+   * Returns a builder for a columnar column of 'scalarType'.
+   */
+  private static ArrowColumnBuilder createColumnBuilder(TScalarType scalarType) {
+    switch (scalarType.type) {
+      case BOOLEAN: return ArrowColumnBuilder.forBoolean();
+      case STRING: return ArrowColumnBuilder.forString();
+      case TINYINT: return ArrowColumnBuilder.forFixedWidth(1);
+      case SMALLINT: return ArrowColumnBuilder.forFixedWidth(2);
+      case INT:
+      case DATE:
+      case FLOAT:
+        return ArrowColumnBuilder.forFixedWidth(4);
+      case BIGINT:
+      case DOUBLE:
+      case TIMESTAMP:
+        return ArrowColumnBuilder.forFixedWidth(8);
+      case DECIMAL: return ArrowColumnBuilder.forFixedWidth(16);
+      default:
+        throw new UnsupportedOperationException("Unsupported column type: " +
+            scalarType.getType());
+    }
+  }
+
+  /**
+   * Appends the value of the current row to 'builder', a columnar column of
+   * 'scalarType'. The values are those of addRow(), apart from the NULL timestamps.
+   */
+  private void appendValue(TScalarType scalarType, ArrowColumnBuilder builder) {
+    switch (scalarType.type) {
+      case TINYINT:
+        builder.appendByte((byte) (currRow_ % 10));
+        break;
+      case SMALLINT:
+        builder.appendShort((short) (currRow_ % 100));
+        break;
+      case INT:
+      case DATE:
+        builder.appendInt(currRow_);
+        break;
+      case BIGINT:
+        builder.appendLong((long) currRow_ * 10);
+        break;
+      case DOUBLE:
+        builder.appendDouble(currRow_);
+        break;
+      case FLOAT:
+        builder.appendFloat((float) (1.1 * currRow_));
+        break;
+      case STRING:
+        if (currRow_ % 5 == 0) {
+          builder.appendNull();
+        } else {
+          builder.appendString(String.valueOf(currRow_).getBytes(StandardCharsets.UTF_8));
+        }
+        break;
+      case BOOLEAN:
+        builder.appendBoolean(currRow_ % 2 == 0);
+        break;
+      case TIMESTAMP:
+        if (currRow_ % 7 == 0) {
+          builder.appendNull();
+        } else {
+          builder.appendTimestamp(new Timestamp(currRow_));
+        }
+        break;
+      case DECIMAL:
+        BigInteger maxUnscaled = BigInteger.TEN.pow(scalarType.getPrecision());
+        BigInteger val = maxUnscaled.subtract(BigInteger.valueOf(currRow_ + 1));
+        val = val.mod(maxUnscaled);
+        if (currRow_ % 2 == 0) val = val.negate();
+        builder.appendDecimal(new BigDecimal(val));
+        break;
+      default:
+        throw new UnsupportedOperationException("Unsupported column type: " +
+            scalarType.getType());
+    }
+  }
+
   @Override
   public TCloseResult close(TCloseParams params) {
     Preconditions.checkState(state_ == DataSourceState.OPENED);
@@ -0,0 +1,308 @@
+#!/usr/bin/env impala-python
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# Writes testdata/parquet_bloom_filter/parquet_bloom_filter.parquet, a Parquet file
+# with split block Bloom filters for every column chunk. Neither Impala nor the Hive
+# in the minicluster write Bloom filters, so the file is encoded here following the
+# Parquet format specification. The file has three row groups of ten rows and the
+# columns
+#   id BIGINT (INT64), int_col INT (INT32), name STRING (BYTE_ARRAY)
+# Row 'i' of row group 'r' has id = 3 * i + r, int_col = 2 * id and name = 'name<id>'.
+# The id ranges of the row groups overlap, so they cannot be pruned with min/max
+# statistics, which are not written anyway.
+#
+# Usage: generate-parquet-bloom-filter.py [output file]
+
+import os
+import struct
+import sys
+
+NUM_ROW_GROUPS = 3
+ROWS_PER_ROW_GROUP = 10
+BLOOM_FILTER_BYTES = 256
+
+# Parquet enums.
+INT32 = 1
+INT64 = 2
+BYTE_ARRAY = 6
+REQUIRED = 0
+UTF8 = 0
+PLAIN = 0
+RLE = 3
+UNCOMPRESSED = 0
+DATA_PAGE = 0
+
+# Types of the Thrift compact protocol.
+CT_I32 = 5
+CT_I64 = 6
+CT_BINARY = 8
+CT_LIST = 9
+CT_STRUCT = 12
+
+MASK64 = 0xFFFFFFFFFFFFFFFF
+PRIME64_1 = 0x9E3779B185EBCA87
+PRIME64_2 = 0xC2B2AE3D27D4EB4F
+PRIME64_3 = 0x165667B19E3779F9
+PRIME64_4 = 0x85EBCA77C2B2AE63
+PRIME64_5 = 0x27D4EB2F165667C5
+
+SALT = [0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+        0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31]
+
+
+def rotl64(x, r):
+  return ((x << r) | (x >> (64 - r))) & MASK64
+
+
+def xxh64_round(acc, lane):
+  acc = (acc + lane * PRIME64_2) & MASK64
+  return (rotl64(acc, 31) * PRIME64_1) & MASK64
+
+
+def xxh64_merge(acc, val):
+  acc ^= xxh64_round(0, val)
+  return (acc * PRIME64_1 + PRIME64_4) & MASK64
+
+
+def xxh64(data, seed=0):
+  """XXH64 of the bytearray 'data' as in the xxHash specification."""
+  length = len(data)
+  p = 0
+  if length >= 32:
+    v = [(seed + PRIME64_1 + PRIME64_2) & MASK64, (seed + PRIME64_2) & MASK64,
+         seed, (seed - PRIME64_1) & MASK64]
+    while p + 32 <= length:
+      for i in range(4):
+        v[i] = xxh64_round(v[i], struct.unpack_from('<Q', data, p)[0])
+        p += 8
+    h = (rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18)) \
+        & MASK64
+    for i in range(4):
+      h = xxh64_merge(h, v[i])
+  else:
+    h = (seed + PRIME64_5) & MASK64
+  h = (h + length) & MASK64
+  while p + 8 <= length:
+    h ^= xxh64_round(0, struct.unpack_from('<Q', data, p)[0])
+    h = (rotl64(h, 27) * PRIME64_1 + PRIME64_4) & MASK64
+    p += 8
+  if p + 4 <= length:
+    h ^= (struct.unpack_from('<I', data, p)[0] * PRIME64_1) & MASK64
+    h = (rotl64(h, 23) * PRIME64_2 + PRIME64_3) & MASK64
+    p += 4
+  while p < length:
+    h ^= (data[p] * PRIME64_5) & MASK64
+    h = (rotl64(h, 11) * PRIME64_1) & MASK64
+    p += 1
+  h ^= h >> 33
+  h = (h * PRIME64_2) & MASK64
+  h ^= h >> 29
+  h = (h * PRIME64_3) & MASK64
+  h ^= h >> 32
+  return h
+
+
+class SplitBlockBloomFilter(object):
+  """The split block Bloom filter of the Parquet specification."""
+  def __init__(self, num_bytes):
+    self.words = [0] * (num_bytes // 4)
+    self.num_blocks = num_bytes // 32
+
+  def _bits(self, h):
+    block = ((h >> 32) * self.num_blocks) >> 32
+    key = h & 0xFFFFFFFF
+    for i in range(8):
+      yield block * 8 + i, 1 << (((key * SALT[i]) & 0xFFFFFFFF) >> 27)
+
+  def insert(self, h):
+    for word, bit in self._bits(h):
+      self.words[word] |= bit
+
+  def find(self, h):
+    return all(self.words[word] & bit for word, bit in self._bits(h))
+
+  def serialize(self):
+    return bytearray(struct.pack('<%dI' % len(self.words), *self.words))
+
+
+class CompactWriter(object):
+  """Minimal writer of Thrift structs in the compact protocol. A struct is a list of
+  (field id, compact type, value) tuples in field id order. Values of structs are
+  lists of fields, values of lists are (element type, list of values) pairs."""
+  def __init__(self):
+    self.buf = bytearray()
+
+  def varint(self, n):
+    while True:
+      if n < 0x80:
+        self.buf.append(n)
+        return
+      self.buf.append((n & 0x7F) | 0x80)
+      n >>= 7
+
+  def zigzag(self, n):
+    self.varint((n << 1) ^ (n >> 63) if n < 0 else n << 1)
+
+  def value(self, ctype, value):
+    if ctype in (CT_I32, CT_I64):
+      self.zigzag(value)
+    elif ctype == CT_BINARY:
+      self.varint(len(value))
+      self.buf += value
+    elif ctype == CT_LIST:
+      elem_type, elems = value
+      if len(elems) < 15:
+        self.buf.append((len(elems) << 4) | elem_type)
+      else:
+        self.buf.append(0xF0 | elem_type)
+        self.varint(len(elems))
+      for elem in elems:
+        self.value(elem_type, elem)
+    else:
+      assert ctype == CT_STRUCT
+      self.struct(value)
+
+  def struct(self, fields):
+    last_id = 0
+    for field_id, ctype, value in fields:
+      if value is None: continue
+      assert 0 < field_id - last_id <= 15
+      self.buf.append(((field_id - last_id) << 4) | ctype)
+      self.value(ctype, value)
+      last_id = field_id
+    self.buf.append(0)
+
+
+def serialize(fields):
+  writer = CompactWriter()
+  writer.struct(fields)
+  return writer.buf
+
+
+def plain_encode(parquet_type, value):
+  if parquet_type == INT32:
+    return bytearray(struct.pack('<i', value))
+  if parquet_type == INT64:
+    return bytearray(struct.pack('<q', value))
+  assert parquet_type == BYTE_ARRAY
+  return bytearray(value)
+
+
+def column_values(row_group):
+  ids = [3 * i + row_group for i in range(ROWS_PER_ROW_GROUP)]
+  return [('id', INT64, ids),
+          ('int_col', INT32, [2 * x for x in ids]),
+          ('name', BYTE_ARRAY, [('name%d' % x).encode('ascii') for x in ids])]
+
+
+def main():
+  out_path = sys.argv[1] if len(sys.argv) > 1 else os.path.join(
+      os.environ['IMPALA_HOME'],
+      'testdata/parquet_bloom_filter/parquet_bloom_filter.parquet')
+  out = bytearray(b'PAR1')
+  row_groups = []
+  # Column metadata fields of every column chunk, completed with the offsets of the
+  # Bloom filters once they are written.
+  chunks = []
+  for rg in range(NUM_ROW_GROUPS):
+    rg_chunks = []
+    rg_bytes = 0
+    for name, parquet_type, values in column_values(rg):
+      data = bytearray()
+      bloom_filter = SplitBlockBloomFilter(BLOOM_FILTER_BYTES)
+      for value in values:
+        encoded = plain_encode(parquet_type, value)
+        bloom_filter.insert(xxh64(encoded))
+        if parquet_type == BYTE_ARRAY:
+          data += bytearray(struct.pack('<i', len(encoded)))
+        data += encoded
+      page_header = serialize([
+          (1, CT_I32, DATA_PAGE),
+          (2, CT_I32, len(data)),
+          (3, CT_I32, len(data)),
+          (5, CT_STRUCT, [
+              (1, CT_I32, len(values)),
+              (2, CT_I32, PLAIN),
+              (3, CT_I32, RLE),
+              (4, CT_I32, RLE)])])
+      offset = len(out)
+      out += page_header + data
+      chunk_size = len(page_header) + len(data)
+      rg_bytes += chunk_size
+      rg_chunks.append({'name': name, 'type': parquet_type, 'offset': offset,
+          'size': chunk_size, 'num_values': len(values), 'bloom_filter': bloom_filter})
+    chunks.append(rg_chunks)
+    row_groups.append(rg_bytes)
+
+  # The Bloom filters follow the column data, as written by parquet-mr.
+  for rg_chunks in chunks:
+    for chunk in rg_chunks:
+      header = serialize([
+          (1, CT_I32, BLOOM_FILTER_BYTES),
+          (2, CT_STRUCT, [(1, CT_STRUCT, [])]),
+          (3, CT_STRUCT, [(1, CT_STRUCT, [])]),
+          (4, CT_STRUCT, [(1, CT_STRUCT, [])])])
+      chunk['bloom_filter_offset'] = len(out)
+      bitset = chunk['bloom_filter'].serialize()
+      chunk['bloom_filter_length'] = len(header) + len(bitset)
+      out += header + bitset
+
+  schema = [[(4, CT_BINARY, b'schema'), (5, CT_I32, 3)]]
+  for name, parquet_type, _ in column_values(0):
+    schema.append([
+        (1, CT_I32, parquet_type),
+        (3, CT_I32, REQUIRED),
+        (4, CT_BINARY, name.encode('ascii')),
+        (6, CT_I32, UTF8 if parquet_type == BYTE_ARRAY else None)])
+  thrift_row_groups = []
+  for rg_chunks, rg_bytes in zip(chunks, row_groups):
+    columns = []
+    for chunk in rg_chunks:
+      columns.append([
+          (2, CT_I64, chunk['offset']),
+          (3, CT_STRUCT, [
+              (1, CT_I32, chunk['type']),
+              (2, CT_LIST, (CT_I32, [PLAIN, RLE])),
+              (3, CT_LIST, (CT_BINARY, [chunk['name'].encode('ascii')])),
+              (4, CT_I32, UNCOMPRESSED),
+              (5, CT_I64, chunk['num_values']),
+              (6, CT_I64, chunk['size']),
+              (7, CT_I64, chunk['size']),
+              (9, CT_I64, chunk['offset']),
+              (14, CT_I64, chunk['bloom_filter_offset']),
+              (15, CT_I32, chunk['bloom_filter_length'])])])
+    thrift_row_groups.append([
+        (1, CT_LIST, (CT_STRUCT, columns)),
+        (2, CT_I64, rg_bytes),
+        (3, CT_I64, ROWS_PER_ROW_GROUP)])
+  footer = serialize([
+      (1, CT_I32, 1),
+      (2, CT_LIST, (CT_STRUCT, schema)),
+      (3, CT_I64, NUM_ROW_GROUPS * ROWS_PER_ROW_GROUP),
+      (4, CT_LIST, (CT_STRUCT, thrift_row_groups)),
+      (6, CT_BINARY, b'generate-parquet-bloom-filter.py')])
+  out += footer
+  out += bytearray(struct.pack('<i', len(footer)))
+  out += b'PAR1'
+  with open(out_path, 'wb') as f:
+    f.write(out)
+
+
+if __name__ == '__main__':
+  main()
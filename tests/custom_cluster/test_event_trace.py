@@ -0,0 +1,66 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import json
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+
+class TestEventTrace(CustomClusterTestSuite):
+  """Tests the per-query event traces of the /query_trace page."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __get_trace(self, impalad, query_id=None):
+    page = "query_trace" if query_id is None else "query_trace?query_id=" + query_id
+    return json.loads(impalad.service.read_debug_webpage(page))
+
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--event_trace_records_per_thread=10000")
+  def test_query_trace(self):
+    query = """select l_returnflag, count(*) from tpch.lineitem
+        group by l_returnflag order by 1"""
+    result = self.execute_query(query, {'mt_dop': 0})
+    query_id = result.query_id
+    names = set()
+    for impalad in self.cluster.impalads:
+      trace = self.__get_trace(impalad, query_id)
+      events = trace["traceEvents"]
+      for event in events:
+        if event["ph"] == "X":
+          assert event["args"]["query_id"] == query_id
+          assert event["dur"] >= 0
+          names.add(event["name"])
+        else:
+          assert event["ph"] == "M"
+    assert "DiskIoMgr::Read" in names, names
+    assert "ScanRange::GetNext" in names, names
+    assert "DataStreamSender::Send" in names, names
+    assert "DataStreamRecvr::GetBatch" in names, names
+
+    # Events of other queries are not returned.
+    trace = self.__get_trace(self.cluster.impalads[0], "1:2")
+    assert not [e for e in trace["traceEvents"] if e["ph"] == "X"]
+    # An invalid query id returns an error.
+    assert "error" in self.__get_trace(self.cluster.impalads[0], "invalid")
+
+  @CustomClusterTestSuite.with_args(impalad_args="--event_trace_records_per_thread=0")
+  def test_tracing_disabled(self):
+    trace = self.__get_trace(self.cluster.impalads[0])
+    assert "disabled" in trace["error"]
@@ -0,0 +1,123 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import pytest
+import re
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+from tests.common.skip import SkipIf
+from tests.util.filesystem_utils import WAREHOUSE
+
+CACHE_ARGS = "--fragment_result_cache_dir=/tmp --fragment_result_cache_capacity=1GB"
+
+
+@SkipIf.not_hdfs
+class TestFragmentResultCache(CustomClusterTestSuite):
+  """Tests the executors' fragment result cache. Runs with a single impalad, so that
+  every scan fragment has a single instance and is eligible for caching."""
+
+  QUERY_OPTS = {'enable_fragment_result_cache': True,
+                'exec_single_node_rows_threshold': 0}
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __run(self, query, query_options={}):
+    """Runs 'query' with the fragment result cache enabled. Returns the result and the
+    lists of the FragmentResultCacheHits and FragmentResultCacheMisses counters of the
+    fragment instances that looked up the cache."""
+    result = self.execute_query(query, dict(self.QUERY_OPTS, **query_options))
+    hits = [int(h) for h in
+        re.findall(r'FragmentResultCacheHits: ([0-9]*)', result.runtime_profile)]
+    misses = [int(m) for m in
+        re.findall(r'FragmentResultCacheMisses: ([0-9]*)', result.runtime_profile)]
+    return result, hits, misses
+
+  def __create_table(self, unique_database, data):
+    """Creates a text table with a single file that contains 'data'."""
+    tbl = unique_database + ".t"
+    self.tbl_path = "%s/%s.db/t" % (WAREHOUSE, unique_database)
+    self.execute_query("create table %s (i int) stored as textfile location '%s'"
+        % (tbl, self.tbl_path))
+    self.__write_file(tbl, data)
+    return tbl
+
+  def __write_file(self, tbl, data):
+    """Replaces the data file of 'tbl' with 'data' and refreshes the table."""
+    self.filesystem_client.create_file("%s/data.txt" % self.tbl_path[1:], data,
+        overwrite=True)
+    self.execute_query("refresh %s" % tbl)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=CACHE_ARGS, cluster_size=1)
+  def test_hit_and_file_changes(self, vector, unique_database):
+    tbl = self.__create_table(unique_database, "1\n2\n2\n3\n")
+    query = "select i, count(*) from %s group by i order by i" % tbl
+    expected = ["1\t1", "2\t2", "3\t1"]
+
+    # The scan and pre-aggregation fragment is cached by the first execution and read
+    # from the cache by the second one.
+    result, hits, misses = self.__run(query)
+    assert result.data == expected
+    assert sum(hits) == 0 and sum(misses) == 1
+    result, hits, misses = self.__run(query)
+    assert result.data == expected
+    assert sum(hits) == 1 and sum(misses) == 0
+    assert "Fragment Result Cache: Hit" in result.runtime_profile
+
+    # Rewriting the file with the same contents changes its mtime.
+    self.__write_file(tbl, "1\n2\n2\n3\n")
+    result, hits, misses = self.__run(query)
+    assert result.data == expected
+    assert sum(hits) == 0 and sum(misses) == 1
+
+    # Changed contents are never read from the cache.
+    self.__write_file(tbl, "1\n2\n2\n3\n3\n3\n")
+    result, hits, misses = self.__run(query)
+    assert result.data == ["1\t1", "2\t2", "3\t3"]
+    assert sum(hits) == 0 and sum(misses) == 1
+    result, hits, misses = self.__run(query)
+    assert result.data == ["1\t1", "2\t2", "3\t3"]
+    assert sum(hits) == 1 and sum(misses) == 0
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=CACHE_ARGS, cluster_size=1)
+  def test_uncacheable_fragments(self, vector, unique_database):
+    tbl = self.__create_table(unique_database, "1\n2\n2\n3\n")
+
+    # Which rows pass a limit depends on the order of the scan ranges.
+    for _ in range(2):
+      result, hits, misses = self.__run("select i from %s limit 2" % tbl)
+      assert len(result.data) == 2
+      assert hits == [] and misses == []
+
+    # Both scans of a shuffle join are cached without runtime filters. With runtime
+    # filters, the scan of the probe side is not cached.
+    query = "select count(*) from %s a join [shuffle] %s b on a.i = b.i" % (tbl, tbl)
+    result, hits, misses = self.__run(query, {'runtime_filter_mode': 'OFF'})
+    assert result.data == ["6"]
+    assert len(misses) == 2
+    result, hits, misses = self.__run(query, {'runtime_filter_mode': 'GLOBAL'})
+    assert result.data == ["6"]
+    assert len(hits) == 1 and len(misses) == 1
+
+    # Non-deterministic functions make the whole query uncacheable.
+    for _ in range(2):
+      result, hits, misses = self.__run(
+          "select count(*) from %s where i < rand() * 10" % tbl)
+      assert hits == [] and misses == []
@@ -0,0 +1,51 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import pytest
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+class TestHashJoinConfigurations(CustomClusterTestSuite):
+  """Tests to exercise non-default hash join build configurations end-to-end."""
+
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestHashJoinConfigurations, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format == 'parquet')
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--hash_join_build_cluster_bytes=64")
+  def test_clustered_build(self, vector):
+    """With tiny clusters, all but the smallest hash tables are built a cluster of four
+    buckets at a time."""
+    self.run_test_case('QueryTest/joins', vector)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--hash_join_direct_index_max_entries=1000000")
+  def test_direct_join_index(self, vector):
+    """Joins on dense integer keys look up their probe rows through a direct join
+    index."""
+    self.run_test_case('QueryTest/joins', vector)
+    result = self.execute_query("select count(*) from functional.alltypes a "
+        "join functional.alltypessmall b on a.id = b.id")
+    assert result.data == ['100']
+    assert "DirectJoinIndexEntries: 100 " in result.runtime_profile
@@ -0,0 +1,85 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import pytest
+import re
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+from tests.common.skip import (SkipIf, SkipIfS3, SkipIfABFS, SkipIfADLS,
+                               SkipIfIsilon, SkipIfGCS, SkipIfLocal)
+
+# A small caching size, so that every region needs several batches of results.
+QUERY_OPTS = {'num_nodes': 1, 'hbase_caching': 100}
+
+AGG_QUERY = """
+select count(*), count(int_col), sum(int_col), count(string_col), max(string_col),
+  count(timestamp_col), max(timestamp_col)
+from {0}.alltypesagg"""
+
+
+@SkipIfS3.hbase
+@SkipIfGCS.hbase
+@SkipIfABFS.hbase
+@SkipIfADLS.hbase
+@SkipIfIsilon.hbase
+@SkipIfLocal.hbase
+@SkipIf.skip_hbase
+class TestHBaseScanner(CustomClusterTestSuite):
+  """Tests that HBase scans return the same results whether or not the ResultScanners
+  of the following regions are opened ahead and the HBase client prefetches results."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __get_counter(self, profile, name):
+    return sum(int(v) for v in re.findall(r'%s: ([0-9]*)' % name, profile))
+
+  def __check_scans(self, expect_scanners_opened_ahead):
+    result = self.execute_query(
+        "select count(*), sum(int_col), min(id), max(id) "
+        "from functional_hbase.alltypes", QUERY_OPTS)
+    assert result.data == ['7300\t32850\t0\t7299']
+    profile = result.runtime_profile
+    # At least one batch per 100 rows and one empty batch at the end of each region.
+    assert self.__get_counter(profile, 'HBaseTableScanner.ResultBatches') > 73
+    scanners_opened_ahead = self.__get_counter(
+        profile, 'HBaseTableScanner.ScannersOpenedAhead')
+    if expect_scanners_opened_ahead:
+      assert scanners_opened_ahead > 0
+    else:
+      assert scanners_opened_ahead == 0
+
+    # Rows with NULL values have fewer cells than requested, which are decoded
+    # differently than complete rows.
+    hbase_result = self.execute_query(AGG_QUERY.format('functional_hbase'), QUERY_OPTS)
+    hdfs_result = self.execute_query(AGG_QUERY.format('functional'))
+    assert hbase_result.data == hdfs_result.data
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--hbase_scanners_in_flight=4 --hbase_scan_async_prefetch=true",
+      cluster_size=1)
+  def test_scanners_in_flight(self, vector):
+    self.__check_scans(True)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--hbase_scanners_in_flight=1 --hbase_scan_async_prefetch=false",
+      cluster_size=1)
+  def test_sequential_scanners(self, vector):
+    self.__check_scans(False)
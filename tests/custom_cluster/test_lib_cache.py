@@ -0,0 +1,137 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import os
+import pytest
+import shutil
+import tempfile
+import time
+from subprocess import check_call
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+from tests.util.filesystem_utils import get_fs_path
+
+LOCAL_LIBRARY_DIR = os.path.join(tempfile.gettempdir(), 'impala-test-lib-cache')
+PERSISTENT_DIR = os.path.join(LOCAL_LIBRARY_DIR, 'impala-lib-cache')
+USAGE_INDEX = os.path.join(PERSISTENT_DIR, 'usage-index')
+PERSISTENT_ARGS = "--lib_cache_persistent=true --local_library_dir=%s" % \
+    LOCAL_LIBRARY_DIR
+
+SO_PATH = get_fs_path('/test-warehouse/libTestUdfs.so')
+IR_PATH = get_fs_path('/test-warehouse/test-udfs.ll')
+
+
+class TestLibCache(CustomClusterTestSuite):
+  """Tests the local copies of UDF libraries that the library cache keeps across
+  restarts with --lib_cache_persistent, and that the default mode is unchanged."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def setup_method(self, method):
+    # Every test starts without copies of a previous test.
+    shutil.rmtree(LOCAL_LIBRARY_DIR, ignore_errors=True)
+    os.makedirs(LOCAL_LIBRARY_DIR)
+    super(TestLibCache, self).setup_method(method)
+
+  def __create_functions(self, db, so_path=SO_PATH):
+    self.execute_query("create function {0}.so_identity(int) returns int "
+        "location '{1}' symbol='Identity'".format(db, so_path))
+    self.execute_query("create function {0}.ir_identity(int) returns int "
+        "location '{1}' symbol='Identity'".format(db, IR_PATH))
+
+  def __check_functions(self, client, db):
+    query = "select {0}.so_identity(1), {0}.ir_identity(2)".format(db)
+    # IR functions require codegen.
+    result = self.execute_query_expect_success(client, query,
+        {'disable_codegen': False, 'disable_codegen_rows_threshold': 0})
+    assert result.data == ['1\t2']
+
+  def __persisted_copies(self, stem):
+    """Returns the names of the persisted copies of the libraries named 'stem'."""
+    return sorted(name for name in os.listdir(PERSISTENT_DIR)
+        if name.startswith(stem + '.') and not name.endswith('.tmp'))
+
+  def __inode(self, name):
+    return os.stat(os.path.join(PERSISTENT_DIR, name)).st_ino
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=PERSISTENT_ARGS, cluster_size=1)
+  def test_restart(self, vector, unique_database):
+    """Checks that a restarted impalad prefetches the libraries that were used before
+    and uses the persisted copies instead of copying the libraries again."""
+    self.__create_functions(unique_database)
+    self.__check_functions(self.client, unique_database)
+    so_copies = self.__persisted_copies('libTestUdfs')
+    ir_copies = self.__persisted_copies('test-udfs')
+    assert len(so_copies) == 1 and so_copies[0].endswith('.so'), so_copies
+    assert len(ir_copies) == 1 and ir_copies[0].endswith('.ll'), ir_copies
+    so_inode = self.__inode(so_copies[0])
+    ir_inode = self.__inode(ir_copies[0])
+    with open(USAGE_INDEX) as index:
+      indexed_paths = [line.rstrip('\n').split('\t')[2] for line in index]
+    # The index has the locations as stored by the catalog, with the file system prefix.
+    for path in ['/test-warehouse/libTestUdfs.so', '/test-warehouse/test-udfs.ll']:
+      assert any(p.endswith(path) for p in indexed_paths), indexed_paths
+
+    # The index is written when a library is added, so it survives a crash.
+    impalad = self.cluster.impalads[0]
+    impalad.restart()
+    self.assert_impalad_log_contains('INFO', 'Prefetched 2 of 2 libraries')
+    client = impalad.service.create_beeswax_client()
+    try:
+      self.__check_functions(client, unique_database)
+    finally:
+      client.close()
+    # A copy is renamed into place, so an unchanged inode means it was not copied again.
+    assert self.__persisted_copies('libTestUdfs') == so_copies
+    assert self.__persisted_copies('test-udfs') == ir_copies
+    assert self.__inode(so_copies[0]) == so_inode
+    assert self.__inode(ir_copies[0]) == ir_inode
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=PERSISTENT_ARGS, cluster_size=1)
+  def test_new_version(self, vector, unique_database):
+    """Checks that a new version of a library replaces the persisted copy of the old
+    one."""
+    so_path = get_fs_path('/test-warehouse/{0}.db/udfs.so'.format(unique_database))
+    check_call(['hadoop', 'fs', '-cp', '-f', SO_PATH, so_path])
+    self.__create_functions(unique_database, so_path)
+    self.__check_functions(self.client, unique_database)
+    old_copies = self.__persisted_copies('udfs')
+    assert len(old_copies) == 1, old_copies
+
+    # The copies are named after the modification time in seconds.
+    time.sleep(1)
+    self.execute_query("drop function {0}.so_identity(int)".format(unique_database))
+    check_call(['hadoop', 'fs', '-cp', '-f', SO_PATH, so_path])
+    self.execute_query("create function {0}.so_identity(int) returns int "
+        "location '{1}' symbol='Identity'".format(unique_database, so_path))
+    self.__check_functions(self.client, unique_database)
+    new_copies = self.__persisted_copies('udfs')
+    assert len(new_copies) == 1, new_copies
+    assert new_copies != old_copies
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--local_library_dir=%s" % LOCAL_LIBRARY_DIR, cluster_size=1)
+  def test_not_persistent(self, vector, unique_database):
+    """Checks that nothing is persisted by default."""
+    self.__create_functions(unique_database)
+    self.__check_functions(self.client, unique_database)
+    assert not os.path.exists(PERSISTENT_DIR)
@@ -0,0 +1,113 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import pytest
+import time
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+QUERY_OPTS = {'use_plan_cache': True}
+CACHE_ARGS = "--plan_cache_capacity=64MB --plan_cache_entry_ttl_s=600"
+
+
+class TestPlanCache(CustomClusterTestSuite):
+  """Tests the coordinator's plan cache. Runs with a single impalad, so that all
+  queries are planned and cached by the same coordinator."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __run(self, query, expected_cache_state):
+    """Runs 'query' with the plan cache enabled, checks that the profile reports
+    'expected_cache_state' and returns the result."""
+    result = self.execute_query(query, QUERY_OPTS)
+    assert "Plan Cache: %s\n" % expected_cache_state in result.runtime_profile
+    return result
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=CACHE_ARGS, cluster_size=1)
+  def test_hit(self, vector):
+    query = "select count(*), sum(int_col) from functional.alltypes where id < 100"
+    miss = self.__run(query, "Miss, stored")
+    hit = self.__run(query, "Hit")
+    assert hit.data == miss.data
+    assert hit.data == ["100\t450"]
+    # The planner did not run for the hit.
+    assert "Single node plan created" in miss.runtime_profile
+    assert "Single node plan created" not in hit.runtime_profile
+    assert self.get_metric('plan-cache.hit-count') == 1
+    assert self.get_metric('plan-cache.num-entries') == 1
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=CACHE_ARGS, cluster_size=1)
+  def test_invalidation(self, vector, unique_database):
+    tbl = unique_database + ".t"
+    self.execute_query("create table %s (i int)" % tbl)
+    self.execute_query("insert into %s values (1), (2)" % tbl)
+    query = "select count(*) from %s" % tbl
+    assert self.__run(query, "Miss, stored").data == ["2"]
+    assert self.__run(query, "Hit").data == ["2"]
+
+    # An INSERT adds a file, so the scan ranges of the cached plan are outdated.
+    self.execute_query("insert into %s values (3)" % tbl)
+    assert self.__run(query, "Miss, stored").data == ["3"]
+    assert self.__run(query, "Hit").data == ["3"]
+
+    # REFRESH and INVALIDATE METADATA may pick up files written by other engines.
+    self.execute_query("refresh %s" % tbl)
+    assert self.__run(query, "Miss, stored").data == ["3"]
+    self.execute_query("invalidate metadata %s" % tbl)
+    assert self.__run(query, "Miss, stored").data == ["3"]
+
+    # A changed schema changes the plan.
+    self.execute_query("alter table %s add columns (j int)" % tbl)
+    query = "select count(*) from %s where j is null" % tbl
+    assert self.__run(query, "Miss, stored").data == ["3"]
+    assert self.__run(query, "Hit").data == ["3"]
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args=CACHE_ARGS, cluster_size=1)
+  def test_time_functions(self, vector, unique_database):
+    """Plans into which the planner folded the time of planning are not cached, also if
+    the functions of the time are called in the definition of a view."""
+    self.execute_query(
+        "create view %s.v_now as select now() n, cast(now() as string) s, "
+        "unix_timestamp() u" % unique_database)
+    self.execute_query("create view %s.v_filter as select count(*) c "
+        "from functional.alltypes where timestamp_col < current_timestamp() "
+        "and date_col < current_date()" % unique_database)
+    for query in ["select now()",
+                  "select * from %s.v_now" % unique_database,
+                  "select c from %s.v_filter" % unique_database,
+                  "select count(*) from functional.alltypes tablesample system(50)"]:
+      first = self.__run(query, "Miss")
+      time.sleep(1)
+      second = self.__run(query, "Miss")
+      assert "Plan Cache: Miss, stored" not in first.runtime_profile
+      assert "Plan Cache: Miss, stored" not in second.runtime_profile
+      if "v_now" in query:
+        # The folded values are those of the current query.
+        assert first.data != second.data
+    assert self.get_metric('plan-cache.num-entries') == 0
+
+    # Views without such calls are cached.
+    self.execute_query("create view %s.v_const as select count(*) c "
+        "from functional.alltypes where int_col < 5" % unique_database)
+    query = "select c from %s.v_const" % unique_database
+    assert self.__run(query, "Miss, stored").data == ["3650"]
+    assert self.__run(query, "Hit").data == ["3650"]
@@ -0,0 +1,132 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import pytest
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+from tests.common.skip import SkipIfHive2
+from tests.util.filesystem_utils import get_fs_path
+
+QUERY_OPTS = {'use_query_result_cache': True}
+
+
+class TestQueryResultCache(CustomClusterTestSuite):
+  """Tests the coordinator's query result cache. Runs with a single impalad, so that all
+  queries are planned and cached by the same coordinator."""
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __run(self, query, expected_cache_state):
+    """Runs 'query' with the result cache enabled, checks that the profile reports
+    'expected_cache_state' and returns the result."""
+    result = self.execute_query(query, QUERY_OPTS)
+    assert "Query Result Cache: %s\n" % expected_cache_state in result.runtime_profile
+    return result
+
+  def __assert_not_cached(self, query):
+    """Runs 'query' twice and checks that neither execution used the result cache."""
+    for _ in range(2):
+      result = self.execute_query(query, QUERY_OPTS)
+      assert "Query Result Cache:" not in result.runtime_profile
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--query_result_cache_capacity=64MB", cluster_size=1)
+  def test_hit(self, vector):
+    query = "select count(*), sum(int_col) from functional.alltypes"
+    miss = self.__run(query, "Miss, stored")
+    hit = self.__run(query, "Hit")
+    assert hit.data == miss.data
+    assert hit.data == ["7300\t32850"]
+    assert self.get_metric('query-result-cache.hit-count') == 1
+    assert self.get_metric('query-result-cache.num-entries') == 1
+    # The key covers the query options.
+    result = self.execute_query(query, dict(QUERY_OPTS, num_nodes=1))
+    assert "Query Result Cache: Miss, stored\n" in result.runtime_profile
+    assert result.data == miss.data
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--query_result_cache_capacity=64MB", cluster_size=1)
+  def test_invalidation(self, vector, unique_database):
+    tbl = unique_database + ".t"
+    self.execute_query("create table %s (i int)" % tbl)
+    self.execute_query("insert into %s values (1), (2)" % tbl)
+    query = "select count(*) from %s" % tbl
+    assert self.__run(query, "Miss, stored").data == ["2"]
+    assert self.__run(query, "Hit").data == ["2"]
+
+    # An INSERT changes the data.
+    self.execute_query("insert into %s values (3)" % tbl)
+    assert self.__run(query, "Miss, stored").data == ["3"]
+    assert self.__run(query, "Hit").data == ["3"]
+
+    # INVALIDATE METADATA may pick up files written by other engines.
+    self.execute_query("invalidate metadata %s" % tbl)
+    assert self.__run(query, "Miss, stored").data == ["3"]
+    assert self.__run(query, "Hit").data == ["3"]
+
+    # Any DDL clears the cache, also if it does not affect the cached query.
+    invalidations = self.get_metric('query-result-cache.invalidation-count')
+    self.execute_query("create table %s.other (i int)" % unique_database)
+    assert self.get_metric('query-result-cache.invalidation-count') > invalidations
+    assert self.get_metric('query-result-cache.num-entries') == 0
+    assert self.__run(query, "Miss, stored").data == ["3"]
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--query_result_cache_capacity=64MB", cluster_size=1)
+  def test_nondeterministic_queries(self, vector, unique_database):
+    """Queries whose results may differ between executions are not cached, also if the
+    non-deterministic calls are hidden in views or user-defined functions."""
+    self.__assert_not_cached(
+        "select count(*) from functional.alltypes where int_col < rand() * 10")
+    self.__assert_not_cached("select now()")
+    self.__assert_not_cached("select count(*) from functional.alltypes tablesample "
+        "system(50)")
+
+    self.execute_query("create view %s.v_rand as select count(*) c "
+        "from functional.alltypes where int_col < rand() * 10" % unique_database)
+    self.execute_query("create view %s.v_now as select count(*) c "
+        "from functional.alltypes where timestamp_col < now()" % unique_database)
+    self.__assert_not_cached("select c from %s.v_rand" % unique_database)
+    self.__assert_not_cached("select c from %s.v_now" % unique_database)
+
+    self.execute_query("create function %s.identity(int) returns int "
+        "location '%s' symbol='Identity'"
+        % (unique_database, get_fs_path('/test-warehouse/libTestUdfs.so')))
+    self.__assert_not_cached(
+        "select sum(%s.identity(int_col)) from functional.alltypes" % unique_database)
+
+    # The same query without the non-deterministic call is cached.
+    query = "select count(*) from functional.alltypes where int_col < 5"
+    self.__run(query, "Miss, stored")
+    self.__run(query, "Hit")
+
+  @SkipIfHive2.acid
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--query_result_cache_capacity=64MB", cluster_size=1)
+  def test_transactional_queries(self, vector, unique_database):
+    """Queries of transactional tables are not cached."""
+    tbl = unique_database + ".acid"
+    self.execute_query("create table %s (i int) tblproperties ("
+        "'transactional'='true', 'transactional_properties'='insert_only')" % tbl)
+    self.execute_query("insert into %s values (1)" % tbl)
+    self.__assert_not_cached("select count(*) from %s" % tbl)
@@ -904,6 +904,52 @@ class TestQueryRetries(CustomClusterTestSuite):
         'impala-server.resultset-cache.total-num-rows', 1, timeout=60)
     self.hs2_client.close_query(handle)
 
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(impalad_args="--status_report_interval_ms=1000",
+      cluster_size=4, num_exclusive_coordinators=1)
+  def test_retry_straggler(self):
+    """Test that a query is retried without the executor whose scan fragment instance
+    straggles when STRAGGLER_RETRY_FACTOR is set. The scan instance that reads the row
+    with id 3650 sleeps for 10s, while the other two instances finish quickly. The
+    exclusive coordinator makes sure that the straggler is never the coordinator."""
+    query = "select count(*) from functional.alltypes " \
+        "where sleep(if(id = 3650, 10000, 0))"
+    handle = self.execute_query_async(query,
+        query_options={'retry_failed_queries': 'true', 'straggler_retry_factor': 2})
+    results = self.client.fetch(query, handle)
+    assert results.success
+    assert len(results.data) == 1
+    assert int(results.data[0]) == 7300
+
+    # Validate the live exec summary.
+    retried_query_id = self.__get_retried_query_id_from_summary(handle)
+    assert retried_query_id is not None
+
+    # Validate the state of the runtime profiles.
+    retried_runtime_profile = self.client.get_runtime_profile(handle)
+    self.__validate_runtime_profiles(
+        retried_runtime_profile, handle.get_handle().id, retried_query_id)
+    original_runtime_profile = self.__get_original_query_profile(handle.get_handle().id)
+    assert "Straggler retry: " in original_runtime_profile, original_runtime_profile
+
+    # The straggling executor is skipped by the retried query, which runs on the other
+    # two executors. A single slow report does not blacklist the executor for other
+    # queries.
+    skipped_impalads = [impalad for impalad in self.cluster.impalads[1:]
+        if "host={0}:{1}".format(impalad.hostname, impalad.service.krpc_port)
+        not in retried_runtime_profile]
+    assert len(skipped_impalads) == 1, retried_runtime_profile
+    assert "Blacklisted Executors: " not in retried_runtime_profile, \
+        retried_runtime_profile
+
+    # Validate the state of the client log.
+    self.__validate_client_log(handle, retried_query_id)
+
+    # Validate the state of the web ui. The query must be closed before validating the
+    # state since it asserts that no queries are in flight.
+    self.client.close_query(handle)
+    self.__validate_web_ui_state()
+
   def __validate_runtime_profiles_from_service(self, impalad_service, handle):
     """Wrapper around '__validate_runtime_profiles' that first fetches the retried profile
     from the web ui."""
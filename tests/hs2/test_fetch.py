@@ -132,17 +132,19 @@ class TestFetch(HS2TestSuite):
     self.__verify_primitive_type(TTypeId.DATE_TYPE, column_types[2])
     self.close(execute_statement_resp.operationHandle)
 
-  def __query_and_fetch(self, query):
+  def __query_and_fetch(self, query, conf_overlay=None, max_rows=1024):
     execute_statement_req = TCLIService.TExecuteStatementReq()
     execute_statement_req.sessionHandle = self.session_handle
     execute_statement_req.statement = query
+    if conf_overlay is not None:
+      execute_statement_req.confOverlay = conf_overlay
     execute_statement_resp = self.hs2_client.ExecuteStatement(execute_statement_req)
     HS2TestSuite.check_response(execute_statement_resp)
 
     # Do the actual fetch with a valid request.
     fetch_results_req = TCLIService.TFetchResultsReq()
     fetch_results_req.operationHandle = execute_statement_resp.operationHandle
-    fetch_results_req.maxRows = 1024
+    fetch_results_req.maxRows = max_rows
     fetch_results_resp = self.fetch(fetch_results_req)
 
     return fetch_results_resp
@@ -186,6 +188,22 @@ class TestFetch(HS2TestSuite):
     num_rows, result = self.column_results_to_string(fetch_results_resp.results.columns)
     assert result == ("0, 0001-01-01, 0001-01-01\n")
 
+  @needs_session()
+  def test_parallel_result_conversion(self):
+    """Test that converting the columns of the results in parallel returns the same
+    results as converting them on a single thread."""
+    query = "SELECT *, 'const' from functional.alltypes ORDER BY id"
+    expected = None
+    for num_threads in ["1", "3", "64"]:
+      fetch_results_resp = self.__query_and_fetch(query,
+          conf_overlay={"result_conversion_threads": num_threads}, max_rows=10000)
+      num_rows, result = \
+          self.column_results_to_string(fetch_results_resp.results.columns)
+      assert num_rows == 7300
+      if expected is None:
+        expected = result
+      assert result == expected
+
   @needs_session()
   def test_show_partitions(self):
     """Regression test for IMPALA-1330"""
@@ -16,6 +16,7 @@
 # under the License.
 #
 import pytest
+import re
 
 from tests.common.impala_test_suite import ImpalaTestSuite
 from tests.common.test_dimensions import add_exec_option_dimension
@@ -133,3 +134,52 @@ limit 10;
       assert debug_action == self.DEBUG_ACTION_EXEC_FINISH_BEFORE_CODEGEN, \
           "Unrecognised debug action: '%s'." % debug_action
       assert exec_end < codegen_end
+
+
+class TestAsyncCodegenFastTier(ImpalaTestSuite):
+  """Tests that queries return correct results when async codegen first compiles the
+  unoptimized fast tier (ASYNC_CODEGEN_FAST_TIER), and that the profile reports the time
+  spent compiling it."""
+
+  QUERY = """
+select count(*), sum(int_col), max(string_col)
+from functional.alltypessmall
+where int_col > 5
+"""
+  EXPECTED_RESULT = ['40\t300\t9']
+
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestAsyncCodegenFastTier, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(create_exec_option_dimension(
+        cluster_sizes=[1], disable_codegen_options=[False], batch_sizes=[0],
+        disable_codegen_rows_threshold_options=[0]))
+    add_exec_option_dimension(cls, "async_codegen", 1)
+    cls.ImpalaTestMatrix.add_constraint(lambda vector:
+        vector.get_value('exec_option')['num_nodes'] == 1 and
+        vector.get_value('table_format').file_format == 'text' and
+        vector.get_value('table_format').compression_codec == 'none')
+
+  def __fast_tier_compile_times(self, profile):
+    return re.findall(r'FastTierCompileTime: (\S+)', profile)
+
+  def test_fast_tier(self, vector):
+    exec_options = dict(vector.get_value('exec_option'))
+    exec_options['async_codegen_fast_tier'] = 1
+    result = self.execute_query(self.QUERY, exec_options)
+    assert result.data == self.EXPECTED_RESULT
+    compile_times = self.__fast_tier_compile_times(result.runtime_profile)
+    assert len(compile_times) > 0
+    assert any(t != '0.000ns' for t in compile_times), compile_times
+
+  def test_fast_tier_disabled(self, vector):
+    exec_options = dict(vector.get_value('exec_option'))
+    exec_options['async_codegen_fast_tier'] = 0
+    result = self.execute_query(self.QUERY, exec_options)
+    assert result.data == self.EXPECTED_RESULT
+    compile_times = self.__fast_tier_compile_times(result.runtime_profile)
+    assert all(t == '0.000ns' for t in compile_times), compile_times
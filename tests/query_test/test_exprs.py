@@ -243,3 +243,51 @@ class TestUtcTimestampFunctions(ImpalaTestSuite):
     vector.get_value('exec_option')['enable_expr_rewrites'] = \
         vector.get_value('enable_expr_rewrites')
     self.run_test_case('QueryTest/utc-timestamp-functions', vector)
+
+class TestBatchConjunctEvaluation(ImpalaTestSuite):
+  """Checks that evaluating conjuncts many rows at a time with the query option
+     BATCH_CONJUNCT_EVALUATION returns the same rows as evaluating them row by row."""
+
+  # The queries mix conjuncts that are evaluated over batches of slot values with
+  # conjuncts that are evaluated one row at a time. The conjuncts of the select nodes
+  # above the top-n are evaluated by the select nodes, the others by the scans.
+  QUERIES = [
+    """select id from functional_parquet.alltypes
+       where int_col < 5 and 3 <= tinyint_col and bigint_col != 20 and bool_col = true
+       and double_col >= 10.1 and float_col > 1.5 and string_col != '4'
+       and smallint_col <= 8""",
+    """select id from functional_parquet.alltypes
+       where date_string_col like '%09%' and id % 7 = 1 and timestamp_col is not null
+       and string_col >= '2'""",
+    """select count(*) from functional_parquet.alltypesagg
+       where int_col is null or tinyint_col is null""",
+    """select id from functional_parquet.alltypesagg where int_col is null and day = 3""",
+    """select * from (select id, int_col, string_col from functional_parquet.alltypesagg
+       order by id limit 5000) v
+       where int_col is not null and string_col < '500' and 20 > int_col % 100""",
+    """select * from (select id, tinyint_col, bool_col from functional_parquet.alltypes
+       order by id limit 1000) v
+       where tinyint_col = null or (bool_col and tinyint_col > 4)""",
+    """select * from (select id, date_col from functional_parquet.date_tbl
+       order by id limit 100) v
+       where date_col >= date '1970-01-01' and date_col < date '2020-01-01'"""
+  ]
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestBatchConjunctEvaluation, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(lambda v:\
+        v.get_value('table_format').file_format == 'parquet')
+
+  def test_batch_conjuncts(self, vector):
+    exec_option = vector.get_value('exec_option')
+    for query in self.QUERIES:
+      exec_option['batch_conjunct_evaluation'] = 'false'
+      expected = self.execute_query(query, exec_option)
+      exec_option['batch_conjunct_evaluation'] = 'true'
+      result = self.execute_query(query, exec_option)
+      assert sorted(result.data) == sorted(expected.data), query
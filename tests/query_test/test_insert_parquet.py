@@ -17,13 +17,16 @@
 
 # Targeted Impala insert tests
 
+import hashlib
 import os
 
 from collections import namedtuple
+from copy import deepcopy
 from datetime import (datetime, date)
 from decimal import Decimal
 from subprocess import check_call
-from parquet.ttypes import ColumnOrder, SortingColumn, TypeDefinedOrder, ConvertedType
+from parquet.ttypes import (ColumnOrder, SortingColumn, TypeDefinedOrder, ConvertedType,
+    Encoding)
 
 from tests.common.environ import impalad_basedir
 from tests.common.impala_test_suite import ImpalaTestSuite
@@ -34,7 +37,7 @@ from tests.common.test_dimensions import create_exec_option_dimension
 from tests.common.test_result_verifier import verify_query_result_is_equal
 from tests.common.test_vector import ImpalaTestDimension
 from tests.util.filesystem_utils import get_fs_path
-from tests.util.get_parquet_metadata import (decode_stats_value,
+from tests.util.get_parquet_metadata import (decode_stats_value, get_parquet_metadata,
     get_parquet_metadata_from_hdfs_folder)
 
 PARQUET_CODECS = ['none', 'snappy', 'gzip', 'zstd', 'lz4']
@@ -235,6 +238,94 @@ class TestInsertParquetVerifySize(ImpalaTestSuite):
         found_small_file = True
 
 
+class TestParquetParallelEncoding(ImpalaTestSuite):
+  """Tests that the Parquet writer writes the same files with and without
+  PARQUET_PARALLEL_ENCODING, which compresses the pages on a thread pool."""
+
+  @classmethod
+  def get_workload(self):
+    return 'tpch'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestParquetParallelEncoding, cls).add_test_dimensions()
+    # Fix the exec_option vector to have a single value.
+    cls.ImpalaTestMatrix.add_dimension(create_exec_option_dimension(
+        cluster_sizes=[0], disable_codegen_options=[False], batch_sizes=[0],
+        sync_ddl=[1]))
+    cls.ImpalaTestMatrix.add_constraint(
+        lambda v: v.get_value('table_format').file_format == 'parquet')
+    cls.ImpalaTestMatrix.add_constraint(
+        lambda v: v.get_value('table_format').compression_codec == 'none')
+    cls.ImpalaTestMatrix.add_dimension(
+        ImpalaTestDimension("compression_codec", *PARQUET_CODECS))
+
+  def _write_orders(self, vector, unique_database, tbl_name, parallel_encoding):
+    """Writes tpch.orders into the new Parquet table 'tbl_name' and returns the
+    table's path. The files are small enough for the writer to roll over to new files.
+    The rows are sorted by the unique o_orderkey before they reach the only writer, so
+    the same files are written every time."""
+    fq_tbl_name = "{0}.{1}".format(unique_database, tbl_name)
+    self.execute_query("create table {0} sort by (o_orderkey) like tpch_parquet.orders "
+                       "stored as parquet".format(fq_tbl_name))
+    exec_options = deepcopy(vector.get_value('exec_option'))
+    exec_options['COMPRESSION_CODEC'] = vector.get_value('compression_codec')
+    exec_options['PARQUET_FILE_SIZE'] = 8 * 1024 * 1024
+    exec_options['PARQUET_PARALLEL_ENCODING'] = parallel_encoding
+    exec_options['NUM_NODES'] = 1
+    self.execute_query("insert into {0} select * from tpch.orders".format(fq_tbl_name),
+        exec_options)
+    return get_fs_path("/test-warehouse/{0}.db/{1}/".format(unique_database, tbl_name))
+
+  def _get_local_files(self, hdfs_path, local_dir):
+    """Copies the Parquet files in 'hdfs_path' into 'local_dir' and returns their
+    local paths."""
+    check_call(['hdfs', 'dfs', '-get', hdfs_path, local_dir])
+    table_dir = os.path.join(local_dir, os.path.basename(os.path.normpath(hdfs_path)))
+    return [os.path.join(table_dir, f) for f in os.listdir(table_dir)
+            if f.endswith('parq')]
+
+  @SkipIfIsilon.hdfs_block_size
+  @SkipIfLocal.hdfs_client
+  def test_parallel_encoding(self, vector, unique_database, tmpdir):
+    serial_path = self._write_orders(vector, unique_database, "serial", False)
+    parallel_path = self._write_orders(vector, unique_database, "parallel", True)
+
+    # The files are byte-identical. Their names differ, so compare the sets of contents.
+    serial_files = self._get_local_files(serial_path, tmpdir.strpath)
+    parallel_files = self._get_local_files(parallel_path, tmpdir.strpath)
+    assert len(parallel_files) > 1, "Expected the writer to roll over to a new file"
+    file_digests = []
+    for local_files in [serial_files, parallel_files]:
+      digests = []
+      for local_file in local_files:
+        with open(local_file, 'rb') as f:
+          digests.append(hashlib.md5(f.read()).hexdigest())
+      file_digests.append(sorted(digests))
+    assert file_digests[0] == file_digests[1]
+
+    # o_comment has too many distinct values for its dictionary, so its column chunks
+    # fall back from dictionary encoding to PLAIN.
+    o_comment_idx = 8
+    dict_encodings = [Encoding.PLAIN_DICTIONARY, Encoding.RLE_DICTIONARY]
+    found_fallback = False
+    for local_file in parallel_files:
+      for row_group in get_parquet_metadata(local_file).row_groups:
+        encodings = row_group.columns[o_comment_idx].meta_data.encodings
+        if Encoding.PLAIN in encodings and any(e in encodings for e in dict_encodings):
+          found_fallback = True
+    assert found_fallback
+
+    # Both tables hold the rows of tpch.orders.
+    checksum = ("select count(*), sum(o_orderkey), sum(o_custkey), sum(o_totalprice), "
+                "sum(length(o_comment)), count(distinct o_orderdate) from {0}")
+    expected = self.execute_query(checksum.format("tpch.orders")).data
+    for tbl_name in ["serial", "parallel"]:
+      result = self.execute_query(
+          checksum.format("{0}.{1}".format(unique_database, tbl_name)))
+      assert result.data == expected
+
+
 class TestHdfsParquetTableWriter(ImpalaTestSuite):
 
   @classmethod
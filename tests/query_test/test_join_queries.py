@@ -124,6 +124,19 @@ class TestJoinQueries(ImpalaTestSuite):
     new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
     self.run_test_case('QueryTest/empty-build-joins', new_vector)
 
+  def test_runtime_broadcast_bytes_limit(self, vector):
+    """Test that a query whose broadcast join build exceeds the
+    RUNTIME_BROADCAST_BYTES_LIMIT is planned again with a partitioned join."""
+    query = "select count(*) from functional_parquet.alltypes a " \
+        "join functional_parquet.alltypestiny b on a.id = b.id"
+    query_options = {'mt_dop': vector.get_value('mt_dop'),
+        'runtime_broadcast_bytes_limit': 1}
+    result = self.execute_query(query, query_options)
+    assert result.data == ['8']
+    # The results come from the retry of the query, which uses a partitioned join.
+    assert "Original Query Id:" in result.runtime_profile
+    assert "INNER JOIN, PARTITIONED" in result.runtime_profile
+
 class TestTPCHJoinQueries(ImpalaTestSuite):
   # Uses the TPC-H dataset in order to have larger joins. Needed for example to test
   # the repartitioning codepaths.
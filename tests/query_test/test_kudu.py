@@ -568,6 +568,69 @@ class TestKuduOperations(KuduTestSuite):
     assert cursor.fetchall() == [(100,)]
 
 
+class TestKuduScanPrefetch(KuduTestSuite):
+  """Tests Kudu scans with and without prefetching the next batch on a fetch thread."""
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestKuduScanPrefetch, cls).add_test_dimensions()
+    add_exec_option_dimension(cls, "kudu_scan_prefetch", "true")
+    extend_exec_option_dimension(cls, "kudu_scan_prefetch", "false")
+    add_exec_option_dimension(cls, "mt_dop", "0")
+    extend_exec_option_dimension(cls, "mt_dop", "4")
+
+  def test_kudu_scan_prefetch(self, vector):
+    self.run_test_case('QueryTest/kudu-scan-prefetch', vector)
+
+
+class TestKuduColumnarScan(KuduTestSuite):
+  """Tests Kudu scans that fetch columnar batches and materialize them one column at
+  a time."""
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestKuduColumnarScan, cls).add_test_dimensions()
+    add_exec_option_dimension(cls, "kudu_columnar_scan", "true")
+    extend_exec_option_dimension(cls, "kudu_columnar_scan", "false")
+    add_exec_option_dimension(cls, "mt_dop", "0")
+    extend_exec_option_dimension(cls, "mt_dop", "4")
+
+  def test_kudu_columnar_scan(self, vector):
+    self.run_test_case('QueryTest/kudu-columnar-scan', vector)
+
+
+class TestKuduScanCodegen(KuduTestSuite):
+  """Tests Kudu scans with and without the codegen'd row loop, which evaluates the
+  conjuncts that are not pushed to Kudu."""
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestKuduScanCodegen, cls).add_test_dimensions()
+    add_exec_option_dimension(cls, "disable_codegen", "false")
+    extend_exec_option_dimension(cls, "disable_codegen", "true")
+    add_exec_option_dimension(cls, "disable_codegen_rows_threshold", "0")
+    add_exec_option_dimension(cls, "kudu_columnar_scan", "false")
+
+  def test_kudu_scan_codegen(self, vector):
+    self.run_test_case('QueryTest/kudu-scan-codegen', vector)
+
+  def test_kudu_scan_codegen_profile(self, vector):
+    exec_options = dict(vector.get_value('exec_option'))
+    result = self.execute_query(
+        "select id from functional_kudu.alltypes where id % 1000 = 1", exec_options)
+    assert sorted(result.data) == ['1', '1001', '2001', '3001', '4001', '5001', '6001',
+        '7001']
+    profile = result.runtime_profile
+    if exec_options['disable_codegen'] == 'true':
+      assert 'Codegen Enabled' not in profile
+      return
+    scan_options = re.findall(
+        r'KUDU_SCAN_NODE \(id=0\).*?ExecOption: ([^\n]*)', profile, re.DOTALL)
+    assert len(scan_options) > 0
+    for options in scan_options:
+      assert 'Codegen Enabled' in options, options
+
+
 class TestKuduPartitioning(KuduTestSuite):
   @classmethod
   def add_test_dimensions(cls):
@@ -23,11 +23,14 @@ import logging
 from copy import deepcopy
 from tests.common.environ import ImpalaTestClusterProperties, build_flavor_timeout
 from tests.common.environ import HIVE_MAJOR_VERSION
+from tests.common.impala_cluster import ImpalaCluster
 from tests.common.impala_test_suite import ImpalaTestSuite
 from tests.common.kudu_test_suite import KuduTestSuite
 from tests.common.skip import SkipIfABFS, SkipIfEC, SkipIfNotHdfsMinicluster
 from tests.common.test_vector import ImpalaTestDimension
+from tests.util.cancel_util import cancel_query_and_validate_state
 from tests.util.filesystem_utils import IS_HDFS
+from tests.verifiers.metric_verifier import MetricVerifier
 
 LOG = logging.getLogger('test_mt_dop')
 
@@ -163,6 +166,42 @@ class TestMtDopKudu(KuduTestSuite):
     self.run_test_case('QueryTest/mt-dop-kudu', vector, use_db=unique_database)
 
 
+class TestMtDopScanPrefetch(ImpalaTestSuite):
+  """Tests HDFS scans with MT_DOP > 0, which start the I/O for the next scan ranges
+  while the current range is scanned."""
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestMtDopScanPrefetch, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(ImpalaTestDimension('mt_dop', 1, 4))
+    cls.ImpalaTestMatrix.add_constraint(
+        lambda v: v.get_value('table_format').file_format in ['parquet', 'orc', 'text'])
+
+  def test_scan_prefetch(self, vector):
+    vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    self.run_test_case('QueryTest/mt-dop-scan-prefetch', vector,
+        test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
+
+  @pytest.mark.execute_serially
+  def test_scan_prefetch_cancellation(self, vector):
+    """Cancels scans while prefetched ranges are in flight. The scan node is delayed in
+    every GetNext() call, so the cancellation happens while ranges are prefetched."""
+    exec_option = deepcopy(vector.get_value('exec_option'))
+    exec_option['mt_dop'] = vector.get_value('mt_dop')
+    exec_option['debug_action'] = '0:GETNEXT:DELAY'
+    for cancel_delay in [0.01, 0.5, 2]:
+      cancel_query_and_validate_state(self.client, "select * from alltypes",
+          exec_option, vector.get_value('table_format'), cancel_delay)
+    # The buffers of the prefetched ranges are freed and every fragment is torn down.
+    for impalad in ImpalaCluster.get_e2e_test_cluster().impalads:
+      verifier = MetricVerifier(impalad.service)
+      verifier.wait_for_metric("impala-server.num-fragments-in-flight", 0, timeout=10)
+      verifier.wait_for_metric("buffer-pool.reserved", 0, timeout=10)
+
+
 @SkipIfNotHdfsMinicluster.tuned_for_minicluster
 class TestMtDopScheduling(ImpalaTestSuite):
   """Test the number of fragment instances and admission slots computed by the scheduler
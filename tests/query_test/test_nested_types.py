@@ -112,6 +112,63 @@ class TestNestedTypes(ImpalaTestSuite):
                        use_db='tpch_nested' + db_suffix)
 
 
+class TestBatchedSubplanUnnest(ImpalaTestSuite):
+  """Runs the subplan tests with and without BATCHED_SUBPLAN_UNNEST. The tests cover
+  inner, left and right outer joins with collections, predicates on the items, limits,
+  empty and NULL collections and nested subplans, which must return the same rows
+  whether or not the SubplanNode unnests whole input batches."""
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestBatchedSubplanUnnest, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format in ['parquet', 'orc'])
+    cls.ImpalaTestMatrix.add_dimension(
+        ImpalaTestDimension('batched_subplan_unnest', 'true', 'false'))
+
+  def _set_options(self, vector):
+    vector = deepcopy(vector)
+    vector.get_value('exec_option')['batched_subplan_unnest'] = \
+        vector.get_value('batched_subplan_unnest')
+    return vector
+
+  def test_subplan(self, vector):
+    vector = self._set_options(vector)
+    db_suffix = vector.get_value('table_format').db_suffix()
+    self.run_test_case('QueryTest/nested-types-subplan', vector,
+                       use_db='tpch_nested' + db_suffix)
+
+  def test_subplan_single_node(self, vector):
+    vector = self._set_options(vector)
+    vector.get_value('exec_option')['num_nodes'] = 1
+    self.run_test_case('QueryTest/nested-types-subplan-single-node', vector)
+
+  def test_runtime(self, vector):
+    vector = self._set_options(vector)
+    self.run_test_case('QueryTest/nested-types-runtime', vector)
+
+  def test_tpch_limit(self, vector):
+    vector = self._set_options(vector)
+    vector.get_value('exec_option')['batch_size'] = 10
+    db_suffix = vector.get_value('table_format').db_suffix()
+    self.run_test_case('QueryTest/nested-types-tpch-limit', vector,
+                       use_db='tpch_nested' + db_suffix)
+
+  def test_exec_option_in_profile(self, vector):
+    """The SubplanNode only unnests whole batches with the option set."""
+    vector = self._set_options(vector)
+    enabled = vector.get_value('batched_subplan_unnest') == 'true'
+    db_suffix = vector.get_value('table_format').db_suffix()
+    result = self.execute_query_expect_success(self.client,
+        "select count(*) from tpch_nested%s.customer c, c.c_orders o "
+        "where o.o_totalprice > 1000" % db_suffix,
+        vector.get_value('exec_option'))
+    assert ('Batched Unnest' in result.runtime_profile) == enabled
+
+
 class TestNestedTypesNoMtDop(ImpalaTestSuite):
   """Functional tests for nested types that do not need to be run with mt_dop > 0."""
   @classmethod
@@ -261,6 +261,20 @@ class TestObservability(ImpalaTestSuite):
     assert results.runtime_profile.count("AGGREGATION_NODE") == 2
     assert results.runtime_profile.count("PLAN_ROOT_SINK") == 2
 
+  def test_cpu_profile_sampling(self):
+    """Test that the fragment instances of a query with CPU_PROFILE_SAMPLING_HZ add
+    their CPU samples as folded stacks to the profile."""
+    query = """select count(*) from tpch.lineitem a join tpch.lineitem b
+        on a.l_orderkey = b.l_orderkey where a.l_comment like '%furious%'"""
+    results = self.execute_query(query, {'cpu_profile_sampling_hz': 100})
+    profile = results.runtime_profile
+    assert "CPU Profile Samples: " in profile, profile
+    assert "CPU Profile (folded stacks): " in profile, profile
+    assert "impala::FragmentInstanceState::Exec" in profile, profile
+    # The profile is only added if sampling is enabled.
+    results = self.execute_query(query)
+    assert "CPU Profile Samples" not in results.runtime_profile
+
   def test_query_profile_contains_query_compilation_static_events(self):
     """Test that the expected events show up in a query profile. These lines are static
     and should appear in this exact order."""
@@ -93,6 +93,28 @@ class TestQueries(ImpalaTestSuite):
       pytest.xfail("A lot of queries check for NULLs, which hbase does not recognize")
     self.run_test_case('QueryTest/analytic-fns', vector)
 
+  def test_analytic_partition_rows(self, vector):
+    """Checks that the analytic eval node reports the number of rows of each
+    partition."""
+    if vector.get_value('table_format').file_format != 'text':
+      pytest.skip("The queries read the text tables")
+    exec_options = dict(vector.get_value('exec_option'))
+    # Evaluate all partitions in a single fragment instance.
+    exec_options['num_nodes'] = 1
+    result = self.execute_query("select id, count(*) over "
+        "(partition by case when id < 1 then 0 else 1 end) "
+        "from functional.alltypestiny", exec_options)
+    assert sorted(result.data) == ['0\t1'] + ['%d\t7' % i for i in range(1, 8)]
+    assert ('PartitionRows: (Avg: 4 (4) ; Min: 1 (1) ; Max: 7 (7) ; '
+        'Number of samples: 2)') in result.runtime_profile, result.runtime_profile
+
+    # Without a PARTITION BY clause the whole input is one partition.
+    result = self.execute_query(
+        "select count(*) over () from functional.alltypestiny", exec_options)
+    assert result.data == ['8'] * 8
+    assert ('PartitionRows: (Avg: 8 (8) ; Min: 8 (8) ; Max: 8 (8) ; '
+        'Number of samples: 1)') in result.runtime_profile, result.runtime_profile
+
   def test_limit(self, vector):
     if vector.get_value('table_format').file_format == 'hbase':
       pytest.xfail("IMPALA-283 - select count(*) produces inconsistent results")
@@ -224,6 +246,11 @@ class TestQueriesTextTables(ImpalaTestSuite):
   def test_data_source_tables(self, vector):
     self.run_test_case('QueryTest/data-source-tables', vector)
 
+  @SkipIfCatalogV2.data_sources_unsupported()
+  def test_columnar_data_source_tables(self, vector, unique_database):
+    """Reads a data source table whose row batches are in the Arrow columnar layout."""
+    self.run_test_case('QueryTest/data-source-tables-columnar', vector, unique_database)
+
   def test_range_constant_propagation(self, vector):
     self.run_test_case('QueryTest/range-constant-propagation', vector)
 
@@ -363,3 +390,35 @@ class TestTopNReclaimQuery(ImpalaTestSuite):
     # Tuple pool is expected to be reclaimed for this query
     for n in num_of_times_tuple_pool_reclaimed:
       assert int(n) > 0
+
+class TestStartLocalFragmentsDirectly(ImpalaTestSuite):
+  """Tests queries whose fragment instances on the coordinator are started without an
+  ExecQueryFInstances RPC (START_LOCAL_FRAGMENTS_DIRECTLY)."""
+
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestStartLocalFragmentsDirectly, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(
+      create_uncompressed_text_dimension(cls.get_workload()))
+
+  def test_start_local_fragments_directly(self, vector):
+    exec_options = vector.get_value('exec_option')
+    exec_options['start_local_fragments_directly'] = True
+    # A single-node query and a query with fragments on all executors.
+    for num_nodes in [1, 0]:
+      exec_options['num_nodes'] = num_nodes
+      result = self.execute_query(
+          "select count(*) from functional.alltypes where id < 10", exec_options)
+      assert result.data == ["10"]
+    # Errors of the local backend fail the query.
+    exec_options['num_nodes'] = 1
+    exec_options['debug_action'] = "QUERY_STATE_INIT:FAIL"
+    try:
+      self.execute_query("select count(*) from functional.alltypes", exec_options)
+      assert False, "Query was expected to fail"
+    except Exception as e:
+      assert "Debug Action: QUERY_STATE_INIT:FAIL" in str(e)
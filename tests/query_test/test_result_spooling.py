@@ -223,6 +223,75 @@ class TestResultSpooling(ImpalaTestSuite):
                                      "spooling was enabled".format(query)
 
 
+class TestResultSpoolingCompression(ImpalaTestSuite):
+  """Tests result spooling with SPOOL_QUERY_RESULTS_COMPRESSION, which keeps the spooled
+  batches compressed in memory and adds the batches that do not fit to the spilled
+  stream."""
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestResultSpoolingCompression, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format == 'parquet')
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def test_result_spooling(self, vector):
+    vector.get_value('exec_option')['spool_query_results_compression'] = 'true'
+    self.run_test_case('QueryTest/result-spooling', vector)
+
+  def test_multi_batches(self, vector):
+    """Validates that many small compressed batches are returned in order."""
+    exec_options = vector.get_value('exec_option')
+    exec_options['batch_size'] = 10
+    exec_options['spool_query_results'] = 'true'
+    exec_options['spool_query_results_compression'] = 'true'
+    self.__validate_query(
+        "select id, string_col from functional_parquet.alltypes order by id limit 1000",
+        exec_options)
+
+  def test_compressed_and_spilled(self, vector):
+    """Tests that the rows stay in order when the first batches are kept compressed in
+    memory and the later batches are spilled because the compressed batches use up the
+    memory of the queue."""
+    query = "select * from functional.alltypes order by id limit 3000"
+    exec_options = vector.get_value('exec_option')
+    exec_options['batch_size'] = 100
+    exec_options['min_spillable_buffer_size'] = 8 * 1024
+    exec_options['default_spillable_buffer_size'] = 8 * 1024
+    exec_options['max_result_spooling_mem'] = 32 * 1024
+    exec_options['max_row_size'] = 8 * 1024
+    base_result = self.execute_query(query, exec_options)
+    assert base_result.success
+
+    exec_options['spool_query_results'] = 'true'
+    exec_options['spool_query_results_compression'] = 'true'
+    compressed_rows_regex = "PLAN_ROOT_SINK[\s\S]*?SpooledRowsCompressed:.*[1-9]"
+    spilled_regex = "PLAN_ROOT_SINK[\s\S]*?ExecOption:.*Spilled"
+    # Wait for the producer to fill the queue before fetching, so that both compressed
+    # and spilled batches are in it.
+    handle = self.execute_query_async(query, exec_options)
+    try:
+      self.assert_eventually(30, 0.5, lambda: re.search(spilled_regex,
+          self.client.get_runtime_profile(handle)))
+      result = self.client.fetch(query, handle)
+      assert result.data == base_result.data
+      assert re.search(compressed_rows_regex, self.client.get_runtime_profile(handle))
+    finally:
+      self.client.close_query(handle)
+
+  def __validate_query(self, query, exec_options):
+    """Compares the results of the given query with and without result spooling."""
+    exec_options = exec_options.copy()
+    result = self.execute_query(query, exec_options)
+    assert result.success
+    exec_options['spool_query_results'] = 'false'
+    base_result = self.execute_query(query, exec_options)
+    assert base_result.success
+    assert result.data == base_result.data
+
+
 class TestResultSpoolingFetchSize(ImpalaTestSuite):
   """Tests fetching logic when result spooling is enabled. When result spooling is
   disabled, Impala only supports fetching up to BATCH_SIZE rows at a time (since only
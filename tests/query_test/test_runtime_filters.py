@@ -316,6 +316,43 @@ class TestAllRuntimeFilters(ImpalaTestSuite):
                        test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
 
 
+@SkipIfLocal.multiple_impalad
+class TestParquetEarlyRuntimeFiltering(ImpalaTestSuite):
+  """Tests PARQUET_EARLY_RUNTIME_FILTERING, which evaluates the runtime filters of
+  Parquet scans on the decoded integer key columns before the other predicate columns
+  are read."""
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestParquetEarlyRuntimeFiltering, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format in ['parquet'])
+    cls.ImpalaTestMatrix.add_dimension(ImpalaTestDimension('mt_dop', 0, 4))
+    # Enable query option ASYNC_CODEGEN for slow build
+    if build_runs_slowly:
+      add_exec_option_dimension(cls, "async_codegen", 1)
+
+  def test_early_runtime_filtering(self, vector):
+    """The test file turns PARQUET_EARLY_RUNTIME_FILTERING on and off itself."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    self.run_test_case('QueryTest/parquet_early_runtime_filtering', new_vector,
+                       test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
+
+  def test_row_filters(self, vector):
+    """The row filter tests return the same rows with the option on and off."""
+    for early_runtime_filtering in [True, False]:
+      new_vector = deepcopy(vector)
+      new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+      new_vector.get_value('exec_option')['parquet_early_runtime_filtering'] = \
+          early_runtime_filtering
+      self.run_test_case('QueryTest/runtime_row_filters', new_vector,
+          test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
+
+
 @SkipIfLocal.multiple_impalad
 class TestRuntimeRowFilters(ImpalaTestSuite):
   @classmethod
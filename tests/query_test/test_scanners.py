@@ -871,6 +871,44 @@ class TestParquet(ImpalaTestSuite):
     create_table_from_parquet(self.client, unique_database, TABLE_NAME)
     self.run_test_case("QueryTest/parquet-rle-dictionary", vector, unique_database)
 
+  def test_bloom_filters(self, vector, unique_database):
+    """Test that row groups are skipped if the split block Bloom filters of their column
+    chunks do not contain the values of equality and IN predicates."""
+    create_table_and_copy_files(self.client,
+        "create table {db}.{tbl} (id bigint, int_col int, name string) "
+        "stored as parquet", unique_database, "parquet_bloom_filter",
+        ["testdata/parquet_bloom_filter/parquet_bloom_filter.parquet"])
+    self.run_test_case('QueryTest/parquet-bloom-filter', vector, unique_database)
+
+  def test_decompress_ahead(self, vector):
+    """Test that scans that decompress data pages ahead of time on the parquet
+    decompression thread pool return the same rows as scans that decompress them
+    synchronously. The TPC-H tables are snappy compressed."""
+    queries = [
+        "select l_returnflag, l_linestatus, count(*), sum(l_quantity), "
+        "sum(l_extendedprice), min(l_comment), max(l_shipdate) "
+        "from tpch_parquet.lineitem group by 1, 2 order by 1, 2",
+        # Returns strings that point into the data pages.
+        "select * from tpch_parquet.lineitem where l_orderkey < 1000 "
+        "order by l_orderkey, l_linenumber",
+        "select * from tpch_parquet.orders where o_orderkey < 10000 order by 1"]
+    options = dict(vector.get_value('exec_option'))
+    for query in queries:
+      expected = self.execute_query(query,
+          dict(options, parquet_decompress_ahead_pages=0))
+      assert self._get_pages_decompressed_ahead(expected.runtime_profile) == 0
+      for ahead_pages in [1, 4, 16]:
+        result = self.execute_query(query,
+            dict(options, parquet_decompress_ahead_pages=ahead_pages))
+        assert result.data == expected.data
+        assert self._get_pages_decompressed_ahead(result.runtime_profile) > 0
+
+  def _get_pages_decompressed_ahead(self, runtime_profile):
+    """Returns the largest NumPagesDecompressedAhead counter of 'runtime_profile'."""
+    counters = re.findall(r'NumPagesDecompressedAhead: ([0-9]*)', runtime_profile)
+    assert len(counters) > 0
+    return max(int(c) for c in counters)
+
   def test_type_widening(self, vector, unique_database):
     """IMPALA-6373: Test that Impala can read parquet file with column types smaller than
        the schema with larger types"""
@@ -1379,6 +1417,145 @@ class TestUncompressedText(ImpalaTestSuite):
                                 unique_database, "lazy_ts", test_files)
     self.run_test_case('QueryTest/select-lazy-timestamp', vector, unique_database)
 
+class TestAvroParallelDecoding(ImpalaTestSuite):
+  """Tests that the query option AVRO_PARALLEL_DECODING returns the same rows as the
+  serial decoding of Avro data blocks, including after corrupt blocks."""
+  # The Avro files written by _write_avro_file() have this many data blocks of
+  # ROWS_PER_BLOCK rows. With the default num_avro_decoding_threads of 8, the scanner
+  # reads the blocks ahead in several windows.
+  NUM_BLOCKS = 20
+  ROWS_PER_BLOCK = 100
+
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestAvroParallelDecoding, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(create_single_exec_option_dimension())
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format == 'avro' and
+        v.get_value('table_format').compression_codec == 'snap')
+
+  def _query_serial_and_parallel(self, vector, query, abort_on_error=1):
+    """Runs 'query' with AVRO_PARALLEL_DECODING off and on with several batch sizes.
+    Checks that the results are the same and returns them."""
+    results = []
+    for parallel_decoding, batch_size in [(0, 0), (1, 0), (1, 1), (1, 37)]:
+      exec_options = deepcopy(vector.get_value('exec_option'))
+      exec_options['avro_parallel_decoding'] = parallel_decoding
+      exec_options['batch_size'] = batch_size
+      exec_options['abort_on_error'] = abort_on_error
+      result = self.execute_query_expect_success(self.client, query, exec_options)
+      results.append(result.data)
+    for data in results[1:]:
+      assert data == results[0]
+    return results[0]
+
+  def test_parallel_decoding_results(self, vector):
+    """Compares the rows of Avro tables that are decoded in parallel and serially."""
+    db = QueryTestSectionReader.get_db_name(vector.get_value('table_format'))
+    queries = [
+        "select * from {0}.alltypes order by id".format(db),
+        "select id, string_col, timestamp_col from {0}.alltypes where int_col < 5 "
+        "order by id".format(db),
+        "select * from {0}.alltypes where id = 1234".format(db),
+        "select count(*), count(distinct string_col), sum(bigint_col) from "
+        "{0}.alltypes".format(db),
+        "select l_orderkey, l_linenumber, l_comment, l_shipdate from "
+        "tpch_avro_snap.lineitem order by l_orderkey, l_linenumber limit 2000",
+        "select count(*), sum(l_orderkey), max(l_comment), min(l_shipdate), "
+        "sum(l_extendedprice) from tpch_avro_snap.lineitem"]
+    for query in queries:
+      self._query_serial_and_parallel(vector, query)
+
+  def _write_avro_file(self, path, bad_count_block=-1, bad_string_block=-1):
+    """Writes an uncompressed Avro file with the records (id int, s string) to 'path'.
+    If 'bad_count_block' is set, that block has a negative record count, which fails the
+    read of the block. If 'bad_string_block' is set, a string of that block has a
+    negative length, which fails the decoding of the block."""
+    def zigzag(n):
+      n = (n << 1) ^ (n >> 63)
+      out = bytearray()
+      while n & ~0x7f:
+        out.append((n & 0x7f) | 0x80)
+        n >>= 7
+      out.append(n)
+      return out
+
+    def avro_string(s):
+      return zigzag(len(s)) + bytearray(s)
+
+    schema = ('{"type": "record", "name": "r", "fields": ['
+              '{"name": "id", "type": "int"}, {"name": "s", "type": "string"}]}')
+    sync = bytearray(range(16))
+    data = bytearray(b"Obj\x01")
+    data += zigzag(2) + avro_string("avro.schema") + avro_string(schema)
+    data += avro_string("avro.codec") + avro_string("null") + zigzag(0)
+    data += sync
+    for block in range(self.NUM_BLOCKS):
+      records = bytearray()
+      for i in range(self.ROWS_PER_BLOCK):
+        row_id = block * self.ROWS_PER_BLOCK + i
+        records += zigzag(row_id)
+        if block == bad_string_block and i == self.ROWS_PER_BLOCK / 2:
+          records += zigzag(-5)
+        else:
+          records += avro_string("row %d" % row_id)
+      num_records = -1 if block == bad_count_block else self.ROWS_PER_BLOCK
+      data += zigzag(num_records) + zigzag(len(records)) + records + sync
+    with open(path, "wb") as f:
+      f.write(data)
+
+  def _create_avro_table(self, unique_database, table_name, **corruptions):
+    qualified_table_name = "%s.%s" % (unique_database, table_name)
+    location = get_fs_path("/test-warehouse/%s_%s" % (unique_database, table_name))
+    self.client.execute("create table %s (id int, s string) stored as avro "
+        "location '%s'" % (qualified_table_name, location))
+    with tempfile.NamedTemporaryFile() as f:
+      self._write_avro_file(f.name, **corruptions)
+      self.filesystem_client.copy_from_local(f.name, location)
+    self.client.execute("refresh %s" % qualified_table_name)
+    return qualified_table_name
+
+  def test_corrupt_block_recovery(self, vector, unique_database):
+    """Checks that a corrupt block is skipped with abort_on_error=false and that all
+    following blocks are returned, both when reading a block ahead fails and when
+    decoding a block fails."""
+    all_ids = set(range(self.NUM_BLOCKS * self.ROWS_PER_BLOCK))
+
+    def block_ids(block):
+      return set(range(block * self.ROWS_PER_BLOCK, (block + 1) * self.ROWS_PER_BLOCK))
+
+    # Each corruption drops exactly the rows of the corrupt block. Blocks 3 and 12 are
+    # in different read-ahead windows and block 9 is not the first one of its window.
+    cases = [
+        ("clean", {}, all_ids),
+        ("bad_count", {"bad_count_block": 3}, all_ids - block_ids(3)),
+        ("bad_string", {"bad_string_block": 9}, all_ids - block_ids(9)),
+        ("bad_both", {"bad_count_block": 12, "bad_string_block": 3},
+            all_ids - block_ids(3) - block_ids(12))]
+    for table_name, corruptions, expected_ids in cases:
+      qualified_table_name = self._create_avro_table(
+          unique_database, table_name, **corruptions)
+      data = self._query_serial_and_parallel(vector,
+          "select id, s from %s order by id" % qualified_table_name, abort_on_error=0)
+      ids = [int(row.split("\t")[0]) for row in data]
+      assert len(ids) == len(expected_ids), table_name
+      assert set(ids) == expected_ids, table_name
+      assert all(row.split("\t")[1] == "row %s" % row.split("\t")[0] for row in data)
+
+      # With abort_on_error the corruption fails the query in both modes.
+      if corruptions:
+        for parallel_decoding in [0, 1]:
+          exec_options = deepcopy(vector.get_value('exec_option'))
+          exec_options['avro_parallel_decoding'] = parallel_decoding
+          exec_options['abort_on_error'] = 1
+          self.execute_query_expect_failure(self.client,
+              "select count(s) from %s" % qualified_table_name, exec_options)
+
+
 class TestOrc(ImpalaTestSuite):
   @classmethod
   def get_workload(cls):
@@ -1636,6 +1813,49 @@ class TestOrc(ImpalaTestSuite):
 
     self.run_test_case('QueryTest/hive2-pre-gregorian-date-orc', vector, unique_database)
 
+  def test_async_read(self, vector):
+    """Test that the ORC scanner returns the same rows with ORC_ASYNC_READ on and off,
+    and that it only prefetches stripe streams when the option is on."""
+    self.run_test_case('QueryTest/orc-async-read', vector)
+
+
+  @SkipIfS3.hdfs_block_size
+  @SkipIfGCS.hdfs_block_size
+  @SkipIfABFS.hdfs_block_size
+  @SkipIfADLS.hdfs_block_size
+  @SkipIfIsilon.hdfs_block_size
+  def test_runtime_filtered_stripes(self, vector, unique_database):
+    """Test that min-max runtime filters skip the stripes of an ORC file whose statistics
+    do not overlap the filter, and that skipping does not change the result."""
+    self._build_lineitem_table_helper(unique_database, 'lineitem_sixblocks',
+        'lineitem_sixblocks.orc')
+    # lineitem_sixblocks.orc has many small stripes ordered by l_orderkey, so the filter
+    # from the build side only overlaps the first stripes.
+    query = """select straight_join count(*), sum(l.l_linenumber)
+        from %s.lineitem_sixblocks l join [broadcast] tpch.orders o
+          on l.l_orderkey = o.o_orderkey
+        where o.o_orderkey < 100""" % unique_database
+    options = {'enabled_runtime_filter_types': 'MIN_MAX',
+               'minmax_filter_threshold': 0.5,
+               'runtime_filter_wait_time_ms': 10000}
+
+    expected = self.execute_query(
+        query, dict(options, runtime_filter_mode='OFF')).data
+    result = self.execute_query(query, options)
+    assert result.data == expected
+    assert self._get_runtime_filtered_stripes(result.runtime_profile) > 0
+
+    # No stripe is skipped without the stripe statistics.
+    result = self.execute_query(query, dict(options, orc_read_statistics=False))
+    assert result.data == expected
+    assert self._get_runtime_filtered_stripes(result.runtime_profile) == 0
+
+  def _get_runtime_filtered_stripes(self, runtime_profile):
+    """Returns the largest NumRuntimeFilteredStripes counter of 'runtime_profile'."""
+    counters = re.findall(r'NumRuntimeFilteredStripes: ([0-9]*)', runtime_profile)
+    assert len(counters) > 0
+    return max(int(c) for c in counters)
+
 
 class TestScannerReservation(ImpalaTestSuite):
   @classmethod
@@ -90,6 +90,61 @@ class TestQueryFullSort(ImpalaTestSuite):
       result = transpose_results(query_result.data)
       assert(result[0] == sorted(result[0]))
 
+  def test_parallel_run_sort(self, vector):
+    """Sorts the runs of lineitem with several threads, with and without key prefixes,
+       in memory and with spilling."""
+    query = """select l_comment, l_partkey, l_orderkey, l_suppkey, l_commitdate
+            from lineitem order by l_comment limit 100000"""
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['disable_outermost_topn'] = 1
+    exec_option['num_nodes'] = 1
+    exec_option['sort_run_threads'] = 4
+    table_format = vector.get_value('table_format')
+    for buffer_pool_limit in ['-1', '130m']:
+      for sort_key_prefix in ['false', 'true']:
+        exec_option['buffer_pool_limit'] = buffer_pool_limit
+        exec_option['sort_key_prefix'] = sort_key_prefix
+        query_result = self.execute_query(
+            query, exec_option, table_format=table_format)
+        m = re.search(r'\s+\- RunsSortedInParallel: (\d+)',
+            query_result.runtime_profile)
+        assert m is not None and int(m.group(1)) > 0
+        result = transpose_results(query_result.data)
+        assert(result[0] == sorted(result[0]))
+
+  def test_radix_sort(self, vector):
+    """Sorts the runs of lineitem with the radix sort on two keys, in memory and with
+       spilling."""
+    query = """select l_orderkey, l_linenumber, l_comment
+            from lineitem order by l_orderkey desc, l_linenumber limit 100000"""
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['disable_outermost_topn'] = 1
+    exec_option['num_nodes'] = 1
+    exec_option['sort_radix'] = 'true'
+    table_format = vector.get_value('table_format')
+    for buffer_pool_limit in ['-1', '130m']:
+      exec_option['buffer_pool_limit'] = buffer_pool_limit
+      query_result = self.execute_query(query, exec_option, table_format=table_format)
+      assert "SortRadix: true" in query_result.runtime_profile
+      keys = [(-int(row[0]), int(row[1])) for row in
+          (line.split('\t') for line in query_result.data)]
+      assert keys == sorted(keys)
+
+  def test_merge_key_prefix(self, vector):
+    """Merges spilled runs and the streams of a merging exchange with cached key
+       prefixes."""
+    query = """select o_orderdate, o_custkey, o_comment
+      from orders
+      order by o_orderdate"""
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['sort_key_prefix'] = 'true'
+    exec_option['buffer_pool_limit'] = '100m'
+    exec_option['default_spillable_buffer_size'] = '8M'
+    table_format = vector.get_value('table_format')
+    result = transpose_results(self.execute_query(
+        query, exec_option, table_format=table_format).data)
+    assert(result[0] == sorted(result[0]))
+
   def test_multiple_mem_limits_full_output(self, vector):
     """ Exercise a range of memory limits, returning the full sorted input. """
     query = """select o_orderdate, o_custkey, o_comment
@@ -135,6 +190,7 @@ class TestQueryFullSort(ImpalaTestSuite):
 
     query_result = self.execute_query(query, exec_option, table_format=table_format)
     assert "TotalMergesPerformed: 1" in query_result.runtime_profile
+    assert "MergeStallTime" in query_result.runtime_profile
     result = transpose_results(query_result.data)
     assert(result[0] == sorted(result[0]))
 
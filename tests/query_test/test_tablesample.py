@@ -18,9 +18,12 @@
 # Tests the TABLESAMPLE clause.
 
 import pytest
+import re
 import subprocess
 
+from tests.common.file_utils import create_table_and_copy_files
 from tests.common.impala_test_suite import ImpalaTestSuite
+from tests.common.test_dimensions import create_single_exec_option_dimension
 from tests.common.test_vector import ImpalaTestDimension
 
 class TestTableSample(ImpalaTestSuite):
@@ -91,3 +94,56 @@ class TestTableSample(ImpalaTestSuite):
         # May not necessarily be true for non-repeatable samples
         assert count > prev_count
       prev_count = count
+
+
+class TestTableSampleWithinFiles(ImpalaTestSuite):
+  """Tests TABLESAMPLE_WITHIN_FILES, which samples the row groups of Parquet files and
+  the stripes of ORC files of a table sample."""
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestTableSampleWithinFiles, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(create_single_exec_option_dimension())
+    # The tests reference their tables directly.
+    cls.ImpalaTestMatrix.add_constraint(lambda v:
+        v.get_value('table_format').file_format == 'parquet')
+
+  def test_parquet_row_groups(self, vector):
+    # The table has a single file with 200 row groups.
+    self.__check_sample("functional_parquet.lineitem_multiblock", 20000,
+        "NumUnsampledRowGroups")
+
+  def test_orc_stripes(self, vector, unique_database):
+    # The file has one stripe per about 1KB of data.
+    create_table_and_copy_files(self.client,
+        "create table {db}.{tbl} like tpch.lineitem stored as orc", unique_database,
+        "lineitem_sixblocks", ["testdata/LineItemMultiBlock/lineitem_sixblocks.orc"])
+    self.__check_sample(unique_database + ".lineitem_sixblocks", 30000,
+        "NumUnsampledStripes")
+
+  def __check_sample(self, table, num_rows, unsampled_counter):
+    """Checks that a 20% sample of the single file of 'table', which has 'num_rows'
+    rows, reads a repeatable part of its row groups or stripes, both with and without
+    materializing columns."""
+    count_star = "select count(*) from %s tablesample system(20) repeatable(1)" % table
+    count_col = ("select count(l_orderkey) from %s tablesample system(20) repeatable(1)"
+        % table)
+    # Without the option, the sampled file is read completely.
+    result = self.execute_query(count_star, {'tablesample_within_files': 'false'})
+    assert int(result.data[0]) == num_rows
+    assert self.__sum_counter(result.runtime_profile, unsampled_counter) == 0
+
+    options = {'tablesample_within_files': 'true'}
+    result = self.execute_query(count_star, options)
+    sample_rows = int(result.data[0])
+    assert 0 < sample_rows < num_rows
+    assert self.__sum_counter(result.runtime_profile, unsampled_counter) > 0
+    # The same seed reads the same sample, also when columns are materialized.
+    assert int(self.execute_query(count_star, options).data[0]) == sample_rows
+    assert int(self.execute_query(count_col, options).data[0]) == sample_rows
+
+  def __sum_counter(self, profile, counter):
+    return sum(int(n) for n in re.findall(r"%s: ([0-9]+)" % counter, profile))
@@ -117,6 +117,14 @@ create aggregate function {database}.char_intermediate_sum(int) returns int
 intermediate char(10) LOCATION '{location}' update_fn='AggCharIntermediateUpdate'
 init_fn='AggCharIntermediateInit' merge_fn='AggCharIntermediateMerge'
 serialize_fn='AggCharIntermediateSerialize' finalize_fn='AggCharIntermediateFinalize';
+
+create aggregate function {database}.batch_sum(int) returns bigint
+location '{location}' init_fn='BatchSumInit' update_fn='BatchSumUpdate'
+merge_fn='BatchSumMerge';
+
+create aggregate function {database}.sum_product(int, int) returns bigint
+location '{location}' init_fn='SumProductInit' update_fn='SumProductUpdate'
+merge_fn='SumProductMerge';
 """
 
   # Create test UDF functions in {database} from library {location}
@@ -222,6 +230,12 @@ location '{location}' symbol='ValidateArgType';
 create function {database}.count_rows() returns bigint
 location '{location}' symbol='Count' prepare_fn='CountPrepare' close_fn='CountClose';
 
+create function {database}.is_multiple(int, int) returns boolean
+location '{location}' symbol='IsMultiple' prepare_fn='IsMultiplePrepare';
+
+create function {database}.batch_only(int) returns boolean
+location '{location}' symbol='BatchOnly' prepare_fn='BatchOnlyPrepare';
+
 create function {database}.constant_arg(int) returns int
 location '{location}' symbol='ConstantArg' prepare_fn='ConstantArgPrepare' close_fn='ConstantArgClose';
 
@@ -299,6 +313,7 @@ class TestUdfExecution(TestUdfBase):
     if not vector.get_value('exec_option')['disable_codegen']:
       self.run_test_case('QueryTest/udf-codegen-required', vector, use_db=unique_database)
     self.run_test_case('QueryTest/uda', vector, use_db=unique_database)
+    self.run_test_case('QueryTest/udf-batch', vector, use_db=unique_database)
     self.run_test_case('QueryTest/udf-init-close', vector, use_db=unique_database)
     # Some tests assume no expr rewrites.
     if enable_expr_rewrites:
@@ -575,6 +575,16 @@ class TestWebPage(ImpalaTestSuite):
       assert any(pattern in t for t in thread_names), \
           "Could not find thread matching '%s'" % pattern
 
+  def test_startup_phases(self):
+    """Test that the duration of every startup phase is exported. LLVM initializes
+    concurrently with the other phases, so none of them takes longer than the total."""
+    phases = ["llvm", "exec-env", "disk-io-mgr", "impala-server"]
+    total = self.get_metric("impala-server.startup.phase-duration-ms.total")
+    assert total > 0
+    for phase in phases:
+      duration = self.get_metric("impala-server.startup.phase-duration-ms." + phase)
+      assert 0 <= duration <= total, phase
+
   def test_krpc_rpcz(self):
     """Test that KRPC metrics are exposed in /rpcz and that they are updated when
     executing a query."""